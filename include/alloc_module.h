@@ -0,0 +1,49 @@
+#ifndef ALLOC_MODULE_H
+#define ALLOC_MODULE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Edge Impulse SDK 分配器
+// 本模块提供 ei_malloc / ei_calloc / ei_free 的强定义，覆盖移植层中直接调用 newlib malloc 的弱定义：
+// - 初始化阶段（alloc_module_seal 之前）从 ALLOC_ARENA_BYTES 的 arena 顺序分配，只有最后一次分配能被释放回收；
+//   这类分配（模型句柄、平滑器状态等）通常伴随整个运行期，顺序分配没有碎片，也没有块头开销
+// - 之后的分配按大小取能容纳它的最小一档定长块池，释放时原样归还，长时间运行不产生堆碎片
+// - 都放不下时按 ALLOC_HEAP_FALLBACK 退回 malloc 或返回 nullptr，分别计数
+
+#define ALLOC_POOL_COUNT 3
+
+struct alloc_pool_stats_t {
+    uint16_t block_bytes;
+    uint16_t blocks;
+    uint16_t in_use;
+    uint16_t peak;        // 启动以来同时占用的最多块数
+};
+
+struct alloc_stats_t {
+    uint32_t arena_bytes;
+    uint32_t arena_used;
+    alloc_pool_stats_t pools[ALLOC_POOL_COUNT];
+    uint32_t allocations;     // 启动以来的分配次数（含 arena、块池与 malloc）
+    uint32_t heap_fallbacks;  // 退回 malloc 的次数
+    uint32_t failed;          // 返回 nullptr 的次数
+    uint32_t heap_in_use;     // 经 malloc 分配、尚未释放的块数
+};
+
+/**
+ * @brief 结束初始化阶段：此后的分配改由块池提供，并把 arena 与块池登记到 RAM 预算
+ * 推理线程进入主循环前调用一次。
+ */
+void alloc_module_seal();
+
+/**
+ * @brief 读取分配统计（线程安全）
+ */
+void alloc_module_get_stats(alloc_stats_t* out_stats);
+
+/**
+ * @brief 打印分配统计：arena 与各块池的占用 / 峰值、上次报告以来的每秒分配次数、退回 malloc 与失败次数
+ */
+void alloc_module_report();
+
+#endif
@@ -0,0 +1,1801 @@
+#ifndef APP_CONFIG_H
+#define APP_CONFIG_H
+
+// 固件编译期配置（可在 platformio.ini 的 build_flags 中用 -D 覆盖）
+
+// ==================== 平台 ====================
+
+// 默认目标是 Nano 33 BLE Sense Rev2（nRF52840，单核）；RP2040 可穿戴版本（Arduino Mbed OS RP2040 核心，
+// 外接 BMI270 与分立 RGB LED，见 [env:rp2040]）；ESP32 版本（Arduino-ESP32 / ESP-IDF FreeRTOS，Mbed 接口由
+// include/esp32/ 的替身实现，见 [env:esp32]）。板级差异集中在本节与下面 IMU / LED 的引脚宏，模块代码只用这些宏
+#if defined(TARGET_RP2040)
+#define PLATFORM_RP2040 1
+#else
+#define PLATFORM_RP2040 0
+#endif
+#if defined(ARDUINO_ARCH_ESP32)
+#define PLATFORM_ESP32 1
+#else
+#define PLATFORM_ESP32 0
+#endif
+// Portenta H7：M7 核运行本固件（推理、BLE / USB 传输、LED），M4 核运行 IMU 采集（src/portenta/m4_main.cpp），
+// 两核经 SRAM4 中的共享缓冲交换数据（见 h7_link.h，[env:portenta_h7_m7] / [env:portenta_h7_m4]）
+#if defined(ARDUINO_PORTENTA_H7_M7) || (defined(STM32H747xx) && defined(CORE_CM7))
+#define PLATFORM_PORTENTA_M7 1
+#else
+#define PLATFORM_PORTENTA_M7 0
+#endif
+#if defined(ARDUINO_PORTENTA_H7_M4) || (defined(STM32H747xx) && defined(CORE_CM4))
+#define PLATFORM_PORTENTA_M4 1
+#else
+#define PLATFORM_PORTENTA_M4 0
+#endif
+#define PLATFORM_PORTENTA (PLATFORM_PORTENTA_M7 || PLATFORM_PORTENTA_M4)
+// 片上 BLE 射频由 Cordio 链路层直接驱动的 nRF52（Nano 33 BLE 的 nRF52840、Nicla Sense ME 的 nRF52832）
+#if defined(NRF52840_XXAA) || defined(NRF52832_XXAA)
+#define PLATFORM_NRF52 1
+#else
+#define PLATFORM_NRF52 0
+#endif
+// Nicla Sense ME（nRF52832 + BHI260AP）：加速度 / 陀螺仪由 BHI260 的虚拟传感器按批写入其 FIFO，
+// 运动门控使用 BHI260 上的 significant motion 检测，主机只在批次到达时醒来（src/nicla/bhi260_imu.cpp，见 [env:nicla_sense_me]）
+#if defined(ARDUINO_NICLA) || defined(TARGET_NICLA)
+#define PLATFORM_NICLA 1
+#else
+#define PLATFORM_NICLA 0
+#endif
+
+// ==================== 构建配置 ====================
+
+// 构建配置决定各诊断子系统的默认开关（下面各节的开关仍可单独用 -D 覆盖）：
+// - DIAGNOSTIC（默认）：全部诊断功能
+// - PRODUCTION：编译期去掉 INFO / DEBUG 日志（包括每次推理的概率打印）与日志的浮点格式化、周期性的线程报告、
+//   LED、BLE 分数流与窗口样本流、原始数据录制、串口文本命令与二进制诊断命令（shell），
+//   量产固件不带这些代码、缓冲区与每次推理的开销（见 [env:nano33ble_production]）
+#define BUILD_PROFILE_DIAGNOSTIC 0
+#define BUILD_PROFILE_PRODUCTION 1
+#ifndef BUILD_PROFILE
+#define BUILD_PROFILE BUILD_PROFILE_DIAGNOSTIC
+#endif
+#define BUILD_DIAGNOSTICS (BUILD_PROFILE != BUILD_PROFILE_PRODUCTION)
+
+// ESP32：各线程绑定的核（0 = PRO_CPU，1 = APP_CPU）。BT 控制器与 esp_timer 任务在 PRO_CPU 上，
+// 采集、BLE / USB 传输、事件（LED 与日志）、录制线程和它们放在一起，推理线程独占 APP_CPU（Arduino loopTask 也在
+// APP_CPU，只做监督与报告）。其它平台忽略
+#ifndef THREAD_SAMPLER_CORE
+#define THREAD_SAMPLER_CORE 0
+#endif
+#ifndef THREAD_INFERENCE_CORE
+#define THREAD_INFERENCE_CORE 1
+#endif
+#ifndef THREAD_BLE_CORE
+#define THREAD_BLE_CORE 0
+#endif
+#ifndef THREAD_EVENTS_CORE
+#define THREAD_EVENTS_CORE 0
+#endif
+#ifndef THREAD_RECORD_CORE
+#define THREAD_RECORD_CORE 0
+#endif
+#ifndef THREAD_HCI_CORE
+#define THREAD_HCI_CORE 0
+#endif
+
+// ESP32：校准 / 配置记录与模型槽所在的数据分区（默认分区表中的 spiffs 分区，本固件不使用 SPIFFS）
+#ifndef ESP32_STORE_PARTITION
+#define ESP32_STORE_PARTITION "spiffs"
+#endif
+
+// 1 = 模型调用在 RP2040 的核 1 上运行，采集、BLE / USB 传输、LED 与其余线程留在核 0 的 RTOS 上，
+// 推理线程在调用期间阻塞让出核 0（见 core1_module.h）；0 = 单核，模型调用在推理线程中直接运行
+#ifndef INFERENCE_DUAL_CORE
+#define INFERENCE_DUAL_CORE PLATFORM_RP2040
+#endif
+#if INFERENCE_DUAL_CORE && !PLATFORM_RP2040
+#error "INFERENCE_DUAL_CORE requires an RP2040 target"
+#endif
+// 核 1 的栈（模型调用与 DSP 在这里运行，取与推理线程相同的大小）
+#ifndef CORE1_STACK_BYTES
+#define CORE1_STACK_BYTES 8192
+#endif
+
+// Portenta H7 双核链路：共享缓冲在 SRAM4 的位置与大小（避开 OpenAMP / RPC 使用的 SRAM4 起始 32 KB，
+// 两个工程的链接脚本都不分配 SRAM4），环形缓冲的帧数与 M4 日志记录数（2 的幂），
+// M4 每批帧写完后释放的硬件信号量通道，M7 等待 M4 完成 IMU 初始化的最长时间
+#ifndef H7_LINK_ADDR
+#define H7_LINK_ADDR 0x38008000u
+#endif
+#ifndef H7_LINK_BYTES
+#define H7_LINK_BYTES 0x8000u
+#endif
+#ifndef H7_LINK_FRAMES
+#define H7_LINK_FRAMES 256
+#endif
+#ifndef H7_LINK_LOGS
+#define H7_LINK_LOGS 16
+#endif
+#ifndef H7_LINK_HSEM
+#define H7_LINK_HSEM 10
+#endif
+#ifndef H7_LINK_BOOT_TIMEOUT_MS
+#define H7_LINK_BOOT_TIMEOUT_MS 2000
+#endif
+
+// Nicla Sense ME：BHI260 虚拟传感器的批次时延（传感器在自己的 FIFO 中攒这么久才通知主机，也是采集线程的唤醒周期；
+// 结果延迟相应增加），运动门控关闭加速度通路后轮询运动事件的间隔，以及最后一次 significant motion 之后保持运行的时间
+#ifndef NICLA_BATCH_MS
+#define NICLA_BATCH_MS 200
+#endif
+#ifndef NICLA_IDLE_POLL_MS
+#define NICLA_IDLE_POLL_MS 500
+#endif
+#ifndef NICLA_MOTION_HOLD_MS
+#define NICLA_MOTION_HOLD_MS 3000
+#endif
+
+// ==================== 功耗 ====================
+
+// 1 = 低功耗运行模式：FIFO 水位加大到约 100 ms，采集 / 推理按批次突发运行，其余时间 CPU 在 System ON
+// 睡眠（Mbed tickless 空闲线程）；LED / BLE / 录制线程的轮询间隔放宽，关闭板载电源指示灯（需要 IMU_USE_FIFO）
+#ifndef POWER_LOW_POWER_MODE
+#define POWER_LOW_POWER_MODE 0
+#endif
+
+// 1 = 统计各线程活动 / 睡眠时间并估算每个分类窗口的能耗（每个统计窗口打印一行 [Energy]）。
+// 统计按单核的抢占栈记账，ESP32 上两个核的线程同时活动，默认关闭
+#ifndef ENERGY_INSTRUMENTATION
+#define ENERGY_INSTRUMENTATION (!PLATFORM_ESP32)
+#endif
+
+// 能耗估算用的功率（mW）：CPU 运行（nRF52840 64 MHz、flash 取指、DC/DC，约 3.3 mA x 3 V）、
+// CPU 睡眠（System ON，高频时钟与 us 定时器保持运行）、常开负载（BMI270 加速度计等）。
+// 都是数据手册量级的估计，用电流表实测整板电流后可按实测值覆盖
+#ifndef ENERGY_ACTIVE_MW
+#define ENERGY_ACTIVE_MW 10.0f
+#endif
+#ifndef ENERGY_SLEEP_MW
+#define ENERGY_SLEEP_MW 1.5f
+#endif
+#ifndef ENERGY_BASELINE_MW
+#define ENERGY_BASELINE_MW 0.6f
+#endif
+
+// 各线程空闲时的轮询间隔（毫秒）。LED / BLE 线程在新结果发布时立即被唤醒（inference_wait_result），
+// BLE 的间隔只决定无新结果时 BLE.poll() 与诊断数据的节奏
+#ifndef BLE_POLL_INTERVAL_MS
+#define BLE_POLL_INTERVAL_MS (POWER_LOW_POWER_MODE ? 250 : 100)
+#endif
+// 事件驱动的 BLE 线程：HCI 监视线程在 Cordio 协议栈收到 HCI 事件 / ACL 数据时唤醒 BLE 线程，USB 链路的主机帧
+// 与新结果也唤醒同一个等待，BLE 线程不再按 ble_poll_interval_ms 轮询（该配置项只在关闭时生效），
+// 没有任何事件时每 BLE_EVENT_BACKSTOP_MS 醒来一次（心跳；诊断数据与广播阶段按各自的截止时间唤醒）
+#ifndef BLE_EVENT_DRIVEN
+#define BLE_EVENT_DRIVEN 1
+#endif
+#ifndef BLE_EVENT_BACKSTOP_MS
+#define BLE_EVENT_BACKSTOP_MS 1000
+#endif
+#ifndef RECORD_IDLE_SLEEP_MS
+#define RECORD_IDLE_SLEEP_MS (POWER_LOW_POWER_MODE ? 50 : 5)
+#endif
+
+// ==================== IMU 采集 ====================
+
+// 1 = 使用 BMI270 硬件 FIFO + 水位中断批量读取；0 = 回退到定时器触发的轮询读取
+#ifndef IMU_USE_FIFO
+#define IMU_USE_FIFO 1
+#endif
+
+#if POWER_LOW_POWER_MODE && !IMU_USE_FIFO
+#error "POWER_LOW_POWER_MODE requires IMU_USE_FIFO (timer-driven polling wakes the CPU for every sample)"
+#endif
+
+// BMI270 INT1 所连接的引脚：Nano 33 BLE Sense Rev2 板载连线为 P0_11；RP2040 版本接 D2（GPIO25）；ESP32 版本接 GPIO4；
+// Portenta H7 版本的外接 BMI270 接 PD_4（按实际连线覆盖，只有 M4 使用）
+#ifndef IMU_INT1_PIN
+#if PLATFORM_RP2040
+#define IMU_INT1_PIN p25
+#elif PLATFORM_ESP32
+#define IMU_INT1_PIN 4
+#elif PLATFORM_PORTENTA
+#define IMU_INT1_PIN PD_4
+#else
+#define IMU_INT1_PIN P0_11
+#endif
+#endif
+
+// IMU 所在的 I2C 总线：nRF52840 板载 IMU 在 Wire1（内部总线），RP2040 版本的外接 BMI270 在 Wire（A4 / A5），
+// ESP32 / Portenta H7 版本在 Wire（板子默认的 SDA / SCL），与 Arduino_BMI270_BMM150 驱动库在各板上选用的总线一致
+#ifndef IMU_WIRE
+#if PLATFORM_ESP32
+#define IMU_WIRE Wire
+#define IMU_WIRE_SDA_PIN SDA
+#define IMU_WIRE_SCL_PIN SCL
+#elif PLATFORM_RP2040 || PLATFORM_PORTENTA
+#define IMU_WIRE Wire
+#define IMU_WIRE_SDA_PIN PIN_WIRE_SDA
+#define IMU_WIRE_SCL_PIN PIN_WIRE_SCL
+#else
+#define IMU_WIRE Wire1
+#define IMU_WIRE_SDA_PIN PIN_WIRE_SDA1
+#define IMU_WIRE_SCL_PIN PIN_WIRE_SCL1
+#endif
+#endif
+
+// FIFO 水位（帧数）：FIFO 中累计到这么多帧才触发一次中断唤醒采集线程（默认约 40 ms 一次，低功耗模式约 100 ms）
+// 超过单次突发读取上限的部分在同一次唤醒中继续读出
+#ifndef IMU_FIFO_WATERMARK_FRAMES
+#define IMU_FIFO_WATERMARK_FRAMES (POWER_LOW_POWER_MODE ? IMU_SENSOR_ODR_HZ / 10 : IMU_SENSOR_ODR_HZ / 25)
+#endif
+
+// BMI270 加速度计输出数据率（Hz，必须是 BMI270 支持的档位：25/50/100/200/400/800/1600）
+// 以高 ODR 采集快速甩动，经抗混叠抽取后再由重采样级对齐到模型采样率（EI_CLASSIFIER_FREQUENCY）
+#ifndef IMU_SENSOR_ODR_HZ
+#define IMU_SENSOR_ODR_HZ 400
+#endif
+
+// 抗混叠抽取（仅 FIFO 模式）：ODR / IMU_DECIMATION_FACTOR 应不低于模型采样率
+#ifndef IMU_DECIMATION_FACTOR
+#define IMU_DECIMATION_FACTOR 4
+#endif
+// 低通截止频率（Hz），须低于模型采样率的一半（48 Hz 模型为 24 Hz）
+#ifndef IMU_DECIMATION_CUTOFF_HZ
+#define IMU_DECIMATION_CUTOFF_HZ 18
+#endif
+// 抽头数：400 Hz 下 64 抽头的过渡带约 20 Hz
+#ifndef IMU_DECIMATION_TAPS
+#define IMU_DECIMATION_TAPS 64
+#endif
+
+// 采样率漂移统计窗口（毫秒）；窗口结束时用实测 ODR 校正重采样比
+#ifndef IMU_RATE_WINDOW_MS
+#define IMU_RATE_WINDOW_MS 2000
+#endif
+
+// 空闲时的低速采集（仅 FIFO 模式，0 = 关闭）：推理步长策略切到粗步长或运动门控生效时，BMI270 改以这一 ODR
+// 采样，FIFO 水位按比例缩小（唤醒周期不变），FIFO 读出与总线传输随之减少；恢复细步长时回到 IMU_SENSOR_ODR_HZ。
+// 低速帧先线性插值回 IMU_SENSOR_ODR_HZ 再进入同一个抽取器，抽取与重采样状态跨切换连续，窗口没有缺口。
+// 须是 BMI270 支持的档位，且不低于 IMU_SENSOR_ODR_HZ / IMU_DECIMATION_FACTOR（抽取后的采样率）
+#ifndef IMU_IDLE_ODR_HZ
+#define IMU_IDLE_ODR_HZ (POWER_LOW_POWER_MODE ? IMU_SENSOR_ODR_HZ / IMU_DECIMATION_FACTOR : 0)
+#endif
+#ifndef IMU_IDLE_FIFO_WATERMARK_FRAMES
+#define IMU_IDLE_FIFO_WATERMARK_FRAMES \
+    (IMU_IDLE_ODR_HZ ? (IMU_FIFO_WATERMARK_FRAMES * IMU_IDLE_ODR_HZ + IMU_SENSOR_ODR_HZ - 1) / IMU_SENSOR_ODR_HZ : 0)
+#endif
+#if IMU_IDLE_ODR_HZ && (IMU_SENSOR_ODR_HZ % IMU_IDLE_ODR_HZ != 0 || IMU_IDLE_ODR_HZ >= IMU_SENSOR_ODR_HZ || \
+                        IMU_SENSOR_ODR_HZ / IMU_IDLE_ODR_HZ > IMU_DECIMATION_FACTOR)
+#error "IMU_IDLE_ODR_HZ must divide IMU_SENSOR_ODR_HZ by at most IMU_DECIMATION_FACTOR"
+#endif
+
+// BMM150 磁力计输出数据率（Hz，BMM150 支持的档位：2/6/8/10/15/20/25/30）
+// 仅当融合轴包含 magx/magy/magz 时才上电并采样；每次采集唤醒最多读取一次，实际读取率不超过唤醒频率
+#ifndef IMU_MAG_ODR_HZ
+#define IMU_MAG_ODR_HZ 25
+#endif
+
+// IMU 内部 I2C 时钟（BMI270 支持 Fast Mode 400 kHz；驱动库默认只有 100 kHz）
+#ifndef IMU_I2C_CLOCK_HZ
+#define IMU_I2C_CLOCK_HZ 400000
+#endif
+
+// 1 = 通过 mbed 异步 I2C（nRF52840 TWIM EasyDMA）读写 IMU，传输期间调用线程休眠；
+// 0 或目标不支持 I2C_ASYNCH 时回退到 Wire1 阻塞传输
+#ifndef IMU_BUS_USE_DMA
+#define IMU_BUS_USE_DMA 1
+#endif
+
+// 1 = 首次启动时静置校准零偏 / 比例系数并保存到 Flash，之后启动直接载入；0 = 不做校准
+#ifndef IMU_CALIB_ENABLE
+#define IMU_CALIB_ENABLE 1
+#endif
+// 校准样本数（每 5 ms 一个，默认约 1 秒）及开始采样前的等待时间（毫秒）
+#ifndef IMU_CALIB_SAMPLES
+#define IMU_CALIB_SAMPLES 200
+#endif
+#ifndef IMU_CALIB_SETTLE_MS
+#define IMU_CALIB_SETTLE_MS 200
+#endif
+// 静置判定：校准期间各轴标准差上限（加速度 g / 陀螺仪 dps）
+#ifndef IMU_CALIB_MAX_ACC_STD_G
+#define IMU_CALIB_MAX_ACC_STD_G 0.01f
+#endif
+#ifndef IMU_CALIB_MAX_GYR_STD_DPS
+#define IMU_CALIB_MAX_GYR_STD_DPS 0.5f
+#endif
+// 水平判定：非重力轴的均值超过该值（g）时拒绝校准
+#ifndef IMU_CALIB_LEVEL_TOLERANCE_G
+#define IMU_CALIB_LEVEL_TOLERANCE_G 0.1f
+#endif
+// 1 = 重力坐标系预处理（include/gravity_frame.h）：抽取后的每帧由加速度计 + 陀螺仪的 EKF 更新重力方向，
+// 加速度（及陀螺仪）轴转到 z 轴竖直向上的坐标系后再重采样进窗口，手腕姿态不同的同一手势得到相同的输入。
+// 传感器帧总是带上陀螺仪；部署的模型按原始轴训练，打开前须用经过同一处理的数据（device_replay.py /
+// replay_runner.py 回放录制）重新训练
+#ifndef IMU_GRAVITY_FRAME
+#define IMU_GRAVITY_FRAME 0
+#endif
+// 重力 EKF 参数：陀螺仪噪声密度（rad/s/√Hz）、静止时归一化加速度的噪声、观测噪声中 (|a| - 1 g)^2 项的系数
+#ifndef IMU_GRAVITY_GYRO_NOISE
+#define IMU_GRAVITY_GYRO_NOISE 0.01f
+#endif
+#ifndef IMU_GRAVITY_ACC_NOISE
+#define IMU_GRAVITY_ACC_NOISE 0.05f
+#endif
+#ifndef IMU_GRAVITY_DYNAMIC_GAIN
+#define IMU_GRAVITY_DYNAMIC_GAIN 10.0f
+#endif
+// 启动时对重力坐标系级做逐样本耗时基准的样本数（DWT 周期，与不做转换的打包对比）；0 = 不做
+#ifndef IMU_GRAVITY_BENCHMARK_ITERATIONS
+#define IMU_GRAVITY_BENCHMARK_ITERATIONS 0
+#endif
+// 校准记录所在 Flash 页的地址；0 = 使用 Flash 最后一页
+#ifndef CALIB_FLASH_ADDR
+#define CALIB_FLASH_ADDR 0
+#endif
+
+// 采集线程 -> 推理线程的样本环形缓冲容量（float 个数，必须是 2 的幂）
+// 512 个 float = 3 轴时 170 帧（48 Hz 下约 3.5 秒），足以吸收一次推理加串口打印的耗时
+#ifndef SAMPLE_RING_CAPACITY
+#define SAMPLE_RING_CAPACITY 512
+#endif
+
+// 每个结果消费者（BLE / LED）的结果事件队列深度（必须是 2 的幂）：发布的每个结果扇出到所有队列，
+// 消费者在两次读取之间错过的结果按顺序补读；队列满时丢弃新事件并计入该消费者的溢出计数
+#ifndef INFERENCE_EVENT_QUEUE_DEPTH
+#define INFERENCE_EVENT_QUEUE_DEPTH 16
+#endif
+
+// 1 = BLE 分数流特征值（19B1001E）：每次推理的全部 int8 类别分数按批发送，供上位机自行平滑 / 校准 / 调阈值；
+// 只在上位机订阅时记录。队列深度（必须是 2 的幂）须能容纳一个 BLE 轮询间隔内的推理次数
+#ifndef BLE_SCORE_STREAM_ENABLE
+#define BLE_SCORE_STREAM_ENABLE BUILD_DIAGNOSTICS
+#endif
+#ifndef INFERENCE_SCORE_QUEUE_DEPTH
+#define INFERENCE_SCORE_QUEUE_DEPTH 32
+#endif
+
+// 1 = BLE 窗口样本流特征值（19B1001F）：实际送入模型的样本（融合轴，校准、重采样之后）按
+// record_format.h 的 RECORD_TYPE_WINDOW 包做差值 + varint 压缩，每包装满本连接的 MTU，与分类并行发送；
+// 只在上位机订阅时记录。队列深度（帧，必须是 2 的幂）须能容纳一个 BLE 轮询间隔内的样本，
+// 未装满的包最多等待 BLE_WINDOW_STREAM_MAX_LATENCY_MS（从其中最早的帧算起）
+#ifndef BLE_WINDOW_STREAM_ENABLE
+#define BLE_WINDOW_STREAM_ENABLE BUILD_DIAGNOSTICS
+#endif
+#ifndef INFERENCE_WINDOW_QUEUE_DEPTH
+#define INFERENCE_WINDOW_QUEUE_DEPTH 64
+#endif
+#ifndef BLE_WINDOW_STREAM_MAX_LATENCY_MS
+#define BLE_WINDOW_STREAM_MAX_LATENCY_MS 100
+#endif
+
+// 固件接受的最大 ATT MTU（中心设备连接后发起 MTU 交换，协议规定外设不能主动发起）；247 = 251 字节
+// LE 数据包减去 4 字节 L2CAP 头，一个数据包装下一次通知。单次通知最多 MTU - 3 字节
+#ifndef BLE_ATT_MTU
+#define BLE_ATT_MTU 247
+#endif
+
+// 事件批量通知的刷新策略（3 字节头 + 每个事件 8 字节）：
+// - 满：攒到 BLE_EVENTS_PER_NOTIFICATION 个事件、或装满本连接协商的 MTU 时立即发送
+//   （上位机报告 MTU 之前按默认 MTU 23 计，即每次 2 个事件）；
+// - 时限：未满的一批最多等待 BLE_EVENT_BATCH_MAX_LATENCY_MS（从其中最早的事件算起）；0 = 每次唤醒即发送
+#ifndef BLE_EVENTS_PER_NOTIFICATION
+#define BLE_EVENTS_PER_NOTIFICATION ((BLE_ATT_MTU - 3 - 3) / 8)
+#endif
+#ifndef BLE_EVENT_BATCH_MAX_LATENCY_MS
+#define BLE_EVENT_BATCH_MAX_LATENCY_MS 0
+#endif
+// 每个连接内已通知事件的投递序号逐个加 1，上位机据此发现漏收的通知；最近 BLE_EVENT_HISTORY_DEPTH 个事件
+// 保留在历史环中，上位机通过补发特征值（19B10021）按序号取回（每个事件 8 字节）
+#ifndef BLE_EVENT_HISTORY_DEPTH
+#define BLE_EVENT_HISTORY_DEPTH 32
+#endif
+// 空闲心跳：事件特征值连续 BLE_HEARTBEAT_INTERVAL_MS 没有通知时发一条心跳记录（wire_heartbeat_t：运行时间、
+// 下一投递序号、电池电压与工作点），有事件时事件通知本身就说明连接正常、不另发；上位机据此区分"空闲"与
+// "连接卡住"（连续错过几次心跳才判定），间隔在布局特征值中报告。0 = 关闭。USB 链路由 hello 保活，不发心跳
+#ifndef BLE_HEARTBEAT_INTERVAL_MS
+#define BLE_HEARTBEAT_INTERVAL_MS 2000
+#endif
+
+#if BLE_ATT_MTU < 23 || BLE_ATT_MTU > 251
+#error "BLE_ATT_MTU must be between 23 (the BLE default) and 251"
+#endif
+#if BLE_EVENTS_PER_NOTIFICATION < 1 || 3 + 8 * BLE_EVENTS_PER_NOTIFICATION > BLE_ATT_MTU - 3
+#error "BLE_EVENTS_PER_NOTIFICATION events must fit one notification at BLE_ATT_MTU"
+#endif
+#if BLE_HEARTBEAT_INTERVAL_MS < 0 || BLE_HEARTBEAT_INTERVAL_MS > 0xFFFF
+#error "BLE_HEARTBEAT_INTERVAL_MS must fit the uint16 of the layout characteristic"
+#endif
+#if BLE_EVENT_HISTORY_DEPTH < 1 || BLE_EVENT_HISTORY_DEPTH > 1024 || (BLE_EVENT_HISTORY_DEPTH & (BLE_EVENT_HISTORY_DEPTH - 1)) != 0
+#error "BLE_EVENT_HISTORY_DEPTH must be a power of two between 1 and 1024 (slots follow the 16-bit delivery number)"
+#endif
+
+// 最新结果除打包的手势特征值（19B1001B，一次通知）外，是否仍同时写入旧的字符串类别 + float 置信度两个特征值
+// （19B10011 / 19B10012，兼容旧上位机）；0 = 不再注册这两个特征值，每个结果少两次通知
+#ifndef BLE_LEGACY_RESULT_CHARACTERISTICS
+#define BLE_LEGACY_RESULT_CHARACTERISTICS 1
+#endif
+
+// 连接参数：不请求时连接间隔由中心设备决定（Windows 常为 30–50 ms，直接叠加在手势延迟上）。
+// 连接建立后及检测到运动 / 手势时请求"活跃"参数（短间隔、无从机延迟），超过 BLE_CONN_IDLE_AFTER_MS
+// 没有运动也没有手势后请求"空闲"参数（长间隔 + 从机延迟，射频少开）。间隔单位 1.25 ms，监督超时单位 10 ms
+#ifndef BLE_CONN_PARAMS_ENABLE
+#define BLE_CONN_PARAMS_ENABLE 1
+#endif
+#ifndef BLE_CONN_ACTIVE_MIN_INTERVAL
+#define BLE_CONN_ACTIVE_MIN_INTERVAL 6  // 7.5 ms
+#endif
+#ifndef BLE_CONN_ACTIVE_MAX_INTERVAL
+#define BLE_CONN_ACTIVE_MAX_INTERVAL 12  // 15 ms：给中心设备留出余地（部分系统不接受固定 7.5 ms）
+#endif
+#ifndef BLE_CONN_ACTIVE_LATENCY
+#define BLE_CONN_ACTIVE_LATENCY 0
+#endif
+#ifndef BLE_CONN_ACTIVE_TIMEOUT
+#define BLE_CONN_ACTIVE_TIMEOUT 100  // 1 s
+#endif
+#ifndef BLE_CONN_IDLE_MIN_INTERVAL
+#define BLE_CONN_IDLE_MIN_INTERVAL 80  // 100 ms
+#endif
+#ifndef BLE_CONN_IDLE_MAX_INTERVAL
+#define BLE_CONN_IDLE_MAX_INTERVAL 120  // 150 ms
+#endif
+#ifndef BLE_CONN_IDLE_LATENCY
+#define BLE_CONN_IDLE_LATENCY 4  // 无数据时最多跳过 4 个连接事件
+#endif
+#ifndef BLE_CONN_IDLE_TIMEOUT
+#define BLE_CONN_IDLE_TIMEOUT 400  // 4 s
+#endif
+#ifndef BLE_CONN_IDLE_AFTER_MS
+#define BLE_CONN_IDLE_AFTER_MS 5000
+#endif
+
+#if BLE_CONN_ACTIVE_MIN_INTERVAL < 6 || BLE_CONN_ACTIVE_MIN_INTERVAL > BLE_CONN_ACTIVE_MAX_INTERVAL || \
+    BLE_CONN_IDLE_MIN_INTERVAL < 6 || BLE_CONN_IDLE_MIN_INTERVAL > BLE_CONN_IDLE_MAX_INTERVAL || \
+    BLE_CONN_ACTIVE_MAX_INTERVAL > 3200 || BLE_CONN_IDLE_MAX_INTERVAL > 3200
+#error "BLE_CONN_*_INTERVAL must satisfy 6 <= min <= max <= 3200 (7.5 ms to 4 s)"
+#endif
+// 协议要求监督超时大于 (1 + 从机延迟) x 最大间隔 x 2
+#if 4 * BLE_CONN_ACTIVE_TIMEOUT <= (1 + BLE_CONN_ACTIVE_LATENCY) * BLE_CONN_ACTIVE_MAX_INTERVAL || \
+    4 * BLE_CONN_IDLE_TIMEOUT <= (1 + BLE_CONN_IDLE_LATENCY) * BLE_CONN_IDLE_MAX_INTERVAL
+#error "BLE_CONN_*_TIMEOUT must exceed (1 + latency) * max interval * 2"
+#endif
+
+// 连接建立后请求 LE 2M PHY 与数据长度扩展（每个链路层数据包最多 BLE_DATA_LENGTH_OCTETS 字节，0 = 不请求）；
+// 中心设备不支持时控制器保持 1M PHY / 27 字节，无需额外处理。实际吞吐量用基准特征值（19B1001D）测量
+#ifndef BLE_PHY_2M_ENABLE
+#define BLE_PHY_2M_ENABLE 1
+#endif
+#ifndef BLE_DATA_LENGTH_OCTETS
+#define BLE_DATA_LENGTH_OCTETS 251
+#endif
+
+#if BLE_DATA_LENGTH_OCTETS != 0 && (BLE_DATA_LENGTH_OCTETS < 27 || BLE_DATA_LENGTH_OCTETS > 251)
+#error "BLE_DATA_LENGTH_OCTETS must be 0 (off) or 27-251"
+#endif
+
+// 1 = LE 信用制 L2CAP 通道（l2cap_module.h）：原始 IMU 录制、窗口样本流、区段追踪与诊断日志导出改走面向连接的通道，
+// 记录连续装进整 K 帧的 SDU，每个链路层数据包都是数据，不再逐条通知；模型空中更新的数据块也可经通道写入。
+// 手势事件与其余特征值仍走 GATT。中心设备不打开通道（例如 Windows 没有 LE CoC 接口）时一切照旧
+#ifndef BLE_L2CAP_ENABLE
+#define BLE_L2CAP_ENABLE 1
+#endif
+// 通道的 SPSM（LE 动态范围 0x0080-0x00FF），上位机从 19B10032 特征值读取
+#ifndef BLE_L2CAP_PSM
+#define BLE_L2CAP_PSM 0x0081
+#endif
+// 每个 K 帧的最大负载（MPS）：247 = 251 字节的链路层包减去 4 字节 L2CAP 头
+#ifndef BLE_L2CAP_MPS
+#define BLE_L2CAP_MPS 247
+#endif
+// 接收的最大 SDU（主机写入的一批记录）与接收缓冲的 K 帧数（授予主机的信用，按 MPS 计）
+#ifndef BLE_L2CAP_MTU
+#define BLE_L2CAP_MTU 512
+#endif
+#ifndef BLE_L2CAP_RX_FRAMES
+#define BLE_L2CAP_RX_FRAMES 8
+#endif
+// 发送：每个 SDU 正好 BLE_L2CAP_SDU_FRAMES 个满 K 帧（主机的 MTU 更小时按其 MTU），最多排队 BLE_L2CAP_TX_SDUS 个；
+// 队列满时记录丢弃，与通知失败相同（录制包与窗口包带序号，主机能看到缺口）
+#ifndef BLE_L2CAP_SDU_FRAMES
+#define BLE_L2CAP_SDU_FRAMES 4
+#endif
+#ifndef BLE_L2CAP_TX_SDUS
+#define BLE_L2CAP_TX_SDUS 4
+#endif
+
+#if BLE_L2CAP_PSM < 0x0080 || BLE_L2CAP_PSM > 0x00FF
+#error "BLE_L2CAP_PSM must be in the LE dynamic range 0x0080-0x00FF"
+#endif
+#if BLE_L2CAP_MPS < 23 || BLE_L2CAP_MPS > 247
+#error "BLE_L2CAP_MPS must be 23-247 (one K-frame per 251-byte link-layer packet at most)"
+#endif
+#if BLE_L2CAP_MTU < 23 || BLE_L2CAP_RX_FRAMES * BLE_L2CAP_MPS < BLE_L2CAP_MTU + 2
+#error "BLE_L2CAP_MTU must be at least 23 and one whole SDU must fit BLE_L2CAP_RX_FRAMES K-frames"
+#endif
+#if BLE_L2CAP_SDU_FRAMES < 1 || BLE_L2CAP_SDU_FRAMES * BLE_L2CAP_MPS > 65535 || BLE_L2CAP_TX_SDUS < 1
+#error "BLE_L2CAP_SDU_FRAMES and BLE_L2CAP_TX_SDUS must be at least 1"
+#endif
+
+// 无连接广播：没有中心设备连接时，最新结果（通过 ble_min_confidence 的结果）写入广播包的厂商数据，
+// 任意数量的扫描者无需连接即可接收（每个新结果重启一次广播）。厂商数据：公司 ID（u16）| 类别（u8，0xFF = 无）|
+// 置信度（u8，0-255）| 结果序列号低 16 位（u16）。0xFFFF 为蓝牙 SIG 保留给测试的公司 ID
+#ifndef BLE_BROADCAST_ENABLE
+#define BLE_BROADCAST_ENABLE 1
+#endif
+#ifndef BLE_BROADCAST_COMPANY_ID
+#define BLE_BROADCAST_COMPANY_ID 0xFFFF
+#endif
+// 1 = 可连接广播（中心设备连接后广播停止，断开后恢复）；0 = 纯广播者，不接受连接
+#ifndef BLE_BROADCAST_CONNECTABLE
+#define BLE_BROADCAST_CONNECTABLE 1
+#endif
+// 广播间隔（0.625 ms 单位；160 = 100 ms），即扫描者看到新结果的最坏额外延迟
+#ifndef BLE_BROADCAST_ADV_INTERVAL
+#define BLE_BROADCAST_ADV_INTERVAL 160
+#endif
+
+#if BLE_BROADCAST_ADV_INTERVAL < 32 || BLE_BROADCAST_ADV_INTERVAL > 16384
+#error "BLE_BROADCAST_ADV_INTERVAL must be between 32 (20 ms) and 16384 (10.24 s)"
+#endif
+
+// 广播策略（开机及每次断开后）：先向上一次连接的中心设备发高占空比定向广播（BLE_ADV_DIRECTED_ENABLE，
+// 控制器 1.28 s 后自行停止；中心设备使用可解析私有地址且已更换时连不上，直接进入下一阶段），再以
+// BLE_ADV_FAST_INTERVAL 非定向广播 BLE_ADV_FAST_MS，之后退回 BLE_ADV_SLOW_INTERVAL 直到再次连接。
+// 间隔单位 0.625 ms；无连接广播打开时慢速间隔默认沿用 BLE_BROADCAST_ADV_INTERVAL
+#ifndef BLE_ADV_DIRECTED_ENABLE
+#define BLE_ADV_DIRECTED_ENABLE 1
+#endif
+#ifndef BLE_ADV_FAST_INTERVAL
+#define BLE_ADV_FAST_INTERVAL 32  // 20 ms
+#endif
+#ifndef BLE_ADV_FAST_MS
+#define BLE_ADV_FAST_MS 10000
+#endif
+#ifndef BLE_ADV_SLOW_INTERVAL
+#if BLE_BROADCAST_ENABLE
+#define BLE_ADV_SLOW_INTERVAL BLE_BROADCAST_ADV_INTERVAL
+#else
+#define BLE_ADV_SLOW_INTERVAL 160  // 100 ms
+#endif
+#endif
+
+#if BLE_ADV_FAST_INTERVAL < 32 || BLE_ADV_FAST_INTERVAL > BLE_ADV_SLOW_INTERVAL || BLE_ADV_SLOW_INTERVAL > 16384
+#error "BLE_ADV_*_INTERVAL must satisfy 32 <= fast <= slow <= 16384 (20 ms to 10.24 s)"
+#endif
+
+// 同时连接的中心设备数（如 PC 做快捷键、手机记录会话）：会话中仍有空位时继续以 BLE_ADV_SLOW_INTERVAL 广播。
+// ArduinoBLE 的每个特征值只有一个订阅状态，任一中心设备订阅后通知发给所有已连接的中心设备，因此每个
+// 数据流只编码、发送一次，突发按各中心设备中最小的 MTU 分包；各中心设备在流声明特征值（19B10026）写入自己
+// 使用的数据流，据此各自请求连接参数。1 = 只接受一个中心设备
+#ifndef BLE_MAX_CENTRALS
+#define BLE_MAX_CENTRALS 2
+#endif
+
+#if BLE_MAX_CENTRALS < 1 || BLE_MAX_CENTRALS > 4
+#error "BLE_MAX_CENTRALS must be between 1 and 4"
+#endif
+
+// 1 = HID-over-GATT 键盘 / 多媒体键（hid_module.h）：设备与操作系统配对为蓝牙键盘，手势直接发出映射的快捷键，
+// 不经过上位机程序；映射由上位机写入键位特征值（19B10020）并保存在 Flash。广播改为键盘外观 + HID 服务 UUID
+#ifndef BLE_HID_ENABLE
+#define BLE_HID_ENABLE 0
+#endif
+// 两次按键之间的最短间隔（与 pc_controller 的 cooldown_time 默认值相同），期间的手势不按键
+#ifndef BLE_HID_COOLDOWN_MS
+#define BLE_HID_COOLDOWN_MS 2000
+#endif
+
+// 1 = 设备端组合手势（combo_module.h）：上位机把组合（如 up, up, left）写入组合特征值（19B1002D），设备编译为
+// 转移表（include/combo_matcher.h），在发布手势事件时逐个匹配，完成一个组合即在组合事件特征值（19B1002E）通知一次，
+// 不需要把每个手势发给上位机再由它判断；组合保存在 Flash
+#ifndef BLE_COMBO_ENABLE
+#define BLE_COMBO_ENABLE 1
+#endif
+// 组合个数与每个组合的手势数上限（决定特征值长度与转移表大小：1 + 两者之积个状态）
+#ifndef BLE_COMBO_MAX
+#define BLE_COMBO_MAX 8
+#endif
+#ifndef BLE_COMBO_MAX_STEPS
+#define BLE_COMBO_MAX_STEPS 6
+#endif
+// 组合记录页的地址；0 = 诊断日志扇区之前的一页
+#ifndef BLE_COMBO_FLASH_ADDR
+#define BLE_COMBO_FLASH_ADDR 0
+#endif
+
+#if BLE_COMBO_ENABLE && (BLE_COMBO_MAX < 1 || BLE_COMBO_MAX > 16 || BLE_COMBO_MAX_STEPS < 2 || \
+                         BLE_COMBO_MAX_STEPS > 8)
+#error "BLE_COMBO_MAX must be 1..16 and BLE_COMBO_MAX_STEPS 2..8"
+#endif
+
+// 1 = 模型权重空中更新（model_slot_module.h）：上位机 model_ota.py 经控制 / 数据特征值（19B10022 / 19B10023）
+// 把重新训练导出的模型权重与量化参数写入 Flash 模型槽，设备自检通过后在两次推理之间切换，不需要重新烧录固件
+#ifndef MODEL_OTA_ENABLE
+#define MODEL_OTA_ENABLE 1
+#endif
+
+// 1 = USB CDC 二进制链路（usb_link_module.h）：有线安装时上位机 serial_manager.py 经 USB 串口收发与 BLE 特征值
+// 相同的事件 / 分数 / 窗口 / 原始 IMU / 诊断数据（COBS 分帧 + CRC16，见 usb_frame.h），与文本日志共用串口。
+// 主机发出 hello 后链路打开，期间断开 BLE 连接并停止广播；保活超时或主机关闭链路后恢复广播
+#ifndef USB_LINK_ENABLE
+#define USB_LINK_ENABLE 1
+#endif
+// 超过这么久没有收到主机的 hello 保活（主机每秒发送一次）即认为链路关闭（毫秒）
+#ifndef USB_LINK_TIMEOUT_MS
+#define USB_LINK_TIMEOUT_MS 3000
+#endif
+// 链路打开期间录制线程读取串口的间隔（毫秒），即主机写入（ack、补发请求、时钟同步）的最大等待
+#ifndef USB_LINK_POLL_MS
+#define USB_LINK_POLL_MS 1
+#endif
+// 主机写入的待处理帧队列深度（2 的幂），由 BLE 线程在每次循环中处理
+#ifndef USB_LINK_QUEUE_FRAMES
+#define USB_LINK_QUEUE_FRAMES 8
+#endif
+// 1 = 二进制诊断命令（shell_module.h）：USB 帧 0x32 上带序号的请求 / 应答，读统计、运行推理基准、读写配置、
+// 开始 / 停止 / 读取区段追踪与开始回放。不需要主机打开链路（不会断开 BLE 连接），在低优先级的录制线程中处理，
+// 应答按固定布局编码而不经 printf 格式化；量产配置默认关闭，需要现场诊断时可以单独打开
+#ifndef SHELL_ENABLE
+#define SHELL_ENABLE (USB_LINK_ENABLE && BUILD_DIAGNOSTICS)
+#endif
+#if SHELL_ENABLE && !USB_LINK_ENABLE
+#error "SHELL_ENABLE requires USB_LINK_ENABLE (the shell uses the link's framing)"
+#endif
+
+// ==================== 内存 ====================
+
+// 芯片 RAM 总量（nRF52840：256 KB），用于启动时打印的 RAM 预算
+#ifndef MEMORY_RAM_BYTES
+#define MEMORY_RAM_BYTES (256UL * 1024UL)
+#endif
+
+// DMA 能访问的 RAM 范围：启动时检查登记为 DMA 的热路径缓冲区（memory_module_check_placement）在其中。
+// nRF52 的 EasyDMA 只能访问数据 RAM（0x20000000 起），放在 Flash 中的常量缓冲区会让传输失败；
+// 其他平台默认为 0 = 不检查范围
+#ifndef MEMORY_DMA_RAM_START
+#define MEMORY_DMA_RAM_START 0x20000000UL
+#endif
+#ifndef MEMORY_DMA_RAM_BYTES
+#if PLATFORM_NRF52
+#define MEMORY_DMA_RAM_BYTES MEMORY_RAM_BYTES
+#else
+#define MEMORY_DMA_RAM_BYTES 0
+#endif
+#endif
+// 可选：DMA 缓冲区放入的链接段（链接脚本中须有该段，例如只有部分 RAM 块可被 DMA 访问的芯片），未定义时在默认的 .bss
+// #define MEMORY_DMA_SECTION ".dma_bss"
+
+// 启动时检查的热路径缓冲区登记表容量
+#ifndef MEMORY_HOT_BUFFER_CAPACITY
+#define MEMORY_HOT_BUFFER_CAPACITY 16
+#endif
+
+// Edge Impulse SDK 的运行时分配（ei_malloc / ei_calloc / ei_free，见 alloc_module.h）：
+// 初始化阶段从只增不减的 arena 顺序分配，推理开始后从三档定长块池分配（块大小须为 8 的倍数）
+#ifndef ALLOC_ARENA_BYTES
+#define ALLOC_ARENA_BYTES 512
+#endif
+#ifndef ALLOC_POOL_SMALL_BYTES
+#define ALLOC_POOL_SMALL_BYTES 32
+#endif
+#ifndef ALLOC_POOL_SMALL_BLOCKS
+#define ALLOC_POOL_SMALL_BLOCKS 16
+#endif
+#ifndef ALLOC_POOL_MEDIUM_BYTES
+#define ALLOC_POOL_MEDIUM_BYTES 128
+#endif
+#ifndef ALLOC_POOL_MEDIUM_BLOCKS
+#define ALLOC_POOL_MEDIUM_BLOCKS 8
+#endif
+#ifndef ALLOC_POOL_LARGE_BYTES
+#define ALLOC_POOL_LARGE_BYTES 512
+#endif
+#ifndef ALLOC_POOL_LARGE_BLOCKS
+#define ALLOC_POOL_LARGE_BLOCKS 2
+#endif
+// 1 = arena / 块池放不下时退回 newlib malloc（计数并在报告中提示调大）；0 = 直接返回 nullptr
+#ifndef ALLOC_HEAP_FALLBACK
+#define ALLOC_HEAP_FALLBACK 1
+#endif
+
+#if !(ALLOC_POOL_SMALL_BYTES < ALLOC_POOL_MEDIUM_BYTES && ALLOC_POOL_MEDIUM_BYTES < ALLOC_POOL_LARGE_BYTES)
+#error "ALLOC_POOL_*_BYTES must be strictly increasing (small < medium < large)"
+#endif
+
+// ==================== LED ====================
+
+// 0 = 不编译 LED 模块：没有 PWM 输出、动画队列与 LED 事件，推理结果不再为 LED 排队
+#ifndef LED_ENABLE
+#define LED_ENABLE BUILD_DIAGNOSTICS
+#endif
+
+// RGB LED 由硬件 PWM 驱动（mbed::PwmOut），动画关键帧由 mbed::Timeout 中断推进：
+// 保持阶段不占用 CPU，渐变阶段每 LED_FADE_STEP_MS 更新一次占空比
+#ifndef LED_PWM_PERIOD_US
+#define LED_PWM_PERIOD_US 2000
+#endif
+// RGB 三色的 Arduino 引脚：Nano 33 BLE 为板载 LED；RP2040 版本为接在 D3 / D4 / D5 上、ESP32 版本为接在
+// GPIO25 / 26 / 27 上的共阳极 LED，与板载 LED 一样低电平点亮
+#ifndef LED_PIN_RED
+#if PLATFORM_ESP32
+#define LED_PIN_RED 25
+#define LED_PIN_GREEN 26
+#define LED_PIN_BLUE 27
+#elif PLATFORM_RP2040
+#define LED_PIN_RED 3
+#define LED_PIN_GREEN 4
+#define LED_PIN_BLUE 5
+#else
+#define LED_PIN_RED LEDR
+#define LED_PIN_GREEN LEDG
+#define LED_PIN_BLUE LEDB
+#endif
+#endif
+#ifndef LED_FADE_STEP_MS
+#define LED_FADE_STEP_MS 20
+#endif
+
+// 待播放动画的队列深度（必须是 2 的幂）；队列满时新动画被丢弃
+#ifndef LED_QUEUE_PATTERNS
+#define LED_QUEUE_PATTERNS 4
+#endif
+
+// 显示结果所需的最低置信度；亮度随置信度从 LED_MIN_BRIGHTNESS（阈值处）线性升到 1（置信度 1）
+#ifndef LED_CONFIDENCE_THRESHOLD
+#define LED_CONFIDENCE_THRESHOLD 0.80f
+#endif
+#ifndef LED_MIN_BRIGHTNESS
+#define LED_MIN_BRIGHTNESS 0.25f
+#endif
+
+// 手势颜色的显示时长（毫秒，含淡入淡出）
+#ifndef LED_GESTURE_MS
+#define LED_GESTURE_MS 500
+#endif
+
+// ==================== 运行时配置 ====================
+
+// 以下是运行时配置（config_module）的编译期默认值与预设：启动时优先载入 Flash 中保存的配置，
+// BLE 配置特征或串口命令 "cfg" 修改后立即生效并写回 Flash。LED 阈值见 LED_CONFIDENCE_THRESHOLD，
+// 推理步长见 INFERENCE_STRIDE_*_SAMPLES，BLE 轮询间隔见 BLE_POLL_INTERVAL_MS
+
+// BLE 只发送置信度不低于该值的结果
+#ifndef BLE_MIN_CONFIDENCE
+#define BLE_MIN_CONFIDENCE 0.55f
+#endif
+
+// "低延迟"预设：每 2 个样本推理一次，稳定 idle 时也不放宽步长，BLE 20 ms 轮询
+#ifndef CONFIG_LOW_LATENCY_STRIDE_FINE
+#define CONFIG_LOW_LATENCY_STRIDE_FINE 2
+#endif
+#ifndef CONFIG_LOW_LATENCY_STRIDE_COARSE
+#define CONFIG_LOW_LATENCY_STRIDE_COARSE 2
+#endif
+#ifndef CONFIG_LOW_LATENCY_POLL_MS
+#define CONFIG_LOW_LATENCY_POLL_MS 20
+#endif
+// "低功耗"预设：细步长 4 个样本（约 83 ms），稳定 idle 时 12 个样本（250 ms），BLE 250 ms 轮询。
+// 预设只改变上述运行时参数，FIFO 水位等硬件设置仍由 POWER_LOW_POWER_MODE 在编译期决定
+#ifndef CONFIG_LOW_POWER_STRIDE_FINE
+#define CONFIG_LOW_POWER_STRIDE_FINE 4
+#endif
+#ifndef CONFIG_LOW_POWER_STRIDE_COARSE
+#define CONFIG_LOW_POWER_STRIDE_COARSE 12
+#endif
+#ifndef CONFIG_LOW_POWER_POLL_MS
+#define CONFIG_LOW_POWER_POLL_MS 250
+#endif
+
+// BLE 轮询间隔的允许范围（毫秒）：下限避免 BLE 线程空转，上限保证诊断数据与连接事件及时处理
+#ifndef CONFIG_POLL_MIN_MS
+#define CONFIG_POLL_MIN_MS 10
+#endif
+#ifndef CONFIG_POLL_MAX_MS
+#define CONFIG_POLL_MAX_MS 1000
+#endif
+
+// 运行时配置所在 Flash 页的地址；0 = 使用校准页之前的一页
+#ifndef CONFIG_FLASH_ADDR
+#define CONFIG_FLASH_ADDR 0
+#endif
+// HID 键位与配对记录所在 Flash 页的地址；0 = 使用运行时配置页之前的一页
+#ifndef HID_FLASH_ADDR
+#define HID_FLASH_ADDR 0
+#endif
+// 模型提交记录所在 Flash 页的地址；0 = 使用 HID 页之前的一页。两个模型槽紧接在它之前（model_slot_module.h）
+#ifndef MODEL_FLASH_ADDR
+#define MODEL_FLASH_ADDR 0
+#endif
+// 每个模型槽的大小（字节，须为 4 KB 扇区的整数倍）：当前图的全部权重、量化参数与自检向量约 2.6 KB
+#ifndef MODEL_SLOT_BYTES
+#define MODEL_SLOT_BYTES 4096
+#endif
+
+#if MODEL_SLOT_BYTES <= 0 || MODEL_SLOT_BYTES % 4096 != 0
+#error "MODEL_SLOT_BYTES must be a positive multiple of the 4 KB flash sector"
+#endif
+
+// ==================== 日志 ====================
+
+// 日志级别（LOG_ERROR / LOG_WARN / LOG_INFO / LOG_DEBUG，见 log_module.h）
+#define LOG_LEVEL_OFF 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+// 编译进固件的最低级别，更详细的日志调用在编译期消除
+#ifndef LOG_LEVEL
+#define LOG_LEVEL (BUILD_DIAGNOSTICS ? LOG_LEVEL_INFO : LOG_LEVEL_WARN)
+#endif
+// 0 = 日志中的 %f / %e / %g 按千分位定点数输出（忽略宽度与精度），不链接 printf 的浮点格式化
+#ifndef LOG_FLOAT_ENABLE
+#define LOG_FLOAT_ENABLE BUILD_DIAGNOSTICS
+#endif
+
+// 1 = 调用线程只把记录写入队列，由日志线程格式化并写串口；0 = 在调用线程中立即输出（主机回放构建）
+#ifndef LOG_DEFERRED
+#define LOG_DEFERRED (INFERENCE_HOST_REPLAY ? 0 : 1)
+#endif
+
+// 日志记录队列深度（必须是 2 的幂），以及单条记录的参数个数上限
+#ifndef LOG_QUEUE_RECORDS
+#define LOG_QUEUE_RECORDS 32
+#endif
+#ifndef LOG_MAX_ARGS
+#define LOG_MAX_ARGS 12
+#endif
+
+// ==================== 线程 ====================
+
+// 各线程优先级：采集 > 推理 > BLE > 事件（录制与 BLE 同级）。采集线程必须能抢占推理，
+// 否则 invoke 期间 IMU FIFO 会溢出；BLE / LED 只是结果的消费者，晚几毫秒不影响识别。
+// LED 动画与日志输出不各占线程，作为事件在同一个事件线程上派发（event_module.h），省下一份栈与每个结果的一次线程切换。
+#ifndef THREAD_SAMPLER_PRIORITY
+#define THREAD_SAMPLER_PRIORITY osPriorityAboveNormal
+#endif
+#ifndef THREAD_INFERENCE_PRIORITY
+#define THREAD_INFERENCE_PRIORITY osPriorityNormal
+#endif
+#ifndef THREAD_BLE_PRIORITY
+#define THREAD_BLE_PRIORITY osPriorityBelowNormal
+#endif
+#ifndef THREAD_EVENTS_PRIORITY
+#define THREAD_EVENTS_PRIORITY osPriorityLow1
+#endif
+#ifndef THREAD_RECORD_PRIORITY
+#define THREAD_RECORD_PRIORITY osPriorityBelowNormal
+#endif
+// HCI 监视线程只在协议栈收到数据时唤醒 BLE 线程（BLE_EVENT_DRIVEN），与 BLE 同级
+#ifndef THREAD_HCI_PRIORITY
+#define THREAD_HCI_PRIORITY osPriorityBelowNormal
+#endif
+
+// 各线程栈大小（字节，8 的倍数）；按串口 [Threads] 报告的栈峰值留出余量后再缩小
+#ifndef THREAD_SAMPLER_STACK_BYTES
+#define THREAD_SAMPLER_STACK_BYTES 2048
+#endif
+#ifndef THREAD_INFERENCE_STACK_BYTES
+#define THREAD_INFERENCE_STACK_BYTES 8192
+#endif
+#ifndef THREAD_BLE_STACK_BYTES
+#define THREAD_BLE_STACK_BYTES 4096
+#endif
+// 事件线程只需容纳 LED 结果处理与日志格式化中较深的一个（原先 LED 4096 + 日志 2048 两份栈）
+#ifndef THREAD_EVENTS_STACK_BYTES
+#define THREAD_EVENTS_STACK_BYTES 2560
+#endif
+#ifndef THREAD_RECORD_STACK_BYTES
+#define THREAD_RECORD_STACK_BYTES 2048
+#endif
+#ifndef THREAD_HCI_STACK_BYTES
+#define THREAD_HCI_STACK_BYTES 768
+#endif
+
+#if (THREAD_SAMPLER_STACK_BYTES % 8) || (THREAD_INFERENCE_STACK_BYTES % 8) || (THREAD_BLE_STACK_BYTES % 8) || \
+    (THREAD_EVENTS_STACK_BYTES % 8) || (THREAD_RECORD_STACK_BYTES % 8) || (THREAD_HCI_STACK_BYTES % 8)
+#error "THREAD_*_STACK_BYTES must be multiples of 8"
+#endif
+
+// 串口打印各线程栈峰值的间隔（毫秒）；0 = 不打印
+#ifndef THREAD_REPORT_INTERVAL_MS
+#define THREAD_REPORT_INTERVAL_MS (BUILD_DIAGNOSTICS ? 30000 : 0)
+#endif
+
+// ==================== 延迟与看门狗 ====================
+
+// 手势到动作的延迟目标（毫秒）：每个统计窗口分别统计各阶段超过它的次数（须为 2 的倍数，不超过 254）
+#ifndef LATENCY_SLO_MS
+#define LATENCY_SLO_MS 150
+#endif
+// BLE 线程记住的最近已通知的结果个数，用于把主机回执对应回结果的样本时刻
+#ifndef LATENCY_ACK_TRACKED
+#define LATENCY_ACK_TRACKED 8
+#endif
+
+// 硬件看门狗：推理线程每循环一次喂一次，线程停止推进超过 WATCHDOG_TIMEOUT_MS 时复位（主机回放无硬件看门狗）
+#ifndef WATCHDOG_ENABLE
+#define WATCHDOG_ENABLE (INFERENCE_HOST_REPLAY ? 0 : 1)
+#endif
+#ifndef WATCHDOG_TIMEOUT_MS
+#define WATCHDOG_TIMEOUT_MS 4000
+#endif
+// 推理线程两次循环的间隔超过该值即记为一次停滞（不复位，只计入统计）；正常情况下间隔不超过等样本超时 200 ms
+#ifndef WATCHDOG_STALL_MS
+#define WATCHDOG_STALL_MS 500
+#endif
+
+// 崩溃记录（include/crash_module.h）：硬件错误、线程栈溢出与 mbed 致命错误时，把故障寄存器、出错线程、
+// 各线程栈峰值与最近 CRASH_TRAIL_DEPTH 次流水线级运行写进不随复位清零的 RAM 并立即复位，下次启动时报告。
+// 依赖 Mbed 的 mbed_error_hook（ESP32 与主机回放没有）；CRASH_NOINIT_SECTION 是链接脚本中不清零、不载入初值的段
+#ifndef CRASH_CAPTURE_ENABLE
+#define CRASH_CAPTURE_ENABLE (INFERENCE_HOST_REPLAY || PLATFORM_ESP32 ? 0 : 1)
+#endif
+#ifndef CRASH_TRAIL_DEPTH
+#define CRASH_TRAIL_DEPTH 16
+#endif
+#ifndef CRASH_NOINIT_SECTION
+#if PLATFORM_RP2040
+#define CRASH_NOINIT_SECTION ".uninitialized_data"
+#else
+#define CRASH_NOINIT_SECTION ".noinit"
+#endif
+#endif
+
+#if (LATENCY_SLO_MS % 2) || LATENCY_SLO_MS > 254
+#error "LATENCY_SLO_MS must be even and at most 254 (latency histogram range)"
+#endif
+#if WATCHDOG_STALL_MS >= WATCHDOG_TIMEOUT_MS
+#error "WATCHDOG_STALL_MS must be shorter than WATCHDOG_TIMEOUT_MS"
+#endif
+#if (CRASH_TRAIL_DEPTH & (CRASH_TRAIL_DEPTH - 1)) || CRASH_TRAIL_DEPTH > 16
+#error "CRASH_TRAIL_DEPTH must be a power of two of at most 16 (the report fits one USB frame)"
+#endif
+
+// ==================== 现场诊断日志 ====================
+
+// 1 = 现场诊断日志（telemetry_module.h）：手势事件、置信度直方图、低置信度窗口、复位与延迟超标写入片上
+// Flash 的环形日志（只追加，按扇区轮转均衡磨损），上位机 telemetry_dump.py 经 BLE（19B1002B / 19B1002C）
+// 或 USB 链路整批读出（主机回放没有 Flash）
+#ifndef TELEMETRY_ENABLE
+#define TELEMETRY_ENABLE (INFERENCE_HOST_REPLAY ? 0 : 1)
+#endif
+// 环形日志的扇区数（每个 4 KB，轮转到最旧的扇区时才擦除它）；默认 16 个扇区约能保存几天的记录
+#ifndef TELEMETRY_SECTORS
+#define TELEMETRY_SECTORS 16
+#endif
+// 环形日志的起始地址；0 = 紧接在自定义手势页之前的 TELEMETRY_SECTORS 个扇区
+#ifndef TELEMETRY_FLASH_ADDR
+#define TELEMETRY_FLASH_ADDR 0
+#endif
+// RAM 中攒批的字节数（双缓冲各一份）：攒满或到 TELEMETRY_FLUSH_MS 时由主循环一次写入，写满时新记录丢弃并计数
+#ifndef TELEMETRY_BATCH_BYTES
+#define TELEMETRY_BATCH_BYTES 512
+#endif
+// 攒批的最长时间（毫秒）：有记录等待这么久即写入，即使不满一批
+#ifndef TELEMETRY_FLUSH_MS
+#define TELEMETRY_FLUSH_MS 60000
+#endif
+// 置信度直方图的记录周期（毫秒）：每个周期把 CNN 获胜类别的置信度分布记为一条记录（期间没有推理时不记）
+#ifndef TELEMETRY_HISTOGRAM_MS
+#define TELEMETRY_HISTOGRAM_MS 60000
+#endif
+// 逐类别直方图的记录周期（毫秒）：每个周期为这期间获胜过的每个类别记两条记录（获胜概率、与第二名的差距），
+// 用于按设备群调整 BLE / 上位机阈值、发现传感器漂移；启动以来的累计值随时可经诊断命令读取
+#ifndef TELEMETRY_LABEL_HISTOGRAM_MS
+#define TELEMETRY_LABEL_HISTOGRAM_MS 600000
+#endif
+// 两条低置信度窗口记录的最短间隔（毫秒），期间的低置信度窗口只计数，随下一条记录写入
+#ifndef TELEMETRY_LOW_CONFIDENCE_MS
+#define TELEMETRY_LOW_CONFIDENCE_MS 1000
+#endif
+
+#if TELEMETRY_ENABLE && INFERENCE_HOST_REPLAY
+#error "TELEMETRY_ENABLE requires the device build (the log is kept in flash)"
+#endif
+#if TELEMETRY_ENABLE && (TELEMETRY_SECTORS < 2 || TELEMETRY_SECTORS > 64 || TELEMETRY_BATCH_BYTES % 4 != 0 || \
+                         TELEMETRY_BATCH_BYTES < 64 || TELEMETRY_BATCH_BYTES > 4096 - 8)
+#error "TELEMETRY_SECTORS must be 2..64 and TELEMETRY_BATCH_BYTES a multiple of 4 between 64 and one sector"
+#endif
+
+// 1 = 主动学习采集（capture_module.h）：获胜类别的概率落在含糊区间、或前两名的差距很小时，把该 int8 窗口
+// （限速）复制进片上 Flash 中独立的环形区域，上位机 capture_dump.py 经诊断日志的通道整批读出后标注
+// （需要 TELEMETRY_ENABLE 与 INFERENCE_INT8_WINDOW）
+#ifndef CAPTURE_ENABLE
+#define CAPTURE_ENABLE 0
+#endif
+// 含糊区间 [下限, 上限]：获胜类别的概率落在其中的窗口被采集
+#ifndef CAPTURE_BAND_LOW
+#define CAPTURE_BAND_LOW 0.4f
+#endif
+#ifndef CAPTURE_BAND_HIGH
+#define CAPTURE_BAND_HIGH 0.7f
+#endif
+// 前两名的概率差低于它的窗口同样被采集（0 = 只按含糊区间）
+#ifndef CAPTURE_MARGIN
+#define CAPTURE_MARGIN 0.15f
+#endif
+// 两次采集的最短间隔（毫秒）：连续的含糊窗口几乎相同，期间只计数，随下一条记录写入
+#ifndef CAPTURE_INTERVAL_MS
+#define CAPTURE_INTERVAL_MS 2000
+#endif
+// 环形区域的扇区数（每个 4 KB，约 44 个窗口）；写满后擦除最旧的扇区
+#ifndef CAPTURE_SECTORS
+#define CAPTURE_SECTORS 8
+#endif
+// 环形区域的起始地址；0 = 紧接在组合手势页之前的 CAPTURE_SECTORS 个扇区
+#ifndef CAPTURE_FLASH_ADDR
+#define CAPTURE_FLASH_ADDR 0
+#endif
+// 推理线程与主循环之间等待写入的窗口数（2 的幂）：满时新窗口只计数，推理线程从不等待 Flash
+#ifndef CAPTURE_QUEUE_DEPTH
+#define CAPTURE_QUEUE_DEPTH 4
+#endif
+
+#if CAPTURE_ENABLE && !TELEMETRY_ENABLE
+#error "CAPTURE_ENABLE requires TELEMETRY_ENABLE (captured windows are downloaded through the diagnostics log)"
+#endif
+#if CAPTURE_ENABLE && (CAPTURE_SECTORS < 2 || CAPTURE_SECTORS > 64 || (CAPTURE_QUEUE_DEPTH & (CAPTURE_QUEUE_DEPTH - 1)))
+#error "CAPTURE_SECTORS must be 2..64 and CAPTURE_QUEUE_DEPTH a power of two"
+#endif
+
+// ==================== 监督与自恢复 ====================
+
+// 启动时 IMU / BLE 初始化的尝试次数；IMU 仍失败则软件复位，BLE 仍失败则由 BLE 线程在后台继续重试
+#ifndef SUPERVISOR_INIT_RETRIES
+#define SUPERVISOR_INIT_RETRIES 3
+#endif
+// 两次初始化尝试之间的退避（毫秒）：从最小值开始每次翻倍，不超过最大值
+#ifndef SUPERVISOR_BACKOFF_MIN_MS
+#define SUPERVISOR_BACKOFF_MIN_MS 50
+#endif
+#ifndef SUPERVISOR_BACKOFF_MAX_MS
+#define SUPERVISOR_BACKOFF_MAX_MS 5000
+#endif
+// 主线程检查各线程心跳的周期（毫秒）
+#ifndef SUPERVISOR_POLL_MS
+#define SUPERVISOR_POLL_MS 250
+#endif
+// 发过心跳的线程超过该时间没有新心跳即视为卡死并重启；须短于看门狗超时，推理线程重启后才来得及重新喂狗
+#ifndef SUPERVISOR_STALL_MS
+#define SUPERVISOR_STALL_MS 2500
+#endif
+
+#if BLE_EVENT_DRIVEN && BLE_EVENT_BACKSTOP_MS >= SUPERVISOR_STALL_MS
+#error "BLE_EVENT_BACKSTOP_MS must be shorter than SUPERVISOR_STALL_MS (the BLE thread's heartbeat)"
+#endif
+// 同一线程连续重启（两次之间稳定运行不到 SUPERVISOR_STABLE_MS）达到该次数后放弃重启，软件复位
+#ifndef SUPERVISOR_MAX_RESTARTS
+#define SUPERVISOR_MAX_RESTARTS 3
+#endif
+#ifndef SUPERVISOR_STABLE_MS
+#define SUPERVISOR_STABLE_MS 10000
+#endif
+// 软件复位前留给串口输出原因的时间（毫秒）
+#ifndef SUPERVISOR_RESET_DELAY_MS
+#define SUPERVISOR_RESET_DELAY_MS 500
+#endif
+// 采集线程连续这么多次唤醒都读不到数据（总线错误或 FIFO 为空）时重新配置传感器；
+// 仍失败时下一次重新配置前的唤醒次数翻倍，不超过最大值
+#ifndef IMU_RECOVERY_WAKEUPS
+#define IMU_RECOVERY_WAKEUPS 3
+#endif
+#ifndef IMU_RECOVERY_MAX_WAKEUPS
+#define IMU_RECOVERY_MAX_WAKEUPS 48
+#endif
+
+#if SUPERVISOR_STALL_MS + SUPERVISOR_POLL_MS >= WATCHDOG_TIMEOUT_MS
+#error "SUPERVISOR_STALL_MS + SUPERVISOR_POLL_MS must be shorter than WATCHDOG_TIMEOUT_MS"
+#endif
+#if SUPERVISOR_STALL_MS <= CONFIG_POLL_MAX_MS
+#error "SUPERVISOR_STALL_MS must be longer than the longest BLE poll interval (CONFIG_POLL_MAX_MS)"
+#endif
+
+// ==================== 原始数据录制 ====================
+
+// 0 = 不编译录制（编码器、包队列与 BLE 录制特征值 19B10014 / 19B10015）；录制线程仍处理 USB 链路的帧
+#ifndef RECORD_ENABLE
+#define RECORD_ENABLE BUILD_DIAGNOSTICS
+#endif
+// 1 = 录制线程解析串口文本命令（rec / replay / prof / bench / mem / zones / cfg / ble / model）
+#ifndef SERIAL_COMMANDS_ENABLE
+#define SERIAL_COMMANDS_ENABLE BUILD_DIAGNOSTICS
+#endif
+
+// 待发送录制包的队列深度（每包最多 244 字节；400 Hz 6 轴约 20 包/秒）
+#ifndef RECORD_QUEUE_PACKETS
+#define RECORD_QUEUE_PACKETS 16
+#endif
+
+// 包未写满时最长等待时间（毫秒），限制低采样率下的输出延迟
+#ifndef RECORD_FLUSH_MS
+#define RECORD_FLUSH_MS 100
+#endif
+
+// ==================== 板上回放 ====================
+
+// 回放队列深度（原始帧，2 的幂）：串口接收与采集线程之间的缓冲，决定主机可以领先实时多少
+#ifndef REPLAY_QUEUE_FRAMES
+#define REPLAY_QUEUE_FRAMES 256
+#endif
+
+// 待打印结果的队列深度（2 的幂）
+#ifndef REPLAY_RESULT_QUEUE
+#define REPLAY_RESULT_QUEUE 32
+#endif
+
+// 回放中超过该时长（毫秒）没有收到数据则按已收到的部分结束
+#ifndef REPLAY_TIMEOUT_MS
+#define REPLAY_TIMEOUT_MS 2000
+#endif
+
+// ==================== 运动门控 ====================
+
+// 1 = 使用 BMI270 any-motion / no-motion 特性判定静止，静止时跳过分类（需要 IMU_USE_FIFO）
+#ifndef MOTION_GATE_ENABLE
+#define MOTION_GATE_ENABLE IMU_USE_FIFO
+#endif
+
+// 1 = 静止时同时暂停读取 FIFO；FIFO 以覆盖模式保留最近约 1.7 秒数据，恢复时用来预填窗口
+#ifndef MOTION_GATE_SAMPLING
+#define MOTION_GATE_SAMPLING 0
+#endif
+
+#if MOTION_GATE_ENABLE && !IMU_USE_FIFO
+#error "MOTION_GATE_ENABLE requires IMU_USE_FIFO (motion interrupts share INT1 with the FIFO watermark)"
+#endif
+
+// any-motion：加速度变化超过阈值并持续该时长即判定为开始运动
+#ifndef MOTION_ANY_THRESHOLD_MG
+#define MOTION_ANY_THRESHOLD_MG 60
+#endif
+#ifndef MOTION_ANY_DURATION_MS
+#define MOTION_ANY_DURATION_MS 40
+#endif
+
+// no-motion：加速度变化一直低于阈值并持续该时长才判定为静止（需大于一个手势窗口）
+#ifndef MOTION_NO_THRESHOLD_MG
+#define MOTION_NO_THRESHOLD_MG 40
+#endif
+#ifndef MOTION_NO_DURATION_MS
+#define MOTION_NO_DURATION_MS 2000
+#endif
+
+// ==================== 两段式唤醒 ====================
+
+// 1 = 先唤醒、再识别：平时只运行逐帧的双击检测（include/tap_detector.h），不运行 CNN、不发布结果；
+// 检测到双击后在 ARM_WINDOW_MS 内全速分类。BMI270 的特性配置中没有敲击检测，双击在推理线程已经
+// 计算的运动能量上判定；可与运动门控同时使用（敲击本身会触发 any-motion）
+#ifndef INFERENCE_ARM_MODE
+#define INFERENCE_ARM_MODE 0
+#endif
+
+// 唤醒窗口长度（毫秒）；窗口内每识别到一个非 idle 手势都从该时刻重新计时，到期时清除当前结果
+#ifndef ARM_WINDOW_MS
+#define ARM_WINDOW_MS 5000
+#endif
+
+// 敲击：单帧运动能量（相邻样本差的平方和，单位 g^2）超过阈值；0.25 约为相邻样本间 0.5 g 的跳变
+#ifndef ARM_TAP_ENERGY_THRESHOLD
+#define ARM_TAP_ENERGY_THRESHOLD 0.25f
+#endif
+
+// 一次敲击超过阈值的最长时间（毫秒），更长的是一般运动
+#ifndef ARM_TAP_MAX_PULSE_MS
+#define ARM_TAP_MAX_PULSE_MS 60
+#endif
+
+// 两次敲击起点的间隔范围（毫秒）
+#ifndef ARM_TAP_MIN_GAP_MS
+#define ARM_TAP_MIN_GAP_MS 100
+#endif
+#ifndef ARM_TAP_MAX_GAP_MS
+#define ARM_TAP_MAX_GAP_MS 500
+#endif
+
+// ==================== 电量分级 ====================
+
+// 1 = 按电池电压逐级降级（battery_module）：满速（运行时配置的步长）→ 粗步长 → 只在运动能量超过阈值的步推理
+// （idle 过滤）→ 双击唤醒后才推理（按需）；当前工作点与电压经 BLE 特征 19B1002F / USB 帧 0x2F 发布
+#ifndef BATTERY_LADDER_ENABLE
+#define BATTERY_LADDER_ENABLE 0
+#endif
+
+// 双击唤醒的代码在两段式或电量分级的按需一级需要时编译
+#define INFERENCE_ARM_SUPPORT (INFERENCE_ARM_MODE || BATTERY_LADDER_ENABLE)
+
+// 电池电压经分压接入的模拟引脚（nRF52840 SAADC；Nano 33 BLE 的 VIN 经稳压后无法在片内测量）、
+// 分压比（电池电压 / 引脚电压）与 ADC 满量程电压（核心默认以 VDD 为参考）
+#ifndef BATTERY_ADC_PIN
+#define BATTERY_ADC_PIN A0
+#endif
+#ifndef BATTERY_DIVIDER_RATIO
+#define BATTERY_DIVIDER_RATIO 2.0f
+#endif
+#ifndef BATTERY_ADC_FULL_SCALE_V
+#define BATTERY_ADC_FULL_SCALE_V 3.3f
+#endif
+// 每次测量平均的转换次数与测量间隔（毫秒，由主循环执行）
+#ifndef BATTERY_ADC_SAMPLES
+#define BATTERY_ADC_SAMPLES 8
+#endif
+#ifndef BATTERY_POLL_MS
+#define BATTERY_POLL_MS 10000
+#endif
+
+// 电压低于这些值（mV）时进入对应的工作点；回升到阈值加滞回以上才回到上一级
+#ifndef BATTERY_COARSE_MV
+#define BATTERY_COARSE_MV 3700
+#endif
+#ifndef BATTERY_IDLE_FILTER_MV
+#define BATTERY_IDLE_FILTER_MV 3550
+#endif
+#ifndef BATTERY_ON_DEMAND_MV
+#define BATTERY_ON_DEMAND_MV 3400
+#endif
+#ifndef BATTERY_HYSTERESIS_MV
+#define BATTERY_HYSTERESIS_MV 50
+#endif
+
+#if BATTERY_LADDER_ENABLE && !(BATTERY_COARSE_MV > BATTERY_IDLE_FILTER_MV && BATTERY_IDLE_FILTER_MV > BATTERY_ON_DEMAND_MV)
+#error "BATTERY_*_MV thresholds must decrease: COARSE > IDLE_FILTER > ON_DEMAND"
+#endif
+
+// ==================== 推理 ====================
+
+// 1 = 主机离线回放构建（host_replay 环境）：采集线程等待推理线程腾出队列空间，回放不丢样本
+#ifndef INFERENCE_HOST_REPLAY
+#define INFERENCE_HOST_REPLAY 0
+#endif
+
+// 1 = 滑动窗口直接以模型输入的 int8 量化格式存放，并绕过 run_classifier 直接调用编译后的模型
+// （窗口内存降为 1/4，样本只量化一次）；0 = 浮点窗口 + run_classifier
+#ifndef INFERENCE_INT8_WINDOW
+#define INFERENCE_INT8_WINDOW 0
+#endif
+
+// 1 = 定点特征链：IMU 抽取后的校准、重采样都在 int16（传感器 LSB）域完成，样本以 int16 进入队列，
+// 再按原始特征块（ei_model_dsp_t）的缩放与输入量化参数用 Q15 乘法直接量化为 int8，全程不转换为浮点
+// （需要 INFERENCE_INT8_WINDOW）；0 = 校准后换算为 g / dps 的浮点样本
+#ifndef INFERENCE_Q15_FEATURES
+#define INFERENCE_Q15_FEATURES 0
+#endif
+
+#if INFERENCE_Q15_FEATURES && !INFERENCE_INT8_WINDOW
+#error "INFERENCE_Q15_FEATURES requires INFERENCE_INT8_WINDOW (the float window path feeds run_classifier with float samples)"
+#endif
+
+// 1 = 流水线输入：采集线程在样本进入队列前就量化为模型输入格式（与上一次推理重叠执行，采集线程优先级更高），
+// 队列存放 int8，推理线程到达步长边界时只需把现成的一步拷进窗口（需要 INFERENCE_INT8_WINDOW）
+#ifndef INFERENCE_PIPELINED_INPUT
+#define INFERENCE_PIPELINED_INPUT 0
+#endif
+
+#if INFERENCE_PIPELINED_INPUT && !INFERENCE_INT8_WINDOW
+#error "INFERENCE_PIPELINED_INPUT requires INFERENCE_INT8_WINDOW (only the int8 window has a model-format sample representation)"
+#endif
+
+// 1 = 逐窗口标准化（模型按标准化后的窗口训练时打开）：按轴增量维护窗口的均值 / 方差，新进入窗口的样本
+// 按 (x - mean) / std 标准化并直接量化为 int8（代价与步长成正比）；每个样本按到达时的窗口统计量标准化，
+// 训练数据须按同样的方式处理。idle 预筛改用这份统计量，结果记忆的容差随之按标准差计（需要 INFERENCE_INT8_WINDOW）
+#ifndef INFERENCE_WINDOW_NORMALIZE
+#define INFERENCE_WINDOW_NORMALIZE 0
+#endif
+// 标准化的标准差下限（g 或 dps）：静止窗口不把噪声放大到满量程
+#ifndef INFERENCE_NORMALIZE_MIN_STD
+#define INFERENCE_NORMALIZE_MIN_STD 0.05f
+#endif
+
+#if INFERENCE_WINDOW_NORMALIZE && !INFERENCE_INT8_WINDOW
+#error "INFERENCE_WINDOW_NORMALIZE requires INFERENCE_INT8_WINDOW (normalization is fused into the int8 quantization)"
+#endif
+#if INFERENCE_WINDOW_NORMALIZE && INFERENCE_PIPELINED_INPUT
+#error "INFERENCE_WINDOW_NORMALIZE does not support INFERENCE_PIPELINED_INPUT (energy and duplicate statistics are read from the quantized samples)"
+#endif
+
+// 1 = 流式推理：缓存重叠窗口的卷积激活，每步只计算新进入窗口的时间列（需要 INFERENCE_INT8_WINDOW）
+#ifndef INFERENCE_STREAMING
+#define INFERENCE_STREAMING INFERENCE_INT8_WINDOW
+#endif
+
+#if INFERENCE_STREAMING && !INFERENCE_INT8_WINDOW
+#error "INFERENCE_STREAMING requires INFERENCE_INT8_WINDOW (activations are cached from the quantized window)"
+#endif
+
+// 1 = 流式推理改用按部署模型各层形状特化的内核（模板在编译期完全展开，Cortex-M4 上用 SMLAD 双乘加），
+// 结果与通用内核逐位一致；需要 INFERENCE_STREAMING。基准测试会同时计时完整图与特化内核
+#ifndef MODEL_SPECIALIZED_KERNELS
+#define MODEL_SPECIALIZED_KERNELS 0
+#endif
+
+#if MODEL_SPECIALIZED_KERNELS && !INFERENCE_STREAMING
+#error "MODEL_SPECIALIZED_KERNELS requires INFERENCE_STREAMING (the kernels reuse its layer parameters and column cache)"
+#endif
+
+// 1 = 编译模型的常量张量（卷积 / 全连接权重、偏置）放进 .data，由启动代码从 flash 复制到 RAM，
+// 推理时读权重不再经过 flash 缓存与等待周期。需同时全局定义 -DEI_MODEL_SECTION=.data.ei_model
+// （编译模型的翻译单元据此给每个常量张量加 section 属性），见 nano33ble_ram 环境
+#ifndef MODEL_WEIGHTS_IN_RAM
+#define MODEL_WEIGHTS_IN_RAM 0
+#endif
+
+#if MODEL_WEIGHTS_IN_RAM && !defined(EI_MODEL_SECTION)
+#error "MODEL_WEIGHTS_IN_RAM requires a global -DEI_MODEL_SECTION=.data.ei_model (the compiled model places its weights there)"
+#endif
+
+// 1 = 流式 / 特化内核（每次推理的热点循环）放进 .data_model_ramfunc 在 RAM 中执行；
+// 编译图本身的 CMSIS-NN 内核属于 SDK 库，仍在 flash 中
+#ifndef MODEL_HOT_CODE_IN_RAM
+#define MODEL_HOT_CODE_IN_RAM 0
+#endif
+
+#if MODEL_HOT_CODE_IN_RAM && !INFERENCE_STREAMING
+#error "MODEL_HOT_CODE_IN_RAM requires INFERENCE_STREAMING (only the streaming kernels are placed in RAM)"
+#endif
+
+// 1 = 新颖性检测：流式推理缓存的倒数第二层激活离所有 K-means 聚类中心（include/novelty_model.h，
+// 用 pc_controller/novelty_trainer.py 训练）都太远时，拒绝本次手势结果（按 uncertain 处理）
+#ifndef INFERENCE_NOVELTY_DETECTION
+#define INFERENCE_NOVELTY_DETECTION 0
+#endif
+
+#if INFERENCE_NOVELTY_DETECTION && !INFERENCE_STREAMING
+#error "INFERENCE_NOVELTY_DETECTION requires INFERENCE_STREAMING (it reads the cached penultimate activations)"
+#endif
+
+// 1 = 设备端自定义手势（fewshot_module.h）：主机经 BLE 让设备录入几次新手势，推理线程把这些窗口的倒数第二层
+// 激活平均成 int8 类别中心存入 flash；之后每次 CNN 推理旁路做一次最近中心搜索，落在某个中心半径内的窗口
+// 报告为该自定义手势（内置结果按 uncertain 处理）。新增手势不需要重新训练或烧录
+#ifndef INFERENCE_FEWSHOT
+#define INFERENCE_FEWSHOT 0
+#endif
+// 自定义手势的类别数上限（每个类别在 flash 记录中占 FEWSHOT_COLUMNS x FEWSHOT_CHANNELS 字节的中心）
+#ifndef FEWSHOT_MAX_CLASSES
+#define FEWSHOT_MAX_CLASSES 4
+#endif
+// 倒数第二层激活的形状（列数 x 每列通道数，即全连接层的输入），初始化时与模型核对
+#ifndef FEWSHOT_COLUMNS
+#define FEWSHOT_COLUMNS 36
+#endif
+#ifndef FEWSHOT_CHANNELS
+#define FEWSHOT_CHANNELS 10
+#endif
+// 一次录入（一遍手势）收集窗口的时长：录入命令之后这段时间内 CNN 没有判为 idle 的窗口都计入该类别
+#ifndef FEWSHOT_CAPTURE_MS
+#define FEWSHOT_CAPTURE_MS 2000
+#endif
+// 提交一个类别至少需要的窗口数（各次录入合计）
+#ifndef FEWSHOT_MIN_WINDOWS
+#define FEWSHOT_MIN_WINDOWS 4
+#endif
+// 类别半径 = 录入窗口到中心的平均平方距离 x 该系数；越大越容易匹配（也越容易抢走内置手势）
+#ifndef FEWSHOT_RADIUS_SCALE
+#define FEWSHOT_RADIUS_SCALE 2.0f
+#endif
+// 自定义手势记录所在 Flash 页的地址；0 = 使用模型槽 0 之前的一页
+#ifndef FEWSHOT_FLASH_ADDR
+#define FEWSHOT_FLASH_ADDR 0
+#endif
+
+#if INFERENCE_FEWSHOT && !INFERENCE_STREAMING
+#error "INFERENCE_FEWSHOT requires INFERENCE_STREAMING (it reads the cached penultimate activations)"
+#endif
+
+#if INFERENCE_FEWSHOT && INFERENCE_HOST_REPLAY
+#error "INFERENCE_FEWSHOT requires the device build (class centroids are kept in flash)"
+#endif
+
+#if INFERENCE_FEWSHOT && ((FEWSHOT_COLUMNS * FEWSHOT_CHANNELS) % 8 != 0 || FEWSHOT_MAX_CLASSES < 1 || FEWSHOT_MAX_CLASSES > 8)
+#error "FEWSHOT_COLUMNS x FEWSHOT_CHANNELS must be a multiple of 8 and FEWSHOT_MAX_CLASSES between 1 and 8"
+#endif
+
+// 1 = 提前退出：流式推理在第一层池化之后先运行一个小分类头（include/early_exit_model.h，用
+// pc_controller/early_exit_trainer.py 蒸馏训练），其获胜类别允许退出且概率达到阈值时跳过第二层卷积与全连接层；
+// 未退出时第二层卷积按需补算，结果与不启用时一致
+#ifndef MODEL_EARLY_EXIT
+#define MODEL_EARLY_EXIT 0
+#endif
+
+#if MODEL_EARLY_EXIT && !INFERENCE_STREAMING
+#error "MODEL_EARLY_EXIT requires INFERENCE_STREAMING (the head reads the cached pooled activations)"
+#endif
+
+// 覆盖训练得到的提前退出概率阈值；0 = 使用 early_exit_model.h 中的阈值，大于 1 = 只运行分类头、从不退出
+// （early_exit_trainer.py 收集训练数据时用，统计中仍可看到分类头本身的耗时）
+#ifndef MODEL_EARLY_EXIT_THRESHOLD
+#define MODEL_EARLY_EXIT_THRESHOLD 0.0f
+#endif
+
+// 1 = 块稀疏全连接层：流式推理初始化时按列（每类别每列 STREAM_CONV2_CH 个权重为一块）找出全零的权重块，
+// 全连接层只累加非零块，结果与稠密计算逐位一致。权重用 pc_controller/sparse_fc_export.py 按块剪枝并微调后
+// 导出（重新编译或经 OTA 下发），未剪枝的模型没有全零块，只多一次位图遍历；需要 INFERENCE_STREAMING
+#ifndef MODEL_SPARSE_FC
+#define MODEL_SPARSE_FC 0
+#endif
+
+#if MODEL_SPARSE_FC && !INFERENCE_STREAMING
+#error "MODEL_SPARSE_FC requires INFERENCE_STREAMING (the sparse kernel replaces the streaming fully connected layer)"
+#endif
+
+// 1 = 特化内核直接读取 4 位打包权重（kTfLiteInt4，每字节两个权重，低半字节在前）：第二层卷积与全连接层的
+// 权重由 pc_controller/int4_export.py 重新量化到 [-7, 7] 并打包，flash 占用减半；内层循环现场拆出半字节
+// （DSP 扩展下用 SXTB16 一次符号扩展两个），结果与 TFLite 对同一 int4 模型的计算逐位一致。未开启时
+// int4 模型仍可运行：流式推理初始化失败，回退到完整图，由 TFLM 内核把权重解包到临时缓冲区；需要
+// MODEL_SPECIALIZED_KERNELS
+#ifndef MODEL_INT4_WEIGHTS
+#define MODEL_INT4_WEIGHTS 0
+#endif
+
+#if MODEL_INT4_WEIGHTS && !MODEL_SPECIALIZED_KERNELS
+#error "MODEL_INT4_WEIGHTS requires MODEL_SPECIALIZED_KERNELS (only the specialized kernels unpack 4-bit weights)"
+#endif
+
+// 1 = 流式推理的内核在启动时实测选择：第一层卷积 + 池化、第二层卷积、全连接层各自在通用内核、特化内核与
+// CMSIS-NN（只有后两层，需要 EI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN）中选最快的一个，输出与特化内核逐位一致
+// 才参与比较。结果连同固件与模型的签名存进 Flash（KERNEL_FLASH_ADDR），之后的启动直接按记录填函数指针表，
+// 固件或权重变化后重新测量。需要 MODEL_SPECIALIZED_KERNELS（作为基准与缺省选择）
+#ifndef MODEL_KERNEL_AUTOTUNE
+#define MODEL_KERNEL_AUTOTUNE 0
+#endif
+
+#if MODEL_KERNEL_AUTOTUNE && !MODEL_SPECIALIZED_KERNELS
+#error "MODEL_KERNEL_AUTOTUNE requires MODEL_SPECIALIZED_KERNELS (the specialized kernels are the reference variant)"
+#endif
+
+// 每个变体的计时：MODEL_KERNEL_AUTOTUNE_ROUNDS 轮取最短，每轮按完整窗口连续运行 MODEL_KERNEL_AUTOTUNE_REPS 次
+#ifndef MODEL_KERNEL_AUTOTUNE_ROUNDS
+#define MODEL_KERNEL_AUTOTUNE_ROUNDS 3
+#endif
+#ifndef MODEL_KERNEL_AUTOTUNE_REPS
+#define MODEL_KERNEL_AUTOTUNE_REPS 20
+#endif
+// 内核选择记录页；0 = 主动学习采集区之前的一页（不随功能开关移动）
+#ifndef KERNEL_FLASH_ADDR
+#define KERNEL_FLASH_ADDR 0
+#endif
+
+// 1 = 解释器后备路径（interp_module.h）：模型槽中的权重包可以携带完整的 .tflite flatbuffer（model_blob.h 的
+// 格式 2），设备用 TFLM 的 MicroInterpreter 直接在 flash 中运行它，层数、通道数与算子参数都可以随 OTA 改变，
+// 只有输入窗口长度与类别数须与固件一致；内置模型与格式 1 的权重包仍由编译图运行。解释器与编译图共用同一块张量
+// arena（两者从不同时初始化），arena 须放大到能装下解释器的分配（-DEI_TENSOR_ARENA_SIZE），模型槽须放得下
+// flatbuffer（MODEL_SLOT_BYTES），见 nano33ble_interpreter 环境。运行 flatbuffer 时流式推理、特化内核与
+// 提前退出按编译图的层参数实现，不可用，每次推理回退到完整的图
+#ifndef MODEL_INTERPRETER_ENABLE
+#define MODEL_INTERPRETER_ENABLE 0
+#endif
+
+#if MODEL_INTERPRETER_ENABLE && !(INFERENCE_INT8_WINDOW && MODEL_OTA_ENABLE)
+#error "MODEL_INTERPRETER_ENABLE requires INFERENCE_INT8_WINDOW and MODEL_OTA_ENABLE (flatbuffers arrive through the model slots and run_classifier only knows the compiled graph)"
+#endif
+
+// 1 = int8 域后处理：argmax 与置信度阈值直接比较量化分数，只反量化获胜类别，串口只打印获胜类别
+// （需要 INFERENCE_INT8_WINDOW）；0 = 反量化全部类别后在浮点域处理
+#ifndef INFERENCE_POSTPROCESS_INT8
+#define INFERENCE_POSTPROCESS_INT8 INFERENCE_INT8_WINDOW
+#endif
+
+#if INFERENCE_POSTPROCESS_INT8 && !INFERENCE_INT8_WINDOW
+#error "INFERENCE_POSTPROCESS_INT8 requires INFERENCE_INT8_WINDOW (the float path gets dequantized scores from run_classifier)"
+#endif
+#if CAPTURE_ENABLE && !INFERENCE_INT8_WINDOW
+#error "CAPTURE_ENABLE requires INFERENCE_INT8_WINDOW (captured windows are the quantized model input)"
+#endif
+
+// 1 = 跳过 softmax：编译图停在全连接层（softmax 不做 init / prepare，也不占 arena），流式推理同样不算 softmax。
+// logits 的 argmax 就是概率的 argmax，只有获胜类别的概率经两张 16 项的 exp 查找表算出
+// （exp(-Δ x logit scale / 温度) 之和的倒数）；分数流等需要全部类别概率时才按同一张表逐类计算。
+// 需要 INFERENCE_POSTPROCESS_INT8；提前退出与解释器的输出本来就是概率，照常处理
+#ifndef MODEL_SKIP_SOFTMAX
+#define MODEL_SKIP_SOFTMAX 0
+#endif
+
+// 跳过 softmax 时的温度缩放：概率按 softmax(logits / 温度) 计算，大于 1 使置信度更保守（按验证集标定）；
+// 1 = 与 softmax 算子一致
+#ifndef MODEL_SOFTMAX_TEMPERATURE
+#define MODEL_SOFTMAX_TEMPERATURE 1.0f
+#endif
+
+#if MODEL_SKIP_SOFTMAX && !INFERENCE_POSTPROCESS_INT8
+#error "MODEL_SKIP_SOFTMAX requires INFERENCE_POSTPROCESS_INT8 (the winner's probability is computed from the int8 logits)"
+#endif
+
+// 1 = TCN 推理引擎（tcn_module.h）：用因果膨胀一维卷积网络（include/tcn_model.h，pc_controller/tcn_export.py 从训练
+// 好的权重生成）代替 CNN，各层保存自己的历史帧，每次推理只把上次以来新进入窗口的帧逐帧送入网络，每帧的计算量固定、
+// 与感受野长短无关；模型未训练或与窗口的通道数 / 量化不符时保留 CNN。需要 INFERENCE_INT8_WINDOW（帧直接取自
+// 量化窗口），且按浮点分数做后处理（INFERENCE_POSTPROCESS_INT8 = 0）、不与读取 CNN 激活的新颖性检测同时使用
+#ifndef INFERENCE_TCN_ENGINE
+#define INFERENCE_TCN_ENGINE 0
+#endif
+
+#if INFERENCE_TCN_ENGINE && \
+    !(INFERENCE_INT8_WINDOW && !INFERENCE_POSTPROCESS_INT8 && !INFERENCE_NOVELTY_DETECTION && !INFERENCE_FEWSHOT)
+#error "INFERENCE_TCN_ENGINE requires INFERENCE_INT8_WINDOW with INFERENCE_POSTPROCESS_INT8 = 0, INFERENCE_NOVELTY_DETECTION = 0 and INFERENCE_FEWSHOT = 0 (frames come from the quantized window, scores are float, novelty and custom gestures read CNN activations)"
+#endif
+
+// 最低置信度：获胜类别的概率低于该值时不输出类别（结果为 unknown）；0 = 不过滤
+#ifndef INFERENCE_MIN_CONFIDENCE
+#define INFERENCE_MIN_CONFIDENCE 0.0f
+#endif
+
+// 1 = 投票平滑（ei_classifier_smooth 的判定，静态分配、O(1) 更新，见 include/vote_smoother.h）：
+// 最近 INFERENCE_VOTE_READINGS 次结果中至少 INFERENCE_VOTE_MIN_SAME 票的类别代替本次 argmax，
+// 置信度低于 INFERENCE_VOTE_CONFIDENCE 的结果计为 uncertain；发布的置信度为该类别的得票比例
+#ifndef INFERENCE_VOTE_SMOOTHING
+#define INFERENCE_VOTE_SMOOTHING 0
+#endif
+#ifndef INFERENCE_VOTE_READINGS
+#define INFERENCE_VOTE_READINGS 6
+#endif
+#ifndef INFERENCE_VOTE_MIN_SAME
+#define INFERENCE_VOTE_MIN_SAME 4
+#endif
+#ifndef INFERENCE_VOTE_CONFIDENCE
+#define INFERENCE_VOTE_CONFIDENCE 0.8f
+#endif
+
+// 结果发布方式（BLE / LED 靠结果序列号判断新结果）：
+//   INFERENCE_EVENTS_RAW       每个窗口的 argmax 变化超过 0.01 即发布
+//   INFERENCE_EVENTS_PERFCAL   PerfCal 事件检测（见 include/gesture_detector.h），只在检出事件时发布
+//   INFERENCE_EVENTS_SEGMENTS  手势分段状态机（见 include/gesture_segmenter.h），每个物理手势在确认时发布一次，
+//                              结束时另行记录带起止时间和峰值置信度的手势事件
+#define INFERENCE_EVENTS_RAW 0
+#define INFERENCE_EVENTS_PERFCAL 1
+#define INFERENCE_EVENTS_SEGMENTS 2
+#ifndef INFERENCE_EVENT_MODE
+#define INFERENCE_EVENT_MODE INFERENCE_EVENTS_SEGMENTS
+#endif
+
+// PerfCal 平均窗口（ms）：按细步长折算为结果个数，48 Hz、2 样本步长时 125 ms = 3 次结果
+#ifndef INFERENCE_EVENT_AVERAGE_MS
+#define INFERENCE_EVENT_AVERAGE_MS 125
+#endif
+
+// 平均分的检测阈值（须高于 1 / 类别数）
+#ifndef INFERENCE_EVENT_THRESHOLD
+#define INFERENCE_EVENT_THRESHOLD 0.7f
+#endif
+
+// 手势事件之后的抑制时间（ms）：默认一个完整窗口（24 样本 = 500 ms），同一个手势只上报一次
+#ifndef INFERENCE_EVENT_SUPPRESSION_MS
+#define INFERENCE_EVENT_SUPPRESSION_MS 500
+#endif
+
+// 手势分段：开始候选 / 确认所需的置信度，与已确认手势保持所需的置信度（滞回）
+#ifndef INFERENCE_SEGMENT_ONSET_CONFIDENCE
+#define INFERENCE_SEGMENT_ONSET_CONFIDENCE 0.7f
+#endif
+#ifndef INFERENCE_SEGMENT_RELEASE_CONFIDENCE
+#define INFERENCE_SEGMENT_RELEASE_CONFIDENCE 0.5f
+#endif
+
+// 确认一个手势需要的连续结果数，结束一个手势需要的连续丢失结果数（细步长下每次结果约 42 ms）
+#ifndef INFERENCE_SEGMENT_CONFIRM_RESULTS
+#define INFERENCE_SEGMENT_CONFIRM_RESULTS 2
+#endif
+#ifndef INFERENCE_SEGMENT_RELEASE_RESULTS
+#define INFERENCE_SEGMENT_RELEASE_RESULTS 2
+#endif
+
+// 手势结束后的不应期与单个手势的最长时长（ms）
+#ifndef INFERENCE_SEGMENT_REFRACTORY_MS
+#define INFERENCE_SEGMENT_REFRACTORY_MS 250
+#endif
+#ifndef INFERENCE_SEGMENT_MAX_MS
+#define INFERENCE_SEGMENT_MAX_MS 2000
+#endif
+
+// 额外注册的 impulse（与默认模型同一次部署导出，输入采样率、轴和窗口长度须相同），格式为
+// ", {&impulse_handle_X, &tflite_learn_Y_arena_usage}"（arena 函数未知时写 nullptr）；
+// 需要浮点窗口路径（INFERENCE_INT8_WINDOW = 0），运行时通过串口 "model <n>" 切换
+#ifndef INFERENCE_EXTRA_IMPULSES
+#define INFERENCE_EXTRA_IMPULSES
+#endif
+
+// 1 = 每一步把窗口交给所有已注册的模型：窗口只读取一次，相同的 DSP 块只计算一次（run_classifier_shared），
+// 各模型的学习块读取同一份特征；当前模型的结果驱动手势管线，其余模型的最新结果见串口 "model"。
+// 每步按整窗计算 DSP，不使用连续分类器的滚动特征；0 = 只运行当前模型
+#ifndef INFERENCE_SHARED_IMPULSES
+#define INFERENCE_SHARED_IMPULSES 0
+#endif
+
+#if INFERENCE_SHARED_IMPULSES && INFERENCE_INT8_WINDOW
+#error "INFERENCE_SHARED_IMPULSES requires INFERENCE_INT8_WINDOW = 0 (the shared DSP reads the float window)"
+#endif
+
+// 影子模式（候选模型的 A/B 评估）：INFERENCE_EXTRA_IMPULSES 中注册的候选模型序号，0 = 关闭。
+// 候选模型在生产模型运行过 CNN 的窗口上每 INFERENCE_SHADOW_EVERY 个运行一次，只在推理线程追上样本之后，
+// 下一步到期时在检查点让路（同长窗口），不影响用户看到的结果与生产模型的延迟；idle 预筛跳过的窗口不运行
+// （上线后预筛同样挡在候选模型之前）。判定的一致性与两者的置信度直方图每 INFERENCE_SHADOW_REPORT_RUNS 次
+// 写入诊断日志（pc_controller/telemetry_dump.py 汇总），自启动的累计见串口 "model"
+#ifndef INFERENCE_SHADOW_MODEL
+#define INFERENCE_SHADOW_MODEL 0
+#endif
+#ifndef INFERENCE_SHADOW_EVERY
+#define INFERENCE_SHADOW_EVERY 4
+#endif
+#ifndef INFERENCE_SHADOW_REPORT_RUNS
+#define INFERENCE_SHADOW_REPORT_RUNS 500
+#endif
+#if INFERENCE_SHADOW_MODEL && INFERENCE_INT8_WINDOW
+#error "INFERENCE_SHADOW_MODEL requires INFERENCE_INT8_WINDOW = 0 (the candidate reads the float window)"
+#endif
+#if INFERENCE_SHADOW_MODEL && INFERENCE_SHARED_IMPULSES
+#error "INFERENCE_SHADOW_MODEL and INFERENCE_SHARED_IMPULSES are exclusive (shared impulses run every model each step)"
+#endif
+#if INFERENCE_SHADOW_REPORT_RUNS > 65535
+#error "INFERENCE_SHADOW_REPORT_RUNS must fit the uint16 counters of the telemetry record"
+#endif
+
+// 1 = 截止时间调度：推理落后时（样本队列里已有下一步的数据）跳过过时的窗口，总是分类最新的完整窗口；
+// 0 = 依次分类每个到期的窗口
+#ifndef INFERENCE_DROP_STALE_WINDOWS
+#define INFERENCE_DROP_STALE_WINDOWS 1
+#endif
+
+// 1 = 协作式取消：推理运行中样本队列里已攒够下一步时，在 SDK 的 DSP 之后与编译模型相邻两个节点之间的检查点
+// 放弃这次推理，立即分类更新的窗口；长窗口（INFERENCE_MULTIRES）在原窗口到期时同样让路。
+// 流式推理只算新的时间列、不经过节点检查点，主要作用于浮点 SDK 路径与完整推理的回退
+#ifndef INFERENCE_CANCEL_STALE
+#define INFERENCE_CANCEL_STALE INFERENCE_DROP_STALE_WINDOWS
+#endif
+
+// 原窗口连续被取消这么多次后，下一次推理不再可取消（推理持续慢于步长时仍然有结果）
+#ifndef INFERENCE_CANCEL_MAX_STREAK
+#define INFERENCE_CANCEL_MAX_STREAK 2
+#endif
+
+// 推理线程等待共享状态锁（读者持有）的时间上限（微秒）：超过时周期报告给出警告，优先级反转压力测试
+// （test/test_priority_inversion）以此判定通过与否。读者的临界区只是复制几个字段，优先级继承下应远低于此
+#ifndef INFERENCE_LOCK_WAIT_BUDGET_US
+#define INFERENCE_LOCK_WAIT_BUDGET_US 1000
+#endif
+
+// 1 = 按射频时序放置推理（radio_module，只在 nRF52 上可用）：链路层在每个连接事件前后的中断会拉长跨过事件的推理，
+// 推理线程在 invoke 前预测下一个连接事件，放不下时推迟到事件结束后 INFERENCE_RADIO_GUARD_US 再开始（最多推迟
+// INFERENCE_RADIO_MAX_DEFER_US；推理比任何空隙都长时照常运行）。以平均吞吐换取推理耗时的确定性
+#ifndef INFERENCE_RADIO_AWARE
+#define INFERENCE_RADIO_AWARE 0
+#endif
+// 预测的余量：锚点抖动、窗口加宽与中断延迟
+#ifndef INFERENCE_RADIO_GUARD_US
+#define INFERENCE_RADIO_GUARD_US 500
+#endif
+#ifndef INFERENCE_RADIO_MAX_DEFER_US
+#define INFERENCE_RADIO_MAX_DEFER_US 10000
+#endif
+// 每这么多次推理有一次不放置、原地运行，作为对照：周期报告比较两组推理耗时的 p99（0 = 不留对照）
+#ifndef INFERENCE_RADIO_CONTROL_EVERY
+#define INFERENCE_RADIO_CONTROL_EVERY 8
+#endif
+#if INFERENCE_RADIO_AWARE && !PLATFORM_NRF52
+#error "INFERENCE_RADIO_AWARE needs the nRF52 radio driven by the Cordio link layer"
+#endif
+
+// 1 = 自适应步长：预测稳定为 idle 时按粗步长推理，出现变化立即回到细步长；0 = 固定细步长
+#ifndef INFERENCE_ADAPTIVE_STRIDE
+#define INFERENCE_ADAPTIVE_STRIDE 1
+#endif
+
+// 细 / 粗步长（样本数，须为 2 的倍数）
+#ifndef INFERENCE_STRIDE_FINE_SAMPLES
+#define INFERENCE_STRIDE_FINE_SAMPLES 2
+#endif
+#ifndef INFERENCE_STRIDE_COARSE_SAMPLES
+#define INFERENCE_STRIDE_COARSE_SAMPLES 12
+#endif
+
+// 连续多少次置信度不低于 INFERENCE_STRIDE_IDLE_CONFIDENCE 的 idle 结果后切换到粗步长
+#ifndef INFERENCE_STRIDE_STABLE_COUNT
+#define INFERENCE_STRIDE_STABLE_COUNT 3
+#endif
+#ifndef INFERENCE_STRIDE_IDLE_CONFIDENCE
+#define INFERENCE_STRIDE_IDLE_CONFIDENCE 0.90f
+#endif
+
+// 运动能量阈值（相邻样本差的平方和，单位 g^2）；约等于每个样本 0.03 g 的变化
+#ifndef INFERENCE_STRIDE_ENERGY_THRESHOLD
+#define INFERENCE_STRIDE_ENERGY_THRESHOLD 0.001f
+#endif
+
+// 启动时对编译后的完整图连续推理的次数，打印耗时用于内核 A/B 对比；0 = 不测试
+#ifndef MODEL_BENCHMARK_ITERATIONS
+#define MODEL_BENCHMARK_ITERATIONS 0
+#endif
+
+// 串口命令 "prof" 触发逐算子性能剖析时的推理次数；剖析本身需以 -DEI_CLASSIFIER_EON_PROFILER=1
+// 全局编译（它同时改变编译模型的翻译单元，不能只在这里定义），见 nano33ble_profile 环境
+#ifndef MODEL_PROFILE_ITERATIONS
+#define MODEL_PROFILE_ITERATIONS 100
+#endif
+
+// 推理基准（串口 "bench [n]" / "bench live [n]"，BLE 19B10029 或 USB 帧 0x29 触发）：每轮最多记录的推理次数
+// （每次推理每级 4 字节的静态缓冲）与未指定次数时的默认值
+#ifndef INFERENCE_BENCHMARK_MAX_RUNS
+#define INFERENCE_BENCHMARK_MAX_RUNS 200
+#endif
+#ifndef INFERENCE_BENCHMARK_DEFAULT_RUNS
+#define INFERENCE_BENCHMARK_DEFAULT_RUNS 100
+#endif
+
+// 区段剖析（include/profiler_module.h）：DWT CYCCNT 计时的命名区段写入静态环形缓冲，串口 "zones" 导出，
+// pc_controller/zone_timeline.py 画成时间线；0 = 区段调用编译为空。容量为最近的区段数（2 的幂，每条 12 字节）
+#ifndef PROFILER_ZONES_ENABLE
+#define PROFILER_ZONES_ENABLE 0
+#endif
+#ifndef PROFILER_ZONE_CAPACITY
+#define PROFILER_ZONE_CAPACITY 512
+#endif
+
+// 1 = 追踪流特征值（19B10030 / USB 帧 0x30）：上位机订阅期间，BLE 线程把区段环形缓冲中新写入的记录
+// 以二进制打包持续发送，pc_controller/trace_capture.py 借助时钟同步与主机侧区段合并成 Perfetto 追踪
+#ifndef BLE_TRACE_STREAM_ENABLE
+#define BLE_TRACE_STREAM_ENABLE 0
+#endif
+#if BLE_TRACE_STREAM_ENABLE && !PROFILER_ZONES_ENABLE
+#error "BLE_TRACE_STREAM_ENABLE requires PROFILER_ZONES_ENABLE (the trace is read from the zone ring)"
+#endif
+
+// 1 = 分配检查（include/heap_guard_module.h）：BLE 发布路径上出现 malloc / calloc / realloc 即断言失败；
+// 需要链接器包装这三个函数，只用 nano33ble_alloc_check 环境构建（它同时加上 -Wl,--wrap）
+#ifndef HEAP_GUARD_ENABLE
+#define HEAP_GUARD_ENABLE 0
+#endif
+#if HEAP_GUARD_ENABLE && (PLATFORM_ESP32 || INFERENCE_HOST_REPLAY)
+#error "HEAP_GUARD_ENABLE wraps the Mbed OS allocator and is only available on the Mbed OS builds"
+#endif
+
+// 统计注册表（include/stats_module.h）的容量：串口 "stats"、诊断命令 STAT_READ 与统计特征值（19B10034 / USB 帧 0x34）
+// 导出的统计量数上限（每项 12 字节）
+#ifndef STATS_REGISTRY_CAPACITY
+#define STATS_REGISTRY_CAPACITY 64
+#endif
+#if STATS_REGISTRY_CAPACITY > 255
+#error "STATS_REGISTRY_CAPACITY must fit the uint8 index of wire_stat_t"
+#endif
+
+// 1 = 级联 idle 预筛：窗口内各轴标准差都低于阈值时直接判为 idle，不运行 CNN
+#ifndef INFERENCE_IDLE_PREFILTER
+#define INFERENCE_IDLE_PREFILTER 1
+#endif
+
+// 预筛的各轴标准差上限（g）；用 pc_controller/idle_prefilter_tuner.py 在录制的数据集上标定
+#ifndef INFERENCE_IDLE_PREFILTER_MAX_STD_G
+#define INFERENCE_IDLE_PREFILTER_MAX_STD_G 0.02f
+#endif
+
+// 1 = 手势起始的临时判定：每次推理前用前缀分类头（onset_head.h；onset_model.h 由 pc_controller/onset_trainer.py
+// 在截短的窗口上训练）只看窗口最新的一段，手势刚开始就发出临时判定（BLE 19B10033），完整窗口判定同一手势时确认、
+// 判定为其他手势或超时则撤销。主机可对临时判定先做延迟敏感的动作，撤销时回退
+#ifndef INFERENCE_ONSET_HEAD
+#define INFERENCE_ONSET_HEAD 0
+#endif
+#if INFERENCE_ONSET_HEAD && INFERENCE_WINDOW_NORMALIZE
+#error "INFERENCE_ONSET_HEAD needs the window in physical units (INFERENCE_WINDOW_NORMALIZE removes the amplitude)"
+#endif
+
+// 1 = 结果记忆：新进入窗口的值与被挤出的值（上次分类时的窗口）平均绝对差不超过容差时沿用上次的结果、不运行 CNN，
+// 覆盖不足以触发 any-motion 的微小晃动；距离随每步增量更新，串口定期打印命中率
+#ifndef INFERENCE_RESULT_MEMO
+#define INFERENCE_RESULT_MEMO 1
+#endif
+
+// 结果记忆的容差（g，int8 窗口按输入量化步长换算）与连续沿用的最多次数
+#ifndef INFERENCE_MEMO_TOLERANCE_G
+#define INFERENCE_MEMO_TOLERANCE_G 0.01f
+#endif
+#ifndef INFERENCE_MEMO_MAX_REUSE
+#define INFERENCE_MEMO_MAX_REUSE 8
+#endif
+
+// 1 = 多分辨率：每步的两帧平均后另存一个 2 倍抽取的长窗口（同样长度，覆盖两倍时长，不额外采样），
+// 同一模型隔一次推理在长窗口上运行一次，只在推理线程已追上样本时执行（不推迟原窗口的推理）；
+// 之后两次原窗口的结果与它融合（非 idle 取较大概率），超出原窗口时长的慢手势也能识别。
+// int8 窗口下需同时设 INFERENCE_POSTPROCESS_INT8=0（融合需要各类别概率）
+#ifndef INFERENCE_MULTIRES
+#define INFERENCE_MULTIRES 0
+#endif
+
+#if INFERENCE_MULTIRES && INFERENCE_POSTPROCESS_INT8
+#error "INFERENCE_MULTIRES fuses per-class scores; INFERENCE_POSTPROCESS_INT8 only produces the winning class"
+#endif
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef BATTERY_MODULE_H
+#define BATTERY_MODULE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 电量分级（BATTERY_LADDER_ENABLE）
+// 主循环每 BATTERY_POLL_MS 用 SAADC 测一次电池电压，按 BATTERY_*_MV 阈值（带滞回）选择推理的工作点
+// （inference_set_power_point）：电量下降时依次改用粗步长、只在运动时推理、双击唤醒后才推理，
+// 而不是一直满速运行到掉电。当前工作点与电压经 BLE / USB 发布，上位机据此解释延迟的变化。
+
+struct battery_state_t {
+    uint16_t millivolts;  // 最近一次测量的电池电压（0 = 尚未测量）
+    uint8_t point;        // 生效的工作点（inference_power_point_t，含主机请求的更省电工作点）
+};
+
+/**
+ * @brief 配置 ADC 并立即测量一次、选择工作点（在 inference_module_init 之后调用）
+ */
+void battery_module_init();
+
+/**
+ * @brief 到期时测量电池电压并更新工作点（主循环中调用）
+ */
+void battery_module_poll();
+
+/**
+ * @brief 读取当前状态（任意线程）
+ * @return uint32_t 状态版本号，每次测量加一；读者据此判断是否需要重新发布
+ */
+uint32_t battery_module_get(battery_state_t* out_state);
+
+#endif
@@ -1,7 +1,22 @@
 #pragma once
 
+#include <stdint.h>
+
+/**
+ * @brief Delivery counters of the BLE thread since boot, notified on the
+ *        counters characteristic and printed by the serial "ble" command.
+ */
+struct ble_counters_t {
+    uint32_t published;        // results sent (events on a session, manufacturer data while broadcasting)
+    uint32_t suppressed;       // results below ble_min_confidence, not sent
+    uint32_t notify_failures;  // notifications the stack refused while the host was subscribed
+    uint32_t connected_s;      // time in BLE / USB sessions, the current one included
+    uint32_t sessions;
+};
+
 /**
  * @brief Initialize the BLE peripheral (services + characteristics).
+ *        May be called again after a failure (the supervisor retries it with backoff).
  * @return true on success, false otherwise.
  */
 bool ble_module_init();
@@ -9,5 +24,25 @@ bool ble_module_init();
 /**
  * @brief Continuous BLE task that keeps the stack responsive and pushes
  *        inference results to the connected central device.
+ *        Brings the radio up itself (started early, in parallel with IMU / model init) and
+ *        keeps retrying with backoff if that fails, then waits for setup to finish.
  */
 void ble_task();
+
+/**
+ * @brief Copy of the counters; safe to call from any thread (the fields may be one update apart).
+ */
+void ble_module_get_counters(ble_counters_t* out_counters);
+
+/**
+ * @brief Wake the BLE task's wait at once (host data arrived on the USB link or
+ *        the BLE stack queued an HCI event); it also wakes on published results.
+ */
+void ble_module_wake();
+
+/**
+ * @brief HCI watch thread (BLE_EVENT_DRIVEN): blocks until the Cordio stack
+ *        queues an HCI event or ACL packet and wakes the BLE task, so that it
+ *        does not have to poll. Returns at once when BLE_EVENT_DRIVEN is off.
+ */
+void ble_hci_watch_task();
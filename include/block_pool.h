@@ -0,0 +1,75 @@
+#ifndef BLOCK_POOL_H
+#define BLOCK_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief 定长块内存池（静态存储，空闲块串成单链表，分配 / 释放都是 O(1)）
+ * 所有块大小相同，释放后原样回到链表，长时间运行也不会产生碎片。不加锁，由调用者串行化。
+ * @tparam BlockBytes 块大小（字节，8 的倍数，保证与 malloc 相同的 8 字节对齐）
+ * @tparam BlockCount 块个数
+ */
+template <size_t BlockBytes, size_t BlockCount>
+class BlockPool {
+    static_assert(BlockBytes >= sizeof(void*) && BlockBytes % 8 == 0, "BlockPool block size must be a multiple of 8");
+    static_assert(BlockCount > 0, "BlockPool needs at least one block");
+
+public:
+    static const size_t kBlockBytes = BlockBytes;
+    static const size_t kBlockCount = BlockCount;
+
+    BlockPool() : free_(nullptr), in_use_(0), peak_(0) {
+        for (size_t i = BlockCount; i > 0; i--) {
+            Block* block = reinterpret_cast<Block*>(storage_ + (i - 1) * BlockBytes);
+            block->next = free_;
+            free_ = block;
+        }
+    }
+
+    /**
+     * @return void* 一个块，池已用尽时为 nullptr
+     */
+    void* allocate() {
+        Block* block = free_;
+        if (block == nullptr) {
+            return nullptr;
+        }
+        free_ = block->next;
+        in_use_++;
+        if (in_use_ > peak_) {
+            peak_ = in_use_;
+        }
+        return block;
+    }
+
+    /**
+     * @brief 归还一个块（必须是本池分配的，见 owns）
+     */
+    void release(void* ptr) {
+        Block* block = static_cast<Block*>(ptr);
+        block->next = free_;
+        free_ = block;
+        in_use_--;
+    }
+
+    bool owns(const void* ptr) const {
+        const uint8_t* p = static_cast<const uint8_t*>(ptr);
+        return p >= storage_ && p < storage_ + sizeof(storage_) && (size_t)(p - storage_) % BlockBytes == 0;
+    }
+
+    size_t in_use() const { return in_use_; }
+    size_t peak() const { return peak_; }
+
+private:
+    struct Block {
+        Block* next;
+    };
+
+    alignas(8) uint8_t storage_[BlockBytes * BlockCount];
+    Block* free_;
+    size_t in_use_;
+    size_t peak_;
+};
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef BOOT_MODULE_H
+#define BOOT_MODULE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 启动过程的里程碑：各阶段第一次到达时记录自复位以来的时间，第一个分类结果出来时打印一行
+// [Boot] 汇总（启动到第一个结果的时间）。里程碑同时用作线程之间的就绪条件：
+// BLE 线程在 setup 仍在初始化 IMU / 模型时就开始启动协议栈，读取运行时配置前等待 BOOT_SETUP_DONE；
+// 推理线程同样等待 BOOT_SETUP_DONE 后直接开始填充窗口，不再固定休眠。
+
+enum boot_milestone_t {
+    BOOT_IMU_READY = 0,  // IMU 配置完成，FIFO 开始缓存
+    BOOT_MODEL_READY,    // 模型初始化与输入检查完成
+    BOOT_SETUP_DONE,     // 运行时配置已载入、全部线程已启动
+    BOOT_BLE_READY,      // BLE 协议栈启动、开始广播
+    BOOT_WINDOW_READY,   // 第一个滑动窗口填满
+    BOOT_FIRST_RESULT,   // 第一个分类结果
+    BOOT_MILESTONE_COUNT
+};
+
+/**
+ * @brief 记录一个里程碑（只有第一次调用生效，任意线程）并唤醒等待它的线程
+ */
+void boot_module_mark(boot_milestone_t milestone);
+
+/**
+ * @brief 等待一个里程碑（已到达时立即返回）
+ */
+void boot_module_wait(boot_milestone_t milestone);
+
+/**
+ * @brief 里程碑到达时自复位以来的毫秒数；尚未到达时返回 0
+ */
+uint32_t boot_module_elapsed_ms(boot_milestone_t milestone);
+
+#endif
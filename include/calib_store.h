@@ -0,0 +1,194 @@
+#ifndef CALIB_STORE_H
+#define CALIB_STORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct runtime_config_t;
+struct hid_settings_t;
+struct fewshot_table_t;
+struct combo_table_t;
+struct model_kernel_choice_t;
+
+// IMU 校准参数、运行时配置、HID 键位、模型提交记录、自定义手势、组合手势与内核选择的 Flash 持久化接口（各占一页），
+// 两个模型槽，以及现场诊断日志的环形扇区
+
+/**
+ * @brief 每个传感器通道的校准参数（板坐标系：加速度 X/Y/Z + 陀螺仪 X/Y/Z）
+ * 校准后的值 = (原始物理量 - bias) * scale
+ */
+struct imu_calibration_t {
+    float bias[6];
+    float scale[6];
+};
+
+/**
+ * @brief 从 Flash 读取校准参数（直接读取内存映射的 Flash，耗时在微秒级）
+ * @param out_calibration 输出校准参数
+ * @return true 读取成功且校验通过
+ * @return false 没有有效记录
+ */
+bool calib_store_load(imu_calibration_t* out_calibration);
+
+/**
+ * @brief 把校准参数写入 Flash（擦除并写入一个页）
+ * @param calibration 校准参数
+ * @return true 写入并回读校验成功
+ * @return false 写入失败
+ */
+bool calib_store_save(const imu_calibration_t* calibration);
+
+/**
+ * @brief 擦除已保存的校准参数（下次启动会重新校准）
+ */
+bool calib_store_erase();
+
+/**
+ * @brief 从 Flash 读取运行时配置（config_module）
+ * @return true 读取成功且校验通过
+ * @return false 没有有效记录（或记录版本不同）
+ */
+bool calib_store_load_config(runtime_config_t* out_config);
+
+/**
+ * @brief 把运行时配置写入 Flash（擦除并写入一页；擦除期间 CPU 暂停数十毫秒）
+ * @return true 写入并回读校验成功
+ */
+bool calib_store_save_config(const runtime_config_t* config);
+
+/**
+ * @brief 从 Flash 读取 HID 键位与配对记录（hid_module）
+ * @return false 没有有效记录
+ */
+bool calib_store_load_hid(hid_settings_t* out_settings);
+
+/**
+ * @brief 把 HID 键位与配对记录写入 Flash（擦除并写入一页）
+ * @return true 写入并回读校验成功
+ */
+bool calib_store_save_hid(const hid_settings_t* settings);
+
+/**
+ * @brief 模型提交记录：启动时载入哪个模型槽中的权重包（model_slot_module）
+ */
+struct model_commit_t {
+    uint32_t slot;          // 模型槽（0 / 1）
+    uint32_t total_bytes;   // 权重包长度
+    uint32_t crc32;         // 权重包包头中的 crc32
+    uint32_t version;       // 权重包版本
+};
+
+/**
+ * @brief 从 Flash 读取模型提交记录
+ * @return false 没有有效记录（使用内置权重）
+ */
+bool calib_store_load_model(model_commit_t* out_commit);
+
+/**
+ * @brief 把模型提交记录写入 Flash（擦除并写入一页）
+ * @return true 写入并回读校验成功
+ */
+bool calib_store_save_model(const model_commit_t* commit);
+
+/**
+ * @brief 擦除模型提交记录（下次启动使用内置权重）
+ */
+bool calib_store_erase_model();
+
+/**
+ * @brief 模型槽的起始地址（Flash 内存映射，可直接读取）
+ * @param slot 模型槽（0 / 1）
+ * @return uint32_t 地址；槽号无效或 Flash 初始化失败时为 0
+ */
+uint32_t calib_store_model_slot_address(uint8_t slot);
+
+/**
+ * @brief 擦除模型槽开头 bytes 字节所在的扇区（每个扇区擦除期间 CPU 暂停，最长约 85 ms）
+ */
+bool calib_store_model_slot_erase(uint8_t slot, uint32_t bytes);
+
+/**
+ * @brief 向已擦除的模型槽写入数据
+ * @param offset 槽内偏移（4 字节对齐）
+ * @param length 长度（4 的倍数，不超过槽的剩余空间）
+ */
+bool calib_store_model_slot_program(uint8_t slot, uint32_t offset, const void* data, uint32_t length);
+
+/**
+ * @brief 从 Flash 读取自定义手势记录（fewshot_module）
+ * 记录有 1 KB 以上，直接读进调用者的缓冲区：返回 false 时其内容不确定
+ * @return false 没有有效记录
+ */
+bool calib_store_load_fewshot(fewshot_table_t* out_table);
+
+/**
+ * @brief 把自定义手势记录写入 Flash（擦除并写入一页），直接从调用者的缓冲区编程，不在栈上复制
+ * @param table 4 字节对齐
+ * @return true 写入并回读校验成功
+ */
+bool calib_store_save_fewshot(const fewshot_table_t* table);
+
+/**
+ * @brief 从 Flash 读取组合手势表（combo_module）
+ * @return false 没有有效记录（或记录的上限与本固件不同）
+ */
+bool calib_store_load_combos(combo_table_t* out_table);
+
+/**
+ * @brief 把组合手势表写入 Flash（擦除并写入一页）
+ * @return true 写入并回读校验成功
+ */
+bool calib_store_save_combos(const combo_table_t* table);
+
+/**
+ * @brief 从 Flash 读取流式推理的内核选择（model_module，MODEL_KERNEL_AUTOTUNE）
+ * @return false 没有有效记录
+ */
+bool calib_store_load_kernels(model_kernel_choice_t* out_choice);
+
+/**
+ * @brief 把内核选择写入 Flash（擦除并写入一页）
+ * @return true 写入并回读校验成功
+ */
+bool calib_store_save_kernels(const model_kernel_choice_t* choice);
+
+/**
+ * @brief 诊断日志第一个扇区的起始地址（Flash 内存映射，可直接读取；扇区 k 在其后 k x TELEMETRY_SECTOR_BYTES 处）
+ * @return uint32_t 地址；Flash 初始化失败时为 0
+ */
+uint32_t calib_store_telemetry_address();
+
+/**
+ * @brief 擦除诊断日志的一个扇区（擦除期间 CPU 暂停，最长约 85 ms）
+ */
+bool calib_store_telemetry_erase(uint8_t sector);
+
+/**
+ * @brief 向诊断日志扇区的已擦除部分写入数据
+ * @param offset 扇区内偏移（4 字节对齐）
+ * @param length 长度（4 的倍数，不超过扇区的剩余空间）
+ */
+bool calib_store_telemetry_program(uint8_t sector, uint32_t offset, const void* data, uint32_t length);
+
+/**
+ * @brief 主动学习采集区第一个扇区的起始地址（同 calib_store_telemetry_address，扇区大小 CAPTURE_SECTOR_BYTES）
+ * @return uint32_t 地址；Flash 初始化失败时为 0
+ */
+uint32_t calib_store_capture_address();
+
+/**
+ * @brief 擦除采集区的一个扇区
+ */
+bool calib_store_capture_erase(uint8_t sector);
+
+/**
+ * @brief 向采集区扇区的已擦除部分写入数据（对齐要求同 calib_store_telemetry_program）
+ */
+bool calib_store_capture_program(uint8_t sector, uint32_t offset, const void* data, uint32_t length);
+
+/**
+ * @brief CRC32（IEEE 802.3，与各记录的校验相同）
+ */
+uint32_t calib_store_crc32(const uint8_t* data, size_t length);
+
+#endif
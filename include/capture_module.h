@@ -0,0 +1,95 @@
+#ifndef CAPTURE_MODULE_H
+#define CAPTURE_MODULE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "app_config.h"
+#include "model-parameters/model_metadata.h"
+
+// 主动学习采集（CAPTURE_ENABLE）：模型拿不准的窗口正是最值得标注的样本。获胜类别的概率落在含糊区间
+// [CAPTURE_BAND_LOW, CAPTURE_BAND_HIGH]，或前两名的差距小于 CAPTURE_MARGIN 时，把这个 int8 窗口
+// （模型的输入，按时间顺序）复制进片上 Flash 中独立的环形区域，上位机之后整批读出、标注、加入训练集。
+//
+// 正常路径几乎没有代价：推理线程每个窗口只比较两个已有的概率；命中且不在限速间隔内时把 72 字节的窗口
+// 复制进无锁单生产者/单消费者队列（spsc_ring.h），队列满时只计数，从不等待锁或 Flash。主循环
+// （capture_module_poll）把队列中的窗口写入 Flash：编程期间 CPU 暂停（每条记录约 1 ms），擦除只在换扇区时发生。
+//
+// Flash 布局：CAPTURE_SECTORS 个 4 KB 扇区（calib_store），与诊断日志相同地以 {魔数, 序号} 开头、轮流擦除；
+// 扇区中是首尾相接的定长记录（CAPTURE_RECORD_BYTES，小端）：
+//   uint32 自启动以来的毫秒数
+//   int8 获胜类别，int8 第二名（-1 = 无），uint8 两者的概率 x 255
+//   uint16 此前因限速或队列满而没有采集的窗口数，uint16 CRC-16/CCITT-FALSE（记录中除它以外的全部字节）
+//   float 输入量化步长，int8 输入零点，uint8 每帧轴数，uint8 帧数，uint8 标志（CAPTURE_FLAG_*）
+//   int8 窗口 x CAPTURE_WINDOW_VALUES（最旧的帧在前）
+//
+// 读出：与诊断日志共用 BLE 特征值 19B1002B / 19B1002C 与 USB 帧（命令 0x03），导出期间暂停写入
+// （窗口在队列中等待，满了只计数）。
+
+#define CAPTURE_SECTOR_BYTES 4096
+#define CAPTURE_SECTOR_MAGIC 0x43415031  // "CAP1"
+#define CAPTURE_WINDOW_VALUES (EI_CLASSIFIER_RAW_SAMPLE_COUNT * EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME)
+#define CAPTURE_HEADER_BYTES 20
+#define CAPTURE_RECORD_BYTES ((CAPTURE_HEADER_BYTES + CAPTURE_WINDOW_VALUES + 3) & ~3)
+
+// 记录的标志
+#define CAPTURE_FLAG_BAND       0x01  // 获胜类别的概率在含糊区间内
+#define CAPTURE_FLAG_MARGIN     0x02  // 前两名的差距小于 CAPTURE_MARGIN
+#define CAPTURE_FLAG_NORMALIZED 0x04  // 窗口经过逐窗口标准化（INFERENCE_WINDOW_NORMALIZE）
+
+struct capture_status_t {
+    bool dumping;             // 正在导出（写入暂停）
+    uint32_t captured;        // 自启动以来进入队列的窗口数
+    uint32_t suppressed;      // 自启动以来因限速或队列满而没有采集的含糊窗口数
+    uint32_t stored_bytes;    // Flash 中记录的总字节数（即一次导出的长度）
+    uint32_t flash_errors;    // 擦除或编程失败的次数
+};
+
+/**
+ * @brief 扫描 Flash 找到写入位置（setup 中调用，在任何线程启动之前）
+ */
+void capture_module_init();
+
+/**
+ * @brief 主循环定期调用：把队列中的窗口写入 Flash
+ */
+void capture_module_poll();
+
+/**
+ * @brief 推理线程在每次运行 CNN 后调用：窗口含糊且不在限速间隔内时把它放进写入队列（不阻塞）
+ * @param window 量化窗口（环形存放）
+ * @param head 最旧的值在 window 中的位置
+ * @param top 获胜类别（-1 = 未知），top_confidence 其概率
+ * @param runner_up 第二名（-1 = 无），runner_up_confidence 其概率
+ */
+void capture_module_window(const int8_t* window, size_t head, int top, float top_confidence, int runner_up,
+                           float runner_up_confidence);
+
+/**
+ * @brief 窗口的量化参数变化时调用（推理线程），随之后的记录写入
+ */
+void capture_module_set_quantization(float input_scale, int32_t zero_point, bool normalized);
+
+/**
+ * @brief 开始一次导出（BLE 线程）：暂停写入
+ * @return 导出的字节数
+ */
+uint32_t capture_module_dump_begin();
+
+/**
+ * @brief 读取导出字节流中的一段（只在 dump_begin 与 dump_end 之间有效）
+ * @return 实际复制的字节数（到达末尾时小于 length）
+ */
+size_t capture_module_dump_read(uint32_t offset, uint8_t* out, size_t length);
+
+/**
+ * @brief 结束导出，恢复写入
+ */
+void capture_module_dump_end();
+
+/**
+ * @brief 当前状态的副本，任意线程可调用
+ */
+void capture_module_get_status(capture_status_t* out_status);
+
+#endif
@@ -0,0 +1,215 @@
+#ifndef COMBO_MATCHER_H
+#define COMBO_MATCHER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief 一次完成的组合
+ */
+struct combo_match_t {
+    int combo;          // 组合编号（在组合表中的位置）
+    uint8_t length;     // 组合的手势数
+    uint32_t start_ms;  // 组合第一个手势的时间
+    uint32_t end_ms;    // 组合最后一个手势的时间
+};
+
+/**
+ * @brief 组合编译的结果
+ */
+enum combo_error_t {
+    COMBO_OK = 0,
+    COMBO_ERROR_LENGTH,    // 组合少于 2 个或多于 MaxSteps 个手势，或组合多于 MaxCombos 个
+    COMBO_ERROR_LABEL,     // 组合中有不允许的类别（超出类别数或不在 gesture_mask 中）
+    COMBO_ERROR_OVERLAP,   // 一个组合是另一个组合的前缀或出现在其中途（较短的会先完成，较长的永远等不到），或两者相同
+    COMBO_ERROR_GAP,       // 手势间隔为 0
+};
+
+/**
+ * @brief 组合手势匹配：把一组手势序列（如 up, up, left）编译为确定有限自动机，逐个手势 O(1) 转移
+ * 编译先把各组合插入前缀树，再按广度优先补全失配转移（Aho-Corasick）：任一状态对任一类别都有一个后继，
+ * 所以 "up, up, up, left" 中的 "up, up, left" 同样能完成，不需要回溯。状态数不超过 1 + MaxCombos x MaxSteps，
+ * 转移表为 uint8_t[状态][类别]。相邻两个手势的间隔超过 gap_ms 时先回到初始状态；完成一个组合后也回到初始状态，
+ * 组成它的手势不再参与下一个组合。
+ * @tparam MaxCombos 组合个数上限
+ * @tparam MaxSteps 每个组合的手势数上限
+ * @tparam Labels 类别数
+ */
+template <size_t MaxCombos, size_t MaxSteps, size_t Labels>
+class ComboMatcher {
+public:
+    static const size_t kMaxStates = 1 + MaxCombos * MaxSteps;
+    static_assert(kMaxStates <= 255, "states are stored as uint8_t");
+    static_assert(MaxCombos <= 127, "combo numbers are stored as int8_t");
+
+    ComboMatcher() : states_(1), gap_ms_(0) {
+        clear();
+    }
+
+    /**
+     * @brief 编译组合表；失败时保留原来的转移表
+     * @param steps 各组合的类别序列（steps[i][0..lengths[i]-1]）
+     * @param lengths 各组合的手势数
+     * @param count 组合个数（0 = 清空）
+     * @param gap_ms 相邻两个手势的最长间隔
+     * @param gesture_mask 可以出现在组合中的类别（位 i 对应类别 i），其余类别（idle）由调用者过滤
+     */
+    combo_error_t compile(const uint8_t (*steps)[MaxSteps], const uint8_t* lengths, size_t count, uint16_t gap_ms,
+                          uint32_t gesture_mask) {
+        if (count > MaxCombos) {
+            return COMBO_ERROR_LENGTH;
+        }
+        if (gap_ms == 0) {
+            return COMBO_ERROR_GAP;
+        }
+        for (size_t c = 0; c < count; c++) {
+            if (lengths[c] < 2 || lengths[c] > MaxSteps) {
+                return COMBO_ERROR_LENGTH;
+            }
+            for (size_t s = 0; s < lengths[c]; s++) {
+                if (steps[c][s] >= Labels || !((gesture_mask >> steps[c][s]) & 1u)) {
+                    return COMBO_ERROR_LABEL;
+                }
+            }
+        }
+
+        // 在副本上编译：失败时正在使用的转移表不变
+        ComboMatcher compiled;
+        const combo_error_t error = compiled.build(steps, lengths, count);
+        if (error != COMBO_OK) {
+            return error;
+        }
+        compiled.gap_ms_ = gap_ms;
+        *this = compiled;
+        return COMBO_OK;
+    }
+
+    /**
+     * @brief 回到初始状态（不改变组合表）
+     */
+    void reset() {
+        state_ = 0;
+        seen_ = 0;
+    }
+
+    /**
+     * @brief 加入一个手势
+     * @param label 类别（调用者已滤掉 idle 等不参与组合的类别）
+     * @param time_ms 手势的时间
+     * @param out_match 完成组合时的结果
+     * @return true 这个手势完成了一个组合
+     */
+    bool feed(int label, uint32_t time_ms, combo_match_t* out_match) {
+        if (label < 0 || (size_t)label >= Labels) {
+            return false;
+        }
+        if (state_ != 0 && time_ms - last_ms_ > gap_ms_) {
+            reset();
+        }
+        state_ = next_[state_][label];
+        last_ms_ = time_ms;
+        times_[seen_ % MaxSteps] = time_ms;
+        seen_++;
+        const int combo = output_[state_];
+        if (combo < 0) {
+            return false;
+        }
+        // 完成的组合就是最近 length 个手势：回到初始状态之后它们都在 gap_ms 之内
+        const uint8_t length = lengths_[combo];
+        out_match->combo = combo;
+        out_match->length = length;
+        out_match->start_ms = times_[(seen_ - length) % MaxSteps];
+        out_match->end_ms = time_ms;
+        reset();
+        return true;
+    }
+
+    size_t states() const { return states_; }
+    uint16_t gap_ms() const { return gap_ms_; }
+
+private:
+    void clear() {
+        for (size_t s = 0; s < kMaxStates; s++) {
+            for (size_t l = 0; l < Labels; l++) {
+                next_[s][l] = 0;
+            }
+            output_[s] = -1;
+        }
+        for (size_t c = 0; c < MaxCombos; c++) {
+            lengths_[c] = 0;
+        }
+        states_ = 1;
+        last_ms_ = 0;
+        reset();
+    }
+
+    combo_error_t build(const uint8_t (*steps)[MaxSteps], const uint8_t* lengths, size_t count) {
+        // 前缀树：状态 0 是根，没有边指向它，所以 0 也表示“还没有这条边”
+        for (size_t c = 0; c < count; c++) {
+            uint8_t state = 0;
+            for (size_t s = 0; s < lengths[c]; s++) {
+                const uint8_t label = steps[c][s];
+                if (output_[state] >= 0) {
+                    return COMBO_ERROR_OVERLAP;  // 另一个组合是这个的前缀
+                }
+                if (next_[state][label] == 0) {
+                    next_[state][label] = (uint8_t)states_++;
+                }
+                state = next_[state][label];
+            }
+            if (output_[state] >= 0 || has_children(state)) {
+                return COMBO_ERROR_OVERLAP;  // 这个组合是另一个的前缀，或两者相同
+            }
+            output_[state] = (int8_t)c;
+            lengths_[c] = lengths[c];
+        }
+
+        // 广度优先补全转移：fail[s] 是 s 所代表序列的最长真后缀中也在前缀树里的状态。处理 s 之前
+        // next_[s] 中的非零项都是前缀树的边，缺的边取 fail[s] 的转移（它离根更近，已经补全）
+        uint8_t fail[kMaxStates];
+        uint8_t queue[kMaxStates];
+        size_t head = 0;
+        size_t tail = 0;
+        fail[0] = 0;
+        queue[tail++] = 0;
+        while (head < tail) {
+            const uint8_t state = queue[head++];
+            for (size_t l = 0; l < Labels; l++) {
+                const uint8_t child = next_[state][l];
+                if (child == 0) {
+                    next_[state][l] = state == 0 ? 0 : next_[fail[state]][l];
+                    continue;
+                }
+                fail[child] = state == 0 ? 0 : next_[fail[state]][l];
+                // 前缀树的叶子都是组合的结尾；中途的状态的后缀完成了一个较短的组合时，经过它的组合永远等不到
+                if (output_[child] < 0 && output_[fail[child]] >= 0) {
+                    return COMBO_ERROR_OVERLAP;
+                }
+                queue[tail++] = child;
+            }
+        }
+        return COMBO_OK;
+    }
+
+    bool has_children(uint8_t state) const {
+        for (size_t l = 0; l < Labels; l++) {
+            if (next_[state][l] != 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    uint8_t next_[kMaxStates][Labels];
+    int8_t output_[kMaxStates];  // 到达该状态时完成的组合（-1 = 无）
+    uint8_t lengths_[MaxCombos];
+    size_t states_;
+    uint16_t gap_ms_;
+
+    uint8_t state_;
+    uint32_t last_ms_;
+    uint32_t times_[MaxSteps];  // 最近 MaxSteps 个手势的时间（环形）
+    uint32_t seen_;
+};
+
+#endif
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "app_config.h"
+#include "combo_matcher.h"
+#include "inference_module.h"
+
+// On-device gesture combos (BLE_COMBO_ENABLE): sequences such as "up, up,
+// left" written by the host over the combo characteristic, compiled into a
+// ComboMatcher transition table and matched against the published gesture
+// events, so a completed combo goes out as one event instead of every gesture
+// being sent to the host to decide. The table is kept in flash. Everything
+// here runs on the BLE thread.
+
+// Encoded table, the value of the combo characteristic: uint8 combo count,
+// uint16 longest gap between two gestures of a combo in ms, then per combo
+// uint8 length and that many uint8 model labels, little-endian.
+#define COMBO_HEADER_BYTES 3
+#define COMBO_ENCODED_MAX_BYTES (COMBO_HEADER_BYTES + BLE_COMBO_MAX * (1 + BLE_COMBO_MAX_STEPS))
+
+// Flash record (fixed layout, no padding).
+struct combo_table_t {
+    uint8_t count;
+    uint8_t reserved;
+    uint16_t gap_ms;
+    uint8_t lengths[BLE_COMBO_MAX];
+    uint8_t steps[BLE_COMBO_MAX][BLE_COMBO_MAX_STEPS];
+};
+
+/**
+ * @brief Load the combos from flash (none when nothing is stored) and compile them.
+ *        Called from ble_module_init().
+ */
+void combo_module_begin();
+
+/**
+ * @brief The table in use, in the characteristic encoding.
+ * @return bytes written to out (capacity COMBO_ENCODED_MAX_BYTES)
+ */
+size_t combo_module_encode(uint8_t* out);
+
+/**
+ * @brief Replace the table with an encoded one; written to flash only when it
+ *        compiles and differs from the stored one. A rejected table leaves the
+ *        one in use unchanged.
+ */
+combo_error_t combo_module_set(const uint8_t* value, size_t length);
+
+/**
+ * @brief Feed one published result event. Idle and unknown results are not
+ *        steps of a combo; with raw events a run of the same gesture is one step.
+ * @return true when the event completed a combo (out_match filled)
+ */
+bool combo_module_feed(const inference_result_snapshot_t& event, combo_match_t* out_match);
+
+/**
+ * @brief Name of a compile error for the log.
+ */
+const char* combo_module_error_name(combo_error_t error);
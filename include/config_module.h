@@ -0,0 +1,93 @@
+#ifndef CONFIG_MODULE_H
+#define CONFIG_MODULE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 运行时配置：BLE / LED 的置信度阈值、推理步长与 BLE 轮询间隔
+// 启动时从 Flash 载入（没有有效记录时使用 app_config.h 中的编译期默认值），
+// 由 BLE 配置特征或串口命令 "cfg" 修改；一次修改的所有字段同时生效并写回 Flash。
+// 读者（BLE / LED 线程）经顺序锁无锁读取完整快照，不会看到一半新、一半旧的配置。
+
+enum config_profile_t {
+    CONFIG_PROFILE_DEFAULT = 0,      // 编译期默认值
+    CONFIG_PROFILE_LOW_LATENCY = 1,  // 最小步长、BLE 快速轮询
+    CONFIG_PROFILE_LOW_POWER = 2,    // 放宽步长与轮询间隔
+    CONFIG_PROFILE_CUSTOM = 3,       // 逐项修改过
+    CONFIG_PROFILE_COUNT
+};
+
+// 布局固定且没有填充字节（整体存入 Flash 并逐字节校验）
+struct runtime_config_t {
+    float ble_min_confidence;        // BLE 只发送置信度不低于该值的结果
+    float led_confidence_threshold;  // LED 只显示置信度高于该值的结果（1 = 关闭 LED）
+    uint16_t ble_poll_interval_ms;   // 没有新结果时 BLE.poll() 与诊断数据的节奏
+    uint8_t stride_fine_samples;     // 推理步长（样本数，见 inference_set_stride）
+    uint8_t stride_coarse_samples;
+    uint8_t profile;                 // config_profile_t
+    uint8_t reserved[3];
+};
+
+/**
+ * @brief 载入保存的配置并应用（在 inference_module_init 之后调用）
+ */
+void config_module_init();
+
+/**
+ * @brief 读取当前配置（任意线程，无锁）
+ * @return uint32_t 配置版本号，每次修改加一；读者据此判断配置是否变化
+ */
+uint32_t config_module_get(runtime_config_t* out_config);
+
+/**
+ * @brief 取某个预设的配置
+ * @param profile CONFIG_PROFILE_DEFAULT / LOW_LATENCY / LOW_POWER
+ * @return false 不是预设
+ */
+bool config_module_preset(config_profile_t profile, runtime_config_t* out_config);
+
+/**
+ * @brief 校验并应用新配置，与已保存的不同时写回 Flash（线程安全）
+ * 写 Flash 时擦除一页，CPU 暂停数十毫秒，只应在配置真正变化时调用。
+ * @return true 已应用
+ * @return false 参数无效，保持原配置
+ */
+bool config_module_set(const runtime_config_t* config);
+
+// 线上格式（BLE 配置特征值 19B1001A、USB 帧 0x1A 与诊断命令共用）：uint8 预设，uint8 BLE 置信度 ×255，
+// uint8 LED 置信度 ×255，uint8 细步长，uint8 粗步长，uint16 轮询间隔（毫秒，小端）。
+// 写入时只有 1 字节表示切换到该预设，完整的 7 字节总是自定义配置。
+#define CONFIG_WIRE_BYTES 7
+
+// 工作点命令（同一特征值 / 帧 / 命令写入 2 字节）：CONFIG_OPERATING_POINT_MARKER，uint8 inference_power_point_t
+// 或 0xFF 撤销。由上位机按前台程序发送（inference_set_host_power_point），不改变配置、不写 Flash。
+#define CONFIG_OPERATING_POINT_MARKER 0xFE
+#define CONFIG_OPERATING_POINT_BYTES 2
+
+/**
+ * @brief 按线上格式编码当前配置
+ * @param out 至少 CONFIG_WIRE_BYTES 字节
+ * @return uint32_t 配置版本号（同 config_module_get）
+ */
+uint32_t config_module_encode(uint8_t* out);
+
+/**
+ * @brief 解码线上格式的写入并应用（同 config_module_set）；2 字节的工作点命令交给推理模块
+ * @return false 长度或参数无效，保持原配置
+ */
+bool config_module_write(const uint8_t* value, size_t length);
+
+/**
+ * @brief 执行串口命令 "cfg ..."（参数部分）：
+ * 空 = 打印当前配置；default / low-latency / low-power = 切换预设；
+ * ble <置信度> / led <置信度> / stride <细> <粗> / poll <毫秒> = 修改单项
+ * @return false 命令无效或参数被拒绝
+ */
+bool config_module_command(const char* args);
+
+/**
+ * @brief 预设名（"default" / "low-latency" / "low-power" / "custom"）
+ */
+const char* config_module_profile_name(uint8_t profile);
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef CORE1_MODULE_H
+#define CORE1_MODULE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 第二个核上的模型调用（RP2040，INFERENCE_DUAL_CORE）
+// Mbed RTX 只在核 0 上调度，采集、BLE / USB 传输、LED 与其余线程都留在核 0；核 1 不运行 RTOS，
+// 只执行推理线程交给它的作业：推理线程写好作业后经 SIO 核间 FIFO 发一个字，在 EventFlags 上阻塞，
+// 核 1 完成后回发一个字，核 0 的 FIFO 中断置位标志唤醒推理线程。调用期间核 0 上的其它线程照常运行，
+// 模型不再与采集 / 传输分时，推理吞吐按核 0 上原本被占用的比例提升。
+// 作业不能使用堆、日志、RTOS 对象或任何依赖核 0 的接口（推理路径的分配全部是静态的，
+// 见 EI_CLASSIFIER_ALLOCATION_STATIC）；作业读写的数据在调用期间只能由推理线程自己访问。
+// 擦写 Flash 期间 XIP 不可用，核 1 的空闲循环放在 RAM 中，擦写操作用 core1_module_flash_begin / end
+// 与模型调用互斥。INFERENCE_DUAL_CORE 为 0 时作业在调用线程中直接运行，其余接口为空。
+
+/**
+ * @brief 作业函数（核 1 上运行，返回值原样交还调用者）
+ */
+typedef bool (*core1_job_t)(void* arg);
+
+struct core1_stats_t {
+    uint32_t jobs;        // 启动以来完成的作业数
+    uint32_t busy_us;     // 启动以来核 1 执行作业的累计时间
+    uint32_t stack_peak;  // 核 1 栈的峰值用量（字节，按未被改写的填充字估算）
+};
+
+/**
+ * @brief 启动核 1 并注册核间 FIFO 中断（setup 中、推理线程启动前调用）
+ */
+void core1_module_init();
+
+/**
+ * @brief 在核 1 上运行作业并等待完成（只在推理线程中调用，同一时刻最多一个作业）
+ * @return 作业函数的返回值
+ */
+bool core1_module_run(core1_job_t job, void* arg);
+
+/**
+ * @brief 擦写 Flash 前调用：等待进行中的作业结束并阻止新作业开始，直到 core1_module_flash_end
+ */
+void core1_module_flash_begin();
+
+/**
+ * @brief 擦写 Flash 后调用
+ */
+void core1_module_flash_end();
+
+/**
+ * @brief 读取核 1 的作业统计（线程安全）
+ */
+void core1_module_get_stats(core1_stats_t* out_stats);
+
+/**
+ * @brief 打印核 1 的作业数、上次报告以来的占用率与栈峰值（INFERENCE_DUAL_CORE 为 0 时不打印）
+ */
+void core1_module_report();
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef CRASH_MODULE_H
+#define CRASH_MODULE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "app_config.h"
+#include "thread_module.h"
+
+// 崩溃记录：HardFault 等硬件错误、RTX 检查到的线程栈溢出、MBED_ASSERT 与其它 mbed 致命错误都经
+// mbed_error_hook 进入本模块。钩子不调用 RTOS、不打印，只把故障寄存器、出错线程、各线程栈峰值与
+// 最近 CRASH_TRAIL_DEPTH 次流水线级运行（轨迹）写进不随复位清零的 RAM，随即软件复位，而不是停在闪灯。
+// 轨迹由 pipeline_module_record 持续写入同一块 RAM，看门狗复位（没有寄存器可记）时也能读出。
+// 下次启动时打印 [Crash] 报告、写入诊断日志（TELEMETRY_ENABLE），并在整个运行期间经 BLE 特征值
+// 19B10031（读）/ USB 帧 0x31（会话开始时）提供给上位机。上电时 RAM 内容随机，由魔数与 CRC 判断有效。
+
+enum crash_kind_t {
+    CRASH_NONE = 0,
+    CRASH_FAULT,           // HardFault / MemManage / BusFault / UsageFault
+    CRASH_STACK_OVERFLOW,  // RTX 在线程切换时发现栈底魔数被改写
+    CRASH_ERROR,           // 其它 mbed 致命错误（MBED_ASSERT、RTOS 对象错误、内存耗尽）
+    CRASH_WATCHDOG,        // 看门狗复位：没有寄存器与栈峰值，只有轨迹
+};
+
+/**
+ * @brief 轨迹中的一次流水线级运行
+ */
+struct crash_trail_entry_t {
+    uint32_t start_us;     // micros()
+    uint16_t duration_us;  // 饱和于 65535
+    uint8_t stage;         // pipeline_stage_t
+    uint8_t reserved;
+};
+
+/**
+ * @brief 上次复位前的崩溃
+ */
+struct crash_report_t {
+    uint8_t kind;          // crash_kind_t
+    uint8_t thread;        // 出错线程（thread_role_t）；THREAD_COUNT = 不在线程表中（主线程、中断）
+    uint8_t trail_count;
+    uint32_t status;       // mbed_error_status_t
+    uint32_t uptime_ms;
+    uint32_t pc;           // 硬件错误时为出错指令；其它错误为调用 mbed_error 的地址
+    uint32_t lr;           // 只有硬件错误有
+    uint32_t sp;
+    uint32_t value;        // mbed_error 的附带值（栈溢出时为线程 ID）
+    uint32_t cfsr;         // SCB 可配置故障状态、硬件错误状态与两个故障地址寄存器
+    uint32_t hfsr;
+    uint32_t mmfar;
+    uint32_t bfar;
+    uint16_t stack_peak[THREAD_COUNT];  // 各线程出错时的栈峰值（字节）
+    crash_trail_entry_t trail[CRASH_TRAIL_DEPTH];  // 从旧到新
+};
+
+// 编码后的报告（上位机读取的格式，小端）：
+//   uint8 类型，uint8 线程（0xFF = 不在线程表中），uint8 轨迹条数，uint8 线程数，
+//   uint32 mbed 错误码、出错时运行毫秒数、pc、lr、sp、附带值、CFSR、HFSR、MMFAR、BFAR，
+//   每个线程 uint16 栈大小与栈峰值（字节），每条轨迹 uint32 开始 µs、uint16 耗时 µs、uint8 流水线级、1 字节保留
+// 没有报告时只有前 4 字节（类型为 0）。
+#define CRASH_REPORT_HEADER_BYTES 44
+#define CRASH_REPORT_MAX_BYTES (CRASH_REPORT_HEADER_BYTES + THREAD_COUNT * 4 + CRASH_TRAIL_DEPTH * 8)
+
+#if CRASH_CAPTURE_ENABLE
+
+/**
+ * @brief 取出上次复位前的崩溃记录（或看门狗复位前的轨迹），打印并写入诊断日志，然后为本次运行清空轨迹
+ * setup 中在诊断日志与看门狗初始化之后、任何线程启动之前调用。
+ */
+void crash_module_init();
+
+/**
+ * @brief 记录一次流水线级运行（pipeline_module_record 调用；任意线程，无锁）
+ */
+void crash_module_trail(uint8_t stage, uint32_t start_us, uint32_t duration_us);
+
+/**
+ * @brief 读取上次复位前的报告
+ * @return 有报告
+ */
+bool crash_module_get(crash_report_t* out_report);
+
+/**
+ * @brief 按上面的格式编码报告
+ * @param out 至少 CRASH_REPORT_MAX_BYTES 字节
+ * @return 字节数
+ */
+size_t crash_module_encode(uint8_t* out);
+
+#else
+
+static inline void crash_module_init() {}
+static inline void crash_module_trail(uint8_t, uint32_t, uint32_t) {}
+static inline bool crash_module_get(crash_report_t*) { return false; }
+
+#endif
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef EARLY_EXIT_MODEL_H
+#define EARLY_EXIT_MODEL_H
+
+// 第一层池化之后的提前退出分类头（见 model_module.cpp）
+// 由 pc_controller/early_exit_trainer.py 生成；尚未训练时没有类别，提前退出不生效
+
+#include <stdint.h>
+
+#define EARLY_EXIT_MODEL_CLASSES 0
+#define EARLY_EXIT_MODEL_COLUMNS 36
+#define EARLY_EXIT_MODEL_CHANNELS 8
+#define EARLY_EXIT_MODEL_FEATURES 16
+
+static const int8_t kEarlyExitWeights[1] = {0};
+static const int32_t kEarlyExitBias[1] = {0};
+static const float kEarlyExitLogitScale = 0.0f;
+static const uint32_t kEarlyExitClassMask = 0;
+static const float kEarlyExitThreshold = 1.0f;
+
+#endif
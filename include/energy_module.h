@@ -0,0 +1,89 @@
+#ifndef ENERGY_MODULE_H
+#define ENERGY_MODULE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <chrono>
+
+// 能耗估算接口
+// 各线程在阻塞等待（休眠、事件、中断）前后登记，模块据此统计每个线程的活动时间和 CPU 空闲（System ON
+// 睡眠）时间，再按 app_config.h 中的功率常数估算每个分类窗口的能耗（µJ），用于比较步长、门控、
+// 低功耗模式等策略。中断与 BLE 协议栈的时间不单独统计，计入当时被打断的线程或睡眠时间。
+
+/**
+ * @brief 参与统计的线程
+ */
+enum energy_thread_t {
+    ENERGY_SAMPLER = 0,
+    ENERGY_INFERENCE,
+    ENERGY_BLE,
+    ENERGY_LED,
+    ENERGY_RECORD,
+    ENERGY_LOG,
+    ENERGY_THREAD_COUNT
+};
+
+/**
+ * @brief 一个统计窗口的能耗估算
+ */
+struct energy_stats_t {
+    uint32_t window_us;                             // 统计窗口长度
+    uint32_t active_us;                             // 至少一个线程处于活动状态的时间
+    uint32_t thread_us[ENERGY_THREAD_COUNT];        // 各线程实际占用 CPU 的时间（被抢占的时间记给抢占者）
+    uint32_t kernel_idle_us;                        // Mbed 空闲线程的运行时间（mbed_stats_cpu_get）
+    bool kernel_idle_valid;                         // false = 核心未启用 MBED_CPU_STATS_ENABLED，kernel_idle_us 无效
+    uint32_t windows;                               // 窗口内分类的窗口数
+    float energy_uj;                                // 窗口内的总能耗估算（CPU 活动 + 睡眠 + 常开负载）
+    float uj_per_window;                            // 每个分类窗口分摊的总能耗
+    float inference_uj_per_window;                  // 其中推理线程 CPU 活动的部分
+};
+
+/**
+ * @brief 开始统计（所有线程视为尚未运行）
+ */
+void energy_module_init();
+
+/**
+ * @brief 当前线程开始活动（线程启动、阻塞等待返回后调用；无锁，每个线程只登记自己）
+ */
+void energy_module_wake(energy_thread_t thread);
+
+/**
+ * @brief 当前线程即将阻塞等待（之后直到 energy_module_wake 都不计为活动）
+ */
+void energy_module_sleep(energy_thread_t thread);
+
+/**
+ * @brief 休眠指定时间，并把这段时间计为该线程的空闲时间
+ */
+void energy_module_sleep_for(energy_thread_t thread, std::chrono::milliseconds duration);
+
+/**
+ * @brief 结算当前统计窗口并开始新窗口
+ * @param windows 窗口内分类的窗口数
+ * @param out_stats 输出统计
+ */
+void energy_module_snapshot(uint32_t windows, energy_stats_t* out_stats);
+
+/**
+ * @brief 最近一次结算的统计（任意线程，无锁）
+ */
+void energy_module_get_stats(energy_stats_t* out_stats);
+
+/**
+ * @brief 统计窗口内的 CPU 占用率（千分比）
+ */
+struct energy_utilization_t {
+    uint16_t active_permille;                       // 至少一个已登记线程在运行
+    uint16_t thread_permille[ENERGY_THREAD_COUNT];
+    uint16_t idle_permille;                         // 空闲（System ON 睡眠）
+    // 未登记的部分：中断、BLE 协议栈、主循环；需要内核空闲统计，否则为 0xFFFF
+    uint16_t other_permille;
+};
+
+/**
+ * @brief 把一次结算折算为占用率；有内核空闲统计时空闲取内核值，其余为 1 - 活动 - 空闲
+ */
+void energy_module_utilization(const energy_stats_t& stats, energy_utilization_t* out_utilization);
+
+#endif
@@ -0,0 +1,213 @@
+#ifndef ESP32_MBED_H
+#define ESP32_MBED_H
+
+// ESP32 构建用的 Mbed 驱动子集，接口与 Mbed OS 6 的同名类一致：
+// InterruptIn -> GPIO 中断（attachInterrupt），Ticker / Timeout -> esp_timer（回调在 esp_timer 任务中运行），
+// PwmOut -> LEDC，FlashIAP -> 数据分区（ESP32_STORE_PARTITION），Watchdog -> 任务看门狗，
+// ResetReason -> esp_reset_reason，CriticalSectionLock -> 跨核自旋锁临界区，NVIC_SystemReset -> esp_restart，
+// events::EventQueue -> FreeRTOS 队列（只支持 call(函数, int) 与 dispatch_forever）。
+// 引脚名（PinName）就是 GPIO 编号。没有异步 I2C（DEVICE_I2C_ASYNCH），imu_bus 使用 Wire 阻塞传输
+
+#include <Arduino.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <chrono>
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "rtos.h"
+
+#define DEVICE_WATCHDOG 1
+#define DEVICE_RESET_REASON 1
+
+typedef int PinName;
+
+inline PinName digitalPinToPinName(int pin) {
+    return pin;
+}
+
+[[noreturn]] inline void NVIC_SystemReset() {
+    esp_restart();
+}
+
+typedef enum {
+    RESET_REASON_POWER_ON,
+    RESET_REASON_PIN_RESET,
+    RESET_REASON_BROWN_OUT,
+    RESET_REASON_SOFTWARE,
+    RESET_REASON_WATCHDOG,
+    RESET_REASON_LOCKUP,
+    RESET_REASON_WAKE_LOW_POWER,
+    RESET_REASON_UNKNOWN,
+} reset_reason_t;
+
+namespace mbed {
+
+// 固件只把普通函数交给 InterruptIn / Ticker / Timeout / I2C，callback 原样返回函数指针
+template <typename F>
+inline F callback(F function) {
+    return function;
+}
+
+class CriticalSectionLock {
+public:
+    CriticalSectionLock();
+    ~CriticalSectionLock();
+    CriticalSectionLock(const CriticalSectionLock&) = delete;
+    CriticalSectionLock& operator=(const CriticalSectionLock&) = delete;
+};
+
+class InterruptIn {
+public:
+    explicit InterruptIn(PinName pin) : pin_(pin) {}
+
+    void rise(void (*handler)());
+    void fall(void (*handler)());
+
+private:
+    PinName pin_;
+};
+
+/**
+ * @brief esp_timer 上的一次性 / 周期回调；回调在 esp_timer 任务（PRO_CPU，最高优先级之一）中运行，
+ * 可以像 Mbed 的中断回调一样置位 EventFlags
+ */
+class TimerEvent {
+public:
+    TimerEvent() : handle_(nullptr), handler_(nullptr) {}
+    ~TimerEvent();
+    TimerEvent(const TimerEvent&) = delete;
+    TimerEvent& operator=(const TimerEvent&) = delete;
+
+    void detach();
+
+protected:
+    void arm(void (*handler)(), int64_t period_us, bool periodic);
+
+private:
+    static void dispatch(void* arg);
+
+    esp_timer_handle_t handle_;
+    void (*volatile handler_)();
+};
+
+class Ticker : public TimerEvent {
+public:
+    template <typename Rep, typename Period>
+    void attach(void (*handler)(), std::chrono::duration<Rep, Period> period) {
+        arm(handler, std::chrono::duration_cast<std::chrono::microseconds>(period).count(), true);
+    }
+};
+
+class Timeout : public TimerEvent {
+public:
+    template <typename Rep, typename Period>
+    void attach(void (*handler)(), std::chrono::duration<Rep, Period> delay) {
+        arm(handler, std::chrono::duration_cast<std::chrono::microseconds>(delay).count(), false);
+    }
+};
+
+class PwmOut {
+public:
+    explicit PwmOut(PinName pin);
+
+    void period_us(int us);
+    void write(float value);
+
+private:
+    PinName pin_;
+    uint8_t channel_;
+    uint32_t frequency_hz_;
+};
+
+/**
+ * @brief 数据分区上的 Flash 接口：地址是分区映射到数据总线上的地址（整个分区在首次 init 时 mmap，
+ * 之后不再解除），因此 calib_store 算出的地址可以像片上 Flash 一样直接按指针读取（模型槽）；
+ * 擦写前换算回分区内偏移
+ */
+class FlashIAP {
+public:
+    int init();
+    int deinit() { return 0; }
+    int read(void* buffer, uint32_t address, uint32_t size);
+    int program(const void* buffer, uint32_t address, uint32_t size);
+    int erase(uint32_t address, uint32_t size);
+    uint32_t get_page_size() const { return 4; }
+    uint32_t get_sector_size(uint32_t) const { return 4096; }
+    uint32_t get_flash_start() const;
+    uint32_t get_flash_size() const;
+};
+
+/**
+ * @brief 任务看门狗：start 把调用线程加入监视（只有推理线程调用），超时后复位
+ */
+class Watchdog {
+public:
+    static Watchdog& get_instance();
+
+    bool start(uint32_t timeout_ms);
+    bool kick();
+
+private:
+    Watchdog() : started_(false) {}
+
+    bool started_;
+};
+
+class ResetReason {
+public:
+    static reset_reason_t get();
+};
+
+}  // namespace mbed
+
+namespace events {
+
+struct EventQueueItem {
+    void (*function)(int);
+    int arg;
+};
+
+/**
+ * @brief 事件队列：事件放进调用方提供的缓冲（静态队列），dispatch_forever 在调用线程中逐个执行。
+ * call 可以在中断中调用；队列满时返回 0
+ */
+class EventQueue {
+public:
+    EventQueue(unsigned size, unsigned char* buffer)
+        : handle_(xQueueCreateStatic(size / sizeof(EventQueueItem), sizeof(EventQueueItem), buffer, &control_)) {}
+    EventQueue(const EventQueue&) = delete;
+    EventQueue& operator=(const EventQueue&) = delete;
+
+    int call(void (*function)(int), int arg) {
+        const EventQueueItem item = {function, arg};
+        if (xPortInIsrContext()) {
+            BaseType_t woken = pdFALSE;
+            const BaseType_t sent = xQueueSendFromISR(handle_, &item, &woken);
+            portYIELD_FROM_ISR(woken);
+            return sent == pdTRUE ? 1 : 0;
+        }
+        return xQueueSend(handle_, &item, 0) == pdTRUE ? 1 : 0;
+    }
+
+    [[noreturn]] void dispatch_forever() {
+        for (;;) {
+            EventQueueItem item;
+            if (xQueueReceive(handle_, &item, portMAX_DELAY) == pdTRUE) {
+                item.function(item.arg);
+            }
+        }
+    }
+
+private:
+    StaticQueue_t control_;
+    QueueHandle_t handle_;
+};
+
+}  // namespace events
+
+// 一个事件占用的缓冲字节数（与 Mbed 的同名宏用法相同：缓冲大小 = 事件数 × EVENTS_EVENT_SIZE）
+#define EVENTS_EVENT_SIZE sizeof(events::EventQueueItem)
+
+#endif
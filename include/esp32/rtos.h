@@ -0,0 +1,245 @@
+#ifndef ESP32_RTOS_H
+#define ESP32_RTOS_H
+
+// ESP32 构建用的 Mbed rtos 子集（ESP-IDF FreeRTOS 实现），接口与 Mbed OS 6 的同名类一致，模块代码不必区分平台。
+// 所有对象的控制块都是静态的（xSemaphoreCreateRecursiveMutexStatic / xEventGroupCreateStatic /
+// xTaskCreateStaticPinnedToCore），不占用堆；EventFlags 只有 FreeRTOS 事件组的低 24 位可用。
+// Thread 比 Mbed 多一个构造参数 core：0 = PRO_CPU，1 = APP_CPU，tskNO_AFFINITY = 不绑定
+
+#include <stdint.h>
+#include <chrono>
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+
+#define osWaitForever       0xFFFFFFFFU
+#define osFlagsError        0x80000000U
+#define osFlagsErrorTimeout 0xFFFFFFFEU
+
+// CMSIS-RTOS2 的状态码与优先级取值（与 Mbed 相同），启动线程时换算为 FreeRTOS 优先级
+typedef enum {
+    osOK = 0,
+    osError = -1,
+    osErrorTimeout = -2,
+    osErrorResource = -3,
+    osErrorParameter = -4,
+    osErrorNoMemory = -5,
+} osStatus;
+
+typedef enum {
+    osPriorityIdle = 1,
+    osPriorityLow = 8,
+    osPriorityLow1 = 9,
+    osPriorityBelowNormal = 16,
+    osPriorityNormal = 24,
+    osPriorityAboveNormal = 32,
+    osPriorityHigh = 40,
+    osPriorityRealtime = 48,
+} osPriority_t;
+
+namespace rtos {
+
+namespace Kernel {
+
+// 与 Mbed 的 Kernel::Clock 一样是 1 ms 分辨率的单调时钟（取自 esp_timer，64 位不回绕）
+struct Clock {
+    typedef std::chrono::milliseconds duration;
+    typedef duration::rep rep;
+    typedef duration::period period;
+    typedef std::chrono::time_point<Clock> time_point;
+    static constexpr bool is_steady = true;
+
+    static time_point now() { return time_point(duration(esp_timer_get_time() / 1000)); }
+};
+
+}  // namespace Kernel
+
+// Mbed 的 Mutex 是可重入的
+class Mutex {
+public:
+    Mutex() : handle_(xSemaphoreCreateRecursiveMutexStatic(&buffer_)) {}
+    Mutex(const Mutex&) = delete;
+    Mutex& operator=(const Mutex&) = delete;
+
+    void lock() { xSemaphoreTakeRecursive(handle_, portMAX_DELAY); }
+    bool trylock() { return xSemaphoreTakeRecursive(handle_, 0) == pdTRUE; }
+    void unlock() { xSemaphoreGiveRecursive(handle_); }
+
+private:
+    StaticSemaphore_t buffer_;
+    SemaphoreHandle_t handle_;
+};
+
+class EventFlags {
+public:
+    EventFlags() : handle_(xEventGroupCreateStatic(&buffer_)) {}
+    EventFlags(const EventFlags&) = delete;
+    EventFlags& operator=(const EventFlags&) = delete;
+
+    // 可以在中断中调用（经定时器服务任务转发，唤醒晚一次任务切换）
+    uint32_t set(uint32_t flags) {
+        if (xPortInIsrContext()) {
+            BaseType_t woken = pdFALSE;
+            xEventGroupSetBitsFromISR(handle_, flags & kUsableBits, &woken);
+            portYIELD_FROM_ISR(woken);
+            return flags;
+        }
+        return (uint32_t)xEventGroupSetBits(handle_, flags & kUsableBits);
+    }
+
+    uint32_t clear(uint32_t flags = 0x7FFFFFFFU) {
+        if (xPortInIsrContext()) {
+            const uint32_t previous = (uint32_t)xEventGroupGetBitsFromISR(handle_);
+            xEventGroupClearBitsFromISR(handle_, flags & kUsableBits);
+            return previous;
+        }
+        return (uint32_t)xEventGroupClearBits(handle_, flags & kUsableBits);
+    }
+
+    uint32_t get() const {
+        return xPortInIsrContext() ? (uint32_t)xEventGroupGetBitsFromISR(handle_)
+                                   : (uint32_t)xEventGroupGetBits(handle_);
+    }
+
+    uint32_t wait_any(uint32_t flags, uint32_t millisec = osWaitForever, bool clear = true) {
+        return wait(flags, millisec == osWaitForever ? portMAX_DELAY : pdMS_TO_TICKS(millisec), clear);
+    }
+
+    template <typename Rep, typename Period>
+    uint32_t wait_any_for(uint32_t flags, std::chrono::duration<Rep, Period> timeout, bool clear = true) {
+        const int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(timeout).count();
+        return wait(flags, ms <= 0 ? 0 : pdMS_TO_TICKS(ms) + 1, clear);
+    }
+
+private:
+    static constexpr uint32_t kUsableBits = 0x00FFFFFFU;
+
+    uint32_t wait(uint32_t flags, TickType_t ticks, bool clear) {
+        const uint32_t matched = (uint32_t)xEventGroupWaitBits(handle_, flags & kUsableBits,
+                                                               clear ? pdTRUE : pdFALSE, pdFALSE, ticks);
+        return (matched & flags) != 0 ? matched : osFlagsErrorTimeout;
+    }
+
+    StaticEventGroup_t buffer_;
+    EventGroupHandle_t handle_;
+};
+
+class Thread {
+public:
+    enum State {
+        Inactive,
+        Ready,
+        Running,
+        WaitingDelay,
+        WaitingEventFlag,
+        Deleted,
+    };
+
+    Thread(osPriority_t priority = osPriorityNormal, uint32_t stack_size = 4096, unsigned char* stack_mem = nullptr,
+           const char* name = nullptr, int core = tskNO_AFFINITY)
+        : priority_(priority), stack_size_(stack_size), stack_mem_(stack_mem), name_(name), core_(core),
+          task_(nullptr), handle_(nullptr), finished_(false) {}
+    Thread(const Thread&) = delete;
+    Thread& operator=(const Thread&) = delete;
+
+    // 线程函数返回后任务挂起（而不是自行删除），控制块与栈在析构时回收
+    ~Thread() {
+        if (handle_) {
+            vTaskDelete(handle_);
+        }
+    }
+
+    // 只支持静态栈（固件的线程表全部使用静态栈）
+    osStatus start(void (*task)()) {
+        if (handle_ || stack_mem_ == nullptr || task == nullptr) {
+            return osErrorParameter;
+        }
+        task_ = task;
+        handle_ = xTaskCreateStaticPinnedToCore(&Thread::entry, name_ ? name_ : "thread", stack_size_, this,
+                                                freertos_priority(priority_),
+                                                reinterpret_cast<StackType_t*>(stack_mem_), &tcb_, core_);
+        return handle_ ? osOK : osErrorNoMemory;
+    }
+
+    State get_state() const {
+        if (!handle_) {
+            return Inactive;
+        }
+        if (finished_) {
+            return Deleted;
+        }
+        switch (eTaskGetState(handle_)) {
+        case eRunning:
+            return Running;
+        case eReady:
+            return Ready;
+        case eBlocked:
+            return WaitingDelay;
+        case eSuspended:
+            return WaitingEventFlag;
+        default:
+            return Deleted;
+        }
+    }
+
+    osPriority_t get_priority() const { return priority_; }
+
+    /**
+     * @brief CMSIS 优先级换算为 FreeRTOS 优先级：Low -> 1，Low1 -> 2，BelowNormal -> 3，Normal -> 4，
+     * AboveNormal -> 5 ……，都低于 BT 控制器与 esp_timer 任务，高于 Arduino loopTask（1）之外的空闲任务
+     */
+    static UBaseType_t freertos_priority(osPriority_t priority) {
+        if (priority < osPriorityLow1) {
+            return 1;
+        }
+        if (priority < osPriorityBelowNormal) {
+            return 2;
+        }
+        return 3 + (priority - osPriorityBelowNormal) / 8;
+    }
+
+private:
+    static void entry(void* arg) {
+        Thread* self = static_cast<Thread*>(arg);
+        self->task_();
+        self->finished_ = true;
+        vTaskSuspend(nullptr);
+    }
+
+    osPriority_t priority_;
+    uint32_t stack_size_;
+    unsigned char* stack_mem_;
+    const char* name_;
+    int core_;
+    void (*task_)();
+    StaticTask_t tcb_;
+    TaskHandle_t handle_;
+    volatile bool finished_;
+};
+
+namespace ThisThread {
+
+template <typename Rep, typename Period>
+inline void sleep_for(std::chrono::duration<Rep, Period> duration) {
+    const int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+    vTaskDelay(ms <= 0 ? 0 : (pdMS_TO_TICKS(ms) > 0 ? pdMS_TO_TICKS(ms) : 1));
+}
+
+inline void sleep_until(Kernel::Clock::time_point deadline) {
+    const Kernel::Clock::time_point now = Kernel::Clock::now();
+    if (deadline > now) {
+        sleep_for(deadline - now);
+    }
+}
+
+inline void yield() {
+    taskYIELD();
+}
+
+}  // namespace ThisThread
+
+}  // namespace rtos
+
+#endif
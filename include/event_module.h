@@ -0,0 +1,39 @@
+#ifndef EVENT_MODULE_H
+#define EVENT_MODULE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 低优先级事件线程
+// LED 动画与日志输出都只是"有新数据时做一点事"，不值得各占一个线程和一份栈：它们作为事件源，
+// 在同一个线程上由 events::EventQueue 依次派发。每个事件源最多排队一个事件（重复投递合并），
+// 队列缓冲是静态的，投递可以在任意线程或中断中进行。处理函数取走投递之前积累的全部数据，不能阻塞。
+
+// 事件源（派发表中的顺序）
+enum event_source_t {
+    EVENT_LED = 0,  // 推理结果发布、（Nicla）动画颜色待发送
+    EVENT_LOG,      // 日志队列中有记录
+    EVENT_SOURCE_COUNT
+};
+
+/**
+ * @brief 投递一个事件源的事件（任意线程 / 中断）；该事件源已有事件排队时不重复投递
+ */
+void event_module_post(event_source_t source);
+
+/**
+ * @brief 把投递失败次数登记到统计注册表（启动时调用一次）
+ */
+void event_module_init();
+
+/**
+ * @brief 因队列缓冲不足而没有投递成功的次数（数据仍在各自的队列中，下一次投递时一并处理）
+ */
+uint32_t event_module_dropped();
+
+/**
+ * @brief 事件线程函数：派发队列中的事件，永不返回
+ */
+void event_task();
+
+#endif
@@ -0,0 +1,182 @@
+#ifndef FEWSHOT_CLASSIFIER_H
+#define FEWSHOT_CLASSIFIER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#include "edge-impulse-sdk/CMSIS/Core/Include/cmsis_compiler.h"
+#define FEWSHOT_SIMD 1
+#else
+#define FEWSHOT_SIMD 0
+#endif
+
+/**
+ * @brief 两个 int8 向量的平方欧氏距离
+ * 有 DSP 扩展（Cortex-M4F）时每 4 个值一组：SXTB16 把 (0, 2) / (1, 3) 字节符号扩展为两组 q15，SSUB16 相减
+ * （差值在 ±255 以内，不会溢出 16 位），两条 SMLAD 累加平方；否则退化为标量循环，结果逐位相同。
+ * 指针不要求对齐（M4 的 LDR 支持非对齐访问，memcpy 编译为一条 LDR）。
+ * @param n 长度（4 的倍数时全部走 SIMD 路径）
+ */
+static inline uint32_t fewshot_squared_distance(const int8_t* a, const int8_t* b, size_t n) {
+    uint32_t acc = 0;
+    size_t i = 0;
+#if FEWSHOT_SIMD
+    int32_t simd = 0;
+    for (; i + 4 <= n; i += 4) {
+        uint32_t wa, wb;
+        memcpy(&wa, a + i, 4);
+        memcpy(&wb, b + i, 4);
+        const int32_t d02 = (int32_t)__SSUB16(__SXTB16(wa), __SXTB16(wb));
+        const int32_t d13 = (int32_t)__SSUB16(__SXTB16(__ROR(wa, 8)), __SXTB16(__ROR(wb, 8)));
+        simd = __SMLAD(d02, d02, simd);
+        simd = __SMLAD(d13, d13, simd);
+    }
+    acc = (uint32_t)simd;
+#endif
+    for (; i < n; i++) {
+        const int32_t diff = (int32_t)a[i] - (int32_t)b[i];
+        acc += (uint32_t)(diff * diff);
+    }
+    return acc;
+}
+
+/**
+ * @brief 自定义手势的最近中心分类：倒数第二层激活到各类别中心的平方距离，最近且不超过该类别半径时命中
+ * 激活与 NoveltyDetector 相同，直接读流式推理缓存的环形列（逻辑第 j 列位于第 (first_row + j) % Rows 行）；
+ * 行在内存中连续，所以逻辑顺序是 [first_row, Rows) 与 [0, first_row) 两段，各与中心的对应段整段比较。
+ * 中心与半径只保存指针（由 fewshot_module 的 flash 记录提供），半径为 0 的类别未录入、不参与搜索。
+ * @tparam Rows 激活的列数（环形缓存的行数）
+ * @tparam RowLen 每列的通道数
+ */
+template <size_t Rows, size_t RowLen>
+class FewShotClassifier {
+public:
+    static constexpr size_t kDims = Rows * RowLen;
+
+    FewShotClassifier() : centroids_(nullptr), radii_(nullptr), classes_(0), distance_(0), nearest_(-1) {}
+
+    /**
+     * @param centroids 类别中心（classes 个，每个按逻辑列顺序 kDims 个 int8）
+     * @param radii 各类别的半径（平方距离，0 = 未录入）
+     * @param classes 类别个数；0 = 关闭分类
+     */
+    void configure(const int8_t* centroids, const uint32_t* radii, size_t classes) {
+        centroids_ = centroids;
+        radii_ = radii;
+        classes_ = centroids != nullptr && radii != nullptr ? classes : 0;
+        distance_ = 0;
+        nearest_ = -1;
+    }
+
+    /**
+     * @brief 对一次激活做最近中心搜索
+     * @param rows 激活的环形缓存（Rows 行，每行 RowLen 个值）
+     * @param first_row 逻辑第 0 列所在的行
+     * @return 命中的类别；-1 = 没有录入的类别，或到最近中心的距离超过其半径
+     */
+    int classify(const int8_t (*rows)[RowLen], size_t first_row) {
+        const int8_t* ring = &rows[0][0];
+        const size_t head = (first_row % Rows) * RowLen;
+        uint32_t best = UINT32_MAX;
+        int best_class = -1;
+        for (size_t k = 0; k < classes_; k++) {
+            if (radii_[k] == 0) {
+                continue;
+            }
+            const int8_t* centroid = &centroids_[k * kDims];
+            uint32_t d = fewshot_squared_distance(ring + head, centroid, kDims - head);
+            // 前一段已不小于当前最近距离时跳过后一段
+            if (d < best) {
+                d += fewshot_squared_distance(ring, centroid + kDims - head, head);
+            }
+            if (d < best) {
+                best = d;
+                best_class = (int)k;
+            }
+        }
+        distance_ = best;
+        nearest_ = best_class;
+        return best_class >= 0 && best <= radii_[best_class] ? best_class : -1;
+    }
+
+    /**
+     * @brief 最近一次搜索中最近的类别与到它的平方距离（没有录入的类别时为 -1）
+     */
+    int nearest() const { return nearest_; }
+    uint32_t distance() const { return distance_; }
+    uint32_t radius() const { return nearest_ >= 0 ? radii_[nearest_] : 0; }
+
+private:
+    const int8_t* centroids_;
+    const uint32_t* radii_;
+    size_t classes_;
+    uint32_t distance_;
+    int nearest_;
+};
+
+/**
+ * @brief 录入一个自定义类别：累加各窗口的激活，完成时给出取整后的 int8 中心与窗口到中心的平均平方距离
+ * 平均平方距离由累加的和与平方和直接算出（Σ|x - c|² = Σ|x|² - 2 c·Σx + n|c|²），不需要保留各个窗口。
+ */
+template <size_t Rows, size_t RowLen>
+class FewShotEnrollment {
+public:
+    static constexpr size_t kDims = Rows * RowLen;
+
+    FewShotEnrollment() { reset(); }
+
+    void reset() {
+        memset(sum_, 0, sizeof(sum_));
+        square_sum_ = 0;
+        windows_ = 0;
+    }
+
+    /**
+     * @brief 计入一个窗口的激活（布局同 FewShotClassifier::classify）
+     */
+    void add(const int8_t (*rows)[RowLen], size_t first_row) {
+        for (size_t j = 0; j < Rows; j++) {
+            const int8_t* row = rows[(first_row + j) % Rows];
+            int32_t* sum = &sum_[j * RowLen];
+            for (size_t i = 0; i < RowLen; i++) {
+                sum[i] += row[i];
+                square_sum_ += (uint64_t)((int32_t)row[i] * row[i]);
+            }
+        }
+        windows_++;
+    }
+
+    uint32_t windows() const { return windows_; }
+
+    /**
+     * @brief 计算中心（按逻辑列顺序，四舍五入）与各窗口到它的平均平方距离
+     * @return false 还没有计入窗口
+     */
+    bool finish(int8_t* out_centroid, uint32_t* out_spread) const {
+        if (windows_ == 0) {
+            return false;
+        }
+        const int32_t n = (int32_t)windows_;
+        int64_t dot = 0;
+        int64_t norm = 0;
+        for (size_t i = 0; i < kDims; i++) {
+            const int32_t s = sum_[i];
+            const int32_t c = s >= 0 ? (s + n / 2) / n : -((-s + n / 2) / n);
+            out_centroid[i] = (int8_t)c;
+            dot += (int64_t)c * s;
+            norm += (int64_t)c * c;
+        }
+        const int64_t total = (int64_t)square_sum_ - 2 * dot + (int64_t)n * norm;
+        *out_spread = total > 0 ? (uint32_t)(total / n) : 0;
+        return true;
+    }
+
+private:
+    int32_t sum_[kDims];
+    uint64_t square_sum_;
+    uint32_t windows_;
+};
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef FEWSHOT_MODULE_H
+#define FEWSHOT_MODULE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "app_config.h"
+
+// 设备端自定义手势（INFERENCE_FEWSHOT）：主机经 BLE 发出录入命令，推理线程在随后 FEWSHOT_CAPTURE_MS 内把
+// CNN 没有判为 idle 的窗口的倒数第二层激活（model_module_stream_features）累加到该类别；录入几遍后提交，
+// 平均成 int8 中心、由窗口的离散程度定出半径，连同录入时的权重版本写入 flash（见 calib_store）。
+// 分类时每次 CNN 推理旁路做一次最近中心搜索（fewshot_classifier.h），与 softmax 头并行；命中时内置结果按 uncertain 处理。
+// 中心只对录入时的权重有效：权重经 OTA 更换后分类关闭，重新录入时清除其余类别。
+//
+// 命令（start / commit / erase / cancel）在 BLE 线程中调用，只登记请求；录入、提交与 flash 写入都在推理线程中
+// （fewshot_module_apply / fewshot_module_update）完成，分类用的中心表因此只有推理线程读写。
+
+enum fewshot_state_t {
+    FEWSHOT_IDLE = 0,        // 没有进行中的录入
+    FEWSHOT_CAPTURING,       // 正在收集一遍手势的窗口
+    FEWSHOT_ENROLLING,       // 已收集若干遍，等待下一次录入或提交
+};
+
+enum fewshot_error_t {
+    FEWSHOT_OK = 0,
+    FEWSHOT_ERR_CLASS,       // 类别号超出 FEWSHOT_MAX_CLASSES，或与正在录入的类别不同
+    FEWSHOT_ERR_WINDOWS,     // 提交时窗口数不足 FEWSHOT_MIN_WINDOWS
+    FEWSHOT_ERR_FLASH,       // 写入 flash 失败（RAM 中的类别表仍已更新）
+    FEWSHOT_ERR_MODEL,       // 激活形状与 FEWSHOT_COLUMNS x FEWSHOT_CHANNELS 不符
+    FEWSHOT_ERR_STATE,       // 当前状态下不能执行该命令
+};
+
+/**
+ * @brief flash 中的自定义手势记录（推理线程持有的 RAM 副本与之相同）
+ */
+struct fewshot_table_t {
+    uint32_t model_version;                                       // 录入时的权重包版本（内置权重为 0）
+    uint8_t model_slot;                                           // 录入时的模型槽（内置权重为 0xFF）
+    uint8_t reserved[3];
+    uint32_t examples[FEWSHOT_MAX_CLASSES];                       // 各类别录入的遍数（0 = 未录入）
+    uint32_t radii[FEWSHOT_MAX_CLASSES];                          // 各类别的半径（平方距离，0 = 未录入）
+    int8_t centroids[FEWSHOT_MAX_CLASSES][FEWSHOT_COLUMNS * FEWSHOT_CHANNELS];
+};
+
+struct fewshot_status_t {
+    uint8_t state;           // fewshot_state_t
+    uint8_t error;           // 最近一次失败的原因（fewshot_error_t）
+    uint8_t enroll_class;    // 正在录入的类别（没有时为 0xFF）
+    uint8_t class_mask;      // 已录入且可用于分类的类别（第 k 位 = 类别 k）
+    uint16_t examples;       // 本次录入已收集的遍数
+    uint16_t windows;        // 本次录入已收集的窗口数
+    uint32_t matches;        // 自启动以来命中自定义手势的次数
+    int8_t last_class;       // 最近一次命中的类别（还没有命中时为 -1）
+    uint32_t last_distance;  // 最近一次命中的平方距离
+};
+
+/**
+ * @brief 推理线程初始化模型后调用：从 flash 载入类别表并按当前权重配置分类
+ */
+void fewshot_module_begin();
+
+/**
+ * @brief 权重更换后（推理线程）调用：重新核对激活形状与录入时的权重版本
+ */
+void fewshot_module_configure();
+
+/**
+ * @brief 开始一遍录入：随后 FEWSHOT_CAPTURE_MS 内的非 idle 窗口计入 class_index
+ * 录入中途换了类别需先 cancel；重新录入已有类别时从头开始，提交后覆盖原来的中心
+ */
+bool fewshot_module_start(uint8_t class_index);
+
+/**
+ * @brief 提交正在录入的类别：推理线程计算中心与半径并写入 flash
+ */
+bool fewshot_module_commit();
+
+/**
+ * @brief 删除一个类别（0xFF = 全部），并写入 flash
+ */
+bool fewshot_module_erase(uint8_t class_index);
+
+/**
+ * @brief 放弃正在录入的类别（已提交的类别不变）
+ */
+void fewshot_module_cancel();
+
+/**
+ * @brief 推理线程在两次推理之间调用：结束到期的录入，执行提交与删除（写 flash 期间 CPU 暂停数十毫秒）
+ */
+void fewshot_module_apply();
+
+/**
+ * @brief 推理线程在每次 CNN 推理之后调用：录入时累加激活，否则做最近中心搜索
+ * @param features 倒数第二层激活的环形缓存（model_module_stream_features）
+ * @param first_column 逻辑第 0 列所在的行
+ * @param active CNN 没有判为 idle
+ * @return 命中的自定义类别；-1 = 没有命中（idle 窗口与录入期间总是 -1）
+ */
+int fewshot_module_update(const int8_t* features, size_t first_column, bool active);
+
+/**
+ * @brief 最近一次搜索中到最近中心的平方距离与该类别的半径（日志用）
+ */
+uint32_t fewshot_module_distance();
+uint32_t fewshot_module_radius();
+
+/**
+ * @brief 当前状态的副本，任意线程可调用
+ */
+void fewshot_module_get_status(fewshot_status_t* out_status);
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef FIR_DECIMATOR_H
+#define FIR_DECIMATOR_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief 多通道定点 FIR 抗混叠抽取器（流式，逐样本输入）
+ * 滤波器设计与 edge-impulse-sdk/dsp/spectral/fir_filter.hpp 相同（加 Hamming 窗的 sinc 低通，
+ * 单位增益，Q15 系数），但只在需要输出的那一个输入样本上做卷积：每个输入样本只写一次历史，
+ * 每 factor 个输入计算一次 Channels * Taps 次乘加，且不使用动态内存。
+ * @tparam Channels 每帧通道数
+ * @tparam Taps 滤波器抽头数
+ */
+template <size_t Channels, size_t Taps>
+class FirDecimator {
+public:
+    FirDecimator() : factor_(1), phase_(0), write_index_(0) {
+        for (size_t i = 0; i < Taps; i++) {
+            taps_[i] = 0;
+        }
+        taps_[0] = 32767;
+        reset();
+    }
+
+    /**
+     * @brief 设计低通滤波器
+     * @param sample_rate_hz 输入采样率
+     * @param cutoff_hz 截止频率（应低于抽取后采样率的一半）
+     * @param factor 抽取倍数（1 = 只滤波不抽取）
+     */
+    void design(float sample_rate_hz, float cutoff_hz, uint8_t factor) {
+        factor_ = factor < 1 ? 1 : factor;
+
+        float f_taps[Taps];
+        const float sine_scale = 2.0f * (float)M_PI * cutoff_hz / sample_rate_hz;
+        const int offset = Taps / 2;
+        float sum = 0.0f;
+        for (size_t i = 0; i < Taps; i++) {
+            const int n = (int)i - offset;
+            f_taps[i] = n == 0 ? sine_scale : sinf(sine_scale * n) / n;
+            f_taps[i] *= 0.54f - 0.46f * cosf(2.0f * (float)M_PI * i / (Taps - 1));
+            sum += f_taps[i];
+        }
+        for (size_t i = 0; i < Taps; i++) {
+            taps_[i] = (int16_t)lroundf(f_taps[i] / sum * 32767.0f);
+        }
+        reset();
+    }
+
+    void reset() {
+        for (size_t i = 0; i < Taps * Channels; i++) {
+            history_[i] = 0;
+        }
+        phase_ = 0;
+        write_index_ = 0;
+    }
+
+    /**
+     * @brief 输入一帧
+     * @param in 输入帧（Channels 个 int16）
+     * @param out 输出帧（仅在返回 true 时写入）
+     * @return true 本次产生了一个抽取后的输出帧
+     */
+    bool push(const int16_t* in, int16_t* out) {
+        int16_t* slot = &history_[write_index_ * Channels];
+        for (size_t c = 0; c < Channels; c++) {
+            slot[c] = in[c];
+        }
+        const size_t newest = write_index_;
+        write_index_ = (write_index_ + 1) % Taps;
+
+        if (++phase_ < factor_) {
+            return false;
+        }
+        phase_ = 0;
+
+        for (size_t c = 0; c < Channels; c++) {
+            int32_t acc = 1 << 14;  // 四舍五入
+            size_t read_index = newest;
+            for (size_t t = 0; t < Taps; t++) {
+                acc += (int32_t)taps_[t] * history_[read_index * Channels + c];
+                read_index = read_index == 0 ? Taps - 1 : read_index - 1;
+            }
+            acc >>= 15;
+            out[c] = (int16_t)(acc > 32767 ? 32767 : (acc < -32768 ? -32768 : acc));
+        }
+        return true;
+    }
+
+    uint8_t factor() const { return factor_; }
+
+private:
+    int16_t taps_[Taps];
+    int16_t history_[Taps * Channels];
+    uint8_t factor_;
+    uint8_t phase_;
+    size_t write_index_;
+};
+
+#endif
@@ -0,0 +1,130 @@
+#ifndef GESTURE_DETECTOR_H
+#define GESTURE_DETECTOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief 手势事件检测：把逐窗口的分类结果去抖为离散事件
+ * 与 Edge Impulse PerfCal（ei_performance_calibration.h）相同的机制：对最近若干次结果的各类别分数
+ * 取滑动平均，平均分最高的类别达到检测阈值即检出；事件类别（手势）检出后在若干次结果内抑制新的检出。
+ * 非事件类别（idle）只在检出状态改变时上报一次。所有缓冲区在对象内静态分配。
+ * @tparam MaxLabels 类别数上限
+ * @tparam MaxAverage 平均窗口（结果个数）上限
+ */
+template <size_t MaxLabels, size_t MaxAverage>
+class GestureDetector {
+public:
+    static const int kNoEvent = -1;
+
+    GestureDetector()
+        : labels_(0), average_(1), threshold_(1.0f), suppression_(0), event_mask_(0) {
+        reset();
+    }
+
+    /**
+     * @param labels 类别数（不超过 MaxLabels）
+     * @param average_results 参与平均的结果个数（1 = 不平均，超过 MaxAverage 时截断）
+     * @param threshold 平均分的检测阈值（应高于 1 / labels，保证最多一个类别达到）
+     * @param suppression_results 事件检出后抑制的结果个数
+     * @param event_mask 事件类别（位 i 对应类别 i），检出后进入抑制期
+     */
+    void configure(size_t labels, size_t average_results, float threshold, uint32_t suppression_results,
+                   uint32_t event_mask) {
+        labels_ = labels > MaxLabels ? MaxLabels : labels;
+        average_ = average_results < 1 ? 1 : (average_results > MaxAverage ? MaxAverage : average_results);
+        threshold_ = threshold;
+        suppression_ = suppression_results;
+        event_mask_ = event_mask;
+        reset();
+    }
+
+    /**
+     * @brief 清空平均窗口与检出状态（切换模型、重新配置时调用）
+     */
+    void reset() {
+        for (size_t i = 0; i < MaxLabels * MaxAverage; i++) {
+            history_[i] = 0.0f;
+        }
+        for (size_t i = 0; i < MaxLabels; i++) {
+            sum_[i] = 0.0f;
+        }
+        next_ = 0;
+        filled_ = 0;
+        suppress_count_ = suppression_;
+        last_detected_ = kNoEvent;
+        score_ = 0.0f;
+    }
+
+    /**
+     * @brief 加入一次分类结果
+     * @param scores 各类别概率（labels 个）
+     * @return int 本次上报的类别，kNoEvent = 无事件
+     */
+    int update(const float* scores) {
+        float* slot = &history_[next_ * MaxLabels];
+        for (size_t i = 0; i < labels_; i++) {
+            sum_[i] += scores[i] - slot[i];
+            slot[i] = scores[i];
+        }
+        if (++next_ >= average_) {
+            next_ = 0;
+        }
+        if (filled_ < average_) {
+            filled_++;
+        }
+
+        int top = kNoEvent;
+        float top_score = 0.0f;
+        for (size_t i = 0; i < labels_; i++) {
+            const float mean = sum_[i] / filled_;
+            if (mean > top_score) {
+                top_score = mean;
+                top = (int)i;
+            }
+        }
+
+        if (suppress_count_ < suppression_) {
+            suppress_count_++;
+            return kNoEvent;
+        }
+        if (top == kNoEvent || top_score < threshold_) {
+            // 没有类别达到阈值：下一次检出（即使与上次相同）都是新的状态
+            last_detected_ = kNoEvent;
+            return kNoEvent;
+        }
+
+        const bool is_event = (event_mask_ >> top) & 1u;
+        if (!is_event && top == last_detected_) {
+            return kNoEvent;
+        }
+        last_detected_ = top;
+        score_ = top_score;
+        if (is_event) {
+            suppress_count_ = 0;
+        }
+        return top;
+    }
+
+    /**
+     * @brief 最近一次上报时该类别的平均分
+     */
+    float score() const { return score_; }
+
+private:
+    size_t labels_;
+    size_t average_;
+    float threshold_;
+    uint32_t suppression_;
+    uint32_t event_mask_;
+
+    float history_[MaxLabels * MaxAverage];
+    float sum_[MaxLabels];
+    size_t next_;
+    size_t filled_;
+    uint32_t suppress_count_;
+    int last_detected_;
+    float score_;
+};
+
+#endif
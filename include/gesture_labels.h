@@ -0,0 +1,39 @@
+#ifndef GESTURE_LABELS_H
+#define GESTURE_LABELS_H
+
+// 模型类别表：类别下标的枚举与结果消费者（LED / BLE）的查表数据
+// 由 pc_controller/label_table_gen.py 从 ei_classifier_inferencing_categories 生成，不要手工修改；
+// 类别数与部署的模型不一致时 inference_module.cpp 编译失败
+
+#include <stdint.h>
+
+enum gesture_label_t {
+    GESTURE_LABEL_DOWN = 0,
+    GESTURE_LABEL_IDLE = 1,
+    GESTURE_LABEL_LEFT = 2,
+    GESTURE_LABEL_RIGHT = 3,
+    GESTURE_LABEL_UP = 4,
+    GESTURE_LABEL_COUNT = 5
+};
+
+enum gesture_kind_t {
+    GESTURE_KIND_GESTURE = 0,
+    GESTURE_KIND_IDLE,
+    GESTURE_KIND_UNKNOWN
+};
+
+struct gesture_label_info_t {
+    const char* name;
+    gesture_kind_t kind;
+    uint8_t r, g, b;  // LED 颜色（感知亮度 0-255）
+};
+
+static constexpr gesture_label_info_t kGestureLabels[GESTURE_LABEL_COUNT] = {
+    {"down", GESTURE_KIND_GESTURE, 255, 255, 0},
+    {"idle", GESTURE_KIND_IDLE, 255, 0, 0},
+    {"left", GESTURE_KIND_GESTURE, 0, 0, 255},
+    {"right", GESTURE_KIND_GESTURE, 255, 0, 255},
+    {"up", GESTURE_KIND_GESTURE, 0, 255, 0},
+};
+
+#endif
@@ -0,0 +1,173 @@
+#ifndef GESTURE_SEGMENTER_H
+#define GESTURE_SEGMENTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief 一次完整手势的分段结果
+ */
+struct gesture_segment_t {
+    int label;              // 手势类别
+    float peak_confidence;  // 手势期间的最高置信度
+    uint32_t start_ms;      // 第一个候选结果的时间
+    uint32_t end_ms;        // 最后一个仍判定为该手势的结果的时间
+};
+
+/**
+ * @brief 手势分段状态机：把逐窗口的结果归并为“每个物理手势一个事件”
+ * idle → candidate（手势类别达到起始阈值）→ confirmed（连续 confirm 次同一类别，上报 onset）
+ * → refractory（连续 release 次低于释放阈值或超过最长时长，上报 offset）→ idle（不应期结束）。
+ * 起始 / 释放两个阈值构成滞回，手势中途的置信度波动不会把一个手势拆成两个。
+ */
+class GestureSegmenter {
+public:
+    enum State { kIdle, kCandidate, kConfirmed, kRefractory };
+    enum Output { kNone, kOnset, kOffset };
+
+    GestureSegmenter()
+        : gesture_mask_(0), onset_threshold_(1.0f), release_threshold_(1.0f), confirm_results_(1),
+          release_results_(1), refractory_ms_(0), max_duration_ms_(0) {
+        reset();
+    }
+
+    /**
+     * @param gesture_mask 手势类别（位 i 对应类别 i），其余类别（idle）只会结束手势
+     * @param onset_threshold 开始候选 / 确认所需的置信度
+     * @param release_threshold 已确认的手势保持所需的置信度（不高于 onset_threshold）
+     * @param confirm_results 确认手势需要的连续结果数（>= 1）
+     * @param release_results 结束手势需要的连续丢失结果数（>= 1）
+     * @param refractory_ms 手势结束后的不应期
+     * @param max_duration_ms 手势最长时长，超过即强制结束（0 = 不限）
+     */
+    void configure(uint32_t gesture_mask, float onset_threshold, float release_threshold, uint8_t confirm_results,
+                   uint8_t release_results, uint32_t refractory_ms, uint32_t max_duration_ms) {
+        gesture_mask_ = gesture_mask;
+        onset_threshold_ = onset_threshold;
+        release_threshold_ = release_threshold < onset_threshold ? release_threshold : onset_threshold;
+        confirm_results_ = confirm_results < 1 ? 1 : confirm_results;
+        release_results_ = release_results < 1 ? 1 : release_results;
+        refractory_ms_ = refractory_ms;
+        max_duration_ms_ = max_duration_ms;
+        reset();
+    }
+
+    void reset() {
+        state_ = kIdle;
+        hits_ = 0;
+        misses_ = 0;
+        refractory_end_ms_ = 0;
+        segment_.label = -1;
+        segment_.peak_confidence = 0.0f;
+        segment_.start_ms = 0;
+        segment_.end_ms = 0;
+    }
+
+    /**
+     * @brief 加入一次分类结果
+     * @param index 获胜类别（-1 = 无）
+     * @param confidence 获胜类别的置信度
+     * @param timestamp_ms 结果对应的时间（窗口最新样本的时间）
+     * @return Output kOnset = 手势被确认（segment() 为目前为止的分段），kOffset = 手势结束（segment() 完整）
+     */
+    Output update(int index, float confidence, uint32_t timestamp_ms) {
+        switch (state_) {
+            case kRefractory:
+                if ((int32_t)(timestamp_ms - refractory_end_ms_) < 0) {
+                    return kNone;
+                }
+                state_ = kIdle;
+                // 不应期已过：本次结果按 idle 状态处理
+                return update(index, confidence, timestamp_ms);
+
+            case kIdle:
+                if (is_onset(index, confidence)) {
+                    start_candidate(index, confidence, timestamp_ms);
+                    return confirm_if_ready();
+                }
+                return kNone;
+
+            case kCandidate:
+                if (index == segment_.label && confidence >= onset_threshold_) {
+                    extend(confidence, timestamp_ms);
+                    hits_++;
+                    return confirm_if_ready();
+                }
+                if (is_onset(index, confidence)) {
+                    // 候选期间换成了另一个手势：以新类别重新开始
+                    start_candidate(index, confidence, timestamp_ms);
+                    return confirm_if_ready();
+                }
+                state_ = kIdle;
+                return kNone;
+
+            case kConfirmed:
+                if (index == segment_.label && confidence >= release_threshold_) {
+                    extend(confidence, timestamp_ms);
+                    misses_ = 0;
+                } else if (++misses_ >= release_results_) {
+                    return finish(timestamp_ms);
+                }
+                if (max_duration_ms_ > 0 && timestamp_ms - segment_.start_ms >= max_duration_ms_) {
+                    return finish(timestamp_ms);
+                }
+                return kNone;
+        }
+        return kNone;
+    }
+
+    const gesture_segment_t& segment() const { return segment_; }
+    State state() const { return state_; }
+
+private:
+    bool is_onset(int index, float confidence) const {
+        return index >= 0 && ((gesture_mask_ >> index) & 1u) && confidence >= onset_threshold_;
+    }
+
+    void start_candidate(int index, float confidence, uint32_t timestamp_ms) {
+        state_ = kCandidate;
+        hits_ = 1;
+        misses_ = 0;
+        segment_.label = index;
+        segment_.peak_confidence = confidence;
+        segment_.start_ms = timestamp_ms;
+        segment_.end_ms = timestamp_ms;
+    }
+
+    void extend(float confidence, uint32_t timestamp_ms) {
+        if (confidence > segment_.peak_confidence) {
+            segment_.peak_confidence = confidence;
+        }
+        segment_.end_ms = timestamp_ms;
+    }
+
+    Output confirm_if_ready() {
+        if (hits_ < confirm_results_) {
+            return kNone;
+        }
+        state_ = kConfirmed;
+        return kOnset;
+    }
+
+    Output finish(uint32_t timestamp_ms) {
+        state_ = kRefractory;
+        refractory_end_ms_ = timestamp_ms + refractory_ms_;
+        return kOffset;
+    }
+
+    uint32_t gesture_mask_;
+    float onset_threshold_;
+    float release_threshold_;
+    uint8_t confirm_results_;
+    uint8_t release_results_;
+    uint32_t refractory_ms_;
+    uint32_t max_duration_ms_;
+
+    State state_;
+    uint8_t hits_;
+    uint8_t misses_;
+    uint32_t refractory_end_ms_;
+    gesture_segment_t segment_;
+};
+
+#endif
@@ -0,0 +1,250 @@
+#ifndef GRAVITY_FRAME_H
+#define GRAVITY_FRAME_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief 重力坐标系预处理：逐样本估计重力方向，把加速度 / 角速度转到 z 轴竖直向上的坐标系
+ * 扩展卡尔曼滤波与 edge-impulse-sdk/classifier/postprocessing/tinyEKF/tinyekf.hpp 的形式相同
+ * （预测 P = F P F^T + Q，更新 G = P H^T (H P H^T + R)^-1、P = (I - G H) P），
+ * 但 SDK 里的 TinyEKF 固定为 4 状态的目标跟踪模型并在堆上分配矩阵，这里是 3 状态、固定尺寸、无动态内存：
+ * 状态为传感器坐标系下的"上"方向单位向量 u（静止时加速度计读数的方向）。
+ * 预测：u 随陀螺仪角速度 ω 反向转动，du/dt = u × ω，F = I - dt [ω]×；
+ * 更新：观测为归一化的加速度，H = I；观测噪声随 | |a| - 1 g | 增大，挥动时主要依靠陀螺仪。
+ * 输出坐标系是把 u 转到 z 轴的最小旋转：倾斜被消除，航向（没有磁力计时不可观测）保持板子的朝向。
+ */
+class GravityFrame {
+public:
+    /**
+     * @param gyro_noise 陀螺仪噪声密度（rad/s/√Hz）
+     * @param acc_noise 静止时归一化加速度的噪声（无量纲，约等于 g 为单位的噪声）
+     * @param dynamic_gain 观测噪声中 (|a| - 1 g)^2 项的系数：越大，挥动时越少相信加速度计
+     */
+    GravityFrame(float gyro_noise = 0.01f, float acc_noise = 0.05f, float dynamic_gain = 10.0f)
+        : dt_(0.01f), gyro_var_(gyro_noise * gyro_noise), acc_var_(acc_noise * acc_noise),
+          dynamic_gain_(dynamic_gain) {
+        reset();
+    }
+
+    /**
+     * @brief 设置样本间隔（秒）
+     */
+    void set_period(float dt_s) {
+        dt_ = dt_s > 0.0f ? dt_s : dt_;
+    }
+
+    /**
+     * @brief 回到未初始化状态：下一个加速度样本直接作为重力方向
+     */
+    void reset() {
+        u_[0] = 0.0f;
+        u_[1] = 0.0f;
+        u_[2] = 1.0f;
+        for (size_t i = 0; i < 9; i++) {
+            p_[i] = 0.0f;
+            rot_[i] = 0.0f;
+        }
+        rot_[0] = rot_[4] = rot_[8] = 1.0f;
+        initialized_ = false;
+    }
+
+    /**
+     * @brief 输入一个样本：预测后用加速度更新重力方向，并重新计算旋转
+     * @param acc_g 传感器坐标系的加速度（g）
+     * @param gyr_dps 传感器坐标系的角速度（dps）
+     */
+    void update(const float* acc_g, const float* gyr_dps) {
+        const float norm = sqrtf(acc_g[0] * acc_g[0] + acc_g[1] * acc_g[1] + acc_g[2] * acc_g[2]);
+        if (!initialized_) {
+            if (norm < kMinNorm) {
+                return;
+            }
+            for (size_t i = 0; i < 3; i++) {
+                u_[i] = acc_g[i] / norm;
+            }
+            for (size_t i = 0; i < 9; i++) {
+                p_[i] = 0.0f;
+            }
+            p_[0] = p_[4] = p_[8] = acc_var_;
+            initialized_ = true;
+            update_rotation();
+            return;
+        }
+
+        predict(gyr_dps);
+        // 失重（自由落体、抛起）时加速度没有重力方向的信息，只做预测
+        if (norm >= kMinNorm) {
+            correct(acc_g, norm);
+        }
+        normalize();
+        update_rotation();
+    }
+
+    /**
+     * @brief 传感器坐标系的向量转到重力坐标系（可原地转换）
+     */
+    void rotate(const float* in, float* out) const {
+        const float x = in[0], y = in[1], z = in[2];
+        out[0] = rot_[0] * x + rot_[1] * y + rot_[2] * z;
+        out[1] = rot_[3] * x + rot_[4] * y + rot_[5] * z;
+        out[2] = rot_[6] * x + rot_[7] * y + rot_[8] * z;
+    }
+
+    /**
+     * @brief 传感器坐标系下的"上"方向（单位向量）
+     */
+    const float* up() const {
+        return u_;
+    }
+
+    bool initialized() const {
+        return initialized_;
+    }
+
+private:
+    // 低于该模长（g）的加速度不用于更新
+    static constexpr float kMinNorm = 0.2f;
+
+    void predict(const float* gyr_dps) {
+        const float k = dt_ * (float)M_PI / 180.0f;
+        const float wx = gyr_dps[0] * k, wy = gyr_dps[1] * k, wz = gyr_dps[2] * k;
+        // u += dt (u × ω)
+        const float ux = u_[0], uy = u_[1], uz = u_[2];
+        u_[0] = ux + (uy * wz - uz * wy);
+        u_[1] = uy + (uz * wx - ux * wz);
+        u_[2] = uz + (ux * wy - uy * wx);
+
+        // F = I - dt [ω]×
+        const float f[9] = {1.0f, wz, -wy, -wz, 1.0f, wx, wy, -wx, 1.0f};
+        float fp[9];
+        mul3(f, p_, fp);
+        // P = F P F^T + Q；陀螺仪噪声按样本间隔积分成角度方差
+        for (size_t i = 0; i < 3; i++) {
+            for (size_t j = 0; j < 3; j++) {
+                p_[i * 3 + j] = fp[i * 3 + 0] * f[j * 3 + 0] + fp[i * 3 + 1] * f[j * 3 + 1] + fp[i * 3 + 2] * f[j * 3 + 2];
+            }
+        }
+        const float q = gyro_var_ * dt_;
+        p_[0] += q;
+        p_[4] += q;
+        p_[8] += q;
+    }
+
+    void correct(const float* acc_g, float norm) {
+        const float deviation = norm - 1.0f;
+        const float r = acc_var_ + dynamic_gain_ * deviation * deviation;
+        // S = P + R（对称），G = P S^-1
+        float s[9];
+        for (size_t i = 0; i < 9; i++) {
+            s[i] = p_[i];
+        }
+        s[0] += r;
+        s[4] += r;
+        s[8] += r;
+        float s_inv[9];
+        if (!invert_symmetric3(s, s_inv)) {
+            return;
+        }
+        float g[9];
+        mul3(p_, s_inv, g);
+
+        float innovation[3];
+        for (size_t i = 0; i < 3; i++) {
+            innovation[i] = acc_g[i] / norm - u_[i];
+        }
+        for (size_t i = 0; i < 3; i++) {
+            u_[i] += g[i * 3 + 0] * innovation[0] + g[i * 3 + 1] * innovation[1] + g[i * 3 + 2] * innovation[2];
+        }
+
+        // P = (I - G) P，再对称化，抵消舍入误差的累积
+        float gp[9];
+        mul3(g, p_, gp);
+        for (size_t i = 0; i < 9; i++) {
+            p_[i] -= gp[i];
+        }
+        for (size_t i = 0; i < 3; i++) {
+            for (size_t j = i + 1; j < 3; j++) {
+                const float mean = 0.5f * (p_[i * 3 + j] + p_[j * 3 + i]);
+                p_[i * 3 + j] = p_[j * 3 + i] = mean;
+            }
+        }
+    }
+
+    void normalize() {
+        const float norm = sqrtf(u_[0] * u_[0] + u_[1] * u_[1] + u_[2] * u_[2]);
+        if (norm > 0.0f) {
+            for (size_t i = 0; i < 3; i++) {
+                u_[i] /= norm;
+            }
+        }
+    }
+
+    /**
+     * @brief 把 u 转到 (0, 0, 1) 的最小旋转（Rodrigues：v = u × z，R = I + [v]× + [v]×^2 / (1 + c)）
+     */
+    void update_rotation() {
+        const float c = u_[2];
+        if (c < -0.9999f) {
+            // 倒置：绕 x 轴转 180°
+            const float flip[9] = {1.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, -1.0f};
+            for (size_t i = 0; i < 9; i++) {
+                rot_[i] = flip[i];
+            }
+            return;
+        }
+        const float vx = u_[1], vy = -u_[0];
+        const float k = 1.0f / (1.0f + c);
+        rot_[0] = 1.0f - vy * vy * k;
+        rot_[1] = vx * vy * k;
+        rot_[2] = vy;
+        rot_[3] = vx * vy * k;
+        rot_[4] = 1.0f - vx * vx * k;
+        rot_[5] = -vx;
+        rot_[6] = -vy;
+        rot_[7] = vx;
+        rot_[8] = 1.0f - (vx * vx + vy * vy) * k;
+    }
+
+    static void mul3(const float* a, const float* b, float* c) {
+        for (size_t i = 0; i < 3; i++) {
+            for (size_t j = 0; j < 3; j++) {
+                c[i * 3 + j] = a[i * 3 + 0] * b[0 * 3 + j] + a[i * 3 + 1] * b[1 * 3 + j] + a[i * 3 + 2] * b[2 * 3 + j];
+            }
+        }
+    }
+
+    /**
+     * @brief 3x3 对称矩阵求逆（伴随矩阵）
+     * @return false 矩阵奇异
+     */
+    static bool invert_symmetric3(const float* a, float* out) {
+        const float c00 = a[4] * a[8] - a[5] * a[7];
+        const float c01 = a[5] * a[6] - a[3] * a[8];
+        const float c02 = a[3] * a[7] - a[4] * a[6];
+        const float det = a[0] * c00 + a[1] * c01 + a[2] * c02;
+        if (!(fabsf(det) > 1e-12f)) {
+            return false;
+        }
+        const float inv = 1.0f / det;
+        out[0] = c00 * inv;
+        out[1] = out[3] = c01 * inv;
+        out[2] = out[6] = c02 * inv;
+        out[4] = (a[0] * a[8] - a[2] * a[6]) * inv;
+        out[5] = out[7] = (a[2] * a[3] - a[0] * a[5]) * inv;
+        out[8] = (a[0] * a[4] - a[1] * a[3]) * inv;
+        return true;
+    }
+
+    float u_[3];
+    float p_[9];
+    float rot_[9];
+    float dt_;
+    float gyro_var_;
+    float acc_var_;
+    float dynamic_gain_;
+    bool initialized_;
+};
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef H7_LINK_H
+#define H7_LINK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "app_config.h"
+#include "imu_module.h"
+#include "log_module.h"
+
+// Portenta H7 双核分工的共享内存布局（SRAM4，H7_LINK_ADDR）
+// M4 运行 imu_module（BMI270 FIFO 读出、抗混叠抽取、校准、重采样），把输出帧写进单生产者 / 单消费者环形缓冲；
+// M7 运行推理、BLE / USB 传输与 LED，src/portenta/m7_imu.cpp 以 imu_module.h 的接口从环形缓冲取帧，
+// 采集线程及其后的窗口 / 推理路径与单核构建完全相同。每批帧写完后 M4 释放硬件信号量 H7_LINK_HSEM，
+// M7 的 HSEM 中断唤醒采集线程。
+// 缓存：M4 没有数据缓存，M7 的 D-cache 覆盖 SRAM4。每个字段组只由一个核写，并独占 32 字节缓存行：
+// M7 读 M4 写的行之前按地址失效（SCB_InvalidateDCache_by_Addr），写自己的行之后按地址清除
+// （SCB_CleanDCache_by_Addr），因此失效操作不会丢掉 M7 尚未写回的数据。
+// M4 的日志记录（格式串指针 + 参数）经同一块内存转交 M7 的日志线程；格式串在 M4 的 flash 中，M7 可以直接读取。
+
+#define H7_LINK_MAGIC 0x48374C4Bu  // "H7LK"
+#define H7_LINK_CACHE_LINE 32
+#define H7_LINK_AXES_CHARS 48
+
+enum h7_link_state_t {
+    H7_LINK_BOOTING = 0,   // M7 已写好配置，M4 尚未完成 IMU 初始化
+    H7_LINK_READY = 1,     // M4 已完成初始化，轴信息有效，帧开始写入
+    H7_LINK_FAILED = 2,    // M4 上 imu_module_init 失败
+};
+
+struct h7_link_t {
+    // M7 写（启动 M4 之前一次，或请求重新配置时）
+    alignas(H7_LINK_CACHE_LINE) uint32_t magic;
+    float output_hz;
+    uint32_t recover_requests;                  // 递增即请求 M4 调用 imu_module_recover
+    char fusion_axes[H7_LINK_AXES_CHARS];
+
+    // M7 写：消费位置
+    alignas(H7_LINK_CACHE_LINE) uint32_t frame_tail;
+    uint32_t log_tail;
+
+    // M4 写：初始化结果与轴信息
+    alignas(H7_LINK_CACHE_LINE) uint32_t state;
+    uint32_t axis_count;
+    uint8_t axis_channel[IMU_MAX_AXES];
+    float axis_lsb[IMU_MAX_AXES];
+    float channel_lsb[IMU_MAX_AXES];
+
+    // M4 写：生产位置与状态
+    alignas(H7_LINK_CACHE_LINE) uint32_t frame_head;
+    uint32_t frame_overruns;                    // 环形缓冲满时丢弃的帧数
+    uint32_t log_head;
+    uint32_t log_overruns;
+    uint32_t recovers_done;                     // 已处理的 recover_requests
+    uint32_t motion_active;
+    imu_stats_t stats;
+
+    // M4 写：数据
+    alignas(H7_LINK_CACHE_LINE) imu_sample_t frames[H7_LINK_FRAMES][IMU_MAX_AXES];
+    alignas(H7_LINK_CACHE_LINE) log_record_t logs[H7_LINK_LOGS];
+};
+
+static_assert((H7_LINK_FRAMES & (H7_LINK_FRAMES - 1)) == 0, "H7_LINK_FRAMES must be a power of two");
+static_assert((H7_LINK_LOGS & (H7_LINK_LOGS - 1)) == 0, "H7_LINK_LOGS must be a power of two");
+static_assert(sizeof(h7_link_t) <= H7_LINK_BYTES, "h7_link_t does not fit into H7_LINK_BYTES");
+
+inline h7_link_t* h7_link() {
+    return reinterpret_cast<h7_link_t*>(H7_LINK_ADDR);
+}
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef HAL_H
+#define HAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <chrono>
+#include <Arduino.h>
+#include "rtos.h"
+
+#include "imu_module.h"
+
+// 流水线（采集 / 窗口 / 推理 / 发布，inference_module.cpp 及其队列、节拍头文件）使用的平台抽象。
+// 绑定全部在编译期：线程原语与时钟是各平台 rtos.h / Arduino.h 的类型别名与内联转发（Mbed 核心，
+// include/host/ 的 std::thread 替身，include/esp32/ 的 FreeRTOS 替身），IMU 数据源是 CRTP 接口，
+// 热路径上没有虚函数调用，nano33ble 构建生成的代码与直接调用相同。
+// 数据源在链接期选择 imu_module.h 的实现：imu_module.cpp（BMI270）、host/replay_imu.cpp（CSV 文件）、
+// portenta/m7_imu.cpp（M4 共享缓冲）。传输（BLE / USB）与 LED 是结果的消费者，经 inference_wait_result
+// 与快照接口取数，流水线不调用它们。
+
+namespace hal {
+
+// ==================== 线程原语与时钟 ====================
+
+typedef rtos::Mutex Mutex;
+typedef rtos::EventFlags EventFlags;
+// 1 ms 分辨率的单调时钟（周期节拍的截止时间）
+typedef rtos::Kernel::Clock Clock;
+
+// 等待超时取值：一直等待
+static constexpr uint32_t kWaitForever = osWaitForever;
+// EventFlags 等待返回值的错误位
+static constexpr uint32_t kFlagsError = osFlagsError;
+
+/**
+ * @brief 微秒计数（32 位，约 71 分钟回绕，差值按无符号运算）
+ */
+inline uint32_t now_us() {
+    return micros();
+}
+
+/**
+ * @brief 毫秒计数（32 位，约 49 天回绕）
+ */
+inline uint32_t now_ms() {
+    return millis();
+}
+
+inline void yield() {
+    rtos::ThisThread::yield();
+}
+
+inline void sleep_until(Clock::time_point deadline) {
+    rtos::ThisThread::sleep_until(deadline);
+}
+
+// ==================== IMU 数据源 ====================
+
+/**
+ * @brief IMU 数据源接口（CRTP）：Impl 提供同名的 *_impl 成员，调用在编译期解析并内联
+ * 语义见 imu_module.h 中的同名函数。
+ * @tparam Impl 具体数据源
+ */
+template <typename Impl>
+class ImuSource {
+public:
+    bool init(float output_hz, const char* fusion_axes) { return self().init_impl(output_hz, fusion_axes); }
+    size_t axis_count() const { return self().axis_count_impl(); }
+    size_t read_frames(imu_sample_t* out_frames, size_t max_frames) {
+        return self().read_frames_impl(out_frames, max_frames);
+    }
+    float axis_lsb(size_t axis) const { return self().axis_lsb_impl(axis); }
+    uint8_t axis_channel(size_t axis) const { return self().axis_channel_impl(axis); }
+    float channel_lsb(size_t channel) const { return self().channel_lsb_impl(channel); }
+    bool motion_active() const { return self().motion_active_impl(); }
+    void set_low_rate(bool low_rate) { self().set_low_rate_impl(low_rate); }
+    void get_stats(imu_stats_t* out_stats) const { self().get_stats_impl(out_stats); }
+
+private:
+    Impl& self() { return static_cast<Impl&>(*this); }
+    const Impl& self() const { return static_cast<const Impl&>(*this); }
+};
+
+/**
+ * @brief 链接进来的 imu_module.h 实现（无状态，只做转发）
+ */
+class ImuModuleSource : public ImuSource<ImuModuleSource> {
+    friend class ImuSource<ImuModuleSource>;
+
+    bool init_impl(float output_hz, const char* fusion_axes) { return imu_module_init(output_hz, fusion_axes); }
+    size_t axis_count_impl() const { return imu_module_axis_count(); }
+    size_t read_frames_impl(imu_sample_t* out_frames, size_t max_frames) {
+        return imu_module_read_frames(out_frames, max_frames);
+    }
+    float axis_lsb_impl(size_t axis) const { return imu_module_axis_lsb(axis); }
+    uint8_t axis_channel_impl(size_t axis) const { return imu_module_axis_channel(axis); }
+    float channel_lsb_impl(size_t channel) const { return imu_module_channel_lsb(channel); }
+    bool motion_active_impl() const { return imu_module_motion_active(); }
+    void set_low_rate_impl(bool low_rate) { imu_module_set_low_rate(low_rate); }
+    void get_stats_impl(imu_stats_t* out_stats) const { imu_module_get_stats(out_stats); }
+};
+
+// 流水线使用的数据源
+typedef ImuModuleSource Imu;
+
+}  // namespace hal
+
+#endif
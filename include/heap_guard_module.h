@@ -0,0 +1,57 @@
+#ifndef HEAP_GUARD_MODULE_H
+#define HEAP_GUARD_MODULE_H
+
+#include <stdint.h>
+#include "app_config.h"
+
+// 分配检查（调试构建，HEAP_GUARD_ENABLE，见 nano33ble_alloc_check 环境）：链接器把 malloc / calloc / realloc
+// 包装到本模块（-Wl,--wrap），在标记的区段内统计当前线程的分配次数。BLE 发布路径只写预先分配的缓冲，
+// 区段内出现任何分配即断言失败（经 crash_module 记录为 MBED_ASSERT），在开发时就发现堆碎片的来源。
+// HEAP_GUARD_ENABLE 为 0 时所有接口都是空的内联函数，调用点不产生任何代码。
+
+#if HEAP_GUARD_ENABLE
+
+/**
+ * @brief 自检链接器包装是否生效（setup 中调用；未生效时打印警告，之后的区段不再检查）
+ */
+void heap_guard_module_init();
+
+/**
+ * @brief 开始统计调用线程的分配（同一时刻只有一个线程处于区段内，区段不嵌套）
+ */
+void heap_guard_module_begin();
+
+/**
+ * @brief 结束统计
+ * @return 区段内调用线程的分配次数（包装未生效时为 0）
+ */
+uint32_t heap_guard_module_end();
+
+/**
+ * @brief 区段结束时分配次数不为 0 则断言失败（name 出现在崩溃记录中）
+ */
+class HeapGuardScope {
+public:
+    explicit HeapGuardScope(const char* name) : name_(name) { heap_guard_module_begin(); }
+    ~HeapGuardScope();
+    HeapGuardScope(const HeapGuardScope&) = delete;
+    HeapGuardScope& operator=(const HeapGuardScope&) = delete;
+
+private:
+    const char* name_;
+};
+
+#define HEAP_GUARD_CONCAT_(a, b) a##b
+#define HEAP_GUARD_CONCAT(a, b) HEAP_GUARD_CONCAT_(a, b)
+#define HEAP_GUARD_SCOPE(name) HeapGuardScope HEAP_GUARD_CONCAT(heap_guard_scope_, __LINE__)(name)
+
+#else
+
+inline void heap_guard_module_init() {}
+inline void heap_guard_module_begin() {}
+inline uint32_t heap_guard_module_end() { return 0; }
+#define HEAP_GUARD_SCOPE(name) ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "gesture_labels.h"
+#include "inference_module.h"
+
+// HID-over-GATT keyboard / consumer control (BLE_HID_ENABLE): the board pairs
+// with the OS as a keyboard and types the shortcut mapped to each gesture
+// itself, without a host application in the loop. The gesture -> key map is
+// written by the host over the keymap characteristic and kept in flash, along
+// with the bond of the last paired central. Everything here runs on the BLE
+// thread.
+
+#define HID_MAX_LABELS 8
+static_assert(GESTURE_LABEL_COUNT <= HID_MAX_LABELS, "hid_keymap_t holds at most HID_MAX_LABELS gestures");
+
+// Modifier value that turns the usage into an 8-bit consumer-control code
+// (media keys such as 0xCD play / pause, 0xE9 volume up).
+#define HID_MODIFIER_CONSUMER 0xFF
+
+/**
+ * @brief One gesture's key: keyboard modifier bits (bit 0 left Ctrl, 1 Shift,
+ *        2 Alt, 3 GUI) and keyboard usage (0 = no key), or
+ *        HID_MODIFIER_CONSUMER and a consumer usage.
+ */
+struct hid_key_t {
+    uint8_t modifiers;
+    uint8_t usage;
+};
+
+// Flash record (fixed layout, no padding): the key map plus one bond.
+struct hid_settings_t {
+    hid_key_t keys[HID_MAX_LABELS];  // indexed by model label
+    uint8_t bond_address[6];         // central that paired last
+    uint8_t bond_valid;
+    uint8_t reserved;
+    uint8_t bond_ltk[16];
+};
+
+/**
+ * @brief Load the key map and bond from flash (defaults when none is stored),
+ *        add the HID and Device Information services and advertise as a keyboard.
+ *        Called from ble_module_init(), before BLE.advertise().
+ */
+void hid_module_begin();
+
+/**
+ * @brief Current key of every model label.
+ */
+void hid_module_get_keymap(hid_key_t* out_keys, uint8_t count);
+
+/**
+ * @brief Replace the key map; written to flash only when it differs from the stored one.
+ * @return false when the flash write failed (the new map is still in use)
+ */
+bool hid_module_set_keymap(const hid_key_t* keys, uint8_t count);
+
+/**
+ * @brief Type the key mapped to a published result (press and release),
+ *        when the OS has subscribed to the input reports. A result within
+ *        BLE_HID_COOLDOWN_MS of the last typed key is skipped.
+ */
+void hid_module_send(const inference_result_snapshot_t& result);
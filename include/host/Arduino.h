@@ -0,0 +1,47 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// 主机离线回放构建用的 Arduino API 子集（只覆盖 inference_module / model_module 与
+// Edge Impulse Arduino 移植层用到的部分）；Serial 输出写到 stderr，stdout 留给回放结果
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <type_traits>
+
+uint32_t micros();
+uint32_t millis();
+void delay(uint32_t ms);
+
+class HostSerial {
+public:
+    void begin(unsigned long) {}
+    explicit operator bool() const { return true; }
+    int available() { return 0; }
+    int read() { return -1; }
+    void flush() { fflush(stderr); }
+
+    size_t write(uint8_t c) { return fputc(c, stderr) == EOF ? 0 : 1; }
+    size_t write(const char* s) { return fputs(s, stderr) == EOF ? 0 : strlen(s); }
+    size_t write(const uint8_t* data, size_t n) { return fwrite(data, 1, n, stderr); }
+
+    size_t print(const char* s) { return write(s); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(double value, int digits = 2) { return (size_t)fprintf(stderr, "%.*f", digits, value); }
+    template <typename T, typename = typename std::enable_if<std::is_integral<T>::value>::type>
+    size_t print(T value) {
+        return std::is_signed<T>::value ? (size_t)fprintf(stderr, "%lld", (long long)value)
+                                        : (size_t)fprintf(stderr, "%llu", (unsigned long long)value);
+    }
+
+    size_t println() { return write("\n"); }
+    template <typename T>
+    size_t println(T value) { return print(value) + println(); }
+    size_t println(double value, int digits) { return print(value, digits) + println(); }
+};
+
+extern HostSerial Serial;
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef BATCH_CLASSIFIER_H
+#define BATCH_CLASSIFIER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 主机构建的批量分类：一次调用对 N 个窗口运行部署的 impulse（run_classifier：DSP + 编译模型），
+// 窗口分给 CPU 的所有核心（src/host/batch_classifier.cpp 实现，只用于主机构建）。
+//
+// 编译模型（EON）把张量与图状态放在静态存储中，每个进程只有一份，不能在线程间并发调用；
+// 因此工作单元是 fork 出来的进程（与 replay_runner.py 并行回放相同的取舍）：每个进程有自己的图，
+// 窗口与结果放在共享内存中，各进程按原子计数器成块领取窗口，调用进程自己也参与。
+// DSP 的 numpy 内核在 x86 上用 SSE2 / AVX2（edge-impulse-sdk/dsp/ei_simd.h），模型内核由编译器按 -O3 向量化。
+//
+// 须在进程创建任何线程之前 init（fork 只复制调用线程）。
+
+// 一次共享的窗口容量：更多窗口分几轮完成
+#define BATCH_CLASSIFIER_MAX_WINDOWS 4096
+// 每次领取的窗口数：小模型单窗口只需几十 µs，逐个领取时原子操作的争用会抵消并行
+#define BATCH_CLASSIFIER_CHUNK 32
+#define BATCH_CLASSIFIER_MAX_LABELS 16
+
+/**
+ * @brief 一个窗口的分类结果
+ */
+struct batch_classifier_result_t {
+    int16_t index;                                 // 最高分类别（-1 = 分类失败）
+    float confidence;
+    float scores[BATCH_CLASSIFIER_MAX_LABELS];     // 按类别序号
+};
+
+/**
+ * @brief 一次批量调用的统计
+ */
+struct batch_classifier_stats_t {
+    uint32_t windows;
+    uint32_t workers;        // 参与的进程数（含调用者）
+    uint64_t wall_us;        // 调用耗时
+    uint64_t busy_us;        // 各进程分类耗时之和（除以 wall_us 与 workers 之积即并行效率）
+    float windows_per_s;
+};
+
+/**
+ * @brief 创建工作进程
+ * @param workers 参与的进程数（含调用者），0 = CPU 核心数
+ * @return true 成功（fork 或共享内存失败时为 false，此时不应调用 run）
+ */
+bool batch_classifier_init(size_t workers);
+
+/**
+ * @brief 每个窗口的值数（impulse 的 dsp_input_frame_size：按帧交错的原始样本）
+ */
+size_t batch_classifier_window_values();
+
+/**
+ * @brief 每帧的值数（impulse 的轴数）
+ */
+size_t batch_classifier_frame_values();
+
+/**
+ * @brief 类别数
+ */
+size_t batch_classifier_label_count();
+
+/**
+ * @brief 类别名称
+ */
+const char* batch_classifier_label(size_t index);
+
+/**
+ * @brief 对 count 个窗口分类
+ * @param windows count 个连续的窗口，每个 batch_classifier_window_values() 个值（impulse 的输入单位）
+ * @param results 输出 count 个结果
+ * @param stats 输出统计（可为 nullptr）
+ * @return true 全部分类成功
+ */
+bool batch_classifier_run(const float* windows, size_t count, batch_classifier_result_t* results,
+                          batch_classifier_stats_t* stats);
+
+/**
+ * @brief 结束工作进程
+ */
+void batch_classifier_shutdown();
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef REPLAY_SOURCE_H
+#define REPLAY_SOURCE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 主机离线回放的 IMU 数据源：以 imu_module.h 的接口向采集线程提供录制文件中的样本
+// （src/host/replay_imu.cpp 实现，替代设备上的 imu_module.cpp）
+
+/**
+ * @brief 载入一段录制（raw_recorder.py 导出的 CSV：毫秒时间戳 + 每轴一列，单位 g / dps；
+ * 或会话语料中的一个会话 "语料#序号"，见 session_corpus.h，样本直接从只读映射中读取）
+ * 须在 inference_module_init（内部调用 imu_module_init）之前调用。
+ * @return true 载入成功
+ * @return false 文件无法打开或缺少模型需要的轴
+ */
+bool replay_source_open(const char* path);
+
+/**
+ * @brief 代替录制载入一段模拟的 IMU 数据（6 轴，静止与周期性的挥动交替，固定种子，每次相同）
+ * 用于不依赖数据集的吞吐 / 压力测试；与 replay_source_open 一样须在 inference_module_init 之前调用。
+ * @param seconds 时长
+ * @param sensor_hz 模拟的传感器采样率（按设备的抽取倍数抽取后重采样到模型采样率）
+ * @param seed 噪声种子
+ * @return true 载入成功（时长或采样率无效时为 false）
+ */
+bool replay_source_simulate(float seconds, float sensor_hz, uint32_t seed);
+
+/**
+ * @brief 回放速度：speed 倍实时按时间戳交出样本（10 = 十倍实时），0 = 不按节奏、以最快速度跑完（默认）
+ * 在采集线程启动之前设置。
+ */
+void replay_source_set_speed(float speed);
+
+/**
+ * @brief 录制中的所有样本是否都已交给采集线程并写入样本队列
+ */
+bool replay_source_finished();
+
+/**
+ * @brief 回放统计
+ * @param out_sensor_frames 读入的原始帧数
+ * @param out_output_frames 重采样后输出的帧数
+ * @param out_process_us 抗混叠抽取与重采样的累计耗时
+ */
+void replay_source_get_stats(uint32_t* out_sensor_frames, uint32_t* out_output_frames, uint32_t* out_process_us);
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef HOST_RTOS_H
+#define HOST_RTOS_H
+
+// 主机离线回放构建用的 Mbed rtos 子集（std::thread 同步原语实现）
+// ThisThread::sleep_for / sleep_until 只让出 CPU：回放按最快速度运行，不按实时节奏
+
+#include <stdint.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <pthread.h>
+#include <thread>
+
+#define osWaitForever       0xFFFFFFFFU
+#define osFlagsError        0x80000000U
+#define osFlagsErrorTimeout 0xFFFFFFFEU
+
+namespace rtos {
+
+namespace Kernel {
+
+// 与 Mbed 的 Kernel::Clock 一样是 1 ms 分辨率的单调时钟
+struct Clock {
+    typedef std::chrono::milliseconds duration;
+    typedef duration::rep rep;
+    typedef duration::period period;
+    typedef std::chrono::time_point<Clock> time_point;
+    static constexpr bool is_steady = true;
+
+    static time_point now() {
+        return time_point(std::chrono::duration_cast<duration>(std::chrono::steady_clock::now().time_since_epoch()));
+    }
+};
+
+}  // namespace Kernel
+
+// 与 Mbed 的 Mutex 相同：可重入并带优先级继承（osMutexRecursive | osMutexPrioInherit），
+// 线程按实时优先级运行时（test_priority_inversion）主机上的阻塞行为与目标一致
+class Mutex {
+public:
+    Mutex() {
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+        pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT);
+        pthread_mutex_init(&mutex_, &attr);
+        pthread_mutexattr_destroy(&attr);
+    }
+    ~Mutex() { pthread_mutex_destroy(&mutex_); }
+    Mutex(const Mutex&) = delete;
+    Mutex& operator=(const Mutex&) = delete;
+
+    void lock() { pthread_mutex_lock(&mutex_); }
+    bool trylock() { return pthread_mutex_trylock(&mutex_) == 0; }
+    void unlock() { pthread_mutex_unlock(&mutex_); }
+
+private:
+    pthread_mutex_t mutex_;
+};
+
+class EventFlags {
+public:
+    EventFlags() : flags_(0) {}
+
+    uint32_t set(uint32_t flags) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        flags_ |= flags;
+        cv_.notify_all();
+        return flags_;
+    }
+
+    uint32_t clear(uint32_t flags = 0x7FFFFFFFU) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const uint32_t previous = flags_;
+        flags_ &= ~flags;
+        return previous;
+    }
+
+    uint32_t get() const { return flags_; }
+
+    template <typename Rep, typename Period>
+    uint32_t wait_any_for(uint32_t flags, std::chrono::duration<Rep, Period> timeout, bool clear = true) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!cv_.wait_for(lock, timeout, [&] { return (flags_ & flags) != 0; })) {
+            return osFlagsErrorTimeout;
+        }
+        const uint32_t matched = flags_;
+        if (clear) {
+            flags_ &= ~flags;
+        }
+        return matched;
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    uint32_t flags_;
+};
+
+namespace ThisThread {
+
+template <typename Rep, typename Period>
+inline void sleep_for(std::chrono::duration<Rep, Period>) {
+    std::this_thread::yield();
+}
+
+inline void sleep_until(Kernel::Clock::time_point) {
+    std::this_thread::yield();
+}
+
+inline void yield() {
+    std::this_thread::yield();
+}
+
+}  // namespace ThisThread
+
+}  // namespace rtos
+
+#endif
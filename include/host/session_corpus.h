@@ -0,0 +1,97 @@
+#ifndef SESSION_CORPUS_H
+#define SESSION_CORPUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 主机回放 / 扫描 / 等价性工具共用的会话语料：成千上万段录制打包成一个文件，只读映射（mmap）后按会话直接取列，
+// 不解析文本、不复制样本（src/host/session_corpus.cpp 实现；pc_controller/session_corpus.py 负责转换与 Python 侧读取）。
+//
+// 文件布局（小端）：
+//   头部 session_corpus_header_t（32 字节）
+//   会话索引：session_count 项，每项 session_bytes 字节（session_corpus_session_t）
+//   各会话的数据块，起始 64 字节对齐，按列存放：
+//     frames 个 uint32 时间戳（µs，相对会话第一帧）
+//     随后 channel_mask 中每个通道（按通道号升序）frames 个 int16 样本
+//   标签表：label_count 个 uint32，字符串表中的偏移
+//   字符串表：NUL 结尾的 UTF-8 字符串（标签名与会话来源名）
+// 标签表与字符串表的位置由头部给出（转换工具边转换边写数据块，最后写在文件末尾）。
+// 样本是传感器 LSB，量程与原始录制相同（±4 g / ±2000 dps，见 record_format.h 与 imu_module_channel_lsb），
+// 因此设备录制无损转换；Edge Impulse 的 g / dps 数据按同一量程量化。
+
+#define SESSION_CORPUS_MAGIC          "GCORPUS"
+#define SESSION_CORPUS_VERSION        1
+#define SESSION_CORPUS_CHANNELS       6
+#define SESSION_CORPUS_ALIGN          64
+
+struct session_corpus_header_t {
+    char magic[8];              // SESSION_CORPUS_MAGIC，NUL 补齐
+    uint16_t version;
+    uint16_t session_bytes;     // 每个索引项的字节数（读者按它跨过索引项，新版本只在末尾追加字段）
+    uint32_t session_count;
+    uint32_t label_count;
+    uint32_t labels_offset;
+    uint32_t strings_offset;
+    uint32_t strings_bytes;
+};
+
+struct session_corpus_session_t {
+    uint64_t data_offset;       // 数据块在文件中的偏移
+    uint32_t frames;
+    uint32_t name_offset;       // 来源名（原文件名）在字符串表中的偏移
+    uint16_t label;             // 标签表序号
+    uint8_t channel_mask;       // 位 c = 通道 c（accX accY accZ gyrX gyrY gyrZ，与 record_format.h 相同）
+    uint8_t reserved[5];
+};
+
+static_assert(sizeof(session_corpus_header_t) == 32, "corpus header layout");
+static_assert(sizeof(session_corpus_session_t) == 24, "corpus index layout");
+
+/**
+ * @brief 一个映射中的语料
+ */
+struct session_corpus_t {
+    const uint8_t* base;
+    size_t bytes;
+};
+
+/**
+ * @brief 一个会话的零复制视图（指针指向映射，语料关闭前有效）
+ */
+struct session_corpus_view_t {
+    uint32_t frames;
+    uint8_t channel_mask;
+    const char* name;
+    const char* label;
+    const uint32_t* timestamps_us;
+    const int16_t* columns[SESSION_CORPUS_CHANNELS];   // 缺失的通道为 nullptr
+};
+
+/**
+ * @brief 只读映射语料文件并校验头部、索引与每个会话的范围（之后按会话读取不再检查）
+ * @return false 文件无法打开、不是语料或已损坏
+ */
+bool session_corpus_open(const char* path, session_corpus_t* out);
+
+void session_corpus_close(session_corpus_t* corpus);
+
+/**
+ * @brief 文件开头是否为语料的魔数（用于区分语料与 CSV 录制）
+ */
+bool session_corpus_is_corpus(const char* path);
+
+uint32_t session_corpus_count(const session_corpus_t* corpus);
+
+/**
+ * @return false 序号超出范围
+ */
+bool session_corpus_session(const session_corpus_t* corpus, uint32_t index, session_corpus_view_t* out);
+
+/**
+ * @brief 拆分回放路径 "corpus.gcorpus#12"：'#' 之后为会话序号
+ * @param path_out 路径部分（容量 path_size）
+ * @return false 没有 '#'、序号无效或路径放不下
+ */
+bool session_corpus_parse_spec(const char* spec, char* path_out, size_t path_size, uint32_t* out_index);
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef IDLE_PREFILTER_H
+#define IDLE_PREFILTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief 级联分类的第一级：窗口内各轴方差都低于阈值时判定为“确定的 idle”，跳过 CNN
+ * 只统计一遍窗口的和与平方和，代价远小于一次推理；阈值用
+ * pc_controller/idle_prefilter_tuner.py 在录制的数据集上标定（与这里的判定公式一致）。
+ */
+class IdlePrefilter {
+public:
+    IdlePrefilter() : max_variance_(0.0f), evaluated_(0), skipped_(0) {}
+
+    /**
+     * @param max_std 各轴标准差上限（与窗口数据同一物理单位，加速度为 g）；<= 0 即关闭预筛
+     */
+    void configure(float max_std) {
+        max_variance_ = max_std > 0.0f ? max_std * max_std : 0.0f;
+    }
+
+    /**
+     * @brief 判定一个窗口是否为确定的 idle，并计入统计
+     * @param window 按帧交错存放的窗口（顺序无关，环形窗口可直接传入）
+     * @param length 窗口值的个数（axes 的整数倍）
+     * @param axes 每帧的轴数（不超过 kMaxAxes）
+     * @param scale 窗口值到物理单位的比例（int8 量化窗口传入输入 scale，浮点窗口传 1）
+     * @return true 判定为 idle，可跳过 CNN
+     */
+    template <typename T>
+    bool check(const T* window, size_t length, size_t axes, float scale) {
+        evaluated_++;
+        if (max_variance_ <= 0.0f || axes == 0 || axes > kMaxAxes || length < 2 * axes) {
+            return false;
+        }
+
+        float sum[kMaxAxes] = {0};
+        float sum_sq[kMaxAxes] = {0};
+        for (size_t i = 0; i < length; i += axes) {
+            for (size_t a = 0; a < axes; a++) {
+                const float v = (float)window[i + a];
+                sum[a] += v;
+                sum_sq[a] += v * v;
+            }
+        }
+
+        const float frames = (float)(length / axes);
+        const float limit = max_variance_ / (scale * scale);
+        for (size_t a = 0; a < axes; a++) {
+            const float mean = sum[a] / frames;
+            const float variance = sum_sq[a] / frames - mean * mean;
+            if (variance > limit) {
+                return false;
+            }
+        }
+
+        skipped_++;
+        return true;
+    }
+
+    /**
+     * @brief 同样的判定，但各轴方差已由调用者增量维护（例如逐窗口标准化的统计量），不再遍历窗口
+     * @param variances 各轴方差（物理单位的平方）
+     */
+    bool check_variances(const float* variances, size_t axes) {
+        evaluated_++;
+        if (max_variance_ <= 0.0f || axes == 0) {
+            return false;
+        }
+        for (size_t a = 0; a < axes; a++) {
+            if (variances[a] > max_variance_) {
+                return false;
+            }
+        }
+        skipped_++;
+        return true;
+    }
+
+    uint32_t evaluated() const { return evaluated_; }
+    uint32_t skipped() const { return skipped_; }
+
+    static const size_t kMaxAxes = 6;
+
+private:
+    float max_variance_;
+    uint32_t evaluated_;
+    uint32_t skipped_;
+};
+
+#endif
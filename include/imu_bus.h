@@ -0,0 +1,63 @@
+#ifndef IMU_BUS_H
+#define IMU_BUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// IMU 内部 I2C 总线访问接口
+// IMU_BUS_USE_DMA = 1 且 mbed 目标支持 I2C_ASYNCH 时，传输由 TWIM EasyDMA 完成，
+// 调用线程在完成回调上休眠，总线等待期间 CPU 可以运行其他线程；否则回退到 Wire1 阻塞传输。
+
+/**
+ * @brief 总线统计快照
+ */
+struct imu_bus_stats_t {
+    uint32_t transfers;  // 完成的传输次数
+    uint32_t bytes;      // 读取的字节数
+    uint32_t errors;     // 失败或超时的传输次数
+    uint32_t busy_us;    // 传输累计耗时（微秒）
+};
+
+/**
+ * @brief 接管 IMU 总线并切换到 IMU_I2C_CLOCK_HZ（须在 IMU.begin() 之后调用）
+ * @param address 7 位 I2C 地址
+ * @return true 初始化成功
+ * @return false 初始化失败
+ */
+bool imu_bus_init(uint8_t address);
+
+/**
+ * @brief 连续写多个寄存器（从 reg 开始自动递增）
+ */
+bool imu_bus_write(uint8_t reg, const uint8_t* data, size_t len);
+
+/**
+ * @brief 写单个寄存器
+ */
+bool imu_bus_write_reg(uint8_t reg, uint8_t value);
+
+/**
+ * @brief 从 reg 开始突发读取 len 字节
+ * @return size_t 实际读取的字节数（失败时为 0）
+ */
+size_t imu_bus_read(uint8_t reg, uint8_t* buffer, size_t len);
+
+/**
+ * @brief 写同一总线上另一器件的单个寄存器（如 BMI270 辅助的 BMM150）
+ * @param address 7 位 I2C 地址
+ */
+bool imu_bus_write_reg_at(uint8_t address, uint8_t reg, uint8_t value);
+
+/**
+ * @brief 从同一总线上另一器件的 reg 开始突发读取 len 字节
+ * @param address 7 位 I2C 地址
+ * @return size_t 实际读取的字节数（失败时为 0）
+ */
+size_t imu_bus_read_at(uint8_t address, uint8_t reg, uint8_t* buffer, size_t len);
+
+/**
+ * @brief 获取总线统计
+ */
+void imu_bus_get_stats(imu_bus_stats_t* out_stats);
+
+#endif
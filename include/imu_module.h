@@ -0,0 +1,147 @@
+#ifndef IMU_MODULE_H
+#define IMU_MODULE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "app_config.h"
+
+// IMU 采集模块对外接口
+
+// BMI270 最多提供 6 个轴（加速度 X/Y/Z + 陀螺仪 X/Y/Z）
+#define IMU_MAX_AXES 6
+// BMM150 磁力计 3 个轴（板坐标系通道 6..8，只在融合轴需要时采样，低速样本按时间戳插值到输出帧）
+#define IMU_MAG_AXES 3
+// 每个输出帧最多的值个数（输出缓冲按此分配）
+#define IMU_MAX_FUSION_AXES (IMU_MAX_AXES + IMU_MAG_AXES)
+
+// 输出样本类型：INFERENCE_Q15_FEATURES 时为校准后的传感器 LSB（int16），否则为 g / dps
+#if INFERENCE_Q15_FEATURES
+typedef int16_t imu_sample_t;
+#else
+typedef float imu_sample_t;
+#endif
+
+/**
+ * @brief 采集统计快照
+ */
+struct imu_stats_t {
+    uint32_t wakeups;        // 采集线程被唤醒（中断、定时器或超时）的次数
+    uint32_t sensor_frames;  // 从传感器读出的原始帧数
+    uint32_t output_frames;  // 重采样后交给调用者的帧数
+    float sensor_hz;         // 上一个统计窗口内实测的传感器 ODR
+    float output_hz;         // 上一个统计窗口内实际输出的采样率
+    float drift_ppm;         // 输出采样率相对目标采样率的偏差（ppm）
+    uint32_t motion_events;  // 从静止转为运动的次数
+    uint32_t process_us;     // FIFO 帧解析、抗混叠抽取、重采样的累计耗时（不含总线传输）
+    uint32_t recoveries;     // 读不到数据后重新配置传感器的次数
+    uint32_t longest_outage_ms;  // 最长一次读不到数据的时间（从第一次失败的唤醒到重新读出帧）
+    uint32_t mag_samples;    // 读出的有效磁力计样本数（未启用磁力计时为 0）
+    uint32_t rate_switches;  // 在满速与空闲低速（IMU_IDLE_ODR_HZ）之间切换 ODR 的次数
+};
+
+/**
+ * @brief 原始帧回调（在采集线程中调用，必须尽快返回）
+ * @param frame 板坐标系下的原始 int16 样本（加速度 X/Y/Z，开启陀螺仪时随后为陀螺仪 X/Y/Z）
+ * @param channel_mask frame 中包含的通道（位 i 对应板坐标系通道 i）
+ * @param timestamp_us 该帧的采样时间（FIFO 模式下按读出时刻与实测 ODR 反推）
+ */
+typedef void (*imu_raw_sink_t)(const int16_t* frame, uint8_t channel_mask, uint32_t timestamp_us);
+
+/**
+ * @brief 回放数据源（在采集线程中调用，不得阻塞）
+ * @param out_frames 输出板坐标系原始 int16 帧，每帧 IMU_MAX_AXES 个值（加速度 X/Y/Z + 陀螺仪 X/Y/Z，
+ *                   与原始帧回调的格式相同，缺失的通道为 0），采样率须为 IMU_SENSOR_ODR_HZ
+ * @param max_frames 最多读取的帧数
+ * @return size_t 实际读取的帧数（0 = 暂时没有数据）
+ */
+typedef size_t (*imu_replay_source_t)(int16_t* out_frames, size_t max_frames);
+
+/**
+ * @brief 初始化 BMI270，配置 ODR，并按 IMU_USE_FIFO 配置 FIFO、水位中断
+ * 只有融合轴中包含陀螺仪轴时才开启陀螺仪数据通路；只有包含磁力计轴时才唤醒 BMM150 并以 IMU_MAG_ODR_HZ 采样，
+ * 否则把它置于挂起模式（不产生任何磁力计总线传输）。
+ * @param output_hz 调用者需要的采样率（通常为 EI_CLASSIFIER_FREQUENCY）
+ * @param fusion_axes 融合轴字符串（通常为 EI_CLASSIFIER_FUSION_AXES_STRING），
+ *                    支持 accx/accy/accz/gyrx/gyry/gyrz/magx/magy/magz，以 '+' 分隔
+ * @return true 初始化成功
+ * @return false 初始化失败
+ */
+bool imu_module_init(float output_hz, const char* fusion_axes);
+
+/**
+ * @brief 融合轴数量（即每帧输出的值个数）
+ */
+size_t imu_module_axis_count();
+
+/**
+ * @brief 读取按 output_hz 重采样后的帧（阻塞，直到至少有一帧可用）
+ * FIFO 模式下线程在水位中断上休眠，被唤醒后一次突发读出 FIFO 中的全部帧。
+ * @param out_frames 输出缓冲区，每帧按融合轴顺序交错存放；浮点样本加速度单位 g，陀螺仪单位 dps，
+ *                   磁力计单位 µT（回放时为 0），int16 样本单位见 imu_module_axis_lsb
+ * @param max_frames 最多读取的帧数（out_frames 至少 imu_module_axis_count() * max_frames 个样本）
+ * @return size_t 实际读取的帧数
+ */
+size_t imu_module_read_frames(imu_sample_t* out_frames, size_t max_frames);
+
+/**
+ * @brief 第 axis 个融合轴每单位物理量（g、dps 或 µT）对应的样本值（浮点样本为 1）
+ */
+float imu_module_axis_lsb(size_t axis);
+
+/**
+ * @brief 第 axis 个融合轴取自的板坐标系通道（0..2 加速度 X/Y/Z，3..5 陀螺仪 X/Y/Z，6..8 磁力计 X/Y/Z；
+ * 越界返回 0xFF）
+ */
+uint8_t imu_module_axis_channel(size_t axis);
+
+/**
+ * @brief 板坐标系通道 channel 的传感器 LSB：每单位物理量（g、dps 或 µT）对应的原始值，与样本类型无关
+ */
+float imu_module_channel_lsb(size_t channel);
+
+/**
+ * @brief 当前是否处于运动状态（BMI270 any-motion / no-motion 判定）
+ * 未启用 MOTION_GATE_ENABLE、处于轮询模式或正在回放时始终返回 true
+ */
+bool imu_module_motion_active();
+
+/**
+ * @brief 设置原始帧回调（传入 nullptr 取消），用于以传感器 ODR 录制未经抽取、未校准的数据
+ * 设置后采集线程在下一次唤醒时生效，并临时打开陀螺仪 FIFO 通道，保证录制的是完整 6 轴数据。
+ * @param sink 回调函数
+ */
+void imu_module_set_raw_sink(imu_raw_sink_t sink);
+
+/**
+ * @brief 设置回放数据源（传入 nullptr 恢复传感器），用于在板上回放录制的会话
+ * 设置后采集线程在下一次唤醒时生效：每个 FIFO 水位周期从数据源取一批帧，代替 FIFO 读出，
+ * 之后的抽取、校准转换、重采样以及采集 / 推理线程与实时采集完全相同。
+ * 开始与结束时抽取与重采样状态复位，结束时清空回放期间 FIFO 中积压的帧。
+ * @return false 轮询模式（IMU_USE_FIFO = 0）不支持回放
+ */
+bool imu_module_set_replay_source(imu_replay_source_t source);
+
+/**
+ * @brief 请求空闲低速采集（true）或满速采集（false），由推理线程随步长策略调用
+ * 采集线程在下一次读空 FIFO 后把 ODR 与 FIFO 水位切换到 IMU_IDLE_ODR_HZ / IMU_IDLE_FIFO_WATERMARK_FRAMES
+ * （或恢复满速）；输出采样率与抽取、重采样状态不变。IMU_IDLE_ODR_HZ 为 0、轮询模式、录制原始帧期间
+ * 保持满速。
+ */
+void imu_module_set_low_rate(bool low_rate);
+
+/**
+ * @brief 重新配置传感器（ODR、FIFO、运动检测），清空待输出的帧与滤波器状态
+ * 采集线程连续 IMU_RECOVERY_WAKEUPS 次唤醒读不到数据时自行调用；监督者在采集线程卡死、
+ * 终止后重启前调用（不得与采集线程并发调用）。不重新加载 BMI270 的特性配置，传感器掉电时无效。
+ * @return bool 配置写入成功
+ */
+bool imu_module_recover();
+
+/**
+ * @brief 获取采集统计
+ * @param out_stats 输出统计快照
+ */
+void imu_module_get_stats(imu_stats_t* out_stats);
+
+#endif
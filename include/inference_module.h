@@ -2,8 +2,12 @@
 #define INFERENCE_MODULE_H
 
 #include <stdint.h>
+#include <chrono>
 
-#include "rtos.h"
+#include "gesture_labels.h"
+#include "hal.h"
+#include "imu_module.h"
+#include "sample_timing.h"
 
 // 推理模块对外接口
 
@@ -14,12 +18,357 @@
  */
 bool inference_module_init();
 
+/**
+ * @brief IMU 采集任务函数（在独立的高优先级线程中运行）
+ * 持续读取 IMU 帧并写入无锁样本队列，与推理互不阻塞
+ */
+void inference_sampler_task();
+
 /**
  * @brief AI推理任务函数（在独立线程中运行）
- * 持续采集IMU数据，运行分类器，并更新预测结果
+ * 从样本队列取出新数据，运行分类器，并更新预测结果
  */
 void inference_task();
 
+/**
+ * @brief 获取样本队列统计
+ * @param out_overruns 输出队列满导致丢弃的帧数
+ * @param out_high_water 输出队列历史最高占用（float 个数）
+ */
+void inference_get_sampler_stats(uint32_t* out_overruns, uint32_t* out_high_water);
+
+/**
+ * @brief 获取上一个统计窗口的采样间隔 / 抖动统计
+ * @param out_stats 输出统计快照
+ */
+void inference_get_sample_timing(sample_timing_stats_t* out_stats);
+
+/**
+ * @brief 推理调度统计（一个统计窗口内）
+ */
+struct inference_scheduler_stats_t {
+    uint32_t classified;        // 分类的窗口数
+    uint32_t skipped;           // 推理落后时因过时而跳过的窗口数
+    uint32_t mean_latency_us;   // 样本到结果的平均延迟（从采集线程取到窗口中最新的样本起算）
+    uint32_t max_latency_us;    // 样本到结果的最大延迟
+    uint32_t canceled;          // 推理中途被更新的窗口抢占而放弃的次数（见 INFERENCE_CANCEL_STALE）
+};
+
+/**
+ * @brief 获取上一个统计窗口的推理调度统计
+ * @param out_stats 输出统计快照
+ */
+void inference_get_scheduler_stats(inference_scheduler_stats_t* out_stats);
+
+/**
+ * @brief 推理线程等待 inference_get_mutex() 的统计（自启动累计）
+ * 读者（BLE、LED、串口线程）持锁期间推理线程只能等待；目标上的互斥锁带优先级继承，等待时间只取决于读者临界区的长度
+ */
+struct inference_lock_stats_t {
+    uint32_t acquisitions;      // 推理线程获取锁的次数
+    uint32_t contended;         // 其中锁被其他线程持有、需要等待的次数
+    uint32_t max_wait_us;       // 最长一次等待（与 INFERENCE_LOCK_WAIT_BUDGET_US 比较）
+    uint32_t total_wait_us;
+};
+
+/**
+ * @brief 获取推理线程的锁等待统计
+ * @param out_stats 输出统计快照
+ */
+void inference_get_lock_stats(inference_lock_stats_t* out_stats);
+
+/**
+ * @brief 按射频时序放置推理的统计（INFERENCE_RADIO_AWARE，自启动累计；只计学到连接事件时序期间的推理）
+ * 放置组在下一个连接事件之前的空隙里运行，对照组（每 INFERENCE_RADIO_CONTROL_EVERY 次一次）原地运行，
+ * 两组推理耗时（墙钟，含被中断拉长的部分）p99 之差即放置带来的改善
+ */
+struct inference_radio_stats_t {
+    uint32_t placed;            // 放置组的推理次数（含不必推迟的）
+    uint32_t control;           // 对照组的推理次数
+    uint32_t deferred;          // 放置组中推迟到连接事件之后的次数
+    uint32_t no_fit;            // 放置组中放不进任何空隙、原地运行的次数
+    uint32_t mean_defer_us;     // 推迟的平均时长
+    uint32_t placed_p99_us;     // 放置组推理耗时的 99 分位
+    uint32_t control_p99_us;    // 对照组推理耗时的 99 分位
+    uint32_t interval_us;       // 学到的连接间隔（0 = 当前没有时序）
+    uint32_t event_us;          // 连接事件长度的估计
+};
+
+/**
+ * @brief 获取按射频时序放置推理的统计（未启用时全为 0）
+ * @param out_stats 输出统计快照
+ */
+void inference_get_radio_stats(inference_radio_stats_t* out_stats);
+
+/**
+ * @brief 一次分类的结果（传给结果观察者）
+ */
+struct inference_result_event_t {
+    int index;              // 预测类别（-1 = 无 / 低于阈值）
+    float confidence;       // 置信度
+    uint32_t frame;         // 窗口中最新样本的序号（自启动以来进入窗口的累计帧数）
+    uint32_t classify_us;   // 分类耗时（0 = 被 idle 预筛跳过）
+    uint32_t latency_us;    // 样本到结果延迟（0 = 未知）
+};
+
+typedef void (*inference_result_observer_t)(const inference_result_event_t* event);
+
+/**
+ * @brief 注册结果观察者：每次分类后在推理线程中调用（必须尽快返回），nullptr 取消
+ * 主机离线回放用它逐窗口收集结果。
+ */
+void inference_set_result_observer(inference_result_observer_t observer);
+
+/**
+ * @brief 采集线程已写入样本队列的累计帧数
+ * 与 inference_result_event_t::frame 同一计数：在采集线程中读取时，之后写入的第一帧进入窗口后 frame 等于返回值加一。
+ */
+uint32_t inference_frames_pushed();
+
+/**
+ * @brief 推理线程是否已处理完样本队列中所有完整的步（正在等待新样本）
+ */
+bool inference_caught_up();
+
+/**
+ * @brief 设置推理步长（线程安全，可在运行中调用）
+ * 预测稳定为 idle 时使用粗步长，其余情况使用细步长；两者相等即为固定步长。
+ * @param fine_samples 细步长（样本数，须为 SLIDING_WINDOW_STEP 对应样本数的整数倍）
+ * @param coarse_samples 粗步长（样本数，>= fine_samples，且不超过窗口长度）
+ * @return true 设置成功
+ * @return false 参数无效，保持原设置
+ */
+bool inference_set_stride(uint8_t fine_samples, uint8_t coarse_samples);
+
+/**
+ * @brief 单个模型的信息与推理耗时统计
+ */
+struct inference_model_stats_t {
+    const char* name;        // impulse 名称
+    uint16_t label_count;    // 类别数
+    uint32_t input_values;   // 模型输入值个数
+    uint32_t arena_bytes;    // 张量 arena 大小（0 = 未知）
+    uint32_t invokes;        // 在该模型上完成的推理次数
+    uint32_t mean_us;        // 平均推理耗时
+    uint32_t max_us;         // 最大推理耗时
+    int last_index;          // 最近一次结果的类别（-1 = 低于阈值或尚未推理）
+    float last_confidence;   // 最近一次结果的置信度
+};
+
+/**
+ * @brief 影子模式（INFERENCE_SHADOW_MODEL）自启动以来的对比统计，计数的含义见 shadow_tally.h
+ */
+struct inference_shadow_stats_t {
+    int candidate;           // 候选模型序号（-1 = 未启用影子模式）
+    uint32_t runs;
+    uint32_t deferred;       // 到期但让路（下一步已到期或运行中被取消）的次数
+    uint32_t agree;
+    uint32_t candidate_only;
+    uint32_t production_only;
+    uint32_t differ;
+    uint32_t mean_us;        // 候选模型的平均与最大耗时
+    uint32_t max_us;
+};
+
+/**
+ * @brief 获取影子模式的统计
+ * @param out_stats 输出统计快照
+ */
+void inference_get_shadow_stats(inference_shadow_stats_t* out_stats);
+
+/**
+ * @brief 已注册的模型数量（默认模型 + INFERENCE_EXTRA_IMPULSES）
+ */
+size_t inference_model_count();
+
+/**
+ * @brief 当前使用的模型序号
+ */
+size_t inference_active_model();
+
+/**
+ * @brief 请求切换模型（由推理线程在下一步切换；所有模型启动时已初始化，切换不需要重新初始化）
+ * 切换后连续分类器用完整的当前窗口重建特征，第一次推理即可给出新模型的结果。
+ * @param index 模型序号
+ * @return true 请求已接受
+ * @return false 序号无效
+ */
+bool inference_select_model(size_t index);
+
+/**
+ * @brief 获取模型信息与耗时统计
+ * @param index 模型序号
+ * @param out_stats 输出统计
+ * @return true 获取成功
+ * @return false 序号无效
+ */
+bool inference_get_model_stats(size_t index, inference_model_stats_t* out_stats);
+
+/**
+ * @brief 上一个统计窗口内因静止而跳过分类的时间比例（0~1）
+ */
+float inference_get_gated_ratio();
+
+/**
+ * @brief 推理的工作点（电量分级：battery_module 按电池电压逐级选择，依次更省电）
+ */
+enum inference_power_point_t {
+    INFERENCE_POWER_FULL = 0,         // 运行时配置的细 / 粗步长
+    INFERENCE_POWER_COARSE,           // 细步长也用粗步长
+    INFERENCE_POWER_IDLE_FILTER,      // 粗步长，且只在新样本的运动能量超过阈值的步推理
+    INFERENCE_POWER_ON_DEMAND,        // 双击唤醒后才推理（唤醒窗口内按粗步长）
+    INFERENCE_POWER_POINT_COUNT
+};
+
+// 主机没有请求工作点
+#define INFERENCE_HOST_POINT_NONE 0xFF
+
+/**
+ * @brief 切换电量分级选择的工作点（线程安全，下一步生效；与运行时配置的步长独立保存，回到满速时恢复）
+ */
+void inference_set_power_point(inference_power_point_t point);
+
+/**
+ * @brief 主机请求的工作点（上位机按前台程序切换：手势能起作用时满速，其余时间只在运动时推理）
+ * 生效的工作点取电量分级与主机请求中更省电的一个；请求不保存，会话结束时撤销（ble_module）
+ * @param point inference_power_point_t，或 INFERENCE_HOST_POINT_NONE 撤销请求
+ * @return false 工作点无效（按需一级需要 INFERENCE_ARM_SUPPORT），保持原请求
+ */
+bool inference_set_host_power_point(uint8_t point);
+
+/**
+ * @brief 主机当前请求的工作点（INFERENCE_HOST_POINT_NONE = 没有请求）
+ */
+uint8_t inference_get_host_power_point();
+
+/**
+ * @brief 生效的工作点
+ */
+inference_power_point_t inference_get_power_point();
+
+/**
+ * @brief 工作点名（"full" / "coarse" / "idle-filter" / "on-demand"）
+ */
+const char* inference_power_point_name(uint8_t point);
+
+/**
+ * @brief 两段式唤醒状态（INFERENCE_ARM_MODE，或电量分级的按需一级）
+ * @param out_arms 自启动以来打开唤醒窗口的次数（可为 nullptr）
+ * @param out_armed_ratio 上一个统计窗口内处于唤醒状态的时间比例（可为 nullptr）
+ * @return true 当前处于唤醒窗口内（不需要唤醒时恒为 true）
+ */
+bool inference_get_arm_state(uint32_t* out_arms, float* out_armed_ratio);
+
+/**
+ * @brief 获取 idle 预筛统计（自启动以来）
+ * @param out_evaluated 经过预筛的推理次数
+ * @param out_skipped 被判定为 idle、跳过 CNN 的次数
+ */
+void inference_get_prefilter_stats(uint32_t* out_evaluated, uint32_t* out_skipped);
+
+/**
+ * @brief 请求一次逐算子性能剖析（由推理线程在下一步执行并打印，见 model_module_profile）
+ */
+void inference_request_profile();
+
+/**
+ * @brief 推理基准的计时级
+ */
+enum inference_bench_stage_t {
+    INFERENCE_BENCH_DSP = 0,     // 特征提取（ei_impulse_result_timing_t::dsp_us；int8 窗口路径没有 DSP 级，为 0）
+    INFERENCE_BENCH_CLASSIFY,    // 模型推理（timing.classification_us；int8 窗口路径为 invoke 耗时）
+    INFERENCE_BENCH_POSTPROCESS, // 分类结果就绪到本次推理处理完（argmax、平滑、事件检测与发布）
+    INFERENCE_BENCH_TOTAL,       // 合成窗口：整次分类；实时数据：窗口最新样本到达到结果发布
+    INFERENCE_BENCH_STAGE_COUNT
+};
+
+enum inference_bench_mode_t {
+    INFERENCE_BENCH_SYNTHETIC = 0,  // 固定的合成窗口连续分类（可复现；只做无状态的 argmax 与阈值，不发布结果）
+    INFERENCE_BENCH_LIVE = 1,       // 记录接下来 n 次运行了 CNN 的实时推理（被 idle 预筛跳过、静止门控的不计）
+};
+
+enum inference_bench_state_t {
+    INFERENCE_BENCH_NONE = 0,
+    INFERENCE_BENCH_RUNNING,
+    INFERENCE_BENCH_DONE,
+    INFERENCE_BENCH_FAILED,
+};
+
+struct inference_bench_stats_t {
+    uint32_t min_us;
+    uint32_t p50_us;
+    uint32_t p95_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+};
+
+/**
+ * @brief 最近一轮推理基准的结果
+ */
+struct inference_bench_report_t {
+    uint8_t mode;    // inference_bench_mode_t
+    uint8_t state;   // inference_bench_state_t
+    uint16_t runs;   // 已记录的推理次数
+    inference_bench_stats_t stages[INFERENCE_BENCH_STAGE_COUNT];
+};
+
+/**
+ * @brief 请求一轮推理基准（由推理线程执行，完成后打印到串口）
+ * @param mode inference_bench_mode_t
+ * @param runs 推理次数（1 ~ INFERENCE_BENCHMARK_MAX_RUNS）
+ * @return true 请求已接受；false 参数无效或上一轮仍在进行
+ */
+bool inference_request_benchmark(inference_bench_mode_t mode, uint16_t runs);
+
+/**
+ * @brief 获取最近一轮推理基准（线程安全）
+ * @param out_report 输出结果
+ * @return 每轮结束时递增的版本号（0 = 尚未完成过），消费者据此判断是否有新结果
+ */
+uint32_t inference_get_benchmark(inference_bench_report_t* out_report);
+
+/**
+ * @brief 已发布结果的快照
+ */
+struct inference_result_snapshot_t {
+    int32_t index;          // 预测类别；无结果时为 -1
+    uint8_t confidence_q;   // 量化的预测置信度（格式见 inference_get_confidence_format）
+    uint32_t sequence;      // 结果序列号（每次发布递增，0 = 尚未发布）
+    uint32_t timestamp_ms;  // 发布时刻（millis）
+    uint32_t sample_us;     // 产生该结果的窗口中最新样本的到达时刻（micros，0 = 未知），用于端到端延迟追踪
+};
+
+/**
+ * @brief 已发布置信度的量化格式：置信度 = (confidence_q - zero_point) x scale
+ * 由模型输出张量的量化参数换算到 uint8（int8 零点 + 128），推理线程在发布时量化一次，
+ * 共享状态与线上记录都只传这一字节，主机按这组参数（BLE 布局特征值、USB hello 的应答）反量化
+ */
+struct inference_confidence_format_t {
+    float scale;
+    uint8_t zero_point;
+};
+
+/**
+ * @brief 获取已发布置信度的量化格式（模型加载后不变；没有模型时为 1/255、零点 0）
+ */
+void inference_get_confidence_format(inference_confidence_format_t* out_format);
+
+/**
+ * @brief 把概率量化为已发布置信度的格式（四舍五入，饱和于 0..255）；用于把阈值换算到整数比较
+ */
+uint8_t inference_quantize_confidence(float confidence);
+
+/**
+ * @brief 把已发布的量化置信度换算回概率（只用于需要浮点的设备内消费者，如 LED 亮度）
+ */
+float inference_confidence_value(uint8_t confidence_q);
+
+/**
+ * @brief 无锁读取最新结果的快照（顺序锁，见 seqlock.h）：读者不阻塞推理线程，推理线程也不等待读者
+ * @param out_snapshot 输出快照，各字段来自同一次发布
+ */
+void inference_get_result_snapshot(inference_result_snapshot_t* out_snapshot);
+
 /**
  * @brief 获取最新的预测结果（线程安全）
  * @param out_prediction_index 输出参数：预测类别索引
@@ -37,6 +386,161 @@ void inference_get_result_with_seq(int* out_prediction_index,
                                    float* out_confidence,
                                    uint32_t* out_sequence);
 
+/**
+ * @brief 结果消费者：每个消费者占用一个通知标志位，等待时只清除自己的位
+ */
+enum inference_consumer_t {
+    INFERENCE_CONSUMER_BLE = 0,
+    INFERENCE_CONSUMER_LED,
+    INFERENCE_CONSUMER_COUNT
+};
+
+/**
+ * @brief 阻塞等待新结果发布（结果序列号递增时通知所有消费者），代替按固定间隔轮询序列号
+ * 通知只表示"可能有新结果"：被唤醒后仍用 inference_get_result_with_seq 读取并比较序列号，
+ * 上次等待之后发布的结果会让下一次等待立即返回
+ * @param consumer 消费者
+ * @param timeout 最长等待时间（std::chrono::milliseconds(osWaitForever) = 一直等待）
+ * @return true 有新结果发布
+ * @return false 超时
+ */
+bool inference_wait_result(inference_consumer_t consumer, std::chrono::milliseconds timeout);
+
+/**
+ * @brief 不发布结果而唤醒该消费者的等待（其他事件源共用同一个等待，例如 BLE 线程的 HCI 事件）
+ * 被唤醒的消费者照常取结果，取不到即处理自己的其他事件
+ */
+void inference_wake_result_waiter(inference_consumer_t consumer);
+
+/**
+ * @brief 登记结果监听：该消费者被唤醒时（结果发布、inference_wake_result_waiter）在唤醒方的线程中调用，
+ * 用于不阻塞等待、而是由事件派发的消费者（LED，event_module.h）。监听函数须很快返回，不能阻塞
+ * @param listener nullptr = 取消
+ */
+void inference_set_result_listener(inference_consumer_t consumer, void (*listener)());
+
+/**
+ * @brief 取出该消费者队列中最早的结果事件
+ * 每次发布结果都扇出到所有消费者的有界队列（INFERENCE_EVENT_QUEUE_DEPTH），两次读取之间的结果不会被合并；
+ * 每个消费者只能在一个线程中读取自己的队列
+ * @param consumer 消费者
+ * @param out_event 输出事件（发布时的结果快照）
+ * @return true 取到事件
+ * @return false 队列为空
+ */
+bool inference_pop_result_event(inference_consumer_t consumer, inference_result_snapshot_t* out_event);
+
+/**
+ * @brief 因该消费者队列已满而丢弃的结果事件数（自启动以来）
+ */
+uint32_t inference_result_event_overruns(inference_consumer_t consumer);
+
+/**
+ * @brief 一次推理的全部类别分数：输出张量的 int8 量化值，未经反量化与后处理（见 model_module_get_output_quantization）
+ */
+struct inference_scores_t {
+    uint32_t sequence;                   // 推理序号（每次推理递增，含被 idle 预筛跳过的窗口）
+    int8_t scores[GESTURE_LABEL_COUNT];  // idle 预筛跳过 CNN 的窗口：idle 为量化的 1，其余为量化的 0
+};
+
+/**
+ * @brief 取出最早的一组分数（单一消费者：BLE 线程）
+ * @return true 取出成功；false 队列为空
+ */
+bool inference_pop_scores(inference_scores_t* out_scores);
+
+/**
+ * @brief 分数队列满时丢弃的组数（自启动以来）
+ */
+uint32_t inference_score_overruns();
+
+/**
+ * @brief 送入模型的一帧样本，换算为 int16 传感器 LSB（见 imu_module_channel_lsb）
+ */
+struct inference_window_frame_t {
+    uint32_t index;     // 样本序号：这一帧写入样本队列之前的 inference_frames_pushed()
+    int16_t values[IMU_MAX_AXES];  // inference_window_channel_mask() 中各通道的样本，按通道序号升序
+};
+
+/**
+ * @brief 窗口样本所含的板坐标系通道（位 i = 通道 i，0..2 加速度、3..5 陀螺仪）；重复的融合轴只计一次
+ */
+uint8_t inference_window_channel_mask();
+
+/**
+ * @brief 取出最早的一帧样本（单一消费者：BLE 线程）
+ * @return true 取出成功；false 队列为空
+ */
+bool inference_pop_window_frame(inference_window_frame_t* out_frame);
+
+/**
+ * @brief 窗口样本队列满时丢弃的帧数（自启动以来）
+ */
+uint32_t inference_window_stream_overruns();
+
+/**
+ * @brief 一个完整的手势（INFERENCE_EVENT_MODE = INFERENCE_EVENTS_SEGMENTS 时在手势结束时记录）
+ */
+struct inference_gesture_event_t {
+    int index;              // 手势类别
+    float peak_confidence;  // 手势期间的最高置信度
+    uint32_t start_ms;      // 手势开始：第一个候选窗口最新样本的采样时钟（进入窗口的累计样本数折算为毫秒）
+    uint32_t end_ms;        // 手势结束：最后一个判定为该手势的窗口的采样时钟
+};
+
+/**
+ * @brief 获取最近一次结束的手势（线程安全）
+ * 结果序列号在手势确认时递增（消费者据此尽早响应），这里的序列号在手势结束时递增。
+ * @param out_event 输出手势事件
+ * @param out_sequence 输出手势序列号（每个结束的手势递增一次）
+ * @return true 至少已有一个手势结束
+ */
+bool inference_get_gesture_event(inference_gesture_event_t* out_event, uint32_t* out_sequence);
+
+/**
+ * @brief 当前手势的保持状态（INFERENCE_EVENT_MODE = INFERENCE_EVENTS_SEGMENTS），用于按住手势的连续控制
+ */
+struct inference_segment_state_t {
+    inference_gesture_event_t gesture;  // 按住时为确认时的分段，释放后为完整的手势
+    bool held;                          // true = 手势已确认且尚未结束
+    uint32_t result_sequence;           // 该手势确认时发布的结果序列号
+    uint32_t changes;                   // 每次确认、结束各递增一次
+};
+
+/**
+ * @brief 获取当前手势的保持状态（线程安全）
+ * 手势结束时不发布结果，但会立即唤醒 BLE 消费者，释放与确认一样低延迟地送达上位机。
+ * @param out_state 输出保持状态
+ * @return true 至少已有一个手势被确认
+ */
+bool inference_get_segment_state(inference_segment_state_t* out_state);
+
+/**
+ * @brief 手势起始的临时判定状态（INFERENCE_ONSET_HEAD）
+ */
+enum inference_onset_kind_t {
+    INFERENCE_ONSET_PROVISIONAL = 0,  // 前缀头判定手势已开始，完整窗口尚未判定
+    INFERENCE_ONSET_CONFIRMED = 1,    // 完整窗口判定为同一手势
+    INFERENCE_ONSET_CANCELED = 2      // 完整窗口判定为其他手势，或等待超时
+};
+
+struct inference_onset_state_t {
+    int index;                  // 临时判定的类别（-1 = 尚无）
+    uint8_t kind;               // inference_onset_kind_t
+    uint8_t confidence_q;       // 前缀头的概率（量化格式同结果）
+    uint32_t onset;             // 临时判定的序号（每个临时判定递增，确认 / 撤销沿用）
+    uint32_t result_sequence;   // 确认时已发布结果的序号（其余为 0）
+    uint32_t sample_ms;         // 临时判定时窗口最新样本的采样时钟
+    uint32_t changes;           // 每次临时判定、确认、撤销各递增一次
+};
+
+/**
+ * @brief 获取手势起始的临时判定状态（线程安全）
+ * 临时判定在 CNN 运行之前发出并立即唤醒 BLE 消费者；确认与撤销随完整窗口的结果一起发布。
+ * @return true 至少已有一个临时判定
+ */
+bool inference_get_onset_state(inference_onset_state_t* out_state);
+
 /**
  * @brief 清除当前的预测结果（线程安全）
  * 用于避免重复触发相同的预测
@@ -45,9 +549,12 @@ void inference_clear_result();
 
 /**
  * @brief 获取互斥锁的引用（供其他模块使用）
- * @return rtos::Mutex& 互斥锁引用
+ * @deprecated 结果已改为无锁快照（inference_get_result_snapshot），读取结果不需要、也不应再持有该锁；
+ * 只为兼容旧代码保留，持有它会阻塞推理线程发布结果
+ * @return hal::Mutex& 互斥锁引用
  */
-rtos::Mutex& inference_get_mutex();
+[[deprecated("results are published through a lock-free snapshot, use inference_get_result_snapshot()")]]
+hal::Mutex& inference_get_mutex();
 
 /**
  * @brief 根据预测索引获取类别名称
@@ -0,0 +1,52 @@
+#ifndef INTERP_MODULE_H
+#define INTERP_MODULE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct TfLiteTensor;
+
+// TFLM 解释器后备路径（MODEL_INTERPRETER_ENABLE）：用 MicroInterpreter 直接运行 flash 中的 .tflite flatbuffer
+// （模型槽中格式 2 的权重包，见 include/model_blob.h），图结构可以随 OTA 改变，不再固定在编译期。
+// 算子解析器（MicroMutableOpResolver）只注册部署模型用到的 5 个算子：RESHAPE、CONV_2D、MAX_POOL_2D、
+// FULLY_CONNECTED、SOFTMAX，用到其他算子的模型在加载时被拒绝。
+// arena 由调用者提供：model_module 传入编译图未初始化时的张量 arena，两个引擎从不同时持有它；
+// 解释器对象本身放在静态存储中，卸载后 arena 即可交还编译图。只在推理线程中调用。
+
+/**
+ * @brief 校验并加载一个 flatbuffer（已加载的模型先卸载）
+ * @param model flatbuffer 起始地址（16 字节对齐，加载期间及之后须一直有效，通常在 flash 中）
+ * @param bytes flatbuffer 长度（flatbuffers::Verifier 按它检查越界）
+ * @param arena 张量 arena（16 字节对齐）
+ * @param arena_bytes arena 大小
+ * @return true 成功：输入 / 输出张量已分配，可以推理
+ */
+bool interp_module_load(const uint8_t* model, size_t bytes, uint8_t* arena, size_t arena_bytes);
+
+/**
+ * @brief 卸载当前模型（析构解释器），之后 arena 不再被使用
+ */
+void interp_module_unload();
+
+/**
+ * @brief 是否已加载模型（即 arena 是否被解释器持有）
+ */
+bool interp_module_active();
+
+/**
+ * @brief 第一个输入 / 输出张量（数据在 arena 中，卸载后失效）；未加载时为 nullptr
+ */
+TfLiteTensor* interp_module_input();
+TfLiteTensor* interp_module_output();
+
+/**
+ * @brief 运行一次完整的图，输出留在输出张量中
+ */
+bool interp_module_invoke();
+
+/**
+ * @brief 解释器实际占用的 arena 字节数（张量、节点与算子的 persistent 数据）；未加载时为 0
+ */
+size_t interp_module_arena_used();
+
+#endif
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// LE credit-based L2CAP channel for the bulk streams (BLE_L2CAP_ENABLE).
+//
+// A central opens the channel on SPSM BLE_L2CAP_PSM (read from 19B10032:
+// uint16 SPSM, uint16 receive MTU, uint8 version). Every SDU in either
+// direction is a run of records: uint8 type, uint8 length, then the payload.
+// The type is the USB frame type (usb_frame.h, the low byte of the
+// characteristic UUID) and the payload that characteristic's notification or
+// write, so the host decodes both transports with the same functions.
+//
+// The host first sends a hello record (uint8 USB_STREAM_* bitmap, may be 0);
+// the device answers with uint8 streams in effect, uint8 L2CAP_BULK_VERSION and
+// uint8 WIRE_SCHEMA_VERSION. From then on the raw IMU recording, the window
+// stream and the zone trace (as the bitmap selects) and the diagnostics log
+// dump go over the channel instead of their characteristics. Records are packed into SDUs that
+// fill whole K-frames, so each link-layer packet carries data rather than one
+// notification with its ATT header and flow control. Gesture events and every
+// other characteristic stay on GATT for latency. The host may write model blob
+// data records (the 19B10023 format) on the channel.
+//
+// ArduinoBLE has no connection-oriented channels. The module wraps the HCI
+// transport (HCI.setTransport) and takes the LE credit-based signaling and its
+// own channel's K-frames out of the ACL stream before ArduinoBLE parses it.
+// Everything else passes through unchanged. Replies, credits and data go out
+// through HCI.sendAclPkt, so the controller's ACL buffer accounting stays
+// ArduinoBLE's. All calls happen on the BLE thread.
+
+#define L2CAP_BULK_VERSION 1
+#define L2CAP_RECORD_MAX 255
+
+/**
+ * @brief A record the host wrote on the channel.
+ */
+struct l2cap_record_t {
+    uint8_t type;
+    uint8_t length;
+    uint8_t data[L2CAP_RECORD_MAX];
+};
+
+/**
+ * @brief Put the filtering transport under ArduinoBLE's HCI layer. Call before BLE.begin().
+ */
+void l2cap_module_install();
+
+/**
+ * @brief After each BLE.poll(): sends signaling replies, returns credits and
+ *        sends queued K-frames while the central has credits.
+ */
+void l2cap_module_service();
+
+/**
+ * @brief Whether a channel is open and its host has sent its hello.
+ */
+bool l2cap_module_open();
+
+/**
+ * @brief Whether records of this type go over the channel (a bulk type the host subscribed to).
+ */
+bool l2cap_module_subscribed(uint8_t type);
+
+/**
+ * @brief Append a record to the SDU being filled; a full SDU is queued for sending.
+ * @return false when the channel is closed or the send queue is full (the record is dropped).
+ */
+bool l2cap_module_send(uint8_t type, const uint8_t* payload, size_t length);
+
+/**
+ * @brief Queue the SDU being filled even if it is not full (end of a BLE thread pass).
+ */
+void l2cap_module_flush();
+
+/**
+ * @brief Take the next record the host wrote (the hello is handled inside).
+ * @return true if a record was taken.
+ */
+bool l2cap_module_pop(l2cap_record_t* out_record);
@@ -0,0 +1,57 @@
+#ifndef LATENCY_MODULE_H
+#define LATENCY_MODULE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 端到端延迟追踪
+// 每个结果都带着触发它的窗口中最新样本的到达时刻（采集线程的 micros），各阶段完成时用当前时刻减去它，
+// 记入该阶段的延迟直方图；每个统计窗口（IMU_RATE_WINDOW_MS）给出一次分位数并统计超过
+// LATENCY_SLO_MS 的次数，然后开始新的窗口。记录与读取都不加锁（stat_counters.h 的原子直方图与 seqlock 快照），
+// 各阶段当前窗口的分布也登记在统计注册表中（stats_module.h）。
+
+/**
+ * @brief 追踪的阶段（都从窗口最新样本到达起算）
+ */
+enum latency_stage_t {
+    LATENCY_INFERENCE = 0,  // 分类完成（推理线程）
+    LATENCY_NOTIFY,         // 结果事件提交给 BLE 协议栈（BLE 线程）
+    LATENCY_ACK,            // 收到主机执行动作后的回执（主机支持时）
+    LATENCY_STAGE_COUNT
+};
+
+/**
+ * @brief 一个阶段在一个统计窗口内的延迟分布
+ */
+struct latency_stats_t {
+    uint32_t count;     // 窗口内的样本数
+    uint32_t p50_us;
+    uint32_t p95_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+    uint32_t over_slo;  // 窗口内不低于 LATENCY_SLO_MS 的次数
+};
+
+/**
+ * @brief 把各阶段的直方图登记到统计注册表（启动时调用一次）
+ */
+void latency_module_init();
+
+/**
+ * @brief 记录一次延迟（任意线程，无锁）
+ * @param stage 阶段
+ * @param sample_us 窗口最新样本的到达时刻（0 = 未知，不记录）
+ */
+void latency_module_record(latency_stage_t stage, uint32_t sample_us);
+
+/**
+ * @brief 读取上一个统计窗口的延迟分布（任意线程，无锁）
+ */
+void latency_module_get_stats(latency_stage_t stage, latency_stats_t* out_stats);
+
+/**
+ * @brief 结束当前统计窗口（只在一个线程中调用）：保存快照、打印各阶段分位数，并开始新的窗口
+ */
+void latency_module_report();
+
+#endif
@@ -1,17 +1,56 @@
 #ifndef LED_MODULE_H
 #define LED_MODULE_H
 
-// LED控制模块对外接口
+#include <stdint.h>
+
+#include "app_config.h"
+
+// LED控制模块对外接口（LED_ENABLE 为 0 时为空实现：不初始化 PWM，动画一律被丢弃）
+
+// 动画最多的关键帧数
+#define LED_MAX_KEYFRAMES 4
+
+/**
+ * @brief 关键帧：在 fade_ms 内从当前颜色线性渐变到目标颜色，再保持 hold_ms
+ * 颜色分量 0-255 为感知亮度（输出前做 gamma 校正）。
+ */
+struct led_keyframe_t {
+    uint8_t r, g, b;
+    uint16_t fade_ms;
+    uint16_t hold_ms;
+};
 
 /**
- * @brief 初始化LED GPIO引脚
+ * @brief 动画：按顺序播放关键帧，共播放 1 + repeat 遍
+ * 播放完且队列中没有下一个动画时，LED 保持最后一帧的颜色。
+ */
+struct led_pattern_t {
+    led_keyframe_t frames[LED_MAX_KEYFRAMES];
+    uint8_t count;
+    uint8_t repeat;
+};
+
+/**
+ * @brief 初始化LED引脚的硬件 PWM 输出（LED 熄灭），并登记推理结果的监听（结果发布时投递 LED 事件）
  */
 void led_module_init();
 
 /**
- * @brief LED控制任务函数（在独立线程中运行）
- * 根据推理结果控制RGB LED的颜色和状态
+ * @brief 把动画加入播放队列（仅在 LED 事件处理中调用），当前动画播完后开始播放
+ * @return bool false = 队列已满，动画被丢弃
+ */
+bool led_module_play(const led_pattern_t& pattern);
+
+/**
+ * @brief 打开 / 关闭结果显示（运行时配置的 LED 阈值为 1 时关闭）
+ * 关闭后推理模块不再为 LED 排队结果、不再投递 LED 事件，LED 整级移出流水线；正在显示的常亮颜色随即熄灭
+ */
+void led_module_set_enabled(bool enabled);
+
+/**
+ * @brief LED 事件处理函数（在事件线程中运行，event_module.h）
+ * 按发布顺序把积累的推理结果转换成动画加入播放队列，动画本身由定时器中断播放
  */
-void led_control_task();
+void led_module_on_event();
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,111 @@
+#ifndef LOG_MODULE_H
+#define LOG_MODULE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+
+#include "app_config.h"
+
+// 延迟日志：调用线程只把格式串指针和参数原样写进无锁队列（不格式化、不碰串口），
+// 由事件线程（event_module.h）取出后格式化并写串口。
+// - 格式串必须是字符串字面量；%s 参数必须指向静态字符串（类别名、模型名等），取出时才读取内容
+// - 支持 %d %i %u %x %X %o %c %s %p 与 %f %e %g（标志、宽度、精度照常；不支持 * 宽度）；
+//   整数按 32 位、浮点按 float 保存，长度修饰符（l、ll、h）被忽略
+// - 低于 LOG_LEVEL 的调用在编译期消除
+
+union log_arg_t {
+    int32_t i;
+    uint32_t u;
+    float f;
+    const char* s;
+    const void* p;
+};
+
+struct log_record_t {
+    const char* format;
+    uint8_t level;
+    uint8_t argc;
+    log_arg_t args[LOG_MAX_ARGS];
+};
+
+/**
+ * @brief 写入一条日志记录（任意线程；队列满时丢弃并计数）
+ * LOG_DEFERRED=0 时在调用线程中立即格式化输出（主机回放构建）。
+ */
+void log_module_push(const log_record_t& record);
+
+/**
+ * @brief 因队列满被丢弃的日志记录数
+ */
+uint32_t log_module_dropped();
+
+/**
+ * @brief 日志事件处理函数（在事件线程中运行，event_module.h）：格式化队列中的全部记录并写串口
+ */
+void log_module_drain();
+
+// ==================== 参数打包（内部） ====================
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value, log_arg_t>::type
+log_make_arg(T value) {
+    // 设备上 long 为 32 位，64 位整数须先转换；主机（64 位 long）上 %lu 参数的高 32 位被截断
+    static_assert(sizeof(T) <= sizeof(long), "log arguments are stored as 32 bits, cast 64-bit values");
+    log_arg_t arg;
+    arg.p = nullptr;
+    if (std::is_signed<T>::value) {
+        arg.i = (int32_t)value;
+    } else {
+        arg.u = (uint32_t)value;
+    }
+    return arg;
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_floating_point<T>::value, log_arg_t>::type log_make_arg(T value) {
+    log_arg_t arg;
+    arg.p = nullptr;
+    arg.f = (float)value;
+    return arg;
+}
+
+inline log_arg_t log_make_arg(const char* value) {
+    log_arg_t arg;
+    arg.s = value;
+    return arg;
+}
+
+inline log_arg_t log_make_arg(const void* value) {
+    log_arg_t arg;
+    arg.p = value;
+    return arg;
+}
+
+template <typename... Args>
+inline void log_module_write(uint8_t level, const char* format, Args... args) {
+    static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "too many log arguments (LOG_MAX_ARGS)");
+    const log_arg_t packed[sizeof...(Args) + 1] = {log_make_arg(args)..., log_make_arg((const void*)nullptr)};
+    log_record_t record;
+    record.format = format;
+    record.level = level;
+    record.argc = (uint8_t)sizeof...(Args);
+    for (size_t i = 0; i < sizeof...(Args); i++) {
+        record.args[i] = packed[i];
+    }
+    log_module_push(record);
+}
+
+#define LOG_AT(level, ...)                          \
+    do {                                            \
+        if ((level) <= LOG_LEVEL) {                 \
+            log_module_write((level), __VA_ARGS__); \
+        }                                           \
+    } while (0)
+
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+#define LOG_WARN(...) LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef MAG_MUX_H
+#define MAG_MUX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief 按时间戳把低速传感器（磁力计）的样本插值到高速帧流上的多路合并器
+ * 磁力计以远低于加速度计的速率读出，每个样本带读出时刻。输出帧按自己的采样时刻取值：
+ * 落在两个样本之间时线性插值，晚于最新样本时保持最新值（不外推，也不为等下一个样本而推迟整帧），
+ * 早于保留的最旧样本时取最旧值。时间戳为 32 位微秒计数，按差值比较，跨越回绕同样正确。
+ * @tparam Channels 每个样本的通道数
+ * @tparam Depth 保留的样本数（须覆盖一次突发读取所跨的时间：帧的时刻早于读出时刻）
+ */
+template <size_t Channels, size_t Depth = 4>
+class TimestampMux {
+public:
+    TimestampMux() : count_(0), head_(0) {}
+
+    void reset() {
+        count_ = 0;
+        head_ = 0;
+    }
+
+    bool empty() const {
+        return count_ == 0;
+    }
+
+    /**
+     * @brief 加入一个样本（时间戳须不早于上一个样本）
+     */
+    void push(const float* values, uint32_t timestamp_us) {
+        sample_t& s = samples_[head_];
+        for (size_t c = 0; c < Channels; c++) {
+            s.values[c] = values[c];
+        }
+        s.timestamp_us = timestamp_us;
+        head_ = (head_ + 1) % Depth;
+        if (count_ < Depth) {
+            count_++;
+        }
+    }
+
+    /**
+     * @brief 时刻 timestamp_us 的插值结果
+     * @return false 还没有任何样本（out 全为 0）
+     */
+    bool sample(uint32_t timestamp_us, float* out) const {
+        if (count_ == 0) {
+            for (size_t c = 0; c < Channels; c++) {
+                out[c] = 0.0f;
+            }
+            return false;
+        }
+        // 从最新的样本往回找第一个不晚于 timestamp_us 的样本
+        const sample_t* newer = &at(0);
+        if ((int32_t)(timestamp_us - newer->timestamp_us) >= 0) {
+            copy(out, newer->values);
+            return true;
+        }
+        for (size_t i = 1; i < count_; i++) {
+            const sample_t* older = &at(i);
+            const int32_t since_older = (int32_t)(timestamp_us - older->timestamp_us);
+            if (since_older >= 0) {
+                const uint32_t span = newer->timestamp_us - older->timestamp_us;
+                const float t = span > 0 ? (float)since_older / (float)span : 1.0f;
+                for (size_t c = 0; c < Channels; c++) {
+                    out[c] = older->values[c] + (newer->values[c] - older->values[c]) * t;
+                }
+                return true;
+            }
+            newer = older;
+        }
+        copy(out, newer->values);
+        return true;
+    }
+
+private:
+    struct sample_t {
+        float values[Channels];
+        uint32_t timestamp_us;
+    };
+
+    // 第 age 新的样本（0 = 最新）
+    const sample_t& at(size_t age) const {
+        return samples_[(head_ + Depth - 1 - age) % Depth];
+    }
+
+    static void copy(float* out, const float* in) {
+        for (size_t c = 0; c < Channels; c++) {
+            out[c] = in[c];
+        }
+    }
+
+    sample_t samples_[Depth];
+    size_t count_;
+    size_t head_;
+};
+
+#endif
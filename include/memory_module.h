@@ -0,0 +1,110 @@
+#ifndef MEMORY_MODULE_H
+#define MEMORY_MODULE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "app_config.h"
+#include "edge-impulse-sdk/classifier/ei_aligned_malloc.h"
+
+// RAM 预算与共享 scratch 内存接口
+// 各模块在初始化时登记自己的大块缓冲区，启动时统一打印一份 RAM 预算；
+// 编译模型张量 arena 中两次推理之间不保存状态的区域可以借给应用作临时缓冲区。
+
+// 热路径缓冲区的静态放置（ei_aligned_malloc.h 的放置宏）：
+//   MEMORY_SIMD_BUFFER  模型输入与窗口，16 字节对齐（CMSIS-NN / DSP 的向量读取）
+//   MEMORY_DMA_BUFFER   外设直接读写的暂存区，字对齐，放在 DMA 能访问的 RAM（可用 MEMORY_DMA_SECTION 指定段）
+//   MEMORY_RING_BUFFER  环形缓冲区，从缓存行边界开始，不与前面的计数器共享缓存行
+// 定义处再用 MemoryPlacement 登记，setup 中 memory_module_check_placement() 逐一核对工具链与链接脚本是否照办。
+#define MEMORY_SIMD_BUFFER EI_ALIGNED_STATIC(EI_SIMD_ALIGN)
+#if defined(MEMORY_DMA_SECTION)
+#define MEMORY_DMA_BUFFER EI_PLACED_STATIC(EI_DMA_ALIGN, MEMORY_DMA_SECTION)
+#else
+#define MEMORY_DMA_BUFFER EI_ALIGNED_STATIC(EI_DMA_ALIGN)
+#endif
+#define MEMORY_RING_BUFFER EI_ALIGNED_STATIC(EI_CACHE_LINE_BYTES)
+
+enum memory_placement_t : uint8_t {
+    MEMORY_PLACE_SIMD = 1,      // EI_SIMD_ALIGN 对齐
+    MEMORY_PLACE_DMA = 2,       // EI_DMA_ALIGN 对齐且在 MEMORY_DMA_RAM_START 起的 MEMORY_DMA_RAM_BYTES 内
+    MEMORY_PLACE_RING = 4,      // 从缓存行边界开始，且与其他登记的缓冲区没有共享的缓存行
+};
+
+/**
+ * @brief 登记一块内存（只用于预算报告，不分配内存）
+ * @param name 名称（须为静态字符串）
+ * @param bytes 字节数
+ * @param on_heap true = 运行时从堆上分配（如线程栈），false = 静态数据
+ */
+void memory_module_register(const char* name, size_t bytes, bool on_heap);
+
+/**
+ * @brief 登记一块热路径缓冲区的放置要求（不加锁，可在静态初始化期间调用；同一地址只登记一次）
+ * @param name 名称（须为静态字符串）
+ * @param flags memory_placement_t 的组合
+ */
+void memory_module_register_hot(const char* name, const void* buffer, size_t bytes, uint8_t flags);
+
+/**
+ * @brief 在定义热路径缓冲区的文件中登记其放置要求（静态对象，main 之前完成）：
+ *   MEMORY_DMA_BUFFER static uint8_t g_staging[240];
+ *   static const MemoryPlacement g_staging_placement("imu fifo staging", g_staging, sizeof(g_staging), MEMORY_PLACE_DMA);
+ */
+class MemoryPlacement {
+public:
+    MemoryPlacement(const char* name, const void* buffer, size_t bytes, uint8_t flags) {
+        memory_module_register_hot(name, buffer, bytes, flags);
+    }
+};
+
+/**
+ * @brief 启动检查：核对每个登记的热路径缓冲区与张量 arena 的对齐、DMA 范围与缓存行，违反的逐条打印
+ * @return size_t 违反要求的缓冲区数（0 = 全部符合）
+ */
+size_t memory_module_check_placement();
+
+/**
+ * @brief 打印 RAM 预算：静态数据、堆使用量、已登记的缓冲区、张量 arena 布局与剩余空间
+ * 跟踪 DSP 分配的构建还列出 DSP 堆统计；EI_ARENA_RECORDING=1 构建还列出模型初始化以来的各类 arena 分配与能装下它们的最小 arena（串口 mem 命令重新打印）。
+ */
+void memory_module_report();
+
+/**
+ * @brief RAM 高水位：静态数据 + 堆已向系统申请到的大小（newlib 的堆只增不减，线程栈也在堆上）
+ * @param out_static 输出静态数据 + bss 字节数（没有链接脚本符号时为 0），可为 nullptr
+ * @return size_t 两者之和
+ */
+size_t memory_module_high_water(size_t* out_static);
+
+/**
+ * @brief 标记一次 DSP（run_classifier 特征提取）的开始 / 结束，统计期间的 DSP 堆分配
+ * 用 EIDSP_TRACK_ALLOCATIONS=1、EIDSP_PRINT_ALLOCATIONS=0 构建时 SDK 的分配计数才存在，否则两者为空操作；
+ * RAM 预算中列出 DSP 堆峰值、每次推理的分配次数与最大单块。只能在推理线程中调用。
+ */
+void memory_module_dsp_begin();
+void memory_module_dsp_end();
+
+/**
+ * @brief 借用张量 arena 中两次推理之间空闲的区域（只能在推理线程中，且在下一次推理之前归还）
+ * 同一时间只有一个借用；借出期间模型推理会被拒绝。解释器（MODEL_INTERPRETER_ENABLE）持有 arena 时不出借。
+ * @param bytes 需要的字节数
+ * @return void* 16 字节对齐的缓冲区，空闲区域不足或已被借出时为 nullptr
+ */
+void* memory_module_borrow(size_t bytes);
+
+/**
+ * @brief 归还 memory_module_borrow 借出的缓冲区
+ */
+void memory_module_release(void* ptr);
+
+/**
+ * @brief 张量 arena 当前是否被借出（推理前检查）
+ */
+bool memory_module_arena_lent();
+
+/**
+ * @brief 地址是否位于 RAM 中的静态数据区（.data / .bss，由链接脚本给出边界）
+ * 用于确认放进 RAM 的权重 / 代码确实由启动代码复制到了 RAM；没有链接脚本符号时恒为 false。
+ */
+bool memory_module_in_static_ram(const void* ptr);
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef MODEL_BLOB_H
+#define MODEL_BLOB_H
+
+#include <stdint.h>
+
+// 模型权重包的二进制格式（与 pc_controller/model_ota.py 对应），小端：
+//
+//   header(32) | entry_count 个 entry(20) | 数据...
+//
+// 权重包只替换编译图（EON）中张量的内容，不改变图结构：每个 entry 按图中的张量序号给出常量张量
+// （权重、偏置）的新数据，和 / 或任意量化张量的新 scale / zero point（逐张量量化）。数据区的偏移
+// 从包头起算并按 4 字节对齐，权重直接在 flash 中使用，不复制到 RAM。
+//
+// 两个特殊序号携带自检向量：MODEL_BLOB_TEST_INPUT 为一个 int8 输入窗口，MODEL_BLOB_TEST_LOGITS
+// 为上位机参考实现对它算出的全连接层 int8 输出（softmax 之前）；切换前设备用新权重推理并逐位比较。
+//
+// crc32（IEEE，与 calib_store 相同）覆盖 [16, total_bytes)，即包头 crc32 之后的全部字节。
+//
+// 格式 2（MODEL_INTERPRETER_ENABLE）不改写编译图，而是携带整个 .tflite flatbuffer，由解释器运行
+// （interp_module.h）：entry 只有三个特殊序号，MODEL_BLOB_FLATBUFFER 为 flatbuffer 本身（偏移按 16 字节对齐，
+// 张量数据直接在 flash 中使用），MODEL_BLOB_TEST_INPUT 同上，MODEL_BLOB_TEST_LOGITS 为模型输出张量
+// （softmax 之后）对测试窗口的 int8 结果，解释器不保留中间张量。
+
+#define MODEL_BLOB_MAGIC         0x31424D47  // "GMB1"
+#define MODEL_BLOB_FORMAT        1
+#define MODEL_BLOB_FORMAT_FLATBUFFER 2
+#define MODEL_BLOB_HEADER_BYTES  32
+#define MODEL_BLOB_ENTRY_BYTES   20
+#define MODEL_BLOB_CRC_OFFSET    16
+
+#define MODEL_BLOB_TEST_INPUT    0xFFFF
+#define MODEL_BLOB_TEST_LOGITS   0xFFFE
+#define MODEL_BLOB_FLATBUFFER    0xFFFD
+#define MODEL_BLOB_FLATBUFFER_ALIGN 16
+
+// entry.flags
+#define MODEL_BLOB_HAS_DATA      0x01
+#define MODEL_BLOB_HAS_QUANT     0x02
+
+struct model_blob_header_t {
+    uint32_t magic;
+    uint16_t format;
+    uint16_t entry_count;
+    uint32_t total_bytes;
+    uint32_t crc32;
+    uint32_t version;        // 上位机给出的模型版本，切换后通过模型状态报告
+    uint32_t reserved[3];
+};
+
+struct model_blob_entry_t {
+    uint16_t tensor;         // 编译图中的张量序号，或 MODEL_BLOB_TEST_* / MODEL_BLOB_FLATBUFFER
+    uint8_t flags;
+    uint8_t type;            // TfLiteType（kTfLiteInt8 = 9、kTfLiteInt32 = 2；flatbuffer 为 kTfLiteUInt8 = 3）
+    uint32_t offset;         // 数据偏移（从包头起算，4 字节对齐）
+    uint32_t bytes;          // 数据长度，须等于张量长度
+    float scale;
+    int32_t zero_point;
+};
+
+static_assert(sizeof(model_blob_header_t) == MODEL_BLOB_HEADER_BYTES, "model_blob_header_t layout");
+static_assert(sizeof(model_blob_entry_t) == MODEL_BLOB_ENTRY_BYTES, "model_blob_entry_t layout");
+
+#endif
@@ -0,0 +1,245 @@
+#ifndef MODEL_MODULE_H
+#define MODEL_MODULE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// EON 编译模型直接调用接口（绕过 run_classifier 的 DSP / 浮点暂存）
+
+/**
+ * @brief 初始化编译后的模型图，并常驻张量 arena
+ * @return true 初始化成功
+ * @return false 初始化失败
+ */
+bool model_module_init();
+
+/**
+ * @brief 释放编译图（更换权重前调用；只在推理线程中、arena 未借出时调用）
+ * @return true 调用前图已初始化（换完权重后需重新调用 model_module_init）
+ */
+bool model_module_deinit();
+
+/**
+ * @brief 标记当前权重是否来自模型槽：提前退出头按内置权重训练，下一次初始化时对其它权重关闭
+ */
+void model_module_set_custom_weights(bool custom);
+
+/**
+ * @brief 选择推理引擎（MODEL_INTERPRETER_ENABLE）：给出 flatbuffer 时下一次初始化改由解释器运行它
+ * （interp_module.h，使用编译图的张量 arena），nullptr 时回到编译图。只在图未初始化时调用。
+ * @param model flatbuffer（通常在模型槽的 flash 中，使用期间须一直有效）
+ * @param bytes flatbuffer 长度
+ */
+void model_module_set_flatbuffer(const uint8_t* model, size_t bytes);
+
+/**
+ * @brief 权重自检：用完整的图推理一个测试窗口，全连接层输出（softmax 之前）须与 expected_logits
+ * 逐位相同；启用流式推理时流式路径的输出也须与完整的图相同。未初始化时临时初始化图，测完释放。
+ * 解释器运行 flatbuffer 时比较的是模型输出张量（softmax 之后）。
+ * @param input 测试窗口（按时间顺序，量化格式与输入张量相同）
+ * @param expected_logits 上位机参考实现给出的全连接层（解释器：输出张量）int8 输出
+ * @return true 自检通过
+ */
+bool model_module_verify(const int8_t* input, size_t input_length, const int8_t* expected_logits,
+                         size_t num_logits);
+
+/**
+ * @brief 打印编译图中每个算子解析到的内核（CMSIS-NN / 参考实现，是否使用 DSP SIMD）
+ */
+void model_module_print_kernels();
+
+/**
+ * @brief 打印模型权重与热点内核所在的存储器（flash / RAM），并把放进 RAM 的权重登记到 RAM 预算
+ * 放置方式由 MODEL_WEIGHTS_IN_RAM / MODEL_HOT_CODE_IN_RAM 在编译期决定（nano33ble_ram 环境）。
+ */
+void model_module_print_placement();
+
+/**
+ * @brief 基准测试结果（单次完整推理的耗时）
+ */
+struct model_benchmark_t {
+    uint32_t iterations;
+    uint32_t mean_us;
+    uint32_t min_us;
+    uint32_t max_us;
+};
+
+/**
+ * @brief 对编译后的完整图连续推理若干次并打印耗时（内核后端见启动时打印的内核表）
+ * 参考内核与 CMSIS-NN 内核由编译期宏决定，A/B 对比需分别烧录 nano33ble_bench 与
+ * nano33ble_reference 两个环境。未初始化时临时初始化图，测完释放。
+ * 选择了 flatbuffer 时依次计时编译图与解释器（两者轮流持有 arena），并打印解释器的额外开销；
+ * 结果为解释器的耗时。
+ * @param iterations 推理次数
+ * @param out_result 输出结果（可为 nullptr）
+ * @return true 测试完成
+ * @return false 初始化或推理失败
+ */
+bool model_module_benchmark(uint32_t iterations, model_benchmark_t* out_result);
+
+/**
+ * @brief 逐算子性能剖析：连续推理若干次，用 DWT CYCCNT 统计每个节点的周期数，
+ * 打印算子、输入 / 输出张量大小、平均耗时与占比
+ * 需要以 -DEI_CLASSIFIER_EON_PROFILER=1 编译（nano33ble_profile 环境），否则只打印提示。
+ * @param iterations 推理次数
+ * @return true 剖析完成
+ * @return false 未启用、初始化或推理失败
+ */
+bool model_module_profile(uint32_t iterations);
+
+/**
+ * @brief 获取 int8 输入张量的量化参数
+ * @param out_scale 输出 scale
+ * @param out_zero_point 输出 zero point
+ */
+void model_module_get_input_quantization(float* out_scale, int32_t* out_zero_point);
+
+/**
+ * @brief 获取 int8 输出张量的量化参数（概率 = (分数 - zero point) x scale）
+ * @param out_scale 输出 scale
+ * @param out_zero_point 输出 zero point
+ */
+void model_module_get_output_quantization(float* out_scale, int32_t* out_zero_point);
+
+/**
+ * @brief 复制最近一次推理输出张量中的 int8 分数（不反量化）
+ * @param out_scores 输出数组
+ * @param max_scores 数组长度
+ * @return size_t 复制的分数个数；未初始化时为 0
+ */
+size_t model_module_output_scores(int8_t* out_scores, size_t max_scores);
+
+/**
+ * @brief 获取 int8 输入张量的数据区（直接写入即可，无需额外拷贝）
+ * @param out_length 输出张量长度（字节）
+ * @return int8_t* 输入张量数据指针，未初始化时为 nullptr
+ */
+int8_t* model_module_input_buffer(size_t* out_length);
+
+/**
+ * @brief 运行一次模型，并把 int8 输出反量化为概率
+ * @param out_scores 输出概率数组
+ * @param num_scores 数组长度（应等于类别数）
+ * @return true 推理成功
+ * @return false 推理失败
+ */
+bool model_module_invoke(float* out_scores, size_t num_scores);
+
+/**
+ * @brief 使流式推理的激活缓存失效（下一次调用会完整计算）
+ */
+void model_module_stream_reset();
+
+/**
+ * @brief 流式推理：缓存重叠窗口的卷积激活，只计算新进入窗口的时间列
+ * 与 model_module_invoke 的结果逐位一致；图结构与预期不符时自动回退到完整推理。
+ * @param window 环形 int8 窗口（量化格式与输入张量相同）
+ * @param head 最旧数据所在的位置（须为偶数）
+ * @param new_values 上一次调用以来写入窗口的值的个数（不小于窗口长度时完整计算）
+ * @param out_scores 输出概率数组
+ * @param num_scores 数组长度（应等于类别数）
+ * @return true 推理成功
+ * @return false 推理失败
+ */
+bool model_module_stream_invoke(const int8_t* window, size_t head, size_t new_values,
+                                float* out_scores, size_t num_scores);
+
+/**
+ * @brief 最近一次流式推理缓存的倒数第二层激活（第二层卷积输出，即全连接层的输入）
+ * 缓存按列环形存放：逻辑第 j 列位于第 (first_column + j) % columns 行，每行 channels 个 int8。
+ * 只在推理线程中、下一次推理之前读取。
+ * @return const int8_t* 缓存首地址；未启用流式推理或最近一次推理回退到完整图时为 nullptr
+ */
+const int8_t* model_module_stream_features(size_t* out_first_column, size_t* out_columns, size_t* out_channels);
+
+/**
+ * @brief 最近一次流式推理缓存的第一层池化输出（第二层卷积的输入，提前退出头读取的激活）
+ * 布局与 model_module_stream_features 相同，每行 channels 个 int8。只在推理线程中、下一次推理之前读取。
+ * @return const int8_t* 缓存首地址；未启用 MODEL_EARLY_EXIT 或最近一次推理回退到完整图时为 nullptr
+ */
+const int8_t* model_module_stream_pooled(size_t* out_first_column, size_t* out_columns, size_t* out_channels);
+
+/**
+ * @brief 提前退出统计（自启动以来，只统计运行了提前退出头的流式推理）
+ */
+struct model_early_exit_stats_t {
+    bool enabled;               // 提前退出头已加载并生效
+    uint32_t evaluated;         // 运行了提前退出头的窗口数
+    uint32_t taken;             // 在池化之后退出的窗口数
+    uint32_t early_mean_us;     // 提前退出窗口的平均推理耗时
+    uint32_t full_mean_us;      // 继续完整推理的窗口的平均耗时（含提前退出头本身）
+};
+
+/**
+ * @brief 获取提前退出统计；未启用 MODEL_EARLY_EXIT 时全部为 0
+ */
+void model_module_get_early_exit_stats(model_early_exit_stats_t* out_stats);
+
+/**
+ * @brief int8 域后处理的结果：只有获胜类别与第二名被反量化
+ */
+struct model_top_result_t {
+    int index;                   // 概率最高的类别；低于阈值或输出全为最小值时为 -1
+    int8_t score_q;              // 获胜类别的量化分数
+    float confidence;            // 获胜类别的概率
+    int top;                     // 概率最高的类别（不论阈值；并列时取序号最小者）
+    int runner_up;               // 概率第二高的类别（只有一个类别时为 -1）
+    float runner_up_confidence;  // 第二名的概率（主动学习采集按前两名的差距判断窗口是否含糊）
+};
+
+/**
+ * @brief 把概率阈值预先量化到输出张量的 int8 格式（向上取整）
+ * @param probability 概率阈值（0 ~ 1）
+ * @return int8_t 量化阈值；未初始化时为 -128（不过滤）
+ */
+int8_t model_module_quantize_score(float probability);
+
+/**
+ * @brief 与 model_module_stream_invoke 相同的推理，但在 int8 域完成 argmax 与阈值判定，
+ * 只反量化获胜类别的分数
+ * @param min_score_q 量化阈值（见 model_module_quantize_score），获胜分数低于它时 index 为 -1
+ * @param out_top 输出结果
+ * @return true 推理成功
+ * @return false 推理失败
+ */
+bool model_module_stream_invoke_top(const int8_t* window, size_t head, size_t new_values,
+                                    int8_t min_score_q, model_top_result_t* out_top);
+
+/**
+ * @brief 流式推理一层的内核变体（MODEL_KERNEL_AUTOTUNE）
+ */
+enum model_kernel_variant_t : uint8_t {
+    MODEL_KERNEL_GENERIC = 0,   // 通用流式内核
+    MODEL_KERNEL_SPECIALIZED,   // 按层形状特化的内核
+    MODEL_KERNEL_CMSIS_NN,      // CMSIS-NN 的 int8 矩阵乘
+    MODEL_KERNEL_VARIANTS,
+};
+
+/**
+ * @brief 流式推理中可以换内核的层
+ */
+enum model_kernel_layer_t {
+    MODEL_KERNEL_LAYER_POOL = 0,  // 第一层卷积 + 池化
+    MODEL_KERNEL_LAYER_CONV2,     // 第二层 1x1 卷积
+    MODEL_KERNEL_LAYER_FC,        // 全连接层
+    MODEL_KERNEL_LAYERS,
+};
+
+/**
+ * @brief 启动时实测得到的内核选择（存在 Flash 中，见 calib_store_save_kernels）
+ */
+struct model_kernel_choice_t {
+    uint32_t signature;                    // 固件构建与权重布局的签名，与当前不同时重新测量
+    uint8_t variant[MODEL_KERNEL_LAYERS];  // 各层选用的变体（model_kernel_variant_t）
+    uint8_t reserved;
+    uint16_t us[MODEL_KERNEL_LAYERS];      // 选中变体按完整窗口计的耗时（微秒）
+    uint16_t reserved2;
+};
+
+/**
+ * @brief 当前生效的内核选择
+ * @return false 未启用 MODEL_KERNEL_AUTOTUNE 或流式推理未就绪
+ */
+bool model_module_kernel_choice(model_kernel_choice_t* out_choice);
+
+#endif
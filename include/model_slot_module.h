@@ -0,0 +1,85 @@
+#ifndef MODEL_SLOT_MODULE_H
+#define MODEL_SLOT_MODULE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 模型权重的空中更新（MODEL_OTA_ENABLE）：flash 中有两个模型槽（见 calib_store），新的权重包
+// （include/model_blob.h）写入当前未使用的槽，接收完成并通过 CRC 后由推理线程在两次推理之间
+// 校验结构、用新权重重新初始化编译图并运行自检向量，全部通过才切换，并把槽号写入提交记录；
+// 任一步失败都保留原来的模型。启动时按提交记录载入槽中的权重，同样先校验再使用。
+//
+// 接收（start / write / finish）在 BLE 线程中调用，切换（apply）在推理线程中调用。
+
+enum model_slot_state_t {
+    MODEL_SLOT_BUILTIN = 0,  // 使用固件内置的权重
+    MODEL_SLOT_ACTIVE,       // 使用 flash 槽中的权重
+    MODEL_SLOT_RECEIVING,    // 正在接收新的权重包
+    MODEL_SLOT_PENDING,      // 已接收并通过 CRC，等待推理线程切换
+};
+
+enum model_slot_error_t {
+    MODEL_SLOT_OK = 0,
+    MODEL_SLOT_ERR_SIZE,     // 包长为 0 或超过 MODEL_SLOT_BYTES
+    MODEL_SLOT_ERR_FLASH,    // 擦除、写入或保存提交记录失败
+    MODEL_SLOT_ERR_OFFSET,   // 数据块不连续（status.received 为期望的偏移）
+    MODEL_SLOT_ERR_CRC,      // 长度不足或 CRC 不符
+    MODEL_SLOT_ERR_FORMAT,   // 包头或 entry 不合法
+    MODEL_SLOT_ERR_TENSOR,   // entry 与编译图中的张量不符（类型、长度、量化方式）
+    MODEL_SLOT_ERR_VERIFY,   // 新权重初始化失败，或自检向量的结果不符
+    MODEL_SLOT_ERR_STATE,    // 当前状态下不能执行该命令
+};
+
+struct model_slot_status_t {
+    uint8_t state;           // model_slot_state_t
+    uint8_t error;           // 最近一次失败的原因（model_slot_error_t）
+    uint8_t active_slot;     // 使用中的槽（0 / 1），内置权重时为 0xFF
+    uint32_t received;       // 本次已接收的字节数
+    uint32_t total;          // 本次权重包的长度
+    uint32_t version;        // 使用中的权重包版本（内置权重为 0）
+};
+
+/**
+ * @brief 启动时（模型初始化之前）调用：按提交记录载入槽中的权重，校验或自检失败时使用内置权重
+ */
+void model_slot_module_begin();
+
+/**
+ * @brief 开始接收一个权重包：擦除未使用的槽中需要的扇区（擦除期间 CPU 暂停，每 4 KB 约 85 ms）
+ * @param total_bytes 权重包长度
+ * @param crc32 权重包包头中的 crc32（覆盖包头 crc32 字段之后的全部字节）
+ */
+bool model_slot_module_start(uint32_t total_bytes, uint32_t crc32);
+
+/**
+ * @brief 写入一块数据：偏移须等于已接收的字节数，除最后一块外长度须为 4 的倍数
+ */
+bool model_slot_module_write(uint32_t offset, const uint8_t* data, size_t length);
+
+/**
+ * @brief 接收完成：检查长度与 CRC，通过后请求推理线程切换
+ */
+bool model_slot_module_finish();
+
+/**
+ * @brief 放弃正在接收的权重包（使用中的模型不变）
+ */
+void model_slot_module_abort();
+
+/**
+ * @brief 请求推理线程切回内置权重（同时清除提交记录）
+ */
+bool model_slot_module_request_builtin();
+
+/**
+ * @brief 推理线程在两次推理之间调用：执行待处理的切换
+ * @return true 模型权重已更换（调用者需重新读取输入 / 输出量化参数）
+ */
+bool model_slot_module_apply();
+
+/**
+ * @brief 当前状态（任意线程）
+ */
+void model_slot_module_get_status(model_slot_status_t* out_status);
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef MPSC_RING_H
+#define MPSC_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+/**
+ * @brief 无锁多生产者/单消费者环形缓冲区（有界，按槽位序号同步）
+ * 每个槽位带一个序号：生产者用 CAS 抢占写入位置，写完后把槽位序号置为“可读”；
+ * 消费者读完后把序号推进一圈，槽位重新变为“可写”。生产者之间、生产者与消费者之间都不加锁，
+ * 任意线程（以及中断）都可以写入；队列满时写入失败并计入 overrun，从不等待。
+ * 被抢占的生产者只会让消费者暂时停在它占住的槽位上，不会阻塞其它生产者。
+ * @tparam T 元素类型
+ * @tparam Capacity 容量（必须是 2 的幂）
+ */
+template <typename T, size_t Capacity>
+class MpscRing {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "MpscRing capacity must be a power of two");
+
+public:
+    MpscRing() : head_(0), tail_(0), overruns_(0) {
+        for (size_t i = 0; i < Capacity; i++) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief 写入一个元素（任意生产者）
+     * @return false 队列已满，元素被丢弃并计入 overrun
+     */
+    bool push(const T& value) {
+        size_t pos = head_.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells_[pos & (Capacity - 1)];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                // 槽位还没被消费者读走：满了
+                overruns_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = value;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 读取一个元素（仅消费者调用）
+     * @return false 没有已写完的元素
+     */
+    bool pop(T* out) {
+        const size_t pos = tail_.load(std::memory_order_relaxed);
+        Cell& cell = cells_[pos & (Capacity - 1)];
+        if (cell.sequence.load(std::memory_order_acquire) != pos + 1) {
+            return false;
+        }
+        *out = cell.value;
+        cell.sequence.store(pos + Capacity, std::memory_order_release);
+        tail_.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /** 因队列满被丢弃的元素数 */
+    uint32_t overruns() const { return overruns_.load(std::memory_order_relaxed); }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    Cell cells_[Capacity];
+    std::atomic<size_t> head_;
+    std::atomic<size_t> tail_;
+    std::atomic<uint32_t> overruns_;
+};
+
+#endif
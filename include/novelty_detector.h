@@ -0,0 +1,95 @@
+#ifndef NOVELTY_DETECTOR_H
+#define NOVELTY_DETECTOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief 新颖性（未知手势）检测：倒数第二层激活到最近 K-means 聚类中心的平方距离超过该中心的半径即判为新颖
+ * 激活直接取流式推理已缓存的第二层卷积输出（全连接层的输入，int8），不再运行第二个模型；聚类中心与半径由
+ * pc_controller/novelty_trainer.py 在录制的数据集上训练并生成 include/novelty_model.h。
+ * 中心与半径只保存指针（常量表留在 flash 中），对象内不分配缓冲区。
+ * @tparam Rows 激活的列数（环形缓存的行数）
+ * @tparam RowLen 每列的通道数
+ */
+template <size_t Rows, size_t RowLen>
+class NoveltyDetector {
+public:
+    NoveltyDetector()
+        : centroids_(nullptr), radii_(nullptr), clusters_(0), evaluated_(0), rejected_(0), distance_(0),
+          cluster_(-1) {}
+
+    /**
+     * @param centroids 聚类中心（clusters 个，每个按逻辑列顺序 Rows x RowLen 个 int8）
+     * @param radii 各中心的半径（平方距离）
+     * @param clusters 中心个数；0 = 关闭检测
+     */
+    void configure(const int8_t* centroids, const uint32_t* radii, size_t clusters) {
+        centroids_ = centroids;
+        radii_ = radii;
+        clusters_ = centroids != nullptr && radii != nullptr ? clusters : 0;
+    }
+
+    /**
+     * @brief 判定一次激活是否新颖，并计入统计
+     * @param rows 激活的环形缓存（Rows 行，每行 RowLen 个值）
+     * @param first_row 逻辑第 0 列所在的行
+     * @return true 到最近中心的距离超过其半径（分布外的窗口）
+     */
+    bool check(const int8_t (*rows)[RowLen], size_t first_row) {
+        if (clusters_ == 0) {
+            return false;
+        }
+        evaluated_++;
+
+        uint32_t best = UINT32_MAX;
+        int best_cluster = -1;
+        for (size_t k = 0; k < clusters_; k++) {
+            const int8_t* centroid = &centroids_[k * Rows * RowLen];
+            uint32_t d = 0;
+            // 部分和已不小于当前最近距离时提前结束这个中心
+            for (size_t j = 0; j < Rows && d < best; j++) {
+                const int8_t* row = rows[(first_row + j) % Rows];
+                const int8_t* c = &centroid[j * RowLen];
+                for (size_t i = 0; i < RowLen; i++) {
+                    const int32_t diff = (int32_t)row[i] - (int32_t)c[i];
+                    d += (uint32_t)(diff * diff);
+                }
+            }
+            if (d < best) {
+                best = d;
+                best_cluster = (int)k;
+            }
+        }
+
+        distance_ = best;
+        cluster_ = best_cluster;
+        if (best <= radii_[best_cluster]) {
+            return false;
+        }
+        rejected_++;
+        return true;
+    }
+
+    /**
+     * @brief 最近一次判定中到最近中心的平方距离与该中心的序号
+     */
+    uint32_t distance() const { return distance_; }
+    int cluster() const { return cluster_; }
+    uint32_t radius() const { return cluster_ >= 0 ? radii_[cluster_] : 0; }
+
+    size_t clusters() const { return clusters_; }
+    uint32_t evaluated() const { return evaluated_; }
+    uint32_t rejected() const { return rejected_; }
+
+private:
+    const int8_t* centroids_;
+    const uint32_t* radii_;
+    size_t clusters_;
+    uint32_t evaluated_;
+    uint32_t rejected_;
+    uint32_t distance_;
+    int cluster_;
+};
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef NOVELTY_MODEL_H
+#define NOVELTY_MODEL_H
+
+// 新颖性检测的 K-means 聚类中心与半径（见 novelty_detector.h）
+// 由 pc_controller/novelty_trainer.py 生成；尚未训练时没有中心，检测器不拒绝任何窗口
+
+#include <stdint.h>
+
+#define NOVELTY_MODEL_CLUSTERS 0
+#define NOVELTY_MODEL_COLUMNS 36
+#define NOVELTY_MODEL_CHANNELS 10
+
+static const int8_t kNoveltyCentroids[1] = {0};
+static const uint32_t kNoveltyRadii[1] = {0};
+
+#endif
@@ -0,0 +1,202 @@
+#ifndef ONSET_HEAD_H
+#define ONSET_HEAD_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief 手势起始的前缀分类头：只看窗口中最新的 prefix 帧（手势的开头），在完整窗口能识别之前给出临时判定
+ * 特征为前缀内各轴的均值与标准差（物理单位），softmax 回归的权重已折入标准化；由
+ * pc_controller/onset_trainer.py 在截短的窗口上训练（目标是完整模型之后对该手势的判定），生成 onset_model.h。
+ * 代价是一遍前缀与几十次乘加，远小于一次推理。
+ */
+class OnsetHead {
+public:
+    static const size_t kMaxAxes = 6;
+    static const size_t kMaxClasses = 8;
+
+    OnsetHead()
+        : weights_(nullptr), bias_(nullptr), classes_(0), axes_(0), prefix_frames_(0), class_mask_(0),
+          threshold_(1.0f) {}
+
+    /**
+     * @param weights classes x (2 x axes) 的权重（先各轴均值、后各轴标准差）
+     * @param classes 类别数（0 = 未训练，不给出判定）
+     * @param class_mask 允许给出临时判定的类别（位 i = 类别 i，不含 idle）
+     * @param threshold 临时判定所需的最低概率
+     */
+    void configure(const float* weights, const float* bias, size_t classes, size_t axes, size_t prefix_frames,
+                   uint32_t class_mask, float threshold) {
+        const bool valid = classes <= kMaxClasses && axes > 0 && axes <= kMaxAxes && prefix_frames >= 2;
+        weights_ = weights;
+        bias_ = bias;
+        classes_ = valid ? classes : 0;
+        axes_ = axes;
+        prefix_frames_ = prefix_frames;
+        class_mask_ = class_mask;
+        threshold_ = threshold;
+    }
+
+    bool enabled() const { return classes_ > 0 && class_mask_ != 0; }
+    size_t prefix_frames() const { return prefix_frames_; }
+
+    /**
+     * @brief 对窗口最新的前缀给出临时判定
+     * @param window 按帧交错存放的环形窗口
+     * @param length 窗口值的个数（axes 的整数倍，不少于前缀）
+     * @param head 最旧的值的位置（最新的一帧紧挨在它之前）
+     * @param scale, offset 窗口值到物理单位：(value - offset) x scale（int8 窗口为输入量化参数，浮点窗口为 1 与 0）
+     * @param out_probability 输出最高类别的概率
+     * @return 达到阈值且允许临时判定的类别，否则 -1
+     */
+    template <typename T>
+    int evaluate(const T* window, size_t length, size_t head, float scale, float offset,
+                 float* out_probability) const {
+        *out_probability = 0.0f;
+        const size_t span = prefix_frames_ * axes_;
+        if (!enabled() || span > length) {
+            return -1;
+        }
+        float sum[kMaxAxes] = {0};
+        float sum_sq[kMaxAxes] = {0};
+        size_t i = (head + length - span) % length;
+        for (size_t f = 0; f < prefix_frames_; f++) {
+            for (size_t a = 0; a < axes_; a++) {
+                const float v = ((float)window[i + a] - offset) * scale;
+                sum[a] += v;
+                sum_sq[a] += v * v;
+            }
+            i += axes_;
+            if (i >= length) {
+                i = 0;
+            }
+        }
+        float features[2 * kMaxAxes];
+        const float frames = (float)prefix_frames_;
+        for (size_t a = 0; a < axes_; a++) {
+            const float mean = sum[a] / frames;
+            const float variance = sum_sq[a] / frames - mean * mean;
+            features[a] = mean;
+            features[axes_ + a] = variance > 0.0f ? sqrtf(variance) : 0.0f;
+        }
+
+        float logits[kMaxClasses];
+        float top_logit = -INFINITY;
+        int top = 0;
+        const size_t count = 2 * axes_;
+        for (size_t k = 0; k < classes_; k++) {
+            float logit = bias_[k];
+            const float* row = weights_ + k * count;
+            for (size_t j = 0; j < count; j++) {
+                logit += row[j] * features[j];
+            }
+            logits[k] = logit;
+            if (logit > top_logit) {
+                top_logit = logit;
+                top = (int)k;
+            }
+        }
+        float total = 0.0f;
+        for (size_t k = 0; k < classes_; k++) {
+            total += expf(logits[k] - top_logit);
+        }
+        *out_probability = 1.0f / total;
+        if (((class_mask_ >> top) & 1u) == 0 || *out_probability < threshold_) {
+            return -1;
+        }
+        return top;
+    }
+
+private:
+    const float* weights_;
+    const float* bias_;
+    size_t classes_;
+    size_t axes_;
+    size_t prefix_frames_;
+    uint32_t class_mask_;
+    float threshold_;
+};
+
+/**
+ * @brief 临时判定的确认与撤销
+ * idle → provisional（前缀头给出一个完整模型尚未报告的手势）→ 完整模型判定同一手势时 confirmed；
+ * 判定为另一个手势、或 horizon 帧内仍未判定时 canceled。一次判定结束后，前缀头须先回到阈值以下才能给出下一次
+ * （同一个手势不会被临时判定多次）。帧号为进入窗口的累计帧数，差值按无符号运算。
+ */
+class OnsetTracker {
+public:
+    enum Output { kNone, kProvisional, kConfirmed, kCanceled };
+
+    OnsetTracker()
+        : horizon_frames_(0), label_(-1), onset_frame_(0), last_result_(-1), pending_(false), armed_(true),
+          onsets_(0), confirmed_(0), canceled_(0), lead_frames_total_(0) {}
+
+    /**
+     * @param horizon_frames 临时判定之后等待完整模型确认的最多帧数
+     */
+    void configure(uint32_t horizon_frames) { horizon_frames_ = horizon_frames; }
+
+    /**
+     * @brief 每次推理前喂入前缀头的判定（-1 = 未达到阈值）
+     */
+    Output on_head(int index, uint32_t frame) {
+        if (index < 0) {
+            armed_ = true;
+            return kNone;
+        }
+        if (pending_ || !armed_ || index == last_result_) {
+            return kNone;
+        }
+        pending_ = true;
+        armed_ = false;
+        label_ = index;
+        onset_frame_ = frame;
+        onsets_++;
+        return kProvisional;
+    }
+
+    /**
+     * @brief 每次推理后喂入完整窗口的判定（-1 = 无 / 低于阈值）
+     */
+    Output on_result(int index, uint32_t frame, int idle_index) {
+        last_result_ = index;
+        if (!pending_) {
+            return kNone;
+        }
+        if (index == label_) {
+            pending_ = false;
+            confirmed_++;
+            lead_frames_total_ += frame - onset_frame_;
+            return kConfirmed;
+        }
+        if ((index >= 0 && index != idle_index) || frame - onset_frame_ > horizon_frames_) {
+            pending_ = false;
+            canceled_++;
+            return kCanceled;
+        }
+        return kNone;
+    }
+
+    int label() const { return label_; }
+    uint32_t onset_frame() const { return onset_frame_; }
+    uint32_t onsets() const { return onsets_; }
+    uint32_t confirmed() const { return confirmed_; }
+    uint32_t canceled() const { return canceled_; }
+    // 确认的临时判定比完整模型提前的帧数之和
+    uint64_t lead_frames_total() const { return lead_frames_total_; }
+
+private:
+    uint32_t horizon_frames_;
+    int label_;
+    uint32_t onset_frame_;
+    int last_result_;
+    bool pending_;
+    bool armed_;
+    uint32_t onsets_;
+    uint32_t confirmed_;
+    uint32_t canceled_;
+    uint64_t lead_frames_total_;
+};
+
+#endif
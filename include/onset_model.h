@@ -0,0 +1,20 @@
+#ifndef ONSET_MODEL_H
+#define ONSET_MODEL_H
+
+// 手势起始的前缀分类头（见 onset_head.h）
+// 由 pc_controller/onset_trainer.py 生成；尚未训练时没有类别，不给出临时判定
+
+#include <stdint.h>
+
+#define ONSET_MODEL_CLASSES 0
+#define ONSET_MODEL_AXES 3
+#define ONSET_MODEL_FEATURES 6
+#define ONSET_MODEL_PREFIX_FRAMES 10
+#define ONSET_MODEL_HORIZON_FRAMES 18
+
+static const float kOnsetWeights[1] = {0.0f};
+static const float kOnsetBias[1] = {0.0f};
+static const uint32_t kOnsetClassMask = 0;
+static const float kOnsetThreshold = 1.0f;
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef PERIODIC_TIMER_H
+#define PERIODIC_TIMER_H
+
+#include <stdint.h>
+#include <chrono>
+#include "hal.h"
+
+/**
+ * @brief 周期任务的绝对截止时间节拍（Kernel::Clock，1 ms 分辨率）
+ * 每个周期的截止时间 = 上一个截止时间 + 周期，而不是"做完工作再睡一个周期"，
+ * 因此工作耗时不会累积成周期漂移。某次工作超过了下一个截止时间时，错过的周期整体跳过（不连续补跑），
+ * 计入 overruns()，并记录最大迟到时间。单线程使用：只由拥有它的任务调用。
+ */
+class PeriodicTimer {
+public:
+    typedef hal::Clock Clock;
+
+    explicit PeriodicTimer(std::chrono::milliseconds period)
+        : period_(period), next_(Clock::now() + period), overruns_(0), max_late_ms_(0) {}
+
+    /**
+     * @brief 修改周期（与当前相同时不做任何事）；新周期从现在起算
+     */
+    void set_period(std::chrono::milliseconds period) {
+        if (period != period_) {
+            period_ = period;
+            next_ = Clock::now() + period;
+        }
+    }
+
+    std::chrono::milliseconds period() const { return period_; }
+
+    /**
+     * @brief 从现在起重新计时（用于有意暂停过节拍的任务，不计入 overruns）
+     */
+    void restart() { next_ = Clock::now() + period_; }
+
+    /**
+     * @brief 当前截止时间是否已到
+     */
+    bool expired() const { return Clock::now() >= next_; }
+
+    /**
+     * @brief 距当前截止时间的剩余时间（已到时为 0），用作事件等待的超时
+     */
+    std::chrono::milliseconds remaining() const {
+        const Clock::time_point now = Clock::now();
+        return now >= next_ ? std::chrono::milliseconds(0)
+                            : std::chrono::duration_cast<std::chrono::milliseconds>(next_ - now);
+    }
+
+    /**
+     * @brief 截止时间后移一个周期（在截止时间到达、本周期的工作开始时调用）
+     * @return false 已错过下一个截止时间，跳过的周期计入 overruns()
+     */
+    bool advance() {
+        const Clock::time_point now = Clock::now();
+        const uint32_t late_ms = now > next_ ? (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+                                                   now - next_).count()
+                                             : 0;
+        if (late_ms > max_late_ms_) {
+            max_late_ms_ = late_ms;
+        }
+        next_ += period_;
+        if (next_ > now) {
+            return true;
+        }
+        const uint32_t missed = (uint32_t)((now - next_) / period_) + 1;
+        overruns_ += missed;
+        next_ += period_ * missed;
+        return false;
+    }
+
+    /**
+     * @brief 睡到当前截止时间（已过则不睡），然后后移一个周期
+     * @return false 有周期被跳过
+     */
+    bool wait() {
+        if (!expired()) {
+            hal::sleep_until(next_);
+        }
+        return advance();
+    }
+
+    uint32_t overruns() const { return overruns_; }
+    uint32_t max_late_ms() const { return max_late_ms_; }
+
+private:
+    std::chrono::milliseconds period_;
+    Clock::time_point next_;
+    uint32_t overruns_;
+    uint32_t max_late_ms_;
+};
+
+#endif
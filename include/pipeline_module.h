@@ -0,0 +1,89 @@
+#ifndef PIPELINE_MODULE_H
+#define PIPELINE_MODULE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 处理流水线：采集 → 窗口 → 推理 → 后处理 → 发布（BLE / LED）
+// 每一级由线程表中的一个线程运行（见 kStageTable），相邻两级之间是有界队列（include/pipeline_queue.h），
+// 同一线程上的相邻两级直接调用、共享滑动窗口。各级每运行一次记录耗时，输入队列的深度在上一级写入后记录；
+// 每个统计窗口（IMU_RATE_WINDOW_MS）打印一次各级的运行次数、平均 / 最大耗时与队列峰值，然后开始新的窗口。
+
+enum pipeline_stage_t {
+    PIPELINE_ACQUIRE = 0,   // IMU 读出、（流水线输入时）量化并写入样本队列
+    PIPELINE_WINDOW,        // 一步样本出队进入滑动窗口，更新时间戳与采样统计
+    PIPELINE_INFER,         // 模型推理（被 idle 预筛跳过时不计）
+    PIPELINE_POSTPROCESS,   // 平滑、事件检测与结果发布
+    PIPELINE_BLE,           // 结果事件打包通知
+    PIPELINE_LED,           // 结果转为 LED 动画
+    PIPELINE_STAGE_COUNT
+};
+
+/**
+ * @brief 可选的产出：各有自己的消费者。生产者在产出前查询订阅登记，没有消费者的一级整个跳过
+ * （不计算、不入队、不唤醒下游），而不是算出来再丢弃。订阅由消费者一方按 CCCD / USB 订阅与运行时配置登记。
+ */
+enum pipeline_output_t {
+    PIPELINE_OUTPUT_EVENTS = 0,  // 结果事件交给 BLE 线程（有 BLE / USB 会话，或广播模式）
+    PIPELINE_OUTPUT_LED,         // 结果转为 LED 动画（LED 阈值小于 1）
+    PIPELINE_OUTPUT_SCORES,      // 每次推理的原始分数（订阅了分数流）
+    PIPELINE_OUTPUT_WINDOW,      // 送入模型的样本（订阅了窗口流）
+    PIPELINE_OUTPUT_COUNT
+};
+
+/**
+ * @brief 一级在一个统计窗口内的运行情况
+ */
+struct pipeline_stage_stats_t {
+    uint32_t runs;
+    uint32_t mean_us;
+    uint32_t max_us;
+    uint32_t busy_permille;  // 耗时之和占窗口时长的千分比
+    uint16_t queue_peak;     // 窗口内输入队列的最大深度（元素数）
+    uint16_t queue_capacity; // 0 = 与上一级在同一线程，没有输入队列
+    uint32_t overruns;       // 输入队列满而丢弃的写入次数（自启动以来）
+};
+
+/**
+ * @brief 把各级的耗时分布与输入队列丢弃数登记到统计注册表（启动时调用一次）
+ */
+void pipeline_module_init();
+
+/**
+ * @brief 记录一级的一次运行（任意线程，无锁；每一级只在一个线程中记录）
+ * @param stage 流水线级
+ * @param start_us 本次运行开始的 micros()
+ */
+void pipeline_module_record(pipeline_stage_t stage, uint32_t start_us);
+
+/**
+ * @brief 记录一级输入队列的当前状态（由写入队列的上一级在写入后调用，无锁）
+ */
+void pipeline_module_record_queue(pipeline_stage_t stage, size_t depth, size_t capacity, uint32_t overruns);
+
+/**
+ * @brief 登记一个产出是否有消费者（任意线程）；启动时结果事件与 LED 有消费者，分数流与窗口流没有
+ */
+void pipeline_module_subscribe(pipeline_output_t output, bool subscribed);
+
+/**
+ * @brief 产出是否有消费者（任意线程，无锁；生产者每次产出前调用）
+ */
+bool pipeline_module_subscribed(pipeline_output_t output);
+
+/**
+ * @brief 读取上一个统计窗口的统计（任意线程，无锁，不阻塞记录与报告）
+ */
+void pipeline_module_get_stats(pipeline_stage_t stage, pipeline_stage_stats_t* out_stats);
+
+/**
+ * @brief 一级的名称（与 [Pipeline] 日志中相同，例如 "infer"）
+ */
+const char* pipeline_module_stage_name(pipeline_stage_t stage);
+
+/**
+ * @brief 结束当前统计窗口（只由一个线程调用）：发布快照、每级打印一行 [Pipeline]（没有消费者而被移出的一级标注出来），并开始新的窗口
+ */
+void pipeline_module_report();
+
+#endif
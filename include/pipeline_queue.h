@@ -0,0 +1,54 @@
+#ifndef PIPELINE_QUEUE_H
+#define PIPELINE_QUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <chrono>
+#include "hal.h"
+#include "spsc_ring.h"
+
+/**
+ * @brief 流水线相邻两级之间的有界队列：无锁 SPSC 环形缓冲加一个唤醒标志
+ * 上一级 push() 后调用 notify() 唤醒下一级；两者分开，生产者可以先释放自己持有的锁再唤醒，
+ * 避免被唤醒的高优先级线程立即阻塞在同一把锁上。下一级在 pop() 失败后 wait()，
+ * notify() 先于 wait() 发生时 wait() 立即返回，不会丢失唤醒。
+ * 队列满时 push() 丢弃整组并计入 overruns()，上一级从不等待下一级。
+ * @tparam T 元素类型
+ * @tparam Capacity 容量（元素数，必须是 2 的幂）
+ */
+template <typename T, size_t Capacity>
+class PipelineQueue {
+public:
+    bool push(const T* values, size_t n) { return ring_.push(values, n); }
+
+    /**
+     * @brief 唤醒等待中的下一级（或让它的下一次 wait() 立即返回）
+     */
+    void notify() { flags_.set(kPushedFlag); }
+
+    bool pop(T* out, size_t n) { return ring_.pop(out, n); }
+
+    /**
+     * @brief 等待上一级 notify()
+     * @param timeout 最长等待时间（std::chrono::milliseconds(osWaitForever) = 一直等待）
+     * @return true 被唤醒
+     * @return false 超时
+     */
+    bool wait(std::chrono::milliseconds timeout) {
+        const uint32_t flags = flags_.wait_any_for(kPushedFlag, timeout);
+        return (flags & hal::kFlagsError) == 0 && (flags & kPushedFlag) != 0;
+    }
+
+    size_t size() const { return ring_.size(); }
+    static constexpr size_t capacity() { return Capacity; }
+    uint32_t overruns() const { return ring_.overruns(); }
+    size_t high_water() const { return ring_.high_water(); }
+
+private:
+    static const uint32_t kPushedFlag = 0x1;
+
+    SpscRing<T, Capacity> ring_;
+    hal::EventFlags flags_;
+};
+
+#endif
@@ -0,0 +1,168 @@
+#ifndef PROFILER_MODULE_H
+#define PROFILER_MODULE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "app_config.h"
+
+#if PROFILER_ZONES_ENABLE
+#if defined(INFERENCE_HOST_REPLAY)
+#include <chrono>
+#else
+#include <Arduino.h>
+#endif
+#include <atomic>
+#endif
+
+// 区段剖析：热路径上只读周期计数器并把 {区段, 开始, 周期数} 写进静态环形缓冲（满后覆盖最旧的），
+// 不格式化、不加锁；串口 "zones" 时才由录制线程取快照并打印，pc_controller/zone_timeline.py 把导出画成
+// 按线程分道的时间线/火焰图。区段可以嵌套（infer 包含 classify），嵌套关系由主机按时间区间还原。
+// 目标板用 DWT CYCCNT（64 MHz，约 67 s 回绕一次），主机回放用 steady_clock（按 62.5 MHz 计）。
+// PROFILER_ZONES_ENABLE 为 0 时所有接口都是空的内联函数，调用点不产生任何代码。
+
+// 顺序与 kZoneTable（src/profiler_module.cpp）一致
+enum profiler_zone_t {
+    ZONE_ACQUIRE = 0,   // 采样线程：一批 IMU 帧入队
+    ZONE_WINDOW,        // 一步样本进入滑动窗口
+    ZONE_INFER,         // 一次推理（分类与后处理）
+    ZONE_CLASSIFY,      // 模型调用（浮点路径含 DSP）
+    ZONE_POSTPROCESS,   // 平滑、事件检测与结果发布
+    ZONE_BLE,           // 结果事件打包通知
+    ZONE_LED,           // 结果转为 LED 动画
+    ZONE_COUNT
+};
+
+/**
+ * @brief 环形缓冲中的一条区段记录
+ */
+struct profiler_zone_record_t {
+    uint32_t start_cycles;
+    uint32_t cycles;
+    uint8_t zone;         // profiler_zone_t
+    uint8_t reserved[3];
+};
+
+/**
+ * @brief 区段快照的头部（取快照时刻的计数器与时钟）
+ */
+struct profiler_zone_snapshot_t {
+    uint32_t now_cycles;
+    uint32_t clock_hz;
+    uint32_t recorded;    // 自启动以来写入的区段数（超出容量的部分已被覆盖）
+    size_t count;         // 复制出的记录数，从旧到新
+};
+
+#if PROFILER_ZONES_ENABLE
+
+// 仅供下面的内联函数使用
+extern profiler_zone_record_t g_profiler_zones[PROFILER_ZONE_CAPACITY];
+extern std::atomic<uint32_t> g_profiler_zone_head;
+extern volatile bool g_profiler_zones_paused;
+
+static_assert((PROFILER_ZONE_CAPACITY & (PROFILER_ZONE_CAPACITY - 1)) == 0,
+              "PROFILER_ZONE_CAPACITY must be a power of two");
+
+/**
+ * @brief 打开周期计数器（启动时调用一次，不清零计数器）
+ */
+void profiler_module_init();
+
+/**
+ * @brief 当前周期计数
+ */
+static inline uint32_t profiler_zone_now() {
+#if defined(INFERENCE_HOST_REPLAY)
+    return (uint32_t)(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::steady_clock::now().time_since_epoch()).count() / 16);
+#else
+    return DWT->CYCCNT;
+#endif
+}
+
+/**
+ * @brief 记录一个从 start_cycles 到现在的区段（任意线程；槽位由原子计数分配）
+ */
+static inline void profiler_zone_record(profiler_zone_t zone, uint32_t start_cycles) {
+    const uint32_t end_cycles = profiler_zone_now();
+    if (g_profiler_zones_paused) {
+        return;
+    }
+    const uint32_t slot = g_profiler_zone_head.fetch_add(1, std::memory_order_relaxed) & (PROFILER_ZONE_CAPACITY - 1);
+    profiler_zone_record_t& record = g_profiler_zones[slot];
+    record.start_cycles = start_cycles;
+    record.cycles = end_cycles - start_cycles;
+    record.zone = (uint8_t)zone;
+}
+
+/**
+ * @brief 暂停记录并复制环形缓冲（从旧到新），复制完继续记录
+ * 与暂停前已开始写入的记录可能交错，个别记录不完整；只用于离线查看。
+ * @param out_records 至少 PROFILER_ZONE_CAPACITY 条
+ */
+void profiler_module_snapshot(profiler_zone_record_t* out_records, profiler_zone_snapshot_t* out_snapshot);
+
+/**
+ * @brief 自启动以来写入的区段数（追踪流读游标的起点）
+ */
+static inline uint32_t profiler_module_head() {
+    return g_profiler_zone_head.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief 周期计数器的频率
+ */
+uint32_t profiler_module_clock_hz();
+
+/**
+ * @brief 不暂停记录，取出读游标之后写入的记录（追踪流与诊断命令用，每个读者有自己的游标）
+ * 与快照一样，被读者抢占时正在写入的那条可能不完整。
+ * @param cursor 读游标（记录序号，初值取 profiler_module_head()），调用后前移到下一条未读的记录
+ * @param out_records 至少 max_records 条，从旧到新
+ * @param out_lost 输出游标之后来不及读出、已被覆盖的记录数
+ * @return 复制出的记录数
+ */
+size_t profiler_module_read(uint32_t* cursor, profiler_zone_record_t* out_records, size_t max_records,
+                            uint32_t* out_lost);
+
+/**
+ * @brief 区段名称与所在线程（thread_module 线程表中的名字）
+ */
+const char* profiler_module_zone_name(profiler_zone_t zone);
+const char* profiler_module_zone_thread(profiler_zone_t zone);
+
+/**
+ * @brief 取快照并逐行导出（pc_controller/zone_timeline.py 的输入格式）：
+ *   [Zones] clock <hz> recorded <n> count <m>
+ *   [Zones] zone <id> <name> <thread>            每个区段一行
+ *   [Zones] Z <id> <start_age> <cycles>          每条记录一行，从旧到新；start_age = 快照时刻减开始时刻（周期）
+ *   [Zones] end
+ * @param emit 每行调用一次（含换行符）；在调用线程中直接输出，不经过日志队列
+ */
+void profiler_module_dump(void (*emit)(const char* line));
+
+#else
+
+static inline void profiler_module_init() {}
+static inline uint32_t profiler_zone_now() { return 0; }
+static inline void profiler_zone_record(profiler_zone_t, uint32_t) {}
+static inline void profiler_module_dump(void (*emit)(const char* line)) { emit("[Zones] disabled (PROFILER_ZONES_ENABLE=0)\n"); }
+
+#endif
+
+/**
+ * @brief 作用域区段：构造时读计数器，析构时记录
+ */
+class ProfilerZoneScope {
+public:
+    explicit ProfilerZoneScope(profiler_zone_t zone) : zone_(zone), start_(profiler_zone_now()) {}
+    ~ProfilerZoneScope() { profiler_zone_record(zone_, start_); }
+
+    ProfilerZoneScope(const ProfilerZoneScope&) = delete;
+    ProfilerZoneScope& operator=(const ProfilerZoneScope&) = delete;
+
+private:
+    profiler_zone_t zone_;
+    uint32_t start_;
+};
+
+#endif
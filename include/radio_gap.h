@@ -0,0 +1,160 @@
+#ifndef RADIO_GAP_H
+#define RADIO_GAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 连接事件时序的学习与推理放置（纯计算，无硬件依赖；radio_module 在射频中断里喂入时刻，推理线程据此决定何时 invoke）
+// 时间全部是 32 位微秒计数，差值按无符号运算（约 71 分钟回绕不影响）。
+//
+// 射频每次收发前后各有一个时刻（RADIO READY / DISABLED）；与上一次收发相隔超过 kEventSplitUs 的开始是一个新连接事件的锚点。
+// 相邻锚点的间隔是连接间隔的整数倍（外设延迟跳过的事件、漏掉的中断），取整后与当前估计相差不超过 kToleranceUs 即确认并
+// 缓慢跟随（两端时钟的漂移），连续 kRelearnAfter 次对不上（连接参数更新、另一个中心设备）则改用新的间隔重新学习。
+// 事件长度取最近事件的衰减最大值（每个事件衰减 1/8）：一个事件内包数随数据量变化，估计偏长比偏短安全。
+
+enum radio_gap_kind_t {
+    RADIO_GAP_UNTIMED = 0,  // 尚未学到时序，或最近没有射频活动：不放置
+    RADIO_GAP_FITS,         // 现在开始能在下一个事件之前完成
+    RADIO_GAP_DEFER,        // 推迟 defer_us 到当前 / 下一个事件结束之后
+    RADIO_GAP_NO_FIT        // 推理比任何空隙都长（或推迟超过上限）：原地运行
+};
+
+struct radio_gap_decision_t {
+    radio_gap_kind_t kind;
+    uint32_t defer_us;
+};
+
+class RadioGapPredictor {
+public:
+    // 同一事件内两次收发相隔 T_IFS（150 us）加一个包长，最长约 2.1 ms（1M PHY 上 251 字节的包）
+    static const uint32_t kEventSplitUs = 2500;
+    static const uint32_t kToleranceUs = 400;
+    static const uint32_t kRelearnAfter = 3;
+    // 锚点间隔最多按这么多个连接间隔取整（更长的沉默按失去时序处理）
+    static const uint32_t kMaxSkipped = 8;
+    // 连接间隔的范围（BLE 规范：7.5 ms ~ 4 s）
+    static const uint32_t kMinIntervalUs = 7500;
+    static const uint32_t kMaxIntervalUs = 4000000;
+
+    RadioGapPredictor() { reset(); }
+
+    void reset() {
+        anchor_us_ = 0;
+        last_end_us_ = 0;
+        interval_us_ = 0;
+        event_us_ = 0;
+        mismatches_ = 0;
+        has_anchor_ = false;
+    }
+
+    /**
+     * @brief 射频开始一次收发（RADIO READY）
+     */
+    void on_radio_start(uint32_t t_us) {
+        if (has_anchor_ && t_us - last_end_us_ <= kEventSplitUs) {
+            return;
+        }
+        if (has_anchor_) {
+            close_event();
+            learn_period(t_us - anchor_us_);
+        }
+        anchor_us_ = t_us;
+        has_anchor_ = true;
+    }
+
+    /**
+     * @brief 射频结束一次收发（RADIO DISABLED）
+     */
+    void on_radio_end(uint32_t t_us) {
+        last_end_us_ = t_us;
+        const uint32_t length = t_us - anchor_us_;
+        if (has_anchor_ && length > event_us_ && length < kEventSplitUs * 4) {
+            event_us_ = length;
+        }
+    }
+
+    /**
+     * @brief 已学到连接间隔，且最近几个间隔内见过事件
+     */
+    bool locked(uint32_t now_us) const {
+        return interval_us_ != 0 && has_anchor_ && now_us - anchor_us_ < kMaxSkipped * interval_us_;
+    }
+
+    uint32_t interval_us() const { return interval_us_; }
+    uint32_t event_us() const { return event_us_; }
+
+    /**
+     * @brief 一次耗时 busy_us 的推理何时开始
+     * 现在开始会与下一个事件重叠（或现在正处于事件中）时推迟到该事件结束后 guard_us；任何空隙都放不下 busy_us，
+     * 或推迟会超过 max_defer_us 时原地运行
+     */
+    radio_gap_decision_t decide(uint32_t now_us, uint32_t busy_us, uint32_t guard_us, uint32_t max_defer_us) const {
+        radio_gap_decision_t decision = {RADIO_GAP_UNTIMED, 0};
+        if (!locked(now_us)) {
+            return decision;
+        }
+        if (busy_us + event_us_ + 2 * guard_us > interval_us_) {
+            decision.kind = RADIO_GAP_NO_FIT;
+            return decision;
+        }
+        // 现在所在的间隔：从最近一个预测锚点开始
+        const uint32_t since = now_us - anchor_us_;
+        const uint32_t current = anchor_us_ + (since / interval_us_) * interval_us_;
+        const uint32_t quiet_from = current + event_us_ + guard_us;
+        const uint32_t next = current + interval_us_;
+        uint32_t start = now_us;
+        if ((int32_t)(now_us - quiet_from) < 0) {
+            start = quiet_from;
+        } else if ((int32_t)(next - guard_us - (now_us + busy_us)) < 0) {
+            start = next + event_us_ + guard_us;
+        }
+        decision.defer_us = start - now_us;
+        if (decision.defer_us == 0) {
+            decision.kind = RADIO_GAP_FITS;
+        } else if (decision.defer_us <= max_defer_us) {
+            decision.kind = RADIO_GAP_DEFER;
+        } else {
+            decision.kind = RADIO_GAP_NO_FIT;
+            decision.defer_us = 0;
+        }
+        return decision;
+    }
+
+private:
+    void close_event() {
+        // 新事件开始时上一个事件的长度已记录在 event_us_ 中：衰减，让偶尔的长事件慢慢淡出
+        event_us_ -= event_us_ / 8;
+    }
+
+    void learn_period(uint32_t period_us) {
+        if (interval_us_ == 0 || mismatches_ >= kRelearnAfter) {
+            if (period_us >= kMinIntervalUs && period_us <= kMaxIntervalUs) {
+                interval_us_ = period_us;
+            }
+            mismatches_ = 0;
+            return;
+        }
+        const uint32_t n = (period_us + interval_us_ / 2) / interval_us_;
+        if (n >= 1 && n <= kMaxSkipped) {
+            const uint32_t expected = n * interval_us_;
+            const uint32_t diff = period_us > expected ? period_us - expected : expected - period_us;
+            if (diff <= kToleranceUs) {
+                // 跟随漂移：每次移动差值的 1/4（按单个间隔折算）
+                const int32_t step = ((int32_t)(period_us / n) - (int32_t)interval_us_) / 4;
+                interval_us_ = (uint32_t)((int32_t)interval_us_ + step);
+                mismatches_ = 0;
+                return;
+            }
+        }
+        mismatches_++;
+    }
+
+    uint32_t anchor_us_;       // 最近一个事件的锚点（第一次收发开始）
+    uint32_t last_end_us_;
+    uint32_t interval_us_;     // 学到的连接间隔（0 = 尚未学到）
+    uint32_t event_us_;        // 事件长度（锚点到最后一次收发结束）的衰减最大值
+    uint32_t mismatches_;
+    bool has_anchor_;
+};
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef RADIO_MODULE_H
+#define RADIO_MODULE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "radio_gap.h"
+
+// 射频活动时序（INFERENCE_RADIO_AWARE，nRF52）
+// Cordio 链路层独占 RADIO 与它的中断，协议栈没有 SoftDevice 那样的 radio notification 信号：这里用 PPI 把
+// RADIO 的 READY / DISABLED 事件接到一个空闲的 EGU 上，在最低优先级的 EGU 中断里记下每次收发的开始与结束时刻，
+// 由 RadioGapPredictor 学习连接间隔与事件长度。不改动 RADIO 的任何配置，也不占用链路层的中断；
+// 每次收发多两次很短的中断（读计数、更新几个字段）。推理线程在 invoke 前据此避开下一个连接事件（inference_module.cpp）。
+
+/**
+ * @brief 找一个空闲的 PPI 通道对与 EGU，开始记录射频时序（setup 中调用；不可用时返回 false，推理照常运行）
+ */
+bool radio_module_init();
+
+/**
+ * @brief 现在开始一次耗时 busy_us 的推理应推迟多久（任意线程；未初始化时为 RADIO_GAP_UNTIMED）
+ */
+radio_gap_decision_t radio_module_decide(uint32_t busy_us, uint32_t guard_us, uint32_t max_defer_us);
+
+/**
+ * @brief 学到的连接间隔与事件长度（0 = 尚未学到）
+ */
+void radio_module_get_timing(uint32_t* out_interval_us, uint32_t* out_event_us);
+
+#endif
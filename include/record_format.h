@@ -0,0 +1,309 @@
+#ifndef RECORD_FORMAT_H
+#define RECORD_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// 原始 IMU 录制的二进制帧格式（与 pc_controller/raw_recorder.py 的解码器对应）
+//
+//   0xA5 0x5A | type(1) | length(1) | payload(length) | crc8(1)
+//
+// payload（小端）：
+//   seq(u16) | t0_us(u32) | channel_mask(u8) | frame_count(u8) | frames...
+// 每帧：时间戳差值，随后每个通道一个样本差值；差值均为 zigzag + varint 编码。
+// 包内第一帧的时间戳相对 t0_us、样本相对 0，因此每个包都能独立解码；
+// seq 不连续即表示丢包，帧头 + CRC 保证混入的串口文本可以被跳过并重新同步。
+//
+// 两种包类型共用这一格式：
+// - RECORD_TYPE_IMU_RAW：传感器 ODR 的原始（未抽取、未校准）6 轴帧，时间戳单位 µs；
+// - RECORD_TYPE_WINDOW：实际送入模型的窗口样本（抽取、校准、重采样之后，只含融合轴），
+//   样本单位为传感器 LSB（见 imu_module_channel_lsb），"时间戳"为样本序号（推理线程收到的第几帧），
+//   相邻帧差值为 1，只占 1 字节；序号跳变表示样本队列满时被丢弃的帧。
+
+#define RECORD_SYNC_0          0xA5
+#define RECORD_SYNC_1          0x5A
+#define RECORD_TYPE_IMU_RAW    0x01
+#define RECORD_TYPE_WINDOW     0x02
+#define RECORD_HEADER_BYTES    4
+#define RECORD_PAYLOAD_HEADER_BYTES 8
+// 单包上限：BLE 通知在 247 字节 MTU 下最多 244 字节
+#define RECORD_PACKET_MAX_BYTES 244
+// 单包下限：默认 23 字节 MTU 下的一次通知（包头 + CRC 之外剩 7 字节，装得下差值较小的 3 轴帧）
+#define RECORD_PACKET_MIN_BYTES 20
+
+// channel_mask 位定义（板坐标系，与 imu_calibration_t 的通道顺序一致）
+#define RECORD_CHANNEL_ACC     0x07
+#define RECORD_CHANNEL_GYR     0x38
+
+/**
+ * @brief 一个已编码的录制包
+ */
+struct record_packet_t {
+    uint8_t length;
+    uint8_t bytes[RECORD_PACKET_MAX_BYTES];
+};
+
+/**
+ * @brief 录制包编码器：按帧追加，写满后由调用者 finish() 取走
+ */
+class RecordPacketEncoder {
+public:
+    RecordPacketEncoder() : size_(0), max_bytes_(RECORD_PACKET_MAX_BYTES), frames_(0), channels_(0), open_(false) {}
+
+    /**
+     * @brief 开始一个新包
+     * @param seq 包序号（每包加一，回绕）
+     * @param t0_us 包的基准时间戳
+     * @param channel_mask 每帧包含的通道（位 i 对应板坐标系通道 i）
+     * @param type 包类型（RECORD_TYPE_IMU_RAW / RECORD_TYPE_WINDOW）
+     * @param max_bytes 包长上限（含帧头与 CRC），例如按本连接的 MTU；限制在
+     *                  RECORD_PACKET_MIN_BYTES..RECORD_PACKET_MAX_BYTES 之内
+     */
+    void begin(uint16_t seq, uint32_t t0_us, uint8_t channel_mask, uint8_t type = RECORD_TYPE_IMU_RAW,
+               size_t max_bytes = RECORD_PACKET_MAX_BYTES) {
+        uint8_t* p = packet_.bytes;
+        p[0] = RECORD_SYNC_0;
+        p[1] = RECORD_SYNC_1;
+        p[2] = type;
+        p[3] = 0;
+        p[4] = (uint8_t)(seq & 0xFF);
+        p[5] = (uint8_t)(seq >> 8);
+        for (int i = 0; i < 4; i++) {
+            p[6 + i] = (uint8_t)(t0_us >> (8 * i));
+        }
+        p[10] = channel_mask;
+        p[11] = 0;
+        size_ = RECORD_HEADER_BYTES + RECORD_PAYLOAD_HEADER_BYTES;
+        max_bytes_ = max_bytes < RECORD_PACKET_MIN_BYTES
+                         ? RECORD_PACKET_MIN_BYTES
+                         : (max_bytes > RECORD_PACKET_MAX_BYTES ? RECORD_PACKET_MAX_BYTES : max_bytes);
+
+        channels_ = 0;
+        for (uint8_t m = channel_mask & 0x3F; m; m >>= 1) {
+            channels_ += m & 1;
+        }
+        last_timestamp_ = t0_us;
+        memset(last_, 0, sizeof(last_));
+        frames_ = 0;
+        open_ = true;
+    }
+
+    bool is_open() const { return open_; }
+    uint8_t frame_count() const { return frames_; }
+
+    /**
+     * @brief 追加一帧
+     * @param values channel_mask 中各通道的样本（按通道序号升序）
+     * @param timestamp_us 该帧的时间戳
+     * @return true 已写入
+     * @return false 剩余空间不足（按这一帧编码后的实际长度），需要先 finish()
+     */
+    bool add(const int16_t* values, uint32_t timestamp_us) {
+        if (!open_ || frames_ == 255) {
+            return false;
+        }
+        // 先算出这一帧的编码长度，末尾留 1 字节 CRC；小 MTU 下按最坏情况估计会一帧也装不下
+        uint32_t codes[1 + 6];
+        codes[0] = zigzag((int32_t)(timestamp_us - last_timestamp_));
+        size_t needed = varint_size(codes[0]);
+        for (size_t c = 0; c < channels_; c++) {
+            codes[1 + c] = zigzag((int32_t)values[c] - last_[c]);
+            needed += varint_size(codes[1 + c]);
+        }
+        if (size_ + needed + 1 > max_bytes_) {
+            return false;
+        }
+
+        for (size_t i = 0; i <= channels_; i++) {
+            put_varint(codes[i]);
+        }
+        last_timestamp_ = timestamp_us;
+        for (size_t c = 0; c < channels_; c++) {
+            last_[c] = values[c];
+        }
+        frames_++;
+        return true;
+    }
+
+    /**
+     * @brief 写入长度与 CRC，结束当前包
+     * @return const record_packet_t& 编码完成的包（下一次 begin() 前有效）
+     */
+    const record_packet_t& finish() {
+        packet_.bytes[3] = (uint8_t)(size_ - RECORD_HEADER_BYTES);
+        packet_.bytes[11] = frames_;
+        packet_.bytes[size_] = crc8(&packet_.bytes[2], size_ - 2);
+        packet_.length = (uint8_t)(size_ + 1);
+        open_ = false;
+        return packet_;
+    }
+
+    /**
+     * @brief CRC-8（多项式 0x07，初值 0），覆盖 type、length 与 payload
+     */
+    static uint8_t crc8(const uint8_t* data, size_t len) {
+        uint8_t crc = 0;
+        for (size_t i = 0; i < len; i++) {
+            crc ^= data[i];
+            for (int b = 0; b < 8; b++) {
+                crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+            }
+        }
+        return crc;
+    }
+
+private:
+    static uint32_t zigzag(int32_t v) {
+        return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+    }
+
+    static size_t varint_size(uint32_t v) {
+        size_t n = 1;
+        while (v >= 0x80) {
+            v >>= 7;
+            n++;
+        }
+        return n;
+    }
+
+    void put_varint(uint32_t v) {
+        while (v >= 0x80) {
+            packet_.bytes[size_++] = (uint8_t)(v | 0x80);
+            v >>= 7;
+        }
+        packet_.bytes[size_++] = (uint8_t)v;
+    }
+
+    record_packet_t packet_;
+    size_t size_;
+    size_t max_bytes_;
+    uint32_t last_timestamp_;
+    int32_t last_[6];
+    uint8_t frames_;
+    uint8_t channels_;
+    bool open_;
+};
+
+/**
+ * @brief 录制包解码器：逐字节喂入，得到一个 CRC 正确的完整包后再逐帧读出
+ * 帧头、类型、长度或 CRC 不对时丢弃已收到的部分，从下一个字节重新寻找帧头。
+ */
+class RecordPacketDecoder {
+public:
+    RecordPacketDecoder() : size_(0), expected_(0), pos_(0), end_(0), frames_left_(0), channels_(0), crc_errors_(0) {}
+
+    /**
+     * @brief 喂入一个字节
+     * @return true 刚好收齐一个有效包，随后用 read_frame() 读出其中的帧（包括 0 帧的空包）
+     */
+    bool feed(uint8_t byte) {
+        if (size_ == 0 && byte != RECORD_SYNC_0) {
+            return false;
+        }
+        if ((size_ == 1 && byte != RECORD_SYNC_1) || (size_ == 2 && byte != RECORD_TYPE_IMU_RAW)) {
+            size_ = byte == RECORD_SYNC_0 ? 1 : 0;
+            return false;
+        }
+        if (size_ == 3) {
+            if (byte < RECORD_PAYLOAD_HEADER_BYTES || byte + RECORD_HEADER_BYTES + 1 > RECORD_PACKET_MAX_BYTES) {
+                size_ = 0;
+                return false;
+            }
+            expected_ = (size_t)byte + RECORD_HEADER_BYTES + 1;
+        }
+        bytes_[size_++] = byte;
+        if (size_ < RECORD_HEADER_BYTES || size_ < expected_) {
+            return false;
+        }
+
+        size_ = 0;
+        if (RecordPacketEncoder::crc8(&bytes_[2], expected_ - 3) != bytes_[expected_ - 1]) {
+            crc_errors_++;
+            return false;
+        }
+        channels_ = 0;
+        for (uint8_t m = channel_mask(); m; m >>= 1) {
+            channels_ += m & 1;
+        }
+        last_timestamp_ = (uint32_t)bytes_[6] | ((uint32_t)bytes_[7] << 8) | ((uint32_t)bytes_[8] << 16) |
+                          ((uint32_t)bytes_[9] << 24);
+        memset(last_, 0, sizeof(last_));
+        pos_ = RECORD_HEADER_BYTES + RECORD_PAYLOAD_HEADER_BYTES;
+        end_ = expected_ - 1;
+        frames_left_ = bytes_[11];
+        return true;
+    }
+
+    uint16_t sequence() const { return (uint16_t)(bytes_[4] | (bytes_[5] << 8)); }
+    uint8_t channel_mask() const { return bytes_[10]; }
+    uint8_t frame_count() const { return bytes_[11]; }
+    uint8_t frames_left() const { return frames_left_; }
+    uint32_t crc_errors() const { return crc_errors_; }
+
+    /**
+     * @brief 读出当前包的下一帧
+     * @param values 输出 channel_mask 中各通道的样本（按通道序号升序）
+     * @param timestamp_us 输出该帧的时间戳
+     * @return false 没有剩余的帧，或包内数据截断
+     */
+    bool read_frame(int16_t* values, uint32_t* timestamp_us) {
+        if (frames_left_ == 0) {
+            return false;
+        }
+        uint32_t v;
+        if (!get_varint(&v)) {
+            return fail();
+        }
+        last_timestamp_ += (uint32_t)unzigzag(v);
+        for (size_t c = 0; c < channels_; c++) {
+            if (!get_varint(&v)) {
+                return fail();
+            }
+            last_[c] += unzigzag(v);
+            values[c] = (int16_t)last_[c];
+        }
+        *timestamp_us = last_timestamp_;
+        frames_left_--;
+        return true;
+    }
+
+private:
+    static int32_t unzigzag(uint32_t v) {
+        return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+    }
+
+    bool get_varint(uint32_t* out) {
+        uint32_t v = 0;
+        for (int shift = 0; shift <= 28; shift += 7) {
+            if (pos_ >= end_) {
+                return false;
+            }
+            const uint8_t byte = bytes_[pos_++];
+            v |= (uint32_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                *out = v;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool fail() {
+        frames_left_ = 0;
+        return false;
+    }
+
+    uint8_t bytes_[RECORD_PACKET_MAX_BYTES];
+    size_t size_;
+    size_t expected_;
+    size_t pos_;
+    size_t end_;
+    uint32_t last_timestamp_;
+    int32_t last_[6];
+    uint8_t frames_left_;
+    uint8_t channels_;
+    uint32_t crc_errors_;
+};
+
+#endif
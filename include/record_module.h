@@ -0,0 +1,67 @@
+#ifndef RECORD_MODULE_H
+#define RECORD_MODULE_H
+
+#include <stdint.h>
+
+#include "record_format.h"
+
+// 原始 IMU 录制模块对外接口（采集数据集用，格式见 record_format.h）
+
+/**
+ * @brief 录制数据的输出通道
+ */
+enum record_transport_t {
+    RECORD_OFF = 0,
+    RECORD_USB = 1,  // USB CDC 串口（Serial.write 二进制包）
+    RECORD_BLE = 2,  // BLE 录制特征值通知（由 ble_task 发送；USB 链路会话中为 USB 链路的录制帧）
+};
+
+/**
+ * @brief 录制统计
+ */
+struct record_stats_t {
+    uint32_t frames;   // 已编码的原始帧数
+    uint32_t packets;  // 已编码的包数
+    uint32_t dropped;  // 队列满被丢弃的包数（主机端表现为 seq 跳变）
+};
+
+/**
+ * @brief 开始录制：以传感器 ODR 输出带时间戳的原始 6 轴帧，期间暂停分类与串口文本输出
+ * @param transport 输出通道（RECORD_OFF 等同于 record_module_stop）
+ */
+void record_module_start(record_transport_t transport);
+
+/**
+ * @brief 停止录制并恢复分类
+ */
+void record_module_stop();
+
+/**
+ * @brief 当前是否正在录制
+ */
+bool record_module_active();
+
+/**
+ * @brief 当前输出通道
+ */
+record_transport_t record_module_transport();
+
+/**
+ * @brief 取出一个待发送的包（BLE 通道由 ble_task 调用）
+ * @return true 取到一个包
+ */
+bool record_module_pop_packet(record_packet_t* out_packet);
+
+/**
+ * @brief 获取录制统计
+ */
+void record_module_get_stats(record_stats_t* out_stats);
+
+/**
+ * @brief 录制任务（在独立线程中运行）
+ * 解析串口命令（"rec usb" / "rec ble" / "rec stop"，"ble" 打印 BLE 发送计数），USB 通道时把包写到串口；
+ * 串口输入中的二进制链路帧交给 usb_link_module_feed
+ */
+void record_task();
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef REPLAY_MODULE_H
+#define REPLAY_MODULE_H
+
+#include <stdint.h>
+
+// 板上回放：主机经 USB CDC 发送录制的原始 IMU 帧，代替传感器输入完整的实时处理链
+// （采集线程的抽取 / 校准 / 重采样、样本队列、滑动窗口、推理与后处理，BLE / LED 照常发布），
+// 设备逐窗口回报分类结果，结束时回报汇总与各级耗时，用于在真实 MCU 上重复地做精度与延迟回归。
+//
+// 串口命令 "replay" 进入回放：设备打印 "[Replay] Ready" 后，主机发送 record_format.h 格式的包
+// （板坐标系原始 LSB，采样率 IMU_SENSOR_ODR_HZ），以一个 0 帧的空包结束；回放队列满时设备停止读取串口，
+// USB 流控让主机自动放慢到实时速率。设备输出（与主机离线回放 src/host/replay_main.cpp 相同的行格式）：
+//
+//   result,<frame>,<label>,<confidence>,<classify_us>,<latency_us>
+//   summary,<windows>,<sensor_frames>,<output_frames>,<wall_us>,<dsp_us>
+//   memory,<ram_high_water>,<static_bytes>   （静态数据 + 堆高水位，见 memory_module_high_water）
+//   stage,<name>,<runs>,<mean_us>,<max_us>,<busy_permille>   （最近一个统计窗口的流水线各级统计）
+//
+// frame 相对回放开始计数；窗口中仍有回放前的实时样本时的结果不输出。
+// 主机端见 pc_controller/device_replay.py。
+
+/**
+ * @brief 登记回放队列的内存（在 record_task 中调用一次）
+ */
+void replay_module_init();
+
+/**
+ * @brief 开始一次回放（串口命令 "replay"）
+ * @return false 正在录制或回放，或当前配置不支持回放（IMU_USE_FIFO = 0）
+ */
+bool replay_module_start();
+
+/**
+ * @brief 是否正在回放（期间串口输入全部交给回放模块，不再解析文本命令）
+ */
+bool replay_module_active();
+
+/**
+ * @brief 在 record_task 中轮询：接收串口数据、打印结果，回放结束时打印汇总并恢复传感器
+ * @return true 本次有数据收发（调用者不休眠）
+ */
+bool replay_module_service();
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief 多通道线性插值重采样器（相位累加器实现）
+ * 把传感器 ODR 下的帧流转换为模型训练时的采样率，每输入一帧最多输出
+ * ceil(output_hz / input_hz) 帧，无动态内存。
+ * @tparam Channels 每帧通道数（例如 3 = X, Y, Z）
+ */
+template <size_t Channels>
+class LinearResampler {
+public:
+    LinearResampler() : step_(1.0f), phase_(0.0f), primed_(false) {}
+
+    /**
+     * @brief 设置输入/输出采样率；可在运行中调用以跟踪实测 ODR
+     */
+    void set_rates(float input_hz, float output_hz) {
+        if (input_hz > 0.0f && output_hz > 0.0f) {
+            step_ = input_hz / output_hz;
+        }
+    }
+
+    void reset() {
+        phase_ = 0.0f;
+        primed_ = false;
+    }
+
+    /**
+     * @brief 输入一帧，输出 0 个或多个重采样后的帧
+     * @param in 输入帧（Channels 个值）
+     * @param out 输出缓冲区
+     * @param max_out out 可容纳的帧数
+     * @return size_t 输出的帧数
+     */
+    size_t push(const float* in, float* out, size_t max_out) {
+        if (!primed_) {
+            copy(prev_, in);
+            primed_ = true;
+            return 0;
+        }
+
+        size_t produced = 0;
+        // phase_ 表示下一个输出点在 [prev_, in] 区间内的位置（单位：输入帧）
+        while (phase_ < 1.0f && produced < max_out) {
+            for (size_t c = 0; c < Channels; c++) {
+                out[produced * Channels + c] = prev_[c] + (in[c] - prev_[c]) * phase_;
+            }
+            produced++;
+            phase_ += step_;
+        }
+        phase_ -= 1.0f;
+        copy(prev_, in);
+        return produced;
+    }
+
+private:
+    static void copy(float* dst, const float* src) {
+        for (size_t c = 0; c < Channels; c++) {
+            dst[c] = src[c];
+        }
+    }
+
+    float prev_[Channels];
+    float step_;
+    float phase_;
+    bool primed_;
+};
+
+/**
+ * @brief LinearResampler 的 int16 版本（INFERENCE_Q15_FEATURES）
+ * 相位为 Q24 定点（步长小于 127 个输入帧），插值系数截取为 Q15，输出四舍五入；
+ * 只有 set_rates 使用浮点（配置时调用，不在逐样本路径上）。
+ * @tparam Channels 每帧通道数
+ */
+template <size_t Channels>
+class LinearResamplerQ15 {
+public:
+    LinearResamplerQ15() : step_(kOne), phase_(0), primed_(false) {}
+
+    void set_rates(float input_hz, float output_hz) {
+        if (input_hz > 0.0f && output_hz > 0.0f && input_hz / output_hz < 127.0f) {
+            step_ = (int32_t)(input_hz / output_hz * kOne + 0.5f);
+        }
+    }
+
+    void reset() {
+        phase_ = 0;
+        primed_ = false;
+    }
+
+    size_t push(const int16_t* in, int16_t* out, size_t max_out) {
+        if (!primed_) {
+            copy(prev_, in);
+            primed_ = true;
+            return 0;
+        }
+
+        size_t produced = 0;
+        while (phase_ < kOne && produced < max_out) {
+            const int32_t frac = (int32_t)(phase_ >> (kPhaseBits - 15));
+            for (size_t c = 0; c < Channels; c++) {
+                const int32_t delta = (int32_t)in[c] - prev_[c];
+                out[produced * Channels + c] = (int16_t)(prev_[c] + ((delta * frac + (1 << 14)) >> 15));
+            }
+            produced++;
+            phase_ += step_;
+        }
+        phase_ -= kOne;
+        copy(prev_, in);
+        return produced;
+    }
+
+private:
+    static const int kPhaseBits = 24;
+    static const int32_t kOne = 1 << kPhaseBits;
+
+    static void copy(int16_t* dst, const int16_t* src) {
+        for (size_t c = 0; c < Channels; c++) {
+            dst[c] = src[c];
+        }
+    }
+
+    int16_t prev_[Channels];
+    int32_t step_;
+    int32_t phase_;
+    bool primed_;
+};
+
+#endif
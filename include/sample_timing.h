@@ -0,0 +1,96 @@
+#ifndef SAMPLE_TIMING_H
+#define SAMPLE_TIMING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "stat_counters.h"
+
+/**
+ * @brief 采样间隔统计快照（一个统计窗口）
+ */
+struct sample_timing_stats_t {
+    uint32_t samples;           // 窗口内进入滑动窗口的样本数
+    uint32_t mean_interval_us;  // 平均样本间隔
+    uint32_t p99_jitter_us;     // 样本间隔相对名义周期偏差的 99 分位
+    uint32_t max_jitter_us;     // 最大偏差
+    uint32_t dropped;           // 累计丢弃的样本数（未能进入窗口）
+    uint32_t duplicated;        // 累计重复样本数（与上一帧完全相同，通常是读到了未更新的寄存器）
+};
+
+/**
+ * @brief 采样间隔与抖动统计（固定桶直方图，无动态内存）
+ * 每批样本进入窗口时记录一次到达时间，按批内样本数折算为单样本间隔。
+ * 记录者只有一个线程；抖动直方图与计数是无锁统计量（stat_counters.h），可以登记到统计注册表，
+ * 其他线程随时读取而不阻塞记录者。
+ */
+class SampleTimingStats {
+public:
+    static const size_t kBucketCount = 128;
+    static const uint32_t kBucketWidthUs = 100;
+
+    explicit SampleTimingStats(uint32_t nominal_interval_us = 0)
+        : nominal_us_(nominal_interval_us), last_us_(0), has_last_(false), jitter_us_(kBucketWidthUs) {}
+
+    void set_nominal_interval(uint32_t nominal_interval_us) {
+        nominal_us_ = nominal_interval_us;
+    }
+
+    /**
+     * @brief 记录一批到达的样本
+     * @param now_us 到达时间（ei_read_timer_us）
+     * @param count 本批样本数
+     */
+    void record(uint32_t now_us, uint32_t count) {
+        if (count == 0) {
+            return;
+        }
+        if (has_last_) {
+            const uint32_t interval = (now_us - last_us_) / count;
+            const uint32_t jitter = interval > nominal_us_ ? interval - nominal_us_ : nominal_us_ - interval;
+            jitter_us_.record(jitter, count);
+            // 一个统计窗口内的间隔之和约等于窗口长度，不会溢出
+            interval_sum_us_.add(interval * count);
+        }
+        last_us_ = now_us;
+        has_last_ = true;
+    }
+
+    void add_dropped(uint32_t count) { dropped_.add(count); }
+    void add_duplicated(uint32_t count) { duplicated_.add(count); }
+
+    /**
+     * @brief 当前窗口的抖动分布、自启动累计的丢弃与重复样本数（登记到统计注册表）
+     */
+    const StatHistogram<kBucketCount>& jitter() const { return jitter_us_; }
+    const StatCounter& dropped() const { return dropped_; }
+    const StatCounter& duplicated() const { return duplicated_; }
+
+    /**
+     * @brief 生成当前窗口的统计快照，并开始新的窗口（只由记录者调用）
+     */
+    sample_timing_stats_t snapshot_and_reset() {
+        StatBins<kBucketCount> bins;
+        jitter_us_.take(&bins);
+        const uint32_t interval_sum_us = interval_sum_us_.take();
+        sample_timing_stats_t out;
+        out.samples = bins.count;
+        out.mean_interval_us = bins.count ? interval_sum_us / bins.count : 0;
+        out.p99_jitter_us = bins.percentile(0.99f);
+        out.max_jitter_us = bins.max;
+        out.dropped = dropped_.value();
+        out.duplicated = duplicated_.value();
+        return out;
+    }
+
+private:
+    // 只由记录者访问
+    uint32_t nominal_us_;
+    uint32_t last_us_;
+    bool has_last_;
+    StatHistogram<kBucketCount> jitter_us_;
+    StatCounter interval_sum_us_;
+    StatCounter dropped_;
+    StatCounter duplicated_;
+};
+
+#endif
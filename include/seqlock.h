@@ -0,0 +1,78 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <type_traits>
+
+/**
+ * @brief 双缓冲顺序锁：一个写者发布快照，任意多个读者无锁读取
+ * 写者轮流写两个槽位：先登记开始的版本号 begun_，写完槽位 (版本号 & 1) 后再公布 published_。
+ * 读者读取已公布版本的槽位，读完确认写者没有在此期间开始写同一个槽位（即没有又开始两次写入），
+ * 否则重读。读者抢占正在写的写者时读到的是另一个完整的槽位，不会自旋等待写者；写者从不等待读者。
+ * 数据按 32 位原子字存放，读写重叠时也没有数据竞争。
+ * 写者只能有一个（多个写者须自行互斥）。
+ * @tparam T 快照类型（可平凡复制）
+ */
+template <typename T>
+class Seqlock {
+    static_assert(std::is_trivially_copyable<T>::value, "Seqlock snapshots must be trivially copyable");
+    static const size_t kWords = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+public:
+    Seqlock() : begun_(0), published_(0) {
+        for (size_t slot = 0; slot < 2; slot++) {
+            for (size_t i = 0; i < kWords; i++) {
+                slots_[slot][i].store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief 发布新快照（仅写者调用）
+     */
+    void store(const T& value) {
+        uint32_t words[kWords] = {0};
+        memcpy(words, &value, sizeof(T));
+
+        const uint32_t version = published_.load(std::memory_order_relaxed) + 1;
+        begun_.store(version, std::memory_order_relaxed);
+        // 读者看到本次写入的任何一个字时，也一定能看到 begun_ 已更新
+        std::atomic_thread_fence(std::memory_order_release);
+        std::atomic<uint32_t>* slot = slots_[version & 1];
+        for (size_t i = 0; i < kWords; i++) {
+            slot[i].store(words[i], std::memory_order_relaxed);
+        }
+        published_.store(version, std::memory_order_release);
+    }
+
+    /**
+     * @brief 读取最近一次发布的快照（任意线程，不阻塞写者）
+     * @return uint32_t 快照的版本号（发布次数，0 = 尚未发布，读到的是全零初始值）
+     */
+    uint32_t load(T* out) const {
+        uint32_t words[kWords];
+        for (;;) {
+            const uint32_t version = published_.load(std::memory_order_acquire);
+            const std::atomic<uint32_t>* slot = slots_[version & 1];
+            for (size_t i = 0; i < kWords; i++) {
+                words[i] = slot[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            // 写者最多开始了下一次写入（写的是另一个槽位）时，本槽位在读取期间没有被改写
+            if (begun_.load(std::memory_order_relaxed) - version < 2) {
+                memcpy(out, words, sizeof(T));
+                return version;
+            }
+        }
+    }
+
+private:
+    std::atomic<uint32_t> begun_;
+    std::atomic<uint32_t> published_;
+    std::atomic<uint32_t> slots_[2][kWords];
+};
+
+#endif
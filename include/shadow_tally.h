@@ -0,0 +1,85 @@
+#ifndef SHADOW_TALLY_H
+#define SHADOW_TALLY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define SHADOW_HISTOGRAM_BINS 10
+
+/**
+ * @brief 影子模式一段时间内的对比统计
+ * 同一窗口上生产模型与候选模型的判定：相同（含都低于阈值），或只有一方给出手势，或双方给出不同的手势；
+ * idle 与低于阈值都算“没有手势”。直方图为两个模型获胜类别的概率（等宽，[0, 1]）
+ */
+struct shadow_counts_t {
+    uint32_t runs;
+    uint32_t agree;
+    uint32_t candidate_only;     // 候选模型给出手势、生产模型没有（可能的误触发或新召回）
+    uint32_t production_only;    // 生产模型给出手势、候选模型没有
+    uint32_t differ;             // 双方给出不同的手势
+    uint32_t production_bins[SHADOW_HISTOGRAM_BINS];
+    uint32_t candidate_bins[SHADOW_HISTOGRAM_BINS];
+};
+
+/**
+ * @brief 影子模式的统计：自启动以来的累计，以及写入诊断日志后清零的一个周期
+ */
+class ShadowTally {
+public:
+    ShadowTally() : idle_index_(-1) {
+        memset(&total_, 0, sizeof(total_));
+        memset(&period_, 0, sizeof(period_));
+    }
+
+    void configure(int idle_index) { idle_index_ = idle_index; }
+
+    /**
+     * @brief 计入一个窗口
+     * @param production_index / candidate_index 各模型的判定（-1 = 低于阈值）
+     * @param production_confidence / candidate_confidence 各模型获胜类别的概率
+     */
+    void add(int production_index, float production_confidence, int candidate_index, float candidate_confidence) {
+        const size_t production_bin = bin_of(production_confidence);
+        const size_t candidate_bin = bin_of(candidate_confidence);
+        const bool production_gesture = is_gesture(production_index);
+        const bool candidate_gesture = is_gesture(candidate_index);
+        shadow_counts_t* counts[2] = {&total_, &period_};
+        for (shadow_counts_t* c : counts) {
+            c->runs++;
+            if (production_index == candidate_index || (!production_gesture && !candidate_gesture)) {
+                c->agree++;
+            } else if (!production_gesture) {
+                c->candidate_only++;
+            } else if (!candidate_gesture) {
+                c->production_only++;
+            } else {
+                c->differ++;
+            }
+            c->production_bins[production_bin]++;
+            c->candidate_bins[candidate_bin]++;
+        }
+    }
+
+    const shadow_counts_t& total() const { return total_; }
+    const shadow_counts_t& period() const { return period_; }
+
+    void reset_period() { memset(&period_, 0, sizeof(period_)); }
+
+private:
+    bool is_gesture(int index) const { return index >= 0 && index != idle_index_; }
+
+    static size_t bin_of(float confidence) {
+        if (!(confidence > 0.0f)) {
+            return 0;
+        }
+        const size_t bin = (size_t)(confidence * SHADOW_HISTOGRAM_BINS);
+        return bin < SHADOW_HISTOGRAM_BINS ? bin : SHADOW_HISTOGRAM_BINS - 1;
+    }
+
+    int idle_index_;
+    shadow_counts_t total_;
+    shadow_counts_t period_;
+};
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef SHELL_MODULE_H
+#define SHELL_MODULE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "app_config.h"
+
+// 二进制诊断命令（SHELL_ENABLE）：主机（pc_controller/device_shell.py）在 USB 帧 USB_FRAME_SHELL（0x32，帧格式见
+// usb_frame.h）中写入请求，设备在同一类型的帧中应答。与文本命令（"prof"、"bench"、"cfg" ...）相比，应答是
+// 固定布局的二进制，不经 printf 格式化、不与日志线程的输出交错，主机按序号配对请求与应答。
+//
+// 请求由录制线程（低优先级）在读到帧时当场处理；读统计只取各模块的无锁快照，不阻塞推理线程。
+// 不需要先发 hello：链路未打开时也应答，BLE 连接照常保持。
+//
+// 请求：uint8 序号，uint8 命令（shell_command_t），参数
+// 应答：uint8 序号，uint8 命令，uint8 状态（shell_status_t），数据（状态为 SHELL_OK 时）
+// 多字节字段均为小端。各命令的参数与数据：
+//
+//   INFO         -                    uint8 协议版本，uint8 线程数，uint8 延迟阶段数，uint8 区段数（0 = 未编译区段剖析），
+//                                     uint32 运行毫秒数
+//   STATS        uint8 分组            SYSTEM：uint32 运行毫秒数、已入队帧数、采样溢出次数、采样队列高水位、推理停滞次数、
+//                                       最长循环间隔毫秒、传感器恢复次数、最长传感器中断毫秒、RAM 高水位、静态数据字节，
+//                                       uint8 上次为看门狗复位、工作点、当前模型、保留
+//                                     THREADS：每个线程 uint32 栈大小、栈峰值、被重启次数（thread_role_t 顺序）
+//                                     LATENCY：每个阶段 uint32 样本数、p50、p95、p99、最大 µs、超出 SLO 次数
+//                uint8 分组，uint8 类别  CONFIDENCE：uint8 类别数，uint8 分箱数，2 字节保留，该类别获胜的窗口自启动以来
+//                                       按获胜概率、与第二名的差距的分箱计数（各 uint32 x 分箱数，见 telemetry_module.h；
+//                                       未编译诊断日志时 SHELL_UNSUPPORTED）
+//   BENCH_START  uint8 模式，uint16 次数   -（结果用 BENCH_RESULT 轮询）
+//   BENCH_RESULT -                    uint32 版本号（每轮结束加一），其后与推理基准帧 0x29 相同
+//   CONFIG_GET   -                    uint32 配置版本号，CONFIG_WIRE_BYTES 字节配置（config_module.h）
+//   CONFIG_SET   1 字节预设、2 字节工作点命令或 7 字节配置  同 CONFIG_GET（应用后的配置）
+//   TRACE_START  -                    -（读游标移到当前位置，之后写入的区段由 TRACE_READ 取出）
+//   TRACE_STOP   -                    -
+//   TRACE_READ   uint8 最多条数         与区段追踪帧 0x30 相同（wire_schema.h）：uint32 millis()，uint32 周期计数，uint16 时钟 kHz，
+//                                       uint8 条数（0x80 = 之前有记录被覆盖），每条 uint8 区段、uint32 开始距今周期、uint32 周期数
+//   REPLAY       -                    -（应答之后串口输入交给回放模块，见 replay_module.h）
+//   STAT_READ    uint8 序号            统计注册表的一项（stats_module.h）：wire_stat_t、名称与值（wire_schema.h），
+//                                       与统计特征值 19B10034 相同；序号超出已登记的数量时 SHELL_BAD_ARGUMENT
+
+#define SHELL_PROTOCOL_VERSION 1
+
+enum shell_command_t {
+    SHELL_CMD_INFO = 0,
+    SHELL_CMD_STATS,
+    SHELL_CMD_BENCH_START,
+    SHELL_CMD_BENCH_RESULT,
+    SHELL_CMD_CONFIG_GET,
+    SHELL_CMD_CONFIG_SET,
+    SHELL_CMD_TRACE_START,
+    SHELL_CMD_TRACE_STOP,
+    SHELL_CMD_TRACE_READ,
+    SHELL_CMD_REPLAY,
+    SHELL_CMD_STAT_READ,
+    SHELL_CMD_COUNT
+};
+
+enum shell_status_t {
+    SHELL_OK = 0,
+    SHELL_UNKNOWN_COMMAND,
+    SHELL_BAD_ARGUMENT,
+    SHELL_BUSY,         // 上一轮基准仍在进行、正在录制或回放
+    SHELL_UNSUPPORTED,  // 当前固件未编译该功能（区段剖析、回放）
+    SHELL_NOT_STARTED,  // TRACE_READ 之前没有 TRACE_START
+};
+
+enum shell_stats_group_t {
+    SHELL_STATS_SYSTEM = 0,
+    SHELL_STATS_THREADS,
+    SHELL_STATS_LATENCY,
+    SHELL_STATS_CONFIDENCE,
+    SHELL_STATS_GROUP_COUNT
+};
+
+#if SHELL_ENABLE
+
+/**
+ * @brief 处理一个请求并发送应答（录制线程，由 usb_link_module_feed 调用）
+ * @param request 帧的 payload（序号、命令与参数）
+ */
+void shell_module_handle(const uint8_t* request, size_t length);
+
+#endif
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+/**
+ * @brief 无锁单生产者/单消费者环形缓冲区
+ * 生产者只写 head_，消费者只写 tail_，两端各自用 acquire/release 同步，
+ * 不需要互斥锁，可在采集线程与推理线程之间传递样本。
+ * 写入以 n 个元素为单位“全有或全无”，保证多轴帧不会被拆开。
+ * @tparam T 元素类型
+ * @tparam Capacity 容量（必须是 2 的幂）
+ */
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "SpscRing capacity must be a power of two");
+
+public:
+    SpscRing() : head_(0), tail_(0), overruns_(0), high_water_(0) {}
+
+    /**
+     * @brief 写入 n 个元素（仅生产者调用）
+     * @return true 写入成功
+     * @return false 空间不足，整组丢弃并计入 overrun
+     */
+    bool push(const T* values, size_t n) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        const size_t used = head - tail;
+        if (Capacity - used < n) {
+            overruns_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            buffer_[(head + i) & (Capacity - 1)] = values[i];
+        }
+        head_.store(head + n, std::memory_order_release);
+
+        if (used + n > high_water_.load(std::memory_order_relaxed)) {
+            high_water_.store(used + n, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    /**
+     * @brief 读取恰好 n 个元素（仅消费者调用）
+     * @return true 读取成功
+     * @return false 可读元素不足 n 个，未读取任何数据
+     */
+    bool pop(T* out, size_t n) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        const size_t head = head_.load(std::memory_order_acquire);
+        if (head - tail < n) {
+            return false;
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            out[i] = buffer_[(tail + i) & (Capacity - 1)];
+        }
+        tail_.store(tail + n, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 当前可读元素数（任意一端调用，结果只是快照）
+     */
+    size_t size() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+    /**
+     * @brief 因空间不足被丢弃的写入次数
+     */
+    uint32_t overruns() const { return overruns_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 历史最高占用（元素数），用于评估容量余量
+     */
+    size_t high_water() const { return high_water_.load(std::memory_order_relaxed); }
+
+private:
+    T buffer_[Capacity];
+    std::atomic<size_t> head_;
+    std::atomic<size_t> tail_;
+    std::atomic<uint32_t> overruns_;
+    std::atomic<size_t> high_water_;
+};
+
+#endif
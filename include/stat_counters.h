@@ -0,0 +1,310 @@
+#ifndef STAT_COUNTERS_H
+#define STAT_COUNTERS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+// 诊断统计的基本类型：计数、最大值、固定桶直方图与流式分位数草图。
+// 所有更新都是 32 位原子字上的 relaxed 读改写（Cortex-M4 上为 LDREX/STREX，几个周期），任意线程与中断中都可调用，
+// 不加锁、不关中断、不分配内存；读者同样无锁，读到的各字段可能相差正在进行的几次更新（只用于诊断）。
+// 统计量在 stats_module.h 中按名称注册后，由串口 "stats"、shell 的 STAT_READ 与诊断特征值统一导出。
+// 各模块自己的快照结构（latency_stats_t、sample_timing_stats_t ...）仍由模块从这些类型中取值。
+
+/**
+ * @brief 分布摘要（直方图与分位数草图的导出格式，单位由统计量决定）
+ */
+struct stat_distribution_t {
+    uint32_t count;
+    uint32_t max;
+    uint32_t p50;
+    uint32_t p90;
+    uint32_t p99;
+};
+
+/**
+ * @brief 原子地把 slot 更新为 max(slot, value)
+ */
+static inline void stat_atomic_max(std::atomic<uint32_t>& slot, uint32_t value) {
+    uint32_t seen = slot.load(std::memory_order_relaxed);
+    while (value > seen && !slot.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+    }
+}
+
+/**
+ * @brief 单调计数（回绕于 2^32）
+ */
+class StatCounter {
+public:
+    StatCounter() : value_(0) {}
+
+    void add(uint32_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+    uint32_t value() const { return value_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 取出并清零（按周期报告的计数）
+     */
+    uint32_t take() { return value_.exchange(0, std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint32_t> value_;
+};
+
+/**
+ * @brief 观测到的最大值（高水位）
+ */
+class StatMax {
+public:
+    StatMax() : value_(0) {}
+
+    void observe(uint32_t value) { stat_atomic_max(value_, value); }
+    uint32_t value() const { return value_.load(std::memory_order_relaxed); }
+    uint32_t take() { return value_.exchange(0, std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint32_t> value_;
+};
+
+/**
+ * @brief 直方图的一份普通（非原子）副本：按周期取出后在读者线程中计算分位数
+ * 分位数取所在桶的上界，不超过实测最大值；最后一个桶（超出量程的样本）以最大值代替。
+ */
+template <size_t N>
+struct StatBins {
+    uint32_t bins[N];
+    uint32_t count;
+    uint32_t max;
+    uint32_t width;
+
+    uint32_t percentile(float p) const {
+        if (count == 0) {
+            return 0;
+        }
+        const uint32_t target = (uint32_t)(count * p);
+        uint32_t seen = 0;
+        for (size_t i = 0; i < N - 1; i++) {
+            seen += bins[i];
+            if (seen > target) {
+                const uint32_t upper = (uint32_t)((i + 1) * width);
+                return upper < max ? upper : max;
+            }
+        }
+        return max;
+    }
+
+    /**
+     * @brief 不小于 limit 的样本数（limit 应为桶宽的整数倍）
+     */
+    uint32_t count_at_least(uint32_t limit) const {
+        uint32_t above = 0;
+        for (size_t i = limit / width; i < N; i++) {
+            above += bins[i];
+        }
+        return above;
+    }
+
+    void summarize(stat_distribution_t* out) const {
+        out->count = count;
+        out->max = max;
+        out->p50 = percentile(0.50f);
+        out->p90 = percentile(0.90f);
+        out->p99 = percentile(0.99f);
+    }
+};
+
+/**
+ * @brief 固定等宽桶直方图，超出量程的样本落入最后一个桶
+ * @tparam N 桶数（量程为 N 个桶宽）
+ */
+template <size_t N>
+class StatHistogram {
+    static_assert(N >= 2, "a histogram needs an overflow bucket");
+
+public:
+    explicit StatHistogram(uint32_t width) : width_(width ? width : 1), max_(0) {
+        for (size_t i = 0; i < N; i++) {
+            bins_[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief 记录 n 个相同的样本（例如一批样本折算出的同一个间隔）
+     */
+    void record(uint32_t value, uint32_t n = 1) {
+        const uint32_t bin = value / width_;
+        bins_[bin < N ? bin : N - 1].fetch_add(n, std::memory_order_relaxed);
+        stat_atomic_max(max_, value);
+    }
+
+    uint32_t width() const { return width_; }
+
+    uint32_t count() const {
+        uint32_t total = 0;
+        for (size_t i = 0; i < N; i++) {
+            total += bins_[i].load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    uint32_t max() const { return max_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 直接在原子桶上取分位数（不复制，取法与 StatBins 相同），读者栈上不需要一份桶的副本
+     */
+    uint32_t percentile(float p) const {
+        const uint32_t total = count();
+        if (total == 0) {
+            return 0;
+        }
+        const uint32_t target = (uint32_t)(total * p);
+        const uint32_t max_value = max();
+        uint32_t seen = 0;
+        for (size_t i = 0; i < N - 1; i++) {
+            seen += bins_[i].load(std::memory_order_relaxed);
+            if (seen > target) {
+                const uint32_t upper = (uint32_t)((i + 1) * width_);
+                return upper < max_value ? upper : max_value;
+            }
+        }
+        return max_value;
+    }
+
+    /**
+     * @brief 复制当前计数（不清零）；count 为各桶之和，与桶一致
+     */
+    void snapshot(StatBins<N>* out) const {
+        copy(out, false);
+    }
+
+    /**
+     * @brief 取出并清零（统计窗口结束）；取出期间的更新落在本窗口或下一个窗口，不会丢失
+     */
+    void take(StatBins<N>* out) {
+        copy(out, true);
+    }
+
+    void summarize(stat_distribution_t* out) const {
+        StatBins<N> bins;
+        snapshot(&bins);
+        bins.summarize(out);
+    }
+
+    /**
+     * @brief 清零（读过 percentile() 等之后开始新一轮；与 take() 不同，不需要一份桶的副本）
+     */
+    void reset() {
+        for (size_t i = 0; i < N; i++) {
+            bins_[i].store(0, std::memory_order_relaxed);
+        }
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    // take() 清零时也经由它（桶与最大值为 mutable）
+    void copy(StatBins<N>* out, bool clear) const {
+        out->count = 0;
+        out->width = width_;
+        for (size_t i = 0; i < N; i++) {
+            out->bins[i] = clear ? bins_[i].exchange(0, std::memory_order_relaxed)
+                                 : bins_[i].load(std::memory_order_relaxed);
+            out->count += out->bins[i];
+        }
+        out->max = clear ? max_.exchange(0, std::memory_order_relaxed) : max_.load(std::memory_order_relaxed);
+    }
+
+    const uint32_t width_;
+    mutable std::atomic<uint32_t> bins_[N];
+    mutable std::atomic<uint32_t> max_;
+};
+
+/**
+ * @brief 流式分位数草图：对数分桶（每个 2 的幂区间再等分 2^kSubBits 份），量程为整个 uint32
+ * 不需要事先知道量程与桶宽，更新与直方图一样只是一次原子加；分位数取桶中点，相对误差不超过 2^-(kSubBits+1)
+ * （默认 6.25%），小于 2^kSubBits 的值精确。与 P² / t-digest 不同，多个线程与中断可以同时更新同一个草图。
+ */
+template <unsigned kSubBits = 3>
+class StatQuantile {
+    static_assert(kSubBits >= 1 && kSubBits <= 6, "kSubBits out of range");
+    static const uint32_t kSub = 1u << kSubBits;
+
+public:
+    static const size_t kBins = (33 - kSubBits) * kSub;
+
+    StatQuantile() : count_(0), max_(0) {
+        for (size_t i = 0; i < kBins; i++) {
+            bins_[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void record(uint32_t value) {
+        bins_[bin_of(value)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        stat_atomic_max(max_, value);
+    }
+
+    uint32_t count() const { return count_.load(std::memory_order_relaxed); }
+    uint32_t max() const { return max_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 分位数（p 取 0~1）；没有样本时为 0
+     */
+    uint32_t quantile(float p) const {
+        const uint32_t total = count();
+        if (total == 0) {
+            return 0;
+        }
+        const uint32_t target = (uint32_t)(total * p);
+        const uint32_t max_value = max();
+        uint32_t seen = 0;
+        for (size_t i = 0; i < kBins; i++) {
+            seen += bins_[i].load(std::memory_order_relaxed);
+            if (seen > target) {
+                const uint32_t middle = bin_middle(i);
+                return middle < max_value ? middle : max_value;
+            }
+        }
+        return max_value;
+    }
+
+    void summarize(stat_distribution_t* out) const {
+        out->count = count();
+        out->max = max();
+        out->p50 = quantile(0.50f);
+        out->p90 = quantile(0.90f);
+        out->p99 = quantile(0.99f);
+    }
+
+    void reset() {
+        for (size_t i = 0; i < kBins; i++) {
+            bins_[i].store(0, std::memory_order_relaxed);
+        }
+        count_.store(0, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+    static size_t bin_of(uint32_t value) {
+        if (value < kSub) {
+            return value;
+        }
+        const unsigned msb = 31u - (unsigned)__builtin_clz(value);
+        const unsigned group = msb - kSubBits + 1;
+        return ((size_t)group << kSubBits) + ((value >> (msb - kSubBits)) & (kSub - 1));
+    }
+
+    static uint32_t bin_middle(size_t bin) {
+        if (bin < kSub) {
+            return (uint32_t)bin;
+        }
+        const unsigned group = (unsigned)(bin >> kSubBits);
+        const uint64_t lower = (uint64_t)(kSub + (bin & (kSub - 1))) << (group - 1);
+        const uint64_t middle = lower + ((1ull << (group - 1)) >> 1);
+        return middle > 0xFFFFFFFFull ? 0xFFFFFFFFu : (uint32_t)middle;
+    }
+
+private:
+    std::atomic<uint32_t> bins_[kBins];
+    std::atomic<uint32_t> count_;
+    std::atomic<uint32_t> max_;
+};
+
+#endif
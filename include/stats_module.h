@@ -0,0 +1,85 @@
+#ifndef STATS_MODULE_H
+#define STATS_MODULE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "stat_counters.h"
+
+// 统计注册表：各模块在初始化时按名称登记自己的 StatCounter / StatMax / StatHistogram / StatQuantile（stat_counters.h），
+// 诊断出口只通过这里枚举与编码，不必为每个新计数器增加字段：
+//   串口 "stats"                   每个统计量一行（stats_module_dump）
+//   shell STAT_READ（shell_module.h） 按序号读取一项的线上记录（stats_module_encode）
+//   统计特征值 19B10034 / USB 帧 0x34  诊断周期内轮流通知各项，同一线上记录
+// 线上记录为 wire_stat_t（wire_schema.h），其后是名称与值。登记不加锁（原子地领取表项），
+// 统计量须为静态对象（注册表只保存指针），名称须为静态字符串，超过 STATS_NAME_MAX 的部分在导出时截断。
+
+#define STATS_NAME_MAX 24
+
+enum stat_kind_t {
+    STAT_KIND_COUNTER = 1,      // uint32 计数
+    STAT_KIND_MAX = 2,          // uint32 最大值
+    STAT_KIND_DISTRIBUTION = 3, // stat_distribution_t
+};
+
+/**
+ * @brief 一个统计量的当前值
+ */
+struct stat_value_t {
+    const char* name;
+    uint8_t kind;                       // stat_kind_t
+    uint32_t value;                     // 计数 / 最大值
+    stat_distribution_t distribution;   // 分布（STAT_KIND_DISTRIBUTION）
+};
+
+typedef void (*stat_summarize_fn)(const void* stat, stat_distribution_t* out);
+
+void stats_module_register_counter(const char* name, const StatCounter* stat);
+void stats_module_register_max(const char* name, const StatMax* stat);
+void stats_module_register_distribution(const char* name, const void* stat, stat_summarize_fn summarize);
+
+template <size_t N>
+inline void stats_module_register(const char* name, const StatHistogram<N>* stat) {
+    stats_module_register_distribution(name, stat, [](const void* s, stat_distribution_t* out) {
+        static_cast<const StatHistogram<N>*>(s)->summarize(out);
+    });
+}
+
+template <unsigned kSubBits>
+inline void stats_module_register(const char* name, const StatQuantile<kSubBits>* stat) {
+    stats_module_register_distribution(name, stat, [](const void* s, stat_distribution_t* out) {
+        static_cast<const StatQuantile<kSubBits>*>(s)->summarize(out);
+    });
+}
+
+inline void stats_module_register(const char* name, const StatCounter* stat) {
+    stats_module_register_counter(name, stat);
+}
+
+inline void stats_module_register(const char* name, const StatMax* stat) {
+    stats_module_register_max(name, stat);
+}
+
+/**
+ * @brief 已登记的统计量数（登记满 STATS_REGISTRY_CAPACITY 后多出的被忽略，启动时打印警告）
+ */
+size_t stats_module_count();
+
+/**
+ * @brief 读取一项（任意线程，不阻塞更新者）
+ * @return false 序号超出范围
+ */
+bool stats_module_read(size_t index, stat_value_t* out);
+
+/**
+ * @brief 把一项编码为线上记录：wire_stat_t，name_length 字节名称（无 NUL），再按种类为 uint32 或 wire_stat_distribution_t
+ * @return 写入的字节数；序号超出范围或 capacity 不足时为 0
+ */
+size_t stats_module_encode(size_t index, uint8_t* out, size_t capacity);
+
+/**
+ * @brief 逐行导出所有统计量（"[Stats] <名称> <值>" 或 "[Stats] <名称> n .. p50 .. p90 .. p99 .. max .."）
+ * @param emit 每行调用一次（含换行符），在调用线程中直接输出
+ */
+void stats_module_dump(void (*emit)(const char* line));
+
+#endif
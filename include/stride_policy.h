@@ -0,0 +1,91 @@
+#ifndef STRIDE_POLICY_H
+#define STRIDE_POLICY_H
+
+#include <stdint.h>
+
+/**
+ * @brief 自适应推理步长策略
+ * 窗口每前进一个基本步长（SLIDING_WINDOW_STEP）调用一次 on_step()，返回 true 时运行推理；
+ * 推理结果通过 on_result() 反馈。连续多次稳定判定为 idle 后切换到粗步长，
+ * 一旦出现非 idle、置信度下降或新样本运动能量升高，立即回到细步长。
+ */
+class StridePolicy {
+public:
+    StridePolicy()
+        : fine_steps_(1), coarse_steps_(1), stable_required_(1), idle_confidence_(1.0f),
+          energy_threshold_(0.0f), steps_(0), stable_count_(0), coarse_(false) {}
+
+    /**
+     * @param fine_steps 细步长（基本步长的倍数，>= 1）
+     * @param coarse_steps 粗步长（基本步长的倍数，>= fine_steps；等于 fine_steps 即关闭自适应）
+     * @param stable_required 切换到粗步长前需要的连续稳定 idle 次数
+     * @param idle_confidence 判定为稳定 idle 的最低置信度
+     * @param energy_threshold 运动能量阈值（相邻样本差的均方，单位 g^2），超过即回到细步长
+     */
+    void configure(uint8_t fine_steps, uint8_t coarse_steps, uint8_t stable_required,
+                   float idle_confidence, float energy_threshold) {
+        fine_steps_ = fine_steps < 1 ? 1 : fine_steps;
+        coarse_steps_ = coarse_steps < fine_steps_ ? fine_steps_ : coarse_steps;
+        stable_required_ = stable_required < 1 ? 1 : stable_required;
+        idle_confidence_ = idle_confidence;
+        energy_threshold_ = energy_threshold;
+        stable_count_ = 0;
+        coarse_ = false;
+    }
+
+    /**
+     * @brief 窗口前进了一个基本步长
+     * @param energy 本步新样本的运动能量
+     * @return true 需要运行推理
+     */
+    bool on_step(float energy) {
+        steps_++;
+        if (coarse_ && energy > energy_threshold_) {
+            // 粗步长期间检测到运动：立即推理，不等凑满步长
+            fall_back_to_fine();
+            steps_ = 0;
+            return true;
+        }
+        if (steps_ >= current_steps()) {
+            steps_ = 0;
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief 反馈一次推理结果
+     * @param is_idle 本次结果是否为 idle 类别
+     * @param confidence 本次结果置信度
+     */
+    void on_result(bool is_idle, float confidence) {
+        if (is_idle && confidence >= idle_confidence_) {
+            if (stable_count_ < stable_required_) {
+                stable_count_++;
+            }
+            coarse_ = stable_count_ >= stable_required_;
+        } else {
+            fall_back_to_fine();
+        }
+    }
+
+    uint8_t current_steps() const { return coarse_ ? coarse_steps_ : fine_steps_; }
+    bool is_coarse() const { return coarse_; }
+
+private:
+    void fall_back_to_fine() {
+        stable_count_ = 0;
+        coarse_ = false;
+    }
+
+    uint8_t fine_steps_;
+    uint8_t coarse_steps_;
+    uint8_t stable_required_;
+    float idle_confidence_;
+    float energy_threshold_;
+    uint8_t steps_;
+    uint8_t stable_count_;
+    bool coarse_;
+};
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef SUPERVISOR_MODULE_H
+#define SUPERVISOR_MODULE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "thread_module.h"
+
+// 子系统监督：代替初始化失败时的 while(1)，让设备在现场从瞬时故障中自行恢复。
+// - 初始化：IMU / BLE 初始化失败时按指数退避重试；IMU 重试用尽后软件复位（重新上电初始化传感器），
+//   BLE 重试用尽后系统照常运行，由 BLE 线程在后台继续重试。
+// - 线程：主线程每 SUPERVISOR_POLL_MS 检查一次线程表，已退出的线程、发过心跳但超过 SUPERVISOR_STALL_MS
+//   没有新心跳的线程被重启（采集线程重启前重新配置传感器）；同一线程接连重启仍不恢复时软件复位。
+// - 传感器：采集线程读不到数据时自行重新配置 BMI270（见 imu_module_recover），不必等线程被判定卡死。
+// 推理线程另有硬件看门狗（watchdog_module.h）兜底：监督者所在的主线程本身被饿死时仍会复位。
+
+// 启动时初始化的子系统
+enum supervisor_subsystem_t {
+    SUPERVISOR_IMU = 0,  // inference_module_init（IMU + 模型检查）
+    SUPERVISOR_BLE,      // ble_module_init
+    SUPERVISOR_SUBSYSTEM_COUNT
+};
+
+struct supervisor_stats_t {
+    uint32_t init_attempts[SUPERVISOR_SUBSYSTEM_COUNT];  // 初始化尝试次数（1 = 第一次即成功）
+    bool init_ok[SUPERVISOR_SUBSYSTEM_COUNT];           // 当前是否已初始化成功
+    uint32_t restarts[THREAD_COUNT];                     // 各线程被重启的次数
+    uint32_t imu_recoveries;                             // 传感器重新配置的次数（采集线程自行恢复 + 重启时）
+    uint32_t imu_longest_outage_ms;                      // 最长一次传感器无数据的时间（到恢复出帧为止）
+};
+
+/**
+ * @brief 初始化一个子系统，失败时按指数退避（SUPERVISOR_BACKOFF_MIN_MS 起翻倍）重试
+ * @param init 初始化函数，必须可以重复调用
+ * @param max_attempts 最多尝试次数；0 = 一直重试直到成功
+ * @return bool 初始化成功
+ */
+bool supervisor_module_init(supervisor_subsystem_t subsystem, bool (*init)(), uint32_t max_attempts);
+
+/**
+ * @brief 子系统是否已初始化成功
+ */
+bool supervisor_module_ready(supervisor_subsystem_t subsystem);
+
+/**
+ * @brief 线程的心跳（在线程的主循环中每次调用）；第一次心跳之后该线程才受卡死检查
+ * 只有等待都有超时的线程才应发心跳，无限期阻塞在事件上的线程只检查是否退出。
+ */
+void supervisor_module_heartbeat(thread_role_t role);
+
+/**
+ * @brief 检查各线程并重启已退出或卡死的线程（主线程中每 SUPERVISOR_POLL_MS 调用一次）
+ */
+void supervisor_module_poll();
+
+/**
+ * @brief 无法恢复的故障：打印原因后软件复位（不返回）
+ */
+void supervisor_module_fatal(const char* reason);
+
+/**
+ * @brief 读取初始化与重启统计（线程安全）
+ */
+void supervisor_module_get_stats(supervisor_stats_t* out_stats);
+
+/**
+ * @brief 打印初始化重试、线程重启与传感器恢复统计（有过重试或恢复时才打印）
+ */
+void supervisor_module_report();
+
+#endif
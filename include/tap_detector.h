@@ -0,0 +1,93 @@
+#ifndef TAP_DETECTOR_H
+#define TAP_DETECTOR_H
+
+#include <stdint.h>
+
+/**
+ * @brief 两段式识别的唤醒手势：在逐帧运动能量上检测双击
+ * 敲击是短促的能量尖峰：超过阈值的连续帧不超过 max_pulse_frames 帧，之后回落；
+ * 更长的超阈值段是一般运动，会作废已记下的第一次敲击。两次敲击的起点间隔落在
+ * [min_gap_frames, max_gap_frames] 内即判定为双击；间隔过短的尖峰视为第一次敲击的余振，忽略。
+ * 每帧只有几次比较，可以常开。
+ */
+class TapDetector {
+public:
+    TapDetector()
+        : threshold_(0.0f), max_pulse_(1), min_gap_(0), max_gap_(0), pulse_(0), since_first_(0),
+          first_tap_(false) {}
+
+    /**
+     * @param threshold 单帧运动能量阈值（相邻样本差的平方和，与窗口数据同一物理单位，加速度为 g^2）
+     * @param max_pulse_frames 一次敲击超过阈值的最长帧数（>= 1）
+     * @param min_gap_frames 两次敲击起点的最短间隔（帧）
+     * @param max_gap_frames 两次敲击起点的最长间隔（帧）
+     */
+    void configure(float threshold, uint16_t max_pulse_frames, uint16_t min_gap_frames, uint16_t max_gap_frames) {
+        threshold_ = threshold;
+        max_pulse_ = max_pulse_frames < 1 ? 1 : max_pulse_frames;
+        min_gap_ = min_gap_frames;
+        max_gap_ = max_gap_frames;
+        reset();
+    }
+
+    void reset() {
+        pulse_ = 0;
+        since_first_ = 0;
+        first_tap_ = false;
+    }
+
+    /**
+     * @brief 输入一帧的运动能量
+     * @return true 这一帧结束了一次双击（检测器随即复位）
+     */
+    bool on_frame(float energy) {
+        if (first_tap_) {
+            since_first_++;
+        }
+        if (energy > threshold_) {
+            // 超过 max_pulse_ 后饱和：整段都不算敲击
+            if (pulse_ <= max_pulse_) {
+                pulse_++;
+            }
+            if (pulse_ > max_pulse_) {
+                first_tap_ = false;
+            }
+            return false;
+        }
+
+        const uint16_t pulse = pulse_;
+        pulse_ = 0;
+        if (pulse == 0 || pulse > max_pulse_) {
+            if (first_tap_ && since_first_ > (uint32_t)max_gap_ + max_pulse_) {
+                first_tap_ = false;
+            }
+            return false;
+        }
+
+        // 一次敲击在这一帧结束，它的起点在 pulse 帧之前
+        if (first_tap_) {
+            const uint32_t gap = since_first_ - pulse;
+            if (gap < min_gap_) {
+                return false;
+            }
+            if (gap <= max_gap_) {
+                reset();
+                return true;
+            }
+        }
+        first_tap_ = true;
+        since_first_ = pulse;
+        return false;
+    }
+
+private:
+    float threshold_;
+    uint16_t max_pulse_;
+    uint16_t min_gap_;
+    uint16_t max_gap_;
+    uint16_t pulse_;
+    uint32_t since_first_;
+    bool first_tap_;
+};
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef TCN_MODEL_H
+#define TCN_MODEL_H
+
+// TCN 推理引擎的模型：因果膨胀一维卷积层 + 最新一帧上的分类头（见 tcn_module.cpp 与 SDK 的
+// inferencing_engines/tcn.h）
+// 由 pc_controller/tcn_export.py 生成；尚未训练时没有层，推理仍用 CNN
+
+#include <stdint.h>
+#include "edge-impulse-sdk/classifier/ei_model_types.h"
+
+#define TCN_MODEL_LAYERS 0
+#define TCN_MODEL_INPUT_CHANNELS 0
+#define TCN_MODEL_CLASSES 0
+#define TCN_MODEL_RECEPTIVE_FIELD 0
+#define TCN_MODEL_TEST_FRAMES 0
+
+static const ei_learning_block_config_tcn_t kTcnConfig = {1, 0, 0, 0.0f, 0, nullptr, 0, nullptr, nullptr, 0, 0.0f, 0, nullptr};
+static const int8_t kTcnTestFrames[1] = {0};
+static const float kTcnTestScores[1] = {0.0f};
+
+#endif
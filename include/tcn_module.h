@@ -0,0 +1,44 @@
+#ifndef TCN_MODULE_H
+#define TCN_MODULE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// TCN 推理引擎（INFERENCE_TCN_ENGINE）：用因果膨胀一维卷积网络代替 CNN 对 int8 窗口分类。
+// 每层保存自己的历史帧（SDK 的 inferencing_engines/tcn.h），每次推理只把上次以来进入窗口的新帧
+// 逐帧送入网络，耗时与新样本数成正比，与感受野长度无关。
+// 模型由 pc_controller/tcn_export.py 生成到 include/tcn_model.h；尚未训练、形状或输入量化与窗口
+// 不符、或自检失败时模块保持未就绪，推理仍用 CNN。只在推理线程中调用。
+
+/**
+ * @brief 核对 tcn_model.h 并运行自检（启动时与更换 CNN 权重后调用）
+ * @param input_scale 窗口样本的量化 scale（CNN 输入张量）
+ * @param input_zero_point 窗口样本的量化零点
+ * @return true TCN 就绪，之后的推理由它完成
+ */
+bool tcn_module_init(float input_scale, int32_t input_zero_point);
+
+/**
+ * @brief TCN 是否就绪
+ */
+bool tcn_module_ready();
+
+/**
+ * @brief 对环形 int8 窗口推理：只送入最新的 new_values 个样本（整帧）
+ * new_values 达到窗口长度（刚启动、窗口被重建）时先复位历史，再按时间顺序送入整个窗口
+ * @param window 环形窗口，最旧的样本位于 head
+ * @param head 最旧样本的下标
+ * @param new_values 上次推理以来新写入的样本数
+ * @param out_scores 输出各类别概率
+ * @param num_scores out_scores 的容量
+ * @return true 推理成功
+ */
+bool tcn_module_stream_invoke(const int8_t* window, size_t head, size_t new_values,
+                              float* out_scores, size_t num_scores);
+
+/**
+ * @brief 丢弃历史，下一次推理重新送入整个窗口
+ */
+void tcn_module_reset();
+
+#endif
@@ -0,0 +1,175 @@
+#ifndef TELEMETRY_MODULE_H
+#define TELEMETRY_MODULE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "app_config.h"
+#include "model-parameters/model_metadata.h"
+
+// 现场诊断日志（TELEMETRY_ENABLE）：片上 Flash 中只追加的环形日志，设备“不再识别”时上位机整批读出，
+// 看清之前发生了什么。
+//
+// Flash 布局：TELEMETRY_SECTORS 个 4 KB 扇区（calib_store），每个扇区以 {魔数, 序号} 开头，其后是首尾相接的
+// 记录。写满一个扇区后打开下一个：擦除最旧的扇区并写入更大的序号，因此每个扇区轮流擦除，磨损均匀；
+// 启动时按序号找到最新的扇区，沿记录走到第一个未写入的字。每个字只编程一次，不需要先读后写。
+//
+// 记录：8 字节头部 {uint8 类型, uint8 负载长度, uint16 CRC-16/CCITT-FALSE（头部其余字段与负载）,
+// uint32 自启动以来的毫秒数}，负载补齐到 4 字节，小端。各线程只把记录追加到 RAM 中的批缓冲
+// （双缓冲，互斥锁只保护追加与交换），主循环在攒满 TELEMETRY_BATCH_BYTES 或等待超过 TELEMETRY_FLUSH_MS 时
+// 一次写入：编程期间 CPU 暂停（每个字约 41 µs），擦除只在换扇区时发生，每 4 KB 一次。
+//
+// 读出：BLE 线程开始一次导出时先写入待写的记录并暂停写入（记录在 RAM 中等待），然后按时间顺序把各扇区的
+// 记录部分（不含扇区头）拼成一条字节流，分块发送；导出结束后恢复写入。
+
+/**
+ * @brief 记录类型（负载格式见各项）
+ */
+enum telemetry_record_type_t {
+    TELEMETRY_RESET = 1,           // uint8 复位原因（mbed reset_reason_t，0xFF = 未知），3 字节保留
+    TELEMETRY_GESTURE,             // wire_result_t（wire_schema.h）：int8 类别，uint8 置信度 x 255，uint16 结果序号的低 16 位
+    TELEMETRY_LOW_CONFIDENCE,      // uint8 获胜类别（0xFF = 未知），uint8 置信度 x 255，uint16 此前因限速未记录的个数
+    TELEMETRY_HISTOGRAM,           // uint16 x TELEMETRY_HISTOGRAM_BINS：各置信度区间（等宽，[0, 1]）的 CNN 推理次数
+    TELEMETRY_LATENCY_SLO,         // uint8 阶段（latency_stage_t），1 字节保留，uint16 超标次数，uint32 p99 与最大值（µs）
+    TELEMETRY_FATAL,               // 监督者复位前的原因（ASCII，不含结尾的 0，最长 TELEMETRY_MAX_PAYLOAD 字节）
+    TELEMETRY_CRASH,               // 上次复位前的崩溃（crash_module.h）：uint8 类型，uint8 线程，2 字节保留，uint32 mbed 错误码、pc 与 lr
+    TELEMETRY_LABEL_HISTOGRAM,     // uint8 类别，uint8 种类（telemetry_label_histogram_kind_t），2 字节保留，
+                                   // uint16 x TELEMETRY_LABEL_BINS：这一周期内该类别获胜的窗口按分箱计数
+    TELEMETRY_SHADOW,              // telemetry_shadow_t：影子模式一个周期的判定一致性与候选模型耗时
+    TELEMETRY_SHADOW_HISTOGRAM,    // telemetry_shadow_histogram_t：同一周期内一个模型获胜类别的概率直方图
+};
+
+/**
+ * @brief 影子模式一个周期（INFERENCE_SHADOW_REPORT_RUNS 次对比）的记录，计数的含义见 shadow_tally.h
+ */
+struct telemetry_shadow_t {
+    uint8_t candidate;        // 候选模型序号
+    uint8_t production;       // 生产模型序号
+    uint16_t runs;
+    uint16_t agree;
+    uint16_t candidate_only;
+    uint16_t production_only;
+    uint16_t differ;
+    uint16_t deferred;        // 让路而没有运行的次数
+    uint16_t reserved;
+    uint32_t mean_us;         // 候选模型的平均与最大耗时
+    uint32_t max_us;
+};
+
+/**
+ * @brief 同一周期内一个模型获胜类别的概率直方图（等宽 10 箱，[0, 1]）
+ */
+struct telemetry_shadow_histogram_t {
+    uint8_t model;            // 模型序号
+    uint8_t candidate;        // 1 = 候选模型，0 = 生产模型
+    uint16_t reserved;
+    uint16_t bins[10];
+};
+
+static_assert(sizeof(telemetry_shadow_t) == 24, "telemetry shadow record layout");
+static_assert(sizeof(telemetry_shadow_histogram_t) == 24, "telemetry shadow histogram layout");
+
+/**
+ * @brief 逐类别直方图的种类：两者都按 uint8 量化（x 255）后取高 3 位分箱，每箱 32 级
+ */
+enum telemetry_label_histogram_kind_t {
+    TELEMETRY_LABEL_TOP = 0,       // 获胜类别的概率
+    TELEMETRY_LABEL_MARGIN,        // 获胜类别与第二名的概率差
+};
+
+#define TELEMETRY_SECTOR_BYTES 4096
+#define TELEMETRY_SECTOR_MAGIC 0x544C4731  // "TLG1"
+#define TELEMETRY_HISTOGRAM_BINS 10
+#define TELEMETRY_LABEL_BINS 8
+#define TELEMETRY_LABELS EI_CLASSIFIER_LABEL_COUNT
+#define TELEMETRY_MAX_PAYLOAD 32
+#define TELEMETRY_RECORD_HEADER_BYTES 8
+
+struct telemetry_status_t {
+    bool dumping;             // 正在导出（写入暂停）
+    uint16_t pending_bytes;   // RAM 中等待写入的字节数
+    uint32_t records;         // 自启动以来追加的记录数
+    uint32_t dropped;         // 批缓冲已满而丢弃的记录数
+    uint32_t log_bytes;       // Flash 中记录的总字节数（即一次导出的长度，不含 RAM 中待写的记录）
+    uint32_t sequence;        // 最新扇区的序号（打开过的扇区总数）
+    uint32_t flash_errors;    // 擦除或编程失败的次数
+};
+
+/**
+ * @brief 一个类别自启动以来的直方图（该类别获胜的窗口）
+ */
+struct telemetry_label_histogram_t {
+    uint32_t top[TELEMETRY_LABEL_BINS];
+    uint32_t margin[TELEMETRY_LABEL_BINS];
+};
+
+/**
+ * @brief 扫描 Flash 找到写入位置，并记录这次复位的原因（setup 中调用，在任何线程启动之前）
+ */
+void telemetry_module_init();
+
+/**
+ * @brief 主循环定期调用：到期时追加置信度直方图，攒满或超时时把批缓冲写入 Flash
+ */
+void telemetry_module_poll();
+
+/**
+ * @brief 立即把批缓冲写入 Flash（导出前、复位前；导出期间不写）
+ */
+void telemetry_module_flush();
+
+/**
+ * @brief 追加一条记录（任意线程；只复制到 RAM）
+ * @return false 负载过长或批缓冲已满（计入 dropped）
+ */
+bool telemetry_module_record(telemetry_record_type_t type, const void* payload, size_t length);
+
+/**
+ * @brief 推理线程在每次运行 CNN 后调用：计入置信度直方图与获胜类别的逐类别直方图（常数时间），
+ * 低于阈值时（限速）追加低置信度记录
+ * @param index 获胜类别（-1 = 未知）
+ * @param confidence 获胜类别的概率
+ * @param runner_up_confidence 第二名的概率（没有第二名时为 0）
+ * @param low 该窗口因置信度不足而没有结果
+ */
+void telemetry_module_window(int index, float confidence, float runner_up_confidence, bool low);
+
+/**
+ * @brief 读取一个类别自启动以来的直方图（任意线程）
+ * @return false 类别越界
+ */
+bool telemetry_module_label_histogram(size_t label, telemetry_label_histogram_t* out_histogram);
+
+/**
+ * @brief 推理线程发布一个手势结果时调用（idle 不记录）
+ */
+void telemetry_module_gesture(int index, float confidence, uint32_t sequence);
+
+/**
+ * @brief 推理线程在每个统计窗口的延迟报告之后调用：为超过 LATENCY_SLO_MS 的阶段追加记录
+ */
+void telemetry_module_latency();
+
+/**
+ * @brief 开始一次导出（BLE 线程）：写入待写的记录并暂停写入
+ * @return 导出的字节数
+ */
+uint32_t telemetry_module_dump_begin();
+
+/**
+ * @brief 读取导出字节流中的一段（只在 dump_begin 与 dump_end 之间有效）
+ * @return 实际复制的字节数（到达末尾时小于 length）
+ */
+size_t telemetry_module_dump_read(uint32_t offset, uint8_t* out, size_t length);
+
+/**
+ * @brief 结束导出，恢复写入
+ */
+void telemetry_module_dump_end();
+
+/**
+ * @brief 当前状态的副本，任意线程可调用
+ */
+void telemetry_module_get_status(telemetry_status_t* out_status);
+
+#endif
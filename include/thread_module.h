@@ -0,0 +1,82 @@
+#ifndef THREAD_MODULE_H
+#define THREAD_MODULE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+class PeriodicTimer;
+
+// 线程表：各线程的优先级与栈大小在 app_config.h 中配置，栈由本模块静态分配。
+// 栈在线程启动前填满固定字，运行时从栈底向上找第一个被改写的字，得到每个线程的栈峰值
+// （不依赖 RTX 的栈水位选项，预编译的 Mbed 核心中它通常是关闭的）。
+
+// 线程角色（线程表中的顺序）
+enum thread_role_t {
+    THREAD_SAMPLER = 0,
+    THREAD_INFERENCE,
+    THREAD_BLE,
+    THREAD_EVENTS,  // LED 与日志的事件线程（event_module.h）
+    THREAD_RECORD,
+    THREAD_HCI,
+    THREAD_COUNT
+};
+
+struct thread_stack_stats_t {
+    const char* name;
+    int priority;         // osPriority_t 数值
+    uint32_t stack_bytes;
+    uint32_t peak_bytes;  // 启动以来的栈使用峰值
+};
+
+/**
+ * @brief 提前启动线程表中的一个线程（setup 中，其余线程启动之前），例如让 BLE 协议栈与 IMU 初始化并行启动
+ * @return bool 启动成功（已启动时直接返回 true）
+ */
+bool thread_module_start_early(thread_role_t role);
+
+/**
+ * @brief 按线程表填充栈并启动全部（尚未提前启动的）线程，登记栈到 RAM 预算
+ * @return bool 全部线程启动成功
+ */
+bool thread_module_start();
+
+/**
+ * @brief 读取一个线程的栈使用情况
+ */
+void thread_module_get_stats(thread_role_t role, thread_stack_stats_t* out_stats);
+
+/**
+ * @brief 地址落在哪个线程的栈内（崩溃记录据此找出出错线程；不调用 RTOS，可在故障处理中使用）
+ * @return 线程角色；不在任何线程栈内（主线程、中断）时返回 THREAD_COUNT
+ */
+thread_role_t thread_module_role_at(uintptr_t address);
+
+/**
+ * @brief 登记一个线程的周期节拍（include/periodic_timer.h），报告中随栈统计一起打印周期与超时次数
+ * 节拍对象须在线程的整个生命周期内有效（通常是永不返回的任务函数中的局部变量）。
+ */
+void thread_module_register_timer(thread_role_t role, const PeriodicTimer* timer);
+
+/**
+ * @brief 串口打印各线程的优先级、栈大小与栈峰值，以及登记的周期节拍的超时次数
+ */
+void thread_module_report();
+
+/**
+ * @brief 线程是否仍在运行（已启动且任务函数没有返回、没有被终止）
+ */
+bool thread_module_running(thread_role_t role);
+
+/**
+ * @brief 终止一个线程（监督者在重启前调用；线程持有的 RTOS 互斥量由内核释放）
+ */
+void thread_module_stop(thread_role_t role);
+
+/**
+ * @brief 重新启动一个线程：仍在运行时先终止，重新填充栈后以线程表中的参数启动
+ * 栈峰值统计随之从零开始。任务函数必须能从头再次运行。
+ * @return bool 启动成功
+ */
+bool thread_module_restart(thread_role_t role);
+
+#endif
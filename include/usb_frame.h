@@ -0,0 +1,149 @@
+#ifndef USB_FRAME_H
+#define USB_FRAME_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// USB CDC 二进制链路的帧格式（与 pc_controller/serial_manager.py 对应）：
+//
+//   0x00 | COBS(type(1) | payload | crc16(2)) | 0x00
+//
+// COBS 编码后帧内不含 0x00，两端的 0x00 是分隔符，因此二进制帧可以与串口文本日志 / 命令行混在同一条
+// 串口上：收方把两个 0x00 之间的字节按帧解码，CRC 不符的段（文本、被截断的帧）丢弃或交给文本处理。
+// crc16 为 CRC-16/CCITT-FALSE（多项式 0x1021，初值 0xFFFF），覆盖 type 与 payload，小端。
+//
+// type 取 BLE 数据服务中对应特征值 UUID 的最低字节，payload 与该特征值的通知 / 写入内容完全相同
+// （格式见 src/ble_module.cpp），上位机对两种传输使用同一套解码函数。链路自身只增加 USB_FRAME_HELLO 与
+// USB_FRAME_SHELL。
+
+#define USB_FRAME_DELIMITER     0x00
+// type + 最长的 payload（一次 247 字节 MTU 的通知）+ crc16
+#define USB_FRAME_MAX_CONTENT   (1 + 244 + 2)
+// COBS 每 254 字节增加 1 字节，再加两个分隔符
+#define USB_FRAME_MAX_BYTES     (USB_FRAME_MAX_CONTENT + USB_FRAME_MAX_CONTENT / 254 + 1 + 2)
+
+// 链路控制：主机写入 uint8 订阅位图（USB_STREAM_*，0 = 关闭链路）打开链路并每秒重发保活，
+// 设备回复 uint8 生效的位图、uint8 链路协议版本、uint8 记录格式版本（WIRE_SCHEMA_VERSION，wire_schema.h）
+// 与结果置信度的量化参数（wire_confidence_format_t）
+#define USB_FRAME_HELLO         0x01
+#define USB_LINK_VERSION        1
+
+// 设备 → 主机（与特征值 19B100xx 对应）
+#define USB_FRAME_DIAGNOSTICS   0x13
+#define USB_FRAME_RECORD_DATA   0x15
+#define USB_FRAME_EVENTS        0x16
+#define USB_FRAME_CPU           0x17
+#define USB_FRAME_LATENCY       0x19
+#define USB_FRAME_CONFIG        0x1A  // 双向：写入与 BLE 相同的配置，设备在配置变化时发出
+#define USB_FRAME_GESTURE       0x1B
+#define USB_FRAME_SCORES        0x1E
+#define USB_FRAME_WINDOW        0x1F
+#define USB_FRAME_MISSED        0x21  // 双向：主机写入补发请求，设备回复补发的事件
+#define USB_FRAME_TIME_SYNC     0x24  // 双向：主机写入同步请求，设备回复
+#define USB_FRAME_COUNTERS      0x25
+#define USB_FRAME_SEGMENT       0x28  // 手势保持状态：确认与结束各一帧
+#define USB_FRAME_INFERENCE_BENCH 0x29  // 双向：主机写入推理基准请求，设备在完成时发出报告
+#define USB_FRAME_TELEMETRY     0x2B  // 双向：主机写入诊断日志命令，设备回复状态
+#define USB_FRAME_TELEMETRY_DATA 0x2C  // 诊断日志导出的数据块
+#define USB_FRAME_COMBO         0x2D  // 双向：主机写入组合表，设备在链路打开与每次写入后发出生效的组合表
+#define USB_FRAME_COMBO_EVENT   0x2E  // 完成的组合
+#define USB_FRAME_POWER         0x2F  // 电量分级的工作点与电池电压
+#define USB_FRAME_TRACE         0x30  // 区段追踪流
+#define USB_FRAME_CRASH         0x31  // 上次复位前的崩溃报告（会话开始时）
+#define USB_FRAME_ONSET         0x33  // 手势起始的临时判定与确认 / 撤销（wire_onset_t）
+#define USB_FRAME_STATS         0x34  // 统计注册表的一项（wire_stat_t，诊断周期内轮流发送）
+
+// 诊断命令（shell_module.h）：主机写入请求，设备以同一类型应答；不需要打开链路，与 BLE 没有对应的特征值
+#define USB_FRAME_SHELL         0x32
+
+// 主机 → 设备
+#define USB_FRAME_RECORD_CONTROL 0x14
+#define USB_FRAME_ACK           0x18
+
+// 订阅位图（hello 的 payload）
+#define USB_STREAM_EVENTS       0x01  // 结果事件（含补发）、打包的最新结果、手势保持状态与完成的组合
+#define USB_STREAM_SCORES       0x02
+#define USB_STREAM_WINDOW       0x04
+#define USB_STREAM_DIAGNOSTICS  0x08  // 采样诊断、CPU 占用、延迟报告与配置
+#define USB_STREAM_RECORD       0x10  // 原始 IMU 录制包
+#define USB_STREAM_TRACE        0x20  // 区段追踪流
+
+/**
+ * @brief CRC-16/CCITT-FALSE
+ */
+inline uint16_t usb_frame_crc16(const uint8_t* data, size_t length, uint16_t crc = 0xFFFF) {
+    for (size_t i = 0; i < length; i++) {
+        crc ^= (uint16_t)(data[i] << 8);
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/**
+ * @brief 编码一帧（含两端的分隔符）
+ * @param out 输出缓冲，至少 USB_FRAME_MAX_BYTES 字节
+ * @return 帧长；payload 过长时返回 0
+ */
+inline size_t usb_frame_encode(uint8_t type, const uint8_t* payload, size_t length, uint8_t* out) {
+    if (1 + length + 2 > USB_FRAME_MAX_CONTENT) {
+        return 0;
+    }
+    uint16_t crc = usb_frame_crc16(&type, 1);
+    crc = usb_frame_crc16(payload, length, crc);
+    const uint8_t crc_bytes[2] = {(uint8_t)crc, (uint8_t)(crc >> 8)};
+
+    size_t n = 0;
+    out[n++] = USB_FRAME_DELIMITER;
+    size_t code_at = n++;
+    uint8_t code = 1;
+    const size_t total = 1 + length + 2;
+    for (size_t i = 0; i < total; i++) {
+        const uint8_t byte = i == 0 ? type : (i <= length ? payload[i - 1] : crc_bytes[i - 1 - length]);
+        if (byte == 0) {
+            out[code_at] = code;
+            code_at = n++;
+            code = 1;
+            continue;
+        }
+        out[n++] = byte;
+        if (++code == 0xFF) {
+            out[code_at] = code;
+            code_at = n++;
+            code = 1;
+        }
+    }
+    out[code_at] = code;
+    out[n++] = USB_FRAME_DELIMITER;
+    return n;
+}
+
+/**
+ * @brief 解码两个分隔符之间的 COBS 段并检查 CRC
+ * @param out 输出 type + payload（不含 crc16），至少 length 字节
+ * @return type + payload 的长度；COBS 或 CRC 不合法时返回 0
+ */
+inline size_t usb_frame_decode(const uint8_t* data, size_t length, uint8_t* out) {
+    size_t n = 0;
+    size_t i = 0;
+    while (i < length) {
+        const uint8_t code = data[i++];
+        if (code == 0 || i + code - 1 > length) {
+            return 0;
+        }
+        for (uint8_t k = 1; k < code; k++) {
+            out[n++] = data[i++];
+        }
+        if (code != 0xFF && i < length) {
+            out[n++] = 0;
+        }
+    }
+    if (n < 3) {
+        return 0;
+    }
+    const uint16_t crc = (uint16_t)(out[n - 2] | (out[n - 1] << 8));
+    return usb_frame_crc16(out, n - 2) == crc ? n - 2 : 0;
+}
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef USB_LINK_MODULE_H
+#define USB_LINK_MODULE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "usb_frame.h"
+
+// USB CDC 二进制链路（USB_LINK_ENABLE，帧格式见 usb_frame.h）：有线安装时代替 BLE 向上位机
+// （pc_controller/serial_manager.py）发送结果事件、分数、窗口、原始 IMU 与诊断数据，不经过无线电。
+//
+// 录制线程读取串口时把每个字节交给 usb_link_module_feed：两个 0x00 之间的字节按帧解码，其余字节仍是
+// 文本命令。hello、时钟同步与诊断命令（shell_module.h）在录制线程中当场回复；其余主机写入的帧（ack、补发请求、配置、录制控制）
+// 进入队列，由 BLE 线程的 USB 会话处理（ble_module.cpp）。发送在 BLE 线程中，每帧一次 Serial.write，
+// 与日志线程的整行写入不会交错。
+
+// 主机写入的帧中最长的 payload（完整的配置写入为 7 字节）
+#define USB_LINK_INBOUND_MAX 16
+
+/**
+ * @brief 主机写入、等待 BLE 线程处理的帧
+ */
+struct usb_link_frame_t {
+    uint8_t type;
+    uint8_t length;
+    uint8_t data[USB_LINK_INBOUND_MAX];
+};
+
+/**
+ * @brief 处理从串口读到的一个字节（录制线程）
+ * @return true 字节属于二进制帧；false 是文本命令的字节，由调用者继续解析
+ */
+bool usb_link_module_feed(uint8_t byte);
+
+/**
+ * @brief 链路是否打开：主机发出了非零的 hello，且最近 USB_LINK_TIMEOUT_MS 内收到过保活
+ */
+bool usb_link_module_open();
+
+/**
+ * @brief 主机是否订阅了该类型的帧（hello 的订阅位图；补发回复、时钟同步与配置总是发送）
+ */
+bool usb_link_module_subscribed(uint8_t type);
+
+/**
+ * @brief 发送一帧（BLE 线程；hello 与诊断命令的应答在录制线程）
+ * @return false 链路未打开、主机未订阅或 payload 过长（hello 与诊断应答不检查链路）
+ */
+bool usb_link_module_send(uint8_t type, const uint8_t* payload, size_t length);
+
+/**
+ * @brief 取出一个主机写入的帧（BLE 线程）
+ * @return true 取到一个帧
+ */
+bool usb_link_module_pop(usb_link_frame_t* out_frame);
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef VOTE_SMOOTHER_H
+#define VOTE_SMOOTHER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief 投票平滑：最近 N 次结果中票数最多且不少于 min_same 票的类别作为输出
+ * 与 Edge Impulse ei_classifier_smooth 的判定相同（初始历史全部为 uncertain，并列时序号小者胜），
+ * 但历史环形缓冲区静态分配，并增量维护各类别票数：每次更新只改两个计数，不再重扫整个历史。
+ * @tparam MaxLabels 类别数上限
+ * @tparam MaxReadings 历史长度上限
+ */
+template <size_t MaxLabels, size_t MaxReadings>
+class VoteSmoother {
+    static_assert(MaxReadings <= 255, "vote counts are stored as uint8_t");
+
+public:
+    static const int kUncertain = -1;
+
+    VoteSmoother() : labels_(0), readings_(1), min_same_(1), confidence_(0.8f) {
+        reset();
+    }
+
+    /**
+     * @param labels 类别数（不超过 MaxLabels）
+     * @param readings 参与投票的历史结果个数（超过 MaxReadings 时截断）
+     * @param min_same 输出一个类别至少需要的票数
+     * @param confidence 一次结果计为该类别一票的最低置信度（否则计为 uncertain）
+     */
+    void configure(size_t labels, size_t readings, uint8_t min_same, float confidence) {
+        labels_ = labels > MaxLabels ? MaxLabels : labels;
+        readings_ = readings < 1 ? 1 : (readings > MaxReadings ? MaxReadings : readings);
+        min_same_ = min_same;
+        confidence_ = confidence;
+        reset();
+    }
+
+    /**
+     * @brief 清空历史（全部记为 uncertain）
+     */
+    void reset() {
+        for (size_t i = 0; i < MaxReadings; i++) {
+            history_[i] = (uint8_t)labels_;
+        }
+        for (size_t i = 0; i <= MaxLabels; i++) {
+            count_[i] = 0;
+        }
+        count_[labels_] = (uint8_t)readings_;
+        next_ = 0;
+        top_count_ = 0;
+    }
+
+    /**
+     * @brief 加入一次结果并返回平滑后的类别
+     * @param index 本次获胜类别（-1 = 无）
+     * @param confidence 本次获胜类别的置信度
+     * @return int 平滑后的类别，kUncertain = 没有类别达到 min_same 票（或 uncertain 票最多）
+     */
+    int update(int index, float confidence) {
+        const uint8_t reading =
+            (index >= 0 && (size_t)index < labels_ && confidence >= confidence_) ? (uint8_t)index : (uint8_t)labels_;
+        count_[history_[next_]]--;
+        count_[reading]++;
+        history_[next_] = reading;
+        if (++next_ >= readings_) {
+            next_ = 0;
+        }
+
+        size_t top = 0;
+        top_count_ = 0;
+        for (size_t i = 0; i <= labels_; i++) {
+            if (count_[i] > top_count_) {
+                top = i;
+                top_count_ = count_[i];
+            }
+        }
+        if (top_count_ < min_same_ || top == labels_) {
+            return kUncertain;
+        }
+        return (int)top;
+    }
+
+    /**
+     * @brief 上一次更新中票数最多的类别所占的比例（0..1）
+     */
+    float vote_fraction() const { return (float)top_count_ / readings_; }
+
+private:
+    size_t labels_;
+    size_t readings_;
+    uint8_t min_same_;
+    float confidence_;
+
+    // 历史中每个元素是类别序号，labels_ 表示 uncertain
+    uint8_t history_[MaxReadings];
+    uint8_t count_[MaxLabels + 1];
+    size_t next_;
+    uint8_t top_count_;
+};
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef WATCHDOG_MODULE_H
+#define WATCHDOG_MODULE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 推理线程看门狗
+// 只有推理线程在每次循环时喂狗，其它线程照常运行也不能让它免于复位：推理线程卡死（死循环、
+// 死锁、被高优先级线程饿死）超过 WATCHDOG_TIMEOUT_MS 时硬件复位。较短的停顿（超过 WATCHDOG_STALL_MS）
+// 不复位，计入停滞统计；复位原因在下次启动时读出，一并报告。
+
+struct watchdog_stats_t {
+    uint32_t stalls;          // 启动以来推理线程停滞的次数
+    uint32_t longest_gap_ms;  // 启动以来两次循环之间的最长间隔
+    bool watchdog_reset;      // 上一次复位由看门狗触发
+};
+
+/**
+ * @brief 读取复位原因并打印（setup 中调用，在任何线程启动之前）
+ */
+void watchdog_module_init();
+
+/**
+ * @brief 启动硬件看门狗（推理线程进入主循环时调用；启动后无法停止，再次调用只重新开始停滞计时）
+ */
+void watchdog_module_start();
+
+/**
+ * @brief 推理线程完成一次循环：喂狗并更新停滞统计（只在推理线程中调用）
+ */
+void watchdog_module_progress();
+
+/**
+ * @brief 读取停滞统计（线程安全）
+ */
+void watchdog_module_get_stats(watchdog_stats_t* out_stats);
+
+/**
+ * @brief 打印停滞统计（有停滞或上次为看门狗复位时才打印）
+ */
+void watchdog_module_report();
+
+#endif
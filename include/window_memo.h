@@ -0,0 +1,100 @@
+#ifndef WINDOW_MEMO_H
+#define WINDOW_MEMO_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @brief 结果记忆：窗口与上次分类的窗口几乎相同时直接沿用上次的结果，不运行 CNN
+ * 分类时保存环形窗口的快照；之后每步只比较新写入的值与快照中同一位置（即被挤出的旧值）的差，
+ * 增量累加 L1 距离，代价与步长成正比。新值的平均绝对差不超过容差即命中。
+ * 窗口被完整替换（或超过最大沿用次数）后必须重新分类，因此每个位置在两次分类之间最多写入一次。
+ * @tparam T 窗口值类型（int8 量化窗口或浮点窗口）
+ * @tparam N 窗口值个数
+ */
+template <typename T, size_t N>
+class WindowMemo {
+public:
+    WindowMemo()
+        : tolerance_(0.0f), max_reuse_(0), distance_(0.0f), changed_(0), reused_(0), valid_(false),
+          index_(-1), confidence_(0.0f), checks_(0), hits_(0) {}
+
+    /**
+     * @param tolerance 新值与被替换值的平均绝对差上限（窗口数据单位，量化窗口为 LSB）；<= 0 即关闭
+     * @param max_reuse 连续沿用的最多次数，之后强制重新分类
+     */
+    void configure(float tolerance, uint16_t max_reuse) {
+        tolerance_ = tolerance;
+        max_reuse_ = max_reuse;
+        invalidate();
+    }
+
+    void invalidate() { valid_ = false; }
+
+    /**
+     * @brief 窗口的 [pos, pos + length) 刚写入新值（调用者保证不跨越环形窗口末尾）
+     */
+    void on_step(const T* window, size_t pos, size_t length) {
+        if (!valid_) {
+            return;
+        }
+        float distance = 0.0f;
+        for (size_t i = pos; i < pos + length; i++) {
+            const float d = (float)window[i] - (float)snapshot_[i];
+            distance += d < 0.0f ? -d : d;
+        }
+        distance_ += distance;
+        changed_ += length;
+    }
+
+    /**
+     * @brief 判定本次能否沿用上次的结果，并计入统计
+     * @param out_index 输出上次的类别（-1 = 低于阈值）
+     * @param out_confidence 输出上次的置信度
+     * @return true 命中，可跳过 CNN
+     */
+    bool lookup(int* out_index, float* out_confidence) {
+        checks_++;
+        if (!valid_ || tolerance_ <= 0.0f || changed_ >= N || reused_ >= max_reuse_ ||
+            distance_ > tolerance_ * changed_) {
+            return false;
+        }
+        reused_++;
+        hits_++;
+        *out_index = index_;
+        *out_confidence = confidence_;
+        return true;
+    }
+
+    /**
+     * @brief 保存刚分类的窗口与结果
+     */
+    void store(const T* window, int index, float confidence) {
+        memcpy(snapshot_, window, sizeof(snapshot_));
+        distance_ = 0.0f;
+        changed_ = 0;
+        reused_ = 0;
+        index_ = index;
+        confidence_ = confidence;
+        valid_ = true;
+    }
+
+    uint32_t checks() const { return checks_; }
+    uint32_t hits() const { return hits_; }
+
+private:
+    T snapshot_[N];
+    float tolerance_;
+    uint16_t max_reuse_;
+    float distance_;
+    size_t changed_;
+    uint16_t reused_;
+    bool valid_;
+    int index_;
+    float confidence_;
+    uint32_t checks_;
+    uint32_t hits_;
+};
+
+#endif
@@ -0,0 +1,160 @@
+#ifndef WINDOW_NORMALIZER_H
+#define WINDOW_NORMALIZER_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief 逐窗口标准化（增量版）：按轴维护最近 Frames 帧的均值与二阶中心矩（滑动 Welford，
+ * 新帧加入、最旧帧移出各一次更新），每步只把新进入窗口的帧按 (x - mean) / std 标准化，
+ * 并与模型输入量化合成一次乘加：q = round(x * inv_scale / std + zero_point - mean * inv_scale / std)。
+ * 代价与步长成正比，而不是每步对整个窗口重新求 mean / stdev。
+ *
+ * 每帧按到达时的窗口统计量标准化，之后不再改写（流式推理缓存的时间列因此仍然有效）；
+ * 训练数据须按同样的因果方式标准化。每移入 Frames 帧按保存的原始帧精确重算一次统计量，
+ * 浮点累积误差不会随运行时间增长（摊到每帧仍是常数代价）。
+ * 窗口未满时统计量只覆盖已有的帧；标准差低于下限（静止）时按下限计，避免放大噪声。
+ * @tparam Axes 每帧的轴数
+ * @tparam Frames 窗口帧数
+ */
+template <size_t Axes, size_t Frames>
+class WindowNormalizer {
+public:
+    WindowNormalizer() : inv_scale_(1.0f), zero_point_(0) {
+        for (size_t a = 0; a < Axes; a++) {
+            min_std_[a] = 1e-3f;
+        }
+        reset();
+    }
+
+    /**
+     * @brief 设置输出量化参数与各轴标准差下限（样本单位）；保留已累积的统计量
+     * @param min_std 各轴标准差下限（nullptr = 不修改）
+     */
+    void configure(float inv_scale, int32_t zero_point, const float* min_std) {
+        inv_scale_ = inv_scale;
+        zero_point_ = zero_point;
+        if (min_std) {
+            for (size_t a = 0; a < Axes; a++) {
+                min_std_[a] = min_std[a] > 0.0f ? min_std[a] : 1e-3f;
+            }
+        }
+    }
+
+    void reset() {
+        count_ = 0;
+        head_ = 0;
+        since_refresh_ = 0;
+        for (size_t a = 0; a < Axes; a++) {
+            mean_[a] = 0.0f;
+            m2_[a] = 0.0f;
+        }
+    }
+
+    /**
+     * @brief 一步新帧进入窗口：更新统计量，并把这些帧标准化、量化为 int8
+     * @param frames 按帧交错存放的样本（frame_count * Axes 个）
+     * @param dst 输出（可与窗口中被挤出的位置相同）
+     */
+    template <typename T>
+    void quantize(const T* frames, size_t frame_count, int8_t* dst) {
+        for (size_t f = 0; f < frame_count; f++) {
+            push(&frames[f * Axes]);
+        }
+
+        float gain[Axes];
+        float offset[Axes];
+        for (size_t a = 0; a < Axes; a++) {
+            const float sd = stddev(a);
+            gain[a] = inv_scale_ / (sd > min_std_[a] ? sd : min_std_[a]);
+            offset[a] = (float)zero_point_ - mean_[a] * gain[a];
+        }
+        for (size_t f = 0; f < frame_count; f++) {
+            for (size_t a = 0; a < Axes; a++) {
+                const int32_t q = (int32_t)lroundf((float)frames[f * Axes + a] * gain[a] + offset[a]);
+                dst[f * Axes + a] = (int8_t)(q < -128 ? -128 : (q > 127 ? 127 : q));
+            }
+        }
+    }
+
+    float mean(size_t axis) const { return mean_[axis]; }
+
+    /**
+     * @brief 窗口内第 axis 轴的方差（总体方差，样本单位的平方）
+     */
+    float variance(size_t axis) const {
+        return count_ > 0 && m2_[axis] > 0.0f ? m2_[axis] / count_ : 0.0f;
+    }
+
+    float stddev(size_t axis) const { return sqrtf(variance(axis)); }
+
+    size_t frames() const { return count_; }
+
+private:
+    template <typename T>
+    void push(const T* frame) {
+        float* slot = history_[head_];
+        if (count_ < Frames) {
+            count_++;
+            for (size_t a = 0; a < Axes; a++) {
+                const float x = (float)frame[a];
+                const float d = x - mean_[a];
+                mean_[a] += d / count_;
+                m2_[a] += d * (x - mean_[a]);
+                slot[a] = x;
+            }
+        } else {
+            // 帧数不变：移出最旧帧与加入新帧合成一次更新
+            for (size_t a = 0; a < Axes; a++) {
+                const float x = (float)frame[a];
+                const float old = slot[a];
+                const float d = x - old;
+                const float new_mean = mean_[a] + d * kInvFrames;
+                m2_[a] += d * (x - new_mean + old - mean_[a]);
+                mean_[a] = new_mean;
+                slot[a] = x;
+            }
+        }
+        head_ = (head_ + 1) % Frames;
+
+        if (count_ == Frames && ++since_refresh_ >= Frames) {
+            refresh();
+        }
+    }
+
+    /**
+     * @brief 按保存的原始帧精确重算均值与二阶中心矩
+     */
+    void refresh() {
+        since_refresh_ = 0;
+        for (size_t a = 0; a < Axes; a++) {
+            float sum = 0.0f;
+            for (size_t f = 0; f < Frames; f++) {
+                sum += history_[f][a];
+            }
+            const float m = sum * kInvFrames;
+            float m2 = 0.0f;
+            for (size_t f = 0; f < Frames; f++) {
+                const float d = history_[f][a] - m;
+                m2 += d * d;
+            }
+            mean_[a] = m;
+            m2_[a] = m2;
+        }
+    }
+
+    static constexpr float kInvFrames = 1.0f / Frames;
+
+    float history_[Frames][Axes];
+    float mean_[Axes];
+    float m2_[Axes];
+    float min_std_[Axes];
+    float inv_scale_;
+    int32_t zero_point_;
+    size_t count_;
+    size_t head_;
+    size_t since_refresh_;
+};
+
+#endif
@@ -0,0 +1,172 @@
+#ifndef WIRE_SCHEMA_H
+#define WIRE_SCHEMA_H
+
+#include <new>
+#include <stddef.h>
+#include <stdint.h>
+
+// 线上数据格式（与 pc_controller/wire_schema.py 对应）：结果事件与空闲心跳、手势起始、最新结果、类别分数、区段追踪、统计量与诊断日志中的手势记录
+// 在 BLE 通知、USB 帧（usb_frame.h）与 Flash 诊断日志（telemetry_module.h）中使用同一组记录布局。
+// 每种记录是一个无填充的小端结构体，编码时用 wire_at 直接在发送缓冲区中构造并逐字段赋值，不经中间结构、不逐字节拼装；
+// 主机按同一布局直接取字段（struct.Struct.iter_unpack / memoryview），不需要解析。
+// 原始 IMU 与模型窗口的包格式见 record_format.h（变长差值编码，不属于本表）；采样诊断直接发送 sample_timing_stats_t。
+//
+// 布局只追加不修改：新字段加在记录末尾（主机按长度判断是否存在），改变已有字段时增加 WIRE_SCHEMA_VERSION。
+// 版本号在 USB hello 的回复与 BLE 布局特征值（19B10027）中报告。
+//
+// 版本 2：结果中的置信度是按 wire_confidence_format_t 量化的一个字节（设备不做浮点换算），
+// wire_gesture_t 的置信度由 uint16 x 65535 缩为这一字节。Flash 诊断日志中的记录仍为 x 255（离线读取时没有格式参数）。
+
+#define WIRE_SCHEMA_VERSION 2
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "the wire records are laid out for a little-endian target");
+
+#pragma pack(push, 1)
+
+/**
+ * @brief 一次结果的标识（Flash 诊断日志的手势记录）
+ */
+struct wire_result_t {
+    int8_t index;          // 类别（-1 = 无）
+    uint8_t confidence;    // 量化置信度（BLE / USB 按 wire_confidence_format_t；诊断日志中为 x 255）
+    uint16_t sequence;     // 结果序号的低 16 位
+};
+
+/**
+ * @brief 一个结果事件（事件 / 补发通知中的每条，BLE 事件历史中按此保存）
+ */
+struct wire_event_t {
+    wire_result_t result;
+    uint32_t timestamp_ms; // 发布时刻的 millis()
+};
+
+/**
+ * @brief 事件通知的头部，其后是若干 wire_event_t
+ */
+struct wire_event_burst_t {
+    uint8_t dropped;       // 自上一次通知以来丢弃的事件数（饱和于 255）
+    uint16_t delivery;     // 第一条事件在本连接上的投递序号
+};
+
+/**
+ * @brief 空闲心跳：事件通知中没有事件时发出的一条记录（与 wire_event_t 同长，占一个事件位置，总在最后）
+ * 首字节为 WIRE_EVENT_HEARTBEAT（不是有效类别，旧主机按未知类别忽略）；不占投递序号、不进补发历史，
+ * 所在通知头部的 delivery 是下一条事件的投递序号，主机据此在空闲时也能发现漏收的最后几条事件
+ */
+#define WIRE_EVENT_HEARTBEAT (-2)
+
+struct wire_heartbeat_t {
+    int8_t marker;         // WIRE_EVENT_HEARTBEAT
+    uint8_t power_point;   // 推理工作点（inference_power_point_t；0xFF = 未启用电量分级）
+    uint16_t battery_mv;   // 电池电压（0 = 未测量）
+    uint32_t uptime_ms;    // 发送时刻的 millis()
+};
+
+/**
+ * @brief 手势起始的临时判定及其确认 / 撤销（INFERENCE_ONSET_HEAD：BLE 起始特征值 19B10033 与 USB 帧）
+ * 每个临时判定先以 PROVISIONAL 发出，之后同一 onset 序号恰好再发一次 CONFIRMED 或 CANCELED。只发送最新状态：
+ * 两次发送之间的变化会被合并，主机收到新的临时判定时应把尚未了结的上一个当作撤销
+ */
+#define WIRE_ONSET_PROVISIONAL 0
+#define WIRE_ONSET_CONFIRMED 1
+#define WIRE_ONSET_CANCELED 2
+
+struct wire_onset_t {
+    int8_t index;          // 临时判定的类别
+    uint8_t state;         // WIRE_ONSET_*
+    uint16_t onset;        // 临时判定的序号（低 16 位）
+    uint8_t confidence;    // 前缀头的概率（量化格式同结果）
+    uint16_t sequence;     // 确认时已发布结果的序号（低 16 位；其余状态为 0）
+    uint32_t sample_ms;    // 临时判定时窗口最新样本的采样时钟
+};
+
+/**
+ * @brief 最新结果（手势特征值）
+ */
+struct wire_gesture_t {
+    uint8_t index;         // 类别（0xFF = 尚无结果）
+    uint8_t confidence;    // 量化置信度（wire_confidence_format_t）
+    uint16_t sequence;
+    uint32_t timestamp_ms;
+};
+
+/**
+ * @brief 结果置信度的量化参数：置信度 = (confidence - zero_point) x scale
+ * 每次启动只发布一次（BLE 布局特征值中版本号之后、USB hello 的应答末尾），主机据此反量化
+ */
+struct wire_confidence_format_t {
+    uint8_t zero_point;
+    float scale;
+};
+
+/**
+ * @brief 分数流通知的头部，其后是连续若干次推理的 label_count 个 int8 分数
+ */
+struct wire_scores_t {
+    uint16_t sequence;     // 第一次推理的序号（低 16 位）
+    uint8_t label_count;
+    int8_t zero_point;     // 输出张量的量化参数
+    float scale;
+};
+
+#define WIRE_TRACE_LOST 0x80
+
+/**
+ * @brief 区段追踪通知（与诊断命令 TRACE_READ 的应答）的头部，其后是若干 wire_trace_zone_t
+ */
+struct wire_trace_t {
+    uint32_t now_ms;       // 与 now_cycles 同时读取的 millis()
+    uint32_t now_cycles;
+    uint16_t clock_khz;
+    uint8_t count;         // 记录数；WIRE_TRACE_LOST = 之前有记录被覆盖
+};
+
+struct wire_trace_zone_t {
+    uint8_t zone;          // profiler_zone_t
+    uint32_t start_age;    // now_cycles 减区段开始（周期）
+    uint32_t cycles;
+};
+
+/**
+ * @brief 一个已登记的统计量（stats_module.h：统计特征值 19B10034 / USB 帧 0x34 与诊断命令 STAT_READ 的应答）
+ * 其后是 name_length 字节名称（UTF-8，无 NUL），再按 kind 为一个 uint32（计数、最大值）或 wire_stat_distribution_t
+ */
+struct wire_stat_t {
+    uint8_t index;         // 注册表序号
+    uint8_t count;         // 已登记的统计量数（主机据此知道一轮何时读完）
+    uint8_t kind;          // stat_kind_t
+    uint8_t name_length;
+};
+
+struct wire_stat_distribution_t {
+    uint32_t count;
+    uint32_t max;
+    uint32_t p50;
+    uint32_t p90;
+    uint32_t p99;
+};
+
+#pragma pack(pop)
+
+static_assert(sizeof(wire_result_t) == 4, "wire_result_t layout changed");
+static_assert(sizeof(wire_event_t) == 8, "wire_event_t layout changed");
+static_assert(sizeof(wire_event_burst_t) == 3, "wire_event_burst_t layout changed");
+static_assert(sizeof(wire_heartbeat_t) == sizeof(wire_event_t), "a heartbeat takes one event slot");
+static_assert(sizeof(wire_onset_t) == 11, "wire_onset_t layout changed");
+static_assert(sizeof(wire_gesture_t) == 8, "wire_gesture_t layout changed");
+static_assert(sizeof(wire_confidence_format_t) == 5, "wire_confidence_format_t layout changed");
+static_assert(sizeof(wire_scores_t) == 8, "wire_scores_t layout changed");
+static_assert(sizeof(wire_trace_t) == 11, "wire_trace_t layout changed");
+static_assert(sizeof(wire_trace_zone_t) == 9, "wire_trace_zone_t layout changed");
+static_assert(sizeof(wire_stat_t) == 4, "wire_stat_t layout changed");
+static_assert(sizeof(wire_stat_distribution_t) == 20, "wire_stat_distribution_t layout changed");
+
+/**
+ * @brief 在发送缓冲区的 buffer 处构造一条记录（字段未初始化，由调用者逐一赋值）
+ */
+template <typename T>
+inline T* wire_at(uint8_t* buffer) {
+    return ::new (static_cast<void*>(buffer)) T;
+}
+
+#endif
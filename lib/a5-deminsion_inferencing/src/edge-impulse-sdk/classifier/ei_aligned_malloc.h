@@ -36,6 +36,7 @@
 #define _EDGE_IMPULSE_ALIGNED_MALLOC_H_
 
 #include <assert.h>
+#include <stdbool.h>
 #include "../porting/ei_classifier_porting.h"
 
 #ifdef __cplusplus
@@ -119,6 +120,45 @@ __attribute__((unused)) void ei_aligned_free(void * ptr)
 	ei_free(p);
 }
 
+/**
+* Static placement for hot-path buffers that must not come from the heap
+* (windows, rings, input staging buffers, transport frames, the arena).
+* The alignment is part of the declaration; a section puts the buffer in a
+* particular RAM block, e.g. the one a DMA engine can reach:
+*
+*	EI_ALIGNED_STATIC(EI_SIMD_ALIGN) static int8_t window[72];
+*	EI_PLACED_STATIC(EI_DMA_ALIGN, ".dma_bss") static uint8_t staging[240];
+*
+* ei_is_aligned() and ei_in_region() let the application verify at startup
+* that the toolchain and linker script honoured the request.
+*/
+#define EI_SIMD_ALIGN 16	// CMSIS-NN / CMSIS-DSP vector loads
+#define EI_DMA_ALIGN 4		// word transfers (nRF52 EasyDMA, STM32 DMA)
+#ifndef EI_CACHE_LINE_BYTES
+#define EI_CACHE_LINE_BYTES 32	// Cortex-M7 D-cache line; rings and counters kept on separate lines
+#endif
+
+#define EI_ALIGNED_STATIC(align) __attribute__((aligned(align)))
+#define EI_PLACED_STATIC(align, section) __attribute__((aligned(align), section(section)))
+
+__attribute__((unused)) static inline bool ei_is_aligned(const void * ptr, size_t align)
+{
+	return ((uintptr_t)ptr & (align - 1)) == 0;
+}
+
+/**
+* True when [ptr, ptr + size) lies inside [start, end). An empty region
+* (start == end) means the target has no such restriction.
+*/
+__attribute__((unused)) static inline bool ei_in_region(const void * ptr, size_t size, uintptr_t start, uintptr_t end)
+{
+	if(start == end)
+	{
+		return true;
+	}
+	return (uintptr_t)ptr >= start && (uintptr_t)ptr + size <= end;
+}
+
 #ifdef __cplusplus
 }
 #endif // __cplusplus
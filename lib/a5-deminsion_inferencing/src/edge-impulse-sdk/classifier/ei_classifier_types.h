@@ -305,12 +305,21 @@ typedef struct {
      * EXPERIMENTAL
      */
     ei_feature_t* _raw_outputs;
+
+    /**
+     * Set when the caller owns _raw_outputs across inferences (continuous mode): the
+     * inferencing engine reuses the matrices in it, and run_postprocessing does not free them.
+     * INTERNAL
+     * EXPERIMENTAL
+     */
+    bool _raw_outputs_persistent;
 #else
     /** padding for C bindings to make sure the struct is the same size
      * INTERNAL
      * EXPERIMENTAL
      */
     void* _padding;
+    unsigned char _padding_persistent;
 #endif
 #if EI_CLASSIFIER_HAS_VISUAL_ANOMALY || __DOXYGEN__
     /**
@@ -299,6 +299,12 @@ typedef struct {
     TfLiteStatus (*model_reset)(void (*free)(void* ptr));
     TfLiteStatus (*model_input)(int, TfLiteTensor*);
     TfLiteStatus (*model_output)(int, TfLiteTensor*);
+    // Optional (nullptr for graphs that are set up and torn down around every inference):
+    // whether the graph is initialized, and zeroing its variables (stateful models)
+    // without re-initializing it. With both set, continuous classification keeps
+    // the graph initialized from one inference to the next.
+    bool (*model_initialized)();
+    TfLiteStatus (*model_reset_state)();
 } ei_config_tflite_eon_graph_t;
 
 typedef struct {
@@ -349,6 +355,45 @@ typedef struct {
     void* graph_config;
 } ei_learning_block_config_anomaly_gmm_t;
 
+/** One causal, dilated 1D convolution of a temporal convolution network (inferencing_engines/tcn.h) */
+typedef struct {
+    uint16_t in_channels;
+    uint16_t out_channels;
+    uint8_t kernel_size;
+    uint16_t dilation;
+    /* int8 weights [out_channels][kernel_size][in_channels], tap 0 is the oldest input */
+    const int8_t *weights;
+    const int32_t *bias;
+    /* requantization as in the TFLite int8 kernels (per-tensor) */
+    int32_t multiplier;
+    int32_t shift;
+    int32_t input_offset;
+    int32_t output_offset;
+    int32_t act_min;
+    /* state: ring of the last (kernel_size - 1) * dilation + 1 input frames, in_channels each */
+    int8_t *history;
+    uint16_t *history_head;
+} ei_tcn_layer_t;
+
+typedef struct {
+    uint16_t implementation_version;
+    uint32_t block_id;
+    /* input frame (one sample of every axis) and its int8 quantization */
+    uint16_t input_channels;
+    float input_scale;
+    int32_t input_zero_point;
+    const ei_tcn_layer_t *layers;
+    uint8_t layers_size;
+    /* classification head on the newest output frame: logit = (bias + sum((x + offset) * w)) * scale */
+    const int8_t *head_weights;
+    const int32_t *head_bias;
+    int32_t head_input_offset;
+    float head_logit_scale;
+    uint16_t classes;
+    /* scratch for two frames of the widest layer */
+    int8_t *scratch;
+} ei_learning_block_config_tcn_t;
+
 typedef struct {
     float confidence_threshold;
     float iou_threshold;
@@ -37,6 +37,19 @@
 
 #include <algorithm>
 #include <cmath>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#include "edge-impulse-sdk/CMSIS/Core/Include/cmsis_compiler.h"
+#define EI_QUANTIZE_SSAT 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define EI_QUANTIZE_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define EI_QUANTIZE_SSE2 1
+#endif
 
 static int32_t pre_cast_quantize(float value, float scale, int32_t zero_point, bool is_signed) {
 
@@ -46,4 +59,143 @@ static int32_t pre_cast_quantize(float value, float scale, int32_t zero_point, b
     return std::min( std::max( static_cast<int32_t>(round(value / scale)) + zero_point, min_value), max_value);
 }
 
+/**
+ * Quantizer for a model input, built by the caller from the tensor's scale and
+ * zero point (it is small and holds no other state, so build it where it is used).
+ *
+ * pre_cast_quantize() divides by the scale and calls round() for every value; this
+ * multiplies by the reciprocal instead (one VMUL against a 14-cycle VDIV on a
+ * Cortex-M4F) and rounds half away from zero from the truncated value and its
+ * fraction. The product and the quotient differ by a few ulp at most, so they can
+ * only round differently when the fraction is that close to .5; those values are
+ * divided and rounded exactly as pre_cast_quantize() does. The results are
+ * therefore identical to pre_cast_quantize() for every input. The scaled value is
+ * clamped to the int16 range first, so the conversion is always defined.
+ * Saturation to int8 / uint8 uses SSAT / USAT on cores with the DSP extension, and
+ * the quantize_* loops run four values at a time with SSE2 or NEON on hosts.
+ */
+class ei_input_quantizer {
+public:
+    ei_input_quantizer(float scale, int32_t zero_point)
+        : scale_(scale), inv_scale_(scale != 0.0f ? 1.0f / scale : 1.0f), zero_point_(zero_point) { }
+
+    int32_t quantize_i8(float value) const {
+#if EI_QUANTIZE_SSAT
+        return __SSAT(scaled(value) + zero_point_, 8);
+#else
+        return std::min(std::max(scaled(value) + zero_point_, (int32_t)-128), (int32_t)127);
+#endif
+    }
+
+    int32_t quantize_u8(float value) const {
+#if EI_QUANTIZE_SSAT
+        return (int32_t)__USAT(scaled(value) + zero_point_, 8);
+#else
+        return std::min(std::max(scaled(value) + zero_point_, (int32_t)0), (int32_t)255);
+#endif
+    }
+
+    void quantize_i8(const float *in, int8_t *out, size_t n) const {
+        size_t i = 0;
+#if EI_QUANTIZE_SSE2 || EI_QUANTIZE_NEON
+        for (; i + 4 <= n; i += 4) {
+            int16_t q[4];
+            if (!quantize4(in + i, q)) {
+                for (size_t k = 0; k < 4; k++) {
+                    out[i + k] = (int8_t)quantize_i8(in[i + k]);
+                }
+                continue;
+            }
+            for (size_t k = 0; k < 4; k++) {
+                out[i + k] = (int8_t)std::min(std::max(q[k], (int16_t)-128), (int16_t)127);
+            }
+        }
+#endif
+        for (; i < n; i++) {
+            out[i] = (int8_t)quantize_i8(in[i]);
+        }
+    }
+
+    void quantize_u8(const float *in, uint8_t *out, size_t n) const {
+        size_t i = 0;
+#if EI_QUANTIZE_SSE2 || EI_QUANTIZE_NEON
+        for (; i + 4 <= n; i += 4) {
+            int16_t q[4];
+            if (!quantize4(in + i, q)) {
+                for (size_t k = 0; k < 4; k++) {
+                    out[i + k] = (uint8_t)quantize_u8(in[i + k]);
+                }
+                continue;
+            }
+            for (size_t k = 0; k < 4; k++) {
+                out[i + k] = (uint8_t)std::min(std::max(q[k], (int16_t)0), (int16_t)255);
+            }
+        }
+#endif
+        for (; i < n; i++) {
+            out[i] = (uint8_t)quantize_u8(in[i]);
+        }
+    }
+
+private:
+    static constexpr float kLimit = 32767.0f;
+    // a fraction within |x| * 2^-20 of .5 may round differently in the quotient: the
+    // reciprocal, the product and the quotient each add at most half an ulp (2^-24 |x|)
+    static constexpr float kTieTolerance = 1.0f / 1048576.0f;
+
+    int32_t scaled(float value) const {
+        float x = value * inv_scale_;
+        x = x < -kLimit ? -kLimit : (x > kLimit ? kLimit : x);
+        const int32_t truncated = static_cast<int32_t>(x);
+        const float away = std::fabs(x - static_cast<float>(truncated));
+        if (std::fabs(away - 0.5f) <= std::fabs(x) * kTieTolerance && scale_ != 0.0f) {
+            return static_cast<int32_t>(round(value / scale_));
+        }
+        return away >= 0.5f ? truncated + (x < 0.0f ? -1 : 1) : truncated;
+    }
+
+#if EI_QUANTIZE_SSE2
+    // round(x * inv_scale) + zero_point for four values, saturated to int16; false when
+    // one of them is near a .5 boundary and the caller has to use scaled() instead
+    bool quantize4(const float *in, int16_t *out) const {
+        const __m128 limit = _mm_set1_ps(kLimit);
+        const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        __m128 x = _mm_mul_ps(_mm_loadu_ps(in), _mm_set1_ps(inv_scale_));
+        x = _mm_min_ps(_mm_max_ps(x, _mm_sub_ps(_mm_setzero_ps(), limit)), limit);
+        const __m128i truncated = _mm_cvttps_epi32(x);
+        const __m128 away = _mm_and_ps(_mm_sub_ps(x, _mm_cvtepi32_ps(truncated)), abs_mask);
+        const __m128 tie_distance = _mm_and_ps(_mm_sub_ps(away, _mm_set1_ps(0.5f)), abs_mask);
+        const __m128 tolerance = _mm_mul_ps(_mm_and_ps(x, abs_mask), _mm_set1_ps(kTieTolerance));
+        if (_mm_movemask_ps(_mm_cmple_ps(tie_distance, tolerance)) != 0) {
+            return false;
+        }
+        // +1 or -1 (the sign of x) where the fraction is .5 or more, 0 elsewhere
+        const __m128i step = _mm_or_si128(_mm_srai_epi32(_mm_castps_si128(x), 31), _mm_set1_epi32(1));
+        const __m128i round_away = _mm_castps_si128(_mm_cmpge_ps(away, _mm_set1_ps(0.5f)));
+        __m128i q = _mm_add_epi32(truncated, _mm_and_si128(round_away, step));
+        q = _mm_add_epi32(q, _mm_set1_epi32(zero_point_));
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(out), _mm_packs_epi32(q, q));
+        return true;
+    }
+#elif EI_QUANTIZE_NEON
+    bool quantize4(const float *in, int16_t *out) const {
+        float32x4_t x = vmulq_n_f32(vld1q_f32(in), inv_scale_);
+        x = vminq_f32(vmaxq_f32(x, vdupq_n_f32(-kLimit)), vdupq_n_f32(kLimit));
+        const float32x4_t away = vabsq_f32(vsubq_f32(x, vcvtq_f32_s32(vcvtq_s32_f32(x))));
+        const float32x4_t tie_distance = vabdq_f32(away, vdupq_n_f32(0.5f));
+        if (vmaxvq_u32(vcleq_f32(tie_distance, vmulq_n_f32(vabsq_f32(x), kTieTolerance))) != 0) {
+            return false;
+        }
+        // vcvtaq rounds to nearest with ties away from zero, like round()
+        const int32x4_t q = vaddq_s32(vcvtaq_s32_f32(x), vdupq_n_s32(zero_point_));
+        vst1_s16(out, vqmovn_s32(q));
+        return true;
+    }
+#endif
+
+    float scale_;
+    float inv_scale_;
+    int32_t zero_point_;
+};
+
 #endif  //!__EI_QUANTIZE__H__
\ No newline at end of file
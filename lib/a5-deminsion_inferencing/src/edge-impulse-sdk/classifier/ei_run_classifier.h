@@ -112,6 +112,41 @@ EI_IMPULSE_ERROR ei_unscale_fmatrix(ei_learning_block_t *block, ei::matrix_t *fm
 
 static uint64_t classifier_continuous_features_written = 0;
 
+/* Statically sized state for process_impulse_continuous(), so that a continuous inference
+   does not allocate on the heap once the first full window has been processed */
+#ifndef EI_CLASSIFIER_CONTINUOUS_MAX_BLOCKS
+#define EI_CLASSIFIER_CONTINUOUS_MAX_BLOCKS 4
+#endif
+static ei_feature_t continuous_raw_outputs[EI_CLASSIFIER_CONTINUOUS_MAX_BLOCKS];
+static ei_feature_t continuous_features[EI_CLASSIFIER_CONTINUOUS_MAX_BLOCKS];
+
+/* Capacity of run_classifier_shared(): impulses run on one window, distinct DSP blocks
+   computed per call, and floats of DSP output kept for them (all statically allocated) */
+#ifndef EI_CLASSIFIER_SHARED_MAX_IMPULSES
+#define EI_CLASSIFIER_SHARED_MAX_IMPULSES 4
+#endif
+#ifndef EI_CLASSIFIER_SHARED_MAX_DSP_BLOCKS
+#define EI_CLASSIFIER_SHARED_MAX_DSP_BLOCKS 4
+#endif
+#ifndef EI_CLASSIFIER_SHARED_MAX_FEATURES
+#define EI_CLASSIFIER_SHARED_MAX_FEATURES (2 * EI_CLASSIFIER_NN_INPUT_FRAME_SIZE)
+#endif
+
+/* An impulse with a single raw DSP block and scale-axes 1.0 (EI_CLASSIFIER_DSP_RAW_IDENTITY in
+   the model metadata) feeds the raw window unchanged into the model. For a quantized EON model
+   the continuous path then keeps the window quantized instead of in a float features matrix,
+   and run_classifier_quantized() accepts an already quantized window. */
+#ifndef EI_CLASSIFIER_DSP_RAW_IDENTITY
+#define EI_CLASSIFIER_DSP_RAW_IDENTITY 0
+#endif
+#if EI_CLASSIFIER_DSP_RAW_IDENTITY == 1 && (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE) && \
+    (EI_CLASSIFIER_COMPILED == 1) && (EI_CLASSIFIER_QUANTIZATION_ENABLED == 1) && \
+    (EI_IMPULSE_RESULT_CLASSIFICATION_IS_STATICALLY_ALLOCATED == 1)
+#define EI_CLASSIFIER_RAW_QUANTIZED_INPUT 1
+#else
+#define EI_CLASSIFIER_RAW_QUANTIZED_INPUT 0
+#endif
+
 /* Private functions ------------------------------------------------------- */
 
 /* These functions (up to Public functions section) are not exposed to end-user,
@@ -405,6 +440,152 @@ extern "C" EI_IMPULSE_ERROR init_impulse(ei_impulse_handle_t *handle) {
     return EI_IMPULSE_OK;
 }
 
+#if EI_CLASSIFIER_RAW_QUANTIZED_INPUT == 1
+/**
+ * @brief      Check that the impulse really is a single identity raw block feeding a
+ *             single EON learning block (the metadata flag is a compile-time promise, the
+ *             block configs are checked here)
+ */
+static bool can_run_classifier_raw_quantized(const ei_impulse_t *impulse)
+{
+    if (impulse->dsp_blocks_size != 1 || impulse->learning_blocks_size != 1 ||
+        impulse->nn_input_frame_size != EI_CLASSIFIER_NN_INPUT_FRAME_SIZE) {
+        return false;
+    }
+
+    const ei_model_dsp_t &block = impulse->dsp_blocks[0];
+    if (block.extract_fn != extract_raw_features ||
+        block.axes_size != impulse->raw_samples_per_frame ||
+        block.n_output_features != impulse->nn_input_frame_size ||
+        ((ei_dsp_config_raw_t*)block.config)->scale_axes != 1.0f) {
+        return false;
+    }
+
+    return impulse->learning_blocks[0].infer_fn == &run_nn_inference;
+}
+
+/**
+ * @brief      Continuous inference for an identity raw impulse. The window is kept in the
+ *             model's int8 input layout; each new slice is copied and quantized in a single
+ *             pass, and the window is copied into the input tensor. There is no float
+ *             features matrix, and the quantization matches fill_input_tensor_from_matrix().
+ *
+ * @param      handle   struct with information about model and DSP
+ * @param      signal   New slice of raw data
+ * @param      result   Output classifier results
+ * @param[in]  debug    Debug output enable
+ *
+ * @return     The ei impulse error.
+ */
+static EI_IMPULSE_ERROR process_impulse_continuous_raw_quantized(ei_impulse_handle_t *handle,
+                                                                 signal_t *signal,
+                                                                 ei_impulse_result_t *result,
+                                                                 bool debug)
+{
+    auto impulse = handle->impulse;
+    ei_learning_block_t learn_block = impulse->learning_blocks[0];
+
+    static int8_t quantized_window[EI_CLASSIFIER_NN_INPUT_FRAME_SIZE];
+    float input_scale;
+    int32_t input_zero_point;
+    EI_IMPULSE_ERROR quantization_res = get_nn_input_quantization(learn_block.config, &input_scale, &input_zero_point);
+    if (quantization_res != EI_IMPULSE_OK) {
+        return quantization_res;
+    }
+    const ei_input_quantizer quantizer(input_scale, input_zero_point);
+
+    uint64_t dsp_start_us = ei_read_timer_us();
+
+    const size_t window_size = EI_CLASSIFIER_NN_INPUT_FRAME_SIZE;
+    size_t new_values = signal->total_length;
+    size_t offset = 0;
+    if (new_values > window_size) {
+        // only the newest values still fit in the window
+        offset = new_values - window_size;
+        new_values = window_size;
+    }
+
+    memmove(quantized_window, quantized_window + new_values, window_size - new_values);
+
+    int8_t *dst = quantized_window + window_size - new_values;
+    float chunk[32];
+    for (size_t done = 0; done < new_values; ) {
+        size_t n = std::min(new_values - done, sizeof(chunk) / sizeof(chunk[0]));
+        if (signal->get_data(offset + done, n, chunk) != 0) {
+            ei_printf("ERR: Failed to read slice\n");
+            return EI_IMPULSE_DSP_ERROR;
+        }
+        quantizer.quantize_i8(chunk, dst + done, n);
+        done += n;
+    }
+
+    classifier_continuous_features_written += new_values;
+
+    result->timing.dsp_us = ei_read_timer_us() - dsp_start_us;
+    result->timing.dsp = (int)(result->timing.dsp_us / 1000);
+
+    if (classifier_continuous_features_written < window_size) {
+        return EI_IMPULSE_OK;
+    }
+
+    if (debug) {
+        ei_printf("Running impulse...\n");
+    }
+
+    EI_IMPULSE_ERROR res = run_nn_inference_i8(impulse, quantized_window, window_size, 0, 0,
+                                               result, learn_block.config, debug);
+    if (res != EI_IMPULSE_OK) {
+        return res;
+    }
+    return run_postprocessing(handle, result);
+}
+/**
+ * @brief      Run an identity raw impulse over an already quantized window, written
+ *             straight into the input tensor
+ *
+ * @param      handle         struct with information about model and DSP
+ * @param      features       Quantized window (int8 input tensor layout), may be a ring
+ * @param      features_size  Number of values in features
+ * @param      oldest         Index of the oldest value in features (0 if not a ring)
+ * @param      result         Output classifier results
+ * @param[in]  debug          Debug output enable
+ *
+ * @return     The ei impulse error.
+ */
+static EI_IMPULSE_ERROR process_impulse_quantized(ei_impulse_handle_t *handle,
+                                                  const int8_t *features,
+                                                  size_t features_size,
+                                                  size_t oldest,
+                                                  ei_impulse_result_t *result,
+                                                  bool debug)
+{
+    if ((handle == nullptr) || (handle->impulse == nullptr) || (result == nullptr) || (features == nullptr)) {
+        return EI_IMPULSE_INFERENCE_ERROR;
+    }
+
+    auto impulse = handle->impulse;
+    if (!can_run_classifier_raw_quantized(impulse)) {
+        return EI_IMPULSE_UNSUPPORTED_INFERENCING_ENGINE;
+    }
+
+    memset(result, 0, sizeof(ei_impulse_result_t));
+    for (int i = 0; i < impulse->label_count; i++) {
+        result->classification[i].label = impulse->categories[(uint32_t)i];
+    }
+
+    // shares the persistent raw outputs with the continuous path (same impulse, same sizes)
+    result->_raw_outputs = continuous_raw_outputs;
+    result->_raw_outputs_persistent = true;
+
+    EI_IMPULSE_ERROR res = run_nn_inference_i8(impulse, features, features_size, oldest, 0,
+                                               result, impulse->learning_blocks[0].config, debug);
+    if (res != EI_IMPULSE_OK) {
+        return res;
+    }
+    return run_postprocessing(handle, result);
+}
+#endif // EI_CLASSIFIER_RAW_QUANTIZED_INPUT == 1
+
 /**
  * @brief      Process a complete impulse for continuous inference
  *
@@ -424,6 +605,15 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(ei_impulse_handle_t *hand
         return EI_IMPULSE_INFERENCE_ERROR;
     }
 
+    auto impulse = handle->impulse;
+    uint32_t block_num = impulse->dsp_blocks_size + impulse->learning_blocks_size;
+    if (block_num > EI_CLASSIFIER_CONTINUOUS_MAX_BLOCKS ||
+        impulse->output_tensors_size > EI_CLASSIFIER_CONTINUOUS_MAX_BLOCKS) {
+        ei_printf("ERR: Impulse has more blocks than EI_CLASSIFIER_CONTINUOUS_MAX_BLOCKS (%d)\n",
+            EI_CLASSIFIER_CONTINUOUS_MAX_BLOCKS);
+        return EI_IMPULSE_ALLOC_FAILED;
+    }
+
     memset(result, 0, sizeof(ei_impulse_result_t));
 
 #if EI_IMPULSE_RESULT_CLASSIFICATION_IS_STATICALLY_ALLOCATED == 0
@@ -462,12 +652,17 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(ei_impulse_handle_t *hand
 
 #endif // EI_IMPULSE_RESULT_CLASSIFICATION_IS_STATICALLY_ALLOCATED == 0
 
-    // smart pointer to results array
-    std::unique_ptr<ei_feature_t[]> raw_results_ptr(new ei_feature_t[handle->impulse->learning_blocks_size]);
-    result->_raw_outputs = raw_results_ptr.get();
-    memset(result->_raw_outputs, 0, sizeof(ei_feature_t) * handle->impulse->learning_blocks_size);
+    // raw outputs are kept across calls, the inferencing engine reuses their matrices
+    // instead of allocating new ones (and run_postprocessing does not free them)
+    result->_raw_outputs = continuous_raw_outputs;
+    result->_raw_outputs_persistent = true;
+
+#if EI_CLASSIFIER_RAW_QUANTIZED_INPUT == 1
+    if (can_run_classifier_raw_quantized(impulse)) {
+        return process_impulse_continuous_raw_quantized(handle, signal, result, debug);
+    }
+#endif
 
-    auto impulse = handle->impulse;
     static ei::matrix_t static_features_matrix(1, impulse->nn_input_frame_size);
     if (!static_features_matrix.buffer) {
         return EI_IMPULSE_ALLOC_FAILED;
@@ -492,7 +687,7 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(ei_impulse_handle_t *hand
 
         int (*extract_fn_slice)(ei::signal_t *signal, ei::matrix_t *output_matrix, void *config, const float frequency, matrix_size_t *out_matrix_size);
 
-        /* Switch to the slice version of the mfcc feature extract function */
+        /* Switch to the slice version of the feature extract function */
         if (block.extract_fn == extract_mfcc_features) {
             extract_fn_slice = &extract_mfcc_per_slice_features;
         }
@@ -502,8 +697,14 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(ei_impulse_handle_t *hand
         else if (block.extract_fn == extract_mfe_features) {
             extract_fn_slice = &extract_mfe_per_slice_features;
         }
+        else if (block.extract_fn == extract_raw_features) {
+            extract_fn_slice = &extract_raw_per_slice_features;
+        }
+        else if (block.extract_fn == extract_spectral_analysis_features) {
+            extract_fn_slice = &extract_spectral_analysis_per_slice_features;
+        }
         else {
-            ei_printf("ERR: Unknown extract function, only MFCC, MFE and spectrogram supported\n");
+            ei_printf("ERR: Unknown extract function, only MFCC, MFE, spectrogram, spectral analysis and raw supported\n");
             return EI_IMPULSE_DSP_ERROR;
         }
 
@@ -540,47 +741,46 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(ei_impulse_handle_t *hand
     if (classifier_continuous_features_written >= impulse->nn_input_frame_size) {
         dsp_start_us = ei_read_timer_us();
 
-        uint32_t block_num = impulse->dsp_blocks_size + impulse->learning_blocks_size;
-
-        // smart pointer to features array
-        std::unique_ptr<ei_feature_t[]> features_ptr(new ei_feature_t[block_num]);
-        ei_feature_t* features = features_ptr.get();
-        if (features == nullptr) {
-            ei_printf("ERR: Out of memory, can't allocate features\n");
+        // normalization works on a copy so the rolling window stays untouched; the copy and
+        // the per-block views into it are created once, on the first full window
+        static ei::matrix_t normalized_features_matrix(1, impulse->nn_input_frame_size);
+        static ei::matrix_t *feature_views[EI_CLASSIFIER_CONTINUOUS_MAX_BLOCKS] = { nullptr };
+        if (!normalized_features_matrix.buffer) {
+            ei_printf("ERR: Out of memory, can't allocate normalized features\n");
             return EI_IMPULSE_ALLOC_FAILED;
         }
-        memset(features, 0, sizeof(ei_feature_t) * block_num);
 
-        // have it outside of the loop to avoid going out of scope
-        std::unique_ptr<ei::matrix_t> *matrix_ptrs = new std::unique_ptr<ei::matrix_t>[block_num];
-        if (matrix_ptrs == nullptr) {
-            ei_printf("ERR: Out of memory, can't allocate matrix_ptrs\n");
-            return EI_IMPULSE_ALLOC_FAILED;
-        }
+        ei_feature_t *features = continuous_features;
+        memset(features, 0, sizeof(ei_feature_t) * block_num);
 
         out_features_index = 0;
         // iterate over every dsp block and run normalization
         for (size_t ix = 0; ix < impulse->dsp_blocks_size; ix++) {
             ei_model_dsp_t block = impulse->dsp_blocks[ix];
-            matrix_ptrs[ix] = std::unique_ptr<ei::matrix_t>(new ei::matrix_t(1, block.n_output_features));
-
-            if (matrix_ptrs[ix] == nullptr) {
-                ei_printf("ERR: Out of memory, can't allocate matrix_ptrs[%lu]\n", (unsigned long)ix);
-                return EI_IMPULSE_ALLOC_FAILED;
-            }
 
-            if (matrix_ptrs[ix]->buffer == nullptr) {
-                ei_printf("ERR: Out of memory, can't allocate matrix_ptrs[%lu]\n", (unsigned long)ix);
-                delete[] matrix_ptrs;
-                return EI_IMPULSE_ALLOC_FAILED;
+            bool normalize = block.extract_fn == extract_mfcc_features ||
+                             block.extract_fn == extract_spectrogram_features ||
+                             block.extract_fn == extract_mfe_features;
+
+            if (feature_views[ix] == nullptr) {
+                // raw features need no normalization, so their view points into the window itself
+                float *view_buffer = normalize ?
+                    normalized_features_matrix.buffer + out_features_index :
+                    static_features_matrix.buffer + out_features_index;
+                feature_views[ix] = new ei::matrix_t(1, block.n_output_features, view_buffer);
+                if (feature_views[ix] == nullptr) {
+                    ei_printf("ERR: Out of memory, can't allocate matrix_ptrs[%lu]\n", (unsigned long)ix);
+                    return EI_IMPULSE_ALLOC_FAILED;
+                }
             }
 
-            features[ix].matrix = matrix_ptrs[ix].get();
+            features[ix].matrix = feature_views[ix];
             features[ix].blockId = block.blockId;
 
-            /* Create a copy of the matrix for normalization */
-            for (size_t m_ix = 0; m_ix < block.n_output_features; m_ix++) {
-                features[ix].matrix->buffer[m_ix] = static_features_matrix.buffer[out_features_index + m_ix];
+            if (normalize) {
+                /* Create a copy of the matrix for normalization */
+                memcpy(features[ix].matrix->buffer, static_features_matrix.buffer + out_features_index,
+                    block.n_output_features * sizeof(float));
             }
 
             if (block.extract_fn == extract_mfcc_features) {
@@ -612,7 +812,6 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(ei_impulse_handle_t *hand
         if (ei_impulse_error != EI_IMPULSE_OK) {
             return ei_impulse_error;
         }
-        delete[] matrix_ptrs;
         ei_impulse_error = run_postprocessing(handle, result);
         if (ei_impulse_error != EI_IMPULSE_OK) {
             return ei_impulse_error;
@@ -622,6 +821,36 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(ei_impulse_handle_t *hand
     return ei_impulse_error;
 }
 
+/**
+ * @brief      Whether two DSP blocks, possibly of different impulses, compute the same
+ *             features from the same window. Configs are compared by content only for
+ *             raw blocks, whose config layout is known; other blocks must share the config.
+ *
+ * @return     true if the output of one can be handed to the learning blocks of the other
+ */
+static bool dsp_blocks_equal(const ei_impulse_t *a_impulse, const ei_model_dsp_t &a,
+                             const ei_impulse_t *b_impulse, const ei_model_dsp_t &b)
+{
+    if (a.extract_fn != b.extract_fn || a.n_output_features != b.n_output_features ||
+        a.axes_size != b.axes_size || a_impulse->frequency != b_impulse->frequency) {
+        return false;
+    }
+    for (uint32_t ix = 0; ix < a.axes_size; ix++) {
+        if (a.axes[ix] != b.axes[ix]) {
+            return false;
+        }
+    }
+    if (a.config == b.config) {
+        return true;
+    }
+    if (a.extract_fn == extract_raw_features) {
+        const ei_dsp_config_raw_t *a_config = (const ei_dsp_config_raw_t *)a.config;
+        const ei_dsp_config_raw_t *b_config = (const ei_dsp_config_raw_t *)b.config;
+        return a_config->axes == b_config->axes && a_config->scale_axes == b_config->scale_axes;
+    }
+    return false;
+}
+
 /**
  * Check if the current impulse could be used by 'run_classifier_image_quantized'
  */
@@ -839,6 +1068,10 @@ extern "C" void run_classifier_init(void)
 #if EI_CLASSIFIER_HAS_DATA_NORMALIZATION
     init_data_normalization(&ei_default_impulse);
 #endif
+#if (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE) && (EI_CLASSIFIER_COMPILED == 1)
+    // graphs kept initialized by earlier continuous inferences start from zero state
+    reset_nn_state(ei_default_impulse.impulse);
+#endif
 }
 
 /**
@@ -864,6 +1097,10 @@ __attribute__((unused)) void run_classifier_init(ei_impulse_handle_t *handle)
 #if EI_CLASSIFIER_HAS_DATA_NORMALIZATION
     init_data_normalization(handle);
 #endif
+#if (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE) && (EI_CLASSIFIER_COMPILED == 1)
+    // graphs kept initialized by earlier continuous inferences start from zero state
+    reset_nn_state(handle->impulse);
+#endif
 }
 
 /**
@@ -880,6 +1117,9 @@ __attribute__((unused)) void run_classifier_init(ei_impulse_handle_t *handle)
 extern "C" void run_classifier_deinit(void)
 {
     deinit_postprocessing(&ei_default_impulse);
+#if (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE) && (EI_CLASSIFIER_COMPILED == 1)
+    release_nn_graphs(ei_default_impulse.impulse);
+#endif
 }
 
 __attribute__((unused)) void run_classifier_deinit(ei_impulse_handle_t *handle)
@@ -888,6 +1128,9 @@ __attribute__((unused)) void run_classifier_deinit(ei_impulse_handle_t *handle)
 #if EI_CLASSIFIER_HAS_DATA_NORMALIZATION
     deinit_data_normalization(handle);
 #endif
+#if (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE) && (EI_CLASSIFIER_COMPILED == 1)
+    release_nn_graphs(handle->impulse);
+#endif
 }
 
 /**
@@ -1009,6 +1252,259 @@ __attribute__((unused)) EI_IMPULSE_ERROR run_classifier_continuous(
     return process_impulse_continuous(impulse, signal, result, debug);
 }
 
+/**
+ * @brief Run several impulses on the same window, computing each distinct DSP block once.
+ *
+ * Impulses exported for the same sensor often start with the same DSP block (e.g. a raw block
+ * over the same axes). Within one impulse the `inputs` of a learning block already let several
+ * learning blocks read one DSP output; this function does the same across impulses. It reads
+ * the window once for every DSP block that is distinct over all impulses (same extract
+ * function, axes, output size and config), keeps the output in a static buffer, and hands
+ * read-only views of it to the learning blocks of every impulse that uses it. Each impulse
+ * then runs its learning and post-processing blocks into its own result.
+ *
+ * The whole window is processed on every call, like `run_classifier()`; features are not
+ * rolled like in `run_classifier_continuous()`. Stateful DSP blocks, data normalization and
+ * image scaling would change a shared view and are not supported.
+ *
+ * `timing.dsp_us` of a result only counts the DSP blocks first computed for that impulse.
+ * Raw outputs are kept per position in `handles`, so pass the impulses in the same order
+ * on every call. The function does not allocate once the first call has returned.
+ *
+ * **Blocking**: yes
+ *
+ * @param[in] handles Impulses to run, at most `EI_CLASSIFIER_SHARED_MAX_IMPULSES`. All of them
+ *  must have the same window length and number of axes.
+ * @param[in] handle_count Number of impulses
+ * @param[in] signal Pointer to a signal_t struct that reads one full window of raw features
+ *  (`dsp_input_frame_size` values)
+ * @param[out] results One `ei_impulse_result_t` per impulse
+ * @param[in] debug Print internal preprocessing and inference debugging information via
+ *  `ei_printf()`.
+ *
+ * @return Error code as defined by `EI_IMPULSE_ERROR` enum. Will be `EI_IMPULSE_OK` if every
+ *  impulse completed successfully.
+ */
+extern "C" EI_IMPULSE_ERROR run_classifier_shared(
+    ei_impulse_handle_t **handles,
+    size_t handle_count,
+    signal_t *signal,
+    ei_impulse_result_t *results,
+    bool debug = false)
+{
+#if EI_CLASSIFIER_LOAD_IMAGE_SCALING
+    ei_printf("ERR: run_classifier_shared does not support image scaling\n");
+    return EI_IMPULSE_INFERENCE_ERROR;
+#else
+    if ((handles == nullptr) || (signal == nullptr) || (results == nullptr) ||
+        (handle_count == 0) || (handle_count > EI_CLASSIFIER_SHARED_MAX_IMPULSES)) {
+        return EI_IMPULSE_INFERENCE_ERROR;
+    }
+
+    // DSP outputs of this call: the views are created on the first call and re-pointed after
+    static float shared_features[EI_CLASSIFIER_SHARED_MAX_FEATURES];
+    static ei::matrix_t *shared_views[EI_CLASSIFIER_SHARED_MAX_DSP_BLOCKS] = { nullptr };
+    static ei_feature_t shared_raw_outputs[EI_CLASSIFIER_SHARED_MAX_IMPULSES][EI_CLASSIFIER_CONTINUOUS_MAX_BLOCKS];
+#if EI_IMPULSE_RESULT_CLASSIFICATION_IS_STATICALLY_ALLOCATED == 0
+    static std::vector<ei_impulse_result_classification_t> classification_results[EI_CLASSIFIER_SHARED_MAX_IMPULSES];
+#endif
+    const ei_impulse_t *shared_impulses[EI_CLASSIFIER_SHARED_MAX_DSP_BLOCKS];
+    const ei_model_dsp_t *shared_blocks[EI_CLASSIFIER_SHARED_MAX_DSP_BLOCKS];
+    size_t shared_count = 0;
+    size_t shared_features_used = 0;
+
+    for (size_t h = 0; h < handle_count; h++) {
+        ei_impulse_handle_t *handle = handles[h];
+        if ((handle == nullptr) || (handle->impulse == nullptr)) {
+            return EI_IMPULSE_INFERENCE_ERROR;
+        }
+
+        auto impulse = handle->impulse;
+        if (impulse->dsp_input_frame_size != signal->total_length ||
+            impulse->raw_samples_per_frame != handles[0]->impulse->raw_samples_per_frame) {
+            ei_printf("ERR: Impulse '%s' does not read the shared window\n", impulse->impulse_name);
+            return EI_IMPULSE_INFERENCE_ERROR;
+        }
+        if (impulse->dsp_blocks_size > EI_CLASSIFIER_CONTINUOUS_MAX_BLOCKS ||
+            impulse->output_tensors_size > EI_CLASSIFIER_CONTINUOUS_MAX_BLOCKS) {
+            ei_printf("ERR: Impulse has more blocks than EI_CLASSIFIER_CONTINUOUS_MAX_BLOCKS (%d)\n",
+                EI_CLASSIFIER_CONTINUOUS_MAX_BLOCKS);
+            return EI_IMPULSE_ALLOC_FAILED;
+        }
+
+        ei_impulse_result_t *result = &results[h];
+        memset(result, 0, sizeof(ei_impulse_result_t));
+
+#if EI_IMPULSE_RESULT_CLASSIFICATION_IS_STATICALLY_ALLOCATED == 0
+        classification_results[h].clear();
+        if (impulse->results_type == EI_CLASSIFIER_TYPE_CLASSIFICATION ||
+            impulse->results_type == EI_CLASSIFIER_TYPE_REGRESSION) {
+            for (size_t ix = 0; ix < impulse->label_count; ix++) {
+                ei_impulse_result_classification_t classification = {
+                    .label = impulse->categories[ix],
+                    .value = 0.0f
+                };
+                classification_results[h].push_back(classification);
+            }
+        }
+        result->classification = classification_results[h].data();
+#else
+        for (int i = 0; i < impulse->label_count; i++) {
+            result->classification[i].label = impulse->categories[(uint32_t)i];
+        }
+#endif // EI_IMPULSE_RESULT_CLASSIFICATION_IS_STATICALLY_ALLOCATED == 0
+
+        result->_raw_outputs = shared_raw_outputs[h];
+        result->_raw_outputs_persistent = true;
+
+        ei_feature_t features[EI_CLASSIFIER_CONTINUOUS_MAX_BLOCKS];
+        memset(features, 0, sizeof(features));
+
+        uint64_t dsp_start_us = ei_read_timer_us();
+
+        for (size_t ix = 0; ix < impulse->dsp_blocks_size; ix++) {
+            const ei_model_dsp_t &block = impulse->dsp_blocks[ix];
+            if (block.factory || block.data_normalization_config) {
+                ei_printf("ERR: DSP block %u keeps state or normalizes, it cannot be shared\n",
+                    (unsigned)block.blockId);
+                return EI_IMPULSE_DSP_ERROR;
+            }
+
+            size_t shared_ix = 0;
+            while (shared_ix < shared_count &&
+                   !dsp_blocks_equal(shared_impulses[shared_ix], *shared_blocks[shared_ix], impulse, block)) {
+                shared_ix++;
+            }
+
+            if (shared_ix == shared_count) {
+                if (shared_count == EI_CLASSIFIER_SHARED_MAX_DSP_BLOCKS ||
+                    shared_features_used + block.n_output_features > EI_CLASSIFIER_SHARED_MAX_FEATURES) {
+                    ei_printf("ERR: DSP outputs exceed EI_CLASSIFIER_SHARED_MAX_DSP_BLOCKS (%d) or "
+                        "EI_CLASSIFIER_SHARED_MAX_FEATURES (%d)\n",
+                        EI_CLASSIFIER_SHARED_MAX_DSP_BLOCKS, (int)EI_CLASSIFIER_SHARED_MAX_FEATURES);
+                    return EI_IMPULSE_ALLOC_FAILED;
+                }
+
+                float *buffer = shared_features + shared_features_used;
+                if (shared_views[shared_ix] == nullptr) {
+                    shared_views[shared_ix] = new ei::matrix_t(1, block.n_output_features, buffer);
+                    if (shared_views[shared_ix] == nullptr) {
+                        ei_printf("ERR: Out of memory, can't allocate shared_views[%lu]\n", (unsigned long)shared_ix);
+                        return EI_IMPULSE_ALLOC_FAILED;
+                    }
+                }
+                shared_views[shared_ix]->buffer = buffer;
+                shared_views[shared_ix]->rows = 1;
+                shared_views[shared_ix]->cols = block.n_output_features;
+
+#if EIDSP_SIGNAL_C_FN_POINTER
+                if (block.axes_size != impulse->raw_samples_per_frame) {
+                    ei_printf("ERR: EIDSP_SIGNAL_C_FN_POINTER can only be used when all axes are selected for DSP blocks\n");
+                    return EI_IMPULSE_DSP_ERROR;
+                }
+                auto internal_signal = signal;
+#else
+                SignalWithAxes swa(signal, block.axes, block.axes_size, impulse);
+                auto internal_signal = swa.get_signal();
+#endif
+
+                int ret = block.extract_fn(internal_signal, shared_views[shared_ix], block.config, impulse->frequency);
+                if (ret != EIDSP_OK) {
+                    ei_printf("ERR: Failed to run DSP process (%d)\n", ret);
+                    return EI_IMPULSE_DSP_ERROR;
+                }
+
+                if (ei_run_impulse_check_canceled() == EI_IMPULSE_CANCELED) {
+                    return EI_IMPULSE_CANCELED;
+                }
+
+                shared_impulses[shared_ix] = impulse;
+                shared_blocks[shared_ix] = &block;
+                shared_count++;
+                shared_features_used += block.n_output_features;
+            }
+
+            features[ix].matrix = shared_views[shared_ix];
+            features[ix].blockId = block.blockId;
+        }
+
+        result->timing.dsp_us = ei_read_timer_us() - dsp_start_us;
+        result->timing.dsp = (int)(result->timing.dsp_us / 1000);
+
+        if (debug) {
+            ei_printf("Running impulse '%s' (%d ms. DSP)...\n", impulse->impulse_name, result->timing.dsp);
+        }
+
+        EI_IMPULSE_ERROR res = run_inference(handle, features, result, debug);
+        if (res != EI_IMPULSE_OK) {
+            return res;
+        }
+        res = run_postprocessing(handle, result);
+        if (res != EI_IMPULSE_OK) {
+            return res;
+        }
+    }
+
+    return EI_IMPULSE_OK;
+#endif // EI_CLASSIFIER_LOAD_IMAGE_SCALING
+}
+
+#if EI_CLASSIFIER_RAW_QUANTIZED_INPUT == 1
+/**
+ * @brief Get the quantization parameters of the model input, for filling a window that is
+ *  passed to `run_classifier_quantized()`.
+ *
+ * A value `x` is quantized as `round(x / scale) + zero_point`, clamped to [-128, 127].
+ *
+ * **Blocking**: no
+ *
+ * @param[out] scale Input scale
+ * @param[out] zero_point Input zero point
+ *
+ * @return Error code as defined by `EI_IMPULSE_ERROR` enum.
+ */
+extern "C" EI_IMPULSE_ERROR run_classifier_get_input_quantization(float *scale, int32_t *zero_point)
+{
+    auto& impulse = ei_default_impulse;
+    if (!can_run_classifier_raw_quantized(impulse.impulse)) {
+        return EI_IMPULSE_UNSUPPORTED_INFERENCING_ENGINE;
+    }
+    return get_nn_input_quantization(impulse.impulse->learning_blocks[0].config, scale, zero_point);
+}
+
+/**
+ * @brief Run the classifier over a window that is already quantized to the model's int8
+ *  input layout (e.g. filled during acquisition).
+ *
+ * Skips `signal_t`, the DSP step, the float features matrix and the quantize step: the
+ * window is written straight into the input tensor and the model is invoked. Only available
+ * for impulses whose features are the raw window (`EI_CLASSIFIER_DSP_RAW_IDENTITY`) with a
+ * quantized EON model. The window may be a ring buffer, `oldest` is the index of its oldest
+ * value; the input tensor receives `features[oldest..size)` followed by `features[0..oldest)`.
+ *
+ * **Blocking**: yes
+ *
+ * @param[in] features Quantized window, see `run_classifier_get_input_quantization()`
+ * @param[in] features_size Number of values in the window (`EI_CLASSIFIER_NN_INPUT_FRAME_SIZE`)
+ * @param[in] oldest Index of the oldest value in the window (0 if not a ring buffer)
+ * @param[out] result Pointer to an `ei_impulse_result_t` struct that contains the various output
+ *  results from inference after run_classifier_quantized() returns.
+ * @param[in] debug Print internal inference debugging information via `ei_printf()`.
+ *
+ * @return Error code as defined by `EI_IMPULSE_ERROR` enum. Will be `EI_IMPULSE_OK` if inference
+ *  completed successfully.
+ */
+extern "C" EI_IMPULSE_ERROR run_classifier_quantized(
+    const int8_t *features,
+    size_t features_size,
+    size_t oldest,
+    ei_impulse_result_t *result,
+    bool debug = false)
+{
+    return process_impulse_quantized(&ei_default_impulse, features, features_size, oldest, result, debug);
+}
+#endif // EI_CLASSIFIER_RAW_QUANTIZED_INPUT == 1
+
 /**
  * @brief Run the classifier over a raw features array.
  *
@@ -37,6 +37,7 @@
 
 #include "edge-impulse-sdk/classifier/ei_model_types.h"
 #include "edge-impulse-sdk/dsp/spectral/spectral.hpp"
+#include "edge-impulse-sdk/dsp/spectral/feature_continuous.hpp"
 #include "edge-impulse-sdk/dsp/speechpy/speechpy.hpp"
 #include "edge-impulse-sdk/classifier/ei_signal_with_range.h"
 #include "edge-impulse-sdk/dsp/ei_flatten.h"
@@ -88,6 +89,7 @@ float ei_dsp_image_buffer[EI_DSP_IMAGE_BUFFER_STATIC_SIZE];
 static float *ei_dsp_cont_current_frame = nullptr;
 static size_t ei_dsp_cont_current_frame_size = 0;
 static int ei_dsp_cont_current_frame_ix = 0;
+static ei::spectral::continuous_spectral_analysis ei_dsp_cont_spectral;
 
 __attribute__((unused)) int extract_hr_features(
     signal_t *signal,
@@ -188,6 +190,52 @@ __attribute__((unused)) int extract_spectral_analysis_features(
     return EIDSP_NOT_SUPPORTED;
 }
 
+static int spectral_window_get_data(size_t offset, size_t length, float *out_ptr) {
+    return ei_dsp_cont_spectral.get_window_data(offset, length, out_ptr);
+}
+
+/**
+ * Continuous version of extract_spectral_analysis_features. Every slice is appended to a kept
+ * window; once the window is full the output matrix holds the features of the latest window.
+ * FFT analysis (version 2 / 3) updates its statistics and spectra per slice, see
+ * ei::spectral::continuous_spectral_analysis; other configurations run the batch block over the
+ * kept window. The window is EI_CLASSIFIER_RAW_SAMPLE_COUNT frames.
+ */
+__attribute__((unused)) int extract_spectral_analysis_per_slice_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float frequency, matrix_size_t *matrix_size_out) {
+    ei_dsp_config_spectral_analysis_t *config = (ei_dsp_config_spectral_analysis_t *)config_ptr;
+
+    int ret = ei_dsp_cont_spectral.configure(config, frequency, EI_CLASSIFIER_RAW_SAMPLE_COUNT);
+    if (ret != EIDSP_OK) {
+        EIDSP_ERR(ret);
+    }
+    ret = ei_dsp_cont_spectral.push(signal);
+    if (ret != EIDSP_OK) {
+        EIDSP_ERR(ret);
+    }
+
+    matrix_size_out->rows = 1;
+    matrix_size_out->cols = 0;
+    if (!ei_dsp_cont_spectral.window_full()) {
+        return EIDSP_OK;
+    }
+
+    if (ei_dsp_cont_spectral.incremental()) {
+        ret = ei_dsp_cont_spectral.extract(output_matrix);
+    }
+    else {
+        signal_t window;
+        window.total_length = EI_CLASSIFIER_RAW_SAMPLE_COUNT * config->axes;
+        window.get_data = &spectral_window_get_data;
+        ret = extract_spectral_analysis_features(&window, output_matrix, config_ptr, frequency);
+    }
+    if (ret != EIDSP_OK) {
+        EIDSP_ERR(ret);
+    }
+    matrix_size_out->cols = output_matrix->rows * output_matrix->cols;
+
+    return EIDSP_OK;
+}
+
 __attribute__((unused)) int extract_raw_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float frequency) {
     ei_dsp_config_raw_t config = *((ei_dsp_config_raw_t*)config_ptr);
 
@@ -211,6 +259,44 @@ __attribute__((unused)) int extract_raw_features(signal_t *signal, matrix_t *out
     return EIDSP_OK;
 }
 
+/**
+ * Continuous version of extract_raw_features. The output matrix holds the whole window:
+ * the oldest values are shifted out and the new slice is appended (scaled) at the end,
+ * so the slice can be any length up to the window size.
+ */
+__attribute__((unused)) int extract_raw_per_slice_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float frequency, matrix_size_t *matrix_size_out) {
+    ei_dsp_config_raw_t config = *((ei_dsp_config_raw_t*)config_ptr);
+
+    const size_t window_size = output_matrix->rows * output_matrix->cols;
+    size_t els_to_copy = signal->total_length;
+    size_t offset = 0;
+    if (els_to_copy > window_size) {
+        // only the newest values still fit in the window
+        offset = els_to_copy - window_size;
+        els_to_copy = window_size;
+    }
+
+    memmove(output_matrix->buffer, output_matrix->buffer + els_to_copy,
+        (window_size - els_to_copy) * sizeof(float));
+
+    matrix_t slice(1, els_to_copy, output_matrix->buffer + window_size - els_to_copy);
+    int ret = signal->get_data(offset, els_to_copy, slice.buffer);
+    if (ret != 0) {
+        EIDSP_ERR(ret);
+    }
+
+    // scale the signal
+    ret = numpy::scale(&slice, config.scale_axes);
+    if (ret != EIDSP_OK) {
+        EIDSP_ERR(ret);
+    }
+
+    matrix_size_out->rows = 1;
+    matrix_size_out->cols = els_to_copy;
+
+    return EIDSP_OK;
+}
+
 __attribute__((unused)) int extract_flatten_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float frequency) {
     auto handle = flatten_class::create(config_ptr, frequency);
     auto ret = handle->extract(signal, output_matrix, config_ptr, frequency, nullptr);
@@ -1411,6 +1497,7 @@ __attribute__((unused)) int ei_dsp_clear_continuous_audio_state() {
     ei_dsp_cont_current_frame = nullptr;
     ei_dsp_cont_current_frame_size = 0;
     ei_dsp_cont_current_frame_ix = 0;
+    ei_dsp_cont_spectral.clear();
 
     return EIDSP_OK;
 }
@@ -0,0 +1,241 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef _EI_CLASSIFIER_INFERENCING_ENGINE_TCN_H_
+#define _EI_CLASSIFIER_INFERENCING_ENGINE_TCN_H_
+
+/**
+ * Streaming engine for temporal convolution networks: a stack of causal,
+ * dilated 1D convolutions (int8, TFLite requantization) followed by a dense
+ * classification head on the newest output frame.
+ *
+ * Every layer keeps a ring of the last (kernel_size - 1) * dilation + 1 input
+ * frames, so ei_tcn_step() consumes exactly one new frame and costs the same
+ * whatever the receptive field (1 + sum((kernel_size - 1) * dilation)).
+ * Before the first frames arrive the rings hold the input zero point, which is
+ * the zero padding of a causal convolution.
+ *
+ * run_tcn_inference() has the ei_learning_block_t infer_fn signature: it resets
+ * the state and steps through every frame of the feature matrix, which gives the
+ * same result as a continuous stream as long as the window is at least the
+ * receptive field long.
+ */
+
+#include <math.h>
+#include <string.h>
+#include "edge-impulse-sdk/classifier/ei_model_types.h"
+#include "edge-impulse-sdk/classifier/ei_quantize.h"
+#include "edge-impulse-sdk/dsp/numpy.hpp"
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/common.h"
+
+// Largest input frame run_tcn_inference quantizes on the stack
+#ifndef EI_TCN_MAX_INPUT_CHANNELS
+#define EI_TCN_MAX_INPUT_CHANNELS 16
+#endif
+
+static inline uint16_t ei_tcn_history_frames(const ei_tcn_layer_t *layer) {
+    return (uint16_t)((layer->kernel_size - 1) * layer->dilation + 1);
+}
+
+/**
+ * @brief      Forget every past frame (rings back to the causal zero padding)
+ */
+__attribute__((unused)) static void ei_tcn_reset(const ei_learning_block_config_tcn_t *config) {
+    for (size_t l = 0; l < config->layers_size; l++) {
+        const ei_tcn_layer_t *layer = &config->layers[l];
+        memset(layer->history, (int8_t)(-layer->input_offset),
+               (size_t)ei_tcn_history_frames(layer) * layer->in_channels);
+        *layer->history_head = 0;
+    }
+}
+
+/**
+ * @brief      Quantize one float frame with the block's input quantization
+ */
+__attribute__((unused)) static void ei_tcn_quantize_frame(const ei_learning_block_config_tcn_t *config,
+                                                          const float *frame, int8_t *out_frame) {
+    for (size_t c = 0; c < config->input_channels; c++) {
+        out_frame[c] = (int8_t)pre_cast_quantize(frame[c], config->input_scale, config->input_zero_point, true);
+    }
+}
+
+/**
+ * @brief      Push one input frame through a layer
+ *
+ * @param      input   in_channels values, stored in the layer's ring
+ * @param      output  out_channels values for the same time step
+ */
+static void ei_tcn_layer_step(const ei_tcn_layer_t *layer, const int8_t *input, int8_t *output) {
+    const uint16_t frames = ei_tcn_history_frames(layer);
+    const uint16_t head = *layer->history_head;
+    memcpy(&layer->history[(size_t)head * layer->in_channels], input, layer->in_channels);
+
+    for (size_t o = 0; o < layer->out_channels; o++) {
+        const int8_t *filter = &layer->weights[o * layer->kernel_size * layer->in_channels];
+        int32_t acc = layer->bias ? layer->bias[o] : 0;
+        for (size_t k = 0; k < layer->kernel_size; k++) {
+            // tap k sees the frame (kernel_size - 1 - k) * dilation steps back
+            const size_t back = (layer->kernel_size - 1 - k) * layer->dilation;
+            const int8_t *x = &layer->history[((head + frames - back) % frames) * layer->in_channels];
+            const int8_t *w = &filter[k * layer->in_channels];
+            for (size_t i = 0; i < layer->in_channels; i++) {
+                acc += (x[i] + layer->input_offset) * w[i];
+            }
+        }
+        int32_t out = tflite::MultiplyByQuantizedMultiplier(acc, layer->multiplier, layer->shift) +
+                      layer->output_offset;
+        out = out < layer->act_min ? layer->act_min : out;
+        output[o] = (int8_t)(out > 127 ? 127 : out);
+    }
+    *layer->history_head = (uint16_t)((head + 1) % frames);
+}
+
+/**
+ * @brief      Consume one quantized input frame and classify the newest time step
+ *
+ * @param      frame       input_channels int8 values
+ * @param      out_scores  classes probabilities (nullptr: only update the state)
+ *
+ * @return     The ei impulse error.
+ */
+__attribute__((unused)) static EI_IMPULSE_ERROR ei_tcn_step(const ei_learning_block_config_tcn_t *config,
+                                                            const int8_t *frame, float *out_scores) {
+    if (config->layers_size == 0) {
+        return EI_IMPULSE_INVALID_SIZE;
+    }
+
+    // layers alternate between the two halves of the scratch buffer
+    size_t widest = config->input_channels;
+    for (size_t l = 0; l < config->layers_size; l++) {
+        widest = config->layers[l].out_channels > widest ? config->layers[l].out_channels : widest;
+    }
+    const int8_t *input = frame;
+    int8_t *output = config->scratch;
+    for (size_t l = 0; l < config->layers_size; l++) {
+        ei_tcn_layer_step(&config->layers[l], input, output);
+        input = output;
+        output = output == config->scratch ? config->scratch + widest : config->scratch;
+    }
+    if (out_scores == nullptr) {
+        return EI_IMPULSE_OK;
+    }
+
+    const size_t features = config->layers[config->layers_size - 1].out_channels;
+    float max_logit = -INFINITY;
+    for (size_t k = 0; k < config->classes; k++) {
+        const int8_t *w = &config->head_weights[k * features];
+        int32_t acc = config->head_bias[k];
+        for (size_t i = 0; i < features; i++) {
+            acc += (input[i] + config->head_input_offset) * w[i];
+        }
+        out_scores[k] = acc * config->head_logit_scale;
+        max_logit = out_scores[k] > max_logit ? out_scores[k] : max_logit;
+    }
+    float total = 0.0f;
+    for (size_t k = 0; k < config->classes; k++) {
+        out_scores[k] = expf(out_scores[k] - max_logit);
+        total += out_scores[k];
+    }
+    for (size_t k = 0; k < config->classes; k++) {
+        out_scores[k] /= total;
+    }
+    return EI_IMPULSE_OK;
+}
+
+/**
+ * @brief      Do TCN inferencing over a feature matrix (frames of input_channels values,
+ *             oldest first); the probabilities of the last frame go to result->_raw_outputs
+ *
+ * @param      fmatrix  Processed matrix
+ * @param      result   Output classifier results
+ * @param[in]  debug    Debug output enable
+ *
+ * @return     The ei impulse error.
+ */
+__attribute__((unused)) static EI_IMPULSE_ERROR run_tcn_inference(
+    const ei_impulse_t *impulse,
+    ei_feature_t *fmatrix,
+    uint32_t learn_block_index,
+    uint32_t* input_block_ids,
+    uint32_t input_block_ids_size,
+    ei_impulse_result_t *result,
+    void *config_ptr,
+    bool debug = false)
+{
+    const ei_learning_block_config_tcn_t *config = (const ei_learning_block_config_tcn_t*)config_ptr;
+
+    ei::matrix_t *matrix = NULL;
+    if (input_block_ids_size != 1 ||
+        !find_mtx_by_idx(fmatrix, &matrix, input_block_ids[0], impulse->dsp_blocks_size)) {
+        ei_printf("ERR: TCN block expects the features of exactly one DSP block\n");
+        return EI_IMPULSE_INVALID_SIZE;
+    }
+    const size_t values = matrix->rows * matrix->cols;
+    if (config->input_channels == 0 || config->input_channels > EI_TCN_MAX_INPUT_CHANNELS ||
+        values % config->input_channels != 0) {
+        ei_printf("ERR: %u features do not split into frames of %u values\n",
+                  (unsigned)values, (unsigned)config->input_channels);
+        return EI_IMPULSE_INVALID_SIZE;
+    }
+
+    ei::matrix_t *output = result->_raw_outputs[learn_block_index].matrix;
+    if (!(result->_raw_outputs_persistent && output && output->rows * output->cols == config->classes)) {
+        delete output;
+        output = new ei::matrix_t(1, config->classes);
+        result->_raw_outputs[learn_block_index].matrix = output;
+    }
+    result->_raw_outputs[learn_block_index].blockId = config->block_id;
+
+    uint64_t ctx_start_us = ei_read_timer_us();
+    ei_tcn_reset(config);
+    int8_t frame[EI_TCN_MAX_INPUT_CHANNELS];
+    const size_t frames = values / config->input_channels;
+    for (size_t t = 0; t < frames; t++) {
+        ei_tcn_quantize_frame(config, &matrix->buffer[t * config->input_channels], frame);
+        EI_IMPULSE_ERROR res = ei_tcn_step(config, frame, t + 1 == frames ? output->buffer : nullptr);
+        if (res != EI_IMPULSE_OK) {
+            return res;
+        }
+    }
+    result->timing.classification_us = ei_read_timer_us() - ctx_start_us;
+    result->timing.classification = (int)(result->timing.classification_us / 1000);
+
+    if (debug) {
+        ei_printf("TCN: %u frames through %u layers\n", (unsigned)frames, (unsigned)config->layers_size);
+    }
+    return EI_IMPULSE_OK;
+}
+
+#endif // _EI_CLASSIFIER_INFERENCING_ENGINE_TCN_H_
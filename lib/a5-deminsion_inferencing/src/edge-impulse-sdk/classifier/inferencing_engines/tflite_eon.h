@@ -112,7 +112,11 @@ static EI_IMPULSE_ERROR inference_tflite_run(
 
     ei_config_tflite_eon_graph_t *graph_config = (ei_config_tflite_eon_graph_t*)block_config->graph_config;
 
-    if (graph_config->model_invoke() != kTfLiteOk) {
+    TfLiteStatus invoke_status = graph_config->model_invoke();
+    if (invoke_status == kTfLiteCancelled) {
+        return EI_IMPULSE_CANCELED;
+    }
+    if (invoke_status != kTfLiteOk) {
         return EI_IMPULSE_TFLITE_ERROR;
     }
 
@@ -153,6 +157,8 @@ EI_IMPULSE_ERROR run_nn_inference_from_dsp(
     uint64_t ctx_start_us = ei_read_timer_us();
     ei_unique_ptr_t p_tensor_arena(nullptr, ei_aligned_free);
     ei_config_tflite_eon_graph_t *graph_config = (ei_config_tflite_eon_graph_t*)block_config->graph_config;
+    // a graph that is already initialized belongs to someone else (init is then a no-op)
+    const bool was_initialized = graph_config->model_initialized && graph_config->model_initialized();
 
     EI_IMPULSE_ERROR init_res = inference_tflite_setup(
         block_config,
@@ -171,7 +177,11 @@ EI_IMPULSE_ERROR run_nn_inference_from_dsp(
     }
 
     // invoke the model
-    if (graph_config->model_invoke() != kTfLiteOk) {
+    TfLiteStatus invoke_status = graph_config->model_invoke();
+    if (invoke_status == kTfLiteCancelled) {
+        return EI_IMPULSE_CANCELED;
+    }
+    if (invoke_status != kTfLiteOk) {
         return EI_IMPULSE_TFLITE_ERROR;
     }
 
@@ -180,7 +190,7 @@ EI_IMPULSE_ERROR run_nn_inference_from_dsp(
         return output_res;
     }
 
-    if (graph_config->model_reset(ei_aligned_free) != kTfLiteOk) {
+    if (!was_initialized && graph_config->model_reset(ei_aligned_free) != kTfLiteOk) {
         return EI_IMPULSE_TFLITE_ERROR;
     }
     ei_free(outputs);
@@ -188,37 +198,79 @@ EI_IMPULSE_ERROR run_nn_inference_from_dsp(
     return EI_IMPULSE_OK;
 }
 
+#ifndef EI_EON_MAX_STACK_OUTPUT_TENSORS
+#define EI_EON_MAX_STACK_OUTPUT_TENSORS 4
+#endif
+
 /**
- * @brief      Do neural network inferencing over a feature matrix
+ * Get the raw output matrix for an output tensor. A new matrix is allocated per inference
+ * (freed in run_postprocessing), unless the caller keeps its raw outputs across inferences,
+ * in which case a matrix of the right size from the previous inference is reused.
  *
- * @param      fmatrix  Processed matrix
- * @param      result   Output classifier results
- * @param[in]  debug    Debug output enable
+ * @param   result          Struct for results
+ * @param   slot            Raw output matrix pointer in result->_raw_outputs
+ * @param   output_size     Number of elements in the output tensor
+ *
+ * @return  The matrix to fill
+ */
+template<typename T>
+static T* eon_raw_output_matrix(ei_impulse_result_t *result, T*& slot, size_t output_size) {
+    if (result->_raw_outputs_persistent && slot) {
+        if (slot->rows * slot->cols == output_size) {
+            return slot;
+        }
+        delete slot;
+    }
+    slot = new T(1, output_size);
+    return slot;
+}
+
+/**
+ * @brief      Set up the graph, fill the input tensor, invoke and copy the outputs
+ *             into result->_raw_outputs
+ *
+ * @param      block_config       Learning block config
+ * @param      learn_block_index  Index of the learning block
+ * @param      result             Output classifier results
+ * @param      fill_input         Callable that fills the input tensor, returns EI_IMPULSE_OK
+ * @param[in]  debug              Debug output enable
  *
  * @return     The ei impulse error.
  */
-EI_IMPULSE_ERROR run_nn_inference(
+template<typename FillInput>
+static EI_IMPULSE_ERROR inference_tflite_invoke(
     const ei_impulse_t *impulse,
-    ei_feature_t *fmatrix,
+    ei_learning_block_config_tflite_graph_t *block_config,
     uint32_t learn_block_index,
-    uint32_t* input_block_ids,
-    uint32_t input_block_ids_size,
     ei_impulse_result_t *result,
-    void *config_ptr,
-    bool debug = false)
+    FillInput fill_input,
+    bool debug)
 {
-    ei_learning_block_config_tflite_graph_t *block_config = (ei_learning_block_config_tflite_graph_t*)config_ptr;
     ei_config_tflite_eon_graph_t *graph_config = (ei_config_tflite_eon_graph_t*)block_config->graph_config;
 
     TfLiteTensor input;
     TfLiteTensor *outputs;
 
-    // allocate outputs
-    outputs = (TfLiteTensor*)ei_malloc(block_config->output_tensors_size * sizeof(TfLiteTensor));
+    // outputs live on the stack unless the model has more than a few of them
+    TfLiteTensor outputs_storage[EI_EON_MAX_STACK_OUTPUT_TENSORS];
+    if (block_config->output_tensors_size <= EI_EON_MAX_STACK_OUTPUT_TENSORS) {
+        outputs = outputs_storage;
+    }
+    else {
+        outputs = (TfLiteTensor*)ei_malloc(block_config->output_tensors_size * sizeof(TfLiteTensor));
+    }
 
     uint64_t ctx_start_us = ei_read_timer_us();
     ei_unique_ptr_t p_tensor_arena(nullptr, ei_aligned_free);
 
+    // Continuous classification (persistent raw outputs) keeps a graph that can report
+    // its state initialized: after the first window every inference is fill + invoke,
+    // without an arena memset, op init / prepare or teardown. A graph that is already
+    // initialized is reused as is and never torn down here.
+    const bool was_initialized = graph_config->model_initialized && graph_config->model_initialized();
+    const bool keep_graph = was_initialized ||
+        (result->_raw_outputs_persistent && graph_config->model_initialized && graph_config->model_reset_state);
+
     EI_IMPULSE_ERROR init_res = inference_tflite_setup(
         block_config,
         &ctx_start_us,
@@ -232,13 +284,7 @@ EI_IMPULSE_ERROR run_nn_inference(
 
     uint8_t* tensor_arena = static_cast<uint8_t*>(p_tensor_arena.get());
 
-    auto input_res = fill_input_tensor_from_matrix(fmatrix,
-                                                   result->_raw_outputs,
-                                                   &input,
-                                                   input_block_ids,
-                                                   input_block_ids_size,
-                                                   impulse->dsp_blocks_size,
-                                                   impulse->learning_blocks_size);
+    auto input_res = fill_input(&input);
 
     if (input_res != EI_IMPULSE_OK) {
         return input_res;
@@ -260,29 +306,29 @@ EI_IMPULSE_ERROR run_nn_inference(
         }
         switch (output->type) {
             case kTfLiteFloat32: {
-                result->_raw_outputs[learn_block_index + output_ix].matrix = new matrix_t(1, output_size);
-                memcpy(result->_raw_outputs[learn_block_index + output_ix].matrix->buffer, output->data.f, output->bytes);
+                matrix_t *matrix = eon_raw_output_matrix(result, result->_raw_outputs[learn_block_index + output_ix].matrix, output_size);
+                memcpy(matrix->buffer, output->data.f, output->bytes);
                 break;
             }
             case kTfLiteInt8: {
                 if (block_config->dequantize_output) {
-                    result->_raw_outputs[learn_block_index + output_ix].matrix = new matrix_t(1, output_size);
-                    fill_output_matrix_from_tensor(output, result->_raw_outputs[learn_block_index + output_ix].matrix);
+                    matrix_t *matrix = eon_raw_output_matrix(result, result->_raw_outputs[learn_block_index + output_ix].matrix, output_size);
+                    fill_output_matrix_from_tensor(output, matrix);
                 }
                 else {
-                    result->_raw_outputs[learn_block_index + output_ix].matrix_i8 = new matrix_i8_t(1, output_size);
-                    memcpy(result->_raw_outputs[learn_block_index + output_ix].matrix_i8->buffer, output->data.int8, output->bytes);
+                    matrix_i8_t *matrix = eon_raw_output_matrix(result, result->_raw_outputs[learn_block_index + output_ix].matrix_i8, output_size);
+                    memcpy(matrix->buffer, output->data.int8, output->bytes);
                 }
                 break;
             }
             case kTfLiteUInt8: {
                 if (block_config->dequantize_output) {
-                    result->_raw_outputs[learn_block_index + output_ix].matrix = new matrix_t(1, output_size);
-                    fill_output_matrix_from_tensor(output, result->_raw_outputs[learn_block_index + output_ix].matrix);
+                    matrix_t *matrix = eon_raw_output_matrix(result, result->_raw_outputs[learn_block_index + output_ix].matrix, output_size);
+                    fill_output_matrix_from_tensor(output, matrix);
                 }
                 else {
-                    result->_raw_outputs[learn_block_index + output_ix].matrix_u8 = new matrix_u8_t(1, output_size);
-                    memcpy(result->_raw_outputs[learn_block_index + output_ix].matrix_u8->buffer, output->data.uint8, output->bytes);
+                    matrix_u8_t *matrix = eon_raw_output_matrix(result, result->_raw_outputs[learn_block_index + output_ix].matrix_u8, output_size);
+                    memcpy(matrix->buffer, output->data.uint8, output->bytes);
                 }
                 break;
             }
@@ -295,8 +341,12 @@ EI_IMPULSE_ERROR run_nn_inference(
         result->_raw_outputs[learn_block_index].blockId = block_config->block_id;
     }
 
-    graph_config->model_reset(ei_aligned_free);
-    ei_free(outputs);
+    if (!keep_graph) {
+        graph_config->model_reset(ei_aligned_free);
+    }
+    if (outputs != outputs_storage) {
+        ei_free(outputs);
+    }
 
     if (run_res != EI_IMPULSE_OK) {
         return run_res;
@@ -305,6 +355,158 @@ EI_IMPULSE_ERROR run_nn_inference(
     return EI_IMPULSE_OK;
 }
 
+/**
+ * @brief      Do neural network inferencing over a feature matrix
+ *
+ * @param      fmatrix  Processed matrix
+ * @param      result   Output classifier results
+ * @param[in]  debug    Debug output enable
+ *
+ * @return     The ei impulse error.
+ */
+EI_IMPULSE_ERROR run_nn_inference(
+    const ei_impulse_t *impulse,
+    ei_feature_t *fmatrix,
+    uint32_t learn_block_index,
+    uint32_t* input_block_ids,
+    uint32_t input_block_ids_size,
+    ei_impulse_result_t *result,
+    void *config_ptr,
+    bool debug = false)
+{
+    ei_learning_block_config_tflite_graph_t *block_config = (ei_learning_block_config_tflite_graph_t*)config_ptr;
+
+    auto fill_input = [&](TfLiteTensor *input) {
+        return fill_input_tensor_from_matrix(fmatrix,
+                                             result->_raw_outputs,
+                                             input,
+                                             input_block_ids,
+                                             input_block_ids_size,
+                                             impulse->dsp_blocks_size,
+                                             impulse->learning_blocks_size);
+    };
+
+    return inference_tflite_invoke(impulse, block_config, learn_block_index, result, fill_input, debug);
+}
+
+/**
+ * @brief      Zero the variables (state of stateful models) of the compiled graphs of an
+ *             impulse that are initialized; graphs that are not start from zero anyway
+ *
+ * @param      impulse  Impulse
+ *
+ * @return     EI_IMPULSE_OK, or EI_IMPULSE_TFLITE_ERROR if a graph failed to reset
+ */
+EI_IMPULSE_ERROR reset_nn_state(const ei_impulse_t *impulse)
+{
+    for (size_t ix = 0; ix < impulse->learning_blocks_size; ix++) {
+        const ei_learning_block_t &block = impulse->learning_blocks[ix];
+        if (block.infer_fn != run_nn_inference) {
+            continue;
+        }
+        ei_learning_block_config_tflite_graph_t *block_config = (ei_learning_block_config_tflite_graph_t*)block.config;
+        ei_config_tflite_eon_graph_t *graph_config = (ei_config_tflite_eon_graph_t*)block_config->graph_config;
+        if (graph_config->model_initialized && graph_config->model_reset_state &&
+            graph_config->model_initialized() && graph_config->model_reset_state() != kTfLiteOk) {
+            return EI_IMPULSE_TFLITE_ERROR;
+        }
+    }
+    return EI_IMPULSE_OK;
+}
+
+/**
+ * @brief      Tear down the compiled graphs of an impulse that continuous classification
+ *             kept initialized
+ *
+ * @param      impulse  Impulse
+ */
+void release_nn_graphs(const ei_impulse_t *impulse)
+{
+    for (size_t ix = 0; ix < impulse->learning_blocks_size; ix++) {
+        const ei_learning_block_t &block = impulse->learning_blocks[ix];
+        if (block.infer_fn != run_nn_inference) {
+            continue;
+        }
+        ei_learning_block_config_tflite_graph_t *block_config = (ei_learning_block_config_tflite_graph_t*)block.config;
+        ei_config_tflite_eon_graph_t *graph_config = (ei_config_tflite_eon_graph_t*)block_config->graph_config;
+        if (graph_config->model_initialized && graph_config->model_initialized()) {
+            graph_config->model_reset(ei_aligned_free);
+        }
+    }
+}
+
+/**
+ * @brief      Get the quantization parameters of the (int8) input tensor, without
+ *             setting up the graph
+ *
+ * @param      config_ptr  Learning block config
+ * @param      scale       Output input scale
+ * @param      zero_point  Output input zero point
+ *
+ * @return     EI_IMPULSE_OK, or an error if the input is not int8
+ */
+EI_IMPULSE_ERROR get_nn_input_quantization(void *config_ptr, float *scale, int32_t *zero_point)
+{
+    ei_learning_block_config_tflite_graph_t *block_config = (ei_learning_block_config_tflite_graph_t*)config_ptr;
+    ei_config_tflite_eon_graph_t *graph_config = (ei_config_tflite_eon_graph_t*)block_config->graph_config;
+
+    // the tensor description (type, quantization) is static, only its data lives in the arena
+    TfLiteTensor input;
+    if (graph_config->model_input(0, &input) != kTfLiteOk) {
+        return EI_IMPULSE_TFLITE_ERROR;
+    }
+    if (input.type != kTfLiteInt8) {
+        return EI_IMPULSE_INPUT_TENSOR_WAS_NULL;
+    }
+
+    *scale = input.params.scale;
+    *zero_point = input.params.zero_point;
+    return EI_IMPULSE_OK;
+}
+
+/**
+ * @brief      Do neural network inferencing over an already quantized feature buffer,
+ *             which is copied straight into the input tensor
+ *
+ * @param      input_buffer  Quantized features (int8 input tensor layout), may be a ring
+ * @param      length        Number of values in input_buffer
+ * @param      oldest        Index of the oldest value in input_buffer (0 if not a ring)
+ * @param      result        Output classifier results
+ * @param[in]  debug         Debug output enable
+ *
+ * @return     The ei impulse error.
+ */
+EI_IMPULSE_ERROR run_nn_inference_i8(
+    const ei_impulse_t *impulse,
+    const int8_t *input_buffer,
+    size_t length,
+    size_t oldest,
+    uint32_t learn_block_index,
+    ei_impulse_result_t *result,
+    void *config_ptr,
+    bool debug = false)
+{
+    ei_learning_block_config_tflite_graph_t *block_config = (ei_learning_block_config_tflite_graph_t*)config_ptr;
+
+    auto fill_input = [&](TfLiteTensor *input) {
+        if (input->type != kTfLiteInt8) {
+            ei_printf("ERR: Quantized input requires an int8 input tensor (%d)\n", input->type);
+            return EI_IMPULSE_INPUT_TENSOR_WAS_NULL;
+        }
+        if (input->bytes != length || oldest >= length) {
+            ei_printf("ERR: input tensor has size %d bytes, but quantized input has size %d bytes\n",
+                (int)input->bytes, (int)length);
+            return EI_IMPULSE_INVALID_SIZE;
+        }
+        // unroll the ring in time order
+        memcpy(input->data.int8, input_buffer + oldest, length - oldest);
+        memcpy(input->data.int8 + length - oldest, input_buffer, oldest);
+        return EI_IMPULSE_OK;
+    };
+
+    return inference_tflite_invoke(impulse, block_config, learn_block_index, result, fill_input, debug);
+}
+
 #if EI_CLASSIFIER_QUANTIZATION_ENABLED == 1
 /**
  * Special function to run the classifier on images, only works on TFLite models (either interpreter or EON or for tensaiflow)
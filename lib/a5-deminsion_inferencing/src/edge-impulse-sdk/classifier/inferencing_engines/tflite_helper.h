@@ -66,6 +66,9 @@ EI_IMPULSE_ERROR fill_input_tensor_from_matrix(
     size_t matrix_els = 0;
     uint32_t input_idx = 0;
 
+    // built from this tensor's quantization on every call (one divide), so impulses never share it
+    const ei_input_quantizer quantizer(input->params.scale, input->params.zero_point);
+
     for (size_t i = 0; i < input_block_ids_size; i++) {
 #if EI_CLASSIFIER_SINGLE_FEATURE_INPUT == 0
         size_t cur_mtx = input_block_ids[i];
@@ -91,18 +94,13 @@ EI_IMPULSE_ERROR fill_input_tensor_from_matrix(
                 break;
             }
             case kTfLiteInt8: {
-                for (size_t ix = 0; ix < matrix->rows * matrix->cols; ix++) {
-                    float val = (float)matrix->buffer[ix];
-                    input->data.int8[input_idx++] = static_cast<int8_t>(
-                        pre_cast_quantize(val, input->params.scale, input->params.zero_point, true));
-                }
+                quantizer.quantize_i8(matrix->buffer, input->data.int8 + input_idx, matrix->rows * matrix->cols);
+                input_idx += matrix->rows * matrix->cols;
                 break;
             }
             case kTfLiteUInt8: {
-                for (size_t ix = 0; ix < matrix->rows * matrix->cols; ix++) {
-                    float val = (float)matrix->buffer[ix];
-                    input->data.uint8[input_idx++] = static_cast<uint8_t>(
-                        pre_cast_quantize(val, input->params.scale, input->params.zero_point, false));            }
+                quantizer.quantize_u8(matrix->buffer, input->data.uint8 + input_idx, matrix->rows * matrix->cols);
+                input_idx += matrix->rows * matrix->cols;
                 break;
             }
             default: {
@@ -123,8 +123,8 @@ extern "C" EI_IMPULSE_ERROR run_postprocessing(ei_impulse_handle_t *handle,
         }
     }
 
-    // free raw results
-    for (size_t ix = 0; ix < impulse->output_tensors_size; ix++) {
+    // free raw results (unless the caller keeps them for the next inference)
+    for (size_t ix = 0; ix < impulse->output_tensors_size && !result->_raw_outputs_persistent; ix++) {
         if (result->_raw_outputs[ix].matrix) {
             delete result->_raw_outputs[ix].matrix;
             result->_raw_outputs[ix].matrix = nullptr;
@@ -185,16 +185,41 @@ static bool can_do_fft(size_t n_fft)
         n_fft == 1024 || n_fft == 2048 || n_fft == 4096;
 }
 
+/**
+* Fast rfft instance for n_fft, initialized on first use (or by numpy::init_fft_plans) and kept,
+* one per supported length. Not thread safe: the DSP runs on one thread.
+* @returns NULL if the length is not supported or its tables are not loaded
+*/
+inline arm_rfft_fast_instance_f32 *cmsis_rfft_plan(size_t n_fft)
+{
+    static arm_rfft_fast_instance_f32 plans[8];
+    static size_t plan_lengths[8];
+
+    if (!can_do_fft(n_fft)) {
+        return NULL;
+    }
+    size_t slot = 0;
+    while (((size_t)32 << slot) < n_fft) {
+        slot++;
+    }
+    if (plan_lengths[slot] != n_fft) {
+        if (cmsis_rfft_init_f32(&plans[slot], n_fft) != ARM_MATH_SUCCESS) {
+            return NULL;
+        }
+        plan_lengths[slot] = n_fft;
+    }
+    return &plans[slot];
+}
+
 static int arm_rfft(const float *input, float *output, size_t n_fft)
 {
     // hardware acceleration only works for the powers above...
-    arm_rfft_fast_instance_f32 rfft_instance;
-    int status = cmsis_rfft_init_f32(&rfft_instance, n_fft);
-    if (status != ARM_MATH_SUCCESS) {
-        return status;
+    arm_rfft_fast_instance_f32 *rfft_instance = cmsis_rfft_plan(n_fft);
+    if (!rfft_instance) {
+        return ei::EIDSP_FFT_TABLE_NOT_LOADED;
     }
 
-    arm_rfft_fast_f32(&rfft_instance, const_cast<float *>(input), output, 0);
+    arm_rfft_fast_f32(rfft_instance, const_cast<float *>(input), output, 0);
     return 0;
 }
 
@@ -0,0 +1,438 @@
+/*
+ * Copyright (c) 2024 EdgeImpulse Inc.
+ *
+ * Generated by Edge Impulse and licensed under the applicable Edge Impulse
+ * Terms of Service. Community and Professional Terms of Service
+ * (https://edgeimpulse.com/legal/terms-of-service) or Enterprise Terms of
+ * Service (https://edgeimpulse.com/legal/enterprise-terms-of-service),
+ * according to your product plan subscription (the “License”).
+ *
+ * This software, documentation and other associated files (collectively referred
+ * to as the “Software”) is a single SDK variation generated by the Edge Impulse
+ * platform and requires an active paid Edge Impulse subscription to use this
+ * Software for any purpose.
+ *
+ * You may NOT use this Software unless you have an active Edge Impulse subscription
+ * that meets the eligibility requirements for the applicable License, subject to
+ * your full and continued compliance with the terms and conditions of the License,
+ * including without limitation any usage restrictions under the applicable License.
+ *
+ * If you do not have an active Edge Impulse product plan subscription, or if use
+ * of this Software exceeds the usage limitations of your Edge Impulse product plan
+ * subscription, you are not permitted to use this Software and must immediately
+ * delete and erase all copies of this Software within your control or possession.
+ * Edge Impulse reserves all rights and remedies available to enforce its rights.
+ *
+ * Unless required by applicable law or agreed to in writing, the Software is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing
+ * permissions, disclaimers and limitations under the License.
+ */
+#ifndef __EI_SIMD__H__
+#define __EI_SIMD__H__
+
+/**
+ * Vectorized float kernels behind numpy::scale / add / subtract / mean / stdev / rms / dot.
+ * One API, picked at compile time:
+ *  - CMSIS-DSP (Cortex-M4F and up): arm_scale_f32, arm_offset_f32, arm_power_f32, arm_dot_prod_f32
+ *    (the M4F has no float SIMD; these are the unrolled library loops)
+ *  - x86 hosts: SSE2, with AVX2 selected at run time when the CPU has it
+ *  - aarch64 hosts: NEON
+ *  - anything else (or EIDSP_HOST_SIMD=0): the plain loops numpy had before
+ *
+ * Element-wise kernels (scale, offset) give the same bits on every path. The reductions
+ * (sum, sums of squares, dot) add in eight interleaved partial sums, so their rounding differs
+ * from the plain loop by a few ulp of the sum; SSE2, AVX2 and NEON use the same order and agree
+ * with each other exactly.
+ */
+
+#include <stddef.h>
+#include "config.hpp"
+
+#ifndef EIDSP_HOST_SIMD
+#define EIDSP_HOST_SIMD 1
+#endif
+
+#if EIDSP_USE_CMSIS_DSP
+#define EI_SIMD_CMSIS 1
+#include "edge-impulse-sdk/CMSIS/DSP/Include/arm_math.h"
+#elif EIDSP_HOST_SIMD && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__) && defined(__GNUC__)
+#define EI_SIMD_X86 1
+#include <immintrin.h>
+#elif EIDSP_HOST_SIMD && defined(__aarch64__) && defined(__ARM_NEON)
+#define EI_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace ei {
+namespace simd {
+
+namespace detail {
+
+// ==================== plain loops ====================
+
+static inline void scale_scalar(float *x, size_t n, float k) {
+    for (size_t i = 0; i < n; i++) {
+        x[i] *= k;
+    }
+}
+
+static inline void offset_scalar(float *x, size_t n, float k) {
+    for (size_t i = 0; i < n; i++) {
+        x[i] += k;
+    }
+}
+
+static inline float sum_scalar(const float *x, size_t n) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < n; i++) {
+        sum += x[i];
+    }
+    return sum;
+}
+
+static inline float sum_of_squares_scalar(const float *x, size_t n) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < n; i++) {
+        sum += x[i] * x[i];
+    }
+    return sum;
+}
+
+static inline float sum_of_squared_deviations_scalar(const float *x, size_t n, float mean) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < n; i++) {
+        const float diff = x[i] - mean;
+        sum += diff * diff;
+    }
+    return sum;
+}
+
+static inline float dot_scalar(const float *x, const float *y, size_t n) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < n; i++) {
+        sum += x[i] * y[i];
+    }
+    return sum;
+}
+
+#if EI_SIMD_X86
+
+// ==================== SSE2 ====================
+// Reductions keep two 4-lane accumulators (elements i % 8 in 0..3 and 4..7), the same
+// partial sums as one 8-lane AVX accumulator
+
+static inline float reduce_sse2(__m128 lo, __m128 hi) {
+    float t[4];
+    _mm_storeu_ps(t, _mm_add_ps(lo, hi));
+    return (t[0] + t[1]) + (t[2] + t[3]);
+}
+
+static inline void scale_sse2(float *x, size_t n, float k) {
+    const __m128 vk = _mm_set1_ps(k);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(x + i, _mm_mul_ps(_mm_loadu_ps(x + i), vk));
+    }
+    scale_scalar(x + i, n - i, k);
+}
+
+static inline void offset_sse2(float *x, size_t n, float k) {
+    const __m128 vk = _mm_set1_ps(k);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(x + i, _mm_add_ps(_mm_loadu_ps(x + i), vk));
+    }
+    offset_scalar(x + i, n - i, k);
+}
+
+static inline float sum_sse2(const float *x, size_t n) {
+    __m128 lo = _mm_setzero_ps(), hi = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        lo = _mm_add_ps(lo, _mm_loadu_ps(x + i));
+        hi = _mm_add_ps(hi, _mm_loadu_ps(x + i + 4));
+    }
+    return reduce_sse2(lo, hi) + sum_scalar(x + i, n - i);
+}
+
+static inline float sum_of_squares_sse2(const float *x, size_t n) {
+    __m128 lo = _mm_setzero_ps(), hi = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m128 a = _mm_loadu_ps(x + i), b = _mm_loadu_ps(x + i + 4);
+        lo = _mm_add_ps(lo, _mm_mul_ps(a, a));
+        hi = _mm_add_ps(hi, _mm_mul_ps(b, b));
+    }
+    return reduce_sse2(lo, hi) + sum_of_squares_scalar(x + i, n - i);
+}
+
+static inline float sum_of_squared_deviations_sse2(const float *x, size_t n, float mean) {
+    const __m128 vm = _mm_set1_ps(mean);
+    __m128 lo = _mm_setzero_ps(), hi = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m128 a = _mm_sub_ps(_mm_loadu_ps(x + i), vm), b = _mm_sub_ps(_mm_loadu_ps(x + i + 4), vm);
+        lo = _mm_add_ps(lo, _mm_mul_ps(a, a));
+        hi = _mm_add_ps(hi, _mm_mul_ps(b, b));
+    }
+    return reduce_sse2(lo, hi) + sum_of_squared_deviations_scalar(x + i, n - i, mean);
+}
+
+static inline float dot_sse2(const float *x, const float *y, size_t n) {
+    __m128 lo = _mm_setzero_ps(), hi = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        lo = _mm_add_ps(lo, _mm_mul_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(y + i)));
+        hi = _mm_add_ps(hi, _mm_mul_ps(_mm_loadu_ps(x + i + 4), _mm_loadu_ps(y + i + 4)));
+    }
+    return reduce_sse2(lo, hi) + dot_scalar(x + i, y + i, n - i);
+}
+
+// ==================== AVX2 ====================
+// Compiled for AVX2 whatever the build flags say and only called when the CPU has it.
+// No FMA: multiply and add round separately, as on the other paths
+
+#define EI_SIMD_AVX2 __attribute__((target("avx2")))
+
+EI_SIMD_AVX2 static inline float reduce_avx2(__m256 acc) {
+    return reduce_sse2(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+}
+
+EI_SIMD_AVX2 static inline void scale_avx2(float *x, size_t n, float k) {
+    const __m256 vk = _mm256_set1_ps(k);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(x + i, _mm256_mul_ps(_mm256_loadu_ps(x + i), vk));
+    }
+    scale_scalar(x + i, n - i, k);
+}
+
+EI_SIMD_AVX2 static inline void offset_avx2(float *x, size_t n, float k) {
+    const __m256 vk = _mm256_set1_ps(k);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(x + i, _mm256_add_ps(_mm256_loadu_ps(x + i), vk));
+    }
+    offset_scalar(x + i, n - i, k);
+}
+
+EI_SIMD_AVX2 static inline float sum_avx2(const float *x, size_t n) {
+    __m256 acc = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc = _mm256_add_ps(acc, _mm256_loadu_ps(x + i));
+    }
+    return reduce_avx2(acc) + sum_scalar(x + i, n - i);
+}
+
+EI_SIMD_AVX2 static inline float sum_of_squares_avx2(const float *x, size_t n) {
+    __m256 acc = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 a = _mm256_loadu_ps(x + i);
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(a, a));
+    }
+    return reduce_avx2(acc) + sum_of_squares_scalar(x + i, n - i);
+}
+
+EI_SIMD_AVX2 static inline float sum_of_squared_deviations_avx2(const float *x, size_t n, float mean) {
+    const __m256 vm = _mm256_set1_ps(mean);
+    __m256 acc = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 a = _mm256_sub_ps(_mm256_loadu_ps(x + i), vm);
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(a, a));
+    }
+    return reduce_avx2(acc) + sum_of_squared_deviations_scalar(x + i, n - i, mean);
+}
+
+EI_SIMD_AVX2 static inline float dot_avx2(const float *x, const float *y, size_t n) {
+    __m256 acc = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+    }
+    return reduce_avx2(acc) + dot_scalar(x + i, y + i, n - i);
+}
+
+static inline bool has_avx2() {
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+}
+
+#endif // EI_SIMD_X86
+
+#if EI_SIMD_NEON
+
+// ==================== NEON ====================
+// Same two-accumulator order as SSE2
+
+static inline float reduce_neon(float32x4_t lo, float32x4_t hi) {
+    const float32x4_t t = vaddq_f32(lo, hi);
+    return (vgetq_lane_f32(t, 0) + vgetq_lane_f32(t, 1)) + (vgetq_lane_f32(t, 2) + vgetq_lane_f32(t, 3));
+}
+
+static inline void scale_neon(float *x, size_t n, float k) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        vst1q_f32(x + i, vmulq_n_f32(vld1q_f32(x + i), k));
+    }
+    scale_scalar(x + i, n - i, k);
+}
+
+static inline void offset_neon(float *x, size_t n, float k) {
+    const float32x4_t vk = vdupq_n_f32(k);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        vst1q_f32(x + i, vaddq_f32(vld1q_f32(x + i), vk));
+    }
+    offset_scalar(x + i, n - i, k);
+}
+
+static inline float sum_neon(const float *x, size_t n) {
+    float32x4_t lo = vdupq_n_f32(0.0f), hi = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        lo = vaddq_f32(lo, vld1q_f32(x + i));
+        hi = vaddq_f32(hi, vld1q_f32(x + i + 4));
+    }
+    return reduce_neon(lo, hi) + sum_scalar(x + i, n - i);
+}
+
+static inline float sum_of_squares_neon(const float *x, size_t n) {
+    float32x4_t lo = vdupq_n_f32(0.0f), hi = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const float32x4_t a = vld1q_f32(x + i), b = vld1q_f32(x + i + 4);
+        lo = vaddq_f32(lo, vmulq_f32(a, a));
+        hi = vaddq_f32(hi, vmulq_f32(b, b));
+    }
+    return reduce_neon(lo, hi) + sum_of_squares_scalar(x + i, n - i);
+}
+
+static inline float sum_of_squared_deviations_neon(const float *x, size_t n, float mean) {
+    const float32x4_t vm = vdupq_n_f32(mean);
+    float32x4_t lo = vdupq_n_f32(0.0f), hi = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const float32x4_t a = vsubq_f32(vld1q_f32(x + i), vm), b = vsubq_f32(vld1q_f32(x + i + 4), vm);
+        lo = vaddq_f32(lo, vmulq_f32(a, a));
+        hi = vaddq_f32(hi, vmulq_f32(b, b));
+    }
+    return reduce_neon(lo, hi) + sum_of_squared_deviations_scalar(x + i, n - i, mean);
+}
+
+static inline float dot_neon(const float *x, const float *y, size_t n) {
+    float32x4_t lo = vdupq_n_f32(0.0f), hi = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        lo = vaddq_f32(lo, vmulq_f32(vld1q_f32(x + i), vld1q_f32(y + i)));
+        hi = vaddq_f32(hi, vmulq_f32(vld1q_f32(x + i + 4), vld1q_f32(y + i + 4)));
+    }
+    return reduce_neon(lo, hi) + dot_scalar(x + i, y + i, n - i);
+}
+
+#endif // EI_SIMD_NEON
+
+} // namespace detail
+
+// ==================== API ====================
+
+/**
+ * x[i] *= k
+ */
+static inline void scale(float *x, size_t n, float k) {
+#if EI_SIMD_CMSIS
+    arm_scale_f32(x, k, x, n);
+#elif EI_SIMD_X86
+    detail::has_avx2() ? detail::scale_avx2(x, n, k) : detail::scale_sse2(x, n, k);
+#elif EI_SIMD_NEON
+    detail::scale_neon(x, n, k);
+#else
+    detail::scale_scalar(x, n, k);
+#endif
+}
+
+/**
+ * x[i] += k
+ */
+static inline void offset(float *x, size_t n, float k) {
+#if EI_SIMD_CMSIS
+    arm_offset_f32(x, k, x, n);
+#elif EI_SIMD_X86
+    detail::has_avx2() ? detail::offset_avx2(x, n, k) : detail::offset_sse2(x, n, k);
+#elif EI_SIMD_NEON
+    detail::offset_neon(x, n, k);
+#else
+    detail::offset_scalar(x, n, k);
+#endif
+}
+
+/**
+ * Sum of x[i]
+ */
+static inline float sum(const float *x, size_t n) {
+#if EI_SIMD_X86
+    return detail::has_avx2() ? detail::sum_avx2(x, n) : detail::sum_sse2(x, n);
+#elif EI_SIMD_NEON
+    return detail::sum_neon(x, n);
+#else
+    // CMSIS has no plain sum (numpy::mean uses arm_mean_f32 directly)
+    return detail::sum_scalar(x, n);
+#endif
+}
+
+/**
+ * Sum of x[i] * x[i]
+ */
+static inline float sum_of_squares(const float *x, size_t n) {
+#if EI_SIMD_CMSIS
+    float power;
+    arm_power_f32(x, n, &power);
+    return power;
+#elif EI_SIMD_X86
+    return detail::has_avx2() ? detail::sum_of_squares_avx2(x, n) : detail::sum_of_squares_sse2(x, n);
+#elif EI_SIMD_NEON
+    return detail::sum_of_squares_neon(x, n);
+#else
+    return detail::sum_of_squares_scalar(x, n);
+#endif
+}
+
+/**
+ * Sum of (x[i] - mean)^2
+ */
+static inline float sum_of_squared_deviations(const float *x, size_t n, float mean) {
+#if EI_SIMD_X86
+    return detail::has_avx2() ? detail::sum_of_squared_deviations_avx2(x, n, mean)
+                              : detail::sum_of_squared_deviations_sse2(x, n, mean);
+#elif EI_SIMD_NEON
+    return detail::sum_of_squared_deviations_neon(x, n, mean);
+#else
+    // CMSIS builds compute the variance with cmsis_arm_variance instead
+    return detail::sum_of_squared_deviations_scalar(x, n, mean);
+#endif
+}
+
+/**
+ * Sum of x[i] * y[i]
+ */
+static inline float dot(const float *x, const float *y, size_t n) {
+#if EI_SIMD_CMSIS
+    float result;
+    arm_dot_prod_f32(x, y, n, &result);
+    return result;
+#elif EI_SIMD_X86
+    return detail::has_avx2() ? detail::dot_avx2(x, y, n) : detail::dot_sse2(x, y, n);
+#elif EI_SIMD_NEON
+    return detail::dot_neon(x, y, n);
+#else
+    return detail::dot_scalar(x, y, n);
+#endif
+}
+
+} // namespace simd
+} // namespace ei
+
+#endif // __EI_SIMD__H__
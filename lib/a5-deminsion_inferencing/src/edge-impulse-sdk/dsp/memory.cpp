@@ -32,3 +32,5 @@
 
 size_t ei_memory_in_use = 0;
 size_t ei_memory_peak_use = 0;
+size_t ei_memory_alloc_count = 0;
+size_t ei_memory_largest_alloc = 0;
@@ -41,11 +41,14 @@
 
 extern size_t ei_memory_in_use;
 extern size_t ei_memory_peak_use;
+// number of allocations and the largest single block, counted with in_use / peak
+extern size_t ei_memory_alloc_count;
+extern size_t ei_memory_largest_alloc;
 
 #if EIDSP_PRINT_ALLOCATIONS == 1
 #define ei_dsp_printf           printf
 #else
-#define ei_dsp_printf           (void)
+#define ei_dsp_printf(...)      (void)0
 #endif
 
 typedef std::unique_ptr<void, std::function<void(void*)>> ei_unique_ptr_t;
@@ -80,6 +83,10 @@ namespace ei {
         if (ei_memory_in_use > ei_memory_peak_use) { \
             ei_memory_peak_use = ei_memory_in_use; \
         } \
+        ei_memory_alloc_count++; \
+        if ((size_t)(bytes) > ei_memory_largest_alloc) { \
+            ei_memory_largest_alloc = (size_t)(bytes); \
+        } \
         ei_dsp_printf("alloc %lu bytes (in_use=%lu, peak=%lu) (%s@ %s:%d) %p\n", \
             (unsigned long)bytes, (unsigned long)ei_memory_in_use, (unsigned long)ei_memory_peak_use, fn, file, line, ptr);
 
@@ -95,6 +102,10 @@ namespace ei {
         if (ei_memory_in_use > ei_memory_peak_use) { \
             ei_memory_peak_use = ei_memory_in_use; \
         } \
+        ei_memory_alloc_count++; \
+        if ((size_t)(rows * cols * type_size) > ei_memory_largest_alloc) { \
+            ei_memory_largest_alloc = (size_t)(rows * cols * type_size); \
+        } \
         ei_dsp_printf("alloc matrix %lu x %lu = %lu bytes (in_use=%lu, peak=%lu) (%s@ %s:%d) %p\n", \
             (unsigned long)rows, (unsigned long)cols, (unsigned long)(rows * cols * type_size), (unsigned long)ei_memory_in_use, \
                 (unsigned long)ei_memory_peak_use, fn, file, line, ptr);
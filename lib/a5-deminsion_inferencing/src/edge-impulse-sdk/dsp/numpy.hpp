@@ -81,6 +81,7 @@
 #define EIDSP_INCLUDE_KISSFFT 1
 #include "edge-impulse-sdk/dsp/dsp_engines/ei_no_hw_dsp.h"
 #endif
+#include "ei_simd.h"
 
 // More decisions on kissfft
 #ifndef EIDSP_INCLUDE_KISSFFT
@@ -93,6 +94,39 @@
 
 #endif // EIDSP_INCLUDE_KISSFFT
 
+// No FFT hardware: every length runs on kissfft
+#if !EIDSP_USE_CEVA_DSP && !EIDSP_USE_CMSIS_DSP && !EIDSP_USE_ESP_DSP
+#define EIDSP_SOFTWARE_FFT 1
+#else
+#define EIDSP_SOFTWARE_FFT 0
+#endif
+
+// kissfft plans are made once per FFT length and kept (see numpy::software_rfft_plan)
+#ifndef EIDSP_FFT_PLAN_SLOTS
+#define EIDSP_FFT_PLAN_SLOTS 4
+#endif
+
+// Upper bound of a kiss_fftr plan: the two state structs (factor table included) plus the twiddles
+#define EIDSP_KISS_FFTR_PLAN_BYTES(n_fft) (512 + sizeof(kiss_fft_cpx) * ((n_fft) / 2 + (n_fft) * 3 / 4))
+
+// Static storage for the plans of the lengths the impulse declares, when they run on kissfft
+#if !defined(EIDSP_FFT_PLAN_POOL_BYTES) && EIDSP_SOFTWARE_FFT && EI_CLASSIFIER_HAS_FFT_INFO == 1 && \
+    !defined(EI_CLASSIFIER_LOAD_ALL_FFTS)
+#if EI_CLASSIFIER_LOAD_FFT_32 == 1 || EI_CLASSIFIER_LOAD_FFT_64 == 1 || EI_CLASSIFIER_LOAD_FFT_128 == 1 || \
+    EI_CLASSIFIER_LOAD_FFT_256 == 1 || EI_CLASSIFIER_LOAD_FFT_512 == 1 || EI_CLASSIFIER_LOAD_FFT_1024 == 1 || \
+    EI_CLASSIFIER_LOAD_FFT_2048 == 1 || EI_CLASSIFIER_LOAD_FFT_4096 == 1
+#define EIDSP_FFT_PLAN_POOL_BYTES ( \
+    (EI_CLASSIFIER_LOAD_FFT_32 == 1 ? EIDSP_KISS_FFTR_PLAN_BYTES(32) : 0) + \
+    (EI_CLASSIFIER_LOAD_FFT_64 == 1 ? EIDSP_KISS_FFTR_PLAN_BYTES(64) : 0) + \
+    (EI_CLASSIFIER_LOAD_FFT_128 == 1 ? EIDSP_KISS_FFTR_PLAN_BYTES(128) : 0) + \
+    (EI_CLASSIFIER_LOAD_FFT_256 == 1 ? EIDSP_KISS_FFTR_PLAN_BYTES(256) : 0) + \
+    (EI_CLASSIFIER_LOAD_FFT_512 == 1 ? EIDSP_KISS_FFTR_PLAN_BYTES(512) : 0) + \
+    (EI_CLASSIFIER_LOAD_FFT_1024 == 1 ? EIDSP_KISS_FFTR_PLAN_BYTES(1024) : 0) + \
+    (EI_CLASSIFIER_LOAD_FFT_2048 == 1 ? EIDSP_KISS_FFTR_PLAN_BYTES(2048) : 0) + \
+    (EI_CLASSIFIER_LOAD_FFT_4096 == 1 ? EIDSP_KISS_FFTR_PLAN_BYTES(4096) : 0))
+#endif
+#endif // EIDSP_FFT_PLAN_POOL_BYTES
+
 // For the following CMSIS includes, we want to use the C fallback, so include whether or not we set the CMSIS flag
 #include "edge-impulse-sdk/CMSIS/DSP/Include/dsp/statistics_functions.h"
 
@@ -788,9 +822,7 @@ public:
             return status;
         }
 #else
-        for (size_t ix = 0; ix < matrix->rows * matrix->cols; ix++) {
-            matrix->buffer[ix] *= scale;
-        }
+        simd::scale(matrix->buffer, matrix->rows * matrix->cols, scale);
 #endif
         return EIDSP_OK;
     }
@@ -829,9 +861,7 @@ public:
      * @returns 0 if OK
      */
     static int add(matrix_t *matrix, float addition) {
-        for (uint32_t ix = 0; ix < matrix->rows * matrix->cols; ix++) {
-            matrix->buffer[ix] += addition;
-        }
+        simd::offset(matrix->buffer, matrix->rows * matrix->cols, addition);
         return EIDSP_OK;
     }
 
@@ -868,9 +898,8 @@ public:
      * @returns 0 if OK
      */
     static int subtract(matrix_t *matrix, float subtraction) {
-        for (uint32_t ix = 0; ix < matrix->rows * matrix->cols; ix++) {
-            matrix->buffer[ix] -= subtraction;
-        }
+        // x + (-s) rounds exactly like x - s
+        simd::offset(matrix->buffer, matrix->rows * matrix->cols, -subtraction);
         return EIDSP_OK;
     }
 
@@ -921,11 +950,7 @@ public:
             arm_rms_f32(matrix->buffer + (row * matrix->cols), matrix->cols, &rms_result);
             output_matrix->buffer[row] = rms_result;
 #else
-            float sum = 0.0;
-            for(size_t ix = 0; ix < matrix->cols; ix++) {
-                float v = matrix->buffer[(row * matrix->cols) + ix];
-                sum += v * v;
-            }
+            float sum = simd::sum_of_squares(matrix->buffer + (row * matrix->cols), matrix->cols);
             output_matrix->buffer[row] = sqrt(sum / static_cast<float>(matrix->cols));
 #endif
         }
@@ -952,11 +977,7 @@ public:
             arm_mean_f32(input_matrix->buffer + (row * input_matrix->cols), input_matrix->cols, &mean);
             output_matrix->buffer[row] = mean;
 #else
-            float sum = 0.0f;
-
-            for (size_t col = 0; col < input_matrix->cols; col++) {
-                sum += input_matrix->buffer[( row * input_matrix->cols ) + col];
-            }
+            float sum = simd::sum(input_matrix->buffer + (row * input_matrix->cols), input_matrix->cols);
 
             output_matrix->buffer[row] = sum / input_matrix->cols;
 #endif
@@ -1134,21 +1155,10 @@ public:
             arm_sqrt_f32(var, &std);
             output_matrix->buffer[row] = std;
 #else
-            float sum = 0.0f;
-
-            for (size_t col = 0; col < input_matrix->cols; col++) {
-                sum += input_matrix->buffer[(row * input_matrix->cols) + col];
-            }
+            const float *row_buffer = input_matrix->buffer + (row * input_matrix->cols);
+            float mean = simd::sum(row_buffer, input_matrix->cols) / input_matrix->cols;
 
-            float mean = sum / input_matrix->cols;
-
-            float std = 0.0f;
-
-            for (size_t col = 0; col < input_matrix->cols; col++) {
-                float diff;
-                diff = input_matrix->buffer[(row * input_matrix->cols) + col] - mean;
-                std += diff * diff;
-            }
+            float std = simd::sum_of_squared_deviations(row_buffer, input_matrix->cols, mean);
 
             output_matrix->buffer[row] = sqrt(std / input_matrix->cols);
 #endif
@@ -1356,6 +1366,13 @@ public:
             src_size = n_fft;
         }
 
+#if EIDSP_SOFTWARE_FFT
+        // kissfft leaves its input alone, so a full frame needs no padded copy
+        if (src_size == n_fft) {
+            return software_rfft(src, output, n_fft, n_fft_out_features);
+        }
+#endif
+
         // Unfortunately, arm fft (at least) modifies the input buffer AND does not work in place
         // So we have to copy the input to a new buffer
         EI_DSP_MATRIX(fft_input, 1, n_fft);
@@ -1378,6 +1395,38 @@ public:
         return EIDSP_OK;
     }
 
+    /**
+     * Make the FFT plans for every length the impulse declares (EI_CLASSIFIER_LOAD_FFT_*),
+     * so the first window does not pay their setup. Optional: plans are also made on first use.
+     * @returns 0 if OK
+     */
+    static int init_fft_plans() {
+#if EI_CLASSIFIER_HAS_FFT_INFO == 1 && !defined(EI_CLASSIFIER_LOAD_ALL_FFTS)
+        const bool declared[] = {
+            EI_CLASSIFIER_LOAD_FFT_32 == 1, EI_CLASSIFIER_LOAD_FFT_64 == 1,
+            EI_CLASSIFIER_LOAD_FFT_128 == 1, EI_CLASSIFIER_LOAD_FFT_256 == 1,
+            EI_CLASSIFIER_LOAD_FFT_512 == 1, EI_CLASSIFIER_LOAD_FFT_1024 == 1,
+            EI_CLASSIFIER_LOAD_FFT_2048 == 1, EI_CLASSIFIER_LOAD_FFT_4096 == 1,
+        };
+        for (size_t ix = 0; ix < sizeof(declared) / sizeof(declared[0]); ix++) {
+            if (!declared[ix]) {
+                continue;
+            }
+            const size_t n_fft = (size_t)32 << ix;
+#if EIDSP_USE_CMSIS_DSP
+            if (!ei::fft::cmsis_rfft_plan(n_fft)) {
+                EIDSP_ERR(EIDSP_FFT_TABLE_NOT_LOADED);
+            }
+#elif EIDSP_SOFTWARE_FFT
+            if (!software_rfft_plan(n_fft)) {
+                EIDSP_ERR(EIDSP_OUT_OF_MEM);
+            }
+#endif
+        }
+#endif
+        return EIDSP_OK;
+    }
+
 
     /**
      * Return evenly spaced numbers over a specified interval.
@@ -1741,10 +1790,73 @@ public:
         return EIDSP_OK;
     }
 
-    static int software_rfft(float *fft_input, fft_complex_t *output, size_t n_fft, size_t n_fft_out_features)
+#if EIDSP_INCLUDE_KISSFFT || !defined(EIDSP_INCLUDE_KISSFFT)
+    /**
+     * kissfft plan for n_fft, made on first use and kept for the next windows. Plans of the
+     * lengths the impulse declares go to static storage, other lengths are allocated once.
+     * Not thread safe: the DSP runs on one thread.
+     * @returns The plan, or NULL if the cache is full or out of memory
+     */
+    static kiss_fftr_cfg software_rfft_plan(size_t n_fft)
+    {
+        struct plan_t {
+            size_t n_fft;
+            kiss_fftr_cfg cfg;
+        };
+        static plan_t plans[EIDSP_FFT_PLAN_SLOTS];
+        static size_t plan_count = 0;
+
+        for (size_t ix = 0; ix < plan_count; ix++) {
+            if (plans[ix].n_fft == n_fft) {
+                return plans[ix].cfg;
+            }
+        }
+        if (plan_count == EIDSP_FFT_PLAN_SLOTS) {
+            return NULL;
+        }
+
+        kiss_fftr_cfg cfg = NULL;
+#ifdef EIDSP_FFT_PLAN_POOL_BYTES
+        alignas(8) static uint8_t pool[EIDSP_FFT_PLAN_POOL_BYTES];
+        static size_t pool_used = 0;
+
+        // without a buffer kiss_fftr_alloc only reports the size it needs
+        size_t mem_length = 0;
+        kiss_fftr_alloc(n_fft, 0, NULL, &mem_length, NULL);
+        const size_t aligned_length = (mem_length + 7) & ~(size_t)7;
+        if (mem_length > 0 && pool_used + aligned_length <= sizeof(pool)) {
+            cfg = kiss_fftr_alloc(n_fft, 0, pool + pool_used, &mem_length, NULL);
+            if (cfg) {
+                pool_used += aligned_length;
+            }
+        }
+#endif
+        if (!cfg) {
+            size_t kiss_fftr_mem_length;
+            cfg = kiss_fftr_alloc(n_fft, 0, NULL, NULL, &kiss_fftr_mem_length);
+            if (!cfg) {
+                return NULL;
+            }
+            ei_dsp_register_alloc(kiss_fftr_mem_length, cfg);
+        }
+
+        plans[plan_count].n_fft = n_fft;
+        plans[plan_count].cfg = cfg;
+        plan_count++;
+        return cfg;
+    }
+#endif
+
+    static int software_rfft(const float *fft_input, fft_complex_t *output, size_t n_fft, size_t n_fft_out_features)
     {
     #if EIDSP_INCLUDE_KISSFFT || !defined(EIDSP_INCLUDE_KISSFFT)
-        // create fftr context
+        kiss_fftr_cfg plan = software_rfft_plan(n_fft);
+        if (plan) {
+            kiss_fftr(plan, fft_input, (kiss_fft_cpx*)output);
+            return EIDSP_OK;
+        }
+
+        // the plan cache is full: create a context for this call only
         size_t kiss_fftr_mem_length;
 
         kiss_fftr_cfg cfg = kiss_fftr_alloc(n_fft, 0, NULL, NULL, &kiss_fftr_mem_length);
@@ -2393,11 +2505,7 @@ public:
     }
 
     static float dot(const float* x, const float* y, size_t n) {
-        float res = 0;
-        for (size_t i = 0; i < n; i++) {
-            res += x[i] * y[i];
-        }
-        return res;
+        return simd::dot(x, y, n);
     }
 
 
@@ -0,0 +1,512 @@
+/*
+ * Copyright (c) 2024 EdgeImpulse Inc.
+ *
+ * Generated by Edge Impulse and licensed under the applicable Edge Impulse
+ * Terms of Service. Community and Professional Terms of Service
+ * (https://edgeimpulse.com/legal/terms-of-service) or Enterprise Terms of
+ * Service (https://edgeimpulse.com/legal/enterprise-terms-of-service),
+ * according to your product plan subscription (the “License”).
+ *
+ * This software, documentation and other associated files (collectively referred
+ * to as the “Software”) is a single SDK variation generated by the Edge Impulse
+ * platform and requires an active paid Edge Impulse subscription to use this
+ * Software for any purpose.
+ *
+ * You may NOT use this Software unless you have an active Edge Impulse subscription
+ * that meets the eligibility requirements for the applicable License, subject to
+ * your full and continued compliance with the terms and conditions of the License,
+ * including without limitation any usage restrictions under the applicable License.
+ *
+ * If you do not have an active Edge Impulse product plan subscription, or if use
+ * of this Software exceeds the usage limitations of your Edge Impulse product plan
+ * subscription, you are not permitted to use this Software and must immediately
+ * delete and erase all copies of this Software within your control or possession.
+ * Edge Impulse reserves all rights and remedies available to enforce its rights.
+ *
+ * Unless required by applicable law or agreed to in writing, the Software is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing
+ * permissions, disclaimers and limitations under the License.
+ */
+
+#ifndef _EIDSP_SPECTRAL_FEATURE_CONTINUOUS_H_
+#define _EIDSP_SPECTRAL_FEATURE_CONTINUOUS_H_
+
+#include <math.h>
+#include <string.h>
+#include "../numpy.hpp"
+#include "feature.hpp"
+
+namespace ei {
+namespace spectral {
+
+/**
+ * Incremental spectral analysis (FFT, implementation version 2 and 3) for
+ * run_classifier_continuous.
+ *
+ * feature::extract_spec_features filters the whole window, computes its
+ * statistics and the power spectrum of every Welch segment on each call. Here
+ * every slice only
+ *  - runs the Butterworth filter over its own samples; the filter state carries
+ *    over from slice to slice instead of restarting at the window start,
+ *  - adds its samples to (and removes the oldest from) running sums of x, x^2,
+ *    x^3 and x^4, from which RMS, skewness and kurtosis of the mean-removed
+ *    window follow,
+ *  - computes the power spectrum of the Welch segments that completed in the
+ *    slice. Spectra of older segments are kept until the window slides past.
+ * Per call only the trailing zero-padded segment and the max-hold over the
+ * kept spectra are redone, so the FFT work scales with the slice, not the
+ * window. Removing the window mean only changes bin 0 of a full segment, which
+ * is never a feature, so kept spectra stay valid while the mean moves.
+ *
+ * Without a filter the features equal the batch block's up to float rounding;
+ * with a filter they differ by the batch filter's start-up transient at the
+ * beginning of each window. The Welch segments must stay aligned with the
+ * window start: the window and every slice must be a multiple of the hop
+ * (fft_length / 2 with overlap, fft_length without). After an unaligned slice
+ * the features are computed over the kept window as in the batch block; other
+ * configurations (version 1 and 4, wavelets) are not incremental at all and
+ * only keep the window for the batch block (see
+ * extract_spectral_analysis_per_slice_features).
+ */
+class continuous_spectral_analysis {
+public:
+    continuous_spectral_analysis() { }
+
+    ~continuous_spectral_analysis() {
+        clear();
+    }
+
+    /**
+     * Whether a configuration can be computed incrementally
+     * @param config Spectral analysis block config
+     * @param window_frames Window length in frames (samples per axis)
+     */
+    static bool supports(const ei_dsp_config_spectral_analysis_t *config, size_t window_frames) {
+        if (config->implementation_version != 2 && config->implementation_version != 3) {
+            return false;
+        }
+        if (config->implementation_version == 3 &&
+                (!config->analysis_type || strcmp(config->analysis_type, "FFT") != 0)) {
+            return false;
+        }
+        const size_t fft_length = (size_t)config->fft_length;
+        if (fft_length < 2 || window_frames < fft_length) {
+            return false;
+        }
+        const size_t hop = config->do_fft_overlap ? fft_length / 2 : fft_length;
+        return fft_length % hop == 0 && window_frames % hop == 0;
+    }
+
+    /**
+     * Allocate the state for a block; nothing happens while the block stays the same.
+     * @param config Spectral analysis block config
+     * @param sampling_freq Sampling frequency of the signal
+     * @param window_frames Window length in frames (samples per axis)
+     * @returns 0 if OK
+     */
+    int configure(const ei_dsp_config_spectral_analysis_t *config, float sampling_freq, size_t window_frames) {
+        if (config == _config && window_frames == _window && sampling_freq == _sampling_freq) {
+            return EIDSP_OK;
+        }
+        clear();
+        if (config->axes <= 0 || window_frames == 0) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+        }
+        _config = config;
+        _sampling_freq = sampling_freq;
+        _window = window_frames;
+        _axes = (size_t)config->axes;
+        _incremental = supports(config, window_frames);
+
+        bool allocated = allocate(&_ring, _axes * _window);
+        if (_incremental) {
+            _fft_length = (size_t)config->fft_length;
+            _hop = config->do_fft_overlap ? _fft_length / 2 : _fft_length;
+            _segments = (_window - _fft_length) / _hop + 1;
+
+            bool is_high_pass = false;
+            bool do_filter = false;
+            if (strcmp(config->filter_type, "low") == 0) {
+                do_filter = true;
+            }
+            else if (strcmp(config->filter_type, "high") == 0) {
+                do_filter = true;
+                is_high_pass = true;
+            }
+            if (do_filter) {
+                feature::get_start_stop_bin(sampling_freq, _fft_length, config->filter_cutoff,
+                    &_start_bin, &_stop_bin, is_high_pass);
+                if (config->filter_order > 0) {
+                    _filter_steps = (size_t)config->filter_order / 2;
+                    _high_pass = is_high_pass;
+                }
+            }
+            else {
+                _start_bin = 1;
+                _stop_bin = _fft_length / 2 + 1;
+            }
+            _bins = _stop_bin - _start_bin;
+
+            allocated = allocated &&
+                allocate(&_spectra, _segments * _axes * _bins) &&
+                allocate(&_fft_in, _fft_length) &&
+                allocate(&_fft_out, _fft_length / 2 + 1) &&
+                allocate(&_moments, _axes * 4) &&
+                (_filter_steps == 0 || allocate(&_filter, _filter_steps * 3 + _axes * _filter_steps * 2));
+            if (allocated && _filter_steps > 0) {
+                init_filter();
+            }
+        }
+        if (!allocated) {
+            clear();
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+        return EIDSP_OK;
+    }
+
+    /**
+     * Free the state; the next configure() starts again from an empty window
+     */
+    void clear() {
+        release(&_ring, _axes * _window);
+        release(&_spectra, _segments * _axes * _bins);
+        release(&_fft_in, _fft_length);
+        release(&_fft_out, _fft_length / 2 + 1);
+        release(&_moments, _axes * 4);
+        release(&_filter, _filter_steps * 3 + _axes * _filter_steps * 2);
+        _config = nullptr;
+        _sampling_freq = 0.0f;
+        _window = _axes = 0;
+        _fft_length = _hop = _segments = _bins = _start_bin = _stop_bin = _filter_steps = 0;
+        _high_pass = false;
+        _incremental = false;
+        _frames = 0;
+    }
+
+    /**
+     * Append a slice (frame by frame, all axes of a frame next to each other)
+     * @param signal Slice; total_length must be a multiple of the axes
+     * @returns 0 if OK
+     */
+    int push(signal_t *signal) {
+        if (!_ring) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+        if (signal->total_length % _axes != 0) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+        }
+        const float scale = _config->scale_axes;
+        // read in small chunks so the slice needs no buffer of its own
+        float chunk[PUSH_CHUNK_VALUES];
+        const size_t frames_per_chunk = PUSH_CHUNK_VALUES / _axes;
+        if (frames_per_chunk == 0) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+        }
+        const size_t slice_frames = signal->total_length / _axes;
+        for (size_t frame = 0; frame < slice_frames; frame += frames_per_chunk) {
+            const size_t n = std::min(frames_per_chunk, slice_frames - frame);
+            int ret = signal->get_data(frame * _axes, n * _axes, chunk);
+            if (ret != 0) {
+                EIDSP_ERR(ret);
+            }
+            for (size_t f = 0; f < n; f++) {
+                if (_incremental) {
+                    EI_TRY(push_frame(chunk + f * _axes, scale));
+                }
+                else {
+                    // batch block: keep the signal as it came in, the block scales it itself
+                    const size_t pos = (size_t)(_frames % _window);
+                    for (size_t a = 0; a < _axes; a++) {
+                        _ring[a * _window + pos] = chunk[f * _axes + a];
+                    }
+                    _frames++;
+                }
+            }
+        }
+        return EIDSP_OK;
+    }
+
+    /**
+     * Whether a full window has been pushed since the last clear()
+     */
+    bool window_full() const {
+        return _frames >= _window;
+    }
+
+    /**
+     * Whether the block runs incrementally (see supports())
+     */
+    bool incremental() const {
+        return _incremental;
+    }
+
+    /**
+     * Number of frames pushed since the last clear()
+     */
+    uint64_t frames() const {
+        return _frames;
+    }
+
+    /**
+     * Read the window in the batch block's layout: oldest frame first, all axes of a frame
+     * next to each other. In incremental mode the samples are scaled and filtered.
+     */
+    int get_window_data(size_t offset, size_t length, float *out_ptr) const {
+        const size_t oldest = (size_t)(_frames % _window);
+        for (size_t i = 0; i < length; i++) {
+            const size_t ix = offset + i;
+            const size_t frame = ix / _axes;
+            const size_t axis = ix % _axes;
+            out_ptr[i] = _ring[axis * _window + (oldest + frame) % _window];
+        }
+        return EIDSP_OK;
+    }
+
+    /**
+     * Features of the current window, laid out as feature::extract_spec_features does
+     * (per axis: RMS, skewness, kurtosis, then the spectral power bins). Incremental mode only.
+     * @param output_matrix Output, needs 1 row and axes * (3 + bins) columns
+     * @returns 0 if OK
+     */
+    int extract(matrix_t *output_matrix) {
+        if (!_incremental || !window_full()) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+        }
+        if (output_matrix->rows * output_matrix->cols != _axes * (3 + _bins)) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+        if (_frames % _hop != 0) {
+            // the kept spectra sit on another segment grid than this window
+            return extract_from_window(output_matrix);
+        }
+
+        float *feature_out = output_matrix->buffer;
+        for (size_t a = 0; a < _axes; a++) {
+            float mean;
+            write_stats(a, &mean, feature_out);
+            feature_out += 3;
+
+            // max-hold over the full segments of the window...
+            memset(feature_out, 0, _bins * sizeof(float));
+            for (size_t s = 0; s < _segments; s++) {
+                const float *spectrum = _spectra + (s * _axes + a) * _bins;
+                for (size_t i = 0; i < _bins; i++) {
+                    feature_out[i] = std::max(feature_out[i], spectrum[i]);
+                }
+            }
+            // ...and the trailing, zero-padded ones, which change with every slice
+            const float *ring = _ring + a * _window;
+            const size_t oldest = (size_t)(_frames % _window);
+            for (size_t start = _segments * _hop; start < _window; start += _hop) {
+                const size_t n = _window - start;
+                for (size_t i = 0; i < n; i++) {
+                    _fft_in[i] = ring[(oldest + start + i) % _window] - mean;
+                }
+                EI_TRY(numpy::power_spectrum(_fft_in, n, _fft_out, _fft_length / 2 + 1, _fft_length));
+                for (size_t i = 0; i < _bins; i++) {
+                    feature_out[i] = std::max(feature_out[i], _fft_out[_start_bin + i]);
+                }
+            }
+            if (_config->do_log) {
+                numpy::zero_handling(feature_out, _bins);
+                ei_matrix temp(_bins, 1, feature_out);
+                numpy::log10(&temp);
+            }
+            feature_out += _bins;
+        }
+        return EIDSP_OK;
+    }
+
+private:
+    static const size_t PUSH_CHUNK_VALUES = 96;
+
+    // the running sums are recomputed from the window once per window length,
+    // so adding and removing samples cannot drift
+    int push_frame(const float *values, float scale) {
+        const size_t pos = (size_t)(_frames % _window);
+        const bool full = window_full();
+        for (size_t a = 0; a < _axes; a++) {
+            float x = values[a] * scale;
+            if (_filter_steps > 0) {
+                x = filter(a, x);
+            }
+            float *slot = _ring + a * _window + pos;
+            double *m = _moments + a * 4;
+            if (full) {
+                const double old = *slot;
+                m[0] -= old;
+                m[1] -= old * old;
+                m[2] -= old * old * old;
+                m[3] -= old * old * old * old;
+            }
+            *slot = x;
+            const double v = x;
+            m[0] += v;
+            m[1] += v * v;
+            m[2] += v * v * v;
+            m[3] += v * v * v * v;
+        }
+        _frames++;
+
+        if (_frames % _window == 0) {
+            recompute_moments();
+        }
+        if (_frames >= _fft_length && (_frames - _fft_length) % _hop == 0) {
+            EI_TRY(compute_segment());
+        }
+        return EIDSP_OK;
+    }
+
+    void recompute_moments() {
+        for (size_t a = 0; a < _axes; a++) {
+            double *m = _moments + a * 4;
+            m[0] = m[1] = m[2] = m[3] = 0.0;
+            const float *ring = _ring + a * _window;
+            for (size_t i = 0; i < _window; i++) {
+                const double v = ring[i];
+                m[0] += v;
+                m[1] += v * v;
+                m[2] += v * v * v;
+                m[3] += v * v * v * v;
+            }
+        }
+    }
+
+    /**
+     * Power spectrum of the segment that just completed (the last fft_length frames),
+     * stored over the oldest kept segment
+     */
+    int compute_segment() {
+        const size_t segment = (size_t)((_frames - _fft_length) / _hop) % _segments;
+        const size_t end = (size_t)(_frames % _window);
+        const size_t count = (size_t)std::min<uint64_t>(_frames, _window);
+        for (size_t a = 0; a < _axes; a++) {
+            // the mean only moves bin 0; removing the current one keeps the float FFT well scaled
+            const float mean = (float)(_moments[a * 4] / count);
+            const float *ring = _ring + a * _window;
+            for (size_t i = 0; i < _fft_length; i++) {
+                _fft_in[i] = ring[(end + _window - _fft_length + i) % _window] - mean;
+            }
+            EI_TRY(numpy::power_spectrum(_fft_in, _fft_length, _fft_out, _fft_length / 2 + 1, _fft_length));
+            memcpy(_spectra + (segment * _axes + a) * _bins, _fft_out + _start_bin, _bins * sizeof(float));
+        }
+        return EIDSP_OK;
+    }
+
+    /**
+     * RMS, skewness and kurtosis of the mean-removed window from the running sums,
+     * with the batch block's definitions (Fisher kurtosis, 1e-10 for a flat signal)
+     */
+    void write_stats(size_t axis, float *out_mean, float *out) const {
+        const double *m = _moments + axis * 4;
+        const double n = (double)_window;
+        const double mean = m[0] / n;
+        const double e2 = m[1] / n, e3 = m[2] / n, e4 = m[3] / n;
+        double var = e2 - mean * mean;
+        if (var < 0.0) {
+            var = 0.0;
+        }
+        const double m3 = e3 - 3.0 * mean * e2 + 2.0 * mean * mean * mean;
+        const double m4 = e4 - 4.0 * mean * e3 + 6.0 * mean * mean * e2 - 3.0 * mean * mean * mean * mean;
+        const float rms = (float)sqrt(var);
+        float stddev = rms == 0.0f ? 1e-10f : rms;
+        const float cube = stddev * stddev * stddev;
+        out[0] = rms;
+        out[1] = (float)m3 / cube;
+        out[2] = ((float)m4 / (cube * stddev)) - 3;
+        *out_mean = (float)mean;
+    }
+
+    /**
+     * Batch features over the kept (already scaled and filtered) window
+     */
+    int extract_from_window(matrix_t *output_matrix) {
+        EI_DSP_MATRIX(window, _axes, _window);
+        for (size_t a = 0; a < _axes; a++) {
+            const float *ring = _ring + a * _window;
+            const size_t oldest = (size_t)(_frames % _window);
+            for (size_t i = 0; i < _window; i++) {
+                window.buffer[a * _window + i] = ring[(oldest + i) % _window];
+            }
+        }
+        // the kept window is filtered already; a zero order filter still selects the bins
+        ei_dsp_config_spectral_analysis_t config = *_config;
+        config.filter_order = 0;
+        size_t n_features = feature::extract_spec_features(&window, output_matrix, &config, _sampling_freq,
+            true, false);
+        return n_features == output_matrix->cols ? EIDSP_OK : EIDSP_MATRIX_SIZE_MISMATCH;
+    }
+
+    /**
+     * Coefficients as in filters::butterworth_lowpass / butterworth_highpass,
+     * followed by the per-axis section state (w1, w2)
+     */
+    void init_filter() {
+        const int order = _config->filter_order;
+        const float a = tan(M_PI * _config->filter_cutoff / _sampling_freq);
+        const float a2 = pow(a, 2);
+        for (size_t ix = 0; ix < _filter_steps; ix++) {
+            const float r = sin(M_PI * ((2.0 * ix) + 1.0) / (2.0 * order));
+            const float norm = a2 + (2.0 * a * r) + 1.0;
+            _filter[ix * 3] = _high_pass ? 1.0f / norm : a2 / norm;
+            _filter[ix * 3 + 1] = 2.0 * (1 - a2) / norm;
+            _filter[ix * 3 + 2] = -(a2 - (2.0 * a * r) + 1.0) / norm;
+        }
+    }
+
+    float filter(size_t axis, float x) {
+        float *w = _filter + _filter_steps * 3 + axis * _filter_steps * 2;
+        for (size_t i = 0; i < _filter_steps; i++) {
+            const float *c = _filter + i * 3;
+            const float w1 = w[i * 2], w2 = w[i * 2 + 1];
+            const float w0 = c[1] * w1 + c[2] * w2 + x;
+            x = _high_pass ? c[0] * (w0 - (2.0 * w1) + w2) : c[0] * (w0 + (2.0 * w1) + w2);
+            w[i * 2 + 1] = w1;
+            w[i * 2] = w0;
+        }
+        return x;
+    }
+
+    template <typename T>
+    static bool allocate(T **ptr, size_t count) {
+        *ptr = (T *)ei_dsp_calloc(count, sizeof(T));
+        return *ptr != nullptr;
+    }
+
+    template <typename T>
+    static void release(T **ptr, size_t count) {
+        if (*ptr) {
+            ei_dsp_free(*ptr, count * sizeof(T));
+            *ptr = nullptr;
+        }
+    }
+
+    const ei_dsp_config_spectral_analysis_t *_config = nullptr;
+    float _sampling_freq = 0.0f;
+    size_t _window = 0;         // frames per window
+    size_t _axes = 0;
+    bool _incremental = false;
+    uint64_t _frames = 0;       // frames pushed since clear()
+
+    size_t _fft_length = 0;
+    size_t _hop = 0;            // Welch segment step
+    size_t _segments = 0;       // full segments in a window
+    size_t _start_bin = 0;
+    size_t _stop_bin = 0;
+    size_t _bins = 0;
+    size_t _filter_steps = 0;   // second order sections, 0 = no filter
+    bool _high_pass = false;
+
+    float *_ring = nullptr;     // per axis, _window samples
+    float *_spectra = nullptr;  // per kept segment and axis, _bins powers
+    float *_fft_in = nullptr;
+    float *_fft_out = nullptr;
+    double *_moments = nullptr; // per axis: sum of x, x^2, x^3, x^4 over the window
+    float *_filter = nullptr;   // coefficients (A, d1, d2) per section, then state
+};
+
+} // namespace spectral
+} // namespace ei
+
+#endif // _EIDSP_SPECTRAL_FEATURE_CONTINUOUS_H_
@@ -41,6 +41,21 @@ MicroResourceVariables* MicroResourceVariables::Create(
   return variables;
 }
 
+MicroResourceVariables* MicroResourceVariables::Create(
+    TfLiteContext* context, int max_num_variables) {
+  TFLITE_DCHECK(context != nullptr);
+
+  uint8_t* buffer = static_cast<uint8_t*>(context->AllocatePersistentBuffer(
+      context, sizeof(MicroResourceVariables)));
+  MicroResourceVariable* variable_array =
+      static_cast<MicroResourceVariable*>(context->AllocatePersistentBuffer(
+          context, sizeof(MicroResourceVariable) * max_num_variables));
+  if (buffer == nullptr || variable_array == nullptr) {
+    return nullptr;
+  }
+  return new (buffer) MicroResourceVariables(variable_array, max_num_variables);
+}
+
 int MicroResourceVariables::CreateIdIfNoneFound(const char* container,
                                                 const char* shared_name) {
   int resource_id = FindId(container, shared_name);
@@ -29,6 +29,12 @@ class MicroResourceVariables {
   static MicroResourceVariables* Create(MicroAllocator* allocator,
                                         int num_variables);
 
+  // Create from the persistent buffers of a context (compiled EON graphs, which
+  // have no MicroAllocator): the variables live as long as the graph stays
+  // initialized.
+  static MicroResourceVariables* Create(TfLiteContext* context,
+                                        int num_variables);
+
   // Creates a resource variable if none is available for the given container
   // and shared name pair. Returns the resource ID corresponding to the
   // container and shared name pair. If allocation fails, the returned resource
@@ -129,6 +129,7 @@
 #define EI_CLASSIFIER_HAS_VISUAL_ANOMALY            0
 #define EI_CLASSIFIER_HAS_MODEL_VARIABLES           1
 #define EI_CLASSIFIER_HAS_DATA_NORMALIZATION        0
+#define EI_CLASSIFIER_DSP_RAW_IDENTITY              1
 #define EI_CLASSIFIER_CALIBRATION_ENABLED           0
 #define EI_CLASSIFIER_OBJECT_TRACKING_ENABLED       0
 #define EI_CLASSIFIER_TFLITE_LARGEST_ARENA_SIZE     5574
@@ -78,6 +78,8 @@ const ei_config_tflite_eon_graph_t ei_config_graph_792000_36 = {
     .model_reset = &tflite_learn_792000_36_reset,
     .model_input = &tflite_learn_792000_36_input,
     .model_output = &tflite_learn_792000_36_output,
+    .model_initialized = &tflite_learn_792000_36_initialized,
+    .model_reset_state = &tflite_learn_792000_36_reset_state,
 };
 
 const uint8_t ei_output_tensors_indices_792000_36[1] = { 0 };
@@ -32,10 +32,12 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <new>
 #include "edge-impulse-sdk/tensorflow/lite/c/builtin_op_data.h"
 #include "edge-impulse-sdk/tensorflow/lite/c/common.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/micro_mutable_op_resolver.h"
 #include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+#include "tflite-model/tflite_learn_792000_36_compiled.h"
 
 #if EI_CLASSIFIER_PRINT_STATE
 #if defined(__cplusplus) && EI_C_LINKAGE == 1
@@ -93,7 +95,10 @@ using namespace tflite::ops::micro;
 
 namespace {
 
-#if defined(EI_CLASSIFIER_ALLOCATION_STATIC_HIMAX) || defined(EI_CLASSIFIER_ALLOCATION_STATIC_HIMAX_GNU)
+#if defined(EI_TENSOR_ARENA_SIZE)
+// Arena size chosen by the build, e.g. the minimum reported by an EI_ARENA_RECORDING build
+constexpr int kTensorArenaSize = EI_TENSOR_ARENA_SIZE;
+#elif defined(EI_CLASSIFIER_ALLOCATION_STATIC_HIMAX) || defined(EI_CLASSIFIER_ALLOCATION_STATIC_HIMAX_GNU)
 constexpr int kTensorArenaSize = 2704;
 #else
 constexpr int kTensorArenaSize = 1680;
@@ -118,6 +123,17 @@ uint8_t* tensor_arena = NULL;
 
 static uint8_t* tensor_boundary;
 static uint8_t* current_location;
+static bool arena_initialized = false;
+
+// VAR_HANDLE ops in the graph: their variables live in persistent buffers of
+// the arena and keep their values from one invoke to the next.
+#define EON_RESOURCE_VARIABLE_COUNT 0
+#if EON_RESOURCE_VARIABLE_COUNT > 0
+static MicroResourceVariables* resource_variables = nullptr;
+// Resource tensors point at the id held by their VAR_HANDLE op; the eval
+// tensors are rebuilt for every node, so the pointers are kept here.
+static void* resource_handles[20];
+#endif
 
 template <int SZ, class T> struct TfArray {
   int sz; T elem[SZ];
@@ -263,7 +279,9 @@ const TfArray<1, int> outputs8 = { 1, { 19 } };
 };
 
 TensorInfo_t tensorData[] = {
-{ kTfLiteArenaRw, kTfLiteInt8, (int32_t*)(tensor_arena + 80), (TfLiteIntArray*)&g0::tensor_dimension0, 72, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&g0::quant0))}, },
+// the input shares its bytes with the RESHAPE output (tensor 11): the input is dead once RESHAPE
+// has run, and RESHAPE skips its copy when input and output alias
+{ kTfLiteArenaRw, kTfLiteInt8, (int32_t*)(tensor_arena + 0), (TfLiteIntArray*)&g0::tensor_dimension0, 72, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&g0::quant0))}, },
 { kTfLiteMmapRo, kTfLiteInt32, (int32_t*)g0::tensor_data1, (TfLiteIntArray*)&g0::tensor_dimension1, 16, {kTfLiteNoQuantization, nullptr}, },
 { kTfLiteMmapRo, kTfLiteInt32, (int32_t*)g0::tensor_data2, (TfLiteIntArray*)&g0::tensor_dimension1, 16, {kTfLiteNoQuantization, nullptr}, },
 { kTfLiteMmapRo, kTfLiteInt32, (int32_t*)g0::tensor_data3, (TfLiteIntArray*)&g0::tensor_dimension1, 16, {kTfLiteNoQuantization, nullptr}, },
@@ -314,6 +332,17 @@ TfLiteNode tflNodes[9] = {
 used_operators_e used_ops[] =
 {OP_RESHAPE, OP_CONV_2D, OP_RESHAPE, OP_MAX_POOL_2D, OP_RESHAPE, OP_CONV_2D, OP_RESHAPE, OP_FULLY_CONNECTED, OP_SOFTMAX, };
 
+// Nodes set up and run by init / prepare / invoke: all of them, or all but the
+// trailing SOFTMAX (see tflite_learn_792000_36_skip_softmax)
+static size_t active_nodes = 9;
+
+#if EI_CLASSIFIER_EON_PROFILER
+const char* const used_op_names[OP_LAST] =
+{"RESHAPE", "CONV_2D", "MAX_POOL_2D", "FULLY_CONNECTED", "SOFTMAX", };
+
+tflite::MicroProfilerInterface* profiler = nullptr;
+#endif
+
 
 // Indices into tflTensors and tflNodes for subgraphs
 const size_t tflTensors_subgraph_index[] = {0, 20, };
@@ -387,6 +416,23 @@ static void init_tflite_eval_tensor(int i, TfLiteEvalTensor *tensor) {
 
 static void* overflow_buffers[EI_MAX_OVERFLOW_BUFFER_COUNT];
 static size_t overflow_buffers_ix = 0;
+
+#if EI_ARENA_RECORDING
+// Every buffer taken from the arena or the heap since the last init, by kind
+static tflite_learn_792000_36_recorded_allocation_t recorded_persistent;
+static tflite_learn_792000_36_recorded_allocation_t recorded_scratch;
+static tflite_learn_792000_36_recorded_allocation_t recorded_overflow;
+// Where the next arena allocation is recorded; scratch requests switch it around their allocation
+static tflite_learn_792000_36_recorded_allocation_t* recording_bucket = &recorded_persistent;
+
+static void RecordAllocation(tflite_learn_792000_36_recorded_allocation_t* bucket, size_t requested_bytes,
+                             size_t used_bytes) {
+  bucket->requested_bytes += requested_bytes;
+  bucket->used_bytes += used_bytes;
+  bucket->count++;
+}
+#endif // EI_ARENA_RECORDING
+
 static void * AllocatePersistentBufferImpl(struct TfLiteContext* ctx,
                                        size_t bytes) {
   void *ptr;
@@ -407,9 +453,16 @@ static void * AllocatePersistentBufferImpl(struct TfLiteContext* ctx,
       return NULL;
     }
     overflow_buffers[overflow_buffers_ix++] = ptr;
+#if EI_ARENA_RECORDING
+    // In an arena large enough it would have taken its size rounded up to the alignment
+    RecordAllocation(&recorded_overflow, bytes, bytes + align_bytes);
+#endif
     return ptr;
   }
 
+#if EI_ARENA_RECORDING
+  uint8_t* const previous_location = current_location;
+#endif
   current_location -= bytes;
 
   // align to the left aligned boundary of 16 bytes
@@ -418,6 +471,9 @@ static void * AllocatePersistentBufferImpl(struct TfLiteContext* ctx,
 
   ptr = current_location;
   memset(ptr, 0, bytes);
+#if EI_ARENA_RECORDING
+  RecordAllocation(recording_bucket, bytes, (size_t)(previous_location - current_location));
+#endif
 
   return ptr;
 }
@@ -441,7 +497,13 @@ static TfLiteStatus RequestScratchBufferInArenaImpl(struct TfLiteContext* ctx, s
   scratch_buffer_t b;
   b.bytes = bytes;
 
+#if EI_ARENA_RECORDING
+  recording_bucket = &recorded_scratch;
+#endif
   b.ptr = AllocatePersistentBufferImpl(ctx, b.bytes);
+#if EI_ARENA_RECORDING
+  recording_bucket = &recorded_persistent;
+#endif
   if (!b.ptr) {
     ei_printf("ERR: Failed to allocate scratch buffer of size %d\n",
       (int)bytes);
@@ -470,6 +532,11 @@ static void ResetTensors() {
     tflTensors[ix].index = TENSOR_IX_UNUSED;
   }
   for (size_t ix = 0; ix < MAX_TFL_EVAL_COUNT; ix++) {
+#if EON_RESOURCE_VARIABLE_COUNT > 0
+    if (tflEvalTensors[ix].index != TENSOR_IX_UNUSED && tflEvalTensors[ix].tensor.type == kTfLiteResource) {
+      resource_handles[tflEvalTensors[ix].index] = tflEvalTensors[ix].tensor.data.data;
+    }
+#endif
     tflEvalTensors[ix].index = TENSOR_IX_UNUSED;
   }
 }
@@ -511,6 +578,11 @@ static TfLiteEvalTensor* GetEvalTensorImpl(const struct TfLiteContext* context,
     if (tflEvalTensors[ix].index == TENSOR_IX_UNUSED) {
       // init the tensor
       init_tflite_eval_tensor(tensor_idx, &tflEvalTensors[ix].tensor);
+#if EON_RESOURCE_VARIABLE_COUNT > 0
+      if (tflEvalTensors[ix].tensor.type == kTfLiteResource && resource_handles[tensor_idx]) {
+        tflEvalTensors[ix].tensor.data.data = resource_handles[tensor_idx];
+      }
+#endif
       tflEvalTensors[ix].index = tensor_idx;
       return &tflEvalTensors[ix].tensor;
     }
@@ -523,7 +595,7 @@ static TfLiteEvalTensor* GetEvalTensorImpl(const struct TfLiteContext* context,
 class EonMicroContext : public MicroContext {
  public:
  
-  EonMicroContext(): MicroContext(nullptr, nullptr, nullptr) { }
+  explicit EonMicroContext(MicroGraph* graph): MicroContext(nullptr, nullptr, graph) { }
 
   void* AllocatePersistentBuffer(size_t bytes) {
     return AllocatePersistentBufferImpl(nullptr, bytes);
@@ -556,10 +628,20 @@ class EonMicroContext : public MicroContext {
 
 };
 
+// Kernels reach the context (and the graph's resource variables) through
+// ctx.impl_ during invoke too, so both outlive init.
+alignas(EonMicroContext) static uint8_t micro_context_storage[sizeof(EonMicroContext)];
+#if EON_RESOURCE_VARIABLE_COUNT > 0
+alignas(MicroGraph) static uint8_t micro_graph_storage[sizeof(MicroGraph)];
+#endif
 
 } // namespace
 
 TfLiteStatus tflite_learn_792000_36_init( void*(*alloc_fnc)(size_t,size_t) ) {
+  // already initialized: keep the graph, its buffers and its variables
+  if (arena_initialized) {
+    return kTfLiteOk;
+  }
 #ifdef EI_CLASSIFIER_ALLOCATION_HEAP
   tensor_arena = (uint8_t*) alloc_fnc(16, kTensorArenaSize);
   if (!tensor_arena) {
@@ -571,11 +653,12 @@ TfLiteStatus tflite_learn_792000_36_init( void*(*alloc_fnc)(size_t,size_t) ) {
 #endif
   tensor_boundary = tensor_arena;
   current_location = tensor_arena + kTensorArenaSize;
+#if EI_ARENA_RECORDING
+  recorded_persistent = {};
+  recorded_scratch = {};
+  recorded_overflow = {};
+#endif
 
-  EonMicroContext micro_context_;
-  
-  // Set microcontext as the context ptr
-  ctx.impl_ = static_cast<void*>(&micro_context_);
   // Setup tflitecontext functions
   ctx.AllocatePersistentBuffer = &AllocatePersistentBufferImpl;
   ctx.RequestScratchBufferInArena = &RequestScratchBufferInArenaImpl;
@@ -601,6 +684,22 @@ TfLiteStatus tflite_learn_792000_36_init( void*(*alloc_fnc)(size_t,size_t) ) {
     return kTfLiteError;
   }
 
+#if EON_RESOURCE_VARIABLE_COUNT > 0
+  memset(resource_handles, 0, sizeof(resource_handles));
+  resource_variables = MicroResourceVariables::Create(&ctx, EON_RESOURCE_VARIABLE_COUNT);
+  if (!resource_variables) {
+    ei_printf("ERR: failed to allocate resource variables\n");
+    return kTfLiteError;
+  }
+  MicroGraph* micro_graph_ = new (micro_graph_storage) MicroGraph(&ctx, nullptr, nullptr, resource_variables);
+#else
+  MicroGraph* micro_graph_ = nullptr;
+#endif
+  EonMicroContext* micro_context_ = new (micro_context_storage) EonMicroContext(micro_graph_);
+
+  // Set microcontext as the context ptr
+  ctx.impl_ = static_cast<void*>(micro_context_);
+
   registrations[OP_RESHAPE] = Register_RESHAPE();
   registrations[OP_CONV_2D] = Register_CONV_2D();
   registrations[OP_MAX_POOL_2D] = Register_MAX_POOL_2D();
@@ -609,7 +708,7 @@ TfLiteStatus tflite_learn_792000_36_init( void*(*alloc_fnc)(size_t,size_t) ) {
 
   for (size_t g = 0; g < 1; ++g) {
     current_subgraph_index = g;
-    for(size_t i = tflNodes_subgraph_index[g]; i < tflNodes_subgraph_index[g+1]; ++i) {
+    for(size_t i = tflNodes_subgraph_index[g]; i < tflNodes_subgraph_index[g+1] && i < active_nodes; ++i) {
       if (registrations[used_ops[i]].init) {
         tflNodes[i].user_data = registrations[used_ops[i]].init(&ctx, (const char*)tflNodes[i].builtin_data, 0);
       }
@@ -619,7 +718,7 @@ TfLiteStatus tflite_learn_792000_36_init( void*(*alloc_fnc)(size_t,size_t) ) {
 
   for(size_t g = 0; g < 1; ++g) {
     current_subgraph_index = g;
-    for(size_t i = tflNodes_subgraph_index[g]; i < tflNodes_subgraph_index[g+1]; ++i) {
+    for(size_t i = tflNodes_subgraph_index[g]; i < tflNodes_subgraph_index[g+1] && i < active_nodes; ++i) {
       if (registrations[used_ops[i]].prepare) {
         ResetTensors();
         TfLiteStatus status = registrations[used_ops[i]].prepare(&ctx, &tflNodes[i]);
@@ -631,6 +730,33 @@ TfLiteStatus tflite_learn_792000_36_init( void*(*alloc_fnc)(size_t,size_t) ) {
   }
   current_subgraph_index = 0;
 
+  arena_initialized = true;
+  return kTfLiteOk;
+}
+
+bool tflite_learn_792000_36_initialized() {
+  return arena_initialized;
+}
+
+TfLiteStatus tflite_learn_792000_36_reset_state() {
+  if (!arena_initialized) {
+    return kTfLiteError;
+  }
+#if EON_RESOURCE_VARIABLE_COUNT > 0
+  return resource_variables->ResetAll();
+#else
+  return kTfLiteOk;
+#endif
+}
+
+TfLiteStatus tflite_learn_792000_36_skip_softmax(bool skip, int* logits_tensor) {
+  if (arena_initialized || used_ops[9 - 1] != OP_SOFTMAX) {
+    return kTfLiteError;
+  }
+  active_nodes = skip ? 9 - 1 : 9;
+  if (logits_tensor) {
+    *logits_tensor = tflNodes[9 - 1].inputs->data[0];
+  }
   return kTfLiteOk;
 }
 
@@ -644,11 +770,161 @@ TfLiteStatus tflite_learn_792000_36_output(int index, TfLiteTensor *tensor) {
   return kTfLiteOk;
 }
 
+TfLiteStatus tflite_learn_792000_36_tensor(int index, TfLiteTensor *tensor) {
+  if (index < 0 || index >= (int)(sizeof(tensorData) / sizeof(tensorData[0]))) {
+    return kTfLiteError;
+  }
+  init_tflite_tensor(index, tensor);
+  return kTfLiteOk;
+}
+
+namespace {
+// Built-in data / quantization of every tensor, saved before the first override.
+const int kTensorCount = (int)(sizeof(tensorData) / sizeof(tensorData[0]));
+void* builtin_data[kTensorCount];
+TfLiteQuantization builtin_quantization[kTensorCount];
+bool builtin_saved = false;
+struct OverrideQuantization {
+  TfArray<1, float> scale;
+  TfArray<1, int> zero_point;
+  TfLiteAffineQuantization params;
+};
+OverrideQuantization override_quantization[kTensorCount];
+}
+
+TfLiteStatus tflite_learn_792000_36_override_tensor(int index, const void* data, const float* scale,
+                                                    const int32_t* zero_point) {
+  if (index < 0 || index >= kTensorCount || arena_initialized) {
+    return kTfLiteError;
+  }
+  if (data && tensorData[index].allocation_type != kTfLiteMmapRo) {
+    return kTfLiteError;
+  }
+  if ((scale || zero_point) && tensorData[index].quantization.type != kTfLiteAffineQuantization) {
+    return kTfLiteError;
+  }
+  if (!builtin_saved) {
+    for (int i = 0; i < kTensorCount; i++) {
+      builtin_data[i] = tensorData[i].data;
+      builtin_quantization[i] = tensorData[i].quantization;
+    }
+    builtin_saved = true;
+  }
+  if (data) {
+    tensorData[index].data = const_cast<void*>(data);
+  }
+  if (scale || zero_point) {
+    const TfLiteAffineQuantization* current =
+        (const TfLiteAffineQuantization*)tensorData[index].quantization.params;
+    OverrideQuantization& q = override_quantization[index];
+    q.scale.sz = 1;
+    q.scale.elem[0] = scale ? *scale : current->scale->data[0];
+    q.zero_point.sz = 1;
+    q.zero_point.elem[0] = zero_point ? *zero_point : current->zero_point->data[0];
+    q.params.scale = (TfLiteFloatArray*)&q.scale;
+    q.params.zero_point = (TfLiteIntArray*)&q.zero_point;
+    q.params.quantized_dimension = 0;
+    tensorData[index].quantization.params = &q.params;
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus tflite_learn_792000_36_clear_overrides() {
+  if (arena_initialized) {
+    return kTfLiteError;
+  }
+  if (builtin_saved) {
+    for (int i = 0; i < kTensorCount; i++) {
+      tensorData[i].data = builtin_data[i];
+      tensorData[i].quantization = builtin_quantization[i];
+    }
+  }
+  return kTfLiteOk;
+}
+
+#if EI_CLASSIFIER_EON_PROFILER
+TfLiteStatus tflite_learn_792000_36_node(size_t index, const char** op_name,
+                                         int* input_tensor, int* output_tensor) {
+  if (index >= 9) {
+    return kTfLiteError;
+  }
+  if (op_name) {
+    *op_name = used_op_names[used_ops[index]];
+  }
+  if (input_tensor) {
+    *input_tensor = tflNodes[index].inputs->data[0];
+  }
+  if (output_tensor) {
+    *output_tensor = tflNodes[index].outputs->data[0];
+  }
+  return kTfLiteOk;
+}
+
+void tflite_learn_792000_36_set_profiler(tflite::MicroProfilerInterface* new_profiler) {
+  profiler = new_profiler;
+}
+#endif
+
+TfLiteStatus tflite_learn_792000_36_arena_usage(size_t* arena_bytes, size_t* tensor_bytes,
+                                                size_t* persistent_bytes) {
+  if (arena_bytes) {
+    *arena_bytes = kTensorArenaSize;
+  }
+  if (tensor_bytes) {
+    *tensor_bytes = arena_initialized ? (size_t)(tensor_boundary - tensor_arena) : 0;
+  }
+  if (persistent_bytes) {
+    *persistent_bytes = arena_initialized ? (size_t)(tensor_arena + kTensorArenaSize - current_location) : 0;
+  }
+  return kTfLiteOk;
+}
+
+#if EI_ARENA_RECORDING
+TfLiteStatus tflite_learn_792000_36_arena_record(tflite_learn_792000_36_arena_record_t* record) {
+  if (!record) {
+    return kTfLiteError;
+  }
+  record->arena_bytes = kTensorArenaSize;
+  record->tensor_bytes = arena_initialized ? (size_t)(tensor_boundary - tensor_arena) : 0;
+  record->persistent = recorded_persistent;
+  record->scratch = recorded_scratch;
+  record->overflow = recorded_overflow;
+  // Persistent and scratch buffers are taken downwards from the 16-byte aligned end, tensors upwards
+  // from the start: a multiple of 16 keeps the end aligned so every buffer lands where it did here
+  const size_t needed = record->tensor_bytes + recorded_persistent.used_bytes + recorded_scratch.used_bytes +
+                        recorded_overflow.used_bytes;
+  record->minimum_arena_bytes = arena_initialized ? (needed + 15) & ~(size_t)15 : 0;
+  return arena_initialized ? kTfLiteOk : kTfLiteError;
+}
+#endif // EI_ARENA_RECORDING
+
+uint8_t* tflite_learn_792000_36_arena(size_t* bytes) {
+  *bytes = tensor_arena ? kTensorArenaSize : 0;
+  return tensor_arena;
+}
+
+uint8_t* tflite_learn_792000_36_idle_region(size_t* bytes) {
+  if (!tensor_arena) {
+    *bytes = 0;
+    return NULL;
+  }
+  *bytes = arena_initialized ? (size_t)(current_location - tensor_arena) : kTensorArenaSize;
+  return tensor_arena;
+}
+
 TfLiteStatus tflite_learn_792000_36_invoke() {
-  for (size_t i = 0; i < 9; ++i) {
+  for (size_t i = 0; i < active_nodes; ++i) {
     ResetTensors();
 
+#if EI_CLASSIFIER_EON_PROFILER
+    const uint32_t event = profiler ? profiler->BeginEvent(used_op_names[used_ops[i]]) : 0;
+#endif
     TfLiteStatus status = registrations[used_ops[i]].invoke(&ctx, &tflNodes[i]);
+#if EI_CLASSIFIER_EON_PROFILER
+    if (profiler) {
+      profiler->EndEvent(event);
+    }
+#endif
 
 #if EI_CLASSIFIER_PRINT_STATE
     ei_printf("layer %lu\n", i);
@@ -712,6 +988,10 @@ TfLiteStatus tflite_learn_792000_36_invoke() {
     if (status != kTfLiteOk) {
       return status;
     }
+    // Preemption point between nodes: the application may abandon this invoke (a fresher window is waiting)
+    if (i + 1 < active_nodes && ei_run_impulse_check_canceled() == EI_IMPULSE_CANCELED) {
+      return kTfLiteCancelled;
+    }
   }
   return kTfLiteOk;
 }
@@ -719,6 +999,7 @@ TfLiteStatus tflite_learn_792000_36_invoke() {
 TfLiteStatus tflite_learn_792000_36_reset( void (*free_fnc)(void* ptr) ) {
 #ifdef EI_CLASSIFIER_ALLOCATION_HEAP
   free_fnc(tensor_arena);
+  tensor_arena = NULL;
 #endif
 
   // scratch buffers are allocated within the arena, so just reset the counter so memory can be reused
@@ -729,5 +1010,6 @@ TfLiteStatus tflite_learn_792000_36_reset( void (*free_fnc)(void* ptr) ) {
     ei_free(overflow_buffers[ix]);
   }
   overflow_buffers_ix = 0;
+  arena_initialized = false;
   return kTfLiteOk;
 }
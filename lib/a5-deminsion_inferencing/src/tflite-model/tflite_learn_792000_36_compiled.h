@@ -35,12 +35,90 @@
 
 #include "edge-impulse-sdk/tensorflow/lite/c/common.h"
 
-// Sets up the model with init and prepare steps.
+// Set to 1 (globally, e.g. via build flags) to report one profiler event per
+// node from tflite_learn_792000_36_invoke().
+#ifndef EI_CLASSIFIER_EON_PROFILER
+#define EI_CLASSIFIER_EON_PROFILER 0
+#endif
+
+#if EI_CLASSIFIER_EON_PROFILER
+#include "edge-impulse-sdk/tensorflow/lite/micro/micro_profiler_interface.h"
+#endif
+
+// Set to 1 (globally) to record every persistent, scratch and overflow buffer
+// the kernels allocate and report the smallest arena that holds them.
+#ifndef EI_ARENA_RECORDING
+#define EI_ARENA_RECORDING 0
+#endif
+
+// Sets up the model with init and prepare steps. Does nothing while the model
+// is already initialized: invoke can be called any number of times in between
+// without touching the arena, the op data or the resource variables.
 TfLiteStatus tflite_learn_792000_36_init( void*(*alloc_fnc)(size_t,size_t) );
+// Returns true between init and reset.
+bool tflite_learn_792000_36_initialized();
+// Zeroes the resource variables (the state of stateful models, e.g. RNN / GRU
+// hidden state written with ASSIGN_VARIABLE) without re-initializing the model.
+// kTfLiteError while not initialized.
+TfLiteStatus tflite_learn_792000_36_reset_state();
+// Stops init / prepare / invoke before the graph's trailing SOFTMAX (skip =
+// true) or runs the whole graph again (false): without it the output tensor is
+// never written and the op takes no arena. The logits, the input of the
+// SOFTMAX, are read with tflite_learn_792000_36_tensor(*logits_tensor).
+// kTfLiteError while the model is initialized or if it does not end with a
+// SOFTMAX.
+TfLiteStatus tflite_learn_792000_36_skip_softmax(bool skip, int* logits_tensor);
 // Returns the input tensor with the given index.
 TfLiteStatus tflite_learn_792000_36_input(int index, TfLiteTensor* tensor);
 // Returns the output tensor with the given index.
 TfLiteStatus tflite_learn_792000_36_output(int index, TfLiteTensor* tensor);
+// Returns the tensor with the given graph index (weights, biases and
+// quantization parameters of intermediate tensors).
+TfLiteStatus tflite_learn_792000_36_tensor(int index, TfLiteTensor* tensor);
+// Replaces the data of a constant tensor and / or the per-tensor quantization
+// of any quantized tensor (nullptr keeps the current value) while the model is
+// not initialized; the next init uses them. The data must match the tensor's
+// type and size and stay valid until the overrides are cleared.
+TfLiteStatus tflite_learn_792000_36_override_tensor(int index, const void* data, const float* scale,
+                                                    const int32_t* zero_point);
+// Restores the built-in data and quantization of every tensor (model not initialized).
+TfLiteStatus tflite_learn_792000_36_clear_overrides();
+// Returns the arena size, the bytes planned for tensors and the bytes taken by
+// persistent / scratch buffers (the last two are 0 while not initialized).
+TfLiteStatus tflite_learn_792000_36_arena_usage(size_t* arena_bytes, size_t* tensor_bytes,
+                                                size_t* persistent_bytes);
+#if EI_ARENA_RECORDING
+// Buffers of one kind allocated since the last init: bytes the kernels asked
+// for, bytes they took (rounded up to the 16-byte alignment) and how many.
+typedef struct {
+  size_t requested_bytes;
+  size_t used_bytes;
+  size_t count;
+} tflite_learn_792000_36_recorded_allocation_t;
+
+typedef struct {
+  size_t arena_bytes;
+  size_t tensor_bytes;
+  tflite_learn_792000_36_recorded_allocation_t persistent;  // kernel op data in the arena
+  tflite_learn_792000_36_recorded_allocation_t scratch;     // scratch buffers in the arena
+  tflite_learn_792000_36_recorded_allocation_t overflow;    // buffers that did not fit and went to the heap
+  size_t minimum_arena_bytes;  // smallest arena (multiple of 16) that holds all of the above
+} tflite_learn_792000_36_arena_record_t;
+
+// Recording build only (EI_ARENA_RECORDING=1): every allocation made through
+// the context since the last init, during init / prepare and invoke alike.
+// Building with -DEI_TENSOR_ARENA_SIZE=<minimum_arena_bytes> fits the model
+// without overflow buffers. kTfLiteError while not initialized.
+TfLiteStatus tflite_learn_792000_36_arena_record(tflite_learn_792000_36_arena_record_t* record);
+#endif // EI_ARENA_RECORDING
+// Returns the tensor arena and its size; nullptr if it is on the heap and not allocated.
+uint8_t* tflite_learn_792000_36_arena(size_t* bytes);
+// Returns the part of the arena that carries no state from one invoke to the
+// next (activations and unused space below the persistent buffers, or the whole
+// arena while not initialized). It may be borrowed as scratch memory between
+// invokes; the next invoke overwrites it. nullptr if the arena is on the heap
+// and not allocated.
+uint8_t* tflite_learn_792000_36_idle_region(size_t* bytes);
 // Runs inference for the model.
 TfLiteStatus tflite_learn_792000_36_invoke();
 //Frees memory allocated
@@ -56,4 +134,17 @@ inline size_t tflite_learn_792000_36_outputs() {
   return 1;
 }
 
+#if EI_CLASSIFIER_EON_PROFILER
+// Returns the number of nodes in the graph.
+inline size_t tflite_learn_792000_36_nodes() {
+  return 9;
+}
+// Returns the op name and the first input / output tensor index of a node.
+TfLiteStatus tflite_learn_792000_36_node(size_t index, const char** op_name,
+                                         int* input_tensor, int* output_tensor);
+// Installs a profiler that receives one event per node (tagged with the op
+// name) during invoke; pass nullptr to disable.
+void tflite_learn_792000_36_set_profiler(tflite::MicroProfilerInterface* profiler);
+#endif
+
 #endif
@@ -0,0 +1,156 @@
+"""
+Tensor Arena Sizing
+
+Reads the arena record of an EI_ARENA_RECORDING build (env nano33ble_arena)
+and writes the smallest arena that holds the model back into platformio.ini:
+-DEI_TENSOR_ARENA_SIZE=<n> in [env:nano33ble] and the matching
+"sym:tensor_arena ram" budget, so the link fails if a later model needs more.
+
+The recording build gives the arena room to spare, so every persistent,
+scratch and would-be overflow buffer is counted at the size it takes in the
+arena; the firmware prints the record with its RAM budget at start-up and
+again on the serial command "mem":
+
+    [Memory]     arena minimum 1424 B (-DEI_TENSOR_ARENA_SIZE=1424), reclaimable 6768 B
+
+Measure on the board: the CMSIS-NN kernels ask for other scratch sizes than
+the reference kernels a host build uses.
+
+Usage:
+    python arena_size.py capture.log
+    python arena_size.py --port /dev/ttyACM0 --write platformio.ini
+"""
+
+import argparse
+import re
+import sys
+from dataclasses import dataclass
+from typing import Iterable, List, Optional
+
+RECORD_LINE = re.compile(r"\[Memory\]\s+(persistent|scratch|overflow \(heap\))\s+(\d+) B in (\d+) "
+                         r"\(requested (\d+) B\)")
+MINIMUM_LINE = re.compile(r"\[Memory\]\s+arena minimum (\d+) B")
+ARENA_LINE = re.compile(r"\[Memory\]\s+tensor arena\s+(\d+) B \(tensors (\d+),")
+FLAG = "-DEI_TENSOR_ARENA_SIZE"
+BUDGET_PREFIX = "sym:tensor_arena ram"
+
+
+@dataclass
+class ArenaRecord:
+    arena_bytes: int
+    tensor_bytes: int
+    minimum_bytes: int
+    buckets: dict  # kind -> (used bytes, count, requested bytes)
+
+    @property
+    def overflow_count(self) -> int:
+        return self.buckets.get("overflow (heap)", (0, 0, 0))[1]
+
+
+def parse_record(lines: Iterable[str]) -> Optional[ArenaRecord]:
+    """The last complete record in a capture, None when there is none."""
+    last = None
+    arena = tensor = 0
+    buckets = {}
+    for line in lines:
+        match = ARENA_LINE.search(line)
+        if match:
+            arena, tensor = int(match.group(1)), int(match.group(2))
+            buckets = {}
+            continue
+        match = RECORD_LINE.search(line)
+        if match:
+            buckets[match.group(1)] = (int(match.group(2)), int(match.group(3)), int(match.group(4)))
+            continue
+        match = MINIMUM_LINE.search(line)
+        if match:
+            last = ArenaRecord(arena, tensor, int(match.group(1)), dict(buckets))
+    return last
+
+
+def apply_size(ini: str, size: int, env: str = "nano33ble") -> str:
+    """platformio.ini with the arena size flag and budget of [env:<env>] set to size."""
+    lines = ini.splitlines(keepends=True)
+    header = f"[env:{env}]"
+    start = next((i for i, line in enumerate(lines) if line.strip() == header), None)
+    if start is None:
+        raise ValueError(f"no {header} section")
+    end = next((i for i in range(start + 1, len(lines)) if lines[i].startswith("[")), len(lines))
+
+    def indent_of(line: str) -> str:
+        return line[:len(line) - len(line.lstrip())]
+
+    flag_done = False
+    flags_at = None
+    for i in range(start + 1, end):
+        stripped = lines[i].strip()
+        if stripped.startswith(FLAG + "="):
+            lines[i] = f"{indent_of(lines[i])}{FLAG}={size}\n"
+            flag_done = True
+        elif stripped.startswith(BUDGET_PREFIX + " "):
+            # Only an existing budget follows the size; none is added
+            lines[i] = f"{indent_of(lines[i])}{BUDGET_PREFIX} {size}\n"
+        elif stripped.startswith("build_flags"):
+            flags_at = i
+    if not flag_done:
+        if flags_at is None:
+            raise ValueError(f"{header} has no build_flags")
+        lines.insert(flags_at + 1, f"    {FLAG}={size}\n")
+    return "".join(lines)
+
+
+def read_port(port: str, timeout_s: float = 5.0) -> List[str]:
+    """Ask the board for its RAM budget over the serial console and collect the lines up to the record."""
+    import serial  # pyserial
+    lines = []
+    with serial.Serial(port, 115200, timeout=timeout_s) as ser:
+        ser.reset_input_buffer()
+        ser.write(b"mem\n")
+        while True:
+            line = ser.readline().decode("utf-8", errors="replace")
+            if not line:
+                break
+            lines.append(line)
+            if MINIMUM_LINE.search(line):
+                break
+    return lines
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Size the tensor arena from an EI_ARENA_RECORDING build")
+    parser.add_argument("capture", nargs="?", help="serial log with the RAM budget (default: stdin)")
+    parser.add_argument("--port", help="read the record from this serial port instead")
+    parser.add_argument("--write", metavar="INI", help="set the arena size in this platformio.ini")
+    parser.add_argument("--env", default="nano33ble", help="environment to size (default nano33ble)")
+    args = parser.parse_args()
+
+    if args.port:
+        lines = read_port(args.port)
+    elif args.capture:
+        with open(args.capture, encoding="utf-8", errors="replace") as f:
+            lines = f.readlines()
+    else:
+        lines = sys.stdin.readlines()
+    record = parse_record(lines)
+    if record is None or record.minimum_bytes <= 0:
+        print("No arena record found (flash env nano33ble_arena and send \"mem\")", file=sys.stderr)
+        return 1
+
+    print(f"tensors {record.tensor_bytes} B in a {record.arena_bytes} B recording arena")
+    for kind, (used, count, requested) in record.buckets.items():
+        print(f"  {kind:<16}{used:>7} B in {count} (requested {requested} B)")
+    print(f"minimum arena {record.minimum_bytes} B: {FLAG}={record.minimum_bytes}")
+    if record.overflow_count:
+        print(f"warning: {record.overflow_count} buffer(s) overflowed to the heap even in the recording build",
+              file=sys.stderr)
+    if args.write:
+        with open(args.write, encoding="utf-8") as f:
+            ini = f.read()
+        with open(args.write, "w", encoding="utf-8") as f:
+            f.write(apply_size(ini, record.minimum_bytes, args.env))
+        print(f"Updated [env:{args.env}] in {args.write}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,102 @@
+"""
+Host Benchmark Comparison
+
+Compares two runs of the host microbenchmark (env host_bench,
+src/host/bench_main.cpp) and fails when a benchmark got slower than the
+threshold allows. Medians are compared; a benchmark counts as regressed only
+when the new fastest round is also slower than the old median, so a single
+noisy round on a busy machine does not fail the check.
+
+Usage:
+    .pio/build/host_bench/program > bench.json
+    python bench_compare.py baseline.json bench.json
+    python bench_compare.py baseline.json bench.json --threshold 0.05
+"""
+
+import argparse
+import json
+import sys
+from dataclasses import dataclass
+from typing import Dict, List, Optional
+
+
+@dataclass
+class BenchResult:
+    name: str
+    iterations: int
+    min_ns: float
+    median_ns: float
+    max_ns: float
+
+
+@dataclass
+class Comparison:
+    name: str
+    old_ns: Optional[float]
+    new_ns: Optional[float]
+    regressed: bool
+
+    @property
+    def change(self) -> Optional[float]:
+        """Relative change of the median, +0.10 = 10 % slower."""
+        if self.old_ns is None or self.new_ns is None or self.old_ns <= 0:
+            return None
+        return self.new_ns / self.old_ns - 1.0
+
+
+def load(text: str) -> Dict[str, BenchResult]:
+    data = json.loads(text)
+    if data.get("schema") != 1:
+        raise ValueError(f"unsupported benchmark schema {data.get('schema')!r}")
+    results = {}
+    for entry in data["benchmarks"]:
+        ns = entry["ns_per_op"]
+        results[entry["name"]] = BenchResult(entry["name"], entry["iterations"], ns["min"], ns["median"], ns["max"])
+    return results
+
+
+def compare(old: Dict[str, BenchResult], new: Dict[str, BenchResult], threshold: float) -> List[Comparison]:
+    """One row per benchmark in either run, in the new run's order; missing ones are never regressions."""
+    names = list(new) + [name for name in old if name not in new]
+    rows = []
+    for name in names:
+        before, after = old.get(name), new.get(name)
+        regressed = (before is not None and after is not None and
+                     after.median_ns > before.median_ns * (1.0 + threshold) and after.min_ns > before.median_ns)
+        rows.append(Comparison(name, before.median_ns if before else None, after.median_ns if after else None,
+                               regressed))
+    return rows
+
+
+def format_ns(value: Optional[float]) -> str:
+    if value is None:
+        return "-"
+    return f"{value / 1000:.2f} us" if value >= 10000 else f"{value:.1f} ns"
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Compare two host benchmark runs")
+    parser.add_argument("baseline", help="JSON of the reference run")
+    parser.add_argument("current", help="JSON of the run to check")
+    parser.add_argument("--threshold", type=float, default=0.10, help="allowed median slowdown (default 0.10)")
+    args = parser.parse_args()
+
+    with open(args.baseline, encoding="utf-8") as f:
+        old = load(f.read())
+    with open(args.current, encoding="utf-8") as f:
+        new = load(f.read())
+    rows = compare(old, new, args.threshold)
+    print(f"{'benchmark':<28}{'baseline':>12}{'current':>12}{'change':>9}")
+    for row in rows:
+        change = f"{row.change * 100:+.1f}%" if row.change is not None else "-"
+        flag = "  REGRESSED" if row.regressed else ""
+        print(f"{row.name:<28}{format_ns(row.old_ns):>12}{format_ns(row.new_ns):>12}{change:>9}{flag}")
+    regressions = [row.name for row in rows if row.regressed]
+    if regressions:
+        print(f"{len(regressions)} benchmark(s) slower than {args.threshold * 100:.0f} %: {', '.join(regressions)}")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,106 @@
+"""
+BLE Benchmark Script - 测量当前链路的往返延迟与吞吐量
+
+连接开发板后通过基准特征值 (19B1001D-...) 依次运行两种模式：
+  loopback    上位机逐个写入（无响应写），设备立即通知回带设备时间戳的回显；
+              上位机与设备各自计时往返延迟，打印 p50 / p95 / p99 / max 与丢失数
+  saturation  设备以 MTU - 3 字节的通知全速发送；打印设备发送与上位机接收的
+              kbit/s、协议栈拒绝的通知数与上位机未收到的包数
+
+另有设备端推理基准（19B10029-...，不包含在 both 中）：
+  inference       设备对固定的合成窗口连续推理 --runs 次
+  inference-live  设备记录接下来 --runs 次实时推理
+两者都打印 DSP、分类、后处理与端到端各级的 min / p50 / p95 / p99 / max（µs）。
+
+同一台设备换中心设备、PHY 或连接间隔后各跑一次，即可直接比较。
+
+Usage:
+    python ble_benchmark.py
+    python ble_benchmark.py --address AA:BB:CC:DD:EE:FF --count 500 --padding 100 --duration 5000
+    python ble_benchmark.py --mode loopback
+    python ble_benchmark.py --mode inference --runs 200
+"""
+
+import argparse
+import asyncio
+import sys
+
+from ble_manager import BLEManager
+
+
+def print_loopback(result) -> None:
+    answered = len(result.rtt_ms)
+    print(f"Loopback: {answered}/{result.sent} round trips, {result.lost} lost")
+    if answered:
+        print(f"  host   RTT p50 {result.percentile(0.50):6.1f} ms  p95 {result.percentile(0.95):6.1f} ms  "
+              f"p99 {result.percentile(0.99):6.1f} ms  max {max(result.rtt_ms):6.1f} ms")
+    device = result.device
+    if device is None:
+        print("  device report not received (firmware without loopback?)")
+    else:
+        print(f"  device RTT p50 {device.p50_ms:6.1f} ms  p95 {device.p95_ms:6.1f} ms  "
+              f"p99 {device.p99_ms:6.1f} ms  max {device.max_ms:6.1f} ms  "
+              f"({device.round_trips} timed, {device.refused} notifications refused)")
+
+
+def print_saturation(result) -> None:
+    print(f"Saturation: device sent {result.sent_packets} packets / {result.sent_bytes} bytes in {result.device_ms} ms "
+          f"({result.device_kbps:.1f} kbit/s), {result.refused_packets} refused by the stack")
+    print(f"  host received {result.received_packets} packets / {result.received_bytes} bytes in {result.host_s:.3f} s "
+          f"({result.throughput_kbps:.1f} kbit/s), {result.missing_packets} missing")
+
+
+def print_inference(report) -> None:
+    print(f"Inference ({report.mode}): {report.runs} runs, {report.state}")
+    print(f"  {'stage':<12}{'min':>8}{'p50':>8}{'p95':>8}{'p99':>8}{'max':>8}  us")
+    for name, stats in report.stages.items():
+        print(f"  {name:<12}{stats.min_us:>8}{stats.p50_us:>8}{stats.p95_us:>8}{stats.p99_us:>8}{stats.max_us:>8}")
+
+
+async def run(args) -> int:
+    manager = BLEManager()
+    manager.set_auto_reconnect(False)
+    connected = await manager.connect(args.address) if args.address else await manager.scan_and_connect()
+    if not connected:
+        print("未连接到设备")
+        return 1
+    status = 0
+    try:
+        if args.mode in ("both", "loopback"):
+            loopback = await manager.run_loopback(args.count, args.padding)
+            if loopback is None:
+                status = 1
+            else:
+                print_loopback(loopback)
+        if args.mode in ("both", "saturation"):
+            saturation = await manager.run_benchmark(args.duration)
+            if saturation is None:
+                status = 1
+            else:
+                print_saturation(saturation)
+        if args.mode in ("inference", "inference-live"):
+            mode = "live" if args.mode == "inference-live" else "synthetic"
+            report = await manager.run_inference_benchmark(mode, args.runs)
+            if report is None:
+                status = 1
+            else:
+                print_inference(report)
+    finally:
+        await manager.disconnect()
+    return status
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="BLE loopback latency and notification throughput benchmark")
+    parser.add_argument("--address", help="device address (default: scan by name)")
+    parser.add_argument("--mode", choices=("both", "loopback", "saturation", "inference", "inference-live"),
+                        default="both")
+    parser.add_argument("--count", type=int, default=200, help="loopback round trips")
+    parser.add_argument("--padding", type=int, default=0, help="extra bytes in each loopback write and echo")
+    parser.add_argument("--duration", type=int, default=3000, help="saturation run length in ms (max 30000)")
+    parser.add_argument("--runs", type=int, default=100, help="inference benchmark runs (max 200)")
+    return asyncio.run(run(parser.parse_args()))
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -7,12 +7,24 @@ Optimized for Windows BLE connectivity.
 
 import asyncio
 import struct
-from typing import Optional, Callable, List
+import time
+from typing import Any, Optional, Callable, Dict, List, Tuple
 from dataclasses import dataclass
 
 from bleak import BleakClient, BleakScanner
 from bleak.backends.device import BLEDevice
 
+from gesture_labels import MODEL_LABELS as DEPLOYED_LABELS
+from l2cap_channel import (BULK_UUID, RECORD_HELLO, RECORD_MAX, RECORD_MODEL_DATA, RECORD_TELEMETRY_DATA,
+                           RECORD_TRACE, RECORD_WINDOW, L2capChannel, encode_hello, parse_bulk_info, parse_hello)
+from l2cap_channel import supported as l2cap_supported
+from percentiles import percentile
+from raw_recorder import TYPE_WINDOW, WINDOW_UUID, RawPacket, StreamDecoder
+from wire_schema import (EVENT as EVENT_STRUCT, EVENT_HEADER, GESTURE as GESTURE_STRUCT, GESTURE_V1, HEARTBEAT,
+                         HEARTBEAT_MARKER, LEGACY_CONFIDENCE, ONSET, ONSET_CANCELED, ONSET_CONFIRMED,
+                         ONSET_PROVISIONAL, SCORES_HEADER, TRACE_HEADER, TRACE_LOST, TRACE_ZONE, ConfidenceFormat, confidence_format,
+                         Stat, iter_records, parse_stat, schema_version, schema_warning)
+
 
 @dataclass
 class GestureData:
@@ -21,138 +33,2024 @@ class GestureData:
     confidence: float
 
 
-class BLEManager:
-    """BLE connection and data management."""
-    
-    # UUIDs matching the Arduino firmware (lowercase for better compatibility)
-    SERVICE_UUID = "19b10010-e8f2-537e-4f6c-d104768a1214"
-    PREDICTION_UUID = "19b10011-e8f2-537e-4f6c-d104768a1214"
-    CONFIDENCE_UUID = "19b10012-e8f2-537e-4f6c-d104768a1214"
-    
-    TARGET_DEVICE_NAME = "5ClassForwarder"
-    
-    def __init__(self):
-        """Initialize BLEManager."""
-        self._client: Optional[BleakClient] = None
-        self._gesture_callback: Optional[Callable[[str, float], None]] = None
-        self._status_callback: Optional[Callable[[str], None]] = None
-        self._connected = False
-        self._current_gesture: Optional[str] = None
-        self._current_confidence: float = 0.0
-        self._reconnect_enabled = True
-        self._reconnect_attempts = 0
-        self._max_reconnect_attempts = 5
-        self._last_device_address: Optional[str] = None
-        self._discovered_devices: List[BLEDevice] = []
-    
-    def set_gesture_callback(self, callback: Callable[[str, float], None]) -> None:
-        """Set callback for gesture data. Signature: callback(gesture, confidence)"""
-        self._gesture_callback = callback
-    
-    def set_status_callback(self, callback: Callable[[str], None]) -> None:
-        """Set callback for connection status changes."""
-        self._status_callback = callback
+@dataclass
+class ResultEvent:
+    """One published result from the events characteristic."""
+    index: int
+    confidence: float
+    sequence: int       # low 16 bits of the firmware result sequence
+    timestamp_ms: int   # firmware millis() at publish time
+    delivery: Optional[int] = None  # 16-bit delivery number on this connection (None: older firmware)
+
+
+# Streams a host takes, one bit each: the USB hello payload and the BLE streams characteristic
+STREAM_EVENTS = 0x01
+STREAM_SCORES = 0x02
+STREAM_WINDOW = 0x04
+STREAM_DIAGNOSTICS = 0x08
+STREAM_RECORD = 0x10
+STREAM_TRACE = 0x20
+
+def parse_event_burst(data: bytes, confidence: ConfidenceFormat = LEGACY_CONFIDENCE) -> Tuple[int, List[ResultEvent]]:
+    """Decode an events notification (see src/ble_module.cpp).
+
+    Returns (events dropped since the previous notification, events in publish order).
+    Bursts with a delivery number have a 3-byte header, older ones a 1-byte header;
+    the length tells them apart (3 + 8n against 1 + 8n bytes). confidence is the
+    device's format from the layout characteristic or hello reply. An idle
+    heartbeat record is not an event (parse_heartbeat).
+    """
+    if not data:
+        return 0, []
+    delivery = None
+    header = 1
+    if len(data) >= EVENT_HEADER.size and (len(data) - EVENT_HEADER.size) % EVENT_STRUCT.size == 0:
+        delivery = EVENT_HEADER.unpack_from(data)[1]
+        header = EVENT_HEADER.size
+    events = []
+    for index, confidence_q, sequence, timestamp_ms in iter_records(EVENT_STRUCT, data, header):
+        if index == HEARTBEAT_MARKER:
+            continue
+        number = (delivery + len(events)) & 0xFFFF if delivery is not None else None
+        events.append(ResultEvent(index, confidence.value(confidence_q), sequence, timestamp_ms, number))
+    return data[0], events
+
+
+def parse_layout(data: bytes) -> Optional[int]:
+    """GATT layout hash of the firmware build (uint32), None when too short."""
+    if len(data) < 4:
+        return None
+    return struct.unpack_from('<I', data)[0]
+
+
+def parse_layout_schema(data: bytes) -> Optional[int]:
+    """Wire schema version after the layout hash (wire_schema.py), None from older firmware."""
+    return schema_version(data, 4)
+
+
+def parse_layout_confidence(data: bytes) -> ConfidenceFormat:
+    """Result confidence format after the schema version; LEGACY_CONFIDENCE from older firmware."""
+    return confidence_format(data, 5)
+
+
+def parse_layout_heartbeat(data: bytes) -> Optional[float]:
+    """Idle heartbeat interval in seconds after the confidence format; None when the device sends none."""
+    if len(data) < 12:
+        return None
+    interval_ms = struct.unpack_from('<H', data, 10)[0]
+    return interval_ms / 1000.0 if interval_ms else None
+
+
+def encode_missed(first: int, count: int) -> bytes:
+    """Retransmit request for count events from delivery number first (at most 255 per request)."""
+    return struct.pack('<HB', first & 0xFFFF, min(max(count, 1), 255))
+
+
+class DeliveryTracker:
+    """Gap detection over the delivery numbers of one connection's events.
+
+    missed counts events whose notification never arrived, recovered those the
+    history read-back returned, lost those it could not (no longer on the device,
+    or no answer within timeout_s).
+    """
+
+    def __init__(self, timeout_s: float = 1.0):
+        self.timeout_s = timeout_s
+        self.reset()
+
+    def reset(self) -> None:
+        self.expected: Optional[int] = None
+        self.received = 0
+        self.missed = 0
+        self.recovered = 0
+        self.lost = 0
+        self._pending: Dict[int, float] = {}
+
+    @property
+    def pending(self) -> int:
+        return len(self._pending)
+
+    def receive(self, first: int, count: int, now: float) -> Optional[Tuple[int, int]]:
+        """Account for a burst; returns (first, count) of a gap to request again, or None."""
+        self.expire(now)
+        gap = None
+        if self.expected is not None:
+            ahead = (first - self.expected) & 0xFFFF
+            if 0 < ahead < 0x8000:
+                self.missed += ahead
+                for i in range(ahead):
+                    self._pending[(self.expected + i) & 0xFFFF] = now
+                gap = (self.expected, min(ahead, 255))
+            elif ahead >= 0x8000:
+                # Numbers went back: the device started over without a reconnect being seen
+                self.lost += len(self._pending)
+                self._pending.clear()
+        self.received += count
+        self.expected = (first + count) & 0xFFFF
+        return gap
+
+    def recover(self, delivery: int) -> bool:
+        """True when a retransmitted event fills a gap (False for one already received)."""
+        if self._pending.pop(delivery & 0xFFFF, None) is None:
+            return False
+        self.recovered += 1
+        return True
+
+    def expire(self, now: float) -> None:
+        """Count gaps unanswered for timeout_s as lost."""
+        expired = [number for number, since in self._pending.items() if now - since >= self.timeout_s]
+        for number in expired:
+            del self._pending[number]
+        self.lost += len(expired)
+
+
+# Legacy confidence characteristic: one float32
+CONFIDENCE_STRUCT = struct.Struct('<f')
+
+
+def parse_gesture(data: bytes, confidence: ConfidenceFormat = LEGACY_CONFIDENCE) -> Optional[ResultEvent]:
+    """Decode the packed gesture characteristic (latest result, see src/ble_module.cpp).
+
+    Returns None for a short payload or before the first result (label index 0xFF).
+    Schema 1 firmware sends 9 bytes with a uint16 confidence x 65535.
+    """
+    if len(data) >= GESTURE_V1.size:
+        index, confidence_q, sequence, timestamp_ms = GESTURE_V1.unpack_from(data)
+        value = confidence_q / 65535.0
+    elif len(data) >= GESTURE_STRUCT.size:
+        index, confidence_q, sequence, timestamp_ms = GESTURE_STRUCT.unpack_from(data)
+        value = confidence.value(confidence_q)
+    else:
+        return None
+    if index == 0xFF:
+        return None
+    return ResultEvent(index, value, sequence, timestamp_ms)
+
+
+@dataclass
+class SegmentState:
+    """One hold report of the segment characteristic: a gesture confirmed (held) or ended."""
+    index: int
+    held: bool
+    sequence: int       # low 16 bits of the result published at the onset
+    start_ms: int       # device sampling clock
+    end_ms: int         # the onset's while held
+
+
+SEGMENT_STRUCT = struct.Struct('<bBHII')
+
+
+def parse_segment(data: bytes) -> Optional[SegmentState]:
+    """Decode a segment notification (src/ble_module.cpp); None for a short payload or no gesture yet."""
+    if len(data) < SEGMENT_STRUCT.size:
+        return None
+    index, state, sequence, start_ms, end_ms = SEGMENT_STRUCT.unpack_from(data)
+    if index < 0:
+        return None
+    return SegmentState(index, state == 1, sequence, start_ms, end_ms)
+
+
+@dataclass
+class OnsetReport:
+    """One report of the onset characteristic: a provisional gesture, or how the full window resolved it."""
+    index: int
+    state: int          # ONSET_PROVISIONAL, ONSET_CONFIRMED or ONSET_CANCELED
+    onset: int          # onset number (low 16 bits), shared by a provisional report and its resolution
+    confidence: float   # prefix head probability
+    sequence: int       # low 16 bits of the confirming result (0 otherwise)
+    sample_ms: int      # device sampling clock at the onset
+
+
+ONSET_STATES = {ONSET_PROVISIONAL: "provisional", ONSET_CONFIRMED: "confirmed", ONSET_CANCELED: "canceled"}
+
+
+def parse_onset(data: bytes, confidence: ConfidenceFormat = LEGACY_CONFIDENCE) -> Optional[OnsetReport]:
+    """Decode an onset notification (wire_onset_t); None for a short payload, no onset yet or an unknown state."""
+    if len(data) < ONSET.size:
+        return None
+    index, state, onset, confidence_q, sequence, sample_ms = ONSET.unpack_from(data)
+    if index < 0 or state not in ONSET_STATES:
+        return None
+    return OnsetReport(index, state, onset, confidence.value(confidence_q), sequence, sample_ms)
+
+
+# HID usages for the firmware keyboard mode (BLE_HID_ENABLE, src/hid_module.cpp); names follow
+# GestureHandler's shortcut strings ("ctrl+shift+a", "right", "f5")
+HID_MODIFIERS = {"ctrl": 0x01, "shift": 0x02, "alt": 0x04, "win": 0x08}
+HID_KEYS = {
+    **{chr(ord('a') + i): 0x04 + i for i in range(26)},
+    **{str(i): 0x1D + i for i in range(1, 10)}, "0": 0x27,
+    "enter": 0x28, "esc": 0x29, "backspace": 0x2A, "tab": 0x2B, "space": 0x2C,
+    **{f"f{i}": 0x39 + i for i in range(1, 13)},
+    "home": 0x4A, "pageup": 0x4B, "delete": 0x4C, "end": 0x4D, "pagedown": 0x4E,
+    "right": 0x4F, "left": 0x50, "down": 0x51, "up": 0x52,
+}
+# Consumer-control keys (sent with modifier byte 0xFF), only available in the firmware HID mode
+HID_CONSUMER = 0xFF
+HID_CONSUMER_KEYS = {"playpause": 0xCD, "nexttrack": 0xB5, "prevtrack": 0xB6,
+                     "mute": 0xE2, "volumeup": 0xE9, "volumedown": 0xEA}
+
+
+def encode_shortcut(shortcut: str) -> Tuple[int, int]:
+    """(modifiers, usage) of a shortcut string; (0, 0) for "none" or keys HID has no usage for."""
+    modifiers, usage = 0, 0
+    for part in (p.strip().lower() for p in (shortcut or "").split("+")):
+        if part in HID_MODIFIERS:
+            modifiers |= HID_MODIFIERS[part]
+        elif part in HID_KEYS:
+            usage = HID_KEYS[part]
+        elif part in HID_CONSUMER_KEYS:
+            return HID_CONSUMER, HID_CONSUMER_KEYS[part]
+        else:
+            return 0, 0
+    return (modifiers, usage) if usage else (0, 0)
+
+
+def encode_keymap(shortcuts: Dict[str, str], labels=DEPLOYED_LABELS) -> bytes:
+    """Keymap characteristic payload: (modifiers, usage) per model label, in label order."""
+    return b"".join(bytes(encode_shortcut(shortcuts.get(label, "none"))) for label in labels)
+
+
+# Manufacturer data of the advertising packet while no central is connected (BLE_BROADCAST_* in app_config.h)
+BROADCAST_COMPANY_ID = 0xFFFF
+BROADCAST_STRUCT = struct.Struct('<BBH')
+
+
+@dataclass
+class BroadcastResult:
+    """The latest result one device advertises, received without a connection."""
+    address: str
+    index: int
+    confidence: float
+    sequence: int  # low 16 bits of the firmware result sequence
+
+
+def parse_broadcast(address: str, data: bytes) -> Optional[BroadcastResult]:
+    """Decode the manufacturer data (after the company ID); None before the first result."""
+    if len(data) < BROADCAST_STRUCT.size:
+        return None
+    index, confidence, sequence = BROADCAST_STRUCT.unpack_from(data)
+    if index == 0xFF:
+        return None
+    return BroadcastResult(address, index, confidence / 255.0, sequence)
+
+
+@dataclass
+class ScoreFrame:
+    """All class scores of one inference, as the int8 output tensor held them."""
+    sequence: int               # low 16 bits of the firmware inference counter
+    scores: List[int]           # int8, in MODEL_LABELS order
+    probabilities: List[float]  # (score - zero point) * scale
+
+
+def parse_scores(data: bytes) -> List[ScoreFrame]:
+    """Decode a score stream notification: consecutive inferences after one header (see src/ble_module.cpp)."""
+    if len(data) < SCORES_HEADER.size:
+        return []
+    first_sequence, labels, zero_point, scale = SCORES_HEADER.unpack_from(data)
+    if labels == 0:
+        return []
+    frames = []
+    for n, scores in enumerate(iter_records(struct.Struct(f'<{labels}b'), data, SCORES_HEADER.size)):
+        scores = list(scores)
+        frames.append(ScoreFrame((first_sequence + n) & 0xFFFF, scores, [(q - zero_point) * scale for q in scores]))
+    return frames
+
+
+# Thread order of the CPU utilization characteristic (energy_thread_t in include/energy_module.h)
+CPU_THREADS = ("sampler", "inference", "ble", "led", "record", "log")
+
+
+@dataclass
+class CpuUtilization:
+    """CPU time split of the firmware's last energy window, as fractions of the window."""
+    active: float
+    threads: Dict[str, float]
+    idle: float
+    other: Optional[float]  # interrupts / BLE stack / unregistered threads; None without kernel stats
+
+
+def parse_cpu_utilization(data: bytes) -> Optional[CpuUtilization]:
+    """Decode a CPU utilization notification (little-endian uint16 permille, see src/ble_module.cpp)."""
+    fields = len(CPU_THREADS) + 3
+    if len(data) < 2 * fields:
+        return None
+    values = struct.unpack_from(f'<{fields}H', data)
+    threads = {name: values[1 + i] / 1000.0 for i, name in enumerate(CPU_THREADS)}
+    other = None if values[-1] == 0xFFFF else values[-1] / 1000.0
+    return CpuUtilization(values[0] / 1000.0, threads, values[-2] / 1000.0, other)
+
+
+DELIVERY_COUNTERS_STRUCT = struct.Struct('<IIIII')
+
+
+@dataclass
+class DeliveryCounters:
+    """The firmware's BLE thread counters since boot (ble_counters_t in include/ble_module.h)."""
+    published: int
+    suppressed: int         # below ble_min_confidence
+    notify_failures: int    # refused by the stack while the host was subscribed
+    connected_s: int
+    sessions: int
+
+
+def parse_delivery_counters(data: bytes) -> Optional[DeliveryCounters]:
+    """Decode a delivery counters notification (five little-endian uint32)."""
+    if len(data) < DELIVERY_COUNTERS_STRUCT.size:
+        return None
+    return DeliveryCounters(*DELIVERY_COUNTERS_STRUCT.unpack_from(data))
+
+
+# Stage order of the latency characteristic (latency_stage_t in include/latency_module.h)
+LATENCY_STAGES = ("inference", "notify", "ack")
+
+
+@dataclass
+class LatencyReport:
+    """Latency of the firmware's last statistics window, measured from the newest sample of each window."""
+    p50_ms: Dict[str, Optional[int]]  # None when the stage had no samples in the window
+    p99_ms: Dict[str, Optional[int]]
+    notify_max_ms: Optional[int]
+    over_slo: int                     # notifications at or above the firmware's LATENCY_SLO_MS
+    stalls: int                       # inference thread stalls since boot
+    watchdog_reset: bool              # the last device reset came from the watchdog
+
+
+def parse_latency_report(data: bytes) -> Optional[LatencyReport]:
+    """Decode a latency notification (little-endian uint16 ms, 0xFFFF = no samples, see src/ble_module.cpp)."""
+    fields = 2 * len(LATENCY_STAGES) + 3
+    if len(data) < 2 * fields + 1:
+        return None
+    values = [None if v == 0xFFFF else v for v in struct.unpack_from(f'<{fields}H', data)]
+    p50 = {name: values[2 * i] for i, name in enumerate(LATENCY_STAGES)}
+    p99 = {name: values[2 * i + 1] for i, name in enumerate(LATENCY_STAGES)}
+    tail = values[2 * len(LATENCY_STAGES):]
+    return LatencyReport(p50, p99, tail[0], tail[1] or 0, tail[2] or 0, data[2 * fields] == 1)
+
+
+# Clock sync reply: uint16 sequence, uint32 device millis() at the request, uint16 us held on the device
+TIME_SYNC_REPLY = struct.Struct('<HIH')
+
+
+def encode_time_sync(sequence: int) -> bytes:
+    return struct.pack('<H', sequence & 0xFFFF)
+
+
+def parse_time_sync(data: bytes) -> Optional[Tuple[int, int, int]]:
+    """(sequence, device ms, device hold in us) of a clock sync reply, None when too short."""
+    if len(data) < TIME_SYNC_REPLY.size:
+        return None
+    return TIME_SYNC_REPLY.unpack_from(data)
+
+
+class ClockSync:
+    """Maps the device's millis() clock onto a host clock from NTP-style exchanges.
+
+    Each exchange gives the host send / receive times (t1, t4) and the device time
+    the request was handled; the device time lies in the middle of the round trip
+    to within half of it. Of the last window exchanges those with the
+    shortest round trips (within tolerance_s of the shortest, at least three) is
+    fitted with device = offset + rate * host, so both the offset and the drift
+    of the device crystal follow; before min_span_s of history only the offset
+    is estimated.
+    """
+
+    WRAP_MS = 1 << 32
+
+    def __init__(self, window: int = 128, tolerance_s: float = 0.002, min_span_s: float = 10.0):
+        self.window = window
+        self.tolerance_s = tolerance_s
+        self.min_span_s = min_span_s
+        self.reset()
+
+    def reset(self) -> None:
+        self._samples: List[Tuple[float, float, float]] = []  # (host mid s, device s, round trip s)
+        self._last_ms: Optional[int] = None  # unwrapped device ms of the newest exchange
+        self._fit: Optional[Tuple[float, float, float]] = None  # (host reference, device at reference, rate)
+        self.delay_s: Optional[float] = None
+
+    @property
+    def ready(self) -> bool:
+        return self._fit is not None
+
+    def _unwrap(self, device_ms: int) -> int:
+        """Device ms unwrapped to the 32-bit period nearest the newest exchange."""
+        if self._last_ms is None:
+            return device_ms
+        base = self._last_ms - self._last_ms % self.WRAP_MS
+        candidates = (base - self.WRAP_MS + device_ms, base + device_ms, base + self.WRAP_MS + device_ms)
+        return min(candidates, key=lambda v: abs(v - self._last_ms))
+
+    def add(self, host_send: float, host_receive: float, device_ms: int, held_us: int = 0) -> None:
+        """Record one exchange (host times in seconds; the device ms is truncated, so +0.5 ms)."""
+        round_trip = (host_receive - host_send) - held_us / 1e6
+        if round_trip < 0:
+            return
+        self._last_ms = self._unwrap(device_ms)
+        device_s = (self._last_ms + 0.5) / 1000.0 + held_us / 2e6
+        self._samples.append(((host_send + host_receive) / 2, device_s, round_trip))
+        del self._samples[:-self.window]
+        self._refit()
+
+    def _refit(self) -> None:
+        best = sorted(self._samples, key=lambda sample: sample[2])
+        self.delay_s = best[0][2]
+        best = best[:max(3, sum(1 for sample in best if sample[2] <= self.delay_s + self.tolerance_s))]
+        reference = best[0][0]
+        hosts = [host - reference for host, _, _ in best]
+        offsets = [device - host for host, device, _ in best]
+        rate = 1.0
+        span = max(hosts) - min(hosts)
+        if len(best) >= 3 and span >= self.min_span_s:
+            mean_h = sum(hosts) / len(hosts)
+            mean_o = sum(offsets) / len(offsets)
+            variance = sum((h - mean_h) ** 2 for h in hosts)
+            slope = sum((h - mean_h) * (o - mean_o) for h, o in zip(hosts, offsets)) / variance
+            rate = 1.0 + slope
+            offset = mean_o - slope * mean_h
+        else:
+            offsets.sort()
+            offset = offsets[len(offsets) // 2]
+        self._fit = (reference, reference + offset, rate)
+
+    @property
+    def offset_ms(self) -> Optional[float]:
+        """Device clock minus host clock at the reference exchange."""
+        return None if self._fit is None else (self._fit[1] - self._fit[0]) * 1000.0
+
+    @property
+    def drift_ppm(self) -> Optional[float]:
+        """How much faster the device clock runs than the host clock (0 until min_span_s of history)."""
+        return None if self._fit is None else (self._fit[2] - 1.0) * 1e6
+
+    def to_host(self, device_ms: int) -> Optional[float]:
+        """Host time (s) of a device millis() timestamp, None before the first exchange."""
+        return self.to_host_exact(device_ms + 0.5)
+
+    def to_host_exact(self, device_ms: float) -> Optional[float]:
+        """Host time (s) of a device time on the millis() scale known to better than a ms (not truncated)."""
+        if self._fit is None:
+            return None
+        reference, device_at_reference, rate = self._fit
+        return reference + (self._unwrap(device_ms) / 1000.0 - device_at_reference) / rate
+
+
+@dataclass
+class LatencyBreakdown:
+    """Median latency of each stage in ms (None = not measured yet).
+
+    sensor: newest window sample to classification (device, latency report p50)
+    device: classification to the notification handed to the BLE stack (device, p50)
+    radio: handed to the stack to the host callback (synced clocks, recent events)
+    host: host callback to the action queued (recent events; GestureHandler.action_stats() has the injection)
+    """
+    sensor_ms: Optional[float]
+    device_ms: Optional[float]
+    radio_ms: Optional[float]
+    host_ms: Optional[float]
+    events: int                 # events behind the radio / host medians
+    sync_error_ms: Optional[float]  # half the shortest sync round trip: bound on the clock offset error
+
+    @property
+    def total_ms(self) -> Optional[float]:
+        stages = (self.sensor_ms, self.device_ms, self.radio_ms, self.host_ms)
+        return None if any(v is None for v in stages) else sum(stages)
+
+
+class LatencyTracker:
+    """Per-stage latency from the device's latency reports and synced event publish times."""
+
+    def __init__(self, depth: int = 64):
+        self.depth = depth
+        self.reset()
+
+    def reset(self) -> None:
+        self._transit: List[float] = []   # publish (device clock, converted) to host arrival, s
+        self._handling: List[float] = []  # host arrival to done, s
+        self._end_to_end: List[float] = []  # publish to done of the same event, s
+        self._report: Optional[LatencyReport] = None
+
+    def set_report(self, report: LatencyReport) -> None:
+        self._report = report
+
+    def record(self, transit_s: Optional[float], handling_s: float) -> None:
+        if transit_s is not None:
+            self._transit.append(transit_s)
+            del self._transit[:-self.depth]
+            self._end_to_end.append(transit_s + handling_s)
+            del self._end_to_end[:-self.depth]
+        self._handling.append(handling_s)
+        del self._handling[:-self.depth]
+
+    @staticmethod
+    def _median(values: List[float]) -> Optional[float]:
+        if not values:
+            return None
+        ordered = sorted(values)
+        middle = len(ordered) // 2
+        return ordered[middle] if len(ordered) % 2 else (ordered[middle - 1] + ordered[middle]) / 2
+
+    def breakdown(self, clock: Optional[ClockSync] = None) -> LatencyBreakdown:
+        sensor = device = None
+        if self._report is not None:
+            inference = self._report.p50_ms.get("inference")
+            notify = self._report.p50_ms.get("notify")
+            sensor = None if inference is None else float(inference)
+            if inference is not None and notify is not None:
+                device = float(max(notify - inference, 0))
+        transit = self._median(self._transit)
+        radio = None
+        if transit is not None:
+            # The publish time is taken at classification: drop the device's queueing share
+            radio = max(transit * 1000.0 - (device or 0.0), 0.0)
+        handling = self._median(self._handling)
+        sync_error = None if clock is None or clock.delay_s is None else clock.delay_s * 500.0
+        return LatencyBreakdown(sensor, device, radio, None if handling is None else handling * 1000.0,
+                                len(self._transit), sync_error)
+
+    def end_to_end_ms(self, fractions: Tuple[float, ...] = (0.5, 0.95, 0.99)) -> Dict[float, Optional[float]]:
+        """Percentiles of classification (device timestamp) to action queued over the recent events."""
+        return {p: percentile(self._end_to_end, p) * 1000.0 if self._end_to_end else None for p in fractions}
+
+
+# Connection parameter profiles of the link characteristic (conn_profile_t in src/ble_module.cpp)
+CONN_PROFILES = ("none", "active", "idle")
+
+LINK_STRUCT = struct.Struct('<BHHHHHBB')
+# Appended by firmware with the advertising policy: reconnects since boot, last / mean / longest ms
+LINK_RECONNECT_STRUCT = struct.Struct('<BHHH')
+
+
+@dataclass
+class LinkParams:
+    """Connection parameters the firmware last requested (the central may have chosen others)."""
+    profile: str            # "none" = the central's own choice
+    min_interval_ms: float
+    max_interval_ms: float
+    latency: int            # connection events the device may skip
+    timeout_ms: int
+    requests: int           # update requests sent on this connection
+    sent: bool
+    data_length: bool       # the device's controller accepted the 251-byte data length request
+    phy_2m: bool            # ... and the 2M PHY request (the central may still stay on 1M / 27 bytes)
+    reconnects: Optional[int] = None          # since boot (saturates at 255); None = older firmware
+    reconnect_last_ms: Optional[int] = None   # disconnect by the central to the next connection
+    reconnect_mean_ms: Optional[int] = None
+    reconnect_max_ms: Optional[int] = None
+
+
+def parse_link_params(data: bytes) -> Optional[LinkParams]:
+    """Decode the link characteristic (intervals in 1.25 ms units, timeout in 10 ms units)."""
+    if len(data) < LINK_STRUCT.size:
+        return None
+    profile, min_interval, max_interval, latency, timeout, requests, sent, flags = LINK_STRUCT.unpack_from(data)
+    name = CONN_PROFILES[profile] if profile < len(CONN_PROFILES) else f"unknown({profile})"
+    params = LinkParams(name, min_interval * 1.25, max_interval * 1.25, latency, timeout * 10, requests, sent == 1,
+                        bool(flags & 0x01), bool(flags & 0x02))
+    if len(data) >= LINK_STRUCT.size + LINK_RECONNECT_STRUCT.size:
+        (params.reconnects, params.reconnect_last_ms, params.reconnect_mean_ms,
+         params.reconnect_max_ms) = LINK_RECONNECT_STRUCT.unpack_from(data, LINK_STRUCT.size)
+    return params
+
+
+BENCHMARK_SUMMARY = struct.Struct('<IIII')
+BENCHMARK_REFUSED = struct.Struct('<I')
+BENCHMARK_MARKER = 0xFFFFFFFF
+LOOPBACK_COMMAND = struct.Struct('<HHI')
+LOOPBACK_ECHO = struct.Struct('<IHI')
+LOOPBACK_REPORT = struct.Struct('<IIIHHHH')
+LOOPBACK_ECHO_COMMAND = 0xFFFF
+LOOPBACK_REPORT_COMMAND = 0xFFFE
+LOOPBACK_ECHO_MARKER = 0xFFFFFFFE
+LOOPBACK_REPORT_MARKER = 0xFFFFFFFD
+
+
+@dataclass
+class BenchmarkResult:
+    """One throughput benchmark run: the device's send side and what reached the host."""
+    sent_packets: int
+    sent_bytes: int
+    device_ms: int
+    received_packets: int
+    received_bytes: int
+    host_s: float
+    refused_packets: int = 0
+    missing_packets: int = 0
+
+    @property
+    def throughput_kbps(self) -> float:
+        """Received application payload in kbit/s over the host's receive time."""
+        return self.received_bytes * 8 / 1000 / self.host_s if self.host_s > 0 else 0.0
+
+    @property
+    def device_kbps(self) -> float:
+        """Payload the device queued in kbit/s over its own send time."""
+        return self.sent_bytes * 8 / self.device_ms if self.device_ms > 0 else 0.0
+
+
+@dataclass
+class LoopbackReport:
+    """The device's side of a loopback session: round trips timed on its clock."""
+    round_trips: int
+    refused: int
+    p50_ms: float
+    p95_ms: float
+    p99_ms: float
+    max_ms: float
+
+
+@dataclass
+class LoopbackResult:
+    """One loopback session: host round trips (ms), unanswered writes and the device's report."""
+    rtt_ms: List[float]
+    sent: int
+    lost: int
+    device: Optional[LoopbackReport] = None
+
+    def percentile(self, p: float) -> float:
+        return percentile(self.rtt_ms, p)
+
+
+def encode_benchmark(duration_ms: int, att_mtu: Optional[int] = None) -> bytes:
+    """Benchmark command: stream for duration_ms (0 = stop), packets sized to att_mtu when given."""
+    duration_ms = min(max(duration_ms, 0), 0xFFFF)
+    if att_mtu is None:
+        return struct.pack('<H', duration_ms)
+    return struct.pack('<HH', duration_ms, min(max(att_mtu, 23), 0xFFFF))
+
+
+def parse_benchmark_report(data: bytes) -> Optional[Tuple[int, int, int, int]]:
+    """(packets, bytes, elapsed ms, refused) for the benchmark's closing notification, None for a data packet.
+
+    Firmware before the refused count sends the 16-byte summary; refused is then 0.
+    """
+    if len(data) not in (BENCHMARK_SUMMARY.size, BENCHMARK_SUMMARY.size + BENCHMARK_REFUSED.size):
+        return None
+    marker, packets, sent_bytes, elapsed_ms = BENCHMARK_SUMMARY.unpack_from(data)
+    if marker != BENCHMARK_MARKER:
+        return None
+    refused = BENCHMARK_REFUSED.unpack_from(data, BENCHMARK_SUMMARY.size)[0] if len(data) > BENCHMARK_SUMMARY.size else 0
+    return packets, sent_bytes, elapsed_ms, refused
+
+
+def parse_benchmark_summary(data: bytes) -> Optional[Tuple[int, int, int]]:
+    """(packets, bytes, elapsed ms) for the benchmark's closing notification, None for a data packet."""
+    report = parse_benchmark_report(data)
+    return report[:3] if report is not None else None
+
+
+def encode_loopback(sequence: int, echoed_us: int, padding: int = 0) -> bytes:
+    """Loopback write: sequence, device time of the previous echo (0 = none), then padding bytes."""
+    return LOOPBACK_COMMAND.pack(LOOPBACK_ECHO_COMMAND, sequence & 0xFFFF, echoed_us & 0xFFFFFFFF) + \
+        bytes(i & 0xFF for i in range(max(padding, 0)))
+
+
+def encode_loopback_report() -> bytes:
+    """Ends a loopback session; the device answers with its LoopbackReport."""
+    return LOOPBACK_COMMAND.pack(LOOPBACK_REPORT_COMMAND, 0, 0)
+
+
+def parse_loopback_echo(data: bytes) -> Optional[Tuple[int, int]]:
+    """(sequence, device time µs) of a loopback echo, None for any other notification."""
+    if len(data) < LOOPBACK_ECHO.size:
+        return None
+    marker, sequence, device_us = LOOPBACK_ECHO.unpack_from(data)
+    return (sequence, device_us) if marker == LOOPBACK_ECHO_MARKER else None
+
+
+def parse_loopback_report(data: bytes) -> Optional[LoopbackReport]:
+    """The device's loopback report, None for any other notification."""
+    if len(data) != LOOPBACK_REPORT.size:
+        return None
+    marker, round_trips, refused, p50, p95, p99, worst = LOOPBACK_REPORT.unpack(data)
+    if marker != LOOPBACK_REPORT_MARKER:
+        return None
+    return LoopbackReport(round_trips, refused, p50 / 10, p95 / 10, p99 / 10, worst / 10)
+
+
+# On-device inference benchmark (firmware inference_bench_report_t): stages and modes in firmware order
+INFERENCE_BENCH_STAGES = ("dsp", "classify", "postprocess", "total")
+INFERENCE_BENCH_MODES = ("synthetic", "live")
+INFERENCE_BENCH_STATES = ("none", "running", "done", "failed")
+INFERENCE_BENCH_HEADER = struct.Struct('<BBH')
+INFERENCE_BENCH_STATS = struct.Struct('<5I')
+INFERENCE_BENCH_SIZE = INFERENCE_BENCH_HEADER.size + len(INFERENCE_BENCH_STAGES) * INFERENCE_BENCH_STATS.size
+
+
+@dataclass
+class InferenceBenchStats:
+    """One stage's times over the benchmark runs, µs on the device clock."""
+    min_us: int
+    p50_us: int
+    p95_us: int
+    p99_us: int
+    max_us: int
+
+
+@dataclass
+class InferenceBenchReport:
+    """The device's inference benchmark: per-stage percentiles of a synthetic or live run."""
+    mode: str
+    state: str
+    runs: int
+    stages: Dict[str, InferenceBenchStats]
+
+
+def encode_inference_benchmark(mode: str = "synthetic", runs: int = 100) -> bytes:
+    """Benchmark request: mode ("synthetic" or "live") and the number of inferences to time."""
+    return struct.pack('<BH', INFERENCE_BENCH_MODES.index(mode), min(max(runs, 1), 0xFFFF))
+
+
+def parse_inference_benchmark(data: bytes) -> Optional[InferenceBenchReport]:
+    """The inference benchmark report, None when truncated (a notification at a small MTU: read the rest)."""
+    if len(data) < INFERENCE_BENCH_SIZE:
+        return None
+    mode, state, runs = INFERENCE_BENCH_HEADER.unpack_from(data)
+    stages = {}
+    for i, name in enumerate(INFERENCE_BENCH_STAGES):
+        offset = INFERENCE_BENCH_HEADER.size + i * INFERENCE_BENCH_STATS.size
+        stages[name] = InferenceBenchStats(*INFERENCE_BENCH_STATS.unpack_from(data, offset))
+    mode_name = INFERENCE_BENCH_MODES[mode] if mode < len(INFERENCE_BENCH_MODES) else str(mode)
+    state_name = INFERENCE_BENCH_STATES[state] if state < len(INFERENCE_BENCH_STATES) else str(state)
+    return InferenceBenchReport(mode_name, state_name, runs, stages)
+
+
+def encode_ack(sequence: int, att_mtu: Optional[int] = None) -> bytes:
+    """Acknowledgement written back after acting on a result event (its low 16-bit sequence).
+
+    With att_mtu the ack also reports the connection's ATT MTU, so the device fills
+    each events notification up to it instead of assuming the 23-byte default.
+    """
+    if att_mtu is None:
+        return struct.pack('<H', sequence & 0xFFFF)
+    return struct.pack('<HH', sequence & 0xFFFF, min(max(att_mtu, 23), 0xFFFF))
+
+
+# Preset order of the config characteristic (config_profile_t in include/config_module.h)
+CONFIG_PROFILES = ("default", "low-latency", "low-power", "custom")
+
+CONFIG_STRUCT = struct.Struct('<BBBBBH')
+
+
+@dataclass
+class RuntimeConfig:
+    """Runtime configuration of the firmware (see src/config_module.cpp)."""
+    profile: str
+    ble_min_confidence: float        # results below it are not sent over BLE
+    led_confidence_threshold: float  # results at or below it are not shown on the LED
+    stride_fine_samples: int         # inference stride; the coarse one applies while idle is stable
+    stride_coarse_samples: int
+    ble_poll_interval_ms: int
+
+
+def parse_config(data: bytes) -> Optional[RuntimeConfig]:
+    """Decode the config characteristic value."""
+    if len(data) < CONFIG_STRUCT.size:
+        return None
+    profile, ble, led, fine, coarse, poll_ms = CONFIG_STRUCT.unpack_from(data)
+    name = CONFIG_PROFILES[profile] if profile < len(CONFIG_PROFILES) else f"profile {profile}"
+    return RuntimeConfig(name, ble / 255.0, led / 255.0, fine, coarse, poll_ms)
+
+
+def encode_config(config: RuntimeConfig) -> bytes:
+    """Full config write: the firmware applies the values as a custom profile."""
+    def confidence(value: float) -> int:
+        return max(0, min(255, round(value * 255)))
+    return CONFIG_STRUCT.pack(CONFIG_PROFILES.index("custom"), confidence(config.ble_min_confidence),
+                              confidence(config.led_confidence_threshold), config.stride_fine_samples,
+                              config.stride_coarse_samples, config.ble_poll_interval_ms)
+
+
+def encode_profile(profile: str) -> bytes:
+    """Single-byte config write switching the firmware to a preset."""
+    index = CONFIG_PROFILES.index(profile)
+    if profile == "custom":
+        raise ValueError("custom is not a preset")
+    return bytes([index])
+
+
+MODEL_STATUS = struct.Struct('<BBBxIII')
+MODEL_START = struct.Struct('<B3xII')
+MODEL_CHUNK_HEADER = struct.Struct('<I')
+MODEL_START_COMMAND = 0x01
+MODEL_FINISH_COMMAND = 0x02
+MODEL_BUILTIN_COMMAND = 0x03
+MODEL_ABORT_COMMAND = 0x04
+# model_slot_state_t / model_slot_error_t in include/model_slot_module.h
+MODEL_STATES = ("builtin", "active", "receiving", "pending")
+MODEL_ERRORS = ("ok", "size", "flash", "offset", "crc", "format", "tensor", "verify", "state")
+NO_MODEL_SLOT = 0xFF
+
+
+@dataclass
+class ModelStatus:
+    """Model update state of the device (model control characteristic)."""
+    state: str              # builtin / active (weights from a flash slot) / receiving / pending
+    error: str              # reason of the last failed command or switch, "ok" when none
+    slot: Optional[int]     # flash slot in use, None for the built-in weights
+    received: int           # bytes of the current upload written to flash
+    total: int
+    version: int            # version of the weights in use (0 = built-in)
+
+
+def parse_model_status(data: bytes) -> Optional[ModelStatus]:
+    if len(data) < MODEL_STATUS.size:
+        return None
+    state, error, slot, received, total, version = MODEL_STATUS.unpack_from(data)
+    return ModelStatus(MODEL_STATES[state] if state < len(MODEL_STATES) else f"unknown({state})",
+                       MODEL_ERRORS[error] if error < len(MODEL_ERRORS) else f"unknown({error})",
+                       None if slot == NO_MODEL_SLOT else slot, received, total, version)
+
+
+def encode_model_start(total_bytes: int, crc32: int) -> bytes:
+    return MODEL_START.pack(MODEL_START_COMMAND, total_bytes, crc32)
+
+
+def model_chunks(blob: bytes, chunk_bytes: int, start: int = 0) -> List[bytes]:
+    """Data writes for blob[start:]: uint32 offset + up to chunk_bytes (a multiple of 4, except the last)."""
+    chunk_bytes = max(4, chunk_bytes - chunk_bytes % 4)
+    return [MODEL_CHUNK_HEADER.pack(offset) + blob[offset:offset + chunk_bytes]
+            for offset in range(start, len(blob), chunk_bytes)]
+
+
+FEWSHOT_STATUS = struct.Struct('<BBBBHHIb3xI')
+FEWSHOT_RECORD_COMMAND = 0x01
+FEWSHOT_COMMIT_COMMAND = 0x02
+FEWSHOT_ERASE_COMMAND = 0x03
+FEWSHOT_CANCEL_COMMAND = 0x04
+FEWSHOT_ALL_CLASSES = 0xFF
+# fewshot_state_t / fewshot_error_t in include/fewshot_module.h
+FEWSHOT_STATES = ("idle", "capturing", "enrolling")
+FEWSHOT_ERRORS = ("ok", "class", "windows", "flash", "model", "state")
+
+
+@dataclass
+class FewShotStatus:
+    """Custom gesture state of the device (custom gesture characteristic, INFERENCE_FEWSHOT)."""
+    state: str              # idle / capturing (recording one example) / enrolling (examples kept, not committed)
+    error: str              # reason of the last failed command, "ok" when none
+    enroll_class: Optional[int]  # class being recorded, None when none
+    classes: List[int]      # enrolled classes the device recognizes
+    examples: int           # examples recorded for enroll_class
+    windows: int            # model windows collected over those examples
+    matches: int            # custom gestures recognized since boot
+    last_class: Optional[int]    # last recognized custom gesture, None before the first
+    last_distance: int      # its squared distance to the class centroid
+
+
+def parse_fewshot_status(data: bytes) -> Optional[FewShotStatus]:
+    if len(data) < FEWSHOT_STATUS.size:
+        return None
+    state, error, enroll_class, mask, examples, windows, matches, last_class, last_distance = \
+        FEWSHOT_STATUS.unpack_from(data)
+    return FewShotStatus(FEWSHOT_STATES[state] if state < len(FEWSHOT_STATES) else f"unknown({state})",
+                         FEWSHOT_ERRORS[error] if error < len(FEWSHOT_ERRORS) else f"unknown({error})",
+                         None if enroll_class == 0xFF else enroll_class,
+                         [k for k in range(8) if mask & (1 << k)], examples, windows, matches,
+                         None if last_class < 0 else last_class, last_distance)
+
+
+def encode_fewshot_command(command: int, class_index: Optional[int] = None) -> bytes:
+    return bytes([command]) if class_index is None else bytes([command, class_index & 0xFF])
+
+
+TELEMETRY_STATUS = struct.Struct('<BBH5I')
+# Appended by firmware that can capture low-confidence windows (zero without CAPTURE_ENABLE)
+TELEMETRY_CAPTURE_STATUS = struct.Struct('<3I')
+TELEMETRY_STATUS_COMMAND = 0x00
+TELEMETRY_DUMP_COMMAND = 0x01
+TELEMETRY_STOP_COMMAND = 0x02
+TELEMETRY_DUMP_CAPTURES_COMMAND = 0x03
+TELEMETRY_CHUNK_HEADER = struct.Struct('<I')
+
+
+@dataclass
+class TelemetryStatus:
+    """Diagnostics log state of the device (telemetry characteristic, TELEMETRY_ENABLE)."""
+    dumping: bool
+    sectors: int            # 4 KB flash sectors in the ring
+    pending_bytes: int      # records waiting in RAM for the next flash write
+    records: int            # records appended since boot
+    dropped: int            # records dropped since boot (RAM batch full)
+    log_bytes: int          # record bytes in flash: the length of a dump
+    sequence: int           # sectors opened over the log's lifetime (each one erased once)
+    flash_errors: int
+    dumping_captures: bool = False  # the running dump reads the captured windows instead of the log
+    captured: int = 0               # low-confidence windows captured since boot (CAPTURE_ENABLE)
+    capture_suppressed: int = 0     # ambiguous windows not captured since boot (rate limit or queue full)
+    capture_bytes: int = 0          # captured windows in flash: the length of a capture dump
+
+
+def parse_telemetry_status(data: bytes) -> Optional[TelemetryStatus]:
+    if len(data) < TELEMETRY_STATUS.size:
+        return None
+    state, sectors, pending, records, dropped, log_bytes, sequence, errors = TELEMETRY_STATUS.unpack_from(data)
+    status = TelemetryStatus(state != 0, sectors, pending, records, dropped, log_bytes, sequence, errors, state == 2)
+    if len(data) >= TELEMETRY_STATUS.size + TELEMETRY_CAPTURE_STATUS.size:
+        status.captured, status.capture_suppressed, status.capture_bytes = \
+            TELEMETRY_CAPTURE_STATUS.unpack_from(data, TELEMETRY_STATUS.size)
+    return status
+
+
+class TelemetryDump:
+    """Reassembles the chunks of one log dump: uint32 offset + records; the offset alone ends it."""
+
+    def __init__(self):
+        self.data = bytearray()
+        self.finished = False
+        self.gap = False
+
+    def feed(self, chunk: bytes) -> bool:
+        """Add one chunk; True once the dump has ended (check gap for a lost chunk)."""
+        if len(chunk) < TELEMETRY_CHUNK_HEADER.size or self.finished:
+            return self.finished
+        offset = TELEMETRY_CHUNK_HEADER.unpack_from(chunk)[0]
+        payload = chunk[TELEMETRY_CHUNK_HEADER.size:]
+        if offset > len(self.data):
+            self.gap = True
+        elif offset == len(self.data):
+            self.data += payload
+        if not payload:
+            self.finished = True
+        return self.finished
+
+
+COMBO_HEADER = struct.Struct('<BH')
+COMBO_EVENT = struct.Struct('<BBHII')
+COMBO_DEFAULT_GAP_MS = 800
+
+
+@dataclass
+class ComboTable:
+    """Gesture combos of the device (combo characteristic, BLE_COMBO_ENABLE): model label indices per combo."""
+    gap_ms: int                 # longest pause between two gestures of a combo
+    combos: List[List[int]]
+
+
+def encode_combos(table: ComboTable) -> bytes:
+    data = bytearray(COMBO_HEADER.pack(len(table.combos), table.gap_ms))
+    for combo in table.combos:
+        data.append(len(combo))
+        data += bytes(combo)
+    return bytes(data)
+
+
+def parse_combos(data: bytes) -> Optional[ComboTable]:
+    if len(data) < COMBO_HEADER.size:
+        return None
+    count, gap_ms = COMBO_HEADER.unpack_from(data)
+    combos = []
+    offset = COMBO_HEADER.size
+    for _ in range(count):
+        if offset >= len(data) or offset + 1 + data[offset] > len(data):
+            return None
+        combos.append(list(data[offset + 1:offset + 1 + data[offset]]))
+        offset += 1 + data[offset]
+    return ComboTable(gap_ms, combos)
+
+
+@dataclass
+class ComboEvent:
+    """A combo the device completed."""
+    combo: int          # position in the combo table
+    length: int
+    sequence: int       # low 16 bits of the result that completed it
+    start_ms: int       # device clock: first and last gesture
+    end_ms: int
+
+
+def parse_combo_event(data: bytes) -> Optional[ComboEvent]:
+    if len(data) < COMBO_EVENT.size:
+        return None
+    return ComboEvent(*COMBO_EVENT.unpack_from(data))
+
+
+# Inference operating points of the battery ladder (BATTERY_LADDER_ENABLE, include/inference_module.h)
+POWER_POINTS = ("full", "coarse", "idle-filter", "on-demand")
+POWER_STRUCT = struct.Struct('<BBH')
+
+
+@dataclass
+class PowerState:
+    """Operating point the device picked from its battery voltage: later points trade latency for battery life."""
+    point: str
+    measured: bool      # False until the first measurement: millivolts is 0
+    millivolts: int
+
+
+def parse_power(data: bytes) -> Optional[PowerState]:
+    """Decode the power characteristic (src/ble_module.cpp); None for a short payload or an unknown point."""
+    if len(data) < POWER_STRUCT.size:
+        return None
+    point, flags, millivolts = POWER_STRUCT.unpack_from(data)
+    if point >= len(POWER_POINTS):
+        return None
+    return PowerState(POWER_POINTS[point], bool(flags & 1), millivolts)
+
+
+# Two-byte config write carrying the host's operating point (CONFIG_OPERATING_POINT_MARKER in include/config_module.h)
+OPERATING_POINT_MARKER = 0xFE
+OPERATING_POINT_RELEASE = 0xFF
+
+
+def encode_operating_point(point: Optional[str]) -> bytes:
+    """Operating-point command: the device runs at least as conservatively as point until the session ends
+    (None releases it). It leaves the runtime configuration alone; "on-demand" needs the firmware's tap arming."""
+    return bytes([OPERATING_POINT_MARKER, OPERATING_POINT_RELEASE if point is None else POWER_POINTS.index(point)])
+
+
+@dataclass
+class Heartbeat:
+    """The device's idle heartbeat on the events characteristic (sent only while no events flow)."""
+    uptime_ms: int                  # device millis()
+    delivery: int                   # delivery number of the next event: a lower count means events were missed
+    power: Optional[PowerState]     # point in effect (millivolts 0 without the battery ladder); None from older firmware
+
+
+def parse_heartbeat(data: bytes) -> Optional[Heartbeat]:
+    """The heartbeat record ending an events notification (src/ble_module.cpp), None when there is none."""
+    if len(data) < EVENT_HEADER.size + HEARTBEAT.size or (len(data) - EVENT_HEADER.size) % HEARTBEAT.size:
+        return None
+    marker, point, millivolts, uptime_ms = HEARTBEAT.unpack_from(data, len(data) - HEARTBEAT.size)
+    if marker != HEARTBEAT_MARKER:
+        return None
+    power = PowerState(POWER_POINTS[point], millivolts != 0, millivolts) if point < len(POWER_POINTS) else None
+    return Heartbeat(uptime_ms, EVENT_HEADER.unpack_from(data)[1], power)
+
+
+class HeartbeatMonitor:
+    """Stall detection on a connection whose device sends idle heartbeats.
+
+    Every events notification (a burst or a heartbeat) proves the link alive; it
+    counts as stalled once missed_limit heartbeat intervals went by without one,
+    however long the device has been idle. Without an interval (older firmware)
+    it never stalls and the OS supervision timeout is all there is.
+    """
+
+    def __init__(self, missed_limit: int = 3):
+        self.missed_limit = missed_limit
+        self.interval_s: Optional[float] = None
+        self.stalls = 0
+        self._last: Optional[float] = None
+
+    def start(self, interval_s: Optional[float], now: float) -> None:
+        self.interval_s = interval_s
+        self._last = now
+
+    def alive(self, now: float) -> None:
+        self._last = now
+
+    def stalled(self, now: float) -> bool:
+        if self.interval_s is None or self._last is None:
+            return False
+        if now - self._last < self.missed_limit * self.interval_s:
+            return False
+        self.stalls += 1
+        self._last = now
+        return True
+
+
+# Zone trace stream (BLE_TRACE_STREAM_ENABLE): a TRACE_HEADER, then a TRACE_ZONE per record (wire_schema.py)
+@dataclass
+class TracePacket:
+    """Zones the device recorded since the previous packet, oldest first."""
+    device_ms: int
+    now_cycles: int
+    clock_hz: int
+    lost: bool          # zones were overwritten on the device before they could be sent
+    zones: List[Tuple[int, int, int]]
+
+
+def parse_trace(data: bytes) -> Optional[TracePacket]:
+    """Decode a trace notification (src/ble_module.cpp); None when it is short or has no clock."""
+    if len(data) < TRACE_HEADER.size:
+        return None
+    device_ms, now_cycles, clock_khz, count = TRACE_HEADER.unpack_from(data)
+    zones = count & ~TRACE_LOST
+    if clock_khz == 0 or len(data) < TRACE_HEADER.size + zones * TRACE_ZONE.size:
+        return None
+    return TracePacket(device_ms, now_cycles, clock_khz * 1000, bool(count & TRACE_LOST),
+                       list(iter_records(TRACE_ZONE, data, TRACE_HEADER.size, zones)))
+
+
+# Crash report of the reset before this boot (CRASH_CAPTURE_ENABLE, include/crash_module.h)
+CRASH_KINDS = ("none", "fault", "stack overflow", "error", "watchdog reset")
+CRASH_HEADER = struct.Struct('<BBBB10I')
+# thread_role_t and pipeline_stage_t order
+CRASH_THREADS = ("sampler", "inference", "ble", "events", "record", "hci")
+PIPELINE_STAGES = ("acquire", "window", "infer", "postprocess", "ble", "led")
+
+
+@dataclass
+class CrashReport:
+    """What the device recorded when it crashed (or was reset by the watchdog) before this boot."""
+    kind: str
+    thread: Optional[str]            # None: main thread or an interrupt
+    status: int                      # mbed_error_status_t
+    uptime_ms: int
+    pc: int
+    lr: int
+    sp: int
+    value: int
+    cfsr: int
+    hfsr: int
+    mmfar: int
+    bfar: int
+    stacks: Dict[str, Tuple[int, int]]          # thread: (stack bytes, peak bytes); peaks are 0 after a watchdog reset
+    trail: List[Tuple[str, int, int]]           # (stage, start µs, duration µs), oldest first
+
+
+def _name(names: Tuple[str, ...], index: int) -> str:
+    return names[index] if index < len(names) else str(index)
+
+
+def parse_crash(data: bytes) -> Optional[CrashReport]:
+    """Decode the crash characteristic (src/crash_module.cpp); None when there was no crash or it is short."""
+    if len(data) < CRASH_HEADER.size or data[0] == 0:
+        return None
+    kind, thread, trail_count, thread_count, *words = CRASH_HEADER.unpack_from(data)
+    offset = CRASH_HEADER.size
+    if len(data) < offset + 4 * thread_count + 8 * trail_count:
+        return None
+    stacks = {}
+    for i in range(thread_count):
+        stacks[_name(CRASH_THREADS, i)] = struct.unpack_from('<HH', data, offset)
+        offset += 4
+    trail = []
+    for _ in range(trail_count):
+        start_us, duration_us, stage = struct.unpack_from('<IHB', data, offset)
+        trail.append((_name(PIPELINE_STAGES, stage), start_us, duration_us))
+        offset += 8
+    return CrashReport(_name(CRASH_KINDS, kind), None if thread == 0xFF else _name(CRASH_THREADS, thread),
+                       *words, stacks, trail)
+
+
+@dataclass
+class ModelUploadResult:
+    """Outcome of one model upload: the device's final status and the transfer time."""
+    status: ModelStatus
+    transfer_s: float       # start command to the finish command's answer
+    switch_s: float         # finish to the inference thread's switch (validation and self-test included)
+
+    @property
+    def ok(self) -> bool:
+        return self.status.state == "active" and self.status.error == "ok"
+
+
+class BLEManager:
+    """BLE connection and data management."""
+    
+    # UUIDs matching the Arduino firmware (lowercase for better compatibility)
+    SERVICE_UUID = "19b10010-e8f2-537e-4f6c-d104768a1214"
+    PREDICTION_UUID = "19b10011-e8f2-537e-4f6c-d104768a1214"
+    CONFIDENCE_UUID = "19b10012-e8f2-537e-4f6c-d104768a1214"
+    EVENTS_UUID = "19b10016-e8f2-537e-4f6c-d104768a1214"
+    CPU_UUID = "19b10017-e8f2-537e-4f6c-d104768a1214"
+    ACK_UUID = "19b10018-e8f2-537e-4f6c-d104768a1214"
+    LATENCY_UUID = "19b10019-e8f2-537e-4f6c-d104768a1214"
+    CONFIG_UUID = "19b1001a-e8f2-537e-4f6c-d104768a1214"
+    GESTURE_UUID = "19b1001b-e8f2-537e-4f6c-d104768a1214"
+    LINK_UUID = "19b1001c-e8f2-537e-4f6c-d104768a1214"
+    BENCHMARK_UUID = "19b1001d-e8f2-537e-4f6c-d104768a1214"
+    SCORES_UUID = "19b1001e-e8f2-537e-4f6c-d104768a1214"
+    WINDOW_UUID = WINDOW_UUID
+    KEYMAP_UUID = "19b10020-e8f2-537e-4f6c-d104768a1214"
+    MISSED_UUID = "19b10021-e8f2-537e-4f6c-d104768a1214"
+    MODEL_CONTROL_UUID = "19b10022-e8f2-537e-4f6c-d104768a1214"
+    MODEL_DATA_UUID = "19b10023-e8f2-537e-4f6c-d104768a1214"
+    TIME_SYNC_UUID = "19b10024-e8f2-537e-4f6c-d104768a1214"
+    COUNTERS_UUID = "19b10025-e8f2-537e-4f6c-d104768a1214"
+    STREAMS_UUID = "19b10026-e8f2-537e-4f6c-d104768a1214"
+    LAYOUT_UUID = "19b10027-e8f2-537e-4f6c-d104768a1214"
+    SEGMENT_UUID = "19b10028-e8f2-537e-4f6c-d104768a1214"
+    ONSET_UUID = "19b10033-e8f2-537e-4f6c-d104768a1214"
+    STATS_UUID = "19b10034-e8f2-537e-4f6c-d104768a1214"
+    INFERENCE_BENCH_UUID = "19b10029-e8f2-537e-4f6c-d104768a1214"
+    FEWSHOT_UUID = "19b1002a-e8f2-537e-4f6c-d104768a1214"
+    TELEMETRY_UUID = "19b1002b-e8f2-537e-4f6c-d104768a1214"
+    COMBO_UUID = "19b1002d-e8f2-537e-4f6c-d104768a1214"
+    COMBO_EVENT_UUID = "19b1002e-e8f2-537e-4f6c-d104768a1214"
+    POWER_UUID = "19b1002f-e8f2-537e-4f6c-d104768a1214"
+    TRACE_UUID = "19b10030-e8f2-537e-4f6c-d104768a1214"
+    CRASH_UUID = "19b10031-e8f2-537e-4f6c-d104768a1214"
+    TELEMETRY_DATA_UUID = "19b1002c-e8f2-537e-4f6c-d104768a1214"
+    BULK_UUID = BULK_UUID
+    # Clock sync: rounds of TIME_SYNC_ROUND requests TIME_SYNC_SPACING_S apart (the first wakes the device's
+    # fast polling, the rest are answered without the poll interval wait), every TIME_SYNC_INTERVAL_S
+    TIME_SYNC_ROUND = 4
+    TIME_SYNC_SPACING_S = 0.03
+    TIME_SYNC_INTERVAL_S = 2.0
+    # Retransmitted events older than this (device time, against the newest event) are counted, not acted on
+    RECOVER_MAX_AGE_MS = 1000
+    # With a cached address, other boards answering the name scan are only taken after this long
+    PREFER_KNOWN_S = 1.5
+    # scan_devices() ends this long after the newest target device (up to its timeout)
+    SCAN_SETTLE_S = 2.0
+    # Reconnects scan in windows of RECONNECT_SCAN_S and connect on the device's first advertisement;
+    # they give up after RECONNECT_GIVE_UP_S without one
+    RECONNECT_SCAN_S = 5.0
+    RECONNECT_GIVE_UP_S = 60.0
+
+    # Class order of the deployed model (event indices refer to it), generated by label_table_gen.py
+    MODEL_LABELS = DEPLOYED_LABELS
+    
+    TARGET_DEVICE_NAME = "5ClassForwarder"
+    
+    def __init__(self):
+        """Initialize BLEManager."""
+        self._client: Optional[BleakClient] = None
+        # Builds the client on connect: BleakClient, or a stand-in that records or replays a session (ble_session.py)
+        self._client_factory: Callable[..., BleakClient] = BleakClient
+        self._gesture_callback: Optional[Callable[[str, float], None]] = None
+        self._event_callback: Optional[Callable[[str, float, float], None]] = None
+        self._status_callback: Optional[Callable[[str], None]] = None
+        self._cpu_callback: Optional[Callable[[CpuUtilization], None]] = None
+        self._counters_callback: Optional[Callable[[DeliveryCounters], None]] = None
+        self._stats_callback: Optional[Callable[[Stat], None]] = None
+        self._latency_callback: Optional[Callable[[LatencyReport], None]] = None
+        self._breakdown_callback: Optional[Callable[[LatencyBreakdown], None]] = None
+        self._config_callback: Optional[Callable[[RuntimeConfig], None]] = None
+        self._link_callback: Optional[Callable[[LinkParams], None]] = None
+        self._scores_callback: Optional[Callable[[ScoreFrame], None]] = None
+        self._window_callback: Optional[Callable[[RawPacket], None]] = None
+        self._hold_callback: Optional[Callable[[str, bool], None]] = None
+        self._combo_callback: Optional[Callable[[ComboEvent], None]] = None
+        self._power_callback: Optional[Callable[[PowerState], None]] = None
+        self._trace_callback: Optional[Callable[[TracePacket], None]] = None
+        self._crash_callback: Optional[Callable[[CrashReport], None]] = None
+        self._held_gesture: Optional[str] = None
+        self._onset_callback: Optional[Callable[[str, str], None]] = None
+        # (onset number, gesture) of the provisional onset not resolved yet
+        self._pending_onset: Optional[Tuple[int, str]] = None
+        self._window_decoder = StreamDecoder(TYPE_WINDOW)
+        self._bulk: Optional[L2capChannel] = None
+        # Record type to handler for what arrives on the bulk channel (l2cap_channel.py)
+        self._bulk_handlers: Dict[int, Callable[[bytes], None]] = {}
+        self._keymap_provider: Optional[Callable[[], Dict[str, str]]] = None
+        self._layout_load: Optional[Callable[[str], Optional[int]]] = None
+        self._layout_save: Optional[Callable[[str, int], None]] = None
+        self._connect_lock: Optional[asyncio.Lock] = None
+        self._device_hid = False
+        self._ack_supported = False
+        self._missed_supported = False
+        self._delivery = DeliveryTracker()
+        self._confidence = LEGACY_CONFIDENCE  # result confidence format of the connected device
+        self._heartbeat_interval_s: Optional[float] = None  # from the layout characteristic
+        self._heartbeat = HeartbeatMonitor()
+        self._heartbeat_task: Optional[asyncio.Task] = None
+        self._last_heartbeat: Optional[Heartbeat] = None
+        self._newest_event_ms: Optional[int] = None
+        self._att_mtu: Optional[int] = None
+        self._clock = ClockSync()
+        self._latency = LatencyTracker()
+        self._time_sync_task: Optional[asyncio.Task] = None
+        self._time_sync_sent: Dict[int, float] = {}
+        self._time_sync_sequence = 0
+        self._connected = False
+        self._current_gesture: Optional[str] = None
+        self._gesture_sequence: Optional[int] = None
+        self._reconnect_enabled = True
+        self._reconnect_attempts = 0
+        self._max_reconnect_attempts = 5
+        self._reconnect_task: Optional[asyncio.Task] = None
+        self._last_device_address: Optional[str] = None
+        self._discovered_devices: List[BLEDevice] = []
+        self._scan_stop: Optional[asyncio.Event] = None
+        self._scan_done: Optional[asyncio.Event] = None
+    
+    def set_client_factory(self, factory: Callable[..., BleakClient]) -> None:
+        """Build clients with factory(device, disconnected_callback=..., timeout=..., winrt=...) instead of BleakClient."""
+        self._client_factory = factory
+
+    def set_gesture_callback(self, callback: Callable[[str, float], None]) -> None:
+        """Set callback for gesture data. Signature: callback(gesture, confidence)"""
+        self._gesture_callback = callback
+
+    def set_event_callback(self, callback: Callable[[str, float, float], None]) -> None:
+        """Set callback for results with their publish time. Signature: callback(gesture, confidence, time_s)
+
+        time_s is the device's publish time on the host clock (time.perf_counter) once the clock is
+        synced, the arrival time before that, so streams of several boards can be lined up.
+        """
+        self._event_callback = callback
+    
+    def set_status_callback(self, callback: Callable[[str], None]) -> None:
+        """Set callback for connection status changes."""
+        self._status_callback = callback
+
+    def set_cpu_callback(self, callback: Callable[[CpuUtilization], None]) -> None:
+        """Set callback for the firmware's periodic CPU utilization reports."""
+        self._cpu_callback = callback
+
+    def set_counters_callback(self, callback: Callable[[DeliveryCounters], None]) -> None:
+        """Set callback for the firmware's periodic delivery counters."""
+        self._counters_callback = callback
+
+    def set_stats_callback(self, callback: Callable[[Stat], None]) -> None:
+        """Set callback for the firmware's registered statistics, one entry per diagnostics interval in turn."""
+        self._stats_callback = callback
+
+    def set_latency_callback(self, callback: Callable[[LatencyReport], None]) -> None:
+        """Set callback for the firmware's periodic latency / watchdog reports."""
+        self._latency_callback = callback
+
+    def set_breakdown_callback(self, callback: Callable[[LatencyBreakdown], None]) -> None:
+        """Set callback for the per-stage latency breakdown (after every result, once the clocks are synced)."""
+        self._breakdown_callback = callback
+
+    def clock_sync(self) -> ClockSync:
+        """Device-to-host clock mapping of the current connection (offset, drift, round trip)."""
+        return self._clock
+
+    def latency_breakdown(self) -> LatencyBreakdown:
+        """Median latency of sensor, device, radio and host stages over the recent results."""
+        return self._latency.breakdown(self._clock)
+
+    def end_to_end_latency(self) -> Dict[float, Optional[float]]:
+        """p50 / p95 / p99 ms from classification on the device to the action queued here (synced clocks)."""
+        return self._latency.end_to_end_ms()
+
+    def set_config_callback(self, callback: Callable[[RuntimeConfig], None]) -> None:
+        """Set callback for the firmware's runtime configuration (sent on subscribe and after every change)."""
+        self._config_callback = callback
+
+    def set_link_callback(self, callback: Callable[[LinkParams], None]) -> None:
+        """Set callback for the connection parameters the firmware requests (on subscribe and on every switch)."""
+        self._link_callback = callback
+
+    def set_scores_callback(self, callback: Callable[[ScoreFrame], None]) -> None:
+        """Set callback for every inference's full score vector (the device only records them while subscribed)."""
+        self._scores_callback = callback
+
+    def set_window_callback(self, callback: Callable[[RawPacket], None]) -> None:
+        """Set callback for the samples fed to the model (raw_recorder.TYPE_WINDOW packets, streamed while subscribed)."""
+        self._window_callback = callback
+
+    def set_hold_callback(self, callback: Callable[[str, bool], None]) -> None:
+        """Set callback for gesture onsets and releases (segmenting firmware). Signature: callback(gesture, held)
+
+        A held gesture is always released: on the device's report, or when the connection goes away.
+        """
+        self._hold_callback = callback
+
+    def set_onset_callback(self, callback: Callable[[str, str], None]) -> None:
+        """Set callback for provisional gesture onsets (INFERENCE_ONSET_HEAD firmware). Signature: callback(gesture, state)
+
+        state is "provisional" as soon as the device sees the start of a gesture, then exactly once "confirmed"
+        (the full window agreed; the gesture also arrives as a normal result) or "canceled" (undo whatever the
+        provisional call started). The device only sends its latest state, so a new provisional onset or a lost
+        connection cancels one still pending.
+        """
+        self._onset_callback = callback
+
+    def set_combo_callback(self, callback: Callable[[ComboEvent], None]) -> None:
+        """Set callback for combos the device completed (write_combos sets what they are)."""
+        self._combo_callback = callback
+
+    def set_power_callback(self, callback: Callable[[PowerState], None]) -> None:
+        """Set callback for the operating point the device runs at (battery ladder firmware)."""
+        self._power_callback = callback
+
+    def set_trace_callback(self, callback: Callable[[TracePacket], None]) -> None:
+        """Set callback for the zone trace stream (firmware with BLE_TRACE_STREAM_ENABLE)."""
+        self._trace_callback = callback
+
+    def set_crash_callback(self, callback: Callable[[CrashReport], None]) -> None:
+        """Set callback for a crash before the device's last reset, reported once per connection."""
+        self._crash_callback = callback
+
+    def streams(self) -> int:
+        """Streams to ask the firmware for, from the callbacks set (events always)."""
+        streams = STREAM_EVENTS
+        if self._scores_callback:
+            streams |= STREAM_SCORES
+        if self._window_callback:
+            streams |= STREAM_WINDOW
+        if (self._cpu_callback or self._counters_callback or self._stats_callback or self._latency_callback or
+                self._breakdown_callback):
+            streams |= STREAM_DIAGNOSTICS
+        if self._trace_callback:
+            streams |= STREAM_TRACE
+        return streams
+
+    def set_layout_store(self, load: Callable[[str], Optional[int]], save: Callable[[str, int], None]) -> None:
+        """Set where the GATT layout hash of each device address is kept between runs."""
+        self._layout_load = load
+        self._layout_save = save
+
+    def set_keymap_provider(self, provider: Callable[[], Dict[str, str]]) -> None:
+        """Set the source of the gesture -> shortcut map pushed to firmware that types keys itself."""
+        self._keymap_provider = provider
+
+    def set_known_address(self, address: Optional[str]) -> None:
+        """Seed the address scan_and_connect() looks for first (the one saved from an earlier run)."""
+        if address:
+            self._last_device_address = address
+
+    def last_device_address(self) -> Optional[str]:
+        """Address of the device connected last (or being connected)."""
+        return self._last_device_address
+
+    def set_connect_lock(self, lock: Optional[asyncio.Lock]) -> None:
+        """Share a lock with other managers so only one connection is set up at a time (reconnects too)."""
+        self._connect_lock = lock
+
+    def delivery_stats(self) -> DeliveryTracker:
+        """Event delivery counters of the current connection (received, missed, recovered, lost)."""
+        return self._delivery
+
+    def device_hid(self) -> bool:
+        """True when the connected firmware types the shortcuts itself (HID keyboard mode)."""
+        return self._device_hid
+
+    async def write_keymap(self, shortcuts: Dict[str, str]) -> bool:
+        """Push the shortcut map to the firmware HID keyboard; False without HID mode or connection."""
+        if not self.is_connected() or not self._device_hid:
+            return False
+        try:
+            await self._client.write_gatt_char(self.KEYMAP_UUID, encode_keymap(shortcuts), response=True)
+            return True
+        except Exception as e:
+            print(f"[BLE] Keymap write failed: {e}")
+            return False
+
+    async def read_config(self) -> Optional[RuntimeConfig]:
+        """Read the runtime configuration; None when not connected or the firmware has none."""
+        if not self.is_connected():
+            return None
+        try:
+            return parse_config(bytes(await self._client.read_gatt_char(self.CONFIG_UUID)))
+        except Exception as e:
+            print(f"[BLE] Config read failed: {e}")
+            return None
+
+    async def run_benchmark(self, duration_ms: int = 3000) -> Optional[BenchmarkResult]:
+        """Measure notification throughput of the current link (MTU, PHY and data length as negotiated)."""
+        if not self.is_connected():
+            return None
+        loop = asyncio.get_running_loop()
+        done = loop.create_future()
+        received = {"packets": 0, "bytes": 0, "first": None, "last": None}
+        indices: List[int] = []
+
+        def on_notify(sender, data: bytearray) -> None:
+            summary = parse_benchmark_report(bytes(data))
+            if summary is not None:
+                if not done.done():
+                    done.set_result(summary)
+                return
+            now = loop.time()
+            received["first"] = received["first"] or now
+            received["last"] = now
+            received["packets"] += 1
+            received["bytes"] += len(data)
+            if len(data) >= 4:
+                indices.append(struct.unpack_from('<I', data)[0])
+
+        try:
+            if self._att_mtu is None:
+                self._att_mtu = await self._negotiated_mtu()
+            await self._client.start_notify(self.BENCHMARK_UUID, on_notify)
+            await self._client.write_gatt_char(self.BENCHMARK_UUID, encode_benchmark(duration_ms, self._att_mtu),
+                                               response=True)
+            packets, sent_bytes, device_ms, refused = await asyncio.wait_for(done, duration_ms / 1000 + 5.0)
+        except Exception as e:
+            print(f"[BLE] Benchmark failed: {e}")
+            return None
+        finally:
+            try:
+                await self._client.stop_notify(self.BENCHMARK_UUID)
+            except Exception:
+                pass
+        host_s = (received["last"] - received["first"]) if received["packets"] > 1 else 0.0
+        # Indices the device queued but the host never saw (the stack dropped them or refused them).
+        missing = max(packets - len(set(indices)), 0)
+        return BenchmarkResult(packets, sent_bytes, device_ms, received["packets"], received["bytes"], host_s,
+                               refused, missing)
+
+    async def run_loopback(self, count: int = 200, padding: int = 0,
+                           timeout_s: float = 1.0) -> Optional[LoopbackResult]:
+        """Time count write -> notify round trips, one at a time (write without response, padding extra bytes).
+
+        Each write carries the device time of the previous echo, so the device times the
+        same round trips on its own clock; its report arrives in LoopbackResult.device.
+        """
+        if not self.is_connected():
+            return None
+        loop = asyncio.get_running_loop()
+        pending: Dict[str, Any] = {"sequence": None, "future": None, "report": None}
+
+        def on_notify(sender, data: bytearray) -> None:
+            data = bytes(data)
+            echo = parse_loopback_echo(data)
+            future = pending["future"]
+            if echo is not None:
+                if future is not None and not future.done() and echo[0] == pending["sequence"]:
+                    future.set_result(echo[1])
+                return
+            report = parse_loopback_report(data)
+            if report is not None and pending["sequence"] is None and future is not None and not future.done():
+                future.set_result(report)
+
+        rtt_ms: List[float] = []
+        lost = 0
+        device_us = 0
+        report = None
+        try:
+            await self._client.start_notify(self.BENCHMARK_UUID, on_notify)
+            for sequence in range(count):
+                pending["sequence"] = sequence & 0xFFFF
+                pending["future"] = loop.create_future()
+                start = loop.time()
+                await self._client.write_gatt_char(self.BENCHMARK_UUID, encode_loopback(sequence, device_us, padding),
+                                                   response=False)
+                try:
+                    device_us = await asyncio.wait_for(pending["future"], timeout_s)
+                    rtt_ms.append((loop.time() - start) * 1000)
+                except asyncio.TimeoutError:
+                    lost += 1
+                    device_us = 0
+            pending["sequence"] = None
+            pending["future"] = loop.create_future()
+            await self._client.write_gatt_char(self.BENCHMARK_UUID, encode_loopback_report(), response=True)
+            try:
+                report = await asyncio.wait_for(pending["future"], timeout_s + 1.0)
+            except asyncio.TimeoutError:
+                print("[BLE] Loopback report not received")
+        except Exception as e:
+            print(f"[BLE] Loopback failed: {e}")
+            return None
+        finally:
+            try:
+                await self._client.stop_notify(self.BENCHMARK_UUID)
+            except Exception:
+                pass
+        return LoopbackResult(rtt_ms, count, lost, report)
+
+    async def run_inference_benchmark(self, mode: str = "synthetic", runs: int = 100,
+                                      timeout_s: float = 30.0) -> Optional[InferenceBenchReport]:
+        """Time runs inferences on the device (a fixed synthetic window, or the live ones) and get its report.
+
+        Live runs take as long as the device needs for that many inferences (24 per second);
+        idle inferences that skip the model are not counted.
+        """
+        if not self.is_connected():
+            return None
+        loop = asyncio.get_running_loop()
+        done = loop.create_future()
+
+        def on_notify(sender, data: bytearray) -> None:
+            if not done.done():
+                done.set_result(bytes(data))
+
+        try:
+            await self._client.start_notify(self.INFERENCE_BENCH_UUID, on_notify)
+            await self._client.write_gatt_char(self.INFERENCE_BENCH_UUID, encode_inference_benchmark(mode, runs),
+                                               response=True)
+            data = await asyncio.wait_for(done, timeout_s)
+            report = parse_inference_benchmark(data)
+            if report is None:
+                report = parse_inference_benchmark(bytes(await self._client.read_gatt_char(self.INFERENCE_BENCH_UUID)))
+        except Exception as e:
+            print(f"[BLE] Inference benchmark failed: {e}")
+            return None
+        finally:
+            try:
+                await self._client.stop_notify(self.INFERENCE_BENCH_UUID)
+            except Exception:
+                pass
+        return report
+
+    async def read_model_status(self) -> Optional[ModelStatus]:
+        """Model update status; None when not connected or the firmware has no model update."""
+        if not self.is_connected():
+            return None
+        try:
+            return parse_model_status(bytes(await self._client.read_gatt_char(self.MODEL_CONTROL_UUID)))
+        except Exception as e:
+            print(f"[BLE] Model status read failed: {e}")
+            return None
+
+    async def upload_model(self, blob: bytes, progress: Optional[Callable[[int, int], None]] = None,
+                           switch_timeout_s: float = 10.0) -> Optional[ModelUploadResult]:
+        """Write a model blob (model_ota.build_blob) into the device's spare slot and wait for the switch.
+
+        Chunks fill the negotiated MTU and are written without response, or go as data records on
+        the bulk channel when it is open; the device answers the start command after erasing the
+        slot and checks the CRC on finish. A gap (status error "offset") is resumed from the byte
+        count the device reports.
+        """
+        if not self.is_connected() or len(blob) < 16:
+            return None
+        loop = asyncio.get_running_loop()
+        updates: asyncio.Queue = asyncio.Queue()
+
+        def on_notify(sender, data: bytearray) -> None:
+            status = parse_model_status(bytes(data))
+            if status is not None:
+                updates.put_nowait(status)
+
+        crc32 = struct.unpack_from('<I', blob, 12)[0]
+        try:
+            if self._att_mtu is None:
+                self._att_mtu = await self._negotiated_mtu()
+            chunk_bytes = (self._att_mtu or 23) - 3 - MODEL_CHUNK_HEADER.size
+            bulk = self._bulk
+            if bulk is not None:
+                chunk_bytes = RECORD_MAX - MODEL_CHUNK_HEADER.size
+            await self._client.start_notify(self.MODEL_CONTROL_UUID, on_notify)
+            start = loop.time()
+            await self._client.write_gatt_char(self.MODEL_CONTROL_UUID, encode_model_start(len(blob), crc32),
+                                               response=True)
+            status = await self.read_model_status()
+            if status is None or status.state != "receiving":
+                print(f"[BLE] Model upload refused: {status.error if status else 'no status'}")
+                return None
+
+            sent = 0
+            for _ in range(3):
+                chunks = model_chunks(blob, chunk_bytes, sent)
+                if bulk is not None:
+                    # A few records per call: the send blocks while the device is out of credits
+                    for i in range(0, len(chunks), 8):
+                        batch = chunks[i:i + 8]
+                        await loop.run_in_executor(None, bulk.send, [(RECORD_MODEL_DATA, chunk) for chunk in batch])
+                        sent = min(len(blob), sent + sum(len(c) - MODEL_CHUNK_HEADER.size for c in batch))
+                        if progress:
+                            progress(sent, len(blob))
+                    chunks = []
+                for chunk in chunks:
+                    await self._client.write_gatt_char(self.MODEL_DATA_UUID, chunk, response=False)
+                    sent = min(len(blob), sent + len(chunk) - MODEL_CHUNK_HEADER.size)
+                    if progress:
+                        progress(sent, len(blob))
+                status = await self.read_model_status()
+                if status is None or status.state != "receiving" or status.received == len(blob):
+                    break
+                print(f"[BLE] Model upload resumed at byte {status.received}")
+                sent = status.received
+            while not updates.empty():
+                updates.get_nowait()
+            await self._client.write_gatt_char(self.MODEL_CONTROL_UUID, bytes([MODEL_FINISH_COMMAND]),
+                                               response=True)
+            finished = loop.time()
+            deadline = finished + switch_timeout_s
+            status = await self.read_model_status()
+            while status is not None and status.state in ("receiving", "pending") and loop.time() < deadline:
+                try:
+                    status = await asyncio.wait_for(updates.get(), max(0.0, deadline - loop.time()))
+                except asyncio.TimeoutError:
+                    break
+        except Exception as e:
+            print(f"[BLE] Model upload failed: {e}")
+            return None
+        finally:
+            try:
+                await self._client.stop_notify(self.MODEL_CONTROL_UUID)
+            except Exception:
+                pass
+        if status is None:
+            return None
+        return ModelUploadResult(status, finished - start, loop.time() - finished)
+
+    async def restore_builtin_model(self) -> Optional[ModelStatus]:
+        """Switch the device back to the weights built into its firmware (and forget the uploaded ones)."""
+        if not self.is_connected():
+            return None
+        try:
+            await self._client.write_gatt_char(self.MODEL_CONTROL_UUID, bytes([MODEL_BUILTIN_COMMAND]),
+                                               response=True)
+            for _ in range(20):
+                await asyncio.sleep(0.1)
+                status = await self.read_model_status()
+                if status is None or status.state != "pending":
+                    return status
+        except Exception as e:
+            print(f"[BLE] Built-in model request failed: {e}")
+        return None
+
+    async def read_fewshot_status(self) -> Optional[FewShotStatus]:
+        """Custom gesture status; None when not connected or the firmware has no custom gestures."""
+        if not self.is_connected():
+            return None
+        try:
+            return parse_fewshot_status(bytes(await self._client.read_gatt_char(self.FEWSHOT_UUID)))
+        except Exception as e:
+            print(f"[BLE] Custom gesture status read failed: {e}")
+            return None
+
+    async def fewshot_command(self, command: int, class_index: Optional[int] = None) -> Optional[FewShotStatus]:
+        """Send a custom gesture command (FEWSHOT_*_COMMAND) and return the status it leaves."""
+        if not self.is_connected():
+            return None
+        try:
+            await self._client.write_gatt_char(self.FEWSHOT_UUID, encode_fewshot_command(command, class_index),
+                                               response=True)
+        except Exception as e:
+            print(f"[BLE] Custom gesture command failed: {e}")
+            return None
+        return await self.read_fewshot_status()
+
+    async def record_fewshot_example(self, class_index: int, timeout_s: float = 5.0) -> Optional[FewShotStatus]:
+        """Record one example of a custom gesture: the device collects the windows of its capture period."""
+        status = await self.fewshot_command(FEWSHOT_RECORD_COMMAND, class_index)
+        if status is None or status.state != "capturing":
+            return status
+        deadline = asyncio.get_running_loop().time() + timeout_s
+        while status is not None and status.state == "capturing" and asyncio.get_running_loop().time() < deadline:
+            await asyncio.sleep(0.1)
+            status = await self.read_fewshot_status()
+        return status
+
+    async def commit_fewshot_class(self, timeout_s: float = 2.0) -> Optional[FewShotStatus]:
+        """Commit the class being recorded; the device writes its centroid to flash between inferences."""
+        status = await self.fewshot_command(FEWSHOT_COMMIT_COMMAND)
+        deadline = asyncio.get_running_loop().time() + timeout_s
+        while status is not None and status.state == "enrolling" and status.error == "ok" and \
+                asyncio.get_running_loop().time() < deadline:
+            await asyncio.sleep(0.1)
+            status = await self.read_fewshot_status()
+        return status
+
+    async def read_combos(self) -> Optional[ComboTable]:
+        """The combos in use; None when not connected or the firmware has no combos."""
+        if not self.is_connected():
+            return None
+        try:
+            return parse_combos(bytes(await self._client.read_gatt_char(self.COMBO_UUID)))
+        except Exception as e:
+            print(f"[BLE] Combo read failed: {e}")
+            return None
+
+    async def write_combos(self, table: ComboTable) -> Optional[ComboTable]:
+        """Replace the device's combos; returns the table in use afterwards (the old one when rejected)."""
+        if not self.is_connected():
+            return None
+        try:
+            await self._client.write_gatt_char(self.COMBO_UUID, encode_combos(table), response=True)
+        except Exception as e:
+            print(f"[BLE] Combo write failed: {e}")
+            return None
+        return await self.read_combos()
+
+    async def read_telemetry_status(self) -> Optional[TelemetryStatus]:
+        """Diagnostics log status; None when not connected or the firmware has no log."""
+        if not self.is_connected():
+            return None
+        try:
+            return parse_telemetry_status(bytes(await self._client.read_gatt_char(self.TELEMETRY_UUID)))
+        except Exception as e:
+            print(f"[BLE] Diagnostics log status read failed: {e}")
+            return None
+
+    async def dump_telemetry(self, timeout_s: float = 60.0, captures: bool = False) -> Optional[TelemetryDump]:
+        """Read the whole diagnostics log: its records in the order they were written.
+
+        With captures, read the captured low-confidence windows instead (capture_dump.py decodes them).
+        """
+        if not self.is_connected():
+            return None
+        done = asyncio.get_running_loop().create_future()
+        dump = TelemetryDump()
+
+        def on_notify(sender, data: bytearray) -> None:
+            if dump.feed(bytes(data)) and not done.done():
+                done.set_result(dump)
+
+        try:
+            self._bulk_handlers[RECORD_TELEMETRY_DATA] = lambda payload: on_notify(None, bytearray(payload))
+            await self._client.start_notify(self.TELEMETRY_DATA_UUID, on_notify)
+            command = TELEMETRY_DUMP_CAPTURES_COMMAND if captures else TELEMETRY_DUMP_COMMAND
+            await self._client.write_gatt_char(self.TELEMETRY_UUID, bytes([command]), response=True)
+            return await asyncio.wait_for(done, timeout_s)
+        except Exception as e:
+            print(f"[BLE] Diagnostics log dump failed: {e or 'timed out'}")
+            try:
+                await self._client.write_gatt_char(self.TELEMETRY_UUID, bytes([TELEMETRY_STOP_COMMAND]),
+                                                   response=True)
+            except Exception:
+                pass
+            return None
+        finally:
+            self._bulk_handlers.pop(RECORD_TELEMETRY_DATA, None)
+            try:
+                await self._client.stop_notify(self.TELEMETRY_DATA_UUID)
+            except Exception:
+                pass
+
+    async def set_profile(self, profile: str) -> bool:
+        """Switch the device to the "default", "low-latency" or "low-power" preset (kept across resets)."""
+        return await self._write_config(encode_profile(profile))
+
+    async def write_config(self, config: RuntimeConfig) -> bool:
+        """Apply individual settings; the firmware rejects out-of-range values and keeps its configuration."""
+        return await self._write_config(encode_config(config))
+
+    async def set_operating_point(self, point: Optional[str]) -> bool:
+        """Ask for a power point (POWER_POINTS) for this session, None to hand the choice back to the device."""
+        return await self._write_config(encode_operating_point(point))
+
+    async def _write_config(self, payload: bytes) -> bool:
+        if not self.is_connected():
+            return False
+        try:
+            await self._client.write_gatt_char(self.CONFIG_UUID, payload, response=True)
+            return True
+        except Exception as e:
+            print(f"[BLE] Config write failed: {e}")
+            return False
     
     def _notify_status(self, status: str) -> None:
         """Notify status change via callback."""
         if self._status_callback:
             self._status_callback(status)
     
-    async def scan_devices(self, timeout: float = 10.0) -> List[BLEDevice]:
+    async def scan_devices(self, timeout: float = 10.0, on_found: Optional[Callable[[BLEDevice], None]] = None,
+                           stop_at: Optional[str] = None) -> List[BLEDevice]:
         """
-        Scan for BLE devices with improved discovery.
+        Scan for BLE devices, reporting each target device as soon as it advertises.
         
         Args:
-            timeout: Scan duration in seconds (default 10s for better discovery)
+            timeout: Longest scan duration in seconds; the scan ends SCAN_SETTLE_S after the newest target device
+            on_found: Called on the event loop with each new target device, so a list fills while the scan runs
+            stop_at: Address that ends the scan as soon as it advertises (the device the user is waiting for)
         
         Returns:
             List of discovered BLE devices
         """
         self._notify_status("Scanning...")
         self._discovered_devices = []
+        newest_found: List[float] = []
+        stop = asyncio.Event()
+        self._scan_stop = stop
+        self._scan_done = asyncio.Event()
         
-        print(f"[BLE] Starting scan for {timeout} seconds...")
+        print(f"[BLE] Starting scan for up to {timeout} seconds...")
         
         def detection_callback(device: BLEDevice, advertisement_data):
             """Callback for each discovered device."""
-            # Check by name
             if device.name:
                 print(f"[BLE] Found: {device.name} [{device.address}]")
-                if self.TARGET_DEVICE_NAME in device.name:
-                    if device not in self._discovered_devices:
-                        self._discovered_devices.append(device)
-                        print(f"[BLE] *** Target device found! ***")
-            
-            # Also check advertisement local name
-            if advertisement_data.local_name:
-                if self.TARGET_DEVICE_NAME in advertisement_data.local_name:
-                    if device not in self._discovered_devices:
-                        self._discovered_devices.append(device)
-                        print(f"[BLE] *** Target device found via local name! ***")
+            if not self._is_target(device.name, advertisement_data.local_name):
+                return
+            if any(d.address == device.address for d in self._discovered_devices):
+                return
+            self._discovered_devices.append(device)
+            newest_found[:] = [time.monotonic()]
+            print(f"[BLE] *** Target device found! ***")
+            if on_found:
+                on_found(device)
+            if stop_at and device.address.upper() == stop_at.upper():
+                stop.set()
         
         # Use scanner with callback for real-time discovery
         scanner = BleakScanner(detection_callback=detection_callback)
         
         try:
             await scanner.start()
-            await asyncio.sleep(timeout)
+            deadline = time.monotonic() + timeout
+            while time.monotonic() < deadline and not stop.is_set():
+                if newest_found and time.monotonic() - newest_found[0] >= self.SCAN_SETTLE_S:
+                    break
+                await asyncio.sleep(0.1)
             await scanner.stop()
         except Exception as e:
             print(f"[BLE] Scan error: {e}")
-        
-        # Also try standard discover as backup
-        if not self._discovered_devices:
-            print("[BLE] Trying standard discover...")
-            try:
-                devices = await BleakScanner.discover(timeout=5.0)
-                for device in devices:
-                    if device.name and self.TARGET_DEVICE_NAME in device.name:
-                        self._discovered_devices.append(device)
-            except Exception as e:
-                print(f"[BLE] Standard discover error: {e}")
+        finally:
+            self._scan_stop = None
+            self._scan_done.set()
         
         print(f"[BLE] Scan complete. Found {len(self._discovered_devices)} target device(s)")
         self._notify_status("Disconnected")
         return self._discovered_devices
+
+    async def stop_scan(self) -> None:
+        """End a running scan_devices() early and wait for its scanner to stop (e.g. to connect to a listed device)."""
+        if self._scan_stop is not None and self._scan_done is not None:
+            self._scan_stop.set()
+            await self._scan_done.wait()
     
-    async def scan_and_connect(self, timeout: float = 15.0) -> bool:
+    async def listen_broadcasts(self, callback: Callable[[BroadcastResult], None], duration: float) -> None:
+        """
+        Receive results from the advertising packets of every nearby device, without connecting.
+
+        Any number of hosts can listen at once. Each advertised sequence is
+        reported once per device; a device that has a central connected stops
+        broadcasting until it disconnects.
+        """
+        last_sequence: Dict[str, int] = {}
+
+        def detection_callback(device: BLEDevice, advertisement_data):
+            data = advertisement_data.manufacturer_data.get(BROADCAST_COMPANY_ID)
+            result = parse_broadcast(device.address, bytes(data)) if data else None
+            if result is None or last_sequence.get(device.address) == result.sequence:
+                return
+            last_sequence[device.address] = result.sequence
+            callback(result)
+
+        scanner = BleakScanner(detection_callback=detection_callback)
+        await scanner.start()
+        try:
+            await asyncio.sleep(duration)
+        finally:
+            await scanner.stop()
+
+    async def scan_and_connect(self, timeout: float = 15.0, known_address: Optional[str] = None) -> bool:
         """
         Scan for target device and connect automatically.
+
+        The cached address (known_address, else the last connected one) and the name scan race
+        in one scanner; the connect starts on the first advertisement that matches.
         
         Args:
             timeout: Total timeout for scan and connect
+            known_address: Address to look for first (see PREFER_KNOWN_S)
         
         Returns:
             True if connected successfully
         """
         self._notify_status("Scanning & Connecting...")
+        known = known_address or self._last_device_address
         
-        print("[BLE] Scanning for target device...")
+        print(f"[BLE] Scanning for target device{f' (cached {known})' if known else ''}...")
         
-        # Try to find device by name during scan
-        device = await BleakScanner.find_device_by_name(
-            self.TARGET_DEVICE_NAME,
-            timeout=timeout
-        )
+        device = await self._find_target(timeout, known)
         
         if device:
             print(f"[BLE] Found device: {device.name} [{device.address}]")
-            return await self.connect(device.address)
+            return await self.connect(device.address, device)
         
         print("[BLE] Device not found")
         self._notify_status("Device not found")
         return False
+
+    @classmethod
+    def _is_target(cls, name: Optional[str], local_name: Optional[str]) -> bool:
+        return any(value and cls.TARGET_DEVICE_NAME in value for value in (name, local_name))
+
+    async def _find_target(self, timeout: float, address: Optional[str] = None,
+                           by_name: bool = True) -> Optional[BLEDevice]:
+        """First advertisement of address, or of any target device when by_name; None after timeout.
+
+        One scanner looks for both, so the cached address and the name scan race without two
+        discoveries at once (BlueZ refuses a second one). With an address, a name match is only
+        taken after PREFER_KNOWN_S, so another board nearby does not win over the cached one.
+        """
+        loop = asyncio.get_running_loop()
+        found = loop.create_future()
+        others: List[BLEDevice] = []
+        started = time.monotonic()
+
+        def detection_callback(device: BLEDevice, advertisement_data):
+            if found.done():
+                return
+            if address is not None and device.address.upper() == address.upper():
+                found.set_result(device)
+            elif by_name and self._is_target(device.name, advertisement_data.local_name):
+                if address is None or time.monotonic() - started >= self.PREFER_KNOWN_S:
+                    found.set_result(device)
+                elif device not in others:
+                    others.append(device)
+
+        scanner = BleakScanner(detection_callback=detection_callback)
+        try:
+            await scanner.start()
+        except Exception as e:
+            print(f"[BLE] Scan error: {e}")
+            return None
+        try:
+            if address is not None and by_name:
+                try:
+                    return await asyncio.wait_for(asyncio.shield(found), min(self.PREFER_KNOWN_S, timeout))
+                except asyncio.TimeoutError:
+                    if others:
+                        return others[0]
+            return await asyncio.wait_for(found, max(timeout - (time.monotonic() - started), 0.0))
+        except asyncio.TimeoutError:
+            return None
+        finally:
+            try:
+                await scanner.stop()
+            except Exception as e:
+                print(f"[BLE] Scan stop error: {e}")
     
-    async def connect(self, device_address: str) -> bool:
+    async def connect(self, device_address: str, device: Optional[BLEDevice] = None) -> bool:
         """
         Connect to a BLE device with improved reliability.
         
         Args:
             device_address: The device's MAC address
+            device: The device as just seen by a scan (skips the scan bleak would run to find it)
         
         Returns:
             True if connection successful, False otherwise
         """
+        if self._connect_lock is None:
+            return await self._connect(device_address, device)
+        async with self._connect_lock:
+            return await self._connect(device_address, device)
+
+    async def _connect(self, device_address: str, device: Optional[BLEDevice] = None) -> bool:
         self._notify_status("Connecting...")
         self._last_device_address = device_address
         
@@ -164,6 +2062,9 @@ class BLEManager:
                 pass
             self._client = None
         
+        # A device whose layout hash is known reuses the OS's cached discovery (see _check_layout)
+        cached_layout = self._layout_load(device_address) if self._layout_load else None
+
         # Try connection with retries
         max_attempts = 3
         for attempt in range(1, max_attempts + 1):
@@ -171,21 +2072,24 @@ class BLEManager:
                 print(f"[BLE] Connection attempt {attempt}/{max_attempts}...")
                 self._notify_status(f"Connecting ({attempt}/{max_attempts})...")
                 
-                self._client = BleakClient(
-                    device_address,
+                self._client = self._client_factory(
+                    device or device_address,
                     disconnected_callback=self._on_disconnect,
-                    timeout=20.0  # Longer timeout for Windows
+                    timeout=20.0,  # Longer timeout for Windows
+                    winrt={"use_cached_services": cached_layout is not None}
                 )
                 
                 await self._client.connect()
                 
                 if self._client.is_connected:
+                    if not await self._check_layout(device_address, cached_layout):
+                        # The firmware changed since the cache was filled: discover again
+                        cached_layout = None
+                        await self._client.disconnect()
+                        self._client = None
+                        continue
+
                     print("[BLE] Connected! Subscribing to notifications...")
-                    
-                    # Small delay before subscribing (helps stability)
-                    await asyncio.sleep(0.5)
-                    
-                    # Subscribe to notifications
                     await self._subscribe_notifications()
                     
                     self._connected = True
@@ -210,11 +2114,136 @@ class BLEManager:
         self._notify_status("Connection failed")
         return False
     
+    async def _check_layout(self, device_address: str, cached_layout: Optional[int]) -> bool:
+        """False when the device's layout hash differs from the cached one; remembers the current hash."""
+        self._confidence = LEGACY_CONFIDENCE
+        self._heartbeat_interval_s = None
+        if self._client.services.get_characteristic(self.LAYOUT_UUID) is None:
+            # Older firmware without the hash, or a stale cache that does not have it yet
+            return cached_layout is None
+        value = await self._client.read_gatt_char(self.LAYOUT_UUID)
+        layout = parse_layout(value)
+        warning = schema_warning(parse_layout_schema(value))
+        if warning:
+            print(f"[BLE] Warning: {warning}")
+        self._confidence = parse_layout_confidence(value)
+        self._heartbeat_interval_s = parse_layout_heartbeat(value)
+        if layout is None:
+            return True
+        if cached_layout is not None and layout != cached_layout:
+            print(f"[BLE] GATT layout changed ({cached_layout:08x} -> {layout:08x}), discovering again")
+            return False
+        if layout != cached_layout and self._layout_save:
+            self._layout_save(device_address, layout)
+        return True
+
+    async def _start_optional_notify(self, uuid: str, handler: Callable[[Any, bytearray], None], name: str,
+                                     read: bool = False) -> None:
+        """Subscribe to a characteristic older firmware may lack; with read the current value is handled too."""
+        try:
+            await self._client.start_notify(uuid, handler)
+            if read:
+                handler(None, await self._client.read_gatt_char(uuid))
+        except Exception as e:
+            print(f"[BLE] No {name} characteristic ({e})")
+
+    async def _read_crash(self) -> None:
+        try:
+            self._on_crash_notify(None, await self._client.read_gatt_char(self.CRASH_UUID))
+        except Exception as e:
+            print(f"[BLE] No crash report characteristic ({e})")
+
     async def _subscribe_notifications(self) -> None:
         """Subscribe to characteristic notifications."""
         if not self._client or not self._client.is_connected:
             return
-        
+
+        # Firmware in HID keyboard mode types the shortcuts itself: hand it the map
+        self._device_hid = self._client.services.get_characteristic(self.KEYMAP_UUID) is not None
+        if self._device_hid and self._keymap_provider:
+            if await self.write_keymap(self._keymap_provider()):
+                print("[BLE] Device types shortcuts itself (HID keyboard mode)")
+
+        # Independent of each other: subscribed concurrently instead of one round trip after the other
+        optional = []
+        if self._cpu_callback:
+            optional.append(self._start_optional_notify(self.CPU_UUID, self._on_cpu_notify, "CPU utilization"))
+        if self._counters_callback:
+            optional.append(self._start_optional_notify(self.COUNTERS_UUID, self._on_counters_notify,
+                                                        "delivery counters"))
+        if self._stats_callback:
+            optional.append(self._start_optional_notify(self.STATS_UUID, self._on_stats_notify, "statistics"))
+        self._latency.reset()
+        if self._latency_callback or self._breakdown_callback:
+            optional.append(self._start_optional_notify(self.LATENCY_UUID, self._on_latency_notify, "latency"))
+        if self._config_callback:
+            optional.append(self._start_optional_notify(self.CONFIG_UUID, self._on_config_notify, "config", read=True))
+        if self._link_callback:
+            optional.append(self._start_optional_notify(self.LINK_UUID, self._on_link_notify, "link", read=True))
+        if self._scores_callback:
+            optional.append(self._start_optional_notify(self.SCORES_UUID, self._on_scores_notify, "score stream"))
+        if self._window_callback:
+            self._window_decoder = StreamDecoder(TYPE_WINDOW)
+            optional.append(self._start_optional_notify(self.WINDOW_UUID, self._on_window_notify, "window stream"))
+        if self._hold_callback:
+            optional.append(self._start_optional_notify(self.SEGMENT_UUID, self._on_segment_notify, "segment"))
+        if self._onset_callback:
+            optional.append(self._start_optional_notify(self.ONSET_UUID, self._on_onset_notify, "onset"))
+        if self._combo_callback:
+            optional.append(self._start_optional_notify(self.COMBO_EVENT_UUID, self._on_combo_notify, "combo"))
+        if self._power_callback:
+            optional.append(self._start_optional_notify(self.POWER_UUID, self._on_power_notify, "power", read=True))
+        if self._trace_callback:
+            optional.append(self._start_optional_notify(self.TRACE_UUID, self._on_trace_notify, "trace stream"))
+        if self._crash_callback:
+            optional.append(self._read_crash())
+        await asyncio.gather(*optional)
+
+        await self._start_time_sync()
+
+        if self._client.services.get_characteristic(self.STREAMS_UUID) is not None:
+            try:
+                # The device serves several centrals at once and sets each one's connection parameters from this
+                await self._client.write_gatt_char(self.STREAMS_UUID, bytes([self.streams()]), response=True)
+            except Exception as e:
+                print(f"[BLE] Could not declare streams ({e})")
+
+        await self._open_bulk_channel()
+
+        self._delivery.reset()
+        self._newest_event_ms = None
+        self._missed_supported = False
+        if self._client.services.get_characteristic(self.MISSED_UUID) is not None:
+            try:
+                # Before the events, so that the first gap can already be requested again
+                await self._client.start_notify(self.MISSED_UUID, self._on_missed_notify)
+                self._missed_supported = True
+            except Exception as e:
+                print(f"[BLE] No missed events characteristic ({e})")
+
+        try:
+            # Prefer the event bursts: every result arrives, even several between connection events
+            await self._client.start_notify(self.EVENTS_UUID, self._on_events_notify)
+            print("[BLE] Subscribed to result event notifications")
+            # Older firmware has no ack characteristic: events still work, only the ack latency is missing
+            self._ack_supported = self._client.services.get_characteristic(self.ACK_UUID) is not None
+            self._att_mtu = await self._negotiated_mtu()
+            print(f"[BLE] ATT MTU {self._att_mtu}")
+            self._start_heartbeat_watch()
+            return
+        except Exception as e:
+            print(f"[BLE] No result events characteristic ({e}), using the gesture characteristic")
+
+        try:
+            # One notification per result with index, confidence and sequence together
+            self._gesture_sequence = None
+            await self._client.start_notify(self.GESTURE_UUID, self._on_gesture_notify)
+            print("[BLE] Subscribed to gesture notifications")
+            self._ack_supported = self._client.services.get_characteristic(self.ACK_UUID) is not None
+            return
+        except Exception as e:
+            print(f"[BLE] No gesture characteristic ({e}), using prediction/confidence")
+
         try:
             # Subscribe to prediction characteristic
             await self._client.start_notify(
@@ -234,64 +2263,494 @@ class BLEManager:
             print(f"[BLE] Notification subscription error: {e}")
             raise
     
+    async def _negotiated_mtu(self) -> Optional[int]:
+        """ATT MTU of the connection (the OS exchanges it on connect; the firmware accepts up to 247)."""
+        backend = getattr(self._client, "_backend", None)
+        if hasattr(backend, "_acquire_mtu"):
+            # BlueZ only learns the exchanged MTU once a notification socket is acquired
+            try:
+                await backend._acquire_mtu()
+            except Exception:
+                pass
+        return getattr(self._client, "mtu_size", None)
+
     def _on_prediction_notify(self, sender, data: bytearray) -> None:
-        """Handle prediction characteristic notification."""
+        """Handle prediction characteristic notification (legacy firmware): held until its confidence arrives."""
         try:
             # Decode string, strip null bytes
-            gesture = data.decode('utf-8').rstrip('\x00').strip()
-            self._current_gesture = gesture
-            self._check_and_emit_gesture()
+            self._current_gesture = data.decode('utf-8').rstrip('\x00').strip()
         except Exception as e:
             print(f"[BLE] Prediction decode error: {e}")
     
     def _on_confidence_notify(self, sender, data: bytearray) -> None:
-        """Handle confidence characteristic notification."""
+        """Handle confidence characteristic notification (legacy firmware).
+
+        The firmware notifies the prediction first and its confidence second, so the pair
+        is emitted once, here, and never with the confidence of the previous result.
+        """
         try:
-            # Decode float (little-endian)
-            if len(data) >= 4:
-                self._current_confidence = struct.unpack('<f', data[:4])[0]
-                self._check_and_emit_gesture()
+            if len(data) < CONFIDENCE_STRUCT.size or not self._current_gesture:
+                return
+            confidence = CONFIDENCE_STRUCT.unpack_from(data)[0]
+            gesture = self._current_gesture
+            self._current_gesture = None
+            if self._gesture_callback:
+                self._gesture_callback(gesture, confidence)
         except Exception as e:
             print(f"[BLE] Confidence decode error: {e}")
     
-    def _check_and_emit_gesture(self) -> None:
-        """Emit gesture if we have both prediction and confidence."""
-        if self._current_gesture and self._gesture_callback:
-            self._gesture_callback(self._current_gesture, self._current_confidence)
-    
+    def _on_events_notify(self, sender, data: bytearray) -> None:
+        """Handle a burst of result events: emit every event in order."""
+        arrival = time.perf_counter()
+        now = time.monotonic()
+        self._heartbeat.alive(now)
+        try:
+            dropped, events = parse_event_burst(bytes(data), self._confidence)
+            if dropped:
+                print(f"[BLE] {dropped} result events dropped on the device")
+            if events and events[0].delivery is not None:
+                gap = self._delivery.receive(events[0].delivery, len(events), now)
+                if gap is not None:
+                    print(f"[BLE] {(events[0].delivery - gap[0]) & 0xFFFF} result events missed")
+                    self._request_missed(*gap)
+            elif not events:
+                heartbeat = parse_heartbeat(bytes(data))
+                if heartbeat is not None:
+                    self._last_heartbeat = heartbeat
+                    # The last events before going idle are missed too when the heartbeat's number is ahead
+                    gap = self._delivery.receive(heartbeat.delivery, 0, now)
+                    if gap is not None:
+                        print(f"[BLE] {gap[1]} result events missed before the heartbeat")
+                        self._request_missed(*gap)
+            for event in events:
+                self._emit_event(event, arrival)
+            if events:
+                # The callbacks have acted on the burst: ack its newest event for the gesture-to-action latency
+                self._send_ack(events[-1].sequence)
+                self._record_latency(events, arrival)
+        except Exception as e:
+            print(f"[BLE] Events decode error: {e}")
+
+    def _on_missed_notify(self, sender, data: bytearray) -> None:
+        """Handle events sent again from the device history: act on the ones that fill a gap."""
+        arrival = time.perf_counter()
+        try:
+            _, events = parse_event_burst(bytes(data), self._confidence)
+            for event in events:
+                if event.delivery is None or not self._delivery.recover(event.delivery):
+                    continue
+                newest = self._newest_event_ms
+                if newest is not None and newest - event.timestamp_ms > self.RECOVER_MAX_AGE_MS:
+                    print(f"[BLE] Recovered event {event.delivery} too old to act on")
+                    continue
+                self._emit_event(event, arrival)
+        except Exception as e:
+            print(f"[BLE] Missed events decode error: {e}")
+
+    def _emit_event(self, event: ResultEvent, arrival: float) -> None:
+        if self._newest_event_ms is None or event.timestamp_ms > self._newest_event_ms:
+            self._newest_event_ms = event.timestamp_ms
+        if 0 <= event.index < len(self.MODEL_LABELS):
+            if self._gesture_callback:
+                self._gesture_callback(self.MODEL_LABELS[event.index], event.confidence)
+            if self._event_callback:
+                self._notify_event(event, arrival)
+
+    def _notify_event(self, event: ResultEvent, arrival: float) -> None:
+        published = self._clock.to_host(event.timestamp_ms)
+        self._event_callback(self.MODEL_LABELS[event.index], event.confidence,
+                             arrival if published is None else published)
+
+    def _request_missed(self, first: int, count: int) -> None:
+        """Ask the device to send a gap again without waiting for the write to complete."""
+        if not self._missed_supported or not self._client or not self._client.is_connected:
+            return
+        asyncio.ensure_future(self._write_missed(encode_missed(first, count)))
+
+    async def _write_missed(self, payload: bytes) -> None:
+        if not self._client:
+            return
+        try:
+            await self._client.write_gatt_char(self.MISSED_UUID, payload, response=False)
+        except Exception as e:
+            print(f"[BLE] Missed events request failed ({e})")
+
+    def _on_gesture_notify(self, sender, data: bytearray) -> None:
+        """Handle the packed latest-result notification."""
+        arrival = time.perf_counter()
+        try:
+            event = parse_gesture(bytes(data), self._confidence)
+            if event is None or event.sequence == self._gesture_sequence:
+                return
+            self._gesture_sequence = event.sequence
+            if 0 <= event.index < len(self.MODEL_LABELS):
+                if self._gesture_callback:
+                    self._gesture_callback(self.MODEL_LABELS[event.index], event.confidence)
+                if self._event_callback:
+                    self._notify_event(event, arrival)
+            self._send_ack(event.sequence)
+            self._record_latency([event], arrival)
+        except Exception as e:
+            print(f"[BLE] Gesture decode error: {e}")
+
+    def _on_segment_notify(self, sender, data: bytearray) -> None:
+        """Handle a gesture onset / release report."""
+        try:
+            state = parse_segment(bytes(data))
+            if state is None or state.index >= len(self.MODEL_LABELS):
+                return
+            gesture = self.MODEL_LABELS[state.index]
+            if state.held:
+                if gesture != self._held_gesture:
+                    self._release_hold()
+                    self._held_gesture = gesture
+                    if self._hold_callback:
+                        self._hold_callback(gesture, True)
+            elif gesture == self._held_gesture:
+                self._release_hold()
+        except Exception as e:
+            print(f"[BLE] Segment decode error: {e}")
+
+    def _on_onset_notify(self, sender, data: bytearray) -> None:
+        """Handle a provisional onset or its confirmation / cancellation."""
+        try:
+            report = parse_onset(bytes(data), self._confidence)
+            if report is None or report.index >= len(self.MODEL_LABELS):
+                return
+            if report.state == ONSET_PROVISIONAL:
+                if self._pending_onset is not None and self._pending_onset[0] == report.onset:
+                    return
+                self._cancel_onset()
+                gesture = self.MODEL_LABELS[report.index]
+                self._pending_onset = (report.onset, gesture)
+                if self._onset_callback:
+                    self._onset_callback(gesture, ONSET_STATES[ONSET_PROVISIONAL])
+            elif self._pending_onset is not None and self._pending_onset[0] == report.onset:
+                # A resolution for an onset never seen provisional is dropped: the result carries the gesture
+                gesture, self._pending_onset = self._pending_onset[1], None
+                if self._onset_callback:
+                    self._onset_callback(gesture, ONSET_STATES[report.state])
+        except Exception as e:
+            print(f"[BLE] Onset decode error: {e}")
+
+    def _cancel_onset(self) -> None:
+        """Report the pending provisional onset canceled (superseded, or the connection went away)."""
+        pending, self._pending_onset = self._pending_onset, None
+        if pending is not None and self._onset_callback:
+            self._onset_callback(pending[1], ONSET_STATES[ONSET_CANCELED])
+
+    def _on_combo_notify(self, sender, data: bytearray) -> None:
+        event = parse_combo_event(bytes(data))
+        if event is not None and self._combo_callback:
+            self._combo_callback(event)
+
+    def _on_power_notify(self, sender, data: bytearray) -> None:
+        state = parse_power(bytes(data))
+        if state is not None and self._power_callback:
+            self._power_callback(state)
+
+    def _on_crash_notify(self, sender, data: bytearray) -> None:
+        report = parse_crash(bytes(data))
+        if report is not None and self._crash_callback:
+            self._crash_callback(report)
+
+    def _on_trace_notify(self, sender, data: bytearray) -> None:
+        packet = parse_trace(bytes(data))
+        if packet is not None and self._trace_callback:
+            self._trace_callback(packet)
+
+    def _random_address(self) -> bool:
+        """Whether the device advertises a random address (BlueZ device property; random when unknown)."""
+        info = getattr(getattr(self._client, "_backend", None), "_device_info", None) or {}
+        return info.get("AddressType", "random") != "public"
+
+    async def _open_bulk_channel(self) -> None:
+        """Move the window and trace streams and the log dump to the L2CAP channel where the host can open it."""
+        self._close_bulk_channel()
+        if not l2cap_supported() or self._client.services.get_characteristic(self.BULK_UUID) is None:
+            return
+        loop = asyncio.get_running_loop()
+        try:
+            info = parse_bulk_info(bytes(await self._client.read_gatt_char(self.BULK_UUID)))
+            if info is None:
+                return
+            psm, device_mtu, _ = info
+            channel = L2capChannel(self._client.address, psm, self._random_address(), device_mtu)
+            await loop.run_in_executor(None, channel.open)
+        except Exception as e:
+            print(f"[BLE] Bulk channel unavailable, streams stay on GATT ({e})")
+            return
+        self._bulk_handlers[RECORD_HELLO] = self._on_bulk_hello
+        self._bulk_handlers[RECORD_WINDOW] = lambda payload: self._on_window_notify(None, bytearray(payload))
+        self._bulk_handlers[RECORD_TRACE] = lambda payload: self._on_trace_notify(None, bytearray(payload))
+        channel.start(lambda record_type, payload: loop.call_soon_threadsafe(self._on_bulk_record, record_type,
+                                                                             payload),
+                      lambda: loop.call_soon_threadsafe(self._on_bulk_closed, channel))
+        self._bulk = channel
+        try:
+            await loop.run_in_executor(None, channel.send,
+                                       [encode_hello(self.streams() & (STREAM_WINDOW | STREAM_TRACE))])
+        except OSError as e:
+            print(f"[BLE] Bulk channel hello failed ({e})")
+            self._close_bulk_channel()
+
+    def _close_bulk_channel(self) -> None:
+        channel, self._bulk = self._bulk, None
+        if channel is not None:
+            channel.close()
+
+    def _on_bulk_closed(self, channel: L2capChannel) -> None:
+        if self._bulk is channel:
+            print("[BLE] Bulk channel closed, streams back on GATT")
+            self._close_bulk_channel()
+
+    def _on_bulk_record(self, record_type: int, payload: bytes) -> None:
+        handler = self._bulk_handlers.get(record_type)
+        if handler:
+            handler(payload)
+
+    def _on_bulk_hello(self, payload: bytes) -> None:
+        hello = parse_hello(payload)
+        if hello is None:
+            return
+        streams, version, schema = hello
+        print(f"[BLE] Bulk channel open (version {version}, streams 0x{streams:02x})")
+        warning = schema_warning(schema)
+        if warning:
+            print(f"[BLE] {warning}")
+
+    def _release_hold(self) -> None:
+        """Report the held gesture released (its release arrived, or the connection went away)."""
+        gesture, self._held_gesture = self._held_gesture, None
+        if gesture is not None and self._hold_callback:
+            self._hold_callback(gesture, False)
+
+    def _send_ack(self, sequence: int) -> None:
+        """Write an acknowledgement without waiting for the write to complete."""
+        if not self._ack_supported or not self._client or not self._client.is_connected:
+            return
+        asyncio.ensure_future(self._write_ack(encode_ack(sequence, self._att_mtu)))
+
+    async def _write_ack(self, payload: bytes) -> None:
+        if not self._client:
+            return
+        try:
+            await self._client.write_gatt_char(self.ACK_UUID, payload, response=False)
+        except Exception as e:
+            print(f"[BLE] Ack write failed ({e}), no longer acknowledging events")
+            self._ack_supported = False
+
+    def _record_latency(self, events: List[ResultEvent], arrival: float) -> None:
+        """Account the radio and host stages of the events that arrived at arrival (host clock)."""
+        done = time.perf_counter()
+        for event in events:
+            published = self._clock.to_host(event.timestamp_ms)
+            self._latency.record(None if published is None else arrival - published, done - arrival)
+        if self._breakdown_callback and self._clock.ready:
+            self._breakdown_callback(self._latency.breakdown(self._clock))
+
+    def last_heartbeat(self) -> Optional[Heartbeat]:
+        """The newest idle heartbeat of this connection (None before the first or from older firmware)."""
+        return self._last_heartbeat
+
+    def _start_heartbeat_watch(self) -> None:
+        """Watch for missed heartbeats when the device sends them (the layout characteristic gives the interval)."""
+        self._stop_heartbeat_watch()
+        self._last_heartbeat = None
+        self._heartbeat.start(self._heartbeat_interval_s, time.monotonic())
+        if self._heartbeat_interval_s is not None:
+            self._heartbeat_task = asyncio.ensure_future(self._heartbeat_watch_loop())
+
+    def _stop_heartbeat_watch(self) -> None:
+        if self._heartbeat_task is not None:
+            self._heartbeat_task.cancel()
+            self._heartbeat_task = None
+
+    async def _heartbeat_watch_loop(self) -> None:
+        """Drop a connection that went silent so the auto-reconnect takes over, long before the OS notices."""
+        client = self._client
+        while client is not None and client.is_connected:
+            await asyncio.sleep(self._heartbeat.interval_s)
+            if not self._heartbeat.stalled(time.monotonic()):
+                continue
+            print(f"[BLE] No notification for {self._heartbeat.missed_limit} heartbeat intervals, link stalled")
+            self._notify_status("Link stalled")
+            self._heartbeat_task = None
+            try:
+                await client.disconnect()
+            except Exception as e:
+                print(f"[BLE] Disconnect error: {e}")
+            return
+
+    async def _start_time_sync(self) -> None:
+        """Subscribe to the clock sync replies and keep exchanging them while connected."""
+        self._stop_time_sync()
+        self._clock.reset()
+        self._time_sync_sent.clear()
+        if self._client.services.get_characteristic(self.TIME_SYNC_UUID) is None:
+            return
+        try:
+            await self._client.start_notify(self.TIME_SYNC_UUID, self._on_time_sync_notify)
+        except Exception as e:
+            print(f"[BLE] No clock sync characteristic ({e})")
+            return
+        self._time_sync_task = asyncio.ensure_future(self._time_sync_loop())
+
+    def _stop_time_sync(self) -> None:
+        if self._time_sync_task is not None:
+            self._time_sync_task.cancel()
+            self._time_sync_task = None
+
+    async def _time_sync_loop(self) -> None:
+        rounds = 0
+        while self._client and self._client.is_connected:
+            for _ in range(self.TIME_SYNC_ROUND):
+                sequence = self._time_sync_sequence = (self._time_sync_sequence + 1) & 0xFFFF
+                # Unanswered requests (a lost write or notification) are simply forgotten
+                self._time_sync_sent = {seq: t for seq, t in self._time_sync_sent.items()
+                                        if (sequence - seq) & 0xFFFF < 4 * self.TIME_SYNC_ROUND}
+                self._time_sync_sent[sequence] = time.perf_counter()
+                try:
+                    await self._client.write_gatt_char(self.TIME_SYNC_UUID, encode_time_sync(sequence), response=False)
+                except Exception as e:
+                    print(f"[BLE] Clock sync write failed ({e}), stopping clock sync")
+                    return
+                await asyncio.sleep(self.TIME_SYNC_SPACING_S)
+            rounds += 1
+            # Two rounds back to back give a first offset right after connecting
+            await asyncio.sleep(0.2 if rounds < 2 else self.TIME_SYNC_INTERVAL_S)
+
+    def _on_time_sync_notify(self, sender, data: bytearray) -> None:
+        """Handle a clock sync reply: one more exchange for the offset / drift fit."""
+        received = time.perf_counter()
+        reply = parse_time_sync(bytes(data))
+        if reply is None:
+            return
+        sequence, device_ms, held_us = reply
+        sent = self._time_sync_sent.pop(sequence, None)
+        if sent is not None:
+            self._clock.add(sent, received, device_ms, held_us)
+
+    def _on_latency_notify(self, sender, data: bytearray) -> None:
+        """Handle a latency / watchdog report."""
+        try:
+            report = parse_latency_report(bytes(data))
+            if report:
+                self._latency.set_report(report)
+            if report and self._latency_callback:
+                self._latency_callback(report)
+        except Exception as e:
+            print(f"[BLE] Latency report decode error: {e}")
+
+    def _on_config_notify(self, sender, data: bytearray) -> None:
+        """Handle a runtime configuration change."""
+        try:
+            config = parse_config(bytes(data))
+            if config and self._config_callback:
+                self._config_callback(config)
+        except Exception as e:
+            print(f"[BLE] Config decode error: {e}")
+
+    def _on_scores_notify(self, sender, data: bytearray) -> None:
+        """Handle a batch of per-inference score vectors."""
+        try:
+            for frame in parse_scores(bytes(data)):
+                if self._scores_callback:
+                    self._scores_callback(frame)
+        except Exception as e:
+            print(f"[BLE] Score stream decode error: {e}")
+
+    def _on_window_notify(self, sender, data: bytearray) -> None:
+        """Handle one packet of model input samples."""
+        for packet in self._window_decoder.feed(bytes(data)):
+            if self._window_callback:
+                self._window_callback(packet)
+
+    def _on_link_notify(self, sender, data: bytearray) -> None:
+        """Handle a connection parameter request."""
+        try:
+            params = parse_link_params(bytes(data))
+            if params and self._link_callback:
+                self._link_callback(params)
+        except Exception as e:
+            print(f"[BLE] Link decode error: {e}")
+
+    def _on_stats_notify(self, sender, data: bytearray) -> None:
+        """Handle one registered statistic."""
+        try:
+            stat = parse_stat(bytes(data))
+            if stat and self._stats_callback:
+                self._stats_callback(stat)
+        except Exception as e:
+            print(f"[BLE] Statistics decode error: {e}")
+
+    def _on_counters_notify(self, sender, data: bytearray) -> None:
+        """Handle a delivery counters report."""
+        try:
+            counters = parse_delivery_counters(bytes(data))
+            if counters and self._counters_callback:
+                self._counters_callback(counters)
+        except Exception as e:
+            print(f"[BLE] Delivery counters decode error: {e}")
+
+    def _on_cpu_notify(self, sender, data: bytearray) -> None:
+        """Handle a CPU utilization report."""
+        try:
+            utilization = parse_cpu_utilization(bytes(data))
+            if utilization and self._cpu_callback:
+                self._cpu_callback(utilization)
+        except Exception as e:
+            print(f"[BLE] CPU utilization decode error: {e}")
+
     def _on_disconnect(self, client: BleakClient) -> None:
         """Handle disconnection event."""
         self._connected = False
+        self._device_hid = False
+        self._stop_time_sync()
+        self._stop_heartbeat_watch()
+        self._close_bulk_channel()
+        self._release_hold()
+        self._cancel_onset()
         self._notify_status("Disconnected")
         print("[BLE] Disconnected from device")
         
         # Trigger auto-reconnect if enabled
-        if self._reconnect_enabled and self._last_device_address:
-            asyncio.create_task(self._auto_reconnect())
+        if self._reconnect_enabled and self._last_device_address and \
+                (self._reconnect_task is None or self._reconnect_task.done()):
+            self._reconnect_task = asyncio.create_task(self._auto_reconnect())
     
     async def _auto_reconnect(self) -> None:
-        """Attempt to reconnect with exponential backoff."""
-        if self._reconnect_attempts >= self._max_reconnect_attempts:
-            print("[BLE] Max reconnect attempts reached")
-            self._notify_status("Reconnect failed")
-            return
-        
-        self._reconnect_attempts += 1
-        delay = min(2 ** self._reconnect_attempts, 10)  # Cap at 10 seconds
-        
-        print(f"[BLE] Reconnect attempt {self._reconnect_attempts}/{self._max_reconnect_attempts} in {delay}s")
-        self._notify_status(f"Reconnecting ({self._reconnect_attempts}/{self._max_reconnect_attempts})...")
-        
-        await asyncio.sleep(delay)
-        
-        if not self._connected and self._last_device_address:
-            success = await self.connect(self._last_device_address)
-            if not success and self._reconnect_attempts < self._max_reconnect_attempts:
-                await self._auto_reconnect()
+        """Reconnect on the device's first advertisement instead of after a fixed backoff.
+
+        The firmware advertises directed, then fast, right after a disconnect, so the reconnect
+        usually starts within one advertising interval of the device being back.
+        """
+        last_seen = time.monotonic()
+        while self._reconnect_enabled and not self._connected and self._last_device_address:
+            if self._reconnect_attempts >= self._max_reconnect_attempts:
+                print("[BLE] Max reconnect attempts reached")
+                self._notify_status("Reconnect failed")
+                return
+            if time.monotonic() - last_seen >= self.RECONNECT_GIVE_UP_S:
+                print(f"[BLE] Device not seen for {self.RECONNECT_GIVE_UP_S:.0f}s, reconnect given up")
+                self._notify_status("Reconnect failed")
+                return
+            self._notify_status(f"Reconnecting ({self._reconnect_attempts + 1}/{self._max_reconnect_attempts})...")
+            device = await self._find_target(self.RECONNECT_SCAN_S, self._last_device_address, by_name=False)
+            if device is None or not self._reconnect_enabled or self._connected:
+                continue
+            last_seen = time.monotonic()
+            self._reconnect_attempts += 1
+            print(f"[BLE] Device advertising, reconnect attempt {self._reconnect_attempts}/{self._max_reconnect_attempts}")
+            if await self.connect(self._last_device_address, device):
+                return
     
     async def disconnect(self) -> None:
         """Disconnect from the current device."""
         self._reconnect_enabled = False  # Disable auto-reconnect for manual disconnect
+        self._stop_time_sync()
+        self._stop_heartbeat_watch()
+        self._close_bulk_channel()
         
         if self._client:
             try:
@@ -302,6 +2761,8 @@ class BLEManager:
         
         self._connected = False
         self._client = None
+        self._release_hold()
+        self._cancel_onset()
         self._notify_status("Disconnected")
     
     def is_connected(self) -> bool:
@@ -311,3 +2772,135 @@ class BLEManager:
     def set_auto_reconnect(self, enabled: bool) -> None:
         """Enable or disable auto-reconnect."""
         self._reconnect_enabled = enabled
+
+    def reconnect_attempts(self) -> int:
+        """Reconnect attempts since the last successful connection."""
+        return self._reconnect_attempts
+
+
+@dataclass
+class DeviceMetrics:
+    """State of one board of a MultiDeviceManager."""
+    address: str
+    connected: bool
+    reconnect_attempts: int
+    received: int           # DeliveryTracker counters of the current connection
+    missed: int
+    recovered: int
+    lost: int
+    latency: LatencyBreakdown
+
+
+class MultiDeviceManager:
+    """Several boards at once (two hands, several presenters), as concurrent BleakClient sessions on one loop.
+
+    Every address gets a BLEManager of its own, so delivery tracking, clock sync, latency and
+    reconnect state stay per device. Callbacks take the device address first, e.g.
+    set_gesture_callback(lambda address, gesture, confidence: ...), and also apply to devices
+    added later. Connection setup is serialized through one lock (OS stacks tend to reject a
+    second connect while one is in progress); the sessions themselves run side by side.
+    """
+
+    def __init__(self, factory: Callable[[], BLEManager] = BLEManager):
+        self._factory = factory
+        self._devices: Dict[str, BLEManager] = {}
+        self._callbacks: Dict[str, Callable] = {}
+        self._keymap_provider: Optional[Callable[[], Dict[str, str]]] = None
+        self._layout_store: Optional[Tuple[Callable, Callable]] = None
+        self._auto_reconnect = True
+        self._connect_lock: Optional[asyncio.Lock] = None
+
+    def __getattr__(self, name: str):
+        if name.startswith("set_") and name.endswith("_callback") and hasattr(BLEManager, name):
+            def set_all(callback: Callable) -> None:
+                self._callbacks[name] = callback
+                for address, device in self._devices.items():
+                    self._bind(device, address, name, callback)
+            return set_all
+        raise AttributeError(name)
+
+    @staticmethod
+    def _bind(device: BLEManager, address: str, name: str, callback: Callable) -> None:
+        getattr(device, name)(lambda *args: callback(address, *args))
+
+    def set_keymap_provider(self, provider: Callable[[], Dict[str, str]]) -> None:
+        self._keymap_provider = provider
+        for device in self._devices.values():
+            device.set_keymap_provider(provider)
+
+    def set_layout_store(self, load: Callable[[str], Optional[int]], save: Callable[[str, int], None]) -> None:
+        self._layout_store = (load, save)
+        for device in self._devices.values():
+            device.set_layout_store(load, save)
+
+    def set_auto_reconnect(self, enabled: bool) -> None:
+        self._auto_reconnect = enabled
+        for device in self._devices.values():
+            device.set_auto_reconnect(enabled)
+
+    def add_device(self, address: str) -> BLEManager:
+        """The manager of address, created with the callbacks and settings given so far."""
+        device = self._devices.get(address)
+        if device is not None:
+            return device
+        device = self._factory()
+        for name, callback in self._callbacks.items():
+            self._bind(device, address, name, callback)
+        if self._keymap_provider:
+            device.set_keymap_provider(self._keymap_provider)
+        if self._layout_store:
+            device.set_layout_store(*self._layout_store)
+        device.set_auto_reconnect(self._auto_reconnect)
+        device.set_connect_lock(self._lock())
+        self._devices[address] = device
+        return device
+
+    def device(self, address: str) -> Optional[BLEManager]:
+        return self._devices.get(address)
+
+    def addresses(self) -> List[str]:
+        return list(self._devices)
+
+    def _lock(self) -> asyncio.Lock:
+        # Created on first use: older Pythons bind a lock to the loop current at creation
+        if self._connect_lock is None:
+            self._connect_lock = asyncio.Lock()
+        return self._connect_lock
+
+    async def connect(self, address: str) -> bool:
+        return await self.add_device(address).connect(address)
+
+    async def connect_all(self, addresses: List[str]) -> Dict[str, bool]:
+        """Connect every address; True for the ones that are connected afterwards."""
+        results = await asyncio.gather(*(self.connect(address) for address in addresses))
+        return dict(zip(addresses, results))
+
+    async def scan_and_connect(self, count: int, timeout: float = 10.0) -> Dict[str, bool]:
+        """Scan once and connect up to count target devices not connected yet."""
+        found = await self._factory().scan_devices(timeout)
+        addresses = [device.address for device in found if not self.is_connected(device.address)]
+        return await self.connect_all(addresses[:count])
+
+    async def disconnect(self, address: str) -> None:
+        """Disconnect address and forget it."""
+        device = self._devices.pop(address, None)
+        if device is not None:
+            await device.disconnect()
+
+    async def disconnect_all(self) -> None:
+        await asyncio.gather(*(self.disconnect(address) for address in list(self._devices)))
+
+    def is_connected(self, address: str) -> bool:
+        device = self._devices.get(address)
+        return device is not None and device.is_connected()
+
+    def metrics(self, address: str) -> Optional[DeviceMetrics]:
+        device = self._devices.get(address)
+        if device is None:
+            return None
+        delivery = device.delivery_stats()
+        return DeviceMetrics(address, device.is_connected(), device.reconnect_attempts(), delivery.received,
+                             delivery.missed, delivery.recovered, delivery.lost, device.latency_breakdown())
+
+    def all_metrics(self) -> List[DeviceMetrics]:
+        return [self.metrics(address) for address in self._devices]
@@ -0,0 +1,494 @@
+"""
+BLE Session Recorder and Replay
+
+Records every notification and characteristic read of a BLE session with its
+arrival time into a compact binary file, and replays the file into BLEManager
+through a stand-in for BleakClient at 1x, 10x or as fast as the host goes. This
+load-tests GestureHandler and the GUI without a board and makes host-side
+changes measurable: the replay reports throughput and per-stage latency.
+
+File (little-endian): b"BLES", uint8 version, then records of uint32 µs since
+the previous record, uint8 kind, uint8 characteristic index, uint16 length and
+the payload. A CHARACTERISTIC record declares the next index (payload: the
+16-byte UUID), MTU carries the ATT MTU (uint16), READ and NOTIFY a value.
+
+While recording, the bulk L2CAP channel is hidden from BLEManager, so every
+stream arrives as a notification of its characteristic and the replay covers the
+GATT decoding. Writes are not recorded; the replay client accepts and counts them.
+
+Replay stages: "dispatch" is the due time of a notification to the start of its
+handler (the event loop's lag, paced replays only); "notify <NAME>" the
+BLEManager handler of a characteristic, decoding plus every callback it calls;
+"gesture handler" GestureHandler.process_gesture; "key injection" submit to
+done on the executor thread (the replay never presses keys). At speed 0
+the notification rate is the host's throughput.
+
+Usage:
+    python ble_session.py record session.bles --seconds 60               # scan by name
+    python ble_session.py record session.bles --address AA:BB:.. --scores --window
+    python ble_session.py replay session.bles --speed 10                 # 0 = as fast as possible
+    python main.py --replay session.bles --speed 1                       # the GUI on a replayed session
+"""
+
+import argparse
+import asyncio
+import struct
+import sys
+import time
+import uuid as uuidlib
+from dataclasses import dataclass, field
+from typing import Any, Callable, Dict, List, Optional
+
+from ble_manager import BLEManager
+from percentiles import percentile
+from l2cap_channel import BULK_UUID
+
+SESSION_MAGIC = b"BLES"
+SESSION_VERSION = 1
+RECORD = struct.Struct('<IBBH')
+
+KIND_CHARACTERISTIC = 0
+KIND_MTU = 1
+KIND_READ = 2
+KIND_NOTIFY = 3
+
+REPLAY_ADDRESS = "replay"
+# Paced replays yield to the loop between notifications anyway; at speed 0 every this many
+YIELD_EVERY = 16
+
+
+@dataclass
+class SessionRecord:
+    time_s: float      # since the first record
+    kind: int
+    uuid: str
+    data: bytes
+
+
+@dataclass
+class Session:
+    records: List[SessionRecord]
+    characteristics: List[str]
+    mtu: Optional[int] = None
+
+    def notifications(self) -> List[SessionRecord]:
+        return [r for r in self.records if r.kind == KIND_NOTIFY]
+
+    def duration_s(self) -> float:
+        notifications = self.notifications()
+        return notifications[-1].time_s - notifications[0].time_s if notifications else 0.0
+
+
+class SessionWriter:
+    """Appends records to a session file as they arrive."""
+
+    def __init__(self, path: str):
+        self._file = open(path, "wb")
+        self._file.write(SESSION_MAGIC + bytes([SESSION_VERSION]))
+        self._index: Dict[str, int] = {}
+        self._last_us: Optional[int] = None
+        self._mtu: Optional[int] = None
+        self.notifications = 0
+
+    def characteristic(self, uuid: str) -> int:
+        uuid = str(uuid).lower()
+        index = self._index.get(uuid)
+        if index is None:
+            if len(self._index) > 0xFF:
+                raise ValueError("a session holds at most 256 characteristics")
+            index = self._index[uuid] = len(self._index)
+            self._write(KIND_CHARACTERISTIC, 0, uuidlib.UUID(uuid).bytes)
+        return index
+
+    def mtu(self, mtu: Optional[int]) -> None:
+        if mtu is not None and mtu != self._mtu:
+            self._mtu = mtu
+            self._write(KIND_MTU, 0, struct.pack('<H', mtu))
+
+    def read(self, uuid: str, data: bytes) -> None:
+        self._write(KIND_READ, self.characteristic(uuid), bytes(data))
+
+    def notify(self, uuid: str, data: bytes) -> None:
+        self._write(KIND_NOTIFY, self.characteristic(uuid), bytes(data))
+        self.notifications += 1
+
+    def _write(self, kind: int, index: int, payload: bytes) -> None:
+        now_us = int(time.perf_counter() * 1e6)
+        delta = 0 if self._last_us is None else min(now_us - self._last_us, 0xFFFFFFFF)
+        self._last_us = now_us
+        self._file.write(RECORD.pack(delta, kind, index, len(payload)) + payload)
+
+    def close(self) -> None:
+        self._file.close()
+
+
+def parse_session(data: bytes) -> Session:
+    """Records of a session file; a truncated last record (recorder killed mid-write) is dropped."""
+    if data[:len(SESSION_MAGIC)] != SESSION_MAGIC or len(data) < len(SESSION_MAGIC) + 1:
+        raise ValueError("not a BLE session file")
+    version = data[len(SESSION_MAGIC)]
+    if version != SESSION_VERSION:
+        raise ValueError(f"session file version {version}, expected {SESSION_VERSION}")
+    session = Session([], [])
+    pos = len(SESSION_MAGIC) + 1
+    time_us = 0
+    while pos + RECORD.size <= len(data):
+        delta, kind, index, length = RECORD.unpack_from(data, pos)
+        payload = data[pos + RECORD.size:pos + RECORD.size + length]
+        if len(payload) < length:
+            break
+        pos += RECORD.size + length
+        time_us += delta
+        if kind == KIND_CHARACTERISTIC:
+            session.characteristics.append(str(uuidlib.UUID(bytes=payload)))
+        elif kind == KIND_MTU:
+            session.mtu = struct.unpack('<H', payload)[0]
+        elif index < len(session.characteristics):
+            session.records.append(SessionRecord(time_us / 1e6, kind, session.characteristics[index], payload))
+    return session
+
+
+def read_session(path: str) -> Session:
+    with open(path, "rb") as f:
+        return parse_session(f.read())
+
+
+# ==================== Recording ====================
+
+class _FilteredServices:
+    """A client's services without the hidden characteristics."""
+
+    def __init__(self, services, hidden: frozenset):
+        self._services = services
+        self._hidden = hidden
+
+    def get_characteristic(self, uuid):
+        if str(uuid).lower() in self._hidden:
+            return None
+        return self._services.get_characteristic(uuid)
+
+    def __getattr__(self, name: str):
+        return getattr(self._services, name)
+
+
+class RecordingClient:
+    """A BleakClient that writes every notification and read to a session file."""
+
+    HIDDEN = frozenset({BULK_UUID})
+
+    def __init__(self, client, writer: SessionWriter):
+        self._client = client
+        self._writer = writer
+
+    def __getattr__(self, name: str):
+        return getattr(self._client, name)
+
+    @property
+    def services(self):
+        return _FilteredServices(self._client.services, self.HIDDEN)
+
+    @property
+    def mtu_size(self):
+        mtu = self._client.mtu_size
+        self._writer.mtu(mtu)
+        return mtu
+
+    async def connect(self, **kwargs) -> bool:
+        connected = await self._client.connect(**kwargs)
+        for characteristic in self._client.services.characteristics.values():
+            if characteristic.uuid.lower() not in self.HIDDEN:
+                self._writer.characteristic(characteristic.uuid)
+        return connected
+
+    async def start_notify(self, char, callback: Callable[[Any, bytearray], None], **kwargs) -> None:
+        uuid = str(getattr(char, "uuid", char)).lower()
+        writer = self._writer
+
+        def tap(sender, data: bytearray) -> None:
+            writer.notify(uuid, data)
+            callback(sender, data)
+
+        await self._client.start_notify(char, tap, **kwargs)
+
+    async def read_gatt_char(self, char, **kwargs) -> bytearray:
+        value = await self._client.read_gatt_char(char, **kwargs)
+        self._writer.read(str(getattr(char, "uuid", char)), value)
+        return value
+
+
+def recording_factory(writer: SessionWriter) -> Callable[..., RecordingClient]:
+    """For BLEManager.set_client_factory: real clients wrapped in RecordingClient."""
+    from bleak import BleakClient
+
+    def factory(*args, **kwargs) -> RecordingClient:
+        return RecordingClient(BleakClient(*args, **kwargs), writer)
+
+    return factory
+
+
+# ==================== Replay ====================
+
+class StageTimer:
+    """Durations per named stage, in seconds."""
+
+    def __init__(self):
+        self.stages: Dict[str, List[float]] = {}
+
+    def add(self, stage: str, seconds: float) -> None:
+        self.stages.setdefault(stage, []).append(seconds)
+
+    def wrap(self, stage: str, callback: Callable) -> Callable:
+        """callback with its duration added to stage on every call."""
+        def timed(*args):
+            start = time.perf_counter()
+            try:
+                return callback(*args)
+            finally:
+                self.add(stage, time.perf_counter() - start)
+        return timed
+
+
+@dataclass
+class ReplayReport:
+    speed: float
+    notifications: int
+    unhandled: int        # notifications of characteristics BLEManager did not subscribe to
+    writes: int           # writes BLEManager made (acks, time sync, missed event requests)
+    recorded_s: float
+    wall_s: float
+    stages: Dict[str, List[float]] = field(default_factory=dict)
+    actions: Optional[Any] = None   # gesture_handler.ActionStats when a GestureHandler was driven
+
+    def throughput(self) -> float:
+        return self.notifications / self.wall_s if self.wall_s > 0 else 0.0
+
+    def format(self) -> str:
+        speed = "max" if self.speed <= 0 else f"{self.speed:g}x"
+        lines = [f"[Replay] {self.notifications} notifications ({self.unhandled} unsubscribed), "
+                 f"{self.recorded_s:.2f} s recorded in {self.wall_s:.2f} s at {speed}: "
+                 f"{self.throughput():.0f} notifications/s, {self.writes} writes",
+                 f"  {'stage':<28} {'count':>7} {'mean us':>9} {'p50 us':>9} {'p99 us':>9} {'max us':>9}"]
+        for stage in sorted(self.stages):
+            values = self.stages[stage]
+            lines.append(f"  {stage:<28} {len(values):>7} {sum(values) / len(values) * 1e6:>9.1f} "
+                         f"{percentile(values, 0.5) * 1e6:>9.1f} {percentile(values, 0.99) * 1e6:>9.1f} "
+                         f"{max(values) * 1e6:>9.1f}")
+        if self.actions is not None and (self.actions.executed or self.actions.dropped):
+            a = self.actions
+            lines.append(f"  key injection: {a.executed} executed, {a.dropped} dropped, {a.coalesced} coalesced, "
+                         f"p50 {a.p50_ms or 0.0:.3f} ms, p95 {a.p95_ms or 0.0:.3f} ms, max {a.max_ms or 0.0:.3f} ms")
+            if a.call_p50_ms is not None:
+                lines.append(f"  injection call ({a.backend or 'custom'}): p50 {a.call_p50_ms:.3f} ms, "
+                             f"max {a.call_max_ms:.3f} ms")
+        return "\n".join(lines)
+
+
+class _ReplayCharacteristic:
+    def __init__(self, uuid: str):
+        self.uuid = uuid
+
+
+class _ReplayServices:
+    def __init__(self, uuids: List[str]):
+        self.characteristics = {i: _ReplayCharacteristic(uuid) for i, uuid in enumerate(uuids)}
+        self._by_uuid = {c.uuid: c for c in self.characteristics.values()}
+
+    def get_characteristic(self, uuid):
+        return self._by_uuid.get(str(uuid).lower())
+
+
+class ReplayClient:
+    """Stands in for BleakClient: answers reads from the session and plays its notifications back."""
+
+    def __init__(self, session: Session, timer: StageTimer, device=None,
+                 disconnected_callback: Optional[Callable[[Any], None]] = None, **kwargs):
+        self.address = REPLAY_ADDRESS
+        self.mtu_size = session.mtu
+        self._session = session
+        self._timer = timer
+        self._disconnected_callback = disconnected_callback
+        self._connected = False
+        self._handlers: Dict[str, Callable[[Any, bytearray], None]] = {}
+        self._reads: Dict[str, List[bytes]] = {}
+        for record in session.records:
+            if record.kind == KIND_READ:
+                self._reads.setdefault(record.uuid, []).append(record.data)
+        self.services = _ReplayServices([u for u in session.characteristics if u not in RecordingClient.HIDDEN])
+        self.writes = 0
+
+    @property
+    def is_connected(self) -> bool:
+        return self._connected
+
+    async def connect(self, **kwargs) -> bool:
+        self._connected = True
+        return True
+
+    async def disconnect(self) -> bool:
+        if self._connected:
+            self._connected = False
+            if self._disconnected_callback:
+                self._disconnected_callback(self)
+        return True
+
+    async def start_notify(self, char, callback: Callable[[Any, bytearray], None], **kwargs) -> None:
+        uuid = str(getattr(char, "uuid", char)).lower()
+        if self.services.get_characteristic(uuid) is None:
+            raise OSError(f"characteristic {uuid} not in the session")
+        self._handlers[uuid] = callback
+
+    async def stop_notify(self, char) -> None:
+        self._handlers.pop(str(getattr(char, "uuid", char)).lower(), None)
+
+    async def read_gatt_char(self, char, **kwargs) -> bytearray:
+        """The session's reads of a characteristic in order; the last one again once they run out."""
+        values = self._reads.get(str(getattr(char, "uuid", char)).lower())
+        if not values:
+            raise OSError(f"no recorded read of {char}")
+        return bytearray(values.pop(0) if len(values) > 1 else values[0])
+
+    async def write_gatt_char(self, char, data, response: bool = False) -> None:
+        self.writes += 1
+
+    async def play(self, speed: float = 1.0) -> ReplayReport:
+        """Deliver the notifications at speed times their recorded pace (0: back to back) on the running loop."""
+        names = {uuid.lower(): name[:-len("_UUID")] for name, uuid in vars(BLEManager).items()
+                 if name.endswith("_UUID") and isinstance(uuid, str)}
+        notifications = self._session.notifications()
+        unhandled = 0
+        base = notifications[0].time_s if notifications else 0.0
+        start = time.perf_counter()
+        for i, record in enumerate(notifications):
+            if not self._connected:
+                break
+            due = start
+            if speed > 0:
+                due = start + (record.time_s - base) / speed
+                delay = due - time.perf_counter()
+                await asyncio.sleep(delay if delay > 0 else 0)
+            elif i % YIELD_EVERY == 0:
+                # Let what the handlers scheduled (ack writes, missed event requests) run
+                await asyncio.sleep(0)
+            handler = self._handlers.get(record.uuid)
+            if handler is None:
+                unhandled += 1
+                continue
+            begin = time.perf_counter()
+            handler(self, bytearray(record.data))
+            end = time.perf_counter()
+            if speed > 0:
+                self._timer.add("dispatch", begin - due)
+            self._timer.add(f"notify {names.get(record.uuid, record.uuid)}", end - begin)
+        await asyncio.sleep(0)
+        return ReplayReport(speed, len(notifications), unhandled, self.writes, self._session.duration_s(),
+                            time.perf_counter() - start, self._timer.stages)
+
+
+def dry_run_gesture_handler(config):
+    """A GestureHandler that runs its whole path except pressing the keys."""
+    from gesture_handler import GestureHandler
+
+    class DryRunGestureHandler(GestureHandler):
+        def _press(self, modifiers: list, main_key) -> bool:
+            return main_key is not None
+
+    return DryRunGestureHandler(config)
+
+
+async def replay_session(path: str, speed: float = 1.0, manager: Optional[BLEManager] = None,
+                         handler=None) -> ReplayReport:
+    """Connect manager (a fresh BLEManager by default) to a replayed session and play it.
+
+    With a GestureHandler, process_gesture is the gesture callback and timed as a stage of its own;
+    without one, the callbacks already set on manager (the GUI's) are what the handlers call.
+    """
+    session = read_session(path)
+    timer = StageTimer()
+    clients: List[ReplayClient] = []
+
+    def factory(*args, **kwargs) -> ReplayClient:
+        client = ReplayClient(session, timer, *args, **kwargs)
+        clients.append(client)
+        return client
+
+    manager = manager or BLEManager()
+    manager.set_client_factory(factory)
+    manager.set_auto_reconnect(False)
+    if handler is not None:
+        manager.set_gesture_callback(timer.wrap("gesture handler", handler.process_gesture))
+    if not await manager.connect(REPLAY_ADDRESS):
+        raise OSError(f"replay of {path} did not connect")
+    try:
+        report = await clients[-1].play(speed)
+    finally:
+        await manager.disconnect()
+    if handler is not None:
+        handler.close()
+        report.actions = handler.action_stats()
+    return report
+
+
+# ==================== CLI ====================
+
+async def record(args) -> int:
+    manager = BLEManager()
+    writer = SessionWriter(args.output)
+    manager.set_client_factory(recording_factory(writer))
+    manager.set_auto_reconnect(False)
+    # Callbacks make BLEManager subscribe; the streams that load the link only when asked for
+    manager.set_gesture_callback(lambda gesture, confidence: print(f"[Session] {gesture} ({confidence:.2f})"))
+    for name in ("cpu", "counters", "latency", "breakdown", "config", "link", "hold", "combo", "power", "crash"):
+        getattr(manager, f"set_{name}_callback")(lambda *_: None)
+    if args.scores:
+        manager.set_scores_callback(lambda *_: None)
+    if args.window:
+        manager.set_window_callback(lambda *_: None)
+    if args.trace:
+        manager.set_trace_callback(lambda *_: None)
+    try:
+        connected = await manager.connect(args.address) if args.address else await manager.scan_and_connect()
+        if not connected:
+            print("[Session] Device not connected")
+            return 1
+        print(f"[Session] Recording for {args.seconds:g} s")
+        await asyncio.sleep(args.seconds)
+        await manager.disconnect()
+    finally:
+        writer.close()
+    print(f"[Session] {writer.notifications} notifications written to {args.output}")
+    return 0
+
+
+async def replay(args) -> int:
+    handler = None
+    if not args.no_handler:
+        from config_manager import ConfigManager
+        config = ConfigManager(args.config)
+        config.load()
+        handler = dry_run_gesture_handler(config)
+    report = await replay_session(args.session, args.speed, handler=handler)
+    print(report.format())
+    return 0
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    parser = argparse.ArgumentParser(description="Record a BLE session, or replay one into BLEManager")
+    commands = parser.add_subparsers(dest="command", required=True)
+    rec = commands.add_parser("record", help="record a session from a board")
+    rec.add_argument("output", help="session file to write")
+    rec.add_argument("--address", help="BLE device address (default: scan by name)")
+    rec.add_argument("--seconds", type=float, default=30.0, help="how long to record")
+    rec.add_argument("--scores", action="store_true", help="also record the score stream")
+    rec.add_argument("--window", action="store_true", help="also record the window stream")
+    rec.add_argument("--trace", action="store_true", help="also record the zone trace")
+    rep = commands.add_parser("replay", help="replay a session and report host throughput and latency")
+    rep.add_argument("session", help="session file to replay")
+    rep.add_argument("--speed", type=float, default=1.0, help="pace multiplier; 0 = as fast as possible")
+    rep.add_argument("--config", default="config.json", help="config for the gesture handler's shortcuts")
+    rep.add_argument("--no-handler", action="store_true", help="time BLEManager alone, without GestureHandler")
+    args = parser.parse_args(argv)
+    return asyncio.run(record(args) if args.command == "record" else replay(args))
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,545 @@
+"""
+BLE Worker Process
+
+Runs the transport (TransportSelector: USB link or BLE) in a separate process
+so that notification reception and decoding never wait for the GIL behind a
+Tkinter redraw. The worker hands its results to the GUI process through a
+single-producer / single-consumer ring of fixed-size records in shared memory
+(multiprocessing.shared_memory), and a dispatcher thread in the GUI process
+runs the gesture, hold and score callbacks - the fusion decoder and the action
+executor - straight from the ring. What the UI is doing only delays drawing.
+
+Ring (little-endian): a 128-byte header - uint32 write index and uint32
+dropped records (producer, offset 0), uint32 read index (consumer, offset 64,
+its own cache line) - then RING_RECORDS records of 64 bytes: uint32 sequence
+(index + 1, written last: a record is complete when it matches), uint8 kind,
+uint8 code, uint16 count, float value, double time.perf_counter() of the
+arrival (system-wide on Linux, macOS and Windows), 44 bytes payload.
+
+    GESTURE  value = confidence, payload = label
+    HOLD     code = 1 on onset / 0 on release, payload = label
+    STATUS   payload = status text, preceded by a STATE record
+    STATE    code = STATE_CONNECTED | STATE_HID, payload = last device address
+    SCORES   code = labels, count = sequence, payload = float probabilities then int8 scores
+
+The ring never blocks the worker: when it is full a record is dropped and
+counted. Everything else - commands (scan, connect, keymap writes), their
+replies, the diagnostics snapshot every STATS_PERIOD_S and the low-rate
+callbacks (latency breakdown, counters, CPU, crash report, window stream) -
+goes over a multiprocessing pipe.
+
+BLEWorkerClient has the BLEManager methods the GUI uses, so MainWindow takes
+either. The latency tracker's "handling" stage, measured in the worker, now
+ends at the hand-off to the ring; key injection is still in the action stats.
+"""
+
+import asyncio
+import concurrent.futures
+import itertools
+import multiprocessing
+import struct
+import threading
+import time
+from collections import namedtuple
+from multiprocessing import shared_memory
+from typing import Any, Callable, Dict, List, Optional
+
+from ble_manager import DeliveryTracker, LatencyBreakdown, ScoreFrame
+
+RING_RECORDS = 256
+RING_HEADER_BYTES = 128
+RING_READ_OFFSET = 64
+RECORD = struct.Struct('<IBBHfd44s')
+INDEX = struct.Struct('<I')
+
+# Record kinds
+KIND_GESTURE = 1
+KIND_HOLD = 2
+KIND_STATUS = 3
+KIND_STATE = 4
+KIND_SCORES = 5
+
+STATE_CONNECTED = 0x01
+STATE_HID = 0x02
+
+# Score frames with more labels do not fit a record (4 + 1 bytes per label)
+SCORES_MAX_LABELS = 8
+# Diagnostics snapshot period while connected (the GUI redraws every 500 ms)
+STATS_PERIOD_S = 0.5
+# The dispatcher re-checks the ring this often even without a doorbell
+DISPATCH_IDLE_S = 0.25
+
+# Callbacks that only exist while the GUI sets them: the device streams depend on them
+SUBSCRIPTIONS = ("scores", "window", "breakdown", "counters", "cpu", "crash")
+# Methods the GUI process may call in the worker
+CALLS = ("scan_devices", "stop_scan", "connect", "scan_and_connect", "disconnect", "write_keymap",
+         "set_operating_point", "set_auto_reconnect", "set_known_address")
+
+RingEvent = namedtuple("RingEvent", "kind code count value time payload")
+# Scan results cross the pipe as name and address only (bleak's BLEDevice holds OS handles)
+FoundDevice = namedtuple("FoundDevice", "name address")
+
+
+class EventRing:
+    """Single-producer / single-consumer ring of RECORD-sized events over a shared memory buffer.
+
+    Indices are uint32 and wrap, so the capacity must be a power of two. Each side
+    only writes its own index; a record's sequence number is written after its
+    fields, so the consumer never reads a half-written record.
+    """
+
+    def __init__(self, buf: memoryview, capacity: int = RING_RECORDS):
+        if capacity <= 0 or capacity & (capacity - 1):
+            raise ValueError("ring capacity must be a power of two")
+        if len(buf) < self.size(capacity):
+            raise ValueError("shared memory block too small for the ring")
+        self._buf = buf
+        self.capacity = capacity
+
+    @staticmethod
+    def size(capacity: int = RING_RECORDS) -> int:
+        return RING_HEADER_BYTES + capacity * RECORD.size
+
+    def _index(self, offset: int) -> int:
+        return INDEX.unpack_from(self._buf, offset)[0]
+
+    @property
+    def dropped(self) -> int:
+        return self._index(4)
+
+    def pending(self) -> int:
+        return (self._index(0) - self._index(RING_READ_OFFSET)) & 0xFFFFFFFF
+
+    def push(self, kind: int, code: int = 0, count: int = 0, value: float = 0.0, payload: bytes = b"",
+             timestamp: Optional[float] = None) -> bool:
+        """Producer: append a record; False (and counted) when the ring is full."""
+        write = self._index(0)
+        if (write - self._index(RING_READ_OFFSET)) & 0xFFFFFFFF >= self.capacity:
+            INDEX.pack_into(self._buf, 4, (self.dropped + 1) & 0xFFFFFFFF)
+            return False
+        offset = RING_HEADER_BYTES + (write % self.capacity) * RECORD.size
+        record = RECORD.pack(0, kind, code, count, value, time.perf_counter() if timestamp is None else timestamp,
+                             payload[:44])
+        self._buf[offset + 4:offset + RECORD.size] = record[4:]
+        INDEX.pack_into(self._buf, offset, (write + 1) & 0xFFFFFFFF)
+        INDEX.pack_into(self._buf, 0, (write + 1) & 0xFFFFFFFF)
+        return True
+
+    def pop(self) -> Optional[RingEvent]:
+        """Consumer: the oldest complete record, None when there is none."""
+        read = self._index(RING_READ_OFFSET)
+        if read == self._index(0):
+            return None
+        offset = RING_HEADER_BYTES + (read % self.capacity) * RECORD.size
+        sequence, kind, code, count, value, timestamp, payload = RECORD.unpack_from(self._buf, offset)
+        if sequence != (read + 1) & 0xFFFFFFFF:
+            return None
+        INDEX.pack_into(self._buf, RING_READ_OFFSET, (read + 1) & 0xFFFFFFFF)
+        return RingEvent(kind, code, count, value, timestamp, payload)
+
+
+def text(payload: bytes) -> str:
+    return payload.rstrip(b"\x00").decode("utf-8", errors="replace")
+
+
+def encode_scores(frame: ScoreFrame) -> Optional[bytes]:
+    labels = len(frame.scores)
+    if labels > SCORES_MAX_LABELS:
+        return None
+    return struct.pack(f'<{labels}f{labels}b', *frame.probabilities, *frame.scores)
+
+
+def decode_scores(event: RingEvent) -> ScoreFrame:
+    values = struct.unpack_from(f'<{event.code}f{event.code}b', event.payload)
+    return ScoreFrame(event.count, list(values[event.code:]), list(values[:event.code]))
+
+
+class WorkerServer:
+    """The worker side: feeds the manager's callbacks into the ring and runs the GUI's commands on its loop."""
+
+    def __init__(self, manager: Any, conn: Any, ring: EventRing, doorbell: Any,
+                 loop: asyncio.AbstractEventLoop):
+        self._manager = manager
+        self._conn = conn
+        self._ring = ring
+        self._doorbell = doorbell
+        self._loop = loop
+        self._keymap: Dict[str, str] = {}
+        self._layouts: Dict[str, Optional[int]] = {}
+        manager.set_gesture_callback(self._on_gesture)
+        manager.set_hold_callback(self._on_hold)
+        manager.set_status_callback(self._on_status)
+        manager.set_keymap_provider(lambda: dict(self._keymap))
+        manager.set_layout_store(self._layouts.get, self._save_layout)
+
+    def _push(self, kind: int, code: int = 0, count: int = 0, value: float = 0.0, payload: bytes = b"") -> None:
+        if self._ring.push(kind, code, count, value, payload):
+            self._doorbell.set()
+
+    def _send(self, message: tuple) -> None:
+        try:
+            self._conn.send(message)
+        except (OSError, EOFError):
+            pass  # the GUI process is gone; the loop stops on its next command read
+
+    def push_state(self) -> None:
+        flags = STATE_CONNECTED if self._manager.is_connected() else 0
+        if self._manager.device_hid():
+            flags |= STATE_HID
+        self._push(KIND_STATE, flags, payload=(self._manager.last_device_address() or "").encode())
+
+    def _on_gesture(self, gesture: str, confidence: float) -> None:
+        self._push(KIND_GESTURE, value=confidence, payload=gesture.encode())
+
+    def _on_hold(self, gesture: str, held: bool) -> None:
+        self._push(KIND_HOLD, 1 if held else 0, payload=gesture.encode())
+
+    def _on_status(self, status: str) -> None:
+        self.push_state()
+        self._push(KIND_STATUS, payload=status.encode())
+
+    def _on_scores(self, frame: ScoreFrame) -> None:
+        payload = encode_scores(frame)
+        if payload is not None:
+            self._push(KIND_SCORES, len(frame.scores), frame.sequence, payload=payload)
+
+    def _save_layout(self, address: str, layout: int) -> None:
+        self._layouts[address] = layout
+        self._send(("event", "layout", (address, layout)))
+
+    def subscribe(self, name: str) -> None:
+        if name == "scores":
+            self._manager.set_scores_callback(self._on_scores)
+        else:
+            getattr(self._manager, f"set_{name}_callback")(lambda value, name=name: self._send(("event", name, value)))
+
+    def handle(self, message: tuple) -> None:
+        """One message from the GUI process (on the loop)."""
+        if message[0] == "call":
+            _, call_id, method, args, kwargs = message
+            self._loop.create_task(self._call(call_id, method, args, kwargs))
+        elif message[0] == "subscribe" and message[1] in SUBSCRIPTIONS:
+            self.subscribe(message[1])
+        elif message[0] == "keymap":
+            self._keymap = dict(message[1])
+        elif message[0] == "layout":
+            self._layouts[message[1]] = message[2]
+        elif message[0] == "close":
+            self._loop.create_task(self._close())
+
+    async def _call(self, call_id: int, method: str, args: tuple, kwargs: dict) -> None:
+        try:
+            if method not in CALLS:
+                raise AttributeError(f"{method} is not available in the BLE worker")
+            if method == "scan_devices" and kwargs.pop("report_found", False):
+                kwargs["on_found"] = lambda d: self._send(("event", "found", (d.name, d.address)))
+            result = getattr(self._manager, method)(*args, **kwargs)
+            if asyncio.iscoroutine(result):
+                result = await result
+            if method == "scan_devices":
+                result = [(d.name, d.address) for d in result]
+            self._send(("reply", call_id, True, result))
+        except Exception as e:
+            self._send(("reply", call_id, False, f"{type(e).__name__}: {e}"))
+        self.push_state()
+
+    async def _close(self) -> None:
+        try:
+            await self._manager.disconnect()
+        finally:
+            self._loop.stop()
+
+    async def report_stats(self) -> None:
+        """The diagnostics the GUI redraws, sent while connected."""
+        while True:
+            await asyncio.sleep(STATS_PERIOD_S)
+            if self._manager.is_connected():
+                self._send(("event", "stats", (self._manager.delivery_stats(), self._manager.latency_breakdown(),
+                                               self._manager.end_to_end_latency())))
+
+    def read_commands(self) -> None:
+        """Command reader thread: every message runs on the loop; a closed pipe ends the worker."""
+        while True:
+            try:
+                message = self._conn.recv()
+            except (OSError, EOFError):
+                message = ("close",)
+            self._loop.call_soon_threadsafe(self.handle, message)
+            if message[0] == "close":
+                return
+
+
+def worker_main(conn: Any, shm_name: str, capacity: int, doorbell: Any) -> None:
+    """Entry point of the worker process."""
+    # Spawned children share the GUI process's resource tracker, which unlinks the block once
+    shm = shared_memory.SharedMemory(name=shm_name)
+    from ble_manager import BLEManager
+    from serial_manager import TransportSelector
+    loop = asyncio.new_event_loop()
+    asyncio.set_event_loop(loop)
+    ring = EventRing(shm.buf, capacity)
+    server = WorkerServer(TransportSelector(ble=BLEManager()), conn, ring, doorbell, loop)
+    threading.Thread(target=server.read_commands, daemon=True).start()
+    stats = loop.create_task(server.report_stats())
+    try:
+        loop.run_forever()
+    finally:
+        stats.cancel()
+        del ring, server
+        shm.close()
+
+
+class BLEWorkerClient:
+    """The GUI side: the BLEManager methods MainWindow uses, served by the worker process."""
+
+    def __init__(self, capacity: int = RING_RECORDS):
+        self._capacity = capacity
+        self._shm: Optional[shared_memory.SharedMemory] = None
+        self._ring: Optional[EventRing] = None
+        self._process = None
+        self._conn = None
+        self._doorbell = None
+        self._send_lock = threading.Lock()
+        self._ids = itertools.count(1)
+        self._pending: Dict[int, concurrent.futures.Future] = {}
+        self._callbacks: Dict[str, Callable] = {}
+        self._keymap_provider: Optional[Callable[[], Dict[str, str]]] = None
+        self._layout_load: Optional[Callable[[str], Optional[int]]] = None
+        self._layout_save: Optional[Callable[[str, int], None]] = None
+        self._on_found: Optional[Callable[[FoundDevice], None]] = None
+        self._connected = False
+        self._hid = False
+        self._address: Optional[str] = None
+        # Until the worker's first snapshot
+        self._stats: tuple = (DeliveryTracker(), LatencyBreakdown(None, None, None, None, 0, None), {})
+        self._closed = False
+
+    def start(self) -> None:
+        """Create the ring and start the worker process and the dispatcher / reply threads."""
+        context = multiprocessing.get_context("spawn")
+        self._shm = shared_memory.SharedMemory(create=True, size=EventRing.size(self._capacity))
+        self._shm.buf[:RING_HEADER_BYTES] = bytes(RING_HEADER_BYTES)
+        self._ring = EventRing(self._shm.buf, self._capacity)
+        self._doorbell = context.Event()
+        self._conn, child = context.Pipe()
+        self._process = context.Process(target=worker_main, args=(child, self._shm.name, self._capacity,
+                                                                  self._doorbell), daemon=True)
+        self._process.start()
+        child.close()
+        threading.Thread(target=self._dispatch_loop, daemon=True).start()
+        threading.Thread(target=self._read_loop, daemon=True).start()
+
+    def close(self, timeout_s: float = 5.0) -> None:
+        """Disconnect in the worker, stop it and release the ring."""
+        if self._closed:
+            return
+        self._closed = True
+        if self._process is not None:
+            self._send(("close",))
+            self._process.join(timeout_s)
+            if self._process.is_alive():
+                self._process.terminate()
+        if self._shm is not None:
+            self._ring = None
+            self._shm.close()
+            self._shm.unlink()
+            self._shm = None
+
+    # ---- ring consumer ----
+
+    def _dispatch_loop(self) -> None:
+        while not self._closed:
+            self._doorbell.wait(DISPATCH_IDLE_S)
+            self._doorbell.clear()
+            self.drain()
+
+    def drain(self) -> int:
+        """Run the callbacks of every complete record in the ring; the number handled."""
+        handled = 0
+        while self._ring is not None:
+            event = self._ring.pop()
+            if event is None:
+                break
+            self.dispatch(event)
+            handled += 1
+        return handled
+
+    def dispatch(self, event: RingEvent) -> None:
+        if event.kind == KIND_STATE:
+            self._connected = bool(event.code & STATE_CONNECTED)
+            self._hid = bool(event.code & STATE_HID)
+            self._address = text(event.payload) or None
+            return
+        if event.kind == KIND_GESTURE:
+            name, args = "gesture", (text(event.payload), event.value)
+        elif event.kind == KIND_HOLD:
+            name, args = "hold", (text(event.payload), bool(event.code))
+        elif event.kind == KIND_STATUS:
+            name, args = "status", (text(event.payload),)
+        elif event.kind == KIND_SCORES:
+            name, args = "scores", (decode_scores(event),)
+        else:
+            return
+        callback = self._callbacks.get(name)
+        if callback:
+            try:
+                callback(*args)
+            except Exception as e:
+                print(f"[BLE worker] {name} callback error: {e}")
+
+    # ---- pipe ----
+
+    def _send(self, message: tuple) -> None:
+        with self._send_lock:
+            self._conn.send(message)
+
+    def _read_loop(self) -> None:
+        while True:
+            try:
+                message = self._conn.recv()
+            except (OSError, EOFError):
+                break
+            self.handle(message)
+        for future in self._pending.values():
+            future.set_exception(RuntimeError("BLE worker stopped"))
+        self._pending.clear()
+        if not self._closed and "status" in self._callbacks:
+            print("[BLE worker] Worker process stopped")
+            self._connected = False
+            self._callbacks["status"]("Disconnected")
+
+    def handle(self, message: tuple) -> None:
+        """One message from the worker (reply thread)."""
+        if message[0] == "reply":
+            _, call_id, ok, value = message
+            future = self._pending.pop(call_id, None)
+            if future is not None:
+                if ok:
+                    future.set_result(value)
+                else:
+                    future.set_exception(RuntimeError(f"BLE worker: {value}"))
+        elif message[0] == "event":
+            _, name, value = message
+            if name == "stats":
+                self._stats = value
+            elif name == "found":
+                if self._on_found:
+                    self._on_found(FoundDevice(*value))
+            elif name == "layout":
+                if self._layout_save:
+                    self._layout_save(*value)
+            elif name in self._callbacks:
+                self._callbacks[name](value)
+
+    def _call(self, method: str, *args, **kwargs) -> concurrent.futures.Future:
+        future: concurrent.futures.Future = concurrent.futures.Future()
+        call_id = next(self._ids)
+        self._pending[call_id] = future
+        self._send(("call", call_id, method, args, kwargs))
+        return future
+
+    async def _await(self, method: str, *args, **kwargs) -> Any:
+        return await asyncio.wrap_future(self._call(method, *args, **kwargs))
+
+    def _push_settings(self, address: Optional[str]) -> None:
+        """What the worker asks the GUI process for while connecting: the keymap and the address's GATT layout."""
+        if self._keymap_provider:
+            self._send(("keymap", self._keymap_provider()))
+        if address and self._layout_load:
+            self._send(("layout", address, self._layout_load(address)))
+
+    # ---- BLEManager interface ----
+
+    def set_gesture_callback(self, callback: Callable[[str, float], None]) -> None:
+        self._callbacks["gesture"] = callback
+
+    def set_hold_callback(self, callback: Callable[[str, bool], None]) -> None:
+        self._callbacks["hold"] = callback
+
+    def set_status_callback(self, callback: Callable[[str], None]) -> None:
+        self._callbacks["status"] = callback
+
+    def _subscribe(self, name: str, callback: Callable) -> None:
+        self._callbacks[name] = callback
+        self._send(("subscribe", name))
+
+    def set_scores_callback(self, callback: Callable[[ScoreFrame], None]) -> None:
+        self._subscribe("scores", callback)
+
+    def set_window_callback(self, callback: Callable) -> None:
+        self._subscribe("window", callback)
+
+    def set_breakdown_callback(self, callback: Callable) -> None:
+        self._subscribe("breakdown", callback)
+
+    def set_counters_callback(self, callback: Callable) -> None:
+        self._subscribe("counters", callback)
+
+    def set_cpu_callback(self, callback: Callable) -> None:
+        self._subscribe("cpu", callback)
+
+    def set_crash_callback(self, callback: Callable) -> None:
+        self._subscribe("crash", callback)
+
+    def set_keymap_provider(self, provider: Callable[[], Dict[str, str]]) -> None:
+        self._keymap_provider = provider
+
+    def set_layout_store(self, load: Callable[[str], Optional[int]], save: Callable[[str, int], None]) -> None:
+        self._layout_load = load
+        self._layout_save = save
+
+    def set_auto_reconnect(self, enabled: bool) -> None:
+        self._call("set_auto_reconnect", enabled)
+
+    def set_known_address(self, address: Optional[str]) -> None:
+        if address:
+            self._address = address
+        self._call("set_known_address", address)
+
+    def last_device_address(self) -> Optional[str]:
+        return self._address
+
+    def is_connected(self) -> bool:
+        return self._connected
+
+    def device_hid(self) -> bool:
+        return self._hid
+
+    def delivery_stats(self) -> DeliveryTracker:
+        return self._stats[0]
+
+    def latency_breakdown(self) -> LatencyBreakdown:
+        return self._stats[1]
+
+    def end_to_end_latency(self) -> Dict[float, Optional[float]]:
+        return self._stats[2]
+
+    def dropped_events(self) -> int:
+        """Ring records the worker had to drop because the dispatcher fell behind."""
+        return self._ring.dropped if self._ring is not None else 0
+
+    async def scan_devices(self, timeout: float = 10.0, on_found: Optional[Callable[[FoundDevice], None]] = None,
+                           stop_at: Optional[str] = None) -> List[FoundDevice]:
+        self._on_found = on_found
+        devices = await self._await("scan_devices", timeout, stop_at=stop_at, report_found=on_found is not None)
+        return [FoundDevice(*device) for device in devices]
+
+    async def stop_scan(self) -> None:
+        await self._await("stop_scan")
+
+    async def connect(self, address: str) -> bool:
+        self._push_settings(address)
+        return await self._await("connect", address)
+
+    async def scan_and_connect(self, timeout: float = 15.0, known_address: Optional[str] = None) -> bool:
+        self._push_settings(known_address)
+        return await self._await("scan_and_connect", timeout, known_address)
+
+    async def disconnect(self) -> None:
+        await self._await("disconnect")
+
+    async def write_keymap(self, shortcuts: Dict[str, str]) -> bool:
+        return await self._await("write_keymap", shortcuts)
+
+    async def set_operating_point(self, point: Optional[str]) -> bool:
+        return await self._await("set_operating_point", point)
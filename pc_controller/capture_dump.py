@@ -0,0 +1,171 @@
+"""
+Capture dump - download the low-confidence windows the board captured for labelling
+
+Firmware built with CAPTURE_ENABLE copies the model's int8 input window into a
+ring of flash sectors whenever the winning probability falls in the ambiguity
+band (CAPTURE_BAND_LOW..CAPTURE_BAND_HIGH) or the two best classes are closer
+than CAPTURE_MARGIN, at most one window per CAPTURE_INTERVAL_MS. Those are the
+windows the model is least sure about, so labelling them improves the next
+training run the most. The ring is read through the diagnostics log transport
+(telemetry characteristic or USB link, command 0x03).
+
+Records (little-endian, fixed size): uint32 milliseconds since boot, int8 top
+class, int8 runner-up (-1 = none), uint8 their probabilities x 255, uint16
+ambiguous windows skipped before this one, uint16 CRC-16/CCITT-FALSE over
+every other byte of the record, float input scale, int8 input zero point,
+uint8 axes per frame, uint8 frames, uint8 flags, then the int8 window oldest
+frame first. A dump is the records of every sector, oldest first.
+
+Usage:
+    python capture_dump.py --output windows.jsonl                     # over BLE
+    python capture_dump.py --port /dev/ttyACM0 --output windows.jsonl # over the USB link
+    python capture_dump.py --status
+
+Each output line holds the decoded window in physical units (or normalized
+units when the firmware normalizes windows) and an empty "label" to fill in.
+"""
+
+import argparse
+import asyncio
+import json
+import struct
+import sys
+from collections import Counter
+from dataclasses import asdict, dataclass, field
+from typing import List, Optional, Tuple
+
+from gesture_labels import MODEL_LABELS
+from serial_manager import crc16
+
+RECORD_HEADER = struct.Struct('<IbbBBHHfbBBB')
+CRC_OFFSET = 10
+
+# CAPTURE_FLAG_* in include/capture_module.h
+FLAG_BAND = 0x01
+FLAG_MARGIN = 0x02
+FLAG_NORMALIZED = 0x04
+
+
+@dataclass
+class CapturedWindow:
+    time_ms: int
+    top: str
+    top_confidence: float
+    runner_up: Optional[str]
+    runner_up_confidence: float
+    skipped: int                      # ambiguous windows not captured just before this one
+    reasons: List[str]                # "band" and/or "margin"
+    normalized: bool
+    frames: List[List[float]] = field(default_factory=list)
+    label: Optional[str] = None
+
+
+def label(index: int) -> str:
+    return MODEL_LABELS[index] if 0 <= index < len(MODEL_LABELS) else str(index)
+
+
+def record_size(data: bytes, offset: int = 0) -> Optional[int]:
+    """Size of the record at offset, from its axes and frames; None past the end of the data."""
+    if offset + RECORD_HEADER.size > len(data):
+        return None
+    axes, frames = data[offset + 17], data[offset + 18]
+    return (RECORD_HEADER.size + axes * frames + 3) // 4 * 4
+
+
+def decode_window(data: bytes) -> Optional[CapturedWindow]:
+    """One record, or None when its CRC does not match."""
+    (time_ms, top, runner_up, top_q, runner_up_q, skipped, crc, scale, zero_point, axes, frames,
+     flags) = RECORD_HEADER.unpack_from(data)
+    if crc16(data[CRC_OFFSET + 2:], crc16(data[:CRC_OFFSET])) != crc:
+        return None
+    values = struct.unpack_from(f'<{axes * frames}b', data, RECORD_HEADER.size)
+    window = [[(values[f * axes + a] - zero_point) * scale for a in range(axes)] for f in range(frames)]
+    reasons = [name for bit, name in ((FLAG_BAND, "band"), (FLAG_MARGIN, "margin")) if flags & bit]
+    return CapturedWindow(time_ms, label(top), top_q / 255, label(runner_up) if runner_up >= 0 else None,
+                          runner_up_q / 255, skipped, reasons, bool(flags & FLAG_NORMALIZED), window)
+
+
+def decode_windows(data: bytes) -> Tuple[List[CapturedWindow], int]:
+    """Windows of a dump and the number of bytes that did not decode (bad CRC or a truncated tail)."""
+    windows = []
+    offset = 0
+    damaged = 0
+    while True:
+        size = record_size(data, offset)
+        if size is None or size <= RECORD_HEADER.size or offset + size > len(data):
+            break
+        window = decode_window(data[offset:offset + size])
+        if window is None:
+            damaged += size
+        else:
+            windows.append(window)
+        offset += size
+    return windows, damaged + len(data) - offset
+
+
+def summarize(windows: List[CapturedWindow]) -> List[str]:
+    """Captured windows per confused pair, most frequent first."""
+    pairs = Counter((w.top, w.runner_up) for w in windows)
+    skipped = sum(w.skipped for w in windows)
+    lines = [f"{len(windows)} windows captured ({skipped} ambiguous windows skipped by the rate limit)"]
+    for (top, runner_up), count in pairs.most_common():
+        lines.append(f"    {top} vs {runner_up or '-'}: {count}")
+    return lines
+
+
+async def run(args) -> int:
+    if args.port:
+        from serial_manager import SerialManager
+        manager = SerialManager()
+    else:
+        from ble_manager import BLEManager
+        manager = BLEManager()
+    manager.set_auto_reconnect(False)
+    address = args.port or args.address
+    connected = await manager.connect(address) if address else await manager.scan_and_connect()
+    if not connected:
+        print("[Capture] Device not connected")
+        return 1
+    try:
+        status = await manager.read_telemetry_status()
+        if status is None:
+            print("[Capture] No diagnostics log (firmware without TELEMETRY_ENABLE?)")
+            return 1
+        print(f"[Capture] Device: {status.capture_bytes} bytes captured in flash, {status.captured} windows "
+              f"since boot ({status.capture_suppressed} skipped)")
+        if args.status:
+            return 0
+        dump = await manager.dump_telemetry(args.timeout, captures=True)
+        if dump is None:
+            return 1
+        windows, damaged = decode_windows(bytes(dump.data))
+        if not dump.data:
+            print("[Capture] Nothing captured (firmware without CAPTURE_ENABLE?)")
+        if dump.gap:
+            print("[Capture] A chunk was lost: the dump ends early")
+        if damaged:
+            print(f"[Capture] {damaged} damaged bytes skipped")
+        if args.output:
+            with open(args.output, "w") as f:
+                for window in windows:
+                    f.write(json.dumps(asdict(window)) + "\n")
+            print(f"[Capture] {len(windows)} windows written to {args.output}")
+        for line in summarize(windows):
+            print(line)
+        return 0
+    finally:
+        await manager.disconnect()
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    parser = argparse.ArgumentParser(description="Download the low-confidence windows captured by the board")
+    parser.add_argument("--port", help="serial port of the board (default: BLE)")
+    parser.add_argument("--address", help="BLE device address (default: scan by name)")
+    parser.add_argument("--status", action="store_true", help="print the capture counters without dumping")
+    parser.add_argument("--output", help="write the decoded windows as JSON lines, ready for labelling")
+    parser.add_argument("--timeout", type=float, default=120.0, help="seconds to wait for the dump")
+    return asyncio.run(run(parser.parse_args(argv)))
+
+
+if __name__ == "__main__":
+    sys.exit(main())
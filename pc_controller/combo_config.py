@@ -0,0 +1,120 @@
+"""
+Combo config - teach the board gesture combos
+
+Firmware built with BLE_COMBO_ENABLE matches sequences of gestures itself:
+the combos written here ("up,up,left") are compiled on the device into a
+transition table, every published gesture advances it in constant time, and a
+completed combo arrives as one notification on the combo event characteristic
+(19B1002E) or USB frame 0x2E. The host no longer has to receive every gesture
+and decide. Two gestures of a combo may be at most --gap ms apart.
+
+The device rejects a table where one combo is a prefix of another or occurs
+in the middle of one, because the shorter combo would always complete first.
+It also rejects a combo that contains idle. After a rejection the old table
+stays in use. The table is kept in flash.
+
+Usage:
+    python combo_config.py --set up,up,left down,right --gap 800
+    python combo_config.py --show
+    python combo_config.py --clear
+    python combo_config.py --listen                  # print combos as the device completes them
+    python combo_config.py --port /dev/ttyACM0 --show
+"""
+
+import argparse
+import asyncio
+import sys
+from typing import List, Optional
+
+from ble_manager import COMBO_DEFAULT_GAP_MS, ComboEvent, ComboTable
+from gesture_labels import MODEL_LABELS
+
+
+def parse_combo(text: str) -> List[int]:
+    """'up,up,left' -> model label indices."""
+    names = [name.strip() for name in text.split(",") if name.strip()]
+    for name in names:
+        if name not in MODEL_LABELS:
+            raise argparse.ArgumentTypeError(f"unknown gesture '{name}' (labels: {', '.join(MODEL_LABELS)})")
+    return [MODEL_LABELS.index(name) for name in names]
+
+
+def describe(table: ComboTable) -> List[str]:
+    lines = [f"{len(table.combos)} combos, gap {table.gap_ms} ms"]
+    for n, combo in enumerate(table.combos):
+        names = [MODEL_LABELS[i] if i < len(MODEL_LABELS) else str(i) for i in combo]
+        lines.append(f"  {n}: {', '.join(names)}")
+    return lines
+
+
+def describe_event(event: ComboEvent, table: Optional[ComboTable]) -> str:
+    text = f"combo {event.combo}"
+    if table is not None and event.combo < len(table.combos):
+        text += " (" + ", ".join(MODEL_LABELS[i] for i in table.combos[event.combo]) + ")"
+    return text + f" in {event.end_ms - event.start_ms} ms, result #{event.sequence}"
+
+
+async def run(args) -> int:
+    if args.port:
+        from serial_manager import SerialManager
+        manager = SerialManager()
+    else:
+        from ble_manager import BLEManager
+        manager = BLEManager()
+    manager.set_auto_reconnect(False)
+    done = asyncio.Event()
+    table: Optional[ComboTable] = None
+    if args.listen:
+        manager.set_combo_callback(lambda event: print(f"[Combo] {describe_event(event, table)}"))
+    address = args.port or args.address
+    connected = await manager.connect(address) if address else await manager.scan_and_connect()
+    if not connected:
+        print("[Combo] Device not connected")
+        return 1
+    try:
+        table = await manager.read_combos()
+        if table is None:
+            print("[Combo] No combo table (firmware without BLE_COMBO_ENABLE?)")
+            return 1
+        if args.set is not None or args.clear:
+            wanted = ComboTable(args.gap, [] if args.clear else args.set)
+            table = await manager.write_combos(wanted)
+            if table != wanted:
+                print("[Combo] The device rejected the combos (see its log); still in use:")
+                for line in describe(table) if table else []:
+                    print(line)
+                return 1
+        for line in describe(table):
+            print(line)
+        if args.listen:
+            print("[Combo] Listening, Ctrl+C to stop")
+            await done.wait()
+        return 0
+    finally:
+        await manager.disconnect()
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    parser = argparse.ArgumentParser(description="Set the gesture combos the board recognizes itself")
+    parser.add_argument("--set", nargs="+", type=parse_combo, metavar="COMBO",
+                        help="combos as comma-separated gestures, e.g. up,up,left")
+    parser.add_argument("--gap", type=int, default=COMBO_DEFAULT_GAP_MS,
+                        help=f"longest pause between two gestures of a combo in ms (default {COMBO_DEFAULT_GAP_MS})")
+    parser.add_argument("--clear", action="store_true", help="remove every combo")
+    parser.add_argument("--show", action="store_true", help="print the device's combos")
+    parser.add_argument("--listen", action="store_true", help="print combos as the device completes them")
+    parser.add_argument("--port", help="serial port of the board (default: BLE)")
+    parser.add_argument("--address", help="BLE device address (default: scan by name)")
+    args = parser.parse_args(argv)
+    if args.set is None and not (args.clear or args.show or args.listen):
+        parser.error("give --set, --clear, --show or --listen")
+    if not 1 <= args.gap <= 0xFFFF:
+        parser.error("--gap must be 1..65535 ms")
+    try:
+        return asyncio.run(run(args))
+    except KeyboardInterrupt:
+        return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
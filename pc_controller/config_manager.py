@@ -7,13 +7,32 @@ Supports custom keyboard shortcuts for each gesture.
 
 import json
 import os
-from typing import Optional
+import threading
+import time
+from dataclasses import dataclass
+from types import MappingProxyType
+from typing import Callable, FrozenSet, List, Mapping, Optional, Tuple
+
+from gesture_labels import GESTURE_LABELS
+
+
+@dataclass(frozen=True)
+class ConfigSnapshot:
+    """Read-only view of the settings hot paths use; replaced as a whole on every change, never modified."""
+    gesture_shortcuts: Mapping[str, str]
+    confidence_threshold: float
+    cooldown_time: float
+    fusion_method: str
+    fusion_thresholds: Mapping[str, float]
+    repeat_gestures: FrozenSet[str]
+    repeat_rate_hz: float
 
 
 class ConfigManager:
     """Configuration persistence and management."""
     
-    VALID_GESTURES = {"left", "right", "up", "down"}
+    # Gestures of the deployed model (generated by label_table_gen.py)
+    VALID_GESTURES = set(GESTURE_LABELS)
     
     # Default shortcuts for each gesture
     DEFAULT_CONFIG = {
@@ -26,14 +45,77 @@ class ConfigManager:
         "confidence_threshold": 0.70,
         "cooldown_time": 2.0,
         "last_device_address": None,
-        "auto_reconnect": True
+        "auto_reconnect": True,
+        "gatt_layouts": {},
+        # Host-side decoder over the score stream (fusion.py); thresholds per gesture, missing ones
+        # use confidence_threshold
+        "fusion_method": "off",
+        "fusion_thresholds": {},
+        # Gestures whose shortcut repeats while the device reports them held (hold-to-repeat)
+        "repeat_gestures": [],
+        "repeat_rate_hz": 10.0,
+        # Larger model run on the PC over the window stream (host_model.py): a .tflite path ("" = off) and its
+        # class names in output order (empty: the deployed model's labels)
+        "host_model_path": "",
+        "host_model_labels": [],
+        # Decided gestures published to other applications (event_publisher.py): UDP "group:port" ("" = off)
+        # and a local WebSocket port (0 = off)
+        "publish_multicast": "",
+        "publish_websocket_port": 0,
+        # Processes (executable names, any case) in whose foreground the device runs full-rate inference
+        # (foreground_watcher.py); any other foreground application asks for background_power_point. [] = off
+        "gesture_apps": ["POWERPNT.EXE", "PPTVIEW.EXE", "vlc.exe", "wmplayer.exe", "Microsoft.Media.Player.exe"],
+        "background_power_point": "idle-filter"
     }
+
+    FUSION_METHODS = ("off", "smoothing", "hmm")
+    # Power points (POWER_POINTS in ble_manager.py) a background application may ask for
+    BACKGROUND_POWER_POINTS = ("coarse", "idle-filter", "on-demand")
+    REPEAT_RATE_RANGE = (1.0, 30.0)
+
+    # save() writes the file this long after the last call, on a background thread
+    SAVE_DELAY_S = 0.5
     
-    def __init__(self, config_path: str = "config.json"):
+    def __init__(self, config_path: str = "config.json", save_delay_s: float = SAVE_DELAY_S):
         """Initialize ConfigManager with the specified config file path."""
         self._config_path = config_path
+        self._change_callbacks: List[Callable[[], None]] = []
         self._config = self._deep_copy(self.DEFAULT_CONFIG)
+        self._snapshot = self._make_snapshot()
+        self._save_delay_s = save_delay_s
+        self._save_condition = threading.Condition()
+        self._write_lock = threading.Lock()
+        self._pending: Optional[str] = None
+        self._pending_due = 0.0
+        self._writer: Optional[threading.Thread] = None
     
+    def add_change_callback(self, callback: Callable[[], None]) -> None:
+        """Call back whenever a setting may have changed (the new values are in snapshot())."""
+        self._change_callbacks.append(callback)
+
+    def snapshot(self) -> ConfigSnapshot:
+        """The current settings as an immutable object: no copy, safe to keep and read from any thread."""
+        return self._snapshot
+
+    def _make_snapshot(self) -> ConfigSnapshot:
+        shortcuts = dict(self._config["gesture_shortcuts"])
+        previous = getattr(self, "_snapshot", None)
+        # Unchanged shortcuts keep their object, so readers can tell by identity that nothing moved
+        if previous is None or dict(previous.gesture_shortcuts) != shortcuts:
+            mapping = MappingProxyType(shortcuts)
+        else:
+            mapping = previous.gesture_shortcuts
+        return ConfigSnapshot(mapping, self._config["confidence_threshold"], self._config.get("cooldown_time", 2.0),
+                              self._config.get("fusion_method", "off"),
+                              MappingProxyType(dict(self._config.get("fusion_thresholds", {}))),
+                              frozenset(self._config.get("repeat_gestures", [])),
+                              self._config.get("repeat_rate_hz", 10.0))
+
+    def _notify_change(self) -> None:
+        self._snapshot = self._make_snapshot()
+        for callback in self._change_callbacks:
+            callback()
+
     def _deep_copy(self, obj):
         """Create a deep copy of a dict/list structure."""
         if isinstance(obj, dict):
@@ -46,6 +128,7 @@ class ConfigManager:
         """Load configuration from file. Returns default config if file missing/corrupted."""
         if not os.path.exists(self._config_path):
             self._config = self._deep_copy(self.DEFAULT_CONFIG)
+            self._notify_change()
             return self._config
         
         try:
@@ -79,6 +162,49 @@ class ConfigManager:
                 
                 if "auto_reconnect" in loaded:
                     self._config["auto_reconnect"] = bool(loaded["auto_reconnect"])
+
+                if "gatt_layouts" in loaded and isinstance(loaded["gatt_layouts"], dict):
+                    for address, layout in loaded["gatt_layouts"].items():
+                        if isinstance(layout, int) and 0 <= layout <= 0xFFFFFFFF:
+                            self._config["gatt_layouts"][str(address)] = layout
+                
+                if loaded.get("fusion_method") in self.FUSION_METHODS:
+                    self._config["fusion_method"] = loaded["fusion_method"]
+
+                if "fusion_thresholds" in loaded and isinstance(loaded["fusion_thresholds"], dict):
+                    for gesture, threshold in loaded["fusion_thresholds"].items():
+                        if gesture in self.VALID_GESTURES and isinstance(threshold, (int, float)) \
+                                and 0.0 <= threshold <= 1.0:
+                            self._config["fusion_thresholds"][gesture] = float(threshold)
+                
+                if "repeat_gestures" in loaded and isinstance(loaded["repeat_gestures"], list):
+                    self._config["repeat_gestures"] = sorted(
+                        {str(gesture) for gesture in loaded["repeat_gestures"]} & self.VALID_GESTURES)
+
+                if "repeat_rate_hz" in loaded:
+                    rate = loaded["repeat_rate_hz"]
+                    low, high = self.REPEAT_RATE_RANGE
+                    if isinstance(rate, (int, float)) and low <= rate <= high:
+                        self._config["repeat_rate_hz"] = float(rate)
+
+                if isinstance(loaded.get("host_model_path"), str):
+                    self._config["host_model_path"] = loaded["host_model_path"]
+
+                if isinstance(loaded.get("host_model_labels"), list):
+                    self._config["host_model_labels"] = [str(label) for label in loaded["host_model_labels"]]
+
+                if isinstance(loaded.get("publish_multicast"), str):
+                    self._config["publish_multicast"] = loaded["publish_multicast"]
+
+                port = loaded.get("publish_websocket_port")
+                if isinstance(port, int) and not isinstance(port, bool) and 0 <= port < 65536:
+                    self._config["publish_websocket_port"] = port
+
+                if isinstance(loaded.get("gesture_apps"), list):
+                    self._config["gesture_apps"] = [str(app) for app in loaded["gesture_apps"]]
+
+                if loaded.get("background_power_point") in self.BACKGROUND_POWER_POINTS:
+                    self._config["background_power_point"] = loaded["background_power_point"]
                 
                 if "cooldown_time" in loaded:
                     cooldown = loaded["cooldown_time"]
@@ -88,19 +214,56 @@ class ConfigManager:
         except (json.JSONDecodeError, IOError):
             self._config = self._deep_copy(self.DEFAULT_CONFIG)
         
+        self._notify_change()
         return self._config
     
     def save(self, config: Optional[dict] = None) -> None:
-        """Save configuration to file."""
+        """Save configuration to file: written SAVE_DELAY_S after the last save, off the calling thread (see flush)."""
         if config is not None:
             self._config = config
+            self._notify_change()
         
-        with open(self._config_path, 'w', encoding='utf-8') as f:
-            json.dump(self._config, f, indent=2, ensure_ascii=False)
+        text = json.dumps(self._config, indent=2, ensure_ascii=False)
+        with self._save_condition:
+            self._pending = text
+            self._pending_due = time.monotonic() + self._save_delay_s
+            if self._writer is None:
+                self._writer = threading.Thread(target=self._write_loop, name="config-writer", daemon=True)
+                self._writer.start()
+            self._save_condition.notify()
+
+    def flush(self) -> None:
+        """Write a pending save now (call before exiting)."""
+        with self._save_condition:
+            text, self._pending = self._pending, None
+        if text is not None:
+            self._write(text)
+
+    def _write_loop(self) -> None:
+        while True:
+            with self._save_condition:
+                while self._pending is None or time.monotonic() < self._pending_due:
+                    timeout = None if self._pending is None else self._pending_due - time.monotonic()
+                    self._save_condition.wait(timeout)
+                text, self._pending = self._pending, None
+            self._write(text)
+
+    def _write(self, text: str) -> None:
+        """Replace the file atomically: a crash mid-write leaves the previous config intact."""
+        temp_path = self._config_path + ".tmp"
+        with self._write_lock:
+            try:
+                with open(temp_path, 'w', encoding='utf-8') as f:
+                    f.write(text)
+                    f.flush()
+                    os.fsync(f.fileno())
+                os.replace(temp_path, self._config_path)
+            except OSError as e:
+                print(f"[Config] Save failed: {e}")
     
     def get_gesture_shortcuts(self) -> dict:
-        """Get the current gesture-to-shortcut mapping."""
-        return self._deep_copy(self._config["gesture_shortcuts"])
+        """Get the current gesture-to-shortcut mapping (a copy; hot paths read snapshot() instead)."""
+        return dict(self._snapshot.gesture_shortcuts)
     
     def set_gesture_shortcut(self, gesture: str, shortcut: str) -> bool:
         """
@@ -116,6 +279,7 @@ class ConfigManager:
         if gesture not in self.VALID_GESTURES:
             return False
         self._config["gesture_shortcuts"][gesture] = shortcut
+        self._notify_change()
         return True
     
     def set_gesture_shortcuts(self, shortcuts: dict) -> bool:
@@ -138,6 +302,7 @@ class ConfigManager:
         for gesture in self.VALID_GESTURES:
             if gesture in shortcuts:
                 self._config["gesture_shortcuts"][gesture] = str(shortcuts[gesture])
+        self._notify_change()
         return True
     
     # Legacy compatibility methods
@@ -160,13 +325,74 @@ class ConfigManager:
     
     def get_confidence_threshold(self) -> float:
         """Get the current confidence threshold."""
-        return self._config["confidence_threshold"]
+        return self._snapshot.confidence_threshold
     
     def set_confidence_threshold(self, threshold: float) -> bool:
         """Set confidence threshold. Returns True if valid, False otherwise."""
         if not isinstance(threshold, (int, float)) or threshold < 0.0 or threshold > 1.0:
             return False
         self._config["confidence_threshold"] = float(threshold)
+        self._notify_change()
+        return True
+    
+    def get_fusion_method(self) -> str:
+        """Get the host-side score decoder ("off": act on the device's results)."""
+        return self._snapshot.fusion_method
+
+    def set_fusion_method(self, method: str) -> bool:
+        """Set the score decoder. Returns True if valid, False otherwise."""
+        if method not in self.FUSION_METHODS:
+            return False
+        self._config["fusion_method"] = method
+        self._notify_change()
+        return True
+
+    def get_fusion_thresholds(self) -> dict:
+        """Get the per-gesture decoder thresholds set so far (others use the confidence threshold)."""
+        return dict(self._snapshot.fusion_thresholds)
+
+    def set_fusion_threshold(self, gesture: str, threshold: Optional[float]) -> bool:
+        """Set one gesture's decoder threshold (None: back to the confidence threshold)."""
+        if gesture not in self.VALID_GESTURES:
+            return False
+        thresholds = self._config.setdefault("fusion_thresholds", {})
+        if threshold is None:
+            thresholds.pop(gesture, None)
+        elif not isinstance(threshold, (int, float)) or threshold < 0.0 or threshold > 1.0:
+            return False
+        else:
+            thresholds[gesture] = float(threshold)
+        self._notify_change()
+        return True
+    
+    def get_repeat_gestures(self) -> set:
+        """Get the gestures that repeat their shortcut while held."""
+        return set(self._snapshot.repeat_gestures)
+
+    def set_repeat_gesture(self, gesture: str, enabled: bool) -> bool:
+        """Turn hold-to-repeat on or off for one gesture. Returns False for an invalid gesture."""
+        if gesture not in self.VALID_GESTURES:
+            return False
+        gestures = set(self._config.get("repeat_gestures", []))
+        if enabled:
+            gestures.add(gesture)
+        else:
+            gestures.discard(gesture)
+        self._config["repeat_gestures"] = sorted(gestures)
+        self._notify_change()
+        return True
+
+    def get_repeat_rate(self) -> float:
+        """Get the repeats per second of a held gesture."""
+        return self._snapshot.repeat_rate_hz
+
+    def set_repeat_rate(self, rate_hz: float) -> bool:
+        """Set the repeat rate. Returns True if valid, False otherwise."""
+        low, high = self.REPEAT_RATE_RANGE
+        if not isinstance(rate_hz, (int, float)) or rate_hz < low or rate_hz > high:
+            return False
+        self._config["repeat_rate_hz"] = float(rate_hz)
+        self._notify_change()
         return True
     
     def get_last_device_address(self) -> Optional[str]:
@@ -176,7 +402,31 @@ class ConfigManager:
     def set_last_device_address(self, address: Optional[str]) -> None:
         """Set the last connected device address."""
         self._config["last_device_address"] = address
+        self._notify_change()
     
+    def get_host_model(self) -> Tuple[str, List[str]]:
+        """Get the host model's .tflite path ("" = off) and class names (empty: the deployed model's)."""
+        return self._config.get("host_model_path", ""), list(self._config.get("host_model_labels", []))
+
+    def get_event_publisher(self) -> Tuple[str, int]:
+        """Get the UDP "group:port" ("" = off) and the WebSocket port (0 = off) decided gestures are published on."""
+        return self._config.get("publish_multicast", ""), int(self._config.get("publish_websocket_port", 0))
+
+    def get_foreground_gating(self) -> Tuple[List[str], str]:
+        """Get the gesture-controlled process names (empty = off) and the power point asked for behind other apps."""
+        return (list(self._config.get("gesture_apps", [])),
+                self._config.get("background_power_point", self.DEFAULT_CONFIG["background_power_point"]))
+
+    def get_gatt_layout(self, address: str) -> Optional[int]:
+        """Get the GATT layout hash last seen on a device (None: discover its services)."""
+        return self._config.get("gatt_layouts", {}).get(address)
+
+    def set_gatt_layout(self, address: str, layout: int) -> None:
+        """Remember the GATT layout hash of a device and save it at once."""
+        self._config.setdefault("gatt_layouts", {})[address] = int(layout)
+        self._notify_change()
+        self.save()
+
     def get_auto_reconnect(self) -> bool:
         """Get auto-reconnect setting."""
         return self._config.get("auto_reconnect", True)
@@ -184,16 +434,18 @@ class ConfigManager:
     def set_auto_reconnect(self, enabled: bool) -> None:
         """Set auto-reconnect setting."""
         self._config["auto_reconnect"] = bool(enabled)
+        self._notify_change()
     
     def get_cooldown_time(self) -> float:
         """Get cooldown time between actions in seconds."""
-        return self._config.get("cooldown_time", 2.0)
+        return self._snapshot.cooldown_time
     
     def set_cooldown_time(self, seconds: float) -> bool:
         """Set cooldown time. Returns True if valid, False otherwise."""
         if not isinstance(seconds, (int, float)) or seconds < 0.5 or seconds > 10.0:
             return False
         self._config["cooldown_time"] = float(seconds)
+        self._notify_change()
         return True
     
     def get_config(self) -> dict:
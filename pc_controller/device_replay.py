@@ -0,0 +1,252 @@
+"""
+On-device Replay Runner
+
+Streams labelled recordings into the board over USB CDC (serial command "replay",
+see include/replay_module.h) and runs them through the real firmware pipeline on
+the MCU: the sampler / inference threads, anti-alias decimation, calibration,
+resampling, the model and the post-processing all run exactly as with the live
+IMU, only the FIFO read-out is replaced. The board reports one line per
+classified window plus a summary and the per-stage timings, in the same format
+as the host build (replay_runner.py), so the same accuracy and latency report
+applies.
+
+Recordings are sent as raw_recorder.py packets (board-frame LSB at the sensor
+ODR; CSVs at another rate are linearly resampled first). The board stops reading
+while its replay queue is full, so USB flow control paces the stream to real time.
+
+--min-accuracy / --max-latency-us turn the report into a regression gate: the
+exit code is 1 when a limit is missed.
+
+Usage:
+    python device_replay.py --port /dev/ttyACM0 data/*.csv
+    python device_replay.py --port COM5 --min-accuracy 0.9 --max-latency-us 40000 data/*.csv
+"""
+
+import argparse
+import sys
+import threading
+import time
+from dataclasses import dataclass
+from typing import Dict, Iterator, List, Optional, Sequence, Tuple
+
+from idle_prefilter_tuner import label_from_path
+from raw_recorder import (ACC_LSB_PER_G, CHANNEL_NAMES, GYR_LSB_PER_DPS, HEADER_BYTES, PACKET_MAX_BYTES,
+                          PAYLOAD_HEADER_BYTES, channel_count, encode_packet)
+from replay_runner import ReplayResult, accuracy, confusion_matrix, format_matrix, parse_output, stage_timing
+
+# Must match IMU_SENSOR_ODR_HZ (include/app_config.h)
+DEVICE_ODR_HZ = 400.0
+# Recordings within this relative rate error are sent as they are
+RATE_TOLERANCE = 0.02
+FRAMES_PER_PACKET = 10
+READY_LINE = "[Replay] Ready"
+STAGE_COUNT = 6  # pipeline_stage_t
+
+
+@dataclass
+class StageStats:
+    runs: int
+    mean_us: int
+    max_us: int
+    busy_permille: int
+
+
+def load_recording(path: str) -> Tuple[int, List[float], List[List[int]]]:
+    """Read an Edge Impulse CSV (ms timestamps, g / dps columns) as channel mask, timestamps and LSB frames."""
+    with open(path, "r", encoding="utf-8") as f:
+        header = f.readline().strip().split(",")
+        columns = [(i, CHANNEL_NAMES.index(name)) for i, name in enumerate(header) if name in CHANNEL_NAMES]
+        if header[0] != "timestamp" or not columns:
+            raise ValueError(f"{path}: expected a timestamp column and IMU columns {CHANNEL_NAMES}")
+        columns.sort(key=lambda column: column[1])
+        scales = [ACC_LSB_PER_G if channel < 3 else GYR_LSB_PER_DPS for _, channel in columns]
+        timestamps: List[float] = []
+        frames: List[List[int]] = []
+        for line in f:
+            fields = line.strip().split(",")
+            if len(fields) < len(header):
+                continue
+            timestamps.append(float(fields[0]))
+            frames.append([max(-32768, min(32767, round(float(fields[i]) * s)))
+                           for (i, _), s in zip(columns, scales)])
+    mask = sum(1 << channel for _, channel in columns)
+    return mask, timestamps, frames
+
+
+def resample_linear(timestamps_ms: Sequence[float], frames: Sequence[Sequence[int]],
+                    rate_hz: float = DEVICE_ODR_HZ) -> List[List[int]]:
+    """Linear interpolation onto a uniform grid at rate_hz starting at the first timestamp."""
+    if len(frames) < 2:
+        return [list(frame) for frame in frames]
+    period_ms = 1000.0 / rate_hz
+    out: List[List[int]] = []
+    j = 0
+    t = timestamps_ms[0]
+    while t <= timestamps_ms[-1]:
+        while j + 2 < len(timestamps_ms) and timestamps_ms[j + 1] < t:
+            j += 1
+        t0, t1 = timestamps_ms[j], timestamps_ms[j + 1]
+        a = (t - t0) / (t1 - t0) if t1 > t0 else 0.0
+        a = min(max(a, 0.0), 1.0)
+        out.append([round(v0 + (v1 - v0) * a) for v0, v1 in zip(frames[j], frames[j + 1])])
+        t = timestamps_ms[0] + len(out) * period_ms
+    return out
+
+
+def to_device_rate(timestamps_ms: Sequence[float], frames: Sequence[Sequence[int]]) -> List[List[int]]:
+    if len(frames) < 2 or timestamps_ms[-1] <= timestamps_ms[0]:
+        return [list(frame) for frame in frames]
+    rate_hz = (len(frames) - 1) * 1000.0 / (timestamps_ms[-1] - timestamps_ms[0])
+    if abs(rate_hz - DEVICE_ODR_HZ) <= RATE_TOLERANCE * DEVICE_ODR_HZ:
+        return [list(frame) for frame in frames]
+    return resample_linear(timestamps_ms, frames)
+
+
+def replay_packets(channel_mask: int, frames: Sequence[Sequence[int]],
+                   frames_per_packet: int = FRAMES_PER_PACKET) -> Iterator[bytes]:
+    """Packets for one replay session, terminated by an empty packet."""
+    period_us = 1e6 / DEVICE_ODR_HZ
+    # worst case per frame like RecordPacketEncoder::add: 5-byte timestamp delta, 3 bytes per sample delta
+    payload_bytes = PACKET_MAX_BYTES - HEADER_BYTES - PAYLOAD_HEADER_BYTES - 1
+    worst_case = payload_bytes // (5 + 3 * channel_count(channel_mask))
+    frames_per_packet = max(1, min(frames_per_packet, worst_case))
+    seq = 0
+    for start in range(0, len(frames), frames_per_packet):
+        chunk = [list(frame) for frame in frames[start:start + frames_per_packet]]
+        timestamps = [round((start + i) * period_us) for i in range(len(chunk))]
+        yield encode_packet(seq, channel_mask, timestamps, chunk)
+        seq += 1
+    yield encode_packet(seq, channel_mask, [round(len(frames) * period_us)], [])
+
+
+def parse_stages(text: str) -> Dict[str, StageStats]:
+    """The board's "stage,<name>,<runs>,<mean_us>,<max_us>,<busy_permille>" lines."""
+    stages: Dict[str, StageStats] = {}
+    for line in text.splitlines():
+        fields = line.strip().split(",")
+        if fields[0] == "stage" and len(fields) == 6:
+            try:
+                stages[fields[1]] = StageStats(*(int(v) for v in fields[2:]))
+            except ValueError:
+                continue
+    return stages
+
+
+def parse_memory(text: str) -> Optional[Tuple[int, int]]:
+    """The board's "memory,<ram_high_water>,<static_bytes>" line; None from firmware without it."""
+    for line in text.splitlines():
+        fields = line.strip().split(",")
+        if fields[0] == "memory" and len(fields) == 3:
+            try:
+                return int(fields[1]), int(fields[2])
+            except ValueError:
+                continue
+    return None
+
+
+def replay_on_device(ser, path: str, timeout_s: float = 10.0) -> Tuple[ReplayResult, Dict[str, StageStats]]:
+    """Run one recording on the board through an open pyserial port."""
+    text = replay_text_on_device(ser, path, timeout_s)
+    return parse_output(path, text), parse_stages(text)
+
+
+def replay_text_on_device(ser, path: str, timeout_s: float = 10.0) -> str:
+    """Run one recording on the board and return everything it printed up to the last stage line."""
+    channel_mask, timestamps, frames = load_recording(path)
+    frames = to_device_rate(timestamps, frames)
+
+    lines: List[str] = []
+    ready = threading.Event()
+    done = threading.Event()
+
+    def reader() -> None:
+        buffer = b""
+        deadline = time.monotonic() + timeout_s
+        stages = 0
+        while time.monotonic() < deadline and not done.is_set():
+            chunk = ser.read(4096)
+            if not chunk:
+                continue
+            buffer += chunk
+            *complete, buffer = buffer.split(b"\n")
+            for raw in complete:
+                line = raw.decode("utf-8", errors="replace").strip()
+                lines.append(line)
+                if line == READY_LINE:
+                    ready.set()
+                elif line.startswith("stage,"):
+                    stages += 1
+                    if stages == STAGE_COUNT:
+                        done.set()
+                # the board sends lines for as long as the stream runs
+                deadline = time.monotonic() + timeout_s
+
+    thread = threading.Thread(target=reader, daemon=True)
+    thread.start()
+    ser.write(b"replay\n")
+    if not ready.wait(timeout_s):
+        done.set()
+        thread.join()
+        raise RuntimeError(f"{path}: the board did not enter replay mode")
+    for packet in replay_packets(channel_mask, frames):
+        ser.write(packet)  # blocks while the board's replay queue is full
+    thread.join()
+    if not done.is_set():
+        raise RuntimeError(f"{path}: no replay summary from the board")
+    return "\n".join(lines)
+
+
+def check_limits(results: Sequence[ReplayResult], min_accuracy: Optional[float],
+                 max_latency_us: Optional[float]) -> List[str]:
+    """Regression gate: a message per missed limit (empty when all pass)."""
+    failures = []
+    value = accuracy(confusion_matrix(results))
+    if min_accuracy is not None and value < min_accuracy:
+        failures.append(f"accuracy {value * 100:.1f}% below {min_accuracy * 100:.1f}%")
+    latency = stage_timing(results)["latency_us_max"]
+    if max_latency_us is not None and latency > max_latency_us:
+        failures.append(f"max latency {latency:.0f} us above {max_latency_us:.0f} us")
+    return failures
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    parser = argparse.ArgumentParser(description="Replay labelled recordings through the firmware on the board")
+    parser.add_argument("files", nargs="+", help="labelled Edge Impulse CSV recordings")
+    parser.add_argument("--port", required=True, help="serial port of the board")
+    parser.add_argument("--timeout", type=float, default=10.0, help="seconds without output before giving up")
+    parser.add_argument("--min-accuracy", type=float, help="fail below this window accuracy (0..1)")
+    parser.add_argument("--max-latency-us", type=float, help="fail above this sample-to-result latency")
+    args = parser.parse_args(argv)
+
+    import serial  # pyserial
+
+    results: List[ReplayResult] = []
+    stages: Dict[str, StageStats] = {}
+    with serial.Serial(args.port, 115200, timeout=0.1) as ser:
+        for path in args.files:
+            result, stages = replay_on_device(ser, path, args.timeout)
+            results.append(result)
+            print(f"[Replay] {path} ({label_from_path(path)}): {len(result.windows)} windows, "
+                  f"{result.wall_us / 1e6:.1f} s on the board")
+
+    matrix = confusion_matrix(results)
+    timing = stage_timing(results)
+    print(f"[Replay] {len(results)} recordings, {sum(len(r.windows) for r in results)} windows, "
+          f"accuracy {accuracy(matrix) * 100:.1f}%")
+    for line in format_matrix(matrix):
+        print("  " + line)
+    print(f"[Replay] DSP {timing['dsp_us_per_frame']:.2f} us/frame, CNN {timing['classify_us_mean']:.1f} us/window "
+          f"({timing['prefilter_skipped']} skipped by the idle pre-filter), "
+          f"latency mean {timing['latency_us_mean']:.0f} us / max {timing['latency_us_max']:.0f} us")
+    for name, s in stages.items():
+        print(f"[Replay] stage {name:<11} runs {s.runs}, mean {s.mean_us} us, max {s.max_us} us, "
+              f"busy {s.busy_permille / 10:.1f}%")
+
+    failures = check_limits(results, args.min_accuracy, args.max_latency_us)
+    for failure in failures:
+        print(f"[Replay] FAIL: {failure}")
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
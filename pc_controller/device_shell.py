@@ -0,0 +1,392 @@
+"""
+Device Shell
+
+Binary diagnostics and control over the USB CDC port (include/shell_module.h):
+each request is one frame of type 0x32 carrying a sequence number, a command and
+its arguments, and the firmware answers in a frame of the same type with the
+sequence, the command, a status and fixed-layout data. Nothing is formatted with
+printf on the device, the request is served by its low-priority record thread,
+and the link does not have to be opened first, so the shell works next to a BLE
+connection and stays enabled in production firmware.
+
+Commands: info, stats (system / threads / latency / confidence), registry (every counter and
+distribution the firmware registered, read one entry per request), bench (start, then poll the
+result), config (read, switch preset or write values), trace (start, read the
+zone records for a while, stop) and replay (hand the port to the replay module,
+see device_replay.py).
+
+Usage:
+    python device_shell.py --port /dev/ttyACM0 info
+    python device_shell.py --port /dev/ttyACM0 stats threads
+    python device_shell.py --port /dev/ttyACM0 stats confidence
+    python device_shell.py --port /dev/ttyACM0 registry
+    python device_shell.py --port /dev/ttyACM0 bench --live 50
+    python device_shell.py --port /dev/ttyACM0 config low-power
+    python device_shell.py --port /dev/ttyACM0 config --ble 0.8 --poll 20
+    python device_shell.py --port /dev/ttyACM0 trace --seconds 5
+"""
+
+import argparse
+import struct
+import sys
+import time
+from dataclasses import dataclass, replace
+from typing import Dict, List, Optional, Tuple
+
+from ble_manager import (CONFIG_PROFILES, CRASH_THREADS, LATENCY_STAGES, POWER_POINTS, InferenceBenchReport, RuntimeConfig,
+                         TracePacket, encode_config, encode_inference_benchmark, encode_profile, parse_config,
+                         parse_inference_benchmark, parse_trace)
+from gesture_labels import MODEL_LABELS
+from serial_manager import FRAME_SHELL, FrameDecoder, encode_frame
+from trace_capture import ZONES
+from wire_schema import Stat, parse_stat
+
+# shell_command_t
+CMD_INFO = 0
+CMD_STATS = 1
+CMD_BENCH_START = 2
+CMD_BENCH_RESULT = 3
+CMD_CONFIG_GET = 4
+CMD_CONFIG_SET = 5
+CMD_TRACE_START = 6
+CMD_TRACE_STOP = 7
+CMD_TRACE_READ = 8
+CMD_REPLAY = 9
+CMD_STAT_READ = 10
+
+# shell_status_t
+STATUSES = ("ok", "unknown command", "bad argument", "busy", "unsupported", "not started")
+# shell_stats_group_t
+STATS_GROUPS = ("system", "threads", "latency", "confidence")
+
+PROTOCOL_VERSION = 1
+REPLY_HEADER = struct.Struct('<BBB')
+INFO = struct.Struct('<BBBBI')
+SYSTEM_STATS = struct.Struct('<10IBBBx')
+THREAD_STATS = struct.Struct('<III')
+LATENCY_STATS = struct.Struct('<6I')
+LABEL_HISTOGRAM_HEADER = struct.Struct('<BBxx')
+
+
+@dataclass
+class ShellReply:
+    sequence: int
+    command: int
+    status: str
+    data: bytes
+
+    @property
+    def ok(self) -> bool:
+        return self.status == "ok"
+
+
+@dataclass
+class SystemStats:
+    uptime_ms: int
+    frames_pushed: int
+    sampler_overruns: int
+    sampler_high_water: int
+    stalls: int
+    longest_gap_ms: int
+    imu_recoveries: int
+    imu_longest_outage_ms: int
+    ram_high_water: int
+    static_bytes: int
+    watchdog_reset: bool
+    power_point: str
+    active_model: int
+
+
+@dataclass
+class ThreadStats:
+    stack_bytes: int
+    peak_bytes: int
+    restarts: int
+
+
+@dataclass
+class LabelHistogram:
+    """Windows a label won since boot, binned by the winning probability and by its margin over the runner-up."""
+    top: List[int]
+    margin: List[int]
+
+
+@dataclass
+class LatencyStats:
+    count: int
+    p50_us: int
+    p95_us: int
+    p99_us: int
+    max_us: int
+    over_slo: int
+
+
+def encode_request(sequence: int, command: int, args: bytes = b"") -> bytes:
+    return bytes([sequence & 0xFF, command]) + args
+
+
+def parse_reply(payload: bytes) -> Optional[ShellReply]:
+    if len(payload) < REPLY_HEADER.size:
+        return None
+    sequence, command, status = REPLY_HEADER.unpack_from(payload)
+    name = STATUSES[status] if status < len(STATUSES) else f"status {status}"
+    return ShellReply(sequence, command, name, payload[REPLY_HEADER.size:])
+
+
+def parse_system_stats(data: bytes) -> Optional[SystemStats]:
+    if len(data) < SYSTEM_STATS.size:
+        return None
+    *words, watchdog_reset, power_point, model = SYSTEM_STATS.unpack_from(data)
+    point = POWER_POINTS[power_point] if power_point < len(POWER_POINTS) else str(power_point)
+    return SystemStats(*words, bool(watchdog_reset), point, model)
+
+
+def parse_thread_stats(data: bytes) -> Dict[str, ThreadStats]:
+    """Per thread in thread_role_t order."""
+    count = len(data) // THREAD_STATS.size
+    return {CRASH_THREADS[i] if i < len(CRASH_THREADS) else f"thread{i}":
+            ThreadStats(*THREAD_STATS.unpack_from(data, i * THREAD_STATS.size)) for i in range(count)}
+
+
+def parse_latency_stats(data: bytes) -> Dict[str, LatencyStats]:
+    count = len(data) // LATENCY_STATS.size
+    return {LATENCY_STAGES[i] if i < len(LATENCY_STAGES) else f"stage{i}":
+            LatencyStats(*LATENCY_STATS.unpack_from(data, i * LATENCY_STATS.size)) for i in range(count)}
+
+
+def parse_label_histogram(data: bytes) -> Optional[Tuple[int, LabelHistogram]]:
+    """(label count, histogram of the requested label)."""
+    if len(data) < LABEL_HISTOGRAM_HEADER.size:
+        return None
+    labels, bins = LABEL_HISTOGRAM_HEADER.unpack_from(data)
+    if len(data) < LABEL_HISTOGRAM_HEADER.size + 8 * bins:
+        return None
+    counts = struct.unpack_from(f'<{2 * bins}I', data, LABEL_HISTOGRAM_HEADER.size)
+    return labels, LabelHistogram(list(counts[:bins]), list(counts[bins:]))
+
+
+def parse_bench_result(data: bytes) -> Optional[Tuple[int, InferenceBenchReport]]:
+    """(version, report); the version is 0 until a benchmark has finished."""
+    if len(data) < 4:
+        return None
+    report = parse_inference_benchmark(data[4:])
+    return None if report is None else (struct.unpack_from('<I', data)[0], report)
+
+
+def parse_config_reply(data: bytes) -> Optional[Tuple[int, RuntimeConfig]]:
+    if len(data) < 4:
+        return None
+    config = parse_config(data[4:])
+    return None if config is None else (struct.unpack_from('<I', data)[0], config)
+
+
+class DeviceShell:
+    """Request / reply over an open serial port (anything with write, read and in_waiting)."""
+
+    def __init__(self, port, timeout_s: float = 1.0):
+        self._port = port
+        self._timeout_s = timeout_s
+        self._decoder = FrameDecoder()
+        self._sequence = 0
+        self.log: List[str] = []  # text the firmware printed meanwhile
+
+    def request(self, command: int, args: bytes = b"") -> ShellReply:
+        self._sequence = (self._sequence + 1) & 0xFF
+        self._port.write(encode_frame(FRAME_SHELL, encode_request(self._sequence, command, args)))
+        deadline = time.monotonic() + self._timeout_s
+        while time.monotonic() < deadline:
+            for frame_type, payload in self._decoder.feed(self._port.read(max(1, self._port.in_waiting))):
+                if frame_type is None:
+                    text = payload.decode("utf-8", errors="replace").strip()
+                    if text:
+                        self.log.append(text)
+                    continue
+                reply = parse_reply(payload) if frame_type == FRAME_SHELL else None
+                if reply is not None and reply.sequence == self._sequence and reply.command == command:
+                    return reply
+        raise TimeoutError(f"no reply to shell command {command} (firmware without SHELL_ENABLE?)")
+
+    def checked(self, command: int, args: bytes = b"") -> bytes:
+        reply = self.request(command, args)
+        if not reply.ok:
+            raise RuntimeError(f"shell command {command}: {reply.status}")
+        return reply.data
+
+    def info(self) -> Tuple[int, int, int, int, int]:
+        """(protocol version, threads, latency stages, zones, uptime ms)."""
+        return INFO.unpack_from(self.checked(CMD_INFO))
+
+    def stats(self, group: str):
+        if group == "confidence":
+            return self.label_histograms()
+        data = self.checked(CMD_STATS, bytes([STATS_GROUPS.index(group)]))
+        if group == "system":
+            return parse_system_stats(data)
+        return parse_thread_stats(data) if group == "threads" else parse_latency_stats(data)
+
+    def registry(self) -> List[Stat]:
+        """Every statistic the firmware registered (counters, maxima and distributions, include/stats_module.h)."""
+        stats: List[Stat] = []
+        while True:
+            reply = self.request(CMD_STAT_READ, bytes([len(stats)]))
+            if not reply.ok:
+                break
+            stat = parse_stat(reply.data)
+            if stat is None:
+                break
+            stats.append(stat)
+            if len(stats) >= stat.count:
+                break
+        return stats
+
+    def label_histograms(self) -> Dict[str, LabelHistogram]:
+        """Per-label confidence histograms since boot (firmware with TELEMETRY_ENABLE)."""
+        group = STATS_GROUPS.index("confidence")
+        histograms: Dict[str, LabelHistogram] = {}
+        label = 0
+        while True:
+            result = parse_label_histogram(self.checked(CMD_STATS, bytes([group, label])))
+            if result is None:
+                break
+            labels, histogram = result
+            histograms[MODEL_LABELS[label] if label < len(MODEL_LABELS) else f"label{label}"] = histogram
+            label += 1
+            if label >= labels:
+                break
+        return histograms
+
+    def bench(self, mode: str = "synthetic", runs: int = 100, timeout_s: float = 60.0,
+              poll_s: float = 0.2) -> Optional[InferenceBenchReport]:
+        before = parse_bench_result(self.checked(CMD_BENCH_RESULT))
+        self.checked(CMD_BENCH_START, encode_inference_benchmark(mode, runs))
+        deadline = time.monotonic() + timeout_s
+        while time.monotonic() < deadline:
+            time.sleep(poll_s)
+            result = parse_bench_result(self.checked(CMD_BENCH_RESULT))
+            if result is not None and (before is None or result[0] != before[0]):
+                return result[1]
+        return None
+
+    def config(self) -> Optional[RuntimeConfig]:
+        result = parse_config_reply(self.checked(CMD_CONFIG_GET))
+        return None if result is None else result[1]
+
+    def set_config(self, payload: bytes) -> Optional[RuntimeConfig]:
+        result = parse_config_reply(self.checked(CMD_CONFIG_SET, payload))
+        return None if result is None else result[1]
+
+    def trace(self, seconds: float, poll_s: float = 0.05) -> List[TracePacket]:
+        self.checked(CMD_TRACE_START)
+        packets = []
+        try:
+            deadline = time.monotonic() + seconds
+            while time.monotonic() < deadline:
+                packet = parse_trace(self.checked(CMD_TRACE_READ))
+                if packet is not None and packet.zones:
+                    packets.append(packet)
+                else:
+                    time.sleep(poll_s)
+        finally:
+            self.checked(CMD_TRACE_STOP)
+        return packets
+
+
+def zone_summary(packets: List[TracePacket]) -> Dict[str, Tuple[int, float, float]]:
+    """Per zone: (count, mean µs, max µs)."""
+    cycles: Dict[str, List[int]] = {}
+    for packet in packets:
+        for zone, _, duration in packet.zones:
+            name = ZONES[zone][0] if zone < len(ZONES) else f"zone{zone}"
+            cycles.setdefault(name, []).append(duration * 1e6 / packet.clock_hz)
+    return {name: (len(us), sum(us) / len(us), max(us)) for name, us in cycles.items()}
+
+
+def run(shell: DeviceShell, args) -> int:
+    if args.command == "info":
+        version, threads, stages, zones, uptime_ms = shell.info()
+        print(f"[Shell] protocol {version}, {threads} threads, {stages} latency stages, "
+              f"{zones or 'no'} zones, up {uptime_ms / 1000:.1f} s")
+    elif args.command == "stats":
+        result = shell.stats(args.group)
+        if args.group == "system":
+            for name, value in vars(result).items():
+                print(f"  {name:22s} {value}")
+        else:
+            for name, value in result.items():
+                print(f"  {name:10s} " + "  ".join(f"{k} {v}" for k, v in vars(value).items()))
+    elif args.command == "registry":
+        stats = shell.registry()
+        if not stats:
+            print("[Shell] No statistics registered (firmware without STAT_READ?)")
+            return 1
+        for stat in stats:
+            print(f"  {stat.describe()}")
+    elif args.command == "bench":
+        report = shell.bench("live" if args.live else "synthetic", args.runs)
+        if report is None:
+            print("[Shell] Benchmark did not finish")
+            return 1
+        print(f"[Shell] {report.mode} benchmark {report.state}, {report.runs} runs")
+        for name, stats in report.stages.items():
+            print(f"  {name:12s} p50 {stats.p50_us:7d} us  p95 {stats.p95_us:7d} us  max {stats.max_us:7d} us")
+    elif args.command == "config":
+        config = shell.config()
+        if args.preset:
+            config = shell.set_config(encode_profile(args.preset))
+        elif any(v is not None for v in (args.ble, args.led, args.fine, args.coarse, args.poll)):
+            changes = {"ble_min_confidence": args.ble, "led_confidence_threshold": args.led,
+                       "stride_fine_samples": args.fine, "stride_coarse_samples": args.coarse,
+                       "ble_poll_interval_ms": args.poll}
+            config = shell.set_config(encode_config(replace(config, **{k: v for k, v in changes.items()
+                                                                       if v is not None})))
+        print(f"[Shell] {config}")
+    elif args.command == "trace":
+        packets = shell.trace(args.seconds)
+        lost = sum(packet.lost for packet in packets)
+        print(f"[Shell] {sum(len(p.zones) for p in packets)} zones in {args.seconds:g} s"
+              + (f", {lost} reads after overwritten zones" if lost else ""))
+        for name, (count, mean_us, max_us) in sorted(zone_summary(packets).items()):
+            print(f"  {name:12s} {count:6d}  mean {mean_us:8.1f} us  max {max_us:8.1f} us")
+    elif args.command == "replay":
+        shell.checked(CMD_REPLAY)
+        print("[Shell] Replay started: stream the recordings now (device_replay.py)")
+    return 0
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    parser = argparse.ArgumentParser(description="Binary diagnostics shell over the board's USB serial port")
+    parser.add_argument("--port", required=True, help="serial port of the board")
+    parser.add_argument("--timeout", type=float, default=1.0, help="seconds to wait for each reply")
+    commands = parser.add_subparsers(dest="command", required=True)
+    commands.add_parser("info", help="protocol version and uptime")
+    stats = commands.add_parser("stats", help="system, thread, latency or per-label confidence statistics")
+    stats.add_argument("group", nargs="?", choices=STATS_GROUPS, default="system")
+    commands.add_parser("registry", help="every registered counter and distribution (the serial 'stats' command)")
+    bench = commands.add_parser("bench", help="run the on-device inference benchmark")
+    bench.add_argument("runs", nargs="?", type=int, default=100)
+    bench.add_argument("--live", action="store_true", help="time live inferences instead of a synthetic window")
+    config = commands.add_parser("config", help="read or change the runtime configuration")
+    config.add_argument("preset", nargs="?", choices=[p for p in CONFIG_PROFILES if p != "custom"])
+    config.add_argument("--ble", type=float, help="BLE minimum confidence")
+    config.add_argument("--led", type=float, help="LED confidence threshold")
+    config.add_argument("--fine", type=int, help="fine stride (samples)")
+    config.add_argument("--coarse", type=int, help="coarse stride (samples)")
+    config.add_argument("--poll", type=int, help="BLE poll interval (ms)")
+    trace = commands.add_parser("trace", help="collect zone records for a while and summarise them")
+    trace.add_argument("--seconds", type=float, default=5.0)
+    commands.add_parser("replay", help="hand the port to the replay module")
+    args = parser.parse_args(argv)
+
+    import serial  # pyserial
+
+    with serial.Serial(args.port, 115200, timeout=0.05) as port:
+        shell = DeviceShell(port, args.timeout)
+        try:
+            return run(shell, args)
+        except (TimeoutError, RuntimeError) as e:
+            print(f"[Shell] {e}")
+            return 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
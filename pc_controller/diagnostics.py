@@ -0,0 +1,91 @@
+"""
+Diagnostics Module
+
+Collects the live rates, loss and latency figures shown by the GUI's diagnostics panel.
+Callbacks from the BLE / USB threads only store values; snapshot() is taken on the Tk
+thread at the panel's refresh rate.
+"""
+
+import threading
+import time
+from collections import deque
+from dataclasses import dataclass
+from typing import Dict, Optional
+
+from ble_manager import CpuUtilization, DeliveryCounters, DeliveryTracker, LatencyBreakdown
+from gesture_handler import ActionStats
+
+
+@dataclass
+class DiagnosticsSnapshot:
+    """One refresh of the diagnostics panel (None = not measured yet)."""
+    gesture_rate: float                 # gestures/s over the last RATE_WINDOW_S
+    notify_rate: float                  # result events/s received over the same window
+    received: int                       # DeliveryTracker counters of the current connection
+    missed: int
+    recovered: int
+    lost: int
+    host_ms: Optional[float]            # host callback to action queued, p50
+    inject_p50_ms: Optional[float]      # action queued to keys injected
+    inject_p95_ms: Optional[float]
+    end_to_end_ms: Dict[float, Optional[float]]  # classification (device clock) to action queued
+    counters: Optional[DeliveryCounters]
+    cpu: Optional[CpuUtilization]
+
+    @property
+    def loss(self) -> Optional[float]:
+        """Fraction of the events never acted on (lost after the history read-back)."""
+        total = self.received + self.lost
+        return self.lost / total if total else None
+
+
+class DiagnosticsMonitor:
+    """Rate windows and the newest device reports, filled from the transport callbacks."""
+
+    RATE_WINDOW_S = 5.0
+
+    def __init__(self):
+        self._lock = threading.Lock()
+        self._gestures: deque = deque()
+        self._received: deque = deque()  # (time, cumulative received) at each snapshot
+        self._counters: Optional[DeliveryCounters] = None
+        self._cpu: Optional[CpuUtilization] = None
+
+    def on_gesture(self, now: Optional[float] = None) -> None:
+        with self._lock:
+            self._gestures.append(time.monotonic() if now is None else now)
+
+    def set_counters(self, counters: DeliveryCounters) -> None:
+        self._counters = counters
+
+    def set_cpu(self, cpu: CpuUtilization) -> None:
+        self._cpu = cpu
+
+    def reset(self) -> None:
+        """Start the rate windows over (new connection: the delivery counters restart)."""
+        with self._lock:
+            self._gestures.clear()
+            self._received.clear()
+        self._counters = None
+        self._cpu = None
+
+    def snapshot(self, delivery: DeliveryTracker, breakdown: LatencyBreakdown,
+                 end_to_end_ms: Dict[float, Optional[float]], actions: ActionStats,
+                 now: Optional[float] = None) -> DiagnosticsSnapshot:
+        now = time.monotonic() if now is None else now
+        since = now - self.RATE_WINDOW_S
+        with self._lock:
+            while self._gestures and self._gestures[0] < since:
+                self._gestures.popleft()
+            gestures = len(self._gestures)
+            if self._received and delivery.received < self._received[-1][1]:
+                self._received.clear()
+            self._received.append((now, delivery.received))
+            while len(self._received) > 1 and self._received[0][0] < since:
+                self._received.popleft()
+            first_time, first_received = self._received[0]
+        span = now - first_time
+        notify_rate = (delivery.received - first_received) / span if span > 0 else 0.0
+        return DiagnosticsSnapshot(gestures / self.RATE_WINDOW_S, notify_rate, delivery.received, delivery.missed,
+                                   delivery.recovered, delivery.lost, breakdown.host_ms, actions.p50_ms,
+                                   actions.p95_ms, end_to_end_ms, self._counters, self._cpu)
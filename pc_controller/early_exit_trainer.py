@@ -0,0 +1,248 @@
+"""
+Early-Exit Head Trainer
+
+Trains the firmware's early-exit classifier (MODEL_EARLY_EXIT, see
+src/model_module.cpp) on recordings made with raw_recorder.py. The recordings
+are replayed through the host build of the inference pipeline (replay_runner.py,
+streaming inference with the head forced never to exit), which dumps the first
+pooling output of every classified window (36 columns x 8 channels, int8)
+together with the full model's prediction. Each window is summarised like the
+firmware does: the per-channel sum over the columns and the per-channel maximum
+times the number of columns (16 integers). A softmax regression on those
+features is distilled from the full model's predictions, standardisation is
+folded into the weights, and the weights are quantized to int8.
+
+The exit threshold is the lowest head probability at which the windows the head
+would let exit (top class in --exit-classes, idle by default) still agree with
+the full model at least --agreement of the time. Windows below the threshold
+continue through the second convolution and the fully connected layer, so a
+strict agreement only costs exits, not accuracy.
+
+The result is written as include/early_exit_model.h; enable the head with
+-DINFERENCE_INT8_WINDOW=1 -DMODEL_EARLY_EXIT=1.
+
+Usage:
+    python early_exit_trainer.py --build data/*.csv
+    python early_exit_trainer.py --exit-classes idle,left --agreement 0.99 data/*.csv
+"""
+
+import argparse
+import math
+import os
+import sys
+from concurrent.futures import ThreadPoolExecutor
+from typing import List, Optional, Sequence, Tuple
+
+from replay_runner import DEFAULT_BINARY, ReplayResult, build, replay_file
+
+# Must match the deployed model (first pooling output: 36 columns x 8 channels)
+COLUMNS = 36
+CHANNELS = 8
+FEATURES = 2 * CHANNELS
+DEFAULT_OUTPUT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "include", "early_exit_model.h")
+# Every CNN window must be dumped with the full model's label: no idle pre-filter, the head never exits
+BUILD_FLAGS = ("-DINFERENCE_INT8_WINDOW=1 -DINFERENCE_IDLE_PREFILTER=0 -DMODEL_EARLY_EXIT=1 "
+               "-DMODEL_EARLY_EXIT_THRESHOLD=2.0f")
+
+Vector = List[float]
+
+
+def pooled_features(pooled: Sequence[int], columns: int = COLUMNS, channels: int = CHANNELS) -> List[int]:
+    """The head's input: per-channel sum over the columns, then per-channel max times the column count."""
+    sums = [sum(pooled[j * channels + c] for j in range(columns)) for c in range(channels)]
+    maxima = [max(pooled[j * channels + c] for j in range(columns)) * columns for c in range(channels)]
+    return sums + maxima
+
+
+def softmax(logits: Sequence[float]) -> List[float]:
+    top = max(logits)
+    exps = [math.exp(v - top) for v in logits]
+    total = sum(exps)
+    return [v / total for v in exps]
+
+
+def train_softmax(points: Sequence[Sequence[float]], targets: Sequence[int], classes: int,
+                  epochs: int = 300, learning_rate: float = 0.5,
+                  l2: float = 1e-4) -> Tuple[List[Vector], Vector, Vector, Vector]:
+    """Full-batch gradient descent on standardised features.
+
+    Returns (weights, bias, mean, std) of the standardised model.
+    """
+    if not points:
+        raise ValueError("need at least one window to train on")
+    dims = len(points[0])
+    mean = [sum(p[i] for p in points) / len(points) for i in range(dims)]
+    std = [math.sqrt(sum((p[i] - mean[i]) ** 2 for p in points) / len(points)) or 1.0 for i in range(dims)]
+    z = [[(p[i] - mean[i]) / std[i] for i in range(dims)] for p in points]
+
+    weights = [[0.0] * dims for _ in range(classes)]
+    bias = [0.0] * classes
+    for _ in range(epochs):
+        grad_w = [[0.0] * dims for _ in range(classes)]
+        grad_b = [0.0] * classes
+        for x, target in zip(z, targets):
+            probs = softmax([b + sum(w_i * x_i for w_i, x_i in zip(w, x)) for w, b in zip(weights, bias)])
+            for k in range(classes):
+                err = probs[k] - (1.0 if k == target else 0.0)
+                grad_b[k] += err
+                row = grad_w[k]
+                for i in range(dims):
+                    row[i] += err * x[i]
+        scale = learning_rate / len(z)
+        for k in range(classes):
+            bias[k] -= scale * grad_b[k]
+            for i in range(dims):
+                weights[k][i] -= scale * grad_w[k][i] + learning_rate * l2 * weights[k][i]
+    return weights, bias, mean, std
+
+
+def quantize_head(weights: Sequence[Sequence[float]], bias: Sequence[float], mean: Sequence[float],
+                  std: Sequence[float]) -> Tuple[List[List[int]], List[int], float]:
+    """Fold the standardisation into the weights and quantize them symmetrically to int8.
+
+    Returns (int8 weights, int32 bias, logit scale): logit = (bias + sum(w * feature)) * scale.
+    """
+    folded = [[w_i / s_i for w_i, s_i in zip(w, std)] for w in weights]
+    folded_bias = [b - sum(w_i * m_i for w_i, m_i in zip(w, mean)) for w, b in zip(folded, bias)]
+    largest = max((abs(v) for w in folded for v in w), default=0.0)
+    scale = largest / 127.0 if largest > 0 else 1.0
+    q_weights = [[max(-127, min(127, int(round(v / scale)))) for v in w] for w in folded]
+    q_bias = [int(round(b / scale)) for b in folded_bias]
+    return q_weights, q_bias, scale
+
+
+def head_probabilities(features: Sequence[int], weights: Sequence[Sequence[int]], bias: Sequence[int],
+                       scale: float) -> List[float]:
+    """The firmware evaluation (integer accumulation, scaled logits, float softmax)."""
+    return softmax([(b + sum(w_i * f_i for w_i, f_i in zip(w, features))) * scale for w, b in zip(weights, bias)])
+
+
+def select_threshold(decisions: Sequence[Tuple[int, float, int]], exit_classes: Sequence[int],
+                     agreement: float) -> Optional[float]:
+    """Lowest probability at which the exiting windows agree with the full model often enough.
+
+    decisions holds (head top class, head probability, full model class) per window.
+    Returns None when no threshold reaches the agreement.
+    """
+    candidates = sorted(((p, top == full) for top, p, full in decisions if top in exit_classes), reverse=True)
+    threshold = None
+    agreed = 0
+    for n, (p, same) in enumerate(candidates, start=1):
+        agreed += same
+        # Only cut between distinct probabilities: every window at the threshold exits
+        if agreed >= agreement * n and (n == len(candidates) or candidates[n][0] < p):
+            threshold = p
+    return threshold
+
+
+def labelled_windows(result: ReplayResult) -> List[Tuple[List[int], int]]:
+    """Pair every dumped pooling output with the full model's class for the same window."""
+    predicted = {w.frame: w.label for w in result.windows}
+    windows = []
+    for frame, pooled in result.pooled:
+        label = predicted.get(frame)
+        if label in result.labels and len(pooled) == COLUMNS * CHANNELS:
+            windows.append((pooled_features(pooled), result.labels.index(label)))
+    return windows
+
+
+def format_header(weights: Sequence[Sequence[int]], bias: Sequence[int], scale: float, class_mask: int,
+                  threshold: float, columns: int = COLUMNS, channels: int = CHANNELS) -> str:
+    lines = [
+        "#ifndef EARLY_EXIT_MODEL_H",
+        "#define EARLY_EXIT_MODEL_H",
+        "",
+        "// 第一层池化之后的提前退出分类头（见 model_module.cpp）",
+        "// 由 pc_controller/early_exit_trainer.py 生成，不要手工修改",
+        "",
+        "#include <stdint.h>",
+        "",
+        f"#define EARLY_EXIT_MODEL_CLASSES {len(weights)}",
+        f"#define EARLY_EXIT_MODEL_COLUMNS {columns}",
+        f"#define EARLY_EXIT_MODEL_CHANNELS {channels}",
+        f"#define EARLY_EXIT_MODEL_FEATURES {2 * channels}",
+        "",
+    ]
+    if weights:
+        lines.append(f"static const int8_t kEarlyExitWeights[{len(weights)} * {2 * channels}] = {{")
+        for row in weights:
+            lines.append("    " + " ".join(f"{v}," for v in row))
+        lines.append("};")
+        lines.append(f"static const int32_t kEarlyExitBias[{len(bias)}] = {{" + ", ".join(str(b) for b in bias) + "};")
+    else:
+        lines.append("static const int8_t kEarlyExitWeights[1] = {0};")
+        lines.append("static const int32_t kEarlyExitBias[1] = {0};")
+    lines.append(f"static const float kEarlyExitLogitScale = {scale:.9g}f;")
+    lines.append(f"static const uint32_t kEarlyExitClassMask = 0x{class_mask:02x};")
+    lines.append(f"static const float kEarlyExitThreshold = {threshold:.6g}f;")
+    lines += ["", "#endif", ""]
+    return "\n".join(lines)
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    parser = argparse.ArgumentParser(description="Train the firmware early-exit head")
+    parser.add_argument("files", nargs="+", help="Edge Impulse CSV recordings (labels come from the full model)")
+    parser.add_argument("--binary", default=DEFAULT_BINARY, help="host_replay program")
+    parser.add_argument("--build", action="store_true", help=f"rebuild host_replay with {BUILD_FLAGS}")
+    parser.add_argument("--jobs", type=int, default=os.cpu_count() or 1, help="parallel replay processes")
+    parser.add_argument("--exit-classes", default="idle", help="comma-separated classes allowed to exit early")
+    parser.add_argument("--agreement", type=float, default=0.995,
+                        help="required agreement with the full model among the windows that exit")
+    parser.add_argument("--epochs", type=int, default=300, help="gradient descent epochs")
+    parser.add_argument("--output", default=DEFAULT_OUTPUT, help="generated header")
+    args = parser.parse_args(argv)
+
+    if args.build:
+        build(BUILD_FLAGS)
+    if not os.path.exists(args.binary):
+        print(f"[EarlyExit] {args.binary} not found, build it with --build")
+        return 1
+
+    with ThreadPoolExecutor(max_workers=max(1, args.jobs)) as pool:
+        results = list(pool.map(lambda path: replay_file(args.binary, path, pooled=True), args.files))
+    labels = next((r.labels for r in results if r.labels), [])
+    windows = [w for result in results for w in labelled_windows(result)]
+    print(f"[EarlyExit] {len(windows)} windows from {len(results)} recordings")
+    if not windows or not labels:
+        print("[EarlyExit] No pooling outputs dumped (was host_replay built with MODEL_EARLY_EXIT?)")
+        return 1
+    exit_classes = [labels.index(name) for name in args.exit_classes.split(",") if name in labels]
+    if not exit_classes:
+        print(f"[EarlyExit] None of {args.exit_classes} is a model class ({', '.join(labels)})")
+        return 1
+
+    points = [features for features, _ in windows]
+    targets = [target for _, target in windows]
+    weights, bias, mean, std = train_softmax(points, targets, len(labels), epochs=args.epochs)
+    q_weights, q_bias, scale = quantize_head(weights, bias, mean, std)
+
+    decisions = []
+    for features, target in windows:
+        probs = head_probabilities(features, q_weights, q_bias, scale)
+        top = max(range(len(probs)), key=probs.__getitem__)
+        decisions.append((top, probs[top], target))
+    agreed = sum(1 for top, _, target in decisions if top == target)
+    print(f"[EarlyExit] Head agrees with the full model on {agreed} of {len(decisions)} windows")
+
+    threshold = select_threshold(decisions, exit_classes, args.agreement)
+    class_mask = sum(1 << k for k in exit_classes) if threshold is not None else 0
+    if threshold is None:
+        print(f"[EarlyExit] No threshold reaches {args.agreement:.3f} agreement, the head will never exit")
+        threshold = 1.0
+    else:
+        # Rounded down so the printed threshold keeps every selected window on the exit side
+        threshold = math.floor(threshold * 1e6) / 1e6
+        exits = [(top, target) for top, p, target in decisions if top in exit_classes and p >= threshold]
+        same = sum(1 for top, target in exits if top == target)
+        print(f"[EarlyExit] Threshold {threshold:.4f}: {len(exits)} of {len(decisions)} windows exit "
+              f"({100.0 * len(exits) / len(decisions):.1f}%), {same} agree with the full model")
+
+    with open(args.output, "w", encoding="utf-8") as f:
+        f.write(format_header(q_weights, q_bias, scale, class_mask, threshold))
+    print(f"[EarlyExit] Head written to {args.output}")
+    print("[EarlyExit] build_flags: -DINFERENCE_INT8_WINDOW=1 -DMODEL_EARLY_EXIT=1")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
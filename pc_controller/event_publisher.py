@@ -0,0 +1,381 @@
+"""
+Event Publisher Module
+
+Fans each decided gesture out to other applications on this PC (OBS, dashboards, Unity)
+over UDP multicast and a local WebSocket endpoint, without going through the GUI.
+
+Every event is one fixed 36-byte little-endian frame (EVENT_FRAME), packed into a buffer
+allocated once and sent with one send per subscriber, from the thread that decided the
+gesture (the BLE notification handler for the device's own results):
+
+    uint8   version (FRAME_VERSION)
+    uint8   label index in MODEL_LABELS (0xFF: a host model class outside them)
+    uint16  reserved (0)
+    uint32  event sequence since the publisher started
+    float32 confidence
+    uint64  publish time, perf_counter_ns (CLOCK_MONOTONIC / QueryPerformanceCounter:
+            a subscriber on the same PC subtracts it from its own clock for the latency)
+    char[16] label, NUL-padded UTF-8
+
+The WebSocket endpoint (ws://127.0.0.1:<port>/, any path) sends the same bytes as one
+binary message per event. A subscriber that cannot take a frame at once (its socket buffer
+is full) is disconnected rather than delaying everyone else.
+
+    python event_publisher.py listen --multicast 239.255.71.1:5871
+    python event_publisher.py listen --websocket 5872
+"""
+
+import argparse
+import base64
+import hashlib
+import selectors
+import socket
+import struct
+import sys
+import threading
+import time
+from typing import List, Optional, Tuple
+
+from config_manager import ConfigManager
+from gesture_labels import MODEL_LABELS
+from percentiles import percentile
+
+EVENT_FRAME = struct.Struct('<BBHIfQ16s')
+FRAME_VERSION = 1
+UNKNOWN_LABEL = 0xFF
+
+WEBSOCKET_GUID = b"258EAFA5-E914-47DA-95CA-C5AB0DC11B0A"
+# FIN + binary opcode, then the unmasked 7-bit payload length
+WEBSOCKET_HEADER = bytes([0x82, EVENT_FRAME.size])
+WEBSOCKET_CLOSE = 0x8
+WEBSOCKET_PING = 0x9
+WEBSOCKET_PONG = 0xA
+HANDSHAKE_MAX_BYTES = 8192
+
+
+def parse_endpoint(text: str) -> Optional[Tuple[str, int]]:
+    """("group", port) of a "group:port" setting, None when empty or malformed."""
+    host, sep, port = text.rpartition(":")
+    if not sep or not host or not port.isdigit() or not 0 < int(port) < 65536:
+        return None
+    return host, int(port)
+
+
+def decode_frame(data: bytes) -> Optional[Tuple[int, str, float, int, int]]:
+    """(sequence, label, confidence, label index, publish time ns) of an event frame."""
+    if len(data) < EVENT_FRAME.size or data[0] != FRAME_VERSION:
+        return None
+    _, index, _, sequence, confidence, published_ns, label = EVENT_FRAME.unpack_from(data)
+    return sequence, label.rstrip(b"\0").decode("utf-8", "replace"), confidence, index, published_ns
+
+
+def websocket_accept(key: str) -> str:
+    return base64.b64encode(hashlib.sha1(key.encode("ascii") + WEBSOCKET_GUID).digest()).decode("ascii")
+
+
+class _Client:
+    """A WebSocket connection: handshake bytes until upgraded, then the client's frames."""
+
+    def __init__(self, sock: socket.socket):
+        self.sock = sock
+        self.pending = bytearray()
+        self.upgraded = False
+
+
+class EventPublisher:
+    """Publishes decided gestures when config.json sets publish_multicast and / or publish_websocket_port."""
+
+    MULTICAST_TTL = 1
+
+    def __init__(self, config: ConfigManager):
+        multicast, websocket_port = config.get_event_publisher()
+        self._multicast = parse_endpoint(multicast)
+        self._websocket_port = websocket_port
+        # Frame buffer: the WebSocket header, then the event frame the datagram also carries
+        self._buffer = bytearray(WEBSOCKET_HEADER) + bytearray(EVENT_FRAME.size)
+        self._websocket_frame = memoryview(self._buffer)
+        self._datagram = self._websocket_frame[len(WEBSOCKET_HEADER):]
+        self._sequence = 0
+        # Label to (index, label field), so an event only packs numbers into the buffer
+        self._labels = {label: (i, label.encode("utf-8")[:16]) for i, label in enumerate(MODEL_LABELS)}
+        self._udp: Optional[socket.socket] = None
+        self._listener: Optional[socket.socket] = None
+        self._selector: Optional[selectors.BaseSelector] = None
+        self._thread: Optional[threading.Thread] = None
+        # Replaced, never mutated, so publish() can drop a subscriber while iterating it
+        self._subscribers: Tuple[_Client, ...] = ()
+        self._lock = threading.RLock()
+        self._running = False
+
+    @property
+    def enabled(self) -> bool:
+        return self._multicast is not None or self._websocket_port > 0
+
+    def websocket_port(self) -> Optional[int]:
+        """Port the WebSocket endpoint listens on, None when it is off."""
+        return self._listener.getsockname()[1] if self._listener else None
+
+    def subscriber_count(self) -> int:
+        return len(self._subscribers)
+
+    def start(self) -> None:
+        if self._running or not self.enabled:
+            return
+        if self._multicast is not None:
+            udp = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+            udp.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_TTL, self.MULTICAST_TTL)
+            udp.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_LOOP, 1)
+            # Connected once: each event is a plain send without an address lookup
+            udp.connect(self._multicast)
+            self._udp = udp
+            print(f"[Publish] Events to udp://{self._multicast[0]}:{self._multicast[1]}")
+        if self._websocket_port > 0:
+            listener = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+            listener.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+            # Other applications on this PC only
+            listener.bind(("127.0.0.1", self._websocket_port))
+            listener.listen(8)
+            listener.setblocking(False)
+            self._listener = listener
+            self._selector = selectors.DefaultSelector()
+            self._selector.register(listener, selectors.EVENT_READ)
+            print(f"[Publish] Events on ws://127.0.0.1:{self.websocket_port()}/")
+        self._running = True
+        if self._selector is not None:
+            self._thread = threading.Thread(target=self._serve, name="event-publisher", daemon=True)
+            self._thread.start()
+
+    def publish(self, gesture: str, confidence: float) -> None:
+        """Send one event to every subscriber (called from the thread that decided it)."""
+        if not self._running:
+            return
+        label = self._labels.get(gesture)
+        if label is None:
+            label = self._labels[gesture] = (UNKNOWN_LABEL, gesture.encode("utf-8")[:16])
+        with self._lock:
+            self._sequence = (self._sequence + 1) & 0xFFFFFFFF
+            EVENT_FRAME.pack_into(self._buffer, len(WEBSOCKET_HEADER), FRAME_VERSION, label[0], 0, self._sequence,
+                                  confidence, time.perf_counter_ns(), label[1])
+            if self._udp is not None:
+                try:
+                    self._udp.send(self._datagram)
+                except OSError:
+                    pass
+            for client in self._subscribers:
+                try:
+                    if client.sock.send(self._websocket_frame) == len(self._websocket_frame):
+                        continue
+                except OSError:
+                    pass
+                # A partial frame would desynchronise the stream: drop the slow subscriber. The
+                # selector thread sees the shut down socket and closes it.
+                self._subscribers = tuple(c for c in self._subscribers if c is not client)
+                try:
+                    client.sock.shutdown(socket.SHUT_RDWR)
+                except OSError:
+                    pass
+
+    def close(self) -> None:
+        self._running = False
+        if self._thread is not None:
+            self._thread.join(timeout=1.0)
+            self._thread = None
+        with self._lock:
+            for client in self._subscribers:
+                client.sock.close()
+            self._subscribers = ()
+        for sock in (self._udp, self._listener):
+            if sock is not None:
+                sock.close()
+        self._udp = self._listener = None
+        if self._selector is not None:
+            self._selector.close()
+            self._selector = None
+
+    # ---- WebSocket endpoint (selector thread) ----
+
+    def _serve(self) -> None:
+        while self._running:
+            try:
+                ready = self._selector.select(timeout=0.2)
+            except (OSError, ValueError):
+                break
+            for key, _ in ready:
+                if key.fileobj is self._listener:
+                    self._accept()
+                else:
+                    self._read(key.data)
+
+    def _accept(self) -> None:
+        try:
+            sock, _ = self._listener.accept()
+        except OSError:
+            return
+        sock.setblocking(False)
+        sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self._selector.register(sock, selectors.EVENT_READ, _Client(sock))
+
+    def _read(self, client: _Client) -> None:
+        try:
+            data = client.sock.recv(4096)
+        except BlockingIOError:
+            return
+        except OSError:
+            data = b""
+        if not data:
+            self._drop(client)
+            return
+        client.pending += data
+        if not client.upgraded:
+            self._handshake(client)
+        else:
+            self._client_frames(client)
+
+    def _handshake(self, client: _Client) -> None:
+        end = client.pending.find(b"\r\n\r\n")
+        if end < 0:
+            if len(client.pending) > HANDSHAKE_MAX_BYTES:
+                self._drop(client)
+            return
+        key = None
+        for line in bytes(client.pending[:end]).decode("latin-1").split("\r\n")[1:]:
+            name, _, value = line.partition(":")
+            if name.strip().lower() == "sec-websocket-key":
+                key = value.strip()
+        del client.pending[:end + 4]
+        if key is None:
+            client.sock.sendall(b"HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\n\r\n")
+            self._drop(client)
+            return
+        client.sock.sendall(("HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                             f"Sec-WebSocket-Accept: {websocket_accept(key)}\r\n\r\n").encode("ascii"))
+        client.upgraded = True
+        with self._lock:
+            self._subscribers = self._subscribers + (client,)
+
+    def _client_frames(self, client: _Client) -> None:
+        """Answer pings and closes; subscribers send nothing else that matters."""
+        while len(client.pending) >= 2:
+            opcode = client.pending[0] & 0x0F
+            length = client.pending[1] & 0x7F
+            header = 2
+            if length == 126:
+                header, length = 4, int.from_bytes(client.pending[2:4], "big")
+            elif length == 127:
+                header, length = 10, int.from_bytes(client.pending[2:10], "big")
+            masked = client.pending[1] & 0x80
+            total = header + (4 if masked else 0) + length
+            if len(client.pending) < total:
+                return
+            payload = bytes(client.pending[total - length:total])
+            if masked:
+                mask = client.pending[header:header + 4]
+                payload = bytes(b ^ mask[i % 4] for i, b in enumerate(payload))
+            del client.pending[:total]
+            if opcode == WEBSOCKET_CLOSE:
+                self._send_control(client, WEBSOCKET_CLOSE, payload[:2])
+                self._drop(client)
+                return
+            if opcode == WEBSOCKET_PING:
+                self._send_control(client, WEBSOCKET_PONG, payload[:125])
+
+    def _send_control(self, client: _Client, opcode: int, payload: bytes) -> None:
+        with self._lock:
+            try:
+                client.sock.send(bytes([0x80 | opcode, len(payload)]) + payload)
+            except OSError:
+                pass
+
+    def _drop(self, client: _Client) -> None:
+        with self._lock:
+            self._subscribers = tuple(c for c in self._subscribers if c is not client)
+        try:
+            self._selector.unregister(client.sock)
+        except (KeyError, ValueError):
+            pass
+        client.sock.close()
+
+
+# ---- Subscriber side (measurement / example) ----
+
+def open_multicast(group: str, port: int) -> socket.socket:
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sock.bind(("", port))
+    if socket.inet_aton(group)[0] & 0xF0 == 0xE0:
+        membership = socket.inet_aton(group) + socket.inet_aton("0.0.0.0")
+        sock.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, membership)
+    return sock
+
+
+def open_websocket(port: int, host: str = "127.0.0.1") -> socket.socket:
+    sock = socket.create_connection((host, port))
+    sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    key = base64.b64encode(hashlib.sha1(str(time.time()).encode()).digest()[:16]).decode("ascii")
+    sock.sendall((f"GET / HTTP/1.1\r\nHost: {host}:{port}\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                  f"Sec-WebSocket-Key: {key}\r\nSec-WebSocket-Version: 13\r\n\r\n").encode("ascii"))
+    response = b""
+    while b"\r\n\r\n" not in response:
+        chunk = sock.recv(1024)
+        if not chunk:
+            raise ConnectionError("endpoint closed during the handshake")
+        response += chunk
+    if websocket_accept(key).encode("ascii") not in response:
+        raise ConnectionError("not a WebSocket endpoint")
+    return sock
+
+
+def receive_websocket_frame(sock: socket.socket) -> bytes:
+    """Payload of the next event message (the publisher sends unmasked frames with 7-bit lengths)."""
+    header = _receive_exact(sock, 2)
+    return _receive_exact(sock, header[1] & 0x7F)
+
+
+def _receive_exact(sock: socket.socket, count: int) -> bytes:
+    data = b""
+    while len(data) < count:
+        chunk = sock.recv(count - len(data))
+        if not chunk:
+            raise ConnectionError("endpoint closed")
+        data += chunk
+    return data
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Receive the controller's published gesture events")
+    sub = parser.add_subparsers(dest="command", required=True)
+    listen = sub.add_parser("listen", help="print events and their latency from the publisher")
+    listen.add_argument("--multicast", help="group:port (publish_multicast)")
+    listen.add_argument("--websocket", type=int, help="port (publish_websocket_port)")
+    args = parser.parse_args()
+
+    if args.websocket:
+        sock = open_websocket(args.websocket)
+        receive = lambda: receive_websocket_frame(sock)
+    else:
+        endpoint = parse_endpoint(args.multicast or "")
+        if endpoint is None:
+            parser.error("give --multicast group:port or --websocket port")
+        sock = open_multicast(*endpoint)
+        receive = lambda: sock.recv(64)
+    latencies: List[float] = []
+    try:
+        while True:
+            data = receive()
+            received_ns = time.perf_counter_ns()
+            event = decode_frame(data)
+            if event is None:
+                continue
+            sequence, label, confidence, _, published_ns = event
+            latencies.append((received_ns - published_ns) / 1e6)
+            print(f"{sequence:6d} {label:<12s} {confidence:5.2f}  {latencies[-1]:.3f} ms")
+    except (KeyboardInterrupt, ConnectionError):
+        pass
+    if latencies:
+        print(f"{len(latencies)} events, latency p50 {percentile(latencies, 0.5):.3f} ms, "
+              f"p99 {percentile(latencies, 0.99):.3f} ms")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
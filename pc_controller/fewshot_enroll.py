@@ -0,0 +1,107 @@
+"""
+Few-shot enroll - teach the board a custom gesture over BLE
+
+Firmware built with INFERENCE_FEWSHOT keeps up to FEWSHOT_MAX_CLASSES custom
+gestures as int8 centroids of the model's penultimate activations (36 x 10,
+the fully connected layer's input). Each recorded example is one performance
+of the gesture: the device averages the windows of the next FEWSHOT_CAPTURE_MS
+that the model does not call idle. After a few examples the class is committed:
+the device computes the centroid and a radius from the spread of the windows
+and writes them to flash, and from then on a window whose activations fall
+within the radius of a custom class is reported as that class on the custom
+gesture characteristic (19B1002A) instead of the built-in result. No training
+run and no firmware build are involved; enrolling takes a few seconds.
+
+Names are kept here on the host: the device only knows class numbers.
+
+Usage:
+    python fewshot_enroll.py --class 0 --examples 5   # prompts before each example
+    python fewshot_enroll.py --status
+    python fewshot_enroll.py --erase 0                # --erase all forgets every class
+"""
+
+import argparse
+import asyncio
+import sys
+from typing import List, Optional
+
+from ble_manager import (FEWSHOT_ALL_CLASSES, FEWSHOT_CANCEL_COMMAND, FEWSHOT_ERASE_COMMAND, FewShotStatus)
+
+
+def describe(status: FewShotStatus) -> str:
+    classes = ", ".join(str(k) for k in status.classes) or "none"
+    text = f"{status.state}, classes [{classes}], {status.matches} recognized"
+    if status.enroll_class is not None:
+        text += f", class {status.enroll_class}: {status.examples} examples / {status.windows} windows"
+    if status.last_class is not None:
+        text += f", last {status.last_class} (distance {status.last_distance})"
+    if status.error != "ok":
+        text += f", error {status.error}"
+    return text
+
+
+def parse_erase(value: str) -> int:
+    return FEWSHOT_ALL_CLASSES if value == "all" else int(value)
+
+
+async def enroll(manager, class_index: int, examples: int, prompt=input) -> int:
+    for n in range(examples):
+        prompt(f"[FewShot] Example {n + 1}/{examples} of class {class_index}: press Enter, then do the gesture")
+        status = await manager.record_fewshot_example(class_index)
+        if status is None or status.error != "ok":
+            print(f"[FewShot] Recording refused: {describe(status) if status else 'no status'}")
+            await manager.fewshot_command(FEWSHOT_CANCEL_COMMAND)
+            return 1
+        print(f"[FewShot] {status.examples} examples, {status.windows} windows")
+    status = await manager.commit_fewshot_class()
+    if status is None or status.error != "ok" or class_index not in status.classes:
+        print(f"[FewShot] Commit failed: {describe(status) if status else 'no status'}")
+        await manager.fewshot_command(FEWSHOT_CANCEL_COMMAND)
+        return 1
+    print(f"[FewShot] Class {class_index} enrolled: {describe(status)}")
+    return 0
+
+
+async def run(args) -> int:
+    from ble_manager import BLEManager
+
+    manager = BLEManager()
+    manager.set_auto_reconnect(False)
+    connected = await manager.connect(args.address) if args.address else await manager.scan_and_connect()
+    if not connected:
+        print("[FewShot] Device not connected")
+        return 1
+    try:
+        status = await manager.read_fewshot_status()
+        if status is None:
+            print("[FewShot] No custom gesture status (firmware without INFERENCE_FEWSHOT?)")
+            return 1
+        if args.erase is not None:
+            status = await manager.fewshot_command(FEWSHOT_ERASE_COMMAND, args.erase)
+            await asyncio.sleep(0.5)
+            status = await manager.read_fewshot_status()
+        elif args.class_index is not None:
+            return await enroll(manager, args.class_index, args.examples)
+        print(f"[FewShot] Device: {describe(status) if status else 'no status'}")
+        return 0 if status is not None and status.error == "ok" else 1
+    finally:
+        await manager.disconnect()
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    parser = argparse.ArgumentParser(description="Enroll custom gestures on the board over BLE")
+    parser.add_argument("--class", dest="class_index", type=int, help="custom class number to enroll")
+    parser.add_argument("--examples", type=int, default=5, help="examples to record before committing")
+    parser.add_argument("--erase", type=parse_erase, help="class number to forget, or 'all'")
+    parser.add_argument("--address", help="device address (default: scan by name)")
+    parser.add_argument("--status", action="store_true", help="print the device's custom gesture status")
+    args = parser.parse_args(argv)
+    if args.class_index is None and args.erase is None and not args.status:
+        parser.error("give --class, --erase or --status")
+    if args.examples < 1:
+        parser.error("--examples must be at least 1")
+    return asyncio.run(run(args))
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,210 @@
+"""
+Foreground Watcher Module
+
+Tells the device when its gestures can have an effect, so it runs full-rate inference only then.
+
+The PC knows which application is in the foreground. On Windows a WinEvent hook
+(SetWinEventHook with EVENT_SYSTEM_FOREGROUND, out of context) calls back on each
+foreground switch on a thread that otherwise sleeps in GetMessage: watching costs nothing
+between switches, and there is no polling interval to trade against reaction time.
+
+With one of config.json's gesture_apps (executable names, e.g. POWERPNT.EXE) or this
+controller in the foreground the device is asked for the "full" power point; any other
+application asks for background_power_point ("idle-filter": inference only on steps with
+motion, so a gesture still wakes it). The request is the two-byte operating-point write of
+the config characteristic (encode_operating_point in ble_manager.py). The device combines
+it with its battery ladder, keeps the more conservative point and drops the request when
+the session ends, so the current one is sent again on every connection.
+
+Other systems have no such hook: the watcher does not start and the device keeps choosing
+its own point.
+
+    python foreground_watcher.py     # print each foreground switch and the point it asks for
+"""
+
+import os
+import sys
+import threading
+from typing import Callable, Iterable, Optional
+
+# Windows API constants (winuser.h / winnt.h)
+EVENT_SYSTEM_FOREGROUND = 0x0003
+WINEVENT_OUTOFCONTEXT = 0x0000
+WM_QUIT = 0x0012
+PROCESS_QUERY_LIMITED_INFORMATION = 0x1000
+MAX_IMAGE_PATH = 1024
+
+FULL_POINT = "full"
+
+
+class OperatingPointPolicy:
+    """Power point to ask for with a given process in the foreground."""
+
+    def __init__(self, gesture_apps: Iterable[str], background_point: str, own_pid: Optional[int] = None):
+        self._apps = frozenset(app.lower() for app in gesture_apps)
+        self._background = background_point
+        self._own_pid = os.getpid() if own_pid is None else own_pid
+
+    @property
+    def enabled(self) -> bool:
+        return bool(self._apps)
+
+    def point_for(self, pid: int, process: Optional[str]) -> str:
+        """"full" behind a gesture app or this controller (its log shows the gestures), the background point otherwise.
+
+        process is the executable name; None when it could not be read (an elevated process): treated as any other.
+        """
+        if pid == self._own_pid or (process is not None and process.lower() in self._apps):
+            return FULL_POINT
+        return self._background
+
+
+class OperatingPointPusher:
+    """Sends the point for the foreground process when it changes, and again on every connection.
+
+    switched() runs on the watcher thread and connected() on the GUI thread; send() is called on
+    either, at most once per change, and must only schedule the write (asyncio.run_coroutine_threadsafe).
+    """
+
+    def __init__(self, policy: OperatingPointPolicy, send: Callable[[str], None]):
+        self._policy = policy
+        self._send = send
+        self._lock = threading.Lock()
+        self._wanted: Optional[str] = None
+        self._sent: Optional[str] = None
+        self._connected = False
+
+    @property
+    def wanted(self) -> Optional[str]:
+        return self._wanted
+
+    def switched(self, pid: int, process: Optional[str]) -> None:
+        with self._lock:
+            self._wanted = self._policy.point_for(pid, process)
+            point = self._take()
+        if point is not None:
+            self._send(point)
+
+    def connected(self) -> None:
+        """A new session: the device released the previous request."""
+        with self._lock:
+            self._connected = True
+            self._sent = None
+            point = self._take()
+        if point is not None:
+            self._send(point)
+
+    def disconnected(self) -> None:
+        with self._lock:
+            self._connected = False
+            self._sent = None
+
+    def _take(self) -> Optional[str]:
+        if not self._connected or self._wanted is None or self._wanted == self._sent:
+            return None
+        self._sent = self._wanted
+        return self._wanted
+
+
+class ForegroundWatcher:
+    """Calls on_switch(pid, process name or None) for the current foreground window and on every switch (Windows)."""
+
+    def __init__(self, on_switch: Callable[[int, Optional[str]], None]):
+        self._on_switch = on_switch
+        self._thread: Optional[threading.Thread] = None
+        self._thread_id = 0
+        self._ready = threading.Event()
+        self._hooked = False
+
+    @staticmethod
+    def supported() -> bool:
+        return sys.platform == "win32"
+
+    def start(self) -> bool:
+        """Install the hook on its own message-loop thread; False where there is no foreground event hook."""
+        if self._thread is not None:
+            return self._hooked
+        if not self.supported():
+            return False
+        self._thread = threading.Thread(target=self._run, name="foreground-watcher", daemon=True)
+        self._thread.start()
+        self._ready.wait(timeout=2.0)
+        return self._hooked
+
+    def close(self) -> None:
+        if self._thread is None:
+            return
+        if self._thread_id:
+            import ctypes
+            ctypes.windll.user32.PostThreadMessageW(self._thread_id, WM_QUIT, 0, 0)
+        self._thread.join(timeout=1.0)
+        self._thread = None
+
+    def _run(self) -> None:
+        import ctypes
+        from ctypes import wintypes
+
+        user32 = ctypes.windll.user32
+        kernel32 = ctypes.windll.kernel32
+        user32.SetWinEventHook.restype = wintypes.HANDLE
+        kernel32.OpenProcess.restype = wintypes.HANDLE
+        process_id = wintypes.DWORD()
+        image = ctypes.create_unicode_buffer(MAX_IMAGE_PATH)
+
+        def report(hwnd) -> None:
+            if not hwnd or not user32.GetWindowThreadProcessId(hwnd, ctypes.byref(process_id)):
+                return
+            name = None
+            handle = kernel32.OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, False, process_id.value)
+            if handle:
+                length = wintypes.DWORD(MAX_IMAGE_PATH)
+                if kernel32.QueryFullProcessImageNameW(handle, 0, image, ctypes.byref(length)):
+                    name = os.path.basename(image.value)
+                kernel32.CloseHandle(handle)
+            try:
+                self._on_switch(process_id.value, name)
+            except Exception as e:
+                print(f"[Foreground] Handler failed: {e}")
+
+        WinEventProc = ctypes.WINFUNCTYPE(None, wintypes.HANDLE, wintypes.DWORD, wintypes.HWND, wintypes.LONG,
+                                          wintypes.LONG, wintypes.DWORD, wintypes.DWORD)
+        # Kept referenced for the lifetime of the hook
+        callback = WinEventProc(lambda hook, event, hwnd, obj, child, thread, time_ms: report(hwnd))
+        hook = user32.SetWinEventHook(EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND, None, callback, 0, 0,
+                                      WINEVENT_OUTOFCONTEXT)
+        self._hooked = bool(hook)
+        self._thread_id = kernel32.GetCurrentThreadId()
+        self._ready.set()
+        if not hook:
+            print("[Foreground] SetWinEventHook failed; the device keeps its own power point")
+            return
+        report(user32.GetForegroundWindow())
+        # Out-of-context hooks are delivered while this thread waits for messages
+        msg = wintypes.MSG()
+        while user32.GetMessageW(ctypes.byref(msg), None, 0, 0) > 0:
+            user32.TranslateMessage(ctypes.byref(msg))
+            user32.DispatchMessageW(ctypes.byref(msg))
+        user32.UnhookWinEvent(hook)
+
+
+def main() -> None:
+    from config_manager import ConfigManager
+
+    config = ConfigManager(os.path.join(os.path.dirname(os.path.abspath(__file__)), "config.json"))
+    config.load()
+    apps, background = config.get_foreground_gating()
+    policy = OperatingPointPolicy(apps, background)
+    watcher = ForegroundWatcher(lambda pid, name: print(f"{name or '?'} (pid {pid}): {policy.point_for(pid, name)}"))
+    if not watcher.start():
+        print("No foreground event hook on this system")
+        return
+    try:
+        threading.Event().wait()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        watcher.close()
+
+
+if __name__ == "__main__":
+    main()
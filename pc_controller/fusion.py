@@ -0,0 +1,150 @@
+"""
+Fusion Module
+
+Host-side decision stage over the streamed score vectors (BLEManager.set_scores_callback),
+between the transport and GestureHandler: instead of acting on each inference's argmax,
+a decoder integrates the probabilities over time and fires once per gesture.
+
+Decoders (config "fusion_method"):
+- smoothing: exponential smoothing of each class probability, time constant SMOOTHING_TAU_STEPS
+- hmm: forward-filtered HMM over the classes with a sticky transition matrix (the online half of
+  Viterbi: the posterior of the current state given everything seen so far)
+
+Both fire when a gesture class reaches its threshold (per gesture, "fusion_thresholds", falling
+back to the confidence threshold) and re-arm once every gesture class has fallen below
+RELEASE_FRACTION of its threshold. State is kept per stream (device address), so several
+boards can share one engine.
+"""
+
+import math
+from typing import Callable, Dict, List, Optional, Sequence, Tuple
+
+from config_manager import ConfigManager
+from gesture_labels import GESTURE_LABELS, MODEL_LABELS
+
+
+class _Stream:
+    """Decoder state of one device's score stream."""
+
+    def __init__(self, belief: List[float]):
+        self.belief = belief
+        self.sequence: Optional[int] = None
+        self.armed = True
+
+
+class FusionEngine:
+    """Probability fusion and temporal smoothing of one or more score streams."""
+
+    METHODS = ConfigManager.FUSION_METHODS
+    # Smoothing time constant in inferences (24 inferences/s: about 125 ms)
+    SMOOTHING_TAU_STEPS = 3.0
+    # HMM: probability of staying in the same class from one inference to the next
+    HMM_STAY = 0.9
+    # Floor of an emission probability, so one near-zero score cannot veto a class outright
+    EMISSION_FLOOR = 1e-3
+    # A gesture re-arms once every gesture class is below this fraction of its threshold
+    RELEASE_FRACTION = 0.6
+    # Sequence gaps longer than this (missed notifications, a reconnect) restart the stream
+    MAX_GAP_STEPS = 48
+
+    def __init__(self, config_manager: ConfigManager, labels: Sequence[str] = MODEL_LABELS):
+        self._config = config_manager
+        self._labels = tuple(labels)
+        self._gestures = [i for i, label in enumerate(self._labels) if label in GESTURE_LABELS]
+        self._streams: Dict[str, _Stream] = {}
+        self._callback: Optional[Callable[[str, float], None]] = None
+        self._method = "off"
+        self._thresholds: List[float] = []
+        self._transition = self._make_transition(len(self._labels), self.HMM_STAY)
+        self._configure()
+        self._config.add_change_callback(self._configure)
+
+    @staticmethod
+    def _make_transition(classes: int, stay: float) -> List[List[float]]:
+        move = (1.0 - stay) / (classes - 1) if classes > 1 else 0.0
+        return [[stay if i == j else move for j in range(classes)] for i in range(classes)]
+
+    def _configure(self) -> None:
+        """Pick up the method and thresholds from the config snapshot (a method change restarts every stream)."""
+        snapshot = self._config.snapshot()
+        thresholds = [snapshot.fusion_thresholds.get(label, snapshot.confidence_threshold) for label in self._labels]
+        if snapshot.fusion_method != self._method:
+            self._streams = {}
+        self._method = snapshot.fusion_method
+        self._thresholds = thresholds
+
+    @property
+    def enabled(self) -> bool:
+        return self._method != "off"
+
+    def set_gesture_callback(self, callback: Callable[[str, float], None]) -> None:
+        """Set callback for fused detections. Signature: callback(gesture, confidence)"""
+        self._callback = callback
+
+    def reset(self, stream: Optional[str] = None) -> None:
+        """Forget the state of one stream (None: all of them), e.g. after a reconnect."""
+        if stream is None:
+            self._streams = {}
+        else:
+            self._streams.pop(stream, None)
+
+    def feed(self, probabilities: Sequence[float], sequence: Optional[int] = None,
+             stream: str = "") -> Optional[Tuple[str, float]]:
+        """Account one inference's probabilities; returns (gesture, confidence) when a gesture fires."""
+        if self._method == "off" or len(probabilities) != len(self._labels):
+            return None
+        emission = self._normalize(probabilities)
+        state = self._streams.get(stream)
+        steps = 1
+        if state is not None and sequence is not None and state.sequence is not None:
+            steps = (sequence - state.sequence) & 0xFFFF
+            if steps == 0 or steps > self.MAX_GAP_STEPS:
+                state = None
+                steps = 1
+        if state is None:
+            # A new stream starts undecided, so its first inference is weighed like any other
+            state = _Stream([1.0 / len(emission)] * len(emission))
+            self._streams[stream] = state
+        if self._method == "smoothing":
+            self._smooth(state, emission, steps)
+        else:
+            self._forward(state, emission, steps)
+        state.sequence = sequence
+        return self._decide(state)
+
+    def _normalize(self, probabilities: Sequence[float]) -> List[float]:
+        values = [max(float(p), 0.0) for p in probabilities]
+        total = sum(values)
+        if total <= 0.0:
+            return [1.0 / len(values)] * len(values)
+        return [value / total for value in values]
+
+    def _smooth(self, state: _Stream, emission: List[float], steps: int) -> None:
+        # Missed inferences count as elapsed time: the newest one weighs as much as they would have together
+        keep = math.exp(-steps / self.SMOOTHING_TAU_STEPS)
+        state.belief = [keep * old + (1.0 - keep) * new for old, new in zip(state.belief, emission)]
+
+    def _forward(self, state: _Stream, emission: List[float], steps: int) -> None:
+        belief = state.belief
+        classes = range(len(belief))
+        for _ in range(steps):
+            belief = [sum(belief[i] * self._transition[i][j] for i in classes) for j in classes]
+        posterior = [b * max(e, self.EMISSION_FLOOR) for b, e in zip(belief, emission)]
+        total = sum(posterior)
+        state.belief = [p / total for p in posterior] if total > 0.0 else [1.0 / len(belief)] * len(belief)
+
+    def _decide(self, state: _Stream) -> Optional[Tuple[str, float]]:
+        belief = state.belief
+        thresholds = self._thresholds
+        if not state.armed:
+            if all(belief[i] < thresholds[i] * self.RELEASE_FRACTION for i in self._gestures):
+                state.armed = True
+            return None
+        best = max(self._gestures, key=lambda i: belief[i], default=None)
+        if best is None or belief[best] < thresholds[best]:
+            return None
+        state.armed = False
+        detection = (self._labels[best], belief[best])
+        if self._callback:
+            self._callback(*detection)
+        return detection
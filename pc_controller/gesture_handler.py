@@ -2,14 +2,215 @@
 Gesture Handler Module
 
 Maps gestures to custom keyboard shortcuts and triggers them.
-Supports modifier keys (Ctrl, Alt, Shift) + any key combinations.
+Supports modifier keys (Ctrl, Alt, Shift) + any key combinations, and macros of several
+combinations separated by commas ("ctrl+a, ctrl+c").
 """
 
+import re
+import threading
 import time
-from typing import Optional, Callable, List, Dict
-from pynput.keyboard import Key, Controller, KeyCode
+from collections import deque
+from dataclasses import dataclass
+from typing import Optional, Callable, List, Dict, Tuple
+from pynput.keyboard import Key, KeyCode
 
 from config_manager import ConfigManager
+from key_injector import Macro, chord_events, create_injector
+from percentiles import percentile
+
+
+@dataclass
+class ActionStats:
+    """Key injections since the executor started; latencies in ms from submit to injection done."""
+    executed: int
+    failed: int
+    dropped: int        # turned away by a full queue
+    coalesced: int      # replaced by a newer action before they ran
+    pending: int
+    p50_ms: Optional[float]
+    p95_ms: Optional[float]
+    max_ms: Optional[float]
+    # The injection call alone (the OS input call, without the wait in the queue)
+    call_p50_ms: Optional[float] = None
+    call_max_ms: Optional[float] = None
+    backend: str = ""
+
+
+class ActionExecutor:
+    """Runs key injections on a thread of its own, so a slow OS input call never holds up the caller.
+
+    submit() only queues: it is called from the BLE notification callback on the asyncio loop.
+    Policies for a busy worker: "fifo" runs every action in order and drops new ones once
+    max_pending are waiting; "latest" keeps only the newest waiting action.
+    """
+
+    POLICIES = ("fifo", "latest")
+
+    def __init__(self, press: Callable[[list, object], bool], max_pending: int = 4, policy: str = "fifo",
+                 depth: int = 64, backend: str = ""):
+        if policy not in self.POLICIES:
+            raise ValueError(f"unknown policy {policy!r}")
+        self._press = press
+        self._max_pending = max(1, max_pending)
+        self._policy = policy
+        self._depth = depth
+        self._pending: deque = deque()
+        self._condition = threading.Condition()
+        self._thread: Optional[threading.Thread] = None
+        self._running = False
+        self._backend = backend
+        self._latencies: List[float] = []
+        self._call_latencies: List[float] = []
+        self._executed = 0
+        self._failed = 0
+        self._dropped = 0
+        self._coalesced = 0
+
+    def submit(self, modifiers: list, main_key, done: Optional[Callable[[bool], None]] = None) -> bool:
+        """Queue one injection; done(success) runs on the worker afterwards. False when it was dropped."""
+        with self._condition:
+            if self._policy == "latest" and self._pending:
+                self._coalesced += len(self._pending)
+                self._pending.clear()
+            elif len(self._pending) >= self._max_pending:
+                self._dropped += 1
+                return False
+            self._pending.append((time.perf_counter(), modifiers, main_key, done))
+            if self._thread is None:
+                self._running = True
+                self._thread = threading.Thread(target=self._run, name="action-executor", daemon=True)
+                self._thread.start()
+            self._condition.notify()
+        return True
+
+    def close(self, timeout: float = 1.0) -> None:
+        """Let the waiting actions run, then stop the worker."""
+        with self._condition:
+            self._running = False
+            self._condition.notify()
+            thread = self._thread
+        if thread is not None:
+            thread.join(timeout)
+
+    def stats(self) -> ActionStats:
+        with self._condition:
+            ordered = sorted(self._latencies)
+            calls = sorted(self._call_latencies)
+            pending = len(self._pending)
+
+        def ms(values: List[float], fraction: float) -> Optional[float]:
+            return percentile(values, fraction) * 1000.0 if values else None
+
+        return ActionStats(self._executed, self._failed, self._dropped, self._coalesced, pending,
+                           ms(ordered, 0.5), ms(ordered, 0.95), ms(ordered, 1.0),
+                           ms(calls, 0.5), ms(calls, 1.0), self._backend)
+
+    def _run(self) -> None:
+        while True:
+            with self._condition:
+                while self._running and not self._pending:
+                    self._condition.wait()
+                if not self._pending:
+                    self._thread = None
+                    return
+                submitted, modifiers, main_key, done = self._pending.popleft()
+            begin = time.perf_counter()
+            success = self._press(modifiers, main_key)
+            end = time.perf_counter()
+            with self._condition:
+                if success:
+                    self._executed += 1
+                else:
+                    self._failed += 1
+                self._latencies.append(end - submitted)
+                self._call_latencies.append(end - begin)
+                del self._latencies[:-self._depth]
+                del self._call_latencies[:-self._depth]
+            if done:
+                done(success)
+
+
+class KeyRepeater:
+    """Repeats the shortcut of a held gesture from a timer thread of its own (not the Tk or asyncio thread).
+
+    start() on the device's onset: the onset event has already pressed the keys once, so the first
+    repeat comes DELAY_S later, then one every 1 / rate_hz s until stop() on the release. A repeater
+    that falls behind skips the missed repeats instead of bursting them. MAX_HOLD_S ends a hold whose
+    release never arrived.
+    """
+
+    DELAY_S = 0.4
+    MAX_HOLD_S = 30.0
+
+    def __init__(self, submit: Callable[[str, list, object], bool]):
+        self._submit = submit
+        self._condition = threading.Condition()
+        self._thread: Optional[threading.Thread] = None
+        self._running = False
+        # (gesture, modifiers, main key, interval, next due, hold deadline)
+        self._hold: Optional[Tuple[str, list, object, float, float, float]] = None
+        self._repeats = 0
+
+    def start(self, gesture: str, modifiers: list, main_key, rate_hz: float,
+              delay_s: Optional[float] = None) -> None:
+        """Repeat until stop(gesture); a hold that was running is replaced."""
+        now = time.monotonic()
+        delay = self.DELAY_S if delay_s is None else delay_s
+        with self._condition:
+            self._hold = (gesture, modifiers, main_key, 1.0 / rate_hz, now + delay, now + self.MAX_HOLD_S)
+            if self._thread is None:
+                self._running = True
+                self._thread = threading.Thread(target=self._run, name="key-repeat", daemon=True)
+                self._thread.start()
+            self._condition.notify()
+
+    def stop(self, gesture: Optional[str] = None) -> bool:
+        """End the hold of gesture (None: any); False when it was not repeating."""
+        with self._condition:
+            if self._hold is None or (gesture is not None and self._hold[0] != gesture):
+                return False
+            self._hold = None
+            self._condition.notify()
+        return True
+
+    def holding(self) -> Optional[str]:
+        hold = self._hold
+        return hold[0] if hold else None
+
+    def repeats(self) -> int:
+        """Repeats submitted since the repeater was created."""
+        return self._repeats
+
+    def close(self, timeout: float = 1.0) -> None:
+        with self._condition:
+            self._running = False
+            self._hold = None
+            self._condition.notify()
+            thread = self._thread
+        if thread is not None:
+            thread.join(timeout)
+
+    def _run(self) -> None:
+        while True:
+            with self._condition:
+                while self._running and self._hold is None:
+                    self._condition.wait()
+                if not self._running:
+                    self._thread = None
+                    return
+                gesture, modifiers, main_key, interval, due, deadline = self._hold
+                now = time.monotonic()
+                if now >= deadline:
+                    self._hold = None
+                    continue
+                if now < due:
+                    self._condition.wait(min(due, deadline) - now)
+                    continue
+                # Behind by more than a repeat (a slow injection): carry on from now, no catch-up burst
+                self._hold = (gesture, modifiers, main_key, interval,
+                              due + interval if now - due < interval else now + interval, deadline)
+                self._repeats += 1
+            self._submit(gesture, modifiers, main_key)
 
 
 class GestureHandler:
@@ -43,13 +244,20 @@ class GestureHandler:
         "win": Key.cmd,
     }
     
+    # Commas between combinations; one not followed by another key is itself the key
+    MACRO_SEPARATOR = re.compile(r"\s*,\s*(?=[^,\s])")
+
     # Default cooldown time in seconds
     DEFAULT_COOLDOWN = 2.0
     
-    def __init__(self, config_manager: ConfigManager):
-        """Initialize GestureHandler with a ConfigManager instance."""
+    def __init__(self, config_manager: ConfigManager, injector=None):
+        """Initialize GestureHandler with a ConfigManager instance.
+
+        injector sends the key events of one action in one call (key_injector.create_injector():
+        SendInput on Windows, pynput elsewhere).
+        """
         self._config = config_manager
-        self._keyboard = Controller()
+        self._injector = injector or create_injector()
         self._action_callback: Optional[Callable[[str, str], None]] = None
         
         # Cooldown time (can be configured)
@@ -57,6 +265,38 @@ class GestureHandler:
         
         # State for deduplication
         self._last_action_time: float = 0.0
+
+        # Key presses run on their own thread; process_gesture() only queues them
+        self._executor = ActionExecutor(self._press, backend=self._injector.name)
+        # Held gestures repeat from a timer thread through the same executor
+        self._repeater = KeyRepeater(self._submit)
+
+        # Shortcuts parsed once per config change: gesture -> (shortcut, modifiers, main key)
+        self._actions: Dict[str, Tuple[str, list, object]] = {}
+        self._compiled_from = None
+        self._threshold = 0.0
+        self._repeat_gestures: frozenset = frozenset()
+        self._repeat_rate = 10.0
+        self._compile_actions()
+        self._config.add_change_callback(self._compile_actions)
+
+    def _compile_actions(self) -> None:
+        """Rebuild the gesture -> key table and the threshold from the config snapshot."""
+        snapshot = self._config.snapshot()
+        self._threshold = snapshot.confidence_threshold
+        self._repeat_gestures = snapshot.repeat_gestures
+        self._repeat_rate = snapshot.repeat_rate_hz
+        if self._repeater.holding() not in self._repeat_gestures:
+            self._repeater.stop()
+        if snapshot.gesture_shortcuts is self._compiled_from:
+            return
+        actions = {}
+        for gesture, shortcut in snapshot.gesture_shortcuts.items():
+            modifiers, main_key = self.parse_shortcut(shortcut)
+            if main_key is not None:
+                actions[gesture] = (shortcut, modifiers, main_key)
+        self._actions = actions
+        self._compiled_from = snapshot.gesture_shortcuts
     
     def set_action_callback(self, callback: Callable[[str, str], None]) -> None:
         """Set a callback to be invoked when an action is triggered."""
@@ -69,10 +309,22 @@ class GestureHandler:
     def get_cooldown_time(self) -> float:
         """Get the current cooldown time."""
         return self._cooldown_time
+
+    def action_stats(self) -> ActionStats:
+        """Queueing and injection latency of the shortcuts triggered so far."""
+        return self._executor.stats()
+
+    def close(self) -> None:
+        """Stop repeating, finish the queued shortcuts and stop the key-injection thread."""
+        self._repeater.close()
+        self._executor.close()
     
     def parse_shortcut(self, shortcut_str: str) -> tuple:
         """
         Parse a shortcut string like "ctrl+shift+a" into modifiers and key.
+
+        A macro ("ctrl+a, ctrl+c") parses to no modifiers and a key_injector.Macro main key
+        holding each combination; a trailing comma is the comma key ("ctrl+,").
         
         Args:
             shortcut_str: Shortcut string (e.g., "ctrl+up", "alt+tab", "a")
@@ -82,6 +334,13 @@ class GestureHandler:
         """
         if not shortcut_str or shortcut_str.lower() == "none":
             return [], None
+
+        steps = self.MACRO_SEPARATOR.split(shortcut_str.strip())
+        if len(steps) > 1:
+            chords = tuple(self.parse_shortcut(step) for step in steps)
+            if any(main_key is None for _, main_key in chords):
+                return [], None
+            return [], Macro(tuple((tuple(modifiers), main_key) for modifiers, main_key in chords))
         
         parts = [p.strip().lower() for p in shortcut_str.split("+")]
         modifiers = []
@@ -112,24 +371,15 @@ class GestureHandler:
             True if executed successfully, False otherwise
         """
         modifiers, main_key = self.parse_shortcut(shortcut_str)
-        
+        return self._press(modifiers, main_key)
+
+    def _press(self, modifiers: list, main_key) -> bool:
+        """Press the modifiers, tap the main key, release the modifiers (every chord of a macro) in one batch."""
         if main_key is None:
             return False
         
         try:
-            # Press all modifiers
-            for mod in modifiers:
-                self._keyboard.press(mod)
-            
-            # Press and release main key
-            self._keyboard.press(main_key)
-            self._keyboard.release(main_key)
-            
-            # Release all modifiers (in reverse order)
-            for mod in reversed(modifiers):
-                self._keyboard.release(mod)
-            
-            return True
+            return self._injector.send(chord_events(modifiers, main_key))
         except Exception as e:
             print(f"[GestureHandler] Shortcut execution error: {e}")
             return False
@@ -145,19 +395,13 @@ class GestureHandler:
         Returns:
             The shortcut string if triggered, None otherwise
         """
-        threshold = self._config.get_confidence_threshold()
-        
-        if confidence < threshold:
-            return None
-        
-        # Get the shortcut for this gesture
-        shortcuts = self._config.get_gesture_shortcuts()
-        shortcut = shortcuts.get(gesture, "none")
-        
-        if not shortcut or shortcut.lower() == "none":
+        action = self._action_for(gesture, confidence)
+        return action[0] if action else None
+
+    def _action_for(self, gesture: str, confidence: float) -> Optional[Tuple[str, list, object]]:
+        if confidence < self._threshold:
             return None
-        
-        return shortcut
+        return self._actions.get(gesture)
     
     def trigger_action(self, shortcut: str) -> bool:
         """
@@ -173,37 +417,66 @@ class GestureHandler:
     
     def process_gesture(self, gesture: str, confidence: float) -> Optional[str]:
         """
-        Full gesture processing: determine shortcut and execute it.
+        Full gesture processing: determine the shortcut and queue it for the key-injection thread.
+
+        The action callback runs on that thread once the keys are pressed.
         
         Args:
             gesture: The gesture name
             confidence: The confidence value
         
         Returns:
-            The shortcut string if triggered, None otherwise
+            The shortcut string if queued, None otherwise
         """
-        shortcut = self.handle_gesture(gesture, confidence)
+        action = self._action_for(gesture, confidence)
         
-        if shortcut is not None:
+        if action is not None:
+            shortcut, modifiers, main_key = action
             current_time = time.time()
             time_since_last = current_time - self._last_action_time
             
-            if time_since_last < self._cooldown_time:
+            # The device segments hold-to-repeat gestures itself: one event per gesture, no cooldown
+            if time_since_last < self._cooldown_time and gesture not in self._repeat_gestures:
                 return None
-            
-            if self.trigger_action(shortcut):
+
+            if self._submit(gesture, modifiers, main_key):
                 self._last_action_time = current_time
-                
-                if self._action_callback:
-                    self._action_callback(gesture, shortcut)
-                
                 return shortcut
         
         return None
+
+    def process_hold(self, gesture: str, held: bool) -> bool:
+        """
+        Start or stop repeating a gesture's shortcut on the device's onset / release report.
+
+        Only gestures configured to repeat (ConfigManager.set_repeat_gesture) start; any release
+        of the gesture being repeated stops it at once. Safe to call from any thread.
+
+        Returns:
+            True if repeating started or stopped
+        """
+        if not held:
+            return self._repeater.stop(gesture)
+        action = self._actions.get(gesture)
+        if action is None or gesture not in self._repeat_gestures:
+            return False
+        _, modifiers, main_key = action
+        self._repeater.start(gesture, modifiers, main_key, self._repeat_rate)
+        return True
+
+    def _submit(self, gesture: str, modifiers: list, main_key) -> bool:
+        shortcut = self._actions.get(gesture, ("",))[0]
+
+        def done(success: bool) -> None:
+            if success and self._action_callback:
+                self._action_callback(gesture, shortcut)
+
+        return self._executor.submit(modifiers, main_key, done)
     
     def reset_state(self) -> None:
-        """Reset the deduplication state."""
+        """Reset the deduplication state and stop any repeat."""
         self._last_action_time = 0.0
+        self._repeater.stop()
     
     @classmethod
     def get_available_keys(cls) -> List[str]:
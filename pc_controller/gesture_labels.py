@@ -0,0 +1,7 @@
+"""Class order of the deployed model, generated by label_table_gen.py (do not edit).
+
+BLE result events carry the class index; MODEL_LABELS maps it back to the name.
+"""
+
+MODEL_LABELS = ("down", "idle", "left", "right", "up")
+GESTURE_LABELS = ("down", "left", "right", "up")
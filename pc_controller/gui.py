@@ -8,12 +8,19 @@ Supports Chinese/English language switching and custom keyboard shortcuts.
 import tkinter as tk
 from tkinter import ttk, messagebox
 import asyncio
+import time
 from datetime import datetime
 from typing import Optional, List, Dict
 
 from config_manager import ConfigManager
 from gesture_handler import GestureHandler
-from ble_manager import BLEManager
+from ble_manager import BLEManager, CpuUtilization, CrashReport, DeliveryCounters, LatencyBreakdown, ScoreFrame
+from diagnostics import DiagnosticsMonitor, DiagnosticsSnapshot
+from fusion import FusionEngine
+from event_publisher import EventPublisher
+from foreground_watcher import ForegroundWatcher, OperatingPointPolicy, OperatingPointPusher
+from host_model import HostModel
+from ui_batch import LatestValues, RingBuffer
 
 
 # Language strings
@@ -32,6 +39,13 @@ LANG_EN = {
     "disconnect": "Disconnect",
     "current_gesture": "Current Gesture",
     "confidence": "Confidence:",
+    "latency": "Latency (ms): sensor {0} · device {1} · radio {2} · host {3} = {4}",
+    "diagnostics": "Diagnostics",
+    "diag_rates": "Rate: {0:.1f} gestures/s · {1:.1f} events/s",
+    "diag_delivery": "Delivery: {0} received · {1} missed · {2} recovered · {3} lost ({4})",
+    "diag_host": "Host (ms): handling {0} · key injection p50 {1} / p95 {2}",
+    "diag_e2e": "End-to-end (ms): p50 {0} · p95 {1} · p99 {2}",
+    "diag_device": "Device: {0} published · {1} suppressed · {2} notify failures · CPU {3}",
     "shortcut_mapping": "Gesture → Shortcut Mapping",
     "left": "Left gesture:",
     "right": "Right gesture:",
@@ -39,6 +53,7 @@ LANG_EN = {
     "down": "Down gesture:",
     "confidence_threshold": "Confidence Threshold:",
     "cooldown": "Cooldown (seconds):",
+    "repeat_hold": "Hold repeats",
     "save_settings": "Save Settings",
     "log": "Log",
     "lang_switch": "中文",
@@ -50,6 +65,7 @@ LANG_EN = {
     "auto_connect_fail": "Auto connect failed - device not found",
     "starting_scan": "Starting 10 second scan...",
     "auto_connecting": "Auto connecting (scanning for 15s)...",
+    "device_crash": "Device reset after a {0} in the {1} thread ({2} ms after boot, pc 0x{3:08x})",
     "shortcut_hint": "Examples: right, ctrl+up, alt+tab, shift+f5",
     "shortcut_help": "Shortcut Help",
     "help_text": """Shortcut Format:
@@ -80,6 +96,13 @@ LANG_ZH = {
     "disconnect": "断开",
     "current_gesture": "当前手势",
     "confidence": "置信度：",
+    "latency": "延迟（ms）：传感器 {0} · 设备 {1} · 无线 {2} · 主机 {3} = {4}",
+    "diagnostics": "诊断",
+    "diag_rates": "速率：{0:.1f} 手势/秒 · {1:.1f} 事件/秒",
+    "diag_delivery": "送达：收到 {0} · 缺失 {1} · 补回 {2} · 丢失 {3}（{4}）",
+    "diag_host": "主机（ms）：处理 {0} · 按键注入 p50 {1} / p95 {2}",
+    "diag_e2e": "端到端（ms）：p50 {0} · p95 {1} · p99 {2}",
+    "diag_device": "设备：发布 {0} · 低于阈值 {1} · 通知失败 {2} · CPU {3}",
     "shortcut_mapping": "手势 → 快捷键映射",
     "left": "向左手势：",
     "right": "向右手势：",
@@ -87,6 +110,7 @@ LANG_ZH = {
     "down": "向下手势：",
     "confidence_threshold": "置信度阈值：",
     "cooldown": "冷却时间（秒）：",
+    "repeat_hold": "按住重复",
     "save_settings": "保存设置",
     "log": "日志",
     "lang_switch": "English",
@@ -98,6 +122,7 @@ LANG_ZH = {
     "auto_connect_fail": "自动连接失败 - 未找到设备",
     "starting_scan": "开始扫描（10秒）...",
     "auto_connecting": "自动连接中（扫描15秒）...",
+    "device_crash": "设备上次复位前发生 {0}（{1} 线程，启动后 {2} ms，pc 0x{3:08x}）",
     "shortcut_hint": "示例: right, ctrl+up, alt+tab, shift+f5",
     "shortcut_help": "快捷键帮助",
     "help_text": """快捷键格式：
@@ -116,6 +141,14 @@ backspace, delete, home, end, pageup, pagedown, f1-f12,
 
 class MainWindow:
     """Main application window using tkinter."""
+
+    # The diagnostics panel and latency line are redrawn at this period, not per notification
+    DIAGNOSTICS_REFRESH_MS = 500
+    # Gesture, status, action and log updates from other threads are drawn once per tick
+    UI_TICK_MS = 50
+    # Lines kept in the log widget (and waiting for it: older ones are dropped when it falls behind)
+    MAX_LOG_LINES = 500
+    ACTION_FEEDBACK_S = 1.5
     
     def __init__(self, config_manager: ConfigManager, gesture_handler: GestureHandler, ble_manager: BLEManager):
         """Initialize the main window."""
@@ -124,11 +157,32 @@ class MainWindow:
         self._ble_manager = ble_manager
         
         self._root = tk.Tk()
-        self._root.geometry("550x750")
+        self._root.geometry("550x860")
         self._root.resizable(True, True)
         
         self._devices: List = []
         self._loop: Optional[asyncio.AbstractEventLoop] = None
+        self._diagnostics = DiagnosticsMonitor()
+        # With a fusion method configured, actions follow the host decoder instead of the device's results
+        self._fusion = FusionEngine(config_manager)
+        # With a host model configured, a larger model on this PC also decides from the window stream
+        self._host_model = HostModel(config_manager)
+        # With publish_multicast / publish_websocket_port set, other applications receive every decided gesture
+        self._publisher = EventPublisher(config_manager)
+        self._publisher.start()
+        # With gesture_apps set, the device runs full-rate inference only behind those applications
+        gesture_apps, background_point = config_manager.get_foreground_gating()
+        policy = OperatingPointPolicy(gesture_apps, background_point)
+        self._foreground = OperatingPointPusher(policy, self._send_operating_point)
+        self._foreground_watcher = ForegroundWatcher(self._foreground.switched)
+        if policy.enabled and self._foreground_watcher.start():
+            print(f"[Foreground] Full-rate inference behind {', '.join(gesture_apps)}, {background_point} otherwise")
+        self._breakdown: Optional[LatencyBreakdown] = None
+        self._log_lines = RingBuffer(self.MAX_LOG_LINES)
+        self._statuses = RingBuffer(32)
+        self._found_devices = RingBuffer(64)
+        self._latest = LatestValues()
+        self._action_clear_at: Optional[float] = None
         
         # Language setting
         self._lang = LANG_EN
@@ -137,6 +191,8 @@ class MainWindow:
         self._setup_ui()
         self._setup_callbacks()
         self._update_language()
+        self._root.after(self.DIAGNOSTICS_REFRESH_MS, self._refresh_diagnostics)
+        self._root.after(self.UI_TICK_MS, self._tick)
     
     def _setup_ui(self) -> None:
         """Set up the user interface."""
@@ -202,10 +258,23 @@ class MainWindow:
         
         self._confidence_label = ttk.Label(self._gesture_frame, text="Confidence: --")
         self._confidence_label.pack()
+
+        self._latency_label = ttk.Label(self._gesture_frame, text="", foreground="gray", font=("Arial", 9))
+        self._latency_label.pack()
         
         self._action_label = ttk.Label(self._gesture_frame, text="", foreground="green", font=("Arial", 12))
         self._action_label.pack()
         
+        # === Diagnostics Section ===
+        self._diag_frame = ttk.LabelFrame(main_frame, text="Diagnostics", padding="5")
+        self._diag_frame.pack(fill=tk.X, pady=(0, 10))
+
+        self._diag_labels: Dict[str, ttk.Label] = {}
+        for key in ("diag_rates", "diag_delivery", "diag_host", "diag_e2e", "diag_device"):
+            label = ttk.Label(self._diag_frame, text="", foreground="gray", font=("Arial", 9))
+            label.pack(anchor=tk.W)
+            self._diag_labels[key] = label
+        
         # === Shortcut Mapping Section ===
         self._settings_frame = ttk.LabelFrame(main_frame, text="Gesture → Shortcut Mapping", padding="5")
         self._settings_frame.pack(fill=tk.X, pady=(0, 10))
@@ -218,6 +287,9 @@ class MainWindow:
         # Shortcut entries
         self._shortcut_vars = {}
         self._shortcut_labels = {}
+        self._repeat_vars: Dict[str, tk.BooleanVar] = {}
+        self._repeat_checks: Dict[str, ttk.Checkbutton] = {}
+        repeat_gestures = self._config.get_repeat_gestures()
         
         shortcuts = self._config.get_gesture_shortcuts()
         gesture_labels = {"left": "Left gesture:", "right": "Right gesture:", 
@@ -236,6 +308,12 @@ class MainWindow:
             
             entry = ttk.Entry(row, textvariable=var, width=25)
             entry.pack(side=tk.LEFT, padx=(5, 0))
+
+            repeat_var = tk.BooleanVar(value=gesture in repeat_gestures)
+            self._repeat_vars[gesture] = repeat_var
+            check = ttk.Checkbutton(row, text="Hold repeats", variable=repeat_var)
+            check.pack(side=tk.LEFT, padx=(5, 0))
+            self._repeat_checks[gesture] = check
         
         # Threshold slider
         threshold_frame = ttk.Frame(self._settings_frame)
@@ -312,6 +390,7 @@ class MainWindow:
         self._disconnect_btn.config(text=self._lang["disconnect"])
         
         self._gesture_frame.config(text=self._lang["current_gesture"])
+        self._diag_frame.config(text=self._lang["diagnostics"])
         
         self._settings_frame.config(text=self._lang["shortcut_mapping"])
         self._hint_label.config(text=self._lang["shortcut_hint"])
@@ -323,6 +402,7 @@ class MainWindow:
                         "up": self._lang["up"], "down": self._lang["down"]}
         for gesture in ["left", "right", "up", "down"]:
             self._shortcut_labels[gesture].config(text=gesture_labels[gesture])
+            self._repeat_checks[gesture].config(text=self._lang["repeat_hold"])
         
         self._log_frame.config(text=self._lang["log"])
     
@@ -330,29 +410,89 @@ class MainWindow:
         """Set up callbacks for BLE and gesture events."""
         self._ble_manager.set_status_callback(self._on_status_change)
         self._ble_manager.set_gesture_callback(self._on_gesture_received)
+        self._ble_manager.set_breakdown_callback(self._on_latency_breakdown)
+        self._ble_manager.set_counters_callback(self._on_counters)
+        self._ble_manager.set_cpu_callback(self._on_cpu)
+        self._ble_manager.set_hold_callback(self._on_hold)
+        self._ble_manager.set_crash_callback(self._on_crash)
+        self._fusion.set_gesture_callback(self._on_gesture_decided)
+        if self._fusion.enabled:
+            # The device streams score vectors only while asked to
+            self._ble_manager.set_scores_callback(self._on_scores)
+        if self._host_model.enabled:
+            self._ble_manager.set_window_callback(self._host_model.feed)
+            self._host_model.set_gesture_callback(self._on_gesture_decided)
+        self._ble_manager.set_keymap_provider(self._config.get_gesture_shortcuts)
+        self._ble_manager.set_layout_store(self._config.get_gatt_layout, self._config.set_gatt_layout)
         self._gesture_handler.set_action_callback(self._on_action_triggered)
     
     def _on_status_change(self, status: str) -> None:
-        """Handle BLE status change."""
-        self._root.after(0, lambda: self._update_status(status))
+        """Handle BLE status change (drawn at the next tick)."""
+        self._statuses.append(status)
+
+    def _tick(self) -> None:
+        """Draw what the other threads handed over since the last tick, in one pass."""
+        try:
+            statuses, _ = self._statuses.drain()
+            for status in statuses:
+                if status == "Connected":
+                    self._on_connected()
+                else:
+                    self._foreground.disconnected()
+                self.add_log_entry(f"{self._lang['status']} {self._display_status(status)}")
+            if statuses:
+                self._update_status(statuses[-1])
+            latest = self._latest.take()
+            if "gesture" in latest:
+                self._update_gesture(*latest["gesture"])
+            if "action" in latest:
+                self._show_action(*latest["action"])
+            elif self._action_clear_at is not None and time.monotonic() >= self._action_clear_at:
+                self._action_label.config(text="")
+                self._action_clear_at = None
+            self._show_found_devices()
+            lines, dropped = self._log_lines.drain()
+            if lines:
+                self._append_log(lines, dropped)
+        finally:
+            self._root.after(self.UI_TICK_MS, self._tick)
+
+    def _on_connected(self) -> None:
+        """New connection: restart the diagnostics and remember the device for the next Auto Connect."""
+        self._diagnostics.reset()
+        self._fusion.reset()
+        self._host_model.reset()
+        self._foreground.connected()
+        address = self._ble_manager.last_device_address()
+        if address and address != self._config.get_last_device_address():
+            self._config.set_last_device_address(address)
+            self._config.save()
+
+    def _display_status(self, status: str) -> str:
+        if status == "Connected":
+            return self._lang["connected"]
+        if "Scanning" in status or "Reconnecting" in status or "Connecting" in status:
+            return self._lang["scanning"] if "Scanning" in status else self._lang["connecting"]
+        return self._lang["disconnected"]
     
     def _update_status(self, status: str) -> None:
         """Update status label."""
+        display_status = self._display_status(status)
         if status == "Connected":
-            display_status = self._lang["connected"]
             self._status_label.config(foreground="green")
             self._connect_btn.config(state=tk.DISABLED)
             self._disconnect_btn.config(state=tk.NORMAL)
             self._scan_btn.config(state=tk.DISABLED)
             self._auto_connect_btn.config(state=tk.DISABLED)
         elif "Scanning" in status or "Reconnecting" in status or "Connecting" in status:
-            display_status = self._lang["scanning"] if "Scanning" in status else self._lang["connecting"]
             self._status_label.config(foreground="orange")
             self._scan_btn.config(state=tk.DISABLED)
             self._auto_connect_btn.config(state=tk.DISABLED)
             self._connect_btn.config(state=tk.DISABLED)
+            # A device listed by a running scan can be connected right away (the scan stops first)
+            if status == "Scanning...":
+                self._connect_btn.config(state=tk.NORMAL)
         else:
-            display_status = self._lang["disconnected"]
             self._status_label.config(foreground="red")
             self._connect_btn.config(state=tk.NORMAL)
             self._disconnect_btn.config(state=tk.DISABLED)
@@ -360,27 +500,103 @@ class MainWindow:
             self._auto_connect_btn.config(state=tk.NORMAL)
         
         self._status_label.config(text=display_status)
-        self.add_log_entry(f"{self._lang['status']} {display_status}")
     
     def _on_gesture_received(self, gesture: str, confidence: float) -> None:
-        """Handle gesture received from BLE."""
-        self._root.after(0, lambda: self._update_gesture(gesture, confidence))
-        self._gesture_handler.process_gesture(gesture, confidence)
+        """Handle gesture received from BLE (ignored while the fusion decoder decides)."""
+        self._host_model.note_device_gesture(gesture)
+        if not self._fusion.enabled:
+            self._on_gesture_decided(gesture, confidence)
+
+    def _on_scores(self, frame: ScoreFrame) -> None:
+        """Handle one inference's score vector: the fusion decoder calls back on a detection."""
+        self._fusion.feed(frame.probabilities, frame.sequence)
+
+    def _on_gesture_decided(self, gesture: str, confidence: float) -> None:
+        """Show and act on a gesture, from the device, the fusion decoder or the host model."""
+        # First: subscribers should not wait for the key injection
+        self._publisher.publish(gesture, confidence)
+        self._diagnostics.on_gesture()
+        self._latest.put("gesture", (gesture, confidence))
+        # In HID keyboard mode the device has already typed the shortcut
+        if not self._ble_manager.device_hid():
+            self._gesture_handler.process_gesture(gesture, confidence)
+    
+    def _on_hold(self, gesture: str, held: bool) -> None:
+        """Handle a gesture onset / release from the device: repeats run on the handler's timer thread."""
+        if held and self._ble_manager.device_hid():
+            return
+        self._gesture_handler.process_hold(gesture, held)
     
     def _update_gesture(self, gesture: str, confidence: float) -> None:
         """Update gesture display."""
         self._gesture_label.config(text=gesture.upper())
         self._confidence_label.config(text=f"{self._lang['confidence']} {confidence:.2%}")
     
+    def _on_latency_breakdown(self, breakdown: LatencyBreakdown) -> None:
+        """Handle the per-stage latency of the recent results (drawn at the next refresh)."""
+        self._breakdown = breakdown
+
+    def _on_counters(self, counters: DeliveryCounters) -> None:
+        """Handle the device's delivery counters (drawn at the next refresh)."""
+        self._diagnostics.set_counters(counters)
+
+    def _on_crash(self, report: CrashReport) -> None:
+        """Log the crash the device recorded before its last reset."""
+        self.add_log_entry(self._lang["device_crash"].format(report.kind, report.thread or "main/ISR",
+                                                            report.uptime_ms, report.pc))
+
+    def _on_cpu(self, cpu: CpuUtilization) -> None:
+        """Handle the device's CPU utilization (drawn at the next refresh)."""
+        self._diagnostics.set_cpu(cpu)
+
+    def _refresh_diagnostics(self) -> None:
+        """Redraw the diagnostics panel and the latency line from the values stored since the last refresh."""
+        try:
+            if self._ble_manager.is_connected():
+                self._show_diagnostics(self._diagnostics.snapshot(
+                    self._ble_manager.delivery_stats(), self._ble_manager.latency_breakdown(),
+                    self._ble_manager.end_to_end_latency(), self._gesture_handler.action_stats()))
+            breakdown, self._breakdown = self._breakdown, None
+            if breakdown is not None:
+                self._update_latency(breakdown)
+        finally:
+            self._root.after(self.DIAGNOSTICS_REFRESH_MS, self._refresh_diagnostics)
+
+    def _show_diagnostics(self, snapshot: DiagnosticsSnapshot) -> None:
+        """Update the diagnostics panel."""
+        def ms(value: Optional[float]) -> str:
+            return "--" if value is None else f"{value:.0f}"
+
+        loss = "--" if snapshot.loss is None else f"{snapshot.loss:.1%}"
+        e2e = snapshot.end_to_end_ms
+        counters = snapshot.counters
+        cpu = "--" if snapshot.cpu is None else f"{snapshot.cpu.active:.0%}"
+        texts = {
+            "diag_rates": (snapshot.gesture_rate, snapshot.notify_rate),
+            "diag_delivery": (snapshot.received, snapshot.missed, snapshot.recovered, snapshot.lost, loss),
+            "diag_host": (ms(snapshot.host_ms), ms(snapshot.inject_p50_ms), ms(snapshot.inject_p95_ms)),
+            "diag_e2e": (ms(e2e.get(0.5)), ms(e2e.get(0.95)), ms(e2e.get(0.99))),
+            "diag_device": ("--", "--", "--", cpu) if counters is None else
+                           (counters.published, counters.suppressed, counters.notify_failures, cpu),
+        }
+        for key, values in texts.items():
+            self._diag_labels[key].config(text=self._lang[key].format(*values))
+
+    def _update_latency(self, breakdown: LatencyBreakdown) -> None:
+        """Update the latency breakdown line."""
+        stages = (breakdown.sensor_ms, breakdown.device_ms, breakdown.radio_ms, breakdown.host_ms, breakdown.total_ms)
+        self._latency_label.config(text=self._lang["latency"].format(
+            *("--" if value is None else f"{value:.0f}" for value in stages)))
+
     def _on_action_triggered(self, gesture: str, shortcut: str) -> None:
-        """Handle action triggered by gesture."""
-        self._root.after(0, lambda: self._show_action(gesture, shortcut))
+        """Handle action triggered by gesture (runs on the key-injection thread; drawn at the next tick)."""
+        self.add_log_entry(f"'{gesture}' → [{shortcut}]")
+        self._latest.put("action", (gesture, shortcut))
     
     def _show_action(self, gesture: str, shortcut: str) -> None:
         """Show action feedback."""
         self._action_label.config(text=f"→ {shortcut.upper()}")
-        self.add_log_entry(f"'{gesture}' → [{shortcut}]")
-        self._root.after(1500, lambda: self._action_label.config(text=""))
+        self._action_clear_at = time.monotonic() + self.ACTION_FEEDBACK_S
     
     def _on_threshold_change(self, value: str) -> None:
         """Handle threshold slider change."""
@@ -402,22 +618,30 @@ class MainWindow:
         self._config.set_gesture_shortcuts(shortcuts)
         self._config.set_confidence_threshold(self._threshold_var.get())
         self._config.set_cooldown_time(self._cooldown_var.get())
+        for gesture, var in self._repeat_vars.items():
+            self._config.set_repeat_gesture(gesture, var.get())
         self._config.save()
         
         self._gesture_handler.set_cooldown_time(self._cooldown_var.get())
+        if self._loop and self._ble_manager.device_hid():
+            asyncio.run_coroutine_threadsafe(self._ble_manager.write_keymap(shortcuts), self._loop)
         
         self.add_log_entry(f"{self._lang['save_settings']}")
         messagebox.showinfo(self._lang["save_settings"], self._lang["settings_saved"])
     
     def _on_scan(self) -> None:
-        """Handle scan button click."""
+        """Handle scan button click: the list fills as devices advertise."""
         if self._loop:
             self.add_log_entry(self._lang["starting_scan"])
+            self._found_devices.drain()
+            self._devices = []
+            self._device_listbox.delete(0, tk.END)
             asyncio.run_coroutine_threadsafe(self._do_scan(), self._loop)
     
     async def _do_scan(self) -> None:
-        """Perform BLE scan."""
-        self._devices = await self._ble_manager.scan_devices(timeout=10.0)
+        """Perform BLE scan; each device goes to the list at the next tick, the last connected one ends the scan."""
+        await self._ble_manager.scan_devices(timeout=10.0, on_found=self._found_devices.append,
+                                             stop_at=self._config.get_last_device_address())
         self._root.after(0, self._update_device_list)
     
     def _on_auto_connect(self) -> None:
@@ -428,20 +652,25 @@ class MainWindow:
     
     async def _do_auto_connect(self) -> None:
         """Scan for target device and connect automatically."""
-        success = await self._ble_manager.scan_and_connect(timeout=15.0)
+        success = await self._ble_manager.scan_and_connect(timeout=15.0,
+                                                           known_address=self._config.get_last_device_address())
         if not success:
-            self._root.after(0, lambda: self.add_log_entry(self._lang["auto_connect_fail"]))
+            self.add_log_entry(self._lang["auto_connect_fail"])
     
+    def _show_found_devices(self) -> None:
+        """Append the devices a running scan reported since the last tick."""
+        devices, _ = self._found_devices.drain()
+        for device in devices:
+            self._devices.append(device)
+            self._device_listbox.insert(tk.END, f"{device.name} ({device.address})")
+
     def _update_device_list(self) -> None:
-        """Update device listbox."""
-        self._device_listbox.delete(0, tk.END)
-        
+        """Scan finished: the list already holds what it found."""
+        self._show_found_devices()
         if not self._devices:
             self._device_listbox.insert(tk.END, self._lang["no_devices"])
             self.add_log_entry(self._lang["scan_none"])
         else:
-            for device in self._devices:
-                self._device_listbox.insert(tk.END, f"{device.name} ({device.address})")
             self.add_log_entry(self._lang["scan_complete"].format(len(self._devices)))
     
     def _on_connect(self) -> None:
@@ -455,7 +684,12 @@ class MainWindow:
         if idx < len(self._devices):
             device = self._devices[idx]
             if self._loop:
-                asyncio.run_coroutine_threadsafe(self._ble_manager.connect(device.address), self._loop)
+                asyncio.run_coroutine_threadsafe(self._do_connect(device.address), self._loop)
+
+    async def _do_connect(self, address: str) -> None:
+        """Connect to a listed device, ending the scan that listed it first."""
+        await self._ble_manager.stop_scan()
+        await self._ble_manager.connect(address)
     
     def _on_disconnect(self) -> None:
         """Handle disconnect button click."""
@@ -463,15 +697,27 @@ class MainWindow:
             asyncio.run_coroutine_threadsafe(self._ble_manager.disconnect(), self._loop)
     
     def add_log_entry(self, message: str) -> None:
-        """Add an entry to the log."""
+        """Add an entry to the log (any thread; written to the widget at the next tick)."""
         timestamp = datetime.now().strftime("%H:%M:%S")
-        entry = f"[{timestamp}] {message}\n"
-        
+        self._log_lines.append(f"[{timestamp}] {message}\n")
+
+    def _append_log(self, lines: List[str], dropped: int) -> None:
+        """Write a tick's log lines in one insert and keep the widget to MAX_LOG_LINES."""
+        if dropped:
+            lines.insert(0, f"[{datetime.now().strftime('%H:%M:%S')}] ... {dropped} log lines dropped\n")
         self._log_text.config(state=tk.NORMAL)
-        self._log_text.insert(tk.END, entry)
+        self._log_text.insert(tk.END, "".join(lines))
+        excess = int(self._log_text.index("end-1c").split(".")[0]) - 1 - self.MAX_LOG_LINES
+        if excess > 0:
+            self._log_text.delete("1.0", f"{excess + 1}.0")
         self._log_text.see(tk.END)
         self._log_text.config(state=tk.DISABLED)
     
+    def _send_operating_point(self, point: str) -> None:
+        """Ask the device for a power point (watcher or GUI thread; the write runs on the asyncio loop)."""
+        if self._loop:
+            asyncio.run_coroutine_threadsafe(self._ble_manager.set_operating_point(point), self._loop)
+
     def set_event_loop(self, loop: asyncio.AbstractEventLoop) -> None:
         """Set the asyncio event loop for async operations."""
         self._loop = loop
@@ -479,6 +725,9 @@ class MainWindow:
     def run(self) -> None:
         """Start the main window event loop."""
         self._root.mainloop()
+        self._host_model.close()
+        self._publisher.close()
+        self._foreground_watcher.close()
     
     def get_root(self) -> tk.Tk:
         """Get the root Tk instance."""
@@ -0,0 +1,275 @@
+"""
+Host Model
+
+Hybrid edge / host inference: while a board is connected, a larger model than the
+firmware's (e.g. a CNN + GRU over 2 s of 6-axis data, exported to .tflite) runs on
+the PC next to the on-device one. The firmware keeps making the latency-critical
+decisions itself; the host model sees the same samples through the window stream
+(BLEManager.set_window_callback: the model input samples, delta-compressed as in
+include/record_format.h) and catches what needs more context or more capacity.
+
+WindowAssembler rebuilds each device's sliding window from the stream. HostModel
+gathers the windows due on all devices since the previous batch and sends them to
+the C++ runtime (src/host/host_model_main.cpp, `pio run -e host_model`) in one
+request; the runtime runs the model with the SDK's TFLM interpreter, filling the
+model's batch dimension on every Invoke. Whatever arrives while a batch runs goes
+into the next one, so the batch grows with the number of devices instead of the
+latency.
+
+Detections are decided per device like fusion.py does (threshold per gesture,
+re-armed once every gesture has dropped) and go to the same callback as the
+device's results. A host detection of a gesture the device reported within the
+last DEVICE_OVERLAP_S is dropped, so a gesture both models see acts once, at the
+device's latency.
+
+Config (config.json): "host_model_path" (.tflite, "" = off) and "host_model_labels"
+(class names in output order; empty: the deployed model's labels). "host_model_path":
+"builtin" runs the deployed impulse instead (DSP + compiled model, spread over all
+cores by src/host/batch_classifier.cpp), e.g. to score many devices' windows at once.
+"""
+
+import os
+import subprocess
+import threading
+import time
+from collections import deque
+from dataclasses import dataclass
+from typing import Callable, Deque, Dict, List, Optional, Sequence, Tuple
+
+from config_manager import ConfigManager
+from gesture_labels import GESTURE_LABELS, MODEL_LABELS
+from raw_recorder import ACC_LSB_PER_G, GYR_LSB_PER_DPS, RawPacket
+
+DEFAULT_PROGRAM = os.path.join(os.path.dirname(os.path.dirname(os.path.abspath(__file__))),
+                               ".pio", "build", "host_model", "program")
+
+# Window channel bits (RECORD_CHANNEL_ACC / RECORD_CHANNEL_GYR in include/record_format.h)
+ACC_CHANNELS = 0x07
+
+# host_model_path selecting the deployed impulse (the runtime's --builtin mode)
+BUILTIN_MODEL = "builtin"
+
+
+def channel_scales(channel_mask: int) -> List[float]:
+    """Sensor LSB to model units (g, deg/s) for the channels of a window packet, in stream order."""
+    return [1.0 / (ACC_LSB_PER_G if (1 << bit) & ACC_CHANNELS else GYR_LSB_PER_DPS)
+            for bit in range(8) if channel_mask & (1 << bit)]
+
+
+class WindowAssembler:
+    """Sliding window of one device's window stream: a window every hop frames once frames are in.
+
+    The stream's timestamps are sample indices; a jump (frames the device's queue dropped,
+    a reconnect) starts the window over, so no window spans a gap.
+    """
+
+    def __init__(self, frames: int, hop: int):
+        self.frames = frames
+        self.hop = hop
+        self._window: Deque[List[int]] = deque(maxlen=frames)
+        self._next_index: Optional[int] = None
+        self._since_window = 0
+
+    def feed(self, packet: RawPacket) -> List[Tuple[int, List[int]]]:
+        """Windows completed by this packet: (sample index of the newest frame, frames x channels values)."""
+        windows = []
+        for index, frame in zip(packet.timestamps_us, packet.frames):
+            if self._next_index is not None and index != self._next_index:
+                self._window.clear()
+                self._since_window = 0
+            self._next_index = index + 1
+            self._window.append(frame)
+            self._since_window += 1
+            if len(self._window) == self.frames and self._since_window >= self.hop:
+                self._since_window = 0
+                windows.append((index, [value for row in self._window for value in row]))
+        return windows
+
+
+class HostModelRuntime:
+    """The C++ runtime as a child process: one request per batch over its stdin / stdout (protocol in its header)."""
+
+    def __init__(self, model_path: str, scales: Sequence[float], program: str = DEFAULT_PROGRAM):
+        model = "--builtin" if model_path == BUILTIN_MODEL else model_path
+        self._process = subprocess.Popen(
+            [program, model, "--channels", str(len(scales)), "--scale", ",".join(f"{s:.9g}" for s in scales)],
+            stdin=subprocess.PIPE, stdout=subprocess.PIPE, text=True, bufsize=1)
+        fields = self._process.stdout.readline().strip().split(",")
+        if len(fields) != 4 or fields[0] != "ready":
+            self.close()
+            raise RuntimeError(f"host model runtime did not start ({program})")
+        self.batch, self.values, self.classes = (int(field) for field in fields[1:])
+
+    def run(self, windows: Sequence[Tuple[str, int, List[int]]]) -> List[Tuple[str, int, List[float]]]:
+        """Scores of each (stream, tag, values) window, in order."""
+        lines = [f"window,{stream},{tag},{encode_values(values)}\n" for stream, tag, values in windows]
+        self._process.stdin.write("".join(lines) + "run\n")
+        self._process.stdin.flush()
+        results = []
+        for line in self._process.stdout:
+            fields = line.strip().split(",")
+            if fields[0] == "done":
+                return results
+            if fields[0] == "result" and len(fields) == 3 + self.classes:
+                results.append((fields[1], int(fields[2]), [float(field) for field in fields[3:]]))
+        raise RuntimeError("host model runtime exited")
+
+    def close(self) -> None:
+        if self._process.stdin:
+            self._process.stdin.close()
+        self._process.wait(timeout=5)
+
+
+def encode_values(values: Sequence[int]) -> str:
+    """int16 samples as the runtime reads them: 4 hex digits each, low byte first."""
+    return b"".join((v & 0xFFFF).to_bytes(2, "little") for v in values).hex()
+
+
+@dataclass
+class _Stream:
+    assembler: Optional[WindowAssembler] = None
+    armed: bool = True
+
+
+class HostModel:
+    """Windows of all connected devices through one host model runtime, decided into gestures."""
+
+    # A window every 12 samples (a quarter second at the model rate of 48 Hz)
+    HOP_FRAMES = 12
+    # A gesture re-arms once every gesture class is below this fraction of its threshold
+    RELEASE_FRACTION = 0.6
+    # A host detection repeating the device's gesture from this recently is dropped (one window)
+    DEVICE_OVERLAP_S = 2.0
+
+    def __init__(self, config_manager: ConfigManager,
+                 runtime_factory: Optional[Callable[[str, List[float]], HostModelRuntime]] = None):
+        self._config = config_manager
+        self._path, labels = config_manager.get_host_model()
+        self._labels = tuple(labels) or MODEL_LABELS
+        self._runtime_factory = runtime_factory or HostModelRuntime
+        self._runtime: Optional[HostModelRuntime] = None
+        self._failed = False
+        self._streams: Dict[str, _Stream] = {}
+        self._device_gestures: Dict[Tuple[str, str], float] = {}
+        self._callback: Optional[Callable[[str, float], None]] = None
+        self._condition = threading.Condition()
+        self._packets: List[Tuple[str, RawPacket]] = []
+        self._worker: Optional[threading.Thread] = None
+        self._closing = False
+        self.batches = 0
+        self.windows = 0
+
+    @property
+    def enabled(self) -> bool:
+        return bool(self._path) and not self._failed
+
+    def set_gesture_callback(self, callback: Callable[[str, float], None]) -> None:
+        """Set callback for the host model's detections. Signature: callback(gesture, confidence)"""
+        self._callback = callback
+
+    def feed(self, packet: RawPacket, stream: str = "") -> None:
+        """Queue one window stream packet (transport thread); the worker thread runs the model."""
+        if not self.enabled:
+            return
+        with self._condition:
+            self._packets.append((stream, packet))
+            if self._worker is None:
+                self._worker = threading.Thread(target=self._run, daemon=True)
+                self._worker.start()
+            self._condition.notify()
+
+    def note_device_gesture(self, gesture: str, stream: str = "") -> None:
+        """The device reported gesture: the host model does not act on it again for a while."""
+        self._device_gestures[(stream, gesture)] = time.monotonic()
+
+    def reset(self, stream: Optional[str] = None) -> None:
+        """Forget the windows of one stream (None: all of them), e.g. after a reconnect."""
+        with self._condition:
+            if stream is None:
+                self._streams = {}
+                self._packets = []
+            else:
+                self._streams.pop(stream, None)
+
+    def close(self) -> None:
+        with self._condition:
+            self._closing = True
+            self._condition.notify()
+        if self._worker is not None:
+            self._worker.join(timeout=5)
+        if self._runtime is not None:
+            self._runtime.close()
+            self._runtime = None
+
+    def _run(self) -> None:
+        while True:
+            with self._condition:
+                while not self._packets and not self._closing:
+                    self._condition.wait()
+                if self._closing:
+                    return
+            try:
+                self.process_pending()
+            except (OSError, RuntimeError) as e:
+                print(f"[HostModel] {e}; host inference off")
+                self._failed = True
+                return
+
+    def process_pending(self) -> List[Tuple[str, float]]:
+        """Run every window due in the queued packets as one batch; returns the detections."""
+        with self._condition:
+            packets, self._packets = self._packets, []
+        windows = []
+        for stream, packet in packets:
+            state = self._streams.setdefault(stream, _Stream())
+            if state.assembler is None:
+                if not self._start(packet.channel_mask):
+                    return []
+                state.assembler = WindowAssembler(self._runtime.values // len(channel_scales(packet.channel_mask)),
+                                                  self.HOP_FRAMES)
+            windows.extend((stream, tag, values) for tag, values in state.assembler.feed(packet))
+        if not windows:
+            return []
+        self.batches += 1
+        self.windows += len(windows)
+        detections = []
+        for stream, _, scores in self._runtime.run(windows):
+            detection = self._decide(stream, scores)
+            if detection is not None:
+                detections.append(detection)
+                if self._callback:
+                    self._callback(*detection)
+        return detections
+
+    def _start(self, channel_mask: int) -> bool:
+        if self._runtime is not None:
+            return True
+        scales = channel_scales(channel_mask)
+        if not scales:
+            return False
+        self._runtime = self._runtime_factory(self._path, scales)
+        if self._runtime.classes != len(self._labels) or self._runtime.values % len(scales) != 0:
+            raise RuntimeError(f"model has {self._runtime.classes} classes and {self._runtime.values} inputs, "
+                               f"expected {len(self._labels)} classes over {len(scales)} channels")
+        print(f"[HostModel] {self._path}: batch {self._runtime.batch}, "
+              f"{self._runtime.values // len(scales)} frames x {len(scales)} channels")
+        return True
+
+    def _decide(self, stream: str, scores: Sequence[float]) -> Optional[Tuple[str, float]]:
+        snapshot = self._config.snapshot()
+        thresholds = [snapshot.fusion_thresholds.get(label, snapshot.confidence_threshold) for label in self._labels]
+        gestures = [i for i, label in enumerate(self._labels) if label in GESTURE_LABELS]
+        state = self._streams[stream]
+        if not state.armed:
+            if all(scores[i] < thresholds[i] * self.RELEASE_FRACTION for i in gestures):
+                state.armed = True
+            return None
+        best = max(gestures, key=lambda i: scores[i], default=None)
+        if best is None or scores[best] < thresholds[best]:
+            return None
+        state.armed = False
+        gesture = self._labels[best]
+        reported = self._device_gestures.get((stream, gesture))
+        if reported is not None and time.monotonic() - reported < self.DEVICE_OVERLAP_S:
+            return None
+        return gesture, scores[best]
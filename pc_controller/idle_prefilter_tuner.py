@@ -0,0 +1,160 @@
+"""
+Idle Pre-filter Tuner
+
+Calibrates the firmware's cascaded idle pre-filter (see include/idle_prefilter.h)
+against a labelled dataset recorded with raw_recorder.py. Windows are cut the way
+the firmware sees them (resampled to the model rate, one window per inference
+stride) and scored with the same statistic: the largest per-axis population
+standard deviation of the acceleration inside the window.
+
+The threshold is chosen so that at most --miss-rate of the gesture windows would
+be mistaken for idle, then shrunk by --margin; the report shows how many idle
+windows the pre-filter would then skip.
+
+Files are labelled by their name prefix, the Edge Impulse convention
+(e.g. "idle.01.csv", "left.wave3.csv").
+
+Usage:
+    python idle_prefilter_tuner.py data/*.csv
+    python idle_prefilter_tuner.py --quantize-scale 0.031373 --miss-rate 0.001 data/*.csv
+"""
+
+import argparse
+import math
+import os
+import sys
+from typing import Dict, List, Optional, Sequence, Tuple
+
+# Must match the deployed model (48 Hz, 72 values = 24 frames x 3 axes, 2-sample fine stride)
+MODEL_HZ = 48.0
+WINDOW_FRAMES = 24
+STRIDE_FRAMES = 2
+ACC_COLUMNS = ["accX", "accY", "accZ"]
+IDLE_LABEL = "idle"
+
+
+def label_from_path(path: str) -> str:
+    return os.path.basename(path).split(".", 1)[0]
+
+
+def load_csv(path: str) -> Tuple[List[float], List[List[float]]]:
+    """Edge Impulse CSV written by raw_recorder.py: timestamp (ms) plus one column per axis."""
+    with open(path, "r", encoding="utf-8") as f:
+        header = f.readline().strip().split(",")
+        try:
+            columns = [header.index(name) for name in ACC_COLUMNS]
+        except ValueError:
+            raise ValueError(f"{path}: missing accelerometer columns {ACC_COLUMNS}")
+        timestamps: List[float] = []
+        frames: List[List[float]] = []
+        for line in f:
+            fields = line.strip().split(",")
+            if len(fields) < len(header):
+                continue
+            timestamps.append(float(fields[0]))
+            frames.append([float(fields[c]) for c in columns])
+    return timestamps, frames
+
+
+def resample(timestamps_ms: Sequence[float], frames: Sequence[Sequence[float]],
+             rate_hz: float = MODEL_HZ) -> List[List[float]]:
+    """Box-average the recording into consecutive output periods (approximates FIR decimation)."""
+    if not frames:
+        return []
+    period_ms = 1000.0 / rate_hz
+    start = timestamps_ms[0]
+    out: List[List[float]] = []
+    acc = [0.0] * len(frames[0])
+    count = 0
+    bucket = 0
+    for ts, frame in zip(timestamps_ms, frames):
+        index = int((ts - start) // period_ms)
+        if index != bucket and count:
+            out.append([v / count for v in acc])
+            acc = [0.0] * len(frame)
+            count = 0
+        bucket = index
+        for a, v in enumerate(frame):
+            acc[a] += v
+        count += 1
+    if count:
+        out.append([v / count for v in acc])
+    return out
+
+
+def quantize(value: float, scale: float, zero_point: int = -1) -> float:
+    """Round-trip through the model's int8 input format, like the INFERENCE_INT8_WINDOW window."""
+    q = max(-128, min(127, int(round(value / scale)) + zero_point))
+    return (q - zero_point) * scale
+
+
+def window_std(window: Sequence[Sequence[float]]) -> float:
+    """Largest per-axis population standard deviation (IdlePrefilter::check)."""
+    n = len(window)
+    worst = 0.0
+    for a in range(len(window[0])):
+        mean = sum(frame[a] for frame in window) / n
+        variance = sum((frame[a] - mean) ** 2 for frame in window) / n
+        worst = max(worst, variance)
+    return math.sqrt(worst)
+
+
+def window_features(frames: Sequence[Sequence[float]], window: int = WINDOW_FRAMES,
+                    stride: int = STRIDE_FRAMES, quantize_scale: float = 0.0) -> List[float]:
+    if quantize_scale > 0.0:
+        frames = [[quantize(v, quantize_scale) for v in frame] for frame in frames]
+    return [window_std(frames[i:i + window]) for i in range(0, len(frames) - window + 1, stride)]
+
+
+def quantile(values: Sequence[float], q: float) -> float:
+    """Lower empirical quantile: at most a fraction q of values lie strictly below the result."""
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(math.floor(q * len(ordered))))]
+
+
+def choose_threshold(idle: Sequence[float], gestures: Sequence[float],
+                     miss_rate: float = 0.0, margin: float = 0.8) -> float:
+    if not gestures:
+        raise ValueError("need at least one gesture window to bound the threshold")
+    return quantile(gestures, miss_rate) * margin
+
+
+def evaluate(threshold: float, idle: Sequence[float], gestures: Sequence[float]) -> Dict[str, float]:
+    """Fractions flagged as idle; the firmware skips a window when its std <= threshold."""
+    def rate(values):
+        return sum(1 for v in values if v <= threshold) / len(values) if values else 0.0
+    return {"idle_skipped": rate(idle), "gesture_missed": rate(gestures)}
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    parser = argparse.ArgumentParser(description="Tune the firmware idle pre-filter threshold")
+    parser.add_argument("files", nargs="+", help="labelled Edge Impulse CSV recordings")
+    parser.add_argument("--miss-rate", type=float, default=0.0,
+                        help="tolerated fraction of gesture windows classified as idle")
+    parser.add_argument("--margin", type=float, default=0.8, help="safety factor applied to the threshold")
+    parser.add_argument("--quantize-scale", type=float, default=0.0,
+                        help="simulate the int8 window with this input scale (INFERENCE_INT8_WINDOW=1)")
+    args = parser.parse_args(argv)
+
+    idle: List[float] = []
+    gestures: List[float] = []
+    for path in args.files:
+        timestamps, frames = load_csv(path)
+        features = window_features(resample(timestamps, frames), quantize_scale=args.quantize_scale)
+        (idle if label_from_path(path) == IDLE_LABEL else gestures).extend(features)
+
+    print(f"[Tuner] {len(idle)} idle windows, {len(gestures)} gesture windows")
+    if not idle or not gestures:
+        print("[Tuner] Need both idle and gesture recordings")
+        return 1
+
+    threshold = choose_threshold(idle, gestures, args.miss_rate, args.margin)
+    result = evaluate(threshold, idle, gestures)
+    print(f"[Tuner] Threshold {threshold:.5f} g: {result['idle_skipped'] * 100:.1f}% of idle windows skipped, "
+          f"{result['gesture_missed'] * 100:.2f}% of gesture windows missed")
+    print(f"[Tuner] build_flags: -DINFERENCE_IDLE_PREFILTER_MAX_STD_G={threshold:.5f}f")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
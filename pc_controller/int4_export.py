@@ -0,0 +1,230 @@
+"""
+Int4 Export - pack the model's weights into 4 bits for MODEL_INT4_WEIGHTS
+
+The second convolution (10 x 8 weights) and the fully connected layer (5 x 360)
+hold almost all of the model's weight bytes. This tool requantizes both to
+signed 4 bits and writes them packed two per byte (kTfLiteInt4, element 2i in
+the low nibble of byte i, as TFLite packs them), so the weights take half the
+flash. The first convolution stays int8: its 3 weights per channel would let a
+byte straddle two channels, and it is only 24 bytes.
+
+Each layer gets one new per-tensor scale: the clipping range that minimizes the
+squared error against the int8 weights (a few candidates below max |w|), values
+in [-7, 7] so the zero point stays 0. The biases are requantized to the new
+input x filter scale. No fine-tuning: given recordings, the tool replays them
+(host_replay --pooled) and reports how often the 4-bit graph still picks the
+int8 graph's class.
+
+The result is the compiled model source with those tensors rewritten: copy it
+over lib/a5-deminsion_inferencing/src/tflite-model/ and build with the flags it
+prints. The specialized streaming kernels then unpack the nibbles inside their
+inner loop. Without MODEL_INT4_WEIGHTS the firmware still runs the model: the
+streaming path refuses the int4 tensors and the full graph's TFLM kernels unpack
+them into a scratch buffer (about 1.8 KB more RAM, taken from the heap when the
+arena is too small). model_ota.py sends int4 weights to firmware built from an
+int4 model; an int8 firmware rejects them (the graph signature differs).
+
+Usage:
+    python int4_export.py
+    python int4_export.py --build data/*.csv       # also measure agreement on recordings
+    python int4_export.py --output int4.cpp
+"""
+
+import argparse
+import os
+import re
+import sys
+from concurrent.futures import ThreadPoolExecutor
+from dataclasses import replace
+from typing import List, Optional, Sequence, Tuple
+
+from model_ota import (CONV1_OUTPUT, CONV2_BIAS, CONV2_FILTER, CONV2_OUTPUT, DEPLOYED_MODEL, FC_BIAS, FC_WEIGHTS,
+                       CompiledModel, float32, load_compiled_model, pack_int4, reference_fc, reference_features,
+                       reference_logits, self_test_window)
+from replay_runner import DEFAULT_BINARY, build, replay_file
+
+# (filter, bias, layer input) of the layers that are packed
+PACKED_LAYERS = ((CONV2_FILTER, CONV2_BIAS, CONV1_OUTPUT), (FC_WEIGHTS, FC_BIAS, CONV2_OUTPUT))
+INT4_MAX = 7
+# Clipping candidates as fractions of max |w|
+CLIP_FRACTIONS = tuple(1.0 - 0.05 * i for i in range(9))
+# Pooled columns of every classified window (same build as early_exit_trainer.py)
+BUILD_FLAGS = ("-DINFERENCE_INT8_WINDOW=1 -DINFERENCE_IDLE_PREFILTER=0 -DMODEL_EARLY_EXIT=1 "
+               "-DMODEL_EARLY_EXIT_THRESHOLD=2.0f")
+FIRMWARE_FLAGS = "-DINFERENCE_INT8_WINDOW=1 -DMODEL_SPECIALIZED_KERNELS=1 -DMODEL_INT4_WEIGHTS=1"
+DEFAULT_OUTPUT = "tflite_learn_792000_36_compiled.cpp"
+RANDOM_WINDOWS = 64
+
+
+def quantize_int4(weights: Sequence[int], scale: float, new_scale: float) -> List[int]:
+    """int8 weights at scale -> 4-bit values at new_scale, clamped to [-7, 7]."""
+    ratio = scale / new_scale
+    return [max(-INT4_MAX, min(INT4_MAX, int(round(w * ratio)))) for w in weights]
+
+
+def choose_scale(weights: Sequence[int], scale: float) -> float:
+    """float32 scale of the clipping range with the smallest squared error against the int8 weights."""
+    peak = max(abs(w) for w in weights)
+    if peak == 0:
+        return scale
+    best = None
+    for fraction in CLIP_FRACTIONS:
+        new_scale = float32(peak * fraction * scale / INT4_MAX)
+        values = quantize_int4(weights, scale, new_scale)
+        error = sum((w * scale - v * new_scale) ** 2 for w, v in zip(weights, values))
+        if best is None or error < best[0]:
+            best = (error, new_scale)
+    return best[1]
+
+
+def to_int4(model: CompiledModel) -> CompiledModel:
+    """The model with PACKED_LAYERS' filters in 4 bits and their biases at the matching scale."""
+    tensors = list(model.tensors)
+    for filter_index, bias_index, input_index in PACKED_LAYERS:
+        weights, bias = tensors[filter_index], tensors[bias_index]
+        if weights.type != "Int8" or len(weights.data) % (2 * weights.dims[0]):
+            raise ValueError(f"tensor {filter_index} is not an int8 filter with an even row length")
+        new_scale = choose_scale(weights.data, weights.scale)
+        bias_scale = float32(tensors[input_index].scale * new_scale)
+        tensors[filter_index] = replace(weights, type="Int4", bytes=len(weights.data) // 2, scale=new_scale,
+                                        data=quantize_int4(weights.data, weights.scale, new_scale))
+        tensors[bias_index] = replace(bias, scale=bias_scale,
+                                      data=[int(round(b * bias.scale / bias_scale)) for b in bias.data])
+    return CompiledModel(tensors, model.structure)
+
+
+def _tensor_entry(text: str, index: int) -> Tuple[str, str, int, int, int]:
+    """(entry text, type, tensor_data id, bytes, quant id) of a constant tensor in the tensorData table."""
+    table = re.search(r'TensorInfo_t tensorData\[\] = \{', text)
+    if not table:
+        raise ValueError("tensorData table not found (not an EON compiled model?)")
+    entries = list(re.finditer(r'\{ kTfLite(?:ArenaRw|MmapRo), kTfLite(\w+), \(int32_t\*\)(?:g0::tensor_data(\d+)|'
+                               r'\(tensor_arena \+ \d+\)), \(TfLiteIntArray\*\)&g0::tensor_dimension\d+, (\d+), '
+                               r'\{kTfLite(?:AffineQuantization|NoQuantization), (?:nullptr|[^}]*&g0::quant(\d+)\)+)\}',
+                               text[table.end():]))
+    if index >= len(entries) or entries[index].group(2) is None or entries[index].group(4) is None:
+        raise ValueError(f"tensor {index} is not a quantized constant")
+    m = entries[index]
+    return m.group(0), m.group(1), int(m.group(2)), int(m.group(3)), int(m.group(4))
+
+
+def _scale_array(text: str, quant_id: int) -> int:
+    m = re.search(r'TfLiteAffineQuantization quant%d = \{ \(TfLiteFloatArray\*\)&(?:g0::)?quant(\d+)_scale'
+                  % quant_id, text)
+    if not m:
+        raise ValueError(f"quant{quant_id} not found")
+    scale_id = int(m.group(1))
+    if len(re.findall(r'\(TfLiteFloatArray\*\)&(?:g0::)?quant%d_scale\b' % scale_id, text)) != 1:
+        raise ValueError(f"quant{scale_id}_scale is shared with another tensor")
+    return scale_id
+
+
+def _rows(values: Sequence[int], per_line: int) -> str:
+    return " \n" + "".join("  " + "".join(f"{v}, " for v in values[i:i + per_line]) + "\n"
+                           for i in range(0, len(values), per_line))
+
+
+def rewrite_model(text: str, model: CompiledModel) -> str:
+    """Write the filters, biases and scales of PACKED_LAYERS of model into a compiled model source."""
+    for filter_index, bias_index, _ in PACKED_LAYERS:
+        for index in (filter_index, bias_index):
+            tensor = model.tensors[index]
+            entry, tensor_type, data_id, size, quant_id = _tensor_entry(text, index)
+            if tensor.type == "Int4":
+                packed = pack_int4(tensor.data)
+                array = re.compile(r'int8_t tensor_data%d\[[^\]]*\] = \{.*?\};' % data_id, re.S)
+                if not array.search(text):
+                    raise ValueError(f"tensor_data{data_id} not found in the compiled model")
+                rows = _rows(packed, len(packed) // tensor.dims[0])
+                text = array.sub(lambda _: f"int8_t tensor_data{data_id}[{len(packed)}] = {{{rows}}};", text, count=1)
+                text = text.replace(entry, entry.replace(f"kTfLite{tensor_type}, ", "kTfLiteInt4, ", 1)
+                                    .replace(f", {size}, ", f", {len(packed)}, ", 1), 1)
+            else:
+                array = re.compile(r'(int32_t tensor_data%d\[[^\]]*\] = \{)(.*?)(\};)' % data_id, re.S)
+                if not array.search(text):
+                    raise ValueError(f"tensor_data{data_id} not found in the compiled model")
+                values = "".join(f"{v}, " for v in tensor.data)
+                text = array.sub(lambda m: m.group(1) + " " + values + m.group(3), text, count=1)
+            scale_id = _scale_array(text, quant_id)
+            text = re.sub(r'(quant%d_scale = \{ 1, \{ )[-+0-9.eE]+(,? \} \};)' % scale_id,
+                          lambda m: m.group(1) + repr(tensor.scale) + m.group(2), text, count=1)
+    return text
+
+
+def weight_bytes(model: CompiledModel) -> int:
+    return sum(model.tensors[f].bytes for f, _, _ in PACKED_LAYERS)
+
+
+def agreement(model: CompiledModel, logits: Sequence[Sequence[int]],
+              pooled: Sequence[Sequence[Sequence[int]]]) -> float:
+    """Fraction of windows (pooling outputs) whose top class with model matches the int8 graph's logits."""
+    if not pooled:
+        return 1.0
+    same = 0
+    for expected, columns in zip(logits, pooled):
+        out = reference_fc(model, reference_features(model, columns))
+        same += expected.index(max(expected)) == out.index(max(out))
+    return same / len(pooled)
+
+
+def _columns(pooled: Sequence[int], channels: int) -> List[List[int]]:
+    return [list(pooled[i:i + channels]) for i in range(0, len(pooled), channels)]
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    parser = argparse.ArgumentParser(description="Pack the conv2 and FC weights into 4 bits for MODEL_INT4_WEIGHTS")
+    parser.add_argument("files", nargs="*", help="Edge Impulse CSV recordings to measure agreement on")
+    parser.add_argument("--model", default=DEPLOYED_MODEL, help="EON compiled model with int8 weights")
+    parser.add_argument("--binary", default=DEFAULT_BINARY, help="host_replay program")
+    parser.add_argument("--build", action="store_true", help=f"rebuild host_replay with {BUILD_FLAGS}")
+    parser.add_argument("--jobs", type=int, default=os.cpu_count() or 1, help="parallel replay processes")
+    parser.add_argument("--output", default=DEFAULT_OUTPUT, help="compiled model source with 4-bit weights")
+    args = parser.parse_args(argv)
+
+    try:
+        with open(args.model, encoding="utf-8") as f:
+            text = f.read()
+        model = load_compiled_model(args.model)
+        packed = to_int4(model)
+        rewritten = rewrite_model(text, packed)
+    except (OSError, ValueError) as e:
+        print(f"[Int4] {e}")
+        return 1
+
+    for filter_index, _, _ in PACKED_LAYERS:
+        before, after = model.tensors[filter_index], packed.tensors[filter_index]
+        print(f"[Int4] Tensor {filter_index}: {before.bytes} -> {after.bytes} bytes, "
+              f"scale {before.scale:.6g} -> {after.scale:.6g}")
+    print(f"[Int4] Weights: {weight_bytes(model)} -> {weight_bytes(packed)} bytes of flash")
+
+    windows = [self_test_window(model.tensors[0].bytes, seed) for seed in range(1, RANDOM_WINDOWS + 1)]
+    same = sum(a.index(max(a)) == b.index(max(b))
+               for a, b in ((reference_logits(model, w), reference_logits(packed, w)) for w in windows))
+    print(f"[Int4] Agreement on {RANDOM_WINDOWS} random windows: {100.0 * same / RANDOM_WINDOWS:.1f}%")
+
+    if args.files:
+        if args.build:
+            build(BUILD_FLAGS)
+        if not os.path.exists(args.binary):
+            print(f"[Int4] {args.binary} not found, build it with --build")
+            return 1
+        with ThreadPoolExecutor(max_workers=max(1, args.jobs)) as pool:
+            results = list(pool.map(lambda path: replay_file(args.binary, path, pooled=True), args.files))
+        channels = model.tensors[CONV2_FILTER].dims[-1]
+        pooled = [_columns(p, channels) for result in results for _, p in result.pooled]
+        if not pooled:
+            print("[Int4] No pooling outputs dumped (was host_replay built with MODEL_EARLY_EXIT?)")
+            return 1
+        logits = [reference_fc(model, reference_features(model, columns)) for columns in pooled]
+        print(f"[Int4] Agreement on {len(pooled)} recorded windows: "
+              f"{100.0 * agreement(packed, logits, pooled):.1f}%")
+
+    with open(args.output, "w", encoding="utf-8") as f:
+        f.write(rewritten)
+    print(f"[Int4] 4-bit model written to {args.output}")
+    print(f"[Int4] build_flags: {FIRMWARE_FLAGS}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
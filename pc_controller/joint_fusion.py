@@ -0,0 +1,201 @@
+"""
+Joint Fusion
+
+Multi-device gestures on the host: the result events of several boards
+(MultiDeviceManager.set_event_callback, publish times on the synced host clock)
+are lined up in time, and a joint pattern fires when each of its gestures comes
+from a different board within the coincidence window - both wrists "out" at
+the same moment means zoom.
+
+    fusion = JointFusion({"zoom": ("out", "out")}, window_s=0.15)
+    fusion.set_gesture_callback(gesture_handler.process_gesture)
+    fusion.start()
+    manager.set_event_callback(fusion.feed)      # (address, gesture, confidence, time_s)
+
+Gestures that are part of no pattern pass straight through. The others wait in
+a bounded reorder buffer, ordered by publish time, for a partner: a pattern
+fires as soon as its last part arrives (the match looks only at the held
+events of the gestures in that pattern, at most one per board, so the work per
+event does not grow with the traffic), and a part that finds no partner is
+passed on alone once window_s + reorder_s have gone by since it was published.
+reorder_s is the slack for a partner published earlier whose radio path is
+slower. A full buffer passes its oldest event on early.
+
+Latency: a joint gesture costs nothing beyond its last part's arrival; a single
+gesture that could be part of a pattern is delayed by up to window_s + reorder_s.
+"""
+
+import bisect
+import threading
+import time
+from collections import Counter
+from dataclasses import dataclass
+from typing import Callable, Dict, List, Mapping, Optional, Sequence, Tuple
+
+
+@dataclass(eq=False)
+class _Held:
+    """An event waiting for a partner (compared by identity)."""
+    time_s: float
+    address: str
+    gesture: str
+    confidence: float
+
+
+class JointFusion:
+    """Coincidence matching of gesture events from several devices on the synced host clock."""
+
+    DEFAULT_WINDOW_S = 0.15
+    DEFAULT_REORDER_S = 0.05
+    DEFAULT_CAPACITY = 32
+
+    def __init__(self, patterns: Mapping[str, Sequence[str]], window_s: float = DEFAULT_WINDOW_S,
+                 reorder_s: float = DEFAULT_REORDER_S, capacity: int = DEFAULT_CAPACITY,
+                 clock: Callable[[], float] = time.perf_counter):
+        self._patterns: Dict[str, Counter] = {}
+        self._by_gesture: Dict[str, List[str]] = {}
+        for name, gestures in patterns.items():
+            if len(gestures) < 2:
+                raise ValueError(f"joint gesture {name!r} needs at least two parts")
+            self._patterns[name] = Counter(gestures)
+            for gesture in set(gestures):
+                self._by_gesture.setdefault(gesture, []).append(name)
+        self.window_s = window_s
+        self.reorder_s = reorder_s
+        self.capacity = capacity
+        self._clock = clock
+        self._buffer: List[_Held] = []                 # reorder buffer, oldest publish time first
+        self._times: List[float] = []                  # publish times of the buffer, for the insertion
+        self._held: Dict[str, List[_Held]] = {}        # the same events by gesture
+        self._callback: Optional[Callable[[str, float], None]] = None
+        self._condition = threading.Condition()
+        self._thread: Optional[threading.Thread] = None
+        self._running = False
+
+    def set_gesture_callback(self, callback: Callable[[str, float], None]) -> None:
+        """Called with every decided gesture: joint pattern names and single gestures passed on."""
+        self._callback = callback
+
+    def start(self) -> None:
+        """Release unmatched events on time from a thread of its own (otherwise call poll())."""
+        if self._thread is None:
+            self._running = True
+            self._thread = threading.Thread(target=self._run, name="joint-fusion", daemon=True)
+            self._thread.start()
+
+    def close(self) -> None:
+        with self._condition:
+            self._running = False
+            self._condition.notify()
+        if self._thread is not None:
+            self._thread.join()
+            self._thread = None
+
+    def reset(self) -> None:
+        """Forget every held event (a device went away)."""
+        with self._condition:
+            self._buffer.clear()
+            self._times.clear()
+            self._held.clear()
+
+    def feed(self, address: str, gesture: str, confidence: float, time_s: float) -> None:
+        """One result event of a device, time_s its publish time on the host clock."""
+        with self._condition:
+            decided = self._release(self._clock())
+            names = self._by_gesture.get(gesture)
+            if not names:
+                decided.append((gesture, confidence))
+            else:
+                event = _Held(time_s, address, gesture, confidence)
+                joint = self._match(event, names)
+                if joint is not None:
+                    decided.append(joint)
+                else:
+                    self._hold(event, decided)
+                    self._condition.notify()
+        self._emit(decided)
+
+    def poll(self, now: Optional[float] = None) -> Optional[float]:
+        """Pass on the events whose wait is over; the host time the next one is due (None: nothing held)."""
+        with self._condition:
+            decided = self._release(self._clock() if now is None else now)
+            due = self._due(self._buffer[0]) if self._buffer else None
+        self._emit(decided)
+        return due
+
+    def held(self) -> int:
+        return len(self._buffer)
+
+    def _due(self, event: _Held) -> float:
+        return event.time_s + self.window_s + self.reorder_s
+
+    def _match(self, event: _Held, names: List[str]) -> Optional[Tuple[str, float]]:
+        """The first pattern the event completes with held partners from other devices; they leave the buffer."""
+        for name in names:
+            needed = self._patterns[name].copy()
+            needed[event.gesture] -= 1
+            partners: List[_Held] = []
+            used = {event.address}
+            for gesture, count in needed.items():
+                for held in self._held.get(gesture, ()):
+                    if count == 0:
+                        break
+                    if held.address not in used and abs(held.time_s - event.time_s) <= self.window_s:
+                        partners.append(held)
+                        used.add(held.address)
+                        count -= 1
+                if count:
+                    break
+            else:
+                for held in partners:
+                    self._remove(held)
+                return name, min([event.confidence] + [held.confidence for held in partners])
+        return None
+
+    def _hold(self, event: _Held, decided: List[Tuple[str, float]]) -> None:
+        # A newer event of the same device and gesture replaces the older one (one per device and gesture)
+        for held in self._held.get(event.gesture, ()):
+            if held.address == event.address:
+                self._remove(held)
+                decided.append((held.gesture, held.confidence))
+                break
+        position = bisect.bisect_right(self._times, event.time_s)
+        self._times.insert(position, event.time_s)
+        self._buffer.insert(position, event)
+        self._held.setdefault(event.gesture, []).append(event)
+        if len(self._buffer) > self.capacity:
+            oldest = self._buffer[0]
+            self._remove(oldest)
+            decided.append((oldest.gesture, oldest.confidence))
+
+    def _remove(self, event: _Held) -> None:
+        for i, held in enumerate(self._buffer):
+            if held is event:
+                del self._buffer[i]
+                del self._times[i]
+                break
+        self._held[event.gesture].remove(event)
+
+    def _release(self, now: float) -> List[Tuple[str, float]]:
+        decided = []
+        while self._buffer and self._due(self._buffer[0]) <= now:
+            event = self._buffer[0]
+            self._remove(event)
+            decided.append((event.gesture, event.confidence))
+        return decided
+
+    def _emit(self, decided: List[Tuple[str, float]]) -> None:
+        if self._callback:
+            for gesture, confidence in decided:
+                self._callback(gesture, confidence)
+
+    def _run(self) -> None:
+        while True:
+            with self._condition:
+                if not self._running:
+                    return
+                due = self._due(self._buffer[0]) if self._buffer else None
+                timeout = None if due is None else max(due - self._clock(), 0.0)
+                if timeout is None or timeout > 0:
+                    self._condition.wait(timeout)
+            self.poll()
@@ -0,0 +1,167 @@
+"""
+Key Injector Module
+
+Injects a whole shortcut or macro as one batch of key events.
+
+On Windows the batch goes to the OS in a single SendInput call: the events land in the input
+stream back to back, so the user's own typing cannot slip between "ctrl down" and "x down",
+and a macro of many keys costs one system call. Elsewhere (or if user32 cannot be loaded) the
+events are replayed one by one through pynput, as before.
+"""
+
+import sys
+from dataclasses import dataclass
+from typing import Callable, List, Sequence, Tuple
+
+from pynput.keyboard import Controller
+
+# One key event: (pynput key, True = press / False = release)
+KeyEvent = Tuple[object, bool]
+
+
+@dataclass(frozen=True)
+class Macro:
+    """Several chords tapped in order ("ctrl+a, ctrl+c"); stands in for the main key of a shortcut."""
+    chords: Tuple[Tuple[tuple, object], ...]   # (modifiers, main key) per chord
+
+
+def chord_events(modifiers: Sequence, main_key) -> List[KeyEvent]:
+    """Press the modifiers, tap the main key, release the modifiers in reverse order."""
+    if isinstance(main_key, Macro):
+        events: List[KeyEvent] = []
+        for chord_modifiers, chord_key in main_key.chords:
+            events.extend(chord_events(chord_modifiers, chord_key))
+        return events
+    return ([(mod, True) for mod in modifiers] + [(main_key, True), (main_key, False)] +
+            [(mod, False) for mod in reversed(modifiers)])
+
+
+# Windows virtual-key codes of the pynput Key names GestureHandler uses
+VK_CODES = {
+    "backspace": 0x08, "tab": 0x09, "enter": 0x0D, "esc": 0x1B, "space": 0x20,
+    "page_up": 0x21, "page_down": 0x22, "end": 0x23, "home": 0x24,
+    "left": 0x25, "up": 0x26, "right": 0x27, "down": 0x28, "delete": 0x2E,
+    "cmd": 0x5B, "shift_l": 0xA0, "ctrl_l": 0xA2, "alt_l": 0xA4,
+    **{f"f{n}": 0x6F + n for n in range(1, 13)},
+}
+# Keys on the extended (E0-prefixed) block: without the flag the arrows arrive as numpad keys
+EXTENDED_KEYS = frozenset(["page_up", "page_down", "end", "home", "left", "up", "right", "down", "delete", "cmd"])
+
+KEYEVENTF_EXTENDEDKEY = 0x0001
+KEYEVENTF_KEYUP = 0x0002
+KEYEVENTF_UNICODE = 0x0004
+
+
+def keyboard_inputs(events: Sequence[KeyEvent], vk_for_char: Callable[[str], int],
+                    scan_for_vk: Callable[[int], int]) -> List[Tuple[int, int, int]]:
+    """(wVk, wScan, dwFlags) of each event for a KEYBDINPUT.
+
+    vk_for_char is VkKeyScanW (-1 when the layout has no key for the character: it is then sent
+    as a Unicode character), scan_for_vk is MapVirtualKeyW(vk, MAPVK_VK_TO_VSC); both are
+    parameters so the mapping can be checked without Windows.
+    """
+    inputs = []
+    for key, pressed in events:
+        up = 0 if pressed else KEYEVENTF_KEYUP
+        char = getattr(key, "char", None)
+        if char is not None:
+            vk = vk_for_char(char)
+            if vk == -1:
+                inputs.append((0, ord(char), KEYEVENTF_UNICODE | up))
+                continue
+            vk &= 0xFF      # the high byte is the shift state; shortcuts name their modifiers
+            flags = 0
+        else:
+            name = getattr(key, "name", None)
+            if name not in VK_CODES:
+                raise ValueError(f"no virtual-key code for {key!r}")
+            vk = VK_CODES[name]
+            flags = KEYEVENTF_EXTENDEDKEY if name in EXTENDED_KEYS else 0
+        inputs.append((vk, scan_for_vk(vk), flags | up))
+    return inputs
+
+
+class PynputInjector:
+    """One pynput call per key event (every platform pynput supports)."""
+
+    name = "pynput"
+
+    def __init__(self):
+        self._keyboard = Controller()
+
+    def send(self, events: Sequence[KeyEvent]) -> bool:
+        for key, pressed in events:
+            if pressed:
+                self._keyboard.press(key)
+            else:
+                self._keyboard.release(key)
+        return True
+
+
+class SendInputInjector:
+    """The whole batch in one user32 SendInput call (Windows)."""
+
+    name = "sendinput"
+
+    def __init__(self):
+        import ctypes
+        from ctypes import wintypes
+
+        class KEYBDINPUT(ctypes.Structure):
+            _fields_ = [("wVk", wintypes.WORD), ("wScan", wintypes.WORD), ("dwFlags", wintypes.DWORD),
+                        ("time", wintypes.DWORD), ("dwExtraInfo", ctypes.c_size_t)]
+
+        # The mouse member sets the union's size; only the keyboard one is filled in
+        class MOUSEINPUT(ctypes.Structure):
+            _fields_ = [("dx", wintypes.LONG), ("dy", wintypes.LONG), ("mouseData", wintypes.DWORD),
+                        ("dwFlags", wintypes.DWORD), ("time", wintypes.DWORD), ("dwExtraInfo", ctypes.c_size_t)]
+
+        class _INPUTUNION(ctypes.Union):
+            _fields_ = [("ki", KEYBDINPUT), ("mi", MOUSEINPUT)]
+
+        class INPUT(ctypes.Structure):
+            _fields_ = [("type", wintypes.DWORD), ("u", _INPUTUNION)]
+
+        self._ctypes = ctypes
+        self._input = INPUT
+        self._user32 = ctypes.WinDLL("user32", use_last_error=True)
+        self._user32.SendInput.argtypes = (wintypes.UINT, ctypes.POINTER(INPUT), ctypes.c_int)
+        self._user32.SendInput.restype = wintypes.UINT
+        self._user32.VkKeyScanW.argtypes = (wintypes.WCHAR,)
+        self._user32.VkKeyScanW.restype = ctypes.c_short
+        self._user32.MapVirtualKeyW.argtypes = (wintypes.UINT, wintypes.UINT)
+        self._user32.MapVirtualKeyW.restype = wintypes.UINT
+        self._scan_codes = {}
+
+    def _scan_for_vk(self, vk: int) -> int:
+        if vk not in self._scan_codes:
+            self._scan_codes[vk] = self._user32.MapVirtualKeyW(vk, 0)   # MAPVK_VK_TO_VSC
+        return self._scan_codes[vk]
+
+    def send(self, events: Sequence[KeyEvent]) -> bool:
+        inputs = keyboard_inputs(events, self._user32.VkKeyScanW, self._scan_for_vk)
+        batch = (self._input * len(inputs))()
+        for slot, (vk, scan, flags) in zip(batch, inputs):
+            slot.type = 1   # INPUT_KEYBOARD
+            slot.u.ki.wVk = vk
+            slot.u.ki.wScan = scan
+            slot.u.ki.dwFlags = flags
+        sent = self._user32.SendInput(len(inputs), batch, self._ctypes.sizeof(self._input))
+        if sent != len(inputs):
+            # Blocked by UIPI (the foreground window runs elevated) or another input injector
+            print(f"[KeyInjector] SendInput injected {sent} of {len(inputs)} events "
+                  f"(error {self._ctypes.get_last_error()})")
+            return False
+        return True
+
+
+def create_injector(backend: str = "auto"):
+    """SendInputInjector on Windows ("auto" or "sendinput"), PynputInjector otherwise or if user32 fails."""
+    if backend not in ("auto", "sendinput", "pynput"):
+        raise ValueError(f"unknown injection backend {backend!r}")
+    if backend != "pynput" and sys.platform == "win32":
+        try:
+            return SendInputInjector()
+        except (OSError, AttributeError) as e:
+            print(f"[KeyInjector] SendInput unavailable ({e}), falling back to pynput")
+    return PynputInjector()
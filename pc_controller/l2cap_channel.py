@@ -0,0 +1,198 @@
+"""
+L2CAP Channel Module
+
+Bulk streams over the firmware's LE credit-based L2CAP channel (include/l2cap_module.h)
+instead of one GATT notification per packet.
+
+The bulk characteristic (19B10032) holds uint16 SPSM, uint16 device receive MTU and
+uint8 channel version. Every SDU in either direction is a run of records: uint8 type,
+uint8 length, payload. The type is the USB frame type (the low byte of the matching
+characteristic UUID) and the payload that characteristic's notification or write, so
+BLEManager hands records to the same handlers as its notifications.
+
+The host opens the channel and sends a hello record (uint8 STREAM_* bits, may be 0);
+the device answers with the streams in effect, the channel version and the wire schema
+version. From then on the window, recording and trace streams (as the bits select) and
+the diagnostics log dump arrive on the channel, and model data records may be written.
+
+Only Linux exposes LE connection-oriented channels to applications (BlueZ L2CAP
+sockets); elsewhere L2capChannel.open raises OSError and BLEManager stays on GATT.
+"""
+
+import ctypes
+import os
+import socket
+import struct
+import sys
+import threading
+from typing import Callable, Iterator, List, Optional, Sequence, Tuple
+
+BULK_UUID = "19b10032-e8f2-537e-4f6c-d104768a1214"
+BULK_INFO = struct.Struct('<HHB')
+CHANNEL_VERSION = 1
+
+RECORD_MAX = 255
+
+# Record types (include/usb_frame.h)
+RECORD_HELLO = 0x01
+RECORD_DATA = 0x15
+RECORD_WINDOW = 0x1F
+RECORD_MODEL_DATA = 0x23
+RECORD_TELEMETRY_DATA = 0x2C
+RECORD_TRACE = 0x30
+
+# BlueZ socket interface (<bluetooth/bluetooth.h>, <bluetooth/l2cap.h>)
+AF_BLUETOOTH = getattr(socket, "AF_BLUETOOTH", 31)
+BTPROTO_L2CAP = getattr(socket, "BTPROTO_L2CAP", 0)
+SOL_BLUETOOTH = 274
+BT_RCVMTU = 13
+BDADDR_LE_PUBLIC = 0x01
+BDADDR_LE_RANDOM = 0x02
+
+# Largest SDU the host accepts; the device fills at most BLE_L2CAP_SDU_FRAMES K-frames
+RECEIVE_MTU = 1024
+
+
+class _SockaddrL2(ctypes.Structure):
+    _fields_ = [("l2_family", ctypes.c_ushort),
+                ("l2_psm", ctypes.c_ushort),
+                ("l2_bdaddr", ctypes.c_uint8 * 6),
+                ("l2_cid", ctypes.c_ushort),
+                ("l2_bdaddr_type", ctypes.c_uint8)]
+
+
+def parse_bulk_info(data: bytes) -> Optional[Tuple[int, int, int]]:
+    """(SPSM, device receive MTU, channel version) from the bulk characteristic."""
+    if len(data) < BULK_INFO.size:
+        return None
+    return BULK_INFO.unpack_from(data)
+
+
+def encode_records(records: Sequence[Tuple[int, bytes]], mtu: int) -> List[bytes]:
+    """Pack (type, payload) records into as few SDUs of at most mtu bytes as their order allows."""
+    sdus: List[bytes] = []
+    current = bytearray()
+    for record_type, payload in records:
+        if len(payload) > RECORD_MAX or 2 + len(payload) > mtu:
+            raise ValueError(f"record of {len(payload)} bytes does not fit an SDU of {mtu}")
+        if current and len(current) + 2 + len(payload) > mtu:
+            sdus.append(bytes(current))
+            current = bytearray()
+        current += bytes([record_type & 0xFF, len(payload)]) + payload
+    if current:
+        sdus.append(bytes(current))
+    return sdus
+
+
+def iter_records(sdu: bytes) -> Iterator[Tuple[int, bytes]]:
+    """(type, payload) of every record in an SDU; a truncated last record is dropped."""
+    pos = 0
+    while pos + 2 <= len(sdu):
+        length = sdu[pos + 1]
+        if pos + 2 + length > len(sdu):
+            return
+        yield sdu[pos], sdu[pos + 2:pos + 2 + length]
+        pos += 2 + length
+
+
+def encode_hello(streams: int) -> Tuple[int, bytes]:
+    return RECORD_HELLO, bytes([streams & 0xFF])
+
+
+def parse_hello(payload: bytes) -> Optional[Tuple[int, int, Optional[int]]]:
+    """(streams in effect, channel version, wire schema version) of the device's hello reply."""
+    if len(payload) < 2:
+        return None
+    return payload[0], payload[1], payload[2] if len(payload) > 2 else None
+
+
+def supported() -> bool:
+    return sys.platform.startswith("linux") and hasattr(socket, "AF_BLUETOOTH")
+
+
+def _sockaddr(address: str, psm: int, address_type: int) -> _SockaddrL2:
+    addr = _SockaddrL2()
+    addr.l2_family = AF_BLUETOOTH
+    # htobs: the kernel reads the SPSM little-endian
+    addr.l2_psm = int.from_bytes(psm.to_bytes(2, "little"), sys.byteorder)
+    octets = bytes(int(part, 16) for part in address.split(":"))
+    if len(octets) != 6:
+        raise ValueError(f"not a Bluetooth address: {address}")
+    addr.l2_bdaddr[:] = list(reversed(octets))
+    addr.l2_bdaddr_type = address_type
+    return addr
+
+
+class L2capChannel:
+    """One LE credit-based channel to a connected device (BlueZ SOCK_SEQPACKET: one SDU per send/recv)."""
+
+    def __init__(self, address: str, psm: int, random_address: bool = True, device_mtu: int = 512):
+        self._address = address
+        self._psm = psm
+        self._address_type = BDADDR_LE_RANDOM if random_address else BDADDR_LE_PUBLIC
+        self._device_mtu = device_mtu
+        self._sock: Optional[socket.socket] = None
+        self._reader: Optional[threading.Thread] = None
+        self._send_lock = threading.Lock()
+
+    def open(self) -> None:
+        """Connect (blocking: run it off the event loop). Raises OSError when the channel is refused."""
+        if not supported():
+            raise OSError("LE credit-based channels need a Linux host")
+        sock = socket.socket(AF_BLUETOOTH, socket.SOCK_SEQPACKET, BTPROTO_L2CAP)
+        try:
+            sock.setsockopt(SOL_BLUETOOTH, BT_RCVMTU, struct.pack('<H', RECEIVE_MTU))
+            # socket.connect has no LE address type for L2CAP, so the sockaddr is built here
+            libc = ctypes.CDLL(None, use_errno=True)
+            addr = _sockaddr(self._address, self._psm, self._address_type)
+            if libc.connect(sock.fileno(), ctypes.byref(addr), ctypes.sizeof(addr)) != 0:
+                err = ctypes.get_errno()
+                raise OSError(err, f"L2CAP connect to SPSM 0x{self._psm:04x}: {os.strerror(err)}")
+        except Exception:
+            sock.close()
+            raise
+        self._sock = sock
+
+    def start(self, on_record: Callable[[int, bytes], None],
+              on_closed: Optional[Callable[[], None]] = None) -> None:
+        """Deliver every received record to on_record from a reader thread."""
+        sock = self._sock
+        if sock is None:
+            return
+
+        def read() -> None:
+            try:
+                while True:
+                    sdu = sock.recv(RECEIVE_MTU)
+                    if not sdu:
+                        break
+                    for record_type, payload in iter_records(sdu):
+                        on_record(record_type, payload)
+            except OSError:
+                pass
+            if on_closed:
+                on_closed()
+
+        self._reader = threading.Thread(target=read, name="l2cap-reader", daemon=True)
+        self._reader.start()
+
+    def is_open(self) -> bool:
+        return self._sock is not None
+
+    def send(self, records: Sequence[Tuple[int, bytes]]) -> None:
+        """Send records packed into SDUs; blocks while the device has no credits left."""
+        sock = self._sock
+        if sock is None:
+            raise OSError("channel closed")
+        with self._send_lock:
+            for sdu in encode_records(records, self._device_mtu):
+                sock.send(sdu)
+
+    def close(self) -> None:
+        sock, self._sock = self._sock, None
+        if sock is not None:
+            try:
+                sock.shutdown(socket.SHUT_RDWR)
+            except OSError:
+                pass
+            sock.close()
@@ -0,0 +1,174 @@
+"""
+Label Table Generator
+
+Generates the firmware's compile-time label table (include/gesture_labels.h) and
+its PC-side twin (pc_controller/gesture_labels.py) from the class list of the
+Edge Impulse deployment (ei_classifier_inferencing_categories in
+lib/a5-deminsion_inferencing/src/model-parameters/model_variables.h).
+
+The header gives every class index a GESTURE_LABEL_* enumerator plus the data
+the result consumers need (kind and LED colour), so the LED and BLE paths
+dispatch on the integer index instead of comparing label strings.
+inference_module.cpp refuses to compile when the table's class count differs
+from the deployed model, and refuses to start when the names differ, so rerun
+this script after retraining:
+
+Usage:
+    python label_table_gen.py
+    python label_table_gen.py --check
+"""
+
+import argparse
+import os
+import re
+import sys
+from typing import List, NamedTuple, Optional, Sequence, Tuple
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+DEFAULT_MODEL_VARIABLES = os.path.join(ROOT, "lib", "a5-deminsion_inferencing", "src", "model-parameters",
+                                       "model_variables.h")
+DEFAULT_HEADER = os.path.join(ROOT, "include", "gesture_labels.h")
+DEFAULT_MODULE = os.path.join(os.path.dirname(os.path.abspath(__file__)), "gesture_labels.py")
+
+# Kinds as the firmware sees them
+KIND_GESTURE = "GESTURE_KIND_GESTURE"
+KIND_IDLE = "GESTURE_KIND_IDLE"
+KIND_UNKNOWN = "GESTURE_KIND_UNKNOWN"
+
+# LED colours of the labels we know; new gestures get the next free colour of GESTURE_PALETTE
+KNOWN_COLOURS = {
+    "up": (0, 255, 0),        # green
+    "down": (255, 255, 0),    # yellow
+    "right": (255, 0, 255),   # purple
+    "left": (0, 0, 255),      # blue
+    "idle": (255, 0, 0),      # red
+    "unknown": (48, 48, 48),  # dim white
+}
+GESTURE_PALETTE = [(0, 255, 255), (255, 128, 0), (255, 255, 255), (128, 0, 255), (0, 255, 128)]
+
+
+class LabelInfo(NamedTuple):
+    name: str
+    kind: str
+    colour: Tuple[int, int, int]
+
+
+def parse_categories(text: str) -> List[str]:
+    """Class names of the default impulse, in index order."""
+    alias = re.search(r"ei_classifier_inferencing_categories\s*=\s*(\w+)\s*;", text)
+    array = alias.group(1) if alias else r"ei_classifier_inferencing_categories\w*"
+    match = re.search(array + r"\s*\[\s*\]\s*=\s*\{([^}]*)\}", text)
+    if not match:
+        raise ValueError("ei_classifier_inferencing_categories not found")
+    return re.findall(r'"((?:[^"\\]|\\.)*)"', match.group(1))
+
+
+def enumerator(name: str) -> str:
+    return "GESTURE_LABEL_" + (re.sub(r"[^0-9A-Za-z]+", "_", name).strip("_").upper() or "UNNAMED")
+
+
+def label_table(categories: Sequence[str]) -> List[LabelInfo]:
+    used = {KNOWN_COLOURS[name] for name in categories if name in KNOWN_COLOURS}
+    palette = [c for c in GESTURE_PALETTE if c not in used]
+    table = []
+    for name in categories:
+        kind = KIND_IDLE if name == "idle" else KIND_UNKNOWN if name == "unknown" else KIND_GESTURE
+        if name in KNOWN_COLOURS:
+            colour = KNOWN_COLOURS[name]
+        else:
+            colour = palette.pop(0) if palette else (255, 255, 255)
+        table.append(LabelInfo(name, kind, colour))
+    return table
+
+
+def format_header(table: Sequence[LabelInfo]) -> str:
+    names = [enumerator(label.name) for label in table]
+    if len(set(names)) != len(names):
+        raise ValueError(f"labels map to duplicate enumerators: {', '.join(names)}")
+    lines = [
+        "#ifndef GESTURE_LABELS_H",
+        "#define GESTURE_LABELS_H",
+        "",
+        "// 模型类别表：类别下标的枚举与结果消费者（LED / BLE）的查表数据",
+        "// 由 pc_controller/label_table_gen.py 从 ei_classifier_inferencing_categories 生成，不要手工修改；",
+        "// 类别数与部署的模型不一致时 inference_module.cpp 编译失败",
+        "",
+        "#include <stdint.h>",
+        "",
+        "enum gesture_label_t {",
+    ]
+    lines += [f"    {name} = {i}," for i, name in enumerate(names)]
+    lines += [
+        f"    GESTURE_LABEL_COUNT = {len(table)}",
+        "};",
+        "",
+        "enum gesture_kind_t {",
+        "    GESTURE_KIND_GESTURE = 0,",
+        "    GESTURE_KIND_IDLE,",
+        "    GESTURE_KIND_UNKNOWN",
+        "};",
+        "",
+        "struct gesture_label_info_t {",
+        "    const char* name;",
+        "    gesture_kind_t kind;",
+        "    uint8_t r, g, b;  // LED 颜色（感知亮度 0-255）",
+        "};",
+        "",
+        "static constexpr gesture_label_info_t kGestureLabels[GESTURE_LABEL_COUNT] = {",
+    ]
+    for label in table:
+        r, g, b = label.colour
+        lines.append(f'    {{"{label.name}", {label.kind}, {r}, {g}, {b}}},')
+    lines += ["};", "", "#endif", ""]
+    return "\n".join(lines)
+
+
+def format_module(table: Sequence[LabelInfo]) -> str:
+    gestures = [label.name for label in table if label.kind == KIND_GESTURE]
+    lines = [
+        '"""Class order of the deployed model, generated by label_table_gen.py (do not edit).',
+        "",
+        "BLE result events carry the class index; MODEL_LABELS maps it back to the name.",
+        '"""',
+        "",
+        "MODEL_LABELS = (" + "".join(f'"{label.name}", ' for label in table).rstrip(", ") +
+        ("," if len(table) == 1 else "") + ")",
+        "GESTURE_LABELS = (" + "".join(f'"{name}", ' for name in gestures).rstrip(", ") +
+        ("," if len(gestures) == 1 else "") + ")",
+        "",
+    ]
+    return "\n".join(lines)
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    parser = argparse.ArgumentParser(description="Generate the firmware / PC label tables from the deployed model")
+    parser.add_argument("--model-variables", default=DEFAULT_MODEL_VARIABLES, help="Edge Impulse model_variables.h")
+    parser.add_argument("--header", default=DEFAULT_HEADER, help="generated firmware header")
+    parser.add_argument("--module", default=DEFAULT_MODULE, help="generated Python module")
+    parser.add_argument("--check", action="store_true", help="only report whether the generated files are current")
+    args = parser.parse_args(argv)
+
+    with open(args.model_variables, encoding="utf-8") as f:
+        table = label_table(parse_categories(f.read()))
+    outputs = [(args.header, format_header(table)), (args.module, format_module(table))]
+
+    if args.check:
+        stale = []
+        for path, text in outputs:
+            current = open(path, encoding="utf-8").read() if os.path.exists(path) else None
+            if current != text:
+                stale.append(path)
+        for path in stale:
+            print(f"[Labels] {path} is out of date, rerun label_table_gen.py")
+        return 1 if stale else 0
+
+    for path, text in outputs:
+        with open(path, "w", encoding="utf-8") as f:
+            f.write(text)
+    print(f"[Labels] {len(table)} classes ({', '.join(label.name for label in table)}) written to "
+          f"{args.header} and {args.module}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
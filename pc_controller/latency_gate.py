@@ -0,0 +1,207 @@
+"""
+On-target Latency Regression Gate
+
+Flashes a firmware build, replays a fixed corpus of recordings through the
+real board (device_replay.py) and compares the result against a stored
+baseline, so a model retrain or an SDK bump cannot quietly slow the device
+down. Compared metrics:
+    latency p50 / p99   sample-to-result latency over every classified window
+    RAM high-water      static data + heap the board ever took (the "memory" line)
+    flash               image size from the linker map (map_budget.py)
+Each must stay within its tolerance of the baseline (relative, default 10 %
+for latency and 2 % for RAM and flash); the exit code is 1 on a regression
+and 2 when nothing could be compared (no baseline, another corpus, no board
+output). Getting faster or smaller never fails; --update-baseline records the
+current run instead of comparing, e.g. after an accepted change.
+
+The baseline stores a digest of the corpus (file names and contents), so a
+comparison against another set of recordings is refused rather than trusted.
+
+Usage:
+    python latency_gate.py --port /dev/ttyACM0 --baseline gate.json --update-baseline data/gate/*.csv
+    python latency_gate.py --port /dev/ttyACM0 --baseline gate.json data/gate/*.csv
+    python latency_gate.py --port COM5 --baseline gate.json --no-flash --latency-tolerance 0.2 data/gate/*.csv
+"""
+
+import argparse
+import hashlib
+import json
+import os
+import subprocess
+import sys
+import time
+from dataclasses import asdict, dataclass
+from typing import List, Optional, Sequence
+
+from device_replay import parse_memory, replay_text_on_device
+from map_budget import analyze
+from percentiles import percentile
+from replay_runner import parse_output
+
+BOOT_LINE = "--- System Ready ---"
+SCHEMA = 1
+
+
+@dataclass
+class GateMetrics:
+    latency_p50_us: float
+    latency_p99_us: float
+    ram_high_water: int
+    flash_bytes: int
+    windows: int = 0
+
+
+# (metric, label, unit, is a latency)
+METRICS = [("latency_p50_us", "latency p50", "us", True), ("latency_p99_us", "latency p99", "us", True),
+           ("ram_high_water", "RAM high-water", "B", False), ("flash_bytes", "flash", "B", False)]
+
+
+def corpus_digest(paths: Sequence[str]) -> str:
+    """SHA-1 over the sorted file names and contents of the corpus."""
+    digest = hashlib.sha1()
+    for path in sorted(paths, key=os.path.basename):
+        digest.update(os.path.basename(path).encode() + b"\0")
+        with open(path, "rb") as f:
+            digest.update(f.read())
+    return digest.hexdigest()
+
+
+def metrics_from_runs(texts: Sequence[str], flash_bytes: int) -> GateMetrics:
+    """Latency percentiles over all windows and the largest RAM high-water of the runs' board output."""
+    latencies = [w.latency_us for text in texts for w in parse_output("", text).windows]
+    memory = [parse_memory(text) for text in texts]
+    if not latencies:
+        raise ValueError("the board classified no windows")
+    if any(m is None for m in memory):
+        raise ValueError("the board printed no memory line (firmware older than the gate?)")
+    return GateMetrics(float(percentile(latencies, 0.50)), float(percentile(latencies, 0.99)), max(m[0] for m in memory),
+                       flash_bytes, len(latencies))
+
+
+def compare(baseline: GateMetrics, current: GateMetrics, latency_tolerance: float,
+            size_tolerance: float) -> List[str]:
+    """A message per metric that grew beyond its tolerance (empty when all pass)."""
+    failures = []
+    for name, label, unit, is_latency in METRICS:
+        before, after = getattr(baseline, name), getattr(current, name)
+        tolerance = latency_tolerance if is_latency else size_tolerance
+        if after > before * (1.0 + tolerance):
+            change = (after / before - 1.0) * 100 if before > 0 else float("inf")
+            failures.append(f"{label} {after:.0f} {unit} vs {before:.0f} {unit} ({change:+.1f}%, "
+                            f"tolerance {tolerance * 100:.0f}%)")
+    return failures
+
+
+def load_baseline(path: str) -> dict:
+    with open(path, encoding="utf-8") as f:
+        data = json.load(f)
+    if data.get("schema") != SCHEMA:
+        raise ValueError(f"unsupported baseline schema {data.get('schema')!r}")
+    data["metrics"] = GateMetrics(**data["metrics"])
+    return data
+
+
+def save_baseline(path: str, env: str, corpus: str, recordings: int, metrics: GateMetrics) -> None:
+    with open(path, "w", encoding="utf-8") as f:
+        json.dump({"schema": SCHEMA, "env": env, "corpus": corpus, "recordings": recordings,
+                   "metrics": asdict(metrics)}, f, indent=2)
+        f.write("\n")
+
+
+# ==================== Board ====================
+
+def flash(env: str, port: str) -> None:
+    print(f"[Gate] Building and flashing {env}")
+    subprocess.run(["pio", "run", "-e", env, "-t", "upload", "--upload-port", port], check=True)
+
+
+def flash_size(map_path: str) -> int:
+    with open(map_path, encoding="utf-8", errors="replace") as f:
+        return analyze(f.read()).total.flash
+
+
+def open_after_boot(port: str, timeout_s: float):
+    """Open the port once the board enumerates again and wait for the end of its start-up."""
+    import serial  # pyserial
+
+    deadline = time.monotonic() + timeout_s
+    while True:
+        try:
+            ser = serial.Serial(port, 115200, timeout=0.1)
+            break
+        except serial.SerialException:
+            if time.monotonic() > deadline:
+                raise
+            time.sleep(0.5)
+    # With --no-flash (or a port that opened late) the ready line is gone and this only costs the timeout
+    buffer = b""
+    while time.monotonic() < deadline and BOOT_LINE.encode() not in buffer:
+        buffer = (buffer + ser.read(4096))[-4096:]
+    return ser
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    parser = argparse.ArgumentParser(description="Fail when the board got slower or bigger than the baseline")
+    parser.add_argument("files", nargs="+", help="the fixed corpus of labelled Edge Impulse CSV recordings")
+    parser.add_argument("--port", required=True, help="serial port of the board")
+    parser.add_argument("--baseline", required=True, help="baseline JSON to compare with (or write)")
+    parser.add_argument("--update-baseline", action="store_true", help="write this run as the new baseline")
+    parser.add_argument("--env", default="nano33ble", help="PlatformIO environment to flash (default nano33ble)")
+    parser.add_argument("--no-flash", action="store_true", help="test the firmware already on the board")
+    parser.add_argument("--map", help="linker map of the flashed image (default .pio/build/<env>/firmware.map)")
+    parser.add_argument("--latency-tolerance", type=float, default=0.10, help="allowed p50 / p99 growth")
+    parser.add_argument("--size-tolerance", type=float, default=0.02, help="allowed RAM / flash growth")
+    parser.add_argument("--timeout", type=float, default=20.0, help="seconds to wait for the board")
+    args = parser.parse_args(argv)
+
+    baseline = None
+    corpus = corpus_digest(args.files)
+    if not args.update_baseline:
+        try:
+            baseline = load_baseline(args.baseline)
+        except (OSError, ValueError, KeyError, TypeError) as e:
+            print(f"[Gate] Cannot read baseline {args.baseline}: {e}")
+            return 2
+        if baseline["corpus"] != corpus:
+            print(f"[Gate] The corpus differs from the baseline's ({baseline['recordings']} recordings); "
+                  f"record a new baseline with --update-baseline")
+            return 2
+
+    if not args.no_flash:
+        flash(args.env, args.port)
+    boot_timeout = 1.0 if args.no_flash else args.timeout
+    map_path = args.map or os.path.join(".pio", "build", args.env, "firmware.map")
+    try:
+        flash_bytes = flash_size(map_path)
+    except OSError as e:
+        print(f"[Gate] Cannot read the linker map: {e}")
+        return 2
+
+    texts = []
+    with open_after_boot(args.port, boot_timeout) as ser:
+        for path in sorted(args.files, key=os.path.basename):
+            texts.append(replay_text_on_device(ser, path, args.timeout))
+            print(f"[Gate] {path}: {len(parse_output(path, texts[-1]).windows)} windows")
+    try:
+        current = metrics_from_runs(texts, flash_bytes)
+    except ValueError as e:
+        print(f"[Gate] {e}")
+        return 2
+
+    print(f"[Gate] {len(args.files)} recordings, {current.windows} windows")
+    for name, label, unit, _ in METRICS:
+        before = f" (baseline {getattr(baseline['metrics'], name):.0f})" if baseline else ""
+        print(f"[Gate]   {label:<15}{getattr(current, name):>10.0f} {unit}{before}")
+    if args.update_baseline:
+        save_baseline(args.baseline, args.env, corpus, len(args.files), current)
+        print(f"[Gate] Wrote baseline {args.baseline}")
+        return 0
+
+    failures = compare(baseline["metrics"], current, args.latency_tolerance, args.size_tolerance)
+    for failure in failures:
+        print(f"[Gate] REGRESSED: {failure}")
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -5,7 +5,10 @@ A PC application that receives gesture recognition results from Arduino Nano 33
 and converts them to PowerPoint slide navigation commands.
 """
 
+import argparse
 import asyncio
+import shutil
+import tempfile
 import threading
 import sys
 import os
@@ -15,7 +18,9 @@ sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
 
 from config_manager import ConfigManager
 from gesture_handler import GestureHandler
+from serial_manager import TransportSelector
 from ble_manager import BLEManager
+from ble_worker import BLEWorkerClient
 from gui import MainWindow
 
 
@@ -27,6 +32,13 @@ def run_async_loop(loop: asyncio.AbstractEventLoop) -> None:
 
 def main():
     """Main entry point for the BLE PPT Controller application."""
+    parser = argparse.ArgumentParser(description="BLE PPT Controller")
+    parser.add_argument("--replay", help="drive the GUI with a recorded BLE session (ble_session.py) instead of a board")
+    parser.add_argument("--speed", type=float, default=1.0, help="replay pace multiplier; 0 = as fast as possible")
+    parser.add_argument("--in-process", action="store_true",
+                        help="receive in the GUI process instead of the BLE worker process (ble_worker.py)")
+    args = parser.parse_args()
+
     print("BLE PPT Controller")
     print("==================")
     print("Starting application...")
@@ -34,16 +46,34 @@ def main():
     # Determine config path (same directory as script)
     script_dir = os.path.dirname(os.path.abspath(__file__))
     config_path = os.path.join(script_dir, "config.json")
+    if args.replay and os.path.exists(config_path):
+        # A replay reads the settings but never changes them (the replay "device" would become the last one)
+        replay_config = os.path.join(tempfile.mkdtemp(), "config.json")
+        shutil.copyfile(config_path, replay_config)
+        config_path = replay_config
     
     # Initialize components
     config_manager = ConfigManager(config_path)
     config_manager.load()
     
-    gesture_handler = GestureHandler(config_manager)
-    ble_manager = BLEManager()
+    if args.replay:
+        from ble_session import dry_run_gesture_handler
+        gesture_handler = dry_run_gesture_handler(config_manager)
+    else:
+        gesture_handler = GestureHandler(config_manager)
+    # USB when a board answers on a serial port, BLE otherwise. Reception and decoding run in a worker
+    # process, so a busy GUI never delays a notification; a replay drives an in-process BLEManager
+    if args.replay or args.in_process:
+        ble = BLEManager()
+        ble_manager = TransportSelector(ble=ble)
+    else:
+        ble_manager = BLEWorkerClient()
+        ble_manager.start()
     
     # Set auto-reconnect from config
     ble_manager.set_auto_reconnect(config_manager.get_auto_reconnect())
+    # Connects look for the board used last first
+    ble_manager.set_known_address(config_manager.get_last_device_address())
     
     # Create GUI
     window = MainWindow(config_manager, gesture_handler, ble_manager)
@@ -57,7 +87,24 @@ def main():
     
     # Add startup log entry
     window.add_log_entry("Application started")
-    window.add_log_entry("Click 'Scan' to find BLE devices")
+    if args.replay:
+        from ble_session import replay_session
+
+        def replayed(future) -> None:
+            try:
+                report = future.result()
+            except Exception as e:
+                window.add_log_entry(f"Replay failed: {e}")
+                return
+            print(report.format())
+            window.add_log_entry(f"Replay done: {report.notifications} notifications, "
+                                 f"{report.throughput():.0f}/s (report on the console)")
+
+        asyncio.run_coroutine_threadsafe(replay_session(args.replay, args.speed, ble),
+                                         loop).add_done_callback(replayed)
+        window.add_log_entry(f"Replaying {args.replay} (keys are not pressed)")
+    else:
+        window.add_log_entry("Click 'Scan' to find devices (USB and BLE)")
     
     print("GUI started. Close the window to exit.")
     
@@ -69,6 +116,10 @@ def main():
     finally:
         # Cleanup
         loop.call_soon_threadsafe(loop.stop)
+        if isinstance(ble_manager, BLEWorkerClient):
+            ble_manager.close()
+        gesture_handler.close()
+        config_manager.flush()
         print("Application closed.")
 
 
@@ -0,0 +1,410 @@
+"""
+Memory Budget Report
+
+Breaks the firmware image down into RAM / flash per module and per large
+symbol by parsing the GNU ld map file, and checks the result against the
+budgets configured in platformio.ini. Registered as a PlatformIO
+extra_script (see [env:nano33ble]), it asks the linker for a map file, prints
+the report after every link and fails the build when a budget is exceeded;
+`pio run -t budget` prints it again without relinking.
+
+A module is the first rule of MODULE_RULES matching an input section's object
+file: firmware sources group by file (src/inference_module.cpp ->
+inference_module), the Edge Impulse library by component (tflite-model,
+edge-impulse-sdk/tensorflow, CMSIS). Sections in a read-only (flash) region
+count as flash, sections in a writable region as RAM; initialised data
+lives in RAM but is also copied from flash, so it counts twice.
+
+Budgets (custom_memory_budgets in platformio.ini), one per line:
+    <module | total | sym:<glob>> <flash | ram> <bytes>
+
+Usage:
+    python map_budget.py .pio/build/nano33ble/firmware.map
+    python map_budget.py firmware.map --budget "tflite-model flash 24000" --budget "total ram 200000"
+"""
+
+import argparse
+import fnmatch
+import re
+import sys
+from dataclasses import dataclass, field
+from typing import Dict, List, NamedTuple, Optional, Sequence, Tuple
+
+# (module, regular expression on the object file path); "\1" takes the name from the first group
+MODULE_RULES: List[Tuple[str, str]] = [
+    ("tflite-model", r"tflite-model[/\\]"),
+    ("edge-impulse-sdk/tensorflow", r"edge-impulse-sdk[/\\]tensorflow[/\\]"),
+    ("CMSIS", r"edge-impulse-sdk[/\\]CMSIS[/\\]"),
+    ("edge-impulse-sdk", r"edge-impulse-sdk[/\\]"),
+    ("ArduinoBLE", r"ArduinoBLE"),
+    ("Arduino_BMI270_BMM150", r"Arduino_BMI270_BMM150"),
+    ("\\1", r"[/\\]src[/\\]([\w-]+)\.(?:cpp|c)\.o$"),
+    ("framework", r"FrameworkArduino|libmbed|mbed-os|[/\\]cores[/\\]|[/\\]variants[/\\]"),
+    ("libc", r"lib(?:c|c_nano|m|gcc|stdc\+\+|stdc\+\+_nano|supc\+\+|nosys)\.a"),
+]
+
+# Symbols always listed, whatever their size (globs; a glob matching several symbols is summed)
+WATCHED_SYMBOLS = ["tensor_arena", "*print_buf", "tensor_data*"]
+
+SECTION_PREFIXES = (".text.", ".rodata.", ".data.", ".bss.", ".tbss.", ".tdata.", ".ramfunc.")
+# Linker-merged string / constant pools and relro data carry no symbol name
+_MERGED_RE = re.compile(r"^(?:str\d|cst\d|rel\.|rel$)")
+
+
+class Region(NamedTuple):
+    name: str
+    origin: int
+    length: int
+    writable: bool
+
+
+class InputSection(NamedTuple):
+    name: str
+    address: int
+    size: int
+    obj: str
+    load_in_flash: bool  # output section has a flash load address (initialised data)
+    output: str          # output section the input section was placed in
+
+
+@dataclass
+class Usage:
+    flash: int = 0
+    ram: int = 0
+
+    def add(self, other: "Usage") -> None:
+        self.flash += other.flash
+        self.ram += other.ram
+
+
+@dataclass
+class SymbolUsage:
+    module: str
+    usage: Usage = field(default_factory=Usage)
+
+
+@dataclass
+class MemoryReport:
+    modules: Dict[str, Usage]
+    symbols: Dict[str, SymbolUsage]
+    total: Usage
+
+
+class Budget(NamedTuple):
+    name: str    # module, "total" or "sym:<glob>"
+    memory: str  # "flash" or "ram"
+    limit: int
+
+
+# ==================== Map file parsing ====================
+
+_REGION_RE = re.compile(r"^(\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(?:\s+(\S+))?\s*$")
+_OUTPUT_RE = re.compile(r"^(\.\S+)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+))?(.*)$")
+_INPUT_RE = re.compile(r"^ (\S+)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(.+))?$")
+_CONTINUATION_RE = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(.+)$")
+
+
+def parse_regions(text: str) -> List[Region]:
+    """Memory regions from the "Memory Configuration" table."""
+    regions = []
+    in_table = False
+    for line in text.splitlines():
+        if line.startswith("Memory Configuration"):
+            in_table = True
+            continue
+        if in_table and line.startswith("Linker script and memory map"):
+            break
+        if not in_table:
+            continue
+        match = _REGION_RE.match(line)
+        if match and match.group(1) != "*default*" and match.group(1) != "Name":
+            attributes = match.group(4) or ""
+            regions.append(Region(match.group(1), int(match.group(2), 16), int(match.group(3), 16),
+                                  "w" in attributes))
+    return regions
+
+
+def parse_sections(text: str) -> List[InputSection]:
+    """Input sections with a size from the memory map (discarded sections are skipped)."""
+    sections = []
+    lines = text.splitlines()
+    try:
+        start = next(i for i, line in enumerate(lines) if line.startswith("Linker script and memory map"))
+    except StopIteration:
+        return sections
+    load_in_flash = False
+    output = ""
+    pending_output: Optional[str] = None
+    pending_input: Optional[str] = None
+    for line in lines[start + 1:]:
+        if pending_output is not None:
+            output = pending_output
+            load_in_flash = "load address" in line
+            pending_output = None
+            continue
+        if pending_input is not None:
+            match = _CONTINUATION_RE.match(line)
+            if match:
+                _append(sections, pending_input, match.group(1), match.group(2), match.group(3), load_in_flash,
+                        output)
+            pending_input = None
+            continue
+        if not line or line[0] == "*":
+            continue
+        if line[0] == ".":
+            match = _OUTPUT_RE.match(line)
+            if match and match.group(2) is None:
+                pending_output = match.group(1)
+            else:
+                output = match.group(1) if match else line.split()[0]
+                load_in_flash = "load address" in line
+            continue
+        if line[0] != " " or line.startswith("  "):
+            continue
+        match = _INPUT_RE.match(line)
+        if not match or match.group(1).startswith("*"):
+            continue
+        if match.group(2) is None:
+            pending_input = match.group(1)
+        else:
+            _append(sections, match.group(1), match.group(2), match.group(3), match.group(4), load_in_flash, output)
+    return sections
+
+
+def _append(sections: List[InputSection], name: str, address: str, size: str, obj: str, load_in_flash: bool,
+            output: str) -> None:
+    size_value = int(size, 16)
+    if size_value > 0:
+        sections.append(InputSection(name, int(address, 16), size_value, obj.strip(), load_in_flash, output))
+
+
+# ==================== Attribution ====================
+
+def module_of(obj: str, rules: Sequence[Tuple[str, str]] = MODULE_RULES) -> str:
+    """Module of an object file path (first matching rule, "other" when none matches)."""
+    for name, pattern in rules:
+        match = re.search(pattern, obj)
+        if match:
+            return match.expand(name) if "\\" in name else name
+    return "other"
+
+
+def symbol_of(section_name: str) -> str:
+    """Symbol name of a -ffunction-sections / -fdata-sections input section, lightly demangled."""
+    name = section_name
+    for prefix in SECTION_PREFIXES:
+        if name.startswith(prefix):
+            name = name[len(prefix):]
+            break
+    return demangle(name)
+
+
+def demangle(name: str) -> str:
+    """Readable form of simple Itanium names: namespaced / static functions and variables, function-local statics.
+
+    Parameter lists are dropped; anything not understood is returned unchanged.
+    """
+    if not name.startswith("_Z"):
+        return name
+    body = name[2:]
+    local = body.startswith("Z")
+    if local:
+        body = body[1:]
+    parts, rest = _read_name(body)
+    if parts is None:
+        return name
+    if local:
+        # _ZZ <function> <parameters> E <entity>
+        end = rest.find("E")
+        if end < 0:
+            return name
+        inner, _ = _read_name(rest[end + 1:])
+        if not inner:
+            return name
+        return "::".join(parts + inner)
+    return "::".join(parts)
+
+
+def _read_name(body: str) -> Tuple[Optional[List[str]], str]:
+    if body.startswith("L"):
+        body = body[1:]
+    if body.startswith("N"):
+        body = body[1:]
+        parts: List[str] = []
+        while body and body[0] != "E":
+            if body[0] in "KVr":
+                body = body[1:]
+                continue
+            part, body = _read_source_name(body)
+            if part is None:
+                # Template arguments and the like: keep the scope read so far
+                return (parts if parts else None), ""
+            parts.append(part)
+        return (parts if parts else None), body[1:]
+    part, body = _read_source_name(body)
+    return ([part] if part is not None else None), body
+
+
+def _read_source_name(body: str) -> Tuple[Optional[str], str]:
+    match = re.match(r"(\d+)", body)
+    if not match:
+        return None, body
+    length = int(match.group(1))
+    start = len(match.group(1))
+    if len(body) < start + length:
+        return None, body
+    return body[start:start + length], body[start + length:]
+
+
+# Output sections by kind, for maps without a memory region table (hosted links)
+FLASH_OUTPUTS = (".text", ".rodata", ".init", ".fini", ".ARM.exidx", ".ARM.extab", ".eh_frame", ".gcc_except_table")
+DATA_OUTPUTS = (".data", ".init_array", ".fini_array", ".tdata")
+BSS_OUTPUTS = (".bss", ".tbss")
+
+
+def classify(section: InputSection, regions: Sequence[Region]) -> Usage:
+    """Flash / RAM bytes of one input section (both for initialised data)."""
+    if not regions:
+        if section.output.startswith(FLASH_OUTPUTS):
+            return Usage(flash=section.size)
+        if section.output.startswith(DATA_OUTPUTS):
+            return Usage(flash=section.size, ram=section.size)
+        if section.output.startswith(BSS_OUTPUTS):
+            return Usage(ram=section.size)
+        return Usage()
+    for region in regions:
+        if region.origin <= section.address < region.origin + region.length:
+            if not region.writable:
+                return Usage(flash=section.size)
+            return Usage(flash=section.size if section.load_in_flash else 0, ram=section.size)
+    return Usage()
+
+
+def analyze(text: str, rules: Sequence[Tuple[str, str]] = MODULE_RULES) -> MemoryReport:
+    regions = parse_regions(text)
+    modules: Dict[str, Usage] = {}
+    symbols: Dict[str, SymbolUsage] = {}
+    total = Usage()
+    for section in parse_sections(text):
+        usage = classify(section, regions)
+        if usage.flash == 0 and usage.ram == 0:
+            continue
+        module = module_of(section.obj, rules)
+        modules.setdefault(module, Usage()).add(usage)
+        total.add(usage)
+        if section.name.startswith(SECTION_PREFIXES) and not _MERGED_RE.match(symbol_of(section.name)):
+            symbols.setdefault(symbol_of(section.name), SymbolUsage(module)).usage.add(usage)
+    return MemoryReport(modules, symbols, total)
+
+
+# ==================== Budgets ====================
+
+def parse_budgets(lines: Sequence[str]) -> List[Budget]:
+    """Budget lines "<name> <flash|ram> <bytes>" (blank lines and # comments ignored)."""
+    budgets = []
+    for line in lines:
+        line = line.split("#", 1)[0].strip()
+        if not line:
+            continue
+        fields = line.split()
+        if len(fields) != 3 or fields[1] not in ("flash", "ram"):
+            raise ValueError(f"bad budget line: {line!r} (expected '<name> <flash|ram> <bytes>')")
+        budgets.append(Budget(fields[0], fields[1], int(fields[2], 0)))
+    return budgets
+
+
+def symbol_usage(report: MemoryReport, pattern: str) -> Usage:
+    usage = Usage()
+    for name, symbol in report.symbols.items():
+        if fnmatch.fnmatchcase(name, pattern):
+            usage.add(symbol.usage)
+    return usage
+
+
+def usage_of(report: MemoryReport, name: str) -> Optional[Usage]:
+    if name == "total":
+        return report.total
+    if name.startswith("sym:"):
+        return symbol_usage(report, name[4:])
+    return report.modules.get(name)
+
+
+def check_budgets(report: MemoryReport, budgets: Sequence[Budget]) -> List[str]:
+    """Messages for every exceeded budget; budgets of modules absent from the image pass (0 bytes)."""
+    violations = []
+    for budget in budgets:
+        usage = usage_of(report, budget.name) or Usage()
+        used = usage.flash if budget.memory == "flash" else usage.ram
+        if used > budget.limit:
+            violations.append(f"{budget.name} uses {used} B of {budget.memory}, budget {budget.limit} B "
+                              f"(over by {used - budget.limit} B)")
+    return violations
+
+
+# ==================== Report ====================
+
+def format_report(report: MemoryReport, top: int = 15, watched: Sequence[str] = WATCHED_SYMBOLS) -> str:
+    lines = [f"[Budget] {'module':<30} {'flash':>9} {'ram':>9}"]
+    for name, usage in sorted(report.modules.items(), key=lambda item: -(item[1].flash + item[1].ram)):
+        lines.append(f"[Budget] {name:<30} {usage.flash:>9} {usage.ram:>9}")
+    lines.append(f"[Budget] {'total':<30} {report.total.flash:>9} {report.total.ram:>9}")
+
+    lines.append(f"[Budget] largest symbols:")
+    largest = sorted(report.symbols.items(), key=lambda item: -(item[1].usage.flash + item[1].usage.ram))[:top]
+    for name, symbol in largest:
+        lines.append(f"[Budget]   {name[:44]:<44} {symbol.usage.flash:>9} {symbol.usage.ram:>9}  {symbol.module}")
+    for pattern in watched:
+        usage = symbol_usage(report, pattern)
+        lines.append(f"[Budget]   {'[' + pattern + ']':<44} {usage.flash:>9} {usage.ram:>9}")
+    return "\n".join(lines)
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    parser = argparse.ArgumentParser(description="RAM / flash per module and symbol from a GNU ld map file")
+    parser.add_argument("map", help="linker map file (-Wl,-Map)")
+    parser.add_argument("--budget", action="append", default=[], help="'<name> <flash|ram> <bytes>', repeatable")
+    parser.add_argument("--top", type=int, default=15, help="number of largest symbols to list")
+    args = parser.parse_args(argv)
+
+    with open(args.map, encoding="utf-8", errors="replace") as f:
+        report = analyze(f.read())
+    print(format_report(report, args.top))
+    violations = check_budgets(report, parse_budgets(args.budget))
+    for message in violations:
+        print(f"[Budget] EXCEEDED: {message}")
+    return 1 if violations else 0
+
+
+# ==================== PlatformIO extra_script ====================
+
+def _register(env) -> None:
+    import os
+
+    map_path = os.path.join(env.subst("$BUILD_DIR"), env.subst("${PROGNAME}.map"))
+    env.Append(LINKFLAGS=["-Wl,-Map," + map_path])
+    option = env.GetProjectOption("custom_memory_budgets", "")
+    budgets = parse_budgets(option if isinstance(option, list) else option.splitlines())
+
+    def report_action(target, source, env):
+        if not os.path.exists(map_path):
+            print(f"[Budget] No map file at {map_path}")
+            return 1
+        with open(map_path, encoding="utf-8", errors="replace") as f:
+            report = analyze(f.read())
+        print(format_report(report))
+        violations = check_budgets(report, budgets)
+        for message in violations:
+            print(f"[Budget] EXCEEDED: {message}")
+        return 1 if violations else 0
+
+    env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", report_action)
+    env.AddCustomTarget(name="budget", dependencies="$BUILD_DIR/${PROGNAME}.elf", actions=[report_action],
+                        title="Memory budget", description="RAM / flash per module and symbol from the map file")
+
+
+if "Import" in globals():
+    # Run by PlatformIO as an extra_script: SCons injects Import() into the script's globals
+    Import("env")  # noqa: F821
+    _register(env)  # noqa: F821
+elif __name__ == "__main__":
+    sys.exit(main())
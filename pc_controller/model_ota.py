@@ -0,0 +1,463 @@
+"""
+Model OTA - push retrained weights to the board over BLE
+
+Reads an Edge Impulse EON export (tflite-model/tflite_learn_*_compiled.cpp of a
+retrained impulse), checks that its graph is the one built into the firmware
+(same operators, tensor shapes and types: only weights, biases and per-tensor
+quantization may differ), and packs the constant tensors and the quantization
+parameters into a model blob (include/model_blob.h). The blob carries one test
+window and the int8 fully connected layer output that an integer reference of
+the graph (TFLite int8 kernel arithmetic) computes for it; the device runs the
+same window through the new weights and only switches when every logit matches.
+
+The blob is written into the device's spare flash slot through the model
+control / data characteristics (19B10022 / 19B10023, MODEL_OTA_ENABLE) in
+full-MTU chunks, about 2.5 KB, so an update takes well under a second on a 2M
+PHY / 247-byte MTU link. A different architecture, new labels or another
+window length still need a firmware build.
+
+Firmware built with MODEL_INTERPRETER_ENABLE (nano33ble_interpreter) also takes
+a whole .tflite flatbuffer (--tflite, blob format 2): the board runs it with the
+TFLM interpreter from flash, so layers and channel counts may change too; only
+the window length and the number of classes are fixed. Its self-test vector is
+the int8 model output (after softmax) from TFLite's reference kernels, which the
+micro kernels match bit for bit; building it needs tensorflow.
+
+Usage:
+    python model_ota.py path/to/tflite_learn_792000_36_compiled.cpp --version 2
+    python model_ota.py export.cpp --output model.bin          # build the blob only
+    python model_ota.py --tflite retrained.tflite --version 3  # interpreter firmware only
+    python model_ota.py --status
+    python model_ota.py --builtin                              # back to the firmware's weights
+"""
+
+import argparse
+import asyncio
+import math
+import os
+import re
+import struct
+import sys
+import zlib
+from dataclasses import dataclass, field
+from typing import Dict, List, Optional, Sequence, Tuple
+
+DEPLOYED_MODEL = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "lib", "a5-deminsion_inferencing",
+                              "src", "tflite-model", "tflite_learn_792000_36_compiled.cpp")
+
+# include/model_blob.h
+BLOB_MAGIC = 0x31424D47
+BLOB_FORMAT = 1
+BLOB_FORMAT_FLATBUFFER = 2
+BLOB_HEADER = struct.Struct('<IHHIII12x')
+BLOB_ENTRY = struct.Struct('<HBBIIfi')
+BLOB_CRC_OFFSET = 16
+TEST_INPUT = 0xFFFF
+TEST_LOGITS = 0xFFFE
+FLATBUFFER = 0xFFFD
+FLATBUFFER_ALIGN = 16
+HAS_DATA = 0x01
+HAS_QUANT = 0x02
+TFLITE_TYPES = {"Int32": 2, "UInt8": 3, "Int8": 9, "Int4": 18}
+SLOT_BYTES = 4096  # MODEL_SLOT_BYTES
+INTERPRETER_SLOT_BYTES = 16384  # MODEL_SLOT_BYTES of nano33ble_interpreter
+TFLITE_IDENTIFIER = b"TFL3"
+
+# Tensor indices of the deployed graph (src/model_module.cpp)
+CONV1_FILTER, CONV1_BIAS, CONV1_OUTPUT = 10, 9, 12
+CONV2_FILTER, CONV2_BIAS, CONV2_OUTPUT = 8, 7, 16
+FC_WEIGHTS, FC_BIAS, FC_OUTPUT = 6, 5, 18
+INPUT = 0
+
+
+@dataclass
+class Tensor:
+    index: int
+    constant: bool          # kTfLiteMmapRo (data in flash) or kTfLiteArenaRw
+    type: str               # "Int8" / "Int32" / "Int4" (two per byte, data holds the unpacked values)
+    dims: Tuple[int, ...]
+    bytes: int
+    data: Optional[List[int]] = None
+    scale: Optional[float] = None       # float32 value, None without quantization
+    zero_point: Optional[int] = None
+
+
+@dataclass
+class CompiledModel:
+    tensors: List[Tensor]
+    structure: List[str] = field(default_factory=list)  # operator, node and op parameter lines
+
+    def signature(self) -> List[Tuple]:
+        """Everything the blob cannot change: tensor layout and the operator graph."""
+        return [(t.constant, t.type, t.dims, t.bytes, t.scale is not None) for t in self.tensors] + \
+               [(line,) for line in self.structure]
+
+
+def float32(value: float) -> float:
+    return struct.unpack('<f', struct.pack('<f', value))[0]
+
+
+def _ints(text: str) -> List[int]:
+    return [int(v) for v in re.findall(r'-?\d+', re.sub(r'/\*.*?\*/', '', text, flags=re.S))]
+
+
+def unpack_int4(packed: Sequence[int], count: int) -> List[int]:
+    """Signed 4-bit values, element 2i in the low nibble of byte i (TFLite's int4 packing)."""
+    values = []
+    for byte in packed:
+        for nibble in (byte & 0x0F, (byte >> 4) & 0x0F):
+            values.append(nibble - 16 if nibble > 7 else nibble)
+    return values[:count]
+
+
+def pack_int4(values: Sequence[int]) -> List[int]:
+    """int8 bytes holding two signed 4-bit values each, low nibble first."""
+    if any(not -8 <= v <= 7 for v in values):
+        raise ValueError("int4 values must be in [-8, 7]")
+    padded = list(values) + [0] * (len(values) % 2)
+    return [struct.unpack('<b', bytes([(lo & 0x0F) | (hi & 0x0F) << 4]))[0]
+            for lo, hi in zip(padded[0::2], padded[1::2])]
+
+
+def parse_compiled_model(text: str) -> CompiledModel:
+    """Parse the tensor table, constant data and quantization of an EON compiled graph."""
+    data = {int(m.group(2)): _ints(m.group(3)) for m in re.finditer(
+        r'(int8_t|int32_t) tensor_data(\d+)\[[^\]]*\] = \{(.*?)\};', text, re.S)}
+    dims = {int(m.group(1)): tuple(_ints(m.group(2))) for m in re.finditer(
+        r'tensor_dimension(\d+) = \{ \d+, \{ ([-\d, ]+) \} \};', text)}
+    scales = {int(m.group(1)): float32(float(m.group(2))) for m in re.finditer(
+        r'quant(\d+)_scale = \{ 1, \{ ([-+0-9.eE]+),? \} \};', text)}
+    zeros = {int(m.group(1)): int(m.group(2)) for m in re.finditer(
+        r'quant(\d+)_zero = \{ 1, \{ (-?\d+) \} \};', text)}
+    quant = {int(m.group(1)): (int(m.group(2)), int(m.group(3))) for m in re.finditer(
+        r'TfLiteAffineQuantization quant(\d+) = \{ \(TfLiteFloatArray\*\)&(?:g0::)?quant(\d+)_scale, '
+        r'\(TfLiteIntArray\*\)&(?:g0::)?quant(\d+)_zero', text)}
+    if re.search(r'TfArray<([2-9]|\d\d+), float> quant', text):
+        raise ValueError("per-channel quantization is not supported (the firmware overrides per-tensor parameters)")
+
+    table = re.search(r'TensorInfo_t tensorData\[\] = \{(.*?)\n\};', text, re.S)
+    if not table:
+        raise ValueError("tensorData table not found (not an EON compiled model?)")
+    tensors = []
+    for index, m in enumerate(re.finditer(
+            r'\{ kTfLite(ArenaRw|MmapRo), kTfLite(\w+), \(int32_t\*\)(?:g0::tensor_data(\d+)|\(tensor_arena \+ \d+\)), '
+            r'\(TfLiteIntArray\*\)&g0::tensor_dimension(\d+), (\d+), '
+            r'\{kTfLite(?:AffineQuantization|NoQuantization), (?:nullptr|[^}]*&g0::quant(\d+)\)+)\}', table.group(1))):
+        tensor = Tensor(index, m.group(1) == "MmapRo", m.group(2), dims[int(m.group(4))], int(m.group(5)))
+        if m.group(3) is not None:
+            tensor.data = data[int(m.group(3))]
+            if tensor.type == "Int4":
+                tensor.data = unpack_int4(tensor.data, math.prod(tensor.dims))
+        if m.group(6) is not None:
+            scale_id, zero_id = quant[int(m.group(6))]
+            tensor.scale, tensor.zero_point = scales[scale_id], zeros[zero_id]
+        tensors.append(tensor)
+    if not tensors:
+        raise ValueError("no tensors parsed")
+
+    structure = [line.strip() for line in text.splitlines()
+                 if re.match(r'\s*(const TfArray<\d+, int> (inputs|outputs)\d+|const TfLite\w+Params opdata\d+)', line)]
+    ops = re.search(r'used_operators_e used_ops\[\] =\s*\{(.*?)\};', text, re.S)
+    structure.append(ops.group(1).strip() if ops else "")
+    return CompiledModel(tensors, structure)
+
+
+def load_compiled_model(path: str) -> CompiledModel:
+    with open(path, encoding="utf-8") as f:
+        return parse_compiled_model(f.read())
+
+
+# ==================== int8 reference (TFLite reference kernel arithmetic) ====================
+
+def quantize_multiplier(real: float) -> Tuple[int, int]:
+    """tflite::QuantizeMultiplier: real = multiplier * 2^(shift - 31)."""
+    if real == 0.0:
+        return 0, 0
+    mantissa, shift = math.frexp(real)
+    q = int(math.floor(abs(mantissa) * (1 << 31) + 0.5)) * (1 if mantissa >= 0 else -1)
+    if q == 1 << 31:
+        q //= 2
+        shift += 1
+    if shift < -31:
+        return 0, 0
+    return q, shift
+
+
+def multiply_by_quantized_multiplier(x: int, multiplier: int, shift: int) -> int:
+    left = shift if shift > 0 else 0
+    right = -shift if shift < 0 else 0
+    a = x * (1 << left)
+    a = max(-(1 << 31), min((1 << 31) - 1, a))
+    if a == multiplier == -(1 << 31):
+        high = (1 << 31) - 1
+    else:
+        ab = a * multiplier
+        nudge = (1 << 30) if ab >= 0 else 1 - (1 << 30)
+        total = ab + nudge
+        high = abs(total) >> 31
+        high = high if total >= 0 else -high  # C division truncates toward zero
+    mask = (1 << right) - 1
+    remainder = high & mask
+    threshold = (mask >> 1) + (1 if high < 0 else 0)
+    return (high >> right) + (1 if remainder > threshold else 0)
+
+
+def _requantize(acc: int, multiplier: int, shift: int, zero_point: int, act_min: int) -> int:
+    out = multiply_by_quantized_multiplier(acc, multiplier, shift) + zero_point
+    return max(act_min, min(127, out))
+
+
+def _layer_multiplier(model: CompiledModel, input_index: int, filter_index: int, output_index: int) -> Tuple[int, int]:
+    t = model.tensors
+    return quantize_multiplier(t[input_index].scale * t[filter_index].scale / t[output_index].scale)
+
+
+def reference_pooled(model: CompiledModel, window: Sequence[int]) -> List[List[int]]:
+    """int8 max pooling output (columns x channels) of the 1xK SAME convolution + ReLU for one input window."""
+    t = model.tensors
+    conv1_w, conv1_b = t[CONV1_FILTER], t[CONV1_BIAS]
+    out1, kernel = conv1_w.dims[0], conv1_w.dims[2]
+    length = len(window)
+
+    in_off = -t[INPUT].zero_point
+    zp1 = t[CONV1_OUTPUT].zero_point
+    m1, s1 = _layer_multiplier(model, INPUT, CONV1_FILTER, CONV1_OUTPUT)
+    pad = (kernel - 1) // 2
+    conv1 = []
+    for w in range(length):
+        row = []
+        for o in range(out1):
+            acc = conv1_b.data[o]
+            for k in range(kernel):
+                x = w + k - pad
+                if 0 <= x < length:
+                    acc += (window[x] + in_off) * conv1_w.data[o * kernel + k]
+            row.append(_requantize(acc, m1, s1, zp1, max(-128, zp1)))
+        conv1.append(row)
+
+    return [[max(conv1[2 * j][c], conv1[2 * j + 1][c]) for c in range(out1)] for j in range(length // 2)]
+
+
+def reference_features(model: CompiledModel, pooled: Sequence[Sequence[int]]) -> List[int]:
+    """int8 output of the 1x1 convolution + ReLU (the fully connected input, column-major) for a pooling output."""
+    t = model.tensors
+    conv2_w, conv2_b = t[CONV2_FILTER], t[CONV2_BIAS]
+    out2, in2 = conv2_w.dims[0], conv2_w.dims[3]
+    zp1 = t[CONV1_OUTPUT].zero_point
+    zp2 = t[CONV2_OUTPUT].zero_point
+    m2, s2 = _layer_multiplier(model, CONV1_OUTPUT, CONV2_FILTER, CONV2_OUTPUT)
+    conv2 = []
+    for column in pooled:
+        for o in range(out2):
+            acc = conv2_b.data[o] + sum((column[i] - zp1) * conv2_w.data[o * in2 + i] for i in range(in2))
+            conv2.append(_requantize(acc, m2, s2, zp2, max(-128, zp2)))
+    return conv2
+
+
+def reference_fc(model: CompiledModel, features: Sequence[int], weights: Optional[Sequence[int]] = None) -> List[int]:
+    """int8 output of the fully connected layer; weights replaces the model's FC weights (same quantization)."""
+    t = model.tensors
+    fc_w, fc_b = t[FC_WEIGHTS], t[FC_BIAS]
+    weights = fc_w.data if weights is None else weights
+    zp2 = t[CONV2_OUTPUT].zero_point
+    m3, s3 = _layer_multiplier(model, CONV2_OUTPUT, FC_WEIGHTS, FC_OUTPUT)
+    n = len(features)
+    return [_requantize(fc_b.data[k] + sum((features[i] - zp2) * weights[k * n + i] for i in range(n)),
+                        m3, s3, t[FC_OUTPUT].zero_point, -128)
+            for k in range(fc_w.dims[0])]
+
+
+def reference_logits(model: CompiledModel, window: Sequence[int]) -> List[int]:
+    """int8 output of the fully connected layer (softmax input) for one input window.
+
+    Graph: 1xK SAME convolution + ReLU, 2:1 max pooling, 1x1 convolution + ReLU, fully connected.
+    """
+    return reference_fc(model, reference_features(model, reference_pooled(model, window)))
+
+
+def self_test_window(length: int, seed: int = 0x12345678) -> List[int]:
+    """Deterministic pseudo-random int8 window (the LCG of model_module's benchmark input)."""
+    values = []
+    for _ in range(length):
+        seed = (seed * 1664525 + 1013904223) & 0xFFFFFFFF
+        values.append(struct.unpack('<b', bytes([seed >> 24]))[0])
+    return values
+
+
+# ==================== blob ====================
+
+def _pack(values: Sequence[int], tensor_type: str) -> bytes:
+    if tensor_type == "Int4":
+        return _pack(pack_int4(values), "Int8")
+    return struct.pack(f'<{len(values)}{"b" if tensor_type == "Int8" else "i"}', *values)
+
+
+def build_blob(model: CompiledModel, deployed: CompiledModel, version: int = 1,
+               window: Optional[Sequence[int]] = None) -> bytes:
+    """Pack every weight / bias tensor and every quantization parameter of model, with a self-test vector."""
+    if model.signature() != deployed.signature():
+        raise ValueError("graph differs from the deployed model (only weights and quantization can be updated)")
+    if not 0 <= version <= 0xFFFFFFFF:
+        raise ValueError("version must fit 32 bits")
+    if window is None:
+        window = self_test_window(model.tensors[INPUT].bytes)
+
+    entries = []  # (tensor, flags, type, payload, scale, zero_point)
+    for t in model.tensors:
+        flags = (HAS_DATA if t.constant and t.scale is not None else 0) | (HAS_QUANT if t.scale is not None else 0)
+        if flags:
+            payload = _pack(t.data, t.type) if flags & HAS_DATA else b""
+            entries.append((t.index, flags, TFLITE_TYPES[t.type], payload, t.scale, t.zero_point))
+    logits = reference_logits(model, window)
+    entries.append((TEST_INPUT, HAS_DATA, TFLITE_TYPES["Int8"], _pack(window, "Int8"), 0.0, 0))
+    entries.append((TEST_LOGITS, HAS_DATA, TFLITE_TYPES["Int8"], _pack(logits, "Int8"), 0.0, 0))
+    return _assemble(BLOB_FORMAT, entries, version, SLOT_BYTES)
+
+
+def _assemble(fmt: int, entries: Sequence[Tuple], version: int, slot_bytes: int, first_align: int = 4) -> bytes:
+    """Header, entry table and 4-byte aligned data; the first payload starts at a first_align boundary."""
+    offset = BLOB_HEADER.size + len(entries) * BLOB_ENTRY.size
+    table = b""
+    data = b"\xff" * (-offset % first_align)
+    for tensor, flags, tensor_type, payload, scale, zero_point in entries:
+        start = offset + len(data) if payload else 0
+        table += BLOB_ENTRY.pack(tensor, flags, tensor_type, start, len(payload), scale or 0.0, zero_point or 0)
+        data += payload + b"\xff" * (-len(payload) % 4)
+    total = offset + len(data)
+    if total > slot_bytes:
+        raise ValueError(f"blob is {total} bytes, the model slot holds {slot_bytes}")
+    body = table + data
+    header = BLOB_HEADER.pack(BLOB_MAGIC, fmt, len(entries), total, 0, version)
+    crc = zlib.crc32(header[BLOB_CRC_OFFSET:] + body) & 0xFFFFFFFF
+    return BLOB_HEADER.pack(BLOB_MAGIC, fmt, len(entries), total, crc, version) + body
+
+
+def build_tflite_blob(flatbuffer: bytes, window: Sequence[int], output: Sequence[int], version: int = 1,
+                      slot_bytes: int = INTERPRETER_SLOT_BYTES) -> bytes:
+    """Format 2 blob: a whole flatbuffer (16-byte aligned for the interpreter) with its int8 self-test output."""
+    if len(flatbuffer) < 8 or flatbuffer[4:8] != TFLITE_IDENTIFIER:
+        raise ValueError("not a TFLite flatbuffer (file identifier TFL3 missing)")
+    if not 0 <= version <= 0xFFFFFFFF:
+        raise ValueError("version must fit 32 bits")
+    entries = [(FLATBUFFER, HAS_DATA, TFLITE_TYPES["UInt8"], bytes(flatbuffer), 0.0, 0),
+               (TEST_INPUT, HAS_DATA, TFLITE_TYPES["Int8"], _pack(window, "Int8"), 0.0, 0),
+               (TEST_LOGITS, HAS_DATA, TFLITE_TYPES["Int8"], _pack(output, "Int8"), 0.0, 0)]
+    return _assemble(BLOB_FORMAT_FLATBUFFER, entries, version, slot_bytes, FLATBUFFER_ALIGN)
+
+
+def reference_output(flatbuffer: bytes, window: Sequence[int]) -> List[int]:
+    """int8 output tensor of a flatbuffer for one window, computed with TFLite's reference kernels."""
+    try:
+        import numpy as np
+        import tensorflow as tf
+    except ImportError as e:
+        raise ValueError("--tflite needs tensorflow to compute the self-test output") from e
+    interpreter = tf.lite.Interpreter(model_content=bytes(flatbuffer),
+                                      experimental_op_resolver_type=tf.lite.experimental.OpResolverType.BUILTIN_REF)
+    interpreter.allocate_tensors()
+    inputs, outputs = interpreter.get_input_details(), interpreter.get_output_details()
+    if len(inputs) != 1 or len(outputs) != 1 or inputs[0]["dtype"] != np.int8 or outputs[0]["dtype"] != np.int8:
+        raise ValueError("the flatbuffer needs one int8 input and one int8 output tensor")
+    interpreter.set_tensor(inputs[0]["index"], np.array(window, dtype=np.int8).reshape(inputs[0]["shape"]))
+    interpreter.invoke()
+    return [int(v) for v in interpreter.get_tensor(outputs[0]["index"]).flatten()]
+
+
+def load_tflite_blob(path: str, deployed: CompiledModel, version: int = 1) -> bytes:
+    """Format 2 blob for a .tflite file; its window length and class count must match the firmware."""
+    with open(path, "rb") as f:
+        flatbuffer = f.read()
+    window = self_test_window(deployed.tensors[INPUT].bytes)
+    output = reference_output(flatbuffer, window)
+    if len(output) != deployed.tensors[-1].bytes:
+        raise ValueError(f"the flatbuffer has {len(output)} outputs, the firmware expects {deployed.tensors[-1].bytes}")
+    return build_tflite_blob(flatbuffer, window, output, version)
+
+
+def parse_blob(blob: bytes) -> Dict[int, Tuple[int, int, bytes, float, int]]:
+    """Entries of a blob by tensor index: (flags, type, data, scale, zero point); checks header and CRC."""
+    if len(blob) < BLOB_HEADER.size:
+        raise ValueError("blob too short")
+    magic, fmt, count, total, crc, _ = BLOB_HEADER.unpack_from(blob)
+    if magic != BLOB_MAGIC or fmt not in (BLOB_FORMAT, BLOB_FORMAT_FLATBUFFER) or total != len(blob):
+        raise ValueError("not a model blob")
+    if zlib.crc32(blob[BLOB_CRC_OFFSET:]) & 0xFFFFFFFF != crc:
+        raise ValueError("CRC mismatch")
+    entries = {}
+    for i in range(count):
+        tensor, flags, tensor_type, offset, size, scale, zero_point = BLOB_ENTRY.unpack_from(
+            blob, BLOB_HEADER.size + i * BLOB_ENTRY.size)
+        entries[tensor] = (flags, tensor_type, blob[offset:offset + size], scale, zero_point)
+    return entries
+
+
+# ==================== CLI ====================
+
+async def run(args) -> int:
+    from ble_manager import BLEManager
+
+    blob = None
+    if args.tflite:
+        blob = load_tflite_blob(args.tflite, load_compiled_model(args.deployed), args.version)
+    elif args.model:
+        blob = build_blob(load_compiled_model(args.model), load_compiled_model(args.deployed), args.version)
+    if blob is not None:
+        print(f"[OTA] Blob: {len(blob)} bytes, version {args.version}")
+        if args.output:
+            with open(args.output, "wb") as f:
+                f.write(blob)
+            print(f"[OTA] Wrote {args.output}")
+            return 0
+
+    manager = BLEManager()
+    manager.set_auto_reconnect(False)
+    connected = await manager.connect(args.address) if args.address else await manager.scan_and_connect()
+    if not connected:
+        print("[OTA] Device not connected")
+        return 1
+    try:
+        if blob is not None:
+            def progress(sent: int, total: int) -> None:
+                print(f"\r[OTA] {sent}/{total} bytes", end="", flush=True)
+
+            result = await manager.upload_model(blob, progress)
+            print()
+            if result is None:
+                return 1
+            status = result.status
+            kbps = len(blob) * 8 / 1000 / result.transfer_s if result.transfer_s > 0 else 0.0
+            print(f"[OTA] Transfer {result.transfer_s:.2f} s ({kbps:.1f} kbit/s), switch {result.switch_s:.2f} s")
+            print(f"[OTA] Device: {status.state}, slot {status.slot}, version {status.version}, error {status.error}")
+            return 0 if result.ok else 1
+        status = await manager.restore_builtin_model() if args.builtin else await manager.read_model_status()
+        if status is None:
+            print("[OTA] No model status (firmware without MODEL_OTA_ENABLE?)")
+            return 1
+        print(f"[OTA] Device: {status.state}, slot {status.slot}, version {status.version}, error {status.error}")
+        return 0
+    finally:
+        await manager.disconnect()
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    parser = argparse.ArgumentParser(description="Update the board's model weights over BLE")
+    parser.add_argument("model", nargs="?", help="EON export of the retrained model (tflite_learn_*_compiled.cpp)")
+    parser.add_argument("--tflite", help="whole .tflite flatbuffer for firmware built with MODEL_INTERPRETER_ENABLE")
+    parser.add_argument("--deployed", default=DEPLOYED_MODEL, help="compiled model built into the firmware")
+    parser.add_argument("--version", type=int, default=1, help="version reported by the device after the switch")
+    parser.add_argument("--output", help="write the blob to a file instead of uploading it")
+    parser.add_argument("--address", help="device address (default: scan by name)")
+    parser.add_argument("--status", action="store_true", help="print the device's model status")
+    parser.add_argument("--builtin", action="store_true", help="switch the device back to its built-in weights")
+    args = parser.parse_args(argv)
+    if not (args.model or args.tflite) and not (args.status or args.builtin):
+        parser.error("give a compiled model, --tflite, --status or --builtin")
+    try:
+        return asyncio.run(run(args))
+    except ValueError as e:
+        print(f"[OTA] {e}")
+        return 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
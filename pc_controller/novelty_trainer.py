@@ -0,0 +1,192 @@
+"""
+Novelty Detector Trainer
+
+Trains the firmware's K-means novelty detector (see include/novelty_detector.h)
+on a labelled dataset recorded with raw_recorder.py. The recordings are replayed
+through the host build of the inference pipeline (replay_runner.py, int8 window
+with streaming inference), which dumps the penultimate activation of every
+classified window: the 36 x 10 int8 second-convolution output that feeds the
+fully connected layer. The trainer clusters those activations and gives every
+centroid a radius (squared distance) that covers all but --reject-rate of its own
+training windows, widened by --margin. At run time a gesture window whose
+activation lies outside the radius of its nearest centroid is rejected.
+
+The result is written as include/novelty_model.h; enable the detector with
+-DINFERENCE_INT8_WINDOW=1 -DINFERENCE_NOVELTY_DETECTION=1.
+
+Usage:
+    python novelty_trainer.py --build data/*.csv
+    python novelty_trainer.py --clusters 12 --reject-rate 0.005 data/*.csv
+"""
+
+import argparse
+import math
+import os
+import random
+import sys
+from concurrent.futures import ThreadPoolExecutor
+from typing import Dict, List, Optional, Sequence
+
+from idle_prefilter_tuner import label_from_path
+from replay_runner import DEFAULT_BINARY, build, replay_file
+
+# Must match the deployed model (second convolution output: 36 columns x 10 channels)
+COLUMNS = 36
+CHANNELS = 10
+DEFAULT_OUTPUT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "include", "novelty_model.h")
+# Every CNN window must be dumped, so the idle pre-filter is off while collecting
+BUILD_FLAGS = "-DINFERENCE_INT8_WINDOW=1 -DINFERENCE_IDLE_PREFILTER=0"
+
+Vector = List[int]
+
+
+def squared_distance(a: Sequence[float], b: Sequence[float]) -> float:
+    return sum((x - y) * (x - y) for x, y in zip(a, b))
+
+
+def nearest(point: Sequence[float], centroids: Sequence[Sequence[float]]) -> int:
+    """Index of the closest centroid (the lowest index wins a tie, like NoveltyDetector::check)."""
+    best = 0
+    best_d = math.inf
+    for k, centroid in enumerate(centroids):
+        d = squared_distance(point, centroid)
+        if d < best_d:
+            best, best_d = k, d
+    return best
+
+
+def kmeans(points: Sequence[Vector], clusters: int, iterations: int = 50, seed: int = 0) -> List[Vector]:
+    """Lloyd's algorithm with k-means++ seeding; centroids are rounded to int8 like the firmware table."""
+    if not points:
+        raise ValueError("need at least one activation to cluster")
+    rng = random.Random(seed)
+    centroids: List[List[float]] = [list(rng.choice(points))]
+    while len(centroids) < min(clusters, len(points)):
+        weights = [min(squared_distance(p, c) for c in centroids) for p in points]
+        total = sum(weights)
+        if total == 0:
+            break
+        pick = rng.uniform(0, total)
+        for point, weight in zip(points, weights):
+            pick -= weight
+            if pick <= 0:
+                break
+        centroids.append(list(point))
+
+    for _ in range(iterations):
+        sums = [[0.0] * len(points[0]) for _ in centroids]
+        counts = [0] * len(centroids)
+        for point in points:
+            k = nearest(point, centroids)
+            counts[k] += 1
+            for i, v in enumerate(point):
+                sums[k][i] += v
+        # Empty clusters are dropped rather than re-seeded
+        updated = [[s / n for s in total] for total, n in zip(sums, counts) if n > 0]
+        if updated == centroids:
+            break
+        centroids = updated
+    return [[max(-128, min(127, int(round(v)))) for v in c] for c in centroids]
+
+
+def upper_quantile(values: Sequence[float], q: float) -> float:
+    """Smallest value with at most a fraction q of values strictly above it."""
+    ordered = sorted(values)
+    return ordered[max(0, int(math.ceil((1.0 - q) * len(ordered))) - 1)]
+
+
+def cluster_radii(points: Sequence[Vector], centroids: Sequence[Vector],
+                  reject_rate: float = 0.01, margin: float = 1.2) -> List[int]:
+    """Per-centroid squared-distance radius covering its own windows up to reject_rate, times margin."""
+    members: Dict[int, List[float]] = {}
+    for point in points:
+        k = nearest(point, centroids)
+        members.setdefault(k, []).append(squared_distance(point, centroids[k]))
+    return [int(math.ceil(upper_quantile(members[k], reject_rate) * margin)) if k in members else 0
+            for k in range(len(centroids))]
+
+
+def is_novel(point: Sequence[int], centroids: Sequence[Vector], radii: Sequence[int]) -> bool:
+    """The firmware decision: outside the radius of the nearest centroid."""
+    k = nearest(point, centroids)
+    return squared_distance(point, centroids[k]) > radii[k]
+
+
+def format_header(centroids: Sequence[Vector], radii: Sequence[int], columns: int = COLUMNS,
+                  channels: int = CHANNELS) -> str:
+    lines = [
+        "#ifndef NOVELTY_MODEL_H",
+        "#define NOVELTY_MODEL_H",
+        "",
+        "// 新颖性检测的 K-means 聚类中心与半径（见 novelty_detector.h）",
+        "// 由 pc_controller/novelty_trainer.py 生成，不要手工修改",
+        "",
+        "#include <stdint.h>",
+        "",
+        f"#define NOVELTY_MODEL_CLUSTERS {len(centroids)}",
+        f"#define NOVELTY_MODEL_COLUMNS {columns}",
+        f"#define NOVELTY_MODEL_CHANNELS {channels}",
+        "",
+    ]
+    if centroids:
+        lines.append(f"static const int8_t kNoveltyCentroids[{len(centroids)} * {columns} * {channels}] = {{")
+        for centroid in centroids:
+            for j in range(0, len(centroid), channels):
+                lines.append("    " + " ".join(f"{v}," for v in centroid[j:j + channels]))
+        lines.append("};")
+        lines.append(f"static const uint32_t kNoveltyRadii[{len(radii)}] = {{" +
+                     ", ".join(str(r) for r in radii) + "};")
+    else:
+        lines.append("static const int8_t kNoveltyCentroids[1] = {0};")
+        lines.append("static const uint32_t kNoveltyRadii[1] = {0};")
+    lines += ["", "#endif", ""]
+    return "\n".join(lines)
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    parser = argparse.ArgumentParser(description="Train the firmware novelty detector")
+    parser.add_argument("files", nargs="+", help="labelled Edge Impulse CSV recordings of normal use")
+    parser.add_argument("--binary", default=DEFAULT_BINARY, help="host_replay program")
+    parser.add_argument("--build", action="store_true", help=f"rebuild host_replay with {BUILD_FLAGS}")
+    parser.add_argument("--jobs", type=int, default=os.cpu_count() or 1, help="parallel replay processes")
+    parser.add_argument("--clusters", type=int, default=8, help="number of K-means centroids")
+    parser.add_argument("--reject-rate", type=float, default=0.01,
+                        help="tolerated fraction of training windows outside their centroid's radius")
+    parser.add_argument("--margin", type=float, default=1.2, help="factor applied to every radius")
+    parser.add_argument("--seed", type=int, default=0, help="k-means++ seed")
+    parser.add_argument("--output", default=DEFAULT_OUTPUT, help="generated header")
+    args = parser.parse_args(argv)
+
+    if args.build:
+        build(BUILD_FLAGS)
+    if not os.path.exists(args.binary):
+        print(f"[Novelty] {args.binary} not found, build it with --build")
+        return 1
+
+    with ThreadPoolExecutor(max_workers=max(1, args.jobs)) as pool:
+        results = list(pool.map(lambda path: replay_file(args.binary, path, features=True), args.files))
+    by_label: Dict[str, List[Vector]] = {}
+    for result in results:
+        by_label.setdefault(label_from_path(result.path), []).extend(v for _, v in result.features)
+    points = [v for vectors in by_label.values() for v in vectors if len(v) == COLUMNS * CHANNELS]
+    print(f"[Novelty] {len(points)} activations from {len(results)} recordings")
+    if not points:
+        print("[Novelty] No activations dumped (was host_replay built with the int8 window?)")
+        return 1
+
+    centroids = kmeans(points, args.clusters, seed=args.seed)
+    radii = cluster_radii(points, centroids, args.reject_rate, args.margin)
+    for label in sorted(by_label):
+        vectors = by_label[label]
+        rejected = sum(1 for v in vectors if is_novel(v, centroids, radii))
+        print(f"[Novelty]   {label:>8}: {rejected} of {len(vectors)} training windows rejected")
+
+    with open(args.output, "w", encoding="utf-8") as f:
+        f.write(format_header(centroids, radii))
+    print(f"[Novelty] {len(centroids)} clusters written to {args.output}")
+    print("[Novelty] build_flags: -DINFERENCE_INT8_WINDOW=1 -DINFERENCE_NOVELTY_DETECTION=1")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
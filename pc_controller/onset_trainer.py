@@ -0,0 +1,260 @@
+"""
+Onset Head Trainer
+
+Trains the firmware's prefix head (INFERENCE_ONSET_HEAD, see include/onset_head.h)
+on recordings made with raw_recorder.py. The head sees only the newest --prefix
+frames of the window and is trained to predict what the full model will say a
+little later: the recordings are replayed through the host build of the
+inference pipeline (replay_runner.py) for the full model's label of every
+window, and the target of a truncated window ending at frame f is the first
+gesture the full model reports within --horizon frames of f (idle when none).
+A head that fires on such a prefix is therefore ahead of the full model by the
+frames the window still needed.
+
+The features are computed like the firmware does: the per-axis mean and
+population standard deviation of the prefix (acceleration in g, resampled to
+the model rate). A softmax regression is trained on them and the
+standardisation is folded into float weights.
+
+The provisional threshold is the lowest head probability at which the windows
+the head would announce (top class a gesture) agree with the full model's later
+decision at least --precision of the time. The device then confirms or cancels
+each provisional onset once the full window is classified (OnsetTracker); the
+report replays that on the recordings and prints how far ahead the confirmed
+onsets were.
+
+The result is written as include/onset_model.h; enable it with
+-DINFERENCE_ONSET_HEAD=1.
+
+Usage:
+    python onset_trainer.py --build data/*.csv
+    python onset_trainer.py --prefix 8 --precision 0.9 data/*.csv
+"""
+
+import argparse
+import math
+import os
+import sys
+from concurrent.futures import ThreadPoolExecutor
+from dataclasses import dataclass
+from typing import List, Optional, Sequence, Tuple
+
+from early_exit_trainer import select_threshold, softmax, train_softmax
+from gesture_labels import GESTURE_LABELS, MODEL_LABELS
+from idle_prefilter_tuner import MODEL_HZ, WINDOW_FRAMES, resample
+from replay_runner import DEFAULT_BINARY, ReplayResult, build, replay_file
+from session_corpus import expand_inputs, load_frames
+
+AXES = 3
+DEFAULT_PREFIX = 10
+DEFAULT_OUTPUT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "include", "onset_model.h")
+# Every window is classified and reported: no idle pre-filter or result memo standing in for the model
+BUILD_FLAGS = "-DINFERENCE_IDLE_PREFILTER=0 -DINFERENCE_RESULT_MEMO=0"
+
+Vector = List[float]
+
+
+def prefix_features(frames: Sequence[Sequence[float]], end: int, prefix: int) -> Optional[Vector]:
+    """Per-axis mean, then per-axis population std of frames[end - prefix:end] (OnsetHead::evaluate)."""
+    if prefix < 2 or end < prefix or end > len(frames):
+        return None
+    window = frames[end - prefix:end]
+    axes = len(window[0])
+    means = [sum(frame[a] for frame in window) / prefix for a in range(axes)]
+    stds = [math.sqrt(max(0.0, sum(frame[a] * frame[a] for frame in window) / prefix - means[a] * means[a]))
+            for a in range(axes)]
+    return means + stds
+
+
+def onset_targets(windows: Sequence[Tuple[int, int]], horizon: int, idle: int) -> List[int]:
+    """Target class per window: the first gesture the full model reports within horizon frames, else idle.
+
+    windows holds (frame, full model class or -1) in frame order.
+    """
+    targets = []
+    for i, (frame, _) in enumerate(windows):
+        target = idle
+        for later_frame, label in windows[i:]:
+            if later_frame - frame > horizon:
+                break
+            if label >= 0 and label != idle:
+                target = label
+                break
+        targets.append(target)
+    return targets
+
+
+def fold_head(weights: Sequence[Sequence[float]], bias: Sequence[float], mean: Sequence[float],
+              std: Sequence[float]) -> Tuple[List[Vector], Vector]:
+    """Fold the standardisation into the weights: logit = bias + sum(w * feature) on raw features."""
+    folded = [[w_i / s_i for w_i, s_i in zip(w, std)] for w in weights]
+    folded_bias = [b - sum(w_i * m_i for w_i, m_i in zip(w, mean)) for w, b in zip(folded, bias)]
+    return folded, folded_bias
+
+
+def head_decision(features: Sequence[float], weights: Sequence[Sequence[float]],
+                  bias: Sequence[float]) -> Tuple[int, float]:
+    """Top class and its probability (the firmware's float evaluation)."""
+    probs = softmax([b + sum(w_i * f_i for w_i, f_i in zip(w, features)) for w, b in zip(weights, bias)])
+    top = max(range(len(probs)), key=probs.__getitem__)
+    return top, probs[top]
+
+
+@dataclass
+class OnsetStats:
+    onsets: int = 0
+    confirmed: int = 0
+    canceled: int = 0
+    lead_frames: int = 0
+
+
+def simulate(steps: Sequence[Tuple[int, int, int]], horizon: int, idle: int,
+             stats: Optional[OnsetStats] = None) -> OnsetStats:
+    """Replay OnsetTracker (include/onset_head.h) over (frame, head class or -1, full model class or -1) steps."""
+    stats = stats or OnsetStats()
+    pending = False
+    armed = True
+    label = -1
+    onset_frame = 0
+    last_result = -1
+    for frame, head, result in steps:
+        if head < 0:
+            armed = True
+        elif not pending and armed and head != last_result:
+            pending, armed, label, onset_frame = True, False, head, frame
+            stats.onsets += 1
+        last_result = result
+        if not pending:
+            continue
+        if result == label:
+            pending = False
+            stats.confirmed += 1
+            stats.lead_frames += frame - onset_frame
+        elif (result >= 0 and result != idle) or frame - onset_frame > horizon:
+            pending = False
+            stats.canceled += 1
+    return stats
+
+
+def labelled_prefixes(result: ReplayResult, frames: Sequence[Sequence[float]], prefix: int, horizon: int,
+                      idle: int) -> List[Tuple[int, Vector, int, int]]:
+    """(frame, prefix features, target, full model class) for every window whose prefix lies in the recording."""
+    windows = [(w.frame, MODEL_LABELS.index(w.label) if w.label in MODEL_LABELS else -1) for w in result.windows]
+    windows.sort()
+    targets = onset_targets(windows, horizon, idle)
+    out = []
+    for (frame, label), target in zip(windows, targets):
+        features = prefix_features(frames, frame, prefix)
+        if features is not None:
+            out.append((frame, features, target, label))
+    return out
+
+
+def format_header(weights: Sequence[Sequence[float]], bias: Sequence[float], class_mask: int, threshold: float,
+                  prefix: int, horizon: int, axes: int = AXES) -> str:
+    lines = [
+        "#ifndef ONSET_MODEL_H",
+        "#define ONSET_MODEL_H",
+        "",
+        "// 手势起始的前缀分类头（见 onset_head.h）",
+        "// 由 pc_controller/onset_trainer.py 生成，不要手工修改",
+        "",
+        "#include <stdint.h>",
+        "",
+        f"#define ONSET_MODEL_CLASSES {len(weights)}",
+        f"#define ONSET_MODEL_AXES {axes}",
+        f"#define ONSET_MODEL_FEATURES {2 * axes}",
+        f"#define ONSET_MODEL_PREFIX_FRAMES {prefix}",
+        f"#define ONSET_MODEL_HORIZON_FRAMES {horizon}",
+        "",
+    ]
+    if weights:
+        lines.append(f"static const float kOnsetWeights[{len(weights)} * {2 * axes}] = {{")
+        for row in weights:
+            lines.append("    " + " ".join(f"{v:.9g}f," for v in row))
+        lines.append("};")
+        lines.append(f"static const float kOnsetBias[{len(bias)}] = {{" + ", ".join(f"{b:.9g}f" for b in bias) + "};")
+    else:
+        lines.append("static const float kOnsetWeights[1] = {0.0f};")
+        lines.append("static const float kOnsetBias[1] = {0.0f};")
+    lines.append(f"static const uint32_t kOnsetClassMask = 0x{class_mask:02x};")
+    lines.append(f"static const float kOnsetThreshold = {threshold:.6g}f;")
+    lines += ["", "#endif", ""]
+    return "\n".join(lines)
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    parser = argparse.ArgumentParser(description="Train the firmware onset prefix head")
+    parser.add_argument("files", nargs="+",
+                        help="Edge Impulse CSV recordings or session corpora (labels come from the full model)")
+    parser.add_argument("--binary", default=DEFAULT_BINARY, help="host_replay program")
+    parser.add_argument("--build", action="store_true", help=f"rebuild host_replay with {BUILD_FLAGS}")
+    parser.add_argument("--jobs", type=int, default=os.cpu_count() or 1, help="parallel replay processes")
+    parser.add_argument("--prefix", type=int, default=DEFAULT_PREFIX, help="frames the head looks at")
+    parser.add_argument("--horizon", type=int, default=0,
+                        help="frames to wait for the full model (default: window minus prefix, plus two strides)")
+    parser.add_argument("--precision", type=float, default=0.9,
+                        help="required share of provisional onsets the full model goes on to confirm")
+    parser.add_argument("--epochs", type=int, default=300, help="gradient descent epochs")
+    parser.add_argument("--output", default=DEFAULT_OUTPUT, help="generated header")
+    args = parser.parse_args(argv)
+
+    if not 2 <= args.prefix < WINDOW_FRAMES:
+        print(f"[Onset] --prefix must be between 2 and {WINDOW_FRAMES - 1} frames")
+        return 1
+    horizon = args.horizon or WINDOW_FRAMES - args.prefix + 4
+    if args.build:
+        build(BUILD_FLAGS)
+    if not os.path.exists(args.binary):
+        print(f"[Onset] {args.binary} not found, build it with --build")
+        return 1
+
+    files = expand_inputs(args.files)
+    with ThreadPoolExecutor(max_workers=max(1, args.jobs)) as pool:
+        results = list(pool.map(lambda path: replay_file(args.binary, path), files))
+    idle = MODEL_LABELS.index("idle")
+    recordings = []
+    for path, result in zip(files, results):
+        timestamps, raw = load_frames(path)
+        recordings.append(labelled_prefixes(result, resample(timestamps, raw), args.prefix, horizon, idle))
+    samples = [s for recording in recordings for s in recording]
+    print(f"[Onset] {len(samples)} prefixes from {len(results)} recordings, "
+          f"{args.prefix} frames ({1000.0 * args.prefix / MODEL_HZ:.0f} ms), horizon {horizon} frames")
+    if not samples:
+        print("[Onset] No classified windows (is host_replay built?)")
+        return 1
+
+    points = [features for _, features, _, _ in samples]
+    targets = [target for _, _, target, _ in samples]
+    weights, bias, mean, std = train_softmax(points, targets, len(MODEL_LABELS), epochs=args.epochs)
+    folded, folded_bias = fold_head(weights, bias, mean, std)
+
+    decisions = [head_decision(features, folded, folded_bias) + (target,) for _, features, target, _ in samples]
+    gestures = [MODEL_LABELS.index(name) for name in GESTURE_LABELS]
+    threshold = select_threshold(decisions, gestures, args.precision)
+    class_mask = sum(1 << k for k in gestures) if threshold is not None else 0
+    if threshold is None:
+        print(f"[Onset] No threshold reaches {args.precision:.3f} precision, the head will never fire")
+        threshold = 1.0
+    else:
+        threshold = math.floor(threshold * 1e6) / 1e6
+        stats = OnsetStats()
+        for recording in recordings:
+            steps = []
+            for frame, features, _, label in recording:
+                top, p = head_decision(features, folded, folded_bias)
+                steps.append((frame, top if top in gestures and p >= threshold else -1, label))
+            simulate(steps, horizon, idle, stats)
+        lead_ms = 1000.0 * stats.lead_frames / stats.confirmed / MODEL_HZ if stats.confirmed else 0.0
+        print(f"[Onset] Threshold {threshold:.4f}: {stats.onsets} provisional onsets, {stats.confirmed} confirmed "
+              f"{lead_ms:.0f} ms ahead of the full model on average, {stats.canceled} canceled")
+
+    with open(args.output, "w", encoding="utf-8") as f:
+        f.write(format_header(folded, folded_bias, class_mask, threshold, args.prefix, horizon))
+    print(f"[Onset] Head written to {args.output}")
+    print("[Onset] build_flags: -DINFERENCE_ONSET_HEAD=1")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,23 @@
+"""
+Percentiles
+
+The one percentile definition the controller's tools share: benchmark and
+latency reports (ble_manager, ble_session, event_publisher, gesture_handler),
+the regression gate and dashboard (latency_gate, perf_dashboard) and the
+profiler summaries (zone_timeline, renode_bench) all rank values the same way,
+so their p50 / p99 can be compared with each other.
+"""
+
+import math
+from typing import Iterable
+
+
+def percentile(values: Iterable[float], p: float) -> float:
+    """Nearest-rank percentile, p in 0..1: the smallest value with at least a fraction p of all values at or below it.
+
+    Always one of the values (no interpolation), so device counters and cycle counts stay exact; 0.0 when empty.
+    """
+    ordered = sorted(values)
+    if not ordered:
+        return 0.0
+    return ordered[min(len(ordered) - 1, max(0, math.ceil(p * len(ordered)) - 1))]
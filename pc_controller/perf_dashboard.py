@@ -0,0 +1,388 @@
+"""
+Performance Dashboard
+
+Collects the numbers the benchmarks already print into one time series, one
+record per commit, and renders trend charts that mark regressions, so
+performance is tracked per commit instead of read off scattered logs.
+
+Sources ("collect"; any subset, each one optional):
+    --bench    host microbenchmark JSON (src/host/bench_main.cpp, bench_compare.py)
+                   bench.<name>.median_ns
+    --replay   host replay outputs (replay_runner.py), pooled over all files
+                   host.latency_p50_us / p99_us, host.classify_p50_us, host.dsp_per_window_us
+    --serial   board serial logs: RAM budget ("mem"), thread stacks, "stats", "zones",
+               and the replay "stage," / "memory," lines (device_replay.py, latency_gate.py)
+                   ram.*_bytes, arena.*_bytes, stack.<thread>.peak_bytes, stats.<name>.p50 / p99,
+                   zone.<name>.mean_us / p95_us, stage.<name>.mean_us / max_us, memory.misplaced
+    --ble      ble_benchmark.py output: RTT, notification throughput and the inference
+               benchmark table (ei_impulse_result_timing_t stages)
+                   ble.host_rtt_p50_ms / p99_ms, ble.device_rtt_*, ble.*_kbps, inference.<stage>.p50_us / p99_us
+    --map      linker map (map_budget.py)
+                   build.flash_bytes, build.ram_bytes
+
+The history is a JSON-lines file; collecting again for the same commit adds to
+its record (later values win), so host and board numbers can be gathered in
+separate steps. Metric names carry their unit and direction: *_kbps is better
+when higher, everything else when lower.
+
+"render" writes a self-contained HTML page: one small chart per metric, grouped
+by the first part of the name. A point is a regression when it is worse than
+the median of the --window points before it by more than the tolerance
+(default 10 %, 2 % for *_bytes like latency_gate.py); regressions are drawn
+red and the latest commit's are listed at the top. With --check the exit code
+is 1 when the latest commit regressed.
+
+Usage:
+    python perf_dashboard.py collect --history perf.jsonl --bench bench.json --map firmware.map --replay out/*.txt
+    python perf_dashboard.py collect --history perf.jsonl --serial board.log --ble ble.log
+    python perf_dashboard.py render --history perf.jsonl -o perf.html --check
+"""
+
+import argparse
+import html
+import json
+import re
+import statistics
+import subprocess
+import sys
+import time
+from dataclasses import dataclass
+from typing import Dict, List, Optional, Sequence
+
+from bench_compare import load as load_bench
+from device_replay import parse_memory, parse_stages
+from map_budget import analyze
+from percentiles import percentile
+from replay_runner import parse_output
+from zone_timeline import parse_dump, summary
+
+SCHEMA = 1
+
+Metrics = Dict[str, float]
+
+# Board log lines (src/memory_module.cpp, src/thread_module.cpp, src/stats_module.cpp)
+MEMORY_PATTERNS = [
+    ("ram.static_bytes", re.compile(r"\[Memory\]\s+static data \+ bss\s+(\d+) B")),
+    ("ram.heap_bytes", re.compile(r"\[Memory\]\s+heap in use\s+(\d+) B")),
+    ("ram.free_bytes", re.compile(r"\[Memory\]\s+free\s+(-?\d+) B")),
+    ("arena.tensor_bytes", re.compile(r"\[Memory\]\s+tensor arena\s+\d+ B \(tensors (\d+)")),
+    ("arena.minimum_bytes", re.compile(r"\[Memory\]\s+arena minimum (\d+) B")),
+    ("arena.dsp_heap_peak_bytes", re.compile(r"\[Memory\]\s+DSP heap\s+(\d+) B peak")),
+    ("memory.misplaced", re.compile(r"\[Memory\] Placement: \d+ hot buffers checked, (\d+) misplaced")),
+]
+THREAD_LINE = re.compile(r"\[Threads\] (\S+)\s+prio\s+-?\d+, stack\s+\d+ B, peak\s+(\d+) B")
+STATS_LINE = re.compile(r"\[Stats\] (\S+) n \d+ p50 (\d+) p90 \d+ p99 (\d+) max \d+")
+
+# ble_benchmark.py output
+RTT_LINE = re.compile(r"(host|device)\s+RTT p50\s+([\d.]+) ms\s+p95\s+[\d.]+ ms\s+p99\s+([\d.]+) ms")
+SENT_LINE = re.compile(r"Saturation: device sent .*\(([\d.]+) kbit/s\)")
+RECEIVED_LINE = re.compile(r"host received .*\(([\d.]+) kbit/s\)")
+STAGE_ROW = re.compile(r"^\s+(\w+)\s+(\d+)\s+(\d+)\s+(\d+)\s+(\d+)\s+(\d+)\s*$")
+
+
+# ==================== Sources ====================
+
+def bench_metrics(text: str) -> Metrics:
+    return {f"bench.{name}.median_ns": result.median_ns for name, result in load_bench(text).items()}
+
+
+def replay_metrics(texts: Sequence[str]) -> Metrics:
+    """Percentiles over every classified window of the host replay outputs."""
+    results = [parse_output("", text) for text in texts]
+    windows = [w for result in results for w in result.windows]
+    if not windows:
+        return {}
+    latencies = [w.latency_us for w in windows]
+    return {"host.latency_p50_us": percentile(latencies, 0.50), "host.latency_p99_us": percentile(latencies, 0.99),
+            "host.classify_p50_us": percentile([w.classify_us for w in windows], 0.50),
+            "host.dsp_per_window_us": sum(r.dsp_us for r in results) / len(windows)}
+
+
+def serial_metrics(text: str) -> Metrics:
+    """The last value of every recognised line in a board log."""
+    metrics: Metrics = {}
+    lines = text.splitlines()
+    for line in lines:
+        for name, pattern in MEMORY_PATTERNS:
+            match = pattern.search(line)
+            if match:
+                metrics[name] = float(match.group(1))
+        match = THREAD_LINE.search(line)
+        if match:
+            metrics[f"stack.{match.group(1)}.peak_bytes"] = float(match.group(2))
+        match = STATS_LINE.search(line)
+        if match:
+            metrics[f"stats.{match.group(1)}.p50"] = float(match.group(2))
+            metrics[f"stats.{match.group(1)}.p99"] = float(match.group(3))
+    memory = parse_memory(text)
+    if memory is not None:
+        metrics["ram.high_water_bytes"] = float(memory[0])
+    for name, stage in parse_stages(text).items():
+        metrics[f"stage.{name}.mean_us"] = float(stage.mean_us)
+        metrics[f"stage.{name}.max_us"] = float(stage.max_us)
+    dump = parse_dump(lines)
+    if dump is not None:
+        for name, _, _, mean, p95, _ in summary(dump):
+            metrics[f"zone.{name}.mean_us"] = mean
+            metrics[f"zone.{name}.p95_us"] = p95
+    return metrics
+
+
+def ble_metrics(text: str) -> Metrics:
+    metrics: Metrics = {}
+    in_table = False
+    for line in text.splitlines():
+        match = RTT_LINE.search(line)
+        if match:
+            metrics[f"ble.{match.group(1)}_rtt_p50_ms"] = float(match.group(2))
+            metrics[f"ble.{match.group(1)}_rtt_p99_ms"] = float(match.group(3))
+        match = SENT_LINE.search(line)
+        if match:
+            metrics["ble.device_kbps"] = float(match.group(1))
+        match = RECEIVED_LINE.search(line)
+        if match:
+            metrics["ble.host_kbps"] = float(match.group(1))
+        if line.startswith("Inference ("):
+            in_table = True
+            continue
+        if not in_table or line.strip().startswith("stage"):
+            continue
+        match = STAGE_ROW.match(line)
+        if match:
+            metrics[f"inference.{match.group(1)}.p50_us"] = float(match.group(3))
+            metrics[f"inference.{match.group(1)}.p99_us"] = float(match.group(5))
+        else:
+            in_table = False
+    return metrics
+
+
+def map_metrics(text: str) -> Metrics:
+    total = analyze(text).total
+    return {"build.flash_bytes": float(total.flash), "build.ram_bytes": float(total.ram)}
+
+
+# ==================== History ====================
+
+def load_history(path: str) -> List[dict]:
+    """One record per commit in first-collected order, later collections merged into it."""
+    records: Dict[str, dict] = {}
+    try:
+        with open(path, encoding="utf-8") as f:
+            lines = f.readlines()
+    except FileNotFoundError:
+        return []
+    for line in lines:
+        if not line.strip():
+            continue
+        entry = json.loads(line)
+        if entry.get("schema") != SCHEMA:
+            raise ValueError(f"unsupported history schema {entry.get('schema')!r}")
+        record = records.setdefault(entry["commit"], {"commit": entry["commit"], "time": entry["time"],
+                                                      "metrics": {}})
+        record["metrics"].update(entry["metrics"])
+    return list(records.values())
+
+
+def append_history(path: str, commit: str, metrics: Metrics, when: Optional[float] = None) -> None:
+    stamp = time.strftime("%Y-%m-%dT%H:%M:%S", time.localtime(time.time() if when is None else when))
+    with open(path, "a", encoding="utf-8") as f:
+        f.write(json.dumps({"schema": SCHEMA, "commit": commit, "time": stamp, "metrics": metrics},
+                           sort_keys=True) + "\n")
+
+
+def current_commit() -> Optional[str]:
+    try:
+        completed = subprocess.run(["git", "rev-parse", "--short", "HEAD"], stdout=subprocess.PIPE,
+                                   stderr=subprocess.DEVNULL, universal_newlines=True, check=True)
+    except (OSError, subprocess.CalledProcessError):
+        return None
+    return completed.stdout.strip() or None
+
+
+# ==================== Regressions ====================
+
+def higher_is_better(name: str) -> bool:
+    return name.endswith("_kbps")
+
+
+def tolerance_for(name: str, tolerance: float, size_tolerance: float) -> float:
+    return size_tolerance if name.endswith("_bytes") else tolerance
+
+
+@dataclass
+class Point:
+    commit: str
+    value: float
+    baseline: Optional[float]   # median of the preceding window, None for the first point
+    regressed: bool
+
+    @property
+    def change(self) -> Optional[float]:
+        """Relative change against the baseline, +0.10 = 10 % higher."""
+        if self.baseline is None or self.baseline == 0:
+            return None
+        return self.value / self.baseline - 1.0
+
+
+def series(history: Sequence[dict], name: str, window: int, tolerance: float) -> List[Point]:
+    """The metric's points in commit order, each judged against the median of up to window earlier ones."""
+    points: List[Point] = []
+    for record in history:
+        value = record["metrics"].get(name)
+        if value is None:
+            continue
+        earlier = [p.value for p in points[-window:]]
+        baseline = statistics.median(earlier) if earlier else None
+        regressed = False
+        if baseline is not None:
+            if higher_is_better(name):
+                regressed = value < baseline * (1.0 - tolerance)
+            else:
+                regressed = value > baseline * (1.0 + tolerance) if baseline > 0 else value > 0
+        points.append(Point(record["commit"], value, baseline, regressed))
+    return points
+
+
+def metric_names(history: Sequence[dict]) -> List[str]:
+    return sorted({name for record in history for name in record["metrics"]})
+
+
+def latest_regressions(history: Sequence[dict], window: int, tolerance: float,
+                       size_tolerance: float) -> List[tuple]:
+    """(metric, point) for every metric whose value at the latest commit regressed."""
+    if not history:
+        return []
+    latest = history[-1]["commit"]
+    found = []
+    for name in metric_names(history):
+        points = series(history, name, window, tolerance_for(name, tolerance, size_tolerance))
+        if points and points[-1].commit == latest and points[-1].regressed:
+            found.append((name, points[-1]))
+    return found
+
+
+# ==================== Rendering ====================
+
+def chart_svg(name: str, points: Sequence[Point], width: int = 360, height: int = 120) -> str:
+    """A line chart of one metric; regressed points red, each point's commit and value in its tooltip."""
+    margin, top = 8, 18
+    values = [p.value for p in points]
+    low, high = min(values), max(values)
+    span = (high - low) or (abs(high) or 1.0)
+    step = (width - 2 * margin) / max(len(points) - 1, 1)
+
+    def xy(i: int, value: float) -> tuple:
+        return margin + i * step, top + (height - top - margin) * (1.0 - (value - low) / span)
+
+    coordinates = [xy(i, p.value) for i, p in enumerate(points)]
+    parts = [f'<text x="{margin}" y="12" font-size="11">{html.escape(name)} '
+             f'({low:g} .. {high:g})</text>',
+             '<polyline fill="none" stroke="#4e79a7" stroke-width="1.5" points="' +
+             " ".join(f"{x:.1f},{y:.1f}" for x, y in coordinates) + '"/>']
+    for (x, y), point in zip(coordinates, points):
+        colour = "#e15759" if point.regressed else "#4e79a7"
+        change = f" ({point.change * 100:+.1f}% vs median)" if point.change is not None else ""
+        parts.append(f'<circle cx="{x:.1f}" cy="{y:.1f}" r="{4 if point.regressed else 2.5}" fill="{colour}">'
+                     f'<title>{html.escape(point.commit)}: {point.value:g}{change}</title></circle>')
+    return (f'<svg xmlns="http://www.w3.org/2000/svg" width="{width}" height="{height}" '
+            f'font-family="sans-serif">{"".join(parts)}</svg>')
+
+
+def format_change(point: Point) -> str:
+    return f"{point.change * 100:+.1f}%" if point.change is not None else "from 0"
+
+
+def render_html(history: Sequence[dict], window: int, tolerance: float, size_tolerance: float) -> str:
+    regressions = latest_regressions(history, window, tolerance, size_tolerance)
+    latest = history[-1]["commit"] if history else "-"
+    rows = "".join(f"<tr><td>{html.escape(name)}</td><td>{point.value:g}</td><td>{point.baseline:g}</td>"
+                   f"<td>{format_change(point)}</td></tr>" for name, point in regressions)
+    body = [f"<h1>Performance: {len(history)} commits, latest {html.escape(latest)}</h1>"]
+    if regressions:
+        body.append(f"<h2 style=\"color:#e15759\">{len(regressions)} regressed at {html.escape(latest)}</h2>"
+                    f"<table><tr><th>metric</th><th>value</th><th>median before</th><th>change</th></tr>"
+                    f"{rows}</table>")
+    else:
+        body.append("<p>No regressions at the latest commit.</p>")
+    groups: Dict[str, List[str]] = {}
+    for name in metric_names(history):
+        points = series(history, name, window, tolerance_for(name, tolerance, size_tolerance))
+        groups.setdefault(name.split(".")[0], []).append(chart_svg(name, points))
+    for group, charts in groups.items():
+        body.append(f"<h2>{html.escape(group)}</h2><div>{''.join(charts)}</div>")
+    return ("<!DOCTYPE html><html><head><meta charset=\"utf-8\"><title>Performance</title></head>"
+            f"<body style=\"font-family:sans-serif\">{''.join(body)}</body></html>")
+
+
+# ==================== Command line ====================
+
+def read(path: str) -> str:
+    with open(path, encoding="utf-8", errors="replace") as f:
+        return f.read()
+
+
+def collect(args) -> int:
+    commit = args.commit or current_commit()
+    if commit is None:
+        print("[Perf] Not in a git checkout: pass --commit")
+        return 2
+    metrics: Metrics = {}
+    if args.bench:
+        metrics.update(bench_metrics(read(args.bench)))
+    if args.replay:
+        metrics.update(replay_metrics([read(path) for path in args.replay]))
+    for path in args.serial or []:
+        metrics.update(serial_metrics(read(path)))
+    if args.ble:
+        metrics.update(ble_metrics(read(args.ble)))
+    if args.map:
+        metrics.update(map_metrics(read(args.map)))
+    if not metrics:
+        print("[Perf] No metrics found in the given sources")
+        return 2
+    append_history(args.history, commit, metrics)
+    print(f"[Perf] {commit}: {len(metrics)} metrics added to {args.history}")
+    return 0
+
+
+def render(args) -> int:
+    history = load_history(args.history)
+    if not history:
+        print(f"[Perf] {args.history} has no records")
+        return 2
+    with open(args.output, "w", encoding="utf-8") as f:
+        f.write(render_html(history, args.window, args.tolerance, args.size_tolerance))
+    regressions = latest_regressions(history, args.window, args.tolerance, args.size_tolerance)
+    print(f"[Perf] Wrote {args.output}: {len(metric_names(history))} metrics over {len(history)} commits")
+    for name, point in regressions:
+        print(f"[Perf] REGRESSED: {name} {point.value:g} vs median {point.baseline:g} ({format_change(point)})")
+    return 1 if args.check and regressions else 0
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    parser = argparse.ArgumentParser(description="Collect benchmark results per commit and chart their trends")
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    collect_parser = commands.add_parser("collect", help="add this commit's numbers to the history")
+    collect_parser.add_argument("--history", required=True, help="JSON-lines history file (created if missing)")
+    collect_parser.add_argument("--commit", help="commit to record under (default: git rev-parse --short HEAD)")
+    collect_parser.add_argument("--bench", help="host microbenchmark JSON")
+    collect_parser.add_argument("--replay", nargs="+", help="host replay outputs")
+    collect_parser.add_argument("--serial", nargs="+", help="board serial logs")
+    collect_parser.add_argument("--ble", help="ble_benchmark.py output")
+    collect_parser.add_argument("--map", help="linker map of the firmware")
+
+    render_parser = commands.add_parser("render", help="write the trend charts")
+    render_parser.add_argument("--history", required=True, help="JSON-lines history file")
+    render_parser.add_argument("-o", "--output", default="perf.html", help="HTML page to write")
+    render_parser.add_argument("--window", type=int, default=5, help="earlier commits in each baseline median")
+    render_parser.add_argument("--tolerance", type=float, default=0.10, help="allowed growth of timings")
+    render_parser.add_argument("--size-tolerance", type=float, default=0.02, help="allowed growth of *_bytes")
+    render_parser.add_argument("--check", action="store_true", help="exit 1 when the latest commit regressed")
+
+    args = parser.parse_args(argv)
+    return collect(args) if args.command == "collect" else render(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,417 @@
+"""
+Raw IMU Recorder
+
+Decodes the firmware's binary raw-recording stream (see include/record_format.h)
+and writes Edge Impulse compatible CSV or CBOR data acquisition files.
+
+Usage:
+    python raw_recorder.py --port COM5 --seconds 10 --out wave.csv
+    python raw_recorder.py --ble --seconds 10 --out wave.cbor
+    python raw_recorder.py --ble --window --seconds 10 --out window.csv
+    python raw_recorder.py --input capture.bin --out capture.csv
+"""
+
+import argparse
+import asyncio
+import json
+import struct
+import sys
+import time
+from dataclasses import dataclass, field
+from typing import Iterable, Iterator, List, Optional, Tuple
+
+
+SYNC = b"\xa5\x5a"
+TYPE_IMU_RAW = 0x01
+# Model input samples (fused axes, after calibration and resampling); the
+# "timestamps" are sample indices at the model rate
+TYPE_WINDOW = 0x02
+HEADER_BYTES = 4
+PAYLOAD_HEADER_BYTES = 8
+PACKET_MAX_BYTES = 244
+
+# Arduino_BMI270_BMM150 default ranges: +-4 g / +-2000 dps
+ACC_LSB_PER_G = 8192.0
+GYR_LSB_PER_DPS = 16.384
+
+CHANNEL_NAMES = ["accX", "accY", "accZ", "gyrX", "gyrY", "gyrZ"]
+CHANNEL_UNITS = ["g", "g", "g", "dps", "dps", "dps"]
+
+# BLE recording characteristics (see ble_module.cpp)
+RECORD_CONTROL_UUID = "19b10014-e8f2-537e-4f6c-d104768a1214"
+RECORD_DATA_UUID = "19b10015-e8f2-537e-4f6c-d104768a1214"
+# Window sample stream, sent while subscribed and alongside classification
+WINDOW_UUID = "19b1001f-e8f2-537e-4f6c-d104768a1214"
+WINDOW_RATE_HZ = 48.0
+TRANSPORT_OFF = 0
+TRANSPORT_USB = 1
+TRANSPORT_BLE = 2
+
+
+@dataclass
+class RawPacket:
+    """One decoded recording packet."""
+    seq: int
+    channel_mask: int
+    timestamps_us: List[int]  # sample indices for TYPE_WINDOW packets
+    frames: List[List[int]]
+    packet_type: int = TYPE_IMU_RAW
+
+
+@dataclass
+class DecoderStats:
+    packets: int = 0
+    frames: int = 0
+    crc_errors: int = 0
+    lost_packets: int = 0
+    skipped_bytes: int = 0
+
+
+def crc8(data: bytes) -> int:
+    """CRC-8, polynomial 0x07, initial value 0 (matches RecordPacketEncoder::crc8)."""
+    crc = 0
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def _zigzag_encode(value: int) -> int:
+    return value << 1 if value >= 0 else ((-value) << 1) - 1
+
+
+def _zigzag_decode(value: int) -> int:
+    return (value >> 1) ^ -(value & 1)
+
+
+def _put_varint(out: bytearray, value: int) -> None:
+    while value >= 0x80:
+        out.append((value & 0x7F) | 0x80)
+        value >>= 7
+    out.append(value)
+
+
+def _get_varint(data: bytes, pos: int) -> Tuple[int, int]:
+    value = 0
+    shift = 0
+    while True:
+        if pos >= len(data) or shift > 28:
+            raise ValueError("truncated varint")
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        if not byte & 0x80:
+            return value, pos
+        shift += 7
+
+
+def channel_count(channel_mask: int) -> int:
+    return bin(channel_mask & 0x3F).count("1")
+
+
+def encode_packet(seq: int, channel_mask: int, timestamps_us: List[int],
+                  frames: List[List[int]], packet_type: int = TYPE_IMU_RAW) -> bytes:
+    """Encode one packet exactly like the firmware encoder (used for tests and simulation)."""
+    payload = bytearray(struct.pack("<HIBB", seq & 0xFFFF, timestamps_us[0] & 0xFFFFFFFF,
+                                    channel_mask, len(frames)))
+    last_ts = timestamps_us[0]
+    last = [0] * channel_count(channel_mask)
+    for ts, frame in zip(timestamps_us, frames):
+        dt = (ts - last_ts) & 0xFFFFFFFF
+        if dt >= 0x80000000:
+            dt -= 0x100000000
+        _put_varint(payload, _zigzag_encode(dt))
+        last_ts = ts
+        for c, value in enumerate(frame):
+            _put_varint(payload, _zigzag_encode(value - last[c]))
+            last[c] = value
+    body = bytes([packet_type, len(payload)]) + bytes(payload)
+    return SYNC + body[0:2] + bytes(payload) + bytes([crc8(body)])
+
+
+def decode_payload(payload: bytes, packet_type: int = TYPE_IMU_RAW) -> RawPacket:
+    """Decode the payload of a recording packet (after its CRC was checked)."""
+    seq, t0_us, channel_mask, frame_count = struct.unpack_from("<HIBB", payload, 0)
+    channels = channel_count(channel_mask)
+    pos = PAYLOAD_HEADER_BYTES
+    timestamp = t0_us
+    last = [0] * channels
+    timestamps_us: List[int] = []
+    frames: List[List[int]] = []
+    for _ in range(frame_count):
+        dt, pos = _get_varint(payload, pos)
+        timestamp = (timestamp + _zigzag_decode(dt)) & 0xFFFFFFFF
+        frame = []
+        for c in range(channels):
+            delta, pos = _get_varint(payload, pos)
+            last[c] += _zigzag_decode(delta)
+            frame.append(last[c])
+        timestamps_us.append(timestamp)
+        frames.append(frame)
+    return RawPacket(seq, channel_mask, timestamps_us, frames, packet_type)
+
+
+def window_to_timestamps(packet: RawPacket, rate_hz: float = WINDOW_RATE_HZ) -> RawPacket:
+    """A window packet with its sample indices converted to microseconds at the model rate."""
+    interval_us = 1e6 / rate_hz
+    timestamps_us = [int(round(index * interval_us)) & 0xFFFFFFFF for index in packet.timestamps_us]
+    return RawPacket(packet.seq, packet.channel_mask, timestamps_us, packet.frames, packet.packet_type)
+
+
+class StreamDecoder:
+    """
+    Incremental decoder for the raw recording byte stream.
+
+    Stray text on the serial port (boot messages, logs) is skipped: the decoder
+    resynchronises on the sync bytes and only accepts packets whose CRC matches.
+    One stream carries one packet type; packets of other types are skipped.
+    """
+
+    def __init__(self, packet_type: int = TYPE_IMU_RAW):
+        self._packet_type = packet_type
+        self._buffer = bytearray()
+        self._last_seq: Optional[int] = None
+        self.stats = DecoderStats()
+
+    def feed(self, data: bytes) -> Iterator[RawPacket]:
+        """Append received bytes and yield every complete packet."""
+        self._buffer.extend(data)
+        while True:
+            start = self._buffer.find(SYNC)
+            if start < 0:
+                keep = 1 if self._buffer.endswith(SYNC[:1]) else 0
+                self.stats.skipped_bytes += len(self._buffer) - keep
+                del self._buffer[:len(self._buffer) - keep]
+                return
+            if start > 0:
+                self.stats.skipped_bytes += start
+                del self._buffer[:start]
+            if len(self._buffer) < HEADER_BYTES:
+                return
+
+            packet_type = self._buffer[2]
+            length = self._buffer[3]
+            total = HEADER_BYTES + length + 1
+            if packet_type != self._packet_type or total > PACKET_MAX_BYTES or length < PAYLOAD_HEADER_BYTES:
+                self._skip(1)
+                continue
+            if len(self._buffer) < total:
+                return
+
+            body = bytes(self._buffer[2:HEADER_BYTES + length])
+            if crc8(body) != self._buffer[total - 1]:
+                self.stats.crc_errors += 1
+                self._skip(1)
+                continue
+
+            try:
+                packet = decode_payload(body[2:], packet_type)
+            except (ValueError, struct.error):
+                self.stats.crc_errors += 1
+                self._skip(1)
+                continue
+            del self._buffer[:total]
+
+            if self._last_seq is not None:
+                self.stats.lost_packets += (packet.seq - self._last_seq - 1) & 0xFFFF
+            self._last_seq = packet.seq
+            self.stats.packets += 1
+            self.stats.frames += len(packet.frames)
+            yield packet
+
+    def _skip(self, count: int) -> None:
+        self.stats.skipped_bytes += count
+        del self._buffer[:count]
+
+
+@dataclass
+class Recording:
+    """Decoded frames with monotonic timestamps (microseconds since the first frame)."""
+    channel_mask: int = 0
+    timestamps_us: List[int] = field(default_factory=list)
+    frames: List[List[int]] = field(default_factory=list)
+    _last_raw_ts: Optional[int] = None
+    _offset: int = 0
+
+    def add(self, packet: RawPacket) -> None:
+        if not self.channel_mask:
+            self.channel_mask = packet.channel_mask
+        if packet.channel_mask != self.channel_mask:
+            return
+        for ts, frame in zip(packet.timestamps_us, packet.frames):
+            if self._last_raw_ts is not None and ts < self._last_raw_ts - 0x80000000:
+                self._offset += 0x100000000  # micros() wrapped
+            self._last_raw_ts = ts
+            self.timestamps_us.append(ts + self._offset)
+            self.frames.append(frame)
+
+    def channels(self) -> List[int]:
+        return [c for c in range(6) if self.channel_mask & (1 << c)]
+
+    def values(self) -> List[List[float]]:
+        """Frames converted to physical units (g / dps)."""
+        scales = [1.0 / (ACC_LSB_PER_G if c < 3 else GYR_LSB_PER_DPS) for c in self.channels()]
+        return [[v * s for v, s in zip(frame, scales)] for frame in self.frames]
+
+    def interval_ms(self) -> float:
+        if len(self.timestamps_us) < 2:
+            return 0.0
+        return (self.timestamps_us[-1] - self.timestamps_us[0]) / (len(self.timestamps_us) - 1) / 1000.0
+
+
+def write_csv(recording: Recording, path: str) -> None:
+    """Edge Impulse CSV: timestamp in milliseconds, one column per axis."""
+    names = [CHANNEL_NAMES[c] for c in recording.channels()]
+    start = recording.timestamps_us[0] if recording.timestamps_us else 0
+    with open(path, "w", encoding="utf-8", newline="") as f:
+        f.write("timestamp," + ",".join(names) + "\n")
+        for ts, values in zip(recording.timestamps_us, recording.values()):
+            f.write(f"{(ts - start) / 1000.0:.3f}," + ",".join(f"{v:.6f}" for v in values) + "\n")
+
+
+def _cbor(value) -> bytes:
+    """Minimal CBOR encoder for the Edge Impulse data acquisition format."""
+    def head(major: int, n: int) -> bytes:
+        if n < 24:
+            return bytes([(major << 5) | n])
+        for info, fmt in ((24, ">B"), (25, ">H"), (26, ">I"), (27, ">Q")):
+            if n < (1 << (8 * struct.calcsize(fmt))):
+                return bytes([(major << 5) | info]) + struct.pack(fmt, n)
+        raise ValueError("integer too large")
+
+    if isinstance(value, bool):
+        return b"\xf5" if value else b"\xf4"
+    if isinstance(value, int):
+        return head(0, value) if value >= 0 else head(1, -1 - value)
+    if isinstance(value, float):
+        return b"\xfb" + struct.pack(">d", value)
+    if isinstance(value, str):
+        data = value.encode("utf-8")
+        return head(3, len(data)) + data
+    if isinstance(value, (list, tuple)):
+        return head(4, len(value)) + b"".join(_cbor(v) for v in value)
+    if isinstance(value, dict):
+        return head(5, len(value)) + b"".join(_cbor(k) + _cbor(v) for k, v in value.items())
+    raise TypeError(f"unsupported CBOR type: {type(value)}")
+
+
+def acquisition_document(recording: Recording, device_type: str = "NANO33BLE_SENSE") -> dict:
+    """Edge Impulse data acquisition document (unsigned)."""
+    return {
+        "protected": {"ver": "v1", "alg": "none", "iat": int(time.time())},
+        "signature": "0" * 64,
+        "payload": {
+            "device_type": device_type,
+            "interval_ms": recording.interval_ms(),
+            "sensors": [{"name": CHANNEL_NAMES[c], "units": CHANNEL_UNITS[c]} for c in recording.channels()],
+            "values": recording.values(),
+        },
+    }
+
+
+def write_cbor(recording: Recording, path: str) -> None:
+    with open(path, "wb") as f:
+        f.write(_cbor(acquisition_document(recording)))
+
+
+def write_recording(recording: Recording, path: str) -> None:
+    if path.lower().endswith(".cbor"):
+        write_cbor(recording, path)
+    elif path.lower().endswith(".json"):
+        with open(path, "w", encoding="utf-8") as f:
+            json.dump(acquisition_document(recording), f)
+    else:
+        write_csv(recording, path)
+
+
+def decode_chunks(chunks: Iterable[bytes], decoder: StreamDecoder) -> Recording:
+    recording = Recording()
+    for chunk in chunks:
+        for packet in decoder.feed(chunk):
+            recording.add(packet)
+    return recording
+
+
+def _record_serial(port: str, seconds: float, decoder: StreamDecoder) -> Recording:
+    import serial  # pyserial
+
+    def chunks():
+        with serial.Serial(port, 115200, timeout=0.1) as ser:
+            ser.write(b"rec usb\n")
+            deadline = time.monotonic() + seconds
+            try:
+                while time.monotonic() < deadline:
+                    yield ser.read(4096)
+            finally:
+                ser.write(b"rec stop\n")
+
+    return decode_chunks(chunks(), decoder)
+
+
+async def _record_ble(seconds: float, decoder: StreamDecoder, window: bool = False) -> Recording:
+    from bleak import BleakClient, BleakScanner
+    from ble_manager import BLEManager
+
+    device = await BleakScanner.find_device_by_name(BLEManager.TARGET_DEVICE_NAME, timeout=10.0)
+    if device is None:
+        raise RuntimeError("device not found")
+
+    recording = Recording()
+
+    def on_packet(_sender, data: bytearray) -> None:
+        for packet in decoder.feed(bytes(data)):
+            recording.add(window_to_timestamps(packet) if window else packet)
+
+    async with BleakClient(device) as client:
+        if window:
+            # Classification keeps running; the stream only needs the subscription
+            await client.start_notify(WINDOW_UUID, on_packet)
+            await asyncio.sleep(seconds)
+            await client.stop_notify(WINDOW_UUID)
+            return recording
+        await client.start_notify(RECORD_DATA_UUID, on_packet)
+        await client.write_gatt_char(RECORD_CONTROL_UUID, bytes([TRANSPORT_BLE]), response=True)
+        await asyncio.sleep(seconds)
+        await client.write_gatt_char(RECORD_CONTROL_UUID, bytes([TRANSPORT_OFF]), response=True)
+        await client.stop_notify(RECORD_DATA_UUID)
+    return recording
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    parser = argparse.ArgumentParser(description="Record raw IMU data from the gesture firmware")
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--port", help="USB CDC serial port (e.g. COM5, /dev/ttyACM0)")
+    source.add_argument("--ble", action="store_true", help="record over BLE")
+    source.add_argument("--input", help="decode a previously captured binary stream")
+    parser.add_argument("--window", action="store_true",
+                        help="with --ble: record the samples fed to the model instead of raw sensor data")
+    parser.add_argument("--seconds", type=float, default=10.0, help="recording length")
+    parser.add_argument("--out", required=True, help="output file (.csv, .cbor or .json)")
+    args = parser.parse_args(argv)
+
+    if args.window and not args.ble:
+        parser.error("--window requires --ble")
+    decoder = StreamDecoder(TYPE_WINDOW if args.window else TYPE_IMU_RAW)
+    if args.input:
+        with open(args.input, "rb") as f:
+            recording = decode_chunks([f.read()], decoder)
+    elif args.ble:
+        recording = asyncio.run(_record_ble(args.seconds, decoder, args.window))
+    else:
+        recording = _record_serial(args.port, args.seconds, decoder)
+
+    stats = decoder.stats
+    print(f"[Record] {stats.frames} frames in {stats.packets} packets, "
+          f"{stats.lost_packets} lost, {stats.crc_errors} CRC errors, "
+          f"{recording.interval_ms():.3f} ms mean interval")
+    if not recording.frames:
+        print("[Record] No data received")
+        return 1
+    write_recording(recording, args.out)
+    print(f"[Record] Wrote {args.out}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,173 @@
+"""
+Renode Benchmark
+
+Runs the production firmware on an emulated Nano 33 BLE (Renode, nRF52840)
+with recorded IMU data and reports the cycle count of every profiler zone, so a
+latency change can be checked on every commit without a board.
+
+The env nano33ble_renode build is the production profile with the zone
+profiler on and the BMI270 driver replaced by src/renode/renode_imu.cpp: a
+memory-mapped FIFO (renode/imu_replay.py) hands out the recording at its
+sensor rate, paced by virtual time, and everything after the FIFO read-out
+(decimation, resampling, the model, post-processing) runs unchanged. When the
+recording is used up the firmware dumps the zone ring on UART0, which Renode
+writes to a file; this script parses it with zone_timeline.py.
+
+Renode counts one cycle per instruction at 64 MHz: no flash wait states, cache
+or bus contention, so the numbers are deterministic and good for comparing two
+builds, not for absolute latency (latency_gate.py on the board for that).
+
+-o writes the zones in the host benchmark format ("zone:<name>", cycles
+converted to ns at the emulated clock), so two runs compare with
+bench_compare.py like the host microbenchmarks.
+
+Usage:
+    pio run -e nano33ble_renode
+    python renode_bench.py data/gate/*.csv -o zones.json
+    python bench_compare.py baseline_zones.json zones.json
+"""
+
+import argparse
+import json
+import os
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+from typing import Dict, List, Optional, Sequence
+
+from device_replay import DEVICE_ODR_HZ, load_recording, to_device_rate
+from percentiles import percentile
+from zone_timeline import ZoneDump, parse_dump
+
+REPO_ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+DEFAULT_ELF = os.path.join(REPO_ROOT, ".pio", "build", "nano33ble_renode", "firmware.elf")
+SCRIPT = "renode/nano33ble.resc"
+
+# Data file read by renode/imu_replay.py
+DATA_MAGIC = b"IMUR"
+DATA_HEADER = struct.Struct("<4sHBBI")
+CHANNELS = 6
+DONE_LINE = "[Renode] done"
+
+
+def encode_imu_data(channel_mask: int, frames: Sequence[Sequence[int]], odr_hz: float = DEVICE_ODR_HZ) -> bytes:
+    """The FIFO contents: header, then every frame as 6 int16 with the absent channels zero."""
+    present = [c for c in range(CHANNELS) if channel_mask & (1 << c)]
+    out = bytearray(DATA_HEADER.pack(DATA_MAGIC, round(odr_hz), channel_mask & 0x3F, 0, len(frames)))
+    for frame in frames:
+        full = [0] * CHANNELS
+        for channel, value in zip(present, frame):
+            full[channel] = value
+        out += struct.pack(f"<{CHANNELS}h", *full)
+    return bytes(out)
+
+
+def load_recordings(paths: Sequence[str]) -> bytes:
+    """Recordings back to back at the device ODR; they must all have the same channels."""
+    mask: Optional[int] = None
+    frames: List[List[int]] = []
+    for path in paths:
+        channels, timestamps, values = load_recording(path)
+        if mask is not None and channels != mask:
+            raise ValueError(f"{path}: channels differ from the first recording")
+        mask = channels
+        frames.extend(to_device_rate(timestamps, values))
+    return encode_imu_data(mask or 0, frames)
+
+
+def zone_cycles(dump: ZoneDump) -> Dict[str, List[float]]:
+    """Cycle counts per zone, in zone order."""
+    scale = dump.clock_hz / 1e6
+    cycles: Dict[str, List[float]] = {}
+    for zone, (name, _) in sorted(dump.zones.items()):
+        values = [round(s.duration_us * scale) for s in dump.spans if s.zone == zone]
+        if values:
+            cycles[name] = values
+    return cycles
+
+
+def to_bench_json(dump: ZoneDump) -> dict:
+    """bench_compare.py format: one benchmark per zone, ns at the emulated clock, cycles alongside."""
+    benchmarks = []
+    ns_per_cycle = 1e9 / dump.clock_hz
+    for name, values in zone_cycles(dump).items():
+        stats = {"min": min(values), "median": percentile(values, 0.5), "max": max(values)}
+        benchmarks.append({"name": f"zone:{name}", "iterations": len(values),
+                           "ns_per_op": {k: v * ns_per_cycle for k, v in stats.items()}, "cycles": stats})
+    return {"schema": 1, "clock_hz": dump.clock_hz, "benchmarks": benchmarks}
+
+
+def format_summary(dump: ZoneDump) -> List[str]:
+    lines = [f"{'zone':<16}{'count':>7}{'mean':>12}{'p50':>12}{'p95':>12}{'max':>12}   (cycles)"]
+    for name, values in zone_cycles(dump).items():
+        lines.append(f"{name:<16}{len(values):>7}{sum(values) / len(values):>12.0f}{percentile(values, 0.5):>12.0f}"
+                     f"{percentile(values, 0.95):>12.0f}{max(values):>12.0f}")
+    if dump.overwritten:
+        lines.append(f"({dump.overwritten} older zones overwritten: raise PROFILER_ZONE_CAPACITY or shorten the run)")
+    return lines
+
+
+def run_renode(renode: str, elf: str, data: bytes, timeout_s: float) -> List[str]:
+    """Run the emulation until the firmware reports the end of the recording; the UART0 lines."""
+    with tempfile.TemporaryDirectory() as tmp:
+        data_path = os.path.join(tmp, "imu.bin")
+        log_path = os.path.join(tmp, "uart0.log")
+        with open(data_path, "wb") as f:
+            f.write(data)
+        commands = f"$bin=@{elf}; include @{SCRIPT}; uart0 CreateFileBackend @{log_path} true; start"
+        env = dict(os.environ, IMU_REPLAY_DATA=data_path)
+        process = subprocess.Popen([renode, "--disable-xwt", "--console", "--plain", "-e", commands],
+                                   cwd=REPO_ROOT, env=env, stdin=subprocess.DEVNULL, stdout=subprocess.DEVNULL)
+        lines: List[str] = []
+        try:
+            deadline = time.monotonic() + timeout_s
+            while time.monotonic() < deadline and process.poll() is None:
+                time.sleep(0.5)
+                if os.path.exists(log_path):
+                    with open(log_path, "r", encoding="utf-8", errors="replace") as f:
+                        lines = f.readlines()
+                    if any(DONE_LINE in line for line in lines):
+                        break
+        finally:
+            process.terminate()
+            try:
+                process.wait(timeout=10)
+            except subprocess.TimeoutExpired:
+                process.kill()
+        return lines
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    parser = argparse.ArgumentParser(description="Profile the firmware's zones on an emulated Nano 33 BLE")
+    parser.add_argument("recordings", nargs="+", help="Edge Impulse CSV recordings, played back to back")
+    parser.add_argument("--elf", default=DEFAULT_ELF, help="firmware built with env nano33ble_renode")
+    parser.add_argument("--renode", default="renode", help="Renode executable")
+    parser.add_argument("--timeout", type=float, default=600.0, help="seconds of wall time to wait")
+    parser.add_argument("-o", "--output", help="write the zones as bench_compare.py JSON")
+    args = parser.parse_args(argv)
+
+    if not os.path.exists(args.elf):
+        print(f"[Renode] {args.elf} not found: build it with pio run -e nano33ble_renode")
+        return 1
+    lines = run_renode(args.renode, os.path.abspath(args.elf), load_recordings(args.recordings), args.timeout)
+    dump = parse_dump(lines)
+    if dump is None or not dump.spans:
+        print("[Renode] No zone dump in the UART output")
+        for line in lines[-10:]:
+            print("    " + line.rstrip())
+        return 1
+    for line in lines:
+        if line.startswith("[Renode]"):
+            print(line.rstrip())
+    for line in format_summary(dump):
+        print(line)
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(to_bench_json(dump), f, indent=2)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
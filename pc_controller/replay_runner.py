@@ -0,0 +1,182 @@
+"""
+Offline Replay Runner
+
+Replays labelled recordings through the host build of the firmware inference
+pipeline (PlatformIO env "host_replay": the same sampler / inference threads,
+anti-alias decimation, resampling and model code as on the board, with the IMU
+replaced by a CSV reader) and reports accuracy and throughput.
+
+Every recording runs in its own host process, so a dataset is replayed in
+parallel on all cores. Files are labelled by their name prefix, the Edge
+Impulse convention (e.g. "idle.01.csv", "left.wave3.csv"); each classified
+window counts once in the confusion matrix. A session corpus
+(session_corpus.py) stands for all of its sessions, each replayed straight
+from the mapped file and labelled from the corpus.
+
+Usage:
+    pio run -e host_replay
+    python replay_runner.py data/*.csv
+    python replay_runner.py data.gcorpus
+    python replay_runner.py --build --build-flags "-DINFERENCE_INT8_WINDOW=0" data/*.csv
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+import time
+from concurrent.futures import ThreadPoolExecutor
+from dataclasses import dataclass, field
+from typing import Dict, List, Optional, Sequence, Tuple
+
+from session_corpus import expand_inputs, recording_label
+
+DEFAULT_BINARY = os.path.join(".pio", "build", "host_replay", "program")
+
+
+@dataclass
+class WindowResult:
+    frame: int
+    label: str
+    confidence: float
+    classify_us: int
+    latency_us: int
+
+
+@dataclass
+class ReplayResult:
+    path: str
+    windows: List[WindowResult] = field(default_factory=list)
+    sensor_frames: int = 0
+    output_frames: int = 0
+    wall_us: int = 0
+    dsp_us: int = 0
+    # (frame, int8 penultimate activations) per classified window, only with --features
+    features: List[Tuple[int, List[int]]] = field(default_factory=list)
+    # (frame, int8 first pooling output) per classified window and the class names, only with --pooled
+    pooled: List[Tuple[int, List[int]]] = field(default_factory=list)
+    labels: List[str] = field(default_factory=list)
+
+
+def parse_int8_hex(text: str) -> List[int]:
+    return [b - 256 if b > 127 else b for b in bytes.fromhex(text)]
+
+
+def parse_output(path: str, text: str) -> ReplayResult:
+    """Parse the host program's stdout (see src/host/replay_main.cpp); other lines are ignored."""
+    result = ReplayResult(path)
+    for line in text.splitlines():
+        fields = line.strip().split(",")
+        if fields[0] == "result" and len(fields) == 6:
+            result.windows.append(WindowResult(int(fields[1]), fields[2], float(fields[3]),
+                                               int(fields[4]), int(fields[5])))
+        elif fields[0] == "summary" and len(fields) == 6:
+            # fields[1] repeats the window count
+            result.sensor_frames, result.output_frames, result.wall_us, result.dsp_us = \
+                (int(v) for v in fields[2:])
+        elif fields[0] == "features" and len(fields) == 3 and len(fields[2]) % 2 == 0:
+            result.features.append((int(fields[1]), parse_int8_hex(fields[2])))
+        elif fields[0] == "pooled" and len(fields) == 3 and len(fields[2]) % 2 == 0:
+            result.pooled.append((int(fields[1]), parse_int8_hex(fields[2])))
+        elif fields[0] == "labels":
+            result.labels = fields[1:]
+    return result
+
+
+def replay_file(binary: str, path: str, features: bool = False, pooled: bool = False) -> ReplayResult:
+    command = [binary, path] + (["--features"] if features else []) + (["--pooled"] if pooled else [])
+    completed = subprocess.run(command, stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+                               universal_newlines=True, check=False)
+    if completed.returncode != 0:
+        raise RuntimeError(f"{path}: host replay failed ({completed.returncode}): {completed.stderr.strip()}")
+    return parse_output(path, completed.stdout)
+
+
+def confusion_matrix(results: Sequence[ReplayResult]) -> Dict[str, Dict[str, int]]:
+    """matrix[true_label][predicted_label] = number of classified windows."""
+    matrix: Dict[str, Dict[str, int]] = {}
+    for result in results:
+        row = matrix.setdefault(recording_label(result.path), {})
+        for window in result.windows:
+            row[window.label] = row.get(window.label, 0) + 1
+    return matrix
+
+
+def accuracy(matrix: Dict[str, Dict[str, int]]) -> float:
+    total = sum(sum(row.values()) for row in matrix.values())
+    correct = sum(row.get(label, 0) for label, row in matrix.items())
+    return correct / total if total else 0.0
+
+
+def stage_timing(results: Sequence[ReplayResult]) -> Dict[str, float]:
+    """Per-stage costs: DSP per sensor frame, CNN per classified window, sample-to-result latency."""
+    sensor_frames = sum(r.sensor_frames for r in results)
+    classified = [w for r in results for w in r.windows if w.classify_us > 0]
+    latencies = [w.latency_us for r in results for w in r.windows if w.latency_us > 0]
+    return {
+        "dsp_us_per_frame": sum(r.dsp_us for r in results) / sensor_frames if sensor_frames else 0.0,
+        "classify_us_mean": sum(w.classify_us for w in classified) / len(classified) if classified else 0.0,
+        "prefilter_skipped": sum(1 for r in results for w in r.windows if w.classify_us == 0),
+        "latency_us_mean": sum(latencies) / len(latencies) if latencies else 0.0,
+        "latency_us_max": float(max(latencies)) if latencies else 0.0,
+    }
+
+
+def format_matrix(matrix: Dict[str, Dict[str, int]]) -> List[str]:
+    predicted = sorted({label for row in matrix.values() for label in row})
+    width = max([len(label) for label in predicted + list(matrix)] + [6])
+    lines = [" " * width + " " + " ".join(f"{label:>{width}}" for label in predicted)]
+    for label in sorted(matrix):
+        lines.append(f"{label:>{width}} " + " ".join(f"{matrix[label].get(p, 0):>{width}}" for p in predicted))
+    return lines
+
+
+def build(build_flags: str, build_dir: Optional[str] = None) -> str:
+    """Rebuild the host program and return its path; build_flags overrides the compile-time
+    configuration (app_config.h), build_dir keeps the build apart from the default one."""
+    env = dict(os.environ)
+    if build_flags:
+        env["PLATFORMIO_BUILD_FLAGS"] = build_flags
+    if build_dir:
+        env["PLATFORMIO_BUILD_DIR"] = build_dir
+    subprocess.run(["pio", "run", "-e", "host_replay"], env=env, check=True)
+    return os.path.join(build_dir, "host_replay", "program") if build_dir else DEFAULT_BINARY
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    parser = argparse.ArgumentParser(description="Replay labelled recordings through the host inference build")
+    parser.add_argument("files", nargs="+", help="labelled Edge Impulse CSV recordings or session corpora")
+    parser.add_argument("--binary", default=DEFAULT_BINARY, help="host_replay program")
+    parser.add_argument("--jobs", type=int, default=os.cpu_count() or 1, help="parallel replay processes")
+    parser.add_argument("--build", action="store_true", help="run 'pio run -e host_replay' first")
+    parser.add_argument("--build-flags", default="", help="extra -D flags for --build (PLATFORMIO_BUILD_FLAGS)")
+    args = parser.parse_args(argv)
+
+    if args.build:
+        build(args.build_flags)
+    if not os.path.exists(args.binary):
+        print(f"[Replay] {args.binary} not found, build it with 'pio run -e host_replay'")
+        return 1
+
+    files = expand_inputs(args.files)
+    start = time.monotonic()
+    with ThreadPoolExecutor(max_workers=max(1, args.jobs)) as pool:
+        results = list(pool.map(lambda path: replay_file(args.binary, path), files))
+    elapsed = time.monotonic() - start
+
+    matrix = confusion_matrix(results)
+    windows = sum(len(r.windows) for r in results)
+    timing = stage_timing(results)
+    print(f"[Replay] {len(results)} recordings, {windows} windows, accuracy {accuracy(matrix) * 100:.1f}%")
+    for line in format_matrix(matrix):
+        print("  " + line)
+    print(f"[Replay] Throughput: {windows / elapsed:.0f} windows/s with {args.jobs} jobs "
+          f"({sum(r.sensor_frames for r in results) / elapsed:.0f} sensor frames/s)")
+    print(f"[Replay] DSP {timing['dsp_us_per_frame']:.2f} us/frame, CNN {timing['classify_us_mean']:.1f} us/window "
+          f"({timing['prefilter_skipped']} skipped by the idle pre-filter), "
+          f"latency mean {timing['latency_us_mean']:.0f} us / max {timing['latency_us_max']:.0f} us")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,239 @@
+"""
+Replay Parameter Sweep
+
+Replays a labelled dataset through every combination of inference settings
+and prints a Pareto table of detection F1 against inferences per second and
+detection latency, so stride, threshold, smoothing and gating choices can be
+made on data.
+
+Settings that live in the firmware build (stride, vote smoothing, the idle
+pre-filter, any other app_config.h macro via --define) give one host_replay
+build each, in its own build directory under .pio/sweep/. Confidence
+thresholds only decide which results become events, so they are applied to
+the replay output without rebuilding; the threshold column stands for the
+effective one, the highest of INFERENCE_MIN_CONFIDENCE, BLE_MIN_CONFIDENCE
+and (for the LED) LED_CONFIDENCE_THRESHOLD. All (build, recording) replays run
+in parallel on all cores.
+
+Per recording (a file, or a session of a corpus), labelled as in replay_runner.py:
+    detection   a gesture recording whose gesture was emitted at least once
+    false alarm every other gesture emitted, in any recording (idle included)
+F1 combines both over the dataset. Inferences per second count the windows
+that ran the CNN per second of recording; the latency is the median time from
+the start of a recording to its first correct event, processing included.
+A row is on the Pareto front (*) when no other row is at least as good in all
+three and better in one.
+
+Usage:
+    python replay_sweep.py data/*.csv --stride 2:2 2:12 4:12 --threshold 0.55 0.7 0.8
+    python replay_sweep.py data/*.csv --vote off 6:4 --prefilter off 0.02 0.04 --csv sweep.csv
+    python replay_sweep.py data/*.csv --define INFERENCE_STRIDE_STABLE_COUNT=2,3,5
+"""
+
+import argparse
+import csv
+import hashlib
+import itertools
+import os
+import statistics
+import sys
+from concurrent.futures import ThreadPoolExecutor
+from dataclasses import dataclass
+from typing import Dict, List, Optional, Sequence, Tuple
+
+from idle_prefilter_tuner import IDLE_LABEL, MODEL_HZ
+from replay_runner import ReplayResult, build, replay_file
+from session_corpus import expand_inputs, recording_label
+
+SWEEP_DIR = os.path.join(".pio", "sweep")
+# Results that are never events, whatever their confidence
+NON_EVENTS = (IDLE_LABEL, "uncertain")
+
+
+@dataclass
+class SweepRow:
+    setting: str     # build axes, e.g. "stride 2:12, vote off"
+    threshold: float
+    f1: float
+    precision: float
+    recall: float
+    inferences_per_s: float
+    latency_ms: Optional[float]  # None when nothing was detected
+    pareto: bool = False
+
+
+# ==================== Axes ====================
+
+def stride_flags(value: str) -> List[str]:
+    """"fine:coarse" in samples; equal values turn the adaptive stride off in effect."""
+    fine, _, coarse = value.partition(":")
+    return [f"-DINFERENCE_STRIDE_FINE_SAMPLES={int(fine)}",
+            f"-DINFERENCE_STRIDE_COARSE_SAMPLES={int(coarse or fine)}"]
+
+
+def vote_flags(value: str) -> List[str]:
+    """"off", or "readings:min_same" for the vote smoother."""
+    if value == "off":
+        return ["-DINFERENCE_VOTE_SMOOTHING=0"]
+    readings, _, min_same = value.partition(":")
+    return ["-DINFERENCE_VOTE_SMOOTHING=1", f"-DINFERENCE_VOTE_READINGS={int(readings)}",
+            f"-DINFERENCE_VOTE_MIN_SAME={int(min_same or readings)}"]
+
+
+def prefilter_flags(value: str) -> List[str]:
+    """"off", or the idle pre-filter's standard deviation limit in g."""
+    if value == "off":
+        return ["-DINFERENCE_IDLE_PREFILTER=0"]
+    return ["-DINFERENCE_IDLE_PREFILTER=1", f"-DINFERENCE_IDLE_PREFILTER_MAX_STD_G={float(value)}f"]
+
+
+def define_axis(spec: str) -> Tuple[str, List[Tuple[str, List[str]]]]:
+    """"MACRO=v1,v2" as an axis of (label, flags)."""
+    name, sep, values = spec.partition("=")
+    if not sep or not name or not values:
+        raise ValueError(f"--define expects MACRO=v1,v2: {spec!r}")
+    return name, [(f"{name}={v}", [f"-D{name}={v}"]) for v in values.split(",")]
+
+
+def build_axes(args: argparse.Namespace) -> List[List[Tuple[str, List[str]]]]:
+    """Every compile-time axis that has values, as a list of (label, flags) per value."""
+    axes = []
+    for name, values, flags in (("stride", args.stride, stride_flags), ("vote", args.vote, vote_flags),
+                                ("prefilter", args.prefilter, prefilter_flags)):
+        if values:
+            axes.append([(f"{name} {v}", flags(v)) for v in values])
+    for spec in args.define:
+        axes.append(define_axis(spec)[1])
+    return axes
+
+
+def variants(axes: Sequence[Sequence[Tuple[str, List[str]]]]) -> List[Tuple[str, str]]:
+    """(setting label, build flags) for every combination; one default build without axes."""
+    if not axes:
+        return [("default", "")]
+    return [(", ".join(label for label, _ in combo), " ".join(f for _, flags in combo for f in flags))
+            for combo in itertools.product(*axes)]
+
+
+def build_dir_of(flags: str) -> str:
+    return os.path.join(SWEEP_DIR, hashlib.sha1(flags.encode()).hexdigest()[:12])
+
+
+# ==================== Metrics ====================
+
+def evaluate(results: Sequence[ReplayResult], threshold: float) -> Tuple[float, float, float, float, Optional[float]]:
+    """(F1, precision, recall, inferences per second, median detection latency in ms) of one build."""
+    detected = false_alarms = gestures = 0
+    latencies = []
+    cnn_windows = 0
+    frames = 0
+    for result in results:
+        truth = recording_label(result.path)
+        emitted = {}
+        for window in result.windows:
+            if window.label not in NON_EVENTS and window.confidence >= threshold:
+                emitted.setdefault(window.label, window)
+        cnn_windows += sum(1 for w in result.windows if w.classify_us > 0)
+        frames += result.output_frames
+        false_alarms += sum(1 for label in emitted if label != truth)
+        if truth in NON_EVENTS:
+            continue
+        gestures += 1
+        first = emitted.get(truth)
+        if first is not None:
+            detected += 1
+            latencies.append(first.frame / MODEL_HZ * 1000.0 + first.latency_us / 1000.0)
+    precision = detected / (detected + false_alarms) if detected + false_alarms else 0.0
+    recall = detected / gestures if gestures else 0.0
+    f1 = 2 * precision * recall / (precision + recall) if precision + recall else 0.0
+    seconds = frames / MODEL_HZ
+    return (f1, precision, recall, cnn_windows / seconds if seconds else 0.0,
+            statistics.median(latencies) if latencies else None)
+
+
+def mark_pareto(rows: List[SweepRow]) -> None:
+    """Higher F1, fewer inferences per second and lower latency are better; no detections is worst latency."""
+    def key(row: SweepRow) -> Tuple[float, float, float]:
+        return (-row.f1, row.inferences_per_s, row.latency_ms if row.latency_ms is not None else float("inf"))
+
+    for row in rows:
+        mine = key(row)
+        row.pareto = not any(all(a <= b for a, b in zip(key(other), mine)) and key(other) != mine
+                             for other in rows)
+
+
+def sweep_rows(results: Dict[str, List[ReplayResult]], thresholds: Sequence[float]) -> List[SweepRow]:
+    """One row per (setting, threshold), best F1 first, with the Pareto front marked."""
+    rows = [SweepRow(setting, threshold, *evaluate(replays, threshold))
+            for setting, replays in results.items() for threshold in thresholds]
+    mark_pareto(rows)
+    rows.sort(key=lambda r: (-r.f1, r.inferences_per_s, r.latency_ms if r.latency_ms is not None else float("inf")))
+    return rows
+
+
+def format_rows(rows: Sequence[SweepRow]) -> List[str]:
+    width = max([len(r.setting) for r in rows] + [7])
+    lines = [f"  {'setting':<{width}} {'thr':>5} {'F1':>6} {'prec':>6} {'recall':>6} {'inf/s':>7} {'latency':>9}"]
+    for r in rows:
+        latency = f"{r.latency_ms:.0f} ms" if r.latency_ms is not None else "-"
+        lines.append(f"{'*' if r.pareto else ' '} {r.setting:<{width}} {r.threshold:>5.2f} {r.f1:>6.3f} "
+                     f"{r.precision:>6.3f} {r.recall:>6.3f} {r.inferences_per_s:>7.1f} {latency:>9}")
+    return lines
+
+
+def write_csv(path: str, rows: Sequence[SweepRow]) -> None:
+    with open(path, "w", newline="", encoding="utf-8") as f:
+        writer = csv.writer(f)
+        writer.writerow(["setting", "threshold", "f1", "precision", "recall", "inferences_per_s", "latency_ms",
+                         "pareto"])
+        for r in rows:
+            writer.writerow([r.setting, r.threshold, f"{r.f1:.4f}", f"{r.precision:.4f}", f"{r.recall:.4f}",
+                             f"{r.inferences_per_s:.2f}", "" if r.latency_ms is None else f"{r.latency_ms:.1f}",
+                             int(r.pareto)])
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    parser = argparse.ArgumentParser(description="Sweep inference settings over a labelled replay dataset")
+    parser.add_argument("files", nargs="+", help="labelled Edge Impulse CSV recordings or session corpora")
+    parser.add_argument("--stride", nargs="+", default=[], metavar="FINE:COARSE", help="stride in samples")
+    parser.add_argument("--vote", nargs="+", default=[], metavar="off|N:M", help="vote smoothing readings:min_same")
+    parser.add_argument("--prefilter", nargs="+", default=[], metavar="off|STD_G", help="idle pre-filter limit")
+    parser.add_argument("--define", action="append", default=[], metavar="MACRO=v1,v2",
+                        help="any other app_config.h macro (repeatable)")
+    parser.add_argument("--threshold", nargs="+", type=float, default=[0.55], help="event confidence thresholds")
+    parser.add_argument("--jobs", type=int, default=os.cpu_count() or 1, help="parallel replay processes")
+    parser.add_argument("--csv", help="also write the table to this CSV file")
+    args = parser.parse_args(argv)
+
+    try:
+        settings = variants(build_axes(args))
+    except ValueError as e:
+        print(f"[Sweep] {e}")
+        return 2
+    # PlatformIO already builds on every core, so the builds run one after another
+    binaries = {}
+    for setting, flags in settings:
+        print(f"[Sweep] Building {setting}: {flags or '(defaults)'}")
+        binaries[setting] = build(flags, build_dir_of(flags))
+
+    files = expand_inputs(args.files)
+    tasks = [(setting, path) for setting in binaries for path in files]
+    with ThreadPoolExecutor(max_workers=max(1, args.jobs)) as pool:
+        replays = list(pool.map(lambda task: replay_file(binaries[task[0]], task[1]), tasks))
+    results: Dict[str, List[ReplayResult]] = {setting: [] for setting in binaries}
+    for (setting, _), replay in zip(tasks, replays):
+        results[setting].append(replay)
+
+    rows = sweep_rows(results, args.threshold)
+    print(f"[Sweep] {len(settings)} builds x {len(args.threshold)} thresholds over {len(files)} recordings "
+          f"(* = Pareto front)")
+    for line in format_rows(rows):
+        print(line)
+    if args.csv:
+        write_csv(args.csv, rows)
+        print(f"[Sweep] Wrote {args.csv}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
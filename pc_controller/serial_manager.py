@@ -0,0 +1,664 @@
+"""
+Serial Manager Module
+
+Receives the firmware's data streams over the USB CDC binary link instead of BLE
+(wired kiosk installations: no radio, sub-millisecond transport latency).
+
+Every frame on the wire is 0x00 | COBS(type | payload | crc16) | 0x00 with
+CRC-16/CCITT-FALSE over type and payload, little-endian (include/usb_frame.h).
+The type is the low byte of the matching BLE characteristic UUID and the payload
+is that characteristic's notification or write, so the BLEManager decoders and
+handlers are reused as they are. Log text printed by the firmware shares the
+port; whatever between two delimiters does not decode is passed on as text.
+
+TransportSelector picks the link at runtime: a board that answers the USB hello
+is used over USB, otherwise it is found over BLE. While the USB link is open the
+firmware drops any BLE connection and stops advertising.
+"""
+
+import asyncio
+import threading
+import time
+from dataclasses import dataclass
+from typing import Any, Callable, Dict, List, Optional, Tuple
+
+from ble_manager import (STREAM_EVENTS, TELEMETRY_DUMP_CAPTURES_COMMAND, TELEMETRY_DUMP_COMMAND,
+                         TELEMETRY_STATUS_COMMAND, TELEMETRY_STOP_COMMAND, BLEManager, ComboTable, InferenceBenchReport,
+                         RuntimeConfig, TelemetryDump, TelemetryStatus,
+                         encode_ack, encode_combos, encode_inference_benchmark, encode_missed, encode_time_sync,
+                         parse_combos, parse_config, parse_inference_benchmark, parse_telemetry_status)
+from raw_recorder import TYPE_WINDOW, StreamDecoder
+from wire_schema import ConfidenceFormat, confidence_format, schema_version, schema_warning
+
+FRAME_DELIMITER = 0x00
+
+# Frame types (include/usb_frame.h)
+FRAME_HELLO = 0x01
+FRAME_DIAGNOSTICS = 0x13
+FRAME_RECORD_CONTROL = 0x14
+FRAME_RECORD_DATA = 0x15
+FRAME_EVENTS = 0x16
+FRAME_CPU = 0x17
+FRAME_ACK = 0x18
+FRAME_LATENCY = 0x19
+FRAME_CONFIG = 0x1A
+FRAME_GESTURE = 0x1B
+FRAME_SCORES = 0x1E
+FRAME_WINDOW = 0x1F
+FRAME_MISSED = 0x21
+FRAME_TIME_SYNC = 0x24
+FRAME_COUNTERS = 0x25
+FRAME_SEGMENT = 0x28
+FRAME_INFERENCE_BENCH = 0x29
+FRAME_TELEMETRY = 0x2B
+FRAME_TELEMETRY_DATA = 0x2C
+FRAME_COMBO = 0x2D
+FRAME_COMBO_EVENT = 0x2E
+FRAME_POWER = 0x2F
+FRAME_TRACE = 0x30
+FRAME_CRASH = 0x31
+FRAME_ONSET = 0x33
+FRAME_STATS = 0x34
+# Diagnostics shell request / reply (device_shell.py); answered without opening the link
+FRAME_SHELL = 0x32
+
+# Hello payload: uint8 STREAM_* bits the host wants (0 closes the link)
+LINK_VERSION = 1
+
+# USB vendor ID of the Arduino boards; other ports are never probed
+ARDUINO_VID = 0x2341
+
+
+def crc16(data: bytes, crc: int = 0xFFFF) -> int:
+    """CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF)."""
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_encode(data: bytes) -> bytes:
+    """Consistent overhead byte stuffing: the result contains no zero byte."""
+    out = bytearray([0])
+    code_at = 0
+    for byte in data:
+        if byte == 0:
+            out[code_at] = len(out) - code_at
+            code_at = len(out)
+            out.append(0)
+            continue
+        out.append(byte)
+        if len(out) - code_at == 0xFF:
+            out[code_at] = 0xFF
+            code_at = len(out)
+            out.append(0)
+    out[code_at] = len(out) - code_at
+    return bytes(out)
+
+
+def cobs_decode(data: bytes) -> Optional[bytes]:
+    """Inverse of cobs_encode; None when data is not a valid COBS block."""
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code != 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def encode_frame(frame_type: int, payload: bytes = b"") -> bytes:
+    """One frame with both delimiters."""
+    content = bytes([frame_type]) + payload
+    crc = crc16(content)
+    return bytes([FRAME_DELIMITER]) + cobs_encode(content + bytes([crc & 0xFF, crc >> 8])) + bytes([FRAME_DELIMITER])
+
+
+def decode_frame(block: bytes) -> Optional[Tuple[int, bytes]]:
+    """(type, payload) of the bytes between two delimiters; None for text or a damaged frame."""
+    content = cobs_decode(block)
+    if content is None or len(content) < 3:
+        return None
+    if crc16(content[:-2]) != content[-2] | (content[-1] << 8):
+        return None
+    return content[0], content[1:-2]
+
+
+class FrameDecoder:
+    """Splits the serial byte stream into frames and log text."""
+
+    def __init__(self):
+        self._pending = bytearray()
+
+    def feed(self, data: bytes) -> List[Tuple[Optional[int], bytes]]:
+        """Returns (type, payload) for frames and (None, text) for undecodable blocks, in arrival order."""
+        items: List[Tuple[Optional[int], bytes]] = []
+        self._pending += data
+        while True:
+            end = self._pending.find(FRAME_DELIMITER)
+            if end < 0:
+                break
+            block = bytes(self._pending[:end])
+            del self._pending[:end + 1]
+            if not block:
+                continue
+            frame = decode_frame(block)
+            items.append(frame if frame is not None else (None, block))
+        return items
+
+
+def encode_hello(streams: int) -> bytes:
+    return encode_frame(FRAME_HELLO, bytes([streams & 0xFF]))
+
+
+def parse_hello(payload: bytes) -> Optional[Tuple[int, int]]:
+    """(streams in effect, link version) of the device's hello reply."""
+    if len(payload) < 2:
+        return None
+    return payload[0], payload[1]
+
+
+def parse_hello_schema(payload: bytes) -> Optional[int]:
+    """Wire schema version in the hello reply (wire_schema.py), None from older firmware."""
+    return schema_version(payload, 2)
+
+
+def parse_hello_confidence(payload: bytes) -> ConfidenceFormat:
+    """Result confidence format after the schema version (LEGACY_CONFIDENCE from older firmware)."""
+    return confidence_format(payload, 3)
+
+
+@dataclass
+class SerialDevice:
+    """A serial port with the gesture firmware behind it (same fields the GUI shows for BLE devices)."""
+    name: str
+    address: str
+
+
+def candidate_ports() -> List[str]:
+    """Serial ports of Arduino boards (pyserial's port list, filtered by USB vendor ID)."""
+    from serial.tools import list_ports  # pyserial
+    return [port.device for port in list_ports.comports() if port.vid == ARDUINO_VID]
+
+
+def probe_port(port: str, timeout_s: float = 1.0) -> bool:
+    """True when the firmware on port answers a hello (the probe closes the link again)."""
+    import serial  # pyserial
+    try:
+        with serial.Serial(port, 115200, timeout=0.05) as ser:
+            ser.write(encode_hello(STREAM_EVENTS))
+            decoder = FrameDecoder()
+            deadline = time.monotonic() + timeout_s
+            while time.monotonic() < deadline:
+                for frame_type, payload in decoder.feed(ser.read(256)):
+                    if frame_type == FRAME_HELLO and parse_hello(payload) is not None:
+                        ser.write(encode_hello(0))
+                        return True
+    except Exception as e:
+        print(f"[USB] Probe of {port} failed: {e}")
+    return False
+
+
+class SerialManager(BLEManager):
+    """BLEManager over the USB CDC link: same callbacks, delivery tracking, clock sync and latency breakdown.
+
+    The throughput benchmark, loopback, model update and HID keymap stay on BLE.
+    """
+
+    # The firmware closes the link after 3 s without a hello
+    HELLO_INTERVAL_S = 1.0
+    HELLO_TIMEOUT_S = 1.0
+
+    def __init__(self):
+        super().__init__()
+        self._serial = None
+        self._write_lock = threading.Lock()
+        self._reader: Optional[threading.Thread] = None
+        self._loop: Optional[asyncio.AbstractEventLoop] = None
+        self._hello_reply: Optional[asyncio.Future] = None
+        self._inference_bench_reply: Optional[asyncio.Future] = None
+        self._telemetry_reply: Optional[asyncio.Future] = None
+        self._telemetry_dump: Optional[TelemetryDump] = None
+        self._combos: Optional[ComboTable] = None
+        self._combo_reply: Optional[asyncio.Future] = None
+        self._keepalive_task: Optional[asyncio.Task] = None
+        self._config: Optional[RuntimeConfig] = None
+        self._port: Optional[str] = None
+        self._closing = False
+        self._lost_callback: Optional[Callable[[], None]] = None
+        # The gesture frames repeat the newest event of the bursts and are not handled
+        self._handlers: Dict[int, Callable[[Any, bytearray], None]] = {
+            FRAME_EVENTS: self._on_events_notify,
+            FRAME_MISSED: self._on_missed_notify,
+            FRAME_LATENCY: self._on_latency_notify,
+            FRAME_CONFIG: self._on_config_frame,
+            FRAME_SCORES: self._on_scores_notify,
+            FRAME_WINDOW: self._on_window_notify,
+            FRAME_CPU: self._on_cpu_notify,
+            FRAME_COUNTERS: self._on_counters_notify,
+            FRAME_TIME_SYNC: self._on_time_sync_notify,
+            FRAME_SEGMENT: self._on_segment_notify,
+            FRAME_INFERENCE_BENCH: self._on_inference_bench_frame,
+            FRAME_TELEMETRY: self._on_telemetry_frame,
+            FRAME_TELEMETRY_DATA: self._on_telemetry_data_frame,
+            FRAME_COMBO: self._on_combo_frame,
+            FRAME_COMBO_EVENT: self._on_combo_notify,
+            FRAME_POWER: self._on_power_notify,
+            FRAME_TRACE: self._on_trace_notify,
+            FRAME_CRASH: self._on_crash_notify,
+            FRAME_ONSET: self._on_onset_notify,
+            FRAME_STATS: self._on_stats_notify,
+        }
+
+    def set_lost_callback(self, callback: Callable[[], None]) -> None:
+        """Set callback for a link that went away without disconnect() (cable unplugged, board reset)."""
+        self._lost_callback = callback
+
+    def device_hid(self) -> bool:
+        return False
+
+    async def write_keymap(self, shortcuts: Dict[str, str]) -> bool:
+        return False
+
+    async def scan_devices(self, timeout: float = 10.0, on_found: Optional[Callable[[SerialDevice], None]] = None,
+                           stop_at: Optional[str] = None) -> List[SerialDevice]:
+        """Boards on the Arduino serial ports that answer the USB hello (each reported to on_found as it answers)."""
+        self._notify_status("Scanning...")
+        loop = asyncio.get_running_loop()
+        try:
+            ports = await loop.run_in_executor(None, candidate_ports)
+        except Exception as e:
+            print(f"[USB] Serial port list unavailable: {e}")
+            ports = []
+        found = []
+        for port in ports:
+            if await loop.run_in_executor(None, probe_port, port, min(timeout, self.HELLO_TIMEOUT_S)):
+                print(f"[USB] Found: {port}")
+                found.append(SerialDevice(f"{self.TARGET_DEVICE_NAME} (USB)", port))
+                if on_found:
+                    on_found(found[-1])
+        self._notify_status("Disconnected")
+        return found
+
+    async def scan_and_connect(self, timeout: float = 15.0) -> bool:
+        devices = await self.scan_devices(timeout)
+        if devices:
+            return await self.connect(devices[0].address)
+        self._notify_status("Device not found")
+        return False
+
+    def last_device_address(self) -> Optional[str]:
+        return self._port
+
+    async def connect(self, device_address: str) -> bool:
+        """Open the serial port and the link; True once the firmware answers the hello."""
+        import serial  # pyserial
+        await self.disconnect()
+        self._notify_status("Connecting...")
+        self._loop = asyncio.get_running_loop()
+        self._port = device_address
+        self._closing = False
+        try:
+            self._serial = serial.Serial(device_address, 115200, timeout=0.05)
+        except Exception as e:
+            print(f"[USB] Cannot open {device_address}: {e}")
+            self._notify_status("Connection failed")
+            return False
+
+        self._delivery.reset()
+        self._latency.reset()
+        self._clock.reset()
+        self._time_sync_sent.clear()
+        self._newest_event_ms = None
+        self._window_decoder = StreamDecoder(TYPE_WINDOW)
+        self._ack_supported = True
+        self._missed_supported = True
+        self._hello_reply = self._loop.create_future()
+        self._reader = threading.Thread(target=self._read_loop, args=(self._serial,), daemon=True)
+        self._reader.start()
+        self._write(encode_hello(self.streams()))
+        try:
+            await asyncio.wait_for(self._hello_reply, self.HELLO_TIMEOUT_S)
+        except asyncio.TimeoutError:
+            print(f"[USB] No hello reply on {device_address}")
+            await self.disconnect()
+            self._notify_status("Connection failed")
+            return False
+
+        self._connected = True
+        self._reconnect_attempts = 0
+        self._keepalive_task = asyncio.ensure_future(self._keepalive_loop())
+        self._time_sync_task = asyncio.ensure_future(self._time_sync_loop())
+        self._notify_status("Connected (USB)")
+        print(f"[USB] Link open on {device_address}")
+        return True
+
+    async def disconnect(self) -> None:
+        """Close the link (the firmware resumes advertising) and the port."""
+        self._closing = True
+        for task in (self._keepalive_task, self._time_sync_task):
+            if task is not None:
+                task.cancel()
+        self._keepalive_task = None
+        self._time_sync_task = None
+        was_open = self._serial is not None
+        if self._serial is not None:
+            try:
+                self._write(encode_hello(0))
+                self._serial.close()
+            except Exception:
+                pass
+        self._serial = None
+        if self._reader is not None and self._reader is not threading.current_thread():
+            self._reader.join(timeout=0.5)
+        self._reader = None
+        self._connected = False
+        self._release_hold()
+        self._cancel_onset()
+        if was_open:
+            self._notify_status("Disconnected")
+
+    def is_connected(self) -> bool:
+        return self._connected and self._serial is not None
+
+    async def read_config(self) -> Optional[RuntimeConfig]:
+        """The configuration last sent by the firmware (on link open and after every change)."""
+        return self._config if self.is_connected() else None
+
+    async def _write_config(self, payload: bytes) -> bool:
+        return self.is_connected() and self._write(encode_frame(FRAME_CONFIG, payload))
+
+    async def record(self, transport: int) -> bool:
+        """Raw IMU recording over the link (record_transport_t; the packets arrive as record data frames)."""
+        return self.is_connected() and self._write(encode_frame(FRAME_RECORD_CONTROL, bytes([transport])))
+
+    async def run_benchmark(self, duration_ms: int = 3000):
+        print("[USB] The throughput benchmark measures the BLE link only")
+        return None
+
+    async def run_loopback(self, count: int = 200, padding: int = 0, timeout_s: float = 1.0):
+        print("[USB] Loopback measures the BLE link only")
+        return None
+
+    async def run_inference_benchmark(self, mode: str = "synthetic", runs: int = 100,
+                                      timeout_s: float = 30.0) -> Optional[InferenceBenchReport]:
+        """The on-device inference benchmark over the link (the report arrives as one frame)."""
+        if not self.is_connected():
+            return None
+        self._inference_bench_reply = asyncio.get_running_loop().create_future()
+        try:
+            if not self._write(encode_frame(FRAME_INFERENCE_BENCH, encode_inference_benchmark(mode, runs))):
+                return None
+            return await asyncio.wait_for(self._inference_bench_reply, timeout_s)
+        except asyncio.TimeoutError:
+            print("[USB] Inference benchmark report not received")
+            return None
+        finally:
+            self._inference_bench_reply = None
+
+    async def read_combos(self) -> Optional[ComboTable]:
+        """The combos last sent by the firmware (on link open and after every write)."""
+        return self._combos if self.is_connected() else None
+
+    async def write_combos(self, table: ComboTable, timeout_s: float = 1.0) -> Optional[ComboTable]:
+        if not self.is_connected():
+            return None
+        self._combo_reply = asyncio.get_running_loop().create_future()
+        try:
+            if not self._write(encode_frame(FRAME_COMBO, encode_combos(table))):
+                return None
+            return await asyncio.wait_for(self._combo_reply, timeout_s)
+        except asyncio.TimeoutError:
+            print("[USB] Combo table not received (firmware without BLE_COMBO_ENABLE?)")
+            return None
+        finally:
+            self._combo_reply = None
+
+    async def read_telemetry_status(self, timeout_s: float = 1.0) -> Optional[TelemetryStatus]:
+        """The status command is answered with a status frame (there is no read over the link)."""
+        if not self.is_connected():
+            return None
+        self._telemetry_reply = asyncio.get_running_loop().create_future()
+        try:
+            if not self._write(encode_frame(FRAME_TELEMETRY, bytes([TELEMETRY_STATUS_COMMAND]))):
+                return None
+            return await asyncio.wait_for(self._telemetry_reply, timeout_s)
+        except asyncio.TimeoutError:
+            print("[USB] Diagnostics log status not received (firmware without TELEMETRY_ENABLE?)")
+            return None
+        finally:
+            self._telemetry_reply = None
+
+    async def dump_telemetry(self, timeout_s: float = 60.0, captures: bool = False) -> Optional[TelemetryDump]:
+        if not self.is_connected():
+            return None
+        dump = TelemetryDump()
+        self._telemetry_dump = dump
+        self._telemetry_reply = asyncio.get_running_loop().create_future()
+        command = TELEMETRY_DUMP_CAPTURES_COMMAND if captures else TELEMETRY_DUMP_COMMAND
+        try:
+            if not self._write(encode_frame(FRAME_TELEMETRY, bytes([command]))):
+                return None
+            return await asyncio.wait_for(self._telemetry_reply, timeout_s)
+        except asyncio.TimeoutError:
+            print("[USB] Diagnostics log dump timed out")
+            self._write(encode_frame(FRAME_TELEMETRY, bytes([TELEMETRY_STOP_COMMAND])))
+            return None
+        finally:
+            self._telemetry_dump = None
+            self._telemetry_reply = None
+
+    async def read_model_status(self):
+        return None
+
+    async def upload_model(self, blob: bytes, progress=None, switch_timeout_s: float = 10.0):
+        print("[USB] Model updates go over BLE")
+        return None
+
+    async def restore_builtin_model(self):
+        return None
+
+    def _write(self, frame: bytes) -> bool:
+        ser = self._serial
+        if ser is None:
+            return False
+        try:
+            with self._write_lock:
+                ser.write(frame)
+            return True
+        except Exception as e:
+            print(f"[USB] Write failed: {e}")
+            return False
+
+    def _send_ack(self, sequence: int) -> None:
+        if self._ack_supported:
+            self._write(encode_frame(FRAME_ACK, encode_ack(sequence)))
+
+    def _request_missed(self, first: int, count: int) -> None:
+        if self._missed_supported:
+            self._write(encode_frame(FRAME_MISSED, encode_missed(first, count)))
+
+    async def _keepalive_loop(self) -> None:
+        while self.is_connected():
+            await asyncio.sleep(self.HELLO_INTERVAL_S)
+            self._write(encode_hello(self.streams()))
+
+    async def _time_sync_loop(self) -> None:
+        rounds = 0
+        while self.is_connected():
+            for _ in range(self.TIME_SYNC_ROUND):
+                sequence = self._time_sync_sequence = (self._time_sync_sequence + 1) & 0xFFFF
+                self._time_sync_sent = {seq: t for seq, t in self._time_sync_sent.items()
+                                        if (sequence - seq) & 0xFFFF < 4 * self.TIME_SYNC_ROUND}
+                self._time_sync_sent[sequence] = time.perf_counter()
+                if not self._write(encode_frame(FRAME_TIME_SYNC, encode_time_sync(sequence))):
+                    return
+                await asyncio.sleep(self.TIME_SYNC_SPACING_S)
+            rounds += 1
+            await asyncio.sleep(0.2 if rounds < 2 else self.TIME_SYNC_INTERVAL_S)
+
+    def _read_loop(self, ser) -> None:
+        """Reader thread: decode frames and hand them to the event loop thread."""
+        decoder = FrameDecoder()
+        while not self._closing:
+            try:
+                data = ser.read(max(1, ser.in_waiting))
+            except Exception as e:
+                if not self._closing:
+                    print(f"[USB] Read failed: {e}")
+                    self._loop.call_soon_threadsafe(self._on_link_lost)
+                return
+            for frame_type, payload in decoder.feed(data):
+                self._loop.call_soon_threadsafe(self._dispatch, frame_type, payload)
+
+    def _dispatch(self, frame_type: Optional[int], payload: bytes) -> None:
+        if frame_type is None:
+            text = payload.decode("utf-8", errors="replace").strip()
+            if text:
+                print(f"[USB] {text}")
+            return
+        if frame_type == FRAME_HELLO:
+            if self._hello_reply is not None and not self._hello_reply.done() and parse_hello(payload):
+                warning = schema_warning(parse_hello_schema(payload))
+                if warning:
+                    print(f"[USB] Warning: {warning}")
+                self._confidence = parse_hello_confidence(payload)
+                self._hello_reply.set_result(parse_hello(payload))
+            return
+        handler = self._handlers.get(frame_type)
+        if handler is not None:
+            handler(None, bytearray(payload))
+
+    def _on_inference_bench_frame(self, sender, data: bytearray) -> None:
+        reply = self._inference_bench_reply
+        report = parse_inference_benchmark(bytes(data))
+        if reply is not None and not reply.done() and report is not None:
+            reply.set_result(report)
+
+    def _on_combo_frame(self, sender, data: bytearray) -> None:
+        self._combos = parse_combos(bytes(data)) or self._combos
+        reply = self._combo_reply
+        if reply is not None and not reply.done() and self._combos is not None:
+            reply.set_result(self._combos)
+
+    def _on_telemetry_frame(self, sender, data: bytearray) -> None:
+        reply = self._telemetry_reply
+        status = parse_telemetry_status(bytes(data))
+        if reply is not None and not reply.done() and status is not None and self._telemetry_dump is None:
+            reply.set_result(status)
+
+    def _on_telemetry_data_frame(self, sender, data: bytearray) -> None:
+        reply = self._telemetry_reply
+        dump = self._telemetry_dump
+        if dump is not None and dump.feed(bytes(data)) and reply is not None and not reply.done():
+            reply.set_result(dump)
+
+    def _on_config_frame(self, sender, data: bytearray) -> None:
+        self._config = parse_config(bytes(data)) or self._config
+        self._on_config_notify(sender, data)
+
+    def _on_link_lost(self) -> None:
+        """The port went away (cable unplugged): report it like a BLE disconnect."""
+        if self._closing:
+            return
+        print("[USB] Link lost")
+        asyncio.ensure_future(self._close_lost())
+
+    async def _close_lost(self) -> None:
+        await self.disconnect()
+        if self._lost_callback:
+            self._lost_callback()
+
+
+class TransportSelector:
+    """One manager for the GUI that picks USB when a board answers on a serial port, BLE otherwise.
+
+    Callbacks and settings go to both transports; everything else goes to the one in use.
+    A lost USB link falls back to scanning for the board over BLE when auto-reconnect is on.
+    """
+
+    def __init__(self, ble: Optional[BLEManager] = None, usb: Optional[SerialManager] = None):
+        self._ble = ble or BLEManager()
+        self._usb = usb or SerialManager()
+        self._active: BLEManager = self._ble
+        self._auto_reconnect = True
+        self._usb.set_lost_callback(self._on_usb_lost)
+
+    @property
+    def transport(self) -> str:
+        return "usb" if self._active is self._usb else "ble"
+
+    def __getattr__(self, name: str):
+        if (name.startswith("set_") and name.endswith("_callback")) or name == "set_keymap_provider":
+            def set_both(callback):
+                getattr(self._ble, name)(callback)
+                getattr(self._usb, name)(callback)
+            return set_both
+        return getattr(self._active, name)
+
+    def set_status_callback(self, callback: Callable[[str], None]) -> None:
+        self._ble.set_status_callback(callback)
+        self._usb.set_status_callback(callback)
+
+    def set_auto_reconnect(self, enabled: bool) -> None:
+        self._auto_reconnect = enabled
+        self._ble.set_auto_reconnect(enabled)
+
+    def set_layout_store(self, load: Callable[[str], Optional[int]], save: Callable[[str, int], None]) -> None:
+        self._ble.set_layout_store(load, save)
+
+    async def scan_devices(self, timeout: float = 10.0, on_found: Optional[Callable[[Any], None]] = None,
+                           stop_at: Optional[str] = None) -> List[Any]:
+        """Boards on USB first, then the ones found over BLE; a board found on stop_at's port skips the BLE scan."""
+        usb = await self._usb.scan_devices(timeout, on_found)
+        if stop_at and any(device.address == stop_at for device in usb):
+            return usb
+        return usb + await self._ble.scan_devices(timeout, on_found, stop_at)
+
+    async def stop_scan(self) -> None:
+        await self._ble.stop_scan()
+
+    def set_known_address(self, address: Optional[str]) -> None:
+        """Seed the BLE address looked for first; serial ports are found by the USB scan anyway."""
+        if address and not self._is_serial(address):
+            self._ble.set_known_address(address)
+
+    async def scan_and_connect(self, timeout: float = 15.0, known_address: Optional[str] = None) -> bool:
+        devices = await self._usb.scan_devices(timeout)
+        if devices:
+            return await self.connect(devices[0].address)
+        self._active = self._ble
+        if known_address and self._is_serial(known_address):
+            known_address = None
+        return await self._ble.scan_and_connect(timeout, known_address)
+
+    @staticmethod
+    def _is_serial(address: str) -> bool:
+        return address.upper().startswith("COM") or address.startswith("/dev/")
+
+    async def connect(self, device_address: str) -> bool:
+        """Serial ports (COM5, /dev/ttyACM0) connect over USB, BLE addresses over BLE."""
+        await self.disconnect()
+        if self._is_serial(device_address):
+            self._active = self._usb
+        else:
+            self._active = self._ble
+        return await self._active.connect(device_address)
+
+    async def disconnect(self) -> None:
+        if self._active.is_connected():
+            await self._active.disconnect()
+
+    def is_connected(self) -> bool:
+        return self._active.is_connected()
+
+    def _on_usb_lost(self) -> None:
+        if self._auto_reconnect and self._active is self._usb:
+            print("[USB] Looking for the board again (USB, then BLE)")
+            asyncio.ensure_future(self.scan_and_connect())
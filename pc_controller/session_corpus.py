@@ -0,0 +1,564 @@
+"""
+Session Corpus
+
+Packs thousands of labelled recordings into one columnar binary file that the
+host replay, sweep and training tools map read-only and read without parsing
+or copying (layout in include/host/session_corpus.h, the C++ reader used by
+host_replay and the golden equivalence test):
+
+    header | session index | per-session blocks | label table | string table
+
+Each session block holds the timestamps (uint32 us since the session's first
+frame) followed by one int16 column per recorded channel, in sensor LSB at the
+ranges of the raw recording (+-4 g, +-2000 dps), so device captures convert
+losslessly and Edge Impulse data (g / dps) is quantised at the same ranges.
+
+Python tools open a corpus with Corpus(path): the index is parsed once, and
+Session.column() / Session.window() return memoryviews into the mapping. A
+session is addressed as "<corpus>#<index>" wherever a recording path is
+accepted (replay_runner.py, replay_sweep.py, onset_trainer.py and host_replay
+itself); expand_inputs() turns a corpus path into all of its sessions, and
+map_sessions() runs a function over the sessions in worker processes that each
+map the file once (the page cache is shared, nothing is pickled but indices and
+results).
+
+Converts device captures (raw_recorder.py --input streams, *.bin), Edge
+Impulse CSV, CBOR and JSON acquisition files and other corpora. Sessions are
+labelled by their file name prefix, as in replay_runner.py, unless --label is
+given.
+
+Usage:
+    python session_corpus.py --out data.gcorpus data/*.csv data/*.cbor captures/*.bin
+    python session_corpus.py --list data.gcorpus
+    python session_corpus.py --scan data.gcorpus --jobs 8
+    python replay_runner.py data.gcorpus
+"""
+
+import argparse
+import functools
+import math
+import mmap
+import multiprocessing
+import os
+import struct
+import sys
+import time
+from array import array
+from dataclasses import dataclass
+from typing import Any, Callable, Dict, Iterator, List, Optional, Sequence, Tuple
+
+from idle_prefilter_tuner import ACC_COLUMNS, STRIDE_FRAMES, WINDOW_FRAMES, label_from_path, load_csv
+from raw_recorder import (ACC_LSB_PER_G, CHANNEL_NAMES, GYR_LSB_PER_DPS, TYPE_IMU_RAW, StreamDecoder,
+                          decode_chunks)
+
+MAGIC = b"GCORPUS\x00"
+VERSION = 1
+EXTENSION = ".gcorpus"
+HEADER = struct.Struct("<8sHHIIIII")
+SESSION = struct.Struct("<QIIHB5x")
+ALIGN = 64
+CHANNELS = 6
+# Longest session the uint32 microsecond timestamps can hold (about 71 minutes)
+MAX_SPAN_US = 0xFFFFFFFF
+
+# CSV / acquisition file axis names (lower case) to channels, as in src/host/replay_imu.cpp
+AXIS_CHANNELS = {"accx": 0, "accy": 1, "accz": 2, "gyrx": 3, "gyry": 4, "gyrz": 5,
+                 "gyrox": 3, "gyroy": 4, "gyroz": 5}
+
+
+def channel_lsb(channel: int) -> float:
+    return ACC_LSB_PER_G if channel < 3 else GYR_LSB_PER_DPS
+
+
+def to_lsb(value: float, channel: int) -> int:
+    v = int(round(value * channel_lsb(channel)))
+    return max(-32768, min(32767, v))
+
+
+def channels_of(mask: int) -> List[int]:
+    return [c for c in range(CHANNELS) if mask & (1 << c)]
+
+
+# ==================== Writing ====================
+
+@dataclass
+class SessionData:
+    """One session to write: timestamps in us from any origin, one LSB column per channel in the mask."""
+    name: str
+    label: str
+    channel_mask: int
+    timestamps_us: Sequence[int]
+    columns: Sequence[Sequence[int]]
+
+
+class CorpusWriter:
+    """Streams session blocks to disk; the index, label table and strings are written by close()."""
+
+    def __init__(self, path: str, capacity: int):
+        self._f = open(path, "wb")
+        self._capacity = capacity
+        self._entries: List[bytes] = []
+        self._labels: Dict[str, int] = {}
+        self._strings = bytearray()
+        self._string_offsets: Dict[str, int] = {}
+        self._f.write(b"\x00" * (HEADER.size + capacity * SESSION.size))
+        self._pad()
+
+    def _pad(self) -> None:
+        self._f.write(b"\x00" * (-self._f.tell() % ALIGN))
+
+    def _string(self, text: str) -> int:
+        if text not in self._string_offsets:
+            self._string_offsets[text] = len(self._strings)
+            self._strings += text.encode("utf-8") + b"\x00"
+        return self._string_offsets[text]
+
+    def add(self, session: SessionData) -> int:
+        """Append a session and return its index."""
+        if len(self._entries) >= self._capacity:
+            raise ValueError("corpus capacity exceeded")
+        frames = len(session.timestamps_us)
+        channels = channels_of(session.channel_mask)
+        if session.channel_mask >> CHANNELS or len(session.columns) != len(channels):
+            raise ValueError(f"{session.name}: columns do not match channel mask 0x{session.channel_mask:02x}")
+        if any(len(column) != frames for column in session.columns):
+            raise ValueError(f"{session.name}: columns differ in length")
+        origin = session.timestamps_us[0] if frames else 0
+        timestamps = array("I", (t - origin for t in session.timestamps_us)) if frames else array("I")
+        if frames and (timestamps[-1] > MAX_SPAN_US or any(b < a for a, b in zip(timestamps, timestamps[1:]))):
+            raise ValueError(f"{session.name}: timestamps must increase and span less than {MAX_SPAN_US} us")
+        label = self._labels.setdefault(session.label, len(self._labels))
+        offset = self._f.tell()
+        self._write(timestamps)
+        for column in session.columns:
+            self._write(array("h", column))
+        self._pad()
+        self._entries.append(SESSION.pack(offset, frames, self._string(session.name), label,
+                                          session.channel_mask))
+        return len(self._entries) - 1
+
+    def _write(self, values: array) -> None:
+        if sys.byteorder == "big":
+            values.byteswap()
+        values.tofile(self._f)
+
+    def close(self) -> None:
+        labels_offset = self._f.tell()
+        label_offsets = array("I", (self._string(name) for name in self._labels))
+        strings_offset = labels_offset + 4 * len(label_offsets)
+        if strings_offset + len(self._strings) > 0xFFFFFFFF:
+            self._f.close()
+            raise ValueError("corpus exceeds 4 GB, split the inputs")
+        self._write(label_offsets)
+        self._f.write(self._strings)
+        self._f.seek(0)
+        self._f.write(HEADER.pack(MAGIC, VERSION, SESSION.size, len(self._entries), len(self._labels),
+                                  labels_offset, strings_offset, len(self._strings)))
+        self._f.write(b"".join(self._entries))
+        self._f.close()
+
+    def __enter__(self) -> "CorpusWriter":
+        return self
+
+    def __exit__(self, *exc: Any) -> None:
+        self.close()
+
+
+# ==================== Reading ====================
+
+class Session:
+    """A session of a mapped corpus; columns and windows are memoryviews into the mapping."""
+
+    def __init__(self, corpus: "Corpus", index: int, offset: int, frames: int, name: str, label: str,
+                 channel_mask: int):
+        self.corpus = corpus
+        self.index = index
+        self.frames = frames
+        self.name = name
+        self.label = label
+        self.channel_mask = channel_mask
+        self._offset = offset
+
+    @property
+    def spec(self) -> str:
+        """Path accepted by host_replay and the replay tools."""
+        return f"{self.corpus.path}#{self.index}"
+
+    def channels(self) -> List[int]:
+        return channels_of(self.channel_mask)
+
+    def timestamps_us(self) -> memoryview:
+        return self.corpus._view(self._offset, self.frames, "I")
+
+    def column(self, channel: int) -> memoryview:
+        """int16 LSB samples of one channel (KeyError when the session lacks it)."""
+        if not self.channel_mask & (1 << channel):
+            raise KeyError(f"{self.spec} has no {CHANNEL_NAMES[channel]} column")
+        position = self.channels().index(channel)
+        return self.corpus._view(self._offset + 4 * self.frames + 2 * self.frames * position, self.frames, "h")
+
+    def window(self, end: int, length: int, channels: Sequence[int] = (0, 1, 2)) -> List[memoryview]:
+        """The length frames before end, one view per channel."""
+        if not length <= end <= self.frames:
+            raise IndexError(f"window {end - length}:{end} outside {self.frames} frames")
+        return [self.column(c)[end - length:end] for c in channels]
+
+    def windows(self, length: int = WINDOW_FRAMES, stride: int = STRIDE_FRAMES,
+                channels: Sequence[int] = (0, 1, 2)) -> Iterator[Tuple[int, List[memoryview]]]:
+        """(end frame, per-channel views) for every window at the given stride."""
+        columns = [self.column(c) for c in channels]
+        for end in range(length, self.frames + 1, stride):
+            yield end, [column[end - length:end] for column in columns]
+
+    def timestamps_ms(self) -> List[float]:
+        return [t / 1000.0 for t in self.timestamps_us()]
+
+    def values(self, channels: Sequence[int] = (0, 1, 2)) -> List[List[float]]:
+        """Frames in physical units (g / dps), as load_csv returns them."""
+        columns = [self.column(c) for c in channels]
+        scales = [1.0 / channel_lsb(c) for c in channels]
+        return [[column[i] * s for column, s in zip(columns, scales)] for i in range(self.frames)]
+
+
+class Corpus:
+    """A corpus file mapped read-only. Views handed out keep the mapping alive until they are released."""
+
+    def __init__(self, path: str):
+        if sys.byteorder != "little":
+            raise RuntimeError("session corpora are read on little-endian hosts only")
+        self.path = path
+        with open(path, "rb") as f:
+            self._map = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        self._memory = memoryview(self._map)
+        try:
+            self.sessions = self._parse()
+        except (ValueError, struct.error) as e:
+            self.close()
+            raise ValueError(f"{path}: {e}")
+
+    def _parse(self) -> List[Session]:
+        magic, version, session_bytes, count, label_count, labels_offset, strings_offset, strings_bytes = \
+            HEADER.unpack_from(self._map, 0)
+        if magic != MAGIC:
+            raise ValueError("not a session corpus")
+        if version != VERSION or session_bytes < SESSION.size:
+            raise ValueError(f"unsupported corpus version {version}")
+        strings = bytes(self._memory[strings_offset:strings_offset + strings_bytes])
+        if len(strings) != strings_bytes:
+            raise ValueError("truncated string table")
+
+        def string(offset: int) -> str:
+            return strings[offset:strings.index(b"\x00", offset)].decode("utf-8")
+
+        labels = [string(o) for o in struct.unpack_from(f"<{label_count}I", self._map, labels_offset)]
+        sessions = []
+        for i in range(count):
+            offset, frames, name_offset, label, mask = SESSION.unpack_from(self._map, HEADER.size + i * session_bytes)
+            if offset + frames * (4 + 2 * len(channels_of(mask))) > len(self._map) or label >= label_count:
+                raise ValueError(f"bad session entry {i}")
+            sessions.append(Session(self, i, offset, frames, string(name_offset), labels[label], mask))
+        return sessions
+
+    def _view(self, offset: int, count: int, typecode: str) -> memoryview:
+        size = 4 if typecode == "I" else 2
+        return self._memory[offset:offset + count * size].cast(typecode)
+
+    def __len__(self) -> int:
+        return len(self.sessions)
+
+    def __getitem__(self, index: int) -> Session:
+        return self.sessions[index]
+
+    def __iter__(self) -> Iterator[Session]:
+        return iter(self.sessions)
+
+    def labels(self) -> List[str]:
+        return sorted({s.label for s in self.sessions})
+
+    def close(self) -> None:
+        self._memory.release()
+        try:
+            self._map.close()
+        except BufferError:
+            pass  # views still exported; the mapping goes with the last of them
+
+    def __enter__(self) -> "Corpus":
+        return self
+
+    def __exit__(self, *exc: Any) -> None:
+        self.close()
+
+
+def is_corpus(path: str) -> bool:
+    try:
+        with open(path, "rb") as f:
+            return f.read(len(MAGIC)) == MAGIC
+    except OSError:
+        return False
+
+
+def split_spec(path: str) -> Optional[Tuple[str, int]]:
+    """("corpus", index) for "corpus#index", None for a plain file."""
+    corpus, sep, index = path.rpartition("#")
+    if not sep or not index.isdigit() or os.path.exists(path):
+        return None
+    return corpus, int(index)
+
+
+@functools.lru_cache(maxsize=16)
+def open_corpus(path: str) -> Corpus:
+    """Shared, cached mapping per path (the tools look up labels and samples many times)."""
+    return Corpus(path)
+
+
+def expand_inputs(paths: Sequence[str]) -> List[str]:
+    """Recording paths with every corpus replaced by its sessions ("corpus#index")."""
+    out = []
+    for path in paths:
+        if is_corpus(path):
+            out.extend(s.spec for s in open_corpus(path))
+        else:
+            out.append(path)
+    return out
+
+
+def session_of(path: str) -> Optional[Session]:
+    spec = split_spec(path)
+    if spec is None:
+        return None
+    return open_corpus(spec[0])[spec[1]]
+
+
+def recording_label(path: str) -> str:
+    """The session's label for "corpus#index", else the file name prefix."""
+    session = session_of(path)
+    return session.label if session is not None else label_from_path(path)
+
+
+def load_frames(path: str) -> Tuple[List[float], List[List[float]]]:
+    """load_csv() for CSV recordings and corpus sessions alike: (timestamps in ms, acceleration frames in g)."""
+    session = session_of(path)
+    if session is None:
+        return load_csv(path)
+    return session.timestamps_ms(), session.values([AXIS_CHANNELS[name.lower()] for name in ACC_COLUMNS])
+
+
+_worker_corpus: Optional[Corpus] = None
+_worker_fn: Optional[Callable[[Session], Any]] = None
+
+
+def _worker_init(path: str, fn: Callable[[Session], Any]) -> None:
+    global _worker_corpus, _worker_fn
+    _worker_corpus, _worker_fn = Corpus(path), fn
+
+
+def _worker_call(index: int) -> Any:
+    return _worker_fn(_worker_corpus[index])
+
+
+def map_sessions(path: str, fn: Callable[[Session], Any], jobs: int = 0,
+                 indices: Optional[Sequence[int]] = None) -> List[Any]:
+    """fn(session) for every session (or the given indices), in order, over jobs worker processes.
+
+    fn must be picklable (a module-level function); each worker maps the corpus once.
+    """
+    if indices is None:
+        with Corpus(path) as corpus:
+            indices = list(range(len(corpus)))
+    jobs = jobs or os.cpu_count() or 1
+    if jobs <= 1 or len(indices) <= 1:
+        _worker_init(path, fn)
+        return [_worker_call(i) for i in indices]
+    chunk = max(1, len(indices) // (4 * jobs))
+    with multiprocessing.Pool(jobs, initializer=_worker_init, initargs=(path, fn)) as pool:
+        return pool.map(_worker_call, indices, chunksize=chunk)
+
+
+# ==================== Conversion ====================
+
+def _cbor_decode(data: bytes, pos: int = 0) -> Tuple[Any, int]:
+    """Minimal CBOR decoder for Edge Impulse acquisition files: returns (value, next position)."""
+    initial = data[pos]
+    major, info = initial >> 5, initial & 0x1F
+    pos += 1
+    if major == 7:
+        if info == 20:
+            return False, pos
+        if info == 21:
+            return True, pos
+        if info in (22, 23):
+            return None, pos
+        for size, fmt in ((25, ">e"), (26, ">f"), (27, ">d")):
+            if info == size:
+                width = struct.calcsize(fmt)
+                return struct.unpack_from(fmt, data, pos)[0], pos + width
+        raise ValueError(f"unsupported CBOR simple value {info}")
+    if info < 24:
+        n = info
+    elif info <= 27:
+        width = 1 << (info - 24)
+        n = int.from_bytes(data[pos:pos + width], "big")
+        pos += width
+    elif info == 31 and major in (4, 5):
+        n = -1
+    else:
+        raise ValueError(f"unsupported CBOR length {info}")
+    if major == 0:
+        return n, pos
+    if major == 1:
+        return -1 - n, pos
+    if major in (2, 3):
+        chunk = data[pos:pos + n]
+        return (bytes(chunk) if major == 2 else chunk.decode("utf-8")), pos + n
+    if major == 6:
+        return _cbor_decode(data, pos)
+    items: List[Any] = []
+    count = n if n >= 0 else math.inf
+    while len(items) < count * (2 if major == 5 else 1):
+        if n < 0 and data[pos] == 0xFF:
+            pos += 1
+            break
+        value, pos = _cbor_decode(data, pos)
+        items.append(value)
+    if major == 4:
+        return items, pos
+    return dict(zip(items[::2], items[1::2])), pos
+
+
+def _from_columns(name: str, label: str, axis_names: Sequence[str], timestamps_ms: Sequence[float],
+                  rows: Sequence[Sequence[float]]) -> SessionData:
+    """Physical-unit rows under axis names; unknown axes are dropped, channels ordered by number."""
+    picked = sorted((AXIS_CHANNELS[a.lower()], i) for i, a in enumerate(axis_names) if a.lower() in AXIS_CHANNELS)
+    if not picked:
+        raise ValueError(f"{name}: no IMU axes among {list(axis_names)}")
+    columns = [[to_lsb(row[i], c) for row in rows] for c, i in picked]
+    timestamps = [int(round(t * 1000.0)) for t in timestamps_ms]
+    return SessionData(name, label, sum(1 << c for c, _ in picked), timestamps, columns)
+
+
+def session_from_csv(path: str, label: str) -> SessionData:
+    with open(path, "r", encoding="utf-8") as f:
+        header = f.readline().strip().split(",")
+        if len(header) < 2 or header[0] != "timestamp":
+            raise ValueError(f"{path}: missing CSV header")
+        timestamps: List[float] = []
+        rows: List[List[float]] = []
+        for line in f:
+            fields = line.strip().split(",")
+            if len(fields) < len(header):
+                continue
+            timestamps.append(float(fields[0]))
+            rows.append([float(v) for v in fields[1:len(header)]])
+    return _from_columns(os.path.basename(path), label, header[1:], timestamps, rows)
+
+
+def session_from_acquisition(path: str, label: str) -> SessionData:
+    """Edge Impulse data acquisition document (CBOR or JSON, as raw_recorder.py writes them)."""
+    if path.lower().endswith(".json"):
+        import json
+        with open(path, "r", encoding="utf-8") as f:
+            document = json.load(f)
+    else:
+        with open(path, "rb") as f:
+            document, _ = _cbor_decode(f.read())
+    payload = document["payload"]
+    interval_ms = float(payload["interval_ms"])
+    rows = [v if isinstance(v, list) else [v] for v in payload["values"]]
+    names = [s["name"] for s in payload["sensors"]]
+    return _from_columns(os.path.basename(path), label, names, [i * interval_ms for i in range(len(rows))], rows)
+
+
+def session_from_capture(path: str, label: str) -> SessionData:
+    """A raw binary stream captured from the device (raw_recorder.py --input): LSB as recorded."""
+    with open(path, "rb") as f:
+        recording = decode_chunks([f.read()], StreamDecoder(TYPE_IMU_RAW))
+    channels = recording.channels()
+    if not recording.frames:
+        raise ValueError(f"{path}: no raw IMU packets")
+    columns = [[frame[i] for frame in recording.frames] for i in range(len(channels))]
+    return SessionData(os.path.basename(path), label, recording.channel_mask, recording.timestamps_us, columns)
+
+
+def read_sessions(path: str, label: Optional[str] = None) -> List[SessionData]:
+    """Sessions of one input file, labelled by --label or the file name prefix (corpora keep theirs)."""
+    if is_corpus(path):
+        with Corpus(path) as corpus:
+            return [SessionData(s.name, label or s.label, s.channel_mask, list(s.timestamps_us()),
+                                [list(s.column(c)) for c in s.channels()]) for s in corpus]
+    label = label or label_from_path(path)
+    lower = path.lower()
+    if lower.endswith(".csv"):
+        return [session_from_csv(path, label)]
+    if lower.endswith((".cbor", ".json")):
+        return [session_from_acquisition(path, label)]
+    return [session_from_capture(path, label)]
+
+
+def convert(inputs: Sequence[str], out: str, label: Optional[str] = None) -> int:
+    """Write every input's sessions to out; returns the number of sessions."""
+    capacity = 0
+    for path in inputs:
+        if is_corpus(path):
+            with Corpus(path) as corpus:
+                capacity += len(corpus)
+        else:
+            capacity += 1
+    with CorpusWriter(out, capacity) as writer:
+        for path in inputs:
+            for session in read_sessions(path, label):
+                writer.add(session)
+    with Corpus(out) as corpus:
+        return len(corpus)
+
+
+# ==================== Scan ====================
+
+def _scan_session(session: Session) -> Tuple[int, int]:
+    """(windows, frames) after cutting every window of the model's accelerometer view."""
+    windows = 0
+    for _ in session.windows():
+        windows += 1
+    return windows, session.frames
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    parser = argparse.ArgumentParser(description="Build, list and scan session corpora")
+    parser.add_argument("inputs", nargs="*", help="CSV, CBOR, JSON, raw capture or corpus files to convert")
+    parser.add_argument("--out", help=f"corpus to write ({EXTENSION})")
+    parser.add_argument("--label", help="label for every converted session (default: file name prefix)")
+    parser.add_argument("--list", metavar="CORPUS", help="print the sessions of a corpus")
+    parser.add_argument("--scan", metavar="CORPUS", help="read every window of a corpus and report the rate")
+    parser.add_argument("--jobs", type=int, default=os.cpu_count() or 1, help="worker processes for --scan")
+    args = parser.parse_args(argv)
+
+    if args.out:
+        if not args.inputs:
+            parser.error("--out needs input files")
+        try:
+            count = convert(args.inputs, args.out, args.label)
+        except (OSError, ValueError, KeyError) as e:
+            print(f"[Corpus] {e}")
+            return 1
+        print(f"[Corpus] Wrote {count} sessions to {args.out} ({os.path.getsize(args.out) / 1e6:.1f} MB)")
+    if args.list:
+        with Corpus(args.list) as corpus:
+            for s in corpus:
+                names = "+".join(CHANNEL_NAMES[c] for c in s.channels())
+                span = s.timestamps_us()[-1] / 1e6 if s.frames else 0.0
+                print(f"{s.index:6d}  {s.label:<10} {s.frames:8d} frames {span:8.2f} s  {names}  {s.name}")
+            print(f"[Corpus] {len(corpus)} sessions, labels: {', '.join(corpus.labels())}")
+    if args.scan:
+        start = time.monotonic()
+        counts = map_sessions(args.scan, _scan_session, args.jobs)
+        elapsed = max(time.monotonic() - start, 1e-9)
+        windows = sum(w for w, _ in counts)
+        frames = sum(f for _, f in counts)
+        print(f"[Corpus] {len(counts)} sessions, {windows} windows in {elapsed:.2f} s with {args.jobs} jobs: "
+              f"{windows / elapsed:.0f} windows/s, {frames / elapsed:.0f} frames/s")
+    if not (args.out or args.list or args.scan):
+        parser.error("nothing to do: give --out, --list or --scan")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
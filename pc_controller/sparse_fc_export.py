@@ -0,0 +1,223 @@
+"""
+Sparse FC Export - block-prune the fully connected layer for MODEL_SPARSE_FC
+
+The streaming fully connected layer (src/model_module.cpp) reads its weights in
+blocks of one column: the STREAM_CONV2_CH (10) weights that one class applies
+to one cached second-convolution column. With MODEL_SPARSE_FC the firmware maps
+the all-zero blocks once at start-up and only accumulates the others, bit for
+bit the same as the dense layer, so every pruned block saves 10 MACs per class.
+
+This tool prunes an EON export of the deployed graph to --density of its blocks
+(largest L1 norm kept, at least one block per class) and fine-tunes the blocks
+that survive: recordings are replayed through the host build (replay_runner.py
+--features dumps the fully connected input of every classified window), the
+dense layer's int8 output is the soft target, and gradient descent on the
+dequantized weights restores as much of the dense decision as the kept blocks
+allow. The weights are requantized to the original scale, so the graph
+signature is unchanged; pruned blocks stay exactly zero.
+
+The result is the same compiled model source with only the FC weights
+rewritten: copy it over lib/a5-deminsion_inferencing/src/tflite-model/ for a
+firmware build, or send it with model_ota.py (the dense graph runs the zero
+blocks too, so OTA and verification need no format change).
+
+Usage:
+    python sparse_fc_export.py --build --density 0.5 data/*.csv
+    python sparse_fc_export.py --density 0.3 --epochs 50 --output pruned.cpp data/*.csv
+    python model_ota.py pruned.cpp --version 4
+"""
+
+import argparse
+import math
+import os
+import re
+import sys
+from concurrent.futures import ThreadPoolExecutor
+from typing import List, Optional, Sequence, Tuple
+
+from model_ota import (CONV2_OUTPUT, DEPLOYED_MODEL, FC_BIAS, FC_OUTPUT, FC_WEIGHTS, CompiledModel, load_compiled_model,
+                       reference_fc)
+from replay_runner import DEFAULT_BINARY, build, replay_file
+
+# Every classified window's FC input, no idle pre-filter (same build as novelty_trainer.py)
+BUILD_FLAGS = "-DINFERENCE_INT8_WINDOW=1 -DINFERENCE_IDLE_PREFILTER=0"
+DEFAULT_OUTPUT = "tflite_learn_792000_36_compiled.cpp"
+
+
+def fc_shape(model: CompiledModel) -> Tuple[int, int, int]:
+    """(classes, columns, block): the FC weights are classes x (columns * block), block = second conv channels."""
+    classes, features = model.tensors[FC_WEIGHTS].dims
+    block = model.tensors[CONV2_OUTPUT].dims[-1]
+    if features % block:
+        raise ValueError(f"{features} FC inputs do not split into columns of {block} channels")
+    return classes, features // block, block
+
+
+def block_masks(weights: Sequence[int], classes: int, columns: int, block: int) -> List[int]:
+    """Bit j of masks[k] is set when class k's weights for column j are not all zero (the firmware's g_fc_blocks)."""
+    masks = []
+    for k in range(classes):
+        mask = 0
+        for j in range(columns):
+            start = (k * columns + j) * block
+            if any(weights[start:start + block]):
+                mask |= 1 << j
+        masks.append(mask)
+    return masks
+
+
+def prune_blocks(weights: Sequence[int], classes: int, columns: int, block: int, density: float) -> List[int]:
+    """Zero every block except the round(density * blocks) with the largest L1 norm (at least one per class)."""
+    if not 0.0 < density <= 1.0:
+        raise ValueError("density must be in (0, 1]")
+    norms = [(sum(abs(v) for v in weights[(k * columns + j) * block:(k * columns + j + 1) * block]), k, j)
+             for k in range(classes) for j in range(columns)]
+    keep_count = max(classes, int(round(density * len(norms))))
+    # The strongest block of each class first, so no class is left with only its bias
+    strongest = {max((n for n in norms if n[1] == k), key=lambda n: (n[0], -n[2])) for k in range(classes)}
+    ranked = sorted(strongest, key=lambda n: (-n[0], n[1], n[2])) + \
+        sorted((n for n in norms if n not in strongest), key=lambda n: (-n[0], n[1], n[2]))
+    keep = {(k, j) for _, k, j in ranked[:keep_count]}
+    return [v if (i // block // columns, i // block % columns) in keep else 0 for i, v in enumerate(weights)]
+
+
+def _softmax(logits: Sequence[float]) -> List[float]:
+    top = max(logits)
+    exps = [math.exp(v - top) for v in logits]
+    total = sum(exps)
+    return [v / total for v in exps]
+
+
+def _real_logits(model: CompiledModel, features: Sequence[int], weights: Sequence[float]) -> List[float]:
+    """Float FC output (before requantization) with weights in quantized units."""
+    t = model.tensors
+    scale = t[CONV2_OUTPUT].scale * t[FC_WEIGHTS].scale
+    zp = t[CONV2_OUTPUT].zero_point
+    bias = t[FC_BIAS].data
+    n = len(features)
+    return [scale * (bias[k] + sum((features[i] - zp) * weights[k * n + i] for i in range(n)))
+            for k in range(len(bias))]
+
+
+def teacher_probabilities(model: CompiledModel, features: Sequence[int]) -> List[float]:
+    """Softmax of the dense layer's int8 output, dequantized (the distillation target)."""
+    out = model.tensors[FC_OUTPUT]
+    return _softmax([(v - out.zero_point) * out.scale for v in reference_fc(model, features)])
+
+
+def fine_tune(model: CompiledModel, samples: Sequence[Sequence[int]], targets: Sequence[Sequence[float]],
+              pruned: Sequence[int], epochs: int = 20, learning_rate: float = 2.0) -> List[int]:
+    """Full-batch gradient descent on the kept blocks (cross entropy to the teacher), requantized to int8.
+
+    Pruned blocks stay zero. learning_rate is the step in weight quanta for a unit probability error on an
+    input of average magnitude.
+    """
+    if not samples:
+        return list(pruned)
+    t = model.tensors
+    zp = t[CONV2_OUTPUT].zero_point
+    classes, columns, block = fc_shape(model)
+    n = columns * block
+    masks = block_masks(pruned, classes, columns, block)
+    kept = [bool(masks[i // n] >> (i % n // block) & 1) for i in range(len(pruned))]
+    weights = [float(v) for v in pruned]
+    inputs = [[f - zp for f in sample] for sample in samples]
+    step = learning_rate / (len(samples) * max(1.0, sum(abs(v) for x in inputs for v in x) / (len(inputs) * n)))
+    for _ in range(epochs):
+        grad = [0.0] * len(weights)
+        for sample, x, target in zip(samples, inputs, targets):
+            probs = _softmax(_real_logits(model, sample, weights))
+            for k in range(classes):
+                err = probs[k] - target[k]
+                if err:
+                    row = k * n
+                    for i in range(n):
+                        grad[row + i] += err * x[i]
+        weights = [w - step * g if keep else 0.0 for w, g, keep in zip(weights, grad, kept)]
+    return [max(-127, min(127, int(round(w)))) if keep else 0 for w, keep in zip(weights, kept)]
+
+
+def agreement(model: CompiledModel, samples: Sequence[Sequence[int]], weights: Sequence[int]) -> float:
+    """Fraction of windows whose top class with weights matches the dense layer's."""
+    if not samples:
+        return 1.0
+    same = 0
+    for features in samples:
+        dense = reference_fc(model, features)
+        sparse = reference_fc(model, features, weights)
+        same += dense.index(max(dense)) == sparse.index(max(sparse))
+    return same / len(samples)
+
+
+def rewrite_fc_weights(text: str, weights: Sequence[int], columns_per_line: int) -> str:
+    """Replace the FC weight initializer of a compiled model source, one line per class like the EON export."""
+    pattern = re.compile(r'(int8_t tensor_data%d\[[^\]]*\] = \{)(.*?)(\};)' % FC_WEIGHTS, re.S)
+    if not pattern.search(text):
+        raise ValueError(f"tensor_data{FC_WEIGHTS} not found in the compiled model")
+    rows = [weights[i:i + columns_per_line] for i in range(0, len(weights), columns_per_line)]
+    body = " \n" + "".join("  " + "".join(f"{v}, " for v in row) + "\n" for row in rows)
+    return pattern.sub(lambda m: m.group(1) + body + m.group(3), text, count=1)
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    parser = argparse.ArgumentParser(description="Block-prune the fully connected layer for MODEL_SPARSE_FC")
+    parser.add_argument("files", nargs="*", help="Edge Impulse CSV recordings for fine-tuning (none: prune only)")
+    parser.add_argument("--model", default=DEPLOYED_MODEL, help="EON compiled model to prune")
+    parser.add_argument("--density", type=float, default=0.5, help="fraction of FC weight blocks to keep")
+    parser.add_argument("--epochs", type=int, default=20, help="fine-tuning epochs")
+    parser.add_argument("--learning-rate", type=float, default=2.0, help="fine-tuning step size")
+    parser.add_argument("--binary", default=DEFAULT_BINARY, help="host_replay program")
+    parser.add_argument("--build", action="store_true", help=f"rebuild host_replay with {BUILD_FLAGS}")
+    parser.add_argument("--jobs", type=int, default=os.cpu_count() or 1, help="parallel replay processes")
+    parser.add_argument("--output", default=DEFAULT_OUTPUT, help="pruned compiled model source")
+    args = parser.parse_args(argv)
+
+    try:
+        model = load_compiled_model(args.model)
+        classes, columns, block = fc_shape(model)
+        dense = model.tensors[FC_WEIGHTS].data
+        pruned = prune_blocks(dense, classes, columns, block, args.density)
+    except (OSError, ValueError) as e:
+        print(f"[SparseFC] {e}")
+        return 1
+
+    samples: List[List[int]] = []
+    if args.files:
+        if args.build:
+            build(BUILD_FLAGS)
+        if not os.path.exists(args.binary):
+            print(f"[SparseFC] {args.binary} not found, build it with --build")
+            return 1
+        with ThreadPoolExecutor(max_workers=max(1, args.jobs)) as pool:
+            results = list(pool.map(lambda path: replay_file(args.binary, path, features=True), args.files))
+        samples = [v for result in results for _, v in result.features if len(v) == columns * block]
+        print(f"[SparseFC] {len(samples)} windows from {len(results)} recordings")
+        if not samples:
+            print("[SparseFC] No FC inputs dumped (was host_replay built with INFERENCE_INT8_WINDOW?)")
+            return 1
+
+    weights = pruned
+    if samples:
+        before = agreement(model, samples, pruned)
+        targets = [teacher_probabilities(model, s) for s in samples]
+        tuned = fine_tune(model, samples, targets, pruned, args.epochs, args.learning_rate)
+        after = agreement(model, samples, tuned)
+        print(f"[SparseFC] Agreement with the dense layer: {100.0 * before:.1f}% pruned, "
+              f"{100.0 * after:.1f}% fine-tuned")
+        weights = tuned if after >= before else pruned
+
+    total = classes * columns
+    kept = sum(bin(mask).count("1") for mask in block_masks(weights, classes, columns, block))
+    print(f"[SparseFC] {kept} of {total} blocks kept: {kept * block} of {total * block} MACs per window")
+
+    with open(args.model, encoding="utf-8") as f:
+        text = f.read()
+    with open(args.output, "w", encoding="utf-8") as f:
+        f.write(rewrite_fc_weights(text, weights, columns * block))
+    print(f"[SparseFC] Pruned model written to {args.output}")
+    print("[SparseFC] build_flags: -DINFERENCE_INT8_WINDOW=1 -DMODEL_SPARSE_FC=1")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
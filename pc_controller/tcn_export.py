@@ -0,0 +1,377 @@
+"""
+TCN Export - quantize a temporal convolution network for INFERENCE_TCN_ENGINE
+
+Converts a trained causal, dilated 1D convolution stack (Keras Conv1D layers
+with padding="causal", then a Dense softmax head on the last time step) into
+include/tcn_model.h for the firmware's streaming TCN engine (tcn_module.cpp,
+edge-impulse-sdk/classifier/inferencing_engines/tcn.h). Every layer keeps its
+own history of (kernel - 1) * dilation + 1 frames, so the board pushes each new
+frame through the network once and the cost per sample does not grow with the
+receptive field.
+
+The weights come as JSON, dumped from Keras next to the training script:
+
+    json.dump({"labels": labels,
+               "layers": [{"kernel": l.get_weights()[0].tolist(), "bias": l.get_weights()[1].tolist(),
+                           "dilation": l.dilation_rate[0], "relu": l.activation.__name__ == "relu"}
+                          for l in model.layers if isinstance(l, keras.layers.Conv1D)],
+               "dense": {"kernel": head.get_weights()[0].tolist(), "bias": head.get_weights()[1].tolist()}},
+              open("tcn_weights.json", "w"))
+
+Inputs are the raw accelerometer frames at the model rate (the INFERENCE_INT8_WINDOW window), quantized with
+the deployed CNN's input scale and zero point, since the board feeds the TCN straight from that window.
+Activation ranges are calibrated by running the float network over the recordings given with --calibration
+(resampled to 48 Hz like idle_prefilter_tuner.py); weights are symmetric per tensor, requantization follows
+the TFLite int8 kernels. The header carries a self-test (the first calibration frames and the int8
+engine's probabilities for them) that the board checks before it switches from the CNN to the TCN.
+
+Usage:
+    python tcn_export.py tcn_weights.json --calibration data/*.csv
+    python tcn_export.py tcn_weights.json --calibration data/*.csv --output ../include/tcn_model.h
+"""
+
+import argparse
+import json
+import math
+import os
+import sys
+from dataclasses import dataclass
+from typing import List, Optional, Sequence, Tuple
+
+from gesture_labels import MODEL_LABELS
+from idle_prefilter_tuner import load_csv, resample
+from model_ota import DEPLOYED_MODEL, INPUT, load_compiled_model, multiply_by_quantized_multiplier, quantize_multiplier
+
+DEFAULT_OUTPUT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "include", "tcn_model.h")
+TEST_FRAMES = 24  # one CNN window
+MAX_INPUT_CHANNELS = 16  # EI_TCN_MAX_INPUT_CHANNELS
+
+Matrix = List[List[float]]
+
+
+@dataclass
+class FloatLayer:
+    weights: List[List[List[float]]]  # [out][tap][in], tap 0 is the oldest input
+    bias: List[float]
+    dilation: int
+    relu: bool
+
+    @property
+    def kernel_size(self) -> int:
+        return len(self.weights[0])
+
+    @property
+    def history(self) -> int:
+        return (self.kernel_size - 1) * self.dilation + 1
+
+
+@dataclass
+class FloatTcn:
+    labels: List[str]
+    layers: List[FloatLayer]
+    head_weights: Matrix  # [class][feature]
+    head_bias: List[float]
+
+
+@dataclass
+class QuantLayer:
+    in_channels: int
+    out_channels: int
+    kernel_size: int
+    dilation: int
+    weights: List[int]  # flattened [out][tap][in]
+    bias: List[int]
+    multiplier: int
+    shift: int
+    input_offset: int
+    output_offset: int
+    act_min: int
+
+    @property
+    def history(self) -> int:
+        return (self.kernel_size - 1) * self.dilation + 1
+
+
+@dataclass
+class QuantTcn:
+    input_scale: float
+    input_zero_point: int
+    layers: List[QuantLayer]
+    head_weights: List[int]  # flattened [class][feature]
+    head_bias: List[int]
+    head_input_offset: int
+    head_logit_scale: float
+    classes: int
+
+
+def parse_keras(data: dict) -> FloatTcn:
+    """Keras Conv1D kernels are [tap][in][out], Dense kernels [in][out]."""
+    layers = []
+    for n, layer in enumerate(data["layers"]):
+        kernel = layer["kernel"]
+        taps, inputs, outputs = len(kernel), len(kernel[0]), len(kernel[0][0])
+        if layers and inputs != len(layers[-1].weights):
+            raise ValueError(f"layer {n} takes {inputs} channels, the previous layer gives {len(layers[-1].weights)}")
+        weights = [[[kernel[k][i][o] for i in range(inputs)] for k in range(taps)] for o in range(outputs)]
+        layers.append(FloatLayer(weights, list(layer["bias"]), int(layer.get("dilation", 1)),
+                                 bool(layer.get("relu", True))))
+    if not layers:
+        raise ValueError("the network has no convolution layers")
+    kernel = data["dense"]["kernel"]
+    if len(kernel) != len(layers[-1].weights):
+        raise ValueError(f"the head takes {len(kernel)} features, the last layer gives {len(layers[-1].weights)}")
+    head = [[kernel[i][k] for i in range(len(kernel))] for k in range(len(kernel[0]))]
+    return FloatTcn(list(data.get("labels", [])), layers, head, list(data["dense"]["bias"]))
+
+
+def receptive_field(layers: Sequence) -> int:
+    return 1 + sum(layer.history - 1 for layer in layers)
+
+
+def float_forward(model: FloatTcn, frames: Sequence[Sequence[float]]) -> List[Matrix]:
+    """Outputs of every layer at every time step (causal convolution, zero padding before the first frame)."""
+    outputs = []
+    x = [list(frame) for frame in frames]
+    for layer in model.layers:
+        y = []
+        for t in range(len(x)):
+            row = []
+            for o, filt in enumerate(layer.weights):
+                acc = layer.bias[o]
+                for k, tap in enumerate(filt):
+                    s = t - (layer.kernel_size - 1 - k) * layer.dilation
+                    if s >= 0:
+                        acc += sum(w * v for w, v in zip(tap, x[s]))
+                row.append(max(0.0, acc) if layer.relu else acc)
+            y.append(row)
+        outputs.append(y)
+        x = y
+    return outputs
+
+
+def activation_quantization(values: Sequence[float]) -> Tuple[float, int]:
+    """Asymmetric int8 (scale, zero point) covering values and 0, as the TFLite converter does."""
+    low = min(0.0, min(values, default=0.0))
+    high = max(0.0, max(values, default=0.0))
+    scale = (high - low) / 255.0 or 1.0
+    zero_point = int(round(-128 - low / scale))
+    return scale, max(-128, min(127, zero_point))
+
+
+def _symmetric(values: Sequence[float]) -> float:
+    largest = max((abs(v) for v in values), default=0.0)
+    return largest / 127.0 if largest > 0 else 1.0
+
+
+def quantize_tcn(model: FloatTcn, calibration: Sequence[Sequence[Sequence[float]]], input_scale: float,
+                 input_zero_point: int) -> QuantTcn:
+    """int8 weights and requantization per layer; activation ranges from the float outputs on calibration."""
+    per_layer: List[List[float]] = [[] for _ in model.layers]
+    for frames in calibration:
+        for n, out in enumerate(float_forward(model, frames)):
+            per_layer[n].extend(v for row in out for v in row)
+
+    layers = []
+    in_scale, in_zp = input_scale, input_zero_point
+    for layer, values in zip(model.layers, per_layer):
+        out_scale, out_zp = activation_quantization(values)
+        flat = [w for filt in layer.weights for tap in filt for w in tap]
+        w_scale = _symmetric(flat)
+        multiplier, shift = quantize_multiplier(in_scale * w_scale / out_scale)
+        layers.append(QuantLayer(
+            in_channels=len(layer.weights[0][0]), out_channels=len(layer.weights), kernel_size=layer.kernel_size,
+            dilation=layer.dilation, weights=[max(-127, min(127, int(round(w / w_scale)))) for w in flat],
+            bias=[int(round(b / (in_scale * w_scale))) for b in layer.bias], multiplier=multiplier, shift=shift,
+            input_offset=-in_zp, output_offset=out_zp, act_min=out_zp if layer.relu else -128))
+        in_scale, in_zp = out_scale, out_zp
+
+    flat = [w for row in model.head_weights for w in row]
+    w_scale = _symmetric(flat)
+    return QuantTcn(input_scale, input_zero_point, layers,
+                    [max(-127, min(127, int(round(w / w_scale)))) for w in flat],
+                    [int(round(b / (in_scale * w_scale))) for b in model.head_bias], -in_zp, in_scale * w_scale,
+                    len(model.head_bias))
+
+
+def quantize_frame(frame: Sequence[float], scale: float, zero_point: int) -> List[int]:
+    return [max(-128, min(127, int(round(v / scale)) + zero_point)) for v in frame]
+
+
+def _softmax(logits: Sequence[float]) -> List[float]:
+    top = max(logits)
+    exps = [math.exp(v - top) for v in logits]
+    total = sum(exps)
+    return [v / total for v in exps]
+
+
+class TcnReference:
+    """Integer model of ei_tcn_step: per-layer history rings, one frame per step."""
+
+    def __init__(self, model: QuantTcn):
+        self.model = model
+        self.reset()
+
+    def reset(self) -> None:
+        self.history = [[[-layer.input_offset] * layer.in_channels for _ in range(layer.history)]
+                        for layer in self.model.layers]
+        self.heads = [0] * len(self.model.layers)
+
+    def step(self, frame: Sequence[int]) -> List[float]:
+        x = list(frame)
+        for n, layer in enumerate(self.model.layers):
+            ring, head = self.history[n], self.heads[n]
+            ring[head] = x
+            y = []
+            for o in range(layer.out_channels):
+                acc = layer.bias[o]
+                for k in range(layer.kernel_size):
+                    past = ring[(head - (layer.kernel_size - 1 - k) * layer.dilation) % layer.history]
+                    start = (o * layer.kernel_size + k) * layer.in_channels
+                    acc += sum((v + layer.input_offset) * w
+                               for v, w in zip(past, layer.weights[start:start + layer.in_channels]))
+                out = multiply_by_quantized_multiplier(acc, layer.multiplier, layer.shift) + layer.output_offset
+                y.append(max(layer.act_min, min(127, out)))
+            self.heads[n] = (head + 1) % layer.history
+            x = y
+        features = len(x)
+        return _softmax([(b + sum((v + self.model.head_input_offset) * w for v, w in
+                                  zip(x, self.model.head_weights[k * features:(k + 1) * features])))
+                         * self.model.head_logit_scale for k, b in enumerate(self.model.head_bias)])
+
+
+def _array(ctype: str, name: str, values: Sequence, per_line: int = 16) -> List[str]:
+    lines = [f"static const {ctype} {name}[{len(values)}] = {{"]
+    for i in range(0, len(values), per_line):
+        lines.append("    " + " ".join(f"{v}," for v in values[i:i + per_line]))
+    lines.append("};")
+    return lines
+
+
+def format_header(model: Optional[QuantTcn], test_frames: Sequence[Sequence[int]] = (),
+                  test_scores: Sequence[float] = ()) -> str:
+    lines = [
+        "#ifndef TCN_MODEL_H",
+        "#define TCN_MODEL_H",
+        "",
+        "// TCN 推理引擎的模型：因果膨胀一维卷积层 + 最新一帧上的分类头（见 tcn_module.cpp 与 SDK 的",
+        "// inferencing_engines/tcn.h）",
+        "// 由 pc_controller/tcn_export.py 生成" + ("，不要手工修改" if model else "；尚未训练时没有层，推理仍用 CNN"),
+        "",
+        "#include <stdint.h>",
+        "#include \"edge-impulse-sdk/classifier/ei_model_types.h\"",
+        "",
+    ]
+    if model is None:
+        lines += [
+            "#define TCN_MODEL_LAYERS 0",
+            "#define TCN_MODEL_INPUT_CHANNELS 0",
+            "#define TCN_MODEL_CLASSES 0",
+            "#define TCN_MODEL_RECEPTIVE_FIELD 0",
+            "#define TCN_MODEL_TEST_FRAMES 0",
+            "",
+            "static const ei_learning_block_config_tcn_t kTcnConfig = {1, 0, 0, 0.0f, 0, nullptr, 0, nullptr, nullptr, "
+            "0, 0.0f, 0, nullptr};",
+            "static const int8_t kTcnTestFrames[1] = {0};",
+            "static const float kTcnTestScores[1] = {0.0f};",
+            "",
+            "#endif",
+            "",
+        ]
+        return "\n".join(lines)
+
+    channels = model.layers[0].in_channels
+    widest = max([channels] + [layer.out_channels for layer in model.layers])
+    lines += [
+        f"#define TCN_MODEL_LAYERS {len(model.layers)}",
+        f"#define TCN_MODEL_INPUT_CHANNELS {channels}",
+        f"#define TCN_MODEL_CLASSES {model.classes}",
+        f"#define TCN_MODEL_RECEPTIVE_FIELD {receptive_field(model.layers)}",
+        f"#define TCN_MODEL_TEST_FRAMES {len(test_frames)}",
+        "",
+    ]
+    entries = []
+    for n, layer in enumerate(model.layers):
+        lines += _array("int8_t", f"kTcnWeights{n}", layer.weights)
+        lines += _array("int32_t", f"kTcnBias{n}", layer.bias, 8)
+        lines.append(f"static int8_t g_tcn_history{n}[{layer.history * layer.in_channels}];")
+        lines.append(f"static uint16_t g_tcn_head{n};")
+        lines.append("")
+        entries.append(f"    {{{layer.in_channels}, {layer.out_channels}, {layer.kernel_size}, {layer.dilation}, "
+                       f"kTcnWeights{n}, kTcnBias{n}, {layer.multiplier}, {layer.shift}, {layer.input_offset}, "
+                       f"{layer.output_offset}, {layer.act_min}, g_tcn_history{n}, &g_tcn_head{n}}},")
+    lines += ["static const ei_tcn_layer_t kTcnLayers[TCN_MODEL_LAYERS] = {"] + entries + ["};", ""]
+    lines += _array("int8_t", "kTcnHeadWeights", model.head_weights)
+    lines += _array("int32_t", "kTcnHeadBias", model.head_bias, 8)
+    lines.append(f"static int8_t g_tcn_scratch[2 * {widest}];")
+    lines.append("")
+    lines.append(f"static const ei_learning_block_config_tcn_t kTcnConfig = {{1, 0, {channels}, "
+                 f"{model.input_scale:.9g}f, {model.input_zero_point}, kTcnLayers, TCN_MODEL_LAYERS, kTcnHeadWeights, "
+                 f"kTcnHeadBias, {model.head_input_offset}, {model.head_logit_scale:.9g}f, {model.classes}, "
+                 f"g_tcn_scratch}};")
+    lines.append("")
+    lines.append("// 自检：逐帧送入下面的帧后（从复位状态开始），最后一帧的各类概率")
+    lines += _array("int8_t", "kTcnTestFrames", [v for frame in test_frames for v in frame] or [0], channels * 8)
+    lines.append("static const float kTcnTestScores[TCN_MODEL_CLASSES] = {" +
+                 ", ".join(f"{p:.6g}f" for p in test_scores) + "};")
+    lines += ["", "#endif", ""]
+    return "\n".join(lines)
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    parser = argparse.ArgumentParser(description="Quantize a trained TCN for the firmware's streaming engine")
+    parser.add_argument("weights", help="JSON dump of the Keras Conv1D layers and the Dense head")
+    parser.add_argument("--calibration", nargs="+", required=True, help="Edge Impulse CSV recordings")
+    parser.add_argument("--deployed", default=DEPLOYED_MODEL, help="compiled CNN whose input quantization is used")
+    parser.add_argument("--output", default=DEFAULT_OUTPUT, help="generated header")
+    args = parser.parse_args(argv)
+
+    try:
+        with open(args.weights, encoding="utf-8") as f:
+            model = parse_keras(json.load(f))
+        if model.labels and tuple(model.labels) != MODEL_LABELS:
+            raise ValueError(f"labels {model.labels} differ from the deployed model's {list(MODEL_LABELS)}")
+        if len(model.head_bias) != len(MODEL_LABELS):
+            raise ValueError(f"the head has {len(model.head_bias)} classes, the firmware {len(MODEL_LABELS)}")
+        channels = len(model.layers[0].weights[0][0])
+        if channels > MAX_INPUT_CHANNELS:
+            raise ValueError(f"{channels} input channels, the engine takes at most {MAX_INPUT_CHANNELS}")
+        recordings = [resample(*load_csv(path)) for path in args.calibration]
+        recordings = [frames for frames in recordings if frames]
+        if not recordings or any(len(frames[0]) != channels for frames in recordings):
+            raise ValueError(f"calibration recordings must hold {channels} axes")
+        input_tensor = load_compiled_model(args.deployed).tensors[INPUT]
+    except (OSError, ValueError, KeyError, IndexError) as e:
+        print(f"[TCN] {e}")
+        return 1
+
+    quant = quantize_tcn(model, recordings, input_tensor.scale, input_tensor.zero_point)
+    print(f"[TCN] {len(quant.layers)} layers, receptive field {receptive_field(quant.layers)} frames, "
+          f"{sum(len(layer.weights) for layer in quant.layers) + len(quant.head_weights)} weights")
+
+    # Agreement of the int8 engine with the float network over every calibration step
+    reference = TcnReference(quant)
+    agreed = total = 0
+    for frames in recordings:
+        reference.reset()
+        outputs = float_forward(model, frames)[-1]
+        for frame, features in zip(frames, outputs):
+            probs = reference.step(quantize_frame(frame, quant.input_scale, quant.input_zero_point))
+            logits = [b + sum(w * v for w, v in zip(row, features)) for row, b in zip(model.head_weights,
+                                                                                    model.head_bias)]
+            agreed += probs.index(max(probs)) == logits.index(max(logits))
+            total += 1
+    print(f"[TCN] int8 engine agrees with the float network on {agreed} of {total} steps")
+
+    test_frames = [quantize_frame(frame, quant.input_scale, quant.input_zero_point)
+                   for frame in recordings[0][:TEST_FRAMES]]
+    reference.reset()
+    scores = [reference.step(frame) for frame in test_frames][-1]
+    with open(args.output, "w", encoding="utf-8") as f:
+        f.write(format_header(quant, test_frames, scores))
+    print(f"[TCN] Model written to {args.output}")
+    print("[TCN] build_flags: -DINFERENCE_INT8_WINDOW=1 -DINFERENCE_POSTPROCESS_INT8=0 -DINFERENCE_TCN_ENGINE=1")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
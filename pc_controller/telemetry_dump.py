@@ -0,0 +1,299 @@
+"""
+Telemetry dump - read the board's field diagnostics log
+
+Firmware built with TELEMETRY_ENABLE appends small records to a ring of flash
+sectors below the few-shot page: every reset and its cause, published
+gestures, rate-limited low-confidence windows, a confidence histogram per
+minute, per-label histograms of the winning probability and of its margin over
+the runner-up (TELEMETRY_LABEL_HISTOGRAM_MS, 10 minutes by default), latency
+SLO violations and the reason of a supervisor reset. Shadow-mode builds
+(INFERENCE_SHADOW_MODEL) add how often a candidate model agreed with the
+production model on the same windows, with both models' confidence histograms.
+When a
+board "stops recognizing" in the field, a dump shows what led up to it across
+reboots, without a debugger or a host that was connected at the time.
+
+Records (little-endian): uint8 type, uint8 payload length, uint16
+CRC-16/CCITT-FALSE over the rest of the header and the payload, uint32
+milliseconds since boot, then the payload padded to 4 bytes. A dump is the
+records of every sector in the order they were written, oldest first.
+
+Usage:
+    python telemetry_dump.py                       # scan over BLE, print a summary per boot
+    python telemetry_dump.py --port /dev/ttyACM0   # over the USB link
+    python telemetry_dump.py --status
+    python telemetry_dump.py --output log.jsonl    # one JSON record per line
+"""
+
+import argparse
+import asyncio
+import json
+import struct
+import sys
+from collections import Counter
+from dataclasses import asdict, dataclass, field
+from typing import Any, Dict, List, Optional, Tuple
+
+from ble_manager import CRASH_KINDS, CRASH_THREADS, LATENCY_STAGES, TelemetryStatus
+from gesture_labels import MODEL_LABELS
+from serial_manager import crc16
+from wire_schema import RESULT
+
+RECORD_HEADER = struct.Struct('<BBHI')
+MAX_PAYLOAD = 32  # TELEMETRY_MAX_PAYLOAD
+
+# telemetry_record_type_t in include/telemetry_module.h
+RECORD_TYPES = {1: "reset", 2: "gesture", 3: "low_confidence", 4: "histogram", 5: "latency_slo", 6: "fatal", 7: "crash",
+                8: "label_histogram", 9: "shadow", 10: "shadow_histogram"}
+
+# telemetry_shadow_t; the counts are defined in include/shadow_tally.h
+SHADOW = struct.Struct('<BB6H2xII')
+SHADOW_FIELDS = ("candidate", "production", "runs", "agree", "candidate_only", "production_only", "differ", "deferred",
+                 "mean_us", "max_us")
+
+# telemetry_label_histogram_kind_t; bins split the probability quantized to a byte (x 255) evenly
+LABEL_HISTOGRAM_KINDS = ("top", "margin")
+
+# mbed reset_reason_t
+RESET_REASONS = ("power_on", "pin_reset", "brown_out", "software", "watchdog", "lockup", "wake_low_power",
+                 "access_error", "boot_error", "multiple", "platform", "unknown")
+
+
+@dataclass
+class Record:
+    type: str
+    time_ms: int
+    fields: Dict[str, Any] = field(default_factory=dict)
+
+
+def label(index: int) -> str:
+    return MODEL_LABELS[index] if 0 <= index < len(MODEL_LABELS) else str(index)
+
+
+def decode_payload(record_type: int, payload: bytes) -> Dict[str, Any]:
+    if record_type == 1 and len(payload) >= 1:
+        reason = payload[0]
+        return {"reason": RESET_REASONS[reason] if reason < len(RESET_REASONS) else "unknown"}
+    if record_type == 2 and len(payload) >= RESULT.size:
+        index, confidence, sequence = RESULT.unpack_from(payload)
+        return {"gesture": label(index), "confidence": confidence / 255, "sequence": sequence}
+    if record_type == 3 and len(payload) >= 4:
+        index, confidence, suppressed = struct.unpack_from('<BBH', payload)
+        return {"gesture": None if index == 0xFF else label(index), "confidence": confidence / 255,
+                "suppressed": suppressed}
+    if record_type == 4:
+        return {"bins": list(struct.unpack_from(f'<{len(payload) // 2}H', payload))}
+    if record_type == 5 and len(payload) >= 12:
+        stage, over, p99, worst = struct.unpack_from('<BxHII', payload)
+        return {"stage": LATENCY_STAGES[stage] if stage < len(LATENCY_STAGES) else str(stage), "over": over,
+                "p99_us": p99, "max_us": worst}
+    if record_type == 6:
+        return {"reason": payload.decode("ascii", errors="replace")}
+    if record_type == 7 and len(payload) >= 16:
+        kind, thread, status, pc, lr = struct.unpack_from('<BBxxIII', payload)
+        return {"kind": CRASH_KINDS[kind] if kind < len(CRASH_KINDS) else str(kind),
+                "thread": CRASH_THREADS[thread] if thread < len(CRASH_THREADS) else None,
+                "status": f"0x{status:08x}", "pc": f"0x{pc:08x}", "lr": f"0x{lr:08x}"}
+    if record_type == 9 and len(payload) >= SHADOW.size:
+        return dict(zip(SHADOW_FIELDS, SHADOW.unpack_from(payload)))
+    if record_type == 10 and len(payload) >= 4:
+        return {"model": payload[0], "candidate": bool(payload[1]),
+                "bins": list(struct.unpack_from(f'<{(len(payload) - 4) // 2}H', payload, 4))}
+    if record_type == 8 and len(payload) >= 4:
+        index, kind = payload[0], payload[1]
+        return {"gesture": label(index),
+                "kind": LABEL_HISTOGRAM_KINDS[kind] if kind < len(LABEL_HISTOGRAM_KINDS) else str(kind),
+                "bins": list(struct.unpack_from(f'<{(len(payload) - 4) // 2}H', payload, 4))}
+    return {"payload": payload.hex()}
+
+
+def decode_records(data: bytes) -> Tuple[List[Record], int]:
+    """Records of a dump and the number of bytes that did not decode.
+
+    A record with a bad CRC is skipped by its length, as the device walks its sectors; an impossible
+    length ends the decoding.
+    """
+    records = []
+    offset = 0
+    damaged = 0
+    while offset + RECORD_HEADER.size <= len(data):
+        record_type, length, crc, time_ms = RECORD_HEADER.unpack_from(data, offset)
+        size = RECORD_HEADER.size + (length + 3) // 4 * 4
+        if length > MAX_PAYLOAD or offset + size > len(data):
+            break
+        payload = data[offset + RECORD_HEADER.size:offset + RECORD_HEADER.size + length]
+        if crc16(data[offset + 4:offset + 8] + payload, crc16(data[offset:offset + 2])) != crc:
+            damaged += size
+        else:
+            name = RECORD_TYPES.get(record_type, f"type_{record_type}")
+            records.append(Record(name, time_ms, decode_payload(record_type, payload)))
+        offset += size
+    return records, damaged + len(data) - offset
+
+
+def split_boots(records: List[Record]) -> List[List[Record]]:
+    """One list per boot: every reset record starts a new one (records before the first are kept)."""
+    boots: List[List[Record]] = []
+    for record in records:
+        if record.type == "reset" or not boots:
+            boots.append([])
+        boots[-1].append(record)
+    return boots
+
+
+def summarize(records: List[Record]) -> List[str]:
+    lines = []
+    for n, boot in enumerate(split_boots(records)):
+        reason = boot[0].fields.get("reason", "?") if boot[0].type == "reset" else "log wrapped"
+        gestures = Counter(r.fields["gesture"] for r in boot if r.type == "gesture")
+        low = sum(1 + r.fields["suppressed"] for r in boot if r.type == "low_confidence")
+        windows = sum(sum(r.fields["bins"]) for r in boot if r.type == "histogram")
+        text = f"boot {n}: {reason}, {boot[-1].time_ms / 1000:.0f} s, {windows} windows, {low} low confidence"
+        if gestures:
+            text += ", " + ", ".join(f"{name} x{count}" for name, count in sorted(gestures.items()))
+        lines.append(text)
+        for record in boot:
+            if record.type in ("latency_slo", "fatal", "crash"):
+                lines.append(f"    {record.time_ms / 1000:9.1f} s {record.type}: {record.fields}")
+    return lines
+
+
+def bin_median(bins: List[int], byte_bins: bool = True) -> float:
+    """Median of a histogram whose bins split 0..255 evenly (or 0..1 when not byte_bins), as a probability
+    (bin centre)."""
+    total = sum(bins)
+    if total == 0:
+        return 0.0
+    seen = 0
+    for n, count in enumerate(bins):
+        seen += count
+        if 2 * seen >= total:
+            break
+    if not byte_bins:
+        return (n + 0.5) / len(bins)
+    width = 256 / len(bins)
+    return min((n + 0.5) * width / 255, 1.0)
+
+
+def label_drift(records: List[Record]) -> List[str]:
+    """Per label: windows won, median winning probability and margin over the whole log, and the change of the
+    median winning probability from its first to its last period (a steady fall hints at sensor drift)."""
+    periods: Dict[Tuple[str, str], List[List[int]]] = {}
+    for record in records:
+        if record.type == "label_histogram":
+            periods.setdefault((record.fields["gesture"], record.fields["kind"]), []).append(record.fields["bins"])
+    lines = []
+    for (name, kind), histograms in sorted(periods.items()):
+        if kind != "top":
+            continue
+        total = [sum(column) for column in zip(*histograms)]
+        margins = periods.get((name, "margin"), [])
+        margin_total = [sum(column) for column in zip(*margins)] if margins else []
+        line = (f"    {name}: {sum(total)} windows, top-1 median {bin_median(total):.2f}, "
+                f"margin median {bin_median(margin_total):.2f}")
+        if len(histograms) > 1:
+            line += f", top-1 median {bin_median(histograms[0]):.2f} -> {bin_median(histograms[-1]):.2f}"
+        lines.append(line)
+    return lines
+
+
+def shadow_summary(records: List[Record]) -> List[str]:
+    """Per candidate / production pair over the whole log: agreement on the compared windows, what the
+    disagreements were, the candidate's cost and the median winning probability of both models."""
+    pairs: Dict[Tuple[int, int], Dict[str, int]] = {}
+    medians: Dict[Tuple[int, bool], List[int]] = {}
+    for record in records:
+        if record.type == "shadow":
+            fields = record.fields
+            pair = pairs.setdefault((fields["candidate"], fields["production"]), Counter())
+            for name in SHADOW_FIELDS[2:8]:
+                pair[name] += fields[name]
+            pair["total_us"] += fields["mean_us"] * fields["runs"]
+            pair["max_us"] = max(pair["max_us"], fields["max_us"])
+        elif record.type == "shadow_histogram":
+            key = (record.fields["model"], record.fields["candidate"])
+            bins = medians.setdefault(key, [0] * len(record.fields["bins"]))
+            for n, count in enumerate(record.fields["bins"]):
+                bins[n] += count
+    lines = []
+    for (candidate, production), pair in sorted(pairs.items()):
+        runs = pair["runs"]
+        agreement = 100.0 * pair["agree"] / runs if runs else 0.0
+        mean_us = pair["total_us"] // runs if runs else 0
+        lines.append(f"    model {candidate} vs {production}: {runs} windows, {agreement:.1f}% agree, "
+                     f"{pair['candidate_only']} candidate only, {pair['production_only']} production only, "
+                     f"{pair['differ']} differ, {pair['deferred']} deferred, mean {mean_us} us, max {pair['max_us']} us, "
+                     f"top-1 median {bin_median(medians.get((production, False), []), False):.2f} -> "
+                     f"{bin_median(medians.get((candidate, True), []), False):.2f}")
+    return lines
+
+
+def describe(status: TelemetryStatus) -> str:
+    return (f"{status.sectors} sectors, {status.log_bytes} bytes in flash, {status.pending_bytes} pending, "
+            f"{status.records} records since boot ({status.dropped} dropped), sequence {status.sequence}, "
+            f"{status.flash_errors} flash errors{', dumping' if status.dumping else ''}")
+
+
+async def run(args) -> int:
+    if args.port:
+        from serial_manager import SerialManager
+        manager = SerialManager()
+    else:
+        from ble_manager import BLEManager
+        manager = BLEManager()
+    manager.set_auto_reconnect(False)
+    address = args.port or args.address
+    connected = await manager.connect(address) if address else await manager.scan_and_connect()
+    if not connected:
+        print("[Telemetry] Device not connected")
+        return 1
+    try:
+        status = await manager.read_telemetry_status()
+        if status is None:
+            print("[Telemetry] No diagnostics log (firmware without TELEMETRY_ENABLE?)")
+            return 1
+        print(f"[Telemetry] Device: {describe(status)}")
+        if args.status:
+            return 0
+        dump = await manager.dump_telemetry(args.timeout)
+        if dump is None:
+            return 1
+        records, damaged = decode_records(bytes(dump.data))
+        if dump.gap:
+            print("[Telemetry] A chunk was lost: the dump ends early")
+        if damaged:
+            print(f"[Telemetry] {damaged} damaged bytes skipped")
+        if args.output:
+            with open(args.output, "w") as f:
+                for record in records:
+                    f.write(json.dumps(asdict(record)) + "\n")
+            print(f"[Telemetry] {len(records)} records written to {args.output}")
+        for line in summarize(records):
+            print(line)
+        drift = label_drift(records)
+        if drift:
+            print("Per-label confidence (first -> last period):")
+            for line in drift:
+                print(line)
+        shadow = shadow_summary(records)
+        if shadow:
+            print("Shadow model (candidate vs production):")
+            for line in shadow:
+                print(line)
+        return 0
+    finally:
+        await manager.disconnect()
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    parser = argparse.ArgumentParser(description="Read the board's field diagnostics log")
+    parser.add_argument("--port", help="serial port of the board (default: BLE)")
+    parser.add_argument("--address", help="BLE device address (default: scan by name)")
+    parser.add_argument("--status", action="store_true", help="print the log status without dumping")
+    parser.add_argument("--output", help="write the decoded records as JSON lines")
+    parser.add_argument("--timeout", type=float, default=60.0, help="seconds to wait for the dump")
+    return asyncio.run(run(parser.parse_args(argv)))
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,70 @@
+import os
+import sys
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from hypothesis import given, strategies as st, settings
+from arena_size import apply_size, parse_record
+
+CAPTURE = """[Inference] Initial window ready, starting continuous inference
+[Memory]     tensor arena             8192 B (tensors 1152, persistent 480, idle between invokes 7712)
+[Memory]       persistent          480 B in 9 (requested 436 B)
+[Memory]       scratch               0 B in 0 (requested 0 B)
+[Memory]       overflow (heap)       0 B in 0 (requested 0 B)
+[Memory]     arena minimum 1632 B (-DEI_TENSOR_ARENA_SIZE=1632), reclaimable 6560 B
+[Memory]   free               120000 B
+"""
+
+INI = """[env:nano33ble]
+platform = nordicnrf52
+build_flags =
+    -DEI_CLASSIFIER_ALLOCATION_STATIC
+
+custom_memory_budgets =
+    total ram 196608
+    sym:tensor_arena ram 4096
+
+[env:nano33ble_zones]
+extends = env:nano33ble
+build_flags =
+    ${env:nano33ble.build_flags}
+    -DPROFILER_ZONES_ENABLE=1
+"""
+
+
+class TestParseRecord:
+    def test_record(self):
+        record = parse_record(CAPTURE.splitlines())
+        assert record.arena_bytes == 8192 and record.tensor_bytes == 1152
+        assert record.minimum_bytes == 1632 and record.overflow_count == 0
+        assert record.buckets["persistent"] == (480, 9, 436)
+
+    def test_last_record_wins(self):
+        second = CAPTURE.replace("1632", "1648").replace("tensors 1152", "tensors 1168")
+        record = parse_record((CAPTURE + second).splitlines())
+        assert record.minimum_bytes == 1648 and record.tensor_bytes == 1168
+
+    def test_no_record(self):
+        assert parse_record(["[Memory]   free 1000 B"]) is None
+
+
+class TestApplySize:
+    def test_flag_and_budget_are_set(self):
+        ini = apply_size(INI, 1632)
+        section = ini.split("[env:nano33ble_zones]")[0]
+        assert "    -DEI_TENSOR_ARENA_SIZE=1632\n" in section
+        assert "    sym:tensor_arena ram 1632\n" in section
+        assert ini.split("[env:nano33ble_zones]")[1] == INI.split("[env:nano33ble_zones]")[1]
+
+    @given(first=st.integers(min_value=16, max_value=65536), second=st.integers(min_value=16, max_value=65536))
+    @settings(max_examples=50)
+    def test_resizing_replaces_the_flag(self, first, second):
+        ini = apply_size(apply_size(INI, first), second)
+        assert ini == apply_size(INI, second)
+        assert ini.count("-DEI_TENSOR_ARENA_SIZE=") == 1
+
+    def test_missing_section(self):
+        try:
+            apply_size(INI, 1632, env="nano33ble_arena")
+        except ValueError:
+            return
+        assert False, "expected ValueError"
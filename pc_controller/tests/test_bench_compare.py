@@ -0,0 +1,49 @@
+import json
+import os
+import sys
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from hypothesis import given, strategies as st, settings
+from bench_compare import compare, load
+
+
+def run_json(results):
+    """Mirror of the JSON printed by src/host/bench_main.cpp: name -> (min, median, max) ns."""
+    return json.dumps({"schema": 1, "compiler": "test", "benchmarks": [
+        {"name": name, "iterations": 1000, "repeats": 7, "ns_per_op": {"min": lo, "median": mid, "max": hi}}
+        for name, (lo, mid, hi) in results.items()]})
+
+
+class TestBenchCompare:
+    def test_load(self):
+        results = load(run_json({"model_invoke": (90000.0, 100000.0, 120000.0)}))
+        assert results["model_invoke"].median_ns == 100000.0 and results["model_invoke"].iterations == 1000
+
+    def test_schema_is_checked(self):
+        try:
+            load(json.dumps({"schema": 2, "benchmarks": []}))
+        except ValueError:
+            return
+        assert False, "an unknown schema must be rejected"
+
+    def test_regression_needs_every_round_slower(self):
+        old = load(run_json({"a": (95.0, 100.0, 105.0), "b": (95.0, 100.0, 105.0)}))
+        # a: every round slower; b: the median is slower but the fastest round is not
+        new = load(run_json({"a": (120.0, 125.0, 130.0), "b": (98.0, 125.0, 130.0)}))
+        rows = {row.name: row for row in compare(old, new, 0.10)}
+        assert rows["a"].regressed and abs(rows["a"].change - 0.25) < 1e-9
+        assert not rows["b"].regressed
+
+    def test_added_and_removed_benchmarks(self):
+        old = load(run_json({"gone": (1.0, 1.0, 1.0)}))
+        new = load(run_json({"added": (1.0, 1.0, 1.0)}))
+        rows = compare(old, new, 0.10)
+        assert [row.name for row in rows] == ["added", "gone"]
+        assert not any(row.regressed for row in rows) and rows[0].change is None
+
+    @given(median=st.floats(min_value=1.0, max_value=1e6), factor=st.floats(min_value=0.5, max_value=1.1))
+    @settings(max_examples=100)
+    def test_within_threshold_never_regresses(self, median, factor):
+        old = load(run_json({"x": (median, median, median)}))
+        new = load(run_json({"x": (median * factor, median * factor, median * factor)}))
+        assert not compare(old, new, 0.10)[0].regressed
@@ -0,0 +1,928 @@
+import asyncio
+import os
+import struct
+import sys
+import time
+from types import SimpleNamespace
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from hypothesis import given, strategies as st, settings
+import ble_manager
+from ble_manager import (CONFIG_PROFILES, CONN_PROFILES, CPU_THREADS, LATENCY_STAGES, RuntimeConfig, encode_ack, encode_config,
+                         encode_profile, parse_config, parse_cpu_utilization, parse_event_burst, parse_gesture,
+                         parse_latency_report, parse_link_params,
+                         encode_benchmark, parse_benchmark_summary, BenchmarkResult, parse_scores,
+                         parse_broadcast, encode_shortcut, encode_keymap, HID_CONSUMER, parse_benchmark_report,
+                         encode_loopback, encode_loopback_report, parse_loopback_echo, parse_loopback_report,
+                         LoopbackResult, encode_missed, DeliveryTracker, ClockSync, LatencyReport, LatencyTracker,
+                         encode_time_sync, parse_time_sync, parse_delivery_counters, BLEManager, STREAM_EVENTS,
+                         STREAM_WINDOW, parse_layout, MultiDeviceManager, parse_segment, INFERENCE_BENCH_STAGES,
+                         encode_inference_benchmark, parse_inference_benchmark, POWER_POINTS, parse_power,
+                         CRASH_KINDS, CRASH_THREADS, PIPELINE_STAGES, parse_crash, HeartbeatMonitor, parse_heartbeat,
+                         parse_layout_heartbeat, parse_onset, encode_operating_point)
+from wire_schema import ConfidenceFormat
+
+event_st = st.tuples(st.integers(min_value=-1, max_value=4), st.integers(min_value=0, max_value=255),
+                     st.integers(min_value=0, max_value=0xFFFF), st.integers(min_value=0, max_value=0xFFFFFFFF))
+
+
+def encode_burst(dropped, events):
+    """Mirror of publish_event_burst() in src/ble_module.cpp."""
+    return bytes([dropped]) + b"".join(struct.pack('<bBHI', *event) for event in events)
+
+
+def encode_numbered_burst(dropped, delivery, events):
+    """Mirror of publish_event_burst() with delivery numbers (3-byte header)."""
+    return struct.pack('<BH', dropped, delivery) + b"".join(struct.pack('<bBHI', *event) for event in events)
+
+
+class TestEventBurst:
+    @given(dropped=st.integers(min_value=0, max_value=255), events=st.lists(event_st, max_size=8))
+    @settings(max_examples=100)
+    def test_round_trip(self, dropped, events):
+        parsed_dropped, parsed = parse_event_burst(encode_burst(dropped, events))
+        assert parsed_dropped == dropped
+        assert [(e.index, e.sequence, e.timestamp_ms) for e in parsed] == [(i, s, t) for i, _, s, t in events]
+        assert all(abs(e.confidence - c / 255.0) < 1e-9 for e, (_, c, _, _) in zip(parsed, events))
+
+    def test_truncated_event_is_ignored(self):
+        data = encode_burst(0, [(2, 255, 7, 1000)]) + b"\x01\x02\x03"
+        _, events = parse_event_burst(data)
+        assert len(events) == 1 and events[0].index == 2 and events[0].confidence == 1.0
+
+    def test_empty_notification(self):
+        assert parse_event_burst(b"") == (0, [])
+
+    def test_full_mtu_burst(self):
+        # 247-byte MTU: 244-byte notification holds 30 events (BLE_EVENTS_PER_NOTIFICATION default)
+        events = [(i % 5, 200, i, 1000 + i) for i in range(30)]
+        data = encode_burst(3, events)
+        assert len(data) <= 247 - 3
+        dropped, parsed = parse_event_burst(data)
+        assert dropped == 3 and [e.sequence for e in parsed] == list(range(30))
+
+
+class TestGesture:
+    @given(index=st.integers(min_value=0, max_value=0xFE), confidence=st.integers(min_value=0, max_value=0xFFFF),
+           sequence=st.integers(min_value=0, max_value=0xFFFF), timestamp_ms=st.integers(min_value=0, max_value=0xFFFFFFFF))
+    @settings(max_examples=100)
+    def test_round_trip(self, index, confidence, sequence, timestamp_ms):
+        # Mirror of publish_latest() in src/ble_module.cpp
+        event = parse_gesture(struct.pack('<BHHI', index, confidence, sequence, timestamp_ms))
+        assert (event.index, event.sequence, event.timestamp_ms) == (index, sequence, timestamp_ms)
+        assert abs(event.confidence - confidence / 65535.0) < 1e-9
+
+    def test_no_result_yet(self):
+        assert parse_gesture(struct.pack('<BHHI', 0xFF, 0, 0, 0)) is None
+
+    def test_short_payload(self):
+        assert parse_gesture(struct.pack('<BBHI', 1, 255, 3, 10)[:7]) is None
+
+    def test_quantized_confidence(self):
+        # Schema 2: one byte in the device's format (zero point 0, scale 1/256 for a softmax output)
+        event = parse_gesture(struct.pack('<BBHI', 3, 230, 4, 20), ConfidenceFormat(0, 1 / 256))
+        assert (event.index, event.sequence, event.timestamp_ms) == (3, 4, 20)
+        assert abs(event.confidence - 230 / 256) < 1e-9
+        # Saturated byte with scale 1/256 stays at 1.0, a zero point above the byte at 0.0
+        assert parse_gesture(struct.pack('<BBHI', 3, 255, 4, 20), ConfidenceFormat(0, 1 / 200)).confidence == 1.0
+        assert parse_gesture(struct.pack('<BBHI', 3, 5, 4, 20), ConfidenceFormat(10, 0.01)).confidence == 0.0
+
+    def test_one_emit_per_notification(self):
+        received = []
+        manager = BLEManager()
+        manager.set_gesture_callback(lambda gesture, confidence: received.append((gesture, confidence)))
+        packed = struct.pack('<BHHI', 2, 65535, 7, 100)
+        manager._on_gesture_notify(None, bytearray(packed))
+        manager._on_gesture_notify(None, bytearray(packed))
+        assert received == [(manager.MODEL_LABELS[2], 1.0)]
+
+    def test_event_callback_times_on_the_host_clock(self):
+        received = []
+        manager = BLEManager()
+        manager.set_event_callback(lambda gesture, confidence, time_s: received.append((gesture, time_s)))
+        before = time.perf_counter()
+        manager._on_gesture_notify(None, bytearray(struct.pack('<BHHI', 2, 65535, 7, 100)))
+        # Not synced yet: the arrival time
+        assert before <= received[0][1] <= time.perf_counter()
+        # Synced with the device 500 s ahead: the publish time mapped onto the host clock
+        manager._clock.add(10.0, 10.002, 510001)
+        manager._on_gesture_notify(None, bytearray(struct.pack('<BHHI', 1, 65535, 8, 509000)))
+        assert received[1][0] == manager.MODEL_LABELS[1] and abs(received[1][1] - 9.0) < 0.002
+
+    def test_legacy_pair_emitted_once(self):
+        received = []
+        manager = BLEManager()
+        manager.set_gesture_callback(lambda gesture, confidence: received.append((gesture, confidence)))
+        manager._on_prediction_notify(None, bytearray(b"left\x00"))
+        manager._on_confidence_notify(None, bytearray(struct.pack('<f', 0.5)))
+        manager._on_prediction_notify(None, bytearray(b"right\x00"))
+        manager._on_confidence_notify(None, bytearray(struct.pack('<f', 0.75)))
+        assert received == [("left", 0.5), ("right", 0.75)]
+
+
+class TestPower:
+    @given(point=st.integers(min_value=0, max_value=len(POWER_POINTS) - 1), measured=st.booleans(),
+           millivolts=st.integers(min_value=0, max_value=0xFFFF))
+    @settings(max_examples=100)
+    def test_round_trip(self, point, measured, millivolts):
+        """Mirror of publish_power() in src/ble_module.cpp."""
+        state = parse_power(struct.pack('<BBH', point, 1 if measured else 0, millivolts))
+        assert (state.point, state.measured, state.millivolts) == (POWER_POINTS[point], measured, millivolts)
+
+    def test_unknown_point_and_short_payload(self):
+        assert parse_power(struct.pack('<BBH', len(POWER_POINTS), 1, 3600)) is None
+        assert parse_power(struct.pack('<BBH', 0, 1, 3600)[:3]) is None
+
+    def test_callback(self):
+        states = []
+        manager = BLEManager()
+        manager.set_power_callback(states.append)
+        manager._on_power_notify(None, bytearray(struct.pack('<BBH', 3, 1, 3380)))
+        assert [(s.point, s.millivolts) for s in states] == [("on-demand", 3380)]
+
+
+
+def encode_heartbeat(delivery, point, millivolts, uptime_ms, events=()):
+    """Mirror of publish_heartbeat() in src/ble_module.cpp (events: records before it, for the parser)."""
+    return encode_numbered_burst(0, delivery, events) + struct.pack('<bBHI', -2, point, millivolts, uptime_ms)
+
+
+class TestHeartbeat:
+    @given(delivery=st.integers(min_value=0, max_value=0xFFFF), point=st.integers(min_value=0, max_value=3),
+           millivolts=st.integers(min_value=0, max_value=0xFFFF), uptime_ms=st.integers(min_value=0, max_value=0xFFFFFFFF))
+    @settings(max_examples=100)
+    def test_round_trip(self, delivery, point, millivolts, uptime_ms):
+        heartbeat = parse_heartbeat(encode_heartbeat(delivery, point, millivolts, uptime_ms))
+        assert (heartbeat.delivery, heartbeat.uptime_ms) == (delivery, uptime_ms)
+        assert (heartbeat.power.point, heartbeat.power.millivolts) == (POWER_POINTS[point], millivolts)
+        assert heartbeat.power.measured == (millivolts != 0)
+
+    def test_not_an_event(self):
+        data = encode_heartbeat(7, 0xFF, 0, 5000, [(1, 200, 9, 4000)])
+        _, events = parse_event_burst(data)
+        assert [(e.index, e.delivery) for e in events] == [(1, 7)]
+        assert parse_heartbeat(data).power is None
+        assert parse_heartbeat(encode_numbered_burst(0, 7, [(1, 200, 9, 4000)])) is None
+        assert parse_heartbeat(encode_burst(0, [(-2, 0, 0, 0)])) is None
+
+    def test_layout_interval(self):
+        layout = struct.pack('<IBBf', 0xDEADBEEF, 2, 0, 1 / 255)
+        assert parse_layout_heartbeat(layout) is None
+        assert parse_layout_heartbeat(layout + struct.pack('<H', 0)) is None
+        assert parse_layout_heartbeat(layout + struct.pack('<H', 2000)) == 2.0
+
+    def test_stall_after_missed_heartbeats(self):
+        monitor = HeartbeatMonitor(missed_limit=3)
+        monitor.start(2.0, 0.0)
+        # Idle for a minute with the heartbeats arriving: never stalled
+        for t in range(2, 60, 2):
+            monitor.alive(float(t))
+            assert not monitor.stalled(t + 1.9)
+        assert not monitor.stalled(58.0 + 5.9)
+        assert monitor.stalled(58.0 + 6.0) and monitor.stalls == 1
+        # Counted once per stretch of silence
+        assert not monitor.stalled(64.5)
+
+    def test_older_firmware_never_stalls(self):
+        monitor = HeartbeatMonitor()
+        monitor.start(None, 0.0)
+        assert not monitor.stalled(1e6)
+
+    def test_heartbeat_reveals_missed_events(self):
+        manager = BLEManager()
+        received = []
+        manager.set_gesture_callback(lambda gesture, confidence: received.append(gesture))
+        manager._on_events_notify(None, bytearray(encode_numbered_burst(0, 0, [(1, 200, 1, 100)])))
+        manager._on_events_notify(None, bytearray(encode_heartbeat(1, 0, 3700, 2100)))
+        assert manager._delivery.missed == 0 and manager.last_heartbeat().uptime_ms == 2100
+        # The notification of event 1 was lost, then the device went idle
+        manager._on_events_notify(None, bytearray(encode_heartbeat(2, 0, 3700, 4100)))
+        assert manager._delivery.missed == 1 and manager._delivery.pending == 1
+        assert received == [manager.MODEL_LABELS[1]]
+
+
+class TestCrash:
+    def encode(self, kind, thread, words, stacks, trail):
+        """Mirror of crash_module_encode() in src/crash_module.cpp."""
+        data = struct.pack('<BBBB10I', kind, thread, len(trail), len(stacks), *words)
+        data += b"".join(struct.pack('<HH', *stack) for stack in stacks)
+        return data + b"".join(struct.pack('<IHBx', *entry) for entry in trail)
+
+    @given(kind=st.integers(min_value=1, max_value=len(CRASH_KINDS) - 1),
+           thread=st.integers(min_value=0, max_value=len(CRASH_THREADS) - 1),
+           words=st.lists(st.integers(min_value=0, max_value=0xFFFFFFFF), min_size=10, max_size=10),
+           trail=st.lists(st.tuples(st.integers(min_value=0, max_value=0xFFFFFFFF),
+                                    st.integers(min_value=0, max_value=0xFFFF),
+                                    st.integers(min_value=0, max_value=len(PIPELINE_STAGES) - 1)), max_size=16))
+    @settings(max_examples=100)
+    def test_round_trip(self, kind, thread, words, trail):
+        stacks = [(4096, 1000 + i) for i in range(len(CRASH_THREADS))]
+        report = parse_crash(self.encode(kind, thread, words, stacks, trail))
+        assert (report.kind, report.thread) == (CRASH_KINDS[kind], CRASH_THREADS[thread])
+        assert [report.status, report.uptime_ms, report.pc, report.lr, report.sp, report.value,
+                report.cfsr, report.hfsr, report.mmfar, report.bfar] == words
+        assert report.stacks == dict(zip(CRASH_THREADS, stacks))
+        assert report.trail == [(PIPELINE_STAGES[stage], start, duration) for start, duration, stage in trail]
+
+    def test_no_report_and_short_payload(self):
+        assert parse_crash(bytes([0, 0, 0, len(CRASH_THREADS)])) is None
+        data = self.encode(4, 0xFF, [0] * 10, [(4096, 0)] * len(CRASH_THREADS), [(10, 20, 2)])
+        assert parse_crash(data).thread is None
+        assert parse_crash(data[:-1]) is None
+
+    def test_callback(self):
+        reports = []
+        manager = BLEManager()
+        manager.set_crash_callback(reports.append)
+        manager._on_crash_notify(None, bytearray(self.encode(1, 1, [0x00010133] + [0] * 9, [], [])))
+        assert [(r.kind, r.thread, r.status) for r in reports] == [("fault", "inference", 0x00010133)]
+
+class TestSegment:
+    def encode(self, index, held, sequence=5, start_ms=100, end_ms=100):
+        """Mirror of publish_segment() in src/ble_module.cpp."""
+        return bytearray(struct.pack('<bBHII', index, 1 if held else 0, sequence, start_ms, end_ms))
+
+    @given(index=st.integers(min_value=0, max_value=127), held=st.booleans(),
+           sequence=st.integers(min_value=0, max_value=0xFFFF), start_ms=st.integers(min_value=0, max_value=0xFFFFFFFF),
+           end_ms=st.integers(min_value=0, max_value=0xFFFFFFFF))
+    @settings(max_examples=100)
+    def test_round_trip(self, index, held, sequence, start_ms, end_ms):
+        state = parse_segment(bytes(self.encode(index, held, sequence, start_ms, end_ms)))
+        assert (state.index, state.held, state.sequence, state.start_ms, state.end_ms) == \
+            (index, held, sequence, start_ms, end_ms)
+
+    def test_no_gesture_and_short_payload(self):
+        assert parse_segment(bytes(self.encode(-1, False))) is None
+        assert parse_segment(bytes(self.encode(1, True))[:11]) is None
+
+    def test_hold_and_release_once(self):
+        holds = []
+        manager = BLEManager()
+        manager.set_hold_callback(lambda gesture, held: holds.append((gesture, held)))
+        manager._on_segment_notify(None, self.encode(2, True))
+        manager._on_segment_notify(None, self.encode(2, True))
+        manager._on_segment_notify(None, self.encode(3, False))
+        manager._on_segment_notify(None, self.encode(2, False))
+        manager._on_segment_notify(None, self.encode(2, False))
+        label = manager.MODEL_LABELS[2]
+        assert holds == [(label, True), (label, False)]
+
+    def test_new_onset_and_disconnect_release(self):
+        holds = []
+        manager = BLEManager()
+        manager._reconnect_enabled = False
+        manager.set_hold_callback(lambda gesture, held: holds.append((gesture, held)))
+        manager._on_segment_notify(None, self.encode(1, True))
+        manager._on_segment_notify(None, self.encode(2, True))
+        manager._on_disconnect(None)
+        first, second = manager.MODEL_LABELS[1], manager.MODEL_LABELS[2]
+        assert holds == [(first, True), (first, False), (second, True), (second, False)]
+
+
+class TestOnset:
+    def encode(self, index, state, onset, confidence=200, sequence=0, sample_ms=1000):
+        """Mirror of publish_onset() in src/ble_module.cpp."""
+        return bytearray(struct.pack('<bBHBHI', index, state, onset, confidence, sequence, sample_ms))
+
+    @given(index=st.integers(min_value=0, max_value=127), state=st.integers(min_value=0, max_value=2),
+           onset=st.integers(min_value=0, max_value=0xFFFF), confidence=st.integers(min_value=0, max_value=255),
+           sequence=st.integers(min_value=0, max_value=0xFFFF), sample_ms=st.integers(min_value=0, max_value=0xFFFFFFFF))
+    @settings(max_examples=100)
+    def test_round_trip(self, index, state, onset, confidence, sequence, sample_ms):
+        report = parse_onset(bytes(self.encode(index, state, onset, confidence, sequence, sample_ms)))
+        assert (report.index, report.state, report.onset, report.sequence, report.sample_ms) == \
+            (index, state, onset, sequence, sample_ms)
+        assert abs(report.confidence - confidence / 255) < 1e-9
+
+    def test_rejects_short_unknown_and_empty(self):
+        assert parse_onset(bytes(self.encode(1, 0, 1))[:10]) is None
+        assert parse_onset(bytes(self.encode(1, 3, 1))) is None
+        assert parse_onset(bytes(self.encode(-1, 0, 0))) is None
+
+    def manager(self):
+        calls = []
+        manager = BLEManager()
+        manager._reconnect_enabled = False
+        manager.set_onset_callback(lambda gesture, state: calls.append((gesture, state)))
+        return manager, calls
+
+    def test_each_provisional_is_resolved_once(self):
+        manager, calls = self.manager()
+        manager._on_onset_notify(None, self.encode(2, 0, 7))
+        manager._on_onset_notify(None, self.encode(2, 0, 7))
+        manager._on_onset_notify(None, self.encode(2, 1, 7, sequence=40))
+        manager._on_onset_notify(None, self.encode(2, 1, 7, sequence=40))
+        manager._on_onset_notify(None, self.encode(3, 0, 8))
+        manager._on_onset_notify(None, self.encode(3, 2, 8))
+        first, second = manager.MODEL_LABELS[2], manager.MODEL_LABELS[3]
+        assert calls == [(first, "provisional"), (first, "confirmed"), (second, "provisional"), (second, "canceled")]
+
+    def test_missed_resolution_and_disconnect_cancel(self):
+        manager, calls = self.manager()
+        # The resolution of onset 1 was merged away: the next provisional cancels it
+        manager._on_onset_notify(None, self.encode(1, 0, 1))
+        manager._on_onset_notify(None, self.encode(2, 0, 2))
+        # A resolution without its provisional report is dropped
+        manager._on_onset_notify(None, self.encode(3, 1, 5))
+        manager._on_disconnect(None)
+        first, second = manager.MODEL_LABELS[1], manager.MODEL_LABELS[2]
+        assert calls == [(first, "provisional"), (first, "canceled"), (second, "provisional"), (second, "canceled")]
+
+
+class TestInferenceBenchmark:
+    stats_st = st.tuples(*[st.integers(min_value=0, max_value=0xFFFFFFFF)] * 5)
+
+    @given(mode=st.integers(min_value=0, max_value=1), state=st.integers(min_value=0, max_value=3),
+           runs=st.integers(min_value=0, max_value=0xFFFF), stages=st.lists(stats_st, min_size=4, max_size=4))
+    @settings(max_examples=100)
+    def test_round_trip(self, mode, state, runs, stages):
+        """Mirror of publish_inference_benchmark() in src/ble_module.cpp."""
+        data = struct.pack('<BBH', mode, state, runs) + b"".join(struct.pack('<5I', *stats) for stats in stages)
+        report = parse_inference_benchmark(data)
+        assert report.mode == ("synthetic", "live")[mode]
+        assert report.state == ("none", "running", "done", "failed")[state]
+        assert report.runs == runs
+        for name, stats in zip(INFERENCE_BENCH_STAGES, stages):
+            stage = report.stages[name]
+            assert (stage.min_us, stage.p50_us, stage.p95_us, stage.p99_us, stage.max_us) == stats
+
+    def test_truncated_notification(self):
+        data = struct.pack('<BBH', 0, 2, 100) + bytes(80)
+        assert parse_inference_benchmark(data) is not None
+        assert parse_inference_benchmark(data[:20]) is None
+
+    def test_request(self):
+        assert encode_inference_benchmark("synthetic", 100) == struct.pack('<BH', 0, 100)
+        assert encode_inference_benchmark("live", 0) == struct.pack('<BH', 1, 1)
+
+
+class TestLinkParams:
+    @given(profile=st.integers(min_value=0, max_value=2), intervals=st.tuples(st.integers(6, 3200), st.integers(6, 3200)),
+           latency=st.integers(0, 499), timeout=st.integers(10, 3200), requests=st.integers(0, 0xFFFF),
+           sent=st.booleans())
+    @settings(max_examples=100)
+    def test_round_trip(self, profile, intervals, latency, timeout, requests, sent):
+        # Mirror of publish_link() in src/ble_module.cpp
+        low, high = sorted(intervals)
+        data = struct.pack('<BHHHHHBB', profile, low, high, latency, timeout, requests, int(sent), 0x03)
+        params = parse_link_params(data)
+        assert params.profile == CONN_PROFILES[profile]
+        assert (params.min_interval_ms, params.max_interval_ms) == (low * 1.25, high * 1.25)
+        assert (params.latency, params.timeout_ms, params.requests, params.sent) == (latency, timeout * 10, requests, sent)
+        assert params.data_length and params.phy_2m
+
+    def test_active_profile_is_7_5_ms(self):
+        params = parse_link_params(struct.pack('<BHHHHHBB', 1, 6, 12, 0, 100, 1, 1, 0x01))
+        assert params.profile == "active" and params.min_interval_ms == 7.5 and params.timeout_ms == 1000
+        assert params.data_length and not params.phy_2m
+
+    def test_short_payload(self):
+        assert parse_link_params(b"\x01\x06\x00") is None
+
+    def test_reconnect_statistics(self):
+        base = struct.pack('<BHHHHHBB', 0, 0, 0, 0, 0, 0, 0, 0)
+        assert parse_link_params(base).reconnects is None
+        params = parse_link_params(base + struct.pack('<BHHH', 3, 120, 450, 1100))
+        assert (params.reconnects, params.reconnect_last_ms) == (3, 120)
+        assert (params.reconnect_mean_ms, params.reconnect_max_ms) == (450, 1100)
+
+
+class TestDelivery:
+    @given(dropped=st.integers(min_value=0, max_value=255), delivery=st.integers(min_value=0, max_value=0xFFFF),
+           events=st.lists(event_st, min_size=1, max_size=8))
+    @settings(max_examples=100)
+    def test_numbered_burst(self, dropped, delivery, events):
+        parsed_dropped, parsed = parse_event_burst(encode_numbered_burst(dropped, delivery, events))
+        assert parsed_dropped == dropped
+        assert [(e.index, e.sequence, e.timestamp_ms) for e in parsed] == [(i, s, t) for i, _, s, t in events]
+        assert [e.delivery for e in parsed] == [(delivery + i) & 0xFFFF for i in range(len(events))]
+
+    def test_old_burst_has_no_delivery_number(self):
+        _, events = parse_event_burst(encode_burst(0, [(1, 200, 9, 50)]))
+        assert len(events) == 1 and events[0].delivery is None
+
+    @given(first=st.integers(min_value=0, max_value=0xFFFF), count=st.integers(min_value=0, max_value=1000))
+    @settings(max_examples=100)
+    def test_missed_request(self, first, count):
+        # handle_missed() in src/ble_module.cpp: uint16 first, uint8 count
+        assert struct.unpack('<HB', encode_missed(first, count)) == (first, min(max(count, 1), 255))
+
+    @given(start=st.integers(min_value=0, max_value=0xFFFF),
+           bursts=st.lists(st.tuples(st.integers(min_value=1, max_value=5), st.integers(min_value=0, max_value=3)),
+                           min_size=1, max_size=20))
+    @settings(max_examples=100)
+    def test_gaps_are_counted_and_requested(self, start, bursts):
+        tracker = DeliveryTracker()
+        number = start
+        sent = missed = 0
+        for count, skip in bursts:
+            if sent == 0:
+                skip = 0
+            gap = tracker.receive((number + skip) & 0xFFFF, count, 0.0)
+            assert gap == ((number, skip) if skip else None)
+            number = (number + skip + count) & 0xFFFF
+            sent += count
+            missed += skip
+        assert tracker.received == sent and tracker.missed == missed and tracker.pending == missed
+
+    def test_recover_and_expire(self):
+        tracker = DeliveryTracker(timeout_s=1.0)
+        tracker.receive(0xFFFE, 1, 0.0)
+        assert tracker.receive(2, 1, 0.1) == (0xFFFF, 3)  # 0xFFFF, 0, 1 missed across the wrap
+        assert tracker.recover(0) and not tracker.recover(0) and not tracker.recover(2)
+        tracker.expire(0.5)
+        assert (tracker.recovered, tracker.lost, tracker.pending) == (1, 0, 2)
+        tracker.expire(1.1)
+        assert (tracker.missed, tracker.recovered, tracker.lost, tracker.pending) == (3, 1, 2, 0)
+
+    def test_restart_drops_pending(self):
+        tracker = DeliveryTracker()
+        tracker.receive(10, 1, 0.0)
+        tracker.receive(13, 1, 0.0)
+        assert tracker.receive(0, 1, 0.0) is None
+        assert (tracker.lost, tracker.pending, tracker.expected) == (2, 0, 1)
+
+
+def sync_exchanges(clock, offset_s, drift_ppm, count, seed_delays, start_s=0.0, period_s=0.5):
+    """Exchanges against a device whose millis() runs at (1 + drift) from offset_s; uneven legs."""
+    for i in range(count):
+        t1 = start_s + i * period_s
+        up, down = seed_delays[i % len(seed_delays)]
+        handled = t1 + up
+        device_ms = int((offset_s + handled * (1 + drift_ppm * 1e-6)) * 1000) % (1 << 32)
+        clock.add(t1, handled + down, device_ms, 0)
+
+
+def device_ms_at(offset_s, drift_ppm, host_s):
+    return int((offset_s + host_s * (1 + drift_ppm * 1e-6)) * 1000) % (1 << 32)
+
+
+class TestClockSync:
+    def test_reply(self):
+        assert encode_time_sync(0x1_0005) == b"\x05\x00"
+        assert parse_time_sync(struct.pack('<HIH', 7, 123456, 40)) == (7, 123456, 40)
+        assert parse_time_sync(b"\x01\x02") is None
+
+    @given(offset_s=st.floats(min_value=-1e5, max_value=4e6), drift=st.floats(min_value=-80, max_value=80),
+           delays=st.lists(st.tuples(st.floats(min_value=0.005, max_value=0.06), st.floats(min_value=0.005, max_value=0.02)),
+                           min_size=4, max_size=16))
+    @settings(max_examples=100)
+    def test_maps_device_time(self, offset_s, drift, delays):
+        # Some requests wait for a poll on the way in; the fastest round trips have even legs
+        delays = delays + [(0.003, 0.003)]
+        clock = ClockSync()
+        sync_exchanges(clock, offset_s, drift, 120, delays)
+        assert clock.ready and abs(clock.delay_s - 0.006) < 1e-9
+        assert abs(clock.drift_ppm - drift) < 30
+        for host_s in (30.0, 59.5, 61.0):
+            assert abs(clock.to_host(device_ms_at(offset_s, drift, host_s)) - host_s) < 0.0015
+
+    def test_offset_before_drift(self):
+        clock = ClockSync()
+        sync_exchanges(clock, 100.0, 50, 4, [(0.005, 0.005), (0.030, 0.005)])
+        assert clock.drift_ppm == 0.0
+        assert abs(clock.offset_ms - 100000.0) < 1.5
+
+    def test_millis_wrap(self):
+        clock = ClockSync()
+        wrap_s = (1 << 32) / 1000.0
+        sync_exchanges(clock, wrap_s - 20.0, 0, 80, [(0.005, 0.005)])  # wraps 20 s in
+        assert abs(clock.to_host(device_ms_at(wrap_s - 20.0, 0, 39.0)) - 39.0) < 0.0015
+        assert abs(clock.to_host(device_ms_at(wrap_s - 20.0, 0, 10.0)) - 10.0) < 0.0015
+
+    def test_not_ready(self):
+        clock = ClockSync()
+        assert clock.to_host(1000) is None and clock.offset_ms is None
+        clock.add(1.0, 0.5, 1000)  # negative round trip is ignored
+        assert not clock.ready
+
+
+class TestLatencyBreakdown:
+    def test_stages(self):
+        tracker = LatencyTracker()
+        assert tracker.breakdown().total_ms is None
+        tracker.set_report(LatencyReport({"inference": 90, "notify": 94, "ack": 130}, {}, None, 0, 0, False))
+        for transit, handling in ((0.020, 0.002), (0.024, 0.003), (0.100, 0.001)):
+            tracker.record(transit, handling)
+        breakdown = tracker.breakdown()
+        assert (breakdown.sensor_ms, breakdown.device_ms) == (90.0, 4.0)
+        assert abs(breakdown.radio_ms - 20.0) < 1e-9 and abs(breakdown.host_ms - 2.0) < 1e-9
+        assert abs(breakdown.total_ms - 116.0) < 1e-9 and breakdown.events == 3
+
+    def test_unsynced_events_only_count_host(self):
+        tracker = LatencyTracker()
+        tracker.record(None, 0.004)
+        breakdown = tracker.breakdown()
+        assert breakdown.radio_ms is None and breakdown.events == 0 and abs(breakdown.host_ms - 4.0) < 1e-9
+        assert tracker.end_to_end_ms() == {0.5: None, 0.95: None, 0.99: None}
+
+    def test_end_to_end_percentiles(self):
+        tracker = LatencyTracker()
+        for transit in range(1, 61):
+            tracker.record(transit / 1000.0, 0.001)
+        tracker.record(None, 0.5)
+        percentiles = tracker.end_to_end_ms()
+        assert abs(percentiles[0.5] - 31.0) < 1e-9 and abs(percentiles[0.99] - 61.0) < 1e-9
+
+
+class TestBenchmark:
+    @given(duration=st.integers(min_value=0, max_value=0xFFFF), mtu=st.integers(min_value=23, max_value=247))
+    @settings(max_examples=100)
+    def test_command(self, duration, mtu):
+        # handle_benchmark() in src/ble_module.cpp: uint16 duration, optional uint16 MTU
+        assert struct.unpack('<HH', encode_benchmark(duration, mtu)) == (duration, mtu)
+        assert struct.unpack('<H', encode_benchmark(duration)) == (duration,)
+
+    @given(packets=st.integers(min_value=0, max_value=0xFFFFFFFE), sent=st.integers(min_value=0, max_value=0xFFFFFFFF),
+           ms=st.integers(min_value=0, max_value=0xFFFFFFFF))
+    @settings(max_examples=100)
+    def test_summary(self, packets, sent, ms):
+        assert parse_benchmark_summary(struct.pack('<IIII', 0xFFFFFFFF, packets, sent, ms)) == (packets, sent, ms)
+
+    def test_data_packet_is_not_a_summary(self):
+        # Data packets start with their index; a 16-byte packet at index 0 is still data
+        assert parse_benchmark_summary(struct.pack('<I', 0) + bytes(12)) is None
+        assert parse_benchmark_summary(struct.pack('<I', 7) + bytes(240)) is None
+
+    def test_throughput(self):
+        result = BenchmarkResult(100, 24400, 1000, 100, 24400, 1.0)
+        assert abs(result.throughput_kbps - 195.2) < 1e-9
+        assert BenchmarkResult(0, 0, 0, 0, 0, 0.0).throughput_kbps == 0.0
+        assert abs(result.device_kbps - 195.2) < 1e-9
+
+    @given(packets=st.integers(min_value=0, max_value=0xFFFFFF), refused=st.integers(min_value=0, max_value=0xFFFFFFFF))
+    @settings(max_examples=100)
+    def test_summary_with_refused(self, packets, refused):
+        # stop_benchmark(): 20-byte summary ends with the notifications the stack refused
+        data = struct.pack('<IIIII', 0xFFFFFFFF, packets, 244 * packets, 3000, refused)
+        assert parse_benchmark_report(data) == (packets, 244 * packets, 3000, refused)
+        assert parse_benchmark_summary(data) == (packets, 244 * packets, 3000)
+        assert parse_benchmark_report(data[:16]) == (packets, 244 * packets, 3000, 0)
+
+    def test_20_byte_data_packet_is_not_a_summary(self):
+        # 23-byte MTU: data packets are 20 bytes too and start with their index
+        assert parse_benchmark_report(struct.pack('<I', 5) + bytes(16)) is None
+
+
+class TestLoopback:
+    @given(sequence=st.integers(min_value=0, max_value=0xFFFF), echoed=st.integers(min_value=0, max_value=0xFFFFFFFF),
+           padding=st.integers(min_value=0, max_value=200))
+    @settings(max_examples=100)
+    def test_command(self, sequence, echoed, padding):
+        # handle_benchmark() in src/ble_module.cpp: 8+ bytes starting with 0xFFFF
+        data = encode_loopback(sequence, echoed, padding)
+        assert len(data) == 8 + padding
+        assert struct.unpack_from('<HHI', data) == (0xFFFF, sequence, echoed)
+
+    def test_commands_do_not_look_like_a_saturation_run(self):
+        # Saturation commands are 2 or 4 bytes; loopback ones at least 8
+        assert len(encode_loopback(0, 0)) == 8
+        assert encode_loopback_report()[:2] == struct.pack('<H', 0xFFFE) and len(encode_loopback_report()) == 8
+
+    @given(sequence=st.integers(min_value=0, max_value=0xFFFF), device_us=st.integers(min_value=1, max_value=0xFFFFFFFF),
+           padding=st.lists(st.integers(min_value=0, max_value=255), max_size=100))
+    @settings(max_examples=100)
+    def test_echo(self, sequence, device_us, padding):
+        assert parse_loopback_echo(struct.pack('<IHI', 0xFFFFFFFE, sequence, device_us) + bytes(padding)) == (sequence, device_us)
+
+    def test_other_notifications_are_not_echoes(self):
+        assert parse_loopback_echo(struct.pack('<IHI', 7, 1, 2)) is None
+        assert parse_loopback_echo(struct.pack('<IIII', 0xFFFFFFFF, 1, 2, 3)) is None
+        assert parse_loopback_echo(b"\xfe\xff\xff\xff") is None
+
+    def test_report(self):
+        report = parse_loopback_report(struct.pack('<IIIHHHH', 0xFFFFFFFD, 200, 1, 75, 120, 150, 412))
+        assert (report.round_trips, report.refused) == (200, 1)
+        assert (report.p50_ms, report.p95_ms, report.p99_ms, report.max_ms) == (7.5, 12.0, 15.0, 41.2)
+        assert parse_loopback_report(struct.pack('<IIIHHHH', 0xFFFFFFFF, 200, 1, 75, 120, 150, 412)) is None
+
+    def test_percentiles(self):
+        result = LoopbackResult([float(v) for v in range(1, 101)], 102, 2)
+        assert result.percentile(0.50) == 50.0 and result.percentile(0.99) == 99.0 and result.percentile(1.0) == 100.0
+        assert LoopbackResult([], 5, 5).percentile(0.5) == 0.0
+
+
+class TestScoreStream:
+    @given(first=st.integers(min_value=0, max_value=0xFFFF),
+           frames=st.lists(st.lists(st.integers(min_value=-128, max_value=127), min_size=5, max_size=5),
+                           min_size=1, max_size=47))
+    @settings(max_examples=100)
+    def test_round_trip(self, first, frames):
+        # Mirror of publish_scores() in src/ble_module.cpp, with the softmax output quantization
+        data = struct.pack('<HBbf', first, 5, -128, 1 / 256) + b"".join(struct.pack('<5b', *f) for f in frames)
+        parsed = parse_scores(data)
+        assert [p.sequence for p in parsed] == [(first + n) & 0xFFFF for n in range(len(frames))]
+        assert [p.scores for p in parsed] == frames
+        assert all(abs(p.probabilities[i] - (q + 128) / 256) < 1e-9 for p in parsed for i, q in enumerate(p.scores))
+
+    def test_truncated_frame_is_ignored(self):
+        data = struct.pack('<HBbf', 9, 5, -128, 1 / 256) + bytes(5) + bytes(3)
+        assert [p.sequence for p in parse_scores(data)] == [9]
+
+    def test_short_payload(self):
+        assert parse_scores(b"\x01\x00\x05") == []
+
+
+class TestBroadcast:
+    @given(index=st.integers(min_value=0, max_value=4), confidence=st.integers(min_value=0, max_value=255),
+           sequence=st.integers(min_value=0, max_value=0xFFFF))
+    @settings(max_examples=100)
+    def test_round_trip(self, index, confidence, sequence):
+        # Mirror of broadcast_result() in src/ble_module.cpp (manufacturer data after the company ID)
+        result = parse_broadcast("AA:BB", struct.pack('<BBH', index, confidence, sequence))
+        assert (result.address, result.index, result.sequence) == ("AA:BB", index, sequence)
+        assert abs(result.confidence - confidence / 255.0) < 1e-9
+
+    def test_no_result_yet(self):
+        assert parse_broadcast("AA:BB", bytes([0xFF, 0, 0, 0])) is None
+
+    def test_short_payload(self):
+        assert parse_broadcast("AA:BB", b"\x01\x02") is None
+
+
+class TestKeymap:
+    def test_shortcut_usages(self):
+        assert encode_shortcut("right") == (0, 0x4F)
+        assert encode_shortcut("ctrl+shift+a") == (0x03, 0x04)
+        assert encode_shortcut("alt+f4") == (0x04, 0x3D)
+        assert encode_shortcut("playpause") == (HID_CONSUMER, 0xCD)
+
+    def test_unmapped_shortcuts_send_nothing(self):
+        assert encode_shortcut("none") == (0, 0)
+        assert encode_shortcut("ctrl") == (0, 0)
+        assert encode_shortcut("ctrl+nosuchkey") == (0, 0)
+
+    def test_keymap_in_label_order(self):
+        # Mirror of handle_keymap() in src/ble_module.cpp: two bytes per model label
+        data = encode_keymap({"left": "right", "right": "left", "up": "ctrl+up"},
+                             ["down", "idle", "left", "right", "up"])
+        assert data == bytes([0, 0, 0, 0, 0, 0x4F, 0, 0x50, 0x01, 0x52])
+
+
+class TestCpuUtilization:
+    @given(values=st.lists(st.integers(min_value=0, max_value=1000), min_size=9, max_size=9))
+    @settings(max_examples=100)
+    def test_round_trip(self, values):
+        utilization = parse_cpu_utilization(struct.pack('<9H', *values))
+        assert abs(utilization.active - values[0] / 1000.0) < 1e-9
+        assert [utilization.threads[name] for name in CPU_THREADS] == [v / 1000.0 for v in values[1:7]]
+        assert utilization.idle == values[7] / 1000.0 and utilization.other == values[8] / 1000.0
+
+    def test_other_unavailable_without_kernel_stats(self):
+        utilization = parse_cpu_utilization(struct.pack('<9H', 300, 10, 250, 20, 5, 0, 15, 700, 0xFFFF))
+        assert utilization.other is None and utilization.threads["inference"] == 0.25
+
+    def test_short_notification(self):
+        assert parse_cpu_utilization(b"\x00\x01") is None
+
+
+def encode_latency(p50, p99, notify_max, over_slo, stalls, watchdog_reset):
+    """Mirror of the latency payload in publish_diagnostics() (src/ble_module.cpp)."""
+    values = [v for pair in zip(p50, p99) for v in pair] + [notify_max, over_slo, stalls]
+    return struct.pack(f'<{len(values)}H', *values) + bytes([1 if watchdog_reset else 0])
+
+
+class TestDeliveryCounters:
+    @given(values=st.tuples(*[st.integers(min_value=0, max_value=0xFFFFFFFF)] * 5))
+    @settings(max_examples=100)
+    def test_round_trip(self, values):
+        # Mirror of publish_diagnostics() in src/ble_module.cpp
+        counters = parse_delivery_counters(struct.pack('<5I', *values))
+        assert (counters.published, counters.suppressed, counters.notify_failures, counters.connected_s,
+                counters.sessions) == values
+
+    def test_short_payload(self):
+        assert parse_delivery_counters(bytes(19)) is None
+
+
+class TestStreams:
+    def test_declared_streams_follow_callbacks(self):
+        # Written to the streams characteristic: the device keeps a raw IMU central on the active profile
+        manager = BLEManager()
+        assert manager.streams() == STREAM_EVENTS
+        manager.set_window_callback(lambda packet: None)
+        assert manager.streams() == STREAM_EVENTS | STREAM_WINDOW
+
+
+class TestMultiDevice:
+    def test_callbacks_carry_the_address(self):
+        multi = MultiDeviceManager()
+        received = []
+        multi.add_device("A")
+        multi.set_gesture_callback(lambda address, gesture, confidence: received.append((address, gesture)))
+        multi.add_device("B")
+        for address, gesture in (("B", "left"), ("A", "up")):
+            multi.device(address)._on_prediction_notify(None, bytearray(gesture.encode()))
+            multi.device(address)._on_confidence_notify(None, bytearray(struct.pack('<f', 0.9)))
+        assert received == [("B", "left"), ("A", "up")]
+
+    def test_metrics_per_device(self):
+        multi = MultiDeviceManager()
+        multi.add_device("A")._on_events_notify(None, bytearray(struct.pack('<BH', 0, 0) + struct.pack('<bBHI', 2, 250, 1, 1000)))
+        multi.add_device("B")
+        assert [metrics.received for metrics in multi.all_metrics()] == [1, 0]
+        assert not multi.metrics("A").connected and multi.metrics("C") is None
+
+    def test_connections_are_set_up_one_at_a_time(self):
+        active = []
+        overlap = []
+
+        class FakeManager(BLEManager):
+            async def _connect(self, device_address, device=None):
+                active.append(device_address)
+                overlap.append(len(active))
+                await asyncio.sleep(0.01)
+                active.remove(device_address)
+                return device_address != "C"
+
+        multi = MultiDeviceManager(FakeManager)
+        results = asyncio.run(multi.connect_all(["A", "B", "C"]))
+        assert results == {"A": True, "B": True, "C": False}
+        assert overlap == [1, 1, 1] and multi.addresses() == ["A", "B", "C"]
+
+
+class FakeScanner:
+    """BleakScanner stand-in replaying (delay s, address, name) advertisements after start()."""
+    adverts = []
+
+    def __init__(self, detection_callback):
+        self._callback = detection_callback
+
+    async def start(self):
+        loop = asyncio.get_running_loop()
+        for delay, address, name in self.adverts:
+            device = SimpleNamespace(address=address, name=name)
+            loop.call_later(delay, self._callback, device, SimpleNamespace(local_name=name))
+
+    async def stop(self):
+        pass
+
+
+class TestReconnect:
+    def find(self, adverts, address, by_name=True, prefer_s=0.1, timeout=1.0):
+        FakeScanner.adverts = adverts
+        original = ble_manager.BleakScanner
+        ble_manager.BleakScanner = FakeScanner
+        try:
+            manager = BLEManager()
+            manager.PREFER_KNOWN_S = prefer_s
+            device = asyncio.run(manager._find_target(timeout, address, by_name))
+        finally:
+            ble_manager.BleakScanner = original
+        return None if device is None else device.address
+
+    def test_cached_address_wins_over_other_boards(self):
+        name = BLEManager.TARGET_DEVICE_NAME
+        assert self.find([(0.0, "B", name), (0.05, "a", name)], "A") == "a"
+        assert self.find([(0.0, "B", name)], "A") == "B"
+        assert self.find([(0.0, "B", name)], "A", by_name=False, timeout=0.2) is None
+        assert self.find([(0.0, "X", "other")], None, timeout=0.2) is None
+
+    def test_reconnect_follows_advertisements(self):
+        scans = []
+        connects = []
+
+        class FakeManager(BLEManager):
+            async def _find_target(self, timeout, address=None, by_name=True):
+                scans.append((address, by_name))
+                return SimpleNamespace(address=address) if len(scans) == 3 else None
+
+            async def _connect(self, device_address, device=None):
+                connects.append(device_address)
+                self._connected = True
+                return True
+
+        manager = FakeManager()
+        manager._last_device_address = "A"
+        asyncio.run(manager._auto_reconnect())
+        assert scans == [("A", False)] * 3 and connects == ["A"]
+
+
+class TestScan:
+    def scan(self, adverts, timeout=1.0, stop_at=None, settle_s=0.3, stop_after=None):
+        FakeScanner.adverts = adverts
+        original = ble_manager.BleakScanner
+        ble_manager.BleakScanner = FakeScanner
+        found = []
+        manager = BLEManager()
+        manager.SCAN_SETTLE_S = settle_s
+
+        async def run():
+            started = time.monotonic()
+
+            def on_found(device):
+                found.append((device.address, time.monotonic() - started))
+
+            scan = asyncio.ensure_future(manager.scan_devices(timeout, on_found, stop_at))
+            if stop_after is not None:
+                await asyncio.sleep(stop_after)
+                await manager.stop_scan()
+                assert scan.done()
+            devices = await scan
+            return devices, time.monotonic() - started
+
+        try:
+            devices, elapsed = asyncio.run(run())
+        finally:
+            ble_manager.BleakScanner = original
+        return [d.address for d in devices], found, elapsed
+
+    def test_devices_are_reported_as_they_advertise(self):
+        name = BLEManager.TARGET_DEVICE_NAME
+        devices, found, elapsed = self.scan([(0.02, "A", name), (0.03, "A", name), (0.15, "B", name),
+                                             (0.05, "X", "other")])
+        assert devices == ["A", "B"]
+        assert [address for address, _ in found] == ["A", "B"]
+        # A was listed long before the scan ended
+        assert found[0][1] < 0.1 and elapsed >= 0.15 + 0.3
+
+    def test_known_device_ends_the_scan(self):
+        name = BLEManager.TARGET_DEVICE_NAME
+        devices, _, elapsed = self.scan([(0.02, "B", name), (0.05, "a", name)], stop_at="A", settle_s=5.0)
+        assert devices == ["B", "a"] and elapsed < 0.5
+
+    def test_stop_scan(self):
+        devices, _, elapsed = self.scan([], timeout=5.0, stop_after=0.1)
+        assert devices == [] and elapsed < 0.5
+
+
+class TestLayout:
+    @given(layout=st.integers(min_value=0, max_value=0xFFFFFFFF))
+    @settings(max_examples=50)
+    def test_layout_hash(self, layout):
+        assert parse_layout(struct.pack('<I', layout)) == layout
+        assert parse_layout(struct.pack('<I', layout)[:3]) is None
+
+
+class TestLatencyReport:
+    @given(p50=st.lists(st.integers(min_value=0, max_value=0xFFFE), min_size=3, max_size=3),
+           p99=st.lists(st.integers(min_value=0, max_value=0xFFFE), min_size=3, max_size=3),
+           notify_max=st.integers(min_value=0, max_value=0xFFFE),
+           over_slo=st.integers(min_value=0, max_value=0xFFFE),
+           stalls=st.integers(min_value=0, max_value=0xFFFE),
+           watchdog_reset=st.booleans())
+    @settings(max_examples=100)
+    def test_round_trip(self, p50, p99, notify_max, over_slo, stalls, watchdog_reset):
+        report = parse_latency_report(encode_latency(p50, p99, notify_max, over_slo, stalls, watchdog_reset))
+        assert [report.p50_ms[name] for name in LATENCY_STAGES] == p50
+        assert [report.p99_ms[name] for name in LATENCY_STAGES] == p99
+        assert (report.notify_max_ms, report.over_slo, report.stalls) == (notify_max, over_slo, stalls)
+        assert report.watchdog_reset == watchdog_reset
+
+    def test_stage_without_samples(self):
+        # No host acks: the ack stage reports 0xFFFF
+        report = parse_latency_report(encode_latency([20, 45, 0xFFFF], [60, 140, 0xFFFF], 150, 1, 0, False))
+        assert report.p50_ms["ack"] is None and report.p99_ms["ack"] is None
+        assert report.p99_ms["notify"] == 140 and report.over_slo == 1
+
+    def test_short_notification(self):
+        assert parse_latency_report(b"\x00" * 18) is None
+
+    @given(sequence=st.integers(min_value=0, max_value=0xFFFFFFFF))
+    @settings(max_examples=100)
+    def test_ack_carries_low_sequence_bits(self, sequence):
+        # Events carry the low 16 bits of the sequence; the ack echoes exactly those
+        assert struct.unpack('<H', encode_ack(sequence))[0] == sequence & 0xFFFF
+
+    @given(sequence=st.integers(min_value=0, max_value=0xFFFFFFFF), mtu=st.integers(min_value=0, max_value=600))
+    @settings(max_examples=100)
+    def test_ack_reports_mtu(self, sequence, mtu):
+        # handle_ack() in src/ble_module.cpp reads the MTU from bytes 2-3 when present
+        assert struct.unpack('<HH', encode_ack(sequence, mtu)) == (sequence & 0xFFFF, max(mtu, 23))
+
+
+class TestRuntimeConfig:
+    @given(ble=st.integers(min_value=0, max_value=255), led=st.integers(min_value=0, max_value=255),
+           fine=st.integers(min_value=1, max_value=24), coarse=st.integers(min_value=1, max_value=24),
+           poll_ms=st.integers(min_value=10, max_value=1000))
+    @settings(max_examples=100)
+    def test_round_trip(self, ble, led, fine, coarse, poll_ms):
+        config = RuntimeConfig("custom", ble / 255.0, led / 255.0, fine, coarse, poll_ms)
+        payload = encode_config(config)
+        assert len(payload) == 7  # kConfigBytes in src/ble_module.cpp
+        assert parse_config(payload) == config
+
+    def test_confidence_is_clamped(self):
+        payload = encode_config(RuntimeConfig("low-power", 1.2, -0.1, 4, 12, 250))
+        # A full write is always a custom profile
+        assert payload[:3] == bytes([CONFIG_PROFILES.index("custom"), 255, 0])
+
+    def test_presets(self):
+        assert encode_profile("low-latency") == b"\x01"
+        assert encode_profile("low-power") == b"\x02"
+        assert parse_config(bytes([2, 140, 204, 4, 12]) + struct.pack('<H', 250)).profile == "low-power"
+        for bad in ("custom", "turbo"):
+            try:
+                encode_profile(bad)
+            except ValueError:
+                continue
+            assert False, f"expected ValueError for {bad}"
+
+    def test_operating_point(self):
+        # Two bytes: never mistaken for a preset (1 byte) or a full configuration (7 bytes)
+        assert encode_operating_point("full") == b"\xfe\x00"
+        assert encode_operating_point("idle-filter") == b"\xfe\x02"
+        assert encode_operating_point(None) == b"\xfe\xff"
+
+    def test_short_value(self):
+        assert parse_config(b"\x01") is None
@@ -0,0 +1,172 @@
+import asyncio
+import os
+import struct
+import sys
+import tempfile
+import uuid as uuidlib
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from hypothesis import given, strategies as st, settings
+from ble_manager import BLEManager
+from ble_session import (KIND_CHARACTERISTIC, KIND_MTU, KIND_NOTIFY, KIND_READ, RECORD, SESSION_MAGIC,
+                         SESSION_VERSION, RecordingClient, SessionWriter, parse_session, read_session,
+                         replay_session)
+from l2cap_channel import BULK_UUID
+
+
+def session_bytes(characteristics, records, mtu=None):
+    """A session file: records are (µs since the previous record, kind, characteristic index, payload)."""
+    data = SESSION_MAGIC + bytes([SESSION_VERSION])
+    for uuid in characteristics:
+        data += RECORD.pack(0, KIND_CHARACTERISTIC, 0, 16) + uuidlib.UUID(uuid).bytes
+    if mtu is not None:
+        data += RECORD.pack(0, KIND_MTU, 0, 2) + struct.pack('<H', mtu)
+    for delta, kind, index, payload in records:
+        data += RECORD.pack(delta, kind, index, len(payload)) + payload
+    return data
+
+
+def event_burst(delivery, events):
+    """Mirror of the numbered burst in src/ble_module.cpp: events are (index, confidence, sequence, ms)."""
+    return struct.pack('<BH', 0, delivery) + b"".join(struct.pack('<bBHI', *event) for event in events)
+
+
+class TestSessionFile:
+    @given(payloads=st.lists(st.binary(max_size=244), max_size=20))
+    @settings(max_examples=50)
+    def test_writer_round_trip(self, payloads):
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, "s.bles")
+            writer = SessionWriter(path)
+            writer.mtu(247)
+            writer.read(BLEManager.CONFIG_UUID, b"\x01\x02")
+            for payload in payloads:
+                writer.notify(BLEManager.EVENTS_UUID, payload)
+            writer.close()
+            session = read_session(path)
+        assert session.mtu == 247
+        # Declared on first use
+        assert session.characteristics == [BLEManager.CONFIG_UUID] + ([BLEManager.EVENTS_UUID] if payloads else [])
+        assert [(r.kind, r.data) for r in session.records] == \
+            [(KIND_READ, b"\x01\x02")] + [(KIND_NOTIFY, p) for p in payloads]
+        times = [r.time_s for r in session.records]
+        assert times == sorted(times)
+
+    def test_times_and_truncated_tail(self):
+        data = session_bytes([BLEManager.EVENTS_UUID],
+                             [(0, KIND_NOTIFY, 0, b"a"), (1500, KIND_NOTIFY, 0, b"bc"), (2500, KIND_NOTIFY, 0, b"d")])
+        session = parse_session(data[:-1])
+        assert [(r.time_s, r.data) for r in session.records] == [(0.0, b"a"), (0.0015, b"bc")]
+        assert session.duration_s() == 0.0015
+
+    def test_rejects_other_files(self):
+        for data in (b"", b"BLEX\x01", SESSION_MAGIC + bytes([SESSION_VERSION + 1])):
+            try:
+                parse_session(data)
+            except ValueError:
+                continue
+            raise AssertionError(data)
+
+
+class FakeServices:
+    def __init__(self, uuids):
+        self.characteristics = {i: type("C", (), {"uuid": u})() for i, u in enumerate(uuids)}
+
+    def get_characteristic(self, uuid):
+        return next((c for c in self.characteristics.values() if c.uuid == uuid), None)
+
+
+class FakeClient:
+    mtu_size = 185
+
+    def __init__(self):
+        self.services = FakeServices([BLEManager.EVENTS_UUID, BLEManager.CONFIG_UUID, BULK_UUID])
+        self.handlers = {}
+
+    async def connect(self):
+        return True
+
+    async def start_notify(self, uuid, callback):
+        self.handlers[uuid] = callback
+
+    async def read_gatt_char(self, uuid):
+        return bytearray(b"\x05")
+
+
+class TestRecordingClient:
+    def test_records_notifications_reads_and_mtu(self):
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, "s.bles")
+            writer = SessionWriter(path)
+            fake = FakeClient()
+            client = RecordingClient(fake, writer)
+            received = []
+
+            async def session():
+                await client.connect()
+                assert await client.read_gatt_char(BLEManager.CONFIG_UUID) == b"\x05"
+                await client.start_notify(BLEManager.EVENTS_UUID, lambda sender, data: received.append(bytes(data)))
+                fake.handlers[BLEManager.EVENTS_UUID](None, bytearray(b"xyz"))
+                assert client.mtu_size == 185
+
+            asyncio.run(session())
+            # The bulk channel stays hidden, so BLEManager keeps every stream on GATT
+            assert client.services.get_characteristic(BULK_UUID) is None
+            assert client.services.get_characteristic(BLEManager.EVENTS_UUID) is not None
+            writer.close()
+            recorded = read_session(path)
+        assert received == [b"xyz"]
+        assert BULK_UUID not in recorded.characteristics
+        assert recorded.mtu == 185
+        assert [(r.kind, r.uuid, r.data) for r in recorded.records] == \
+            [(KIND_READ, BLEManager.CONFIG_UUID, b"\x05"), (KIND_NOTIFY, BLEManager.EVENTS_UUID, b"xyz")]
+
+
+class CountingHandler:
+    def __init__(self):
+        self.gestures = []
+
+    def process_gesture(self, gesture, confidence):
+        self.gestures.append((gesture, round(confidence, 2)))
+
+    def close(self):
+        pass
+
+    def action_stats(self):
+        return None
+
+
+class TestReplay:
+    def write_session(self, tmp, bursts=40, spacing_us=5000):
+        # Result events, plus scores nobody subscribes to
+        records = []
+        for i in range(bursts):
+            records.append((spacing_us, KIND_NOTIFY, 0, event_burst(i, [(i % 5, 255, i, 100 + i * 5)])))
+            records.append((0, KIND_NOTIFY, 1, b"\x00" * 8))
+        path = os.path.join(tmp, "s.bles")
+        with open(path, "wb") as f:
+            f.write(session_bytes([BLEManager.EVENTS_UUID, BLEManager.SCORES_UUID], records, mtu=247))
+        return path
+
+    def test_max_speed_reaches_the_handler(self):
+        with tempfile.TemporaryDirectory() as tmp:
+            path = self.write_session(tmp)
+            handler = CountingHandler()
+            report = asyncio.run(replay_session(path, 0, handler=handler))
+        labels = BLEManager.MODEL_LABELS
+        assert handler.gestures == [(labels[i % 5], 1.0) for i in range(40)]
+        assert report.notifications == 80 and report.unhandled == 40
+        assert len(report.stages["notify EVENTS"]) == 40
+        assert len(report.stages["gesture handler"]) == 40
+        assert "dispatch" not in report.stages
+        assert report.recorded_s == 0.195
+        assert report.throughput() > 0
+        assert "notify EVENTS" in report.format()
+
+    def test_paced_replay_keeps_the_recorded_pace(self):
+        with tempfile.TemporaryDirectory() as tmp:
+            path = self.write_session(tmp, bursts=20, spacing_us=10000)
+            report = asyncio.run(replay_session(path, 2.0, handler=CountingHandler()))
+        # 0.19 s recorded at 2x
+        assert report.wall_s >= 0.19 / 2.0
+        assert len(report.stages["dispatch"]) == 20
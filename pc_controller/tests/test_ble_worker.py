@@ -0,0 +1,145 @@
+import os
+import sys
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+import asyncio
+import multiprocessing
+import threading
+
+from hypothesis import given, strategies as st, settings
+from ble_manager import ScoreFrame
+from ble_worker import (KIND_GESTURE, KIND_STATE, RECORD, BLEWorkerClient, EventRing, WorkerServer, decode_scores,
+                        encode_scores)
+
+
+def ring(capacity=8):
+    return EventRing(memoryview(bytearray(EventRing.size(capacity))), capacity)
+
+
+class FakeManager:
+    """The TransportSelector methods the worker uses."""
+
+    def __init__(self):
+        self.callbacks = {}
+        self.connected = False
+        self.layouts = None
+
+    def __getattr__(self, name):
+        if name.startswith("set_") and name.endswith("_callback"):
+            return lambda callback: self.callbacks.__setitem__(name[4:-9], callback)
+        raise AttributeError(name)
+
+    def set_keymap_provider(self, provider):
+        self.keymap = provider
+
+    def set_layout_store(self, load, save):
+        self.layouts = (load, save)
+
+    def is_connected(self):
+        return self.connected
+
+    def device_hid(self):
+        return True
+
+    def last_device_address(self):
+        return "AA:BB:CC:DD:EE:FF"
+
+    async def connect(self, address):
+        self.connected = True
+        self.callbacks["status"]("Connected")
+        return address == "AA:BB:CC:DD:EE:FF"
+
+    async def disconnect(self):
+        self.connected = False
+
+
+class TestEventRing:
+    @given(batches=st.lists(st.integers(0, 8), max_size=40))
+    @settings(max_examples=50)
+    def test_order_across_wraps(self, batches):
+        r = ring(8)
+        sent = received = 0
+        for batch in batches:
+            for _ in range(batch):
+                assert r.push(KIND_GESTURE, value=float(sent), payload=b"left")
+                sent += 1
+            while True:
+                event = r.pop()
+                if event is None:
+                    break
+                assert (event.kind, event.value, event.payload.rstrip(b"\0")) == (KIND_GESTURE, received, b"left")
+                received += 1
+        assert received == sent and r.dropped == 0
+
+    def test_full_ring_drops_and_counts(self):
+        r = ring(4)
+        assert all(r.push(KIND_GESTURE, value=i) for i in range(4))
+        assert not r.push(KIND_GESTURE, value=4)
+        assert r.dropped == 1 and r.pending() == 4
+        assert r.pop().value == 0.0
+        assert r.push(KIND_GESTURE, value=5)
+
+    def test_half_written_record_is_not_read(self):
+        r = ring(4)
+        r.push(KIND_GESTURE, payload=b"up")
+        # The producer has moved its index but not yet written the sequence number
+        r._buf[128:132] = bytes(4)
+        assert r.pop() is None
+        r._buf[128:132] = (1).to_bytes(4, "little")
+        assert r.pop().payload.rstrip(b"\0") == b"up"
+
+    def test_record_size_and_scores(self):
+        assert RECORD.size == 64
+        frame = ScoreFrame(513, [10, -128, 127, 0], [0.25, 0.0, 1.0, 0.125])
+        r = ring()
+        r.push(5, 4, frame.sequence, payload=encode_scores(frame))
+        assert decode_scores(r.pop()) == frame
+        assert encode_scores(ScoreFrame(0, [0] * 9, [0.0] * 9)) is None
+
+
+def test_worker_to_client_over_the_ring_and_pipe():
+    """A connect through the worker: reply on the pipe, state and callbacks from the ring."""
+    shared = ring(16)
+    client_end, worker_end = multiprocessing.Pipe()
+    manager = FakeManager()
+    doorbell = threading.Event()
+    client = BLEWorkerClient()
+    client._ring, client._conn = shared, client_end
+    statuses, gestures = [], []
+    client.set_status_callback(statuses.append)
+    client.set_gesture_callback(lambda gesture, confidence: gestures.append((gesture, confidence)))
+
+    async def run():
+        server = WorkerServer(manager, worker_end, shared, doorbell, asyncio.get_running_loop())
+        future = client._call("connect", "AA:BB:CC:DD:EE:FF")
+        server.handle(worker_end.recv())
+        await asyncio.sleep(0)
+        manager.callbacks["gesture"]("left", 0.9)
+        client.handle(client_end.recv())
+        return future.result(timeout=1.0)
+
+    assert asyncio.run(run()) is True
+    assert doorbell.is_set()
+    assert client.drain() == 4  # state, status, gesture, state after the call
+    assert statuses == ["Connected"]
+    assert gestures[0][0] == "left" and abs(gestures[0][1] - 0.9) < 1e-6
+    assert client.is_connected() and client.device_hid() and client.last_device_address() == "AA:BB:CC:DD:EE:FF"
+
+
+def test_unknown_method_is_refused():
+    shared = ring()
+    client_end, worker_end = multiprocessing.Pipe()
+    client = BLEWorkerClient()
+    client._ring, client._conn = shared, client_end
+
+    async def run():
+        server = WorkerServer(FakeManager(), worker_end, shared, threading.Event(), asyncio.get_running_loop())
+        future = client._call("upload_model", b"")
+        server.handle(worker_end.recv())
+        await asyncio.sleep(0)
+        client.handle(client_end.recv())
+        return future
+
+    future = asyncio.run(run())
+    assert "not available" in str(future.exception(timeout=1.0))
+    assert shared.pop().kind == KIND_STATE
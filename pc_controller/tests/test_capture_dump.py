@@ -0,0 +1,75 @@
+import os
+import struct
+import sys
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from hypothesis import given, strategies as st, settings
+from ble_manager import TELEMETRY_CAPTURE_STATUS, TELEMETRY_STATUS, parse_telemetry_status
+from capture_dump import CRC_OFFSET, RECORD_HEADER, decode_windows, summarize
+from serial_manager import crc16
+
+AXES = 3
+FRAMES = 24
+
+
+def record(window, time_ms=0, top=1, runner_up=2, top_q=140, runner_up_q=120, skipped=0, scale=0.5, zero_point=-3,
+           flags=0x03):
+    """A record as capture_module_window builds it."""
+    header = RECORD_HEADER.pack(time_ms, top, runner_up, top_q, runner_up_q, skipped, 0, scale, zero_point, AXES,
+                                FRAMES, flags)
+    body = header + struct.pack(f'<{len(window)}b', *window)
+    body += b"\x00" * (-len(body) % 4)
+    crc = crc16(body[CRC_OFFSET + 2:], crc16(body[:CRC_OFFSET]))
+    return body[:CRC_OFFSET] + struct.pack('<H', crc) + body[CRC_OFFSET + 2:]
+
+
+windows_strategy = st.lists(st.integers(-128, 127), min_size=AXES * FRAMES, max_size=AXES * FRAMES)
+
+
+class TestRecords:
+    def test_record_size_matches_the_firmware(self):
+        # CAPTURE_RECORD_BYTES for the 24 x 3 window
+        assert len(record([0] * AXES * FRAMES)) == 92
+
+    @given(windows=st.lists(windows_strategy, max_size=6), time_ms=st.integers(0, 0xFFFFFFFF))
+    @settings(max_examples=50)
+    def test_round_trip(self, windows, time_ms):
+        data = b"".join(record(w, time_ms) for w in windows)
+        decoded, damaged = decode_windows(data)
+        assert damaged == 0 and len(decoded) == len(windows)
+        for window, values in zip(decoded, windows):
+            assert window.time_ms == time_ms
+            assert window.frames[0] == [(v + 3) * 0.5 for v in values[:AXES]]
+            assert len(window.frames) == FRAMES
+
+    def test_fields(self):
+        decoded, _ = decode_windows(record([0] * AXES * FRAMES, top=3, runner_up=-1, top_q=255, skipped=7, flags=0x05))
+        window = decoded[0]
+        assert (window.top, window.runner_up, window.top_confidence) == ("right", None, 1.0)
+        assert window.skipped == 7 and window.reasons == ["band"] and window.normalized
+        assert window.label is None
+
+    def test_bad_crc_and_truncated_tail(self):
+        bad = bytearray(record([1] * AXES * FRAMES))
+        bad[40] ^= 0x01
+        good = record([2] * AXES * FRAMES)
+        decoded, damaged = decode_windows(good + bytes(bad) + good + good[:30])
+        assert len(decoded) == 2
+        assert damaged == len(bad) + 30
+
+
+def test_summary_counts_confused_pairs():
+    data = record([0] * 72, top=1, runner_up=2) * 3 + record([0] * 72, top=2, runner_up=1, skipped=4)
+    lines = summarize(decode_windows(data)[0])
+    assert lines[0] == "4 windows captured (4 ambiguous windows skipped by the rate limit)"
+    assert lines[1].endswith(": 3")
+
+
+def test_status_with_capture_counters():
+    base = TELEMETRY_STATUS.pack(2, 16, 0, 9, 0, 4096, 3, 0)
+    status = parse_telemetry_status(base + TELEMETRY_CAPTURE_STATUS.pack(5, 11, 460))
+    assert status.dumping and status.dumping_captures
+    assert (status.captured, status.capture_suppressed, status.capture_bytes) == (5, 11, 460)
+    # Older firmware: no capture counters
+    older = parse_telemetry_status(TELEMETRY_STATUS.pack(1, 16, 0, 9, 0, 4096, 3, 0))
+    assert older.dumping and not older.dumping_captures and older.capture_bytes == 0
@@ -0,0 +1,44 @@
+import os
+import sys
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+import argparse
+
+import pytest
+from hypothesis import given, strategies as st, settings
+from ble_manager import COMBO_EVENT, ComboTable, encode_combos, parse_combo_event, parse_combos
+from combo_config import describe, describe_event, parse_combo
+
+
+class TestEncoding:
+    @given(combos=st.lists(st.lists(st.integers(0, 4), min_size=2, max_size=6), max_size=8),
+           gap_ms=st.integers(1, 0xFFFF))
+    @settings(max_examples=100)
+    def test_round_trip(self, combos, gap_ms):
+        table = ComboTable(gap_ms, combos)
+        assert parse_combos(encode_combos(table)) == table
+
+    def test_layout(self):
+        assert encode_combos(ComboTable(800, [[4, 4, 2]])) == bytes([1, 0x20, 0x03, 3, 4, 4, 2])
+
+    def test_truncated(self):
+        assert parse_combos(encode_combos(ComboTable(800, [[4, 4, 2]]))[:-1]) is None
+        assert parse_combos(b"\x00\x20") is None
+
+    def test_event(self):
+        event = parse_combo_event(COMBO_EVENT.pack(1, 3, 77, 1000, 1900))
+        assert (event.combo, event.length, event.sequence, event.end_ms - event.start_ms) == (1, 3, 77, 900)
+        assert parse_combo_event(b"\x00" * (COMBO_EVENT.size - 1)) is None
+
+
+class TestNames:
+    def test_parse(self):
+        assert parse_combo("up, up,left") == [4, 4, 2]
+        with pytest.raises(argparse.ArgumentTypeError):
+            parse_combo("up,jump")
+
+    def test_describe(self):
+        table = ComboTable(800, [[4, 4, 2], [0, 3]])
+        assert describe(table) == ["2 combos, gap 800 ms", "  0: up, up, left", "  1: down, right"]
+        event = parse_combo_event(COMBO_EVENT.pack(1, 2, 5, 100, 400))
+        assert describe_event(event, table) == "combo 1 (down, right) in 300 ms, result #5"
@@ -8,6 +8,7 @@ Tests:
 
 import os
 import tempfile
+import time
 from hypothesis import given, strategies as st, settings
 
 import sys
@@ -68,6 +69,7 @@ class TestConfigRoundTrip:
             manager1 = ConfigManager(temp_path)
             manager1._config = config
             manager1.save()
+            manager1.flush()
             
             # Load config in new manager
             manager2 = ConfigManager(temp_path)
@@ -90,6 +92,95 @@ class TestConfigRoundTrip:
             if os.path.exists(temp_path):
                 os.unlink(temp_path)
 
+    @given(layout=st.integers(min_value=0, max_value=0xFFFFFFFF))
+    @settings(max_examples=50)
+    def test_gatt_layout_round_trip(self, layout):
+        """A remembered GATT layout hash survives a restart."""
+        with tempfile.NamedTemporaryFile(mode='w', suffix='.json', delete=False) as f:
+            temp_path = f.name
+
+        try:
+            manager1 = ConfigManager(temp_path)
+            manager1.load()
+            manager1.set_gatt_layout("AA:BB:CC:DD:EE:FF", layout)
+            manager1.flush()
+
+            manager2 = ConfigManager(temp_path)
+            manager2.load()
+            assert manager2.get_gatt_layout("AA:BB:CC:DD:EE:FF") == layout
+            assert manager2.get_gatt_layout("11:22:33:44:55:66") is None
+        finally:
+            if os.path.exists(temp_path):
+                os.unlink(temp_path)
+
+
+    def test_repeat_settings_round_trip(self):
+        """Hold-to-repeat gestures and rate survive a restart; invalid ones are refused."""
+        with tempfile.NamedTemporaryFile(mode='w', suffix='.json', delete=False) as f:
+            temp_path = f.name
+
+        try:
+            manager1 = ConfigManager(temp_path)
+            manager1.load()
+            assert manager1.get_repeat_gestures() == set()
+            assert manager1.set_repeat_gesture("left", True) and manager1.set_repeat_gesture("down", True)
+            assert manager1.set_repeat_gesture("down", False)
+            assert not manager1.set_repeat_gesture("wave", True)
+            assert manager1.set_repeat_rate(12.5) and not manager1.set_repeat_rate(100.0)
+            assert manager1.snapshot().repeat_gestures == frozenset({"left"})
+            manager1.save()
+            manager1.flush()
+
+            manager2 = ConfigManager(temp_path)
+            manager2.load()
+            assert manager2.get_repeat_gestures() == {"left"}
+            assert manager2.get_repeat_rate() == 12.5
+        finally:
+            if os.path.exists(temp_path):
+                os.unlink(temp_path)
+
+
+class TestSnapshot:
+    @given(shortcuts=valid_gesture_shortcuts, threshold=valid_threshold)
+    @settings(max_examples=50)
+    def test_snapshot_is_replaced_not_modified(self, shortcuts, threshold):
+        manager = ConfigManager()
+        before = manager.snapshot()
+        defaults = dict(before.gesture_shortcuts)
+        manager.set_gesture_shortcuts(shortcuts)
+        manager.set_confidence_threshold(threshold)
+        after = manager.snapshot()
+        assert dict(before.gesture_shortcuts) == defaults
+        assert dict(after.gesture_shortcuts) == shortcuts and after.confidence_threshold == threshold
+        try:
+            after.gesture_shortcuts["left"] = "up"
+            assert False
+        except TypeError:
+            pass
+
+    def test_unchanged_shortcuts_keep_their_object(self):
+        manager = ConfigManager()
+        shortcuts = manager.snapshot().gesture_shortcuts
+        manager.set_cooldown_time(3.0)
+        assert manager.snapshot().gesture_shortcuts is shortcuts and manager.snapshot().cooldown_time == 3.0
+
+
+class TestDebouncedSave:
+    def test_saves_coalesce_into_one_atomic_write(self):
+        with tempfile.TemporaryDirectory() as directory:
+            path = os.path.join(directory, "config.json")
+            manager = ConfigManager(path, save_delay_s=0.05)
+            for threshold in (0.6, 0.7, 0.8):
+                manager.set_confidence_threshold(threshold)
+                manager.save()
+            assert not os.path.exists(path)
+            deadline = time.monotonic() + 2.0
+            while not os.path.exists(path) and time.monotonic() < deadline:
+                time.sleep(0.01)
+            loaded = ConfigManager(path)
+            assert loaded.load()["confidence_threshold"] == 0.8
+            assert os.listdir(directory) == ["config.json"]
+
 
 class TestShortcutValidation:
     """
@@ -0,0 +1,114 @@
+import os
+import sys
+import tempfile
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from hypothesis import given, strategies as st, settings
+from device_replay import (DEVICE_ODR_HZ, check_limits, load_recording, parse_stages, replay_on_device,
+                           replay_packets, resample_linear, to_device_rate)
+from raw_recorder import StreamDecoder, encode_packet
+from replay_runner import ReplayResult, WindowResult
+
+samples = st.integers(min_value=-32768, max_value=32767)
+frames_st = st.lists(st.lists(samples, min_size=6, max_size=6), max_size=80)
+
+STAGES = ["acquire", "window", "infer", "postprocess", "ble", "led"]
+
+
+class FakeBoard:
+    """Answers "replay" with the ready line and the end packet with a result, summary and stage lines."""
+
+    def __init__(self):
+        self.received = bytearray()
+        self.output = []
+        self.decoder = StreamDecoder()
+        self.frames = 0
+
+    def write(self, data: bytes) -> None:
+        if data == b"replay\n":
+            self.output.append(b"[Replay] Ready\n")
+            return
+        for packet in self.decoder.feed(data):
+            self.frames += len(packet.frames)
+            if not packet.frames:
+                lines = ["[Inference] unrelated log line", "result,30,left,0.91000,1800,21000",
+                         f"summary,1,{self.frames},{self.frames // 8},1000000,900"]
+                lines += [f"stage,{name},10,100,200,5" for name in STAGES]
+                self.output.append(("\n".join(lines) + "\n").encode())
+
+    def read(self, size: int) -> bytes:
+        return self.output.pop(0) if self.output else b""
+
+
+class TestPackets:
+    @given(frames=frames_st, per_packet=st.integers(min_value=1, max_value=30))
+    @settings(max_examples=50)
+    def test_stream_decodes_to_the_same_frames(self, frames, per_packet):
+        decoder = StreamDecoder()
+        packets = [p for data in replay_packets(0x3F, frames, per_packet) for p in decoder.feed(data)]
+        assert [f for p in packets for f in p.frames] == frames
+        assert packets[-1].frames == []
+        assert [p.seq for p in packets] == list(range(len(packets)))
+        assert decoder.stats.crc_errors == 0 and decoder.stats.lost_packets == 0
+
+    def test_empty_packet_still_has_a_header(self):
+        data = encode_packet(3, 0x07, [0], [])
+        packets = list(StreamDecoder().feed(data))
+        assert len(packets) == 1 and packets[0].seq == 3 and packets[0].frames == []
+
+
+class TestResample:
+    def test_device_rate_is_kept(self):
+        timestamps = [i * 2.5 for i in range(100)]
+        frames = [[i, -i, 0] for i in range(100)]
+        assert to_device_rate(timestamps, frames) == frames
+
+    @given(rate=st.sampled_from([50.0, 100.0, 200.0, 800.0]))
+    @settings(max_examples=4)
+    def test_ramp_is_interpolated(self, rate):
+        count = 40
+        timestamps = [i * 1000.0 / rate for i in range(count)]
+        frames = [[i * 100] for i in range(count)]
+        out = to_device_rate(timestamps, frames)
+        expected = int((count - 1) * DEVICE_ODR_HZ / rate) + 1
+        assert abs(len(out) - expected) <= 1
+        for k, frame in enumerate(out):
+            assert abs(frame[0] - k * rate / DEVICE_ODR_HZ * 100) <= 1
+
+    def test_short_recording_is_unchanged(self):
+        assert resample_linear([0.0], [[5]]) == [[5]]
+
+
+class TestReport:
+    def test_parse_stages(self):
+        text = "stage,infer,10,1500,2200,310\nstage,led,x,1,2,3\nstage,ble,1\nresult,1,idle,0.9,1,2\n"
+        stages = parse_stages(text)
+        assert list(stages) == ["infer"]
+        assert (stages["infer"].runs, stages["infer"].mean_us, stages["infer"].max_us,
+                stages["infer"].busy_permille) == (10, 1500, 2200, 310)
+
+    def test_limits(self):
+        results = [ReplayResult("left.01.csv", [WindowResult(30, "left", 0.9, 1000, 20000),
+                                                WindowResult(32, "idle", 0.8, 0, 50000)])]
+        assert check_limits(results, None, None) == []
+        assert check_limits(results, 0.5, 50000) == []
+        assert len(check_limits(results, 0.6, 40000)) == 2
+
+
+class TestDeviceSession:
+    def test_round_trip_through_fake_board(self):
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, "left.01.csv")
+            with open(path, "w", encoding="utf-8") as f:
+                f.write("timestamp,accX,accY,accZ,gyrX,gyrY,gyrZ\n")
+                for i in range(200):
+                    f.write(f"{i * 2.5:.3f},0.1,-0.2,1.0,5.0,0.0,-5.0\n")
+            mask, _, frames = load_recording(path)
+            assert mask == 0x3F and frames[0] == [819, -1638, 8192, 82, 0, -82]
+
+            board = FakeBoard()
+            result, stages = replay_on_device(board, path, timeout_s=2.0)
+        assert board.frames == 200
+        assert [(w.frame, w.label) for w in result.windows] == [(30, "left")]
+        assert result.sensor_frames == 200
+        assert list(stages) == STAGES
@@ -0,0 +1,167 @@
+import os
+import struct
+import sys
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from hypothesis import given, strategies as st, settings
+from ble_manager import CRASH_THREADS, encode_profile
+from device_shell import (CMD_BENCH_RESULT, CMD_BENCH_START, CMD_CONFIG_GET, CMD_CONFIG_SET, CMD_INFO, CMD_STAT_READ,
+                          CMD_STATS, CMD_TRACE_READ, CMD_TRACE_START, CMD_TRACE_STOP, STATUSES, DeviceShell, encode_request,
+                          parse_reply, parse_system_stats, zone_summary)
+from serial_manager import FRAME_SHELL, FrameDecoder, encode_frame
+from wire_schema import STAT_COUNTER, STAT_DISTRIBUTION, STAT_DISTRIBUTION_KIND, STAT_HEADER
+
+CONFIG = bytes([0, 179, 204, 4, 12]) + struct.pack('<H', 250)
+
+
+# Registry entries of the fake board: (name, kind, value)
+REGISTRY = [("events.dropped", STAT_COUNTER, 3), ("latency.inference_us", STAT_DISTRIBUTION_KIND, (40, 9000, 4000, 6000, 8000))]
+
+
+def stat_payload(index):
+    """Mirror of stats_module_encode() in src/stats_module.cpp."""
+    name, kind, value = REGISTRY[index]
+    body = STAT_DISTRIBUTION.pack(*value) if kind == STAT_DISTRIBUTION_KIND else struct.pack('<I', value)
+    return STAT_HEADER.pack(index, len(REGISTRY), kind, len(name)) + name.encode() + body
+
+
+def bench_payload(version, state=2):
+    """Mirror of bench_result() in src/shell_module.cpp."""
+    return struct.pack('<IBBH', version, 0, state, 100) + b"".join(struct.pack('<5I', 1, 2, 3, 4, 5) for _ in range(4))
+
+
+class FakeBoard:
+    """A serial port answering shell frames the way src/shell_module.cpp does."""
+
+    def __init__(self, log_text=b""):
+        self._decoder = FrameDecoder()
+        self._out = bytearray(log_text)
+        self.bench_version = 1
+        self.tracing = False
+        self.requests = []
+
+    @property
+    def in_waiting(self):
+        return len(self._out)
+
+    def read(self, n):
+        data = bytes(self._out[:n])
+        del self._out[:n]
+        return data
+
+    def write(self, data):
+        for frame_type, payload in self._decoder.feed(data):
+            assert frame_type == FRAME_SHELL
+            sequence, command, args = payload[0], payload[1], payload[2:]
+            self.requests.append((command, args))
+            status, reply = self.execute(command, args)
+            # A stale reply with another sequence first: the shell must skip it
+            self._out += encode_frame(FRAME_SHELL, bytes([(sequence - 1) & 0xFF, command, 0]))
+            self._out += encode_frame(FRAME_SHELL, bytes([sequence, command, status]) + reply)
+
+    def execute(self, command, args):
+        if command == CMD_INFO:
+            return 0, struct.pack('<BBBBI', 1, 6, 3, 7, 12345)
+        if command == CMD_STATS:
+            if args[0] == 1:
+                return 0, b"".join(struct.pack('<III', 4096, 1000 + i, i) for i in range(6))
+            if args[0] == 3:
+                # 3 labels, 8 bins: label n won n windows in the top bin with a margin in bin 4
+                top = [0] * 7 + [args[1]]
+                margin = [0] * 4 + [args[1]] + [0] * 3
+                return 0, struct.pack('<BBxx16I', 3, 8, *top, *margin)
+            return 2, b""
+        if command == CMD_BENCH_START:
+            self.bench_version += 1
+            return 0, b""
+        if command == CMD_BENCH_RESULT:
+            return 0, bench_payload(self.bench_version)
+        if command in (CMD_CONFIG_GET, CMD_CONFIG_SET):
+            config = CONFIG if command == CMD_CONFIG_GET or len(args) != 1 else bytes([args[0]]) + CONFIG[1:]
+            return 0, struct.pack('<I', 3) + config
+        if command == CMD_TRACE_START:
+            self.tracing = True
+            return 0, b""
+        if command == CMD_TRACE_STOP:
+            self.tracing = False
+            return 0, b""
+        if command == CMD_TRACE_READ:
+            if not self.tracing:
+                return 5, b""
+            return 0, struct.pack('<IIHB', 100, 6400, 64000, 2) + struct.pack('<BII', 2, 640, 3200) + \
+                struct.pack('<BII', 5, 64, 640)
+        if command == CMD_STAT_READ:
+            return (0, stat_payload(args[0])) if args[0] < len(REGISTRY) else (2, b"")
+        return 1, b""
+
+
+class TestReply:
+    @given(sequence=st.integers(0, 255), command=st.integers(0, 9), status=st.integers(0, len(STATUSES) - 1),
+           data=st.binary(max_size=64))
+    @settings(max_examples=50)
+    def test_round_trip(self, sequence, command, status, data):
+        reply = parse_reply(bytes([sequence, command, status]) + data)
+        assert (reply.sequence, reply.command, reply.status, reply.data) == (sequence, command, STATUSES[status], data)
+
+    def test_short_reply_and_request(self):
+        assert parse_reply(b"\x01\x02") is None
+        assert encode_request(257, CMD_STATS, b"\x01") == b"\x01\x01\x01"
+
+    def test_system_stats(self):
+        data = struct.pack('<10IBBBx', *range(10), 1, 3, 0)
+        stats = parse_system_stats(data)
+        assert (stats.uptime_ms, stats.static_bytes, stats.watchdog_reset, stats.power_point) == (0, 9, True, "on-demand")
+        assert parse_system_stats(data[:-1]) is None
+
+
+class TestDeviceShell:
+    def test_info_skips_log_text_and_stale_replies(self):
+        board = FakeBoard(b"[Replay] something\n")
+        shell = DeviceShell(board)
+        assert shell.info() == (1, 6, 3, 7, 12345)
+        assert shell.log == ["[Replay] something"]
+
+    def test_thread_stats_and_errors(self):
+        shell = DeviceShell(FakeBoard())
+        threads = shell.stats("threads")
+        assert list(threads) == list(CRASH_THREADS)
+        assert (threads["ble"].peak_bytes, threads["ble"].restarts) == (1002, 2)
+        try:
+            shell.stats("latency")
+        except RuntimeError as e:
+            assert "bad argument" in str(e)
+        else:
+            assert False, "expected the bad argument status"
+
+    def test_label_histograms_walk_every_label(self):
+        board = FakeBoard()
+        histograms = DeviceShell(board).stats("confidence")
+        assert list(histograms) == ["down", "idle", "left"]
+        assert histograms["left"].top[7] == 2 and histograms["left"].margin[4] == 2
+        assert [args for _, args in board.requests] == [bytes([3, n]) for n in range(3)]
+
+    def test_bench_waits_for_a_new_version(self):
+        board = FakeBoard()
+        report = DeviceShell(board).bench("live", 100, poll_s=0)
+        assert report.state == "done" and report.stages["total"].max_us == 5
+        assert board.requests[1] == (CMD_BENCH_START, struct.pack('<BH', 1, 100))
+
+    def test_config_preset(self):
+        config = DeviceShell(FakeBoard()).set_config(encode_profile("low-power"))
+        assert config.profile == "low-power" and config.ble_poll_interval_ms == 250
+
+    def test_trace_starts_and_stops(self):
+        board = FakeBoard()
+        packets = DeviceShell(board).trace(0.01, poll_s=0)
+        assert packets and not board.tracing
+        summary = zone_summary(packets)
+        assert summary["infer"][1] == 50.0 and summary["ble"][2] == 10.0
+        assert board.requests[0][0] == CMD_TRACE_START and board.requests[-1][0] == CMD_TRACE_STOP
+
+    def test_registry_reads_every_entry(self):
+        board = FakeBoard()
+        stats = DeviceShell(board).registry()
+        assert [(s.name, s.value) for s in stats] == [("events.dropped", 3), ("latency.inference_us", 0)]
+        assert stats[1].distribution.p99 == 8000 and stats[1].distribution.count == 40
+        assert stats[1].describe() == "latency.inference_us n 40 p50 4000 p90 6000 p99 8000 max 9000"
+        assert [args for _, args in board.requests] == [bytes([0]), bytes([1])]
@@ -0,0 +1,53 @@
+import os
+import sys
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from hypothesis import given, strategies as st, settings
+from ble_manager import DeliveryTracker, DeliveryCounters, LatencyBreakdown
+from diagnostics import DiagnosticsMonitor
+from gesture_handler import ActionStats
+
+NO_LATENCY = LatencyBreakdown(None, None, None, None, 0, None)
+NO_ACTIONS = ActionStats(0, 0, 0, 0, 0, None, None, None)
+
+
+class TestDiagnosticsMonitor:
+    @given(gestures=st.lists(st.floats(min_value=0.0, max_value=20.0), max_size=50))
+    @settings(max_examples=100)
+    def test_gesture_rate_counts_the_window(self, gestures):
+        monitor = DiagnosticsMonitor()
+        for when in sorted(gestures):
+            monitor.on_gesture(when)
+        snapshot = monitor.snapshot(DeliveryTracker(), NO_LATENCY, {}, NO_ACTIONS, now=20.0)
+        recent = [when for when in gestures if when >= 20.0 - monitor.RATE_WINDOW_S]
+        assert abs(snapshot.gesture_rate - len(recent) / monitor.RATE_WINDOW_S) < 1e-9
+
+    def test_notify_rate_and_loss(self):
+        monitor = DiagnosticsMonitor()
+        delivery = DeliveryTracker()
+        delivery.receive(0, 10, 0.0)
+        assert monitor.snapshot(delivery, NO_LATENCY, {}, NO_ACTIONS, now=1.0).notify_rate == 0.0
+        delivery.receive(10, 20, 1.0)
+        delivery.lost = 3
+        snapshot = monitor.snapshot(delivery, NO_LATENCY, {}, NO_ACTIONS, now=3.0)
+        assert snapshot.notify_rate == 10.0 and snapshot.received == 30
+        assert abs(snapshot.loss - 3 / 33) < 1e-9
+
+    def test_new_connection_restarts_the_rate(self):
+        monitor = DiagnosticsMonitor()
+        delivery = DeliveryTracker()
+        delivery.receive(0, 50, 0.0)
+        monitor.snapshot(delivery, NO_LATENCY, {}, NO_ACTIONS, now=0.0)
+        delivery.reset()
+        snapshot = monitor.snapshot(delivery, NO_LATENCY, {}, NO_ACTIONS, now=1.0)
+        assert snapshot.notify_rate == 0.0 and snapshot.loss is None
+
+    def test_device_reports_are_kept(self):
+        monitor = DiagnosticsMonitor()
+        monitor.set_counters(DeliveryCounters(5, 1, 0, 30, 2))
+        actions = ActionStats(4, 0, 0, 0, 0, 1.0, 3.0, 4.0)
+        snapshot = monitor.snapshot(DeliveryTracker(), NO_LATENCY, {0.5: 40.0}, actions, now=0.0)
+        assert snapshot.counters.published == 5 and snapshot.inject_p95_ms == 3.0
+        assert snapshot.end_to_end_ms[0.5] == 40.0
+        monitor.reset()
+        assert monitor.snapshot(DeliveryTracker(), NO_LATENCY, {}, NO_ACTIONS).counters is None
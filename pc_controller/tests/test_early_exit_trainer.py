@@ -0,0 +1,105 @@
+import os
+import re
+import sys
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from hypothesis import given, strategies as st, settings
+from early_exit_trainer import (format_header, head_probabilities, labelled_windows, pooled_features,
+                                quantize_head, select_threshold, train_softmax)
+from replay_runner import parse_output
+
+int8_st = st.integers(min_value=-128, max_value=127)
+
+
+class TestFeatures:
+    @given(pooled=st.lists(int8_st, min_size=36 * 8, max_size=36 * 8))
+    @settings(max_examples=50)
+    def test_sum_and_scaled_max_per_channel(self, pooled):
+        features = pooled_features(pooled)
+        assert len(features) == 16
+        for c in range(8):
+            channel = pooled[c::8]
+            assert features[c] == sum(channel)
+            assert features[8 + c] == max(channel) * 36
+
+    def test_column_order_does_not_matter(self):
+        pooled = [(j * 7 + c) % 50 for j in range(36) for c in range(8)]
+        rotated = pooled[5 * 8:] + pooled[:5 * 8]
+        assert pooled_features(pooled) == pooled_features(rotated)
+
+
+class TestTraining:
+    def test_separates_two_classes(self):
+        points = [[10 + i % 3, 0] for i in range(20)] + [[-10 - i % 3, 0] for i in range(20)]
+        targets = [0] * 20 + [1] * 20
+        weights, bias, mean, std = train_softmax(points, targets, 2, epochs=100)
+        q_weights, q_bias, scale = quantize_head(weights, bias, mean, std)
+        for point, target in zip(points, targets):
+            probs = head_probabilities(point, q_weights, q_bias, scale)
+            assert probs.index(max(probs)) == target
+
+    @given(points=st.lists(st.lists(st.integers(min_value=-4000, max_value=4000), min_size=4, max_size=4),
+                           min_size=2, max_size=20))
+    @settings(max_examples=30)
+    def test_quantized_head_tracks_float_head(self, points):
+        targets = [i % 3 for i in range(len(points))]
+        weights, bias, mean, std = train_softmax(points, targets, 3, epochs=20)
+        q_weights, q_bias, scale = quantize_head(weights, bias, mean, std)
+        assert all(-127 <= v <= 127 for row in q_weights for v in row)
+        for point in points:
+            z = [(p - m) / s for p, m, s in zip(point, mean, std)]
+            for w, b, q_w, q_b in zip(weights, bias, q_weights, q_bias):
+                exact = b + sum(w_i * z_i for w_i, z_i in zip(w, z))
+                quantized = (q_b + sum(w_i * f_i for w_i, f_i in zip(q_w, point))) * scale
+                # every weight and the bias are rounded by at most half a quantization step
+                bound = scale * (sum(abs(f) for f in point) + 1) / 2
+                assert abs(exact - quantized) <= bound + 1e-6 * (1 + abs(exact))
+
+
+class TestThreshold:
+    @given(decisions=st.lists(st.tuples(st.integers(min_value=0, max_value=2), st.floats(min_value=0.3, max_value=1.0),
+                                        st.integers(min_value=0, max_value=2)), max_size=60),
+           agreement=st.floats(min_value=0.5, max_value=1.0))
+    @settings(max_examples=50)
+    def test_exiting_windows_reach_agreement(self, decisions, agreement):
+        threshold = select_threshold(decisions, [0], agreement)
+        if threshold is not None:
+            exits = [(top, full) for top, p, full in decisions if top == 0 and p >= threshold]
+            assert exits and sum(1 for top, full in exits if top == full) >= agreement * len(exits)
+
+    def test_lowest_threshold_is_chosen(self):
+        decisions = [(0, 0.99, 0), (0, 0.9, 0), (0, 0.8, 1), (0, 0.7, 0), (1, 0.95, 0)]
+        assert select_threshold(decisions, [0], 0.75) == 0.7
+        assert select_threshold(decisions, [0], 1.0) == 0.9
+        assert select_threshold([(1, 0.9, 1)], [0], 0.9) is None
+
+
+class TestHeader:
+    def test_table_sizes_match_defines(self):
+        text = format_header([[1] * 16] * 5, [1, 2, 3, 4, 5], 0.01, 0x02, 0.9)
+        assert "#define EARLY_EXIT_MODEL_CLASSES 5" in text
+        body = text.split("kEarlyExitWeights", 1)[1].split("};", 1)[0].split("{", 1)[1]
+        assert len(re.findall(r"-?\d+", body)) == 80
+        assert "kEarlyExitBias[5] = {1, 2, 3, 4, 5};" in text
+        assert "kEarlyExitClassMask = 0x02;" in text
+
+    def test_empty_head_keeps_placeholder_tables(self):
+        text = format_header([], [], 0.0, 0, 1.0)
+        assert "#define EARLY_EXIT_MODEL_CLASSES 0" in text and "kEarlyExitBias[1] = {0};" in text
+
+
+class TestPooledLines:
+    @given(values=st.lists(int8_st, min_size=1, max_size=288), frame=st.integers(min_value=0, max_value=10**6))
+    @settings(max_examples=50)
+    def test_round_trip(self, values, frame):
+        line = f"pooled,{frame}," + "".join(f"{v & 0xff:02x}" for v in values)
+        parsed = parse_output("idle.csv", "labels,down,idle\n" + line + "\n")
+        assert parsed.pooled == [(frame, values)]
+        assert parsed.labels == ["down", "idle"]
+
+    def test_windows_are_labelled_by_frame(self):
+        pooled = "".join("01" for _ in range(288))
+        text = ("labels,down,idle\nresult,24,idle,0.9,10,20\npooled,24," + pooled +
+                "\nresult,30,uncertain,0.0,10,20\npooled,30," + pooled + "\n")
+        windows = labelled_windows(parse_output("idle.csv", text))
+        assert windows == [([36] * 8 + [36] * 8, 1)]
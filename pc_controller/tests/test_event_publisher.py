@@ -0,0 +1,90 @@
+import json
+import os
+import socket
+import sys
+import tempfile
+import time
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from hypothesis import given, strategies as st, settings
+from config_manager import ConfigManager
+from event_publisher import (EVENT_FRAME, UNKNOWN_LABEL, EventPublisher, decode_frame, open_websocket,
+                             parse_endpoint, percentile, receive_websocket_frame)
+from gesture_labels import MODEL_LABELS
+
+
+def free_port(kind=socket.SOCK_STREAM):
+    with socket.socket(socket.AF_INET, kind) as sock:
+        sock.bind(("127.0.0.1", 0))
+        return sock.getsockname()[1]
+
+
+def make_publisher(tmp, multicast="", websocket_port=0):
+    path = os.path.join(tmp, "config.json")
+    with open(path, "w") as f:
+        json.dump({"publish_multicast": multicast, "publish_websocket_port": websocket_port}, f)
+    config = ConfigManager(path)
+    config.load()
+    return EventPublisher(config)
+
+
+class TestFrames:
+    @given(label=st.sampled_from(list(MODEL_LABELS) + ["custom_3"]), confidence=st.floats(0, 1))
+    @settings(max_examples=50)
+    def test_round_trip(self, label, confidence):
+        with tempfile.TemporaryDirectory() as tmp:
+            publisher = make_publisher(tmp, "127.0.0.1:9")
+            publisher._running = True
+            publisher.publish(label, confidence)
+            sequence, decoded, value, index, _ = decode_frame(bytes(publisher._datagram))
+            assert (sequence, decoded) == (1, label) and abs(value - confidence) < 1e-6
+            assert index == (MODEL_LABELS.index(label) if label in MODEL_LABELS else UNKNOWN_LABEL)
+            assert len(publisher._datagram) == EVENT_FRAME.size
+            publisher.close()
+
+    def test_endpoints(self):
+        assert parse_endpoint("239.255.71.1:5871") == ("239.255.71.1", 5871)
+        assert parse_endpoint("") is None and parse_endpoint("239.255.71.1") is None
+        assert parse_endpoint("host:0") is None
+        with tempfile.TemporaryDirectory() as tmp:
+            assert not make_publisher(tmp).enabled
+
+
+class TestDelivery:
+    def test_every_subscriber_gets_every_event_within_a_millisecond(self):
+        with tempfile.TemporaryDirectory() as tmp:
+            udp_port = free_port(socket.SOCK_DGRAM)
+            publisher = make_publisher(tmp, f"127.0.0.1:{udp_port}", free_port())
+            udp = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+            udp.bind(("127.0.0.1", udp_port))
+            udp.settimeout(2.0)
+            publisher.start()
+            try:
+                websockets = [open_websocket(publisher.websocket_port()) for _ in range(2)]
+                for sock in websockets:
+                    sock.settimeout(2.0)
+                deadline = time.monotonic() + 2.0
+                while publisher.subscriber_count() < 2 and time.monotonic() < deadline:
+                    time.sleep(0.01)
+                assert publisher.subscriber_count() == 2
+                latencies = []
+                for n in range(200):
+                    publisher.publish(MODEL_LABELS[n % len(MODEL_LABELS)], 0.9)
+                    for receive in [lambda: udp.recv(64)] + [lambda s=s: receive_websocket_frame(s) for s in websockets]:
+                        data = receive()
+                        received_ns = time.perf_counter_ns()
+                        sequence, label, _, _, published_ns = decode_frame(data)
+                        assert sequence == n + 1 and label == MODEL_LABELS[n % len(MODEL_LABELS)]
+                        latencies.append((received_ns - published_ns) / 1e6)
+                assert percentile(latencies, 0.5) < 1.0
+                # A subscriber that goes away is dropped, the others keep receiving
+                websockets[0].close()
+                deadline = time.monotonic() + 2.0
+                while publisher.subscriber_count() > 1 and time.monotonic() < deadline:
+                    time.sleep(0.01)
+                publisher.publish("left", 0.5)
+                assert decode_frame(receive_websocket_frame(websockets[1]))[0] == 201
+                websockets[1].close()
+            finally:
+                publisher.close()
+                udp.close()
@@ -0,0 +1,73 @@
+import asyncio
+import os
+import sys
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from hypothesis import given, strategies as st, settings
+from ble_manager import (FEWSHOT_ALL_CLASSES, FEWSHOT_COMMIT_COMMAND, FEWSHOT_RECORD_COMMAND, FEWSHOT_STATUS,
+                         FewShotStatus, encode_fewshot_command, parse_fewshot_status)
+from fewshot_enroll import enroll, parse_erase
+
+
+def status(state="idle", error="ok", enroll_class=None, classes=(), examples=0, windows=0):
+    return FewShotStatus(state, error, enroll_class, list(classes), examples, windows, 0, None, 0)
+
+
+class FakeManager:
+    """Device side of the enrollment commands: every record collects three windows."""
+
+    def __init__(self, commit_error="ok"):
+        self.commands = []
+        self.examples = 0
+        self.commit_error = commit_error
+
+    async def record_fewshot_example(self, class_index):
+        self.commands.append((FEWSHOT_RECORD_COMMAND, class_index))
+        self.examples += 1
+        return status("enrolling", enroll_class=class_index, examples=self.examples, windows=3 * self.examples)
+
+    async def commit_fewshot_class(self):
+        self.commands.append((FEWSHOT_COMMIT_COMMAND, None))
+        if self.commit_error != "ok":
+            return status("enrolling", self.commit_error, enroll_class=0, examples=self.examples)
+        return status(classes=[0])
+
+    async def fewshot_command(self, command, class_index=None):
+        self.commands.append((command, class_index))
+        return status()
+
+
+class TestStatus:
+    @given(state=st.integers(min_value=0, max_value=2), error=st.integers(min_value=0, max_value=5),
+           enroll_class=st.sampled_from([0, 3, 0xFF]), mask=st.integers(min_value=0, max_value=0xFF),
+           last_class=st.integers(min_value=-1, max_value=7), distance=st.integers(min_value=0, max_value=0xFFFFFFFF))
+    @settings(max_examples=100)
+    def test_round_trip(self, state, error, enroll_class, mask, last_class, distance):
+        parsed = parse_fewshot_status(FEWSHOT_STATUS.pack(state, error, enroll_class, mask, 4, 17, 9, last_class,
+                                                          distance))
+        assert parsed.enroll_class == (None if enroll_class == 0xFF else enroll_class)
+        assert sum(1 << k for k in parsed.classes) == mask
+        assert parsed.last_class == (None if last_class < 0 else last_class)
+        assert (parsed.examples, parsed.windows, parsed.matches, parsed.last_distance) == (4, 17, 9, distance)
+
+    def test_short_value(self):
+        assert FEWSHOT_STATUS.size == 20
+        assert parse_fewshot_status(b"\x00" * (FEWSHOT_STATUS.size - 1)) is None
+
+    def test_commands(self):
+        assert encode_fewshot_command(FEWSHOT_RECORD_COMMAND, 2) == bytes([1, 2])
+        assert encode_fewshot_command(FEWSHOT_COMMIT_COMMAND) == bytes([2])
+        assert parse_erase("all") == FEWSHOT_ALL_CLASSES
+        assert parse_erase("3") == 3
+
+
+class TestEnroll:
+    def test_records_then_commits(self):
+        manager = FakeManager()
+        assert asyncio.run(enroll(manager, 0, 3, prompt=lambda _: None)) == 0
+        assert manager.commands == [(FEWSHOT_RECORD_COMMAND, 0)] * 3 + [(FEWSHOT_COMMIT_COMMAND, None)]
+
+    def test_failed_commit_cancels(self):
+        manager = FakeManager(commit_error="windows")
+        assert asyncio.run(enroll(manager, 0, 1, prompt=lambda _: None)) == 1
+        assert manager.commands[-1] == (0x04, None)
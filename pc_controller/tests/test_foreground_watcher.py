@@ -0,0 +1,81 @@
+import json
+import os
+import sys
+import tempfile
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from config_manager import ConfigManager
+from foreground_watcher import ForegroundWatcher, OperatingPointPolicy, OperatingPointPusher
+
+OWN_PID = 4242
+
+
+def make_pusher(apps=("POWERPNT.EXE", "vlc.exe"), background="idle-filter"):
+    sent = []
+    pusher = OperatingPointPusher(OperatingPointPolicy(apps, background, own_pid=OWN_PID), sent.append)
+    return pusher, sent
+
+
+class TestPolicy:
+    def test_gesture_apps_run_full(self):
+        policy = OperatingPointPolicy(["POWERPNT.EXE"], "idle-filter", own_pid=OWN_PID)
+        assert policy.point_for(10, "powerpnt.exe") == "full"
+        assert policy.point_for(11, "chrome.exe") == "idle-filter"
+        # An unreadable (elevated) process is any other application
+        assert policy.point_for(12, None) == "idle-filter"
+        # The controller's own window shows the gestures
+        assert policy.point_for(OWN_PID, "python.exe") == "full"
+
+    def test_empty_list_is_off(self):
+        assert not OperatingPointPolicy([], "idle-filter").enabled
+
+
+class TestPusher:
+    def test_sends_only_changes(self):
+        pusher, sent = make_pusher()
+        pusher.connected()
+        assert sent == []   # nothing known about the foreground yet
+        for pid, name in [(1, "POWERPNT.EXE"), (2, "vlc.exe"), (3, "chrome.exe"), (4, "explorer.exe"),
+                          (1, "POWERPNT.EXE")]:
+            pusher.switched(pid, name)
+        assert sent == ["full", "idle-filter", "full"]
+
+    def test_resends_on_every_connection(self):
+        pusher, sent = make_pusher(background="coarse")
+        pusher.switched(3, "chrome.exe")
+        assert sent == []   # no session to send to
+        pusher.connected()
+        pusher.disconnected()
+        pusher.switched(1, "POWERPNT.EXE")
+        assert sent == ["coarse"]
+        # The device released the request when the session ended
+        pusher.connected()
+        assert sent == ["coarse", "full"] and pusher.wanted == "full"
+
+
+class TestConfig:
+    def test_settings_and_defaults(self):
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, "config.json")
+            config = ConfigManager(path)
+            config.load()
+            apps, background = config.get_foreground_gating()
+            assert "POWERPNT.EXE" in apps and background == "idle-filter"
+
+            with open(path, "w") as f:
+                json.dump({"gesture_apps": ["obs64.exe"], "background_power_point": "full"}, f)
+            config.load()
+            # "full" in the background would be no gating at all: the default stays
+            assert config.get_foreground_gating() == (["obs64.exe"], "idle-filter")
+
+            with open(path, "w") as f:
+                json.dump({"gesture_apps": [], "background_power_point": "on-demand"}, f)
+            config.load()
+            assert config.get_foreground_gating() == ([], "on-demand")
+
+
+def test_watcher_off_without_hook():
+    watcher = ForegroundWatcher(lambda pid, name: None)
+    if not ForegroundWatcher.supported():
+        assert not watcher.start()
+    watcher.close()
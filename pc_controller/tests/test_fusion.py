@@ -0,0 +1,66 @@
+import os
+import sys
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from hypothesis import given, strategies as st, settings
+from config_manager import ConfigManager
+from fusion import FusionEngine
+from gesture_labels import MODEL_LABELS
+
+IDLE = [0.02, 0.9, 0.04, 0.02, 0.02]    # MODEL_LABELS order: down, idle, left, right, up
+
+
+def confident(label, probability=0.9):
+    rest = (1.0 - probability) / (len(MODEL_LABELS) - 1)
+    return [probability if name == label else rest for name in MODEL_LABELS]
+
+
+def engine(method, **thresholds):
+    config = ConfigManager()
+    config.set_fusion_method(method)
+    for gesture, threshold in thresholds.items():
+        config.set_fusion_threshold(gesture, threshold)
+    return config, FusionEngine(config)
+
+
+def run(fusion, frames, stream=""):
+    return [detection for n, frame in enumerate(frames)
+            if (detection := fusion.feed(frame, n, stream)) is not None]
+
+
+class TestFusion:
+    @given(method=st.sampled_from(["smoothing", "hmm"]))
+    @settings(max_examples=4)
+    def test_sustained_gesture_fires_once(self, method):
+        _, fusion = engine(method)
+        detections = run(fusion, [IDLE] * 10 + [confident("left")] * 8 + [IDLE] * 10)
+        assert [gesture for gesture, _ in detections] == ["left"]
+        assert detections[0][1] >= 0.7
+
+    @given(method=st.sampled_from(["smoothing", "hmm"]))
+    @settings(max_examples=4)
+    def test_single_moderate_spike_is_ignored(self, method):
+        _, fusion = engine(method)
+        assert run(fusion, [IDLE] * 10 + [confident("right", 0.75)] + [IDLE] * 10) == []
+
+    def test_rearms_after_release(self):
+        _, fusion = engine("smoothing")
+        frames = ([IDLE] * 6 + [confident("up")] * 8) * 2 + [IDLE] * 6
+        assert [gesture for gesture, _ in run(fusion, frames)] == ["up", "up"]
+
+    def test_per_gesture_threshold(self):
+        _, fusion = engine("smoothing", left=0.95)
+        frames = [confident("left", 0.85)] * 12 + [IDLE] * 10 + [confident("right", 0.85)] * 12
+        assert [gesture for gesture, _ in run(fusion, frames)] == ["right"]
+
+    def test_streams_are_independent(self):
+        _, fusion = engine("hmm")
+        assert run(fusion, [confident("down")] * 8, "A") != []
+        assert fusion.feed(IDLE, 0, "B") is None
+
+    def test_off_and_config_change(self):
+        config, fusion = engine("off")
+        assert not fusion.enabled and run(fusion, [confident("left")] * 10) == []
+        config.set_fusion_method("hmm")
+        assert fusion.enabled and run(fusion, [confident("left")] * 10) != []
+        assert not config.set_fusion_method("viterbi") and not config.set_fusion_threshold("left", 1.5)
@@ -1,10 +1,12 @@
 import os
 import sys
+import threading
+import time
 sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
 
 from hypothesis import given, strategies as st, settings
 from config_manager import ConfigManager
-from gesture_handler import GestureHandler
+from gesture_handler import ActionExecutor, GestureHandler, KeyRepeater
 
 valid_gestures = st.sampled_from(["left", "right", "up", "down"])
 shortcut_strings = st.sampled_from(["right", "left", "up", "down", "none", "ctrl+up"])
@@ -67,3 +69,178 @@ class TestDefaults:
         handler = GestureHandler(config)
         assert handler.handle_gesture("unknown", 0.90) is None
         assert handler.handle_gesture("idle", 0.90) is None
+
+
+class TestMacros:
+    def test_commas_separate_combinations(self):
+        handler = GestureHandler(ConfigManager())
+        modifiers, macro = handler.parse_shortcut("ctrl+a , ctrl+shift+c,f5")
+        assert modifiers == [] and len(macro.chords) == 3
+        assert macro.chords[1] == ((GestureHandler.MODIFIER_KEYS["ctrl"], GestureHandler.MODIFIER_KEYS["shift"]),
+                                   handler.parse_shortcut("c")[1])
+
+    def test_trailing_comma_is_the_comma_key(self):
+        handler = GestureHandler(ConfigManager())
+        assert handler.parse_shortcut("ctrl+,")[1] == handler.parse_shortcut(",")[1]
+        assert len(handler.parse_shortcut("ctrl+,, a")[1].chords) == 2
+
+    def test_invalid_step_disables_the_macro(self):
+        handler = GestureHandler(ConfigManager())
+        assert handler.parse_shortcut("ctrl+a, none") == ([], None)
+
+
+class TestActionCache:
+    @given(shortcuts=valid_shortcuts, threshold=threshold_st)
+    @settings(max_examples=50)
+    def test_config_change_recompiles(self, shortcuts, threshold):
+        config = ConfigManager()
+        handler = GestureHandler(config)
+        config.set_gesture_shortcuts(shortcuts)
+        config.set_confidence_threshold(threshold)
+        for gesture, shortcut in shortcuts.items():
+            expected = None if shortcut == "none" else shortcut
+            assert handler.handle_gesture(gesture, 1.0) == expected
+
+
+class TestActionExecutor:
+    def blocked(self, policy, max_pending=4):
+        """Executor whose first press waits for the returned event."""
+        release = threading.Event()
+        started = threading.Event()
+        pressed = []
+
+        def press(modifiers, main_key):
+            if not pressed:
+                started.set()
+                release.wait(5)
+            pressed.append(main_key)
+            return main_key != "fail"
+
+        executor = ActionExecutor(press, max_pending=max_pending, policy=policy)
+        executor.submit([], "first")
+        started.wait(5)
+        return executor, release, pressed
+
+    @given(keys=st.lists(st.sampled_from(["a", "b", "c"]), max_size=4))
+    @settings(max_examples=30)
+    def test_fifo_runs_in_order(self, keys):
+        executor, release, pressed = self.blocked("fifo")
+        for key in keys:
+            assert executor.submit([], key)
+        release.set()
+        executor.close()
+        assert pressed == ["first"] + keys
+        stats = executor.stats()
+        assert stats.executed == len(keys) + 1 and stats.pending == 0 and stats.dropped == 0
+
+    def test_fifo_drops_when_full(self):
+        executor, release, pressed = self.blocked("fifo", max_pending=2)
+        assert executor.submit([], "a") and executor.submit([], "b")
+        assert not executor.submit([], "c")
+        release.set()
+        executor.close()
+        assert pressed == ["first", "a", "b"] and executor.stats().dropped == 1
+
+    def test_latest_keeps_newest(self):
+        executor, release, pressed = self.blocked("latest")
+        for key in ("a", "b", "c"):
+            assert executor.submit([], key)
+        release.set()
+        executor.close()
+        assert pressed == ["first", "c"] and executor.stats().coalesced == 2
+
+    def test_done_and_stats(self):
+        results = []
+        executor = ActionExecutor(lambda modifiers, main_key: main_key != "fail")
+        executor.submit([], "a", results.append)
+        executor.submit([], "fail", results.append)
+        executor.close()
+        stats = executor.stats()
+        assert results == [True, False]
+        assert stats.executed == 1 and stats.failed == 1
+        assert stats.p50_ms is not None and stats.max_ms >= stats.p50_ms
+
+    def test_call_latency_excludes_the_queue(self):
+        executor, release, pressed = self.blocked("fifo")
+        executor.submit([], "a")
+        release.set()
+        executor.close()
+        stats = executor.stats()
+        assert stats.call_p50_ms is not None and stats.call_max_ms <= stats.max_ms
+
+    def test_unknown_policy(self):
+        try:
+            ActionExecutor(lambda modifiers, main_key: True, policy="oldest")
+            assert False
+        except ValueError:
+            pass
+
+
+def wait_for(condition, timeout=2.0):
+    deadline = time.monotonic() + timeout
+    while not condition() and time.monotonic() < deadline:
+        time.sleep(0.005)
+    return condition()
+
+
+class TestKeyRepeater:
+    def test_repeats_until_stopped(self):
+        submitted = []
+        repeater = KeyRepeater(lambda gesture, modifiers, main_key: submitted.append(gesture) or True)
+        repeater.start("left", [], "a", rate_hz=100.0, delay_s=0.0)
+        assert wait_for(lambda: len(submitted) >= 3)
+        assert not repeater.stop("right")
+        assert repeater.stop("left") and repeater.holding() is None
+        count = len(submitted)
+        time.sleep(0.05)
+        repeater.close()
+        assert len(submitted) == count and set(submitted) == {"left"}
+
+    def test_first_repeat_after_delay(self):
+        submitted = []
+        repeater = KeyRepeater(lambda gesture, modifiers, main_key: submitted.append(gesture) or True)
+        repeater.start("left", [], "a", rate_hz=100.0, delay_s=0.2)
+        time.sleep(0.05)
+        assert submitted == [] and repeater.holding() == "left"
+        repeater.close()
+
+
+class TestHoldToRepeat:
+    def handler(self):
+        config = ConfigManager()
+        config.set_gesture_shortcuts({"left": "right", "right": "left", "up": "none", "down": "none"})
+        config.set_repeat_gesture("left", True)
+        config.set_repeat_gesture("up", True)
+        handler = GestureHandler(config)
+        pressed = []
+        handler._executor = ActionExecutor(lambda modifiers, main_key: pressed.append(main_key) or True)
+        return config, handler, pressed
+
+    def test_only_repeat_gestures_with_a_shortcut_hold(self):
+        config, handler, pressed = self.handler()
+        assert not handler.process_hold("right", True)
+        assert not handler.process_hold("up", True)
+        assert handler.process_hold("left", True)
+        assert not handler.process_hold("right", False)
+        assert handler.process_hold("left", False)
+        handler.close()
+        assert pressed == []
+
+    def test_repeat_gestures_skip_the_cooldown(self):
+        config, handler, pressed = self.handler()
+        assert handler.process_gesture("left", 0.9) == "right"
+        assert handler.process_gesture("left", 0.9) == "right"
+        # They still start the cooldown of the other gestures
+        assert handler.process_gesture("right", 0.9) is None
+        handler.close()
+        assert len(pressed) == 2
+
+    def test_held_gesture_repeats(self):
+        config, handler, pressed = self.handler()
+        config.set_repeat_rate(30.0)
+        handler._repeater.DELAY_S = 0.0
+        handler.process_hold("left", True)
+        assert wait_for(lambda: len(pressed) >= 2)
+        config.set_repeat_gesture("left", False)
+        assert handler._repeater.holding() is None
+        handler.close()
@@ -0,0 +1,122 @@
+import json
+import os
+import sys
+import tempfile
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from hypothesis import given, strategies as st, settings
+from config_manager import ConfigManager
+from gesture_labels import MODEL_LABELS
+from host_model import BUILTIN_MODEL, HostModel, HostModelRuntime, WindowAssembler, channel_scales, encode_values
+from raw_recorder import ACC_LSB_PER_G, GYR_LSB_PER_DPS, TYPE_WINDOW, RawPacket
+
+FRAMES = 8
+
+
+def window_packet(first, count, channels=6):
+    indices = list(range(first, first + count))
+    return RawPacket(0, (1 << channels) - 1, indices, [[i] * channels for i in indices], TYPE_WINDOW)
+
+
+def make_config(tmp, labels=()):
+    path = os.path.join(tmp, "config.json")
+    with open(path, "w") as f:
+        json.dump({"host_model_path": "model.tflite", "host_model_labels": list(labels)}, f)
+    config = ConfigManager(path)
+    config.load()
+    return config
+
+
+class FakeRuntime:
+    """Answers like the C++ runtime: batch 4, FRAMES frames, a score vector chosen per tag."""
+
+    def __init__(self, path, scales):
+        self.batch, self.values, self.classes = 4, FRAMES * len(scales), len(MODEL_LABELS)
+        self.requests = []
+
+    def run(self, windows):
+        self.requests.append(windows)
+        left = MODEL_LABELS.index("left")
+        return [(stream, tag, [0.9 if c == left and tag >= 20 else 0.02 for c in range(self.classes)])
+                for stream, tag, _ in windows]
+
+    def close(self):
+        pass
+
+
+class TestWindows:
+    @given(count=st.integers(1, 60), hop=st.integers(1, 5))
+    @settings(max_examples=50)
+    def test_window_every_hop(self, count, hop):
+        assembler = WindowAssembler(FRAMES, hop)
+        windows = assembler.feed(window_packet(0, count))
+        assert [tag for tag, _ in windows] == list(range(FRAMES - 1, count, hop))
+        for tag, values in windows:
+            assert values[::6] == list(range(tag - FRAMES + 1, tag + 1))
+
+    def test_gap_starts_over(self):
+        assembler = WindowAssembler(FRAMES, 1)
+        assembler.feed(window_packet(0, FRAMES - 1))
+        assert assembler.feed(window_packet(FRAMES, 2)) == []
+
+    def test_encoding_and_scales(self):
+        assert encode_values([1, -1, 0x1234]) == "0100ffff3412"
+        assert channel_scales(0x3F) == [1 / ACC_LSB_PER_G] * 3 + [1 / GYR_LSB_PER_DPS] * 3
+        assert channel_scales(0x38) == [1 / GYR_LSB_PER_DPS] * 3
+
+
+class TestHostModel:
+    def test_config(self):
+        with tempfile.TemporaryDirectory() as tmp:
+            assert make_config(tmp, ["a", "b"]).get_host_model() == ("model.tflite", ["a", "b"])
+            assert ConfigManager(os.path.join(tmp, "missing.json")).get_host_model() == ("", [])
+
+    def test_batches_all_devices_and_decides_once(self):
+        with tempfile.TemporaryDirectory() as tmp:
+            model = HostModel(make_config(tmp), FakeRuntime)
+            detected = []
+            model.set_gesture_callback(lambda gesture, confidence: detected.append(gesture))
+            model._packets = [("a", window_packet(0, 16)), ("b", window_packet(0, 16))]
+            model.process_pending()
+            runtime = model._runtime
+            # One request with the windows of both devices
+            assert len(runtime.requests) == 1 and {w[0] for w in runtime.requests[0]} == {"a", "b"}
+            model._packets = [("a", window_packet(16, 16))]
+            assert model.process_pending() == [("left", 0.9)]
+            model._packets = [("a", window_packet(32, 24))]
+            assert model.process_pending() == []  # still above the release level
+            assert detected == ["left"]
+
+    def test_device_gesture_is_not_repeated(self):
+        with tempfile.TemporaryDirectory() as tmp:
+            model = HostModel(make_config(tmp), FakeRuntime)
+            model.note_device_gesture("left", "a")
+            model._packets = [("a", window_packet(0, 32))]
+            assert model.process_pending() == []
+
+    def test_builtin_model_runs_the_deployed_impulse(self):
+        # A stand-in runtime that reports its first argument as the single class score
+        with tempfile.TemporaryDirectory() as tmp:
+            program = os.path.join(tmp, "program")
+            with open(program, "w") as f:
+                f.write(f"#!{sys.executable}\nimport sys\nprint('ready,1,3,1', flush=True)\n"
+                        "for line in sys.stdin:\n"
+                        "    if line.strip() == 'run':\n"
+                        "        print(f'result,a,0,{int(sys.argv[1] == \"--builtin\")}\\ndone,1,1,0', flush=True)\n")
+            os.chmod(program, 0o755)
+            runtime = HostModelRuntime(BUILTIN_MODEL, [1.0] * 3, program)
+            try:
+                assert runtime.run([("a", 0, [0, 0, 0])]) == [("a", 0, [1.0])]
+            finally:
+                runtime.close()
+
+    def test_label_count_mismatch_is_reported(self):
+        with tempfile.TemporaryDirectory() as tmp:
+            model = HostModel(make_config(tmp, ["a", "b"]), FakeRuntime)
+            model._packets = [("a", window_packet(0, 16))]
+            try:
+                model.process_pending()
+            except RuntimeError as e:
+                assert "classes" in str(e)
+            else:
+                assert False, "expected the label mismatch"
@@ -0,0 +1,78 @@
+import os
+import sys
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+import math
+
+from hypothesis import given, strategies as st, settings
+from idle_prefilter_tuner import (choose_threshold, evaluate, label_from_path, quantize,
+                                  resample, window_features, window_std)
+
+values = st.floats(min_value=-4.0, max_value=4.0, allow_nan=False)
+windows_st = st.lists(st.lists(values, min_size=3, max_size=3), min_size=2, max_size=48)
+features_st = st.lists(st.floats(min_value=0.0, max_value=2.0, allow_nan=False), min_size=1, max_size=200)
+
+
+class TestWindowStd:
+    @given(frame=st.lists(values, min_size=3, max_size=3), count=st.integers(min_value=2, max_value=48))
+    def test_constant_window_is_zero(self, frame, count):
+        assert window_std([frame] * count) < 1e-9
+
+    @given(window=windows_st, offset=values)
+    @settings(max_examples=50)
+    def test_offset_invariant(self, window, offset):
+        shifted = [[v + offset for v in frame] for frame in window]
+        assert math.isclose(window_std(window), window_std(shifted), rel_tol=1e-6, abs_tol=1e-6)
+
+    @given(window=windows_st)
+    @settings(max_examples=50)
+    def test_bounded_by_largest_axis_range(self, window):
+        worst_range = max(max(f[a] for f in window) - min(f[a] for f in window) for a in range(3))
+        assert window_std(window) <= worst_range / 2 + 1e-9
+
+
+class TestThreshold:
+    @given(idle=features_st, gestures=features_st)
+    @settings(max_examples=100)
+    def test_zero_miss_rate_misses_no_gesture(self, idle, gestures):
+        threshold = choose_threshold(idle, gestures, miss_rate=0.0, margin=0.99)
+        result = evaluate(threshold, idle, gestures)
+        assert result["gesture_missed"] == 0.0 or min(gestures) == 0.0
+
+    @given(idle=features_st, gestures=features_st, miss_rate=st.floats(min_value=0.0, max_value=0.5))
+    @settings(max_examples=100)
+    def test_miss_rate_respected(self, idle, gestures, miss_rate):
+        threshold = choose_threshold(idle, gestures, miss_rate=miss_rate, margin=1.0)
+        below = sum(1 for g in gestures if g < threshold)
+        assert below <= miss_rate * len(gestures)
+
+    def test_separable_dataset(self):
+        idle = [0.002, 0.004, 0.003]
+        gestures = [0.3, 0.5, 0.2]
+        result = evaluate(choose_threshold(idle, gestures), idle, gestures)
+        assert result == {"idle_skipped": 1.0, "gesture_missed": 0.0}
+
+
+class TestPipeline:
+    def test_label_from_path(self):
+        assert label_from_path("/data/idle.01.csv") == "idle"
+        assert label_from_path("left.wave3.csv") == "left"
+
+    def test_resample_rate(self):
+        # 2 s at 400 Hz -> 96 frames at 48 Hz
+        timestamps = [i * 2.5 for i in range(800)]
+        frames = [[0.0, 0.0, 1.0]] * 800
+        out = resample(timestamps, frames)
+        assert len(out) == 96
+        assert out[0] == [0.0, 0.0, 1.0]
+
+    @given(count=st.integers(min_value=24, max_value=200))
+    def test_window_count(self, count):
+        frames = [[0.0, 0.0, 1.0]] * count
+        assert len(window_features(frames)) == (count - 24) // 2 + 1
+
+    @given(value=values)
+    def test_quantize_round_trip_error(self, value):
+        scale = 0.031373
+        if -127 * scale <= value <= 128 * scale:
+            assert abs(quantize(value, scale) - value) <= scale / 2 + 1e-9
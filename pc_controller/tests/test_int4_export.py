@@ -0,0 +1,71 @@
+import os
+import sys
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from hypothesis import given, strategies as st, settings
+from int4_export import PACKED_LAYERS, choose_scale, quantize_int4, rewrite_model, to_int4, weight_bytes
+from model_ota import (CONV1_FILTER, DEPLOYED_MODEL, build_blob, load_compiled_model, pack_int4, parse_blob,
+                       parse_compiled_model, reference_logits, self_test_window, unpack_int4)
+
+DEPLOYED = load_compiled_model(DEPLOYED_MODEL)
+with open(DEPLOYED_MODEL, encoding="utf-8") as _f:
+    SOURCE = _f.read()
+PACKED = to_int4(DEPLOYED)
+
+
+class TestPacking:
+    @given(values=st.lists(st.integers(min_value=-8, max_value=7), max_size=64))
+    @settings(max_examples=100)
+    def test_round_trip(self, values):
+        packed = pack_int4(values)
+        assert len(packed) == (len(values) + 1) // 2
+        assert all(-128 <= b <= 127 for b in packed)
+        assert unpack_int4(packed, len(values)) == values
+
+    def test_low_nibble_first(self):
+        assert pack_int4([1, -2]) == [-31]  # 0xE1
+        assert unpack_int4([-31], 2) == [1, -2]
+
+
+class TestQuantization:
+    @given(weights=st.lists(st.integers(min_value=-127, max_value=127), min_size=1, max_size=64))
+    @settings(max_examples=50)
+    def test_range_and_zero(self, weights):
+        new_scale = choose_scale(weights, 0.01)
+        values = quantize_int4(weights, 0.01, new_scale)
+        assert all(-7 <= v <= 7 for v in values)
+        assert all(v == 0 for w, v in zip(weights, values) if w == 0)
+
+    def test_halves_the_packed_layers(self):
+        assert weight_bytes(PACKED) * 2 == weight_bytes(DEPLOYED)
+        assert PACKED.tensors[CONV1_FILTER] == DEPLOYED.tensors[CONV1_FILTER]
+        for filter_index, bias_index, input_index in PACKED_LAYERS:
+            t = PACKED.tensors
+            assert t[filter_index].type == "Int4"
+            assert abs(t[bias_index].scale - t[input_index].scale * t[filter_index].scale) < 1e-9
+
+
+class TestRewrite:
+    def test_parses_back(self):
+        rewritten = parse_compiled_model(rewrite_model(SOURCE, PACKED))
+        assert rewritten.tensors == PACKED.tensors
+        assert rewritten.structure == DEPLOYED.structure
+
+    @given(seed=st.integers(min_value=1, max_value=0xFFFFFFFF))
+    @settings(max_examples=5)
+    def test_logits_stay_close(self, seed):
+        window = self_test_window(72, seed)
+        before, after = reference_logits(DEPLOYED, window), reference_logits(PACKED, window)
+        # 4-bit weights move the FC output by a few of its 256 quantization steps, not across its range
+        assert max(abs(a - b) for a, b in zip(before, after)) <= 24
+
+    def test_ota_blob_carries_packed_bytes(self):
+        entries = parse_blob(build_blob(PACKED, PACKED))
+        for filter_index, _, _ in PACKED_LAYERS:
+            flags, tensor_type, data, _, _ = entries[filter_index]
+            assert tensor_type == 18 and len(data) == PACKED.tensors[filter_index].bytes
+        try:
+            build_blob(PACKED, DEPLOYED)
+            assert False, "an int8 firmware must reject int4 weights"
+        except ValueError:
+            pass
@@ -0,0 +1,82 @@
+import os
+import sys
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from hypothesis import given, strategies as st, settings
+from joint_fusion import JointFusion
+
+LEFT, RIGHT = "AA:00", "BB:00"
+
+
+class Clock:
+    def __init__(self):
+        self.now = 100.0
+
+    def __call__(self):
+        return self.now
+
+
+def make(patterns=None, **kwargs):
+    clock = Clock()
+    fusion = JointFusion(patterns or {"zoom": ("out", "out")}, window_s=0.15, reorder_s=0.05, clock=clock, **kwargs)
+    decided = []
+    fusion.set_gesture_callback(lambda gesture, confidence: decided.append((gesture, round(confidence, 3))))
+    return fusion, clock, decided
+
+
+class TestJointFusion:
+    def test_both_hands_within_the_window_fire_at_once(self):
+        fusion, clock, decided = make()
+        fusion.feed(LEFT, "out", 0.9, 99.98)
+        assert decided == [] and fusion.held() == 1
+        # The right hand was published 100 ms later but arrives first: order does not matter
+        fusion.feed(RIGHT, "out", 0.8, 99.88)
+        assert decided == [("zoom", 0.8)] and fusion.held() == 0
+
+    def test_same_device_twice_is_not_a_joint_gesture(self):
+        fusion, clock, decided = make()
+        fusion.feed(LEFT, "out", 0.9, 99.98)
+        fusion.feed(LEFT, "out", 0.7, 99.99)
+        assert decided == [("out", 0.9)] and fusion.held() == 1
+
+    def test_too_far_apart_passes_both_on_alone(self):
+        fusion, clock, decided = make()
+        clock.now = 99.87
+        fusion.feed(LEFT, "out", 0.9, 99.70)
+        fusion.feed(RIGHT, "out", 0.8, 99.86)
+        assert decided == []
+        # The first one's wait (window + reorder) is over at 99.90
+        clock.now = 99.95
+        assert abs(fusion.poll() - 100.06) < 1e-9
+        assert decided == [("out", 0.9)]
+        clock.now = 100.2
+        assert fusion.poll() is None
+        assert decided == [("out", 0.9), ("out", 0.8)]
+
+    def test_gestures_in_no_pattern_pass_straight_through(self):
+        fusion, clock, decided = make()
+        fusion.feed(LEFT, "left", 0.9, 99.99)
+        assert decided == [("left", 0.9)] and fusion.held() == 0
+
+    def test_mixed_pattern_and_capacity(self):
+        fusion, clock, decided = make({"rotate": ("left", "right")}, capacity=2)
+        fusion.feed(LEFT, "left", 0.9, 99.99)
+        fusion.feed(RIGHT, "right", 0.6, 100.0)
+        assert decided == [("rotate", 0.6)]
+        fusion.feed(LEFT, "left", 0.9, 99.99)
+        fusion.feed("CC:00", "left", 0.8, 99.995)
+        fusion.feed("DD:00", "left", 0.7, 99.999)
+        # Three held with room for two: the oldest goes on alone
+        assert decided[1:] == [("left", 0.9)] and fusion.held() == 2
+
+    @given(times=st.lists(st.tuples(st.sampled_from([LEFT, RIGHT, "CC:00"]), st.floats(99.0, 100.0)), max_size=30))
+    @settings(max_examples=100)
+    def test_every_event_is_decided_once(self, times):
+        fusion, clock, decided = make()
+        for address, time_s in times:
+            fusion.feed(address, "out", 1.0, time_s)
+        clock.now = 200.0
+        fusion.poll()
+        joint = sum(1 for gesture, _ in decided if gesture == "zoom")
+        assert 2 * joint + (len(decided) - joint) == len(times)
+        assert fusion.held() == 0
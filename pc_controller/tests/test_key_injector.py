@@ -0,0 +1,96 @@
+import os
+import sys
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from hypothesis import given, strategies as st, settings
+from pynput.keyboard import Key, KeyCode
+from gesture_handler import GestureHandler
+from config_manager import ConfigManager
+from key_injector import (KEYEVENTF_EXTENDEDKEY, KEYEVENTF_KEYUP, KEYEVENTF_UNICODE, Macro, PynputInjector,
+                          chord_events, create_injector, keyboard_inputs)
+
+modifier_names = st.lists(st.sampled_from(["ctrl", "alt", "shift", "win"]), unique=True, max_size=3)
+key_names = st.sampled_from(["a", "x", "up", "f5", "space", "delete"])
+
+
+def us_layout(char):
+    return -1 if char == "é" else ord(char.upper()) | (0x100 if char.isupper() else 0)
+
+
+class RecordingInjector:
+    name = "recording"
+
+    def __init__(self):
+        self.batches = []
+
+    def send(self, events):
+        self.batches.append(list(events))
+        return True
+
+
+class TestChordEvents:
+    @given(modifiers=modifier_names, key=key_names)
+    @settings(max_examples=50)
+    def test_modifiers_wrap_the_key(self, modifiers, key):
+        handler = GestureHandler(ConfigManager(), RecordingInjector())
+        mods, main_key = handler.parse_shortcut("+".join(modifiers + [key]))
+        events = chord_events(mods, main_key)
+        assert events == [(m, True) for m in mods] + [(main_key, True), (main_key, False)] + \
+            [(m, False) for m in reversed(mods)]
+
+    def test_macro_is_every_chord_in_order(self):
+        a, c = KeyCode.from_char("a"), KeyCode.from_char("c")
+        macro = Macro((((Key.ctrl_l,), a), ((Key.ctrl_l,), c)))
+        assert chord_events([], macro) == [(Key.ctrl_l, True), (a, True), (a, False), (Key.ctrl_l, False),
+                                           (Key.ctrl_l, True), (c, True), (c, False), (Key.ctrl_l, False)]
+
+
+class TestKeyboardInputs:
+    def test_virtual_keys_scan_codes_and_flags(self):
+        events = [(Key.ctrl_l, True), (KeyCode.from_char("x"), True), (KeyCode.from_char("x"), False),
+                  (Key.up, True), (Key.up, False), (Key.ctrl_l, False)]
+        inputs = keyboard_inputs(events, us_layout, lambda vk: vk + 0x1000)
+        assert inputs == [(0xA2, 0x10A2, 0), (0x58, 0x1058, 0), (0x58, 0x1058, KEYEVENTF_KEYUP),
+                          (0x26, 0x1026, KEYEVENTF_EXTENDEDKEY),
+                          (0x26, 0x1026, KEYEVENTF_EXTENDEDKEY | KEYEVENTF_KEYUP), (0xA2, 0x10A2, KEYEVENTF_KEYUP)]
+
+    def test_characters_without_a_key_are_unicode(self):
+        key = KeyCode.from_char("é")
+        inputs = keyboard_inputs([(key, True), (key, False)], us_layout, lambda vk: 0)
+        assert inputs == [(0, ord("é"), KEYEVENTF_UNICODE), (0, ord("é"), KEYEVENTF_UNICODE | KEYEVENTF_KEYUP)]
+
+    def test_shift_state_is_dropped(self):
+        assert keyboard_inputs([(KeyCode.from_char("A"), True)], us_layout, lambda vk: 0) == [(0x41, 0, 0)]
+
+    def test_unknown_key(self):
+        try:
+            keyboard_inputs([(Key.media_play_pause, True)], us_layout, lambda vk: 0)
+            assert False, "expected ValueError"
+        except ValueError:
+            pass
+
+
+class TestBackends:
+    def test_pynput_off_windows(self):
+        if sys.platform != "win32":
+            assert isinstance(create_injector(), PynputInjector)
+        assert create_injector("pynput").name == "pynput"
+
+    def test_unknown_backend(self):
+        try:
+            create_injector("xdotool")
+            assert False, "expected ValueError"
+        except ValueError:
+            pass
+
+    def test_one_batch_per_action(self):
+        config = ConfigManager()
+        config.set_gesture_shortcuts({"left": "ctrl+a, ctrl+c, alt+tab", "right": "ctrl+shift+x"})
+        injector = RecordingInjector()
+        handler = GestureHandler(config, injector)
+        assert handler.process_gesture("left", 0.9) == "ctrl+a, ctrl+c, alt+tab"
+        handler.close()
+        assert len(injector.batches) == 1 and len(injector.batches[0]) == 12
+        stats = handler.action_stats()
+        assert stats.backend == "recording" and stats.call_p50_ms is not None
+        assert stats.call_max_ms <= stats.max_ms
@@ -0,0 +1,52 @@
+import os
+import sys
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from hypothesis import given, strategies as st, settings
+from l2cap_channel import (RECORD_HELLO, RECORD_MAX, _sockaddr, encode_hello, encode_records, iter_records,
+                           parse_bulk_info, parse_hello)
+
+records = st.lists(st.tuples(st.integers(0, 255), st.binary(max_size=RECORD_MAX)), max_size=20)
+
+
+class TestRecords:
+    @given(records=records, mtu=st.integers(2 + RECORD_MAX, 1024))
+    @settings(max_examples=100)
+    def test_round_trip_in_order(self, records, mtu):
+        sdus = encode_records(records, mtu)
+        assert all(len(sdu) <= mtu for sdu in sdus)
+        assert [r for sdu in sdus for r in iter_records(sdu)] == records
+
+    @given(records=records)
+    @settings(max_examples=50)
+    def test_sdus_are_filled(self, records):
+        # An SDU is only ended when the next record does not fit
+        sdus = encode_records(records, 512)
+        for sdu, following in zip(sdus, sdus[1:]):
+            first = next(iter_records(following))
+            assert len(sdu) + 2 + len(first[1]) > 512
+
+    def test_truncated_record_is_dropped(self):
+        assert list(iter_records(bytes([0x1F, 3, 1, 2, 3, 0x30, 4, 1]))) == [(0x1F, bytes([1, 2, 3]))]
+
+    def test_oversized_record_is_refused(self):
+        try:
+            encode_records([(0x23, bytes(100))], 64)
+        except ValueError:
+            pass
+        else:
+            assert False, "expected the record to be refused"
+
+
+class TestHandshake:
+    def test_bulk_info_and_hello(self):
+        assert parse_bulk_info(bytes([0x81, 0x00, 0x00, 0x02, 0x01])) == (0x0081, 512, 1)
+        assert parse_bulk_info(b"\x81") is None
+        assert encode_hello(0x124) == (RECORD_HELLO, bytes([0x24]))
+        assert parse_hello(bytes([0x04, 1, 2])) == (0x04, 1, 2)
+        assert parse_hello(bytes([0x04, 1])) == (0x04, 1, None)
+
+    def test_address_is_little_endian(self):
+        addr = _sockaddr("C0:11:22:33:44:55", 0x0081, 2)
+        assert bytes(addr.l2_bdaddr) == bytes([0x55, 0x44, 0x33, 0x22, 0x11, 0xC0])
+        assert addr.l2_bdaddr_type == 2
@@ -0,0 +1,52 @@
+import os
+import re
+import sys
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from hypothesis import given, strategies as st, settings
+import label_table_gen
+from label_table_gen import KIND_GESTURE, KIND_IDLE, format_header, format_module, label_table, parse_categories
+
+name_st = st.text(alphabet="abcdefghijklmnopqrstuvwxyz", min_size=1, max_size=8)
+
+MODEL_VARIABLES = '''
+const char* ei_classifier_inferencing_categories_1_2[] = { "a", "b" };
+const char* ei_classifier_inferencing_categories_792000_9[] = { "down", "idle", "left", "right", "up" };
+constexpr auto& ei_classifier_inferencing_categories = ei_classifier_inferencing_categories_792000_9;
+'''
+
+
+class TestParse:
+    def test_follows_the_default_impulse_alias(self):
+        assert parse_categories(MODEL_VARIABLES) == ["down", "idle", "left", "right", "up"]
+
+    def test_repository_header_and_module_are_current(self):
+        assert label_table_gen.main(["--check"]) == 0
+
+
+class TestTable:
+    @given(names=st.lists(name_st, min_size=1, max_size=8, unique=True))
+    @settings(max_examples=50)
+    def test_header_enumerates_every_class_in_order(self, names):
+        text = format_header(label_table(names))
+        assert f"GESTURE_LABEL_COUNT = {len(names)}" in text
+        entries = re.findall(r'\{"(\w+)", (GESTURE_KIND_\w+), (\d+), (\d+), (\d+)\}', text)
+        assert [e[0] for e in entries] == names
+        for i, name in enumerate(names):
+            assert f"GESTURE_LABEL_{name.upper()} = {i}," in text
+
+    @given(names=st.lists(name_st, min_size=1, max_size=8, unique=True))
+    @settings(max_examples=50)
+    def test_module_lists_gestures_without_idle(self, names):
+        table = label_table(names)
+        namespace = {}
+        exec(format_module(table), namespace)
+        assert list(namespace["MODEL_LABELS"]) == names
+        assert list(namespace["GESTURE_LABELS"]) == [n for n in names if n not in ("idle", "unknown")]
+
+    def test_known_colours_and_kinds(self):
+        table = {label.name: label for label in label_table(["down", "idle", "circle"])}
+        assert table["idle"].kind == KIND_IDLE and table["idle"].colour == (255, 0, 0)
+        assert table["down"].colour == (255, 255, 0)
+        assert table["circle"].kind == KIND_GESTURE
+        assert table["circle"].colour not in (table["idle"].colour, table["down"].colour)
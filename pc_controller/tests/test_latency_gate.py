@@ -0,0 +1,70 @@
+import os
+import sys
+import tempfile
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from hypothesis import given, strategies as st, settings
+from latency_gate import GateMetrics, compare, corpus_digest, load_baseline, metrics_from_runs, save_baseline
+
+BASELINE = GateMetrics(latency_p50_us=20000, latency_p99_us=30000, ram_high_water=100000, flash_bytes=400000)
+
+
+def board_output(latencies, high_water=100000):
+    lines = [f"result,{i * 8},left,0.9,1800,{latency}" for i, latency in enumerate(latencies)]
+    lines += ["summary,1,400,48,1000000,900", f"memory,{high_water},60000", "stage,infer,10,100,200,5"]
+    return "\n".join(lines)
+
+
+class TestMetrics:
+    def test_all_runs_count(self):
+        metrics = metrics_from_runs([board_output([10, 20, 30]), board_output([40], high_water=120000)], 500)
+        assert metrics.windows == 4 and metrics.latency_p50_us == 20 and metrics.latency_p99_us == 40
+        assert metrics.ram_high_water == 120000 and metrics.flash_bytes == 500
+
+    def test_old_firmware_without_memory_line(self):
+        try:
+            metrics_from_runs([board_output([10]).replace("memory,", "other,")], 0)
+        except ValueError:
+            return
+        assert False, "expected ValueError"
+
+
+class TestCompare:
+    def test_within_tolerance_passes(self):
+        current = GateMetrics(21000, 32000, 101000, 404000)
+        assert compare(BASELINE, current, 0.10, 0.02) == []
+
+    def test_each_regression_is_reported(self):
+        current = GateMetrics(23000, 30000, 110000, 400000)
+        failures = compare(BASELINE, current, 0.10, 0.02)
+        assert len(failures) == 2
+        assert failures[0].startswith("latency p50") and failures[1].startswith("RAM high-water")
+
+    @given(scale=st.floats(min_value=0.1, max_value=1.0))
+    @settings(max_examples=50)
+    def test_faster_or_smaller_never_fails(self, scale):
+        current = GateMetrics(BASELINE.latency_p50_us * scale, BASELINE.latency_p99_us * scale,
+                              int(BASELINE.ram_high_water * scale), int(BASELINE.flash_bytes * scale))
+        assert compare(BASELINE, current, 0.0, 0.0) == []
+
+
+class TestBaseline:
+    def test_round_trip(self):
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, "gate.json")
+            save_baseline(path, "nano33ble", "abc", 3, BASELINE)
+            data = load_baseline(path)
+            assert data["metrics"] == BASELINE and data["corpus"] == "abc" and data["recordings"] == 3
+
+    def test_digest_ignores_order_but_not_content(self):
+        with tempfile.TemporaryDirectory() as tmp:
+            paths = []
+            for name, body in (("left.01.csv", "a"), ("right.01.csv", "b")):
+                paths.append(os.path.join(tmp, name))
+                with open(paths[-1], "w") as f:
+                    f.write(body)
+            digest = corpus_digest(paths)
+            assert corpus_digest(list(reversed(paths))) == digest
+            with open(paths[0], "w") as f:
+                f.write("changed")
+            assert corpus_digest(paths) != digest
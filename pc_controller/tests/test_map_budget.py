@@ -0,0 +1,123 @@
+import os
+import sys
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from hypothesis import given, strategies as st, settings
+from map_budget import Budget, analyze, check_budgets, demangle, module_of, parse_budgets
+
+BUILD = ".pio/build/nano33ble"
+
+# Trimmed arm-none-eabi-ld map: a discarded section, one-line and split input sections,
+# initialised data with a flash load address, and bss
+MAP = f'''Archive member included to satisfy reference by file (symbol)
+
+Discarded input sections
+
+ .text._Z6unusedv
+                0x0000000000000000       0x40 {BUILD}/src/led_module.cpp.o
+
+Memory Configuration
+
+Name             Origin             Length             Attributes
+FLASH            0x0000000000010000 0x00000000000f0000 xr
+RAM              0x0000000020000000 0x0000000000040000 xrw
+*default*        0x0000000000000000 0xffffffffffffffff
+
+Linker script and memory map
+
+LOAD {BUILD}/src/inference_module.cpp.o
+
+.text           0x0000000000010000     0x1000
+ *(.text*)
+ .text._Z14inference_taskv
+                0x0000000000010000      0x200 {BUILD}/src/inference_module.cpp.o
+                0x0000000000010000                _Z14inference_taskv
+ .text._ZN6tflite3ops5micro8Register_CONV_2DEv
+                0x0000000000010200      0x300 {BUILD}/lib6f4/a5-deminsion_inferencing/edge-impulse-sdk/tensorflow/lite/micro/kernels/conv.cpp.o
+ .text.arm_convolve_s8
+                0x0000000000010500      0x100 {BUILD}/lib6f4/a5-deminsion_inferencing/edge-impulse-sdk/CMSIS/NN/Source/arm_convolve_s8.c.o
+ *fill*         0x0000000000010600        0x4
+ .rodata.tensor_data0
+                0x0000000000010604      0x800 {BUILD}/lib6f4/a5-deminsion_inferencing/tflite-model/tflite_learn_792000_36_compiled.cpp.o
+ .rodata.tensor_data1
+                0x0000000000010e04       0x10 {BUILD}/lib6f4/a5-deminsion_inferencing/tflite-model/tflite_learn_792000_36_compiled.cpp.o
+ .rodata.str1.4
+                0x0000000000010e14       0x40 {BUILD}/src/ble_module.cpp.o
+
+.data           0x0000000020000000       0x20 load address 0x0000000000011000
+ .data._ZL10g_led_mode
+                0x0000000020000000       0x20 {BUILD}/src/led_module.cpp.o
+
+.bss            0x0000000020000020     0x1500
+ .bss.tensor_arena
+                0x0000000020000020      0xa90 {BUILD}/lib6f4/a5-deminsion_inferencing/tflite-model/tflite_learn_792000_36_compiled.cpp.o
+ .bss._ZZ9ei_printfPKczE9print_buf
+                0x0000000020000ab0      0x400 {BUILD}/lib6f4/a5-deminsion_inferencing/edge-impulse-sdk/porting/arduino/ei_classifier_porting.cpp.o
+ .bss           0x0000000020000eb0      0x100 {BUILD}/src/ble_module.cpp.o
+
+.debug_info     0x0000000000000000    0x12345
+ .debug_info    0x0000000000000000    0x12345 {BUILD}/src/inference_module.cpp.o
+'''
+
+
+class TestAnalyze:
+    def test_modules(self):
+        report = analyze(MAP)
+        modules = {name: (usage.flash, usage.ram) for name, usage in report.modules.items()}
+        assert modules == {
+            "inference_module": (0x200, 0),
+            "edge-impulse-sdk/tensorflow": (0x300, 0),
+            "CMSIS": (0x100, 0),
+            "tflite-model": (0x810, 0xa90),
+            "ble_module": (0x40, 0x100),
+            "led_module": (0x20, 0x20),  # initialised data: RAM plus its flash copy; the discarded text is ignored
+            "edge-impulse-sdk": (0, 0x400),
+        }
+        assert (report.total.flash, report.total.ram) == (0xe70, 0xfb0)
+
+    def test_symbols(self):
+        report = analyze(MAP)
+        assert report.symbols["tensor_arena"].usage.ram == 0xa90
+        assert report.symbols["tensor_arena"].module == "tflite-model"
+        assert report.symbols["ei_printf::print_buf"].usage.ram == 0x400
+        assert report.symbols["inference_task"].usage.flash == 0x200
+        assert report.symbols["g_led_mode"].usage.flash == 0x20
+        assert not any(name.startswith("str1") for name in report.symbols)
+
+    def test_budgets(self):
+        report = analyze(MAP)
+        budgets = parse_budgets(["# limits", "tflite-model flash 0x810", "sym:tensor_data* flash 2048",
+                                 "total ram 4000", "", "record_module ram 0"])
+        violations = check_budgets(report, budgets)
+        assert len(violations) == 2
+        assert violations[0].startswith("sym:tensor_data* uses 2064 B of flash")
+        assert violations[1].startswith("total uses 4016 B of ram")
+
+
+class TestBudgetLines:
+    @given(name=st.text(alphabet="abcdefghijklmnopqrstuvwxyz_-", min_size=1, max_size=12),
+           memory=st.sampled_from(["flash", "ram"]), limit=st.integers(min_value=0, max_value=1 << 20))
+    @settings(max_examples=50)
+    def test_round_trip(self, name, memory, limit):
+        assert parse_budgets([f"  {name} {memory} {limit}  # note"]) == [Budget(name, memory, limit)]
+
+    def test_rejects_unknown_memory(self):
+        try:
+            parse_budgets(["ble_module eeprom 10"])
+        except ValueError:
+            return
+        assert False, "expected ValueError"
+
+
+class TestAttribution:
+    def test_sources_group_by_file(self):
+        assert module_of(f"{BUILD}/src/thread_module.cpp.o") == "thread_module"
+        assert module_of("/home/u/.platformio/lib/libArduinoBLE.a(HCI.cpp.o)") == "ArduinoBLE"
+        assert module_of("/opt/toolchain/arm-none-eabi/lib/thumb/v7e-m/libc_nano.a(lib_a-memcpy.o)") == "libc"
+        assert module_of("startup.o") == "other"
+
+    def test_demangle(self):
+        assert demangle("_ZN4mbed6Ticker6attachEv") == "mbed::Ticker::attach"
+        assert demangle("_ZL10g_led_mode") == "g_led_mode"
+        assert demangle("_ZZ9ei_printfPKczE9print_buf") == "ei_printf::print_buf"
+        assert demangle("tensor_arena") == "tensor_arena"
@@ -0,0 +1,174 @@
+import copy
+import os
+import struct
+import sys
+import zlib
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from hypothesis import given, strategies as st, settings
+from ble_manager import MODEL_STATUS, NO_MODEL_SLOT, encode_model_start, model_chunks, parse_model_status
+from model_ota import (BLOB_CRC_OFFSET, BLOB_ENTRY, BLOB_FORMAT, BLOB_FORMAT_FLATBUFFER, BLOB_HEADER, BLOB_MAGIC,
+                       DEPLOYED_MODEL, FC_OUTPUT, FC_WEIGHTS, FLATBUFFER, FLATBUFFER_ALIGN, HAS_DATA, HAS_QUANT,
+                       INTERPRETER_SLOT_BYTES, SLOT_BYTES, TEST_INPUT, TEST_LOGITS, build_blob, build_tflite_blob,
+                       load_compiled_model, multiply_by_quantized_multiplier, parse_blob, quantize_multiplier,
+                       reference_logits, self_test_window)
+
+DEPLOYED = load_compiled_model(DEPLOYED_MODEL)
+
+
+class TestCompiledModel:
+    def test_deployed_graph(self):
+        tensors = DEPLOYED.tensors
+        assert len(tensors) == 20
+        assert tensors[0].dims == (1, 72) and tensors[0].zero_point == -1
+        assert tensors[FC_WEIGHTS].dims == (5, 360) and len(tensors[FC_WEIGHTS].data) == 1800
+        assert tensors[FC_OUTPUT].scale is not None and tensors[FC_OUTPUT].data is None
+        # shape tensors of the reshape ops have data but no quantization
+        assert tensors[1].constant and tensors[1].scale is None
+
+    def test_window_matches_firmware_lcg(self):
+        seed = 0x12345678
+        seed = (seed * 1664525 + 1013904223) & 0xFFFFFFFF
+        assert self_test_window(1)[0] == struct.unpack('<b', bytes([seed >> 24]))[0]
+
+
+class TestRequantize:
+    @given(real=st.floats(min_value=1e-6, max_value=0.99))
+    @settings(max_examples=200)
+    def test_multiplier_represents_scale(self, real):
+        multiplier, shift = quantize_multiplier(real)
+        assert (1 << 30) <= multiplier < (1 << 31)
+        assert abs(multiplier * 2.0 ** (shift - 31) - real) <= real * 2 ** -30
+
+    @given(acc=st.integers(min_value=-(1 << 24), max_value=1 << 24), real=st.floats(min_value=1e-5, max_value=0.99))
+    @settings(max_examples=200)
+    def test_close_to_real_product(self, acc, real):
+        multiplier, shift = quantize_multiplier(real)
+        assert abs(multiply_by_quantized_multiplier(acc, multiplier, shift) - acc * real) <= 1.0
+
+    def test_logits_in_range(self):
+        logits = reference_logits(DEPLOYED, self_test_window(72))
+        assert len(logits) == 5 and all(-128 <= v <= 127 for v in logits)
+
+
+class TestBlob:
+    def test_round_trip(self):
+        blob = build_blob(DEPLOYED, DEPLOYED, version=7)
+        assert len(blob) <= SLOT_BYTES and len(blob) % 4 == 0
+        magic, _, _, total, crc, version = BLOB_HEADER.unpack_from(blob)
+        assert (magic, total, version) == (BLOB_MAGIC, len(blob), 7)
+        assert crc == zlib.crc32(blob[BLOB_CRC_OFFSET:]) & 0xFFFFFFFF
+        entries = parse_blob(blob)
+        flags, _, data, scale, zero_point = entries[FC_WEIGHTS]
+        assert flags == HAS_DATA | HAS_QUANT
+        assert list(struct.unpack('<1800b', data)) == DEPLOYED.tensors[FC_WEIGHTS].data
+        assert entries[FC_OUTPUT][0] == HAS_QUANT and entries[FC_OUTPUT][2] == b""
+        assert 1 not in entries  # unquantized shape tensor stays built in
+        assert list(struct.unpack('<72b', entries[TEST_INPUT][2])) == self_test_window(72)
+        assert list(struct.unpack('<5b', entries[TEST_LOGITS][2])) == reference_logits(DEPLOYED, self_test_window(72))
+
+    def test_data_offsets_aligned(self):
+        blob = build_blob(DEPLOYED, DEPLOYED)
+        for i in range(BLOB_HEADER.unpack_from(blob)[2]):
+            _, flags, _, offset, size, _, _ = BLOB_ENTRY.unpack_from(blob, BLOB_HEADER.size + i * BLOB_ENTRY.size)
+            assert offset % 4 == 0 and (size > 0) == bool(flags & HAS_DATA)
+            assert offset + size <= len(blob)
+
+    def test_corruption_detected(self):
+        blob = bytearray(build_blob(DEPLOYED, DEPLOYED))
+        blob[-1] ^= 0x01
+        try:
+            parse_blob(bytes(blob))
+        except ValueError:
+            return
+        assert False, "expected ValueError"
+
+    def test_new_weights_change_self_test(self):
+        retrained = copy.deepcopy(DEPLOYED)
+        retrained.tensors[FC_WEIGHTS].data = [-v for v in retrained.tensors[FC_WEIGHTS].data]
+        entries = parse_blob(build_blob(retrained, DEPLOYED))
+        assert entries[TEST_LOGITS][2] != parse_blob(build_blob(DEPLOYED, DEPLOYED))[TEST_LOGITS][2]
+
+    def test_graph_change_rejected(self):
+        changed = copy.deepcopy(DEPLOYED)
+        changed.tensors[FC_WEIGHTS].dims = (6, 300)
+        try:
+            build_blob(changed, DEPLOYED)
+        except ValueError:
+            return
+        assert False, "expected ValueError"
+
+
+
+def fake_flatbuffer(payload: bytes) -> bytes:
+    """Root table offset + TFL3 identifier: enough for the host side, the device verifies the rest."""
+    return struct.pack('<I', 0x1C) + b"TFL3" + payload
+
+
+class TestFlatbufferBlob:
+    @given(payload=st.binary(min_size=0, max_size=6000), version=st.integers(min_value=0, max_value=0xFFFFFFFF))
+    @settings(max_examples=100)
+    def test_round_trip(self, payload, version):
+        flatbuffer = fake_flatbuffer(payload)
+        window, output = self_test_window(72), list(range(-2, 3))
+        blob = build_tflite_blob(flatbuffer, window, output, version)
+        assert len(blob) <= INTERPRETER_SLOT_BYTES and len(blob) % 4 == 0
+        _, fmt, count, total, _, parsed_version = BLOB_HEADER.unpack_from(blob)
+        assert (fmt, count, total, parsed_version) == (BLOB_FORMAT_FLATBUFFER, 3, len(blob), version)
+        entries = parse_blob(blob)
+        assert entries[FLATBUFFER][2] == flatbuffer
+        assert list(struct.unpack('<72b', entries[TEST_INPUT][2])) == window
+        assert list(struct.unpack('<5b', entries[TEST_LOGITS][2])) == output
+
+    def test_flatbuffer_aligned_for_interpreter(self):
+        blob = build_tflite_blob(fake_flatbuffer(b"\x00" * 13), self_test_window(72), [0] * 5)
+        for i in range(3):
+            tensor, flags, _, offset, size, _, _ = BLOB_ENTRY.unpack_from(blob, BLOB_HEADER.size + i * BLOB_ENTRY.size)
+            assert flags == HAS_DATA and offset % 4 == 0 and offset + size <= len(blob)
+            if tensor == FLATBUFFER:
+                assert offset % FLATBUFFER_ALIGN == 0
+
+    def test_weights_blob_keeps_format_1(self):
+        assert BLOB_HEADER.unpack_from(build_blob(DEPLOYED, DEPLOYED))[1] == BLOB_FORMAT
+
+    def test_not_a_flatbuffer_rejected(self):
+        try:
+            build_tflite_blob(b"\x1c\x00\x00\x00TFL2" + b"\x00" * 64, self_test_window(72), [0] * 5)
+        except ValueError:
+            return
+        assert False, "expected ValueError"
+
+    def test_oversized_rejected(self):
+        try:
+            build_tflite_blob(fake_flatbuffer(b"\x00" * INTERPRETER_SLOT_BYTES), self_test_window(72), [0] * 5)
+        except ValueError:
+            return
+        assert False, "expected ValueError"
+
+
+class TestModelTransport:
+    @given(length=st.integers(min_value=1, max_value=SLOT_BYTES), chunk=st.integers(min_value=1, max_value=244),
+           start=st.integers(min_value=0, max_value=64))
+    @settings(max_examples=100)
+    def test_chunks_reassemble(self, length, chunk, start):
+        blob = bytes(i & 0xFF for i in range(length))
+        start = min(start * 4, length)
+        rebuilt = bytearray(blob[:start])
+        for write in model_chunks(blob, chunk, start):
+            offset = struct.unpack_from('<I', write)[0]
+            assert offset == len(rebuilt) and offset % 4 == 0
+            rebuilt += write[4:]
+        assert bytes(rebuilt) == blob
+
+    @given(state=st.integers(min_value=0, max_value=3), error=st.integers(min_value=0, max_value=8),
+           slot=st.sampled_from([0, 1, NO_MODEL_SLOT]), received=st.integers(min_value=0, max_value=0xFFFFFFFF),
+           version=st.integers(min_value=0, max_value=0xFFFFFFFF))
+    @settings(max_examples=100)
+    def test_status(self, state, error, slot, received, version):
+        status = parse_model_status(MODEL_STATUS.pack(state, error, slot, received, SLOT_BYTES, version))
+        assert status.slot == (None if slot == NO_MODEL_SLOT else slot)
+        assert (status.received, status.total, status.version) == (received, SLOT_BYTES, version)
+        assert parse_model_status(b"\x00" * (MODEL_STATUS.size - 1)) is None
+
+    def test_start_command(self):
+        assert encode_model_start(2468, 0xDEADBEEF) == bytes([1, 0, 0, 0]) + struct.pack('<II', 2468, 0xDEADBEEF)
@@ -0,0 +1,74 @@
+import os
+import re
+import sys
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from hypothesis import given, strategies as st, settings
+from novelty_trainer import cluster_radii, format_header, is_novel, kmeans, nearest, upper_quantile
+from replay_runner import parse_output
+
+int8_st = st.integers(min_value=-128, max_value=127)
+points_st = st.lists(st.lists(int8_st, min_size=6, max_size=6), min_size=1, max_size=40)
+
+
+class TestKmeans:
+    @given(points=points_st, clusters=st.integers(min_value=1, max_value=6))
+    @settings(max_examples=50)
+    def test_centroids_are_int8_and_bounded(self, points, clusters):
+        centroids = kmeans(points, clusters)
+        assert 1 <= len(centroids) <= min(clusters, len(points))
+        assert all(len(c) == 6 and all(-128 <= v <= 127 for v in c) for c in centroids)
+
+    def test_separates_two_blobs(self):
+        points = [[-100 + i % 3] * 4 for i in range(20)] + [[100 - i % 3] * 4 for i in range(20)]
+        centroids = kmeans(points, 2)
+        assert sorted(c[0] for c in centroids) == [-99, 99]
+
+    def test_nearest_prefers_lowest_index_on_tie(self):
+        assert nearest([0, 0], [[1, 0], [-1, 0]]) == 0
+
+
+class TestRadii:
+    @given(points=points_st, clusters=st.integers(min_value=1, max_value=4),
+           reject_rate=st.floats(min_value=0.0, max_value=0.5))
+    @settings(max_examples=50)
+    def test_rejects_at_most_reject_rate_of_training(self, points, clusters, reject_rate):
+        centroids = kmeans(points, clusters)
+        radii = cluster_radii(points, centroids, reject_rate, margin=1.0)
+        rejected = sum(1 for p in points if is_novel(p, centroids, radii))
+        # the quantile is taken per cluster, so the bound holds cluster by cluster and in total
+        assert rejected <= reject_rate * len(points) + len(centroids)
+
+    def test_zero_reject_rate_accepts_all_training_windows(self):
+        points = [[i, -i, 2 * i] for i in range(-20, 20)]
+        centroids = kmeans(points, 3)
+        radii = cluster_radii(points, centroids, 0.0, margin=1.0)
+        assert not any(is_novel(p, centroids, radii) for p in points)
+        assert is_novel([127, -128, 127], centroids, radii)
+
+    def test_upper_quantile(self):
+        assert upper_quantile([1, 2, 3, 4], 0.0) == 4
+        assert upper_quantile([1, 2, 3, 4], 0.25) == 3
+
+
+class TestHeader:
+    def test_table_sizes_match_defines(self):
+        centroids = [[1] * 360, [-2] * 360]
+        text = format_header(centroids, [10, 20])
+        assert "#define NOVELTY_MODEL_CLUSTERS 2" in text
+        body = text.split("kNoveltyCentroids", 1)[1].split("};", 1)[0].split("{", 1)[1]
+        assert len(re.findall(r"-?\d+", body)) == 720
+        assert "kNoveltyRadii[2] = {10, 20};" in text
+
+    def test_empty_model_keeps_placeholder_tables(self):
+        text = format_header([], [])
+        assert "#define NOVELTY_MODEL_CLUSTERS 0" in text and "kNoveltyRadii[1] = {0};" in text
+
+
+class TestFeatureLines:
+    @given(values=st.lists(int8_st, min_size=1, max_size=360), frame=st.integers(min_value=0, max_value=10**6))
+    @settings(max_examples=50)
+    def test_round_trip(self, values, frame):
+        line = f"features,{frame}," + "".join(f"{v & 0xff:02x}" for v in values)
+        parsed = parse_output("left.csv", line + "\n")
+        assert parsed.features == [(frame, values)]
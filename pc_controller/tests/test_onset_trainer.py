@@ -0,0 +1,100 @@
+import os
+import re
+import sys
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+import math
+
+from hypothesis import given, strategies as st, settings
+from onset_trainer import (OnsetStats, fold_head, format_header, head_decision, onset_targets, prefix_features,
+                           simulate)
+from early_exit_trainer import train_softmax
+
+values = st.floats(min_value=-4.0, max_value=4.0, allow_nan=False)
+frames_st = st.lists(st.lists(values, min_size=3, max_size=3), min_size=2, max_size=30)
+IDLE = 1
+
+
+class TestPrefixFeatures:
+    @given(frames=frames_st, prefix=st.integers(min_value=2, max_value=30))
+    @settings(max_examples=50)
+    def test_mean_and_std_of_the_newest_frames(self, frames, prefix):
+        features = prefix_features(frames, len(frames), prefix)
+        if prefix > len(frames):
+            assert features is None
+            return
+        window = frames[-prefix:]
+        for a in range(3):
+            column = [f[a] for f in window]
+            mean = sum(column) / prefix
+            assert math.isclose(features[a], mean, abs_tol=1e-9)
+            std = math.sqrt(sum((v - mean) ** 2 for v in column) / prefix)
+            assert math.isclose(features[3 + a], std, rel_tol=1e-6, abs_tol=1e-6)
+
+    def test_ignores_frames_after_the_end(self):
+        frames = [[0.0, 0.0, 1.0]] * 10 + [[3.0, 3.0, 3.0]] * 5
+        assert prefix_features(frames, 10, 4) == [0.0, 0.0, 1.0, 0.0, 0.0, 0.0]
+
+
+class TestTargets:
+    def test_first_gesture_within_the_horizon(self):
+        windows = [(10, IDLE), (12, IDLE), (14, -1), (16, 3), (18, 3), (30, 0)]
+        assert onset_targets(windows, horizon=4, idle=IDLE) == [IDLE, 3, 3, 3, 3, 0]
+
+    def test_nothing_ahead_is_idle(self):
+        assert onset_targets([(2, IDLE), (4, -1)], horizon=10, idle=IDLE) == [IDLE, IDLE]
+
+
+class TestHead:
+    def test_folded_head_matches_standardised_head(self):
+        points = [[1.0 + i % 3, 0.2, 0.0, 0.1, 0.0, 0.0] for i in range(20)] + \
+                 [[-1.0 - i % 3, 0.0, 0.4, 0.5, 0.3, 0.0] for i in range(20)]
+        targets = [0] * 20 + [2] * 20
+        weights, bias, mean, std = train_softmax(points, targets, 3, epochs=100)
+        folded, folded_bias = fold_head(weights, bias, mean, std)
+        for point, target in zip(points, targets):
+            top, p = head_decision(point, folded, folded_bias)
+            assert top == target and 0.0 < p <= 1.0
+
+    def test_header_layout(self):
+        header = format_header([[0.5] * 6, [-0.25] * 6], [0.0, 1.0], 0x1d, 0.8, prefix=10, horizon=18)
+        assert "#define ONSET_MODEL_CLASSES 2" in header
+        assert "#define ONSET_MODEL_PREFIX_FRAMES 10" in header
+        assert "kOnsetWeights[2 * 6]" in header
+        assert "kOnsetClassMask = 0x1d" in header
+        assert re.search(r"kOnsetThreshold = 0\.8f", header)
+
+    def test_untrained_header_disables_the_head(self):
+        header = format_header([], [], 0, 1.0, prefix=10, horizon=18)
+        assert "#define ONSET_MODEL_CLASSES 0" in header
+        assert "kOnsetWeights[1]" in header
+
+
+class TestSimulate:
+    def test_confirm_cancel_and_timeout(self):
+        steps = [
+            (10, -1, IDLE),
+            (12, 3, IDLE),      # provisional
+            (14, 3, IDLE),      # still pending, not announced again
+            (16, 3, 3),         # confirmed 4 frames ahead
+            (18, 3, 3),         # the head must drop first
+            (20, -1, IDLE),
+            (22, 0, IDLE),      # provisional
+            (24, -1, 2),        # another gesture: canceled
+            (26, 4, IDLE),      # provisional, never confirmed
+            (40, -1, IDLE),     # past the horizon: canceled
+        ]
+        stats = simulate(steps, horizon=10, idle=IDLE)
+        assert stats == OnsetStats(onsets=3, confirmed=1, canceled=2, lead_frames=4)
+
+    def test_no_provisional_for_what_the_model_already_reports(self):
+        stats = simulate([(10, -1, 3), (12, 3, 3), (14, 3, 3)], horizon=10, idle=IDLE)
+        assert stats.onsets == 0
+
+    @given(steps=st.lists(st.tuples(st.integers(min_value=-1, max_value=4), st.integers(min_value=-1, max_value=4)),
+                          max_size=60))
+    @settings(max_examples=100)
+    def test_every_onset_is_resolved_at_most_once(self, steps):
+        timeline = [(2 * i, head, result) for i, (head, result) in enumerate(steps)]
+        stats = simulate(timeline, horizon=8, idle=IDLE)
+        assert stats.confirmed + stats.canceled <= stats.onsets <= stats.confirmed + stats.canceled + 1
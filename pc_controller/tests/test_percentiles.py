@@ -0,0 +1,23 @@
+import os
+import sys
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from hypothesis import given, strategies as st, settings
+from percentiles import percentile
+
+
+class TestPercentile:
+    def test_nearest_rank(self):
+        values = list(range(100, 0, -1))
+        assert percentile(values, 0.5) == 50 and percentile(values, 0.99) == 99 and percentile(values, 1.0) == 100
+        assert percentile(values, 0.0) == 1 and percentile([7], 0.99) == 7
+        assert percentile([], 0.5) == 0.0
+
+    @given(values=st.lists(st.integers(min_value=0, max_value=10 ** 6), min_size=1, max_size=60),
+           p=st.floats(min_value=0.0, max_value=1.0))
+    @settings(max_examples=100)
+    def test_is_a_member_with_p_at_or_below(self, values, p):
+        value = percentile(values, p)
+        assert value in values
+        assert sum(v <= value for v in values) >= p * len(values)
+        assert percentile(values, 0.5) <= percentile(values, 0.99)
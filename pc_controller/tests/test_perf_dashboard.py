@@ -0,0 +1,126 @@
+import json
+import os
+import sys
+import tempfile
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from perf_dashboard import (append_history, ble_metrics, bench_metrics, latest_regressions, load_history, main,
+                            render_html, replay_metrics, serial_metrics, series)
+
+# Mirror of a board log: RAM budget (memory_module_report), thread stacks, "stats", replay lines
+BOARD_LOG = """\
+[Memory] RAM budget: 262144 B total
+[Memory]   static data + bss   41000 B
+[Memory]   heap in use          3100 B
+[Memory]     tensor arena             1680 B (tensors 1152, persistent 300, idle between invokes 1152)
+[Memory]   free               218044 B
+[Memory] Placement: 8 hot buffers checked, 1 misplaced
+[Threads] inference prio  3, stack  6144 B, peak  2900 B (47%)
+[Threads] ble       prio  2, stack  4096 B, peak  1800 B (43%)
+[Stats] infer.total_us n 120 p50 4100 p90 4500 p99 5200 max 6000
+[Stats] ble.drops 3
+stage,classify,50,3900,4700,310
+memory,52000,41000
+[Threads] inference prio  3, stack  6144 B, peak  3000 B (48%)
+"""
+
+# Mirror of ble_benchmark.py's print_loopback / print_saturation / print_inference
+BLE_LOG = """\
+Loopback: 200/200 round trips, 0 lost
+  host   RTT p50   15.2 ms  p95   22.0 ms  p99   30.5 ms  max   40.0 ms
+  device RTT p50   14.0 ms  p95   20.0 ms  p99   28.0 ms  max   35.0 ms  (200 timed, 0 notifications refused)
+Saturation: device sent 900 packets / 216000 bytes in 3000 ms (576.0 kbit/s), 2 refused by the stack
+  host received 898 packets / 215520 bytes in 3.010 s (572.8 kbit/s), 2 missing
+Inference (synthetic): 100 runs, ok
+  stage            min     p50     p95     p99     max  us
+  dsp              180     200     230     250     300
+  classification  3800    3900    4100    4300    4800
+done
+"""
+
+
+def history_of(values, name="host.latency_p50_us"):
+    return [{"commit": f"c{i}", "time": "", "metrics": {name: v}} for i, v in enumerate(values)]
+
+
+class TestSources:
+    def test_board_log(self):
+        metrics = serial_metrics(BOARD_LOG)
+        assert metrics["ram.static_bytes"] == 41000 and metrics["ram.heap_bytes"] == 3100
+        assert metrics["arena.tensor_bytes"] == 1152 and metrics["ram.free_bytes"] == 218044
+        assert metrics["memory.misplaced"] == 1
+        # The last report wins
+        assert metrics["stack.inference.peak_bytes"] == 3000 and metrics["stack.ble.peak_bytes"] == 1800
+        assert metrics["stats.infer.total_us.p50"] == 4100 and metrics["stats.infer.total_us.p99"] == 5200
+        assert "stats.ble.drops.p50" not in metrics
+        assert metrics["stage.classify.mean_us"] == 3900 and metrics["ram.high_water_bytes"] == 52000
+
+    def test_ble_log(self):
+        metrics = ble_metrics(BLE_LOG)
+        assert metrics["ble.host_rtt_p50_ms"] == 15.2 and metrics["ble.device_rtt_p99_ms"] == 28.0
+        assert metrics["ble.device_kbps"] == 576.0 and metrics["ble.host_kbps"] == 572.8
+        assert metrics["inference.dsp.p50_us"] == 200 and metrics["inference.classification.p99_us"] == 4300
+        assert not any(name.startswith("inference.done") for name in metrics)
+
+    def test_host_outputs(self):
+        replay = "labels,idle,left\nresult,10,left,0.9,400,1000\nresult,20,idle,0.8,500,3000\nsummary,2,100,100,9000,600\n"
+        metrics = replay_metrics([replay, "result,5,left,0.9,450,2000\n"])
+        assert metrics["host.latency_p50_us"] == 2000 and metrics["host.latency_p99_us"] == 3000
+        assert metrics["host.dsp_per_window_us"] == 200
+        assert replay_metrics(["nothing classified\n"]) == {}
+        bench = json.dumps({"schema": 1, "benchmarks": [
+            {"name": "model_invoke", "iterations": 10, "ns_per_op": {"min": 1.0, "median": 2.0, "max": 3.0}}]})
+        assert bench_metrics(bench) == {"bench.model_invoke.median_ns": 2.0}
+
+
+class TestRegressions:
+    def test_against_median_of_window(self):
+        points = series(history_of([100, 104, 98, 200, 101, 112]), "host.latency_p50_us", 3, 0.10)
+        assert [p.regressed for p in points] == [False, False, False, True, False, True]
+        # One outlier does not move the median the next point is judged against
+        assert points[4].baseline == 104
+
+    def test_direction_and_size_tolerance(self):
+        kbps = series(history_of([500, 400, 600], "ble.host_kbps"), "ble.host_kbps", 5, 0.10)
+        assert [p.regressed for p in kbps] == [False, True, False]
+        history = history_of([1000, 1025], "build.flash_bytes")
+        assert [name for name, _ in latest_regressions(history, 5, 0.10, 0.02)] == ["build.flash_bytes"]
+        assert latest_regressions(history, 5, 0.10, 0.05) == []
+        # A metric the latest commit did not measure is not reported
+        history.append({"commit": "c2", "time": "", "metrics": {"host.latency_p50_us": 1.0}})
+        assert latest_regressions(history, 5, 0.10, 0.02) == []
+
+
+class TestHistory:
+    def test_collections_merge_per_commit(self):
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, "perf.jsonl")
+            assert load_history(path) == []
+            append_history(path, "aaa", {"a_us": 1.0, "b_us": 2.0})
+            append_history(path, "bbb", {"a_us": 3.0})
+            append_history(path, "aaa", {"b_us": 5.0})
+            history = load_history(path)
+            assert [r["commit"] for r in history] == ["aaa", "bbb"]
+            assert history[0]["metrics"] == {"a_us": 1.0, "b_us": 5.0}
+
+    def test_cli_collect_and_render(self):
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, "perf.jsonl")
+            log = os.path.join(tmp, "ble.log")
+            with open(log, "w") as f:
+                f.write(BLE_LOG)
+            assert main(["collect", "--history", path, "--commit", "one", "--ble", log]) == 0
+            with open(log, "w") as f:
+                f.write(BLE_LOG.replace("15.2 ms", "25.0 ms"))
+            assert main(["collect", "--history", path, "--commit", "two", "--ble", log]) == 0
+            page = os.path.join(tmp, "perf.html")
+            assert main(["render", "--history", path, "-o", page]) == 0
+            assert main(["render", "--history", path, "-o", page, "--check"]) == 1
+            with open(page) as f:
+                text = f.read()
+            assert "ble.host_rtt_p50_ms" in text and "1 regressed at two" in text
+            assert main(["collect", "--history", path, "--commit", "three", "--ble", page]) == 2
+
+    def test_page_without_regressions(self):
+        page = render_html(history_of([100, 101]), 5, 0.10, 0.02)
+        assert "No regressions" in page and page.count("<svg") == 1
@@ -0,0 +1,109 @@
+import os
+import sys
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from hypothesis import given, strategies as st, settings
+from raw_recorder import (StreamDecoder, Recording, TYPE_WINDOW, encode_packet, crc8,
+                          window_to_timestamps)
+
+samples = st.integers(min_value=-32768, max_value=32767)
+frames_st = st.lists(st.lists(samples, min_size=6, max_size=6), min_size=1, max_size=8)
+intervals_st = st.integers(min_value=0, max_value=100000)
+
+
+def make_timestamps(start, count, interval):
+    return [(start + i * interval) & 0xFFFFFFFF for i in range(count)]
+
+
+class TestRoundTrip:
+    @given(frames=frames_st, start=st.integers(min_value=0, max_value=0xFFFFFFFF),
+           interval=intervals_st, seq=st.integers(min_value=0, max_value=0xFFFF))
+    @settings(max_examples=100)
+    def test_decode_matches_encoded(self, frames, start, interval, seq):
+        timestamps = make_timestamps(start, len(frames), interval)
+        decoder = StreamDecoder()
+        packets = list(decoder.feed(encode_packet(seq, 0x3F, timestamps, frames)))
+        assert len(packets) == 1
+        assert packets[0].seq == seq
+        assert packets[0].frames == frames
+        assert packets[0].timestamps_us == timestamps
+
+    @given(frames=frames_st, split=st.integers(min_value=0, max_value=300))
+    @settings(max_examples=50)
+    def test_byte_by_byte_feed(self, frames, split):
+        data = encode_packet(1, 0x3F, make_timestamps(0, len(frames), 2500), frames)
+        split = min(split, len(data))
+        decoder = StreamDecoder()
+        packets = list(decoder.feed(data[:split])) + list(decoder.feed(data[split:]))
+        assert len(packets) == 1
+        assert packets[0].frames == frames
+
+
+class TestStreamErrors:
+    def test_skips_text_between_packets(self):
+        frames = [[1, 2, 3]]
+        data = (b"[IMU] boot\r\n" + encode_packet(0, 0x07, [0], frames)
+                + b"noise\xa5" + encode_packet(1, 0x07, [2500], frames))
+        decoder = StreamDecoder()
+        packets = list(decoder.feed(data))
+        assert [p.seq for p in packets] == [0, 1]
+        assert decoder.stats.lost_packets == 0
+
+    def test_corrupted_packet_is_rejected(self):
+        data = bytearray(encode_packet(0, 0x07, [0], [[1, 2, 3]]))
+        data[-2] ^= 0x01
+        decoder = StreamDecoder()
+        assert list(decoder.feed(bytes(data))) == []
+        assert decoder.stats.crc_errors == 1
+
+    def test_sequence_gap_counts_lost_packets(self):
+        decoder = StreamDecoder()
+        data = encode_packet(0xFFFE, 0x07, [0], [[0, 0, 0]]) + encode_packet(2, 0x07, [0], [[0, 0, 0]])
+        list(decoder.feed(data))
+        assert decoder.stats.lost_packets == 3
+
+    def test_crc8_check_value(self):
+        assert crc8(b"123456789") == 0xF4
+
+
+class TestRecording:
+    def test_timestamps_unwrap(self):
+        decoder = StreamDecoder()
+        recording = Recording()
+        timestamps = make_timestamps(0xFFFFF000, 4, 2500)
+        for packet in decoder.feed(encode_packet(0, 0x07, timestamps, [[0, 0, 8192]] * 4)):
+            recording.add(packet)
+        assert recording.timestamps_us == [0xFFFFF000 + i * 2500 for i in range(4)]
+        assert abs(recording.interval_ms() - 2.5) < 1e-9
+        assert recording.values()[0] == [0.0, 0.0, 1.0]
+
+
+class TestWindowStream:
+    @given(frames=st.lists(st.lists(samples, min_size=3, max_size=3), min_size=1, max_size=16),
+           first=st.integers(min_value=0, max_value=0xFFFFFF00))
+    @settings(max_examples=100)
+    def test_round_trip(self, frames, first):
+        # Mirror of publish_window() in src/ble_module.cpp: consecutive sample indices as timestamps
+        indices = list(range(first, first + len(frames)))
+        decoder = StreamDecoder(TYPE_WINDOW)
+        packets = list(decoder.feed(encode_packet(3, 0x07, indices, frames, TYPE_WINDOW)))
+        assert len(packets) == 1 and packets[0].packet_type == TYPE_WINDOW
+        assert packets[0].timestamps_us == indices and packets[0].frames == frames
+
+    def test_index_step_costs_one_byte(self):
+        one = encode_packet(0, 0x07, [100], [[0, 0, 8192]], TYPE_WINDOW)
+        two = encode_packet(0, 0x07, [100, 101], [[0, 0, 8192], [1, -1, 8190]], TYPE_WINDOW)
+        assert len(two) - len(one) == 4
+
+    def test_streams_do_not_mix(self):
+        window = encode_packet(0, 0x07, [0], [[1, 2, 3]], TYPE_WINDOW)
+        raw = encode_packet(0, 0x07, [0], [[1, 2, 3]])
+        assert [p.packet_type for p in StreamDecoder().feed(window + raw)] == [1]
+        assert [p.packet_type for p in StreamDecoder(TYPE_WINDOW).feed(window + raw)] == [TYPE_WINDOW]
+
+    def test_indices_to_model_rate(self):
+        decoder = StreamDecoder(TYPE_WINDOW)
+        recording = Recording()
+        for packet in decoder.feed(encode_packet(0, 0x07, [48, 49, 51], [[0, 0, 8192]] * 3, TYPE_WINDOW)):
+            recording.add(window_to_timestamps(packet, 48.0))
+        assert recording.timestamps_us == [1000000, 1020833, 1062500]
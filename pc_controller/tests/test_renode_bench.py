@@ -0,0 +1,66 @@
+import json
+import os
+import struct
+import sys
+import tempfile
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+import pytest
+from hypothesis import given, strategies as st, settings
+from bench_compare import load
+from renode_bench import DATA_HEADER, encode_imu_data, format_summary, load_recordings, to_bench_json, zone_cycles
+from zone_timeline import parse_dump
+
+CLOCK_HZ = 64000000
+
+
+def dump_lines(records):
+    """Mirror of profiler_module_dump() in src/profiler_module.cpp, as src/renode/renode_imu.cpp sends it on UART0."""
+    lines = [f"[Zones] clock {CLOCK_HZ} recorded {len(records)} count {len(records)}\n",
+             "[Zones] zone 0 acquire sampler\n", "[Zones] zone 2 infer inference\n"]
+    lines += [f"[Zones] Z {zone} {age} {cycles}\n" for zone, age, cycles in records]
+    return lines + ["[Zones] end\n", "[Renode] done 800 sensor frames, 200 output frames\n"]
+
+
+class TestImuData:
+    @given(frames=st.lists(st.lists(st.integers(-32768, 32767), min_size=3, max_size=3), max_size=20))
+    @settings(max_examples=50)
+    def test_words_as_the_firmware_reads_them(self, frames):
+        # accelerometer only (mask 0x07): gyro words are zero
+        data = encode_imu_data(0x07, frames)
+        magic, odr, mask, _, count = DATA_HEADER.unpack_from(data)
+        assert (magic, odr, mask, count) == (b"IMUR", 400, 0x07, len(frames))
+        words = struct.unpack_from(f"<{3 * len(frames)}I", data, DATA_HEADER.size)
+        for i, frame in enumerate(frames):
+            low = [w & 0xFFFF for w in words[3 * i:3 * i + 3]]
+            high = [w >> 16 for w in words[3 * i:3 * i + 3]]
+            assert [v & 0xFFFF for v in frame] == [low[0], high[0], low[1]]
+            assert high[1] == low[2] == high[2] == 0
+
+    def test_gyro_only_recording_fills_the_gyro_slots(self):
+        data = encode_imu_data(0x38, [[1, 2, 3]])
+        assert struct.unpack_from("<6h", data, DATA_HEADER.size) == (0, 0, 0, 1, 2, 3)
+
+    def test_recordings_with_different_channels_are_rejected(self):
+        with tempfile.TemporaryDirectory() as tmp:
+            acc = os.path.join(tmp, "a.csv")
+            gyr = os.path.join(tmp, "b.csv")
+            with open(acc, "w") as f:
+                f.write("timestamp,accX,accY,accZ\n0,0,0,1\n2.5,0,0,1\n")
+            with open(gyr, "w") as f:
+                f.write("timestamp,gyrX,gyrY,gyrZ\n0,0,0,1\n2.5,0,0,1\n")
+            assert DATA_HEADER.unpack_from(load_recordings([acc, acc]))[4] == 4
+            with pytest.raises(ValueError):
+                load_recordings([acc, gyr])
+
+
+def test_zones_in_bench_format():
+    # infer: 6400 and 12800 cycles, acquire: 640
+    dump = parse_dump(dump_lines([(2, 100000, 6400), (0, 50000, 640), (2, 30000, 12800)]))
+    assert zone_cycles(dump) == {"acquire": [640], "infer": [6400, 12800]}
+    results = load(json.dumps(to_bench_json(dump)))
+    infer = results["zone:infer"]
+    assert infer.iterations == 2
+    assert (infer.min_ns, infer.median_ns, infer.max_ns) == (100000.0, 100000.0, 200000.0)
+    lines = format_summary(dump)
+    assert lines[1].split()[:2] == ["acquire", "1"] and lines[2].split()[-1] == "12800"
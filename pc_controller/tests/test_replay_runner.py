@@ -0,0 +1,62 @@
+import os
+import sys
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from hypothesis import given, strategies as st, settings
+from replay_runner import ReplayResult, WindowResult, accuracy, confusion_matrix, parse_output, stage_timing
+
+labels_st = st.sampled_from(["down", "idle", "left", "right", "up", "uncertain"])
+window_st = st.builds(WindowResult, frame=st.integers(min_value=0, max_value=100000), label=labels_st,
+                      confidence=st.floats(min_value=0.0, max_value=1.0, allow_nan=False),
+                      classify_us=st.integers(min_value=0, max_value=10000),
+                      latency_us=st.integers(min_value=0, max_value=100000))
+
+
+def format_output(result: ReplayResult) -> str:
+    lines = ["[Inference] log line", "--- Prediction: idle 0.99 ---"]
+    lines += [f"result,{w.frame},{w.label},{w.confidence:.5f},{w.classify_us},{w.latency_us}" for w in result.windows]
+    lines.append(f"summary,{len(result.windows)},{result.sensor_frames},{result.output_frames},"
+                 f"{result.wall_us},{result.dsp_us}")
+    return "\n".join(lines) + "\n"
+
+
+class TestParseOutput:
+    @given(windows=st.lists(window_st, max_size=30), counters=st.lists(st.integers(min_value=0, max_value=2**32 - 1),
+                                                                      min_size=4, max_size=4))
+    @settings(max_examples=50)
+    def test_round_trip(self, windows, counters):
+        expected = ReplayResult("left.01.csv", windows, *counters)
+        parsed = parse_output(expected.path, format_output(expected))
+        assert [(w.frame, w.label, w.classify_us, w.latency_us) for w in parsed.windows] == \
+            [(w.frame, w.label, w.classify_us, w.latency_us) for w in windows]
+        assert all(abs(p.confidence - w.confidence) <= 5e-6 for p, w in zip(parsed.windows, windows))
+        assert (parsed.sensor_frames, parsed.output_frames, parsed.wall_us, parsed.dsp_us) == tuple(counters)
+
+    def test_ignores_truncated_lines(self):
+        parsed = parse_output("idle.csv", "result,1,idle\nsummary,1\nresult,4,idle,0.9,10,20\n")
+        assert len(parsed.windows) == 1 and parsed.sensor_frames == 0
+
+
+class TestConfusion:
+    @given(windows=st.lists(window_st, max_size=40))
+    @settings(max_examples=50)
+    def test_counts_every_window_once(self, windows):
+        matrix = confusion_matrix([ReplayResult("left.a.csv", windows), ReplayResult("idle.b.csv", windows)])
+        assert sum(matrix["left"].values()) == len(windows)
+        assert matrix["left"] == matrix["idle"]
+
+    def test_accuracy(self):
+        windows = [WindowResult(0, "left", 0.9, 10, 0), WindowResult(2, "idle", 0.8, 0, 0)]
+        matrix = confusion_matrix([ReplayResult("left.wave.csv", windows)])
+        assert accuracy(matrix) == 0.5
+        assert accuracy({}) == 0.0
+
+
+class TestStageTiming:
+    def test_skipped_windows_excluded_from_classify_mean(self):
+        windows = [WindowResult(0, "idle", 1.0, 0, 100), WindowResult(2, "left", 0.9, 40, 300)]
+        timing = stage_timing([ReplayResult("left.csv", windows, sensor_frames=400, dsp_us=200)])
+        assert timing["classify_us_mean"] == 40
+        assert timing["prefilter_skipped"] == 1
+        assert timing["dsp_us_per_frame"] == 0.5
+        assert timing["latency_us_mean"] == 200 and timing["latency_us_max"] == 300
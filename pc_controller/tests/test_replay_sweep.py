@@ -0,0 +1,77 @@
+import os
+import sys
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from hypothesis import given, strategies as st, settings
+from replay_runner import ReplayResult, WindowResult
+from replay_sweep import SweepRow, evaluate, mark_pareto, stride_flags, variants, vote_flags
+
+row_st = st.builds(SweepRow, setting=st.sampled_from(["a", "b", "c"]), threshold=st.just(0.5),
+                   f1=st.floats(min_value=0.0, max_value=1.0), precision=st.just(0.0), recall=st.just(0.0),
+                   inferences_per_s=st.floats(min_value=0.0, max_value=100.0),
+                   latency_ms=st.one_of(st.none(), st.floats(min_value=0.0, max_value=2000.0)))
+
+
+def replay(path, windows, output_frames=480):
+    return ReplayResult(path, [WindowResult(*w) for w in windows], output_frames, output_frames)
+
+
+class TestEvaluate:
+    def test_detection_false_alarm_and_latency(self):
+        results = [
+            # left detected at frame 48 (1 s) with 2 ms processing; the 0.4 one is below the threshold
+            replay("left.01.csv", [(24, "left", 0.4, 500, 1000), (48, "left", 0.9, 500, 2000),
+                                   (50, "left", 0.95, 0, 2000)]),
+            # missed
+            replay("right.01.csv", [(24, "idle", 0.99, 500, 1000)]),
+            # a false alarm in an idle recording
+            replay("idle.01.csv", [(24, "up", 0.7, 500, 1000), (30, "uncertain", 0.9, 500, 1000)]),
+        ]
+        f1, precision, recall, per_s, latency = evaluate(results, 0.6)
+        assert precision == 0.5 and recall == 0.5 and abs(f1 - 0.5) < 1e-9
+        assert abs(latency - 1002.0) < 1e-9
+        # 5 windows ran the CNN over 30 s of recording
+        assert abs(per_s - 5 / 30.0) < 1e-9
+
+    def test_nothing_detected(self):
+        f1, precision, recall, _, latency = evaluate([replay("left.01.csv", [])], 0.5)
+        assert (f1, precision, recall, latency) == (0.0, 0.0, 0.0, None)
+
+    @given(thresholds=st.lists(st.floats(min_value=0.0, max_value=1.0), min_size=2, max_size=2, unique=True),
+           confidences=st.lists(st.floats(min_value=0.0, max_value=1.0), min_size=1, max_size=10))
+    @settings(max_examples=50)
+    def test_higher_threshold_never_raises_recall(self, thresholds, confidences):
+        low, high = sorted(thresholds)
+        results = [replay("left.01.csv", [(i, "left", c, 1, 0) for i, c in enumerate(confidences)]),
+                   replay("right.01.csv", [(i, "right", 1.0 - c, 1, 0) for i, c in enumerate(confidences)])]
+        assert evaluate(results, high)[2] <= evaluate(results, low)[2]
+
+
+class TestPareto:
+    @given(rows=st.lists(row_st, min_size=1, max_size=12))
+    @settings(max_examples=100)
+    def test_front_is_not_dominated(self, rows):
+        mark_pareto(rows)
+        assert any(r.pareto for r in rows)
+        for row in rows:
+            if not row.pareto:
+                continue
+            for other in rows:
+                better_everywhere = (other.f1 > row.f1 and other.inferences_per_s < row.inferences_per_s and
+                                     other.latency_ms is not None and
+                                     (row.latency_ms is None or other.latency_ms < row.latency_ms))
+                assert not better_everywhere
+
+
+class TestVariants:
+    def test_product_of_axes(self):
+        axes = [[(f"stride {v}", stride_flags(v)) for v in ("2:12", "4")],
+                [(f"vote {v}", vote_flags(v)) for v in ("off", "6:4")]]
+        result = variants(axes)
+        assert len(result) == 4
+        assert result[0] == ("stride 2:12, vote off", "-DINFERENCE_STRIDE_FINE_SAMPLES=2 "
+                             "-DINFERENCE_STRIDE_COARSE_SAMPLES=12 -DINFERENCE_VOTE_SMOOTHING=0")
+        assert "-DINFERENCE_STRIDE_COARSE_SAMPLES=4" in result[2][1]
+
+    def test_no_axes_is_one_default_build(self):
+        assert variants([]) == [("default", "")]
@@ -0,0 +1,164 @@
+import asyncio
+import os
+import struct
+import sys
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from hypothesis import given, strategies as st, settings
+from ble_manager import STREAM_DIAGNOSTICS, STREAM_EVENTS, STREAM_SCORES
+from serial_manager import (FRAME_ACK, FRAME_CONFIG, FRAME_COUNTERS, FRAME_EVENTS, FRAME_HELLO,
+                            FRAME_INFERENCE_BENCH, FRAME_MISSED, FRAME_SEGMENT, FrameDecoder, SerialManager,
+                            cobs_decode, cobs_encode, crc16, decode_frame, encode_frame, encode_hello, parse_hello)
+
+byte_list_st = st.lists(st.integers(min_value=0, max_value=255), max_size=300)
+
+
+class FakePort:
+    def __init__(self):
+        self.written = []
+
+    def write(self, data):
+        self.written.append(bytes(data))
+
+
+def written_frames(port):
+    return [item for chunk in port.written for item in FrameDecoder().feed(chunk)]
+
+
+class TestFraming:
+    def test_crc_check_value(self):
+        assert crc16(b"123456789") == 0x29B1
+
+    @given(data=byte_list_st)
+    @settings(max_examples=200)
+    def test_cobs_round_trip(self, data):
+        data = bytes(data)
+        encoded = cobs_encode(data)
+        assert 0 not in encoded
+        assert len(encoded) <= len(data) + len(data) // 254 + 1
+        assert cobs_decode(encoded) == data
+
+    @given(frame_type=st.integers(min_value=1, max_value=255), payload=byte_list_st)
+    @settings(max_examples=200)
+    def test_frame_round_trip(self, frame_type, payload):
+        payload = bytes(payload[:244])
+        frame = encode_frame(frame_type, payload)
+        assert frame[0] == 0 and frame[-1] == 0 and 0 not in frame[1:-1]
+        assert decode_frame(frame[1:-1]) == (frame_type, payload)
+
+    @given(payload=byte_list_st, flip=st.integers(min_value=0, max_value=10000))
+    @settings(max_examples=200)
+    def test_corruption_detected(self, payload, flip):
+        payload = bytes(payload[:32])
+        block = bytearray(encode_frame(FRAME_EVENTS, payload)[1:-1])
+        position = flip % len(block)
+        block[position] ^= 1 << (flip % 8)
+        if 0 in block:
+            return  # the corrupted byte would have split the block on the wire
+        assert decode_frame(bytes(block)) != (FRAME_EVENTS, payload)
+
+    def test_hello(self):
+        assert decode_frame(encode_hello(STREAM_EVENTS)[1:-1]) == (FRAME_HELLO, bytes([STREAM_EVENTS]))
+        assert parse_hello(bytes([0x03, 1])) == (0x03, 1)
+        assert parse_hello(b"\x03") is None
+
+
+class TestFrameDecoder:
+    @given(payloads=st.lists(byte_list_st, max_size=6),
+           cut=st.lists(st.integers(min_value=1, max_value=40), max_size=20))
+    @settings(max_examples=100)
+    def test_frames_and_text_in_any_chunking(self, payloads, cut):
+        stream = b""
+        expected = []
+        for i, payload in enumerate(payloads):
+            payload = bytes(payload[:64])
+            text = f"[BLE] line {i}\n".encode()
+            stream += text + encode_frame(FRAME_EVENTS, payload)
+            expected += [(None, text), (FRAME_EVENTS, payload)]
+        decoder = FrameDecoder()
+        items = []
+        position = 0
+        for size in cut + [len(stream)]:
+            items += decoder.feed(stream[position:position + size])
+            position += size
+        assert items == expected
+
+    def test_damaged_frame_becomes_text(self):
+        frame = bytearray(encode_frame(FRAME_CONFIG, b"\x01\x02\x03"))
+        frame[3] ^= 0x40
+        assert FrameDecoder().feed(bytes(frame)) == [(None, bytes(frame[1:-1]))]
+
+
+class TestSerialManager:
+    def connected(self, received):
+        manager = SerialManager()
+        manager._serial = FakePort()
+        manager._connected = True
+        manager._ack_supported = True
+        manager._missed_supported = True
+        manager.set_gesture_callback(lambda gesture, confidence: received.append(gesture))
+        return manager
+
+    def test_streams_follow_callbacks(self):
+        manager = SerialManager()
+        assert manager.streams() == STREAM_EVENTS
+        manager.set_scores_callback(lambda frame: None)
+        manager.set_latency_callback(lambda report: None)
+        assert manager.streams() == STREAM_EVENTS | STREAM_SCORES | STREAM_DIAGNOSTICS
+
+    def test_events_are_emitted_and_acked(self):
+        received = []
+        manager = self.connected(received)
+        burst = struct.pack('<BH', 0, 0) + struct.pack('<bBHI', 2, 250, 41, 1000) + struct.pack('<bBHI', 3, 250, 42, 1100)
+        manager._dispatch(FRAME_EVENTS, burst)
+        assert received == [manager.MODEL_LABELS[2], manager.MODEL_LABELS[3]]
+        assert written_frames(manager._serial) == [(FRAME_ACK, struct.pack('<H', 42))]
+
+    def test_gap_is_requested_again(self):
+        manager = self.connected([])
+        manager._dispatch(FRAME_EVENTS, struct.pack('<BH', 0, 0) + struct.pack('<bBHI', 2, 250, 1, 1000))
+        manager._dispatch(FRAME_EVENTS, struct.pack('<BH', 0, 3) + struct.pack('<bBHI', 2, 250, 4, 1300))
+        frames = written_frames(manager._serial)
+        assert (FRAME_MISSED, struct.pack('<HB', 1, 2)) in frames
+
+    def test_config_is_kept(self):
+        manager = self.connected([])
+        manager._dispatch(FRAME_CONFIG, struct.pack('<BBBBBH', 1, 128, 200, 4, 16, 50))
+        assert manager._config is not None and manager._config.ble_poll_interval_ms == 50
+
+    def test_text_is_not_dispatched(self):
+        received = []
+        manager = self.connected(received)
+        manager._dispatch(None, b"[BLE] Published: left (0.912)\n")
+        assert received == [] and manager._serial.written == []
+
+    def test_counters_frame(self):
+        manager = self.connected([])
+        reports = []
+        manager.set_counters_callback(reports.append)
+        assert manager.streams() & STREAM_DIAGNOSTICS
+        manager._dispatch(FRAME_COUNTERS, struct.pack('<5I', 10, 2, 0, 61, 1))
+        assert reports[0].published == 10 and reports[0].connected_s == 61
+
+    def test_segment_frame_and_close_release(self):
+        manager = self.connected([])
+        holds = []
+        manager.set_hold_callback(lambda gesture, held: holds.append(held))
+        manager._dispatch(FRAME_SEGMENT, struct.pack('<bBHII', 1, 1, 7, 500, 500))
+        manager._serial = None
+        asyncio.run(manager.disconnect())
+        assert holds == [True, False]
+
+    def test_inference_benchmark_round_trip(self):
+        manager = self.connected([])
+        report = struct.pack('<BBH', 1, 2, 50) + struct.pack('<5I', 1, 2, 3, 4, 5) * 4
+
+        async def run():
+            task = asyncio.ensure_future(manager.run_inference_benchmark("live", 50, timeout_s=1.0))
+            await asyncio.sleep(0)
+            manager._dispatch(FRAME_INFERENCE_BENCH, report)
+            return await task
+
+        result = asyncio.run(run())
+        assert written_frames(manager._serial) == [(FRAME_INFERENCE_BENCH, struct.pack('<BH', 1, 50))]
+        assert result.mode == "live" and result.runs == 50 and result.stages["total"].p99_us == 4
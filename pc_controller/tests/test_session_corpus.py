@@ -0,0 +1,148 @@
+import os
+import sys
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+import tempfile
+
+from hypothesis import given, strategies as st, settings
+from raw_recorder import Recording, RawPacket, _cbor, encode_packet, write_cbor, write_csv
+from session_corpus import (Corpus, CorpusWriter, SessionData, _cbor_decode, convert, expand_inputs, load_frames,
+                            map_sessions, recording_label, to_lsb)
+
+masks = st.sampled_from([0x07, 0x3F, 0x01, 0x38, 0x05])
+
+
+def make_session(name, label, mask, frames, step_us=2500, start=1000):
+    channels = bin(mask).count("1")
+    columns = [[(17 * f + 101 * c) % 65536 - 32768 for f in range(frames)] for c in range(channels)]
+    return SessionData(name, label, mask, [start + f * step_us for f in range(frames)], columns)
+
+
+def write(path, sessions):
+    with CorpusWriter(path, len(sessions)) as writer:
+        for session in sessions:
+            writer.add(session)
+
+
+def first_sample(session):
+    return session.column(session.channels()[0])[0]
+
+
+class TestRoundTrip:
+    @given(shapes=st.lists(st.tuples(masks, st.integers(min_value=0, max_value=40), st.sampled_from(["idle", "up"])),
+                           min_size=1, max_size=6))
+    @settings(max_examples=30)
+    def test_columns_timestamps_and_labels(self, shapes):
+        sessions = [make_session(f"s{i}.csv", label, mask, frames) for i, (mask, frames, label) in enumerate(shapes)]
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, "data.gcorpus")
+            write(path, sessions)
+            with Corpus(path) as corpus:
+                assert len(corpus) == len(sessions)
+                for expected, session in zip(sessions, corpus):
+                    assert (session.name, session.label, session.frames) == \
+                        (expected.name, expected.label, len(expected.timestamps_us))
+                    assert list(session.timestamps_us()) == [t - 1000 for t in expected.timestamps_us]
+                    for channel, column in zip(session.channels(), expected.columns):
+                        assert list(session.column(channel)) == column
+
+    def test_windows_are_views_into_the_mapping(self):
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, "data.gcorpus")
+            write(path, [make_session("a.csv", "left", 0x3F, 50)])
+            corpus = Corpus(path)
+            session = corpus[0]
+            views = session.window(30, 24, channels=(0, 2))
+            assert all(view.obj is corpus._map for view in views)
+            assert list(views[1]) == list(session.column(2))[6:30]
+            ends = [end for end, _ in session.windows(24, 2)]
+            assert ends == list(range(24, 51, 2))
+            del views
+            corpus.close()
+
+    def test_blocks_are_aligned(self):
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, "data.gcorpus")
+            write(path, [make_session("a.csv", "up", 0x07, 13), make_session("b.csv", "up", 0x3F, 7)])
+            with Corpus(path) as corpus:
+                assert all(s._offset % 64 == 0 for s in corpus)
+                assert corpus.labels() == ["up"]
+
+    def test_rejects_other_files(self):
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, "idle.csv")
+            with open(path, "w") as f:
+                f.write("timestamp,accX\n0,1\n" * 4)
+            try:
+                Corpus(path)
+                assert False, "expected ValueError"
+            except ValueError as e:
+                assert "not a session corpus" in str(e)
+
+
+class TestConvert:
+    def recording(self):
+        recording = Recording()
+        packet = RawPacket(0, 0x3F, [i * 625 for i in range(40)],
+                           [[i, -i, 8192, 3 * i, 0, -16] for i in range(40)])
+        recording.add(packet)
+        return recording
+
+    def test_csv_cbor_and_capture(self):
+        recording = self.recording()
+        with tempfile.TemporaryDirectory() as tmp:
+            csv_path = os.path.join(tmp, "left.a.csv")
+            cbor_path = os.path.join(tmp, "up.b.cbor")
+            bin_path = os.path.join(tmp, "idle.c.bin")
+            write_csv(recording, csv_path)
+            write_cbor(recording, cbor_path)
+            with open(bin_path, "wb") as f:
+                f.write(b"boot log\r\n")
+                for seq, i in enumerate(range(0, 40, 8)):
+                    f.write(encode_packet(seq, 0x3F, recording.timestamps_us[i:i + 8], recording.frames[i:i + 8]))
+            out = os.path.join(tmp, "data.gcorpus")
+            assert convert([csv_path, cbor_path, bin_path], out) == 3
+            with Corpus(out) as corpus:
+                assert [s.label for s in corpus] == ["left", "up", "idle"]
+                for session in corpus:
+                    assert session.channel_mask == 0x3F and session.frames == 40
+                    assert list(session.column(2)) == [8192] * 40
+                    assert list(session.column(3)) == [3 * i for i in range(40)]
+                    assert list(session.timestamps_us())[-1] == 39 * 625
+            # Merging a corpus keeps its sessions and labels unless relabelled
+            merged = os.path.join(tmp, "merged.gcorpus")
+            assert convert([out, csv_path], merged, label="wave") == 4
+            with Corpus(merged) as corpus:
+                assert {s.label for s in corpus} == {"wave"}
+
+    def test_quantises_physical_units_at_the_recording_ranges(self):
+        assert to_lsb(1.0, 0) == 8192
+        assert to_lsb(100.0, 1) == 32767
+        assert to_lsb(-2000.0, 4) == -32768
+
+    @given(values=st.lists(st.one_of(st.integers(min_value=-100000, max_value=100000),
+                                     st.floats(min_value=-10.0, max_value=10.0), st.text()), max_size=10))
+    @settings(max_examples=50)
+    def test_cbor_decoder_reads_the_encoder(self, values):
+        document = {"payload": {"values": values, "nested": [values, {"k": True}]}}
+        decoded, end = _cbor_decode(_cbor(document))
+        assert decoded == document and end == len(_cbor(document))
+
+    def test_indefinite_length_and_half_floats(self):
+        data = bytes([0xBF, 0x61, 0x76, 0x9F, 0xF9, 0x3C, 0x00, 0xFA, 0x3F, 0xC0, 0x00, 0x00, 0xFF, 0xFF])
+        assert _cbor_decode(data)[0] == {"v": [1.0, 1.5]}
+
+
+class TestTools:
+    def test_specs_labels_frames_and_parallel_map(self):
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, "data.gcorpus")
+            write(path, [make_session("a.csv", "left", 0x07, 10), make_session("b.csv", "idle", 0x3F, 20)])
+            specs = expand_inputs([path, "up.01.csv"])
+            assert specs == [f"{path}#0", f"{path}#1", "up.01.csv"]
+            assert [recording_label(s) for s in specs] == ["left", "idle", "up"]
+            timestamps, frames = load_frames(specs[1])
+            assert timestamps[1] == 2.5 and len(frames) == 20
+            assert frames[0][0] == make_session("b", "", 0x3F, 20).columns[0][0] / 8192.0
+            assert map_sessions(path, first_sample, jobs=2) == [-32768, -32768]
+            assert map_sessions(path, first_sample, jobs=1, indices=[1]) == [-32768]
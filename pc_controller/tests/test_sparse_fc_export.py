@@ -0,0 +1,100 @@
+import os
+import sys
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from hypothesis import given, strategies as st, settings
+from model_ota import (DEPLOYED_MODEL, FC_WEIGHTS, load_compiled_model, parse_compiled_model, reference_features,
+                       reference_fc, reference_logits, reference_pooled, self_test_window)
+from sparse_fc_export import (agreement, block_masks, fc_shape, fine_tune, prune_blocks, rewrite_fc_weights,
+                              teacher_probabilities)
+
+DEPLOYED = load_compiled_model(DEPLOYED_MODEL)
+DENSE = DEPLOYED.tensors[FC_WEIGHTS].data
+CLASSES, COLUMNS, BLOCK = fc_shape(DEPLOYED)
+
+
+def _features(seed):
+    return reference_features(DEPLOYED, reference_pooled(DEPLOYED, self_test_window(72, seed)))
+
+
+class TestReferenceStages:
+    def test_deployed_shape(self):
+        assert (CLASSES, COLUMNS, BLOCK) == (5, 36, 10)
+
+    @given(seed=st.integers(min_value=1, max_value=0xFFFFFFFF))
+    @settings(max_examples=5)
+    def test_stages_compose_to_logits(self, seed):
+        window = self_test_window(72, seed)
+        assert reference_fc(DEPLOYED, _features(seed)) == reference_logits(DEPLOYED, window)
+
+
+class TestPruning:
+    @given(density=st.floats(min_value=0.01, max_value=1.0))
+    @settings(max_examples=30)
+    def test_keeps_requested_blocks_untouched(self, density):
+        pruned = prune_blocks(DENSE, CLASSES, COLUMNS, BLOCK, density)
+        masks = block_masks(pruned, CLASSES, COLUMNS, BLOCK)
+        total = CLASSES * COLUMNS
+        assert sum(bin(m).count("1") for m in masks) == max(CLASSES, int(round(density * total)))
+        # every class keeps a block, kept blocks are copied as they are
+        assert all(masks)
+        for i, (p, d) in enumerate(zip(pruned, DENSE)):
+            assert p == 0 or p == d
+            if masks[i // (COLUMNS * BLOCK)] >> (i // BLOCK % COLUMNS) & 1:
+                assert p == d
+
+    def test_full_density_is_dense(self):
+        assert prune_blocks(DENSE, CLASSES, COLUMNS, BLOCK, 1.0) == DENSE
+        assert agreement(DEPLOYED, [_features(s) for s in range(1, 6)], DENSE) == 1.0
+
+    def test_keeps_largest_blocks(self):
+        weights = [0] * (2 * 4 * 2)
+        for k, j, v in ((0, 1, 9), (0, 3, 5), (1, 2, 7), (1, 0, 1)):
+            weights[(k * 4 + j) * 2] = v
+        masks = block_masks(prune_blocks(weights, 2, 4, 2, 3 / 8), 2, 4, 2)
+        assert masks == [0b1010, 0b0100]
+
+    def test_rejects_bad_density(self):
+        for density in (0.0, 1.5):
+            try:
+                prune_blocks(DENSE, CLASSES, COLUMNS, BLOCK, density)
+            except ValueError:
+                continue
+            raise AssertionError(f"density {density} accepted")
+
+
+class TestFineTune:
+    def test_pruned_blocks_stay_zero(self):
+        pruned = prune_blocks(DENSE, CLASSES, COLUMNS, BLOCK, 0.4)
+        samples = [_features(s) for s in range(1, 9)]
+        targets = [teacher_probabilities(DEPLOYED, s) for s in samples]
+        tuned = fine_tune(DEPLOYED, samples, targets, pruned, epochs=5)
+        assert all(-127 <= v <= 127 for v in tuned)
+        kept = block_masks(pruned, CLASSES, COLUMNS, BLOCK)
+        for i, v in enumerate(tuned):
+            if not kept[i // (COLUMNS * BLOCK)] >> (i // BLOCK % COLUMNS) & 1:
+                assert v == 0
+
+    def test_no_samples_is_identity(self):
+        pruned = prune_blocks(DENSE, CLASSES, COLUMNS, BLOCK, 0.5)
+        assert fine_tune(DEPLOYED, [], [], pruned) == pruned
+
+
+class TestRewrite:
+    def test_round_trip_keeps_signature(self):
+        with open(DEPLOYED_MODEL, encoding="utf-8") as f:
+            text = f.read()
+        pruned = prune_blocks(DENSE, CLASSES, COLUMNS, BLOCK, 0.25)
+        model = parse_compiled_model(rewrite_fc_weights(text, pruned, COLUMNS * BLOCK))
+        assert model.tensors[FC_WEIGHTS].data == pruned
+        assert model.signature() == DEPLOYED.signature()
+        for i, t in enumerate(model.tensors):
+            if i != FC_WEIGHTS:
+                assert t.data == DEPLOYED.tensors[i].data
+
+    def test_missing_tensor_rejected(self):
+        try:
+            rewrite_fc_weights("int8_t tensor_data1[2] = { 1, 2 };", DENSE, 360)
+        except ValueError:
+            return
+        raise AssertionError("source without FC weights accepted")
@@ -0,0 +1,145 @@
+import os
+import random
+import sys
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from hypothesis import given, strategies as st, settings
+from tcn_export import (TcnReference, activation_quantization, float_forward, format_header, parse_keras,
+                        quantize_frame, quantize_tcn, receptive_field)
+
+INPUT_SCALE = 0.0627
+INPUT_ZERO_POINT = -1
+
+
+def _keras(seed, channels=(3, 6, 5), dilations=(1, 2), kernel=3, classes=5):
+    rng = random.Random(seed)
+    layers = []
+    for n, dilation in enumerate(dilations):
+        layers.append({"kernel": [[[rng.uniform(-0.5, 0.5) for _ in range(channels[n + 1])]
+                                   for _ in range(channels[n])] for _ in range(kernel)],
+                       "bias": [rng.uniform(-0.2, 0.2) for _ in range(channels[n + 1])],
+                       "dilation": dilation, "relu": True})
+    return {"layers": layers,
+            "dense": {"kernel": [[rng.uniform(-1, 1) for _ in range(classes)] for _ in range(channels[-1])],
+                      "bias": [rng.uniform(-0.1, 0.1) for _ in range(classes)]}}
+
+
+def _frames(seed, count=40, axes=3):
+    rng = random.Random(seed)
+    return [[rng.uniform(-6, 6) for _ in range(axes)] for _ in range(count)]
+
+
+def _quantized(seed):
+    model = parse_keras(_keras(seed))
+    return model, quantize_tcn(model, [_frames(seed + 1), _frames(seed + 2)], INPUT_SCALE, INPUT_ZERO_POINT)
+
+
+class TestFloatModel:
+    def test_parse_transposes_keras_layout(self):
+        data = _keras(1)
+        model = parse_keras(data)
+        layer = data["layers"][0]
+        assert model.layers[0].weights[4][2][1] == layer["kernel"][2][1][4]
+        assert model.head_weights[3][2] == data["dense"]["kernel"][2][3]
+
+    def test_rejects_mismatched_layers(self):
+        data = _keras(1)
+        data["layers"][1]["kernel"] = [[[0.0] * 5] * 4] * 3
+        try:
+            parse_keras(data)
+        except ValueError:
+            return
+        raise AssertionError("layer with the wrong input channels accepted")
+
+    def test_receptive_field(self):
+        model = parse_keras(_keras(1, channels=(3, 4, 4, 4), dilations=(1, 2, 4)))
+        assert receptive_field(model.layers) == 1 + 2 * (1 + 2 + 4)
+
+    @given(seed=st.integers(min_value=0, max_value=1000))
+    @settings(max_examples=10)
+    def test_causal(self, seed):
+        model = parse_keras(_keras(seed))
+        frames = _frames(seed)
+        changed = [list(f) for f in frames]
+        changed[30] = [v + 1.0 for v in changed[30]]
+        before, after = float_forward(model, frames)[-1], float_forward(model, changed)[-1]
+        assert before[:30] == after[:30]
+        assert before[30:] != after[30:]
+
+
+class TestQuantization:
+    @given(low=st.floats(min_value=-10, max_value=0), high=st.floats(min_value=0.01, max_value=10))
+    @settings(max_examples=30)
+    def test_activation_range_covers_zero(self, low, high):
+        scale, zero_point = activation_quantization([low, high])
+        assert -128 <= zero_point <= 127
+        assert abs((-128 - zero_point) * scale - low) <= scale
+        assert abs((127 - zero_point) * scale - high) <= scale
+
+    def test_relu_layers_start_at_the_zero_point(self):
+        _, quant = _quantized(3)
+        for layer in quant.layers:
+            assert layer.act_min == layer.output_offset == -128
+        assert quant.layers[0].input_offset == -INPUT_ZERO_POINT
+
+    @given(seed=st.integers(min_value=0, max_value=1000))
+    @settings(max_examples=5)
+    def test_int8_follows_float(self, seed):
+        model, quant = _quantized(seed)
+        frames = _frames(seed + 1)
+        features = float_forward(model, frames)[-1]
+        reference = TcnReference(quant)
+        agreed = 0
+        for frame, feature in zip(frames, features):
+            probs = reference.step(quantize_frame(frame, INPUT_SCALE, INPUT_ZERO_POINT))
+            logits = [b + sum(w * v for w, v in zip(row, feature)) for row, b in zip(model.head_weights,
+                                                                                    model.head_bias)]
+            agreed += probs.index(max(probs)) == logits.index(max(logits))
+        assert agreed >= 0.8 * len(frames)
+
+
+class TestReference:
+    @given(seed=st.integers(min_value=0, max_value=1000))
+    @settings(max_examples=5)
+    def test_streaming_matches_restart(self, seed):
+        # the newest output depends only on the last receptive field frames
+        _, quant = _quantized(seed)
+        frames = [quantize_frame(f, INPUT_SCALE, INPUT_ZERO_POINT) for f in _frames(seed, 60)]
+        field = receptive_field(quant.layers)
+        streaming = TcnReference(quant)
+        for frame in frames[:-1]:
+            streaming.step(frame)
+        last = streaming.step(frames[-1])
+
+        restarted = TcnReference(quant)
+        pad = [INPUT_ZERO_POINT] * 3
+        for frame in [pad] * field + frames[-field:-1]:
+            restarted.step(frame)
+        assert restarted.step(frames[-1]) == last
+
+    def test_reset_forgets(self):
+        _, quant = _quantized(5)
+        frames = [quantize_frame(f, INPUT_SCALE, INPUT_ZERO_POINT) for f in _frames(5, 20)]
+        reference = TcnReference(quant)
+        first = [reference.step(f) for f in frames]
+        reference.reset()
+        assert [reference.step(f) for f in frames] == first
+
+
+class TestHeader:
+    def test_placeholder(self):
+        text = format_header(None)
+        assert "#define TCN_MODEL_LAYERS 0" in text
+        assert "kTcnConfig" in text and "kTcnTestScores" in text
+
+    def test_trained(self):
+        _, quant = _quantized(7)
+        frames = [quantize_frame(f, INPUT_SCALE, INPUT_ZERO_POINT) for f in _frames(7, 24)]
+        reference = TcnReference(quant)
+        scores = [reference.step(f) for f in frames][-1]
+        text = format_header(quant, frames, scores)
+        assert "#define TCN_MODEL_LAYERS 2" in text
+        assert f"#define TCN_MODEL_RECEPTIVE_FIELD {receptive_field(quant.layers)}" in text
+        assert "static int8_t g_tcn_history1[30];" in text  # (3 - 1) * 2 + 1 frames of 6 channels
+        assert "static int8_t g_tcn_scratch[2 * 6];" in text
+        assert text.count("{") == text.count("}")
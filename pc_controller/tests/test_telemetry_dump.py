@@ -0,0 +1,116 @@
+import os
+import struct
+import sys
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from hypothesis import given, strategies as st, settings
+from ble_manager import (TELEMETRY_CHUNK_HEADER, TELEMETRY_STATUS, TelemetryDump, parse_telemetry_status)
+from serial_manager import crc16
+from telemetry_dump import RECORD_HEADER, SHADOW, bin_median, decode_records, label_drift, shadow_summary, summarize
+
+
+def record(record_type, payload, time_ms=0):
+    """A record as telemetry_module_record builds it."""
+    crc = crc16(struct.pack('<I', time_ms) + payload, crc16(bytes([record_type, len(payload)])))
+    padding = b"\x00" * (-len(payload) % 4)
+    return RECORD_HEADER.pack(record_type, len(payload), crc, time_ms) + payload + padding
+
+
+def chunks(data, size):
+    out = [TELEMETRY_CHUNK_HEADER.pack(offset) + data[offset:offset + size] for offset in range(0, len(data), size)]
+    return out + [TELEMETRY_CHUNK_HEADER.pack(len(data))]
+
+
+class TestRecords:
+    @given(payloads=st.lists(st.binary(max_size=32), max_size=20), time_ms=st.integers(0, 0xFFFFFFFF))
+    @settings(max_examples=100)
+    def test_round_trip(self, payloads, time_ms):
+        data = b"".join(record(6, p, time_ms) for p in payloads)
+        records, damaged = decode_records(data)
+        assert damaged == 0
+        assert [r.fields["reason"] for r in records] == [p.decode("ascii", errors="replace") for p in payloads]
+        assert all(r.time_ms == time_ms for r in records)
+
+    def test_bad_crc_is_skipped(self):
+        bad = bytearray(record(2, bytes([0, 200, 7, 0])))
+        bad[-1] ^= 0x01
+        records, damaged = decode_records(record(1, bytes([4, 0, 0, 0])) + bytes(bad) + record(1, bytes([0, 0, 0, 0])))
+        assert [r.fields["reason"] for r in records] == ["watchdog", "power_on"]
+        assert damaged == len(bad)
+
+    def test_truncated_tail(self):
+        data = record(2, bytes([3, 255, 1, 0])) + record(2, bytes([0, 128, 2, 0]))[:10]
+        records, damaged = decode_records(data)
+        assert records[0].fields == {"gesture": "right", "confidence": 1.0, "sequence": 1}
+        assert damaged == 10
+
+
+class TestDump:
+    @given(data=st.binary(max_size=600), size=st.integers(1, 240))
+    @settings(max_examples=100)
+    def test_reassembly(self, data, size):
+        dump = TelemetryDump()
+        assert [dump.feed(c) for c in chunks(data, size)][-1]
+        assert bytes(dump.data) == data and not dump.gap
+
+    def test_lost_chunk(self):
+        dump = TelemetryDump()
+        parts = chunks(bytes(range(100)), 40)
+        for chunk in parts[:1] + parts[2:]:
+            dump.feed(chunk)
+        assert dump.finished and dump.gap and len(dump.data) == 40
+
+    def test_status(self):
+        assert TELEMETRY_STATUS.size == 24
+        status = parse_telemetry_status(TELEMETRY_STATUS.pack(1, 16, 40, 9, 2, 4096, 33, 0))
+        assert status.dumping and (status.sectors, status.log_bytes, status.sequence) == (16, 4096, 33)
+        assert parse_telemetry_status(b"\x00" * 23) is None
+
+
+def test_summary_per_boot():
+    histogram = struct.pack('<10H', *([0] * 9 + [30]))
+    data = (record(1, bytes([0, 0, 0, 0]), 5) + record(2, bytes([2, 230, 1, 0]), 900) +
+            record(3, bytes([0xFF, 90, 4, 0]), 1200) + record(4, histogram, 60000) +
+            record(6, b"inference stalled", 61000) + record(1, bytes([4, 0, 0, 0]), 5))
+    lines = summarize(decode_records(data)[0])
+    assert lines[0] == "boot 0: power_on, 61 s, 30 windows, 5 low confidence, left x1"
+    assert "fatal" in lines[1] and "inference stalled" in lines[1]
+    assert lines[2].startswith("boot 1: watchdog")
+
+
+def label_histogram(index, kind, bins):
+    """A TELEMETRY_LABEL_HISTOGRAM payload."""
+    return bytes([index, kind, 0, 0]) + struct.pack(f'<{len(bins)}H', *bins)
+
+
+def test_label_histograms_and_drift():
+    assert bin_median([0] * 8) == 0.0
+    assert abs(bin_median([0, 0, 0, 0, 0, 0, 1, 3]) - 240 / 255) < 1e-9
+    first = [0] * 6 + [2, 8]    # left mostly won above 0.87
+    last = [0] * 4 + [6, 4, 0, 0]  # ... and drifted to about 0.6
+    margin = [0, 0, 0, 5, 5, 0, 0, 0]
+    data = (record(8, label_histogram(2, 0, first), 600000) + record(8, label_histogram(2, 1, margin), 600000) +
+            record(8, label_histogram(2, 0, last), 1200000) + record(8, label_histogram(2, 1, margin), 1200000))
+    records, damaged = decode_records(data)
+    assert damaged == 0
+    assert records[0].fields == {"gesture": "left", "kind": "top", "bins": first}
+    assert records[1].fields["kind"] == "margin"
+    lines = label_drift(records)
+    assert len(lines) == 1
+    assert lines[0] == "    left: 20 windows, top-1 median 0.69, margin median 0.44, top-1 median 0.94 -> 0.56"
+
+
+def test_shadow_agreement():
+    periods = [SHADOW.pack(1, 0, 500, 480, 12, 5, 3, 40, 900, 1500), SHADOW.pack(1, 0, 500, 490, 6, 3, 1, 10, 1100, 2100)]
+    production = [0] * 9 + [20]
+    candidate = [0] * 7 + [10, 10, 0]
+    data = b"".join(record(9, p, 60000 * n) for n, p in enumerate(periods))
+    data += record(10, bytes([0, 0, 0, 0]) + struct.pack('<10H', *production), 60000)
+    data += record(10, bytes([1, 1, 0, 0]) + struct.pack('<10H', *candidate), 60000)
+    records, damaged = decode_records(data)
+    assert damaged == 0 and len(records) == 4
+    assert records[0].fields["agree"] == 480 and records[0].fields["max_us"] == 1500
+    assert records[3].fields == {"model": 1, "candidate": True, "bins": candidate}
+    assert shadow_summary(records) == [
+        "    model 1 vs 0: 1000 windows, 97.0% agree, 18 candidate only, 8 production only, 4 differ, 50 deferred, "
+        "mean 1000 us, max 2100 us, top-1 median 0.95 -> 0.75"]
@@ -0,0 +1,90 @@
+import os
+import struct
+import sys
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from hypothesis import given, strategies as st, settings
+from ble_manager import TRACE_LOST, ClockSync, parse_trace
+from trace_capture import DeviceTrace, HostSpans, TraceSpan, to_chrome_trace
+
+CLOCK_HZ = 64000000
+
+
+def trace_packet(device_ms, now_cycles, zones, lost=False):
+    """Mirror of publish_trace() in src/ble_module.cpp: zones are (zone, start age, cycles)."""
+    data = struct.pack('<IIHB', device_ms, now_cycles, CLOCK_HZ // 1000, len(zones) | (TRACE_LOST if lost else 0))
+    return data + b"".join(struct.pack('<BII', *zone) for zone in zones)
+
+
+def synced_clock():
+    """A clock sync whose device ms equal host s * 1000."""
+    clock = ClockSync()
+    for host in (1.0, 2.0, 3.0):
+        clock.add(host, host, int(host * 1000))
+    return clock
+
+
+class TestParseTrace:
+    def test_round_trip(self):
+        packet = parse_trace(trace_packet(1234, 99, [(2, 640, 320), (5, 64, 32)], lost=True))
+        assert (packet.device_ms, packet.now_cycles, packet.clock_hz, packet.lost) == (1234, 99, CLOCK_HZ, True)
+        assert packet.zones == [(2, 640, 320), (5, 64, 32)]
+
+    def test_short_payloads(self):
+        data = trace_packet(1, 2, [(0, 3, 4)])
+        assert parse_trace(data[:10]) is None
+        assert parse_trace(data[:-1]) is None
+
+
+class TestDeviceTrace:
+    def test_sub_ms_placement(self):
+        # The cycle counter runs 0.3 ms behind the device clock; millis() only says which ms a packet is in,
+        # and the packet that falls early in its ms bounds the offset tightly
+        trace = DeviceTrace()
+        times = (10.05, 13.42, 16.77, 20.9, 24.3)
+        for t in times:
+            trace.add(parse_trace(trace_packet(int(t), int((t - 0.3) * CLOCK_HZ / 1000), [(2, 0, 64)])))
+        spans = trace.spans(synced_clock())
+        assert spans[0].name == "infer" and spans[0].thread == "inference"
+        # synced_clock maps device ms m to host m / 1000 - 0.0005 (the exchanges' millis() are truncated)
+        for span, t in zip(spans, times):
+            assert abs(span.start_s - (t / 1000 - 0.0005)) < 0.0001
+        assert abs(spans[0].duration_s - 1e-6) < 1e-12
+
+    def test_cycle_counter_wrap(self):
+        # 80 s between packets: the counter wrapped once (67 s at 64 MHz)
+        trace = DeviceTrace()
+        trace.add(parse_trace(trace_packet(1000, 0, [(0, 0, 64)])))
+        trace.add(parse_trace(trace_packet(81000, (80 * CLOCK_HZ) % (1 << 32), [(0, 0, 64)])))
+        first, second = trace.spans(synced_clock())
+        assert abs((second.start_s - first.start_s) - 80.0) < 0.002
+
+    def test_not_placed_before_clock_sync(self):
+        trace = DeviceTrace()
+        trace.add(parse_trace(trace_packet(1, 2, [(0, 0, 1)], lost=True)))
+        assert trace.spans(ClockSync()) == [] and trace.lost == 1
+
+    @given(ages=st.lists(st.integers(0, 6400000), min_size=1, max_size=20))
+    @settings(max_examples=50)
+    def test_ages_keep_their_order(self, ages):
+        trace = DeviceTrace()
+        trace.add(parse_trace(trace_packet(5000, 5000 * (CLOCK_HZ // 1000), [(1, age, 10) for age in ages])))
+        starts = [span.start_s for span in trace.spans(synced_clock())]
+        for (age_a, start_a), (age_b, start_b) in zip(zip(ages, starts), zip(ages[1:], starts[1:])):
+            assert abs((start_a - start_b) * CLOCK_HZ - (age_b - age_a)) < 1
+
+
+class TestChromeTrace:
+    def test_processes_and_lanes(self):
+        host = HostSpans()
+        with host.span("gesture left"):
+            pass
+        device = [TraceSpan("classify", "inference", host.spans[0].start_s - 0.01, 0.005),
+                  TraceSpan("acquire", "sampler", host.spans[0].start_s - 0.02, 0.001)]
+        trace = to_chrome_trace(device, host.spans)
+        names = {(e["pid"], e.get("tid")): e["args"]["name"] for e in trace["traceEvents"] if e["ph"] == "M"}
+        assert names[(1, None)] == "device" and names[(2, None)] == "pc_controller"
+        assert names[(1, 1)] == "sampler" and names[(1, 2)] == "inference" and names[(2, 1)] == "callbacks"
+        complete = [e for e in trace["traceEvents"] if e["ph"] == "X"]
+        assert [e["name"] for e in complete] == ["acquire", "classify", "gesture left"]
+        assert complete[0]["ts"] == 0.0 and complete[1]["ts"] == 10000.0
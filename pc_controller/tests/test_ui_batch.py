@@ -0,0 +1,29 @@
+import os
+import sys
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from hypothesis import given, strategies as st, settings
+from ui_batch import LatestValues, RingBuffer
+
+
+class TestRingBuffer:
+    @given(items=st.lists(st.integers(), max_size=100), capacity=st.integers(min_value=1, max_value=20))
+    @settings(max_examples=100)
+    def test_keeps_the_newest_and_counts_the_rest(self, items, capacity):
+        ring = RingBuffer(capacity)
+        for item in items:
+            ring.append(item)
+        kept, dropped = ring.drain()
+        assert kept == items[-capacity:] if items else kept == []
+        assert dropped == max(len(items) - capacity, 0)
+        assert ring.drain() == ([], 0)
+
+
+class TestLatestValues:
+    def test_only_the_newest_value_is_taken(self):
+        latest = LatestValues()
+        for confidence in (0.7, 0.8, 0.9):
+            latest.put("gesture", ("left", confidence))
+        latest.put("action", ("left", "right"))
+        assert latest.take() == {"gesture": ("left", 0.9), "action": ("left", "right")}
+        assert latest.take() == {}
@@ -0,0 +1,83 @@
+import os
+import struct
+import sys
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from hypothesis import given, strategies as st, settings
+from ble_manager import parse_event_burst, parse_layout, parse_layout_confidence, parse_layout_schema, parse_trace
+from serial_manager import parse_hello, parse_hello_confidence, parse_hello_schema
+from wire_schema import (CONFIDENCE_FORMAT, EVENT, EVENT_HEADER, GESTURE, HEARTBEAT, LEGACY_CONFIDENCE, ONSET, RESULT,
+                         SCHEMA_VERSION, STAT_DISTRIBUTION, STAT_DISTRIBUTION_KIND, STAT_HEADER, STAT_MAX, parse_stat,
+                         SCORES_HEADER, TRACE_HEADER, TRACE_LOST, TRACE_ZONE, ConfidenceFormat, iter_records,
+                         schema_warning)
+
+event_st = st.tuples(st.integers(-1, 127), st.integers(0, 255), st.integers(0, 0xFFFF), st.integers(0, 0xFFFFFFFF))
+
+
+class TestLayouts:
+    def test_sizes_match_the_firmware(self):
+        # static_asserts in include/wire_schema.h
+        assert (RESULT.size, EVENT.size, EVENT_HEADER.size, GESTURE.size, CONFIDENCE_FORMAT.size) == (4, 8, 3, 8, 5)
+        assert HEARTBEAT.size == EVENT.size
+        assert ONSET.size == 11
+        assert (SCORES_HEADER.size, TRACE_HEADER.size, TRACE_ZONE.size) == (8, 11, 9)
+        assert (STAT_HEADER.size, STAT_DISTRIBUTION.size) == (4, 20)
+
+    def test_stat_records(self):
+        stat = parse_stat(STAT_HEADER.pack(2, 5, STAT_MAX, 6) + b"q.high" + struct.pack('<I', 77))
+        assert (stat.index, stat.count, stat.name, stat.value, stat.distribution) == (2, 5, "q.high", 77, None)
+        data = STAT_HEADER.pack(0, 1, STAT_DISTRIBUTION_KIND, 1) + b"d" + STAT_DISTRIBUTION.pack(9, 50, 10, 20, 40)
+        assert parse_stat(data).distribution.p90 == 20
+        assert parse_stat(data[:-1]) is None and parse_stat(STAT_HEADER.pack(0, 1, 9, 0) + bytes(20)) is None
+
+    def test_event_starts_with_a_result(self):
+        assert RESULT.unpack_from(EVENT.pack(-1, 200, 7, 1234)) == (-1, 200, 7)
+
+    @given(events=st.lists(event_st, max_size=8), offset=st.integers(0, 3))
+    @settings(max_examples=50)
+    def test_iter_records_round_trip(self, events, offset):
+        data = bytes(offset) + b"".join(EVENT.pack(*e) for e in events) + b"\x01"
+        assert list(iter_records(EVENT, data, offset)) == events
+        assert list(iter_records(EVENT, data, offset, 1)) == events[:1]
+
+    @given(events=st.lists(event_st, min_size=1, max_size=5), delivery=st.integers(0, 0xFFFF))
+    @settings(max_examples=30)
+    def test_event_burst(self, events, delivery):
+        dropped, decoded = parse_event_burst(EVENT_HEADER.pack(2, delivery) + b"".join(EVENT.pack(*e) for e in events))
+        assert dropped == 2 and [(e.index, e.sequence, e.timestamp_ms) for e in decoded] == \
+            [(i, s, t) for i, _, s, t in events]
+
+    def test_event_confidence_is_dequantized_with_the_device_format(self):
+        data = EVENT_HEADER.pack(0, 1) + EVENT.pack(2, 192, 5, 100)
+        assert parse_event_burst(data)[1][0].confidence == 192 / 255
+        assert parse_event_burst(data, ConfidenceFormat(0, 1 / 256))[1][0].confidence == 0.75
+
+    def test_trace_reads_only_the_counted_zones(self):
+        data = TRACE_HEADER.pack(100, 6400, 64000, 1 | TRACE_LOST) + TRACE_ZONE.pack(2, 640, 3200) + bytes(TRACE_ZONE.size)
+        packet = parse_trace(data)
+        assert packet.lost and packet.zones == [(2, 640, 3200)]
+
+
+class TestSchemaVersion:
+    def test_hello_and_layout(self):
+        assert parse_hello(bytes([0x03, 1, SCHEMA_VERSION])) == (0x03, 1)
+        assert parse_hello_schema(bytes([0x03, 1, SCHEMA_VERSION])) == SCHEMA_VERSION
+        assert parse_hello_schema(bytes([0x03, 1])) is None
+        layout = struct.pack('<IB', 0xDEADBEEF, SCHEMA_VERSION)
+        assert parse_layout(layout) == 0xDEADBEEF and parse_layout_schema(layout) == SCHEMA_VERSION
+        assert parse_layout_schema(layout[:4]) is None
+
+    def test_confidence_format_follows_the_version(self):
+        layout = struct.pack('<IB', 0xDEADBEEF, SCHEMA_VERSION) + CONFIDENCE_FORMAT.pack(0, 1 / 256)
+        assert parse_layout_confidence(layout) == ConfidenceFormat(0, 1 / 256)
+        hello = bytes([0x03, 1, SCHEMA_VERSION]) + CONFIDENCE_FORMAT.pack(128, 0.5)
+        assert parse_hello_confidence(hello) == ConfidenceFormat(128, 0.5)
+        # Older firmware, or a format that cannot be right, decodes as x 255
+        assert parse_layout_confidence(layout[:5]) == LEGACY_CONFIDENCE
+        assert parse_hello_confidence(bytes([0x03, 1, 1])) == LEGACY_CONFIDENCE
+        assert parse_hello_confidence(bytes([0x03, 1, 2]) + CONFIDENCE_FORMAT.pack(0, 0.0)) == LEGACY_CONFIDENCE
+
+    def test_warning_only_for_a_newer_device(self):
+        assert schema_warning(None) is None
+        assert schema_warning(SCHEMA_VERSION) is None
+        assert "newer" in schema_warning(SCHEMA_VERSION + 1)
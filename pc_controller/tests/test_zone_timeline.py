@@ -0,0 +1,59 @@
+import os
+import sys
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from hypothesis import given, strategies as st, settings
+from zone_timeline import ZoneSpan, assign_depths, parse_dump, summary, to_chrome_trace, to_svg
+
+CLOCK_HZ = 64000000
+
+
+def dump_lines(records, recorded=None):
+    """Mirror of profiler_module_dump() in src/profiler_module.cpp: (zone, start_age, cycles) oldest first."""
+    lines = [f"[Zones] clock {CLOCK_HZ} recorded {len(records) if recorded is None else recorded} count {len(records)}\n",
+             "[Zones] zone 0 acquire sampler\n", "[Zones] zone 2 infer inference\n",
+             "[Zones] zone 3 classify inference\n"]
+    lines += [f"[Zones] Z {zone} {age} {cycles}\n" for zone, age, cycles in records]
+    return lines + ["[Zones] end\n"]
+
+
+class TestParseDump:
+    def test_times_and_overwritten(self):
+        # infer 640 cycles (10 us) from age 6400, classify nested 5 us inside it, acquire on another thread
+        lines = ["boot log\n"] + [f"[USB] {line}" for line in dump_lines(
+            [(2, 6400, 640), (3, 6336, 320), (0, 3200, 64)], recorded=10)]
+        dump = parse_dump(lines)
+        infer, classify, acquire = dump.spans
+        assert (infer.start_us, infer.duration_us, infer.depth) == (0.0, 10.0, 0)
+        assert (classify.start_us, classify.duration_us, classify.depth) == (1.0, 5.0, 1)
+        assert (acquire.thread, acquire.start_us, acquire.depth) == ("sampler", 50.0, 0)
+        assert dump.overwritten == 7
+
+    def test_incomplete_dump_is_ignored(self):
+        complete = dump_lines([(0, 100, 10)])
+        assert parse_dump(complete[:-1]) is None
+        assert len(parse_dump(complete + complete[:-1]).spans) == 1
+
+    def test_summary_and_outputs(self):
+        dump = parse_dump(dump_lines([(2, 6400, 640), (3, 6336, 320), (2, 3200, 1280)]))
+        rows = {row[0]: row for row in summary(dump)}
+        assert rows["infer"][2:] == (2, 15.0, 20.0, 20.0)
+        trace = to_chrome_trace(dump)
+        complete = [event for event in trace["traceEvents"] if event["ph"] == "X"]
+        assert [event["name"] for event in complete] == ["infer", "classify", "infer"]
+        assert to_svg(dump).count("<rect") == 3
+
+
+class TestDepths:
+    @given(spans=st.lists(st.tuples(st.integers(0, 1000), st.integers(0, 200)), max_size=30))
+    @settings(max_examples=100)
+    def test_depth_counts_enclosing_spans(self, spans):
+        zones = [ZoneSpan(0, "z", "inference", float(start), float(length)) for start, length in spans]
+        assign_depths(zones)
+        ordered = sorted(zones, key=lambda s: (s.start_us, -s.duration_us))
+        for i, span in enumerate(ordered):
+            # Each enclosing span still open when this one starts is one level up
+            assert span.depth <= i
+            if span.depth > 0:
+                parents = [p for p in ordered[:i] if p.end_us > span.start_us and p.depth == span.depth - 1]
+                assert parents
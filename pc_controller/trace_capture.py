@@ -0,0 +1,187 @@
+"""
+Trace Capture
+
+Records the firmware's zone trace stream together with spans of the host's own
+work and writes both as one Chrome trace (JSON) on the host clock: open it in
+ui.perfetto.dev to see a gesture go from the sampler through inference and the
+BLE notification to the host's callback. The device threads (sampler,
+inference, ble, events) are one process, pc_controller another.
+
+The stream needs firmware built with BLE_TRACE_STREAM_ENABLE (env
+nano33ble_zones) and runs over BLE or the USB link. Each packet carries
+millis() and the cycle counter read together: the clock sync (ClockSync) maps
+millis() onto the host clock, and the cycle counter places the zones within the
+millisecond. Unlike zone_timeline.py, which reads one ring dump, the capture
+runs as long as it is left to run.
+
+Host spans are the gesture callbacks by default; other code can add its own
+with HostSpans.span(). The host's spans land in the same file without any
+conversion since they are taken on the clock the sync maps onto.
+
+Usage:
+    python trace_capture.py -o trace.json                        # scan over BLE, capture 10 s
+    python trace_capture.py --port /dev/ttyACM0 --seconds 30 -o trace.json
+"""
+
+import argparse
+import asyncio
+import json
+import sys
+import time
+from contextlib import contextmanager
+from dataclasses import dataclass
+from typing import Iterator, List, Optional, Tuple
+
+from ble_manager import ClockSync, TracePacket
+from zone_timeline import THREAD_ORDER
+
+# Mirror of kZoneTable in src/profiler_module.cpp: (name, thread) per zone id
+ZONES = (("acquire", "sampler"), ("window", "inference"), ("infer", "inference"), ("classify", "inference"),
+         ("postprocess", "inference"), ("ble", "ble"), ("led", "events"))
+HOST_THREAD = "callbacks"
+CYCLE_WRAP = 1 << 32
+
+
+@dataclass
+class TraceSpan:
+    """One zone or host span; start in host seconds (perf_counter)."""
+    name: str
+    thread: str
+    start_s: float
+    duration_s: float
+
+
+class DeviceTrace:
+    """Trace packets placed on the device's millis() scale to better than a millisecond.
+
+    millis() is truncated, so a packet's true device time lies in [ms, ms + 1); the cycle counter read with it is
+    not. Every packet therefore bounds the offset between the two clocks from below, and the largest bound of the
+    packets around one (window of them, short enough to follow the drift between the CPU clock and the millis()
+    clock) is its offset. The cycle counter wraps every 67 s at 64 MHz; millis() tells how many times it did.
+    """
+
+    def __init__(self, window: int = 64):
+        self.window = window
+        # (unwrapped device ms, unwrapped cycle counter in ms, packet)
+        self._packets: List[Tuple[int, float, TracePacket]] = []
+        self._last: Optional[Tuple[int, int]] = None  # (unwrapped ms, unwrapped cycles) of the newest packet
+        self.lost = 0
+
+    def add(self, packet: TracePacket) -> None:
+        if self._last is None:
+            ms, cycles = packet.device_ms, packet.now_cycles
+        else:
+            last_ms, last_cycles = self._last
+            ms = last_ms + ((packet.device_ms - last_ms) % ClockSync.WRAP_MS)
+            expected = last_cycles + (ms - last_ms) * packet.clock_hz / 1000.0
+            cycles = packet.now_cycles + round((expected - packet.now_cycles) / CYCLE_WRAP) * CYCLE_WRAP
+        self._last = (ms, cycles)
+        self._packets.append((ms, cycles * 1000.0 / packet.clock_hz, packet))
+        self.lost += packet.lost
+
+    def __len__(self) -> int:
+        return len(self._packets)
+
+    def spans(self, clock: ClockSync) -> List[TraceSpan]:
+        """The zones on the host clock (an empty list before the clock sync has an offset)."""
+        if not clock.ready:
+            return []
+        bounds = [ms - cycle_ms for ms, cycle_ms, _ in self._packets]
+        half = self.window // 2
+        spans = []
+        for i, (_, cycle_ms, packet) in enumerate(self._packets):
+            offset = max(bounds[max(0, i - half):i + half + 1])
+            now_ms = (cycle_ms + offset) % ClockSync.WRAP_MS
+            scale = 1000.0 / packet.clock_hz
+            for zone, age, cycles in packet.zones:
+                name, thread = ZONES[zone] if zone < len(ZONES) else (f"zone{zone}", "?")
+                start = clock.to_host_exact(now_ms - age * scale)
+                spans.append(TraceSpan(name, thread, start, cycles * scale / 1000.0))
+        return spans
+
+
+class HostSpans:
+    """Spans of the host's own work, on the clock the device zones are mapped onto."""
+
+    def __init__(self):
+        self.spans: List[TraceSpan] = []
+
+    @contextmanager
+    def span(self, name: str, thread: str = HOST_THREAD) -> Iterator[None]:
+        start = time.perf_counter()
+        try:
+            yield
+        finally:
+            self.spans.append(TraceSpan(name, thread, start, time.perf_counter() - start))
+
+
+def to_chrome_trace(device: List[TraceSpan], host: List[TraceSpan], lost: int = 0) -> dict:
+    """Chrome trace events: pid 1 the device, pid 2 the host, one tid per thread; µs from the earliest span."""
+    origin = min((span.start_s for span in device + host), default=0.0)
+    events = []
+    for pid, process, spans, order in ((1, "device", device, THREAD_ORDER), (2, "pc_controller", host, ())):
+        threads = {span.thread for span in spans}
+        lanes = [t for t in order if t in threads] + sorted(threads - set(order))
+        tids = {thread: i + 1 for i, thread in enumerate(lanes)}
+        events.append({"ph": "M", "name": "process_name", "pid": pid, "args": {"name": process}})
+        events += [{"ph": "M", "name": "thread_name", "pid": pid, "tid": tid, "args": {"name": thread}}
+                   for thread, tid in tids.items()]
+        for span in sorted(spans, key=lambda s: (s.start_s, -s.duration_s)):
+            events.append({"ph": "X", "name": span.name, "cat": span.thread, "pid": pid, "tid": tids[span.thread],
+                           "ts": round((span.start_s - origin) * 1e6, 3), "dur": round(span.duration_s * 1e6, 3)})
+    return {"traceEvents": events, "displayTimeUnit": "ns", "otherData": {"lost_packets": lost}}
+
+
+async def run(args) -> int:
+    if args.port:
+        from serial_manager import SerialManager
+        manager = SerialManager()
+    else:
+        from ble_manager import BLEManager
+        manager = BLEManager()
+    device = DeviceTrace()
+    host = HostSpans()
+
+    def on_gesture(gesture: str, confidence: float) -> None:
+        with host.span(f"gesture {gesture}"):
+            print(f"[Trace] {gesture} ({confidence:.2f})")
+
+    manager.set_auto_reconnect(False)
+    manager.set_trace_callback(device.add)
+    manager.set_gesture_callback(on_gesture)
+    address = args.port or args.address
+    connected = await manager.connect(address) if address else await manager.scan_and_connect()
+    if not connected:
+        print("[Trace] Device not connected")
+        return 1
+    try:
+        print(f"[Trace] Capturing for {args.seconds:g} s")
+        await asyncio.sleep(args.seconds)
+    finally:
+        await manager.disconnect()
+
+    if not len(device):
+        print("[Trace] No trace packets (firmware without BLE_TRACE_STREAM_ENABLE?)")
+        return 1
+    zones = device.spans(manager.clock_sync())
+    if not zones:
+        print("[Trace] The clock sync never got an offset; device zones cannot be placed")
+        return 1
+    with open(args.output, "w", encoding="utf-8") as f:
+        json.dump(to_chrome_trace(zones, host.spans, device.lost), f)
+    lost = f", {device.lost} packets after overwritten zones" if device.lost else ""
+    print(f"[Trace] {len(zones)} device zones and {len(host.spans)} host spans written to {args.output}{lost}")
+    return 0
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    parser = argparse.ArgumentParser(description="Capture the device zone trace and host spans as a Perfetto trace")
+    parser.add_argument("--port", help="serial port of the board (default: BLE)")
+    parser.add_argument("--address", help="BLE device address (default: scan by name)")
+    parser.add_argument("--seconds", type=float, default=10.0, help="how long to capture")
+    parser.add_argument("-o", "--output", default="trace.json", help="Chrome trace JSON to write")
+    return asyncio.run(run(parser.parse_args(argv)))
+
+
+if __name__ == "__main__":
+    sys.exit(main())
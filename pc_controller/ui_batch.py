@@ -0,0 +1,53 @@
+"""
+UI Batch Module
+
+Hands values from the transport and key-injection threads to the Tk loop in batches:
+bounded rings (log lines, status changes) and latest-value slots, all drained once per GUI tick
+instead of one root.after() callback per event.
+"""
+
+import threading
+from collections import deque
+from typing import Any, Dict, List, Tuple
+
+
+class RingBuffer:
+    """Items waiting for the GUI, at most capacity: when it falls behind, the oldest are dropped and counted."""
+
+    def __init__(self, capacity: int):
+        self._items: deque = deque(maxlen=max(1, capacity))
+        self._dropped = 0
+        self._lock = threading.Lock()
+
+    def append(self, item: Any) -> None:
+        with self._lock:
+            if len(self._items) == self._items.maxlen:
+                self._dropped += 1
+            self._items.append(item)
+
+    def drain(self) -> Tuple[List[Any], int]:
+        """The waiting items, oldest first, and how many were dropped since the last drain."""
+        with self._lock:
+            items = list(self._items)
+            dropped = self._dropped
+            self._items.clear()
+            self._dropped = 0
+        return items, dropped
+
+
+class LatestValues:
+    """Slots where only the newest value matters (the gesture shown, action feedback); take() empties them."""
+
+    def __init__(self):
+        self._values: Dict[str, Any] = {}
+        self._lock = threading.Lock()
+
+    def put(self, key: str, value: Any) -> None:
+        with self._lock:
+            self._values[key] = value
+
+    def take(self) -> Dict[str, Any]:
+        with self._lock:
+            values = self._values
+            self._values = {}
+        return values
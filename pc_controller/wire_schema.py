@@ -0,0 +1,144 @@
+"""
+Wire Schema
+
+Record layouts the firmware sends over BLE notifications, USB frames and the
+flash diagnostics log (include/wire_schema.h). Each record is a packed
+little-endian C struct the device fills in place, so the host reads fields
+straight out of the received buffer: Struct.unpack_from at an offset, or
+Struct.iter_unpack over a memoryview slice for a run of records, without
+copying or re-parsing.
+
+Layouts only grow at the end (a decoder checks the length before reading a
+newer field); a change to an existing field bumps SCHEMA_VERSION. The device
+reports its version in the USB hello reply and after the BLE layout hash.
+
+Statistics (the firmware's registry of counters and distributions, see
+include/stats_module.h) are variable-length: a header, the name, then the value.
+
+Schema 2 sends the result confidence as one byte quantized with the model's
+output tensor parameters. The device reports them once, after the schema
+version (ConfidenceFormat), and the host dequantizes; the gesture record's
+confidence shrank from uint16 x 65535 to that byte. Schema 1 bytes are x 255,
+and so are the flash log's.
+"""
+
+import struct
+from typing import Iterator, NamedTuple, Optional, Tuple
+
+SCHEMA_VERSION = 2
+
+# wire_result_t: int8 label index (-1 = none), uint8 quantized confidence, uint16 sequence (low 16 bits)
+RESULT = struct.Struct('<bBH')
+# wire_event_t: a wire_result_t and the uint32 publish time in ms
+EVENT = struct.Struct('<bBHI')
+# wire_event_burst_t: uint8 events dropped (saturating), uint16 delivery number of the first event
+EVENT_HEADER = struct.Struct('<BH')
+# wire_heartbeat_t: int8 HEARTBEAT_MARKER in place of the label index, uint8 operating point (0xFF = no battery
+# ladder), uint16 battery mV (0 = not measured), uint32 millis(); the last record of an events notification
+HEARTBEAT = struct.Struct('<bBHI')
+HEARTBEAT_MARKER = -2
+# wire_onset_t: int8 label index, uint8 ONSET_* state, uint16 onset number (low 16 bits), uint8 quantized
+# prefix-head confidence, uint16 sequence of the confirming result (0 otherwise), uint32 sampling-clock ms
+ONSET = struct.Struct('<bBHBHI')
+ONSET_PROVISIONAL = 0
+ONSET_CONFIRMED = 1
+ONSET_CANCELED = 2
+# wire_gesture_t: uint8 label index (0xFF = none yet), uint8 quantized confidence, uint16 sequence, uint32 ms
+GESTURE = struct.Struct('<BBHI')
+# wire_gesture_t of schema 1: the confidence was uint16 x 65535 (told apart by the length)
+GESTURE_V1 = struct.Struct('<BHHI')
+# wire_confidence_format_t: uint8 zero point, float32 scale
+CONFIDENCE_FORMAT = struct.Struct('<Bf')
+# wire_scores_t: uint16 first sequence, uint8 label count, int8 zero point, float32 scale
+SCORES_HEADER = struct.Struct('<HBbf')
+# wire_trace_t: uint32 millis(), uint32 cycle counter, uint16 clock in kHz, uint8 count with TRACE_LOST
+TRACE_HEADER = struct.Struct('<IIHB')
+# wire_trace_zone_t: uint8 zone, uint32 start age in cycles, uint32 cycles
+TRACE_ZONE = struct.Struct('<BII')
+TRACE_LOST = 0x80
+# wire_stat_t: uint8 registry index, uint8 registered count, uint8 STAT_* kind, uint8 name length; the name follows,
+# then a uint32 (counter, maximum) or a STAT_DISTRIBUTION (include/stats_module.h)
+STAT_HEADER = struct.Struct('<BBBB')
+# wire_stat_distribution_t: uint32 count, max, p50, p90, p99
+STAT_DISTRIBUTION = struct.Struct('<5I')
+STAT_COUNTER = 1
+STAT_MAX = 2
+STAT_DISTRIBUTION_KIND = 3
+
+
+def iter_records(layout: struct.Struct, data: bytes, offset: int = 0, count: Optional[int] = None) -> Iterator[Tuple]:
+    """Fields of consecutive records from offset (count of them, or as many as fit), without copying data."""
+    available = (len(data) - offset) // layout.size if len(data) > offset else 0
+    n = available if count is None else min(count, available)
+    return layout.iter_unpack(memoryview(data)[offset:offset + n * layout.size])
+
+
+class ConfidenceFormat(NamedTuple):
+    """Quantization of the result confidence byte: confidence = (byte - zero_point) * scale."""
+    zero_point: int = 0
+    scale: float = 1.0 / 255
+
+    def value(self, confidence: int) -> float:
+        return min(max((confidence - self.zero_point) * self.scale, 0.0), 1.0)
+
+
+# Firmware before schema 2 and the flash log
+LEGACY_CONFIDENCE = ConfidenceFormat()
+
+
+def confidence_format(data: bytes, offset: int) -> ConfidenceFormat:
+    """Confidence format at offset of a hello reply or layout value; LEGACY_CONFIDENCE from older firmware."""
+    if len(data) < offset + CONFIDENCE_FORMAT.size:
+        return LEGACY_CONFIDENCE
+    zero_point, scale = CONFIDENCE_FORMAT.unpack_from(data, offset)
+    return ConfidenceFormat(zero_point, scale) if scale > 0 else LEGACY_CONFIDENCE
+
+
+class Distribution(NamedTuple):
+    count: int
+    max: int
+    p50: int
+    p90: int
+    p99: int
+
+
+class Stat(NamedTuple):
+    """One entry of the firmware's statistics registry: value for a counter or maximum, distribution otherwise."""
+    index: int
+    count: int          # entries registered on the device
+    kind: int           # STAT_COUNTER, STAT_MAX or STAT_DISTRIBUTION_KIND
+    name: str
+    value: int = 0
+    distribution: Optional[Distribution] = None
+
+    def describe(self) -> str:
+        if self.distribution is None:
+            return f"{self.name} {self.value}"
+        d = self.distribution
+        return f"{self.name} n {d.count} p50 {d.p50} p90 {d.p90} p99 {d.p99} max {d.max}"
+
+
+def parse_stat(data: bytes) -> Optional[Stat]:
+    """Decode a statistics notification / STAT_READ reply; None when truncated or of an unknown kind."""
+    if len(data) < STAT_HEADER.size:
+        return None
+    index, count, kind, name_length = STAT_HEADER.unpack_from(data)
+    offset = STAT_HEADER.size + name_length
+    name = bytes(data[STAT_HEADER.size:offset]).decode("utf-8", errors="replace")
+    if kind == STAT_DISTRIBUTION_KIND and len(data) >= offset + STAT_DISTRIBUTION.size:
+        return Stat(index, count, kind, name, distribution=Distribution(*STAT_DISTRIBUTION.unpack_from(data, offset)))
+    if kind in (STAT_COUNTER, STAT_MAX) and len(data) >= offset + 4:
+        return Stat(index, count, kind, name, struct.unpack_from('<I', data, offset)[0])
+    return None
+
+
+def schema_version(data: bytes, offset: int) -> Optional[int]:
+    """Schema version byte at offset of a hello reply or layout value; None from firmware before the schema."""
+    return data[offset] if len(data) > offset else None
+
+
+def schema_warning(version: Optional[int]) -> Optional[str]:
+    """Message when the device writes a schema this host does not know, None when it can be decoded."""
+    if version is None or version <= SCHEMA_VERSION:
+        return None
+    return f"device wire schema {version} is newer than this host's {SCHEMA_VERSION}; update pc_controller"
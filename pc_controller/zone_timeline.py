@@ -0,0 +1,238 @@
+"""
+Zone Timeline
+
+Renders the firmware's zone profiler dump (include/profiler_module.h) as a
+timeline: one lane per thread, nested zones (classify inside infer) stacked
+below their parent like a flame chart. The firmware only stores cycle counts
+into a ring; this script turns them into time.
+
+Get a dump with the serial command "zones" on a PROFILER_ZONES_ENABLE=1 build
+(env nano33ble_zones), or from a host replay built with it and run with --zones
+(the dump goes to stderr). Any capture works: lines before and after the dump,
+and prefixes such as "[USB] ", are skipped.
+
+Outputs, by the extension of -o:
+    .json   Chrome trace events (open in chrome://tracing or ui.perfetto.dev)
+    .svg    a self-contained SVG timeline
+    .html   the same SVG in a page
+A per-zone summary (count, mean, p95, max in µs) is printed either way.
+
+Usage:
+    python zone_timeline.py capture.log -o zones.html
+    python zone_timeline.py --port /dev/ttyACM0 -o zones.json
+    .pio/build/host_replay/program data/left.01.csv --zones 2> zones.log
+"""
+
+import argparse
+import json
+import re
+import sys
+from dataclasses import dataclass, field
+from typing import Dict, Iterable, List, Optional, Tuple
+
+from percentiles import percentile
+
+ZONE_LINE = re.compile(r"\[Zones\] (.*)$")
+# Lane order in the outputs; threads the firmware adds later go after these
+THREAD_ORDER = ("sampler", "inference", "ble", "events")
+
+
+@dataclass
+class ZoneSpan:
+    """One recorded zone: start relative to the oldest record, in µs."""
+    zone: int
+    name: str
+    thread: str
+    start_us: float
+    duration_us: float
+    depth: int = 0
+
+    @property
+    def end_us(self) -> float:
+        return self.start_us + self.duration_us
+
+
+@dataclass
+class ZoneDump:
+    clock_hz: int
+    recorded: int
+    zones: Dict[int, Tuple[str, str]] = field(default_factory=dict)
+    spans: List[ZoneSpan] = field(default_factory=list)
+
+    @property
+    def overwritten(self) -> int:
+        """Zones recorded before the oldest one still in the ring."""
+        return max(self.recorded - len(self.spans), 0)
+
+
+def parse_dump(lines: Iterable[str]) -> Optional[ZoneDump]:
+    """The last complete dump in the lines, None when there is none."""
+    dump: Optional[ZoneDump] = None
+    ages: List[Tuple[int, int, int]] = []
+    last: Optional[ZoneDump] = None
+    for line in lines:
+        match = ZONE_LINE.search(line.rstrip("\r\n"))
+        if match is None:
+            continue
+        fields = match.group(1).split()
+        if not fields:
+            continue
+        if fields[0] == "clock" and len(fields) >= 4:
+            dump = ZoneDump(int(fields[1]), int(fields[3]))
+            ages = []
+        elif dump is None:
+            continue
+        elif fields[0] == "zone" and len(fields) >= 4:
+            dump.zones[int(fields[1])] = (fields[2], fields[3])
+        elif fields[0] == "Z" and len(fields) >= 4:
+            ages.append((int(fields[1]), int(fields[2]), int(fields[3])))
+        elif fields[0] == "end":
+            _place_spans(dump, ages)
+            last = dump
+            dump = None
+    return last
+
+
+def _place_spans(dump: ZoneDump, ages: List[Tuple[int, int, int]]) -> None:
+    if dump.clock_hz <= 0:
+        return
+    scale = 1e6 / dump.clock_hz
+    oldest = max((age for _, age, _ in ages), default=0)
+    for zone, age, cycles in ages:
+        name, thread = dump.zones.get(zone, (f"zone{zone}", "?"))
+        dump.spans.append(ZoneSpan(zone, name, thread, (oldest - age) * scale, cycles * scale))
+    assign_depths(dump.spans)
+
+
+def assign_depths(spans: List[ZoneSpan]) -> None:
+    """Nesting depth of each span within its thread: a span inside another one sits one level below it."""
+    by_thread: Dict[str, List[ZoneSpan]] = {}
+    for span in spans:
+        by_thread.setdefault(span.thread, []).append(span)
+    for lane in by_thread.values():
+        # Parents first: earlier start, and the longer one of two that start together
+        lane.sort(key=lambda s: (s.start_us, -s.duration_us))
+        open_spans: List[ZoneSpan] = []
+        for span in lane:
+            while open_spans and open_spans[-1].end_us <= span.start_us:
+                open_spans.pop()
+            span.depth = len(open_spans)
+            open_spans.append(span)
+
+
+def summary(dump: ZoneDump) -> List[Tuple[str, str, int, float, float, float]]:
+    """(zone, thread, count, mean µs, p95 µs, max µs) per zone, in zone order."""
+    rows = []
+    for zone, (name, thread) in sorted(dump.zones.items()):
+        durations = [s.duration_us for s in dump.spans if s.zone == zone]
+        if durations:
+            rows.append((name, thread, len(durations), sum(durations) / len(durations),
+                         percentile(durations, 0.95), max(durations)))
+    return rows
+
+
+def lanes(dump: ZoneDump) -> List[str]:
+    threads = {span.thread for span in dump.spans}
+    known = [t for t in THREAD_ORDER if t in threads]
+    return known + sorted(threads - set(known))
+
+
+def to_chrome_trace(dump: ZoneDump) -> dict:
+    """Chrome trace event format: complete events, one tid per thread lane."""
+    tids = {thread: i + 1 for i, thread in enumerate(lanes(dump))}
+    events = [{"ph": "M", "name": "thread_name", "pid": 1, "tid": tid, "args": {"name": thread}}
+              for thread, tid in tids.items()]
+    for span in sorted(dump.spans, key=lambda s: (s.start_us, -s.duration_us)):
+        events.append({"ph": "X", "name": span.name, "cat": span.thread, "pid": 1, "tid": tids[span.thread],
+                       "ts": round(span.start_us, 3), "dur": round(span.duration_us, 3)})
+    return {"traceEvents": events, "displayTimeUnit": "ns",
+            "otherData": {"clock_hz": dump.clock_hz, "recorded": dump.recorded}}
+
+
+# Zone colours for the SVG, cycled by zone id
+COLOURS = ("#4e79a7", "#f28e2b", "#e15759", "#76b7b2", "#59a14f", "#edc948", "#b07aa1", "#ff9da7")
+
+
+def to_svg(dump: ZoneDump, width: int = 1600, row_height: int = 18) -> str:
+    """A timeline of the whole ring: lanes top to bottom, zones as boxes, nested ones one row lower."""
+    margin, label_width = 10, 80
+    total_us = max((s.end_us for s in dump.spans), default=1.0) or 1.0
+    scale = (width - label_width - 2 * margin) / total_us
+    rows: List[str] = []
+    y = margin + 20
+    for thread in lanes(dump):
+        spans = [s for s in dump.spans if s.thread == thread]
+        depth = max(s.depth for s in spans) + 1
+        rows.append(f'<text x="{margin}" y="{y + row_height - 5}" font-size="12">{thread}</text>')
+        for span in spans:
+            x = label_width + margin + span.start_us * scale
+            w = max(span.duration_us * scale, 0.5)
+            top = y + span.depth * row_height
+            colour = COLOURS[span.zone % len(COLOURS)]
+            rows.append(f'<rect x="{x:.2f}" y="{top}" width="{w:.2f}" height="{row_height - 2}" fill="{colour}">'
+                        f'<title>{span.name} {span.duration_us:.1f} us @ {span.start_us / 1000:.3f} ms</title></rect>')
+            if w > 7 * len(span.name):
+                rows.append(f'<text x="{x + 2:.2f}" y="{top + row_height - 6}" font-size="10" fill="white">'
+                            f'{span.name}</text>')
+        y += depth * row_height + 10
+    header = (f'<text x="{margin}" y="{margin + 10}" font-size="12">{len(dump.spans)} zones over '
+              f'{total_us / 1000:.1f} ms ({dump.overwritten} older ones overwritten)</text>')
+    return (f'<svg xmlns="http://www.w3.org/2000/svg" width="{width}" height="{y + margin}" '
+            f'font-family="sans-serif">{header}{"".join(rows)}</svg>')
+
+
+def read_port(port: str, timeout_s: float = 5.0) -> List[str]:
+    """Ask the board for a dump over its serial console and collect the lines up to its end."""
+    import serial  # pyserial
+    lines = []
+    with serial.Serial(port, 115200, timeout=timeout_s) as ser:
+        ser.reset_input_buffer()
+        ser.write(b"zones\n")
+        while True:
+            line = ser.readline().decode("utf-8", errors="replace")
+            if not line:
+                break
+            lines.append(line)
+            if line.rstrip().endswith("[Zones] end") or "[Zones] disabled" in line:
+                break
+    return lines
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Render the firmware zone profiler dump as a timeline")
+    parser.add_argument("capture", nargs="?", help="serial log or replay stderr with a dump (default: stdin)")
+    parser.add_argument("--port", help="read a fresh dump from this serial port instead")
+    parser.add_argument("-o", "--output", help="write a .json trace, .svg or .html timeline")
+    args = parser.parse_args()
+
+    if args.port:
+        lines = read_port(args.port)
+    elif args.capture:
+        with open(args.capture, encoding="utf-8", errors="replace") as f:
+            lines = f.readlines()
+    else:
+        lines = sys.stdin.readlines()
+    dump = parse_dump(lines)
+    if dump is None or not dump.spans:
+        print("No zone dump found (build with -DPROFILER_ZONES_ENABLE=1 and send \"zones\")", file=sys.stderr)
+        return 1
+
+    print(f"{len(dump.spans)} zones at {dump.clock_hz / 1e6:g} MHz, {dump.overwritten} older ones overwritten")
+    print(f"{'zone':<12}{'thread':<11}{'count':>6}{'mean':>9}{'p95':>9}{'max':>9}  us")
+    for name, thread, count, mean, p95, worst in summary(dump):
+        print(f"{name:<12}{thread:<11}{count:>6}{mean:>9.1f}{p95:>9.1f}{worst:>9.1f}")
+    if args.output:
+        if args.output.endswith(".json"):
+            text = json.dumps(to_chrome_trace(dump))
+        elif args.output.endswith(".html"):
+            text = f"<!DOCTYPE html><html><body>{to_svg(dump)}</body></html>"
+        else:
+            text = to_svg(dump)
+        with open(args.output, "w", encoding="utf-8") as f:
+            f.write(text)
+        print(f"Wrote {args.output}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
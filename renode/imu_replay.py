@@ -0,0 +1,45 @@
+# Renode Python peripheral: the recorded IMU FIFO read by src/renode/renode_imu.cpp.
+#
+# The data file is written by pc_controller/renode_bench.py; its path is taken
+# from the IMU_REPLAY_DATA environment variable when the machine is created:
+#   "IMUR", uint16 ODR (Hz), uint8 channel mask, uint8 0, uint32 frames,
+#   then per frame 6 little-endian int16 (accX/Y/Z, gyrX/Y/Z; absent channels 0).
+#
+# Registers (32-bit, read-only):
+#   0x00 ID    0x494D5552 ("IMUR")
+#   0x04 ODR   sample rate of the recording (Hz)
+#   0x08 MASK  channels in the recording (bit i = board channel i)
+#   0x0C LEFT  frames not read yet
+#   0x10 DATA  next word of the FIFO, 3 words per frame (0 once empty)
+# Pacing is the firmware's business: it reads as many frames as virtual time says were sampled.
+
+import struct
+from System import Environment
+
+if request.isInit:
+    path = Environment.GetEnvironmentVariable("IMU_REPLAY_DATA")
+    odr, mask, words = 0, 0, ()
+    if path:
+        with open(path, "rb") as f:
+            data = f.read()
+        if len(data) >= 12 and data[:4] == "IMUR":
+            odr, mask, _, frames = struct.unpack_from("<HBBI", data, 4)
+            words = struct.unpack_from("<%dI" % (frames * 3), data, 12)
+    position = 0
+elif request.isRead:
+    if request.offset == 0x00:
+        request.value = 0x494D5552
+    elif request.offset == 0x04:
+        request.value = odr
+    elif request.offset == 0x08:
+        request.value = mask
+    elif request.offset == 0x0C:
+        request.value = (len(words) - position) // 3
+    elif request.offset == 0x10:
+        if position < len(words):
+            request.value = words[position]
+            position += 1
+        else:
+            request.value = 0
+    else:
+        request.value = 0
@@ -0,0 +1,213 @@
+// Edge Impulse SDK 分配器模块实现
+#include <Arduino.h>
+#include "rtos.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "app_config.h"
+#include "alloc_module.h"
+#include "block_pool.h"
+#include "memory_module.h"
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+
+// arena 与块池按 8 字节对齐返回（与 newlib malloc 相同）
+#define ALLOC_ALIGN 8
+
+// ==================== 内部状态（模块私有） ====================
+
+// SDK 可能在任意线程中分配，所有状态受 g_alloc_mutex 保护
+static rtos::Mutex g_alloc_mutex;
+
+alignas(ALLOC_ALIGN) static uint8_t g_arena[ALLOC_ARENA_BYTES];
+static size_t g_arena_used = 0;
+// 最后一次 arena 分配的起点（只有它能被释放回收），SIZE_MAX = 无
+static size_t g_arena_last = SIZE_MAX;
+static bool g_sealed = false;
+
+static BlockPool<ALLOC_POOL_SMALL_BYTES, ALLOC_POOL_SMALL_BLOCKS> g_small_pool;
+static BlockPool<ALLOC_POOL_MEDIUM_BYTES, ALLOC_POOL_MEDIUM_BLOCKS> g_medium_pool;
+static BlockPool<ALLOC_POOL_LARGE_BYTES, ALLOC_POOL_LARGE_BLOCKS> g_large_pool;
+
+static uint32_t g_allocations = 0;
+static uint32_t g_heap_fallbacks = 0;
+static uint32_t g_failed = 0;
+static uint32_t g_heap_in_use = 0;
+
+// ==================== 内部辅助函数 ====================
+
+static void* arena_allocate(size_t size) {
+    const size_t rounded = (size + ALLOC_ALIGN - 1) & ~(size_t)(ALLOC_ALIGN - 1);
+    if (rounded > ALLOC_ARENA_BYTES - g_arena_used) {
+        return nullptr;
+    }
+    g_arena_last = g_arena_used;
+    g_arena_used += rounded;
+    return &g_arena[g_arena_last];
+}
+
+static bool in_arena(const void* ptr) {
+    const uint8_t* p = static_cast<const uint8_t*>(ptr);
+    return p >= g_arena && p < g_arena + ALLOC_ARENA_BYTES;
+}
+
+static void* pool_allocate(size_t size) {
+    // 按大小取最小的一档；这一档用尽时借用更大的一档
+    void* ptr = nullptr;
+    if (size <= ALLOC_POOL_SMALL_BYTES) {
+        ptr = g_small_pool.allocate();
+    }
+    if (!ptr && size <= ALLOC_POOL_MEDIUM_BYTES) {
+        ptr = g_medium_pool.allocate();
+    }
+    if (!ptr && size <= ALLOC_POOL_LARGE_BYTES) {
+        ptr = g_large_pool.allocate();
+    }
+    return ptr;
+}
+
+static void* allocate(size_t size) {
+    if (size == 0) {
+        size = 1;
+    }
+    g_alloc_mutex.lock();
+    g_allocations++;
+    void* ptr = g_sealed ? pool_allocate(size) : arena_allocate(size);
+    if (!ptr && g_sealed) {
+        // 初始化之后仍可能有罕见的大块分配：arena 剩余的部分也可用，只是不再回收
+        ptr = arena_allocate(size);
+    }
+#if ALLOC_HEAP_FALLBACK
+    if (!ptr) {
+        ptr = malloc(size);
+        if (ptr) {
+            g_heap_fallbacks++;
+            g_heap_in_use++;
+        }
+    }
+#endif
+    if (!ptr) {
+        g_failed++;
+    }
+    g_alloc_mutex.unlock();
+    return ptr;
+}
+
+template <typename Pool>
+static void pool_stats(const Pool& pool, alloc_pool_stats_t* out) {
+    out->block_bytes = (uint16_t)Pool::kBlockBytes;
+    out->blocks = (uint16_t)Pool::kBlockCount;
+    out->in_use = (uint16_t)pool.in_use();
+    out->peak = (uint16_t)pool.peak();
+}
+
+// ==================== SDK 移植层接口 ====================
+
+void* ei_malloc(size_t size) {
+    return allocate(size);
+}
+
+void* ei_calloc(size_t nitems, size_t size) {
+    if (size != 0 && nitems > SIZE_MAX / size) {
+        g_alloc_mutex.lock();
+        g_failed++;
+        g_alloc_mutex.unlock();
+        return nullptr;
+    }
+    void* ptr = allocate(nitems * size);
+    if (ptr) {
+        memset(ptr, 0, nitems * size);
+    }
+    return ptr;
+}
+
+void ei_free(void* ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+    g_alloc_mutex.lock();
+    if (in_arena(ptr)) {
+        // arena 只回收最后一次分配（初始化阶段常见的"临时缓冲区立即释放"），其余留到重启
+        if (g_arena_last != SIZE_MAX && ptr == &g_arena[g_arena_last]) {
+            g_arena_used = g_arena_last;
+            g_arena_last = SIZE_MAX;
+        }
+    } else if (g_small_pool.owns(ptr)) {
+        g_small_pool.release(ptr);
+    } else if (g_medium_pool.owns(ptr)) {
+        g_medium_pool.release(ptr);
+    } else if (g_large_pool.owns(ptr)) {
+        g_large_pool.release(ptr);
+    } else {
+        free(ptr);
+        g_heap_in_use--;
+    }
+    g_alloc_mutex.unlock();
+}
+
+// ==================== 公共接口实现 ====================
+
+void alloc_module_seal() {
+    g_alloc_mutex.lock();
+    const bool first = !g_sealed;
+    g_sealed = true;
+    g_arena_last = SIZE_MAX;
+    g_alloc_mutex.unlock();
+    if (first) {
+        memory_module_register("ei alloc arena", ALLOC_ARENA_BYTES, false);
+        memory_module_register("ei alloc pools",
+                               ALLOC_POOL_SMALL_BYTES * ALLOC_POOL_SMALL_BLOCKS +
+                                   ALLOC_POOL_MEDIUM_BYTES * ALLOC_POOL_MEDIUM_BLOCKS +
+                                   ALLOC_POOL_LARGE_BYTES * ALLOC_POOL_LARGE_BLOCKS,
+                               false);
+    }
+}
+
+void alloc_module_get_stats(alloc_stats_t* out_stats) {
+    if (!out_stats) {
+        return;
+    }
+    g_alloc_mutex.lock();
+    out_stats->arena_bytes = ALLOC_ARENA_BYTES;
+    out_stats->arena_used = (uint32_t)g_arena_used;
+    pool_stats(g_small_pool, &out_stats->pools[0]);
+    pool_stats(g_medium_pool, &out_stats->pools[1]);
+    pool_stats(g_large_pool, &out_stats->pools[2]);
+    out_stats->allocations = g_allocations;
+    out_stats->heap_fallbacks = g_heap_fallbacks;
+    out_stats->failed = g_failed;
+    out_stats->heap_in_use = g_heap_in_use;
+    g_alloc_mutex.unlock();
+}
+
+void alloc_module_report() {
+    static uint32_t last_allocations = 0;
+    static uint32_t last_ms = 0;
+    alloc_stats_t stats;
+    alloc_module_get_stats(&stats);
+    const uint32_t now_ms = millis();
+    const uint32_t elapsed_ms = now_ms - last_ms;
+    // 每秒分配次数以 0.1 为单位的整数打印（与 memory_module 的平均分配次数相同），报告行长度有上界
+    const uint64_t rate_x10 = elapsed_ms > 0 ? (stats.allocations - last_allocations) * 10000ull / elapsed_ms : 0;
+    const uint32_t per_second_x10 = rate_x10 > UINT32_MAX ? UINT32_MAX : (uint32_t)rate_x10;
+    last_allocations = stats.allocations;
+    last_ms = now_ms;
+
+    // 所有计数取最大值时约 152 字符
+    char line[160];
+    snprintf(line, sizeof(line), "[Alloc] arena %lu/%lu B, %lu allocations (%lu.%lu/s), %lu heap fallbacks (%lu live), %lu failed",
+             (unsigned long)stats.arena_used, (unsigned long)stats.arena_bytes, (unsigned long)stats.allocations,
+             (unsigned long)(per_second_x10 / 10), (unsigned long)(per_second_x10 % 10),
+             (unsigned long)stats.heap_fallbacks, (unsigned long)stats.heap_in_use,
+             (unsigned long)stats.failed);
+    Serial.println(line);
+    for (size_t i = 0; i < ALLOC_POOL_COUNT; i++) {
+        const alloc_pool_stats_t& pool = stats.pools[i];
+        snprintf(line, sizeof(line), "[Alloc]   pool %3u B x %2u: %2u in use, peak %2u", (unsigned)pool.block_bytes,
+                 (unsigned)pool.blocks, (unsigned)pool.in_use, (unsigned)pool.peak);
+        Serial.println(line);
+    }
+    if (stats.heap_fallbacks > 0 || stats.failed > 0) {
+        Serial.println("[Alloc] pools too small for the SDK's allocations, raise ALLOC_ARENA_BYTES / ALLOC_POOL_*");
+    }
+}
@@ -0,0 +1,93 @@
+// 电量分级模块实现
+#include <Arduino.h>
+
+#include "app_config.h"
+#include "battery_module.h"
+#include "inference_module.h"
+#include "log_module.h"
+
+// ==================== 内部状态（模块私有） ====================
+
+// 进入各工作点的电压（mV），下标即 inference_power_point_t；满速没有进入阈值
+static const uint16_t kEnterMillivolts[INFERENCE_POWER_POINT_COUNT] = {
+    0, BATTERY_COARSE_MV, BATTERY_IDLE_FILTER_MV, BATTERY_ON_DEMAND_MV};
+
+// 只由主线程写；读者只读 32 位以内的字段，不加锁
+static volatile uint16_t g_millivolts = 0;
+static volatile uint32_t g_version = 0;
+// 按电压选出的工作点（滞回以它为准；生效的工作点还取决于主机的请求，见 inference_set_host_power_point）
+static inference_power_point_t g_point = INFERENCE_POWER_FULL;
+static uint32_t g_last_poll_ms = 0;
+
+// ==================== 内部辅助函数 ====================
+
+/**
+ * @brief 用 SAADC 测量电池电压（Mbed 核心的 analogRead 即一次 SAADC 单次转换）
+ * @return uint16_t 电池电压（mV）
+ */
+static uint16_t measure_millivolts() {
+    uint32_t sum = 0;
+    for (int i = 0; i < BATTERY_ADC_SAMPLES; i++) {
+        sum += analogRead(BATTERY_ADC_PIN);
+    }
+    const float pin_v = (float)sum / BATTERY_ADC_SAMPLES / 4095.0f * BATTERY_ADC_FULL_SCALE_V;
+    const float battery_mv = pin_v * BATTERY_DIVIDER_RATIO * 1000.0f;
+    return (uint16_t)(battery_mv > 65535.0f ? 65535.0f : battery_mv);
+}
+
+/**
+ * @brief 按电压选择工作点：低于下一级的进入阈值时降级，高于本级阈值加滞回时回升（一次可跨多级）
+ */
+static inference_power_point_t select_point(inference_power_point_t current, uint16_t millivolts) {
+    size_t point = current;
+    while (point + 1 < INFERENCE_POWER_POINT_COUNT && millivolts < kEnterMillivolts[point + 1]) {
+        point++;
+    }
+    while (point > 0 && millivolts >= kEnterMillivolts[point] + BATTERY_HYSTERESIS_MV) {
+        point--;
+    }
+    return (inference_power_point_t)point;
+}
+
+static void update() {
+    const uint16_t millivolts = measure_millivolts();
+    const inference_power_point_t previous = g_point;
+    const inference_power_point_t point = select_point(previous, millivolts);
+    g_millivolts = millivolts;
+    if (point != previous) {
+        LOG_INFO("[Battery] %u mV: %s -> %s\n", (unsigned)millivolts, inference_power_point_name(previous),
+                  inference_power_point_name(point));
+        g_point = point;
+        inference_set_power_point(point);
+    }
+    g_version++;
+}
+
+// ==================== 公共接口实现 ====================
+
+void battery_module_init() {
+    analogReadResolution(12);
+    update();
+    g_last_poll_ms = millis();
+    LOG_INFO("[Battery] %u mV, power point %s (thresholds %d / %d / %d mV)\n", (unsigned)g_millivolts,
+              inference_power_point_name(inference_get_power_point()), BATTERY_COARSE_MV, BATTERY_IDLE_FILTER_MV,
+              BATTERY_ON_DEMAND_MV);
+}
+
+void battery_module_poll() {
+    const uint32_t now_ms = millis();
+    if (now_ms - g_last_poll_ms < BATTERY_POLL_MS) {
+        return;
+    }
+    g_last_poll_ms = now_ms;
+    update();
+}
+
+uint32_t battery_module_get(battery_state_t* out_state) {
+    const uint32_t version = g_version;
+    if (out_state) {
+        out_state->millivolts = g_millivolts;
+        out_state->point = (uint8_t)inference_get_power_point();
+    }
+    return version;
+}
@@ -1,92 +1,2841 @@
 #include <Arduino.h>
 #include <ArduinoBLE.h>
+#include <utility/ATT.h>
+#include <utility/HCI.h>
+#include <utility/HCITransport.h>
 #include "rtos.h"
 #include <chrono>
+#include <stdio.h>
+#include <string.h>
 
+#include "app_config.h"
+#include "battery_module.h"
 #include "ble_module.h"
+#include "boot_module.h"
+#include "capture_module.h"
+#include "combo_module.h"
+#include "config_module.h"
+#include "crash_module.h"
+#include "energy_module.h"
+#include "fewshot_module.h"
+#include "heap_guard_module.h"
+#include "hid_module.h"
+#include "imu_module.h"
 #include "inference_module.h"
+#include "l2cap_module.h"
+#include "latency_module.h"
+#include "log_module.h"
+#include "model_module.h"
+#include "model_slot_module.h"
+#include "periodic_timer.h"
+#include "pipeline_module.h"
+#include "profiler_module.h"
+#include "record_format.h"
+#include "record_module.h"
+#include "stats_module.h"
+#include "supervisor_module.h"
+#include "telemetry_module.h"
+#include "thread_module.h"
+#include "usb_link_module.h"
+#include "watchdog_module.h"
+#include "wire_schema.h"
 
 namespace {
 
 // Custom service/characteristic UUIDs (randomly generated).
 BLEService g_dataService("19B10010-E8F2-537E-4F6C-D104768A1214");
-BLEStringCharacteristic g_predictionCharacteristic(
-    "19B10011-E8F2-537E-4F6C-D104768A1214", BLERead | BLENotify, 32);
-BLEFloatCharacteristic g_confidenceCharacteristic(
-    "19B10012-E8F2-537E-4F6C-D104768A1214", BLERead | BLENotify);
+#if BLE_LEGACY_RESULT_CHARACTERISTICS
+// Latest result as a label string and a float confidence (two notifications per
+// result); superseded by the gesture characteristic, kept for older hosts.
+// Plain characteristics written from stack buffers: the String and typed
+// wrappers build a heap String / temporary per write. Same sizes and
+// properties as those wrappers, so hosts see no difference.
+constexpr size_t kLegacyLabelBytes = 32;
+BLECharacteristic g_predictionCharacteristic(
+    "19B10011-E8F2-537E-4F6C-D104768A1214", BLERead | BLENotify, kLegacyLabelBytes);
+BLECharacteristic g_confidenceCharacteristic(
+    "19B10012-E8F2-537E-4F6C-D104768A1214", BLERead | BLENotify, sizeof(float), true);
+#endif
+// Latest result in one notification (wire_gesture_t): uint8 label index
+// (0xFF = none yet), uint8 quantized confidence (format in the layout
+// characteristic), uint16 sequence (low 16 bits), uint32 publish time in ms,
+// little-endian.
+constexpr size_t kGestureBytes = sizeof(wire_gesture_t);
+BLECharacteristic g_gestureCharacteristic(
+    "19B1001B-E8F2-537E-4F6C-D104768A1214", BLERead | BLENotify, kGestureBytes);
+// Sampling diagnostics: sample_timing_stats_t as six little-endian uint32
+// (samples, mean interval us, p99 jitter us, max jitter us, dropped, duplicated).
+BLECharacteristic g_diagnosticsCharacteristic(
+    "19B10013-E8F2-537E-4F6C-D104768A1214", BLERead | BLENotify, sizeof(sample_timing_stats_t));
+#if RECORD_ENABLE
+// Raw IMU recording: write a record_transport_t to start/stop, packets
+// (see record_format.h) arrive as notifications on the data characteristic.
+BLEByteCharacteristic g_recordControlCharacteristic(
+    "19B10014-E8F2-537E-4F6C-D104768A1214", BLERead | BLEWrite);
+BLECharacteristic g_recordDataCharacteristic(
+    "19B10015-E8F2-537E-4F6C-D104768A1214", BLENotify, RECORD_PACKET_MAX_BYTES);
+#endif
+// Result events in bursts (wire_event_burst_t): one byte of events dropped
+// since the previous notification (saturating), uint16 delivery number of the
+// first event, then per event (wire_event_t) int8 index, uint8 confidence
+// (0-255), uint16 sequence (low 16 bits), uint32 publish time in ms,
+// little-endian. Delivery numbers count the events notified on this connection
+// from 0, one apart, so the host sees every gap.
+// After BLE_HEARTBEAT_INTERVAL_MS without a notification a burst of just a
+// heartbeat (wire_heartbeat_t) goes out: int8 -2 in place of the index, uint8
+// operating point (0xFF = no battery ladder), uint16 battery voltage in mV,
+// uint32 millis(). It takes no delivery number; the header carries the next
+// one. While events flow they are the proof of life and no heartbeat is sent.
+constexpr size_t kEventHeaderBytes = sizeof(wire_event_burst_t);
+constexpr size_t kEventBytes = sizeof(wire_event_t);
+constexpr size_t kEventBurstBytes = kEventHeaderBytes + kEventBytes * BLE_EVENTS_PER_NOTIFICATION;
+BLECharacteristic g_eventsCharacteristic(
+    "19B10016-E8F2-537E-4F6C-D104768A1214", BLERead | BLENotify, kEventBurstBytes);
+// Missed events: writing uint16 delivery number and uint8 count notifies those
+// events again from the history of the last BLE_EVENT_HISTORY_DEPTH, in the
+// events format (dropped byte 0). Events no longer kept are skipped, so the
+// reply may start later than asked; nothing is sent for numbers not yet used.
+BLECharacteristic g_missedCharacteristic(
+    "19B10021-E8F2-537E-4F6C-D104768A1214", BLEWrite | BLEWriteWithoutResponse | BLENotify, kEventBurstBytes);
 
-constexpr std::chrono::milliseconds kBlePollInterval(100);
-constexpr float kMinConfidenceToTransmit = 0.55f;
+// Clock sync, NTP-style: writing a uint16 sequence is answered at once with
+// uint16 sequence, uint32 millis() when the write was handled, and uint16 us
+// from then until the reply was queued, little-endian. millis() is the clock
+// of the event and gesture publish times; the host keeps its own send and
+// receive times and fits this clock's offset and drift over repeated exchanges.
+constexpr size_t kTimeSyncRequestBytes = 2;
+constexpr size_t kTimeSyncReplyBytes = 8;
+BLECharacteristic g_timeSyncCharacteristic(
+    "19B10024-E8F2-537E-4F6C-D104768A1214", BLEWrite | BLEWriteWithoutResponse | BLENotify, kTimeSyncReplyBytes);
+// BLE.poll() runs every loop pass until this long after the last sync request,
+// so the rest of a round of requests is handled without the poll interval wait.
+constexpr uint32_t kTimeSyncActiveMs = 250;
+uint32_t g_time_sync_last_ms = 0;
+bool g_time_sync_active = false;
+
+// CPU utilization of the last energy window: little-endian uint16 permille for
+// active, then each energy_thread_t (sampler, inference, ble, led, record, log),
+// idle, and time outside the registered threads (0xFFFF = kernel stats unavailable).
+constexpr size_t kCpuFields = ENERGY_THREAD_COUNT + 3;
+BLECharacteristic g_cpuCharacteristic(
+    "19B10017-E8F2-537E-4F6C-D104768A1214", BLERead | BLENotify, kCpuFields * 2);
+
+// Host acknowledgement: after acting on a result event the host writes back its
+// uint16 sequence (little-endian); the device turns it into the ack latency stage.
+// A host may append the uint16 ATT MTU of its connection: the bursts are sized to
+// the smallest one among the connected centrals (ArduinoBLE keeps the exchanged
+// MTU to itself), 23 for a central that has not reported it.
+BLECharacteristic g_ackCharacteristic(
+    "19B10018-E8F2-537E-4F6C-D104768A1214", BLEWrite | BLEWriteWithoutResponse, 4);
+
+// Latency of the last statistics window, little-endian uint16 ms (0xFFFF = no
+// samples): p50 and p99 for each latency_stage_t (inference, notify, ack), then
+// notify max and notify count at or above LATENCY_SLO_MS, inference thread
+// stalls since boot, and one byte set to 1 when the last reset came from the watchdog.
+constexpr size_t kLatencyBytes = 2 * (2 * LATENCY_STAGE_COUNT + 3) + 1;
+BLECharacteristic g_latencyCharacteristic(
+    "19B10019-E8F2-537E-4F6C-D104768A1214", BLERead | BLENotify, kLatencyBytes);
+
+// Runtime configuration (runtime_config_t): uint8 profile, uint8 BLE minimum
+// confidence and uint8 LED threshold (0-255), uint8 fine and coarse stride in
+// samples, uint16 BLE poll interval in ms, little-endian. Writing the full
+// payload applies those values as a custom profile; writing a single byte
+// switches to that config_profile_t preset. Writing 0xFE and a power point
+// (0xFF = release) is the host's operating-point command: it leaves the
+// configuration alone and lasts until the session ends. The value is notified whenever the
+// configuration changes (also from the serial "cfg" command) and persists across resets.
+constexpr size_t kConfigBytes = CONFIG_WIRE_BYTES;
+BLECharacteristic g_configCharacteristic(
+    "19B1001A-E8F2-537E-4F6C-D104768A1214", BLERead | BLEWrite | BLENotify, kConfigBytes);
+
+#if BLE_HID_ENABLE
+// HID key of every model label (hid_key_t): uint8 modifiers (0xFF = consumer
+// control) and uint8 usage (0 = no key), in label order. Written by the host
+// from its shortcut settings and kept in flash.
+constexpr size_t kKeymapBytes = 2 * GESTURE_LABEL_COUNT;
+BLECharacteristic g_keymapCharacteristic(
+    "19B10020-E8F2-537E-4F6C-D104768A1214", BLERead | BLEWrite, kKeymapBytes);
+#endif
+
+#if BLE_COMBO_ENABLE
+// Gesture combos (combo_module.h): uint8 combo count, uint16 longest gap in
+// ms between two gestures of a combo, then per combo uint8 length and that
+// many uint8 model labels, little-endian. Written by the host and kept in
+// flash; a table that does not compile (a combo inside another, idle in a
+// combo, too long) is rejected and the value goes back to the one in use.
+BLECharacteristic g_comboCharacteristic(
+    "19B1002D-E8F2-537E-4F6C-D104768A1214", BLERead | BLEWrite, COMBO_ENCODED_MAX_BYTES);
+// A completed combo: uint8 combo number, uint8 length, uint16 sequence (low 16
+// bits) of the result that completed it, uint32 publish time of its first and
+// last gesture in ms, little-endian. Gestures count once they pass
+// ble_min_confidence, like the events.
+constexpr size_t kComboEventBytes = 12;
+BLECharacteristic g_comboEventCharacteristic(
+    "19B1002E-E8F2-537E-4F6C-D104768A1214", BLERead | BLENotify, kComboEventBytes);
+#endif
+
+#if BATTERY_LADDER_ENABLE
+// Inference operating point chosen from the battery voltage (battery_module.h):
+// uint8 point (0 = full, 1 = coarse stride, 2 = idle filter, 3 = on demand),
+// uint8 flags (bit 0 = the voltage has been measured), uint16 battery voltage
+// in mV, little-endian. Notified after each measurement.
+constexpr size_t kPowerBytes = 4;
+BLECharacteristic g_powerCharacteristic(
+    "19B1002F-E8F2-537E-4F6C-D104768A1214", BLERead | BLENotify, kPowerBytes);
+#endif
+
+#if CRASH_CAPTURE_ENABLE
+// The crash before the last reset (crash_module.h), as crash_module_encode()
+// lays it out; 4 bytes with kind 0 when there was none. Set once at startup.
+BLECharacteristic g_crashCharacteristic(
+    "19B10031-E8F2-537E-4F6C-D104768A1214", BLERead, CRASH_REPORT_MAX_BYTES);
+#endif
+
+#if BLE_L2CAP_ENABLE
+// Bulk channel (l2cap_module.h): uint16 SPSM, uint16 receive MTU and uint8
+// L2CAP_BULK_VERSION, little-endian. While a central has the channel open and
+// has sent its hello, the recording, window and trace streams and the log dump
+// go over it instead of their characteristics.
+constexpr size_t kBulkInfoBytes = 5;
+BLECharacteristic g_bulkCharacteristic(
+    "19B10032-E8F2-537E-4F6C-D104768A1214", BLERead, kBulkInfoBytes);
+#endif
+
+#if INFERENCE_ONSET_HEAD
+// Provisional gesture onsets (wire_onset_t): int8 label index, uint8 state
+// (0 = provisional, 1 = confirmed, 2 = canceled), uint16 onset number, uint8
+// prefix-head confidence (result format), uint16 sequence of the result that
+// confirmed it, uint32 sampling-clock ms of the onset. Only the latest state is
+// notified; a new provisional onset implies the previous unresolved one is off.
+BLECharacteristic g_onsetCharacteristic(
+    "19B10033-E8F2-537E-4F6C-D104768A1214", BLERead | BLENotify, sizeof(wire_onset_t));
+#endif
+
+#if BLE_TRACE_STREAM_ENABLE
+// Zone trace (profiler_module.h), streamed from the moment the host subscribes
+// (wire_trace_t, then a wire_trace_zone_t per record): uint32 millis() and
+// uint32 cycle counter read together, uint16 counter clock in kHz, uint8 record
+// count (bit 7 = zones were overwritten before they could be sent), then per
+// record uint8 zone, uint32 start age (counter at the header minus the zone
+// start, cycles) and uint32 duration in cycles, little-endian.
+// The millis() anchor puts the zones on the clock sync's time scale.
+constexpr size_t kTraceHeaderBytes = sizeof(wire_trace_t);
+constexpr size_t kTraceRecordBytes = sizeof(wire_trace_zone_t);
+static_assert(kTraceHeaderBytes + kTraceRecordBytes <= 20, "one zone must fit a 23-byte-MTU notification");
+BLECharacteristic g_traceCharacteristic(
+    "19B10030-E8F2-537E-4F6C-D104768A1214", BLENotify, BLE_ATT_MTU - 3);
+bool g_trace_subscribed = false;
+uint32_t g_trace_cursor = 0;
+#endif
+
+#if MODEL_OTA_ENABLE
+// Model update control (model_slot_module.h). Commands: 0x01 start (uint8 op,
+// 3 reserved bytes, uint32 blob size, uint32 blob header crc32; erases the
+// inactive slot before the write is answered), 0x02 finish (checks the CRC and
+// hands the blob to the inference thread), 0x03 switch back to the built-in
+// weights, 0x04 abort. The value is the status: uint8 state, uint8 error,
+// uint8 active slot (0xFF = built-in weights), reserved byte, then uint32
+// bytes received, blob size and active blob version; it is notified whenever
+// state, error, slot or version changes.
+constexpr size_t kModelStatusBytes = 16;
+constexpr size_t kModelStartBytes = 12;
+constexpr uint8_t kModelStart = 0x01;
+constexpr uint8_t kModelFinish = 0x02;
+constexpr uint8_t kModelBuiltin = 0x03;
+constexpr uint8_t kModelAbort = 0x04;
+BLECharacteristic g_modelControlCharacteristic(
+    "19B10022-E8F2-537E-4F6C-D104768A1214", BLERead | BLEWrite | BLENotify, kModelStatusBytes);
+// Model blob data: uint32 offset followed by up to MTU - 7 bytes, written
+// without response in order. Every write is handled as it arrives (several can
+// land in one BLE.poll()); a gap leaves status.received at the offset to resume from.
+constexpr size_t kModelChunkHeaderBytes = 4;
+// The same chunks as records on the bulk channel (the UUID's low byte).
+constexpr uint8_t kModelDataRecord = 0x23;
+BLECharacteristic g_modelDataCharacteristic(
+    "19B10023-E8F2-537E-4F6C-D104768A1214", BLEWrite | BLEWriteWithoutResponse, BLE_ATT_MTU - 3);
+model_slot_status_t g_model_published = {0xFF, 0, 0, 0, 0, 0};
+#endif
+
+#if INFERENCE_FEWSHOT
+// Custom gestures (fewshot_module.h). Commands: 0x01 record one example of
+// uint8 class (the windows of the next FEWSHOT_CAPTURE_MS that the model does
+// not call idle), 0x02 commit the class being recorded, 0x03 erase uint8 class
+// (0xFF = all), 0x04 cancel the recording. The value is the status: uint8
+// state, uint8 error, uint8 class being recorded (0xFF = none), uint8 mask of
+// the enrolled classes, uint16 examples and windows recorded, uint32 custom
+// gestures recognized since boot, int8 last recognized class, 3 reserved bytes,
+// then uint32 its squared distance, little-endian. It is notified whenever it
+// changes, so a recognized custom gesture arrives with the result it replaces.
+constexpr size_t kFewShotStatusBytes = 20;
+constexpr uint8_t kFewShotRecord = 0x01;
+constexpr uint8_t kFewShotCommit = 0x02;
+constexpr uint8_t kFewShotErase = 0x03;
+constexpr uint8_t kFewShotCancel = 0x04;
+BLECharacteristic g_fewShotCharacteristic(
+    "19B1002A-E8F2-537E-4F6C-D104768A1214", BLERead | BLEWrite | BLENotify, kFewShotStatusBytes);
+uint8_t g_fewshot_published[kFewShotStatusBytes] = {0};
+#endif
+
+#if TELEMETRY_ENABLE
+// Field diagnostics log (telemetry_module.h). Commands: 0x00 notify the status
+// (USB hosts cannot read it), 0x01 dump the log, 0x02 stop the dump, 0x03 dump
+// the captured low-confidence windows instead (CAPTURE_ENABLE,
+// capture_module.h). The value is the status: uint8 state (0 = idle,
+// 1 = dumping the log, 2 = dumping captured windows), uint8 sectors, uint16
+// bytes waiting in RAM, then uint32 records appended since boot, records
+// dropped, bytes in flash (the length of a dump), newest sector sequence and
+// flash errors, then uint32 windows captured since boot, ambiguous windows not
+// captured (rate limit or queue full) and captured bytes in flash (the length
+// of a capture dump; all zero without CAPTURE_ENABLE), little-endian. It is
+// notified when a dump starts and ends.
+constexpr size_t kTelemetryStatusBytes = 36;
+constexpr uint8_t kTelemetryDump = 0x01;
+constexpr uint8_t kTelemetryStop = 0x02;
+constexpr uint8_t kTelemetryDumpCaptures = 0x03;
+BLECharacteristic g_telemetryCharacteristic(
+    "19B1002B-E8F2-537E-4F6C-D104768A1214", BLERead | BLEWrite | BLENotify, kTelemetryStatusBytes);
+// Dump data: uint32 offset into the dump followed by up to MTU - 7 bytes of
+// records in the order they were written (the record format is in
+// telemetry_module.h). A notification with the offset alone, equal to the dump
+// length, ends the dump.
+constexpr size_t kTelemetryChunkHeaderBytes = 4;
+BLECharacteristic g_telemetryDataCharacteristic(
+    "19B1002C-E8F2-537E-4F6C-D104768A1214", BLENotify, BLE_ATT_MTU - 3);
+// Chunks sent per pass of the BLE task; the pass repeats every kRecordPollInterval while dumping.
+constexpr size_t kTelemetryChunksPerPass = 8;
+bool g_telemetry_dumping = false;
+bool g_telemetry_captures = false;  // the running dump reads the captured windows
+uint32_t g_telemetry_offset = 0;
+#endif
+
+// Delivery counters since boot (ble_counters_t), five little-endian uint32:
+// results published, results below ble_min_confidence, notifications refused
+// while subscribed, seconds in sessions and sessions, notified with the diagnostics.
+constexpr size_t kCountersBytes = 20;
+BLECharacteristic g_countersCharacteristic(
+    "19B10025-E8F2-537E-4F6C-D104768A1214", BLERead | BLENotify, kCountersBytes);
+// One registered statistic (stats_module.h) per diagnostics interval, cycling
+// through the registry: wire_stat_t (uint8 index, uint8 registered count,
+// uint8 kind, uint8 name length), the name, then a uint32 for a counter or
+// maximum, or wire_stat_distribution_t (count, max, p50, p90, p99) for a
+// distribution. The shell's STAT_READ returns the same record.
+constexpr size_t kStatBytes = sizeof(wire_stat_t) + STATS_NAME_MAX + sizeof(wire_stat_distribution_t);
+BLECharacteristic g_statsCharacteristic(
+    "19B10034-E8F2-537E-4F6C-D104768A1214", BLERead | BLENotify, kStatBytes);
+size_t g_next_stat = 0;  // BLE thread only
+// Updated by the BLE thread without locks and registered with the stats
+// registry as ble.*; ble_module_get_counters() reads them from any thread.
+StatCounter g_published;
+StatCounter g_suppressed;
+StatCounter g_notify_failures;
+StatCounter g_sessions;
+bool g_stats_registered = false;
+volatile bool g_in_session = false;
+volatile uint32_t g_session_start_ms = 0;
+uint32_t g_connected_ms = 0;
+
+// Streams a central uses, written once after it has subscribed: uint8
+// USB_STREAM_* bits (usb_frame.h), the same as the USB hello. ArduinoBLE keeps
+// one subscription per characteristic and notifies every connected central once
+// any of them has subscribed, so each value is encoded and notified once for all
+// centrals. The declared streams pick a central's connection parameters: one
+// that takes scores, the model window, raw IMU or the zone trace stays on the
+// active profile.
+constexpr size_t kStreamsBytes = 1;
+BLECharacteristic g_streamsCharacteristic(
+    "19B10026-E8F2-537E-4F6C-D104768A1214", BLEWrite | BLEWriteWithoutResponse, kStreamsBytes);
+constexpr uint8_t kContinuousStreams = USB_STREAM_SCORES | USB_STREAM_WINDOW | USB_STREAM_RECORD | USB_STREAM_TRACE;
+
+// GATT caching: ArduinoBLE builds the Generic Attribute service itself, with
+// Service Changed but without a Database Hash, so this service carries its own:
+// uint32 FNV-1a over the UUID and properties of each characteristic in the
+// order they are added (and whether the HID services are there), little-endian.
+// It only changes with the firmware build; a host that kept the discovery of a
+// device reads it first and discovers again only when it differs. A uint8
+// WIRE_SCHEMA_VERSION (wire_schema.h) follows the hash, then the quantization
+// of the result confidence byte (wire_confidence_format_t): the host reads it
+// once per connection and dequantizes, the device never converts to float.
+// Last comes the uint16 heartbeat interval in ms (0 = no heartbeat).
+constexpr size_t kLayoutBytes = 5 + sizeof(wire_confidence_format_t) + 2;
+BLECharacteristic g_layoutCharacteristic(
+    "19B10027-E8F2-537E-4F6C-D104768A1214", BLERead, kLayoutBytes);
+constexpr uint32_t kLayoutHashBasis = 2166136261u;
+uint32_t g_layout_hash = kLayoutHashBasis;
+
+// Connection parameters last requested from the first central (the one
+// connected longest; the others are not reported): uint8 profile (0 =
+// none, the central's choice; 1 = active; 2 = idle), then uint16 minimum and
+// maximum interval (1.25 ms units), peripheral latency (connection events),
+// supervision timeout (10 ms units) and requests sent on this connection,
+// uint8 1 when the last request went out, and uint8 flags: bit 0 the controller
+// accepted the data length request, bit 1 the 2M PHY request. ArduinoBLE drops
+// the central's answers, so these are the values asked for, not necessarily
+// the ones in use; the benchmark characteristic measures what the link achieves.
+// Then time to reconnect since boot: uint8 reconnects (saturating), uint16 last,
+// mean and longest ms from a central's disconnect to the next connection (saturating).
+constexpr size_t kLinkBytes = 20;
+BLECharacteristic g_linkCharacteristic(
+    "19B1001C-E8F2-537E-4F6C-D104768A1214", BLERead | BLENotify, kLinkBytes);
+
+enum conn_profile_t { CONN_PROFILE_NONE = 0, CONN_PROFILE_ACTIVE, CONN_PROFILE_IDLE };
+struct conn_params_t {
+    uint16_t min_interval;
+    uint16_t max_interval;
+    uint16_t latency;
+    uint16_t timeout;
+};
+const conn_params_t kConnParams[] = {
+    {0, 0, 0, 0},
+    {BLE_CONN_ACTIVE_MIN_INTERVAL, BLE_CONN_ACTIVE_MAX_INTERVAL, BLE_CONN_ACTIVE_LATENCY, BLE_CONN_ACTIVE_TIMEOUT},
+    {BLE_CONN_IDLE_MIN_INTERVAL, BLE_CONN_IDLE_MAX_INTERVAL, BLE_CONN_IDLE_LATENCY, BLE_CONN_IDLE_TIMEOUT},
+};
+const char* const kConnProfileNames[] = {"none", "active", "idle"};
+constexpr uint16_t kNoConnection = 0xFFFF;
+uint8_t g_conn_identifier = 0;
+// Last motion or gesture; the idle profile is requested BLE_CONN_IDLE_AFTER_MS later.
+uint32_t g_last_activity_ms = 0;
+constexpr uint8_t kLinkDataLength = 0x01;
+constexpr uint8_t kLinkPhy2M = 0x02;
+
+// Connected centrals, oldest first: added and removed by the connect and
+// disconnect events (inside BLE.poll()); the BLE thread starts a new one
+// (link upgrade, connection parameters) on its next session pass.
+struct central_t {
+    uint16_t handle;
+    uint8_t address[6];  // HCI byte order (least significant first)
+    uint8_t address_type;
+    bool started;
+    uint8_t streams;  // USB_STREAM_* bits declared on the streams characteristic, 0 = none yet
+    uint16_t mtu;
+    conn_profile_t profile;
+    uint16_t requests;
+    bool request_sent;
+    uint8_t link_flags;
+};
+central_t g_centrals[BLE_MAX_CENTRALS];
+size_t g_central_count = 0;
+// A central left while others stay connected: advertise for it to come back.
+bool g_central_left = false;
+
+// Advertising policy (app_config.h): directed to the last central, then fast, then slow.
+enum adv_phase_t { ADV_PHASE_OFF = 0, ADV_PHASE_DIRECTED, ADV_PHASE_FAST, ADV_PHASE_SLOW };
+const char* const kAdvPhaseNames[] = {"off", "directed", "fast", "slow"};
+// High duty cycle directed advertising: the controller gives up after 1.28 s.
+constexpr uint32_t kDirectedAdvertisingMs = 1280;
+constexpr bool kAdvertisingConnectable = !BLE_BROADCAST_ENABLE || BLE_BROADCAST_CONNECTABLE;
+adv_phase_t g_adv_phase = ADV_PHASE_OFF;
+uint32_t g_adv_phase_ms = 0;
+// Central that disconnected last in HCI byte order (least significant first) and its address type.
+uint8_t g_last_central[6];
+uint8_t g_last_central_type = 0;
+bool g_last_central_valid = false;
+// Time to reconnect, from a disconnect by the central to the next connection.
+bool g_reconnect_pending = false;
+uint32_t g_disconnect_ms = 0;
+uint32_t g_reconnects = 0;
+uint32_t g_reconnect_last_ms = 0;
+uint64_t g_reconnect_total_ms = 0;
+uint32_t g_reconnect_max_ms = 0;
+
+// Throughput benchmark: writing uint16 duration in ms (and optionally the
+// uint16 ATT MTU of the connection) streams notifications of MTU - 3 bytes,
+// each starting with its uint32 index, for that long; writing 0 stops early.
+// The run ends with a summary notification: uint32 0xFFFFFFFF, then uint32
+// packets, bytes, elapsed ms and notifications the stack refused, little-endian.
+//
+// Loopback: writes of 8 bytes or more starting with uint16 0xFFFF carry uint16
+// sequence and the uint32 device time (µs) of the previous echo (0 = none),
+// then any padding. Each is echoed at once as uint32 0xFFFFFFFE, uint16
+// sequence, uint32 device time, then the padding (cut to the MTU). The device
+// time that comes back gives the round trip on the device's clock. Writing
+// uint16 0xFFFE the same way ends the session with a report: uint32 0xFFFFFFFD,
+// uint32 round trips and refused notifications, then uint16 p50, p95, p99 and
+// max round trip in 0.1 ms.
+constexpr size_t kBenchmarkMaxBytes = BLE_ATT_MTU - 3;
+constexpr uint32_t kBenchmarkSummaryMarker = 0xFFFFFFFF;
+constexpr uint32_t kBenchmarkMaxMs = 30000;
+// Notifications queued per pass before BLE.poll() runs again.
+constexpr uint32_t kBenchmarkSliceMs = 20;
+constexpr uint16_t kLoopbackEcho = 0xFFFF;
+constexpr uint16_t kLoopbackReport = 0xFFFE;
+constexpr size_t kLoopbackCommandBytes = 8;
+constexpr uint32_t kLoopbackEchoMarker = 0xFFFFFFFE;
+constexpr uint32_t kLoopbackReportMarker = 0xFFFFFFFD;
+constexpr size_t kLoopbackEchoBytes = 10;
+// BLE.poll() runs every loop pass until this long after the last loopback write.
+constexpr uint32_t kLoopbackActiveMs = 1000;
+BLECharacteristic g_benchmarkCharacteristic(
+    "19B1001D-E8F2-537E-4F6C-D104768A1214", BLEWrite | BLEWriteWithoutResponse | BLENotify, kBenchmarkMaxBytes);
+#if BLE_SCORE_STREAM_ENABLE
+// Per-inference class scores straight from the int8 output tensor
+// (wire_scores_t, then the scores): uint16 sequence of the first inference
+// (low 16 bits), uint8 label count, int8 output zero point, float32 output
+// scale, then label-count int8 scores for each of that many consecutive
+// inferences (a gap starts a new notification), little-endian.
+constexpr size_t kScoresHeaderBytes = sizeof(wire_scores_t);
+static_assert(kScoresHeaderBytes + GESTURE_LABEL_COUNT <= 20, "one inference's scores must fit a 23-byte-MTU notification");
+BLECharacteristic g_scoresCharacteristic(
+    "19B1001E-E8F2-537E-4F6C-D104768A1214", BLENotify, BLE_ATT_MTU - 3);
+bool g_scores_subscribed = false;
+#endif
+#if BLE_WINDOW_STREAM_ENABLE
+// The samples the model is fed, as RECORD_TYPE_WINDOW packets (include/record_format.h):
+// one packet per notification, sized to the MTU of this connection.
+BLECharacteristic g_windowCharacteristic(
+    "19B1001F-E8F2-537E-4F6C-D104768A1214", BLENotify, RECORD_PACKET_MAX_BYTES);
+RecordPacketEncoder g_window_encoder;
+bool g_window_subscribed = false;
+uint16_t g_window_sequence = 0;
+uint32_t g_window_since_ms = 0;
+uint8_t g_window_mask = 0;
+#endif
+#if INFERENCE_EVENT_MODE == INFERENCE_EVENTS_SEGMENTS
+// Hold state of the current gesture, notified when it is confirmed and again
+// when it ends (the end wakes the task at once): int8 label index, uint8 state
+// (1 = held, 0 = released), uint16 sequence of the result published at the
+// onset (low 16 bits), uint32 start and end in ms on the sampling clock (the end
+// is the onset's while held), little-endian. A host repeats a held gesture's
+// action until the release.
+constexpr size_t kSegmentBytes = 12;
+BLECharacteristic g_segmentCharacteristic(
+    "19B10028-E8F2-537E-4F6C-D104768A1214", BLERead | BLENotify, kSegmentBytes);
+#endif
+// On-device inference benchmark: writing uint8 mode (0 = a fixed synthetic
+// window, 1 = the next live inferences) and optionally uint16 runs starts it.
+// The report is notified (and readable) when it completes: uint8 mode, uint8
+// state (0 = none, 1 = running, 2 = done, 3 = failed), uint16 runs, then for
+// DSP, classification, postprocessing and end to end the uint32 min, p50, p95,
+// p99 and max in µs, little-endian. A notification carries only what the MTU
+// allows; the host reads the rest.
+constexpr size_t kInferenceBenchStatBytes = 5 * 4;
+constexpr size_t kInferenceBenchBytes = 4 + INFERENCE_BENCH_STAGE_COUNT * kInferenceBenchStatBytes;
+BLECharacteristic g_inferenceBenchCharacteristic(
+    "19B10029-E8F2-537E-4F6C-D104768A1214", BLERead | BLEWrite | BLENotify, kInferenceBenchBytes);
+bool g_benchmark_running = false;
+uint32_t g_benchmark_start_ms = 0;
+uint32_t g_benchmark_duration_ms = 0;
+uint32_t g_benchmark_packets = 0;
+uint32_t g_benchmark_bytes = 0;
+size_t g_benchmark_payload = 0;
+uint32_t g_benchmark_failed = 0;
+// 128 buckets of 2 ms; registered as ble.loopback_rtt_us, reset when a report is sent.
+StatHistogram<128> g_loopback_rtt(2000);
+uint32_t g_loopback_failed = 0;
+uint32_t g_loopback_last_ms = 0;
+bool g_loopback_active = false;
+
+// Sample arrival times of the most recently notified events, matched against host acks.
+struct notified_event_t {
+    uint16_t sequence;
+    uint32_t sample_us;
+};
+notified_event_t g_notified[LATENCY_ACK_TRACKED];
+size_t g_notified_next = 0;
+// Once the host has acked on this connection, BLE.poll() runs at the record
+// poll interval until the ack for the last notification arrives, so the ack
+// stage is not rounded up to the next regular poll.
+bool g_host_acks = false;
+bool g_ack_outstanding = false;
+uint32_t g_last_notify_ms = 0;
+
+// Encoded events of this connection by delivery number (slot = number % depth).
+wire_event_t g_history[BLE_EVENT_HISTORY_DEPTH];
+uint16_t g_delivery_next = 0;
+uint16_t g_history_count = 0;
+
+// Events waiting for the current burst to fill or for its latency budget to run out.
+constexpr uint16_t kDefaultAttMtu = 23;
+// Smallest MTU among the connected centrals, BLE_ATT_MTU over the USB link.
+uint16_t g_att_mtu = kDefaultAttMtu;
+inference_result_snapshot_t g_burst[BLE_EVENTS_PER_NOTIFICATION];
+size_t g_burst_count = 0;
+uint32_t g_burst_since_ms = 0;
+// Last time the events characteristic notified anything (a burst or a heartbeat).
+uint32_t g_heartbeat_since_ms = 0;
+
+// While recording over BLE the queue is drained far more often than results are published.
+constexpr std::chrono::milliseconds kRecordPollInterval(10);
+#if BLE_EVENT_DRIVEN
+// Longest wait with nothing to wake the task (heartbeat, diagnostics, advertising phases).
+constexpr std::chrono::milliseconds kEventBackstop(BLE_EVENT_BACKSTOP_MS);
+// Set by the BLE thread after each BLE.poll(): the HCI watch thread may wait for new traffic again.
+rtos::EventFlags g_hci_watch;
+constexpr uint32_t kHciDrained = 0x01;
+#endif
+constexpr uint32_t kDiagnosticsIntervalMs = IMU_RATE_WINDOW_MS;
+
+// Set while the session runs over the USB link (usb_link_module.h) instead of a
+// BLE connection: the streams go out as frames carrying the payload of the
+// characteristic, and host writes arrive as frames in its write format.
+bool g_usb_session = false;
+
+void hash_layout(const uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        g_layout_hash = (g_layout_hash ^ data[i]) * 16777619u;
+    }
+}
+
+// Adds a characteristic to the data service and to the layout hash.
+void add_characteristic(BLECharacteristic& characteristic) {
+    const char* uuid = characteristic.uuid();
+    hash_layout(reinterpret_cast<const uint8_t*>(uuid), strlen(uuid));
+    const uint8_t properties = characteristic.properties();
+    hash_layout(&properties, 1);
+    g_dataService.addCharacteristic(characteristic);
+}
+
+// BLE.poll(), then lets the HCI watch thread wait for the next HCI event.
+void poll_stack() {
+    BLE.poll();
+#if BLE_L2CAP_ENABLE
+    l2cap_module_service();
+#endif
+#if BLE_EVENT_DRIVEN
+    g_hci_watch.set(kHciDrained);
+#endif
+}
+
+/**
+ * Sends a notification on the transport of this session: the characteristic
+ * on a BLE connection, a frame of the given type on the USB link, a record on
+ * the bulk channel when its host takes that stream there.
+ */
+bool send_stream(BLECharacteristic& characteristic, uint8_t frame_type, const uint8_t* data, size_t length) {
+#if USB_LINK_ENABLE
+    if (g_usb_session) {
+        if (usb_link_module_send(frame_type, data, length)) {
+            return true;
+        }
+        if (usb_link_module_subscribed(frame_type)) {
+            g_notify_failures.add();
+        }
+        return false;
+    }
+#endif
+#if BLE_L2CAP_ENABLE
+    if (l2cap_module_subscribed(frame_type)) {
+        if (l2cap_module_send(frame_type, data, length)) {
+            return true;
+        }
+        g_notify_failures.add();
+        return false;
+    }
+#endif
+    (void)frame_type;
+    if (characteristic.writeValue(data, static_cast<int>(length))) {
+        return true;
+    }
+    if (characteristic.subscribed()) {
+        g_notify_failures.add();
+    }
+    return false;
+}
+
+// Whether the host of this session listens to the stream (CCCD on BLE, hello streams on USB and on the bulk channel).
+bool stream_subscribed(BLECharacteristic& characteristic, uint8_t frame_type) {
+#if USB_LINK_ENABLE
+    if (g_usb_session) {
+        return usb_link_module_subscribed(frame_type);
+    }
+#endif
+#if BLE_L2CAP_ENABLE
+    if (l2cap_module_subscribed(frame_type)) {
+        return true;
+    }
+#endif
+    (void)frame_type;
+    return characteristic.subscribed();
+}
+
+// Largest payload of one packet of the stream: the ATT MTU of the connection,
+// or a whole BLE_ATT_MTU-sized payload on the bulk channel.
+size_t stream_payload_bytes(uint8_t frame_type) {
+#if BLE_L2CAP_ENABLE
+    if (!g_usb_session && l2cap_module_subscribed(frame_type)) {
+        return BLE_ATT_MTU - 3;
+    }
+#else
+    (void)frame_type;
+#endif
+    return g_att_mtu - 3;
+}
+
+#if RECORD_ENABLE
+void apply_record_control(uint8_t transport) {
+    if (transport == RECORD_USB || transport == RECORD_BLE) {
+        record_module_start(static_cast<record_transport_t>(transport));
+    } else {
+        record_module_stop();
+    }
+}
+
+void handle_record_control() {
+    if (!g_recordControlCharacteristic.written()) {
+        return;
+    }
+    apply_record_control(g_recordControlCharacteristic.value());
+}
+
+void publish_record_packets() {
+    if (record_module_transport() != RECORD_BLE) {
+        return;
+    }
+    record_packet_t packet;
+    while (record_module_pop_packet(&packet)) {
+        send_stream(g_recordDataCharacteristic, USB_FRAME_RECORD_DATA, packet.bytes, packet.length);
+    }
+}
+#endif
+
+void put_u16(uint8_t* dst, uint16_t value) {
+    dst[0] = static_cast<uint8_t>(value);
+    dst[1] = static_cast<uint8_t>(value >> 8);
+}
+
+void put_u32(uint8_t* dst, uint32_t value) {
+    put_u16(dst, static_cast<uint16_t>(value));
+    put_u16(dst + 2, static_cast<uint16_t>(value >> 16));
+}
+
+uint32_t get_u32(const uint8_t* src) {
+    return src[0] | (src[1] << 8) | (src[2] << 16) | (static_cast<uint32_t>(src[3]) << 24);
+}
+
+uint16_t latency_ms(uint32_t latency_us, uint32_t count) {
+    if (count == 0) {
+        return 0xFFFF;
+    }
+    const uint32_t ms = (latency_us + 500) / 1000;
+    return static_cast<uint16_t>(ms > 0xFFFE ? 0xFFFE : ms);
+}
+
+/**
+ * Writes the latest-value interface: the packed gesture characteristic and,
+ * when enabled, the legacy label string / float confidence pair.
+ */
+void publish_latest(const inference_result_snapshot_t& result) {
+    uint8_t payload[kGestureBytes];
+    wire_gesture_t* gesture = wire_at<wire_gesture_t>(payload);
+    gesture->index = result.index >= 0 ? static_cast<uint8_t>(result.index) : 0xFF;
+    gesture->confidence = result.confidence_q;
+    gesture->sequence = static_cast<uint16_t>(result.sequence);
+    gesture->timestamp_ms = result.timestamp_ms;
+    send_stream(g_gestureCharacteristic, USB_FRAME_GESTURE, payload, sizeof(payload));
+#if BLE_LEGACY_RESULT_CHARACTERISTICS
+    // Copy and measure the label in one bounded pass (no terminator on the wire, as before).
+    const char* name = result.index >= 0 ? inference_get_category_name(result.index) : "unknown";
+    uint8_t label[kLegacyLabelBytes];
+    size_t length = 0;
+    for (; length < sizeof(label) && name[length] != '\0'; length++) {
+        label[length] = static_cast<uint8_t>(name[length]);
+    }
+    g_predictionCharacteristic.writeValue(label, static_cast<int>(length));
+    const float confidence = inference_confidence_value(result.confidence_q);
+    uint8_t confidence_bytes[sizeof(float)];
+    memcpy(confidence_bytes, &confidence, sizeof(confidence_bytes));
+    g_confidenceCharacteristic.writeValue(confidence_bytes, sizeof(confidence_bytes));
+#endif
+}
+
+// Layout hash, wire schema and confidence format. The format comes from the
+// model's output tensor, so it is written again once setup() has loaded it.
+void publish_layout() {
+    uint8_t layout[kLayoutBytes];
+    put_u32(layout, g_layout_hash);
+    layout[4] = WIRE_SCHEMA_VERSION;
+    inference_confidence_format_t format;
+    inference_get_confidence_format(&format);
+    wire_confidence_format_t* confidence = wire_at<wire_confidence_format_t>(layout + 5);
+    confidence->zero_point = format.zero_point;
+    confidence->scale = format.scale;
+    put_u16(layout + 5 + sizeof(wire_confidence_format_t), BLE_HEARTBEAT_INTERVAL_MS);
+    g_layoutCharacteristic.writeValue(layout, sizeof(layout));
+}
+
+// Returns the configuration version, so callers can tell when to re-read it.
+uint32_t publish_config() {
+    uint8_t payload[kConfigBytes];
+    const uint32_t version = config_module_encode(payload);
+    // The characteristic keeps the value in effect for the next BLE connection either way.
+    g_configCharacteristic.writeValue(payload, sizeof(payload));
+#if USB_LINK_ENABLE
+    if (g_usb_session) {
+        usb_link_module_send(USB_FRAME_CONFIG, payload, sizeof(payload));
+    }
+#endif
+    return version;
+}
+
+void apply_config(const uint8_t* value, size_t length) {
+    // A rejected write must not linger as the characteristic value: restore the one in effect.
+    if (!config_module_write(value, length)) {
+        LOG_WARN("[BLE] Config write rejected\n");
+        publish_config();
+    } else if (length == CONFIG_OPERATING_POINT_BYTES && value[0] == CONFIG_OPERATING_POINT_MARKER) {
+        // Neither does an operating-point command, which leaves the configuration unchanged.
+        publish_config();
+    }
+}
+
+void handle_config() {
+    if (!g_configCharacteristic.written()) {
+        return;
+    }
+    apply_config(g_configCharacteristic.value(), g_configCharacteristic.valueLength());
+}
+
+#if BLE_HID_ENABLE
+void publish_keymap() {
+    hid_key_t keys[GESTURE_LABEL_COUNT];
+    hid_module_get_keymap(keys, GESTURE_LABEL_COUNT);
+    uint8_t payload[kKeymapBytes];
+    for (size_t i = 0; i < GESTURE_LABEL_COUNT; i++) {
+        payload[2 * i] = keys[i].modifiers;
+        payload[2 * i + 1] = keys[i].usage;
+    }
+    g_keymapCharacteristic.writeValue(payload, sizeof(payload));
+}
+
+void handle_keymap() {
+    if (!g_keymapCharacteristic.written()) {
+        return;
+    }
+    if (g_keymapCharacteristic.valueLength() != static_cast<int>(kKeymapBytes)) {
+        LOG_WARN("[BLE] Keymap write rejected\n");
+        publish_keymap();
+        return;
+    }
+    const uint8_t* value = g_keymapCharacteristic.value();
+    hid_key_t keys[GESTURE_LABEL_COUNT];
+    for (size_t i = 0; i < GESTURE_LABEL_COUNT; i++) {
+        keys[i] = {value[2 * i], value[2 * i + 1]};
+    }
+    hid_module_set_keymap(keys, GESTURE_LABEL_COUNT);
+}
+#endif
+
+#if BLE_COMBO_ENABLE
+void publish_combos() {
+    uint8_t payload[COMBO_ENCODED_MAX_BYTES];
+    const size_t length = combo_module_encode(payload);
+    g_comboCharacteristic.writeValue(payload, static_cast<int>(length));
+#if USB_LINK_ENABLE
+    if (g_usb_session) {
+        usb_link_module_send(USB_FRAME_COMBO, payload, length);
+    }
+#endif
+}
+
+// The table in use is published after every write: a USB host learns from it whether the write was taken.
+void apply_combos(const uint8_t* value, size_t length) {
+    const combo_error_t error = combo_module_set(value, length);
+    if (error != COMBO_OK) {
+        LOG_WARN("[BLE] Combo write rejected (%s)\n", combo_module_error_name(error));
+    }
+    publish_combos();
+}
+
+void handle_combos() {
+    if (!g_comboCharacteristic.written()) {
+        return;
+    }
+    apply_combos(g_comboCharacteristic.value(), g_comboCharacteristic.valueLength());
+}
+
+void publish_combo(const combo_match_t& match, uint32_t sequence) {
+    uint8_t payload[kComboEventBytes];
+    payload[0] = static_cast<uint8_t>(match.combo);
+    payload[1] = match.length;
+    put_u16(payload + 2, static_cast<uint16_t>(sequence));
+    put_u32(payload + 4, match.start_ms);
+    put_u32(payload + 8, match.end_ms);
+    send_stream(g_comboEventCharacteristic, USB_FRAME_COMBO_EVENT, payload, sizeof(payload));
+    LOG_INFO("[BLE] Combo %d completed (%u gestures in %lu ms)\n", match.combo, (unsigned)match.length,
+             (unsigned long)(match.end_ms - match.start_ms));
+}
+#endif
+
+#if MODEL_OTA_ENABLE
+/**
+ * Publishes the model update status when anything but the byte count changed:
+ * the inference thread finishes a switch on its own schedule, so this is polled.
+ */
+void publish_model_status(bool force) {
+    model_slot_status_t status;
+    model_slot_module_get_status(&status);
+    if (!force && status.state == g_model_published.state && status.error == g_model_published.error &&
+        status.active_slot == g_model_published.active_slot && status.version == g_model_published.version) {
+        return;
+    }
+    uint8_t payload[kModelStatusBytes];
+    payload[0] = status.state;
+    payload[1] = status.error;
+    payload[2] = status.active_slot;
+    payload[3] = 0;
+    put_u32(payload + 4, status.received);
+    put_u32(payload + 8, status.total);
+    put_u32(payload + 12, status.version);
+    g_modelControlCharacteristic.writeValue(payload, sizeof(payload));
+    g_model_published = status;
+}
+
+// While a blob is coming in BLE.poll() runs every pass, like a loopback session.
+bool model_receiving() {
+    return g_model_published.state == MODEL_SLOT_RECEIVING;
+}
+
+void on_model_control(BLEDevice, BLECharacteristic characteristic) {
+    const uint8_t* value = characteristic.value();
+    const int length = characteristic.valueLength();
+    g_last_activity_ms = millis();
+    if (length < 1) {
+        return;
+    }
+    bool ok = false;
+    switch (value[0]) {
+    case kModelStart:
+        ok = length == static_cast<int>(kModelStartBytes) &&
+             model_slot_module_start(get_u32(value + 4), get_u32(value + 8));
+        break;
+    case kModelFinish:
+        ok = model_slot_module_finish();
+        break;
+    case kModelBuiltin:
+        ok = model_slot_module_request_builtin();
+        break;
+    case kModelAbort:
+        model_slot_module_abort();
+        ok = true;
+        break;
+    default:
+        break;
+    }
+    if (!ok) {
+        LOG_WARN("[BLE] Model update command 0x%02x rejected\n", (unsigned)value[0]);
+    }
+    // The written command must not linger as the value: reads return the status.
+    publish_model_status(true);
+}
+
+void apply_model_data(const uint8_t* value, size_t length) {
+    g_last_activity_ms = millis();
+    if (length <= kModelChunkHeaderBytes) {
+        return;
+    }
+    if (!model_slot_module_write(get_u32(value), value + kModelChunkHeaderBytes, length - kModelChunkHeaderBytes)) {
+        publish_model_status(true);
+    }
+}
+
+void on_model_data(BLEDevice, BLECharacteristic characteristic) {
+    apply_model_data(characteristic.value(), characteristic.valueLength());
+}
+#endif
+
+#if INFERENCE_FEWSHOT
+// Recording, commits and matches happen in the inference thread, so the status is polled.
+void publish_fewshot_status(bool force) {
+    fewshot_status_t status;
+    fewshot_module_get_status(&status);
+    uint8_t payload[kFewShotStatusBytes];
+    payload[0] = status.state;
+    payload[1] = status.error;
+    payload[2] = status.enroll_class;
+    payload[3] = status.class_mask;
+    put_u16(payload + 4, status.examples);
+    put_u16(payload + 6, status.windows);
+    put_u32(payload + 8, status.matches);
+    payload[12] = static_cast<uint8_t>(status.last_class);
+    payload[13] = payload[14] = payload[15] = 0;
+    put_u32(payload + 16, status.last_distance);
+    if (!force && memcmp(payload, g_fewshot_published, sizeof(payload)) == 0) {
+        return;
+    }
+    g_fewShotCharacteristic.writeValue(payload, sizeof(payload));
+    memcpy(g_fewshot_published, payload, sizeof(payload));
+}
+
+void on_fewshot_control(BLEDevice, BLECharacteristic characteristic) {
+    const uint8_t* value = characteristic.value();
+    const int length = characteristic.valueLength();
+    g_last_activity_ms = millis();
+    if (length < 1) {
+        return;
+    }
+    bool ok = false;
+    switch (value[0]) {
+    case kFewShotRecord:
+        ok = length >= 2 && fewshot_module_start(value[1]);
+        break;
+    case kFewShotCommit:
+        ok = fewshot_module_commit();
+        break;
+    case kFewShotErase:
+        ok = length >= 2 && fewshot_module_erase(value[1]);
+        break;
+    case kFewShotCancel:
+        fewshot_module_cancel();
+        ok = true;
+        break;
+    default:
+        break;
+    }
+    if (!ok) {
+        LOG_WARN("[BLE] Custom gesture command 0x%02x rejected\n", (unsigned)value[0]);
+    }
+    // The written command must not linger as the value: reads return the status.
+    publish_fewshot_status(true);
+}
+#endif
+
+#if TELEMETRY_ENABLE
+void publish_telemetry_status() {
+    telemetry_status_t status;
+    telemetry_module_get_status(&status);
+    uint8_t payload[kTelemetryStatusBytes] = {0};
+    payload[0] = !g_telemetry_dumping ? 0 : (g_telemetry_captures ? 2 : 1);
+    payload[1] = TELEMETRY_SECTORS;
+    put_u16(payload + 2, status.pending_bytes);
+    put_u32(payload + 4, status.records);
+    put_u32(payload + 8, status.dropped);
+    put_u32(payload + 12, status.log_bytes);
+    put_u32(payload + 16, status.sequence);
+    put_u32(payload + 20, status.flash_errors);
+#if CAPTURE_ENABLE
+    capture_status_t capture;
+    capture_module_get_status(&capture);
+    put_u32(payload + 24, capture.captured);
+    put_u32(payload + 28, capture.suppressed);
+    put_u32(payload + 32, capture.stored_bytes);
+#endif
+    send_stream(g_telemetryCharacteristic, USB_FRAME_TELEMETRY, payload, sizeof(payload));
+}
+
+void stop_telemetry_dump() {
+    if (!g_telemetry_dumping) {
+        return;
+    }
+    g_telemetry_dumping = false;
+#if CAPTURE_ENABLE
+    if (g_telemetry_captures) {
+        capture_module_dump_end();
+    } else
+#endif
+    {
+        telemetry_module_dump_end();
+    }
+    publish_telemetry_status();
+}
+
+void apply_telemetry_command(const uint8_t* value, size_t length) {
+    if (length < 1) {
+        return;
+    }
+    if (value[0] == kTelemetryDump && !g_telemetry_dumping) {
+        telemetry_module_dump_begin();
+        g_telemetry_offset = 0;
+        g_telemetry_captures = false;
+        g_telemetry_dumping = true;
+        publish_telemetry_status();
+#if CAPTURE_ENABLE
+    } else if (value[0] == kTelemetryDumpCaptures && !g_telemetry_dumping) {
+        capture_module_dump_begin();
+        g_telemetry_offset = 0;
+        g_telemetry_captures = true;
+        g_telemetry_dumping = true;
+        publish_telemetry_status();
+#endif
+    } else if (value[0] == kTelemetryStop) {
+        stop_telemetry_dump();
+    } else {
+        // A dump already running, or an unknown command: the status says which.
+        publish_telemetry_status();
+    }
+}
+
+void handle_telemetry() {
+    if (!g_telemetryCharacteristic.written()) {
+        return;
+    }
+    apply_telemetry_command(g_telemetryCharacteristic.value(), g_telemetryCharacteristic.valueLength());
+}
+
+// Sends the next chunks of a dump; a chunk that does not go out is sent again on the next pass.
+void run_telemetry_dump() {
+    if (!g_telemetry_dumping) {
+        return;
+    }
+    if (!stream_subscribed(g_telemetryDataCharacteristic, USB_FRAME_TELEMETRY_DATA)) {
+        stop_telemetry_dump();
+        return;
+    }
+    uint8_t payload[BLE_ATT_MTU - 3];
+    const size_t capacity = stream_payload_bytes(USB_FRAME_TELEMETRY_DATA) - kTelemetryChunkHeaderBytes;
+    for (size_t i = 0; i < kTelemetryChunksPerPass; i++) {
+        put_u32(payload, g_telemetry_offset);
+#if CAPTURE_ENABLE
+        const size_t length =
+            g_telemetry_captures
+                ? capture_module_dump_read(g_telemetry_offset, payload + kTelemetryChunkHeaderBytes, capacity)
+                : telemetry_module_dump_read(g_telemetry_offset, payload + kTelemetryChunkHeaderBytes, capacity);
+#else
+        const size_t length =
+            telemetry_module_dump_read(g_telemetry_offset, payload + kTelemetryChunkHeaderBytes, capacity);
+#endif
+        if (!send_stream(g_telemetryDataCharacteristic, USB_FRAME_TELEMETRY_DATA, payload,
+                         kTelemetryChunkHeaderBytes + length)) {
+            return;
+        }
+        if (length == 0) {
+            stop_telemetry_dump();
+            return;
+        }
+        g_telemetry_offset += length;
+    }
+}
+#endif
+
+// Called from BLE.poll() as the write is processed, so the reply does not wait
+// for the next pass; the wait for that poll is the only asymmetric part of the
+// round trip, and the host keeps the exchanges with the shortest round trips.
+void on_time_sync(BLEDevice, BLECharacteristic characteristic) {
+    const uint32_t received_ms = millis();
+    const uint32_t received_us = micros();
+    g_time_sync_last_ms = received_ms;
+    g_time_sync_active = true;
+    if (characteristic.valueLength() < static_cast<int>(kTimeSyncRequestBytes)) {
+        return;
+    }
+    const uint8_t* value = characteristic.value();
+    uint8_t reply[kTimeSyncReplyBytes];
+    reply[0] = value[0];
+    reply[1] = value[1];
+    put_u32(reply + 2, received_ms);
+    const uint32_t held_us = micros() - received_us;
+    put_u16(reply + 6, static_cast<uint16_t>(held_us > 0xFFFF ? 0xFFFF : held_us));
+    g_timeSyncCharacteristic.writeValue(reply, sizeof(reply));
+}
+
+bool time_sync_active() {
+    if (g_time_sync_active && millis() - g_time_sync_last_ms >= kTimeSyncActiveMs) {
+        g_time_sync_active = false;
+    }
+    return g_time_sync_active;
+}
+
+void publish_link() {
+    const central_t* central = g_central_count > 0 ? &g_centrals[0] : nullptr;
+    const conn_profile_t profile = central ? central->profile : CONN_PROFILE_NONE;
+    const conn_params_t& params = kConnParams[profile];
+    uint8_t payload[kLinkBytes];
+    payload[0] = static_cast<uint8_t>(profile);
+    put_u16(payload + 1, params.min_interval);
+    put_u16(payload + 3, params.max_interval);
+    put_u16(payload + 5, params.latency);
+    put_u16(payload + 7, params.timeout);
+    put_u16(payload + 9, central ? central->requests : 0);
+    payload[11] = central && central->request_sent ? 1 : 0;
+    payload[12] = central ? central->link_flags : 0;
+    payload[13] = static_cast<uint8_t>(g_reconnects > 0xFF ? 0xFF : g_reconnects);
+    const uint32_t mean_ms = g_reconnects == 0 ? 0 : static_cast<uint32_t>(g_reconnect_total_ms / g_reconnects);
+    put_u16(payload + 14, static_cast<uint16_t>(g_reconnect_last_ms > 0xFFFF ? 0xFFFF : g_reconnect_last_ms));
+    put_u16(payload + 16, static_cast<uint16_t>(mean_ms > 0xFFFF ? 0xFFFF : mean_ms));
+    put_u16(payload + 18, static_cast<uint16_t>(g_reconnect_max_ms > 0xFFFF ? 0xFFFF : g_reconnect_max_ms));
+    g_linkCharacteristic.writeValue(payload, sizeof(payload));
+}
+
+/**
+ * Asks the controller for the 251-byte data length and the 2M PHY on the
+ * central's connection. Either procedure settles on what both sides support,
+ * so a central without them simply stays on 1M PHY / 27-byte packets.
+ */
+void request_link_upgrade(central_t& central) {
+    central.link_flags = 0;
+    if (central.handle == kNoConnection) {
+        return;
+    }
+#if BLE_DATA_LENGTH_OCTETS
+    // HCI LE Set Data Length: handle, TX octets, TX time (us at 1M PHY, the longest case).
+    uint8_t data_length[6];
+    put_u16(data_length, central.handle);
+    put_u16(data_length + 2, BLE_DATA_LENGTH_OCTETS);
+    put_u16(data_length + 4, (BLE_DATA_LENGTH_OCTETS + 14) * 8);
+    if (HCI.sendCommand(0x2022, sizeof(data_length), data_length) == 0) {
+        central.link_flags |= kLinkDataLength;
+    }
+#endif
+#if BLE_PHY_2M_ENABLE
+    // HCI LE Set PHY: handle, all PHYs (no preference bits), TX / RX PHYs (2M), PHY options.
+    uint8_t phy[7];
+    put_u16(phy, central.handle);
+    phy[2] = 0;
+    phy[3] = 0x02;
+    phy[4] = 0x02;
+    put_u16(phy + 5, 0);
+    if (HCI.sendCommand(0x2032, sizeof(phy), phy) == 0) {
+        central.link_flags |= kLinkPhy2M;
+    }
+#endif
+    if (BLE_DATA_LENGTH_OCTETS && !(central.link_flags & kLinkDataLength)) {
+        LOG_WARN("[BLE] Controller rejected the data length request\n");
+    }
+    if (BLE_PHY_2M_ENABLE && !(central.link_flags & kLinkPhy2M)) {
+        LOG_WARN("[BLE] Controller rejected the 2M PHY request\n");
+    }
+}
+
+void stop_benchmark() {
+    if (!g_benchmark_running) {
+        return;
+    }
+    g_benchmark_running = false;
+    const uint32_t elapsed_ms = millis() - g_benchmark_start_ms;
+    uint8_t summary[20];
+    put_u32(summary, kBenchmarkSummaryMarker);
+    put_u32(summary + 4, g_benchmark_packets);
+    put_u32(summary + 8, g_benchmark_bytes);
+    put_u32(summary + 12, elapsed_ms);
+    put_u32(summary + 16, g_benchmark_failed);
+    g_benchmarkCharacteristic.writeValue(summary, sizeof(summary));
+    LOG_INFO("[BLE] Benchmark: %lu packets of %u bytes in %lu ms, %lu kbit/s, %lu refused\n",
+             (unsigned long)g_benchmark_packets, (unsigned)g_benchmark_payload, (unsigned long)elapsed_ms,
+             (unsigned long)(elapsed_ms > 0 ? (uint64_t)g_benchmark_bytes * 8 / elapsed_ms : 0),
+             (unsigned long)g_benchmark_failed);
+}
+
+uint16_t tenth_ms(uint32_t us) {
+    const uint32_t tenths = us / 100;
+    return static_cast<uint16_t>(tenths < 0xFFFF ? tenths : 0xFFFF);
+}
+
+void report_loopback() {
+    uint8_t report[20];
+    put_u32(report, kLoopbackReportMarker);
+    put_u32(report + 4, g_loopback_rtt.count());
+    put_u32(report + 8, g_loopback_failed);
+    put_u16(report + 12, tenth_ms(g_loopback_rtt.percentile(0.50f)));
+    put_u16(report + 14, tenth_ms(g_loopback_rtt.percentile(0.95f)));
+    put_u16(report + 16, tenth_ms(g_loopback_rtt.percentile(0.99f)));
+    put_u16(report + 18, tenth_ms(g_loopback_rtt.max()));
+    g_benchmarkCharacteristic.writeValue(report, sizeof(report));
+    LOG_INFO("[BLE] Loopback: %lu round trips, p50 %lu us, p99 %lu us, max %lu us, %lu refused\n",
+             (unsigned long)g_loopback_rtt.count(), (unsigned long)g_loopback_rtt.percentile(0.50f),
+             (unsigned long)g_loopback_rtt.percentile(0.99f), (unsigned long)g_loopback_rtt.max(),
+             (unsigned long)g_loopback_failed);
+    g_loopback_rtt.reset();
+    g_loopback_failed = 0;
+    g_loopback_active = false;
+}
+
+void handle_loopback(const uint8_t* value, size_t length) {
+    const uint16_t command = value[0] | (value[1] << 8);
+    if (command == kLoopbackReport) {
+        report_loopback();
+        return;
+    }
+    const uint32_t now_us = micros();
+    const uint32_t echoed_us = value[4] | (value[5] << 8) | (value[6] << 16) | ((uint32_t)value[7] << 24);
+    if (echoed_us != 0) {
+        g_loopback_rtt.record(now_us - echoed_us);
+    }
+    uint8_t echo[kBenchmarkMaxBytes];
+    size_t padding = length - kLoopbackCommandBytes;
+    if (kLoopbackEchoBytes + padding > static_cast<size_t>(g_att_mtu - 3)) {
+        padding = g_att_mtu - 3 - kLoopbackEchoBytes;
+    }
+    put_u32(echo, kLoopbackEchoMarker);
+    echo[4] = value[2];
+    echo[5] = value[3];
+    // 0 means "no previous echo" to the host, so a device time of 0 is sent as 1.
+    put_u32(echo + 6, now_us != 0 ? now_us : 1);
+    memcpy(echo + kLoopbackEchoBytes, value + kLoopbackCommandBytes, padding);
+    if (!g_benchmarkCharacteristic.writeValue(echo, kLoopbackEchoBytes + padding)) {
+        g_loopback_failed++;
+    }
+    g_loopback_last_ms = millis();
+    g_loopback_active = true;
+}
+
+bool loopback_active() {
+    if (g_loopback_active && millis() - g_loopback_last_ms >= kLoopbackActiveMs) {
+        g_loopback_active = false;
+    }
+    return g_loopback_active;
+}
+
+void handle_benchmark() {
+    if (!g_benchmarkCharacteristic.written() || g_benchmarkCharacteristic.valueLength() < 2) {
+        return;
+    }
+    const uint8_t* value = g_benchmarkCharacteristic.value();
+    const size_t length = g_benchmarkCharacteristic.valueLength();
+    if (length >= kLoopbackCommandBytes && value[0] == 0xFF && (value[1] == 0xFF || value[1] == 0xFE)) {
+        handle_loopback(value, length);
+        return;
+    }
+    const uint32_t duration_ms = value[0] | (value[1] << 8);
+    if (duration_ms == 0) {
+        stop_benchmark();
+        return;
+    }
+    // The MTU given is the benchmarking central's; the bursts stay at the smallest one of all centrals.
+    uint16_t mtu = g_att_mtu;
+    if (g_benchmarkCharacteristic.valueLength() >= 4) {
+        mtu = static_cast<uint16_t>(value[2] | (value[3] << 8));
+        mtu = mtu < kDefaultAttMtu ? kDefaultAttMtu : (mtu > BLE_ATT_MTU ? BLE_ATT_MTU : mtu);
+    }
+    g_benchmark_payload = mtu - 3;
+    g_benchmark_duration_ms = duration_ms < kBenchmarkMaxMs ? duration_ms : kBenchmarkMaxMs;
+    g_benchmark_packets = 0;
+    g_benchmark_bytes = 0;
+    g_benchmark_failed = 0;
+    g_benchmark_start_ms = millis();
+    g_benchmark_running = true;
+}
+
+// Queues notifications for one slice; ArduinoBLE blocks while the controller's buffers are full.
+void apply_inference_benchmark(const uint8_t* value, size_t length) {
+    if (length < 1) {
+        return;
+    }
+    const uint16_t runs =
+        length >= 3 ? static_cast<uint16_t>(value[1] | (value[2] << 8)) : INFERENCE_BENCHMARK_DEFAULT_RUNS;
+    if (!inference_request_benchmark(static_cast<inference_bench_mode_t>(value[0]), runs)) {
+        LOG_WARN("[BLE] Inference benchmark refused (mode %u, %u runs)\n", (unsigned)value[0], (unsigned)runs);
+    }
+}
+
+void handle_inference_benchmark() {
+    if (!g_inferenceBenchCharacteristic.written()) {
+        return;
+    }
+    apply_inference_benchmark(g_inferenceBenchCharacteristic.value(), g_inferenceBenchCharacteristic.valueLength());
+}
+
+// Sends the inference benchmark report once per completed run; *last_version is the one last sent.
+void publish_inference_benchmark(uint32_t* last_version) {
+    inference_bench_report_t report;
+    const uint32_t version = inference_get_benchmark(&report);
+    if (version == *last_version) {
+        return;
+    }
+    *last_version = version;
+    uint8_t payload[kInferenceBenchBytes];
+    payload[0] = report.mode;
+    payload[1] = report.state;
+    put_u16(payload + 2, report.runs);
+    for (size_t stage = 0; stage < INFERENCE_BENCH_STAGE_COUNT; stage++) {
+        const inference_bench_stats_t& stats = report.stages[stage];
+        uint8_t* out = payload + 4 + stage * kInferenceBenchStatBytes;
+        put_u32(out, stats.min_us);
+        put_u32(out + 4, stats.p50_us);
+        put_u32(out + 8, stats.p95_us);
+        put_u32(out + 12, stats.p99_us);
+        put_u32(out + 16, stats.max_us);
+    }
+    send_stream(g_inferenceBenchCharacteristic, USB_FRAME_INFERENCE_BENCH, payload, sizeof(payload));
+}
+
+void run_benchmark() {
+    if (!g_benchmark_running) {
+        return;
+    }
+    uint8_t packet[kBenchmarkMaxBytes];
+    for (size_t i = 4; i < g_benchmark_payload; i++) {
+        packet[i] = static_cast<uint8_t>(i);
+    }
+    const uint32_t slice_start_ms = millis();
+    while (millis() - slice_start_ms < kBenchmarkSliceMs) {
+        if (millis() - g_benchmark_start_ms >= g_benchmark_duration_ms) {
+            stop_benchmark();
+            return;
+        }
+        put_u32(packet, g_benchmark_packets);
+        if (!g_benchmarkCharacteristic.writeValue(packet, g_benchmark_payload)) {
+            g_benchmark_failed++;
+        }
+        g_benchmark_packets++;
+        g_benchmark_bytes += g_benchmark_payload;
+    }
+}
+
+/**
+ * ArduinoBLE keeps connection handles to itself: centrals are told apart by
+ * address (BLEDevice::address() prints the bytes most significant first).
+ */
+bool parse_address(BLEDevice& device, uint8_t* address) {
+    return sscanf(device.address().c_str(), "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx", &address[5], &address[4], &address[3],
+                  &address[2], &address[1], &address[0]) == 6;
+}
+
+central_t* find_central(BLEDevice& device) {
+    uint8_t address[6];
+    if (!parse_address(device, address)) {
+        return nullptr;
+    }
+    for (size_t i = 0; i < g_central_count; i++) {
+        if (memcmp(g_centrals[i].address, address, sizeof(address)) == 0) {
+            return &g_centrals[i];
+        }
+    }
+    return nullptr;
+}
+
+// The smallest MTU among the connected centrals: a notification reaches all of them.
+void update_att_mtu() {
+    uint16_t mtu = g_central_count > 0 ? BLE_ATT_MTU : kDefaultAttMtu;
+    for (size_t i = 0; i < g_central_count; i++) {
+        mtu = g_centrals[i].mtu < mtu ? g_centrals[i].mtu : mtu;
+    }
+    g_att_mtu = mtu;
+}
+
+// A central connected: advertising has stopped; the wait since a central went away on its own is timed.
+void note_connection() {
+    const adv_phase_t phase = g_adv_phase;
+    g_adv_phase = ADV_PHASE_OFF;
+    if (!g_reconnect_pending) {
+        return;
+    }
+    g_reconnect_pending = false;
+    const uint32_t elapsed_ms = millis() - g_disconnect_ms;
+    g_reconnects++;
+    g_reconnect_last_ms = elapsed_ms;
+    g_reconnect_total_ms += elapsed_ms;
+    if (elapsed_ms > g_reconnect_max_ms) {
+        g_reconnect_max_ms = elapsed_ms;
+    }
+    LOG_INFO("[BLE] Reconnected after %lu ms (%s advertising); %lu reconnects, mean %lu ms, longest %lu ms\n",
+             (unsigned long)elapsed_ms, kAdvPhaseNames[phase], (unsigned long)g_reconnects,
+             (unsigned long)(g_reconnect_total_ms / g_reconnects), (unsigned long)g_reconnect_max_ms);
+}
+
+// Connect event: the central is started by the BLE thread once the session loop gets to it.
+void on_connected(BLEDevice device) {
+    if (g_central_count == BLE_MAX_CENTRALS) {
+        LOG_WARN("[BLE] More than %u centrals connected, the new one is not served\n", (unsigned)BLE_MAX_CENTRALS);
+        return;
+    }
+    central_t& central = g_centrals[g_central_count];
+    if (!parse_address(device, central.address)) {
+        return;
+    }
+    central.handle = kNoConnection;
+    central.address_type = 0;
+    for (uint8_t type = 0; type < 2 && central.handle == kNoConnection; type++) {
+        central.handle = ATT.connectionHandle(type, central.address);
+        central.address_type = type;
+    }
+    central.started = false;
+    central.streams = 0;
+    central.mtu = kDefaultAttMtu;
+    central.profile = CONN_PROFILE_NONE;
+    central.requests = 0;
+    central.request_sent = false;
+    central.link_flags = 0;
+    g_central_count++;
+    update_att_mtu();
+    note_connection();
+    LOG_INFO("[BLE] Connected to central: %02x:%02x:%02x:%02x:%02x:%02x\n", central.address[5], central.address[4],
+             central.address[3], central.address[2], central.address[1], central.address[0]);
+}
+
+// Disconnect event: the central is kept as the target of directed advertising.
+void on_disconnected(BLEDevice device) {
+    central_t* central = find_central(device);
+    if (!central) {
+        return;
+    }
+    memcpy(g_last_central, central->address, sizeof(g_last_central));
+    g_last_central_type = central->address_type;
+    g_last_central_valid = true;
+    const size_t index = static_cast<size_t>(central - g_centrals);
+    for (size_t i = index + 1; i < g_central_count; i++) {
+        g_centrals[i - 1] = g_centrals[i];
+    }
+    g_central_count--;
+    g_central_left = true;
+    update_att_mtu();
+    LOG_INFO("[BLE] Central disconnected: %02x:%02x:%02x:%02x:%02x:%02x\n", g_last_central[5], g_last_central[4],
+             g_last_central[3], g_last_central[2], g_last_central[1], g_last_central[0]);
+}
+
+void on_streams(BLEDevice device, BLECharacteristic characteristic) {
+    central_t* central = find_central(device);
+    if (!central || characteristic.valueLength() < 1) {
+        return;
+    }
+    central->streams = characteristic.value()[0];
+    LOG_INFO("[BLE] Central %u streams 0x%02x\n", (unsigned)(central - g_centrals), (unsigned)central->streams);
+}
+
+// Ack writes carry the MTU of the writing central; handle_ack() takes the ack itself.
+void on_ack(BLEDevice device, BLECharacteristic characteristic) {
+    central_t* central = find_central(device);
+    if (!central || characteristic.valueLength() < 4) {
+        return;
+    }
+    const uint8_t* value = characteristic.value();
+    const uint16_t mtu = static_cast<uint16_t>(value[2] | (value[3] << 8));
+    central->mtu = mtu < kDefaultAttMtu ? kDefaultAttMtu : (mtu > BLE_ATT_MTU ? BLE_ATT_MTU : mtu);
+    update_att_mtu();
+}
+
+/**
+ * Sends an L2CAP connection parameter update request (the peripheral side of
+ * the procedure, accepted by every central) unless the profile is already requested.
+ */
+void request_conn_profile(central_t& central, conn_profile_t profile) {
+    if (profile == central.profile || central.handle == kNoConnection) {
+        return;
+    }
+    const conn_params_t& params = kConnParams[profile];
+    constexpr uint8_t kSignalingCid = 0x05;
+    constexpr uint8_t kConnectionParameterUpdateRequest = 0x12;
+    g_conn_identifier = g_conn_identifier == 0xFF ? 1 : g_conn_identifier + 1;
+    uint8_t request[12];
+    request[0] = kConnectionParameterUpdateRequest;
+    request[1] = g_conn_identifier;
+    put_u16(request + 2, 8);
+    put_u16(request + 4, params.min_interval);
+    put_u16(request + 6, params.max_interval);
+    put_u16(request + 8, params.latency);
+    put_u16(request + 10, params.timeout);
+    central.request_sent = HCI.sendAclPkt(central.handle, kSignalingCid, sizeof(request), request) == 0;
+    central.profile = profile;
+    central.requests++;
+    LOG_INFO("[BLE] Requested %s connection parameters for central %u: interval %u-%u x1.25 ms, latency %u\n",
+             kConnProfileNames[profile], (unsigned)(&central - g_centrals), (unsigned)params.min_interval,
+             (unsigned)params.max_interval, (unsigned)params.latency);
+    publish_link();
+}
+
+// Centrals connected since the last pass: link upgrade now, connection parameters from update_conn_params().
+void start_centrals() {
+    for (size_t i = 0; i < g_central_count; i++) {
+        central_t& central = g_centrals[i];
+        if (central.started) {
+            continue;
+        }
+        central.started = true;
+        if (central.handle == kNoConnection) {
+            LOG_WARN("[BLE] Connection handle not found, leaving connection parameters to the central\n");
+        }
+        request_link_upgrade(central);
+        publish_link();
+    }
+}
+
+/**
+ * Active while the user moves or gestures, idle after BLE_CONN_IDLE_AFTER_MS
+ * without either; a central that declared a continuous stream stays active.
+ */
+void update_conn_params() {
+#if BLE_CONN_PARAMS_ENABLE
+    const uint32_t now_ms = millis();
+#if MOTION_GATE_ENABLE
+    if (imu_module_motion_active()) {
+        g_last_activity_ms = now_ms;
+    }
+#endif
+    const conn_profile_t profile =
+        now_ms - g_last_activity_ms < BLE_CONN_IDLE_AFTER_MS ? CONN_PROFILE_ACTIVE : CONN_PROFILE_IDLE;
+    for (size_t i = 0; i < g_central_count; i++) {
+        request_conn_profile(g_centrals[i],
+                             (g_centrals[i].streams & kContinuousStreams) ? CONN_PROFILE_ACTIVE : profile);
+    }
+#endif
+}
+
+#if BLE_SCORE_STREAM_ENABLE
+/**
+ * Sends the scores queued since the last pass, as many inferences per
+ * notification as the MTU allows. Scores are only recorded while the host is subscribed.
+ */
+void publish_scores() {
+    const bool subscribed = stream_subscribed(g_scoresCharacteristic, USB_FRAME_SCORES);
+    if (subscribed != g_scores_subscribed) {
+        g_scores_subscribed = subscribed;
+        inference_scores_t stale;
+        while (inference_pop_scores(&stale)) {
+        }
+        pipeline_module_subscribe(PIPELINE_OUTPUT_SCORES, subscribed);
+    }
+    if (!subscribed) {
+        return;
+    }
+
+    float scale;
+    int32_t zero_point;
+    model_module_get_output_quantization(&scale, &zero_point);
+    uint8_t payload[BLE_ATT_MTU - 3];
+    wire_scores_t* header = wire_at<wire_scores_t>(payload);
+    header->label_count = GESTURE_LABEL_COUNT;
+    header->zero_point = static_cast<int8_t>(zero_point);
+    header->scale = scale;
+    const size_t capacity = (g_att_mtu - 3 - kScoresHeaderBytes) / GESTURE_LABEL_COUNT;
+    size_t count = 0;
+    uint32_t next_sequence = 0;
+    inference_scores_t entry;
+    while (inference_pop_scores(&entry)) {
+        if (count > 0 && (count == capacity || entry.sequence != next_sequence)) {
+            send_stream(g_scoresCharacteristic, USB_FRAME_SCORES, payload,
+                        kScoresHeaderBytes + count * GESTURE_LABEL_COUNT);
+            count = 0;
+        }
+        if (count == 0) {
+            header->sequence = static_cast<uint16_t>(entry.sequence);
+        }
+        memcpy(payload + kScoresHeaderBytes + count * GESTURE_LABEL_COUNT, entry.scores, GESTURE_LABEL_COUNT);
+        count++;
+        next_sequence = entry.sequence + 1;
+    }
+    if (count > 0) {
+        send_stream(g_scoresCharacteristic, USB_FRAME_SCORES, payload,
+                    kScoresHeaderBytes + count * GESTURE_LABEL_COUNT);
+    }
+}
+#endif
+
+#if BLE_TRACE_STREAM_ENABLE
+/**
+ * Sends the zones recorded since the last pass, as many per notification as
+ * the MTU allows. The ring keeps recording either way; the capture starts at
+ * the subscription.
+ */
+void publish_trace() {
+    const bool subscribed = stream_subscribed(g_traceCharacteristic, USB_FRAME_TRACE);
+    if (subscribed != g_trace_subscribed) {
+        g_trace_subscribed = subscribed;
+        g_trace_cursor = profiler_module_head();
+    }
+    if (!subscribed) {
+        return;
+    }
+
+    const size_t capacity = (stream_payload_bytes(USB_FRAME_TRACE) - kTraceHeaderBytes) / kTraceRecordBytes;
+    const uint16_t clock_khz = static_cast<uint16_t>(profiler_module_clock_hz() / 1000);
+    profiler_zone_record_t records[(BLE_ATT_MTU - 3 - kTraceHeaderBytes) / kTraceRecordBytes];
+    uint8_t payload[BLE_ATT_MTU - 3];
+    bool lost_any = false;
+    for (;;) {
+        uint32_t lost;
+        const size_t count = profiler_module_read(&g_trace_cursor, records, capacity, &lost);
+        lost_any = lost_any || lost > 0;
+        if (count == 0) {
+            break;
+        }
+        wire_trace_t* header = wire_at<wire_trace_t>(payload);
+        header->now_ms = millis();
+        header->now_cycles = profiler_zone_now();
+        header->clock_khz = clock_khz;
+        header->count = static_cast<uint8_t>(count | (lost_any ? WIRE_TRACE_LOST : 0));
+        for (size_t i = 0; i < count; i++) {
+            wire_trace_zone_t* zone = wire_at<wire_trace_zone_t>(payload + kTraceHeaderBytes + i * kTraceRecordBytes);
+            zone->zone = records[i].zone;
+            zone->start_age = header->now_cycles - records[i].start_cycles;
+            zone->cycles = records[i].cycles;
+        }
+        send_stream(g_traceCharacteristic, USB_FRAME_TRACE, payload, kTraceHeaderBytes + count * kTraceRecordBytes);
+        lost_any = false;
+        if (count < capacity) {
+            break;
+        }
+    }
+}
+#endif
+
+#if BLE_WINDOW_STREAM_ENABLE
+void flush_window_packet() {
+    if (!g_window_encoder.is_open()) {
+        return;
+    }
+    const record_packet_t& packet = g_window_encoder.finish();
+    send_stream(g_windowCharacteristic, USB_FRAME_WINDOW, packet.bytes, packet.length);
+}
+
+/**
+ * Packs the samples queued since the last pass into MTU-sized packets. A
+ * partial packet is held for up to BLE_WINDOW_STREAM_MAX_LATENCY_MS.
+ * Samples are only recorded while the host is subscribed.
+ */
+void publish_window() {
+    const bool subscribed = stream_subscribed(g_windowCharacteristic, USB_FRAME_WINDOW);
+    if (subscribed != g_window_subscribed) {
+        g_window_subscribed = subscribed;
+        inference_window_frame_t stale;
+        while (inference_pop_window_frame(&stale)) {
+        }
+        if (g_window_encoder.is_open()) {
+            g_window_encoder.finish();
+        }
+        g_window_mask = inference_window_channel_mask();
+        pipeline_module_subscribe(PIPELINE_OUTPUT_WINDOW, subscribed);
+    }
+    if (!subscribed) {
+        return;
+    }
+
+    inference_window_frame_t frame;
+    while (inference_pop_window_frame(&frame)) {
+        if (g_window_encoder.is_open() && g_window_encoder.add(frame.values, frame.index)) {
+            continue;
+        }
+        flush_window_packet();
+        g_window_encoder.begin(g_window_sequence++, frame.index, g_window_mask, RECORD_TYPE_WINDOW,
+                               stream_payload_bytes(USB_FRAME_WINDOW));
+        g_window_since_ms = millis();
+        // A frame that does not fit even an empty packet (large values at a 23-byte MTU) is dropped;
+        // the host sees the gap in the sample index.
+        g_window_encoder.add(frame.values, frame.index);
+    }
+    if (g_window_encoder.is_open() &&
+        millis() - g_window_since_ms >= static_cast<uint32_t>(BLE_WINDOW_STREAM_MAX_LATENCY_MS)) {
+        flush_window_packet();
+    }
+}
+
+// Wait limit for the BLE task: the given limit, or earlier when a partial window packet falls due.
+std::chrono::milliseconds window_remaining(std::chrono::milliseconds limit) {
+    if (!g_window_encoder.is_open()) {
+        return limit;
+    }
+    const int32_t left_ms = static_cast<int32_t>(g_window_since_ms + BLE_WINDOW_STREAM_MAX_LATENCY_MS - millis());
+    const std::chrono::milliseconds left(left_ms > 0 ? left_ms : 0);
+    return left < limit ? left : limit;
+}
+#endif
+
+// Events that fit one notification at the MTU of this connection.
+size_t burst_capacity() {
+    const size_t fit = (g_att_mtu - 3 - kEventHeaderBytes) / kEventBytes;
+    return fit < BLE_EVENTS_PER_NOTIFICATION ? fit : BLE_EVENTS_PER_NOTIFICATION;
+}
+
+void publish_event_burst(const inference_result_snapshot_t* events, size_t count, uint32_t dropped) {
+    uint8_t payload[kEventBurstBytes];
+    wire_event_burst_t* header = wire_at<wire_event_burst_t>(payload);
+    header->dropped = static_cast<uint8_t>(dropped > 255 ? 255 : dropped);
+    header->delivery = g_delivery_next;
+    for (size_t i = 0; i < count; i++) {
+        wire_event_t* event = wire_at<wire_event_t>(payload + kEventHeaderBytes + i * kEventBytes);
+        event->result.index = static_cast<int8_t>(events[i].index);
+        event->result.confidence = events[i].confidence_q;
+        event->result.sequence = static_cast<uint16_t>(events[i].sequence);
+        event->timestamp_ms = events[i].timestamp_ms;
+        g_history[g_delivery_next % BLE_EVENT_HISTORY_DEPTH] = *event;
+        g_delivery_next++;
+        if (g_history_count < BLE_EVENT_HISTORY_DEPTH) {
+            g_history_count++;
+        }
+    }
+    send_stream(g_eventsCharacteristic, USB_FRAME_EVENTS, payload, kEventHeaderBytes + count * kEventBytes);
+    for (size_t i = 0; i < count; i++) {
+        latency_module_record(LATENCY_NOTIFY, events[i].sample_us);
+        g_notified[g_notified_next] = {static_cast<uint16_t>(events[i].sequence), events[i].sample_us};
+        g_notified_next = (g_notified_next + 1) % LATENCY_ACK_TRACKED;
+    }
+    g_ack_outstanding = true;
+    g_last_notify_ms = millis();
+    g_heartbeat_since_ms = g_last_notify_ms;
+}
+
+void forget_notified_events() {
+    for (size_t i = 0; i < LATENCY_ACK_TRACKED; i++) {
+        g_notified[i] = {0, 0};
+    }
+    g_host_acks = false;
+    g_ack_outstanding = false;
+    g_burst_count = 0;
+    g_delivery_next = 0;
+    g_history_count = 0;
+    g_heartbeat_since_ms = millis();
+}
+
+void apply_missed(const uint8_t* value, size_t length) {
+    if (length < 3) {
+        return;
+    }
+    uint16_t first = static_cast<uint16_t>(value[0] | (value[1] << 8));
+    size_t count = value[2];
+    // How far back the request starts; 0 or "negative" asks for numbers not used yet.
+    const uint16_t back = static_cast<uint16_t>(g_delivery_next - first);
+    if (back == 0 || back > 0x8000) {
+        return;
+    }
+    if (back > g_history_count) {
+        const size_t forgotten = back - g_history_count;
+        if (count <= forgotten) {
+            return;
+        }
+        count -= forgotten;
+        first = static_cast<uint16_t>(g_delivery_next - g_history_count);
+    }
+    const size_t kept = static_cast<uint16_t>(g_delivery_next - first);
+    if (count > kept) {
+        count = kept;
+    }
+    const size_t capacity = burst_capacity();
+    uint8_t payload[kEventBurstBytes];
+    while (count > 0) {
+        const size_t n = count < capacity ? count : capacity;
+        wire_event_burst_t* header = wire_at<wire_event_burst_t>(payload);
+        header->dropped = 0;
+        header->delivery = first;
+        for (size_t i = 0; i < n; i++) {
+            *wire_at<wire_event_t>(payload + kEventHeaderBytes + i * kEventBytes) =
+                g_history[static_cast<uint16_t>(first + i) % BLE_EVENT_HISTORY_DEPTH];
+        }
+        send_stream(g_missedCharacteristic, USB_FRAME_MISSED, payload, kEventHeaderBytes + n * kEventBytes);
+        first = static_cast<uint16_t>(first + n);
+        count -= n;
+    }
+}
+
+void handle_missed() {
+    if (!g_missedCharacteristic.written()) {
+        return;
+    }
+    apply_missed(g_missedCharacteristic.value(), g_missedCharacteristic.valueLength());
+}
+
+void flush_event_burst(uint32_t* last_overruns) {
+    if (g_burst_count == 0) {
+        return;
+    }
+    const uint32_t overruns = inference_result_event_overruns(INFERENCE_CONSUMER_BLE);
+    publish_event_burst(g_burst, g_burst_count, overruns - *last_overruns);
+    *last_overruns = overruns;
+    g_burst_count = 0;
+}
+
+// Milliseconds until the pending partial burst is due (0 = due now).
+uint32_t burst_left_ms() {
+    const int32_t left_ms = static_cast<int32_t>(g_burst_since_ms + BLE_EVENT_BATCH_MAX_LATENCY_MS - millis());
+    return left_ms > 0 ? static_cast<uint32_t>(left_ms) : 0;
+}
+
+// Wait limit for the BLE task: the poll deadline, or earlier when a partial burst falls due.
+std::chrono::milliseconds burst_remaining(std::chrono::milliseconds limit) {
+    if (g_burst_count == 0) {
+        return limit;
+    }
+    const std::chrono::milliseconds left(burst_left_ms());
+    return left < limit ? left : limit;
+}
+
+#if BLE_HEARTBEAT_INTERVAL_MS > 0
+// Milliseconds until the heartbeat is due (0 = due now).
+uint32_t heartbeat_left_ms() {
+    const int32_t left_ms = static_cast<int32_t>(g_heartbeat_since_ms + BLE_HEARTBEAT_INTERVAL_MS - millis());
+    return left_ms > 0 ? static_cast<uint32_t>(left_ms) : 0;
+}
+
+// Sends a heartbeat on the events characteristic once it has been quiet for the interval.
+void publish_heartbeat() {
+    HEAP_GUARD_SCOPE("publish_heartbeat");
+    // A pending burst is about to prove the link alive; the USB link has its own keepalive.
+    if (g_usb_session || g_burst_count > 0 || heartbeat_left_ms() > 0) {
+        return;
+    }
+    uint8_t payload[kEventHeaderBytes + sizeof(wire_heartbeat_t)];
+    wire_event_burst_t* header = wire_at<wire_event_burst_t>(payload);
+    header->dropped = 0;
+    header->delivery = g_delivery_next;
+    wire_heartbeat_t* heartbeat = wire_at<wire_heartbeat_t>(payload + kEventHeaderBytes);
+    heartbeat->marker = WIRE_EVENT_HEARTBEAT;
+    // The point in effect also follows the host's operating-point command, so it is sent without the ladder too.
+    heartbeat->power_point = (uint8_t)inference_get_power_point();
+#if BATTERY_LADDER_ENABLE
+    battery_state_t state;
+    battery_module_get(&state);
+    heartbeat->battery_mv = state.millivolts;
+#else
+    heartbeat->battery_mv = 0;
+#endif
+    heartbeat->uptime_ms = millis();
+    send_stream(g_eventsCharacteristic, USB_FRAME_EVENTS, payload, sizeof(payload));
+    g_heartbeat_since_ms = heartbeat->uptime_ms;
+}
+
+// Wait limit for the BLE task: the given limit, or earlier when the heartbeat falls due.
+std::chrono::milliseconds heartbeat_remaining(std::chrono::milliseconds limit) {
+    if (g_usb_session) {
+        return limit;
+    }
+    const std::chrono::milliseconds left(heartbeat_left_ms());
+    return left < limit ? left : limit;
+}
+#endif
+
+bool ack_expected() {
+    if (g_ack_outstanding && millis() - g_last_notify_ms >= 2 * LATENCY_SLO_MS) {
+        g_ack_outstanding = false;
+    }
+    return g_host_acks && g_ack_outstanding;
+}
+
+void apply_ack(const uint8_t* value, size_t length) {
+    if (length < 2) {
+        return;
+    }
+    const uint16_t sequence = static_cast<uint16_t>(value[0] | (value[1] << 8));
+    const size_t last = (g_notified_next + LATENCY_ACK_TRACKED - 1) % LATENCY_ACK_TRACKED;
+    g_host_acks = true;
+    if (sequence == g_notified[last].sequence) {
+        g_ack_outstanding = false;
+    }
+    for (size_t i = 0; i < LATENCY_ACK_TRACKED; i++) {
+        if (g_notified[i].sample_us != 0 && g_notified[i].sequence == sequence) {
+            latency_module_record(LATENCY_ACK, g_notified[i].sample_us);
+            g_notified[i] = {0, 0};
+            return;
+        }
+    }
+}
+
+void handle_ack() {
+    if (!g_ackCharacteristic.written()) {
+        return;
+    }
+    apply_ack(g_ackCharacteristic.value(), g_ackCharacteristic.valueLength());
+}
+
+#if USB_LINK_ENABLE
+// Host writes on the USB link, each in the write format of its characteristic.
+void handle_usb_frames() {
+    usb_link_frame_t frame;
+    while (usb_link_module_pop(&frame)) {
+        switch (frame.type) {
+#if RECORD_ENABLE
+        case USB_FRAME_RECORD_CONTROL:
+            if (frame.length >= 1) {
+                apply_record_control(frame.data[0]);
+            }
+            break;
+#endif
+        case USB_FRAME_CONFIG:
+            apply_config(frame.data, frame.length);
+            break;
+        case USB_FRAME_ACK:
+            apply_ack(frame.data, frame.length);
+            break;
+        case USB_FRAME_MISSED:
+            apply_missed(frame.data, frame.length);
+            break;
+        case USB_FRAME_INFERENCE_BENCH:
+            apply_inference_benchmark(frame.data, frame.length);
+            break;
+#if TELEMETRY_ENABLE
+        case USB_FRAME_TELEMETRY:
+            apply_telemetry_command(frame.data, frame.length);
+            break;
+#endif
+#if BLE_COMBO_ENABLE
+        case USB_FRAME_COMBO:
+            apply_combos(frame.data, frame.length);
+            break;
+#endif
+        default:
+            break;
+        }
+    }
+}
+#endif
+
+#if BLE_L2CAP_ENABLE
+// Host records on the bulk channel, each in the write format of its characteristic.
+void handle_l2cap_records() {
+    l2cap_record_t record;
+    while (l2cap_module_pop(&record)) {
+        switch (record.type) {
+#if MODEL_OTA_ENABLE
+        case kModelDataRecord:
+            apply_model_data(record.data, record.length);
+            break;
+#endif
+        default:
+            break;
+        }
+    }
+}
+#endif
+
+// Results published while nobody is connected are stale: drop them so the
+// queue does not sit full and count overruns.
+void discard_results() {
+    inference_result_snapshot_t event;
+    while (inference_pop_result_event(INFERENCE_CONSUMER_BLE, &event)) {
+    }
+}
+
+#if BLE_BROADCAST_ENABLE
+// Scanners never read the layout characteristic, so the advertised confidence stays x 255.
+uint8_t confidence_byte(float confidence) {
+    const float clamped = confidence < 0.0f ? 0.0f : (confidence > 1.0f ? 1.0f : confidence);
+    return static_cast<uint8_t>(lroundf(clamped * 255.0f));
+}
+
+/**
+ * Puts a result into the manufacturer data of the advertising packet and
+ * restarts advertising so that scanners see it on the next advertising event.
+ * Flags and the 128-bit service UUID take 21 of the 31 advertising bytes; the
+ * 8-byte manufacturer block fits next to them (the name goes in the scan response).
+ */
+void set_broadcast_data(const inference_result_snapshot_t& event) {
+    uint8_t data[4];
+    data[0] = static_cast<uint8_t>(event.index < 0 ? 0xFF : event.index);
+    data[1] = confidence_byte(inference_confidence_value(event.confidence_q));
+    put_u16(data + 2, static_cast<uint16_t>(event.sequence));
+    BLE.setManufacturerData(BLE_BROADCAST_COMPANY_ID, data, sizeof(data));
+}
+
+void broadcast_result(const inference_result_snapshot_t& event) {
+    set_broadcast_data(event);
+    BLE.advertise();
+}
+
+// Broadcasts the newest queued result that passes the confidence gate (no central connected).
+void broadcast_results(uint8_t min_confidence_q) {
+    inference_result_snapshot_t latest = {-1, 0, 0, 0, 0};
+    inference_result_snapshot_t event;
+    while (inference_pop_result_event(INFERENCE_CONSUMER_BLE, &event)) {
+        if (event.index == -1) {
+            continue;
+        }
+        if (event.confidence_q < min_confidence_q) {
+            g_suppressed.add();
+        } else {
+            latest = event;
+        }
+    }
+    if (latest.index != -1) {
+        g_published.add();
+        broadcast_result(latest);
+    }
+}
+#endif
+
+void set_adv_phase(adv_phase_t phase) {
+    g_adv_phase = phase;
+    g_adv_phase_ms = millis();
+}
+
+void advertise_undirected(uint16_t interval) {
+    BLE.stopAdvertise();
+    BLE.setAdvertisingInterval(interval);
+    BLE.advertise();
+}
+
+/**
+ * ArduinoBLE only advertises undirected: high duty cycle directed advertising
+ * is set up with the controller directly (same own address type as the GAP
+ * layer). Only the addressed central can connect; the next BLE.advertise()
+ * replaces it.
+ */
+bool advertise_directed() {
+    constexpr uint8_t kAdvDirectIndHighDuty = 0x01;
+    constexpr uint8_t kOwnAddressPublic = 0x00;
+    constexpr uint8_t kAllChannels = 0x07;
+    constexpr uint8_t kNoFilter = 0x00;
+    BLE.stopAdvertise();
+    // The interval does not apply to high duty cycle directed advertising (3.75 ms or less).
+    if (HCI.leSetAdvertisingParameters(BLE_ADV_FAST_INTERVAL, BLE_ADV_FAST_INTERVAL, kAdvDirectIndHighDuty,
+                                       kOwnAddressPublic, g_last_central_type, g_last_central, kAllChannels,
+                                       kNoFilter) != 0) {
+        return false;
+    }
+    return HCI.leSetAdvertiseEnable(0x01) == 0;
+}
+
+/**
+ * Starts advertising after a session ends (or at boot): directed to the last
+ * central first when there is one, fast otherwise. A central that went away
+ * on its own is timed until the next connection.
+ */
+void start_advertising(bool time_reconnect) {
+    g_reconnect_pending = time_reconnect;
+    g_disconnect_ms = millis();
+#if BLE_ADV_DIRECTED_ENABLE
+    if (kAdvertisingConnectable && g_last_central_valid) {
+        if (advertise_directed()) {
+            set_adv_phase(ADV_PHASE_DIRECTED);
+            return;
+        }
+        LOG_WARN("[BLE] Directed advertising refused by the controller\n");
+    }
+#endif
+    advertise_undirected(BLE_ADV_FAST_INTERVAL);
+    set_adv_phase(ADV_PHASE_FAST);
+}
+
+// Moves on to the next advertising phase once the current one has run its time.
+void update_advertising() {
+    const uint32_t elapsed_ms = millis() - g_adv_phase_ms;
+    if (g_adv_phase == ADV_PHASE_DIRECTED && elapsed_ms >= kDirectedAdvertisingMs) {
+        advertise_undirected(BLE_ADV_FAST_INTERVAL);
+        set_adv_phase(ADV_PHASE_FAST);
+    } else if (g_adv_phase == ADV_PHASE_FAST && elapsed_ms >= BLE_ADV_FAST_MS) {
+        advertise_undirected(BLE_ADV_SLOW_INTERVAL);
+        set_adv_phase(ADV_PHASE_SLOW);
+    }
+}
+
+std::chrono::milliseconds advertising_remaining(std::chrono::milliseconds limit) {
+    uint32_t phase_ms;
+    if (g_adv_phase == ADV_PHASE_DIRECTED) {
+        phase_ms = kDirectedAdvertisingMs;
+    } else if (g_adv_phase == ADV_PHASE_FAST) {
+        phase_ms = BLE_ADV_FAST_MS;
+    } else {
+        return limit;
+    }
+    const int32_t left_ms = static_cast<int32_t>(g_adv_phase_ms + phase_ms - millis());
+    const std::chrono::milliseconds left(left_ms > 0 ? left_ms : 0);
+    return left < limit ? left : limit;
+}
+
+/**
+ * Keeps advertising during a BLE session while another central fits: slowly
+ * for a new one, after a central went away on its own the same phases as after
+ * a session (directed to it first). The controller stops on the next connection.
+ */
+void update_session_advertising() {
+    if (!kAdvertisingConnectable || g_central_count >= BLE_MAX_CENTRALS) {
+        g_central_left = false;
+        return;
+    }
+    if (g_central_left) {
+        g_central_left = false;
+        start_advertising(true);
+    } else if (g_adv_phase == ADV_PHASE_OFF) {
+        advertise_undirected(BLE_ADV_SLOW_INTERVAL);
+        set_adv_phase(ADV_PHASE_SLOW);
+    }
+    update_advertising();
+}
+
+
+/**
+ * Sends every queued result that passes the confidence gate: all of them as
+ * event bursts (a full burst at once, a partial one once its oldest event has
+ * waited BLE_EVENT_BATCH_MAX_LATENCY_MS), the newest one also on the
+ * latest-value characteristics.
+ */
+void publish_results(uint8_t min_confidence_q, uint32_t* last_overruns, uint32_t* last_sequence) {
+    // The publish path writes only preallocated buffers; the alloc_check build asserts that.
+    HEAP_GUARD_SCOPE("publish_results");
+    const uint32_t start_us = micros();
+    const uint32_t zone_start = profiler_zone_now();
+    const size_t capacity = burst_capacity();
+    size_t popped = 0;
+    inference_result_snapshot_t latest = {-1, 0, 0, 0, 0};
+    inference_result_snapshot_t event;
+    while (inference_pop_result_event(INFERENCE_CONSUMER_BLE, &event)) {
+        popped++;
+        // Skip results already sent (the snapshot sent on connect may also be queued).
+        if (static_cast<int32_t>(event.sequence - *last_sequence) <= 0) {
+            continue;
+        }
+        *last_sequence = event.sequence;
+        if (event.index == -1) {
+            continue;
+        }
+        if (event.confidence_q < min_confidence_q) {
+            g_suppressed.add();
+            continue;
+        }
+        g_published.add();
+        latest = event;
+        if (g_burst_count == 0) {
+            g_burst_since_ms = millis();
+        }
+        g_burst[g_burst_count++] = event;
+        if (g_burst_count >= capacity) {
+            flush_event_burst(last_overruns);
+        }
+#if BLE_COMBO_ENABLE
+        combo_match_t match;
+        if (combo_module_feed(event, &match)) {
+            publish_combo(match, event.sequence);
+        }
+#endif
+    }
+    // The USB link has no connection events to fill: a partial burst goes out on the pass that queued it.
+    if (g_burst_count > 0 && (g_usb_session || burst_left_ms() == 0)) {
+        flush_event_burst(last_overruns);
+    }
+    if (latest.index != -1) {
+        publish_latest(latest);
+#if BLE_HID_ENABLE
+        hid_module_send(latest);
+#endif
+        if (strcmp(inference_get_category_name(latest.index), "idle") != 0) {
+            g_last_activity_ms = millis();
+        }
+    }
+    // Polls that found nothing queued are not runs of the BLE stage.
+    if (popped > 0) {
+        pipeline_module_record(PIPELINE_BLE, start_us);
+        profiler_zone_record(ZONE_BLE, zone_start);
+    }
+}
+
+#if CRASH_CAPTURE_ENABLE
+void publish_crash() {
+    uint8_t payload[CRASH_REPORT_MAX_BYTES];
+    send_stream(g_crashCharacteristic, USB_FRAME_CRASH, payload, crash_module_encode(payload));
+}
+#endif
+
+#if BATTERY_LADDER_ENABLE
+// Sends the operating point and voltage after a measurement or a change of point; *last_version and
+// *last_point are the ones last sent.
+void publish_power(uint32_t* last_version, uint8_t* last_point) {
+    HEAP_GUARD_SCOPE("publish_power");
+    battery_state_t state;
+    const uint32_t version = battery_module_get(&state);
+    // The host's operating-point command changes the point between measurements.
+    if (version == *last_version && state.point == *last_point) {
+        return;
+    }
+    *last_version = version;
+    *last_point = state.point;
+    uint8_t payload[kPowerBytes];
+    payload[0] = state.point;
+    payload[1] = version != 0 ? 1 : 0;
+    put_u16(payload + 2, state.millivolts);
+    send_stream(g_powerCharacteristic, USB_FRAME_POWER, payload, sizeof(payload));
+}
+#endif
+
+#if INFERENCE_ONSET_HEAD
+// Sends each provisional onset, confirmation and cancellation; *last_changes is the change count last sent.
+void publish_onset(uint32_t* last_changes) {
+    HEAP_GUARD_SCOPE("publish_onset");
+    inference_onset_state_t state;
+    if (!inference_get_onset_state(&state) || state.changes == *last_changes) {
+        return;
+    }
+    *last_changes = state.changes;
+    uint8_t payload[sizeof(wire_onset_t)];
+    wire_onset_t* onset = wire_at<wire_onset_t>(payload);
+    onset->index = static_cast<int8_t>(state.index);
+    onset->state = state.kind;
+    onset->onset = static_cast<uint16_t>(state.onset);
+    onset->confidence = state.confidence_q;
+    onset->sequence = static_cast<uint16_t>(state.result_sequence);
+    onset->sample_ms = state.sample_ms;
+    send_stream(g_onsetCharacteristic, USB_FRAME_ONSET, payload, sizeof(payload));
+    if (state.kind == INFERENCE_ONSET_PROVISIONAL) {
+        g_last_activity_ms = millis();
+    }
+}
+#endif
+
+#if INFERENCE_EVENT_MODE == INFERENCE_EVENTS_SEGMENTS
+// Sends the hold state once per onset and offset; *last_changes is the change count last sent.
+void publish_segment(uint32_t* last_changes) {
+    HEAP_GUARD_SCOPE("publish_segment");
+    inference_segment_state_t state;
+    if (!inference_get_segment_state(&state) || state.changes == *last_changes) {
+        return;
+    }
+    *last_changes = state.changes;
+    uint8_t payload[kSegmentBytes];
+    payload[0] = static_cast<uint8_t>(static_cast<int8_t>(state.gesture.index));
+    payload[1] = state.held ? 1 : 0;
+    put_u16(payload + 2, static_cast<uint16_t>(state.result_sequence));
+    put_u32(payload + 4, state.gesture.start_ms);
+    put_u32(payload + 8, state.gesture.end_ms);
+    send_stream(g_segmentCharacteristic, USB_FRAME_SEGMENT, payload, sizeof(payload));
+    if (state.held) {
+        g_last_activity_ms = millis();
+    }
+}
+#endif
+
+void publish_diagnostics() {
+    sample_timing_stats_t timing;
+    inference_get_sample_timing(&timing);
+    send_stream(g_diagnosticsCharacteristic, USB_FRAME_DIAGNOSTICS, reinterpret_cast<const uint8_t*>(&timing),
+           sizeof(timing));
+
+    energy_stats_t energy;
+    energy_module_get_stats(&energy);
+    energy_utilization_t utilization;
+    energy_module_utilization(energy, &utilization);
+    uint8_t payload[kCpuFields * 2];
+    put_u16(payload, utilization.active_permille);
+    for (size_t i = 0; i < ENERGY_THREAD_COUNT; i++) {
+        put_u16(payload + 2 * (1 + i), utilization.thread_permille[i]);
+    }
+    put_u16(payload + 2 * (1 + ENERGY_THREAD_COUNT), utilization.idle_permille);
+    put_u16(payload + 2 * (2 + ENERGY_THREAD_COUNT), utilization.other_permille);
+    send_stream(g_cpuCharacteristic, USB_FRAME_CPU, payload, sizeof(payload));
+
+    uint8_t latency[kLatencyBytes];
+    latency_stats_t stages[LATENCY_STAGE_COUNT];
+    for (size_t i = 0; i < LATENCY_STAGE_COUNT; i++) {
+        latency_module_get_stats(static_cast<latency_stage_t>(i), &stages[i]);
+        put_u16(latency + 4 * i, latency_ms(stages[i].p50_us, stages[i].count));
+        put_u16(latency + 4 * i + 2, latency_ms(stages[i].p99_us, stages[i].count));
+    }
+    const latency_stats_t& notify = stages[LATENCY_NOTIFY];
+    watchdog_stats_t watchdog;
+    watchdog_module_get_stats(&watchdog);
+    uint8_t* tail = latency + 4 * LATENCY_STAGE_COUNT;
+    put_u16(tail, latency_ms(notify.max_us, notify.count));
+    put_u16(tail + 2, static_cast<uint16_t>(notify.over_slo > 0xFFFF ? 0xFFFF : notify.over_slo));
+    put_u16(tail + 4, static_cast<uint16_t>(watchdog.stalls > 0xFFFF ? 0xFFFF : watchdog.stalls));
+    tail[6] = watchdog.watchdog_reset ? 1 : 0;
+    send_stream(g_latencyCharacteristic, USB_FRAME_LATENCY, latency, sizeof(latency));
+
+    ble_counters_t counters;
+    ble_module_get_counters(&counters);
+    uint8_t payload_counters[kCountersBytes];
+    put_u32(payload_counters, counters.published);
+    put_u32(payload_counters + 4, counters.suppressed);
+    put_u32(payload_counters + 8, counters.notify_failures);
+    put_u32(payload_counters + 12, counters.connected_s);
+    put_u32(payload_counters + 16, counters.sessions);
+    send_stream(g_countersCharacteristic, USB_FRAME_COUNTERS, payload_counters, sizeof(payload_counters));
+
+    const size_t stat_count = stats_module_count();
+    if (stat_count > 0) {
+        if (g_next_stat >= stat_count) {
+            g_next_stat = 0;
+        }
+        uint8_t stat[kStatBytes];
+        const size_t stat_bytes = stats_module_encode(g_next_stat++, stat, sizeof(stat));
+        if (stat_bytes > 0) {
+            send_stream(g_statsCharacteristic, USB_FRAME_STATS, stat, stat_bytes);
+        }
+    }
+}
+
+/**
+ * Runs one session until it ends: BLE while any central is connected (those
+ * connecting meanwhile join it) or the USB link. Both carry the same streams;
+ * the connection parameters, throughput benchmark, clock sync characteristic
+ * and model update stay on BLE (the USB link answers clock sync itself).
+ */
+void run_session(bool usb_link, PeriodicTimer& poll_timer) {
+    PeriodicTimer diagnostics_timer{std::chrono::milliseconds(kDiagnosticsIntervalMs)};
+
+    // Results are queued for this task only while a host listens.
+    pipeline_module_subscribe(PIPELINE_OUTPUT_EVENTS, true);
+    // The current result is sent once as the first payload for this connection.
+    discard_results();
+    uint32_t last_overruns = inference_result_event_overruns(INFERENCE_CONSUMER_BLE);
+    inference_result_snapshot_t current;
+    inference_get_result_snapshot(&current);
+    // Published before the connection: its latency says nothing about the pipeline.
+    current.sample_us = 0;
+    forget_notified_events();
+    g_usb_session = usb_link;
+    g_sessions.add();
+    g_session_start_ms = millis();
+    g_in_session = true;
+    g_central_left = false;
+    if (!usb_link) {
+        g_last_activity_ms = millis();
+        g_benchmark_running = false;
+        g_loopback_rtt.reset();
+        g_loopback_failed = 0;
+        g_loopback_active = false;
+        g_time_sync_active = false;
+        update_att_mtu();
+        start_centrals();
+    } else {
+        // A USB frame carries what one notification at the largest MTU does.
+        g_att_mtu = BLE_ATT_MTU;
+        // The USB host cannot read characteristics: it gets the configuration in effect up front.
+        publish_config();
+#if BLE_COMBO_ENABLE
+        publish_combos();
+#endif
+#if CRASH_CAPTURE_ENABLE
+        publish_crash();
+#endif
+    }
+    uint32_t last_sequence = current.sequence;
+#if BATTERY_LADDER_ENABLE
+    // Measurements outside a session left the value behind: the first pass sends the point in effect.
+    uint32_t last_power_version = ~battery_module_get(nullptr);
+    uint8_t last_power_point = 0xFF;
+#endif
+#if INFERENCE_EVENT_MODE == INFERENCE_EVENTS_SEGMENTS
+    // A gesture held since before the session was never announced: its release is not sent either.
+    inference_segment_state_t segment;
+    inference_get_segment_state(&segment);
+    uint32_t last_segment_changes = segment.changes + (segment.held ? 1 : 0);
+#endif
+#if INFERENCE_ONSET_HEAD
+    // Onsets from before the session are stale: only later changes are sent.
+    inference_onset_state_t onset;
+    inference_get_onset_state(&onset);
+    uint32_t last_onset_changes = onset.changes;
+#endif
+    // A report completed before the session is readable, not notified.
+    uint32_t last_inference_bench = inference_get_benchmark(nullptr);
+    runtime_config_t config;
+    uint32_t config_version = config_module_get(&config);
+    if (current.sequence != 0 && current.index != -1 && current.confidence_q >= inference_quantize_confidence(config.ble_min_confidence)) {
+        publish_latest(current);
+        publish_event_burst(&current, 1, 0);
+    }
+
+    while (usb_link ? usb_link_module_open() : g_central_count > 0) {
+#if USB_LINK_ENABLE
+        // The USB link takes over from BLE as soon as the host opens it.
+        if (!usb_link && usb_link_module_open()) {
+            BLE.disconnect();
+            break;
+        }
+#endif
+        supervisor_module_heartbeat(THREAD_BLE);
+        poll_stack();
+        if (!usb_link) {
+            start_centrals();
+            update_session_advertising();
+        }
+#if USB_LINK_ENABLE
+        handle_usb_frames();
+#endif
+#if BLE_L2CAP_ENABLE
+        handle_l2cap_records();
+#endif
+        handle_config();
+#if BLE_HID_ENABLE
+        handle_keymap();
+#endif
+#if BLE_COMBO_ENABLE
+        handle_combos();
+#endif
+        if (config_module_get(&config) != config_version) {
+            config_version = publish_config();
+        }
+        publish_results(inference_quantize_confidence(config.ble_min_confidence), &last_overruns, &last_sequence);
+#if INFERENCE_ONSET_HEAD
+        publish_onset(&last_onset_changes);
+#endif
+#if INFERENCE_EVENT_MODE == INFERENCE_EVENTS_SEGMENTS
+        publish_segment(&last_segment_changes);
+#endif
+#if BATTERY_LADDER_ENABLE
+        publish_power(&last_power_version, &last_power_point);
+#endif
+#if BLE_HEARTBEAT_INTERVAL_MS > 0
+        publish_heartbeat();
+#endif
+        if (!usb_link) {
+            update_conn_params();
+        }
+#if BLE_SCORE_STREAM_ENABLE
+        publish_scores();
+#endif
+#if BLE_WINDOW_STREAM_ENABLE
+        publish_window();
+#endif
+#if BLE_TRACE_STREAM_ENABLE
+        publish_trace();
+#endif
+
+        if (diagnostics_timer.expired()) {
+            diagnostics_timer.advance();
+            publish_diagnostics();
+        }
+
+#if RECORD_ENABLE
+        handle_record_control();
+#endif
+        handle_ack();
+        handle_missed();
+#if RECORD_ENABLE
+        publish_record_packets();
+#endif
+        handle_benchmark();
+        run_benchmark();
+        handle_inference_benchmark();
+        publish_inference_benchmark(&last_inference_bench);
+#if MODEL_OTA_ENABLE
+        publish_model_status(false);
+#endif
+#if INFERENCE_FEWSHOT
+        publish_fewshot_status(false);
+#endif
+#if TELEMETRY_ENABLE
+        handle_telemetry();
+        run_telemetry_dump();
+#endif
+#if BLE_L2CAP_ENABLE
+        // What this pass queued goes out now, in as few K-frames as it fills.
+        l2cap_module_flush();
+        l2cap_module_service();
+#endif
+
+        // A BLE recording and a diagnostics log dump are drained at the record poll interval.
+        bool draining = record_module_transport() == RECORD_BLE;
+#if TELEMETRY_ENABLE
+        draining = draining || g_telemetry_dumping;
+#endif
+#if BLE_EVENT_DRIVEN
+        // HCI traffic, USB host frames and published results all wake the task; the
+        // deadline is only a backstop, except for draining.
+        poll_timer.set_period(draining ? kRecordPollInterval : kEventBackstop);
+#else
+        // A published result wakes the task at once; the deadline only paces BLE.poll() and diagnostics.
+        poll_timer.set_period(draining || ack_expected()
+                                  ? kRecordPollInterval
+                                  : std::chrono::milliseconds(config.ble_poll_interval_ms));
+#endif
+        energy_module_sleep(ENERGY_BLE);
+        std::chrono::milliseconds wait = burst_remaining(poll_timer.remaining());
+#if BLE_HEARTBEAT_INTERVAL_MS > 0
+        wait = heartbeat_remaining(wait);
+#endif
+#if BLE_WINDOW_STREAM_ENABLE
+        wait = window_remaining(wait);
+#endif
+#if BLE_EVENT_DRIVEN
+        const std::chrono::milliseconds diagnostics_left = diagnostics_timer.remaining();
+        wait = diagnostics_left < wait ? diagnostics_left : wait;
+        if (!usb_link) {
+            wait = advertising_remaining(wait);
+        }
+        const bool fast_poll = false;
+#else
+        // A running benchmark only yields for BLE.poll() between slices; a loopback
+        // session polls every pass so the echo is not held back by the poll interval,
+        // so does a round of clock sync requests, and so does a model upload so the
+        // controller's receive buffers keep draining. A USB session picks up host
+        // writes from the record thread at its poll interval.
+        bool fast_poll = g_usb_session || loopback_active() || time_sync_active();
+#if MODEL_OTA_ENABLE
+        fast_poll = fast_poll || model_receiving();
+#endif
+#endif
+        if (g_benchmark_running) {
+            wait = std::chrono::milliseconds(0);
+        } else if (fast_poll && wait > std::chrono::milliseconds(1)) {
+            wait = std::chrono::milliseconds(1);
+        }
+        inference_wait_result(INFERENCE_CONSUMER_BLE, wait);
+        energy_module_wake(ENERGY_BLE);
+        if (poll_timer.expired()) {
+            poll_timer.advance();
+        }
+    }
+
+    if (record_module_transport() == RECORD_BLE) {
+        record_module_stop();
+    }
+#if TELEMETRY_ENABLE
+    stop_telemetry_dump();
+#endif
+    publish_link();
+#if BLE_SCORE_STREAM_ENABLE
+    g_scores_subscribed = false;
+    pipeline_module_subscribe(PIPELINE_OUTPUT_SCORES, false);
+#endif
+#if BLE_WINDOW_STREAM_ENABLE
+    g_window_subscribed = false;
+    pipeline_module_subscribe(PIPELINE_OUTPUT_WINDOW, false);
+    if (g_window_encoder.is_open()) {
+        g_window_encoder.finish();
+    }
+#endif
+#if BLE_TRACE_STREAM_ENABLE
+    g_trace_subscribed = false;
+#endif
+    pipeline_module_subscribe(PIPELINE_OUTPUT_EVENTS, BLE_BROADCAST_ENABLE);
+    // A host that went away cannot say when gestures matter again: back to the battery's point.
+    inference_set_host_power_point(INFERENCE_HOST_POINT_NONE);
+    g_usb_session = false;
+    g_in_session = false;
+    g_connected_ms += millis() - g_session_start_ms;
+    // Centrals that were dropped for the USB link are not waiting to reconnect.
+    start_advertising(!usb_link && !usb_link_module_open());
+}
 
 }  // namespace
 
+void ble_module_get_counters(ble_counters_t* out_counters) {
+    out_counters->published = g_published.value();
+    out_counters->suppressed = g_suppressed.value();
+    out_counters->notify_failures = g_notify_failures.value();
+    out_counters->sessions = g_sessions.value();
+    uint32_t connected_ms = g_connected_ms;
+    if (g_in_session) {
+        connected_ms += millis() - g_session_start_ms;
+    }
+    out_counters->connected_s = connected_ms / 1000;
+}
+
 bool ble_module_init() {
+    // The supervisor retries this; register once.
+    if (!g_stats_registered) {
+        stats_module_register("ble.published", &g_published);
+        stats_module_register("ble.suppressed", &g_suppressed);
+        stats_module_register("ble.notify_failures", &g_notify_failures);
+        stats_module_register("ble.sessions", &g_sessions);
+        stats_module_register("ble.loopback_rtt_us", &g_loopback_rtt);
+        g_stats_registered = true;
+    }
+#if BLE_L2CAP_ENABLE
+    l2cap_module_install();
+#endif
     if (!BLE.begin()) {
-        Serial.println("[BLE] Failed to initialize radio");
+        LOG_ERROR("[BLE] Failed to initialize radio\n");
+        // Leave the stack in its initial state so that the next attempt starts from scratch.
+        BLE.end();
         return false;
     }
+    // Accept the larger MTU a central asks for (ArduinoBLE answers the exchange with 23 otherwise).
+    ATT.setMaxMtu(BLE_ATT_MTU);
+    BLE.setEventHandler(BLEConnected, on_connected);
+    BLE.setEventHandler(BLEDisconnected, on_disconnected);
+    g_layout_hash = kLayoutHashBasis;
 
     BLE.setLocalName("5ClassForwarder");
     BLE.setDeviceName("5ClassForwarder");
+#if !BLE_HID_ENABLE
+    // With HID the keyboard service is advertised instead (hid_module_begin).
     BLE.setAdvertisedService(g_dataService);
+#endif
 
-    g_dataService.addCharacteristic(g_predictionCharacteristic);
-    g_dataService.addCharacteristic(g_confidenceCharacteristic);
+    g_dataService.addCharacteristic(g_layoutCharacteristic);
+#if BLE_LEGACY_RESULT_CHARACTERISTICS
+    add_characteristic(g_predictionCharacteristic);
+    add_characteristic(g_confidenceCharacteristic);
+#endif
+    add_characteristic(g_gestureCharacteristic);
+    add_characteristic(g_diagnosticsCharacteristic);
+#if RECORD_ENABLE
+    add_characteristic(g_recordControlCharacteristic);
+    add_characteristic(g_recordDataCharacteristic);
+#endif
+    add_characteristic(g_eventsCharacteristic);
+    add_characteristic(g_missedCharacteristic);
+    g_timeSyncCharacteristic.setEventHandler(BLEWritten, on_time_sync);
+    add_characteristic(g_timeSyncCharacteristic);
+    add_characteristic(g_cpuCharacteristic);
+    g_ackCharacteristic.setEventHandler(BLEWritten, on_ack);
+    add_characteristic(g_ackCharacteristic);
+    add_characteristic(g_latencyCharacteristic);
+    add_characteristic(g_countersCharacteristic);
+    add_characteristic(g_statsCharacteristic);
+    g_streamsCharacteristic.setEventHandler(BLEWritten, on_streams);
+    add_characteristic(g_streamsCharacteristic);
+    add_characteristic(g_configCharacteristic);
+    add_characteristic(g_linkCharacteristic);
+    add_characteristic(g_benchmarkCharacteristic);
+    add_characteristic(g_inferenceBenchCharacteristic);
+#if INFERENCE_EVENT_MODE == INFERENCE_EVENTS_SEGMENTS
+    add_characteristic(g_segmentCharacteristic);
+#endif
+#if INFERENCE_ONSET_HEAD
+    add_characteristic(g_onsetCharacteristic);
+#endif
+#if BLE_SCORE_STREAM_ENABLE
+    add_characteristic(g_scoresCharacteristic);
+#endif
+#if BLE_WINDOW_STREAM_ENABLE
+    add_characteristic(g_windowCharacteristic);
+#endif
+#if BLE_HID_ENABLE
+    add_characteristic(g_keymapCharacteristic);
+#endif
+#if MODEL_OTA_ENABLE
+    g_modelControlCharacteristic.setEventHandler(BLEWritten, on_model_control);
+    g_modelDataCharacteristic.setEventHandler(BLEWritten, on_model_data);
+    add_characteristic(g_modelControlCharacteristic);
+    add_characteristic(g_modelDataCharacteristic);
+#endif
+#if INFERENCE_FEWSHOT
+    g_fewShotCharacteristic.setEventHandler(BLEWritten, on_fewshot_control);
+    add_characteristic(g_fewShotCharacteristic);
+#endif
+#if TELEMETRY_ENABLE
+    add_characteristic(g_telemetryCharacteristic);
+    add_characteristic(g_telemetryDataCharacteristic);
+#endif
+#if BLE_COMBO_ENABLE
+    add_characteristic(g_comboCharacteristic);
+    add_characteristic(g_comboEventCharacteristic);
+#endif
+#if BATTERY_LADDER_ENABLE
+    add_characteristic(g_powerCharacteristic);
+#endif
+#if BLE_TRACE_STREAM_ENABLE
+    add_characteristic(g_traceCharacteristic);
+#endif
+#if CRASH_CAPTURE_ENABLE
+    add_characteristic(g_crashCharacteristic);
+#endif
+#if BLE_L2CAP_ENABLE
+    add_characteristic(g_bulkCharacteristic);
+#endif
     BLE.addService(g_dataService);
+#if BLE_HID_ENABLE
+    hid_module_begin();
+    publish_keymap();
+#endif
+#if BLE_COMBO_ENABLE
+    combo_module_begin();
+    publish_combos();
+#endif
+#if BATTERY_LADDER_ENABLE
+    uint32_t power_version = ~battery_module_get(nullptr);
+    uint8_t power_point = 0xFF;
+    publish_power(&power_version, &power_point);
+#endif
+#if CRASH_CAPTURE_ENABLE
+    publish_crash();
+#endif
+#if BLE_L2CAP_ENABLE
+    uint8_t bulk[kBulkInfoBytes];
+    put_u16(bulk, BLE_L2CAP_PSM);
+    put_u16(bulk + 2, BLE_L2CAP_MTU);
+    bulk[4] = L2CAP_BULK_VERSION;
+    g_bulkCharacteristic.writeValue(bulk, sizeof(bulk));
+#endif
+    const uint8_t hid = BLE_HID_ENABLE ? 1 : 0;
+    hash_layout(&hid, 1);
+    publish_layout();
 
-    g_predictionCharacteristic.writeValue("unknown");
-    g_confidenceCharacteristic.writeValue(0.0f);
+    const inference_result_snapshot_t none = {-1, 0, 0, 0, 0};
+    publish_latest(none);
+#if RECORD_ENABLE
+    g_recordControlCharacteristic.writeValue(RECORD_OFF);
+#endif
+    publish_diagnostics();
+    publish_config();
+    publish_link();
+#if MODEL_OTA_ENABLE
+    publish_model_status(true);
+#endif
+#if INFERENCE_FEWSHOT
+    publish_fewshot_status(true);
+#endif
+#if TELEMETRY_ENABLE
+    publish_telemetry_status();
+#endif
 
-    BLE.advertise();
-    Serial.println("[BLE] Advertising started");
+#if BLE_BROADCAST_ENABLE
+    BLE.setConnectable(BLE_BROADCAST_CONNECTABLE != 0);
+    set_broadcast_data(none);
+#endif
+    start_advertising(false);
+    LOG_INFO("[BLE] Advertising started\n");
     return true;
 }
 
 void ble_task() {
-    uint32_t last_published_sequence = 0;
+    // Outside a session only broadcast mode uses the results: with no host the inference thread
+    // neither queues them for this task nor wakes it.
+    pipeline_module_subscribe(PIPELINE_OUTPUT_EVENTS, BLE_BROADCAST_ENABLE);
+    // Radio bring-up runs here, in parallel with IMU and model init in setup(). A failed bring-up does not stop
+    // local recognition: after SUPERVISOR_INIT_RETRIES the task keeps retrying with backoff in the background.
+    // A task restarted by the supervisor finds the stack already up.
+    if (!supervisor_module_ready(SUPERVISOR_BLE) &&
+        !supervisor_module_init(SUPERVISOR_BLE, ble_module_init, SUPERVISOR_INIT_RETRIES)) {
+        LOG_WARN("[BLE] Unavailable, retrying in the background\n");
+        supervisor_module_init(SUPERVISOR_BLE, ble_module_init, 0);
+    }
+    boot_module_mark(BOOT_BLE_READY);
+    // The runtime configuration is loaded by setup(); republish it once it is there.
+    boot_module_wait(BOOT_SETUP_DONE);
+    publish_config();
+    publish_layout();
+
+    runtime_config_t initial_config;
+    config_module_get(&initial_config);
+    // BLE.poll() / advertising cadence on absolute deadlines: the work done per pass does not stretch the period.
+    PeriodicTimer poll_timer(std::chrono::milliseconds(initial_config.ble_poll_interval_ms));
+    thread_module_register_timer(THREAD_BLE, &poll_timer);
+    energy_module_wake(ENERGY_BLE);
 
     for (;;) {
-        BLEDevice central = BLE.central();
-        if (central) {
-            Serial.print("[BLE] Connected to central: ");
-            Serial.println(central.address());
-            last_published_sequence = 0;  // Force first payload for this connection.
-
-            while (central.connected()) {
-                BLE.poll();
-
-                int prediction_index = -1;
-                float confidence = 0.0f;
-                uint32_t sequence = 0;
-                inference_get_result_with_seq(&prediction_index, &confidence, &sequence);
-
-                const bool has_new_payload = (sequence != 0) &&
-                                             (sequence != last_published_sequence) &&
-                                             (prediction_index != -1) &&
-                                             (confidence >= kMinConfidenceToTransmit);
-
-                if (has_new_payload) {
-                    last_published_sequence = sequence;
-
-                    const char* label = inference_get_category_name(prediction_index);
-                    g_predictionCharacteristic.writeValue(label);
-                    g_confidenceCharacteristic.writeValue(confidence);
-
-                    Serial.print("[BLE] Published: ");
-                    Serial.print(label);
-                    Serial.print(" (");
-                    Serial.print(confidence, 3);
-                    Serial.println(")");
-                }
-
-                rtos::ThisThread::sleep_for(kBlePollInterval);
-            }
+#if USB_LINK_ENABLE
+        if (usb_link_module_open()) {
+            // Wired: no central can connect while the USB link carries the data.
+            BLE.stopAdvertise();
+            g_adv_phase = ADV_PHASE_OFF;
+            g_reconnect_pending = false;
+            LOG_INFO("[BLE] USB link open, advertising stopped\n");
+            run_session(true, poll_timer);
+            LOG_INFO("[BLE] USB link closed\n");
+        }
+#endif
+        // Set by the connect event in BLE.poll().
+        if (g_central_count > 0) {
+            run_session(false, poll_timer);
+        }
 
-            Serial.println("[BLE] Central disconnected");
-            BLE.advertise();
+        supervisor_module_heartbeat(THREAD_BLE);
+        poll_stack();
+        runtime_config_t config;
+        config_module_get(&config);
+#if BLE_EVENT_DRIVEN
+        poll_timer.set_period(kEventBackstop);
+#else
+        poll_timer.set_period(std::chrono::milliseconds(config.ble_poll_interval_ms));
+#endif
+        update_advertising();
+#if BLE_BROADCAST_ENABLE
+        // Restarting advertising for a result would end the directed phase early.
+        if (g_adv_phase == ADV_PHASE_DIRECTED) {
+            discard_results();
+        } else {
+            broadcast_results(inference_quantize_confidence(config.ble_min_confidence));
+        }
+        // A new result restarts advertising at once; the deadline only paces BLE.poll().
+        energy_module_sleep(ENERGY_BLE);
+        inference_wait_result(INFERENCE_CONSUMER_BLE, advertising_remaining(poll_timer.remaining()));
+        energy_module_wake(ENERGY_BLE);
+        if (poll_timer.expired()) {
+            poll_timer.advance();
+        }
+#else
+        discard_results();
+        energy_module_sleep(ENERGY_BLE);
+#if BLE_EVENT_DRIVEN
+        // A connection request or the USB hello wakes the task (results are dropped until a session starts).
+        inference_wait_result(INFERENCE_CONSUMER_BLE, advertising_remaining(poll_timer.remaining()));
+        if (poll_timer.expired()) {
+            poll_timer.advance();
         }
+#else
+        poll_timer.wait();
+#endif
+        energy_module_wake(ENERGY_BLE);
+#endif
+    }
+}
+
+void ble_module_wake() {
+    inference_wake_result_waiter(INFERENCE_CONSUMER_BLE);
+}
 
-        BLE.poll();
-        rtos::ThisThread::sleep_for(kBlePollInterval);
+void ble_hci_watch_task() {
+#if BLE_EVENT_DRIVEN
+    boot_module_wait(BOOT_BLE_READY);
+    for (;;) {
+        if (!supervisor_module_ready(SUPERVISOR_BLE)) {
+            // The BLE thread is still retrying the radio bring-up.
+            rtos::ThisThread::sleep_for(kEventBackstop);
+            continue;
+        }
+        // Returns as soon as the Cordio stack has queued an HCI event or ACL packet (at once while one is pending).
+        HCITransport.wait(BLE_EVENT_BACKSTOP_MS);
+        if (!HCITransport.available()) {
+            continue;
+        }
+        ble_module_wake();
+        // Data stays pending until BLE.poll() reads it: wait for that before watching again.
+        g_hci_watch.wait_any_for(kHciDrained, kEventBackstop);
     }
+#endif
 }
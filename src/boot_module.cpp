@@ -0,0 +1,58 @@
+// 启动里程碑模块实现
+#include <Arduino.h>
+#include "rtos.h"
+#include <chrono>
+
+#include "boot_module.h"
+#include "log_module.h"
+
+// ==================== 内部状态（模块私有） ====================
+
+static rtos::EventFlags g_boot_flags;
+// 写一次、之后只读；32 位读写是原子的，读者不加锁
+static volatile uint32_t g_elapsed_ms[BOOT_MILESTONE_COUNT] = {0};
+
+// ==================== 内部辅助函数 ====================
+
+/**
+ * @brief 打印各阶段自复位以来的时间（没有到达的阶段打印 "-"）
+ */
+static void report() {
+    const char* const kNames[BOOT_MILESTONE_COUNT] = {"IMU", "model", "setup", "BLE", "window", "first result"};
+    static_assert(sizeof(kNames) / sizeof(kNames[0]) == BOOT_MILESTONE_COUNT, "milestone names");
+    uint32_t ms[BOOT_MILESTONE_COUNT];
+    for (size_t i = 0; i < BOOT_MILESTONE_COUNT; i++) {
+        ms[i] = g_elapsed_ms[i];
+    }
+    LOG_INFO("[Boot] %s %lu ms, %s %lu ms, %s %lu ms, %s %lu ms, %s %lu ms, %s %lu ms (0 = not reached)\n",
+             kNames[0], (unsigned long)ms[0], kNames[1], (unsigned long)ms[1], kNames[2], (unsigned long)ms[2],
+             kNames[3], (unsigned long)ms[3], kNames[4], (unsigned long)ms[4], kNames[5], (unsigned long)ms[5]);
+}
+
+// ==================== 公共接口实现 ====================
+
+void boot_module_mark(boot_milestone_t milestone) {
+    if (milestone >= BOOT_MILESTONE_COUNT || g_elapsed_ms[milestone] != 0) {
+        return;
+    }
+    // 复位后 1 ms 之内到达的里程碑记为 1 ms，0 保留给"尚未到达"
+    const uint32_t now_ms = millis();
+    g_elapsed_ms[milestone] = now_ms > 0 ? now_ms : 1;
+    g_boot_flags.set(1u << milestone);
+    if (milestone == BOOT_FIRST_RESULT) {
+        report();
+    }
+}
+
+void boot_module_wait(boot_milestone_t milestone) {
+    if (milestone >= BOOT_MILESTONE_COUNT) {
+        return;
+    }
+    while (g_elapsed_ms[milestone] == 0) {
+        g_boot_flags.wait_any_for(1u << milestone, std::chrono::milliseconds(100), false);
+    }
+}
+
+uint32_t boot_module_elapsed_ms(boot_milestone_t milestone) {
+    return milestone < BOOT_MILESTONE_COUNT ? g_elapsed_ms[milestone] : 0;
+}
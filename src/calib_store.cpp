@@ -0,0 +1,502 @@
+// IMU 校准参数、运行时配置、HID 键位、模型提交记录、自定义手势、诊断日志、组合手势、主动学习采集区与内核选择的
+// Flash 持久化实现
+#include <Arduino.h>
+#include "mbed.h"
+#include <string.h>
+
+#include "app_config.h"
+#include "calib_store.h"
+#include "capture_module.h"
+#include "combo_module.h"
+#include "config_module.h"
+#include "core1_module.h"
+#include "fewshot_module.h"
+#include "hid_module.h"
+#include "model_module.h"
+#include "telemetry_module.h"
+
+// 记录格式：魔数 + 版本 + 参数 + CRC32（整体按 Flash 编程单位对齐）
+#define CALIB_MAGIC   0x43414C31  // "CAL1"
+#define CALIB_VERSION 1
+#define CONFIG_MAGIC   0x43464731  // "CFG1"
+#define CONFIG_VERSION 1
+#define HID_MAGIC      0x48494431  // "HID1"
+#define HID_VERSION    1
+#define MODEL_MAGIC    0x4D444C31  // "MDL1"
+#define MODEL_VERSION  1
+#define FEWSHOT_MAGIC   0x46535431  // "FST1"
+#define FEWSHOT_VERSION 1
+#define COMBO_MAGIC    0x434D4231  // "CMB1"
+// 版本含两个上限：改变上限后旧记录的布局不同
+#define COMBO_VERSION  ((1u << 16) | (BLE_COMBO_MAX << 8) | BLE_COMBO_MAX_STEPS)
+#define KERNEL_MAGIC   0x4B524E31  // "KRN1"
+#define KERNEL_VERSION 1
+
+template <typename T>
+struct store_record_t {
+    uint32_t magic;
+    uint32_t version;
+    T payload;
+    uint32_t crc;
+};
+
+// 每种记录独占一页
+enum store_slot_t {
+    SLOT_CALIBRATION,
+    SLOT_CONFIG,
+    SLOT_HID,
+    SLOT_MODEL,
+    SLOT_COMBO,
+    SLOT_KERNELS,
+};
+
+// ==================== 内部辅助函数 ====================
+
+static uint32_t crc32(const uint8_t* data, size_t len) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0U - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+template <typename T>
+static uint32_t record_crc(const store_record_t<T>* record) {
+    return crc32(reinterpret_cast<const uint8_t*>(record), offsetof(store_record_t<T>, crc));
+}
+
+static uint32_t combo_address(mbed::FlashIAP& flash);
+static uint32_t kernel_address(mbed::FlashIAP& flash);
+
+/**
+ * @brief 校准记录所在页的地址：CALIB_FLASH_ADDR 为 0 时使用 Flash 最后一页
+ * 运行时配置在 CONFIG_FLASH_ADDR，为 0 时使用校准页之前的一页；HID 记录在 HID_FLASH_ADDR，为 0 时再往前一页；
+ * 模型提交记录在 MODEL_FLASH_ADDR，为 0 时再往前一页
+ */
+static uint32_t record_address(mbed::FlashIAP& flash, store_slot_t slot) {
+    if (slot == SLOT_COMBO) {
+        return combo_address(flash);
+    }
+    if (slot == SLOT_KERNELS) {
+        return kernel_address(flash);
+    }
+#if CALIB_FLASH_ADDR
+    const uint32_t calibration = CALIB_FLASH_ADDR;
+#else
+    const uint32_t end = flash.get_flash_start() + flash.get_flash_size();
+    const uint32_t calibration = end - flash.get_sector_size(end - 1);
+#endif
+    if (slot == SLOT_CALIBRATION) {
+        return calibration;
+    }
+#if CONFIG_FLASH_ADDR
+    const uint32_t config = CONFIG_FLASH_ADDR;
+#else
+    const uint32_t config = calibration - flash.get_sector_size(calibration - 1);
+#endif
+    if (slot == SLOT_CONFIG) {
+        return config;
+    }
+#if HID_FLASH_ADDR
+    const uint32_t hid = HID_FLASH_ADDR;
+#else
+    const uint32_t hid = config - flash.get_sector_size(config - 1);
+#endif
+    if (slot == SLOT_HID) {
+        return hid;
+    }
+#if MODEL_FLASH_ADDR
+    return MODEL_FLASH_ADDR;
+#else
+    return hid - flash.get_sector_size(hid - 1);
+#endif
+}
+
+/**
+ * @brief 模型槽紧接在模型提交记录页之前：槽 0 在低地址，槽 1 在高地址
+ */
+static uint32_t model_slot_address(mbed::FlashIAP& flash, uint8_t slot) {
+    return record_address(flash, SLOT_MODEL) - (2u - slot) * MODEL_SLOT_BYTES;
+}
+
+/**
+ * @brief 自定义手势记录页：FEWSHOT_FLASH_ADDR 为 0 时使用模型槽 0 之前的一页
+ */
+static uint32_t fewshot_address(mbed::FlashIAP& flash) {
+#if FEWSHOT_FLASH_ADDR
+    (void)flash;
+    return FEWSHOT_FLASH_ADDR;
+#else
+    const uint32_t slots = model_slot_address(flash, 0);
+    return slots - flash.get_sector_size(slots - 1);
+#endif
+}
+
+/**
+ * @brief 诊断日志的扇区：TELEMETRY_FLASH_ADDR 为 0 时紧接在自定义手势页之前
+ */
+static uint32_t telemetry_address(mbed::FlashIAP& flash, uint8_t sector) {
+#if TELEMETRY_FLASH_ADDR
+    (void)flash;
+    const uint32_t start = TELEMETRY_FLASH_ADDR;
+#else
+    const uint32_t start = fewshot_address(flash) - TELEMETRY_SECTORS * TELEMETRY_SECTOR_BYTES;
+#endif
+    return start + (uint32_t)sector * TELEMETRY_SECTOR_BYTES;
+}
+
+/**
+ * @brief 组合手势记录页：BLE_COMBO_FLASH_ADDR 为 0 时使用诊断日志扇区之前的一页（不论是否启用诊断日志，
+ * 各页的位置都不随功能开关移动）
+ */
+static uint32_t combo_address(mbed::FlashIAP& flash) {
+#if BLE_COMBO_FLASH_ADDR
+    (void)flash;
+    return BLE_COMBO_FLASH_ADDR;
+#else
+    const uint32_t ring = telemetry_address(flash, 0);
+    return ring - flash.get_sector_size(ring - 1);
+#endif
+}
+
+/**
+ * @brief 主动学习采集区的扇区：CAPTURE_FLASH_ADDR 为 0 时紧接在组合手势页之前（同样不随功能开关移动）
+ */
+static uint32_t capture_address(mbed::FlashIAP& flash, uint8_t sector) {
+#if CAPTURE_FLASH_ADDR
+    (void)flash;
+    const uint32_t start = CAPTURE_FLASH_ADDR;
+#else
+    const uint32_t start = combo_address(flash) - CAPTURE_SECTORS * CAPTURE_SECTOR_BYTES;
+#endif
+    return start + (uint32_t)sector * CAPTURE_SECTOR_BYTES;
+}
+
+/**
+ * @brief 内核选择记录页：KERNEL_FLASH_ADDR 为 0 时使用采集区之前的一页（同样不随功能开关移动）
+ */
+static uint32_t kernel_address(mbed::FlashIAP& flash) {
+#if KERNEL_FLASH_ADDR
+    (void)flash;
+    return KERNEL_FLASH_ADDR;
+#else
+    const uint32_t area = capture_address(flash, 0);
+    return area - flash.get_sector_size(area - 1);
+#endif
+}
+
+/**
+ * @brief 自定义手势记录的头部：记录太大，不经 store_record_t 在栈上复制，负载紧跟在头部之后
+ */
+struct fewshot_header_t {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t bytes;
+    uint32_t crc;
+};
+
+template <typename T>
+static bool load_record(store_slot_t slot, uint32_t magic, uint32_t version, T* out_payload) {
+    mbed::FlashIAP flash;
+    if (flash.init() != 0) {
+        return false;
+    }
+
+    store_record_t<T> record;
+    const bool read_ok = flash.read(&record, record_address(flash, slot), sizeof(record)) == 0;
+    flash.deinit();
+
+    if (!read_ok || record.magic != magic || record.version != version || record.crc != record_crc(&record)) {
+        return false;
+    }
+
+    *out_payload = record.payload;
+    return true;
+}
+
+template <typename T>
+static bool save_record(store_slot_t slot, uint32_t magic, uint32_t version, const T* payload) {
+    mbed::FlashIAP flash;
+    if (flash.init() != 0) {
+        return false;
+    }
+
+    const uint32_t address = record_address(flash, slot);
+    const uint32_t page_size = flash.get_page_size();
+
+    // 按编程单位补齐，未使用部分保持擦除后的 0xFF
+    alignas(4) uint8_t buffer[(sizeof(store_record_t<T>) + 7) & ~7u];
+    memset(buffer, 0xFF, sizeof(buffer));
+
+    store_record_t<T> record;
+    memset(&record, 0, sizeof(record));
+    record.magic = magic;
+    record.version = version;
+    record.payload = *payload;
+    record.crc = record_crc(&record);
+    memcpy(buffer, &record, sizeof(record));
+
+    const uint32_t program_size = (sizeof(buffer) + page_size - 1) / page_size * page_size;
+    core1_module_flash_begin();
+    bool ok = program_size <= sizeof(buffer) &&
+              flash.erase(address, flash.get_sector_size(address)) == 0 &&
+              flash.program(buffer, address, program_size) == 0;
+    core1_module_flash_end();
+    flash.deinit();
+
+    T verify;
+    return ok && load_record(slot, magic, version, &verify) && memcmp(&verify, payload, sizeof(verify)) == 0;
+}
+
+static bool erase_record(store_slot_t slot) {
+    mbed::FlashIAP flash;
+    if (flash.init() != 0) {
+        return false;
+    }
+
+    const uint32_t address = record_address(flash, slot);
+    core1_module_flash_begin();
+    const bool ok = flash.erase(address, flash.get_sector_size(address)) == 0;
+    core1_module_flash_end();
+    flash.deinit();
+    return ok;
+}
+
+// ==================== 公共接口实现 ====================
+
+bool calib_store_load(imu_calibration_t* out_calibration) {
+    return load_record(SLOT_CALIBRATION, CALIB_MAGIC, CALIB_VERSION, out_calibration);
+}
+
+bool calib_store_save(const imu_calibration_t* calibration) {
+    return save_record(SLOT_CALIBRATION, CALIB_MAGIC, CALIB_VERSION, calibration);
+}
+
+bool calib_store_erase() {
+    return erase_record(SLOT_CALIBRATION);
+}
+
+bool calib_store_load_config(runtime_config_t* out_config) {
+    return load_record(SLOT_CONFIG, CONFIG_MAGIC, CONFIG_VERSION, out_config);
+}
+
+bool calib_store_save_config(const runtime_config_t* config) {
+    return save_record(SLOT_CONFIG, CONFIG_MAGIC, CONFIG_VERSION, config);
+}
+
+bool calib_store_load_hid(hid_settings_t* out_settings) {
+    return load_record(SLOT_HID, HID_MAGIC, HID_VERSION, out_settings);
+}
+
+bool calib_store_save_hid(const hid_settings_t* settings) {
+    return save_record(SLOT_HID, HID_MAGIC, HID_VERSION, settings);
+}
+
+bool calib_store_load_model(model_commit_t* out_commit) {
+    return load_record(SLOT_MODEL, MODEL_MAGIC, MODEL_VERSION, out_commit);
+}
+
+bool calib_store_save_model(const model_commit_t* commit) {
+    return save_record(SLOT_MODEL, MODEL_MAGIC, MODEL_VERSION, commit);
+}
+
+bool calib_store_erase_model() {
+    return erase_record(SLOT_MODEL);
+}
+
+bool calib_store_load_fewshot(fewshot_table_t* out_table) {
+    mbed::FlashIAP flash;
+    if (flash.init() != 0) {
+        return false;
+    }
+
+    const uint32_t address = fewshot_address(flash);
+    fewshot_header_t header;
+    const bool read_ok = flash.read(&header, address, sizeof(header)) == 0 && header.magic == FEWSHOT_MAGIC &&
+                         header.version == FEWSHOT_VERSION && header.bytes == sizeof(fewshot_table_t) &&
+                         flash.read(out_table, address + sizeof(header), sizeof(fewshot_table_t)) == 0;
+    flash.deinit();
+
+    return read_ok && header.crc == crc32(reinterpret_cast<const uint8_t*>(out_table), sizeof(fewshot_table_t));
+}
+
+bool calib_store_save_fewshot(const fewshot_table_t* table) {
+    static_assert(sizeof(fewshot_header_t) % 8 == 0 && sizeof(fewshot_table_t) % 8 == 0,
+                  "the few-shot record must be a whole number of flash program units");
+    mbed::FlashIAP flash;
+    if (flash.init() != 0) {
+        return false;
+    }
+
+    const uint32_t address = fewshot_address(flash);
+    const uint32_t page_size = flash.get_page_size();
+    const fewshot_header_t header = {FEWSHOT_MAGIC, FEWSHOT_VERSION, sizeof(fewshot_table_t),
+                                     crc32(reinterpret_cast<const uint8_t*>(table), sizeof(fewshot_table_t))};
+
+    core1_module_flash_begin();
+    const bool ok = sizeof(header) % page_size == 0 && sizeof(fewshot_table_t) % page_size == 0 &&
+                    sizeof(header) + sizeof(fewshot_table_t) <= flash.get_sector_size(address) &&
+                    flash.erase(address, flash.get_sector_size(address)) == 0 &&
+                    flash.program(&header, address, sizeof(header)) == 0 &&
+                    flash.program(table, address + sizeof(header), sizeof(fewshot_table_t)) == 0;
+    core1_module_flash_end();
+    flash.deinit();
+
+    // 回读直接比较内存映射的 Flash（与模型槽的读取方式相同）
+    const uint8_t* stored = reinterpret_cast<const uint8_t*>(address);
+    return ok && memcmp(stored, &header, sizeof(header)) == 0 &&
+           memcmp(stored + sizeof(header), table, sizeof(fewshot_table_t)) == 0;
+}
+
+#if BLE_COMBO_ENABLE
+bool calib_store_load_combos(combo_table_t* out_table) {
+    return load_record(SLOT_COMBO, COMBO_MAGIC, COMBO_VERSION, out_table);
+}
+
+bool calib_store_save_combos(const combo_table_t* table) {
+    return save_record(SLOT_COMBO, COMBO_MAGIC, COMBO_VERSION, table);
+}
+#endif
+
+#if MODEL_KERNEL_AUTOTUNE
+bool calib_store_load_kernels(model_kernel_choice_t* out_choice) {
+    return load_record(SLOT_KERNELS, KERNEL_MAGIC, KERNEL_VERSION, out_choice);
+}
+
+bool calib_store_save_kernels(const model_kernel_choice_t* choice) {
+    return save_record(SLOT_KERNELS, KERNEL_MAGIC, KERNEL_VERSION, choice);
+}
+#endif
+
+uint32_t calib_store_model_slot_address(uint8_t slot) {
+    mbed::FlashIAP flash;
+    if (slot > 1 || flash.init() != 0) {
+        return 0;
+    }
+    const uint32_t address = model_slot_address(flash, slot);
+    flash.deinit();
+    return address;
+}
+
+bool calib_store_model_slot_erase(uint8_t slot, uint32_t bytes) {
+    mbed::FlashIAP flash;
+    if (slot > 1 || bytes > MODEL_SLOT_BYTES || flash.init() != 0) {
+        return false;
+    }
+
+    const uint32_t start = model_slot_address(flash, slot);
+    bool ok = true;
+    core1_module_flash_begin();
+    for (uint32_t address = start; ok && address < start + bytes;) {
+        const uint32_t sector = flash.get_sector_size(address);
+        ok = flash.erase(address, sector) == 0;
+        address += sector;
+    }
+    core1_module_flash_end();
+    flash.deinit();
+    return ok;
+}
+
+bool calib_store_model_slot_program(uint8_t slot, uint32_t offset, const void* data, uint32_t length) {
+    mbed::FlashIAP flash;
+    if (slot > 1 || offset > MODEL_SLOT_BYTES || length > MODEL_SLOT_BYTES - offset || flash.init() != 0) {
+        return false;
+    }
+
+    const uint32_t page_size = flash.get_page_size();
+    core1_module_flash_begin();
+    const bool ok = offset % page_size == 0 && length % page_size == 0 &&
+                    flash.program(data, model_slot_address(flash, slot) + offset, length) == 0;
+    core1_module_flash_end();
+    flash.deinit();
+    return ok;
+}
+
+uint32_t calib_store_telemetry_address() {
+    mbed::FlashIAP flash;
+    if (flash.init() != 0) {
+        return 0;
+    }
+    const uint32_t address = telemetry_address(flash, 0);
+    flash.deinit();
+    return address;
+}
+
+bool calib_store_telemetry_erase(uint8_t sector) {
+    mbed::FlashIAP flash;
+    if (sector >= TELEMETRY_SECTORS || flash.init() != 0) {
+        return false;
+    }
+
+    const uint32_t address = telemetry_address(flash, sector);
+    core1_module_flash_begin();
+    const bool ok = flash.get_sector_size(address) == TELEMETRY_SECTOR_BYTES &&
+                    flash.erase(address, TELEMETRY_SECTOR_BYTES) == 0;
+    core1_module_flash_end();
+    flash.deinit();
+    return ok;
+}
+
+bool calib_store_telemetry_program(uint8_t sector, uint32_t offset, const void* data, uint32_t length) {
+    mbed::FlashIAP flash;
+    if (sector >= TELEMETRY_SECTORS || offset > TELEMETRY_SECTOR_BYTES || length > TELEMETRY_SECTOR_BYTES - offset ||
+        flash.init() != 0) {
+        return false;
+    }
+
+    const uint32_t page_size = flash.get_page_size();
+    core1_module_flash_begin();
+    const bool ok = offset % page_size == 0 && length % page_size == 0 &&
+                    flash.program(data, telemetry_address(flash, sector) + offset, length) == 0;
+    core1_module_flash_end();
+    flash.deinit();
+    return ok;
+}
+
+uint32_t calib_store_capture_address() {
+    mbed::FlashIAP flash;
+    if (flash.init() != 0) {
+        return 0;
+    }
+    const uint32_t address = capture_address(flash, 0);
+    flash.deinit();
+    return address;
+}
+
+bool calib_store_capture_erase(uint8_t sector) {
+    mbed::FlashIAP flash;
+    if (sector >= CAPTURE_SECTORS || flash.init() != 0) {
+        return false;
+    }
+
+    const uint32_t address = capture_address(flash, sector);
+    core1_module_flash_begin();
+    const bool ok = flash.get_sector_size(address) == CAPTURE_SECTOR_BYTES &&
+                    flash.erase(address, CAPTURE_SECTOR_BYTES) == 0;
+    core1_module_flash_end();
+    flash.deinit();
+    return ok;
+}
+
+bool calib_store_capture_program(uint8_t sector, uint32_t offset, const void* data, uint32_t length) {
+    mbed::FlashIAP flash;
+    if (sector >= CAPTURE_SECTORS || offset > CAPTURE_SECTOR_BYTES || length > CAPTURE_SECTOR_BYTES - offset ||
+        flash.init() != 0) {
+        return false;
+    }
+
+    const uint32_t page_size = flash.get_page_size();
+    core1_module_flash_begin();
+    const bool ok = offset % page_size == 0 && length % page_size == 0 &&
+                    flash.program(data, capture_address(flash, sector) + offset, length) == 0;
+    core1_module_flash_end();
+    flash.deinit();
+    return ok;
+}
+
+uint32_t calib_store_crc32(const uint8_t* data, size_t length) {
+    return crc32(data, length);
+}
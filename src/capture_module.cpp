@@ -0,0 +1,319 @@
+// 主动学习采集实现：推理线程 -> 无锁队列 -> 主循环写入 Flash 环形扇区
+#include <Arduino.h>
+#include "mbed.h"
+#include "rtos.h"
+#include <stddef.h>
+#include <string.h>
+
+#include "app_config.h"
+#include "calib_store.h"
+#include "capture_module.h"
+#include "log_module.h"
+#include "memory_module.h"
+#include "spsc_ring.h"
+#include "usb_frame.h"
+
+#if CAPTURE_ENABLE
+
+#define SECTOR_HEADER_BYTES 8
+#define ERASED_WORD 0xFFFFFFFFu
+
+// 一条记录（布局见 capture_module.h；设备与上位机都是小端）
+struct capture_record_t {
+    uint32_t ms;
+    int8_t top;
+    int8_t runner_up;
+    uint8_t top_confidence;
+    uint8_t runner_up_confidence;
+    uint16_t suppressed;
+    uint16_t crc;
+    float input_scale;
+    int8_t zero_point;
+    uint8_t axes;
+    uint8_t frames;
+    uint8_t flags;
+    int8_t window[CAPTURE_RECORD_BYTES - CAPTURE_HEADER_BYTES];
+};
+static_assert(sizeof(capture_record_t) == CAPTURE_RECORD_BYTES, "capture record layout");
+static_assert(offsetof(capture_record_t, window) == CAPTURE_HEADER_BYTES, "capture record header");
+
+// 导出中的一段：一个扇区的记录部分
+struct dump_span_t {
+    uint32_t sequence;
+    uint32_t address;
+    uint32_t length;
+};
+
+// ==================== 内部状态（模块私有） ====================
+
+// 推理线程写入、主循环取出；两端都不加锁
+static SpscRing<capture_record_t, CAPTURE_QUEUE_DEPTH> g_queue;
+
+// 只由推理线程访问（计数供其它线程读取，32 位的读是原子的）
+static bool g_captured_once = false;
+static uint32_t g_last_ms = 0;
+static uint16_t g_pending_suppressed = 0;
+static volatile uint32_t g_captured = 0;
+static volatile uint32_t g_suppressed = 0;
+static float g_input_scale = 1.0f;
+static int8_t g_zero_point = 0;
+static uint8_t g_flags = 0;
+
+// 写入位置与导出受 g_flash_mutex 保护（主循环写入，BLE 线程导出）
+static rtos::Mutex g_flash_mutex;
+static uint32_t g_base = 0;  // 第一个扇区的地址（0 = Flash 不可用，窗口丢弃）
+static uint8_t g_sector = CAPTURE_SECTORS - 1;
+static uint32_t g_offset = CAPTURE_SECTOR_BYTES;
+static uint32_t g_sequence = 0;
+static uint32_t g_stored_bytes = 0;
+static uint32_t g_flash_errors = 0;
+static bool g_dumping = false;
+static dump_span_t g_dump[CAPTURE_SECTORS];
+static size_t g_dump_spans = 0;
+
+// ==================== 内部辅助函数 ====================
+
+static const uint8_t* sector_data(uint8_t sector) {
+    return reinterpret_cast<const uint8_t*>(g_base + (uint32_t)sector * CAPTURE_SECTOR_BYTES);
+}
+
+static uint32_t read_word(const uint8_t* data) {
+    uint32_t word;
+    memcpy(&word, data, sizeof(word));
+    return word;
+}
+
+static bool sector_sequence(uint8_t sector, uint32_t* out_sequence) {
+    const uint8_t* data = sector_data(sector);
+    if (read_word(data) != CAPTURE_SECTOR_MAGIC) {
+        return false;
+    }
+    *out_sequence = read_word(data + 4);
+    return true;
+}
+
+/**
+ * @brief 记录定长：跳过整条记录直到时间戳与 CRC 所在的字都未写入
+ * （写到一半的记录留在原处，由上位机按 CRC 丢弃）
+ */
+static uint32_t sector_end(uint8_t sector) {
+    const uint8_t* data = sector_data(sector);
+    uint32_t offset = SECTOR_HEADER_BYTES;
+    while (offset + CAPTURE_RECORD_BYTES <= CAPTURE_SECTOR_BYTES &&
+           !(read_word(data + offset) == ERASED_WORD && read_word(data + offset + 8) == ERASED_WORD)) {
+        offset += CAPTURE_RECORD_BYTES;
+    }
+    return offset;
+}
+
+/**
+ * @brief 打开下一个扇区：擦除它（其中最旧的窗口离开环形区域）并写入更大的序号
+ */
+static bool open_next_sector() {
+    const uint8_t next = (uint8_t)((g_sector + 1) % CAPTURE_SECTORS);
+    uint32_t sequence;
+    const uint32_t leaving = sector_sequence(next, &sequence) ? sector_end(next) - SECTOR_HEADER_BYTES : 0;
+    if (!calib_store_capture_erase(next)) {
+        g_flash_errors++;
+        return false;
+    }
+    g_stored_bytes -= leaving < g_stored_bytes ? leaving : g_stored_bytes;
+    g_sector = next;
+    g_sequence++;
+    const uint32_t header[2] = {CAPTURE_SECTOR_MAGIC, g_sequence};
+    if (!calib_store_capture_program(next, 0, header, sizeof(header))) {
+        g_flash_errors++;
+        g_offset = CAPTURE_SECTOR_BYTES;
+        return false;
+    }
+    g_offset = SECTOR_HEADER_BYTES;
+    return true;
+}
+
+static uint8_t confidence_byte(float confidence) {
+    const float scaled = confidence * 255.0f + 0.5f;
+    return scaled <= 0.0f ? 0 : (scaled >= 255.0f ? 255 : (uint8_t)scaled);
+}
+
+static void suppress() {
+    if (g_pending_suppressed < UINT16_MAX) {
+        g_pending_suppressed++;
+    }
+    g_suppressed = g_suppressed + 1;
+}
+
+// ==================== 公共接口实现 ====================
+
+void capture_module_init() {
+    memory_module_register("capture queue", sizeof(g_queue), false);
+    g_base = calib_store_capture_address();
+    if (g_base == 0) {
+        LOG_ERROR("[Capture] Flash unavailable, window capture disabled\n");
+        return;
+    }
+
+    bool found = false;
+    for (uint8_t sector = 0; sector < CAPTURE_SECTORS; sector++) {
+        uint32_t sequence;
+        if (!sector_sequence(sector, &sequence)) {
+            continue;
+        }
+        g_stored_bytes += sector_end(sector) - SECTOR_HEADER_BYTES;
+        if (!found || sequence > g_sequence) {
+            g_sector = sector;
+            g_sequence = sequence;
+            found = true;
+        }
+    }
+    if (found) {
+        g_offset = sector_end(g_sector);
+    }
+    LOG_INFO("[Capture] %lu windows in %u sectors\n", (unsigned long)(g_stored_bytes / CAPTURE_RECORD_BYTES),
+             (unsigned)CAPTURE_SECTORS);
+}
+
+void capture_module_set_quantization(float input_scale, int32_t zero_point, bool normalized) {
+    g_input_scale = input_scale;
+    g_zero_point = (int8_t)zero_point;
+    g_flags = normalized ? CAPTURE_FLAG_NORMALIZED : 0;
+}
+
+void capture_module_window(const int8_t* window, size_t head, int top, float top_confidence, int runner_up,
+                           float runner_up_confidence) {
+    uint8_t flags = 0;
+    if (top_confidence >= CAPTURE_BAND_LOW && top_confidence <= CAPTURE_BAND_HIGH) {
+        flags |= CAPTURE_FLAG_BAND;
+    }
+    if (runner_up >= 0 && top_confidence - runner_up_confidence < CAPTURE_MARGIN) {
+        flags |= CAPTURE_FLAG_MARGIN;
+    }
+    // 正常路径到此为止：窗口足够确定
+    if (flags == 0 || top < 0) {
+        return;
+    }
+    const uint32_t now_ms = millis();
+    if (g_captured_once && now_ms - g_last_ms < CAPTURE_INTERVAL_MS) {
+        suppress();
+        return;
+    }
+
+    capture_record_t record;
+    record.ms = now_ms;
+    record.top = (int8_t)top;
+    record.runner_up = (int8_t)runner_up;
+    record.top_confidence = confidence_byte(top_confidence);
+    record.runner_up_confidence = runner_up >= 0 ? confidence_byte(runner_up_confidence) : 0;
+    record.suppressed = g_pending_suppressed;
+    record.input_scale = g_input_scale;
+    record.zero_point = g_zero_point;
+    record.axes = EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME;
+    record.frames = EI_CLASSIFIER_RAW_SAMPLE_COUNT;
+    record.flags = (uint8_t)(flags | g_flags);
+    // 环形窗口按时间顺序展开
+    const size_t tail = CAPTURE_WINDOW_VALUES - head;
+    memcpy(record.window, window + head, tail);
+    memcpy(record.window + tail, window, head);
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&record);
+    const size_t crc_at = offsetof(capture_record_t, crc);
+    uint16_t crc = usb_frame_crc16(bytes, crc_at);
+    record.crc = usb_frame_crc16(bytes + crc_at + 2, CAPTURE_RECORD_BYTES - crc_at - 2, crc);
+
+    // 队列满（主循环正在写入或在导出）：这个窗口只计数，下一个含糊窗口再试
+    if (!g_queue.push(&record, 1)) {
+        suppress();
+        return;
+    }
+    g_captured_once = true;
+    g_last_ms = now_ms;
+    g_pending_suppressed = 0;
+    g_captured = g_captured + 1;
+}
+
+void capture_module_poll() {
+    g_flash_mutex.lock();
+    capture_record_t record;
+    while (!g_dumping && g_queue.size() > 0) {
+        if (g_base != 0 && g_offset + CAPTURE_RECORD_BYTES > CAPTURE_SECTOR_BYTES && !open_next_sector()) {
+            // 失败已计数：窗口留在队列中，下一次轮询再打开扇区
+            break;
+        }
+        g_queue.pop(&record, 1);
+        if (g_base == 0) {
+            continue;
+        }
+        if (!calib_store_capture_program(g_sector, g_offset, &record, sizeof(record))) {
+            // 写入位置之后的内容不确定：下一条从新的扇区开始
+            g_flash_errors++;
+            g_offset = CAPTURE_SECTOR_BYTES;
+            continue;
+        }
+        g_offset += CAPTURE_RECORD_BYTES;
+        g_stored_bytes += CAPTURE_RECORD_BYTES;
+    }
+    g_flash_mutex.unlock();
+}
+
+uint32_t capture_module_dump_begin() {
+    g_flash_mutex.lock();
+    g_dumping = true;
+    g_dump_spans = 0;
+    uint32_t bytes = 0;
+    for (uint8_t sector = 0; g_base != 0 && sector < CAPTURE_SECTORS; sector++) {
+        uint32_t sequence;
+        if (!sector_sequence(sector, &sequence)) {
+            continue;
+        }
+        const dump_span_t span = {sequence, g_base + (uint32_t)sector * CAPTURE_SECTOR_BYTES + SECTOR_HEADER_BYTES,
+                                  sector_end(sector) - SECTOR_HEADER_BYTES};
+        // 按序号插入：导出按时间顺序
+        size_t i = g_dump_spans++;
+        for (; i > 0 && g_dump[i - 1].sequence > sequence; i--) {
+            g_dump[i] = g_dump[i - 1];
+        }
+        g_dump[i] = span;
+        bytes += span.length;
+    }
+    g_flash_mutex.unlock();
+    LOG_INFO("[Capture] Dump of %lu bytes started\n", (unsigned long)bytes);
+    return bytes;
+}
+
+size_t capture_module_dump_read(uint32_t offset, uint8_t* out, size_t length) {
+    size_t copied = 0;
+    g_flash_mutex.lock();
+    for (size_t i = 0; g_dumping && i < g_dump_spans && copied < length; i++) {
+        const dump_span_t& span = g_dump[i];
+        if (offset >= span.length) {
+            offset -= span.length;
+            continue;
+        }
+        size_t n = span.length - offset;
+        n = n < length - copied ? n : length - copied;
+        memcpy(out + copied, reinterpret_cast<const uint8_t*>(span.address + offset), n);
+        copied += n;
+        offset = 0;
+    }
+    g_flash_mutex.unlock();
+    return copied;
+}
+
+void capture_module_dump_end() {
+    g_flash_mutex.lock();
+    const bool was_dumping = g_dumping;
+    g_dumping = false;
+    g_flash_mutex.unlock();
+    if (was_dumping) {
+        LOG_INFO("[Capture] Dump finished\n");
+    }
+}
+
+void capture_module_get_status(capture_status_t* out_status) {
+    // 不加锁：写入期间持有 g_flash_mutex，32 位的读是原子的
+    out_status->dumping = g_dumping;
+    out_status->captured = g_captured;
+    out_status->suppressed = g_suppressed;
+    out_status->stored_bytes = g_stored_bytes;
+    out_status->flash_errors = g_flash_errors;
+}
+
+#endif
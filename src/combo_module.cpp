@@ -0,0 +1,155 @@
+#include <Arduino.h>
+#include <string.h>
+
+#include "app_config.h"
+#include "calib_store.h"
+#include "combo_module.h"
+#include "gesture_labels.h"
+#include "log_module.h"
+
+#if BLE_COMBO_ENABLE
+
+namespace {
+
+static_assert(sizeof(combo_table_t) == 4 + BLE_COMBO_MAX * (1 + BLE_COMBO_MAX_STEPS),
+              "combo_table_t must not contain padding");
+
+// Gap of the empty table used when flash holds none (the host sends its own with the combos).
+constexpr uint16_t kDefaultGapMs = 800;
+
+ComboMatcher<BLE_COMBO_MAX, BLE_COMBO_MAX_STEPS, GESTURE_LABEL_COUNT> g_matcher;
+combo_table_t g_table;
+combo_table_t g_saved;
+#if INFERENCE_EVENT_MODE == INFERENCE_EVENTS_RAW
+int g_last_index = -1;
+#endif
+
+uint32_t gesture_mask() {
+    uint32_t mask = 0;
+    for (size_t i = 0; i < GESTURE_LABEL_COUNT; i++) {
+        if (kGestureLabels[i].kind == GESTURE_KIND_GESTURE) {
+            mask |= 1u << i;
+        }
+    }
+    return mask;
+}
+
+combo_error_t compile(const combo_table_t& table) {
+    return g_matcher.compile(table.steps, table.lengths, table.count, table.gap_ms, gesture_mask());
+}
+
+bool decode(const uint8_t* value, size_t length, combo_table_t* out_table) {
+    memset(out_table, 0, sizeof(*out_table));
+    if (length < COMBO_HEADER_BYTES || value[0] > BLE_COMBO_MAX) {
+        return false;
+    }
+    out_table->count = value[0];
+    out_table->gap_ms = static_cast<uint16_t>(value[1] | (value[2] << 8));
+    size_t offset = COMBO_HEADER_BYTES;
+    for (size_t c = 0; c < out_table->count; c++) {
+        if (offset >= length || value[offset] > BLE_COMBO_MAX_STEPS || offset + 1 + value[offset] > length) {
+            return false;
+        }
+        out_table->lengths[c] = value[offset];
+        memcpy(out_table->steps[c], value + offset + 1, value[offset]);
+        offset += 1 + value[offset];
+    }
+    return offset == length;
+}
+
+}  // namespace
+
+void combo_module_begin() {
+    memset(&g_table, 0, sizeof(g_table));
+    g_table.gap_ms = kDefaultGapMs;
+    combo_table_t stored;
+    if (calib_store_load_combos(&stored)) {
+        const combo_error_t error = compile(stored);
+        if (error == COMBO_OK) {
+            g_table = stored;
+        } else {
+            // Stored by a firmware with other labels: keep no combos rather than wrong ones.
+            LOG_WARN("[Combo] Stored combos rejected (%s)\n", combo_module_error_name(error));
+        }
+    }
+    if (g_table.count == 0) {
+        compile(g_table);
+    }
+    g_saved = g_table;
+    LOG_INFO("[Combo] %u combos, %u states, gap %u ms\n", (unsigned)g_table.count, (unsigned)g_matcher.states(),
+             (unsigned)g_table.gap_ms);
+}
+
+size_t combo_module_encode(uint8_t* out) {
+    out[0] = g_table.count;
+    out[1] = static_cast<uint8_t>(g_table.gap_ms);
+    out[2] = static_cast<uint8_t>(g_table.gap_ms >> 8);
+    size_t offset = COMBO_HEADER_BYTES;
+    for (size_t c = 0; c < g_table.count; c++) {
+        out[offset] = g_table.lengths[c];
+        memcpy(out + offset + 1, g_table.steps[c], g_table.lengths[c]);
+        offset += 1 + g_table.lengths[c];
+    }
+    return offset;
+}
+
+combo_error_t combo_module_set(const uint8_t* value, size_t length) {
+    combo_table_t table;
+    if (!decode(value, length, &table)) {
+        return COMBO_ERROR_LENGTH;
+    }
+    const combo_error_t error = compile(table);
+    if (error != COMBO_OK) {
+        return error;
+    }
+    g_table = table;
+#if INFERENCE_EVENT_MODE == INFERENCE_EVENTS_RAW
+    g_last_index = -1;
+#endif
+    LOG_INFO("[Combo] %u combos, %u states, gap %u ms\n", (unsigned)g_table.count, (unsigned)g_matcher.states(),
+             (unsigned)g_table.gap_ms);
+    if (memcmp(&g_table, &g_saved, sizeof(g_table)) != 0) {
+        // The new combos are in use either way; a failed write only loses them at the next reset.
+        if (calib_store_save_combos(&g_table)) {
+            g_saved = g_table;
+        } else {
+            LOG_WARN("[Combo] Failed to save combos\n");
+        }
+    }
+    return COMBO_OK;
+}
+
+bool combo_module_feed(const inference_result_snapshot_t& event, combo_match_t* out_match) {
+    if (event.index < 0 || event.index >= GESTURE_LABEL_COUNT) {
+        return false;
+    }
+#if INFERENCE_EVENT_MODE == INFERENCE_EVENTS_RAW
+    // Raw events repeat a gesture while its windows last; an idle result in between makes the next one a new step.
+    if (event.index == g_last_index) {
+        return false;
+    }
+    g_last_index = event.index;
+#endif
+    if (kGestureLabels[event.index].kind != GESTURE_KIND_GESTURE) {
+        return false;
+    }
+    return g_matcher.feed(event.index, event.timestamp_ms, out_match);
+}
+
+const char* combo_module_error_name(combo_error_t error) {
+    switch (error) {
+    case COMBO_OK:
+        return "ok";
+    case COMBO_ERROR_LENGTH:
+        return "length";
+    case COMBO_ERROR_LABEL:
+        return "label";
+    case COMBO_ERROR_OVERLAP:
+        return "overlap";
+    case COMBO_ERROR_GAP:
+        return "gap";
+    }
+    return "?";
+}
+
+#endif
@@ -0,0 +1,237 @@
+// 运行时配置模块实现
+#include <Arduino.h>
+#include "rtos.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "app_config.h"
+#include "calib_store.h"
+#include "config_module.h"
+#include "inference_module.h"
+#include "led_module.h"
+#include "log_module.h"
+#include "seqlock.h"
+
+static_assert(sizeof(runtime_config_t) == 16, "runtime_config_t must not contain padding");
+
+// ==================== 内部状态（模块私有） ====================
+
+// 读者无锁读取快照；写者（BLE 线程、串口命令线程）由 g_config_mutex 串行化
+static Seqlock<runtime_config_t> g_config;
+static rtos::Mutex g_config_mutex;
+
+// Flash 中的配置（未保存过时与默认值相同），用来跳过不必要的擦写
+static runtime_config_t g_saved;
+
+static const char* const kProfileNames[CONFIG_PROFILE_COUNT] = {"default", "low-latency", "low-power", "custom"};
+
+// ==================== 内部辅助函数 ====================
+
+static bool valid_confidence(float confidence) {
+    return confidence >= 0.0f && confidence <= 1.0f;
+}
+
+/**
+ * @brief 校验阈值与轮询间隔，并把步长交给推理模块（步长的约束由它检查）
+ */
+static bool apply(const runtime_config_t& config) {
+    if (!valid_confidence(config.ble_min_confidence) || !valid_confidence(config.led_confidence_threshold) ||
+        config.ble_poll_interval_ms < CONFIG_POLL_MIN_MS || config.ble_poll_interval_ms > CONFIG_POLL_MAX_MS ||
+        config.profile >= CONFIG_PROFILE_COUNT) {
+        return false;
+    }
+    if (!inference_set_stride(config.stride_fine_samples, config.stride_coarse_samples)) {
+        return false;
+    }
+    // 结果的置信度不会超过 1：阈值为 1 时 LED 永不显示，整级关闭
+    led_module_set_enabled(config.led_confidence_threshold < 1.0f);
+    g_config.store(config);
+    return true;
+}
+
+static void log_config(const char* action, const runtime_config_t& config) {
+    LOG_INFO("[Config] %s %s: BLE >= %.2f, LED > %.2f, stride %u/%u samples, poll %u ms\n", action,
+             config_module_profile_name(config.profile), config.ble_min_confidence,
+             config.led_confidence_threshold, (unsigned)config.stride_fine_samples,
+             (unsigned)config.stride_coarse_samples, (unsigned)config.ble_poll_interval_ms);
+}
+
+static bool parse_confidence(const char* text, float* out) {
+    char* end = nullptr;
+    const float value = strtof(text, &end);
+    if (end == text || *end != '\0' || !valid_confidence(value)) {
+        return false;
+    }
+    *out = value;
+    return true;
+}
+
+// ==================== 公共接口实现 ====================
+
+void config_module_init() {
+    runtime_config_t config;
+    config_module_preset(CONFIG_PROFILE_DEFAULT, &config);
+    g_saved = config;
+
+    runtime_config_t stored;
+    if (calib_store_load_config(&stored)) {
+        g_saved = stored;
+        if (apply(stored)) {
+            log_config("Loaded", stored);
+            return;
+        }
+        LOG_WARN("[Config] Stored configuration rejected, using defaults\n");
+    }
+    apply(config);
+}
+
+uint32_t config_module_get(runtime_config_t* out_config) {
+    return g_config.load(out_config);
+}
+
+bool config_module_preset(config_profile_t profile, runtime_config_t* out_config) {
+    runtime_config_t config;
+    memset(&config, 0, sizeof(config));
+    config.ble_min_confidence = BLE_MIN_CONFIDENCE;
+    config.led_confidence_threshold = LED_CONFIDENCE_THRESHOLD;
+    config.profile = (uint8_t)profile;
+    switch (profile) {
+        case CONFIG_PROFILE_DEFAULT:
+            config.ble_poll_interval_ms = BLE_POLL_INTERVAL_MS;
+            config.stride_fine_samples = INFERENCE_STRIDE_FINE_SAMPLES;
+            config.stride_coarse_samples =
+                INFERENCE_ADAPTIVE_STRIDE ? INFERENCE_STRIDE_COARSE_SAMPLES : INFERENCE_STRIDE_FINE_SAMPLES;
+            break;
+        case CONFIG_PROFILE_LOW_LATENCY:
+            config.ble_poll_interval_ms = CONFIG_LOW_LATENCY_POLL_MS;
+            config.stride_fine_samples = CONFIG_LOW_LATENCY_STRIDE_FINE;
+            config.stride_coarse_samples = CONFIG_LOW_LATENCY_STRIDE_COARSE;
+            break;
+        case CONFIG_PROFILE_LOW_POWER:
+            config.ble_poll_interval_ms = CONFIG_LOW_POWER_POLL_MS;
+            config.stride_fine_samples = CONFIG_LOW_POWER_STRIDE_FINE;
+            config.stride_coarse_samples = CONFIG_LOW_POWER_STRIDE_COARSE;
+            break;
+        default:
+            return false;
+    }
+    *out_config = config;
+    return true;
+}
+
+bool config_module_set(const runtime_config_t* config) {
+    if (!config) {
+        return false;
+    }
+    runtime_config_t next = *config;
+    memset(next.reserved, 0, sizeof(next.reserved));
+
+    g_config_mutex.lock();
+    const bool applied = apply(next);
+    bool saved = true;
+    if (applied && memcmp(&next, &g_saved, sizeof(next)) != 0) {
+        saved = calib_store_save_config(&next);
+        if (saved) {
+            g_saved = next;
+        }
+    }
+    g_config_mutex.unlock();
+
+    if (!applied) {
+        LOG_WARN("[Config] Rejected configuration\n");
+        return false;
+    }
+    log_config("Applied", next);
+    if (!saved) {
+        LOG_WARN("[Config] Failed to save configuration to flash\n");
+    }
+    return true;
+}
+
+uint32_t config_module_encode(uint8_t* out) {
+    runtime_config_t config;
+    const uint32_t version = config_module_get(&config);
+    out[0] = config.profile;
+    out[1] = (uint8_t)lroundf(config.ble_min_confidence * 255.0f);
+    out[2] = (uint8_t)lroundf(config.led_confidence_threshold * 255.0f);
+    out[3] = config.stride_fine_samples;
+    out[4] = config.stride_coarse_samples;
+    out[5] = (uint8_t)config.ble_poll_interval_ms;
+    out[6] = (uint8_t)(config.ble_poll_interval_ms >> 8);
+    return version;
+}
+
+bool config_module_write(const uint8_t* value, size_t length) {
+    runtime_config_t config;
+    if (length == CONFIG_OPERATING_POINT_BYTES && value[0] == CONFIG_OPERATING_POINT_MARKER) {
+        return inference_set_host_power_point(value[1]);
+    }
+    if (length == 1) {
+        if (!config_module_preset(static_cast<config_profile_t>(value[0]), &config)) {
+            return false;
+        }
+    } else if (length >= CONFIG_WIRE_BYTES) {
+        config_module_get(&config);
+        config.profile = CONFIG_PROFILE_CUSTOM;
+        config.ble_min_confidence = value[1] / 255.0f;
+        config.led_confidence_threshold = value[2] / 255.0f;
+        config.stride_fine_samples = value[3];
+        config.stride_coarse_samples = value[4];
+        config.ble_poll_interval_ms = (uint16_t)(value[5] | (value[6] << 8));
+    } else {
+        return false;
+    }
+    return config_module_set(&config);
+}
+
+bool config_module_command(const char* args) {
+    runtime_config_t config;
+    config_module_get(&config);
+
+    while (*args == ' ') {
+        args++;
+    }
+    if (*args == '\0') {
+        log_config("Current", config);
+        return true;
+    }
+    for (size_t i = 0; i < CONFIG_PROFILE_CUSTOM; i++) {
+        if (strcmp(args, kProfileNames[i]) == 0) {
+            config_module_preset(static_cast<config_profile_t>(i), &config);
+            return config_module_set(&config);
+        }
+    }
+
+    char key[8];
+    char first[12];
+    char second[12];
+    const int fields = sscanf(args, "%7s %11s %11s", key, first, second);
+    bool ok = false;
+    if (fields == 2 && strcmp(key, "ble") == 0) {
+        ok = parse_confidence(first, &config.ble_min_confidence);
+    } else if (fields == 2 && strcmp(key, "led") == 0) {
+        ok = parse_confidence(first, &config.led_confidence_threshold);
+    } else if (fields == 2 && strcmp(key, "poll") == 0) {
+        const int ms = atoi(first);
+        ok = ms > 0 && ms <= 0xFFFF;
+        config.ble_poll_interval_ms = (uint16_t)ms;
+    } else if (fields == 3 && strcmp(key, "stride") == 0) {
+        const int fine = atoi(first);
+        const int coarse = atoi(second);
+        ok = fine > 0 && fine <= 0xFF && coarse > 0 && coarse <= 0xFF;
+        config.stride_fine_samples = (uint8_t)fine;
+        config.stride_coarse_samples = (uint8_t)coarse;
+    }
+    if (!ok) {
+        LOG_WARN("[Config] Usage: cfg [default|low-latency|low-power|ble <c>|led <c>|stride <fine> <coarse>|poll <ms>]\n");
+        return false;
+    }
+    config.profile = CONFIG_PROFILE_CUSTOM;
+    return config_module_set(&config);
+}
+
+const char* config_module_profile_name(uint8_t profile) {
+    return profile < CONFIG_PROFILE_COUNT ? kProfileNames[profile] : "unknown";
+}
@@ -0,0 +1,175 @@
+// 核 1 作业模块实现
+#include <Arduino.h>
+#include "rtos.h"
+
+#include "app_config.h"
+#include "core1_module.h"
+#if INFERENCE_DUAL_CORE
+#include <string.h>
+#include "mbed.h"
+#include "hardware/structs/sio.h"
+#include "hardware/structs/timer.h"
+#include "hardware/sync.h"
+#include "pico/multicore.h"
+#include "log_module.h"
+#include "memory_module.h"
+#endif
+
+#if INFERENCE_DUAL_CORE
+// ==================== 内部状态（模块私有） ====================
+
+#define CORE1_FLAG_DONE    0x01
+#define CORE1_STACK_FILL   0xC0DE51A5u
+
+// 作业槽：推理线程在发出 FIFO 字之前写好，核 1 在回发 FIFO 字之前写回结果，FIFO 读写前后的
+// 内存屏障保证对方看到完整的槽（RP2040 没有数据缓存）
+static core1_job_t volatile g_job = nullptr;
+static void* volatile g_arg = nullptr;
+static volatile bool g_result = false;
+
+// 只由核 1 写；32 位读写是原子的，读者不加锁
+static volatile uint32_t g_jobs = 0;
+static volatile uint32_t g_busy_us = 0;
+
+static uint32_t g_stack[CORE1_STACK_BYTES / sizeof(uint32_t)] __attribute__((aligned(8)));
+static rtos::EventFlags g_done;
+// 模型调用与 Flash 擦写互斥（擦写期间核 1 不能执行 flash 中的代码）
+static rtos::Mutex g_job_mutex;
+static bool g_running = false;
+
+// 上次报告时的计数，用于按报告周期计算占用率
+static uint32_t g_report_ms = 0;
+static uint32_t g_report_busy_us = 0;
+static uint32_t g_report_jobs = 0;
+
+/**
+ * @brief 核 1 的主循环：等待 FIFO 中的作业字，执行作业后原样回发
+ * 循环本身放在 RAM 中，只直接访问 SIO / TIMER 寄存器，Flash 擦写期间空闲的核 1 不会从 XIP 取指
+ */
+static void __not_in_flash_func(core1_main)() {
+    while (true) {
+        while (!(sio_hw->fifo_st & SIO_FIFO_ST_VLD_BITS)) {
+            __wfe();
+        }
+        const uint32_t token = sio_hw->fifo_rd;
+        __dmb();
+
+        const uint32_t start_us = timer_hw->timerawl;
+        g_result = g_job(g_arg);
+        g_busy_us += timer_hw->timerawl - start_us;
+        g_jobs++;
+
+        __dmb();
+        while (!(sio_hw->fifo_st & SIO_FIFO_ST_RDY_BITS)) {
+            __wfe();
+        }
+        sio_hw->fifo_wr = token;
+        __sev();
+    }
+}
+
+/**
+ * @brief 核 0 的 SIO FIFO 中断：读空回发的字，清除溢出标志，唤醒等待的推理线程
+ */
+static void sio_irq_proc0() {
+    while (sio_hw->fifo_st & SIO_FIFO_ST_VLD_BITS) {
+        (void)sio_hw->fifo_rd;
+    }
+    sio_hw->fifo_st = 0xFF;
+    g_done.set(CORE1_FLAG_DONE);
+}
+
+static uint32_t stack_peak_bytes() {
+    // 栈向下生长：从低地址数起仍是填充字的部分从未被使用
+    size_t untouched = 0;
+    while (untouched < sizeof(g_stack) / sizeof(g_stack[0]) && g_stack[untouched] == CORE1_STACK_FILL) {
+        untouched++;
+    }
+    return (uint32_t)(sizeof(g_stack) - untouched * sizeof(g_stack[0]));
+}
+#endif
+
+// ==================== 公共接口实现 ====================
+
+void core1_module_init() {
+#if INFERENCE_DUAL_CORE
+    if (g_running) {
+        return;
+    }
+    for (size_t i = 0; i < sizeof(g_stack) / sizeof(g_stack[0]); i++) {
+        g_stack[i] = CORE1_STACK_FILL;
+    }
+    memory_module_register("core1 stack", sizeof(g_stack), false);
+
+    // 启动握手本身经过 FIFO，完成后才接管核 0 的 FIFO 中断
+    multicore_launch_core1_with_stack(core1_main, g_stack, sizeof(g_stack));
+    sio_hw->fifo_st = 0xFF;
+    NVIC_SetVector(SIO_IRQ_PROC0_IRQn, (uint32_t)&sio_irq_proc0);
+    NVIC_EnableIRQ(SIO_IRQ_PROC0_IRQn);
+    g_report_ms = millis();
+    g_running = true;
+    Serial.println("[Core1] Model invoke runs on core 1");
+#endif
+}
+
+bool core1_module_run(core1_job_t job, void* arg) {
+#if INFERENCE_DUAL_CORE
+    if (!g_running) {
+        return job(arg);
+    }
+    // 核 1 卡死时推理线程停在这里不再喂狗，由看门狗复位
+    g_job_mutex.lock();
+    g_job = job;
+    g_arg = arg;
+    g_done.clear(CORE1_FLAG_DONE);
+    __dmb();
+    sio_hw->fifo_wr = 1;
+    __sev();
+    g_done.wait_any(CORE1_FLAG_DONE);
+    __dmb();
+    const bool result = g_result;
+    g_job_mutex.unlock();
+    return result;
+#else
+    return job(arg);
+#endif
+}
+
+void core1_module_flash_begin() {
+#if INFERENCE_DUAL_CORE
+    g_job_mutex.lock();
+#endif
+}
+
+void core1_module_flash_end() {
+#if INFERENCE_DUAL_CORE
+    g_job_mutex.unlock();
+#endif
+}
+
+void core1_module_get_stats(core1_stats_t* out_stats) {
+#if INFERENCE_DUAL_CORE
+    out_stats->jobs = g_jobs;
+    out_stats->busy_us = g_busy_us;
+    out_stats->stack_peak = stack_peak_bytes();
+#else
+    *out_stats = core1_stats_t{0, 0, 0};
+#endif
+}
+
+void core1_module_report() {
+#if INFERENCE_DUAL_CORE
+    core1_stats_t stats;
+    core1_module_get_stats(&stats);
+    const uint32_t now_ms = millis();
+    const uint32_t window_ms = now_ms - g_report_ms;
+    const uint32_t busy_us = stats.busy_us - g_report_busy_us;
+    LOG_INFO("[Core1] %lu jobs, busy %lu%% since last report, stack peak %lu/%lu B\n",
+             (unsigned long)(stats.jobs - g_report_jobs),
+             (unsigned long)(window_ms > 0 ? (uint64_t)busy_us / 10 / window_ms : 0),
+             (unsigned long)stats.stack_peak, (unsigned long)sizeof(g_stack));
+    g_report_ms = now_ms;
+    g_report_busy_us = stats.busy_us;
+    g_report_jobs = stats.jobs;
+#endif
+}
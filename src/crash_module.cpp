@@ -0,0 +1,259 @@
+// 崩溃记录模块实现
+#include "crash_module.h"
+
+#if CRASH_CAPTURE_ENABLE
+#include <Arduino.h>
+#include "mbed.h"
+#include <atomic>
+#include <stdio.h>
+#include <string.h>
+
+#include "calib_store.h"
+#include "pipeline_module.h"
+#include "telemetry_module.h"
+#include "watchdog_module.h"
+
+// ==================== 内部状态（模块私有） ====================
+
+#define CRASH_MAGIC 0x43525348        // "CRSH"：record 有效
+#define CRASH_TRAIL_MAGIC 0x5452414C  // "TRAL"：轨迹已由上次启动初始化
+
+static_assert(CRASH_REPORT_MAX_BYTES <= 244, "the crash report must fit one USB frame");
+
+// mbed_fault_handler 把这个上下文的地址作为 mbed_error 的附带值传入
+// （platform/source/TARGET_CORTEX_M/mbed_fault_handler.h 中的 mbed_fault_context_t，头文件不在核心的包含路径中）
+struct fault_context_t {
+    uint32_t r[13];
+    uint32_t sp;
+    uint32_t lr;
+    uint32_t pc;
+    uint32_t xpsr;
+    uint32_t psp;
+    uint32_t msp;
+    uint32_t exc_return;
+    uint32_t control;
+};
+
+// 不随复位清零的区域：链接脚本中的 NOLOAD 段，启动代码既不清零也不载入初值，所以这里不能有初始化器
+struct crash_noinit_t {
+    uint32_t magic;
+    uint32_t crc;          // record 的 crc32
+    crash_report_t record;
+    uint32_t trail_magic;
+    std::atomic<uint32_t> trail_head;
+    crash_trail_entry_t trail[CRASH_TRAIL_DEPTH];
+};
+__attribute__((section(CRASH_NOINIT_SECTION))) static crash_noinit_t g_noinit;
+
+// 本次启动取出的报告（只在 crash_module_init 中写入，之后只读）
+static crash_report_t g_report;
+static bool g_has_report = false;
+
+static const char* const kKindNames[] = {"none", "fault", "stack overflow", "error", "watchdog reset"};
+
+// ==================== 内部辅助函数 ====================
+
+/**
+ * @brief 把轨迹从旧到新复制出来
+ * @return 条数
+ */
+static uint8_t copy_trail(crash_trail_entry_t* out) {
+    if (g_noinit.trail_magic != CRASH_TRAIL_MAGIC) {
+        return 0;
+    }
+    const uint32_t head = g_noinit.trail_head.load(std::memory_order_relaxed);
+    const uint32_t count = head < CRASH_TRAIL_DEPTH ? head : CRASH_TRAIL_DEPTH;
+    for (uint32_t i = 0; i < count; i++) {
+        out[i] = g_noinit.trail[(head - count + i) & (CRASH_TRAIL_DEPTH - 1)];
+    }
+    return (uint8_t)count;
+}
+
+static uint32_t record_crc() {
+    return calib_store_crc32(reinterpret_cast<const uint8_t*>(&g_noinit.record), sizeof(g_noinit.record));
+}
+
+static const char* thread_name(uint8_t role) {
+    if (role >= THREAD_COUNT) {
+        return "main/ISR";
+    }
+    thread_stack_stats_t stats;
+    thread_module_get_stats((thread_role_t)role, &stats);
+    return stats.name;
+}
+
+static void print_report(const crash_report_t& report) {
+    char line[128];
+    snprintf(line, sizeof(line), "[Crash] Last reset: %s in %s thread, status 0x%08lx, after %lu ms",
+             kKindNames[report.kind], thread_name(report.thread), (unsigned long)report.status,
+             (unsigned long)report.uptime_ms);
+    Serial.println(line);
+    if (report.kind != CRASH_WATCHDOG) {
+        snprintf(line, sizeof(line),
+                 "[Crash] pc 0x%08lx lr 0x%08lx sp 0x%08lx value 0x%08lx cfsr 0x%08lx hfsr 0x%08lx mmfar 0x%08lx bfar 0x%08lx",
+                 (unsigned long)report.pc, (unsigned long)report.lr, (unsigned long)report.sp,
+                 (unsigned long)report.value, (unsigned long)report.cfsr, (unsigned long)report.hfsr,
+                 (unsigned long)report.mmfar, (unsigned long)report.bfar);
+        Serial.println(line);
+        int len = snprintf(line, sizeof(line), "[Crash] stack peaks");
+        for (size_t i = 0; i < THREAD_COUNT && len > 0 && (size_t)len < sizeof(line); i++) {
+            thread_stack_stats_t stats;
+            thread_module_get_stats((thread_role_t)i, &stats);
+            len += snprintf(line + len, sizeof(line) - len, "%s %s %u/%lu", i == 0 ? ":" : ",", stats.name,
+                            (unsigned)report.stack_peak[i], (unsigned long)stats.stack_bytes);
+        }
+        Serial.println(line);
+    }
+    // 时间相对最后一条轨迹的开始
+    const uint32_t last_us = report.trail_count > 0 ? report.trail[report.trail_count - 1].start_us : 0;
+    for (uint8_t i = 0; i < report.trail_count; i++) {
+        const crash_trail_entry_t& entry = report.trail[i];
+        snprintf(line, sizeof(line), "[Crash] trail %8ld us %-11s %5u us", -(long)(last_us - entry.start_us),
+                 pipeline_module_stage_name((pipeline_stage_t)entry.stage), (unsigned)entry.duration_us);
+        Serial.println(line);
+    }
+}
+
+static void put_u32(uint8_t* dst, uint32_t value) {
+    memcpy(dst, &value, sizeof(value));
+}
+
+static void put_u16(uint8_t* dst, uint16_t value) {
+    memcpy(dst, &value, sizeof(value));
+}
+
+// ==================== mbed 错误钩子 ====================
+
+/**
+ * @brief mbed 记下错误之后、打印与停机之前调用（故障处理或内核上下文，中断可能已关闭）
+ * 固件不使用 mbed_warning，进入这里的都是致命错误。
+ */
+extern "C" void mbed_error_hook(const mbed_error_ctx* error_context) {
+    crash_report_t& record = g_noinit.record;
+    memset(&record, 0, sizeof(record));
+    switch (MBED_GET_ERROR_CODE(error_context->error_status)) {
+        case MBED_ERROR_CODE_HARDFAULT_EXCEPTION:
+        case MBED_ERROR_CODE_MEMMANAGE_EXCEPTION:
+        case MBED_ERROR_CODE_BUSFAULT_EXCEPTION:
+        case MBED_ERROR_CODE_USAGEFAULT_EXCEPTION: {
+            const fault_context_t* fault = reinterpret_cast<const fault_context_t*>(error_context->error_value);
+            record.kind = CRASH_FAULT;
+            record.pc = fault->pc;
+            record.lr = fault->lr;
+            record.sp = fault->sp;
+            break;
+        }
+        case MBED_ERROR_CODE_STACK_OVERFLOW:
+            record.kind = CRASH_STACK_OVERFLOW;
+            record.pc = error_context->error_address;
+            record.sp = error_context->thread_current_sp;
+            record.value = error_context->error_value;
+            break;
+        default:
+            record.kind = CRASH_ERROR;
+            record.pc = error_context->error_address;
+            record.sp = error_context->thread_current_sp;
+            record.value = error_context->error_value;
+            break;
+    }
+    // 栈溢出时栈指针已在栈外，按栈底所在的线程判断
+    record.thread = (uint8_t)thread_module_role_at(error_context->thread_stack_mem);
+    record.status = (uint32_t)error_context->error_status;
+    record.uptime_ms = millis();
+    record.cfsr = SCB->CFSR;
+    record.hfsr = SCB->HFSR;
+    record.mmfar = SCB->MMFAR;
+    record.bfar = SCB->BFAR;
+    for (size_t i = 0; i < THREAD_COUNT; i++) {
+        thread_stack_stats_t stats;
+        thread_module_get_stats((thread_role_t)i, &stats);
+        record.stack_peak[i] = (uint16_t)(stats.peak_bytes > 0xFFFF ? 0xFFFF : stats.peak_bytes);
+    }
+    record.trail_count = copy_trail(record.trail);
+    g_noinit.crc = record_crc();
+    g_noinit.magic = CRASH_MAGIC;
+    NVIC_SystemReset();
+}
+
+// ==================== 公共接口实现 ====================
+
+void crash_module_init() {
+    if (g_noinit.magic == CRASH_MAGIC && g_noinit.crc == record_crc() && g_noinit.record.kind != CRASH_NONE) {
+        g_report = g_noinit.record;
+        g_has_report = true;
+    } else {
+        watchdog_stats_t watchdog;
+        watchdog_module_get_stats(&watchdog);
+        if (watchdog.watchdog_reset) {
+            memset(&g_report, 0, sizeof(g_report));
+            g_report.kind = CRASH_WATCHDOG;
+            g_report.thread = THREAD_INFERENCE;
+            g_report.trail_count = copy_trail(g_report.trail);
+            g_has_report = true;
+        }
+    }
+    g_noinit.magic = 0;
+    g_noinit.trail_head.store(0, std::memory_order_relaxed);
+    g_noinit.trail_magic = CRASH_TRAIL_MAGIC;
+
+    if (!g_has_report) {
+        return;
+    }
+    print_report(g_report);
+#if TELEMETRY_ENABLE
+    uint8_t payload[16] = {g_report.kind, g_report.thread, 0, 0};
+    put_u32(payload + 4, g_report.status);
+    put_u32(payload + 8, g_report.pc);
+    put_u32(payload + 12, g_report.lr);
+    telemetry_module_record(TELEMETRY_CRASH, payload, sizeof(payload));
+    telemetry_module_flush();
+#endif
+}
+
+void crash_module_trail(uint8_t stage, uint32_t start_us, uint32_t duration_us) {
+    const uint32_t slot = g_noinit.trail_head.fetch_add(1, std::memory_order_relaxed) & (CRASH_TRAIL_DEPTH - 1);
+    crash_trail_entry_t& entry = g_noinit.trail[slot];
+    entry.start_us = start_us;
+    entry.duration_us = (uint16_t)(duration_us > 0xFFFF ? 0xFFFF : duration_us);
+    entry.stage = stage;
+}
+
+bool crash_module_get(crash_report_t* out_report) {
+    if (g_has_report && out_report) {
+        *out_report = g_report;
+    }
+    return g_has_report;
+}
+
+size_t crash_module_encode(uint8_t* out) {
+    memset(out, 0, CRASH_REPORT_HEADER_BYTES);
+    if (!g_has_report) {
+        out[3] = THREAD_COUNT;
+        return 4;
+    }
+    const crash_report_t& report = g_report;
+    out[0] = report.kind;
+    out[1] = report.thread < THREAD_COUNT ? report.thread : 0xFF;
+    out[2] = report.trail_count;
+    out[3] = THREAD_COUNT;
+    const uint32_t words[] = {report.status, report.uptime_ms, report.pc, report.lr, report.sp,
+                              report.value, report.cfsr, report.hfsr, report.mmfar, report.bfar};
+    for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); i++) {
+        put_u32(out + 4 + 4 * i, words[i]);
+    }
+    uint8_t* cursor = out + CRASH_REPORT_HEADER_BYTES;
+    for (size_t i = 0; i < THREAD_COUNT; i++, cursor += 4) {
+        thread_stack_stats_t stats;
+        thread_module_get_stats((thread_role_t)i, &stats);
+        put_u16(cursor, (uint16_t)stats.stack_bytes);
+        put_u16(cursor + 2, report.stack_peak[i]);
+    }
+    for (uint8_t i = 0; i < report.trail_count; i++, cursor += 8) {
+        put_u32(cursor, report.trail[i].start_us);
+        put_u16(cursor + 4, report.trail[i].duration_us);
+        cursor[6] = report.trail[i].stage;
+        cursor[7] = 0;
+    }
+    return (size_t)(cursor - out);
+}
+#endif
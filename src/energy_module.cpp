@@ -0,0 +1,170 @@
+// 能耗估算模块实现
+#include <Arduino.h>
+#include "rtos.h"
+#if defined(__MBED__)
+#include "mbed.h"
+#endif
+
+#include "app_config.h"
+#include "energy_module.h"
+#include "seqlock.h"
+#include "stat_counters.h"
+
+// ==================== 内部状态（模块私有） ====================
+
+// 单核上高优先级线程抢占时，它的活动区间完整地嵌在被抢占者的区间内（阻塞后 CPU 才回到被抢占者），
+// 所以一个线程阻塞时，它实际占用的时间 = 本次活动的墙钟时间 - 期间记给其他线程的时间。
+// g_charged_us 是记给所有线程的累计时间（回绕于 2^32，只取差值）：活动开始时记下它，阻塞时相减即得。
+// 每个线程的活动状态只有它自己读写，累计值是 relaxed 原子计数，结算者取出清零；全程不加锁。
+// 同优先级轮转时只是近似；一次活动的时间在它结束时记入当时的统计窗口。
+struct energy_thread_state_t {
+    bool active;
+    uint32_t wake_us;
+    uint32_t wake_charged_us;   // 开始活动时的 g_charged_us
+};
+
+static energy_thread_state_t g_threads[ENERGY_THREAD_COUNT];
+static StatCounter g_thread_us[ENERGY_THREAD_COUNT];
+static StatCounter g_active_us;
+static std::atomic<uint32_t> g_charged_us(0);
+
+// 窗口起点与内核空闲基准只有结算者（推理线程）读写；结算结果经顺序锁发布，任意线程读取
+static uint32_t g_window_start_us = 0;
+static uint64_t g_kernel_idle_us = 0;
+static Seqlock<energy_stats_t> g_snapshot;
+
+/**
+ * @brief 结束线程的一次活动，把它实际占用的时间记给它（只由该线程调用）
+ */
+static void charge(energy_thread_t thread) {
+    energy_thread_state_t& state = g_threads[thread];
+    if (!state.active) {
+        return;
+    }
+    state.active = false;
+    const uint32_t wall_us = micros() - state.wake_us;
+    const uint32_t others_us = g_charged_us.load(std::memory_order_relaxed) - state.wake_charged_us;
+    const uint32_t own_us = wall_us > others_us ? wall_us - others_us : 0;
+    g_charged_us.fetch_add(own_us, std::memory_order_relaxed);
+    g_thread_us[thread].add(own_us);
+    g_active_us.add(own_us);
+}
+
+/**
+ * @brief Mbed 空闲线程的累计运行时间（µs）；核心未启用 CPU 统计时返回 false
+ */
+static bool read_kernel_idle(uint64_t* out_idle_us) {
+#if defined(__MBED__) && defined(MBED_CPU_STATS_ENABLED)
+    mbed_stats_cpu_t cpu;
+    mbed_stats_cpu_get(&cpu);
+    *out_idle_us = cpu.idle_time;
+    return true;
+#else
+    *out_idle_us = 0;
+    return false;
+#endif
+}
+
+static uint16_t permille(uint32_t part_us, uint32_t window_us) {
+    if (window_us == 0) {
+        return 0;
+    }
+    const uint64_t value = ((uint64_t)part_us * 1000 + window_us / 2) / window_us;
+    return (uint16_t)(value > 1000 ? 1000 : value);
+}
+
+// ==================== 公共接口实现 ====================
+
+void energy_module_init() {
+    g_window_start_us = micros();
+    for (size_t i = 0; i < ENERGY_THREAD_COUNT; i++) {
+        g_thread_us[i].take();
+    }
+    g_active_us.take();
+    read_kernel_idle(&g_kernel_idle_us);
+}
+
+void energy_module_wake(energy_thread_t thread) {
+#if ENERGY_INSTRUMENTATION
+    if (thread >= ENERGY_THREAD_COUNT) {
+        return;
+    }
+    // 已在活动中（重复登记）时先结束上一次活动
+    charge(thread);
+    energy_thread_state_t& state = g_threads[thread];
+    state.wake_charged_us = g_charged_us.load(std::memory_order_relaxed);
+    state.wake_us = micros();
+    state.active = true;
+#else
+    (void)thread;
+#endif
+}
+
+void energy_module_sleep(energy_thread_t thread) {
+#if ENERGY_INSTRUMENTATION
+    if (thread < ENERGY_THREAD_COUNT) {
+        charge(thread);
+    }
+#else
+    (void)thread;
+#endif
+}
+
+void energy_module_sleep_for(energy_thread_t thread, std::chrono::milliseconds duration) {
+    energy_module_sleep(thread);
+    rtos::ThisThread::sleep_for(duration);
+    energy_module_wake(thread);
+}
+
+void energy_module_snapshot(uint32_t windows, energy_stats_t* out_stats) {
+    energy_stats_t stats = {};
+    const uint32_t now_us = micros();
+    stats.window_us = now_us - g_window_start_us;
+    stats.active_us = g_active_us.take();
+    for (size_t i = 0; i < ENERGY_THREAD_COUNT; i++) {
+        stats.thread_us[i] = g_thread_us[i].take();
+    }
+    g_window_start_us = now_us;
+    uint64_t kernel_idle_us = 0;
+    stats.kernel_idle_valid = read_kernel_idle(&kernel_idle_us);
+    stats.kernel_idle_us = (uint32_t)(kernel_idle_us - g_kernel_idle_us);
+    g_kernel_idle_us = kernel_idle_us;
+
+    // mW x µs = nJ
+    const uint32_t sleep_us = stats.window_us > stats.active_us ? stats.window_us - stats.active_us : 0;
+    stats.windows = windows;
+    stats.energy_uj = (stats.active_us * ENERGY_ACTIVE_MW + sleep_us * ENERGY_SLEEP_MW +
+                       stats.window_us * ENERGY_BASELINE_MW) / 1000.0f;
+    stats.uj_per_window = windows > 0 ? stats.energy_uj / windows : 0.0f;
+    stats.inference_uj_per_window =
+        windows > 0 ? stats.thread_us[ENERGY_INFERENCE] * ENERGY_ACTIVE_MW / 1000.0f / windows : 0.0f;
+
+    g_snapshot.store(stats);
+    if (out_stats) {
+        *out_stats = stats;
+    }
+}
+
+void energy_module_get_stats(energy_stats_t* out_stats) {
+    if (out_stats) {
+        g_snapshot.load(out_stats);
+    }
+}
+
+void energy_module_utilization(const energy_stats_t& stats, energy_utilization_t* out_utilization) {
+    if (!out_utilization) {
+        return;
+    }
+    out_utilization->active_permille = permille(stats.active_us, stats.window_us);
+    for (size_t i = 0; i < ENERGY_THREAD_COUNT; i++) {
+        out_utilization->thread_permille[i] = permille(stats.thread_us[i], stats.window_us);
+    }
+    if (stats.kernel_idle_valid) {
+        out_utilization->idle_permille = permille(stats.kernel_idle_us, stats.window_us);
+        const int other = 1000 - out_utilization->active_permille - out_utilization->idle_permille;
+        out_utilization->other_permille = (uint16_t)(other > 0 ? other : 0);
+    } else {
+        out_utilization->idle_permille = 1000 - out_utilization->active_permille;
+        out_utilization->other_permille = 0xFFFF;
+    }
+}
@@ -0,0 +1,259 @@
+// ESP32 构建的平台层：include/esp32/mbed.h 中 Mbed 驱动替身的实现（ESP-IDF / Arduino-ESP32）
+#include <Arduino.h>
+#include "mbed.h"
+#include <string.h>
+#include "esp_idf_version.h"
+#include "esp_partition.h"
+#include "esp_task_wdt.h"
+
+#include "app_config.h"
+
+// ==================== 内部状态（模块私有） ====================
+
+// 所有 CriticalSectionLock 共用一把自旋锁：两个核上的临界区彼此互斥
+static portMUX_TYPE g_critical_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// FlashIAP 使用的数据分区及其映射（首次 init 时建立，之后常驻）
+static const esp_partition_t* g_store_partition = nullptr;
+static const uint8_t* g_store_base = nullptr;
+#if ESP_IDF_VERSION_MAJOR >= 5
+static esp_partition_mmap_handle_t g_store_mmap;
+#define STORE_MMAP_DATA ESP_PARTITION_MMAP_DATA
+#else
+static spi_flash_mmap_handle_t g_store_mmap;
+#define STORE_MMAP_DATA SPI_FLASH_MMAP_DATA
+#endif
+
+// Arduino-ESP32 2.x 的 LEDC 接口按通道寻址，按构造顺序分配
+static uint8_t g_next_pwm_channel = 0;
+
+#define PWM_RESOLUTION_BITS 12
+
+/**
+ * @brief 把映射地址换算为分区内偏移，越界返回 false
+ */
+static bool store_offset(uint32_t address, uint32_t size, size_t* out_offset) {
+    if (g_store_partition == nullptr) {
+        return false;
+    }
+    const uint32_t base = (uint32_t)(uintptr_t)g_store_base;
+    if (address < base || size > g_store_partition->size || address - base > g_store_partition->size - size) {
+        return false;
+    }
+    *out_offset = address - base;
+    return true;
+}
+
+namespace mbed {
+
+// ==================== CriticalSectionLock ====================
+
+CriticalSectionLock::CriticalSectionLock() {
+    if (xPortInIsrContext()) {
+        portENTER_CRITICAL_ISR(&g_critical_mux);
+    } else {
+        portENTER_CRITICAL(&g_critical_mux);
+    }
+}
+
+CriticalSectionLock::~CriticalSectionLock() {
+    if (xPortInIsrContext()) {
+        portEXIT_CRITICAL_ISR(&g_critical_mux);
+    } else {
+        portEXIT_CRITICAL(&g_critical_mux);
+    }
+}
+
+// ==================== InterruptIn ====================
+
+void InterruptIn::rise(void (*handler)()) {
+    pinMode(pin_, INPUT);
+    attachInterrupt(digitalPinToInterrupt(pin_), handler, RISING);
+}
+
+void InterruptIn::fall(void (*handler)()) {
+    pinMode(pin_, INPUT);
+    attachInterrupt(digitalPinToInterrupt(pin_), handler, FALLING);
+}
+
+// ==================== Ticker / Timeout ====================
+
+TimerEvent::~TimerEvent() {
+    if (handle_) {
+        esp_timer_stop(handle_);
+        esp_timer_delete(handle_);
+    }
+}
+
+void TimerEvent::dispatch(void* arg) {
+    void (*handler)() = static_cast<TimerEvent*>(arg)->handler_;
+    if (handler) {
+        handler();
+    }
+}
+
+void TimerEvent::arm(void (*handler)(), int64_t period_us, bool periodic) {
+    if (handle_ == nullptr) {
+        const esp_timer_create_args_t args = {&TimerEvent::dispatch, this, ESP_TIMER_TASK, "mbed-timer", true};
+        if (esp_timer_create(&args, &handle_) != ESP_OK) {
+            handle_ = nullptr;
+            return;
+        }
+    }
+    // 与 Mbed 一样，重新 attach 取消尚未到期的上一次
+    esp_timer_stop(handle_);
+    handler_ = handler;
+    const uint64_t us = period_us > 0 ? (uint64_t)period_us : 1;
+    if (periodic) {
+        esp_timer_start_periodic(handle_, us);
+    } else {
+        esp_timer_start_once(handle_, us);
+    }
+}
+
+void TimerEvent::detach() {
+    handler_ = nullptr;
+    if (handle_) {
+        esp_timer_stop(handle_);
+    }
+}
+
+// ==================== PwmOut ====================
+
+PwmOut::PwmOut(PinName pin) : pin_(pin), channel_(g_next_pwm_channel++), frequency_hz_(1000) {
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+    ledcAttach(pin_, frequency_hz_, PWM_RESOLUTION_BITS);
+#else
+    ledcSetup(channel_, frequency_hz_, PWM_RESOLUTION_BITS);
+    ledcAttachPin(pin_, channel_);
+#endif
+}
+
+void PwmOut::period_us(int us) {
+    frequency_hz_ = us > 0 ? 1000000u / (uint32_t)us : 1000;
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+    ledcChangeFrequency(pin_, frequency_hz_, PWM_RESOLUTION_BITS);
+#else
+    ledcChangeFrequency(channel_, frequency_hz_, PWM_RESOLUTION_BITS);
+#endif
+}
+
+void PwmOut::write(float value) {
+    value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+    const uint32_t duty = (uint32_t)(value * ((1u << PWM_RESOLUTION_BITS) - 1) + 0.5f);
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+    ledcWrite(pin_, duty);
+#else
+    ledcWrite(channel_, duty);
+#endif
+}
+
+// ==================== FlashIAP ====================
+
+int FlashIAP::init() {
+    if (g_store_base) {
+        return 0;
+    }
+    g_store_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                                 ESP32_STORE_PARTITION);
+    if (g_store_partition == nullptr) {
+        return -1;
+    }
+    const void* base = nullptr;
+    if (esp_partition_mmap(g_store_partition, 0, g_store_partition->size, STORE_MMAP_DATA, &base,
+                           &g_store_mmap) != ESP_OK) {
+        g_store_partition = nullptr;
+        return -1;
+    }
+    g_store_base = static_cast<const uint8_t*>(base);
+    return 0;
+}
+
+int FlashIAP::read(void* buffer, uint32_t address, uint32_t size) {
+    size_t offset;
+    if (!store_offset(address, size, &offset)) {
+        return -1;
+    }
+    memcpy(buffer, g_store_base + offset, size);
+    return 0;
+}
+
+// esp_partition_write / erase_range 期间两个核的 flash cache 都被暂停，写完后映射区的 cache 失效重读
+int FlashIAP::program(const void* buffer, uint32_t address, uint32_t size) {
+    size_t offset;
+    if (!store_offset(address, size, &offset)) {
+        return -1;
+    }
+    return esp_partition_write(g_store_partition, offset, buffer, size) == ESP_OK ? 0 : -1;
+}
+
+int FlashIAP::erase(uint32_t address, uint32_t size) {
+    size_t offset;
+    if (!store_offset(address, size, &offset) || offset % 4096 != 0 || size % 4096 != 0) {
+        return -1;
+    }
+    return esp_partition_erase_range(g_store_partition, offset, size) == ESP_OK ? 0 : -1;
+}
+
+uint32_t FlashIAP::get_flash_start() const {
+    return (uint32_t)(uintptr_t)g_store_base;
+}
+
+uint32_t FlashIAP::get_flash_size() const {
+    return g_store_partition ? (uint32_t)g_store_partition->size : 0;
+}
+
+// ==================== Watchdog / ResetReason ====================
+
+Watchdog& Watchdog::get_instance() {
+    static Watchdog instance;
+    return instance;
+}
+
+bool Watchdog::start(uint32_t timeout_ms) {
+    if (started_) {
+        return true;
+    }
+#if ESP_IDF_VERSION_MAJOR >= 5
+    const esp_task_wdt_config_t config = {timeout_ms, 0, true};
+    esp_err_t err = esp_task_wdt_reconfigure(&config);
+    if (err == ESP_ERR_INVALID_STATE) {
+        err = esp_task_wdt_init(&config);
+    }
+#else
+    const esp_err_t err = esp_task_wdt_init((timeout_ms + 999) / 1000, true);
+#endif
+    if (err != ESP_OK || esp_task_wdt_add(nullptr) != ESP_OK) {
+        return false;
+    }
+    started_ = true;
+    return true;
+}
+
+bool Watchdog::kick() {
+    return started_ && esp_task_wdt_reset() == ESP_OK;
+}
+
+reset_reason_t ResetReason::get() {
+    switch (esp_reset_reason()) {
+    case ESP_RST_POWERON:
+        return RESET_REASON_POWER_ON;
+    case ESP_RST_EXT:
+        return RESET_REASON_PIN_RESET;
+    case ESP_RST_BROWNOUT:
+        return RESET_REASON_BROWN_OUT;
+    case ESP_RST_SW:
+    case ESP_RST_PANIC:
+        return RESET_REASON_SOFTWARE;
+    case ESP_RST_INT_WDT:
+    case ESP_RST_TASK_WDT:
+    case ESP_RST_WDT:
+        return RESET_REASON_WATCHDOG;
+    case ESP_RST_DEEPSLEEP:
+        return RESET_REASON_WAKE_LOW_POWER;
+    default:
+        return RESET_REASON_UNKNOWN;
+    }
+}
+
+}  // namespace mbed
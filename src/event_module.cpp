@@ -0,0 +1,69 @@
+// 低优先级事件线程实现
+#include <Arduino.h>
+#include "mbed.h"
+#include <atomic>
+
+#include "app_config.h"
+#include "energy_module.h"
+#include "event_module.h"
+#include "led_module.h"
+#include "log_module.h"
+#include "stats_module.h"
+
+// ==================== 内部状态（模块私有） ====================
+
+struct event_entry_t {
+    void (*handler)();
+    energy_thread_t energy;  // 处理时间记给原先各自线程的统计项
+};
+
+// 派发表，顺序与 event_source_t 一致
+static const event_entry_t kEventTable[EVENT_SOURCE_COUNT] = {
+    {led_module_on_event, ENERGY_LED},
+    {log_module_drain, ENERGY_LOG},
+};
+
+// 每个事件源一个排队中、一个派发中（派发完成后才归还缓冲）
+static const size_t kQueueEvents = 2 * EVENT_SOURCE_COUNT;
+alignas(8) static unsigned char g_queue_buffer[kQueueEvents * EVENTS_EVENT_SIZE];
+static events::EventQueue g_queue(sizeof(g_queue_buffer), g_queue_buffer);
+
+// 已排队、尚未开始处理的事件源（位 = event_source_t）
+static std::atomic<uint32_t> g_pending(0);
+static StatCounter g_dropped;
+
+// ==================== 内部辅助函数 ====================
+
+static void dispatch(int source) {
+    // 先清除排队标志：处理期间的新投递再排一个事件，不会漏掉处理函数已经读过之后到达的数据
+    g_pending.fetch_and(~(1UL << source));
+    const event_entry_t& entry = kEventTable[source];
+    energy_module_wake(entry.energy);
+    entry.handler();
+    energy_module_sleep(entry.energy);
+}
+
+// ==================== 公共接口实现 ====================
+
+void event_module_post(event_source_t source) {
+    const uint32_t bit = 1UL << source;
+    if (g_pending.fetch_or(bit) & bit) {
+        return;
+    }
+    if (g_queue.call(dispatch, (int)source) == 0) {
+        g_pending.fetch_and(~bit);
+        g_dropped.add();
+    }
+}
+
+uint32_t event_module_dropped() {
+    return g_dropped.value();
+}
+
+void event_module_init() {
+    stats_module_register("events.dropped", &g_dropped);
+}
+
+void event_task() {
+    g_queue.dispatch_forever();
+}
@@ -0,0 +1,341 @@
+// 设备端自定义手势：录入、提交与最近中心分类
+#include <Arduino.h>
+#include "rtos.h"
+#include <string.h>
+
+#include "app_config.h"
+#include "calib_store.h"
+#include "fewshot_classifier.h"
+#include "fewshot_module.h"
+#include "log_module.h"
+#include "memory_module.h"
+#include "model_module.h"
+#include "model_slot_module.h"
+
+#if INFERENCE_FEWSHOT
+
+// 推理线程待处理的请求
+enum fewshot_request_t {
+    REQUEST_NONE = 0,
+    REQUEST_COMMIT,     // 提交正在录入的类别
+    REQUEST_ERASE,      // 删除 g_erase_class（0xFF = 全部）
+};
+
+static const char* const kErrorNames[] = {"ok", "class", "windows", "flash", "model", "state"};
+
+// ==================== 内部状态（模块私有） ====================
+
+// 类别表（flash 记录的 RAM 副本）、录入累加器与分类器只在推理线程中使用
+alignas(8) static fewshot_table_t g_table;
+static FewShotEnrollment<FEWSHOT_COLUMNS, FEWSHOT_CHANNELS> g_enrollment;
+static FewShotClassifier<FEWSHOT_COLUMNS, FEWSHOT_CHANNELS> g_classifier;
+static bool g_shape_ok = false;
+
+// g_status 与请求受 g_mutex 保护（BLE 线程登记命令、推理线程执行、任意线程读取）
+static rtos::Mutex g_mutex;
+static fewshot_status_t g_status = {FEWSHOT_IDLE, FEWSHOT_OK, 0xFF, 0, 0, 0, 0, -1, 0};
+static uint32_t g_capture_end_ms = 0;
+static uint32_t g_capture_start_windows = 0;
+static bool g_reset_enrollment = false;
+static int g_request = REQUEST_NONE;
+static uint8_t g_erase_class = 0xFF;
+
+// ==================== 内部辅助函数 ====================
+
+static void current_model(uint8_t* out_slot, uint32_t* out_version) {
+    model_slot_status_t slot = {MODEL_SLOT_BUILTIN, 0, 0xFF, 0, 0, 0};
+#if MODEL_OTA_ENABLE
+    model_slot_module_get_status(&slot);
+#endif
+    *out_slot = slot.active_slot;
+    *out_version = slot.version;
+}
+
+static bool table_matches_model() {
+    uint8_t slot;
+    uint32_t version;
+    current_model(&slot, &version);
+    return g_table.model_slot == slot && g_table.model_version == version;
+}
+
+/**
+ * @brief 按类别表重新配置分类器：形状不符或权重已更换时关闭
+ */
+static void configure_classifier() {
+    uint8_t mask = 0;
+    if (g_shape_ok && table_matches_model()) {
+        g_classifier.configure(&g_table.centroids[0][0], g_table.radii, FEWSHOT_MAX_CLASSES);
+        for (size_t k = 0; k < FEWSHOT_MAX_CLASSES; k++) {
+            if (g_table.radii[k] != 0) {
+                mask |= (uint8_t)(1u << k);
+            }
+        }
+    } else {
+        g_classifier.configure(nullptr, nullptr, 0);
+    }
+    g_mutex.lock();
+    g_status.class_mask = mask;
+    g_mutex.unlock();
+}
+
+/**
+ * @brief 清空类别表并记下当前权重（录入时的权重与现在不同，已有的中心不再有效）
+ */
+static void clear_table() {
+    memset(&g_table, 0, sizeof(g_table));
+    current_model(&g_table.model_slot, &g_table.model_version);
+}
+
+static void set_error(fewshot_error_t error) {
+    g_mutex.lock();
+    g_status.error = error;
+    g_mutex.unlock();
+    if (error != FEWSHOT_OK) {
+        LOG_WARN("[FewShot] Command failed: %s\n", kErrorNames[error]);
+    }
+}
+
+static bool save_table() {
+    if (!calib_store_save_fewshot(&g_table)) {
+        set_error(FEWSHOT_ERR_FLASH);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 新的录入由 BLE 线程登记，累加器在推理线程中清零
+ */
+static void take_enrollment_reset() {
+    g_mutex.lock();
+    const bool reset = g_reset_enrollment;
+    g_reset_enrollment = false;
+    g_mutex.unlock();
+    if (reset) {
+        g_enrollment.reset();
+    }
+}
+
+static void commit_enrollment(uint8_t class_index) {
+    take_enrollment_reset();
+    if (!g_shape_ok) {
+        set_error(FEWSHOT_ERR_MODEL);
+        return;
+    }
+    if (g_enrollment.windows() < FEWSHOT_MIN_WINDOWS) {
+        set_error(FEWSHOT_ERR_WINDOWS);
+        return;
+    }
+    if (!table_matches_model()) {
+        clear_table();
+    }
+    uint32_t spread = 0;
+    g_enrollment.finish(g_table.centroids[class_index], &spread);
+    const float radius = spread * FEWSHOT_RADIUS_SCALE;
+    g_table.radii[class_index] = radius < 1.0f ? 1 : (radius >= 4294967040.0f ? UINT32_MAX : (uint32_t)radius);
+
+    g_mutex.lock();
+    g_table.examples[class_index] = g_status.examples;
+    g_status.state = FEWSHOT_IDLE;
+    g_status.enroll_class = 0xFF;
+    g_status.error = FEWSHOT_OK;
+    g_mutex.unlock();
+
+    LOG_INFO("[FewShot] Class %u committed: %lu examples, %lu windows, radius %lu\n", (unsigned)class_index,
+             (unsigned long)g_table.examples[class_index], (unsigned long)g_enrollment.windows(),
+             (unsigned long)g_table.radii[class_index]);
+    g_enrollment.reset();
+    save_table();
+    configure_classifier();
+}
+
+static void erase_classes(uint8_t class_index) {
+    if (class_index == 0xFF || !table_matches_model()) {
+        clear_table();
+    } else {
+        g_table.examples[class_index] = 0;
+        g_table.radii[class_index] = 0;
+        memset(g_table.centroids[class_index], 0, sizeof(g_table.centroids[class_index]));
+    }
+    LOG_INFO("[FewShot] Class %u erased\n", (unsigned)class_index);
+    if (save_table()) {
+        set_error(FEWSHOT_OK);
+    }
+    configure_classifier();
+}
+
+// ==================== 公共接口实现 ====================
+
+void fewshot_module_begin() {
+    memory_module_register("few-shot classes", sizeof(g_table) + sizeof(g_enrollment), false);
+    if (!calib_store_load_fewshot(&g_table)) {
+        clear_table();
+        LOG_INFO("[FewShot] No custom gestures stored\n");
+    }
+    fewshot_module_configure();
+}
+
+void fewshot_module_configure() {
+    size_t columns = 0;
+    size_t channels = 0;
+    model_module_stream_features(nullptr, &columns, &channels);
+    g_shape_ok = columns == FEWSHOT_COLUMNS && channels == FEWSHOT_CHANNELS;
+    if (!g_shape_ok) {
+        LOG_ERROR("[FewShot] Activation shape %ux%u does not match %ux%u, custom gestures disabled\n",
+                  (unsigned)columns, (unsigned)channels, (unsigned)FEWSHOT_COLUMNS, (unsigned)FEWSHOT_CHANNELS);
+    } else if (!table_matches_model()) {
+        LOG_WARN("[FewShot] Custom gestures were enrolled with other weights, re-enroll them\n");
+    }
+    configure_classifier();
+    fewshot_status_t status;
+    fewshot_module_get_status(&status);
+    LOG_INFO("[FewShot] Custom gestures: class mask 0x%02x of %u classes\n", (unsigned)status.class_mask,
+             (unsigned)FEWSHOT_MAX_CLASSES);
+}
+
+bool fewshot_module_start(uint8_t class_index) {
+    g_mutex.lock();
+    bool ok = false;
+    if (class_index >= FEWSHOT_MAX_CLASSES ||
+        (g_status.state != FEWSHOT_IDLE && g_status.enroll_class != class_index)) {
+        g_status.error = FEWSHOT_ERR_CLASS;
+    } else if (g_status.state == FEWSHOT_CAPTURING || g_request != REQUEST_NONE) {
+        g_status.error = FEWSHOT_ERR_STATE;
+    } else {
+        if (g_status.state == FEWSHOT_IDLE) {
+            g_reset_enrollment = true;
+            g_status.enroll_class = class_index;
+            g_status.examples = 0;
+            g_status.windows = 0;
+        }
+        g_status.state = FEWSHOT_CAPTURING;
+        g_status.error = FEWSHOT_OK;
+        g_capture_start_windows = g_status.windows;
+        g_capture_end_ms = millis() + FEWSHOT_CAPTURE_MS;
+        ok = true;
+    }
+    g_mutex.unlock();
+    return ok;
+}
+
+bool fewshot_module_commit() {
+    g_mutex.lock();
+    const bool ok = g_status.state == FEWSHOT_ENROLLING && g_request == REQUEST_NONE;
+    if (ok) {
+        g_request = REQUEST_COMMIT;
+    } else {
+        g_status.error = FEWSHOT_ERR_STATE;
+    }
+    g_mutex.unlock();
+    return ok;
+}
+
+bool fewshot_module_erase(uint8_t class_index) {
+    g_mutex.lock();
+    bool ok = false;
+    if (class_index >= FEWSHOT_MAX_CLASSES && class_index != 0xFF) {
+        g_status.error = FEWSHOT_ERR_CLASS;
+    } else if (g_request != REQUEST_NONE) {
+        g_status.error = FEWSHOT_ERR_STATE;
+    } else {
+        g_request = REQUEST_ERASE;
+        g_erase_class = class_index;
+        ok = true;
+    }
+    g_mutex.unlock();
+    return ok;
+}
+
+void fewshot_module_cancel() {
+    g_mutex.lock();
+    if (g_request == REQUEST_COMMIT) {
+        g_request = REQUEST_NONE;
+    }
+    g_status.state = FEWSHOT_IDLE;
+    g_status.enroll_class = 0xFF;
+    g_status.examples = 0;
+    g_status.windows = 0;
+    g_status.error = FEWSHOT_OK;
+    g_mutex.unlock();
+}
+
+void fewshot_module_apply() {
+    g_mutex.lock();
+    // 一遍录入到期：收集到窗口才算一遍（整段时间都被判为 idle 时不计）
+    const bool captured = g_status.state == FEWSHOT_CAPTURING && (int32_t)(millis() - g_capture_end_ms) >= 0;
+    if (captured) {
+        g_status.state = FEWSHOT_ENROLLING;
+        if (g_status.windows > g_capture_start_windows) {
+            g_status.examples++;
+        }
+    }
+    const fewshot_status_t status = g_status;
+    const int request = g_request;
+    const uint8_t erase_class = g_erase_class;
+    g_request = REQUEST_NONE;
+    g_mutex.unlock();
+
+    if (captured) {
+        LOG_INFO("[FewShot] Class %u: %u examples, %u windows\n", (unsigned)status.enroll_class,
+                 (unsigned)status.examples, (unsigned)status.windows);
+    }
+    if (request == REQUEST_COMMIT) {
+        commit_enrollment(status.enroll_class);
+    } else if (request == REQUEST_ERASE) {
+        erase_classes(erase_class);
+    }
+}
+
+int fewshot_module_update(const int8_t* features, size_t first_column, bool active) {
+    if (!g_shape_ok || features == nullptr) {
+        return -1;
+    }
+    const int8_t(*rows)[FEWSHOT_CHANNELS] = reinterpret_cast<const int8_t(*)[FEWSHOT_CHANNELS]>(features);
+    g_mutex.lock();
+    const bool reset = g_reset_enrollment;
+    const bool capturing = g_status.state == FEWSHOT_CAPTURING;
+    g_reset_enrollment = false;
+    g_mutex.unlock();
+    if (reset) {
+        g_enrollment.reset();
+    }
+
+    // idle 窗口既不录入也不分类：自定义手势只从 CNN 认为有动作的窗口中区分
+    if (!active) {
+        return -1;
+    }
+    if (capturing) {
+        // 录入期间不分类：正在录入的手势可能与已有的类别相近
+        g_enrollment.add(rows, first_column);
+        g_mutex.lock();
+        g_status.windows = (uint16_t)(g_enrollment.windows() > UINT16_MAX ? UINT16_MAX : g_enrollment.windows());
+        g_mutex.unlock();
+        return -1;
+    }
+
+    const int match = g_classifier.classify(rows, first_column);
+    if (match >= 0) {
+        g_mutex.lock();
+        g_status.matches++;
+        g_status.last_class = (int8_t)match;
+        g_status.last_distance = g_classifier.distance();
+        g_mutex.unlock();
+    }
+    return match;
+}
+
+uint32_t fewshot_module_distance() {
+    return g_classifier.distance();
+}
+
+uint32_t fewshot_module_radius() {
+    return g_classifier.radius();
+}
+
+void fewshot_module_get_status(fewshot_status_t* out_status) {
+    g_mutex.lock();
+    *out_status = g_status;
+    g_mutex.unlock();
+}
+
+#endif
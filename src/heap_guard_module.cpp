@@ -0,0 +1,91 @@
+// 分配检查模块实现
+#include "heap_guard_module.h"
+
+#if HEAP_GUARD_ENABLE
+#include <stdlib.h>
+#include <atomic>
+#include "log_module.h"
+#include "mbed.h"
+
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+}
+
+// ==================== 内部状态（模块私有） ====================
+
+// 处于区段内的线程（nullptr = 无）；包装函数在任意线程与中断中被调用，只读它并对计数做原子加
+static std::atomic<osThreadId_t> g_armed_thread(nullptr);
+static std::atomic<uint32_t> g_allocations(0);
+static bool g_wrapped = false;
+
+static void note_allocation() {
+    osThreadId_t armed = g_armed_thread.load(std::memory_order_relaxed);
+    if (armed && !core_util_is_isr_active() && osThreadGetId() == armed) {
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// ==================== 链接器包装 ====================
+
+extern "C" {
+
+void* __wrap_malloc(size_t size) {
+    note_allocation();
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    note_allocation();
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    note_allocation();
+    return __real_realloc(ptr, size);
+}
+
+}
+
+// ==================== 公共接口实现 ====================
+
+void heap_guard_module_init() {
+    // 自检：在区段内分配一次，计数不变说明构建没有带上 -Wl,--wrap（volatile 防止编译器消去这次分配）
+    g_wrapped = true;
+    heap_guard_module_begin();
+    void* volatile probe = malloc(1);
+    free(probe);
+    g_wrapped = heap_guard_module_end() > 0;
+    if (g_wrapped) {
+        LOG_INFO("[HeapGuard] Allocation checks armed on the BLE publish path\n");
+    } else {
+        LOG_WARN("[HeapGuard] malloc is not wrapped (missing -Wl,--wrap=malloc); allocation checks disabled\n");
+    }
+}
+
+void heap_guard_module_begin() {
+    if (!g_wrapped) {
+        return;
+    }
+    g_allocations.store(0, std::memory_order_relaxed);
+    g_armed_thread.store(osThreadGetId(), std::memory_order_release);
+}
+
+uint32_t heap_guard_module_end() {
+    if (!g_wrapped) {
+        return 0;
+    }
+    g_armed_thread.store(nullptr, std::memory_order_release);
+    return g_allocations.load(std::memory_order_relaxed);
+}
+
+HeapGuardScope::~HeapGuardScope() {
+    const uint32_t allocations = heap_guard_module_end();
+    if (allocations > 0) {
+        LOG_ERROR("[HeapGuard] %s allocated %lu times\n", name_, (unsigned long)allocations);
+        mbed_assert_internal(name_, __FILE__, __LINE__);
+    }
+}
+
+#endif
@@ -0,0 +1,188 @@
+#include <Arduino.h>
+#include <ArduinoBLE.h>
+#include <string.h>
+
+#include "app_config.h"
+#include "calib_store.h"
+#include "hid_module.h"
+#include "log_module.h"
+
+#if BLE_HID_ENABLE
+
+namespace {
+
+static_assert(sizeof(hid_settings_t) == 40, "hid_settings_t must not contain padding");
+
+// Report ID 1: boot-compatible keyboard (modifiers, reserved, 6 key codes).
+// Report ID 2: one 16-bit consumer-control usage.
+const uint8_t kReportMap[] = {
+    0x05, 0x01, 0x09, 0x06, 0xA1, 0x01, 0x85, 0x01,  // Usage Page (Desktop), Keyboard, Collection, Report ID 1
+    0x05, 0x07, 0x19, 0xE0, 0x29, 0xE7, 0x15, 0x00,  //   Usage Page (Keys), modifiers E0-E7, 0..1
+    0x25, 0x01, 0x75, 0x01, 0x95, 0x08, 0x81, 0x02,  //   8 x 1 bit, Input (Variable)
+    0x95, 0x01, 0x75, 0x08, 0x81, 0x01,              //   1 x 8 bit reserved, Input (Constant)
+    0x95, 0x06, 0x75, 0x08, 0x15, 0x00, 0x25, 0x65,  //   6 x 8 bit, 0..101
+    0x05, 0x07, 0x19, 0x00, 0x29, 0x65, 0x81, 0x00,  //   key codes 0-101, Input (Array)
+    0xC0,                                            // End Collection
+    0x05, 0x0C, 0x09, 0x01, 0xA1, 0x01, 0x85, 0x02,  // Usage Page (Consumer), Consumer Control, Report ID 2
+    0x15, 0x00, 0x26, 0xFF, 0x03, 0x19, 0x00, 0x2A,  //   0..1023
+    0xFF, 0x03, 0x75, 0x10, 0x95, 0x01, 0x81, 0x00,  //   1 x 16 bit, Input (Array)
+    0xC0,                                            // End Collection
+};
+constexpr uint8_t kKeyboardReportId = 1;
+constexpr uint8_t kConsumerReportId = 2;
+constexpr size_t kKeyboardReportBytes = 8;
+constexpr size_t kConsumerReportBytes = 2;
+constexpr uint8_t kReportTypeInput = 1;
+
+// Keyboard usages of the default map (pc_controller/config_manager.py: left -> Right arrow, right -> Left arrow).
+constexpr uint8_t kUsageRightArrow = 0x4F;
+constexpr uint8_t kUsageLeftArrow = 0x50;
+
+BLEService g_hidService("1812");
+// bcdHID 1.11, country code 0, flags: normally connectable.
+const uint8_t kHidInformation[] = {0x11, 0x01, 0x00, 0x02};
+BLECharacteristic g_hidInformation("2A4A", BLERead, sizeof(kHidInformation), true);
+BLECharacteristic g_reportMap("2A4B", BLERead, sizeof(kReportMap), true);
+BLECharacteristic g_controlPoint("2A4C", BLEWriteWithoutResponse, 1, true);
+BLECharacteristic g_keyboardReport("2A4D", BLERead | BLENotify, kKeyboardReportBytes, true);
+BLECharacteristic g_consumerReport("2A4D", BLERead | BLENotify, kConsumerReportBytes, true);
+const uint8_t kKeyboardReference[] = {kKeyboardReportId, kReportTypeInput};
+const uint8_t kConsumerReference[] = {kConsumerReportId, kReportTypeInput};
+BLEDescriptor g_keyboardReferenceDescriptor("2908", kKeyboardReference, sizeof(kKeyboardReference));
+BLEDescriptor g_consumerReferenceDescriptor("2908", kConsumerReference, sizeof(kConsumerReference));
+
+// PnP ID: vendor ID source USB, Arduino SA vendor ID, Nano 33 BLE product ID, version 1.0.
+BLEService g_deviceInfoService("180A");
+const uint8_t kPnpId[] = {0x02, 0x41, 0x23, 0x5A, 0x80, 0x00, 0x01};
+BLECharacteristic g_pnpId("2A50", BLERead, sizeof(kPnpId), true);
+
+hid_settings_t g_settings;
+hid_settings_t g_saved;
+uint32_t g_last_key_ms = 0;
+bool g_typed = false;
+
+void default_settings(hid_settings_t* settings) {
+    memset(settings, 0, sizeof(*settings));
+    for (size_t i = 0; i < GESTURE_LABEL_COUNT; i++) {
+        if (strcmp(kGestureLabels[i].name, "left") == 0) {
+            settings->keys[i].usage = kUsageRightArrow;
+        } else if (strcmp(kGestureLabels[i].name, "right") == 0) {
+            settings->keys[i].usage = kUsageLeftArrow;
+        }
+    }
+}
+
+bool save_settings() {
+    if (memcmp(&g_settings, &g_saved, sizeof(g_settings)) == 0) {
+        return true;
+    }
+    if (!calib_store_save_hid(&g_settings)) {
+        LOG_WARN("[HID] Failed to save settings\n");
+        return false;
+    }
+    g_saved = g_settings;
+    return true;
+}
+
+// Bond callbacks: one central is remembered, so the OS reconnects encrypted without pairing again.
+int store_ltk(uint8_t* address, uint8_t* ltk) {
+    memcpy(g_settings.bond_address, address, sizeof(g_settings.bond_address));
+    memcpy(g_settings.bond_ltk, ltk, sizeof(g_settings.bond_ltk));
+    g_settings.bond_valid = 1;
+    return save_settings() ? 1 : 0;
+}
+
+int get_ltk(uint8_t* address, uint8_t* ltk) {
+    if (!g_settings.bond_valid ||
+        memcmp(address, g_settings.bond_address, sizeof(g_settings.bond_address)) != 0) {
+        return 0;
+    }
+    memcpy(ltk, g_settings.bond_ltk, sizeof(g_settings.bond_ltk));
+    return 1;
+}
+
+}  // namespace
+
+void hid_module_begin() {
+    if (calib_store_load_hid(&g_saved)) {
+        g_settings = g_saved;
+    } else {
+        default_settings(&g_settings);
+        g_saved = g_settings;
+    }
+
+    g_hidInformation.writeValue(kHidInformation, sizeof(kHidInformation));
+    g_reportMap.writeValue(kReportMap, sizeof(kReportMap));
+    const uint8_t keyboard_idle[kKeyboardReportBytes] = {0};
+    const uint8_t consumer_idle[kConsumerReportBytes] = {0};
+    g_keyboardReport.writeValue(keyboard_idle, sizeof(keyboard_idle));
+    g_consumerReport.writeValue(consumer_idle, sizeof(consumer_idle));
+    g_keyboardReport.addDescriptor(g_keyboardReferenceDescriptor);
+    g_consumerReport.addDescriptor(g_consumerReferenceDescriptor);
+    g_hidService.addCharacteristic(g_hidInformation);
+    g_hidService.addCharacteristic(g_reportMap);
+    g_hidService.addCharacteristic(g_controlPoint);
+    g_hidService.addCharacteristic(g_keyboardReport);
+    g_hidService.addCharacteristic(g_consumerReport);
+    BLE.addService(g_hidService);
+
+    g_pnpId.writeValue(kPnpId, sizeof(kPnpId));
+    g_deviceInfoService.addCharacteristic(g_pnpId);
+    BLE.addService(g_deviceInfoService);
+
+    // HID hosts only use an encrypted link.
+    BLE.setPairable(Pairable::YES);
+    BLE.setStoreLTK(store_ltk);
+    BLE.setGetLTK(get_ltk);
+    // The OS lists keyboards by appearance and the HID service UUID; the name stays in the scan response.
+    BLE.setAppearance(0x03C1);
+    BLE.setAdvertisedServiceUuid("1812");
+}
+
+void hid_module_get_keymap(hid_key_t* out_keys, uint8_t count) {
+    for (uint8_t i = 0; i < count && i < HID_MAX_LABELS; i++) {
+        out_keys[i] = g_settings.keys[i];
+    }
+}
+
+bool hid_module_set_keymap(const hid_key_t* keys, uint8_t count) {
+    for (uint8_t i = 0; i < HID_MAX_LABELS; i++) {
+        g_settings.keys[i] = i < count ? keys[i] : hid_key_t{0, 0};
+    }
+    return save_settings();
+}
+
+void hid_module_send(const inference_result_snapshot_t& result) {
+    if (result.index < 0 || result.index >= GESTURE_LABEL_COUNT) {
+        return;
+    }
+    const hid_key_t key = g_settings.keys[result.index];
+    const uint32_t now_ms = millis();
+    if (key.usage == 0 || (g_typed && now_ms - g_last_key_ms < BLE_HID_COOLDOWN_MS)) {
+        return;
+    }
+
+    if (key.modifiers == HID_MODIFIER_CONSUMER) {
+        if (!g_consumerReport.subscribed()) {
+            return;
+        }
+        const uint8_t press[kConsumerReportBytes] = {key.usage, 0};
+        const uint8_t release[kConsumerReportBytes] = {0, 0};
+        g_consumerReport.writeValue(press, sizeof(press));
+        g_consumerReport.writeValue(release, sizeof(release));
+    } else {
+        if (!g_keyboardReport.subscribed()) {
+            return;
+        }
+        const uint8_t press[kKeyboardReportBytes] = {key.modifiers, 0, key.usage, 0, 0, 0, 0, 0};
+        const uint8_t release[kKeyboardReportBytes] = {0};
+        g_keyboardReport.writeValue(press, sizeof(press));
+        g_keyboardReport.writeValue(release, sizeof(release));
+    }
+    g_last_key_ms = now_ms;
+    g_typed = true;
+    LOG_INFO("[HID] Typed key 0x%02x (modifiers 0x%02x) for %s\n", (unsigned)key.usage, (unsigned)key.modifiers,
+             kGestureLabels[result.index].name);
+}
+
+#endif
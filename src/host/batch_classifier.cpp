@@ -0,0 +1,229 @@
+// 主机批量分类：fork 出的工作进程共享窗口与结果，按原子计数器成块领取
+#include "batch_classifier.h"
+
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include "edge-impulse-sdk/classifier/ei_run_classifier.h"
+
+#define BATCH_CLASSIFIER_MAX_WORKERS 64
+
+static_assert(EI_CLASSIFIER_LABEL_COUNT <= BATCH_CLASSIFIER_MAX_LABELS, "raise BATCH_CLASSIFIER_MAX_LABELS");
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+              "the counters live in memory shared between processes");
+
+/**
+ * @brief 进程间共享的一轮工作（MAP_SHARED 匿名映射，fork 前创建）
+ * 调用者写好窗口与 count 后经管道唤醒各进程；管道的读写保证窗口在被读取前可见、结果在被读取前写完
+ */
+struct batch_shared_t {
+    std::atomic<uint32_t> next;     // 下一个未领取的窗口
+    std::atomic<uint64_t> busy_us;
+    uint32_t count;
+    float windows[BATCH_CLASSIFIER_MAX_WINDOWS][EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE];
+    batch_classifier_result_t results[BATCH_CLASSIFIER_MAX_WINDOWS];
+};
+
+// ==================== 内部状态（模块私有） ====================
+
+static batch_shared_t* g_shared = nullptr;
+static pid_t g_pids[BATCH_CLASSIFIER_MAX_WORKERS];
+static int g_start_fds[BATCH_CLASSIFIER_MAX_WORKERS];  // 调用者写入一个字节开始一轮，关闭即退出
+static int g_done_fds[BATCH_CLASSIFIER_MAX_WORKERS];   // 工作进程完成一轮时写回一个字节
+static size_t g_children = 0;
+
+// ==================== 内部辅助函数 ====================
+
+static uint64_t now_us() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void classify_window(uint32_t i) {
+    batch_classifier_result_t& out = g_shared->results[i];
+    signal_t signal;
+    ei_impulse_result_t result;
+    memset(&result, 0, sizeof(result));
+    if (numpy::signal_from_buffer(g_shared->windows[i], EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE, &signal) != 0 ||
+        run_classifier(&signal, &result, false) != EI_IMPULSE_OK) {
+        out.index = -1;
+        out.confidence = 0.0f;
+        return;
+    }
+    out.index = 0;
+    for (size_t c = 0; c < EI_CLASSIFIER_LABEL_COUNT; c++) {
+        out.scores[c] = result.classification[c].value;
+        if (out.scores[c] > out.scores[out.index]) {
+            out.index = (int16_t)c;
+        }
+    }
+    out.confidence = out.scores[out.index];
+}
+
+/**
+ * @brief 领取并分类窗口，直到本轮的窗口都被领完（调用者与每个工作进程都运行）
+ */
+static void work() {
+    const uint32_t count = g_shared->count;
+    const uint64_t start_us = now_us();
+    for (;;) {
+        const uint32_t first = g_shared->next.fetch_add(BATCH_CLASSIFIER_CHUNK, std::memory_order_relaxed);
+        if (first >= count) {
+            break;
+        }
+        const uint32_t end = first + BATCH_CLASSIFIER_CHUNK < count ? first + BATCH_CLASSIFIER_CHUNK : count;
+        for (uint32_t i = first; i < end; i++) {
+            classify_window(i);
+        }
+    }
+    g_shared->busy_us.fetch_add(now_us() - start_us, std::memory_order_relaxed);
+}
+
+static void worker_main(int start_fd, int done_fd) {
+    char token;
+    while (read(start_fd, &token, 1) == 1) {
+        work();
+        if (write(done_fd, &token, 1) != 1) {
+            break;
+        }
+    }
+    // 不执行静态析构与 stdio 刷新：它们属于父进程
+    _exit(0);
+}
+
+// ==================== 公共接口实现 ====================
+
+bool batch_classifier_init(size_t workers) {
+    batch_classifier_shutdown();
+    if (workers == 0) {
+        workers = std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1;
+    }
+    if (workers > BATCH_CLASSIFIER_MAX_WORKERS) {
+        workers = BATCH_CLASSIFIER_MAX_WORKERS;
+    }
+    void* shared = mmap(nullptr, sizeof(batch_shared_t), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED) {
+        perror("[Batch] mmap");
+        return false;
+    }
+    g_shared = new (shared) batch_shared_t;
+    // 调用者自己算一份，其余由子进程分担
+    fflush(stdout);
+    fflush(stderr);
+    for (size_t w = 0; w + 1 < workers; w++) {
+        int start_pipe[2];
+        int done_pipe[2];
+        if (pipe(start_pipe) != 0) {
+            perror("[Batch] pipe");
+            break;
+        }
+        if (pipe(done_pipe) != 0) {
+            perror("[Batch] pipe");
+            close(start_pipe[0]);
+            close(start_pipe[1]);
+            break;
+        }
+        const pid_t pid = fork();
+        if (pid == 0) {
+            // 只保留自己的两端；继承来的其他工作进程的写端不关掉的话，父进程关闭时它们读不到 EOF
+            for (size_t j = 0; j < g_children; j++) {
+                close(g_start_fds[j]);
+                close(g_done_fds[j]);
+            }
+            close(start_pipe[1]);
+            close(done_pipe[0]);
+            worker_main(start_pipe[0], done_pipe[1]);
+        }
+        close(start_pipe[0]);
+        close(done_pipe[1]);
+        if (pid < 0) {
+            perror("[Batch] fork");
+            close(start_pipe[1]);
+            close(done_pipe[0]);
+            break;
+        }
+        g_pids[g_children] = pid;
+        g_start_fds[g_children] = start_pipe[1];
+        g_done_fds[g_children] = done_pipe[0];
+        g_children++;
+    }
+    return true;
+}
+
+size_t batch_classifier_window_values() {
+    return EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE;
+}
+
+size_t batch_classifier_frame_values() {
+    return EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME;
+}
+
+size_t batch_classifier_label_count() {
+    return EI_CLASSIFIER_LABEL_COUNT;
+}
+
+const char* batch_classifier_label(size_t index) {
+    return index < EI_CLASSIFIER_LABEL_COUNT ? ei_classifier_inferencing_categories[index] : "";
+}
+
+bool batch_classifier_run(const float* windows, size_t count, batch_classifier_result_t* results,
+                          batch_classifier_stats_t* stats) {
+    if (g_shared == nullptr) {
+        return false;
+    }
+    const uint64_t start_us = now_us();
+    uint64_t busy_us = 0;
+    bool ok = true;
+    for (size_t first = 0; first < count; first += BATCH_CLASSIFIER_MAX_WINDOWS) {
+        const size_t n = count - first < BATCH_CLASSIFIER_MAX_WINDOWS ? count - first : BATCH_CLASSIFIER_MAX_WINDOWS;
+        memcpy(g_shared->windows, windows + first * EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE,
+               n * sizeof(g_shared->windows[0]));
+        g_shared->count = (uint32_t)n;
+        g_shared->next.store(0, std::memory_order_relaxed);
+        g_shared->busy_us.store(0, std::memory_order_relaxed);
+        const char token = 1;
+        for (size_t w = 0; w < g_children; w++) {
+            ok = write(g_start_fds[w], &token, 1) == 1 && ok;
+        }
+        work();
+        for (size_t w = 0; w < g_children; w++) {
+            char done;
+            ok = read(g_done_fds[w], &done, 1) == 1 && ok;
+        }
+        memcpy(results + first, g_shared->results, n * sizeof(results[0]));
+        busy_us += g_shared->busy_us.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < n; i++) {
+            ok = ok && results[first + i].index >= 0;
+        }
+    }
+    if (stats != nullptr) {
+        stats->windows = (uint32_t)count;
+        stats->workers = (uint32_t)(g_children + 1);
+        stats->wall_us = now_us() - start_us;
+        stats->busy_us = busy_us;
+        stats->windows_per_s = stats->wall_us > 0 ? count * 1e6f / stats->wall_us : 0.0f;
+    }
+    return ok;
+}
+
+void batch_classifier_shutdown() {
+    for (size_t w = 0; w < g_children; w++) {
+        close(g_start_fds[w]);
+        close(g_done_fds[w]);
+    }
+    for (size_t w = 0; w < g_children; w++) {
+        waitpid(g_pids[w], nullptr, 0);
+    }
+    g_children = 0;
+    if (g_shared != nullptr) {
+        g_shared->~batch_shared_t();
+        munmap(g_shared, sizeof(batch_shared_t));
+        g_shared = nullptr;
+    }
+}
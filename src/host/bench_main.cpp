@@ -0,0 +1,438 @@
+// 主机微基准：SDK 内核与编译模型各跑固定次数，stdout 输出一份 JSON（日志在 stderr）
+//
+//   {"schema": 1, "compiler": "...", "benchmarks": [
+//     {"name": "model_invoke", "iterations": 200, "repeats": 7, "ns_per_op": {"min": ..., "median": ..., "max": ...}}, ...]}
+//
+// 每项先预热一轮，再计时 repeats 轮固定次数的循环，取每次调用的纳秒数；输入由固定种子生成，每次运行都相同。
+// 用法：program [--repeats <n>] [--filter <name 子串>]（pio run -e host_bench；
+// pc_controller/bench_compare.py 对比两次的 JSON，超出阈值的项使命令失败）
+#include <Arduino.h>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include "app_config.h"
+#include "fewshot_classifier.h"
+#include "gravity_frame.h"
+#include "window_normalizer.h"
+#include "edge-impulse-sdk/classifier/ei_run_classifier.h"
+#include "edge-impulse-sdk/classifier/ei_aligned_malloc.h"
+#include "tflite-model/tflite_learn_792000_36_compiled.h"
+
+// 与 inference_module 相同的窗口与步长（SLIDING_WINDOW_STEP：每次 2 个样本的全部轴）
+static const size_t kWindowValues = EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE;
+static const size_t kStepValues = 2 * EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME;
+static const int kMaxRepeats = 31;
+
+struct bench_case_t {
+    const char* name;
+    uint32_t iterations;  // 每轮调用次数：各项一轮约 5–20 ms，次数固定，结果才能跨版本直接比较
+    bool (*setup)();
+    void (*run)(uint32_t iteration);
+};
+
+// 防止编译器把没有副作用的循环删掉
+static volatile float g_sink = 0.0f;
+
+static uint32_t g_seed = 0x12345678u;
+
+static uint32_t next_random() {
+    g_seed = g_seed * 1664525u + 1013904223u;
+    return g_seed;
+}
+
+static float random_sample() {
+    // ±2 g
+    return ((int32_t)(next_random() >> 16) - 32768) / 16384.0f;
+}
+
+// ==================== 编译模型 ====================
+
+static TfLiteTensor g_input;
+static TfLiteTensor g_output;
+
+static bool setup_model() {
+    if (tflite_learn_792000_36_init(ei_aligned_calloc) != kTfLiteOk ||
+        tflite_learn_792000_36_input(0, &g_input) != kTfLiteOk ||
+        tflite_learn_792000_36_output(0, &g_output) != kTfLiteOk) {
+        fprintf(stderr, "model init failed\n");
+        return false;
+    }
+    for (size_t i = 0; i < g_input.bytes; i++) {
+        g_input.data.int8[i] = (int8_t)(next_random() >> 24);
+    }
+    return true;
+}
+
+static void run_model(uint32_t iteration) {
+    // 每次改一个输入值：内核不能因为输入不变而走捷径
+    g_input.data.int8[iteration % g_input.bytes] ^= 1;
+    tflite_learn_792000_36_invoke();
+    g_sink = g_sink + g_output.data.int8[0];
+}
+
+// ==================== DSP ====================
+
+static float g_samples[kWindowValues];
+static float g_features[kWindowValues];
+
+static bool setup_samples() {
+    for (size_t i = 0; i < kWindowValues; i++) {
+        g_samples[i] = random_sample();
+    }
+    return true;
+}
+
+static void run_signal_from_buffer(uint32_t) {
+    signal_t signal;
+    numpy::signal_from_buffer(g_samples, kWindowValues, &signal);
+    signal.get_data(0, kWindowValues, g_features);
+    g_sink = g_sink + g_features[kWindowValues - 1];
+}
+
+static void run_scale(uint32_t iteration) {
+    // scale-axes 为 1.0 时 numpy::scale 直接返回：交替乘 2 与 0.5，值保持不变且都是精确的
+    matrix_t matrix(1, kWindowValues, g_samples);
+    numpy::scale(&matrix, (iteration & 1) ? 0.5f : 2.0f);
+    g_sink = g_sink + g_samples[0];
+}
+
+static void run_extract_raw_features(uint32_t) {
+    signal_t signal;
+    numpy::signal_from_buffer(g_samples, kWindowValues, &signal);
+    matrix_t features(1, kWindowValues, g_features);
+    extract_raw_features(&signal, &features, ei_dsp_blocks[0].config, EI_CLASSIFIER_FREQUENCY);
+    g_sink = g_sink + g_features[0];
+}
+
+// ==================== 后处理 ====================
+
+static int8_t g_raw_scores[EI_CLASSIFIER_LABEL_COUNT];
+static ei::matrix_i8_t g_raw_matrix(1, EI_CLASSIFIER_LABEL_COUNT, g_raw_scores);
+static ei_feature_t g_raw_output;
+static ei_impulse_result_t g_result;
+
+static bool setup_postprocess() {
+    for (size_t i = 0; i < EI_CLASSIFIER_LABEL_COUNT; i++) {
+        g_raw_scores[i] = (int8_t)(next_random() >> 24);
+    }
+    const ei_learning_block_t& block = ei_default_impulse.impulse->learning_blocks[0];
+    g_raw_output.matrix_i8 = &g_raw_matrix;
+    g_raw_output.blockId = block.blockId;
+    g_result._raw_outputs = &g_raw_output;
+    return true;
+}
+
+static void run_postprocess(uint32_t iteration) {
+    const ei_postprocessing_block_t& block = ei_default_impulse.impulse->postprocessing_blocks[0];
+    g_raw_scores[iteration % EI_CLASSIFIER_LABEL_COUNT] ^= 1;
+    block.postprocess_fn(&ei_default_impulse, 0, block.input_block_id, &g_result, block.config, nullptr);
+    g_sink = g_sink + g_result.classification[0].value;
+}
+
+// ==================== 滑动窗口 ====================
+
+// 与 inference_module 的 slide_window() / window_get_data() 相同：一步样本写到最旧数据的位置、只移动 head，
+// 读出时从最旧的样本开始分两段复制（浮点窗口路径）
+static float g_window[kWindowValues];
+static size_t g_window_head = 0;
+
+static void run_window_update(uint32_t) {
+    for (size_t i = 0; i < kStepValues; i++) {
+        g_window[g_window_head + i] = g_samples[(g_window_head + i) % kWindowValues];
+    }
+    g_window_head = (g_window_head + kStepValues) % kWindowValues;
+    const size_t first = kWindowValues - g_window_head;
+    memcpy(g_features, &g_window[g_window_head], first * sizeof(float));
+    memcpy(g_features + first, g_window, (kWindowValues - first) * sizeof(float));
+    g_sink = g_sink + g_features[0];
+}
+
+// ==================== 逐窗口标准化 ====================
+
+// 与 inference_module 的 INFERENCE_WINDOW_NORMALIZE 相同：每步两帧进入窗口，按窗口统计量标准化并量化为 int8。
+// window_normalize_step 为增量版本，window_normalize_full 把原始帧写入环形窗口后每步按整个窗口重新求
+// mean / stdev（对照）。输入是幅度逐段变化的随机流，长度为窗口的 4 倍，窗口统计量每步都在变
+static const size_t kAxes = EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME;
+static const size_t kFrames = EI_CLASSIFIER_RAW_SAMPLE_COUNT;
+static const size_t kStreamFrames = 4 * kFrames;
+static const float kQuantScale = 1.0f / 32.0f;
+static float g_stream[kStreamFrames * kAxes];
+static float g_raw_window[kWindowValues];
+static size_t g_raw_head = 0;
+static WindowNormalizer<kAxes, kFrames> g_normalizer;
+static int8_t g_quantized[kWindowValues];
+
+static void quantize_frame(const float* frame, const float* mean, const float* variance, int8_t* out) {
+    for (size_t a = 0; a < kAxes; a++) {
+        const float sd = sqrtf(variance[a]);
+        const int32_t q = (int32_t)lroundf((frame[a] - mean[a]) / (sd > 1e-3f ? sd : 1e-3f) / kQuantScale);
+        out[a] = (int8_t)(q < -128 ? -128 : (q > 127 ? 127 : q));
+    }
+}
+
+/**
+ * @brief 对照：一步两帧写入原始环形窗口，按整个窗口重新求各轴均值与总体方差后量化这两帧
+ */
+static void normalize_full(const float* frames, int8_t* out) {
+    memcpy(&g_raw_window[g_raw_head], frames, kStepValues * sizeof(float));
+    g_raw_head = (g_raw_head + kStepValues) % kWindowValues;
+    float mean[kAxes];
+    float variance[kAxes];
+    for (size_t a = 0; a < kAxes; a++) {
+        float sum = 0.0f;
+        for (size_t f = 0; f < kFrames; f++) {
+            sum += g_raw_window[f * kAxes + a];
+        }
+        mean[a] = sum / kFrames;
+        float sum_sq = 0.0f;
+        for (size_t f = 0; f < kFrames; f++) {
+            const float d = g_raw_window[f * kAxes + a] - mean[a];
+            sum_sq += d * d;
+        }
+        variance[a] = sum_sq / kFrames;
+    }
+    quantize_frame(&frames[0], mean, variance, &out[0]);
+    quantize_frame(&frames[kAxes], mean, variance, &out[kAxes]);
+}
+
+static bool setup_normalize() {
+    for (size_t f = 0; f < kStreamFrames; f++) {
+        const float amplitude = 0.1f + (float)((f / 7) % 5);
+        for (size_t a = 0; a < kAxes; a++) {
+            g_stream[f * kAxes + a] = random_sample() * amplitude + (a == 2 ? 1.0f : 0.0f);
+        }
+    }
+    memset(g_raw_window, 0, sizeof(g_raw_window));
+    g_raw_head = 0;
+    g_normalizer.configure(1.0f / kQuantScale, 0, nullptr);
+    g_normalizer.reset();
+
+    // 窗口填满之后，增量版本的每个量化值与对照相差不超过 1 LSB（两者的浮点运算顺序不同），覆盖多次精确重算
+    for (size_t step = 0; step < 2 * kStreamFrames; step++) {
+        const float* frames = &g_stream[((step * 2) % kStreamFrames) * kAxes];
+        int8_t incremental[kStepValues];
+        int8_t full[kStepValues];
+        g_normalizer.quantize(frames, 2, incremental);
+        normalize_full(frames, full);
+        if ((step + 1) * 2 < kFrames) {
+            continue;
+        }
+        for (size_t i = 0; i < kStepValues; i++) {
+            if (abs(incremental[i] - full[i]) > 1) {
+                fprintf(stderr, "window normalizer diverged at step %u value %u: %d vs %d\n", (unsigned)step,
+                        (unsigned)i, incremental[i], full[i]);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void run_normalize_step(uint32_t iteration) {
+    const size_t frame = (iteration * 2) % kStreamFrames;
+    g_normalizer.quantize(&g_stream[frame * kAxes], 2, &g_quantized[(frame % kFrames) * kAxes]);
+    g_sink = g_sink + g_quantized[0];
+}
+
+static void run_normalize_full(uint32_t iteration) {
+    const size_t frame = (iteration * 2) % kStreamFrames;
+    normalize_full(&g_stream[frame * kAxes], &g_quantized[(frame % kFrames) * kAxes]);
+    g_sink = g_sink + g_quantized[0];
+}
+
+// ==================== 输入量化 ====================
+
+// fill_input_tensor_from_matrix 的 int8 分支：一个窗口的 float 特征量化为模型输入。input_quantize_divide 为
+// 逐值 pre_cast_quantize（除法 + round），input_quantize_reciprocal 为 ei_input_quantizer（倒数乘法）。
+// 量化步长取非 2 的幂，除法与乘法的舍入才会不同；输入复用逐窗口标准化的随机流
+static const float kInputScale = 0.0173f;
+static const int32_t kInputZeroPoint = -6;
+static const ei_input_quantizer g_input_quantizer(kInputScale, kInputZeroPoint);
+
+static bool quantize_matches_reference(float x) {
+    const int32_t expected = pre_cast_quantize(x, kInputScale, kInputZeroPoint, true);
+    int8_t batch;
+    g_input_quantizer.quantize_i8(&x, &batch, 1);
+    const int32_t got = g_input_quantizer.quantize_i8(x);
+    if (got != batch || got != expected) {
+        fprintf(stderr, "input quantizer diverged at %.9g: %d / %d vs %d\n", x, (int)got, (int)batch, (int)expected);
+        return false;
+    }
+    return true;
+}
+
+static bool setup_quantize() {
+    setup_normalize();
+
+    // 与 pre_cast_quantize 逐值比较，必须完全一致：随机流之外再覆盖每个 .5 边界两侧各 4 个 ulp
+    for (size_t i = 0; i < kStreamFrames * kAxes; i++) {
+        for (float factor : {1.0f, 20.0f}) {
+            if (!quantize_matches_reference(g_stream[i] * factor)) {
+                return false;
+            }
+        }
+    }
+    for (int k = -140; k < 140; k++) {
+        float x = ((float)k + 0.5f) * kInputScale;
+        for (int step = 0; step < 4; step++) {
+            x = nextafterf(x, -1e9f);
+        }
+        for (int step = 0; step < 9; step++, x = nextafterf(x, 1e9f)) {
+            if (!quantize_matches_reference(x)) {
+                return false;
+            }
+        }
+    }
+    int8_t batch[kWindowValues];
+    g_input_quantizer.quantize_i8(g_stream, batch, kWindowValues);
+    for (size_t i = 0; i < kWindowValues; i++) {
+        if (batch[i] != g_input_quantizer.quantize_i8(g_stream[i])) {
+            fprintf(stderr, "input quantizer batch differs at value %u\n", (unsigned)i);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void run_quantize_divide(uint32_t iteration) {
+    const float* features = &g_stream[(iteration % 4) * kWindowValues / 4];
+    for (size_t i = 0; i < kWindowValues; i++) {
+        g_quantized[i] = (int8_t)pre_cast_quantize(features[i], kInputScale, kInputZeroPoint, true);
+    }
+    g_sink = g_sink + g_quantized[iteration % kWindowValues];
+}
+
+static void run_quantize_reciprocal(uint32_t iteration) {
+    const float* features = &g_stream[(iteration % 4) * kWindowValues / 4];
+    g_input_quantizer.quantize_i8(features, g_quantized, kWindowValues);
+    g_sink = g_sink + g_quantized[iteration % kWindowValues];
+}
+
+// ==================== 重力坐标系 ====================
+
+// 与 imu_module 的重力坐标系级相同的逐样本工作：EKF 预测 + 更新与两次旋转，输入为 1 g 附近的随机 6 轴帧
+static const size_t kImuFrames = 256;
+static float g_imu_frames[kImuFrames * 6];
+static GravityFrame g_gravity(IMU_GRAVITY_GYRO_NOISE, IMU_GRAVITY_ACC_NOISE, IMU_GRAVITY_DYNAMIC_GAIN);
+
+static bool setup_gravity() {
+    for (size_t i = 0; i < kImuFrames; i++) {
+        float* frame = &g_imu_frames[i * 6];
+        for (size_t c = 0; c < 3; c++) {
+            frame[c] = random_sample() * 0.25f + (c == 2 ? 1.0f : 0.0f);
+            frame[3 + c] = random_sample() * 100.0f;
+        }
+    }
+    g_gravity.set_period((float)IMU_DECIMATION_FACTOR / IMU_SENSOR_ODR_HZ);
+    g_gravity.reset();
+    return true;
+}
+
+static void run_gravity(uint32_t iteration) {
+    const float* frame = &g_imu_frames[(iteration % kImuFrames) * 6];
+    float out[6];
+    g_gravity.update(&frame[0], &frame[3]);
+    g_gravity.rotate(&frame[0], &out[0]);
+    g_gravity.rotate(&frame[3], &out[3]);
+    g_sink = g_sink + out[2] + out[5];
+}
+
+// ==================== 自定义手势 ====================
+
+// 与 fewshot_module 相同的最近中心搜索：FEWSHOT_MAX_CLASSES 个已录入的类别，环形起点逐次移动；
+// 主机上走标量路径，设备上是 SMLAD 路径，两者结果逐位相同
+static int8_t g_fewshot_rows[FEWSHOT_COLUMNS][FEWSHOT_CHANNELS];
+static int8_t g_fewshot_centroids[FEWSHOT_MAX_CLASSES][FEWSHOT_COLUMNS * FEWSHOT_CHANNELS];
+static uint32_t g_fewshot_radii[FEWSHOT_MAX_CLASSES];
+static FewShotClassifier<FEWSHOT_COLUMNS, FEWSHOT_CHANNELS> g_fewshot;
+
+static bool setup_fewshot() {
+    for (size_t j = 0; j < FEWSHOT_COLUMNS; j++) {
+        for (size_t i = 0; i < FEWSHOT_CHANNELS; i++) {
+            g_fewshot_rows[j][i] = (int8_t)(next_random() >> 24);
+        }
+    }
+    for (size_t k = 0; k < FEWSHOT_MAX_CLASSES; k++) {
+        for (size_t i = 0; i < FEWSHOT_COLUMNS * FEWSHOT_CHANNELS; i++) {
+            g_fewshot_centroids[k][i] = (int8_t)(next_random() >> 24);
+        }
+        g_fewshot_radii[k] = 1;
+    }
+    g_fewshot.configure(&g_fewshot_centroids[0][0], g_fewshot_radii, FEWSHOT_MAX_CLASSES);
+    return true;
+}
+
+static void run_fewshot(uint32_t iteration) {
+    g_fewshot.classify(g_fewshot_rows, iteration % FEWSHOT_COLUMNS);
+    g_sink = g_sink + (float)g_fewshot.distance();
+}
+
+static const bench_case_t kCases[] = {
+    {"model_invoke", 200, setup_model, run_model},
+    {"extract_raw_features", 200000, setup_samples, run_extract_raw_features},
+    {"signal_from_buffer", 200000, setup_samples, run_signal_from_buffer},
+    {"numpy_scale", 200000, setup_samples, run_scale},
+    {"process_classification_i8", 200000, setup_postprocess, run_postprocess},
+    {"sliding_window_update", 200000, setup_samples, run_window_update},
+    {"window_normalize_step", 200000, setup_normalize, run_normalize_step},
+    {"window_normalize_full", 200000, setup_normalize, run_normalize_full},
+    {"input_quantize_divide", 200000, setup_quantize, run_quantize_divide},
+    {"input_quantize_reciprocal", 200000, setup_quantize, run_quantize_reciprocal},
+    {"gravity_frame_update", 200000, setup_gravity, run_gravity},
+    {"fewshot_nearest_centroid", 20000, setup_fewshot, run_fewshot},
+};
+
+static double time_round(const bench_case_t& bench) {
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < bench.iterations; i++) {
+        bench.run(i);
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / bench.iterations;
+}
+
+int main(int argc, char** argv) {
+    int repeats = 7;
+    const char* filter = nullptr;
+    bool usage_ok = true;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--repeats") == 0 && i + 1 < argc) {
+            repeats = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else {
+            usage_ok = false;
+        }
+    }
+    if (!usage_ok || repeats < 1 || repeats > kMaxRepeats) {
+        fprintf(stderr, "usage: %s [--repeats <1-%d>] [--filter <name>]\n", argv[0], kMaxRepeats);
+        return 2;
+    }
+
+    printf("{\"schema\": 1, \"compiler\": \"%s\", \"benchmarks\": [", __VERSION__);
+    bool first = true;
+    for (const bench_case_t& bench : kCases) {
+        if (filter && !strstr(bench.name, filter)) {
+            continue;
+        }
+        if (!bench.setup()) {
+            return 1;
+        }
+        time_round(bench);
+        double ns[kMaxRepeats];
+        for (int r = 0; r < repeats; r++) {
+            ns[r] = time_round(bench);
+        }
+        std::sort(ns, ns + repeats);
+        printf("%s\n  {\"name\": \"%s\", \"iterations\": %u, \"repeats\": %d, "
+               "\"ns_per_op\": {\"min\": %.2f, \"median\": %.2f, \"max\": %.2f}}",
+               first ? "" : ",", bench.name, (unsigned)bench.iterations, repeats, ns[0], ns[repeats / 2],
+               ns[repeats - 1]);
+        fprintf(stderr, "%-28s %10.1f ns/op (median of %d)\n", bench.name, ns[repeats / 2], repeats);
+        first = false;
+    }
+    printf("\n]}\n");
+    return 0;
+}
@@ -0,0 +1,328 @@
+// 主机模型推理：在 PC 上用 SDK 的 TFLM 解释器运行比板上更大的模型（例如 2 s 六轴窗口上的 CNN + GRU），
+// 所有已连接设备的窗口成批推理。pc_controller/host_model.py 启动本程序，经 stdin / stdout 按行通信（日志在 stderr）：
+//
+//   -> ready,<batch>,<每窗口值数>,<类别数>       启动后一次：模型输入第 0 维、其余各维之积、输出类别数
+//   <- window,<stream>,<tag>,<hex>              一个窗口：按帧交错的 int16 样本（传感器 LSB），每个 4 位十六进制（小端）
+//   <- run                                      推理此前收到的全部窗口
+//   -> result,<stream>,<tag>,<p0>,...,<pN-1>   每个窗口一行，按收到的顺序
+//   -> done,<windows>,<invokes>,<invoke_us>
+//
+// 每次 Invoke 填满模型的批维度（不足的部分补零），窗口多于一批时连续调用；样本乘以 --scale 的逐通道系数换算为模型单位
+// （g、°/s），float32 输入直接写入，int8 输入按张量的量化参数量化；int8 输出按量化参数还原。
+// 解析器注册 SDK 的全部算子（AllOpsResolver）：展开的 GRU（unroll=True 导出为全连接与逐元素算子）与
+// UNIDIRECTIONAL_SEQUENCE_LSTM 都可以直接运行。
+//
+// 模型写成 --builtin 时运行部署的 impulse（DSP + 编译模型，batch_classifier.h）：一次 run 的全部窗口作为一批
+// 分给 --workers 个进程（默认 CPU 核心数），ready 的批大小为一次共享的窗口容量，done 的 invoke_us 为整批耗时，
+// 每批的每秒窗口数与并行效率写到 stderr。
+//
+// 用法：program <model.tflite> --channels <n> [--scale s0,s1,...] [--arena-kb <n>]（pio run -e host_model）
+//       program --builtin --channels <n> [--scale s0,s1,...] [--workers <n>]
+#include <Arduino.h>
+#include <iostream>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "batch_classifier.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/all_ops_resolver.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/micro_interpreter.h"
+#include "edge-impulse-sdk/tensorflow/lite/schema/schema_generated_full.h"
+
+// 主机内存充裕：arena 默认 4 MB，够 2 s 窗口上的循环网络
+static const size_t kDefaultArenaKb = 4096;
+
+struct pending_window_t {
+    std::string stream;
+    std::string tag;
+    std::vector<int16_t> values;
+};
+
+static bool read_file(const char* path, std::vector<uint64_t>* out, size_t* bytes) {
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    const long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    // uint64_t 存储保证 flatbuffer 的 8 字节对齐
+    out->assign(size > 0 ? ((size_t)size + 7) / 8 : 0, 0);
+    const bool ok = size > 0 && fread(out->data(), 1, (size_t)size, file) == (size_t)size;
+    fclose(file);
+    *bytes = ok ? (size_t)size : 0;
+    return ok;
+}
+
+static bool parse_scales(const char* text, std::vector<float>* out) {
+    out->clear();
+    while (*text != '\0') {
+        char* end = nullptr;
+        out->push_back(strtof(text, &end));
+        if (end == text || (*end != ',' && *end != '\0')) {
+            return false;
+        }
+        text = *end == ',' ? end + 1 : end;
+    }
+    return !out->empty();
+}
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+/**
+ * @brief 解析一行 window,<stream>,<tag>,<hex>
+ */
+static bool parse_window(const std::string& line, size_t values, pending_window_t* out) {
+    const size_t first = line.find(',');
+    const size_t second = line.find(',', first + 1);
+    const size_t third = line.find(',', second + 1);
+    if (first == std::string::npos || second == std::string::npos || third == std::string::npos ||
+        line.size() - third - 1 != values * 4) {
+        return false;
+    }
+    out->stream = line.substr(first + 1, second - first - 1);
+    out->tag = line.substr(second + 1, third - second - 1);
+    out->values.resize(values);
+    const char* hex = line.c_str() + third + 1;
+    for (size_t i = 0; i < values; i++, hex += 4) {
+        int digits[4];
+        for (int d = 0; d < 4; d++) {
+            digits[d] = hex_digit(hex[d]);
+            if (digits[d] < 0) {
+                return false;
+            }
+        }
+        // 小端：低字节在前
+        out->values[i] = (int16_t)(uint16_t)((digits[0] << 4) | digits[1] | (digits[2] << 12) | (digits[3] << 8));
+    }
+    return true;
+}
+
+static void fill_input(TfLiteTensor* input, size_t slot, size_t values, const std::vector<int16_t>* samples,
+                       const std::vector<float>& scales) {
+    const size_t channels = scales.size();
+    for (size_t i = 0; i < values; i++) {
+        const float value = samples != nullptr ? (*samples)[i] * scales[i % channels] : 0.0f;
+        if (input->type == kTfLiteFloat32) {
+            input->data.f[slot * values + i] = value;
+        } else {
+            const long q = lroundf(value / input->params.scale) + input->params.zero_point;
+            input->data.int8[slot * values + i] = (int8_t)(q > 127 ? 127 : (q < -128 ? -128 : q));
+        }
+    }
+}
+
+static float output_score(const TfLiteTensor* output, size_t index) {
+    if (output->type == kTfLiteFloat32) {
+        return output->data.f[index];
+    }
+    return (output->data.int8[index] - output->params.zero_point) * output->params.scale;
+}
+
+static size_t element_count(const TfLiteTensor* tensor) {
+    size_t count = 1;
+    for (int i = 0; i < tensor->dims->size; i++) {
+        count *= (size_t)tensor->dims->data[i];
+    }
+    return count;
+}
+
+/**
+ * @brief --builtin：部署的 impulse 经批量分类运行，协议同上
+ */
+static int run_builtin(size_t channels, const std::vector<float>& scales, size_t workers) {
+    const size_t values = batch_classifier_window_values();
+    const size_t classes = batch_classifier_label_count();
+    if (channels != batch_classifier_frame_values()) {
+        fprintf(stderr, "[HostModel] The deployed impulse takes %u-channel frames, the stream has %u\n",
+                (unsigned)batch_classifier_frame_values(), (unsigned)channels);
+        return 1;
+    }
+    // 在读 stdin 之前 fork：此时进程只有一个线程
+    if (!batch_classifier_init(workers)) {
+        return 1;
+    }
+    fprintf(stderr, "[HostModel] Deployed impulse, %u frames x %u channels, %u classes\n",
+            (unsigned)(values / channels), (unsigned)channels, (unsigned)classes);
+    printf("ready,%u,%u,%u\n", (unsigned)BATCH_CLASSIFIER_MAX_WINDOWS, (unsigned)values, (unsigned)classes);
+    fflush(stdout);
+
+    std::vector<pending_window_t> pending;
+    std::vector<float> windows;
+    std::vector<batch_classifier_result_t> results;
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        if (line.compare(0, 7, "window,") == 0) {
+            pending_window_t window;
+            if (parse_window(line, values, &window)) {
+                pending.push_back(std::move(window));
+            } else {
+                fprintf(stderr, "[HostModel] Malformed window line dropped\n");
+            }
+            continue;
+        }
+        if (line != "run") {
+            continue;
+        }
+        windows.resize(pending.size() * values);
+        for (size_t n = 0; n < pending.size(); n++) {
+            for (size_t i = 0; i < values; i++) {
+                windows[n * values + i] = pending[n].values[i] * scales[i % channels];
+            }
+        }
+        results.resize(pending.size());
+        batch_classifier_stats_t stats = {};
+        if (!pending.empty() && !batch_classifier_run(windows.data(), pending.size(), results.data(), &stats)) {
+            fprintf(stderr, "[HostModel] run_classifier failed\n");
+            batch_classifier_shutdown();
+            return 1;
+        }
+        for (size_t n = 0; n < pending.size(); n++) {
+            printf("result,%s,%s", pending[n].stream.c_str(), pending[n].tag.c_str());
+            for (size_t c = 0; c < classes; c++) {
+                printf(",%.5f", results[n].scores[c]);
+            }
+            printf("\n");
+        }
+        const size_t rounds = (pending.size() + BATCH_CLASSIFIER_MAX_WINDOWS - 1) / BATCH_CLASSIFIER_MAX_WINDOWS;
+        printf("done,%u,%u,%u\n", (unsigned)pending.size(), (unsigned)rounds, (unsigned)stats.wall_us);
+        fflush(stdout);
+        if (stats.wall_us > 0) {
+            fprintf(stderr, "[HostModel] %u windows, %u workers: %.0f windows/s, %.0f%% parallel efficiency\n",
+                    (unsigned)stats.windows, (unsigned)stats.workers, stats.windows_per_s,
+                    100.0 * stats.busy_us / ((double)stats.wall_us * stats.workers));
+        }
+        pending.clear();
+    }
+    batch_classifier_shutdown();
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    bool usage_ok = argc >= 2;
+    const bool builtin = argc >= 2 && strcmp(argv[1], "--builtin") == 0;
+    size_t channels = 0;
+    size_t arena_kb = kDefaultArenaKb;
+    size_t workers = 0;
+    std::vector<float> scales;
+    for (int i = 2; i < argc && usage_ok; i++) {
+        if (strcmp(argv[i], "--channels") == 0 && i + 1 < argc) {
+            channels = (size_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc) {
+            usage_ok = parse_scales(argv[++i], &scales);
+        } else if (strcmp(argv[i], "--arena-kb") == 0 && i + 1 < argc) {
+            arena_kb = (size_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            workers = (size_t)atoi(argv[++i]);
+        } else {
+            usage_ok = false;
+        }
+    }
+    if (scales.empty()) {
+        scales.assign(channels, 1.0f);
+    }
+    if (!usage_ok || channels == 0 || scales.size() != channels || arena_kb == 0) {
+        fprintf(stderr, "usage: %s <model.tflite> --channels <n> [--scale s0,s1,...] [--arena-kb <n>]\n"
+                        "       %s --builtin --channels <n> [--scale s0,s1,...] [--workers <n>]\n",
+                argv[0], argv[0]);
+        return 2;
+    }
+    if (builtin) {
+        return run_builtin(channels, scales, workers);
+    }
+
+    std::vector<uint64_t> model;
+    size_t model_bytes = 0;
+    if (!read_file(argv[1], &model, &model_bytes)) {
+        fprintf(stderr, "[HostModel] Cannot read %s\n", argv[1]);
+        return 1;
+    }
+    const uint8_t* buffer = reinterpret_cast<const uint8_t*>(model.data());
+    flatbuffers::Verifier verifier(buffer, model_bytes);
+    if (!tflite::VerifyModelBuffer(verifier)) {
+        fprintf(stderr, "[HostModel] %s is not a valid TFLite flatbuffer\n", argv[1]);
+        return 1;
+    }
+    static tflite::AllOpsResolver resolver;
+    std::vector<uint8_t> arena(arena_kb * 1024);
+    tflite::MicroInterpreter interpreter(tflite::GetModel(buffer), resolver, arena.data(), arena.size());
+    if (interpreter.AllocateTensors(true) != kTfLiteOk || interpreter.inputs_size() != 1 ||
+        interpreter.outputs_size() != 1) {
+        fprintf(stderr, "[HostModel] AllocateTensors failed (unsupported op, arena too small, or not one input "
+                        "and one output)\n");
+        return 1;
+    }
+    TfLiteTensor* input = interpreter.input(0);
+    TfLiteTensor* output = interpreter.output(0);
+    const size_t batch = input->dims->size > 1 ? (size_t)input->dims->data[0] : 1;
+    const size_t values = element_count(input) / batch;
+    const size_t classes = element_count(output) / batch;
+    if ((input->type != kTfLiteFloat32 && input->type != kTfLiteInt8) ||
+        (output->type != kTfLiteFloat32 && output->type != kTfLiteInt8) || values % channels != 0) {
+        fprintf(stderr, "[HostModel] Expected float32 / int8 tensors and a window of whole %u-channel frames\n",
+                (unsigned)channels);
+        return 1;
+    }
+    fprintf(stderr, "[HostModel] %u B flatbuffer, batch %u, %u frames x %u channels, %u classes, arena %u of %u B\n",
+            (unsigned)model_bytes, (unsigned)batch, (unsigned)(values / channels), (unsigned)channels,
+            (unsigned)classes, (unsigned)interpreter.arena_used_bytes(), (unsigned)arena.size());
+    printf("ready,%u,%u,%u\n", (unsigned)batch, (unsigned)values, (unsigned)classes);
+    fflush(stdout);
+
+    std::vector<pending_window_t> pending;
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        if (line.compare(0, 7, "window,") == 0) {
+            pending_window_t window;
+            if (parse_window(line, values, &window)) {
+                pending.push_back(std::move(window));
+            } else {
+                fprintf(stderr, "[HostModel] Malformed window line dropped\n");
+            }
+            continue;
+        }
+        if (line != "run") {
+            continue;
+        }
+        uint32_t invokes = 0;
+        uint32_t invoke_us = 0;
+        for (size_t first = 0; first < pending.size(); first += batch) {
+            for (size_t slot = 0; slot < batch; slot++) {
+                const size_t n = first + slot;
+                fill_input(input, slot, values, n < pending.size() ? &pending[n].values : nullptr, scales);
+            }
+            const uint32_t start_us = micros();
+            if (interpreter.Invoke() != kTfLiteOk) {
+                fprintf(stderr, "[HostModel] Invoke failed\n");
+                return 1;
+            }
+            invoke_us += micros() - start_us;
+            invokes++;
+            for (size_t slot = 0; slot < batch && first + slot < pending.size(); slot++) {
+                const pending_window_t& window = pending[first + slot];
+                printf("result,%s,%s", window.stream.c_str(), window.tag.c_str());
+                for (size_t c = 0; c < classes; c++) {
+                    printf(",%.5f", output_score(output, slot * classes + c));
+                }
+                printf("\n");
+            }
+        }
+        printf("done,%u,%u,%u\n", (unsigned)pending.size(), (unsigned)invokes, (unsigned)invoke_us);
+        fflush(stdout);
+        pending.clear();
+    }
+    return 0;
+}
@@ -0,0 +1,92 @@
+// 主机离线回放构建的平台层：Arduino 时间函数，以及板上才有意义的模块的空实现
+#include <Arduino.h>
+#include <chrono>
+#include <thread>
+#include "core1_module.h"
+#include "memory_module.h"
+#include "model_slot_module.h"
+#include "record_module.h"
+#include "supervisor_module.h"
+
+HostSerial Serial;
+
+static const std::chrono::steady_clock::time_point g_start = std::chrono::steady_clock::now();
+
+uint32_t micros() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - g_start).count();
+}
+
+uint32_t millis() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - g_start).count();
+}
+
+void delay(uint32_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+// 主机上只有单核路径：作业在推理线程中直接运行
+bool core1_module_run(core1_job_t job, void* arg) {
+    return job(arg);
+}
+
+// 回放时不录制原始数据
+bool record_module_active() {
+    return false;
+}
+
+// 主机上没有线程监督
+void supervisor_module_heartbeat(thread_role_t) {
+}
+
+// 主机上不统计 RAM 预算，也没有 arena 借用者
+void memory_module_register(const char*, size_t, bool) {
+}
+
+void memory_module_report() {
+}
+
+void memory_module_dsp_begin() {
+}
+
+void memory_module_dsp_end() {
+}
+
+void* memory_module_borrow(size_t) {
+    return nullptr;
+}
+
+void memory_module_release(void*) {
+}
+
+bool memory_module_arena_lent() {
+    return false;
+}
+
+bool memory_module_in_static_ram(const void*) {
+    return false;
+}
+
+void memory_module_register_hot(const char*, const void*, size_t, uint8_t) {
+}
+
+size_t memory_module_check_placement() {
+    return 0;
+}
+
+// 主机上没有 Flash 模型槽，始终使用内置权重
+void model_slot_module_begin() {
+}
+
+bool model_slot_module_apply() {
+    return false;
+}
+
+bool model_slot_module_request_builtin() {
+    return false;
+}
+
+void model_slot_module_get_status(model_slot_status_t* out_status) {
+    *out_status = model_slot_status_t{MODEL_SLOT_BUILTIN, MODEL_SLOT_OK, 0xFF, 0, 0, 0};
+}
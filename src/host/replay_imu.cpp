@@ -0,0 +1,508 @@
+// 主机离线回放的 IMU 数据源：按 imu_module.h 的接口回放 raw_recorder.py 导出的 CSV、会话语料中的一个会话
+// （session_corpus.h，直接读映射中的列）或 replay_source_simulate 的模拟数据
+// 样本先换算回 BMI270 的 int16 LSB，再经过与设备相同的抗混叠抽取和线性重采样，
+// 因此回放与板上看到的是同一条 DSP 链（校准除外：录制的是校准前的原始数据）。
+// 打开 IMU_GRAVITY_FRAME 时抽取后的帧同样经过重力坐标系级（录制须包含陀螺仪）
+#include <Arduino.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "app_config.h"
+#include "fir_decimator.h"
+#include "gravity_frame.h"
+#include "imu_module.h"
+#include "replay_source.h"
+#include "resampler.h"
+#include "session_corpus.h"
+
+// 与 imu_module.cpp / raw_recorder.py 一致的量程：±4 g / ±2000 dps
+#define ACC_LSB_PER_G          8192.0f
+#define GYR_LSB_PER_DPS        16.384f
+
+namespace {
+struct axis_name_t {
+    const char* name;
+    uint8_t channel;
+};
+
+// 与 imu_module.cpp 相同的融合轴名称；CSV 列名（accX / gyrX ...）转小写后同样查这张表
+const axis_name_t kAxisNames[] = {
+    {"accx", 0}, {"accy", 1}, {"accz", 2},
+    {"gyrx", 3}, {"gyry", 4}, {"gyrz", 5},
+    {"gyrox", 3}, {"gyroy", 4}, {"gyroz", 5},
+};
+
+// CSV 与模拟数据的存放：每帧 IMU_MAX_AXES 个原始 LSB（缺失的通道为 0），时间戳为相对第一帧的 µs
+std::vector<int16_t> g_recording;
+std::vector<uint32_t> g_recording_us;
+// 语料会话的列直接指向映射
+session_corpus_t g_corpus = {};
+
+// 回放读取的视图：每个通道一列（步长为相邻帧的间隔，以值计），缺失的通道指向 0、步长为 0
+const int16_t kZeroSample = 0;
+const int16_t* g_columns[IMU_MAX_AXES];
+size_t g_column_stride[IMU_MAX_AXES];
+const uint32_t* g_timestamps_us = nullptr;
+size_t g_frame_count = 0;
+uint8_t g_channel_mask = 0;
+size_t g_next_frame = 0;
+
+uint8_t g_axis_map[IMU_MAX_AXES];
+size_t g_axis_count = 0;
+
+FirDecimator<IMU_MAX_AXES, IMU_DECIMATION_TAPS> g_decimator;
+#if INFERENCE_Q15_FEATURES
+LinearResamplerQ15<IMU_MAX_AXES> g_resampler;
+#else
+LinearResampler<IMU_MAX_AXES> g_resampler;
+#endif
+#if IMU_GRAVITY_FRAME
+GravityFrame g_gravity(IMU_GRAVITY_GYRO_NOISE, IMU_GRAVITY_ACC_NOISE, IMU_GRAVITY_DYNAMIC_GAIN);
+#endif
+
+// 一个原始帧最多产生两个输出帧，放不下的留到下一次读取
+imu_sample_t g_carry[2 * IMU_MAX_AXES];
+size_t g_carry_count = 0;
+size_t g_carry_pos = 0;
+
+imu_stats_t g_stats = {};
+volatile bool g_finished = false;
+
+// 回放速度（倍实时，0 = 最快）与第一次读取的时刻
+float g_speed = 0.0f;
+uint32_t g_first_read_us = 0;
+bool g_started = false;
+}
+
+static int channel_from_name(const char* name) {
+    char token[8];
+    size_t len = 0;
+    for (; name[len] && len < sizeof(token) - 1; len++) {
+        token[len] = (char)tolower((unsigned char)name[len]);
+    }
+    token[len] = '\0';
+    for (size_t i = 0; i < sizeof(kAxisNames) / sizeof(kAxisNames[0]); i++) {
+        if (strcmp(token, kAxisNames[i].name) == 0) {
+            return kAxisNames[i].channel;
+        }
+    }
+    return -1;
+}
+
+static inline float channel_lsb(size_t channel) {
+    return channel < 3 ? ACC_LSB_PER_G : GYR_LSB_PER_DPS;
+}
+
+static int16_t to_lsb(float value, size_t channel) {
+    const long v = lroundf(value * channel_lsb(channel));
+    return (int16_t)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+}
+
+/**
+ * @brief 把一行 CSV 按逗号原地切分
+ * @return size_t 字段个数（最多 max_fields）
+ */
+static size_t split_fields(char* line, char** fields, size_t max_fields) {
+    size_t count = 0;
+    char* p = line;
+    while (count < max_fields) {
+        fields[count++] = p;
+        char* comma = strchr(p, ',');
+        if (!comma) {
+            break;
+        }
+        *comma = '\0';
+        p = comma + 1;
+    }
+    p = fields[count - 1];
+    p[strcspn(p, "\r\n")] = '\0';
+    return count;
+}
+
+/**
+ * @brief 回放 g_recording / g_recording_us（按帧交错存放）
+ */
+static void use_interleaved(uint8_t channel_mask) {
+    session_corpus_close(&g_corpus);
+    for (size_t c = 0; c < IMU_MAX_AXES; c++) {
+        g_columns[c] = g_recording.data() + c;
+        g_column_stride[c] = IMU_MAX_AXES;
+    }
+    g_timestamps_us = g_recording_us.data();
+    g_frame_count = g_recording_us.size();
+    g_channel_mask = channel_mask;
+}
+
+static void rewind_recording() {
+    g_next_frame = 0;
+    g_finished = false;
+    g_started = false;
+}
+
+/**
+ * @brief 按回放速度，下一个原始帧要到第一次读取之后多少微秒才交出（最快速度时为 0）
+ */
+static uint32_t frame_due_us(size_t frame) {
+    if (g_speed <= 0.0f) {
+        return 0;
+    }
+    return (uint32_t)((g_timestamps_us[frame] - g_timestamps_us[0]) / g_speed);
+}
+
+static bool recording_long_enough(const char* path) {
+    if (g_frame_count < 2 || g_timestamps_us[g_frame_count - 1] <= g_timestamps_us[0]) {
+        Serial.print("[Replay] Recording too short: ");
+        Serial.println(path);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 回放语料中的一个会话（spec 为 "语料#序号"）：列指针直接指向映射，不复制样本
+ */
+static bool open_corpus_session(const char* spec) {
+    char path[512];
+    uint32_t index = 0;
+    if (!session_corpus_parse_spec(spec, path, sizeof(path), &index)) {
+        Serial.print("[Replay] Corpus sessions are opened as <corpus>#<index>: ");
+        Serial.println(spec);
+        return false;
+    }
+    session_corpus_close(&g_corpus);
+    session_corpus_view_t view;
+    if (!session_corpus_open(path, &g_corpus)) {
+        return false;
+    }
+    if (!session_corpus_session(&g_corpus, index, &view)) {
+        Serial.print("[Replay] No such session: ");
+        Serial.println(spec);
+        session_corpus_close(&g_corpus);
+        return false;
+    }
+    for (size_t c = 0; c < IMU_MAX_AXES; c++) {
+        const bool present = c < SESSION_CORPUS_CHANNELS && view.columns[c] != nullptr;
+        g_columns[c] = present ? view.columns[c] : &kZeroSample;
+        g_column_stride[c] = present ? 1 : 0;
+    }
+    g_timestamps_us = view.timestamps_us;
+    g_frame_count = view.frames;
+    g_channel_mask = view.channel_mask;
+    if (!recording_long_enough(spec)) {
+        return false;
+    }
+    rewind_recording();
+    return true;
+}
+
+bool replay_source_open(const char* path) {
+    if (session_corpus_is_corpus(path)) {
+        Serial.print("[Replay] Select a session of the corpus: ");
+        Serial.print(path);
+        Serial.println("#<index>");
+        return false;
+    }
+    FILE* f = fopen(path, "r");
+    if (!f && strchr(path, '#') != nullptr) {
+        return open_corpus_session(path);
+    }
+    if (!f) {
+        Serial.print("[Replay] Cannot open ");
+        Serial.println(path);
+        return false;
+    }
+
+    char line[512];
+    char* fields[1 + IMU_MAX_AXES * 2];
+    const size_t max_fields = sizeof(fields) / sizeof(fields[0]);
+    int column_channel[max_fields];
+    uint8_t channel_mask = 0;
+
+    const size_t header_fields = fgets(line, sizeof(line), f) ? split_fields(line, fields, max_fields) : 0;
+    if (header_fields < 2 || strcmp(fields[0], "timestamp") != 0) {
+        Serial.print("[Replay] Missing CSV header in ");
+        Serial.println(path);
+        fclose(f);
+        return false;
+    }
+    for (size_t i = 1; i < header_fields; i++) {
+        column_channel[i] = channel_from_name(fields[i]);
+        if (column_channel[i] >= 0) {
+            channel_mask |= (uint8_t)(1u << column_channel[i]);
+        }
+    }
+
+    g_recording.clear();
+    g_recording_us.clear();
+    float first_ms = 0.0f;
+    while (fgets(line, sizeof(line), f)) {
+        if (split_fields(line, fields, max_fields) < header_fields) {
+            continue;
+        }
+        const float ms = strtof(fields[0], nullptr);
+        if (g_recording_us.empty()) {
+            first_ms = ms;
+        }
+        g_recording_us.push_back((uint32_t)lroundf((ms - first_ms) * 1000.0f));
+        int16_t frame[IMU_MAX_AXES] = {0};
+        for (size_t i = 1; i < header_fields; i++) {
+            if (column_channel[i] >= 0) {
+                frame[column_channel[i]] = to_lsb(strtof(fields[i], nullptr), (size_t)column_channel[i]);
+            }
+        }
+        g_recording.insert(g_recording.end(), frame, frame + IMU_MAX_AXES);
+    }
+    fclose(f);
+
+    use_interleaved(channel_mask);
+    if (!recording_long_enough(path)) {
+        return false;
+    }
+    rewind_recording();
+    return true;
+}
+
+bool replay_source_simulate(float seconds, float sensor_hz, uint32_t seed) {
+    if (!(seconds > 0.0f) || !(sensor_hz > 0.0f)) {
+        return false;
+    }
+    const size_t frames = (size_t)(seconds * sensor_hz);
+    if (frames < 2) {
+        return false;
+    }
+    g_recording.assign(frames * IMU_MAX_AXES, 0);
+    g_recording_us.resize(frames);
+    uint32_t state = seed;
+    for (size_t i = 0; i < frames; i++) {
+        const float t = i / sensor_hz;
+        g_recording_us[i] = (uint32_t)lroundf(t * 1e6f);
+        // 每 3 秒中挥动 1 秒（2 Hz）：加速度 ±1.5 g、角速度 ±300 dps，其余时间静止，重力在 z 轴上
+        const float phase = fmodf(t, 3.0f);
+        const float swing = phase < 1.0f ? sinf(2.0f * (float)M_PI * 2.0f * phase) : 0.0f;
+        const float acc[3] = {1.5f * swing, 0.5f * swing, 1.0f};
+        const float gyr[3] = {0.0f, 0.0f, 300.0f * swing};
+        for (size_t channel = 0; channel < IMU_MAX_AXES; channel++) {
+            state = state * 1664525u + 1013904223u;
+            // 约 ±0.01 g / ±1 dps 的均匀噪声
+            const float noise = ((int32_t)(state >> 16) - 32768) / 32768.0f * (channel < 3 ? 0.01f : 1.0f);
+            const float value = (channel < 3 ? acc[channel] : gyr[channel - 3]) + noise;
+            g_recording[i * IMU_MAX_AXES + channel] = to_lsb(value, channel);
+        }
+    }
+    use_interleaved((uint8_t)((1u << IMU_MAX_AXES) - 1));
+    rewind_recording();
+    return true;
+}
+
+void replay_source_set_speed(float speed) {
+    g_speed = speed > 0.0f ? speed : 0.0f;
+}
+
+bool replay_source_finished() {
+    return g_finished;
+}
+
+void replay_source_get_stats(uint32_t* out_sensor_frames, uint32_t* out_output_frames, uint32_t* out_process_us) {
+    if (out_sensor_frames) {
+        *out_sensor_frames = g_stats.sensor_frames;
+    }
+    if (out_output_frames) {
+        *out_output_frames = g_stats.output_frames;
+    }
+    if (out_process_us) {
+        *out_process_us = g_stats.process_us;
+    }
+}
+
+// ==================== imu_module.h 接口 ====================
+
+bool imu_module_init(float output_hz, const char* fusion_axes) {
+    g_axis_count = 0;
+    const char* p = fusion_axes;
+    while (*p) {
+        while (*p == ' ' || *p == '+') {
+            p++;
+        }
+        if (!*p) {
+            break;
+        }
+        char token[8];
+        size_t len = 0;
+        while (*p && *p != ' ' && *p != '+') {
+            if (len < sizeof(token) - 1) {
+                token[len++] = *p;
+            }
+            p++;
+        }
+        token[len] = '\0';
+
+        const int channel = channel_from_name(token);
+        if (channel < 0 || g_axis_count >= IMU_MAX_AXES || !(g_channel_mask & (1u << channel))) {
+            Serial.print("[Replay] Recording does not provide axis: ");
+            Serial.println(token);
+            return false;
+        }
+        g_axis_map[g_axis_count++] = (uint8_t)channel;
+    }
+    if (g_axis_count == 0) {
+        return false;
+    }
+#if IMU_GRAVITY_FRAME
+    if ((g_channel_mask & 0x3F) != 0x3F) {
+        Serial.println("[Replay] Gravity frame needs all accelerometer and gyroscope axes in the recording");
+        return false;
+    }
+#endif
+
+    // 录制的采样率由时间戳实测；抽取倍数按设备上的抽取后采样率换算，
+    // 已是模型采样率的录制（例如从 Edge Impulse 导出的数据）只滤波不抽取
+    const float span_us = (float)(g_timestamps_us[g_frame_count - 1] - g_timestamps_us[0]);
+    const float sensor_hz = (g_frame_count - 1) * 1e6f / span_us;
+    const float device_decimated_hz = (float)IMU_SENSOR_ODR_HZ / IMU_DECIMATION_FACTOR;
+    long factor = lroundf(sensor_hz / device_decimated_hz);
+    factor = factor < 1 ? 1 : (factor > 255 ? 255 : factor);
+    float cutoff_hz = (float)IMU_DECIMATION_CUTOFF_HZ;
+    if (cutoff_hz > 0.4f * sensor_hz / factor) {
+        cutoff_hz = 0.4f * sensor_hz / factor;
+    }
+
+    g_decimator.design(sensor_hz, cutoff_hz, (uint8_t)factor);
+    g_resampler.set_rates(sensor_hz / factor, output_hz);
+    g_resampler.reset();
+    g_carry_count = g_carry_pos = 0;
+#if IMU_GRAVITY_FRAME
+    g_gravity.set_period(factor / sensor_hz);
+    g_gravity.reset();
+#endif
+
+    g_stats = imu_stats_t();
+    g_stats.sensor_hz = sensor_hz;
+    g_stats.output_hz = output_hz;
+
+    Serial.print("[Replay] ");
+    Serial.print((unsigned long)g_frame_count);
+    Serial.print(" frames at ");
+    Serial.print(sensor_hz, 1);
+    Serial.print(" Hz, decimation x");
+    Serial.println(factor);
+    return true;
+}
+
+size_t imu_module_axis_count() {
+    return g_axis_count;
+}
+
+float imu_module_axis_lsb(size_t axis) {
+#if INFERENCE_Q15_FEATURES
+    return axis < g_axis_count ? channel_lsb(g_axis_map[axis]) : 1.0f;
+#else
+    (void)axis;
+    return 1.0f;
+#endif
+}
+
+uint8_t imu_module_axis_channel(size_t axis) {
+    return axis < g_axis_count ? g_axis_map[axis] : 0xFF;
+}
+
+float imu_module_channel_lsb(size_t channel) {
+    return channel_lsb(channel);
+}
+
+size_t imu_module_read_frames(imu_sample_t* out_frames, size_t max_frames) {
+    const uint32_t start_us = micros();
+    if (!g_started) {
+        g_first_read_us = start_us;
+        g_started = true;
+    }
+    size_t produced = 0;
+    uint32_t wait_us = 0;
+    while (produced < max_frames) {
+        if (g_carry_pos < g_carry_count) {
+            const imu_sample_t* src = &g_carry[g_carry_pos++ * IMU_MAX_AXES];
+            memcpy(&out_frames[produced++ * g_axis_count], src, g_axis_count * sizeof(imu_sample_t));
+            continue;
+        }
+        if (g_next_frame >= g_frame_count) {
+            break;
+        }
+        // 按节奏回放：还没到时间的帧留到下一次读取，像传感器 FIFO 那样只交出已经"采到"的样本
+        const uint32_t due_us = frame_due_us(g_next_frame);
+        const uint32_t elapsed_us = micros() - g_first_read_us;
+        if (due_us > elapsed_us) {
+            wait_us = due_us - elapsed_us;
+            break;
+        }
+
+        int16_t sensor[IMU_MAX_AXES];
+        for (size_t c = 0; c < IMU_MAX_AXES; c++) {
+            sensor[c] = g_columns[c][g_next_frame * g_column_stride[c]];
+        }
+        g_next_frame++;
+        g_stats.sensor_frames++;
+        int16_t filtered[IMU_MAX_AXES];
+        if (!g_decimator.push(sensor, filtered)) {
+            continue;
+        }
+
+        imu_sample_t packed[IMU_MAX_AXES] = {0};
+#if IMU_GRAVITY_FRAME
+        // 与 imu_module.cpp 的 convert_gravity_and_pack 相同：所有通道换算为物理量，转到重力坐标系后打包
+        float board[IMU_MAX_AXES];
+        for (size_t c = 0; c < IMU_MAX_AXES; c++) {
+            board[c] = filtered[c] / channel_lsb(c);
+        }
+        g_gravity.update(&board[0], &board[3]);
+        g_gravity.rotate(&board[0], &board[0]);
+        g_gravity.rotate(&board[3], &board[3]);
+        for (size_t i = 0; i < g_axis_count; i++) {
+#if INFERENCE_Q15_FEATURES
+            packed[i] = to_lsb(board[g_axis_map[i]], g_axis_map[i]);
+#else
+            packed[i] = board[g_axis_map[i]];
+#endif
+        }
+#else
+        for (size_t i = 0; i < g_axis_count; i++) {
+#if INFERENCE_Q15_FEATURES
+            packed[i] = filtered[g_axis_map[i]];
+#else
+            packed[i] = filtered[g_axis_map[i]] / channel_lsb(g_axis_map[i]);
+#endif
+        }
+#endif
+        g_carry_count = g_resampler.push(packed, g_carry, 2);
+        g_carry_pos = 0;
+    }
+    g_stats.process_us += micros() - start_us;
+    g_stats.output_frames += produced;
+
+    if (produced == 0 && wait_us > 0) {
+        // 下一帧还没到时间：等到它（最多 1 ms，之后采集线程再来读）
+        std::this_thread::sleep_for(std::chrono::microseconds(wait_us < 1000 ? wait_us : 1000));
+    } else if (produced == 0) {
+        // 上一批已由采集线程写入队列：回放结束，之后的调用像空闲的传感器一样阻塞片刻
+        g_finished = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return produced;
+}
+
+bool imu_module_motion_active() {
+    return true;
+}
+
+void imu_module_set_raw_sink(imu_raw_sink_t) {
+}
+
+void imu_module_set_low_rate(bool) {
+}
+
+void imu_module_get_stats(imu_stats_t* out_stats) {
+    if (out_stats) {
+        *out_stats = g_stats;
+    }
+}
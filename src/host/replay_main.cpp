@@ -0,0 +1,141 @@
+// 主机离线回放入口：把一段录制喂给与板上相同的采集线程 / 推理线程，按最快速度跑完
+// stdout 每个分类窗口一行 CSV，最后一行汇总；日志（ei_printf / Serial）都在 stderr
+//
+//   result,<frame>,<label>,<confidence>,<classify_us>,<latency_us>
+//   summary,<windows>,<sensor_frames>,<output_frames>,<wall_us>,<dsp_us>
+//   features,<frame>,<hex>   （--features：运行了 CNN 的窗口的倒数第二层激活，按逻辑列顺序的 int8）
+//   labels,<name>,...        （--pooled：第一行，类别序号到名称的映射）
+//   pooled,<frame>,<hex>     （--pooled：运行了 CNN 的窗口的第一层池化输出，按逻辑列顺序的 int8，需要 MODEL_EARLY_EXIT）
+//
+// 用法：program <recording.csv | corpus.gcorpus#序号> [--features] [--pooled] [--zones]（pc_controller/replay_runner.py 并行回放整个数据集，
+// novelty_trainer.py 用 --features 收集激活训练新颖性检测，early_exit_trainer.py 用 --pooled 训练提前退出头；
+// --zones 在结束时把区段剖析导出到 stderr，需以 -DPROFILER_ZONES_ENABLE=1 构建，见 pc_controller/zone_timeline.py）
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include "alloc_module.h"
+#include "boot_module.h"
+#include "inference_module.h"
+#include "model_module.h"
+#include "profiler_module.h"
+#include "replay_source.h"
+
+static uint32_t g_windows = 0;
+static bool g_print_features = false;
+static bool g_print_pooled = false;
+
+/**
+ * @brief 打印本次窗口的激活（结果回调在推理线程中调用，列缓存在下一次推理前不变）
+ */
+static void print_activations(const char* tag, const int8_t* features, size_t first, size_t columns,
+                              size_t channels, uint32_t frame) {
+    if (features == nullptr) {
+        return;
+    }
+    printf("%s,%u,", tag, (unsigned)frame);
+    for (size_t j = 0; j < columns; j++) {
+        const int8_t* column = &features[((first + j) % columns) * channels];
+        for (size_t c = 0; c < channels; c++) {
+            printf("%02x", (unsigned)(uint8_t)column[c]);
+        }
+    }
+    printf("\n");
+}
+
+static void on_result(const inference_result_event_t* event) {
+    g_windows++;
+    printf("result,%u,%s,%.5f,%u,%u\n", (unsigned)event->frame,
+           event->index >= 0 ? inference_get_category_name(event->index) : "uncertain",
+           event->confidence, (unsigned)event->classify_us, (unsigned)event->latency_us);
+    size_t first = 0;
+    size_t columns = 0;
+    size_t channels = 0;
+    // idle 预筛跳过 CNN 时列缓存仍是上一个窗口的
+    if (g_print_features && event->classify_us > 0) {
+        const int8_t* features = model_module_stream_features(&first, &columns, &channels);
+        print_activations("features", features, first, columns, channels, event->frame);
+    }
+    if (g_print_pooled && event->classify_us > 0) {
+        const int8_t* pooled = model_module_stream_pooled(&first, &columns, &channels);
+        print_activations("pooled", pooled, first, columns, channels, event->frame);
+    }
+}
+
+/**
+ * @brief 打印当前模型的类别名称（按类别序号）
+ */
+static void print_labels() {
+    inference_model_stats_t stats;
+    if (!inference_get_model_stats(inference_active_model(), &stats)) {
+        return;
+    }
+    printf("labels");
+    for (int i = 0; i < stats.label_count; i++) {
+        printf(",%s", inference_get_category_name(i));
+    }
+    printf("\n");
+}
+
+static void print_zone_line(const char* line) {
+    fputs(line, stderr);
+}
+
+int main(int argc, char** argv) {
+    bool usage_ok = argc >= 2;
+    bool print_zones = false;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--features") == 0) {
+            g_print_features = true;
+        } else if (strcmp(argv[i], "--pooled") == 0) {
+            g_print_pooled = true;
+        } else if (strcmp(argv[i], "--zones") == 0) {
+            print_zones = true;
+        } else {
+            usage_ok = false;
+        }
+    }
+    if (!usage_ok) {
+        fprintf(stderr, "usage: %s <recording.csv | corpus#index> [--features] [--pooled] [--zones]\n", argv[0]);
+        return 2;
+    }
+    profiler_module_init();
+    if (!replay_source_open(argv[1]) || !inference_module_init()) {
+        return 1;
+    }
+    if (g_print_pooled) {
+        print_labels();
+    }
+    inference_set_result_observer(on_result);
+    // 没有 setup()：推理线程启动后直接开始填充窗口
+    boot_module_mark(BOOT_SETUP_DONE);
+
+    const uint32_t start_us = micros();
+    // 两个线程都是无限循环：回放完成后随进程退出
+    std::thread sampler(inference_sampler_task);
+    std::thread inference(inference_task);
+    sampler.detach();
+    inference.detach();
+
+    while (!(replay_source_finished() && inference_caught_up())) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    const uint32_t wall_us = micros() - start_us;
+
+    uint32_t sensor_frames = 0;
+    uint32_t output_frames = 0;
+    uint32_t dsp_us = 0;
+    replay_source_get_stats(&sensor_frames, &output_frames, &dsp_us);
+    // SDK 运行时分配（stderr），用于在录制数据上确认 ALLOC_* 池容量
+    alloc_module_report();
+    printf("summary,%u,%u,%u,%u,%u\n", (unsigned)g_windows, (unsigned)sensor_frames,
+           (unsigned)output_frames, (unsigned)wall_us, (unsigned)dsp_us);
+    if (print_zones) {
+        profiler_module_dump(print_zone_line);
+    }
+    fflush(stdout);
+    fflush(stderr);
+    // 不执行静态析构：推理线程仍可能在使用模型和队列
+    _Exit(0);
+}
@@ -0,0 +1,169 @@
+// 会话语料的只读映射（格式见 session_corpus.h）：打开时一次校验全部索引，之后取会话只是指针运算
+#include "session_corpus.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const session_corpus_header_t* header_of(const session_corpus_t* corpus) {
+    return (const session_corpus_header_t*)corpus->base;
+}
+
+static const session_corpus_session_t* session_of(const session_corpus_t* corpus, uint32_t index) {
+    const session_corpus_header_t* header = header_of(corpus);
+    return (const session_corpus_session_t*)(corpus->base + sizeof(session_corpus_header_t) +
+                                             (size_t)index * header->session_bytes);
+}
+
+static uint32_t channel_count(uint8_t mask) {
+    uint32_t count = 0;
+    for (; mask; mask &= (uint8_t)(mask - 1)) {
+        count++;
+    }
+    return count;
+}
+
+/**
+ * @brief 头部、标签表、字符串表与每个会话的数据块都落在文件之内
+ */
+static bool validate(const session_corpus_t* corpus, const char* path) {
+    const size_t bytes = corpus->bytes;
+    const session_corpus_header_t* header = header_of(corpus);
+    const char* problem = nullptr;
+    if (bytes < sizeof(session_corpus_header_t) ||
+        memcmp(header->magic, SESSION_CORPUS_MAGIC, sizeof(SESSION_CORPUS_MAGIC)) != 0) {
+        problem = "not a session corpus";
+    } else if (header->version != SESSION_CORPUS_VERSION ||
+               header->session_bytes < sizeof(session_corpus_session_t)) {
+        problem = "unsupported corpus version";
+    } else if (sizeof(session_corpus_header_t) + (uint64_t)header->session_count * header->session_bytes > bytes ||
+               (uint64_t)header->labels_offset + 4ull * header->label_count > bytes ||
+               header->labels_offset % 4 != 0 ||
+               (uint64_t)header->strings_offset + header->strings_bytes > bytes || header->strings_bytes == 0 ||
+               corpus->base[header->strings_offset + header->strings_bytes - 1] != '\0') {
+        problem = "truncated index";
+    }
+    const uint32_t* labels = (const uint32_t*)(corpus->base + header->labels_offset);
+    for (uint32_t i = 0; !problem && i < header->label_count; i++) {
+        if (labels[i] >= header->strings_bytes) {
+            problem = "bad label table";
+        }
+    }
+    for (uint32_t i = 0; !problem && i < header->session_count; i++) {
+        const session_corpus_session_t* session = session_of(corpus, i);
+        const uint64_t block = (uint64_t)session->frames * (4 + 2 * channel_count(session->channel_mask));
+        if (session->data_offset % 4 != 0 || session->data_offset + block > bytes ||
+            session->label >= header->label_count || session->name_offset >= header->strings_bytes ||
+            (session->channel_mask >> SESSION_CORPUS_CHANNELS) != 0) {
+            problem = "bad session entry";
+        }
+    }
+    if (problem) {
+        fprintf(stderr, "[Corpus] %s: %s\n", path, problem);
+        return false;
+    }
+    return true;
+}
+
+bool session_corpus_open(const char* path, session_corpus_t* out) {
+    out->base = nullptr;
+    out->bytes = 0;
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "[Corpus] Cannot open %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(session_corpus_header_t)) {
+        fprintf(stderr, "[Corpus] %s: not a session corpus\n", path);
+        close(fd);
+        return false;
+    }
+    // 映射在关闭文件后仍然有效；回放按时间顺序读列，提示内核预读
+    void* base = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        fprintf(stderr, "[Corpus] Cannot map %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    madvise(base, (size_t)st.st_size, MADV_SEQUENTIAL);
+    out->base = (const uint8_t*)base;
+    out->bytes = (size_t)st.st_size;
+    if (!validate(out, path)) {
+        session_corpus_close(out);
+        return false;
+    }
+    return true;
+}
+
+void session_corpus_close(session_corpus_t* corpus) {
+    if (corpus->base) {
+        munmap((void*)corpus->base, corpus->bytes);
+    }
+    corpus->base = nullptr;
+    corpus->bytes = 0;
+}
+
+bool session_corpus_is_corpus(const char* path) {
+    char magic[8] = {0};
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        return false;
+    }
+    const bool ok = fread(magic, 1, sizeof(magic), f) == sizeof(magic) &&
+                    memcmp(magic, SESSION_CORPUS_MAGIC, sizeof(SESSION_CORPUS_MAGIC)) == 0;
+    fclose(f);
+    return ok;
+}
+
+uint32_t session_corpus_count(const session_corpus_t* corpus) {
+    return corpus->base ? header_of(corpus)->session_count : 0;
+}
+
+bool session_corpus_session(const session_corpus_t* corpus, uint32_t index, session_corpus_view_t* out) {
+    if (index >= session_corpus_count(corpus)) {
+        return false;
+    }
+    const session_corpus_header_t* header = header_of(corpus);
+    const session_corpus_session_t* session = session_of(corpus, index);
+    const char* strings = (const char*)corpus->base + header->strings_offset;
+    const uint32_t* labels = (const uint32_t*)(corpus->base + header->labels_offset);
+    out->frames = session->frames;
+    out->channel_mask = session->channel_mask;
+    out->name = strings + session->name_offset;
+    out->label = strings + labels[session->label];
+    const uint8_t* block = corpus->base + session->data_offset;
+    out->timestamps_us = (const uint32_t*)block;
+    const int16_t* column = (const int16_t*)(block + 4ull * session->frames);
+    for (size_t c = 0; c < SESSION_CORPUS_CHANNELS; c++) {
+        if (session->channel_mask & (1u << c)) {
+            out->columns[c] = column;
+            column += session->frames;
+        } else {
+            out->columns[c] = nullptr;
+        }
+    }
+    return true;
+}
+
+bool session_corpus_parse_spec(const char* spec, char* path_out, size_t path_size, uint32_t* out_index) {
+    const char* hash = strrchr(spec, '#');
+    if (!hash || hash == spec || hash[1] == '\0') {
+        return false;
+    }
+    char* end = nullptr;
+    const unsigned long index = strtoul(hash + 1, &end, 10);
+    const size_t length = (size_t)(hash - spec);
+    if (*end != '\0' || index > UINT32_MAX || length + 1 > path_size) {
+        return false;
+    }
+    memcpy(path_out, spec, length);
+    path_out[length] = '\0';
+    *out_index = (uint32_t)index;
+    return true;
+}
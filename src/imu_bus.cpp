@@ -0,0 +1,167 @@
+// IMU 内部 I2C 总线访问实现
+#include <Arduino.h>
+#include <Wire.h>
+#include "mbed.h"
+#include "rtos.h"
+#include <chrono>
+
+#include "app_config.h"
+#include "imu_bus.h"
+
+// IMU_WIRE 在 mbed 上的接收缓冲上限；DMA 模式下单次传输由 TWIM MAXCNT 限制（远大于此）
+#define WIRE_BUFFER_BYTES      256
+// 单次寄存器写入（寄存器地址 + 数据）的最大长度
+#define BUS_MAX_WRITE_BYTES    17
+// DMA 传输完成回调的等待上限：400 kHz 下 2 KB 约 50 ms
+#define BUS_TRANSFER_TIMEOUT_MS 100
+
+#if IMU_BUS_USE_DMA && defined(DEVICE_I2C_ASYNCH)
+#define IMU_BUS_DMA 1
+#else
+#define IMU_BUS_DMA 0
+#endif
+
+// ==================== 内部状态（模块私有） ====================
+
+static uint8_t g_address = 0;
+static imu_bus_stats_t g_stats = {0, 0, 0, 0};
+
+#if IMU_BUS_DMA
+static mbed::I2C* g_i2c = nullptr;
+static rtos::EventFlags g_bus_flags;
+static const uint32_t kTransferDoneFlag = 0x1;
+static volatile int g_last_event = 0;
+#endif
+
+// ==================== 内部辅助函数 ====================
+
+static void record_transfer(bool ok, size_t bytes, uint32_t start_us) {
+    g_stats.busy_us += micros() - start_us;
+    if (ok) {
+        g_stats.transfers++;
+        g_stats.bytes += bytes;
+    } else {
+        g_stats.errors++;
+    }
+}
+
+#if IMU_BUS_DMA
+/**
+ * @brief TWIM 传输完成回调（中断上下文）
+ */
+static void on_transfer_done(int event) {
+    g_last_event = event;
+    g_bus_flags.set(kTransferDoneFlag);
+}
+
+/**
+ * @brief 发起一次 DMA 传输，并在完成回调上休眠等待
+ */
+static bool dma_transfer(uint8_t address, const uint8_t* tx, size_t tx_len, uint8_t* rx, size_t rx_len) {
+    g_bus_flags.clear(kTransferDoneFlag);
+    int rc = g_i2c->transfer(address << 1, (const char*)tx, tx_len, (char*)rx, rx_len,
+                             mbed::callback(on_transfer_done), I2C_EVENT_ALL, false);
+    if (rc != 0) {
+        return false;
+    }
+
+    uint32_t flags = g_bus_flags.wait_any_for(kTransferDoneFlag,
+                                              std::chrono::milliseconds(BUS_TRANSFER_TIMEOUT_MS));
+    if (flags & osFlagsError) {
+        g_i2c->abort_transfer();
+        return false;
+    }
+    return (g_last_event & I2C_EVENT_TRANSFER_COMPLETE) != 0;
+}
+#endif
+
+static bool bus_write(uint8_t address, uint8_t reg, const uint8_t* data, size_t len) {
+    if (len + 1 > BUS_MAX_WRITE_BYTES) {
+        return false;
+    }
+
+    const uint32_t start_us = micros();
+    bool ok;
+#if IMU_BUS_DMA
+    uint8_t tx[BUS_MAX_WRITE_BYTES];
+    tx[0] = reg;
+    memcpy(&tx[1], data, len);
+    ok = dma_transfer(address, tx, len + 1, nullptr, 0);
+#else
+    IMU_WIRE.beginTransmission(address);
+    IMU_WIRE.write(reg);
+    IMU_WIRE.write(data, len);
+    ok = IMU_WIRE.endTransmission() == 0;
+#endif
+    record_transfer(ok, 0, start_us);
+    return ok;
+}
+
+static size_t bus_read(uint8_t address, uint8_t reg, uint8_t* buffer, size_t len) {
+    const uint32_t start_us = micros();
+    size_t received = 0;
+#if IMU_BUS_DMA
+    if (dma_transfer(address, &reg, 1, buffer, len)) {
+        received = len;
+    }
+#else
+    if (len > WIRE_BUFFER_BYTES) {
+        len = WIRE_BUFFER_BYTES;
+    }
+    IMU_WIRE.beginTransmission(address);
+    IMU_WIRE.write(reg);
+    if (IMU_WIRE.endTransmission(false) == 0) {
+        received = IMU_WIRE.requestFrom(address, len);
+        for (size_t i = 0; i < received; i++) {
+            buffer[i] = IMU_WIRE.read();
+        }
+    }
+#endif
+    record_transfer(received == len, received, start_us);
+    return received;
+}
+
+// ==================== 公共接口实现 ====================
+
+bool imu_bus_init(uint8_t address) {
+    g_address = address;
+
+#if IMU_BUS_DMA
+    // IMU.begin() 之后不再通过驱动库访问传感器，释放 IMU_WIRE 并由本模块独占同一组引脚
+    IMU_WIRE.end();
+    static mbed::I2C i2c(digitalPinToPinName(IMU_WIRE_SDA_PIN), digitalPinToPinName(IMU_WIRE_SCL_PIN));
+    g_i2c = &i2c;
+    g_i2c->frequency(IMU_I2C_CLOCK_HZ);
+    Serial.println("[IMU] I2C bus: TWIM EasyDMA");
+#else
+    IMU_WIRE.setClock(IMU_I2C_CLOCK_HZ);
+    Serial.println("[IMU] I2C bus: Wire (blocking)");
+#endif
+    return true;
+}
+
+bool imu_bus_write(uint8_t reg, const uint8_t* data, size_t len) {
+    return bus_write(g_address, reg, data, len);
+}
+
+bool imu_bus_write_reg(uint8_t reg, uint8_t value) {
+    return bus_write(g_address, reg, &value, 1);
+}
+
+size_t imu_bus_read(uint8_t reg, uint8_t* buffer, size_t len) {
+    return bus_read(g_address, reg, buffer, len);
+}
+
+bool imu_bus_write_reg_at(uint8_t address, uint8_t reg, uint8_t value) {
+    return bus_write(address, reg, &value, 1);
+}
+
+size_t imu_bus_read_at(uint8_t address, uint8_t reg, uint8_t* buffer, size_t len) {
+    return bus_read(address, reg, buffer, len);
+}
+
+void imu_bus_get_stats(imu_bus_stats_t* out_stats) {
+    if (out_stats) {
+        *out_stats = g_stats;
+    }
+}
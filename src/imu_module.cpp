@@ -0,0 +1,1403 @@
+// IMU 采集模块实现
+#include <Arduino.h>
+#include <Arduino_BMI270_BMM150.h>
+#include "mbed.h"
+#include "rtos.h"
+#include <chrono>
+#include <ctype.h>
+#include <math.h>
+#include <string.h>
+
+#include "app_config.h"
+#include "calib_store.h"
+#include "energy_module.h"
+#include "imu_bus.h"
+#include "fir_decimator.h"
+#include "gravity_frame.h"
+#include "imu_module.h"
+#include "log_module.h"
+#include "mag_mux.h"
+#include "memory_module.h"
+#include "periodic_timer.h"
+#include "resampler.h"
+#include "supervisor_module.h"
+
+// ==================== BMI270 寄存器 ====================
+
+#define BMI270_I2C_ADDR        0x68
+#define BMI270_REG_DATA_8      0x0C  // ACC_X_LSB，随后依次为 ACC_Y/Z、GYR_X/Y/Z
+#define BMI270_REG_INT_STATUS_0 0x1C // 特性中断状态（读后清零）
+#define BMI270_REG_FEAT_PAGE   0x2F
+#define BMI270_REG_FEATURES    0x30  // 当前特性页的 16 字节配置窗口
+#define BMI270_REG_FIFO_LENGTH_0 0x24
+#define BMI270_REG_FIFO_DATA   0x26
+#define BMI270_REG_ACC_CONF    0x40
+#define BMI270_REG_GYR_CONF    0x42
+#define BMI270_REG_FIFO_WTM_0  0x46
+#define BMI270_REG_FIFO_WTM_1  0x47
+#define BMI270_REG_FIFO_CONFIG_0 0x48
+#define BMI270_REG_FIFO_CONFIG_1 0x49
+#define BMI270_REG_INT1_IO_CTRL 0x53
+#define BMI270_REG_INT_LATCH   0x55
+#define BMI270_REG_INT1_MAP_FEAT 0x56
+#define BMI270_REG_INT_MAP_DATA 0x58
+#define BMI270_REG_PWR_CONF    0x7C
+#define BMI270_REG_CMD         0x7E
+
+#define BMI270_ACC_CONF_PERF   0xA0  // ACC_CONF: filter_perf=1, bwp=normal(avg4)
+#define BMI270_GYR_CONF_PERF   0xA0  // GYR_CONF: filter_perf=1, bwp=normal
+#define BMI270_FIFO_ACC_EN     0x40  // FIFO_CONFIG_1: 写入加速度（无帧头）
+#define BMI270_FIFO_GYR_EN     0x80  // FIFO_CONFIG_1: 写入陀螺仪（无帧头）
+#define BMI270_INT1_OUTPUT_EN  0x0A  // INT1_IO_CTRL: 推挽输出、高电平有效
+#define BMI270_INT_MAP_FWM_INT1 0x02 // INT_MAP_DATA: FIFO 水位中断映射到 INT1
+#define BMI270_CMD_FIFO_FLUSH  0xB0
+#define BMI270_PWR_CONF_NO_APS 0x02  // PWR_CONF: 关闭高级省电（写特性配置的前提），保留 FIFO 自唤醒
+
+// ==================== BMM150 寄存器 ====================
+
+#define BMM150_I2C_ADDR        0x10
+#define BMM150_REG_CHIP_ID     0x40
+#define BMM150_REG_DATA_X_LSB  0x42  // 随后依次为 X_MSB、Y、Z、RHALL（各 16 位，小端）
+#define BMM150_REG_POWER       0x4B
+#define BMM150_REG_OP_MODE     0x4C
+#define BMM150_REG_REP_XY      0x51
+#define BMM150_REG_REP_Z       0x52
+#define BMM150_REG_DIG_X1      0x5D  // 出厂补偿参数起始地址（0x5D..0x71）
+
+#define BMM150_CHIP_ID         0x32
+#define BMM150_POWER_ON        0x01  // POWER: 退出挂起模式（0x00 = 挂起，只有本寄存器可访问）
+#define BMM150_DATA_READY      0x01  // RHALL_LSB bit0: 数据寄存器中有新样本
+#define BMM150_REP_XY_REGULAR  0x04  // 常规预设：XY 9 次、Z 15 次重复测量
+#define BMM150_REP_Z_REGULAR   0x0E
+#define BMM150_STARTUP_MS      3     // 退出挂起后到寄存器可访问的时间
+#define BMM150_DATA_BYTES      8
+#define BMM150_TRIM_BYTES      21
+#define BMM150_XY_OVERFLOW     (-4096)
+#define BMM150_Z_OVERFLOW      (-16384)
+
+// any-motion / no-motion 特性（特性页 1 内的偏移；中断位同时用于 INT1_MAP_FEAT 与 INT_STATUS_0）
+#define BMI270_FEAT_PAGE_MOTION 1
+#define BMI270_FEAT_NO_MOT_OFFSET  0x00
+#define BMI270_FEAT_ANY_MOT_OFFSET 0x0C
+#define BMI270_FEAT_MOT_SELECT_XYZ 0xE000  // 第 0 字：bit13-15 选择 X/Y/Z 轴
+#define BMI270_FEAT_MOT_ENABLE     0x8000  // 第 1 字：bit15 使能
+#define BMI270_INT_NO_MOTION   0x20
+#define BMI270_INT_ANY_MOTION  0x40
+// 阈值 1 LSB = 0.488 mg（11 位覆盖 1 g），持续时间 1 LSB = 20 ms
+#define MOTION_THRESHOLD_LSB_PER_MG (2048.0f / 1000.0f)
+#define MOTION_DURATION_MS_PER_LSB  20
+
+// 每个传感器一组 X/Y/Z（各 int16，小端）= 6 字节；
+// 无帧头 FIFO 同时开启陀螺仪时帧内顺序为 GYR 在前、ACC 在后
+#define SENSOR_XYZ_BYTES       6
+// Arduino_BMI270_BMM150 默认量程 ±4g / ±2000dps
+#define ACC_LSB_PER_G          8192.0f
+#define GYR_LSB_PER_DPS        16.384f
+// 磁力计补偿后为 µT；int16 样本按 8 LSB/µT 表示（覆盖 BMM150 Z 轴 ±2500 µT 量程）
+#define MAG_LSB_PER_UT         8.0f
+// 单次突发读取上限：不超过 Wire1 的 256 字节缓冲，取 12 的整数倍（6 字节帧同样整除）
+#define FIFO_BURST_BYTES       240
+#define FIFO_BURST_FRAMES      (FIFO_BURST_BYTES / SENSOR_XYZ_BYTES)
+// 中断丢失时的兜底超时（远大于一个水位周期）
+#define FIFO_WAIT_TIMEOUT_MS   100
+// 启动校准时两次读取数据寄存器的间隔（与 ODR 无关，只要求样本近似独立）
+#define CALIB_SAMPLE_INTERVAL_MS 5
+
+// ==================== 内部状态（模块私有） ====================
+
+static rtos::EventFlags g_imu_flags;
+static const uint32_t kSampleReadyFlag = 0x1;
+
+// 融合轴名称 -> 传感器通道（0..2 = 加速度 X/Y/Z，3..5 = 陀螺仪 X/Y/Z，6..8 = 磁力计 X/Y/Z）
+struct axis_name_t {
+    const char* name;
+    uint8_t channel;
+};
+
+static const axis_name_t kAxisNames[] = {
+    {"accx", 0}, {"accy", 1}, {"accz", 2},
+    {"gyrx", 3}, {"gyry", 4}, {"gyrz", 5},
+    {"gyrox", 3}, {"gyroy", 4}, {"gyroz", 5},
+    {"magx", 6}, {"magy", 7}, {"magz", 8},
+};
+
+// 输出帧第 i 个值取自 g_axis_map[i] 通道
+static uint8_t g_axis_map[IMU_MAX_FUSION_AXES];
+static size_t g_axis_count = 0;
+// 其中取自 BMI270 的轴（按融合轴顺序）：抽取、转换与重采样只处理这些轴，第 i 个落在输出帧的 g_sensor_slot[i]
+static uint8_t g_sensor_map[IMU_MAX_AXES];
+static uint8_t g_sensor_slot[IMU_MAX_AXES];
+static size_t g_sensor_count = 0;
+// 取自 BMM150 的轴：第 m 个是磁力计的 g_mag_channel[m] 轴，落在输出帧的 g_mag_slot[m]；为 0 时不访问 BMM150
+static uint8_t g_mag_channel[IMU_MAG_AXES];
+static uint8_t g_mag_slot[IMU_MAG_AXES];
+static size_t g_mag_count = 0;
+static bool g_gyro_enabled = false;
+// 传感器帧中是否包含陀螺仪（融合轴需要，或正在录制原始 6 轴数据）
+static bool g_sensor_gyro = false;
+
+// 原始帧回调：其他线程只写 g_raw_sink_request，由采集线程在唤醒时切换
+static imu_raw_sink_t g_raw_sink = nullptr;
+static volatile imu_raw_sink_t g_raw_sink_request = nullptr;
+static volatile bool g_raw_sink_changed = false;
+
+// 运动状态：any-motion 置位、no-motion 清零；未启用运动检测时始终为 true
+static volatile bool g_motion_active = true;
+
+// 空闲低速采集（IMU_IDLE_ODR_HZ）：推理线程只写请求，采集线程在读空 FIFO 后切换 ODR 与水位
+static volatile bool g_low_rate_request = false;
+static bool g_low_rate = false;
+
+// 传感器当前的 ODR
+static inline int sensor_odr_hz() {
+    return g_low_rate ? IMU_IDLE_ODR_HZ : IMU_SENSOR_ODR_HZ;
+}
+
+// 回放数据源：与原始帧回调相同，其他线程只写请求，由采集线程在唤醒时切换
+static volatile imu_replay_source_t g_replay_source = nullptr;
+#if IMU_USE_FIFO
+static volatile imu_replay_source_t g_replay_source_request = nullptr;
+static volatile bool g_replay_source_changed = false;
+#endif
+
+#if IMU_USE_FIFO
+static mbed::InterruptIn g_imu_int1(IMU_INT1_PIN);
+// 原始 int16 帧先经过抗混叠抽取（IMU_SENSOR_ODR_HZ -> ODR / IMU_DECIMATION_FACTOR），
+// 再由线性重采样对齐到模型采样率
+static FirDecimator<IMU_MAX_AXES, IMU_DECIMATION_TAPS> g_decimator;
+#if INFERENCE_Q15_FEATURES
+static LinearResamplerQ15<IMU_MAX_AXES> g_resampler;
+#else
+static LinearResampler<IMU_MAX_AXES> g_resampler;
+#endif
+// 恢复采集后第一批读出的是静止期间积压在 FIFO 中的历史帧，不能用于校正 ODR
+static bool g_skip_rate_correction = false;
+// 上一个传感器帧（原始寄存器顺序）：低速采集时与当前帧之间线性插值，补齐抽取器需要的 IMU_SENSOR_ODR_HZ 样本
+static int16_t g_last_sensor[IMU_MAX_AXES] = {0};
+
+// 已重采样、尚未交给调用者的帧（ODR >= 输出采样率，所以不会多于原始帧数），
+// 每帧 g_axis_count 个值，已按融合轴顺序排列
+static imu_sample_t g_pending[FIFO_BURST_FRAMES * IMU_MAX_FUSION_AXES];
+static size_t g_pending_frames = 0;
+static size_t g_pending_pos = 0;
+// 上一次突发读取后 FIFO 中仍有剩余（超过单次读取上限），下一次不等待中断直接继续读
+static bool g_fifo_backlog = false;
+// 一次突发读取的 FIFO 原始字节（只由采集线程访问）：外设可直接写入的暂存区，不放在线程栈上
+MEMORY_DMA_BUFFER static uint8_t g_fifo_raw[FIFO_BURST_BYTES];
+static const MemoryPlacement g_fifo_raw_placement("imu fifo burst", g_fifo_raw, sizeof(g_fifo_raw), MEMORY_PLACE_DMA);
+// 一个 FIFO 水位周期
+static const uint32_t kWatermarkPeriodMs =
+    IMU_FIFO_WATERMARK_FRAMES * 1000UL / IMU_SENSOR_ODR_HZ > 0 ? IMU_FIFO_WATERMARK_FRAMES * 1000UL / IMU_SENSOR_ODR_HZ : 1;
+// 回放时取帧的节拍：一个水位周期（绝对截止时间，处理耗时不会拉长周期；开始回放时重新计时）
+static PeriodicTimer g_replay_timer{std::chrono::milliseconds(kWatermarkPeriodMs)};
+#else
+static mbed::Ticker g_sample_ticker;
+#endif
+
+static float g_output_hz = IMU_SENSOR_ODR_HZ;
+
+// BMM150 出厂补偿参数
+struct mag_trim_t {
+    int8_t x1, y1, x2, y2, xy2;
+    uint8_t xy1;
+    int16_t z2, z3, z4;
+    uint16_t z1, xyz1;
+};
+static mag_trim_t g_mag_trim;
+// 磁力计样本（µT，带读出时刻），按输出帧的采样时刻插值；深度覆盖一次突发读取加上抽取群延迟（约 120 ms）
+static TimestampMux<IMU_MAG_AXES, 8> g_mag_mux;
+static uint32_t g_mag_last_poll_us = 0;
+// 两次读取磁力计的最小间隔：留出采集唤醒抖动的余量，重复读到的旧样本由数据就绪位过滤
+static const uint32_t kMagPollIntervalUs = 1000000UL / IMU_MAG_ODR_HZ * 3 / 4;
+
+// 输出帧第 i 个值 = raw[g_raw_index[i]] * g_gain[i] + g_offset[i]
+// 坐标映射符号、LSB 换算与校准参数全部折叠进这两张表，转换时每个值只需一次乘加
+static uint8_t g_raw_index[IMU_MAX_AXES];
+#if INFERENCE_Q15_FEATURES
+// 定点版本：结果仍是传感器 LSB，系数为 Q14（比例系数最大约 ±2），零偏已换算为 LSB
+#define IMU_GAIN_FRAC_BITS 14
+static int32_t g_gain[IMU_MAX_AXES];
+static int32_t g_offset[IMU_MAX_AXES];
+#else
+static float g_gain[IMU_MAX_AXES];
+static float g_offset[IMU_MAX_AXES];
+#endif
+
+#if IMU_GRAVITY_FRAME
+// 重力坐标系级：抽取后的每帧先换算为板坐标系物理量（g / dps，所有通道，按板坐标系通道索引），
+// 更新重力方向后把加速度与陀螺仪两组向量转到重力坐标系，再按通道映射打包
+static GravityFrame g_gravity(IMU_GRAVITY_GYRO_NOISE, IMU_GRAVITY_ACC_NOISE, IMU_GRAVITY_DYNAMIC_GAIN);
+static float g_frame_gain[IMU_MAX_AXES];
+static float g_frame_offset[IMU_MAX_AXES];
+#endif
+
+// 统计（只由采集线程写入）
+static imu_stats_t g_stats = {0, 0, 0, 0.0f, 0.0f, 0.0f, 0, 0, 0, 0, 0, 0};
+static uint32_t g_window_start_us = 0;
+
+// 传感器健康（只由采集线程访问，采集线程终止后由监督者访问）：连续读不到数据的唤醒次数、
+// 下一次重新配置前允许的失败唤醒次数（每次仍失败时翻倍），以及这次中断开始的时刻
+static uint32_t g_failed_wakeups = 0;
+static uint32_t g_recovery_wakeups = IMU_RECOVERY_WAKEUPS;
+static uint32_t g_outage_start_ms = 0;
+static uint32_t g_window_sensor_frames = 0;
+static uint32_t g_window_output_frames = 0;
+
+// ==================== 内部辅助函数 ====================
+
+static void on_sample_ready() {
+    g_imu_flags.set(kSampleReadyFlag);
+}
+
+/**
+ * @brief 统计窗口结束时计算实测 ODR / 输出采样率，并用实测 ODR 校正重采样比
+ */
+static void update_rate_window(size_t sensor_frames, size_t output_frames) {
+    g_stats.sensor_frames += sensor_frames;
+    g_stats.output_frames += output_frames;
+    g_window_sensor_frames += sensor_frames;
+    g_window_output_frames += output_frames;
+
+    const uint32_t now_us = micros();
+    const uint32_t elapsed_us = now_us - g_window_start_us;
+    if (elapsed_us < IMU_RATE_WINDOW_MS * 1000UL) {
+        return;
+    }
+
+    const float elapsed_s = elapsed_us / 1000000.0f;
+    g_stats.sensor_hz = g_window_sensor_frames / elapsed_s;
+    g_stats.output_hz = g_window_output_frames / elapsed_s;
+    g_stats.drift_ppm = (g_stats.output_hz - g_output_hz) / g_output_hz * 1e6f;
+
+#if IMU_USE_FIFO
+    // BMI270 内部振荡器有 ±1% 左右的偏差，以实测 ODR 为准保证输出锁定在目标采样率；
+    // 回放时按标称 ODR 重采样，与录制时的振荡器无关
+    if (g_stats.sensor_hz > 0.0f && !g_skip_rate_correction && !g_replay_source) {
+        const float upsample = (float)IMU_SENSOR_ODR_HZ / sensor_odr_hz();
+        g_resampler.set_rates(g_stats.sensor_hz * upsample / g_decimator.factor(), g_output_hz);
+    }
+    g_skip_rate_correction = false;
+#endif
+
+    g_window_start_us = now_us;
+    g_window_sensor_frames = 0;
+    g_window_output_frames = 0;
+}
+
+/**
+ * @brief 解析融合轴字符串（例如 "accx + accy + accz"），生成输出通道映射
+ * @return true 所有轴都能由 BMI270 / BMM150 提供
+ */
+static bool parse_axes(const char* fusion_axes) {
+    g_axis_count = 0;
+    g_sensor_count = 0;
+    g_mag_count = 0;
+    g_gyro_enabled = false;
+
+    const char* p = fusion_axes;
+    while (*p) {
+        while (*p == ' ' || *p == '+') {
+            p++;
+        }
+        if (!*p) {
+            break;
+        }
+
+        char token[8];
+        size_t len = 0;
+        while (*p && *p != ' ' && *p != '+') {
+            if (len < sizeof(token) - 1) {
+                token[len++] = (char)tolower((unsigned char)*p);
+            }
+            p++;
+        }
+        token[len] = '\0';
+
+        bool found = false;
+        for (size_t i = 0; i < sizeof(kAxisNames) / sizeof(kAxisNames[0]); i++) {
+            if (strcmp(token, kAxisNames[i].name) == 0) {
+                const uint8_t channel = kAxisNames[i].channel;
+                if (g_axis_count >= IMU_MAX_FUSION_AXES) {
+                    return false;
+                }
+                if (channel >= IMU_MAX_AXES) {
+                    if (g_mag_count >= IMU_MAG_AXES) {
+                        return false;
+                    }
+                    g_mag_slot[g_mag_count] = (uint8_t)g_axis_count;
+                    g_mag_channel[g_mag_count++] = channel - IMU_MAX_AXES;
+                } else {
+                    if (g_sensor_count >= IMU_MAX_AXES) {
+                        return false;
+                    }
+                    g_sensor_slot[g_sensor_count] = (uint8_t)g_axis_count;
+                    g_sensor_map[g_sensor_count++] = channel;
+                    g_gyro_enabled |= channel >= 3;
+                }
+                g_axis_map[g_axis_count++] = channel;
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            Serial.print("[IMU] Unsupported axis: ");
+            Serial.println(token);
+            return false;
+        }
+    }
+    return g_axis_count > 0;
+}
+
+static inline int16_t read_le16(const uint8_t* p) {
+    return (int16_t)(p[0] | (p[1] << 8));
+}
+
+/**
+ * @brief 解析一组 X/Y/Z 原始数据（寄存器顺序，小端）
+ */
+static inline void read_xyz(const uint8_t* bytes, int16_t* out) {
+    out[0] = read_le16(bytes + 0);
+    out[1] = read_le16(bytes + 2);
+    out[2] = read_le16(bytes + 4);
+}
+
+/**
+ * @brief 板坐标系通道 -> 原始寄存器通道及符号
+ * 与 Arduino_BMI270_BMM150 保持一致：x = -y, y = -x, z = z
+ */
+static const uint8_t kBoardToRaw[IMU_MAX_AXES] = {1, 0, 2, 4, 3, 5};
+static const float kBoardSign[IMU_MAX_AXES] = {-1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f};
+
+static inline int16_t negate_saturate(int16_t v) {
+    return v == INT16_MIN ? INT16_MAX : (int16_t)-v;
+}
+
+/**
+ * @brief 原始寄存器顺序的帧 -> 板坐标系 int16 帧（只做坐标映射，不换算单位）
+ */
+static inline void raw_to_board(const int16_t* raw, int16_t* out, size_t channels) {
+    for (size_t c = 0; c < channels; c++) {
+        const int16_t v = raw[kBoardToRaw[c]];
+        out[c] = kBoardSign[c] < 0.0f ? negate_saturate(v) : v;
+    }
+}
+
+static inline void emit_raw_frame(const int16_t* raw, uint32_t timestamp_us) {
+    int16_t board[IMU_MAX_AXES];
+    const size_t channels = g_sensor_gyro ? IMU_MAX_AXES : 3;
+    raw_to_board(raw, board, channels);
+    g_raw_sink(board, g_sensor_gyro ? 0x3F : 0x07, timestamp_us);
+}
+
+static inline float channel_lsb(size_t channel) {
+    return channel < 3 ? ACC_LSB_PER_G : (channel < IMU_MAX_AXES ? GYR_LSB_PER_DPS : MAG_LSB_PER_UT);
+}
+
+/**
+ * @brief 由通道映射和校准参数生成每个输出值的乘加系数
+ */
+static void build_conversion(const imu_calibration_t* calibration) {
+    for (size_t i = 0; i < g_sensor_count; i++) {
+        const uint8_t channel = g_sensor_map[i];
+        const float scale = calibration->scale[channel];
+        g_raw_index[i] = kBoardToRaw[channel];
+#if INFERENCE_Q15_FEATURES
+        g_gain[i] = lroundf(kBoardSign[channel] * scale * (1 << IMU_GAIN_FRAC_BITS));
+        g_offset[i] = lroundf(-calibration->bias[channel] * scale * channel_lsb(channel) * (1 << IMU_GAIN_FRAC_BITS));
+#else
+        g_gain[i] = kBoardSign[channel] * scale / channel_lsb(channel);
+        g_offset[i] = -calibration->bias[channel] * scale;
+#endif
+    }
+#if IMU_GRAVITY_FRAME
+    for (size_t channel = 0; channel < IMU_MAX_AXES; channel++) {
+        const float scale = calibration->scale[channel];
+        g_frame_gain[channel] = kBoardSign[channel] * scale / channel_lsb(channel);
+        g_frame_offset[channel] = -calibration->bias[channel] * scale;
+    }
+#endif
+}
+
+/**
+ * @brief 原始帧（加速度 XYZ + 陀螺仪 XYZ）转换为校准后的物理量，并按 BMI270 各轴的顺序打包（无逐轴分支）
+ */
+static inline void convert_and_pack(const int16_t* raw, imu_sample_t* out) {
+    for (size_t i = 0; i < g_sensor_count; i++) {
+#if INFERENCE_Q15_FEATURES
+        int32_t v = (raw[g_raw_index[i]] * g_gain[i] + g_offset[i] + (1 << (IMU_GAIN_FRAC_BITS - 1))) >>
+                    IMU_GAIN_FRAC_BITS;
+        out[i] = (int16_t)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+#else
+        out[i] = raw[g_raw_index[i]] * g_gain[i] + g_offset[i];
+#endif
+    }
+}
+
+#if IMU_GRAVITY_FRAME
+/**
+ * @brief 原始帧换算为板坐标系物理量，更新重力方向，转到重力坐标系后按通道映射打包
+ */
+static inline void convert_gravity_and_pack(const int16_t* raw, imu_sample_t* out) {
+    float board[IMU_MAX_AXES];
+    for (size_t c = 0; c < IMU_MAX_AXES; c++) {
+        board[c] = raw[kBoardToRaw[c]] * g_frame_gain[c] + g_frame_offset[c];
+    }
+    g_gravity.update(&board[0], &board[3]);
+    g_gravity.rotate(&board[0], &board[0]);
+    g_gravity.rotate(&board[3], &board[3]);
+    for (size_t i = 0; i < g_sensor_count; i++) {
+        const uint8_t channel = g_sensor_map[i];
+#if INFERENCE_Q15_FEATURES
+        const long v = lroundf(board[channel] * channel_lsb(channel));
+        out[i] = (int16_t)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+#else
+        out[i] = board[channel];
+#endif
+    }
+}
+#endif
+
+/**
+ * @brief 抽取后的一帧转换为输出帧（打开重力坐标系时先经过重力坐标系级）
+ */
+static inline void convert_frame(const int16_t* raw, imu_sample_t* out) {
+#if IMU_GRAVITY_FRAME
+    convert_gravity_and_pack(raw, out);
+#else
+    convert_and_pack(raw, out);
+#endif
+}
+
+/**
+ * @brief 按融合轴顺序组装输出帧：BMI270 各轴取自 packed，磁力计各轴取自时刻 timestamp_us 的插值
+ * 未启用磁力计时两者顺序相同，直接拷贝
+ */
+static inline void merge_frame(const imu_sample_t* packed, uint32_t timestamp_us, imu_sample_t* out) {
+    if (g_mag_count == 0) {
+        memcpy(out, packed, g_axis_count * sizeof(imu_sample_t));
+        return;
+    }
+    for (size_t i = 0; i < g_sensor_count; i++) {
+        out[g_sensor_slot[i]] = packed[i];
+    }
+    float field[IMU_MAG_AXES];
+    g_mag_mux.sample(timestamp_us, field);
+    for (size_t m = 0; m < g_mag_count; m++) {
+        const float v = field[g_mag_channel[m]];
+#if INFERENCE_Q15_FEATURES
+        const long q = lroundf(v * MAG_LSB_PER_UT);
+        out[g_mag_slot[m]] = (int16_t)(q > 32767 ? 32767 : (q < -32768 ? -32768 : q));
+#else
+        out[g_mag_slot[m]] = v;
+#endif
+    }
+}
+
+/**
+ * @brief 传感器帧中是否需要陀螺仪（融合轴包含陀螺仪，或重力坐标系级需要它）
+ */
+static inline bool gyro_required() {
+    return g_gyro_enabled || IMU_GRAVITY_FRAME;
+}
+
+static uint8_t odr_to_conf(int odr_hz) {
+    switch (odr_hz) {
+        case 25:   return 0x06;
+        case 50:   return 0x07;
+        case 100:  return 0x08;
+        case 200:  return 0x09;
+        case 400:  return 0x0A;
+        case 800:  return 0x0B;
+        case 1600: return 0x0C;
+        default:   return 0x08;
+    }
+}
+
+static inline bool bmi270_write_reg(uint8_t reg, uint8_t value) {
+    return imu_bus_write_reg(reg, value);
+}
+
+static inline size_t bmi270_read_regs(uint8_t reg, uint8_t* buffer, size_t len) {
+    return imu_bus_read(reg, buffer, len);
+}
+
+static uint8_t mag_odr_to_conf(int odr_hz) {
+    switch (odr_hz) {
+        case 2:  return 0x01;
+        case 6:  return 0x02;
+        case 8:  return 0x03;
+        case 15: return 0x04;
+        case 20: return 0x05;
+        case 25: return 0x06;
+        case 30: return 0x07;
+        default: return 0x00;  // 10 Hz
+    }
+}
+
+static bool bmm150_read_trim() {
+    uint8_t t[BMM150_TRIM_BYTES];
+    if (imu_bus_read_at(BMM150_I2C_ADDR, BMM150_REG_DIG_X1, t, sizeof(t)) != sizeof(t)) {
+        return false;
+    }
+    g_mag_trim.x1 = (int8_t)t[0];
+    g_mag_trim.y1 = (int8_t)t[1];
+    g_mag_trim.z4 = read_le16(t + 5);
+    g_mag_trim.x2 = (int8_t)t[7];
+    g_mag_trim.y2 = (int8_t)t[8];
+    g_mag_trim.z2 = read_le16(t + 11);
+    g_mag_trim.z1 = (uint16_t)(t[13] | (t[14] << 8));
+    g_mag_trim.xyz1 = (uint16_t)(t[15] | ((t[16] & 0x7F) << 8));
+    g_mag_trim.z3 = read_le16(t + 17);
+    g_mag_trim.xy2 = (int8_t)t[19];
+    g_mag_trim.xy1 = t[20];
+    return true;
+}
+
+/**
+ * @brief X / Y 轴温漂与灵敏度补偿（Bosch BMM150 参考驱动的浮点公式），结果为 µT
+ * @return false 溢出或补偿参数无效
+ */
+static bool bmm150_compensate_xy(int16_t raw, uint16_t rhall, int8_t dig1, int8_t dig2, float* out) {
+    if (raw == BMM150_XY_OVERFLOW || rhall == 0 || g_mag_trim.xyz1 == 0) {
+        return false;
+    }
+    const float r = (float)g_mag_trim.xyz1 * 16384.0f / rhall - 16384.0f;
+    const float c = g_mag_trim.xy2 * (r * r / 268435456.0f) + r * g_mag_trim.xy1 / 16384.0f;
+    *out = (raw * ((c + 256.0f) * (dig2 + 160.0f)) / 8192.0f + dig1 * 8.0f) / 16.0f;
+    return true;
+}
+
+static bool bmm150_compensate_z(int16_t raw, uint16_t rhall, float* out) {
+    const mag_trim_t& t = g_mag_trim;
+    if (raw == BMM150_Z_OVERFLOW || rhall == 0 || t.z1 == 0 || t.z2 == 0 || t.xyz1 == 0) {
+        return false;
+    }
+    const float num = (raw - (float)t.z4) * 131072.0f - t.z3 * ((float)rhall - t.xyz1);
+    const float den = (t.z2 + t.z1 * (float)rhall / 32768.0f) * 4.0f;
+    *out = num / den / 16.0f;
+    return true;
+}
+
+/**
+ * @brief 融合轴需要磁力计时唤醒 BMM150、读出补偿参数并以 IMU_MAG_ODR_HZ 连续测量；
+ * 否则挂起（驱动库在 IMU.begin() 中让它进入正常模式持续测量）
+ */
+static bool configure_magnetometer() {
+    g_mag_mux.reset();
+    if (g_mag_count == 0) {
+        imu_bus_write_reg_at(BMM150_I2C_ADDR, BMM150_REG_POWER, 0x00);
+        return true;
+    }
+
+    bool ok = imu_bus_write_reg_at(BMM150_I2C_ADDR, BMM150_REG_POWER, BMM150_POWER_ON);
+    delay(BMM150_STARTUP_MS);
+    uint8_t chip_id = 0;
+    ok = ok && imu_bus_read_at(BMM150_I2C_ADDR, BMM150_REG_CHIP_ID, &chip_id, 1) == 1 && chip_id == BMM150_CHIP_ID;
+    ok = ok && bmm150_read_trim();
+    ok = ok && imu_bus_write_reg_at(BMM150_I2C_ADDR, BMM150_REG_REP_XY, BMM150_REP_XY_REGULAR);
+    ok = ok && imu_bus_write_reg_at(BMM150_I2C_ADDR, BMM150_REG_REP_Z, BMM150_REP_Z_REGULAR);
+    ok = ok && imu_bus_write_reg_at(BMM150_I2C_ADDR, BMM150_REG_OP_MODE, mag_odr_to_conf(IMU_MAG_ODR_HZ) << 3);
+    return ok;
+}
+
+/**
+ * @brief 距上一次读取超过磁力计周期时读一次 BMM150，有新样本则补偿后按读出时刻加入插值器
+ * 未启用磁力计时直接返回，不产生总线传输
+ */
+static void poll_magnetometer() {
+    if (g_mag_count == 0) {
+        return;
+    }
+    const uint32_t now_us = micros();
+    if (now_us - g_mag_last_poll_us < kMagPollIntervalUs) {
+        return;
+    }
+    g_mag_last_poll_us = now_us;
+
+    uint8_t d[BMM150_DATA_BYTES];
+    if (imu_bus_read_at(BMM150_I2C_ADDR, BMM150_REG_DATA_X_LSB, d, sizeof(d)) != sizeof(d) ||
+        !(d[6] & BMM150_DATA_READY)) {
+        return;
+    }
+    // X / Y 为 13 位、Z 为 15 位有符号数，RHALL 为 14 位无符号数，都在 16 位字的高位
+    const int16_t x = (int16_t)(read_le16(d + 0) >> 3);
+    const int16_t y = (int16_t)(read_le16(d + 2) >> 3);
+    const int16_t z = (int16_t)(read_le16(d + 4) >> 1);
+    const uint16_t rhall = (uint16_t)(d[6] | (d[7] << 8)) >> 2;
+
+    float field[IMU_MAG_AXES];
+    if (!bmm150_compensate_xy(x, rhall, g_mag_trim.x1, g_mag_trim.x2, &field[0]) ||
+        !bmm150_compensate_xy(y, rhall, g_mag_trim.y1, g_mag_trim.y2, &field[1]) ||
+        !bmm150_compensate_z(z, rhall, &field[2])) {
+        return;
+    }
+    g_mag_mux.push(field, now_us);
+    g_stats.mag_samples++;
+}
+
+/**
+ * @brief 静止状态下估计各通道的零偏与重力轴的比例系数
+ * 要求板子静置且大致水平：重力落在某一个加速度轴上，其余两轴的均值即为零偏，
+ * 重力轴由 1 g 反推比例系数（单一姿态无法同时分离该轴的零偏，保持为 0）；陀螺仪均值即为零偏。
+ * @return true 样本足够平稳且姿态满足要求
+ */
+static bool estimate_calibration(imu_calibration_t* out_calibration) {
+    double sum[IMU_MAX_AXES] = {0};
+    double sum_sq[IMU_MAX_AXES] = {0};
+    size_t count = 0;
+
+    uint8_t raw[2 * SENSOR_XYZ_BYTES];
+    for (size_t n = 0; n < IMU_CALIB_SAMPLES; n++) {
+        delay(CALIB_SAMPLE_INTERVAL_MS);
+        if (bmi270_read_regs(BMI270_REG_DATA_8, raw, sizeof(raw)) != sizeof(raw)) {
+            continue;
+        }
+        int16_t sensor[IMU_MAX_AXES];
+        read_xyz(raw, &sensor[0]);
+        read_xyz(raw + SENSOR_XYZ_BYTES, &sensor[3]);
+        for (size_t c = 0; c < IMU_MAX_AXES; c++) {
+            const double v = kBoardSign[c] * sensor[kBoardToRaw[c]] / channel_lsb(c);
+            sum[c] += v;
+            sum_sq[c] += v * v;
+        }
+        count++;
+    }
+    if (count < IMU_CALIB_SAMPLES / 2) {
+        return false;
+    }
+
+    float mean[IMU_MAX_AXES];
+    for (size_t c = 0; c < IMU_MAX_AXES; c++) {
+        mean[c] = (float)(sum[c] / count);
+        const float variance = (float)(sum_sq[c] / count) - mean[c] * mean[c];
+        const float max_std = c < 3 ? IMU_CALIB_MAX_ACC_STD_G : IMU_CALIB_MAX_GYR_STD_DPS;
+        if (variance > max_std * max_std) {
+            return false;  // 校准期间有晃动
+        }
+    }
+
+    size_t gravity_axis = 0;
+    for (size_t c = 1; c < 3; c++) {
+        if (fabsf(mean[c]) > fabsf(mean[gravity_axis])) {
+            gravity_axis = c;
+        }
+    }
+    const float gravity = fabsf(mean[gravity_axis]);
+    if (gravity < 0.8f || gravity > 1.2f) {
+        return false;
+    }
+
+    for (size_t c = 0; c < IMU_MAX_AXES; c++) {
+        out_calibration->bias[c] = 0.0f;
+        out_calibration->scale[c] = 1.0f;
+    }
+    for (size_t c = 0; c < 3; c++) {
+        if (c == gravity_axis) {
+            out_calibration->scale[c] = 1.0f / gravity;
+        } else if (fabsf(mean[c]) > IMU_CALIB_LEVEL_TOLERANCE_G) {
+            return false;  // 倾斜过大，重力分量会被误当作零偏
+        } else {
+            out_calibration->bias[c] = mean[c];
+        }
+    }
+    for (size_t c = 3; c < IMU_MAX_AXES; c++) {
+        out_calibration->bias[c] = mean[c];
+    }
+    return true;
+}
+
+/**
+ * @brief 载入 Flash 中的校准参数；没有有效记录时现场校准并写入 Flash
+ * 校准失败（例如开机时板子在晃动）时本次使用单位校准，下次启动再尝试。
+ */
+static void load_calibration(imu_calibration_t* out_calibration) {
+    for (size_t c = 0; c < IMU_MAX_AXES; c++) {
+        out_calibration->bias[c] = 0.0f;
+        out_calibration->scale[c] = 1.0f;
+    }
+
+#if IMU_CALIB_ENABLE
+    if (calib_store_load(out_calibration)) {
+        Serial.println("[IMU] Calibration loaded from flash");
+        return;
+    }
+
+    Serial.println("[IMU] Calibrating, keep the board still and level...");
+    delay(IMU_CALIB_SETTLE_MS);
+
+    imu_calibration_t estimated;
+    if (!estimate_calibration(&estimated)) {
+        Serial.println("[IMU] Calibration rejected (board moving or tilted), using defaults");
+        return;
+    }
+    *out_calibration = estimated;
+    if (!calib_store_save(out_calibration)) {
+        Serial.println("[IMU] Failed to save calibration");
+        return;
+    }
+    Serial.println("[IMU] Calibration saved to flash");
+#endif
+}
+
+#if IMU_USE_FIFO
+static size_t fifo_frame_bytes() {
+    return g_sensor_gyro ? 2 * SENSOR_XYZ_BYTES : SENSOR_XYZ_BYTES;
+}
+
+/**
+ * @brief 写入当前 ODR 对应的 FIFO 水位（低速采集时按比例缩小，唤醒周期不变）
+ */
+static bool write_fifo_watermark() {
+    const uint16_t watermark_frames = g_low_rate ? IMU_IDLE_FIFO_WATERMARK_FRAMES : IMU_FIFO_WATERMARK_FRAMES;
+    const uint16_t watermark_bytes = watermark_frames * fifo_frame_bytes();
+    bool ok = bmi270_write_reg(BMI270_REG_FIFO_WTM_0, watermark_bytes & 0xFF);
+    ok &= bmi270_write_reg(BMI270_REG_FIFO_WTM_1, (watermark_bytes >> 8) & 0x1F);
+    return ok;
+}
+
+/**
+ * @brief 配置 FIFO：无帧头，只缓存融合轴需要的传感器，水位映射到 INT1
+ */
+static bool configure_fifo() {
+    const uint8_t sensors = BMI270_FIFO_ACC_EN | (g_sensor_gyro ? BMI270_FIFO_GYR_EN : 0);
+
+    bool ok = true;
+    ok &= bmi270_write_reg(BMI270_REG_FIFO_CONFIG_0, 0x00);  // FIFO 满时覆盖最旧数据
+    ok &= bmi270_write_reg(BMI270_REG_FIFO_CONFIG_1, sensors);
+    ok &= write_fifo_watermark();
+    ok &= bmi270_write_reg(BMI270_REG_INT1_IO_CTRL, BMI270_INT1_OUTPUT_EN);
+    ok &= bmi270_write_reg(BMI270_REG_INT_LATCH, 0x00);
+    ok &= bmi270_write_reg(BMI270_REG_INT_MAP_DATA, BMI270_INT_MAP_FWM_INT1);
+    ok &= bmi270_write_reg(BMI270_REG_CMD, BMI270_CMD_FIFO_FLUSH);
+    return ok;
+}
+
+#if MOTION_GATE_ENABLE
+static bool write_motion_feature(uint8_t offset, float threshold_mg, uint32_t duration_ms) {
+    const uint16_t duration = (uint16_t)((duration_ms / MOTION_DURATION_MS_PER_LSB) & 0x1FFF);
+    const uint16_t threshold = (uint16_t)((uint16_t)(threshold_mg * MOTION_THRESHOLD_LSB_PER_MG) & 0x07FF);
+    const uint16_t word0 = duration | BMI270_FEAT_MOT_SELECT_XYZ;
+    const uint16_t word1 = threshold | BMI270_FEAT_MOT_ENABLE;
+
+    const uint8_t data[4] = {
+        (uint8_t)(word0 & 0xFF), (uint8_t)(word0 >> 8),
+        (uint8_t)(word1 & 0xFF), (uint8_t)(word1 >> 8),
+    };
+    return imu_bus_write(BMI270_REG_FEATURES + offset, data, sizeof(data));
+}
+
+/**
+ * @brief 配置 any-motion / no-motion 特性，并把两者映射到 INT1（与 FIFO 水位共用一根中断线）
+ */
+static bool configure_motion_detect() {
+    bool ok = true;
+    ok &= bmi270_write_reg(BMI270_REG_PWR_CONF, BMI270_PWR_CONF_NO_APS);
+    delay(1);
+    ok &= bmi270_write_reg(BMI270_REG_FEAT_PAGE, BMI270_FEAT_PAGE_MOTION);
+    ok &= write_motion_feature(BMI270_FEAT_ANY_MOT_OFFSET, MOTION_ANY_THRESHOLD_MG, MOTION_ANY_DURATION_MS);
+    ok &= write_motion_feature(BMI270_FEAT_NO_MOT_OFFSET, MOTION_NO_THRESHOLD_MG, MOTION_NO_DURATION_MS);
+    ok &= bmi270_write_reg(BMI270_REG_FEAT_PAGE, 0);
+    ok &= bmi270_write_reg(BMI270_REG_INT1_MAP_FEAT, BMI270_INT_ANY_MOTION | BMI270_INT_NO_MOTION);
+    return ok;
+}
+
+/**
+ * @brief 读取特性中断状态并更新运动状态
+ * @return false 总线读取失败
+ * 静止期间若同时门控采集，则取消 FIFO 水位中断映射，让采集线程只被运动中断唤醒；
+ * FIFO 以覆盖模式继续缓存最近的帧，恢复时一次读出即可预填滑动窗口。
+ */
+static bool update_motion_state() {
+    uint8_t status = 0;
+    if (bmi270_read_regs(BMI270_REG_INT_STATUS_0, &status, 1) != 1) {
+        return false;
+    }
+
+    bool active = g_motion_active;
+    if (status & BMI270_INT_ANY_MOTION) {
+        active = true;
+    } else if (status & BMI270_INT_NO_MOTION) {
+        active = false;
+    }
+    if (active == g_motion_active) {
+        return true;
+    }
+
+    g_motion_active = active;
+    if (active) {
+        g_stats.motion_events++;
+    }
+
+#if MOTION_GATE_SAMPLING
+    bmi270_write_reg(BMI270_REG_INT_MAP_DATA, active ? BMI270_INT_MAP_FWM_INT1 : 0x00);
+    if (active) {
+        g_skip_rate_correction = true;
+    }
+#endif
+    return true;
+}
+#endif
+
+/**
+ * @brief 一个原始寄存器顺序的帧经抗混叠抽取、转换与重采样，与磁力计插值合并后追加到 g_pending
+ * @param timestamp_us 抽取输出对应的采样时刻（传感器帧时刻减去 FIR 群延迟）；重采样输出与它相差
+ *                     不超过一个抽取后周期，磁力计按这一时刻插值
+ * @param produced g_pending 中已有的帧数
+ * @param upsample 这一帧代表的 IMU_SENSOR_ODR_HZ 样本数（低速采集时 > 1）：抽取器依次收到从上一帧到这一帧
+ *                 的线性插值，滤波器的采样率与状态因此不随 ODR 切换而变化
+ * @return size_t 追加后的帧数
+ */
+static size_t process_sensor_frame(const int16_t* sensor, uint32_t timestamp_us, size_t produced,
+                                   uint8_t upsample) {
+    for (uint8_t r = 1; r <= upsample; r++) {
+        int16_t interpolated[IMU_MAX_AXES];
+        const int16_t* in = sensor;
+        if (r < upsample) {
+            for (size_t c = 0; c < IMU_MAX_AXES; c++) {
+                interpolated[c] =
+                    (int16_t)(g_last_sensor[c] + ((int32_t)sensor[c] - g_last_sensor[c]) * r / upsample);
+            }
+            in = interpolated;
+        }
+
+        int16_t filtered[IMU_MAX_AXES];
+        if (!g_decimator.push(in, filtered)) {
+            continue;
+        }
+
+        imu_sample_t packed[IMU_MAX_AXES] = {0};
+        convert_frame(filtered, packed);
+
+        imu_sample_t resampled[2 * IMU_MAX_AXES];
+        size_t n = g_resampler.push(packed, resampled, 2);
+        for (size_t k = 0; k < n && produced < FIFO_BURST_FRAMES; k++, produced++) {
+            merge_frame(&resampled[k * IMU_MAX_AXES], timestamp_us, &g_pending[produced * g_axis_count]);
+        }
+    }
+    memcpy(g_last_sensor, sensor, sizeof(g_last_sensor));
+    return produced;
+}
+
+/**
+ * @brief 一次突发读出 FIFO 中的完整帧，重采样后放入 g_pending
+ * @return size_t 重采样后得到的帧数
+ */
+static size_t drain_fifo() {
+    poll_magnetometer();
+
+    uint8_t length_bytes[2];
+    if (bmi270_read_regs(BMI270_REG_FIFO_LENGTH_0, length_bytes, 2) != 2) {
+        return 0;
+    }
+
+    const size_t frame_bytes = fifo_frame_bytes();
+    size_t fifo_bytes = (size_t)length_bytes[0] | ((size_t)(length_bytes[1] & 0x3F) << 8);
+    fifo_bytes -= fifo_bytes % frame_bytes;
+    // 剩余部分在同一次唤醒中继续读出：读空到水位以下后中断才会再次触发
+    g_fifo_backlog = fifo_bytes > FIFO_BURST_BYTES;
+    // 仍留在 FIFO 中、比本次最后一帧更新的帧数
+    const size_t newer_frames = g_fifo_backlog ? (fifo_bytes - FIFO_BURST_BYTES) / frame_bytes : 0;
+    if (g_fifo_backlog) {
+        fifo_bytes = FIFO_BURST_BYTES;
+    }
+    if (fifo_bytes == 0) {
+        return 0;
+    }
+
+    const uint8_t* raw = g_fifo_raw;
+    size_t received = bmi270_read_regs(BMI270_REG_FIFO_DATA, g_fifo_raw, fifo_bytes);
+    size_t frames = received / frame_bytes;
+    const size_t acc_offset = g_sensor_gyro ? SENSOR_XYZ_BYTES : 0;
+
+    const uint32_t start_us = micros();
+    // FIFO 帧没有时间戳：FIFO 中最新的一帧按读出时刻计，之前的帧按实测 ODR 依次前推
+    const float sensor_hz = g_stats.sensor_hz > 0.0f ? g_stats.sensor_hz : (float)sensor_odr_hz();
+    const uint32_t period_us = (uint32_t)(1000000.0f / sensor_hz);
+    const uint8_t upsample = (uint8_t)(IMU_SENSOR_ODR_HZ / sensor_odr_hz());
+    const uint32_t group_delay_us = (IMU_DECIMATION_TAPS - 1) * period_us / upsample / 2;
+    size_t produced = 0;
+    for (size_t i = 0; i < frames; i++) {
+        const uint8_t* f = &raw[i * frame_bytes];
+
+        int16_t sensor[IMU_MAX_AXES] = {0};
+        read_xyz(f + acc_offset, &sensor[0]);
+        if (g_sensor_gyro) {
+            read_xyz(f, &sensor[3]);
+        }
+        const uint32_t frame_us = start_us - (uint32_t)(frames - 1 - i + newer_frames) * period_us;
+        if (g_raw_sink) {
+            emit_raw_frame(sensor, frame_us);
+        }
+        produced = process_sensor_frame(sensor, frame_us - group_delay_us, produced, upsample);
+    }
+
+    g_stats.process_us += micros() - start_us;
+
+    g_pending_frames = produced;
+    g_pending_pos = 0;
+    update_rate_window(frames, produced);
+    return produced;
+}
+
+/**
+ * @brief 从回放数据源取一个水位周期的帧，经与 FIFO 帧相同的处理链放入 g_pending
+ */
+static void drain_replay() {
+    int16_t board[FIFO_BURST_FRAMES * IMU_MAX_AXES];
+    const size_t max_frames =
+        IMU_FIFO_WATERMARK_FRAMES < FIFO_BURST_FRAMES ? IMU_FIFO_WATERMARK_FRAMES : FIFO_BURST_FRAMES;
+    const size_t frames = g_replay_source(board, max_frames);
+
+    const uint32_t start_us = micros();
+    size_t produced = 0;
+    for (size_t i = 0; i < frames; i++) {
+        // 板坐标系 -> 原始寄存器顺序（kBoardToRaw 是对合映射，符号同样只取反一次）
+        const int16_t* b = &board[i * IMU_MAX_AXES];
+        int16_t sensor[IMU_MAX_AXES];
+        for (size_t c = 0; c < IMU_MAX_AXES; c++) {
+            sensor[kBoardToRaw[c]] = kBoardSign[c] < 0.0f ? negate_saturate(b[c]) : b[c];
+        }
+        // 回放不采样磁力计（插值器已清空，磁力计轴为 0），结果与录制时的磁场无关
+        produced = process_sensor_frame(sensor, start_us, produced, 1);
+    }
+    g_stats.process_us += micros() - start_us;
+
+    g_pending_frames = produced;
+    g_pending_pos = 0;
+    update_rate_window(frames, produced);
+}
+
+/**
+ * @brief 抽取、重采样与磁力计插值回到初始状态、重采样比回到标称 ODR（回放开始与结束时调用）
+ */
+static void reset_filters() {
+    g_decimator.reset();
+    memset(g_last_sensor, 0, sizeof(g_last_sensor));
+    g_mag_mux.reset();
+#if IMU_GRAVITY_FRAME
+    g_gravity.reset();
+#endif
+    g_resampler.set_rates((float)IMU_SENSOR_ODR_HZ / IMU_DECIMATION_FACTOR, g_output_hz);
+    g_resampler.reset();
+}
+
+/**
+ * @brief 在采集线程中应用回放数据源的切换
+ * 开始时从干净的滤波器状态处理回放帧；结束时清空回放期间积压在 FIFO 中的帧，下一个统计窗口重新校正 ODR。
+ */
+static void apply_replay_source_request() {
+    if (!g_replay_source_changed) {
+        return;
+    }
+    g_replay_source_changed = false;
+    const bool was_active = g_replay_source != nullptr;
+    g_replay_source = g_replay_source_request;
+    if ((g_replay_source != nullptr) != was_active) {
+        reset_filters();
+        g_fifo_backlog = false;
+        g_replay_timer.restart();
+        if (!g_replay_source) {
+            configure_fifo();
+            g_skip_rate_correction = true;
+        }
+    }
+}
+
+/**
+ * @brief 在采集线程中应用低速采集的切换（刚读空 FIFO 之后调用，FIFO 中没有按旧 ODR 采样的帧）
+ * 只改 ODR 与水位，不清空 FIFO、不复位滤波器：抽取器的采样率不变，重采样相位与历史照常延续。
+ * 录制原始帧期间保持满速，录下的始终是 IMU_SENSOR_ODR_HZ 的数据。
+ */
+static void apply_low_rate_request() {
+    const bool low_rate = IMU_IDLE_ODR_HZ && g_low_rate_request && !g_raw_sink;
+    if (low_rate == g_low_rate) {
+        return;
+    }
+    g_low_rate = low_rate;
+    const uint8_t odr = odr_to_conf(sensor_odr_hz());
+    bmi270_write_reg(BMI270_REG_ACC_CONF, BMI270_ACC_CONF_PERF | odr);
+    if (g_sensor_gyro) {
+        bmi270_write_reg(BMI270_REG_GYR_CONF, BMI270_GYR_CONF_PERF | odr);
+    }
+    write_fifo_watermark();
+    g_stats.rate_switches++;
+
+    // 新 ODR 从下一个统计窗口开始实测；在那之前帧时刻按标称 ODR 反推。振荡器偏差与 ODR 无关，重采样比保持不变
+    g_stats.sensor_hz = (float)sensor_odr_hz();
+    g_window_start_us = micros();
+    g_window_sensor_frames = 0;
+    g_window_output_frames = 0;
+}
+#endif
+
+/**
+ * @brief 在采集线程中应用原始帧回调的切换；需要时重新配置 FIFO 以加入 / 去掉陀螺仪
+ */
+static void apply_raw_sink_request() {
+    if (!g_raw_sink_changed) {
+        return;
+    }
+    g_raw_sink_changed = false;
+    g_raw_sink = g_raw_sink_request;
+
+    const bool sensor_gyro = gyro_required() || g_raw_sink != nullptr;
+    if (sensor_gyro == g_sensor_gyro) {
+        return;
+    }
+    g_sensor_gyro = sensor_gyro;
+    if (sensor_gyro && !gyro_required()) {
+        bmi270_write_reg(BMI270_REG_GYR_CONF, BMI270_GYR_CONF_PERF | odr_to_conf(sensor_odr_hz()));
+    }
+#if IMU_USE_FIFO
+    // 帧长变化后 FIFO 中的旧帧无法再按新帧长解析，直接清空
+    configure_fifo();
+    g_skip_rate_correction = true;
+#endif
+}
+
+/**
+ * @brief 写入 ODR、FIFO 与运动检测配置（采集线程运行时的配置：陀螺仪跟随 g_sensor_gyro）
+ */
+static bool configure_sensor() {
+    const uint8_t odr = odr_to_conf(sensor_odr_hz());
+    bool ok = bmi270_write_reg(BMI270_REG_ACC_CONF, BMI270_ACC_CONF_PERF | odr);
+    if (g_sensor_gyro) {
+        ok &= bmi270_write_reg(BMI270_REG_GYR_CONF, BMI270_GYR_CONF_PERF | odr);
+    }
+    if (g_mag_count > 0) {
+        ok &= configure_magnetometer();
+    }
+#if IMU_USE_FIFO
+    ok &= configure_fifo();
+#if MOTION_GATE_ENABLE
+    ok &= configure_motion_detect();
+#endif
+#endif
+    return ok;
+}
+
+/**
+ * @brief 一次采集唤醒的结果：读出了数据（或运动门控下成功读取状态）时发心跳；
+ * 连续 g_recovery_wakeups 次失败时重新配置传感器，仍失败则下一次等待加倍
+ */
+static void note_wakeup(bool healthy) {
+    if (healthy) {
+        if (g_failed_wakeups > 0 || g_recovery_wakeups != IMU_RECOVERY_WAKEUPS) {
+            const uint32_t outage_ms = millis() - g_outage_start_ms;
+            if (g_recovery_wakeups != IMU_RECOVERY_WAKEUPS && outage_ms > g_stats.longest_outage_ms) {
+                g_stats.longest_outage_ms = outage_ms;
+            }
+            g_failed_wakeups = 0;
+            g_recovery_wakeups = IMU_RECOVERY_WAKEUPS;
+        }
+        supervisor_module_heartbeat(THREAD_SAMPLER);
+        return;
+    }
+
+    if (g_failed_wakeups == 0 && g_recovery_wakeups == IMU_RECOVERY_WAKEUPS) {
+        g_outage_start_ms = millis();
+    }
+    if (++g_failed_wakeups < g_recovery_wakeups) {
+        return;
+    }
+    LOG_WARN("[IMU] No data for %lu wakeups, reconfiguring the sensor\n", (unsigned long)g_failed_wakeups);
+    g_failed_wakeups = 0;
+    g_recovery_wakeups = g_recovery_wakeups * 2 < IMU_RECOVERY_MAX_WAKEUPS ? g_recovery_wakeups * 2
+                                                                          : IMU_RECOVERY_MAX_WAKEUPS;
+    if (!imu_module_recover()) {
+        LOG_WARN("[IMU] Reconfiguration failed, next attempt after %lu wakeups\n",
+                 (unsigned long)g_recovery_wakeups);
+    }
+}
+
+#if IMU_GRAVITY_FRAME && IMU_GRAVITY_BENCHMARK_ITERATIONS
+/**
+ * @brief 重力坐标系级的逐样本耗时（DWT 周期）：合成帧（绕 x 轴慢转并沿 x 挥动）依次经过重力坐标系级与
+ * 不做转换的打包，两者之差即这一级的额外开销。结束后重力滤波器回到初始状态
+ */
+static void benchmark_gravity_frame(uint32_t iterations) {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    uint64_t gravity_cycles = 0;
+    uint64_t plain_cycles = 0;
+    uint32_t worst_cycles = 0;
+    imu_sample_t packed[IMU_MAX_AXES];
+    for (uint32_t i = 0; i < iterations; i++) {
+        const float t = (float)i / (IMU_SENSOR_ODR_HZ / IMU_DECIMATION_FACTOR);
+        const float angle = 0.5f * t;
+        const float board[IMU_MAX_AXES] = {0.8f * sinf(12.0f * t), sinf(angle), cosf(angle), 28.6f, 0.0f, 0.0f};
+        int16_t raw[IMU_MAX_AXES];
+        for (size_t c = 0; c < IMU_MAX_AXES; c++) {
+            raw[kBoardToRaw[c]] = (int16_t)lroundf(kBoardSign[c] * board[c] * channel_lsb(c));
+        }
+
+        uint32_t start = DWT->CYCCNT;
+        convert_gravity_and_pack(raw, packed);
+        const uint32_t cycles = DWT->CYCCNT - start;
+        gravity_cycles += cycles;
+        if (cycles > worst_cycles) {
+            worst_cycles = cycles;
+        }
+        start = DWT->CYCCNT;
+        convert_and_pack(raw, packed);
+        plain_cycles += DWT->CYCCNT - start;
+    }
+    g_gravity.reset();
+
+    const uint32_t mean = (uint32_t)(gravity_cycles / iterations);
+    Serial.print("[IMU] Gravity frame: ");
+    Serial.print(iterations);
+    Serial.print(" samples, mean ");
+    Serial.print(mean);
+    Serial.print(" cycles (");
+    Serial.print(mean * 1000000.0f / SystemCoreClock, 2);
+    Serial.print(" us), max ");
+    Serial.print(worst_cycles);
+    Serial.print(" cycles; plain conversion ");
+    Serial.print((uint32_t)(plain_cycles / iterations));
+    Serial.println(" cycles");
+}
+#endif
+
+// ==================== 公共接口实现 ====================
+
+bool imu_module_init(float output_hz, const char* fusion_axes) {
+    if (!parse_axes(fusion_axes)) {
+        Serial.println("[IMU] Invalid axis layout");
+        return false;
+    }
+
+    if (!IMU.begin()) {
+        Serial.println("[IMU] Failed to initialize BMI270");
+        return false;
+    }
+
+    // 驱动库只负责上电和加载特性配置，之后的所有访问都走 imu_bus 突发传输
+    if (!imu_bus_init(BMI270_I2C_ADDR)) {
+        Serial.println("[IMU] Failed to initialize I2C bus");
+        return false;
+    }
+    if (!configure_magnetometer()) {
+        Serial.println("[IMU] Failed to initialize BMM150");
+        return false;
+    }
+
+    // 加速度计与陀螺仪使用相同 ODR，无帧头 FIFO 中每帧才会同时包含两者
+    g_output_hz = output_hz;
+    g_sensor_gyro = gyro_required();
+    const uint8_t odr = odr_to_conf(IMU_SENSOR_ODR_HZ);
+    if (!bmi270_write_reg(BMI270_REG_ACC_CONF, BMI270_ACC_CONF_PERF | odr) ||
+        (g_sensor_gyro && !bmi270_write_reg(BMI270_REG_GYR_CONF, BMI270_GYR_CONF_PERF | odr))) {
+        Serial.println("[IMU] Failed to set ODR");
+        return false;
+    }
+
+    imu_calibration_t calibration;
+    load_calibration(&calibration);
+    build_conversion(&calibration);
+    g_window_start_us = micros();
+
+#if IMU_GRAVITY_FRAME
+#if IMU_USE_FIFO
+    g_gravity.set_period((float)IMU_DECIMATION_FACTOR / IMU_SENSOR_ODR_HZ);
+#else
+    g_gravity.set_period(1.0f / output_hz);
+#endif
+#if IMU_GRAVITY_BENCHMARK_ITERATIONS
+    benchmark_gravity_frame(IMU_GRAVITY_BENCHMARK_ITERATIONS);
+#endif
+    g_gravity.reset();
+#endif
+
+#if IMU_USE_FIFO
+    g_decimator.design(IMU_SENSOR_ODR_HZ, IMU_DECIMATION_CUTOFF_HZ, IMU_DECIMATION_FACTOR);
+    g_resampler.set_rates((float)IMU_SENSOR_ODR_HZ / IMU_DECIMATION_FACTOR, output_hz);
+    g_resampler.reset();
+    if (!configure_fifo()) {
+        Serial.println("[IMU] Failed to configure FIFO");
+        return false;
+    }
+#if MOTION_GATE_ENABLE
+    if (!configure_motion_detect()) {
+        Serial.println("[IMU] Failed to configure motion detection");
+        return false;
+    }
+#endif
+    g_imu_int1.rise(mbed::callback(on_sample_ready));
+    Serial.println("[IMU] FIFO watermark mode enabled");
+#else
+    // 无 FIFO 时由硬件定时器按目标采样率触发，每个节拍读取一次最新样本
+    g_sample_ticker.attach(mbed::callback(on_sample_ready),
+                           std::chrono::microseconds((long)(1000000.0f / output_hz)));
+    Serial.println("[IMU] Timer-driven polling mode enabled");
+#endif
+    return true;
+}
+
+size_t imu_module_read_frames(imu_sample_t* out_frames, size_t max_frames) {
+#if IMU_USE_FIFO
+    while (g_pending_pos >= g_pending_frames) {
+        const bool backlog = g_fifo_backlog;
+        g_fifo_backlog = false;
+        if (g_replay_source) {
+            // 回放时按水位周期取帧，保持与实时采集相同的批大小和节奏
+            energy_module_sleep(ENERGY_SAMPLER);
+            g_imu_flags.wait_any_for(kSampleReadyFlag, g_replay_timer.remaining());
+            energy_module_wake(ENERGY_SAMPLER);
+            g_stats.wakeups++;
+        } else if (!backlog) {
+            // 在水位中断上休眠；超时后也直接查询一次，防止中断丢失导致卡死。
+            // 上一次没读到数据时只等一个水位周期，传感器无响应时尽快重新配置
+            energy_module_sleep(ENERGY_SAMPLER);
+            g_imu_flags.wait_any_for(kSampleReadyFlag, std::chrono::milliseconds(
+                                                           g_failed_wakeups > 0 ? kWatermarkPeriodMs : FIFO_WAIT_TIMEOUT_MS));
+            energy_module_wake(ENERGY_SAMPLER);
+            g_stats.wakeups++;
+        }
+        apply_raw_sink_request();
+        apply_replay_source_request();
+        if (g_replay_source) {
+            // 提前唤醒（切换请求、残留的水位中断）时不取帧
+            if (g_replay_timer.expired()) {
+                g_replay_timer.advance();
+                drain_replay();
+            }
+            note_wakeup(true);
+            continue;
+        }
+#if MOTION_GATE_ENABLE
+        const bool status_ok = update_motion_state();
+#if MOTION_GATE_SAMPLING
+        // 录制时不门控采集，静止片段同样是数据集的一部分
+        if (!g_motion_active && !g_raw_sink) {
+            note_wakeup(status_ok);
+            continue;
+        }
+#else
+        (void)status_ok;
+#endif
+#endif
+        // 总线错误与 FIFO 为空同样计为一次没读到数据
+        const uint32_t sensor_frames = g_stats.sensor_frames;
+        drain_fifo();
+        note_wakeup(g_stats.sensor_frames != sensor_frames);
+        if (!g_fifo_backlog) {
+            apply_low_rate_request();
+        }
+    }
+
+    size_t frames = g_pending_frames - g_pending_pos;
+    if (frames > max_frames) {
+        frames = max_frames;
+    }
+
+    memcpy(out_frames, &g_pending[g_pending_pos * g_axis_count], frames * g_axis_count * sizeof(imu_sample_t));
+    g_pending_pos += frames;
+    return frames;
+#else
+    (void)max_frames;
+    uint8_t raw[2 * SENSOR_XYZ_BYTES];
+    for (;;) {
+        energy_module_sleep(ENERGY_SAMPLER);
+        g_imu_flags.wait_any(kSampleReadyFlag);
+        energy_module_wake(ENERGY_SAMPLER);
+        g_stats.wakeups++;
+        apply_raw_sink_request();
+        // 数据寄存器中加速度与陀螺仪连续存放，一次突发读取即可取回全部 6 轴
+        const size_t read_bytes = g_sensor_gyro ? 2 * SENSOR_XYZ_BYTES : SENSOR_XYZ_BYTES;
+        if (bmi270_read_regs(BMI270_REG_DATA_8, raw, read_bytes) == read_bytes) {
+            int16_t sensor[IMU_MAX_AXES] = {0};
+            read_xyz(raw, &sensor[0]);
+            if (g_sensor_gyro) {
+                read_xyz(raw + SENSOR_XYZ_BYTES, &sensor[3]);
+            }
+            const uint32_t now_us = micros();
+            if (g_raw_sink) {
+                emit_raw_frame(sensor, now_us);
+            }
+            imu_sample_t packed[IMU_MAX_AXES];
+            convert_frame(sensor, packed);
+            poll_magnetometer();
+            merge_frame(packed, now_us, out_frames);
+            update_rate_window(1, 1);
+            note_wakeup(true);
+            return 1;
+        }
+        note_wakeup(false);
+    }
+#endif
+}
+
+void imu_module_set_raw_sink(imu_raw_sink_t sink) {
+    g_raw_sink_request = sink;
+    g_raw_sink_changed = true;
+#if IMU_USE_FIFO
+    g_imu_flags.set(kSampleReadyFlag);
+#endif
+}
+
+bool imu_module_set_replay_source(imu_replay_source_t source) {
+#if IMU_USE_FIFO
+    g_replay_source_request = source;
+    g_replay_source_changed = true;
+    g_imu_flags.set(kSampleReadyFlag);
+    return true;
+#else
+    (void)source;
+    return false;
+#endif
+}
+
+void imu_module_set_low_rate(bool low_rate) {
+    // 不唤醒采集线程：下一次水位中断读空 FIFO 后切换
+    g_low_rate_request = low_rate;
+}
+
+bool imu_module_motion_active() {
+    // 回放的录制本身决定是否有动作，不受传感器运动判定影响
+    return g_motion_active || g_replay_source != nullptr;
+}
+
+size_t imu_module_axis_count() {
+    return g_axis_count;
+}
+
+float imu_module_axis_lsb(size_t axis) {
+#if INFERENCE_Q15_FEATURES
+    return axis < g_axis_count ? channel_lsb(g_axis_map[axis]) : 1.0f;
+#else
+    (void)axis;
+    return 1.0f;
+#endif
+}
+
+uint8_t imu_module_axis_channel(size_t axis) {
+    return axis < g_axis_count ? g_axis_map[axis] : 0xFF;
+}
+
+float imu_module_channel_lsb(size_t channel) {
+    return channel_lsb(channel);
+}
+
+bool imu_module_recover() {
+    g_stats.recoveries++;
+    const bool ok = configure_sensor();
+#if IMU_USE_FIFO
+    // 中断前后的帧不连续：丢弃待输出的帧，滤波器从干净状态开始，下一个统计窗口不校正 ODR
+    g_pending_frames = 0;
+    g_pending_pos = 0;
+    g_fifo_backlog = false;
+    reset_filters();
+    g_skip_rate_correction = true;
+    // 运动检测重新配置后先按运动处理，由 no-motion 中断重新门控
+    g_motion_active = true;
+#endif
+    return ok;
+}
+
+void imu_module_get_stats(imu_stats_t* out_stats) {
+    if (out_stats) {
+        *out_stats = g_stats;
+    }
+}
@@ -1,215 +1,3370 @@
 // AI推理模块实现
-#include <Arduino.h>
-#include <Arduino_BMI270_BMM150.h>
-#include "rtos.h"
 #include <chrono>
 #include <cmath>
+#include "app_config.h"
+#include "alloc_module.h"
+#include "boot_module.h"
+#include "core1_module.h"
+#include "hal.h"
 #include "inference_module.h"
+#include "imu_module.h"
+#include "energy_module.h"
+#include "latency_module.h"
+#include "memory_module.h"
+#include "log_module.h"
+#include "pipeline_module.h"
+#include "pipeline_queue.h"
+#include "profiler_module.h"
+#include "radio_module.h"
+#include "record_module.h"
+#include "sample_timing.h"
+#include "spsc_ring.h"
+#include "seqlock.h"
+#include "shadow_tally.h"
+#include "stat_counters.h"
+#include "stats_module.h"
+#include "idle_prefilter.h"
+#include "onset_head.h"
+#include "window_memo.h"
+#include "window_normalizer.h"
+#include "stride_policy.h"
+#include "tap_detector.h"
+#include "gesture_detector.h"
+#include "gesture_segmenter.h"
+#include "vote_smoother.h"
+#include "novelty_detector.h"
+#include "fewshot_module.h"
+#include "model_module.h"
+#include "model_slot_module.h"
+#include "gesture_labels.h"
+#include "capture_module.h"
+#include "supervisor_module.h"
+#include "tcn_module.h"
+#include "telemetry_module.h"
+#include "watchdog_module.h"
+#if INFERENCE_NOVELTY_DETECTION
+#include "novelty_model.h"
+#endif
+#if INFERENCE_ONSET_HEAD
+#include "onset_model.h"
+#endif
 #include "a5-deminsion_inferencing.h"
+#if INFERENCE_Q15_FEATURES && EIDSP_USE_CMSIS_DSP
+#include "edge-impulse-sdk/CMSIS/DSP/Include/arm_math.h"
+#endif
+
+// 推理结果数组的容量（所有注册模型中最大的类别数；注册了类别更多的模型时在 build_flags 中覆盖）
+// LED / BLE 按类别下标查 gesture_labels.h；重新训练后须重新生成（pc_controller/label_table_gen.py）
+static_assert(GESTURE_LABEL_COUNT == EI_CLASSIFIER_LABEL_COUNT,
+              "include/gesture_labels.h does not match the deployed model, rerun pc_controller/label_table_gen.py");
+
+#ifndef INFERENCE_MAX_LABELS
+#define INFERENCE_MAX_LABELS EI_CLASSIFIER_LABEL_COUNT
+#endif
 
 // ==================== 内部状态（模块私有） ====================
 
-// 互斥锁，用于保护共享的预测结果
-static rtos::Mutex g_inference_mutex;
+// 流水线的 IMU 数据源（编译期绑定，见 hal.h）
+static hal::Imu g_imu;
+
+// 互斥锁：保护统计与手势事件，并串行化结果的写者（推理线程、inference_clear_result）
+static hal::Mutex g_inference_mutex;
+
+// 最新的预测结果：写者持有 g_inference_mutex 维护下面的副本并发布到 g_result，读者无锁读取快照
+static int g_prediction_index = -1;
+static uint8_t g_confidence_q = 0;
+static uint32_t g_result_sequence = 0;
+static Seqlock<inference_result_snapshot_t> g_result;
+// 已发布置信度的量化格式：启动时按模型输出张量确定一次，更换权重后不变（主机只在连接时读取）
+static inference_confidence_format_t g_confidence_format = {1.0f / 255.0f, 0};
+static float g_confidence_inv_scale = 255.0f;
+// 置信度变化超过这么多个量化步（约 0.01）才算新结果
+static uint8_t g_confidence_step = 2;
+// 流水线的发布级：每个消费者一个结果事件队列（写者持有 g_inference_mutex，单一生产者；消费者各自读取）
+// 结果序列号递增时唤醒所有消费者：BLE 线程阻塞等待而不必轮询序列号，LED 经监听投递到事件线程
+static PipelineQueue<inference_result_snapshot_t, INFERENCE_EVENT_QUEUE_DEPTH> g_result_queues[INFERENCE_CONSUMER_COUNT];
+// 由事件派发的消费者登记的监听（inference_set_result_listener）
+static void (*volatile g_result_listeners[INFERENCE_CONSUMER_COUNT])() = {nullptr};
+static const pipeline_stage_t kConsumerStages[INFERENCE_CONSUMER_COUNT] = {PIPELINE_BLE, PIPELINE_LED};
+// 各消费者对应的产出：没有订阅时不入队、不唤醒（pipeline_module_subscribe）
+static const pipeline_output_t kConsumerOutputs[INFERENCE_CONSUMER_COUNT] = {PIPELINE_OUTPUT_EVENTS,
+                                                                            PIPELINE_OUTPUT_LED};
+
+// 每次推理的原始分数（推理线程单一生产者，BLE 线程单一消费者）；只在订阅了 PIPELINE_OUTPUT_SCORES 时写入
+static PipelineQueue<inference_scores_t, INFERENCE_SCORE_QUEUE_DEPTH> g_score_queue;
+
+// 送入模型的样本（采集线程单一生产者，BLE 线程单一消费者）；只在订阅了 PIPELINE_OUTPUT_WINDOW 时写入
+static PipelineQueue<inference_window_frame_t, INFERENCE_WINDOW_QUEUE_DEPTH> g_window_queue;
+
+// 最近一次结束的手势（受 g_inference_mutex 保护，手势结束时序列号递增）
+static inference_gesture_event_t g_gesture_event = {-1, 0.0f, 0, 0};
+static uint32_t g_gesture_sequence = 0;
+
+// 当前手势的保持状态（受 g_inference_mutex 保护，手势确认与结束时 changes 各递增一次）
+static inference_segment_state_t g_segment_state = {{-1, 0.0f, 0, 0}, false, 0, 0};
 
-// 最新的预测结果
-static volatile int g_prediction_index = -1;
-static volatile float g_confidence = 0.0f;
-static volatile uint32_t g_result_sequence = 0;
+// 手势起始的临时判定（受 g_inference_mutex 保护，临时判定、确认、撤销时 changes 各递增一次）
+static inference_onset_state_t g_onset_state = {-1, 0, 0, 0, 0, 0, 0};
 
-// 滑动窗口缓冲区
-static float g_sliding_window[EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE] = {0};
+// 滑动窗口缓冲区（环形存放，g_window_head 指向最旧的数据点）
+#if INFERENCE_INT8_WINDOW
+// 直接以模型输入的量化格式存放，每个样本到达时只量化一次
+MEMORY_SIMD_BUFFER static int8_t g_sliding_window[EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE] = {0};
+static float g_input_inv_scale = 1.0f;
+static int32_t g_input_zero_point = 0;
+#if INFERENCE_Q15_FEATURES
+// int16 样本 -> int8 输入：Q15 乘数 fract * 2^shift / 32768 = 原始特征块缩放 / (轴的 LSB 值 × 输入量化步长)
+// × 2^Q15_OUT_FRAC_BITS，即乘法结果保留 7 位小数用于四舍五入，整数部分留出加零点前的余量
+#define Q15_OUT_FRAC_BITS 7
+struct q15_scale_t {
+    int16_t fract;
+    int8_t shift;
+};
+static q15_scale_t g_axis_scale[EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME];
+// 所有轴的乘数相同（单一传感器）时整步一次缩放
+static bool g_uniform_scale = true;
+// 运动能量换算回物理单位：1 / LSB²
+static float g_axis_energy_scale[EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME];
+#endif
+#if INFERENCE_PIPELINED_INPUT
+// 量化值的运动能量换算回物理单位：(输入量化步长 / 原始特征块缩放)²
+static float g_window_energy_scale = 1.0f;
+// 采集线程检测到的与上一帧完全相同的帧数（量化后的样本无法区分重复帧与静止）
+static volatile uint32_t g_sampler_duplicates = 0;
+static uint32_t g_last_duplicates = 0;
+#endif
+#if INFERENCE_POSTPROCESS_INT8
+// 预先量化到输出格式的 INFERENCE_MIN_CONFIDENCE
+static int8_t g_min_score_q = -128;
+#endif
+#if INFERENCE_WINDOW_NORMALIZE
+// 逐窗口标准化：新样本按窗口的增量统计量标准化后直接量化（代替 quantize_samples）
+static WindowNormalizer<EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME, EI_CLASSIFIER_RAW_SAMPLE_COUNT> g_window_normalizer;
+#endif
+#else
+MEMORY_SIMD_BUFFER static float g_sliding_window[EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE] = {0};
+#endif
+static const MemoryPlacement g_window_placement("sliding window", g_sliding_window, sizeof(g_sliding_window),
+                                                MEMORY_PLACE_SIMD);
+static size_t g_window_head = 0;
+// 上一次推理以来写入窗口的值的个数（流式推理只计算新的时间列；浮点窗口只把这部分交给连续分类器）
+static size_t g_window_new_values = EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE;
+
+#if INFERENCE_MULTIRES
+// 2 倍抽取的长窗口：每步进入窗口的两帧取平均成一帧，同样环形存放（覆盖两倍时长，不额外采样）
+#if INFERENCE_INT8_WINDOW
+MEMORY_SIMD_BUFFER static int8_t g_long_window[EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE] = {0};
+#else
+MEMORY_SIMD_BUFFER static float g_long_window[EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE] = {0};
+#endif
+static const MemoryPlacement g_long_window_placement("long window", g_long_window, sizeof(g_long_window),
+                                                     MEMORY_PLACE_SIMD);
+static size_t g_long_head = 0;
+// 长窗口推理（只由推理线程访问）：到期标记、最近一次的分数及其剩余的融合次数
+static bool g_long_due = false;
+static bool g_long_toggle = false;
+static float g_long_scores[INFERENCE_MAX_LABELS] = {0};
+static uint8_t g_long_uses = 0;
+// 统计（当前统计窗口）：长窗口推理次数、被推迟的次数、耗时、融合后改变获胜类别的次数
+static uint32_t g_long_runs = 0;
+static uint32_t g_long_deferred = 0;
+static uint32_t g_long_total_us = 0;
+static uint32_t g_long_max_us = 0;
+static uint32_t g_long_wins = 0;
+#endif
+
+// 每个样本进入窗口的时间戳（与窗口中的帧一一对应，同样环形存放）
+static uint32_t g_sample_timestamps[EI_CLASSIFIER_RAW_SAMPLE_COUNT] = {0};
 
 // 滑动窗口配置
-#define SLIDING_WINDOW_STEP 6  // 每次采集 6 个新数据点（2个样本 × 3轴）
+#define SLIDING_WINDOW_STEP (2 * EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME)  // 每次采集 2 个样本的全部轴
+
+// 步长整除窗口长度时，每次写入的新数据在环形窗口内不会跨越末尾
+static_assert(EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE % SLIDING_WINDOW_STEP == 0,
+              "SLIDING_WINDOW_STEP must divide the window size");
+
+// 采集线程每次从 imu_module 取回的最大帧数
+#define SAMPLER_BATCH_FRAMES 8
+// 推理线程等待新样本的超时（远大于一个步长的采集时间）
+#define SAMPLE_WAIT_TIMEOUT_MS 200
+// 样本批次到达时间标记的队列深度（FIFO 模式约每 40 ms 一批）
+#define SAMPLE_MARK_CAPACITY 64
+
+// 采集线程（生产者）与推理线程（消费者）之间的无锁样本队列；流水线输入时存放已量化的样本
+#if INFERENCE_PIPELINED_INPUT
+typedef int8_t window_sample_t;
+#else
+typedef imu_sample_t window_sample_t;
+#endif
+// 两个线程各自更新读写位置：整个队列独占缓存行，不与推理线程频繁写的状态交错
+MEMORY_RING_BUFFER static PipelineQueue<window_sample_t, SAMPLE_RING_CAPACITY> g_sample_ring;
+static const MemoryPlacement g_sample_ring_placement("sample ring", &g_sample_ring, sizeof(g_sample_ring),
+                                                     MEMORY_PLACE_RING);
+
+// 每批样本的到达时间，按写入队列的累计帧数标记（采集线程写、推理线程读）
+struct sample_batch_mark_t {
+    uint32_t frames_end;
+    uint32_t arrival_us;
+};
+static SpscRing<sample_batch_mark_t, SAMPLE_MARK_CAPACITY> g_batch_marks;
+// 采集线程写入样本队列的累计帧数（只由采集线程写入）
+static volatile uint32_t g_frames_pushed = 0;
+
+// 以下只由推理线程访问：已进入窗口的累计帧数，以及尚未越过的批次标记
+static uint32_t g_frames_consumed = 0;
+static sample_batch_mark_t g_pending_mark = {0, 0};
+static bool g_have_pending_mark = false;
+
+// 截止时间调度：有一次到期的推理尚未执行（等窗口追上最新样本）
+static bool g_inference_pending = false;
+// 推理线程正阻塞在样本队列上
+static volatile bool g_waiting_for_samples = false;
+static volatile inference_result_observer_t g_result_observer = nullptr;
+// 当前统计窗口的调度统计（推理线程无锁更新，登记到统计注册表，报告时取出清零）与上一个窗口的快照
+static StatCounter g_scheduler_classified;
+static StatCounter g_scheduler_skipped;
+static StatCounter g_scheduler_canceled;
+static StatMax g_scheduler_max_latency_us;
+static Seqlock<inference_scheduler_stats_t> g_scheduler_snapshot;
+// 推理线程等待 g_inference_mutex 的统计（持锁后更新，受 g_inference_mutex 保护）
+static inference_lock_stats_t g_lock_stats = {0, 0, 0, 0};
+
+#if INFERENCE_RADIO_AWARE
+// 按射频时序放置推理（推理线程无锁更新，登记到统计注册表）：两组推理耗时的分布用 250 us 的桶（量程 32 ms），
+// 推理耗时的估计是未受射频打扰的推理（放置组与没有时序时）耗时的衰减最大值，决定一次推理需要多长的空隙
+static const uint32_t kRadioBucketUs = 250;
+static const size_t kRadioBuckets = 128;
+enum radio_sample_t {
+    RADIO_SAMPLE_NONE = 0,      // 没有连接事件时序：不计入两组
+    RADIO_SAMPLE_PLACED,
+    RADIO_SAMPLE_CONTROL
+};
+static StatHistogram<kRadioBuckets> g_radio_placed(kRadioBucketUs);
+static StatHistogram<kRadioBuckets> g_radio_control(kRadioBucketUs);
+static StatCounter g_radio_deferred;
+static StatCounter g_radio_no_fit;
+// 推迟的平均时长：推理线程累计，平均值以一个原子字发布
+static std::atomic<uint32_t> g_radio_mean_defer_us(0);
+// 只由推理线程访问
+static uint64_t g_radio_defer_total_us = 0;
+static uint32_t g_radio_invokes = 0;
+static uint32_t g_invoke_estimate_us = 0;
+#endif
+
+// 协作式取消：推理线程运行模型期间置位 g_cancel_armed，SDK 与编译模型的检查点（DSP 之后、相邻两个节点之间）
+// 发现样本队列里已有完整的下一步时放弃本次推理（g_cancel_hit），窗口滑到最新后重新分类。
+// g_cancel_streak 为原窗口连续被放弃的次数，达到 INFERENCE_CANCEL_MAX_STREAK 后下一次不再可取消
+static volatile bool g_cancel_armed = false;
+static volatile bool g_cancel_hit = false;
+static uint8_t g_cancel_streak = 0;
+
+#if INFERENCE_CANCEL_STALE
+// 覆盖 SDK 移植层的弱定义（双核时在核 1 上调用）
+EI_IMPULSE_ERROR ei_run_impulse_check_canceled() {
+    if (!g_cancel_armed || g_sample_ring.size() < SLIDING_WINDOW_STEP) {
+        return EI_IMPULSE_OK;
+    }
+    g_cancel_hit = true;
+    return EI_IMPULSE_CANCELED;
+}
+#endif
+
+static void cancel_arm(bool armed) {
+    g_cancel_hit = false;
+    g_cancel_armed = armed;
+}
+
+/**
+ * @brief 解除检查点
+ * @return true 本次推理被取消
+ */
+static bool cancel_disarm() {
+    g_cancel_armed = false;
+    return g_cancel_hit;
+}
+// 平均延迟的累计（只由推理线程访问）
+static uint64_t g_latency_total_us = 0;
+static uint32_t g_latency_samples = 0;
+
+// 采样间隔 / 抖动统计（名义间隔在 inference_module_init 中设置；推理线程记录，上一个窗口的快照经顺序锁发布）
+static SampleTimingStats g_timing;
+static window_sample_t g_last_frame[EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME] = {0};
+static uint32_t g_last_overruns = 0;
+static Seqlock<sample_timing_stats_t> g_timing_snapshot;
+
+// 自适应推理步长
+static StridePolicy g_stride_policy;
+static hal::Mutex g_stride_mutex;
+// 运行时配置的步长（样本数，受 g_stride_mutex 保护）与生效的工作点；生效的步长由两者共同决定
+static uint8_t g_config_fine_samples = INFERENCE_STRIDE_FINE_SAMPLES;
+static uint8_t g_config_coarse_samples = INFERENCE_STRIDE_COARSE_SAMPLES;
+static volatile uint8_t g_power_point = INFERENCE_POWER_FULL;
+// 电量分级与主机各自请求的工作点（受 g_stride_mutex 保护），生效的是更省电的一个
+static uint8_t g_battery_point = INFERENCE_POWER_FULL;
+static volatile uint8_t g_host_point = INFERENCE_HOST_POINT_NONE;
+static int g_idle_index = -1;
+static float g_step_energy = 0.0f;
+static uint32_t g_inference_count = 0;
+
+#if TELEMETRY_ENABLE && INFERENCE_EVENT_MODE == INFERENCE_EVENTS_RAW
+// 诊断日志中最近记录的结果类别：RAW 模式下置信度变化也会发布，同一手势只记第一次
+static int g_telemetry_last_index = -1;
+#endif
+
+#if INFERENCE_VOTE_SMOOTHING
+// 投票平滑（只在推理线程中使用）
+static VoteSmoother<INFERENCE_MAX_LABELS, INFERENCE_VOTE_READINGS> g_vote_smoother;
+#endif
+
+#if INFERENCE_EVENT_MODE == INFERENCE_EVENTS_PERFCAL
+// 手势事件检测的平均窗口容量（结果个数）
+#define INFERENCE_EVENT_MAX_AVERAGE 16
+
+// 手势事件检测（推理线程更新；配置依赖细步长，与步长策略共用 g_stride_mutex）
+static GestureDetector<INFERENCE_MAX_LABELS, INFERENCE_EVENT_MAX_AVERAGE> g_event_detector;
+static uint8_t g_fine_stride_samples = INFERENCE_STRIDE_FINE_SAMPLES;
+#endif
+
+#if INFERENCE_EVENT_MODE == INFERENCE_EVENTS_SEGMENTS
+// 手势分段状态机（只在推理线程中使用）
+static GestureSegmenter g_segmenter;
+#endif
+
+#if INFERENCE_NOVELTY_DETECTION
+// 新颖性检测（只在推理线程中使用），激活形状由 novelty_model.h 给出，初始化时与模型核对
+static NoveltyDetector<NOVELTY_MODEL_COLUMNS, NOVELTY_MODEL_CHANNELS> g_novelty;
+#endif
+
+// 串口请求的逐算子性能剖析（在推理线程中执行，避免与分类器争用编译图）
+static volatile bool g_profile_requested = false;
+
+// 最近一次分类各级的耗时（推理线程），推理基准按级记录
+static uint32_t g_run_dsp_us = 0;
+static uint32_t g_run_classify_us = 0;
+static uint32_t g_run_postprocess_us = 0;
+// 自启动以来运行过 CNN 的推理的模型调用耗时（统计注册表 "inference.classify_us"）
+static StatQuantile<> g_classify_quantile;
+static bool g_stats_registered = false;
+
+// 推理基准：请求与结果受 g_inference_mutex 保护，执行与样本只在推理线程中；一轮结束时排序得出分位数
+static bool g_bench_pending = false;
+static inference_bench_mode_t g_bench_mode = INFERENCE_BENCH_SYNTHETIC;
+static uint16_t g_bench_target = 0;
+static uint16_t g_bench_count = 0;
+static bool g_bench_live = false;
+static uint32_t g_bench_us[INFERENCE_BENCH_STAGE_COUNT][INFERENCE_BENCHMARK_MAX_RUNS];
+static inference_bench_report_t g_bench_report;
+static uint32_t g_bench_version = 0;
+static const char* const kBenchStageNames[INFERENCE_BENCH_STAGE_COUNT] = {"dsp", "classify", "postprocess", "total"};
+
+// 级联 idle 预筛（CNN 之前的第一级）
+static IdlePrefilter g_idle_prefilter;
+
+#if INFERENCE_ONSET_HEAD
+// 手势起始的前缀分类头与临时判定的确认（只由推理线程访问）
+static OnsetHead g_onset_head;
+static OnsetTracker g_onset_tracker;
+#endif
+
+#if INFERENCE_RESULT_MEMO
+// 结果记忆（预筛之后的第二级）：窗口与上次分类的窗口几乎相同时沿用上次的结果
+#if INFERENCE_INT8_WINDOW
+static WindowMemo<int8_t, EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE> g_window_memo;
+#else
+static WindowMemo<float, EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE> g_window_memo;
+#endif
+#endif
+
+// 已注册的模型：启动时全部初始化，推理线程按 g_active_model 选择
+struct inference_model_t {
+    ei_impulse_handle_t* handle;
+    TfLiteStatus (*arena_usage)(size_t* arena_bytes, size_t* tensor_bytes, size_t* persistent_bytes);
+};
+
+static const inference_model_t g_models[] = {
+    {&ei_default_impulse, &tflite_learn_792000_36_arena_usage} INFERENCE_EXTRA_IMPULSES
+};
+static const size_t kModelCount = sizeof(g_models) / sizeof(g_models[0]);
+static volatile size_t g_active_model = 0;
+static volatile int g_requested_model = -1;
+
+// 每个模型的 idle 类别序号、推理耗时统计与最近一次结果（后三者受 g_inference_mutex 保护）
+static int g_model_idle_index[kModelCount];
+static uint32_t g_model_invokes[kModelCount];
+static uint64_t g_model_total_us[kModelCount];
+static uint32_t g_model_max_us[kModelCount];
+static int g_model_last_index[kModelCount];
+static float g_model_last_confidence[kModelCount];
+
+#if INFERENCE_SHARED_IMPULSES
+static_assert(kModelCount <= EI_CLASSIFIER_SHARED_MAX_IMPULSES,
+              "INFERENCE_EXTRA_IMPULSES registers more models than EI_CLASSIFIER_SHARED_MAX_IMPULSES");
+
+// 所有模型在同一个窗口上运行：句柄按 g_models 的顺序排列，结果每步覆盖
+static ei_impulse_handle_t* g_model_handles[kModelCount];
+static ei_impulse_result_t g_model_results[kModelCount];
+#endif
+
+#if INFERENCE_SHADOW_MODEL
+static_assert(INFERENCE_SHADOW_MODEL < kModelCount, "INFERENCE_SHADOW_MODEL is not a registered model");
+static_assert(SHADOW_HISTOGRAM_BINS == 10, "telemetry_shadow_histogram_t has 10 bins");
+
+// 影子模式：到期标记与倒数、到期时生产模型对同一窗口的判定（只由推理线程访问）；
+// 对比统计与候选模型的平均耗时受 g_inference_mutex 保护，让路次数与耗时分布是无锁统计量（登记到统计注册表）
+static bool g_shadow_due = false;
+static uint8_t g_shadow_countdown = INFERENCE_SHADOW_EVERY;
+static int g_shadow_production_index = -1;
+static float g_shadow_production_confidence = 0.0f;
+static ShadowTally g_shadow_tally;
+static StatCounter g_shadow_deferred;
+static StatQuantile<> g_shadow_time_us;
+static uint32_t g_shadow_period_deferred = 0;
+static uint64_t g_shadow_total_us = 0;
+static uint64_t g_shadow_period_us = 0;
+static uint32_t g_shadow_period_max_us = 0;
+#endif
+
+// 运动门控统计：静止时跳过分类所占的时间比例（当前窗口只由推理线程访问；每个窗口结束时
+// 累加到自启动以来的毫秒计数，登记为 gate.gated_ms / gate.total_ms，两者之比即累计的门控比例）
+static uint32_t g_gated_us = 0;
+static uint32_t g_total_us = 0;
+static volatile float g_gated_ratio = 0.0f;
+static StatCounter g_gate_gated_ms;
+static StatCounter g_gate_total_ms;
+
+#if INFERENCE_ARM_SUPPORT
+// 两段式唤醒（只由推理线程写入）：双击检测、唤醒窗口的截止时刻与统计
+static TapDetector g_tap_detector;
+static volatile bool g_armed = false;
+static uint32_t g_armed_until_ms = 0;
+static uint32_t g_armed_us = 0;
+static volatile uint32_t g_arm_count = 0;
+static volatile float g_armed_ratio = 0.0f;
+
+/**
+ * @brief 是否需要双击唤醒才推理：两段式构建始终需要，电量分级时只在按需一级需要
+ */
+static bool arm_required() {
+    return INFERENCE_ARM_MODE || g_power_point == INFERENCE_POWER_ON_DEMAND;
+}
+#endif
 
 // ==================== 内部辅助函数 ====================
 
 /**
- * @brief 采集指定数量的新IMU数据点（用于滑动窗口）
+ * @brief 把写者副本发布为读者可见的快照，并作为事件扇出到每个消费者的队列（调用者持有 g_inference_mutex）
+ * @param sample_us 窗口最新样本的到达时刻（0 = 与样本无关，如清除结果）
+ */
+static void publish_result(uint32_t sample_us) {
+    const inference_result_snapshot_t snapshot = {g_prediction_index, g_confidence_q, g_result_sequence, hal::now_ms(),
+                                                  sample_us};
+    g_result.store(snapshot);
+    for (size_t i = 0; i < INFERENCE_CONSUMER_COUNT; i++) {
+        if (!pipeline_module_subscribed(kConsumerOutputs[i])) {
+            continue;
+        }
+        // 队列满时丢弃本事件，计入 overruns()，不等待消费者
+        g_result_queues[i].push(&snapshot, 1);
+        pipeline_module_record_queue(kConsumerStages[i], g_result_queues[i].size(), g_result_queues[i].capacity(),
+                                     g_result_queues[i].overruns());
+    }
+}
+
+/**
+ * @brief 唤醒所有结果消费者（在释放 g_inference_mutex 之后调用）
+ */
+static void notify_consumers() {
+    for (size_t i = 0; i < INFERENCE_CONSUMER_COUNT; i++) {
+        if (pipeline_module_subscribed(kConsumerOutputs[i])) {
+            inference_wake_result_waiter((inference_consumer_t)i);
+        }
+    }
+}
+
+/**
+ * @brief 推理线程获取 g_inference_mutex：先不等待地尝试，锁被读者持有时记下阻塞了多久
+ * 目标上的 rtos::Mutex 带优先级继承（osMutexPrioInherit）：推理线程等待期间持锁的低优先级线程提升到推理线程的优先级，
+ * 中等优先级的线程不能在它释放锁之前抢占它，阻塞时间只取决于读者临界区的长度
+ */
+static void lock_from_inference() {
+    if (g_inference_mutex.trylock()) {
+        g_lock_stats.acquisitions++;
+        return;
+    }
+    const uint32_t start_us = hal::now_us();
+    g_inference_mutex.lock();
+    const uint32_t wait_us = hal::now_us() - start_us;
+    g_lock_stats.acquisitions++;
+    g_lock_stats.contended++;
+    g_lock_stats.total_wait_us += wait_us;
+    if (wait_us > g_lock_stats.max_wait_us) {
+        g_lock_stats.max_wait_us = wait_us;
+    }
+}
+
+#if INFERENCE_RADIO_AWARE
+/**
+ * @brief invoke 之前按射频时序放置：现在开始会跨过下一个连接事件时休眠到该事件结束之后
+ * 整毫秒部分交给 RTOS 休眠（节拍粒度 1 ms），最后不到 1~2 ms 忙等到截止时刻，开始时刻不因节拍而晚到下一个事件里
+ * @return 这次推理的耗时计入哪一组；*out_kind / *out_defer_us 为放置的决定
+ */
+static radio_sample_t place_around_radio(radio_gap_kind_t* out_kind, uint32_t* out_defer_us) {
+    const radio_gap_decision_t decision =
+        radio_module_decide(g_invoke_estimate_us, INFERENCE_RADIO_GUARD_US, INFERENCE_RADIO_MAX_DEFER_US);
+    *out_kind = decision.kind;
+    *out_defer_us = 0;
+    if (decision.kind == RADIO_GAP_UNTIMED) {
+        return RADIO_SAMPLE_NONE;
+    }
+    g_radio_invokes++;
+    if (INFERENCE_RADIO_CONTROL_EVERY > 0 && g_radio_invokes % INFERENCE_RADIO_CONTROL_EVERY == 0) {
+        return RADIO_SAMPLE_CONTROL;
+    }
+    if (decision.kind == RADIO_GAP_DEFER) {
+        const uint32_t deadline_us = hal::now_us() + decision.defer_us;
+        if (decision.defer_us > 1500) {
+            energy_module_sleep_for(ENERGY_INFERENCE, std::chrono::milliseconds((decision.defer_us - 1000) / 1000));
+        }
+        while ((int32_t)(hal::now_us() - deadline_us) < 0) {
+        }
+        *out_defer_us = decision.defer_us;
+    }
+    return RADIO_SAMPLE_PLACED;
+}
+
+/**
+ * @brief 记下一次完成的推理的耗时（elapsed_us，墙钟）
+ */
+static void record_radio_invoke(radio_sample_t sample, radio_gap_kind_t kind, uint32_t defer_us, uint32_t elapsed_us) {
+    if (sample != RADIO_SAMPLE_CONTROL) {
+        const uint32_t decayed = g_invoke_estimate_us - g_invoke_estimate_us / 16;
+        g_invoke_estimate_us = elapsed_us > decayed ? elapsed_us : decayed;
+    }
+    if (sample == RADIO_SAMPLE_CONTROL) {
+        g_radio_control.record(elapsed_us);
+    } else if (sample == RADIO_SAMPLE_PLACED) {
+        g_radio_placed.record(elapsed_us);
+        if (kind == RADIO_GAP_DEFER) {
+            g_radio_deferred.add();
+            g_radio_defer_total_us += defer_us;
+            g_radio_mean_defer_us.store((uint32_t)(g_radio_defer_total_us / g_radio_deferred.value()),
+                                        std::memory_order_relaxed);
+        } else if (kind == RADIO_GAP_NO_FIT) {
+            g_radio_no_fit.add();
+        }
+    }
+}
+#endif
+
+/**
+ * @brief 从样本队列取出指定数量的新IMU数据点（用于滑动窗口）
+ * 采样由独立的采集线程完成，推理和串口打印期间不会丢失样本
  * @param buffer 输出缓冲区
- * @param num_samples 要采集的数据点数量（3的倍数：X, Y, Z）
- * @return true 采集成功
- * @return false 采集失败
+ * @param num_samples 要取出的数据点数量（每帧轴数的整数倍）
+ * @return true 取出成功
+ * @return false 等待超时（采集线程没有产生数据）
+ */
+static bool collect_new_samples(window_sample_t* buffer, size_t num_samples) {
+    while (!g_sample_ring.pop(buffer, num_samples)) {
+        // 只在出队失败后置位：观察到 true 时本线程已处理完之前所有完整的步
+        g_waiting_for_samples = true;
+        energy_module_sleep(ENERGY_INFERENCE);
+        const bool woken = g_sample_ring.wait(std::chrono::milliseconds(SAMPLE_WAIT_TIMEOUT_MS));
+        energy_module_wake(ENERGY_INFERENCE);
+        g_waiting_for_samples = false;
+        if (!woken) {
+            return g_sample_ring.pop(buffer, num_samples);
+        }
+    }
+
+    return true;
+}
+
+#if INFERENCE_ARM_SUPPORT
+/**
+ * @brief 一帧相对上一帧（g_last_frame）的运动能量，换算为物理单位
+ */
+static float frame_energy(const window_sample_t* frame) {
+    float energy = 0.0f;
+    for (size_t a = 0; a < EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME; a++) {
+#if INFERENCE_PIPELINED_INPUT
+        const int32_t d = (int32_t)frame[a] - g_last_frame[a];
+        energy += (float)(d * d);
+#elif INFERENCE_Q15_FEATURES
+        const int32_t d = (int32_t)frame[a] - g_last_frame[a];
+        energy += (float)(d * d) * g_axis_energy_scale[a];
+#else
+        const float d = frame[a] - g_last_frame[a];
+        energy += d * d;
+#endif
+    }
+#if INFERENCE_PIPELINED_INPUT
+    energy *= g_window_energy_scale;
+#endif
+    return energy;
+}
+
+/**
+ * @brief 打开（或延长）唤醒窗口
+ */
+static void arm_window(const char* reason) {
+    if (!g_armed) {
+        g_armed = true;
+        g_arm_count++;
+        LOG_INFO("[Inference] Armed by %s for %d ms\n", reason, (int)ARM_WINDOW_MS);
+    }
+    g_armed_until_ms = hal::now_ms() + ARM_WINDOW_MS;
+}
+#endif
+
+/**
+ * @brief 为进入窗口的一批样本打时间戳，并更新间隔、重复、丢弃统计
+ * @param frames 新样本（SLIDING_WINDOW_STEP 个值）
+ */
+static void record_sample_timing(const window_sample_t* frames) {
+    const uint32_t now_us = (uint32_t)ei_read_timer_us();
+    const size_t frame_count = SLIDING_WINDOW_STEP / EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME;
+    const size_t first_frame = g_window_head / EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME;
+
+    uint32_t duplicated = 0;
+#if INFERENCE_PIPELINED_INPUT
+    // 量化值的差不会溢出 int32
+    int32_t energy_q = 0;
+#elif INFERENCE_Q15_FEATURES
+    // 按轴累加 LSB² 的整数和，整步只换算一次物理单位
+    uint64_t energy_lsb[EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME] = {0};
+#else
+    float energy = 0.0f;
+#endif
+    for (size_t f = 0; f < frame_count; f++) {
+        const window_sample_t* frame = &frames[f * EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME];
+#if !INFERENCE_PIPELINED_INPUT
+        if (memcmp(frame, g_last_frame, sizeof(g_last_frame)) == 0) {
+            duplicated++;
+        }
+#endif
+        // 运动能量：相邻样本差的平方和（对重力分量不敏感，只反映变化）
+        for (size_t a = 0; a < EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME; a++) {
+#if INFERENCE_PIPELINED_INPUT
+            const int32_t d = (int32_t)frame[a] - g_last_frame[a];
+            energy_q += d * d;
+#elif INFERENCE_Q15_FEATURES
+            const int32_t d = (int32_t)frame[a] - g_last_frame[a];
+            energy_lsb[a] += (uint64_t)((int64_t)d * d);
+#else
+            const float d = frame[a] - g_last_frame[a];
+            energy += d * d;
+#endif
+        }
+#if INFERENCE_ARM_SUPPORT
+        // 唤醒手势：每帧几次比较，未唤醒时这是唯一运行的识别
+        if (arm_required() && g_tap_detector.on_frame(frame_energy(frame))) {
+            arm_window("double tap");
+        }
+#endif
+        memcpy(g_last_frame, frame, sizeof(g_last_frame));
+        g_sample_timestamps[first_frame + f] = now_us;
+    }
+#if INFERENCE_PIPELINED_INPUT
+    const float energy = energy_q * g_window_energy_scale;
+    const uint32_t sampler_duplicates = g_sampler_duplicates;
+    duplicated = sampler_duplicates - g_last_duplicates;
+    g_last_duplicates = sampler_duplicates;
+#elif INFERENCE_Q15_FEATURES
+    float energy = 0.0f;
+    for (size_t a = 0; a < EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME; a++) {
+        energy += energy_lsb[a] * g_axis_energy_scale[a];
+    }
+#endif
+
+    const uint32_t overruns = g_sample_ring.overruns();
+    g_timing.add_dropped(overruns - g_last_overruns);
+    g_last_overruns = overruns;
+    g_timing.add_duplicated(duplicated);
+    g_timing.record(now_us, frame_count);
+    g_step_energy = energy / frame_count;
+}
+
+/**
+ * @brief 丢弃已完全进入窗口的批次标记，让 g_pending_mark 停在包含窗口最新样本的批次上
+ * 每步都调用，门控或粗步长期间标记队列也不会积压。
+ */
+static void advance_batch_marks() {
+    for (;;) {
+        if (!g_have_pending_mark) {
+            if (!g_batch_marks.pop(&g_pending_mark, 1)) {
+                return;
+            }
+            g_have_pending_mark = true;
+        }
+        if ((int32_t)(g_pending_mark.frames_end - g_frames_consumed) >= 0) {
+            return;
+        }
+        g_have_pending_mark = false;
+    }
+}
+
+/**
+ * @brief 窗口最新样本的到达时刻（micros）
+ * @return uint32_t 0 = 未知（标记在队列满时被丢弃）
  */
-static bool collect_new_samples(float* buffer, size_t num_samples) {
-    size_t collected = 0;
+static uint32_t window_arrival_us() {
+    // advance_batch_marks 已让 g_pending_mark 停在包含窗口最新样本的批次上
+    const bool known = g_have_pending_mark && (int32_t)(g_pending_mark.frames_end - g_frames_consumed) >= 0;
+    return known ? g_pending_mark.arrival_us : 0;
+}
+
+#if INFERENCE_Q15_FEATURES
+/**
+ * @brief 与 arm_scale_q15 相同的定点缩放（同样截断、饱和到 q15），用于逐轴乘数不同或没有 CMSIS-DSP 的情况
+ */
+static inline void scale_q15(const int16_t* src, int16_t fract, int8_t shift, int16_t* dst, size_t length) {
+    const int k_shift = 15 - shift;
+    for (size_t i = 0; i < length; i++) {
+        const int32_t v = ((int32_t)src[i] * fract) >> k_shift;
+        dst[i] = (int16_t)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+    }
+}
+
+/**
+ * @brief int16 样本直接量化为模型输入：Q15 缩放后四舍五入去掉小数位，加零点并饱和到 int8
+ * @param length 样本个数（整帧，不超过一批采集的帧）
+ */
+static void quantize_samples(const int16_t* samples, int8_t* dst, size_t length) {
+    int16_t scaled[SAMPLER_BATCH_FRAMES * IMU_MAX_FUSION_AXES];
+    if (g_uniform_scale) {
+#if EIDSP_USE_CMSIS_DSP
+        arm_scale_q15(samples, g_axis_scale[0].fract, g_axis_scale[0].shift, scaled, length);
+#else
+        scale_q15(samples, g_axis_scale[0].fract, g_axis_scale[0].shift, scaled, length);
+#endif
+    } else {
+        for (size_t i = 0; i < length; i++) {
+            const q15_scale_t& axis = g_axis_scale[i % EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME];
+            scale_q15(&samples[i], axis.fract, axis.shift, &scaled[i], 1);
+        }
+    }
+
+    const int32_t bias = (g_input_zero_point << Q15_OUT_FRAC_BITS) + (1 << (Q15_OUT_FRAC_BITS - 1));
+    for (size_t i = 0; i < length; i++) {
+        const int32_t q = (scaled[i] + bias) >> Q15_OUT_FRAC_BITS;
+        dst[i] = (int8_t)(q < -128 ? -128 : (q > 127 ? 127 : q));
+    }
+}
+
+/**
+ * @brief 按原始特征块（ei_model_dsp_t）的缩放和模型输入量化参数计算每轴的 Q15 乘数
+ * 只接受不重排轴的原始特征块：其它 DSP 块的特征不是逐样本缩放，无法在样本进入窗口时量化
+ */
+static bool configure_q15_features(float input_scale) {
+    const ei_model_dsp_t& block = ei_default_impulse.impulse->dsp_blocks[0];
+    if (ei_default_impulse.impulse->dsp_blocks_size != 1 || block.extract_fn != &extract_raw_features) {
+        LOG_ERROR("[Inference] Q15 features require a single raw DSP block\n");
+        return false;
+    }
+    if (g_imu.axis_count() != EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME || block.axes_size != g_imu.axis_count()) {
+        LOG_ERROR("[Inference] Q15 features: axis count does not match the raw DSP block\n");
+        return false;
+    }
+    const float scale_axes = static_cast<const ei_dsp_config_raw_t*>(block.config)->scale_axes;
+#if INFERENCE_PIPELINED_INPUT
+    g_window_energy_scale /= scale_axes * scale_axes;
+#endif
+
+    for (size_t a = 0; a < EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME; a++) {
+        if (block.axes[a] != a) {
+            LOG_ERROR("[Inference] Q15 features: raw DSP block reorders axes\n");
+            return false;
+        }
+        const float lsb = g_imu.axis_lsb(a);
+        const float multiplier = scale_axes / (lsb * input_scale) * (1 << Q15_OUT_FRAC_BITS);
+        int exponent = 0;
+        long fract = lroundf(frexpf(multiplier, &exponent) * 32768.0f);
+        if (fract == 32768) {
+            fract = 16384;
+            exponent++;
+        }
+        if (exponent > 15 || exponent < -16) {
+            LOG_ERROR("[Inference] Q15 features: axis %u multiplier %.6f out of range\n", (unsigned)a, multiplier);
+            return false;
+        }
+        g_axis_scale[a].fract = (int16_t)fract;
+        g_axis_scale[a].shift = (int8_t)exponent;
+        g_axis_energy_scale[a] = 1.0f / (lsb * lsb);
+        g_uniform_scale = g_uniform_scale && g_axis_scale[a].fract == g_axis_scale[0].fract &&
+                          g_axis_scale[a].shift == g_axis_scale[0].shift;
+        LOG_INFO("[Inference] Q15 axis %u: %.1f LSB/unit, multiplier %d * 2^%d\n", (unsigned)a, lsb,
+                  (int)g_axis_scale[a].fract, (int)g_axis_scale[a].shift);
+    }
+    return true;
+}
+#elif INFERENCE_INT8_WINDOW
+/**
+ * @brief 浮点样本量化为模型输入
+ */
+static void quantize_samples(const float* samples, int8_t* dst, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        int32_t q = (int32_t)lroundf(samples[i] * g_input_inv_scale) + g_input_zero_point;
+        dst[i] = (int8_t)(q < -128 ? -128 : (q > 127 ? 127 : q));
+    }
+}
+#endif
+
+#if INFERENCE_MULTIRES
+/**
+ * @brief 一步的两帧取平均写入长窗口（两点平均即抽取前的低通，手势的频带远低于抽取后的奈奎斯特频率）
+ * @param values 刚进入窗口的一步（SLIDING_WINDOW_STEP 个值，正好两帧）
+ */
+template <typename T>
+static void decimate_step(const T* values) {
+    for (size_t a = 0; a < EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME; a++) {
+#if INFERENCE_INT8_WINDOW
+        // 两个值共用同一零点，量化域内的平均与浮点平均一致（四舍五入）
+        g_long_window[g_long_head + a] =
+            (int8_t)(((int32_t)values[a] + values[a + EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME] + 1) >> 1);
+#else
+        g_long_window[g_long_head + a] = 0.5f * (values[a] + values[a + EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME]);
+#endif
+    }
+    g_long_head = (g_long_head + EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME) % EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE;
+}
+
+static_assert(SLIDING_WINDOW_STEP == 2 * EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME,
+              "INFERENCE_MULTIRES decimates exactly one step (two frames) into one frame");
+#endif
+
+/**
+ * @brief 滑动窗口：把新样本直接写到最旧数据的位置，只移动 head，不搬移旧数据
+ * @return true 写入成功
+ * @return false 样本队列等待超时，窗口保持不变
+ */
+static bool slide_window() {
+#if INFERENCE_INT8_WINDOW && !INFERENCE_PIPELINED_INPUT
+    imu_sample_t new_samples[SLIDING_WINDOW_STEP];
+    if (!collect_new_samples(new_samples, SLIDING_WINDOW_STEP)) {
+        return false;
+    }
+    // 窗口级的耗时从样本出队后算起（不含等待样本的时间）
+    const uint32_t start_us = hal::now_us();
+    const uint32_t zone_start = profiler_zone_now();
+    record_sample_timing(new_samples);
+#if INFERENCE_WINDOW_NORMALIZE
+    g_window_normalizer.quantize(new_samples, SLIDING_WINDOW_STEP / EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME,
+                                 &g_sliding_window[g_window_head]);
+#else
+    quantize_samples(new_samples, &g_sliding_window[g_window_head], SLIDING_WINDOW_STEP);
+#endif
+#else
+    // 浮点窗口与流水线输入：队列中的样本已是窗口格式，直接出队到窗口
+    if (!collect_new_samples(&g_sliding_window[g_window_head], SLIDING_WINDOW_STEP)) {
+        return false;
+    }
+    const uint32_t start_us = hal::now_us();
+    const uint32_t zone_start = profiler_zone_now();
+    record_sample_timing(&g_sliding_window[g_window_head]);
+#endif
+#if INFERENCE_MULTIRES
+    decimate_step(&g_sliding_window[g_window_head]);
+#endif
+#if INFERENCE_RESULT_MEMO
+    g_window_memo.on_step(g_sliding_window, g_window_head, SLIDING_WINDOW_STEP);
+#endif
+    if (g_window_new_values < EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE) {
+        g_window_new_values += SLIDING_WINDOW_STEP;
+    }
+    g_frames_consumed += SLIDING_WINDOW_STEP / EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME;
+    advance_batch_marks();
+
+    g_window_head = (g_window_head + SLIDING_WINDOW_STEP) % EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE;
+    pipeline_module_record(PIPELINE_WINDOW, start_us);
+    profiler_zone_record(ZONE_WINDOW, zone_start);
+    return true;
+}
+
+#if INFERENCE_INT8_WINDOW
+/**
+ * @brief 直接对量化窗口运行编译后的模型
+ * 流式推理时只计算上次推理以来新进入窗口的时间列，否则按时间顺序写入输入张量后完整推理
+ * @param out_scores 输出各类别概率
+ */
+static bool invoke_job(void* arg) {
+#if INFERENCE_TCN_ENGINE
+    if (tcn_module_ready()) {
+        return tcn_module_stream_invoke(g_sliding_window, g_window_head, g_window_new_values,
+                                        static_cast<float*>(arg), EI_CLASSIFIER_LABEL_COUNT);
+    }
+#endif
+    return model_module_stream_invoke(g_sliding_window, g_window_head, g_window_new_values,
+                                      static_cast<float*>(arg), EI_CLASSIFIER_LABEL_COUNT);
+}
+
+static bool classify_window(float* out_scores) {
+    ProfilerZoneScope zone(ZONE_CLASSIFY);
+    const uint32_t start_us = hal::now_us();
+    if (!core1_module_run(invoke_job, out_scores)) {
+        if (!g_cancel_hit) {
+            LOG_ERROR("[Inference] Model invoke failed\n");
+        }
+        return false;
+    }
+    g_run_dsp_us = 0;
+    g_run_classify_us = hal::now_us() - start_us;
+    g_window_new_values = 0;
+    return true;
+}
+
+#if INFERENCE_POSTPROCESS_INT8
+/**
+ * @brief 同 classify_window，但 argmax 与阈值判定在 int8 域完成，只反量化获胜类别与第二名
+ * @param out_top 输出结果（index 在低于阈值时为 -1）
+ */
+static bool invoke_top_job(void* arg) {
+    return model_module_stream_invoke_top(g_sliding_window, g_window_head, g_window_new_values,
+                                          g_min_score_q, static_cast<model_top_result_t*>(arg));
+}
+
+static bool classify_window_top(model_top_result_t* out_top) {
+    ProfilerZoneScope zone(ZONE_CLASSIFY);
+    const uint32_t start_us = hal::now_us();
+    if (!core1_module_run(invoke_top_job, out_top)) {
+        if (!g_cancel_hit) {
+            LOG_ERROR("[Inference] Model invoke failed\n");
+        }
+        return false;
+    }
+    g_run_dsp_us = 0;
+    g_run_classify_us = hal::now_us() - start_us;
+    g_window_new_values = 0;
+    return true;
+}
+#endif
+
+#if INFERENCE_MULTIRES
+/**
+ * @brief 长窗口按时间顺序写入输入张量后运行完整的图（不经过流式缓存，原窗口的缓存保持有效）
+ */
+static bool long_invoke_job(void* arg) {
+    size_t length = 0;
+    int8_t* input = model_module_input_buffer(&length);
+    if (input == nullptr || length != EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE) {
+        return false;
+    }
+    const size_t tail = EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE - g_long_head;
+    memcpy(input, &g_long_window[g_long_head], tail);
+    memcpy(input + tail, g_long_window, g_long_head);
+    return model_module_invoke(static_cast<float*>(arg), EI_CLASSIFIER_LABEL_COUNT);
+}
+
+static bool classify_long_window(float* out_scores) {
+    ProfilerZoneScope zone(ZONE_CLASSIFY);
+    return core1_module_run(long_invoke_job, out_scores);
+}
+#endif
+#else
+/**
+ * @brief 从环形窗口的 start 处起按时间顺序复制 length 个值，自行处理回绕
+ */
+static void window_copy(size_t start, size_t length, float* out_ptr) {
+    size_t first = EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE - start;
+    if (first > length) {
+        first = length;
+    }
+
+    memcpy(out_ptr, &g_sliding_window[start], first * sizeof(float));
+    memcpy(out_ptr + first, g_sliding_window, (length - first) * sizeof(float));
+}
+
+/**
+ * @brief signal_t 回调：按时间顺序读取窗口中最新的 g_window_new_values 个值
+ */
+static int window_get_data(size_t offset, size_t length, float* out_ptr) {
+    const size_t oldest_new = EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE - g_window_new_values;
+    window_copy((g_window_head + oldest_new + offset) % EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE, length, out_ptr);
+    return 0;
+}
+
+#if INFERENCE_MULTIRES
+/**
+ * @brief signal_t 回调：从最旧的帧起按时间顺序读取长窗口
+ */
+static int long_window_get_data(size_t offset, size_t length, float* out_ptr) {
+    const size_t start = (g_long_head + offset) % EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE;
+    size_t first = EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE - start;
+    if (first > length) {
+        first = length;
+    }
+    memcpy(out_ptr, &g_long_window[start], first * sizeof(float));
+    memcpy(out_ptr + first, g_long_window, (length - first) * sizeof(float));
+    return 0;
+}
+#endif
+
+#if INFERENCE_SHARED_IMPULSES || INFERENCE_SHADOW_MODEL
+/**
+ * @brief signal_t 回调：从最旧的样本起按时间顺序读取整个窗口
+ */
+static int window_get_all(size_t offset, size_t length, float* out_ptr) {
+    window_copy((g_window_head + offset) % EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE, length, out_ptr);
+    return 0;
+}
+#endif
+
+#if INFERENCE_SHARED_IMPULSES
+
+struct shared_classifier_job_t {
+    signal_t* signal;
+    int err;
+};
+
+static bool shared_classifier_job(void* arg) {
+    shared_classifier_job_t* job = static_cast<shared_classifier_job_t*>(arg);
+    job->err = run_classifier_shared(g_model_handles, kModelCount, job->signal, g_model_results, false);
+    return job->err == EI_IMPULSE_OK;
+}
+
+/**
+ * @brief 记录当前模型以外各模型本步的结果与耗时（当前模型由 run_inference 记录）
+ * @param active 当前模型序号
+ */
+static void record_shared_results(size_t active) {
+    lock_from_inference();
+    for (size_t m = 0; m < kModelCount; m++) {
+        if (m == active) {
+            continue;
+        }
+        const ei_impulse_result_t& result = g_model_results[m];
+        int index = -1;
+        float confidence = 0.0f;
+        for (size_t i = 0; i < g_models[m].handle->impulse->label_count; i++) {
+            if (result.classification[i].value > confidence) {
+                confidence = result.classification[i].value;
+                index = (int)i;
+            }
+        }
+        g_model_last_index[m] = confidence < INFERENCE_MIN_CONFIDENCE ? -1 : index;
+        g_model_last_confidence[m] = confidence;
+        const uint32_t elapsed_us = (uint32_t)(result.timing.dsp_us + result.timing.classification_us);
+        g_model_invokes[m]++;
+        g_model_total_us[m] += elapsed_us;
+        if (elapsed_us > g_model_max_us[m]) {
+            g_model_max_us[m] = elapsed_us;
+        }
+    }
+    g_inference_mutex.unlock();
+}
+#endif
+
+struct classifier_job_t {
+    ei_impulse_handle_t* handle;
+    signal_t* signal;
+    ei_impulse_result_t* result;
+    int err;
+};
+
+static bool classifier_job(void* arg) {
+    classifier_job_t* job = static_cast<classifier_job_t*>(arg);
+    job->err = run_classifier_continuous(job->handle, job->signal, job->result, false);
+    return job->err == EI_IMPULSE_OK;
+}
+
+/**
+ * @brief 通过 run_classifier_continuous 对当前窗口分类
+ * 只把上次推理以来的新样本交给分类器，由它滚动自己的特征窗口；该路径不做任何堆分配
+ * （分类结果、原始输出与特征矩阵都是静态的，张量 arena 由 EI_CLASSIFIER_ALLOCATION_STATIC 静态分配），
+ * RAM 预算中的 DSP heap 一行给出实际的分配次数。
+ * INFERENCE_SHARED_IMPULSES 构建改用 run_classifier_shared 在整个窗口上运行所有模型
+ * @param out_scores 输出当前模型的各类别概率
+ */
+static bool classify_window(float* out_scores) {
+    ProfilerZoneScope zone(ZONE_CLASSIFY);
+    if (memory_module_arena_lent()) {
+        LOG_WARN("[Inference] Tensor arena is lent out, skipping classification\n");
+        return false;
+    }
+
+#if INFERENCE_SHARED_IMPULSES
+    // 整个窗口交给所有模型，相同的 DSP 块只算一次，当前模型的分数进入手势管线
+    signal_t signal;
+    signal.total_length = EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE;
+    signal.get_data = &window_get_all;
+
+    shared_classifier_job_t job = {&signal, EI_IMPULSE_OK};
+    memory_module_dsp_begin();
+    core1_module_run(shared_classifier_job, &job);
+    memory_module_dsp_end();
+    if (job.err != EI_IMPULSE_OK) {
+        if (job.err != EI_IMPULSE_CANCELED) {
+            LOG_ERROR("[Inference] Shared classifier failed (err: %d)\n", job.err);
+        }
+        return false;
+    }
+    g_window_new_values = 0;
+    g_run_dsp_us = 0;
+    g_run_classify_us = 0;
+    for (size_t m = 0; m < kModelCount; m++) {
+        g_run_dsp_us += (uint32_t)g_model_results[m].timing.dsp_us;
+        g_run_classify_us += (uint32_t)g_model_results[m].timing.classification_us;
+    }
+
+    const size_t active = g_active_model;
+    record_shared_results(active);
+    for (size_t i = 0; i < g_models[active].handle->impulse->label_count; i++) {
+        out_scores[i] = g_model_results[active].classification[i].value;
+    }
+    return true;
+#else
+    // 准备信号数据（直接从环形窗口读取，无需先拼接成连续缓冲区）
+    signal_t signal;
+    signal.total_length = g_window_new_values;
+    signal.get_data = &window_get_data;
+
+    // 运行分类器（双核时在核 1 上运行，结果与错误码由作业写回）
+    ei_impulse_result_t result = {0};
+    classifier_job_t job = {g_models[g_active_model].handle, &signal, &result, EI_IMPULSE_OK};
+    ei_impulse_handle_t* handle = job.handle;
+    memory_module_dsp_begin();
+    core1_module_run(classifier_job, &job);
+    memory_module_dsp_end();
+    if (job.err != EI_IMPULSE_OK) {
+        if (job.err != EI_IMPULSE_CANCELED) {
+            LOG_ERROR("[Inference] Classifier failed (err: %d)\n", job.err);
+        }
+        return false;
+    }
+    g_window_new_values = 0;
+    g_run_dsp_us = (uint32_t)result.timing.dsp_us;
+    g_run_classify_us = (uint32_t)result.timing.classification_us;
+
+    for (size_t i = 0; i < handle->impulse->label_count; i++) {
+        out_scores[i] = result.classification[i].value;
+    }
+    return true;
+#endif
+}
+#endif
+
+/**
+ * @brief 把本次推理的分数放入分数队列（运行了 CNN 时直接取输出张量；队列满时丢弃并计数）
+ * @param scores 反量化后的分数；为 nullptr 时直接复制输出张量（int8 路径）
+ * @param skipped_index 未运行 CNN 时判定的类别（idle 预筛），否则为 -1
+ */
+static void record_scores(const float* scores, int skipped_index) {
+    if (!pipeline_module_subscribed(PIPELINE_OUTPUT_SCORES)) {
+        return;
+    }
+    inference_scores_t entry;
+    entry.sequence = g_inference_count;
+    float scale;
+    int32_t zero_point;
+    model_module_get_output_quantization(&scale, &zero_point);
+    if (scores == nullptr && skipped_index < 0) {
+        if (model_module_output_scores(entry.scores, GESTURE_LABEL_COUNT) != GESTURE_LABEL_COUNT) {
+            return;
+        }
+    } else {
+        // 浮点路径由 run_classifier 反量化；按输出张量的量化参数取回原来的 int8 分数
+        for (size_t i = 0; i < GESTURE_LABEL_COUNT; i++) {
+            const float p = scores ? scores[i] : ((int)i == skipped_index ? 1.0f : 0.0f);
+            const int32_t q = scale > 0.0f ? (int32_t)lroundf(p / scale) + zero_point : -128;
+            entry.scores[i] = (int8_t)(q < -128 ? -128 : (q > 127 ? 127 : q));
+        }
+    }
+    g_score_queue.push(&entry, 1);
+}
+
+/**
+ * @brief 窗口样本流的通道顺序：按板坐标系通道升序排列的融合轴下标，重复的通道只取第一个
+ * @param out_order 输出融合轴下标（至少 IMU_MAX_AXES 个）
+ * @param out_mask 输出通道位图（可为 nullptr）
+ * @return size_t 通道数
+ */
+static size_t window_stream_order(uint8_t* out_order, uint8_t* out_mask) {
+    const size_t axes = g_imu.axis_count();
+    uint8_t mask = 0;
+    size_t count = 0;
+    for (uint8_t channel = 0; channel < IMU_MAX_AXES; channel++) {
+        for (size_t axis = 0; axis < axes; axis++) {
+            if (g_imu.axis_channel(axis) == channel) {
+                out_order[count++] = (uint8_t)axis;
+                mask |= (uint8_t)(1u << channel);
+                break;
+            }
+        }
+    }
+    if (out_mask) {
+        *out_mask = mask;
+    }
+    return count;
+}
+
+/**
+ * @brief 级联第一级：窗口足够平稳时判定为确定的 idle
+ */
+static bool window_is_idle() {
+#if INFERENCE_IDLE_PREFILTER
+    if (g_idle_index < 0) {
+        return false;
+    }
+#if INFERENCE_WINDOW_NORMALIZE
+    // 标准化后的窗口不再带幅度：直接用标准化级维护的各轴方差（换算回物理单位）
+    float variances[EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME];
+    for (size_t a = 0; a < EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME; a++) {
+        const float lsb = g_imu.axis_lsb(a);
+        variances[a] = g_window_normalizer.variance(a) / (lsb * lsb);
+    }
+    return g_idle_prefilter.check_variances(variances, EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME);
+#elif INFERENCE_INT8_WINDOW
+    return g_idle_prefilter.check(g_sliding_window, EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE,
+                                  EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME, 1.0f / g_input_inv_scale);
+#else
+    return g_idle_prefilter.check(g_sliding_window, EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE,
+                                  EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME, 1.0f);
+#endif
+#else
+    return false;
+#endif
+}
+
+#if INFERENCE_NOVELTY_DETECTION
+/**
+ * @brief 级联最后一级：本次窗口的倒数第二层激活离所有聚类中心都太远时判为分布外
+ * 只在 CNN 判为手势后调用（idle 与 uncertain 结果不需要拒绝）
+ */
+static bool window_is_novel() {
+    size_t first_column = 0;
+    const int8_t* features = model_module_stream_features(&first_column, nullptr, nullptr);
+    if (features == nullptr) {
+        return false;
+    }
+    return g_novelty.check(reinterpret_cast<const int8_t(*)[NOVELTY_MODEL_CHANNELS]>(features), first_column);
+}
+#endif
+
+#if INFERENCE_FEWSHOT
+/**
+ * @brief 与 softmax 头并行的自定义手势：本次窗口的倒数第二层激活落在某个自定义类别的半径内时返回该类别
+ * 录入期间 CNN 没有判为 idle 的窗口计入正在录入的类别（新颖性检测拒绝的窗口也算：新手势多半在分布外）
+ */
+static int window_custom_gesture(int max_index) {
+    size_t first_column = 0;
+    const int8_t* features = model_module_stream_features(&first_column, nullptr, nullptr);
+    const bool active = max_index < 0 || max_index != g_idle_index;
+    return fewshot_module_update(features, first_column, active);
+}
+#endif
+
+#if INFERENCE_EVENT_MODE == INFERENCE_EVENTS_PERFCAL
+/**
+ * @brief 按当前模型与细步长配置事件检测（调用者持有 g_stride_mutex）
+ * 平均窗口与抑制时间按细步长折算为结果个数，折算方式与 PerfCal 相同（不足一次结果时取 1 / 0）
+ */
+static void configure_event_detector() {
+    const float period_ms = g_fine_stride_samples * 1000.0f / EI_CLASSIFIER_FREQUENCY;
+    const size_t average = INFERENCE_EVENT_AVERAGE_MS < period_ms ? 1 : (size_t)(INFERENCE_EVENT_AVERAGE_MS / period_ms);
+    const uint32_t suppression =
+        INFERENCE_EVENT_SUPPRESSION_MS < period_ms ? 0 : (uint32_t)(INFERENCE_EVENT_SUPPRESSION_MS / period_ms);
+    const size_t labels = g_models[g_active_model].handle->impulse->label_count;
+    // 除 idle 外的类别都是手势事件
+    uint32_t event_mask = (1u << labels) - 1;
+    if (g_idle_index >= 0) {
+        event_mask &= ~(1u << g_idle_index);
+    }
+    g_event_detector.configure(labels, average, INFERENCE_EVENT_THRESHOLD, suppression, event_mask);
+}
+#endif
+
+#if INFERENCE_EVENT_MODE == INFERENCE_EVENTS_SEGMENTS
+/**
+ * @brief 按当前模型配置手势分段状态机（除 idle 外的类别都是手势）
+ */
+static void configure_segmenter() {
+    const size_t labels = g_models[g_active_model].handle->impulse->label_count;
+    uint32_t gesture_mask = (1u << labels) - 1;
+    if (g_idle_index >= 0) {
+        gesture_mask &= ~(1u << g_idle_index);
+    }
+    g_segmenter.configure(gesture_mask, INFERENCE_SEGMENT_ONSET_CONFIDENCE, INFERENCE_SEGMENT_RELEASE_CONFIDENCE,
+                          INFERENCE_SEGMENT_CONFIRM_RESULTS, INFERENCE_SEGMENT_RELEASE_RESULTS,
+                          INFERENCE_SEGMENT_REFRACTORY_MS, INFERENCE_SEGMENT_MAX_MS);
+    // 复位的状态机不会再报告正在进行的手势结束：这里代为释放（随后的 inference_clear_result() 唤醒消费者）
+    lock_from_inference();
+    if (g_segment_state.held) {
+        g_segment_state.held = false;
+        g_segment_state.changes++;
+    }
+    g_inference_mutex.unlock();
+}
+#endif
+
+#if INFERENCE_MULTIRES
+/**
+ * @brief 融合两种分辨率的分数：非 idle 类别取较大的概率，idle 取较小的，再归一化
+ * 任一分辨率看到的手势都能胜出；长窗口的一次结果最多融合进随后两次原窗口的结果（它隔一次推理运行）
+ * @param scores 原窗口的各类别概率，原地更新
+ * @param count 类别数
+ */
+static void fuse_long_scores(float* scores, size_t count) {
+    if (g_long_uses == 0) {
+        return;
+    }
+    g_long_uses--;
+
+    int native_index = -1;
+    int fused_index = -1;
+    float native_max = 0.0f;
+    float fused_max = 0.0f;
+    float sum = 0.0f;
+    for (size_t i = 0; i < count; i++) {
+        if (scores[i] > native_max) {
+            native_max = scores[i];
+            native_index = (int)i;
+        }
+        const bool is_idle = (int)i == g_idle_index;
+        const float other = g_long_scores[i];
+        scores[i] = is_idle ? (other < scores[i] ? other : scores[i]) : (other > scores[i] ? other : scores[i]);
+        sum += scores[i];
+    }
+    if (sum <= 0.0f) {
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        scores[i] /= sum;
+        if (scores[i] > fused_max) {
+            fused_max = scores[i];
+            fused_index = (int)i;
+        }
+    }
+    if (fused_index != native_index) {
+        g_long_wins++;
+    }
+}
+
+/**
+ * @brief 在长窗口上运行一次模型，保存分数供随后的原窗口结果融合
+ * 只在推理线程已追上样本（队列中没有完整的下一步）时运行，不推迟任何到期的原窗口推理；
+ * 否则留到下一个空闲的步，峰值延迟仍只有一次推理。运行中原窗口到期时在下一个检查点让路（同样计为推迟）
+ */
+static void run_long_pass() {
+    if (!g_long_due) {
+        return;
+    }
+    if (g_sample_ring.size() >= SLIDING_WINDOW_STEP) {
+        g_long_deferred++;
+        return;
+    }
+    g_long_due = false;
+
+    const uint32_t start_us = hal::now_us();
+    float scores[INFERENCE_MAX_LABELS] = {0};
+    cancel_arm(true);
+#if INFERENCE_INT8_WINDOW
+    const bool ok = classify_long_window(scores);
+#else
+    bool ok = !memory_module_arena_lent();
+    if (ok) {
+        ProfilerZoneScope zone(ZONE_CLASSIFY);
+        signal_t signal;
+        signal.total_length = EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE;
+        signal.get_data = &long_window_get_data;
+        ei_impulse_result_t result = {};
+        memory_module_dsp_begin();
+        ok = run_classifier(g_models[g_active_model].handle, &signal, &result, false) == EI_IMPULSE_OK;
+        memory_module_dsp_end();
+        for (size_t i = 0; ok && i < g_models[g_active_model].handle->impulse->label_count; i++) {
+            scores[i] = result.classification[i].value;
+        }
+    }
+#endif
+    if (cancel_disarm()) {
+        g_long_due = true;
+        g_long_deferred++;
+        return;
+    }
+    if (!ok) {
+        LOG_WARN("[Inference] Long window pass failed\n");
+        return;
+    }
+    const uint32_t elapsed_us = hal::now_us() - start_us;
+    memcpy(g_long_scores, scores, sizeof(g_long_scores));
+    g_long_uses = 2;
+    g_long_runs++;
+    g_long_total_us += elapsed_us;
+    if (elapsed_us > g_long_max_us) {
+        g_long_max_us = elapsed_us;
+    }
+}
+#endif
+
+#if INFERENCE_SHADOW_MODEL
+/**
+ * @brief 生产模型在一个窗口上运行过 CNN：每 INFERENCE_SHADOW_EVERY 个这样的窗口让候选模型在同一窗口上运行一次
+ */
+static void shadow_schedule(size_t active) {
+    if (g_shadow_countdown > 1) {
+        g_shadow_countdown--;
+        return;
+    }
+    g_shadow_due = true;
+    g_shadow_production_index = g_model_last_index[active];
+    g_shadow_production_confidence = g_model_last_confidence[active];
+}
+
+/**
+ * @brief 一个周期的对比写入诊断日志并打印（推理线程，不持锁）
+ */
+static void shadow_report(size_t active, const shadow_counts_t& counts, uint32_t deferred, uint64_t total_us,
+                          uint32_t max_us) {
+    const uint32_t mean_us = counts.runs > 0 ? (uint32_t)(total_us / counts.runs) : 0;
+    LOG_INFO("[Inference] Shadow model %u vs %u: %lu windows, %lu agree, %lu candidate only, %lu production only, "
+              "%lu differ, %lu deferred, mean %lu us, max %lu us\n",
+              (unsigned)INFERENCE_SHADOW_MODEL, (unsigned)active, (unsigned long)counts.runs,
+              (unsigned long)counts.agree, (unsigned long)counts.candidate_only,
+              (unsigned long)counts.production_only, (unsigned long)counts.differ, (unsigned long)deferred,
+              (unsigned long)mean_us, (unsigned long)max_us);
+#if TELEMETRY_ENABLE
+    telemetry_shadow_t record;
+    record.candidate = (uint8_t)INFERENCE_SHADOW_MODEL;
+    record.production = (uint8_t)active;
+    record.runs = (uint16_t)counts.runs;
+    record.agree = (uint16_t)counts.agree;
+    record.candidate_only = (uint16_t)counts.candidate_only;
+    record.production_only = (uint16_t)counts.production_only;
+    record.differ = (uint16_t)counts.differ;
+    record.deferred = (uint16_t)(deferred > 0xFFFF ? 0xFFFF : deferred);
+    record.reserved = 0;
+    record.mean_us = mean_us;
+    record.max_us = max_us;
+    telemetry_module_record(TELEMETRY_SHADOW, &record, sizeof(record));
+    for (uint8_t candidate = 0; candidate < 2; candidate++) {
+        const uint32_t* bins = candidate ? counts.candidate_bins : counts.production_bins;
+        telemetry_shadow_histogram_t histogram;
+        histogram.model = (uint8_t)(candidate ? INFERENCE_SHADOW_MODEL : active);
+        histogram.candidate = candidate;
+        histogram.reserved = 0;
+        for (size_t b = 0; b < SHADOW_HISTOGRAM_BINS; b++) {
+            histogram.bins[b] = (uint16_t)bins[b];
+        }
+        telemetry_module_record(TELEMETRY_SHADOW_HISTOGRAM, &histogram, sizeof(histogram));
+    }
+#endif
+}
+
+/**
+ * @brief 在空闲时间里让候选模型对刚分类的窗口运行一次，与生产模型的判定对比
+ * 与长窗口相同：只在推理线程已追上样本时运行，运行中下一步到期时在检查点让路；让路的窗口不再补跑
+ * （窗口随即滑动，生产模型的判定不再对应），下一个运行过 CNN 的窗口接着到期。
+ * 候选模型按整窗计算 DSP（run_classifier），不改动生产模型连续分类器的特征窗口
+ */
+static void run_shadow_pass() {
+    if (!g_shadow_due) {
+        return;
+    }
+    g_shadow_due = false;
+    const size_t active = g_active_model;
+    if (active == INFERENCE_SHADOW_MODEL) {
+        // 候选模型已被切换为当前模型，没有可对比的
+        return;
+    }
+    bool ok = g_sample_ring.size() < SLIDING_WINDOW_STEP && !memory_module_arena_lent();
+    if (!ok) {
+        g_shadow_deferred.add();
+        lock_from_inference();
+        g_shadow_period_deferred++;
+        g_inference_mutex.unlock();
+        return;
+    }
+
+    const uint32_t start_us = hal::now_us();
+    const ei_impulse_handle_t* handle = g_models[INFERENCE_SHADOW_MODEL].handle;
+    ei_impulse_result_t result = {};
+    signal_t signal;
+    signal.total_length = EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE;
+    signal.get_data = &window_get_all;
+    cancel_arm(true);
+    memory_module_dsp_begin();
+    ok = run_classifier(g_models[INFERENCE_SHADOW_MODEL].handle, &signal, &result, false) == EI_IMPULSE_OK;
+    memory_module_dsp_end();
+    const bool canceled = cancel_disarm();
+    const uint32_t elapsed_us = hal::now_us() - start_us;
+    if (!ok && !canceled) {
+        LOG_WARN("[Inference] Shadow model pass failed\n");
+        return;
+    }
+
+    int index = -1;
+    float confidence = 0.0f;
+    for (size_t i = 0; ok && i < handle->impulse->label_count; i++) {
+        if (result.classification[i].value > confidence) {
+            confidence = result.classification[i].value;
+            index = (int)i;
+        }
+    }
+    if (confidence < INFERENCE_MIN_CONFIDENCE) {
+        index = -1;
+    }
+
+    if (canceled) {
+        g_shadow_deferred.add();
+    } else {
+        g_shadow_time_us.record(elapsed_us);
+    }
+    lock_from_inference();
+    if (canceled) {
+        g_shadow_period_deferred++;
+        g_inference_mutex.unlock();
+        return;
+    }
+    g_shadow_tally.add(g_shadow_production_index, g_shadow_production_confidence, index, confidence);
+    g_shadow_total_us += elapsed_us;
+    g_shadow_period_us += elapsed_us;
+    if (elapsed_us > g_shadow_period_max_us) {
+        g_shadow_period_max_us = elapsed_us;
+    }
+    // 候选模型的最近结果与耗时同样出现在串口 "model" 中
+    g_model_last_index[INFERENCE_SHADOW_MODEL] = index;
+    g_model_last_confidence[INFERENCE_SHADOW_MODEL] = confidence;
+    g_model_invokes[INFERENCE_SHADOW_MODEL]++;
+    g_model_total_us[INFERENCE_SHADOW_MODEL] += elapsed_us;
+    if (elapsed_us > g_model_max_us[INFERENCE_SHADOW_MODEL]) {
+        g_model_max_us[INFERENCE_SHADOW_MODEL] = elapsed_us;
+    }
+    const bool report_due = g_shadow_tally.period().runs >= INFERENCE_SHADOW_REPORT_RUNS;
+    shadow_counts_t period;
+    uint32_t period_deferred = 0;
+    uint64_t period_us = 0;
+    uint32_t period_max_us = 0;
+    if (report_due) {
+        period = g_shadow_tally.period();
+        period_deferred = g_shadow_period_deferred;
+        period_us = g_shadow_period_us;
+        period_max_us = g_shadow_period_max_us;
+        g_shadow_tally.reset_period();
+        g_shadow_period_deferred = 0;
+        g_shadow_period_us = 0;
+        g_shadow_period_max_us = 0;
+    }
+    g_inference_mutex.unlock();
+    g_shadow_countdown = INFERENCE_SHADOW_EVERY;
+    if (report_due) {
+        shadow_report(active, period, period_deferred, period_us, period_max_us);
+    }
+}
+#endif
+
+/**
+ * @brief 以当前滑动窗口运行分类器并更新预测结果
+ * @param out_event 输出本次结果（延迟由调用者补上）
+ * @return true 推理成功
+ * @return false 推理失败
+ */
+#if INFERENCE_ONSET_HEAD
+/**
+ * @brief CNN 之前用前缀分类头检查窗口最新的一段：给出临时判定时立即发布并唤醒 BLE 线程，不等本次推理
+ */
+static void check_onset(const ei_impulse_t* impulse) {
+    float probability;
+#if INFERENCE_INT8_WINDOW
+    const int index = g_onset_head.evaluate(g_sliding_window, EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE, g_window_head,
+                                            1.0f / g_input_inv_scale, (float)g_input_zero_point, &probability);
+#else
+    const int index = g_onset_head.evaluate(g_sliding_window, EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE, g_window_head,
+                                            1.0f, 0.0f, &probability);
+#endif
+    if (g_onset_tracker.on_head(index, g_frames_consumed) != OnsetTracker::kProvisional) {
+        return;
+    }
+    const uint32_t sample_ms = (uint32_t)((uint64_t)g_frames_consumed * 1000 / EI_CLASSIFIER_FREQUENCY);
+    lock_from_inference();
+    g_onset_state.index = index;
+    g_onset_state.kind = INFERENCE_ONSET_PROVISIONAL;
+    g_onset_state.confidence_q = inference_quantize_confidence(probability);
+    g_onset_state.onset = g_onset_tracker.onsets();
+    g_onset_state.result_sequence = 0;
+    g_onset_state.sample_ms = sample_ms;
+    g_onset_state.changes++;
+    g_inference_mutex.unlock();
+    g_result_queues[INFERENCE_CONSUMER_BLE].notify();
+    LOG_INFO("[Inference] Onset: %s (%.3f) provisional\n", impulse->categories[index], probability);
+}
+#endif
+
+static bool run_inference(inference_result_event_t* out_event) {
+    ProfilerZoneScope zone(ZONE_INFER);
+    const size_t model = g_active_model;
+    const ei_impulse_t* impulse = g_models[model].handle->impulse;
+    uint32_t elapsed_us = 0;
+    float max_confidence = 0.0f;
+    int max_index = -1;
+#if INFERENCE_EVENT_MODE == INFERENCE_EVENTS_PERFCAL || !INFERENCE_POSTPROCESS_INT8
+    float scores[INFERENCE_MAX_LABELS] = {0};
+#endif
+#if INFERENCE_EVENT_MODE == INFERENCE_EVENTS_PERFCAL
+    bool have_scores = false;
+#endif
+    // 后处理级从分类结果就绪时算起：argmax 与打印、平滑、事件检测和发布
+    uint32_t postprocess_start_us;
+    uint32_t postprocess_zone_start;
+#if INFERENCE_ONSET_HEAD
+    check_onset(impulse);
+#endif
+    if (window_is_idle()) {
+        // 预筛判定为 idle：不运行 CNN（流式缓存与连续分类器会在下一次推理时补上新样本）
+        max_index = g_idle_index;
+        max_confidence = 1.0f;
+        postprocess_start_us = hal::now_us();
+        postprocess_zone_start = profiler_zone_now();
+        record_scores(nullptr, g_idle_index);
+#if INFERENCE_RESULT_MEMO
+    } else if (g_window_memo.lookup(&max_index, &max_confidence)) {
+        // 与上次分类的窗口几乎相同：沿用上次的结果，不运行 CNN（同样由下一次推理补上新样本）
+        postprocess_start_us = hal::now_us();
+        postprocess_zone_start = profiler_zone_now();
+        if (max_index >= 0) {
+            record_scores(nullptr, max_index);
+        }
+#endif
+    } else {
+        const uint32_t start_us = hal::now_us();
+#if INFERENCE_POSTPROCESS_INT8
+        model_top_result_t top;
+        if (!classify_window_top(&top)) {
+            return false;
+        }
+        max_index = top.index;
+        max_confidence = top.confidence;
+        elapsed_us = hal::now_us() - start_us;
+        pipeline_module_record(PIPELINE_INFER, start_us);
+        postprocess_start_us = hal::now_us();
+        postprocess_zone_start = profiler_zone_now();
+        record_scores(nullptr, -1);
+
+        LOG_INFO("--- Prediction: %s %.5f ---\n",
+                  max_index >= 0 ? impulse->categories[max_index] : "unknown", max_confidence);
+#if TELEMETRY_ENABLE
+        // 低于阈值的窗口同样按获胜类别计入逐类别直方图（阈值正是要由这些分布来调）
+        telemetry_module_window(top.top, top.confidence, top.runner_up_confidence, max_index < 0);
+#endif
+#if CAPTURE_ENABLE
+        capture_module_window(g_sliding_window, g_window_head, top.top, top.confidence, top.runner_up,
+                              top.runner_up_confidence);
+#endif
+#else
+        if (!classify_window(scores)) {
+            return false;
+        }
+        elapsed_us = hal::now_us() - start_us;
+        pipeline_module_record(PIPELINE_INFER, start_us);
+        postprocess_start_us = hal::now_us();
+        postprocess_zone_start = profiler_zone_now();
+#if INFERENCE_TCN_ENGINE
+        // TCN 的概率不经过 CNN 的输出张量
+        record_scores(tcn_module_ready() ? scores : nullptr, -1);
+#elif INFERENCE_INT8_WINDOW
+        record_scores(nullptr, -1);
+#else
+        record_scores(scores, -1);
+#endif
+#if INFERENCE_EVENT_MODE == INFERENCE_EVENTS_PERFCAL
+        have_scores = true;
+#endif
+#if INFERENCE_MULTIRES
+        fuse_long_scores(scores, impulse->label_count);
+#endif
+
+        // 打印预测结果，并找到置信度最高的类别
+        LOG_INFO("--- Predictions ---\n");
+        for (size_t i = 0; i < impulse->label_count; i++) {
+            LOG_INFO("  %s: %.5f\n", impulse->categories[i], scores[i]);
+            if (scores[i] > max_confidence) {
+                max_confidence = scores[i];
+                max_index = i;
+            }
+        }
+#if TELEMETRY_ENABLE || CAPTURE_ENABLE
+        int runner_up = -1;
+        for (size_t i = 0; i < impulse->label_count; i++) {
+            if ((int)i != max_index && (runner_up < 0 || scores[i] > scores[runner_up])) {
+                runner_up = (int)i;
+            }
+        }
+        const float runner_up_confidence = runner_up >= 0 ? scores[runner_up] : 0.0f;
+#endif
+#if TELEMETRY_ENABLE
+        telemetry_module_window(max_index, max_confidence, runner_up_confidence,
+                                max_confidence < INFERENCE_MIN_CONFIDENCE);
+#endif
+#if CAPTURE_ENABLE
+        capture_module_window(g_sliding_window, g_window_head, max_index, max_confidence, runner_up,
+                              runner_up_confidence);
+#endif
+        if (max_confidence < INFERENCE_MIN_CONFIDENCE) {
+            max_index = -1;
+        }
+#endif
+#if INFERENCE_NOVELTY_DETECTION
+        if (max_index >= 0 && max_index != g_idle_index && window_is_novel()) {
+            LOG_INFO("[Inference] Novel window rejected: %s (distance %lu > %lu)\n", impulse->categories[max_index],
+                      (unsigned long)g_novelty.distance(), (unsigned long)g_novelty.radius());
+            max_index = -1;
+            max_confidence = 0.0f;
+#if INFERENCE_EVENT_MODE == INFERENCE_EVENTS_PERFCAL
+            for (size_t i = 0; i < INFERENCE_MAX_LABELS; i++) {
+                scores[i] = 0.0f;
+            }
+            have_scores = false;
+#endif
+        }
+#endif
+#if INFERENCE_FEWSHOT
+        const int custom = window_custom_gesture(max_index);
+        if (custom >= 0) {
+            // 自定义手势通过 fewshot_module 的状态发布（BLE 自定义手势特征），内置结果按 uncertain 处理
+            LOG_INFO("[Inference] Custom gesture %d (distance %lu <= %lu) replaces %s\n", custom,
+                      (unsigned long)fewshot_module_distance(), (unsigned long)fewshot_module_radius(),
+                      max_index >= 0 ? impulse->categories[max_index] : "uncertain");
+            max_index = -1;
+            max_confidence = 0.0f;
+#if INFERENCE_EVENT_MODE == INFERENCE_EVENTS_PERFCAL
+            for (size_t i = 0; i < INFERENCE_MAX_LABELS; i++) {
+                scores[i] = 0.0f;
+            }
+            have_scores = false;
+#endif
+        }
+#endif
+#if INFERENCE_RESULT_MEMO
+        g_window_memo.store(g_sliding_window, max_index, max_confidence);
+#endif
+    }
+
+#if INFERENCE_VOTE_SMOOTHING
+    // 以最近若干次结果的多数票代替本次 argmax；之后的事件检测只看到平滑后的类别
+    max_index = g_vote_smoother.update(max_index, max_confidence);
+    max_confidence = max_index >= 0 ? g_vote_smoother.vote_fraction() : 0.0f;
+#if INFERENCE_EVENT_MODE == INFERENCE_EVENTS_PERFCAL
+    for (size_t i = 0; i < INFERENCE_MAX_LABELS; i++) {
+        scores[i] = 0.0f;
+    }
+    have_scores = false;
+#endif
+#endif
+
+    g_stride_mutex.lock();
+#if INFERENCE_EVENT_MODE == INFERENCE_EVENTS_PERFCAL
+    // 只知道获胜类别时（idle 预筛、int8 域后处理）其余类别按 0 计入平均
+    if (!have_scores && max_index >= 0) {
+        scores[max_index] = max_confidence;
+    }
+    const int event_index = g_event_detector.update(scores);
+    const float event_score = g_event_detector.score();
+#endif
+    g_stride_policy.on_result(max_index == g_idle_index, max_confidence);
+    g_stride_mutex.unlock();
+#if INFERENCE_EVENT_MODE == INFERENCE_EVENTS_SEGMENTS
+    // 分段用采样时钟（窗口最新样本的序号折算为毫秒），离线回放时同样有意义
+    const uint32_t sample_ms = (uint32_t)((uint64_t)g_frames_consumed * 1000 / EI_CLASSIFIER_FREQUENCY);
+    const GestureSegmenter::Output segment_output = g_segmenter.update(max_index, max_confidence, sample_ms);
+    const gesture_segment_t& segment = g_segmenter.segment();
+#endif
+#if INFERENCE_ONSET_HEAD
+    const OnsetTracker::Output onset_output = g_onset_tracker.on_result(max_index, g_frames_consumed, g_idle_index);
+#endif
+
+    // 使用互斥锁更新共享变量
+    lock_from_inference();
+    const uint32_t previous_sequence = g_result_sequence;
+#if INFERENCE_EVENT_MODE == INFERENCE_EVENTS_PERFCAL
+    // 只发布检出的事件：序列号只在事件时递增
+    if (event_index >= 0) {
+        g_prediction_index = event_index;
+        g_confidence_q = inference_quantize_confidence(event_score);
+        g_result_sequence++;
+    }
+#elif INFERENCE_EVENT_MODE == INFERENCE_EVENTS_SEGMENTS
+    // 每个手势在确认时发布一次（消费者尽早响应），结束时记录完整的手势事件
+    if (segment_output == GestureSegmenter::kOnset) {
+        g_prediction_index = segment.label;
+        g_confidence_q = inference_quantize_confidence(segment.peak_confidence);
+        g_result_sequence++;
+        g_segment_state.gesture = {segment.label, segment.peak_confidence, segment.start_ms, segment.end_ms};
+        g_segment_state.held = true;
+        g_segment_state.result_sequence = g_result_sequence;
+        g_segment_state.changes++;
+    } else if (segment_output == GestureSegmenter::kOffset) {
+        g_gesture_event.index = segment.label;
+        g_gesture_event.peak_confidence = segment.peak_confidence;
+        g_gesture_event.start_ms = segment.start_ms;
+        g_gesture_event.end_ms = segment.end_ms;
+        g_gesture_sequence++;
+        g_segment_state.gesture = g_gesture_event;
+        g_segment_state.held = false;
+        g_segment_state.changes++;
+    }
+#else
+    // 置信度只在这里量化一次，之后的共享状态、比较与线上记录都是这一字节
+    const uint8_t max_confidence_q = inference_quantize_confidence(max_confidence);
+    const int confidence_delta = (int)max_confidence_q - (int)g_confidence_q;
+    const bool changed =
+        (max_index != g_prediction_index) ||
+        (confidence_delta > g_confidence_step) || (-confidence_delta > g_confidence_step);
+    g_prediction_index = max_index;
+    g_confidence_q = max_confidence_q;
+    if (changed) {
+        g_result_sequence++;
+    }
+#endif
+    g_model_last_index[model] = max_index;
+    g_model_last_confidence[model] = max_confidence;
+    if (elapsed_us > 0) {
+        g_model_invokes[model]++;
+        g_model_total_us[model] += elapsed_us;
+        if (elapsed_us > g_model_max_us[model]) {
+            g_model_max_us[model] = elapsed_us;
+        }
+    }
+    const bool published = g_result_sequence != previous_sequence;
+    if (published) {
+        publish_result(window_arrival_us());
+    }
+#if INFERENCE_ONSET_HEAD
+    if (onset_output != OnsetTracker::kNone) {
+        const bool confirmed = onset_output == OnsetTracker::kConfirmed;
+        g_onset_state.kind = confirmed ? INFERENCE_ONSET_CONFIRMED : INFERENCE_ONSET_CANCELED;
+        g_onset_state.result_sequence = confirmed ? g_result_sequence : 0;
+        g_onset_state.changes++;
+    }
+#endif
+#if TELEMETRY_ENABLE
+    const int published_index = g_prediction_index;
+    const uint8_t published_confidence_q = g_confidence_q;
+    const uint32_t published_sequence = g_result_sequence;
+#endif
+    g_inference_mutex.unlock();
+#if TELEMETRY_ENABLE
+    if (published) {
+#if INFERENCE_EVENT_MODE == INFERENCE_EVENTS_RAW
+        const bool new_gesture = published_index != g_telemetry_last_index;
+        g_telemetry_last_index = published_index;
+#else
+        const bool new_gesture = true;
+#endif
+        // idle 与 uncertain 不记录
+        if (new_gesture && published_index != g_idle_index) {
+            telemetry_module_gesture(published_index, inference_confidence_value(published_confidence_q),
+                                     published_sequence);
+        }
+    }
+#endif
+    if (published) {
+        notify_consumers();
+#if INFERENCE_EVENT_MODE == INFERENCE_EVENTS_SEGMENTS
+    } else if (segment_output == GestureSegmenter::kOffset) {
+        // 手势结束不发布结果：只唤醒 BLE 线程发出释放，按住的手势不必等到下一次轮询
+        g_result_queues[INFERENCE_CONSUMER_BLE].notify();
+#endif
+    }
+#if INFERENCE_ONSET_HEAD
+    if (onset_output != OnsetTracker::kNone) {
+        if (!published) {
+            g_result_queues[INFERENCE_CONSUMER_BLE].notify();
+        }
+        LOG_INFO("[Inference] Onset: %s %s\n", impulse->categories[g_onset_tracker.label()],
+                  onset_output == OnsetTracker::kConfirmed ? "confirmed" : "canceled");
+    }
+#endif
+
+#if INFERENCE_EVENT_MODE == INFERENCE_EVENTS_PERFCAL
+    if (event_index >= 0) {
+        LOG_INFO("[Inference] Event: %s (%.3f)\n", impulse->categories[event_index], event_score);
+    }
+#elif INFERENCE_EVENT_MODE == INFERENCE_EVENTS_SEGMENTS
+    if (segment_output == GestureSegmenter::kOffset) {
+        LOG_INFO("[Inference] Gesture: %s %lu-%lu ms (peak %.3f)\n", impulse->categories[segment.label],
+                  (unsigned long)segment.start_ms, (unsigned long)segment.end_ms, segment.peak_confidence);
+    }
+#endif
+    g_inference_count++;
+    pipeline_module_record(PIPELINE_POSTPROCESS, postprocess_start_us);
+    profiler_zone_record(ZONE_POSTPROCESS, postprocess_zone_start);
+    g_run_postprocess_us = hal::now_us() - postprocess_start_us;
+
+    out_event->index = max_index;
+    out_event->confidence = max_confidence;
+    out_event->frame = g_frames_consumed;
+    out_event->classify_us = elapsed_us;
+    out_event->latency_us = 0;
+    return true;
+}
+
+/**
+ * @brief 记录一次推理各级的耗时（超出本轮次数的丢弃）
+ */
+static void bench_record(uint32_t dsp_us, uint32_t classify_us, uint32_t postprocess_us, uint32_t total_us) {
+    if (g_bench_count >= g_bench_target) {
+        return;
+    }
+    g_bench_us[INFERENCE_BENCH_DSP][g_bench_count] = dsp_us;
+    g_bench_us[INFERENCE_BENCH_CLASSIFY][g_bench_count] = classify_us;
+    g_bench_us[INFERENCE_BENCH_POSTPROCESS][g_bench_count] = postprocess_us;
+    g_bench_us[INFERENCE_BENCH_TOTAL][g_bench_count] = total_us;
+    g_bench_count++;
+}
+
+/**
+ * @brief 结束一轮基准：各级排序取分位数（最近秩），发布结果、唤醒 BLE 线程并打印
+ */
+static void bench_finish(bool ok) {
+    inference_bench_report_t report = {(uint8_t)g_bench_mode,
+                                       (uint8_t)(ok ? INFERENCE_BENCH_DONE : INFERENCE_BENCH_FAILED), g_bench_count, {}};
+    const size_t count = g_bench_count;
+    for (size_t stage = 0; stage < INFERENCE_BENCH_STAGE_COUNT && count > 0; stage++) {
+        uint32_t* values = g_bench_us[stage];
+        // 插入排序：至多 INFERENCE_BENCHMARK_MAX_RUNS 个值，只在一轮结束时排一次
+        for (size_t i = 1; i < count; i++) {
+            const uint32_t value = values[i];
+            size_t j = i;
+            for (; j > 0 && values[j - 1] > value; j--) {
+                values[j] = values[j - 1];
+            }
+            values[j] = value;
+        }
+        inference_bench_stats_t& stats = report.stages[stage];
+        stats.min_us = values[0];
+        stats.p50_us = values[count / 2];
+        stats.p95_us = values[count * 95 / 100];
+        stats.p99_us = values[count * 99 / 100];
+        stats.max_us = values[count - 1];
+    }
+    g_bench_live = false;
+    lock_from_inference();
+    g_bench_report = report;
+    g_bench_version++;
+    g_inference_mutex.unlock();
+    g_result_queues[INFERENCE_CONSUMER_BLE].notify();
+
+    if (!ok) {
+        LOG_ERROR("[Inference] Benchmark failed after %u runs\n", (unsigned)count);
+        return;
+    }
+    LOG_INFO("[Inference] Benchmark (%s, %u runs), us: min / p50 / p95 / p99 / max\n",
+             g_bench_mode == INFERENCE_BENCH_LIVE ? "live" : "synthetic", (unsigned)count);
+    for (size_t stage = 0; stage < INFERENCE_BENCH_STAGE_COUNT; stage++) {
+        const inference_bench_stats_t& stats = report.stages[stage];
+        LOG_INFO("[Inference]   %-11s %7lu %7lu %7lu %7lu %7lu\n", kBenchStageNames[stage],
+                 (unsigned long)stats.min_us, (unsigned long)stats.p50_us, (unsigned long)stats.p95_us,
+                 (unsigned long)stats.p99_us, (unsigned long)stats.max_us);
+    }
+}
+
+/**
+ * @brief 对固定的合成窗口连续分类 runs 次（每次都按完整窗口计算），之后恢复实时窗口
+ * 合成窗口由固定种子的 LCG 生成（与 model_module 的测试输入同一个生成器），每次运行输入相同；
+ * 后处理只计无状态的 argmax 与阈值，平滑、分段与发布不受影响。
+ */
+static bool run_synthetic_benchmark(uint16_t runs) {
+    static decltype(g_sliding_window) live_window;
+    memcpy(live_window, g_sliding_window, sizeof(live_window));
+    const size_t live_head = g_window_head;
+
+    uint32_t seed = 0x12345678u;
+    for (size_t i = 0; i < EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE; i++) {
+        seed = seed * 1664525u + 1013904223u;
+#if INFERENCE_INT8_WINDOW
+        g_sliding_window[i] = (int8_t)(seed >> 24);
+#else
+        // ±2 g
+        g_sliding_window[i] = ((int32_t)(seed >> 16) - 32768) / 16384.0f;
+#endif
+    }
+    g_window_head = 0;
+
+    bool ok = true;
+    for (uint16_t run = 0; run < runs && ok; run++) {
+        watchdog_module_progress();
+        supervisor_module_heartbeat(THREAD_INFERENCE);
+        g_window_new_values = EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE;
+        const uint32_t start_us = hal::now_us();
+        int index = -1;
+        float confidence = 0.0f;
+#if INFERENCE_POSTPROCESS_INT8
+        model_top_result_t top;
+        ok = classify_window_top(&top);
+        const uint32_t classified_us = hal::now_us();
+        index = top.index;
+        confidence = top.confidence;
+#else
+        float scores[INFERENCE_MAX_LABELS] = {0};
+        ok = classify_window(scores);
+        const uint32_t classified_us = hal::now_us();
+        for (size_t i = 0; ok && i < g_models[g_active_model].handle->impulse->label_count; i++) {
+            if (scores[i] > confidence) {
+                confidence = scores[i];
+                index = (int)i;
+            }
+        }
+        if (confidence < INFERENCE_MIN_CONFIDENCE) {
+            index = -1;
+        }
+#endif
+        const uint32_t end_us = hal::now_us();
+        (void)index;
+        if (ok) {
+            bench_record(g_run_dsp_us, g_run_classify_us, end_us - classified_us, end_us - start_us);
+        }
+    }
+
+    // 流式缓存与连续分类器的特征窗口属于合成数据：下一次推理按完整的实时窗口重建
+    memcpy(g_sliding_window, live_window, sizeof(live_window));
+    g_window_head = live_head;
+    g_window_new_values = EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE;
+    return ok;
+}
+
+/**
+ * @brief 在推理线程中开始请求的基准：合成模式当场跑完，实时模式从下一次推理开始记录
+ */
+static void apply_benchmark_request() {
+    lock_from_inference();
+    const bool pending = g_bench_pending;
+    g_bench_pending = false;
+    g_inference_mutex.unlock();
+    if (!pending) {
+        return;
+    }
+    g_bench_count = 0;
+    if (g_bench_mode == INFERENCE_BENCH_LIVE) {
+        LOG_INFO("[Inference] Benchmark: recording the next %u live inferences\n", (unsigned)g_bench_target);
+        g_bench_live = true;
+        return;
+    }
+    bench_finish(run_synthetic_benchmark(g_bench_target));
+}
+
+/**
+ * @brief 记录一次分类的样本到结果延迟
+ * @param event 本次结果，写入延迟（未知时保持 0）
+ */
+static void record_result_latency(inference_result_event_t* event) {
+    const uint32_t arrival_us = window_arrival_us();
+    const uint32_t latency_us = hal::now_us() - arrival_us;
+    latency_module_record(LATENCY_INFERENCE, arrival_us);
+
+    g_scheduler_classified.add();
+    if (arrival_us != 0) {
+        event->latency_us = latency_us;
+        g_latency_total_us += latency_us;
+        g_latency_samples++;
+        g_scheduler_max_latency_us.observe(latency_us);
+    }
+}
+
+/**
+ * @brief 步长策略处于粗步长或运动门控生效时请求 IMU 空闲低速采集，回到细步长时恢复满速（只在变化时通知）
+ */
+static void update_sensor_rate(bool gated) {
+#if IMU_IDLE_ODR_HZ
+    static bool low_rate = false;
+    g_stride_mutex.lock();
+    const bool coarse = g_stride_policy.is_coarse();
+    g_stride_mutex.unlock();
+    if ((gated || coarse) != low_rate) {
+        low_rate = gated || coarse;
+        g_imu.set_low_rate(low_rate);
+    }
+#else
+    (void)gated;
+#endif
+}
+
+/**
+ * @brief 每个统计周期打印一次实测采样率与漂移，便于确认输入与训练采样率一致
+ */
+static void report_sample_rate() {
+    static uint32_t last_report_ms = 0;
+    const uint32_t now_ms = hal::now_ms();
+    if (now_ms - last_report_ms < IMU_RATE_WINDOW_MS) {
+        return;
+    }
+    last_report_ms = now_ms;
+
+    imu_stats_t stats;
+    g_imu.get_stats(&stats);
+    LOG_INFO("[Inference] Sample rate: sensor %.2f Hz, output %.2f Hz (target %d Hz, drift %.0f ppm)\n",
+              stats.sensor_hz, stats.output_hz, (int)EI_CLASSIFIER_FREQUENCY, stats.drift_ppm);
+#if IMU_IDLE_ODR_HZ
+    LOG_INFO("[Inference] Idle sensor rate: %lu switches\n", (unsigned long)stats.rate_switches);
+#endif
+    if (stats.sensor_frames > 0) {
+        LOG_INFO("[Inference] IMU processing: %.2f us per sensor frame\n",
+                  (float)stats.process_us / stats.sensor_frames);
+    }
+    LOG_INFO("[Inference] Sample ring high water %u/%u\n", (unsigned)g_sample_ring.high_water(),
+              (unsigned)g_sample_ring.capacity());
+    // 各级耗时与队列深度（样本队列的窗口峰值与丢弃计数在 window 一行）
+    pipeline_module_report();
+
+    const sample_timing_stats_t timing = g_timing.snapshot_and_reset();
+    g_timing_snapshot.store(timing);
+    inference_scheduler_stats_t scheduler;
+    scheduler.classified = g_scheduler_classified.take();
+    scheduler.skipped = g_scheduler_skipped.take();
+    scheduler.canceled = g_scheduler_canceled.take();
+    scheduler.max_latency_us = g_scheduler_max_latency_us.take();
+    scheduler.mean_latency_us = g_latency_samples > 0 ? (uint32_t)(g_latency_total_us / g_latency_samples) : 0;
+    g_latency_total_us = 0;
+    g_latency_samples = 0;
+    g_scheduler_snapshot.store(scheduler);
+    lock_from_inference();
+    const inference_lock_stats_t lock_stats = g_lock_stats;
+    g_inference_mutex.unlock();
+#if INFERENCE_RADIO_AWARE
+    inference_radio_stats_t radio;
+    inference_get_radio_stats(&radio);
+#endif
+    static uint32_t last_inference_count = 0;
+    g_stride_mutex.lock();
+    const uint8_t stride_steps = g_stride_policy.current_steps();
+    g_stride_mutex.unlock();
+    LOG_INFO("[Inference] Stride: %u samples, %.1f inferences/s\n",
+              (unsigned)(stride_steps * SLIDING_WINDOW_STEP / EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME),
+              (g_inference_count - last_inference_count) * 1000.0f / IMU_RATE_WINDOW_MS);
+    last_inference_count = g_inference_count;
+    LOG_INFO("[Inference] Scheduler: %lu windows classified, %lu stale skipped, %lu canceled, "
+             "latency mean %lu us, max %lu us\n",
+              (unsigned long)scheduler.classified, (unsigned long)scheduler.skipped, (unsigned long)scheduler.canceled,
+              (unsigned long)scheduler.mean_latency_us, (unsigned long)scheduler.max_latency_us);
+    if (lock_stats.contended > 0) {
+        if (lock_stats.max_wait_us > INFERENCE_LOCK_WAIT_BUDGET_US) {
+            LOG_WARN("[Inference] Lock: waited %lu of %lu times, max %lu us over the %u us budget\n",
+                      (unsigned long)lock_stats.contended, (unsigned long)lock_stats.acquisitions,
+                      (unsigned long)lock_stats.max_wait_us, (unsigned)INFERENCE_LOCK_WAIT_BUDGET_US);
+        } else {
+            LOG_INFO("[Inference] Lock: waited %lu of %lu times, max %lu us\n", (unsigned long)lock_stats.contended,
+                      (unsigned long)lock_stats.acquisitions, (unsigned long)lock_stats.max_wait_us);
+        }
+    }
+#if INFERENCE_ONSET_HEAD
+    if (g_onset_tracker.onsets() > 0) {
+        const uint32_t lead_ms =
+            g_onset_tracker.confirmed() > 0
+                ? (uint32_t)(g_onset_tracker.lead_frames_total() * 1000 / EI_CLASSIFIER_FREQUENCY /
+                             g_onset_tracker.confirmed())
+                : 0;
+        LOG_INFO("[Inference] Onset: %lu provisional, %lu confirmed (%lu ms ahead on average), %lu canceled\n",
+                  (unsigned long)g_onset_tracker.onsets(), (unsigned long)g_onset_tracker.confirmed(),
+                  (unsigned long)lead_ms, (unsigned long)g_onset_tracker.canceled());
+    }
+#endif
+#if INFERENCE_RADIO_AWARE
+    if (radio.placed > 0 && radio.control > 0) {
+        LOG_INFO("[Inference] Radio-aware: interval %lu us, event %lu us; %lu placed (%lu deferred, mean %lu us, "
+                 "%lu no fit), p99 %lu us vs %lu us unplaced (%ld us less)\n",
+                  (unsigned long)radio.interval_us, (unsigned long)radio.event_us, (unsigned long)radio.placed,
+                  (unsigned long)radio.deferred, (unsigned long)radio.mean_defer_us, (unsigned long)radio.no_fit,
+                  (unsigned long)radio.placed_p99_us, (unsigned long)radio.control_p99_us,
+                  (long)radio.control_p99_us - (long)radio.placed_p99_us);
+    }
+#endif
+    latency_module_report();
+#if TELEMETRY_ENABLE
+    telemetry_module_latency();
+#endif
+    watchdog_module_report();
+#if INFERENCE_IDLE_PREFILTER
+    LOG_INFO("[Inference] Idle pre-filter: %lu of %lu inferences skipped the CNN\n",
+              (unsigned long)g_idle_prefilter.skipped(), (unsigned long)g_idle_prefilter.evaluated());
+#endif
+#if INFERENCE_RESULT_MEMO
+    const uint32_t memo_checks = g_window_memo.checks();
+    LOG_INFO("[Inference] Result memo: %lu of %lu inferences reused the last result (%.1f%% hit rate)\n",
+              (unsigned long)g_window_memo.hits(), (unsigned long)memo_checks,
+              memo_checks > 0 ? 100.0f * g_window_memo.hits() / memo_checks : 0.0f);
+#endif
+#if INFERENCE_NOVELTY_DETECTION
+    LOG_INFO("[Inference] Novelty: %lu of %lu gesture windows rejected\n",
+              (unsigned long)g_novelty.rejected(), (unsigned long)g_novelty.evaluated());
+#endif
+#if MODEL_EARLY_EXIT
+    model_early_exit_stats_t early_exit;
+    model_module_get_early_exit_stats(&early_exit);
+    if (early_exit.evaluated > 0) {
+        // 每个窗口平均节省 = 退出比例 x（完整推理 - 提前退出）的耗时差
+        const float saved_us = early_exit.full_mean_us > early_exit.early_mean_us
+                                   ? (float)(early_exit.full_mean_us - early_exit.early_mean_us) *
+                                         early_exit.taken / early_exit.evaluated
+                                   : 0.0f;
+        LOG_INFO("[Inference] Early exit: %lu of %lu windows exited after pooling, mean %lu us (full %lu us), "
+                  "%.1f us saved per window\n",
+                  (unsigned long)early_exit.taken, (unsigned long)early_exit.evaluated,
+                  (unsigned long)early_exit.early_mean_us, (unsigned long)early_exit.full_mean_us, saved_us);
+    }
+#endif
+    inference_model_stats_t model_stats;
+    if (inference_get_model_stats(g_active_model, &model_stats) && model_stats.invokes > 0) {
+        LOG_INFO("[Inference] Model %u \"%s\": %lu invokes, mean %lu us, max %lu us\n",
+                  (unsigned)g_active_model, model_stats.name, (unsigned long)model_stats.invokes,
+                  (unsigned long)model_stats.mean_us, (unsigned long)model_stats.max_us);
+    }
+
+#if INFERENCE_MULTIRES
+    LOG_INFO("[Inference] Long window: %lu passes (%lu deferred), mean %lu us, max %lu us, %lu results changed by fusion\n",
+              (unsigned long)g_long_runs, (unsigned long)g_long_deferred,
+              (unsigned long)(g_long_runs > 0 ? g_long_total_us / g_long_runs : 0), (unsigned long)g_long_max_us,
+              (unsigned long)g_long_wins);
+    g_long_runs = 0;
+    g_long_deferred = 0;
+    g_long_total_us = 0;
+    g_long_max_us = 0;
+    g_long_wins = 0;
+#endif
+
+    LOG_INFO("[Inference] Sample timing: %lu samples, mean %lu us, p99 jitter %lu us, max %lu us, "
+              "dropped %lu, duplicated %lu\n",
+              (unsigned long)timing.samples, (unsigned long)timing.mean_interval_us,
+              (unsigned long)timing.p99_jitter_us, (unsigned long)timing.max_jitter_us,
+              (unsigned long)timing.dropped, (unsigned long)timing.duplicated);
+#if ENERGY_INSTRUMENTATION
+    energy_stats_t energy;
+    energy_module_snapshot(scheduler.classified, &energy);
+    const float window_pct = energy.window_us > 0 ? 100.0f / energy.window_us : 0.0f;
+    LOG_INFO("[Energy] CPU active %.1f%% (sampler %.1f%%, inference %.1f%%, ble %.1f%%, led %.1f%%, record %.1f%%, "
+              "log %.1f%%), %.0f uJ, %lu windows, %.1f uJ/window (inference %.1f uJ)\n",
+              energy.active_us * window_pct, energy.thread_us[ENERGY_SAMPLER] * window_pct,
+              energy.thread_us[ENERGY_INFERENCE] * window_pct, energy.thread_us[ENERGY_BLE] * window_pct,
+              energy.thread_us[ENERGY_LED] * window_pct, energy.thread_us[ENERGY_RECORD] * window_pct,
+              energy.thread_us[ENERGY_LOG] * window_pct, energy.energy_uj,
+              (unsigned long)energy.windows, energy.uj_per_window, energy.inference_uj_per_window);
+    if (energy.kernel_idle_valid) {
+        // 内核空闲统计：窗口中既不是已登记线程、也不是空闲线程的时间属于中断 / BLE 协议栈 / 主循环
+        energy_utilization_t utilization;
+        energy_module_utilization(energy, &utilization);
+        LOG_INFO("[Energy] CPU idle %.1f%%, interrupts and unregistered threads %.1f%%\n",
+                  utilization.idle_permille / 10.0f, utilization.other_permille / 10.0f);
+    }
+#endif
+#if MOTION_GATE_ENABLE
+    // 统计窗口结束时结算门控比例并重新计数
+    g_gated_ratio = g_total_us > 0 ? (float)g_gated_us / g_total_us : 0.0f;
+    g_gate_gated_ms.add(g_gated_us / 1000);
+    g_gate_total_ms.add(g_total_us / 1000);
+    LOG_INFO("[Inference] Motion gate: %.1f%% of time gated, %lu motion events\n",
+              g_gated_ratio * 100.0f, (unsigned long)stats.motion_events);
+    g_gated_us = 0;
+#endif
+#if INFERENCE_ARM_SUPPORT
+    g_armed_ratio = g_total_us > 0 ? (float)g_armed_us / g_total_us : 0.0f;
+    LOG_INFO("[Inference] Arm mode: armed %.1f%% of time, %lu arms since boot\n", g_armed_ratio * 100.0f,
+              (unsigned long)g_arm_count);
+    g_armed_us = 0;
+#endif
+    g_total_us = 0;
+}
+
+#if INFERENCE_INT8_WINDOW
+/**
+ * @brief 新颖度检测只对内置权重训练过：权重来自模型槽时关闭
+ */
+static void configure_novelty() {
+#if INFERENCE_NOVELTY_DETECTION
+    size_t feature_columns = 0;
+    size_t feature_channels = 0;
+    model_module_stream_features(nullptr, &feature_columns, &feature_channels);
+    model_slot_status_t slot = {MODEL_SLOT_BUILTIN, 0, 0xFF, 0, 0, 0};
+#if MODEL_OTA_ENABLE
+    model_slot_module_get_status(&slot);
+#endif
+    g_novelty.configure(nullptr, nullptr, 0);
+    if (feature_columns != NOVELTY_MODEL_COLUMNS || feature_channels != NOVELTY_MODEL_CHANNELS) {
+        LOG_ERROR("[Inference] Novelty model shape %ux%u does not match the activations, detector disabled\n",
+                  (unsigned)NOVELTY_MODEL_COLUMNS, (unsigned)NOVELTY_MODEL_CHANNELS);
+    } else if (NOVELTY_MODEL_CLUSTERS == 0) {
+        LOG_WARN("[Inference] Novelty model has no clusters (train it with novelty_trainer.py)\n");
+    } else if (slot.state != MODEL_SLOT_BUILTIN) {
+        LOG_WARN("[Inference] Novelty model was trained for the built-in weights, detector disabled\n");
+    } else {
+        g_novelty.configure(kNoveltyCentroids, kNoveltyRadii, NOVELTY_MODEL_CLUSTERS);
+        LOG_INFO("[Inference] Novelty detector: %u clusters\n", (unsigned)NOVELTY_MODEL_CLUSTERS);
+    }
+#endif
+}
+
+/**
+ * @brief 按模型输入 / 输出张量的量化参数准备样本量化、Q15 乘数与 int8 阈值（启动时与更换权重后调用）
+ */
+static bool configure_quantization() {
+    float input_scale = 1.0f;
+    model_module_get_input_quantization(&input_scale, &g_input_zero_point);
+    g_input_inv_scale = 1.0f / input_scale;
+#if INFERENCE_PIPELINED_INPUT
+    g_window_energy_scale = input_scale * input_scale;
+#endif
+    LOG_INFO("[Inference] INT8 window enabled (scale %.6f, zero point %d)\n",
+              input_scale, (int)g_input_zero_point);
+#if INFERENCE_Q15_FEATURES
+    g_uniform_scale = true;
+    if (!configure_q15_features(input_scale)) {
+        return false;
+    }
+#endif
+#if INFERENCE_POSTPROCESS_INT8
+    g_min_score_q = model_module_quantize_score(INFERENCE_MIN_CONFIDENCE);
+#endif
+#if INFERENCE_WINDOW_NORMALIZE
+    // 标准差下限换算为样本单位；更换权重时保留已累积的窗口统计量
+    float min_std[EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME];
+    for (size_t a = 0; a < EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME; a++) {
+        min_std[a] = INFERENCE_NORMALIZE_MIN_STD * g_imu.axis_lsb(a);
+    }
+    g_window_normalizer.configure(g_input_inv_scale, g_input_zero_point, min_std);
+    LOG_INFO("[Inference] Window normalization: %u frames, min std %.3f\n",
+             (unsigned)EI_CLASSIFIER_RAW_SAMPLE_COUNT, INFERENCE_NORMALIZE_MIN_STD);
+#endif
+#if CAPTURE_ENABLE
+    capture_module_set_quantization(input_scale, g_input_zero_point, INFERENCE_WINDOW_NORMALIZE);
+#endif
+    return true;
+}
+
+/**
+ * @brief TCN 引擎按当前窗口量化核对模型（启动时与更换权重后调用）；未就绪时推理仍用 CNN
+ */
+static void configure_tcn() {
+#if INFERENCE_TCN_ENGINE
+    tcn_module_init(1.0f / g_input_inv_scale, g_input_zero_point);
+#endif
+}
+#endif
+
+/**
+ * @brief 按当前输入量化换算结果记忆的容差（启动时与更换权重后调用，之前的结果作废）
+ */
+static void configure_memo() {
+#if INFERENCE_RESULT_MEMO
+#if INFERENCE_INT8_WINDOW
+    const float tolerance = INFERENCE_MEMO_TOLERANCE_G * g_input_inv_scale;
+#else
+    const float tolerance = INFERENCE_MEMO_TOLERANCE_G;
+#endif
+    g_window_memo.configure(tolerance, INFERENCE_MEMO_MAX_REUSE);
+#endif
+}
+
+#if MODEL_OTA_ENABLE
+/**
+ * @brief 在推理线程中完成模型槽切换（model_slot_module.h），并按新权重的量化参数重新配置输入与后处理
+ * 窗口中已量化的样本换算到新的输入量化；管线化输入时样本环形缓冲中尚未进入窗口的几个样本仍按旧参数量化，
+ * 只影响切换后的第一个窗口。
+ */
+static void apply_model_slot() {
+    if (!model_slot_module_apply()) {
+        return;
+    }
 
-    while (collected < num_samples) {
-        float x, y, z;
-        if (IMU.accelerationAvailable()) {
-            IMU.readAcceleration(x, y, z);
-            buffer[collected++] = x;
-            buffer[collected++] = y;
-            buffer[collected++] = z;
+#if INFERENCE_INT8_WINDOW
+    const float old_scale = 1.0f / g_input_inv_scale;
+    const int32_t old_zero_point = g_input_zero_point;
+    if (!configure_quantization()) {
+        LOG_ERROR("[Inference] New weights do not fit the sample quantization, reverting to built-in weights\n");
+        model_slot_module_request_builtin();
+        return;
+    }
+    configure_novelty();
+#if INFERENCE_FEWSHOT
+    fewshot_module_configure();
+#endif
+    configure_tcn();
+    const float rescale = old_scale * g_input_inv_scale;
+    if (rescale != 1.0f || old_zero_point != g_input_zero_point) {
+        for (size_t i = 0; i < EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE; i++) {
+            const int32_t q = (int32_t)lroundf((g_sliding_window[i] - old_zero_point) * rescale) + g_input_zero_point;
+            g_sliding_window[i] = (int8_t)(q < -128 ? -128 : (q > 127 ? 127 : q));
         }
-        rtos::ThisThread::sleep_for(std::chrono::milliseconds(10));
     }
-
-    return true;
+#else
+    // 连续分类器的平滑状态属于原来的权重
+    run_classifier_init(g_models[g_active_model].handle);
+#endif
+    g_window_new_values = EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE;
+    configure_memo();
+#if INFERENCE_VOTE_SMOOTHING
+    g_vote_smoother.configure(g_models[g_active_model].handle->impulse->label_count, INFERENCE_VOTE_READINGS,
+                              INFERENCE_VOTE_MIN_SAME, INFERENCE_VOTE_CONFIDENCE);
+#endif
+    g_stride_mutex.lock();
+    g_stride_policy.on_result(false, 0.0f);
+    g_stride_mutex.unlock();
+    inference_clear_result();
 }
+#endif
 
 /**
- * @brief 滑动窗口：移动数据并添加新样本
- * @param new_data 新采集的数据
- * @param new_data_size 新数据的大小
+ * @brief 在推理线程中完成模型切换请求
  */
-static void slide_window(const float* new_data, size_t new_data_size) {
-    // 将旧数据向左移动（丢弃最旧的数据）
-    size_t shift_size = EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE - new_data_size;
-    memmove(g_sliding_window, g_sliding_window + new_data_size, shift_size * sizeof(float));
+static void apply_model_switch() {
+    const int requested = g_requested_model;
+    if (requested < 0) {
+        return;
+    }
+    g_requested_model = -1;
+    if ((size_t)requested == g_active_model) {
+        return;
+    }
+
+#if !INFERENCE_INT8_WINDOW
+    // 连续分类器的特征窗口属于上一个模型：复位，并把完整的当前窗口交给新模型
+    run_classifier_init(g_models[requested].handle);
+#endif
+    g_window_new_values = EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE;
+#if INFERENCE_RESULT_MEMO
+    g_window_memo.invalidate();
+#endif
+    g_active_model = (size_t)requested;
+    g_idle_index = g_model_idle_index[requested];
+#if INFERENCE_VOTE_SMOOTHING
+    g_vote_smoother.configure(g_models[requested].handle->impulse->label_count, INFERENCE_VOTE_READINGS,
+                              INFERENCE_VOTE_MIN_SAME, INFERENCE_VOTE_CONFIDENCE);
+#endif
 
-    // 在窗口末尾添加新数据
-    memcpy(g_sliding_window + shift_size, new_data, new_data_size * sizeof(float));
+    g_stride_mutex.lock();
+    g_stride_policy.on_result(false, 0.0f);
+#if INFERENCE_EVENT_MODE == INFERENCE_EVENTS_PERFCAL
+    configure_event_detector();
+#endif
+    g_stride_mutex.unlock();
+#if INFERENCE_EVENT_MODE == INFERENCE_EVENTS_SEGMENTS
+    configure_segmenter();
+#endif
+    inference_clear_result();
+
+    LOG_INFO("[Inference] Switched to model %d \"%s\"\n", requested,
+              g_models[requested].handle->impulse->impulse_name);
 }
 
 /**
- * @brief 运行分类器并更新预测结果
- * @param buffer 输入数据缓冲区
- * @param buffer_size 缓冲区大小
- * @return true 推理成功
- * @return false 推理失败
+ * @brief 确定已发布置信度的量化格式：模型输出张量的 int8 参数换算到 uint8（零点 + 128）
+ * 量化窗口之外不经过 model_module 的输出张量，沿用 1/255
  */
-static bool run_inference(float* buffer, size_t buffer_size) {
-    // 准备信号数据
-    signal_t signal;
-    int err = numpy::signal_from_buffer(buffer, buffer_size, &signal);
-    if (err != 0) {
-        ei_printf("[Inference] Failed to create signal from buffer\n");
-        return false;
+static void configure_confidence_format() {
+#if INFERENCE_INT8_WINDOW
+    float scale = 0.0f;
+    int32_t zero_point = 0;
+    model_module_get_output_quantization(&scale, &zero_point);
+    if (scale > 0.0f && zero_point >= -128 && zero_point <= 127) {
+        g_confidence_format.scale = scale;
+        g_confidence_format.zero_point = (uint8_t)(zero_point + 128);
     }
+#endif
+    g_confidence_inv_scale = 1.0f / g_confidence_format.scale;
+    g_confidence_step = (uint8_t)(0.01f * g_confidence_inv_scale);
+    g_confidence_q = inference_quantize_confidence(0.0f);
+    LOG_INFO("[Inference] Published confidence: scale %.6f, zero point %u\n", g_confidence_format.scale,
+              (unsigned)g_confidence_format.zero_point);
+}
 
-    // 运行分类器
-    ei_impulse_result_t result = {0};
-    err = run_classifier(&signal, &result, false);
-    if (err != EI_IMPULSE_OK) {
-        ei_printf("[Inference] Classifier failed (err: %d)\n", err);
+// ==================== 公共接口实现 ====================
+
+bool inference_module_init() {
+    if (!g_imu.init(EI_CLASSIFIER_FREQUENCY, EI_CLASSIFIER_FUSION_AXES_STRING)) {
+        LOG_ERROR("[Inference] Failed to initialize IMU!\n");
         return false;
     }
 
-    // 打印预测结果
-    ei_printf("--- Predictions ---\n");
-    for (size_t i = 0; i < EI_CLASSIFIER_LABEL_COUNT; i++) {
-        ei_printf("  %s: %.5f\n", result.classification[i].label, result.classification[i].value);
+    if (g_imu.axis_count() != EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME) {
+        LOG_ERROR("[Inference] Axis layout \"%s\" does not match model input (%d values per frame)\n",
+                  EI_CLASSIFIER_FUSION_AXES_STRING, EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME);
+        return false;
     }
 
-    // 找到置信度最高的类别
-    float max_confidence = 0.0f;
-    int max_index = -1;
-    for (size_t i = 0; i < EI_CLASSIFIER_LABEL_COUNT; i++) {
-        if (result.classification[i].value > max_confidence) {
-            max_confidence = result.classification[i].value;
-            max_index = i;
+    LOG_INFO("[Inference] IMU initialized successfully (output %d Hz)\n", (int)EI_CLASSIFIER_FREQUENCY);
+    boot_module_mark(BOOT_IMU_READY);
+    g_timing.set_nominal_interval((uint32_t)(1000000.0f / EI_CLASSIFIER_FREQUENCY));
+
+    // 所有模型共用同一个滑动窗口，输入格式必须一致
+    for (size_t m = 0; m < kModelCount; m++) {
+        const ei_impulse_t* impulse = g_models[m].handle->impulse;
+        if (impulse->frequency != EI_CLASSIFIER_FREQUENCY ||
+            impulse->raw_samples_per_frame != EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME ||
+            impulse->dsp_input_frame_size != EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE ||
+            impulse->label_count > INFERENCE_MAX_LABELS) {
+            LOG_ERROR("[Inference] Model %u \"%s\" does not match the shared window (or exceeds %d labels)\n",
+                      (unsigned)m, impulse->impulse_name, INFERENCE_MAX_LABELS);
+            return false;
         }
+
+        // 结果的消费者只认类别下标，所有模型的类别顺序都必须与类别表一致
+        if (impulse->label_count != GESTURE_LABEL_COUNT) {
+            LOG_ERROR("[Inference] Model %u \"%s\" has %u labels, the label table has %d\n", (unsigned)m,
+                      impulse->impulse_name, (unsigned)impulse->label_count, (int)GESTURE_LABEL_COUNT);
+            return false;
+        }
+        g_model_idle_index[m] = -1;
+        g_model_last_index[m] = -1;
+#if INFERENCE_SHARED_IMPULSES
+        g_model_handles[m] = g_models[m].handle;
+#endif
+        for (size_t i = 0; i < impulse->label_count; i++) {
+            if (strcmp(impulse->categories[i], kGestureLabels[i].name) != 0) {
+                LOG_ERROR("[Inference] Model %u label %u is \"%s\", the label table says \"%s\"\n", (unsigned)m,
+                          (unsigned)i, impulse->categories[i], kGestureLabels[i].name);
+                return false;
+            }
+            if (kGestureLabels[i].kind == GESTURE_KIND_IDLE) {
+                g_model_idle_index[m] = (int)i;
+            }
+        }
+    }
+    g_idle_index = g_model_idle_index[0];
+#if INFERENCE_SHADOW_MODEL
+    g_shadow_tally.configure(g_model_idle_index[INFERENCE_SHADOW_MODEL]);
+    LOG_INFO("[Inference] Shadow mode: model %u \"%s\" on every %d classified windows\n",
+              (unsigned)INFERENCE_SHADOW_MODEL, g_models[INFERENCE_SHADOW_MODEL].handle->impulse->impulse_name,
+              (int)INFERENCE_SHADOW_EVERY);
+#endif
+#if INFERENCE_VOTE_SMOOTHING
+    g_vote_smoother.configure(g_models[0].handle->impulse->label_count, INFERENCE_VOTE_READINGS,
+                              INFERENCE_VOTE_MIN_SAME, INFERENCE_VOTE_CONFIDENCE);
+#endif
+#if INFERENCE_EVENT_MODE == INFERENCE_EVENTS_SEGMENTS
+    configure_segmenter();
+#endif
+    memory_module_register("sliding window", sizeof(g_sliding_window), false);
+    memory_module_register("sample timestamps", sizeof(g_sample_timestamps), false);
+#if INFERENCE_MULTIRES
+    memory_module_register("long window", sizeof(g_long_window), false);
+#endif
+#if INFERENCE_RESULT_MEMO
+    memory_module_register("result memo", sizeof(g_window_memo), false);
+#endif
+    memory_module_register("sample ring", sizeof(g_sample_ring), false);
+    memory_module_register("score queue", sizeof(g_score_queue), false);
+    memory_module_register("window stream queue", sizeof(g_window_queue), false);
+    memory_module_register("sample batch marks", sizeof(g_batch_marks), false);
+    memory_module_register("benchmark samples", sizeof(g_bench_us), false);
+#if INFERENCE_SHARED_IMPULSES
+    memory_module_register("shared model results", sizeof(g_model_results), false);
+    memory_module_register("shared DSP features", EI_CLASSIFIER_SHARED_MAX_FEATURES * sizeof(float), false);
+#endif
+#if INFERENCE_SHADOW_MODEL
+    memory_module_register("shadow tally", sizeof(g_shadow_tally), false);
+#endif
+    // SDK 移植层中 ei_printf 的静态格式化缓冲区
+    memory_module_register("ei_printf buffer", 1024, false);
+    // 初始化失败重试时不重复登记
+    if (!g_stats_registered) {
+        stats_module_register("inference.classify_us", &g_classify_quantile);
+        stats_module_register("sampler.jitter_us", &g_timing.jitter());
+        stats_module_register("sampler.dropped", &g_timing.dropped());
+        stats_module_register("sampler.duplicated", &g_timing.duplicated());
+        stats_module_register("scheduler.classified", &g_scheduler_classified);
+        stats_module_register("scheduler.skipped", &g_scheduler_skipped);
+        stats_module_register("scheduler.canceled", &g_scheduler_canceled);
+        stats_module_register("scheduler.max_latency_us", &g_scheduler_max_latency_us);
+#if MOTION_GATE_ENABLE
+        stats_module_register("gate.gated_ms", &g_gate_gated_ms);
+        stats_module_register("gate.total_ms", &g_gate_total_ms);
+#endif
+#if INFERENCE_SHADOW_MODEL
+        stats_module_register("shadow.deferred", &g_shadow_deferred);
+        stats_module_register("shadow.candidate_us", &g_shadow_time_us);
+#endif
+#if INFERENCE_RADIO_AWARE
+        stats_module_register("radio.placed_us", &g_radio_placed);
+        stats_module_register("radio.control_us", &g_radio_control);
+        stats_module_register("radio.deferred", &g_radio_deferred);
+        stats_module_register("radio.no_fit", &g_radio_no_fit);
+#endif
+        g_stats_registered = true;
     }
+    g_idle_prefilter.configure(INFERENCE_IDLE_PREFILTER_MAX_STD_G);
+#if INFERENCE_ONSET_HEAD
+    if (ONSET_MODEL_CLASSES == 0) {
+        LOG_WARN("[Inference] Onset head not trained (train it with onset_trainer.py)\n");
+    } else if (ONSET_MODEL_CLASSES != g_models[0].handle->impulse->label_count ||
+               ONSET_MODEL_AXES != EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME ||
+               ONSET_MODEL_PREFIX_FRAMES > EI_CLASSIFIER_RAW_SAMPLE_COUNT) {
+        LOG_WARN("[Inference] Onset head does not match the model, provisional onsets disabled\n");
+    } else {
+        g_onset_head.configure(kOnsetWeights, kOnsetBias, ONSET_MODEL_CLASSES, ONSET_MODEL_AXES,
+                               ONSET_MODEL_PREFIX_FRAMES, kOnsetClassMask, kOnsetThreshold);
+        LOG_INFO("[Inference] Onset head: %u-frame prefix, class mask 0x%02lx, threshold %.3f\n",
+                  (unsigned)ONSET_MODEL_PREFIX_FRAMES, (unsigned long)kOnsetClassMask, kOnsetThreshold);
+    }
+    g_onset_tracker.configure(ONSET_MODEL_HORIZON_FRAMES);
+#endif
+#if INFERENCE_ARM_SUPPORT
+    // 毫秒换算为帧：检测器按帧计时，与批次到达时间无关
+    g_tap_detector.configure(ARM_TAP_ENERGY_THRESHOLD,
+                             (uint16_t)lroundf(ARM_TAP_MAX_PULSE_MS / EI_CLASSIFIER_INTERVAL_MS),
+                             (uint16_t)lroundf(ARM_TAP_MIN_GAP_MS / EI_CLASSIFIER_INTERVAL_MS),
+                             (uint16_t)lroundf(ARM_TAP_MAX_GAP_MS / EI_CLASSIFIER_INTERVAL_MS));
+    if (INFERENCE_ARM_MODE) {
+        LOG_INFO("[Inference] Arm mode: double tap opens a %d ms window\n", (int)ARM_WINDOW_MS);
+    }
+#endif
+    inference_set_stride(INFERENCE_STRIDE_FINE_SAMPLES,
+                         INFERENCE_ADAPTIVE_STRIDE ? INFERENCE_STRIDE_COARSE_SAMPLES : INFERENCE_STRIDE_FINE_SAMPLES);
 
-    // 使用互斥锁更新共享变量
-    g_inference_mutex.lock();
-    const bool changed =
-        (max_index != g_prediction_index) ||
-        (std::fabs(max_confidence - g_confidence) > 0.01f);
-    g_prediction_index = max_index;
-    g_confidence = max_confidence;
-    if (changed) {
-        g_result_sequence++;
+#if MODEL_OTA_ENABLE
+    // 模型槽中的权重在模型初始化（以及下面的基准测试）之前换上
+    model_slot_module_begin();
+#endif
+    model_module_print_kernels();
+    model_module_print_placement();
+#if MODEL_BENCHMARK_ITERATIONS
+    model_module_benchmark(MODEL_BENCHMARK_ITERATIONS, nullptr);
+#endif
+
+#if INFERENCE_INT8_WINDOW
+    // 量化窗口跳过了原始特征块，仅在该块不做缩放时才等价（定点特征链把缩放并入 Q15 乘数）
+    if (!INFERENCE_Q15_FEATURES && ei_dsp_config_792000_35.scale_axes != 1.0f) {
+        LOG_ERROR("[Inference] INT8 window requires raw DSP block with scale-axes 1.0\n");
+        return false;
     }
-    g_inference_mutex.unlock();
 
-    return true;
-}
+    if (!model_module_init()) {
+        LOG_ERROR("[Inference] Failed to initialize model!\n");
+        return false;
+    }
 
-// ==================== 公共接口实现 ====================
+    size_t input_length = 0;
+    if (!model_module_input_buffer(&input_length) || input_length != EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE) {
+        LOG_ERROR("[Inference] Model input tensor does not match the window size\n");
+        return false;
+    }
 
-bool inference_module_init() {
-    if (!IMU.begin()) {
-        ei_printf("[Inference] Failed to initialize IMU!\n");
+    configure_novelty();
+    if (!configure_quantization()) {
         return false;
     }
+    configure_tcn();
+#if INFERENCE_FEWSHOT
+    fewshot_module_begin();
+#endif
 
-    ei_printf("[Inference] IMU initialized successfully\n");
+    if (kModelCount > 1) {
+        LOG_WARN("[Inference] INT8 window runs the default model only; extra models are disabled\n");
+    }
+#else
+    // 预先初始化所有模型，运行时切换只需重建连续分类器的特征窗口
+    for (size_t m = 0; m < kModelCount; m++) {
+        run_classifier_init(g_models[m].handle);
+        LOG_INFO("[Inference] Model %u: \"%s\" (%u labels)\n", (unsigned)m,
+                  g_models[m].handle->impulse->impulse_name, (unsigned)g_models[m].handle->impulse->label_count);
+    }
+#endif
+    configure_confidence_format();
+    configure_memo();
+    // 模型声明的 FFT 长度（EI_CLASSIFIER_LOAD_FFT_*）在此一次建好计划，频谱类 DSP 块不再每个窗口初始化、分配
+    if (ei::numpy::init_fft_plans() != ei::EIDSP_OK) {
+        LOG_WARN("[Inference] FFT plans not preloaded, they are made on first use\n");
+    }
+    boot_module_mark(BOOT_MODEL_READY);
     return true;
 }
 
 void inference_task() {
-    // 等待1秒让系统稳定
-    rtos::ThisThread::sleep_for(std::chrono::seconds(1));
+    energy_module_wake(ENERGY_INFERENCE);
+    // 不再固定等待：模型已在 setup 中初始化，setup 完成（全部线程已启动）后直接填充窗口，
+    // 填充本身就在等采集线程送来样本。被监督者重启时立即返回
+    energy_module_sleep(ENERGY_INFERENCE);
+    boot_module_wait(BOOT_SETUP_DONE);
+    energy_module_wake(ENERGY_INFERENCE);
 
-    ei_printf("[Inference] Task started with sliding window mode\n");
-    ei_printf("[Inference] Window size: %d, Step: %d\n",
+    LOG_INFO("[Inference] Task started with sliding window mode\n");
+    LOG_INFO("[Inference] Window size: %d, Step: %d\n",
               EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE, SLIDING_WINDOW_STEP);
 
-    // 临时缓冲区用于存放新采集的数据
-    float new_samples[SLIDING_WINDOW_STEP];
-
     // 第一次：填充整个滑动窗口
-    ei_printf("[Inference] Filling initial window...\n");
-    if (!collect_new_samples(g_sliding_window, EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE)) {
-        ei_printf("[Inference] Failed to initialize window\n");
-        return;
+    LOG_INFO("[Inference] Filling initial window...\n");
+    g_window_head = 0;
+    for (size_t i = 0; i < EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE / SLIDING_WINDOW_STEP; i++) {
+        while (!slide_window()) {
+            LOG_WARN("[Inference] Waiting for sampler to fill initial window...\n");
+        }
     }
-    ei_printf("[Inference] Initial window ready, starting continuous inference\n");
+    LOG_INFO("[Inference] Initial window ready, starting continuous inference\n");
+    boot_module_mark(BOOT_WINDOW_READY);
+    // 初始化阶段的 SDK 分配留在 arena 中，之后的分配由定长块池提供
+    alloc_module_seal();
+    memory_module_report();
 
+    // 看门狗从这里开始计时：之后每次循环（包括门控、录制期间）都喂一次
+    watchdog_module_start();
+    uint32_t last_us = hal::now_us();
     for (;;) {
-        // 采集新的样本数据
-        if (!collect_new_samples(new_samples, SLIDING_WINDOW_STEP)) {
-            ei_printf("[Inference] Failed to collect new samples\n");
-            rtos::ThisThread::sleep_for(std::chrono::milliseconds(50));
+        watchdog_module_progress();
+        supervisor_module_heartbeat(THREAD_INFERENCE);
+        // 采集新的样本数据并滑动窗口（静止时窗口照常更新，恢复运动时无需重新填充）
+        const bool window_ok = slide_window();
+
+        const uint32_t now_us = hal::now_us();
+        const bool gated = MOTION_GATE_ENABLE && !g_imu.motion_active();
+        g_total_us += now_us - last_us;
+        if (gated) {
+            g_gated_us += now_us - last_us;
+        }
+#if INFERENCE_ARM_SUPPORT
+        if (g_armed) {
+            g_armed_us += now_us - last_us;
+        }
+#endif
+        last_us = now_us;
+        update_sensor_rate(gated);
+
+        if (record_module_active()) {
+            // 录制期间暂停分类和文本输出，避免与二进制录制流争用串口；窗口照常滑动
+            continue;
+        }
+
+        if (g_profile_requested) {
+            g_profile_requested = false;
+            // 剖析会让这次循环明显变长（计为一次停滞），先喂狗，留满 WATCHDOG_TIMEOUT_MS
+            watchdog_module_progress();
+            supervisor_module_heartbeat(THREAD_INFERENCE);
+            model_module_profile(MODEL_PROFILE_ITERATIONS);
+        }
+        apply_benchmark_request();
+        apply_model_switch();
+#if MODEL_OTA_ENABLE
+        apply_model_slot();
+#endif
+#if INFERENCE_FEWSHOT
+        fewshot_module_apply();
+#endif
+
+        if (gated) {
+            // 静止：跳过分类；若采集也被门控，队列为空导致的超时属于正常情况
+            report_sample_rate();
+            continue;
+        }
+#if INFERENCE_ARM_SUPPORT
+        if (arm_required()) {
+            if (g_armed && (int32_t)(hal::now_ms() - g_armed_until_ms) >= 0) {
+                // 唤醒窗口到期：清除结果，消费者看到“无手势”
+                g_armed = false;
+                g_inference_pending = false;
+                LOG_INFO("[Inference] Disarmed\n");
+                inference_clear_result();
+            }
+            if (!g_armed) {
+                // 未唤醒：窗口照常滑动（双击检测已在 record_sample_timing 中完成），不运行 CNN、不发布结果
+                report_sample_rate();
+                continue;
+            }
+        }
+#endif
+
+        if (!window_ok) {
+            LOG_ERROR("[Inference] Failed to collect new samples\n");
+            energy_module_sleep_for(ENERGY_INFERENCE, std::chrono::milliseconds(50));
             continue;
         }
 
-        // 滑动窗口：移动数据并添加新样本
-        slide_window(new_samples, SLIDING_WINDOW_STEP);
+        // 步长策略决定这一步是否需要推理（粗步长时大部分步只更新窗口）
+        g_stride_mutex.lock();
+        bool inference_due = g_stride_policy.on_step(g_step_energy);
+        g_stride_mutex.unlock();
+        if (g_power_point == INFERENCE_POWER_IDLE_FILTER && !(g_step_energy > INFERENCE_STRIDE_ENERGY_THRESHOLD)) {
+            // 电量分级的 idle 过滤一级：只有新样本的运动能量超过阈值的步才推理，没有周期推理
+            inference_due = false;
+        }
+        if (inference_due) {
+            if (g_inference_pending) {
+                // 上一个到期的窗口还没来得及分类就被更新的窗口取代
+                g_scheduler_skipped.add();
+            }
+            g_inference_pending = true;
+        }
+        if (!g_inference_pending) {
+#if INFERENCE_MULTIRES
+            run_long_pass();
+#endif
+            continue;
+        }
+#if INFERENCE_DROP_STALE_WINDOWS
+        // 队列里已有下一步的样本：当前窗口已经过时，先把窗口滑到最新再分类
+        if (g_sample_ring.size() >= SLIDING_WINDOW_STEP) {
+            continue;
+        }
+#endif
+        g_inference_pending = false;
 
         // 使用滑动窗口运行推理
-        if (!run_inference(g_sliding_window, EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE)) {
-            ei_printf("[Inference] Inference failed\n");
-            rtos::ThisThread::sleep_for(std::chrono::milliseconds(50));
+        inference_result_event_t event;
+#if INFERENCE_RADIO_AWARE
+        radio_gap_kind_t radio_kind;
+        uint32_t radio_defer_us;
+        const radio_sample_t radio_sample = place_around_radio(&radio_kind, &radio_defer_us);
+        const uint32_t invoke_start_us = hal::now_us();
+#endif
+        cancel_arm(g_cancel_streak < INFERENCE_CANCEL_MAX_STREAK);
+        const bool ok = run_inference(&event);
+        if (cancel_disarm()) {
+            // 推理中途被更新的窗口抢占：窗口滑到最新后立即重新分类。连续分类器的特征窗口可能停在
+            // DSP 之后的检查点（特征已写入、计数未前进），下一次按完整窗口重建
+            g_cancel_streak++;
+            g_window_new_values = EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE;
+            g_inference_pending = true;
+            g_scheduler_canceled.add();
+            continue;
+        }
+        g_cancel_streak = 0;
+        if (!ok) {
+            LOG_ERROR("[Inference] Inference failed\n");
+            energy_module_sleep_for(ENERGY_INFERENCE, std::chrono::milliseconds(50));
             continue;
         }
+#if INFERENCE_RADIO_AWARE
+        // 被 idle 预筛跳过的推理没有运行 CNN，不计入
+        if (event.classify_us > 0) {
+            record_radio_invoke(radio_sample, radio_kind, radio_defer_us, hal::now_us() - invoke_start_us);
+        }
+#endif
+        record_result_latency(&event);
+        boot_module_mark(BOOT_FIRST_RESULT);
+#if INFERENCE_ARM_SUPPORT
+        if (arm_required() && event.index >= 0 && event.index != g_idle_index) {
+            arm_window("gesture");
+        }
+#endif
+#if INFERENCE_MULTIRES
+        // 长窗口隔一次原窗口推理运行一次（它每步只前进一帧）
+        g_long_toggle = !g_long_toggle;
+        if (g_long_toggle) {
+            g_long_due = true;
+        }
+#endif
+        if (event.classify_us > 0) {
+            g_classify_quantile.record(g_run_classify_us);
+        }
+        // 被 idle 预筛跳过的推理没有运行 CNN，不计入实时基准
+        if (g_bench_live && event.classify_us > 0) {
+            bench_record(g_run_dsp_us, g_run_classify_us, g_run_postprocess_us, event.latency_us);
+            if (g_bench_count >= g_bench_target) {
+                bench_finish(true);
+            }
+        }
+        const inference_result_observer_t observer = g_result_observer;
+        if (observer) {
+            observer(&event);
+        }
+
+#if INFERENCE_MULTIRES
+        run_long_pass();
+#endif
+#if INFERENCE_SHADOW_MODEL
+        // 被 idle 预筛或结果记忆跳过的窗口没有运行 CNN，不对比
+        if (event.classify_us > 0) {
+            shadow_schedule(g_active_model);
+        }
+        run_shadow_pass();
+#endif
 
-        // 短暂休眠，让其他线程有机会运行
-        rtos::ThisThread::sleep_for(std::chrono::milliseconds(1));
+        // 不额外休眠：下一次 slide_window() 在样本队列上阻塞，推理节奏只由样本到达决定，
+        // 更低优先级的线程在此期间运行
+        report_sample_rate();
     }
 }
 
-void inference_get_result(int* out_prediction_index, float* out_confidence) {
+void inference_sampler_task() {
+    imu_sample_t frames[SAMPLER_BATCH_FRAMES * IMU_MAX_FUSION_AXES];
+#if INFERENCE_PIPELINED_INPUT
+    // 这一批在上一次推理仍在进行时就量化好，推理线程到步长边界时直接使用
+    int8_t quantized[SAMPLER_BATCH_FRAMES * IMU_MAX_FUSION_AXES];
+    imu_sample_t last_frame[IMU_MAX_FUSION_AXES] = {0};
+    const window_sample_t* samples = quantized;
+#else
+    const window_sample_t* samples = frames;
+#endif
+    const size_t axes = g_imu.axis_count();
+    // 窗口样本流：按通道升序取值，换算为传感器 LSB（int16 样本已是 LSB，比例为 1）
+    uint8_t window_order[IMU_MAX_AXES];
+    float window_scale[IMU_MAX_AXES];
+    const size_t window_channels = window_stream_order(window_order, nullptr);
+    for (size_t c = 0; c < window_channels; c++) {
+        window_scale[c] = g_imu.channel_lsb(g_imu.axis_channel(window_order[c])) /
+                          g_imu.axis_lsb(window_order[c]);
+    }
+    // 被监督者重启时接着之前的计数，批标记仍与推理线程的帧计数对应
+    uint32_t frames_pushed = g_frames_pushed;
+    energy_module_wake(ENERGY_SAMPLER);
+
+    for (;;) {
+        // 阻塞在 IMU 数据就绪上（FIFO 水位中断或采样定时器）
+        size_t count = g_imu.read_frames(frames, SAMPLER_BATCH_FRAMES);
+        const uint32_t start_us = hal::now_us();
+        const uint32_t zone_start = profiler_zone_now();
+#if INFERENCE_PIPELINED_INPUT
+        for (size_t i = 0; i < count; i++) {
+            if (memcmp(&frames[i * axes], last_frame, axes * sizeof(imu_sample_t)) == 0) {
+                g_sampler_duplicates++;
+            }
+            memcpy(last_frame, &frames[i * axes], axes * sizeof(imu_sample_t));
+        }
+        quantize_samples(frames, quantized, count * axes);
+#endif
+#if INFERENCE_HOST_REPLAY
+        // 离线回放比实时快得多：等推理线程腾出空间，而不是像设备上那样丢帧
+        while (g_sample_ring.capacity() - g_sample_ring.size() < count * axes) {
+            hal::yield();
+        }
+#endif
+
+        // 逐帧写入，队列满时只丢弃放不下的帧，并由 overrun 计数体现
+        const bool window_stream = pipeline_module_subscribed(PIPELINE_OUTPUT_WINDOW);
+        for (size_t i = 0; i < count; i++) {
+            if (g_sample_ring.push(&samples[i * axes], axes)) {
+                if (window_stream) {
+                    inference_window_frame_t entry;
+                    entry.index = frames_pushed;
+                    for (size_t c = 0; c < window_channels; c++) {
+                        const long v = lroundf((float)frames[i * axes + window_order[c]] * window_scale[c]);
+                        entry.values[c] = (int16_t)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+                    }
+                    g_window_queue.push(&entry, 1);
+                }
+                frames_pushed++;
+            }
+        }
+        if (count > 0) {
+            // 标记队列满时丢弃这一条（只会让延迟统计偏小，不影响样本）
+            const sample_batch_mark_t mark = {frames_pushed, (uint32_t)hal::now_us()};
+            g_batch_marks.push(&mark, 1);
+        }
+        g_frames_pushed = frames_pushed;
+        g_sample_ring.notify();
+        pipeline_module_record_queue(PIPELINE_WINDOW, g_sample_ring.size(), g_sample_ring.capacity(),
+                                     g_sample_ring.overruns());
+        pipeline_module_record(PIPELINE_ACQUIRE, start_us);
+        profiler_zone_record(ZONE_ACQUIRE, zone_start);
+    }
+}
+
+void inference_get_sampler_stats(uint32_t* out_overruns, uint32_t* out_high_water) {
+    if (out_overruns) {
+        *out_overruns = g_sample_ring.overruns();
+    }
+    if (out_high_water) {
+        *out_high_water = g_sample_ring.high_water();
+    }
+}
+
+void inference_get_radio_stats(inference_radio_stats_t* out_stats) {
+    if (!out_stats) {
+        return;
+    }
+    inference_radio_stats_t stats = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+#if INFERENCE_RADIO_AWARE
+    stats.placed = g_radio_placed.count();
+    stats.control = g_radio_control.count();
+    stats.deferred = g_radio_deferred.value();
+    stats.no_fit = g_radio_no_fit.value();
+    stats.mean_defer_us = g_radio_mean_defer_us.load(std::memory_order_relaxed);
+    stats.placed_p99_us = g_radio_placed.percentile(0.99f);
+    stats.control_p99_us = g_radio_control.percentile(0.99f);
+    radio_module_get_timing(&stats.interval_us, &stats.event_us);
+#endif
+    *out_stats = stats;
+}
+
+void inference_get_shadow_stats(inference_shadow_stats_t* out_stats) {
+    if (!out_stats) {
+        return;
+    }
+    inference_shadow_stats_t stats = {-1, 0, 0, 0, 0, 0, 0, 0, 0};
+#if INFERENCE_SHADOW_MODEL
+    g_inference_mutex.lock();
+    const shadow_counts_t& total = g_shadow_tally.total();
+    stats.candidate = INFERENCE_SHADOW_MODEL;
+    stats.runs = total.runs;
+    stats.deferred = g_shadow_deferred.value();
+    stats.agree = total.agree;
+    stats.candidate_only = total.candidate_only;
+    stats.production_only = total.production_only;
+    stats.differ = total.differ;
+    stats.mean_us = total.runs > 0 ? (uint32_t)(g_shadow_total_us / total.runs) : 0;
+    stats.max_us = g_shadow_time_us.max();
+    g_inference_mutex.unlock();
+#endif
+    *out_stats = stats;
+}
+
+void inference_get_lock_stats(inference_lock_stats_t* out_stats) {
+    if (out_stats) {
+        g_inference_mutex.lock();
+        *out_stats = g_lock_stats;
+        g_inference_mutex.unlock();
+    }
+}
+
+void inference_get_sample_timing(sample_timing_stats_t* out_stats) {
+    if (out_stats) {
+        g_timing_snapshot.load(out_stats);
+    }
+}
+
+void inference_set_result_observer(inference_result_observer_t observer) {
+    g_result_observer = observer;
+}
+
+uint32_t inference_frames_pushed() {
+    return g_frames_pushed;
+}
+
+bool inference_caught_up() {
+    return g_waiting_for_samples && g_sample_ring.size() < SLIDING_WINDOW_STEP;
+}
+
+void inference_get_scheduler_stats(inference_scheduler_stats_t* out_stats) {
+    if (out_stats) {
+        g_scheduler_snapshot.load(out_stats);
+    }
+}
+
+/**
+ * @brief 按运行时配置的步长与工作点配置步长策略（调用者持有 g_stride_mutex）
+ * 满速用配置的细 / 粗步长，其余工作点细步长也用粗步长
+ */
+static void apply_stride() {
+    const size_t samples_per_step = SLIDING_WINDOW_STEP / EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME;
+    const uint8_t fine_samples =
+        g_power_point == INFERENCE_POWER_FULL ? g_config_fine_samples : g_config_coarse_samples;
+    g_stride_policy.configure(fine_samples / samples_per_step, g_config_coarse_samples / samples_per_step,
+                              INFERENCE_STRIDE_STABLE_COUNT, INFERENCE_STRIDE_IDLE_CONFIDENCE,
+                              INFERENCE_STRIDE_ENERGY_THRESHOLD);
+#if INFERENCE_EVENT_MODE == INFERENCE_EVENTS_PERFCAL
+    g_fine_stride_samples = fine_samples;
+    configure_event_detector();
+#endif
+}
+
+bool inference_set_stride(uint8_t fine_samples, uint8_t coarse_samples) {
+    const size_t samples_per_step = SLIDING_WINDOW_STEP / EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME;
+    if (fine_samples == 0 || coarse_samples < fine_samples ||
+        fine_samples % samples_per_step != 0 || coarse_samples % samples_per_step != 0 ||
+        coarse_samples > EI_CLASSIFIER_RAW_SAMPLE_COUNT) {
+        return false;
+    }
+
+    g_stride_mutex.lock();
+    g_config_fine_samples = fine_samples;
+    g_config_coarse_samples = coarse_samples;
+    apply_stride();
+    g_stride_mutex.unlock();
+    return true;
+}
+
+/**
+ * @brief 按电量分级与主机的请求更新生效的工作点（调用者持有 g_stride_mutex）
+ * @return true 生效的工作点改变
+ */
+static bool update_power_point() {
+    const uint8_t point =
+        g_host_point != INFERENCE_HOST_POINT_NONE && g_host_point > g_battery_point ? g_host_point : g_battery_point;
+    if (point == g_power_point) {
+        return false;
+    }
+    g_power_point = point;
+    apply_stride();
+    return true;
+}
+
+void inference_set_power_point(inference_power_point_t point) {
+    if (point >= INFERENCE_POWER_POINT_COUNT) {
+        return;
+    }
+    g_stride_mutex.lock();
+    g_battery_point = (uint8_t)point;
+    const bool changed = update_power_point();
+    g_stride_mutex.unlock();
+    if (changed) {
+        LOG_INFO("[Inference] Power point: %s\n", inference_power_point_name(g_power_point));
+    }
+}
+
+bool inference_set_host_power_point(uint8_t point) {
+    if (point >= INFERENCE_POWER_POINT_COUNT && point != INFERENCE_HOST_POINT_NONE) {
+        return false;
+    }
+#if !INFERENCE_ARM_SUPPORT
+    // 没有编译双击唤醒时按需一级不能生效
+    if (point == INFERENCE_POWER_ON_DEMAND) {
+        return false;
+    }
+#endif
+    if (point == g_host_point) {
+        return true;
+    }
+    g_stride_mutex.lock();
+    g_host_point = point;
+    update_power_point();
+    g_stride_mutex.unlock();
+    LOG_INFO("[Inference] Host power point: %s, in effect %s\n",
+             point == INFERENCE_HOST_POINT_NONE ? "released" : inference_power_point_name(point),
+             inference_power_point_name(g_power_point));
+    return true;
+}
+
+uint8_t inference_get_host_power_point() {
+    return g_host_point;
+}
+
+inference_power_point_t inference_get_power_point() {
+    return (inference_power_point_t)g_power_point;
+}
+
+const char* inference_power_point_name(uint8_t point) {
+    static const char* const kNames[INFERENCE_POWER_POINT_COUNT] = {"full", "coarse", "idle-filter", "on-demand"};
+    return point < INFERENCE_POWER_POINT_COUNT ? kNames[point] : "unknown";
+}
+
+float inference_get_gated_ratio() {
+    return g_gated_ratio;
+}
+
+bool inference_get_arm_state(uint32_t* out_arms, float* out_armed_ratio) {
+#if INFERENCE_ARM_SUPPORT
+    if (out_arms) {
+        *out_arms = g_arm_count;
+    }
+    if (out_armed_ratio) {
+        *out_armed_ratio = g_armed_ratio;
+    }
+    return !arm_required() || g_armed;
+#else
+    if (out_arms) {
+        *out_arms = 0;
+    }
+    if (out_armed_ratio) {
+        *out_armed_ratio = 1.0f;
+    }
+    return true;
+#endif
+}
+
+void inference_request_profile() {
+    g_profile_requested = true;
+}
+
+bool inference_request_benchmark(inference_bench_mode_t mode, uint16_t runs) {
+    if (runs == 0 || runs > INFERENCE_BENCHMARK_MAX_RUNS ||
+        (mode != INFERENCE_BENCH_SYNTHETIC && mode != INFERENCE_BENCH_LIVE)) {
+        return false;
+    }
+    g_inference_mutex.lock();
+    const bool busy = g_bench_pending || g_bench_report.state == INFERENCE_BENCH_RUNNING;
+    if (!busy) {
+        g_bench_mode = mode;
+        g_bench_target = runs;
+        g_bench_pending = true;
+        g_bench_report = {(uint8_t)mode, (uint8_t)INFERENCE_BENCH_RUNNING, 0, {}};
+    }
+    g_inference_mutex.unlock();
+    return !busy;
+}
+
+uint32_t inference_get_benchmark(inference_bench_report_t* out_report) {
     g_inference_mutex.lock();
-    *out_prediction_index = g_prediction_index;
-    *out_confidence = g_confidence;
+    const uint32_t version = g_bench_version;
+    if (out_report) {
+        *out_report = g_bench_report;
+    }
     g_inference_mutex.unlock();
+    return version;
+}
+
+void inference_get_prefilter_stats(uint32_t* out_evaluated, uint32_t* out_skipped) {
+    if (out_evaluated) {
+        *out_evaluated = g_idle_prefilter.evaluated();
+    }
+    if (out_skipped) {
+        *out_skipped = g_idle_prefilter.skipped();
+    }
+}
+
+void inference_get_confidence_format(inference_confidence_format_t* out_format) {
+    if (out_format) {
+        *out_format = g_confidence_format;
+    }
+}
+
+uint8_t inference_quantize_confidence(float confidence) {
+    const int32_t q = (int32_t)lroundf(confidence * g_confidence_inv_scale) + g_confidence_format.zero_point;
+    return (uint8_t)(q < 0 ? 0 : (q > 255 ? 255 : q));
+}
+
+float inference_confidence_value(uint8_t confidence_q) {
+    return ((int32_t)confidence_q - g_confidence_format.zero_point) * g_confidence_format.scale;
+}
+
+void inference_get_result(int* out_prediction_index, float* out_confidence) {
+    inference_get_result_with_seq(out_prediction_index, out_confidence, nullptr);
 }
 
 void inference_get_result_with_seq(int* out_prediction_index,
                                    float* out_confidence,
                                    uint32_t* out_sequence) {
-    g_inference_mutex.lock();
+    inference_result_snapshot_t snapshot;
+    inference_get_result_snapshot(&snapshot);
     if (out_prediction_index) {
-        *out_prediction_index = g_prediction_index;
+        *out_prediction_index = snapshot.index;
     }
     if (out_confidence) {
-        *out_confidence = g_confidence;
+        *out_confidence = inference_confidence_value(snapshot.confidence_q);
+    }
+    if (out_sequence) {
+        *out_sequence = snapshot.sequence;
+    }
+}
+
+void inference_get_result_snapshot(inference_result_snapshot_t* out_snapshot) {
+    if (out_snapshot == nullptr) {
+        return;
+    }
+    if (g_result.load(out_snapshot) == 0) {
+        // 尚未发布过：初始值为"无结果"
+        *out_snapshot = {-1, 0, 0, 0, 0};
+    }
+}
+
+bool inference_get_gesture_event(inference_gesture_event_t* out_event, uint32_t* out_sequence) {
+    g_inference_mutex.lock();
+    const uint32_t sequence = g_gesture_sequence;
+    if (out_event) {
+        *out_event = g_gesture_event;
     }
     if (out_sequence) {
-        *out_sequence = g_result_sequence;
+        *out_sequence = sequence;
+    }
+    g_inference_mutex.unlock();
+    return sequence != 0;
+}
+
+bool inference_get_segment_state(inference_segment_state_t* out_state) {
+    g_inference_mutex.lock();
+    const inference_segment_state_t state = g_segment_state;
+    g_inference_mutex.unlock();
+    if (out_state) {
+        *out_state = state;
     }
+    return state.changes != 0;
+}
+
+bool inference_get_onset_state(inference_onset_state_t* out_state) {
+    g_inference_mutex.lock();
+    const inference_onset_state_t state = g_onset_state;
     g_inference_mutex.unlock();
+    if (out_state) {
+        *out_state = state;
+    }
+    return state.changes != 0;
 }
 
 void inference_clear_result() {
     g_inference_mutex.lock();
     g_prediction_index = -1;
-    g_confidence = 0.0f;
+    g_confidence_q = inference_quantize_confidence(0.0f);
     g_result_sequence++;
+    publish_result(0);
     g_inference_mutex.unlock();
+    notify_consumers();
+}
+
+bool inference_pop_result_event(inference_consumer_t consumer, inference_result_snapshot_t* out_event) {
+    return out_event != nullptr && g_result_queues[consumer].pop(out_event, 1);
+}
+
+uint32_t inference_result_event_overruns(inference_consumer_t consumer) {
+    return g_result_queues[consumer].overruns();
+}
+
+bool inference_wait_result(inference_consumer_t consumer, std::chrono::milliseconds timeout) {
+    return g_result_queues[consumer].wait(timeout);
+}
+
+void inference_wake_result_waiter(inference_consumer_t consumer) {
+    g_result_queues[consumer].notify();
+    void (*listener)() = g_result_listeners[consumer];
+    if (listener) {
+        listener();
+    }
+}
+
+void inference_set_result_listener(inference_consumer_t consumer, void (*listener)()) {
+    g_result_listeners[consumer] = listener;
+}
+
+bool inference_pop_scores(inference_scores_t* out_scores) {
+    return out_scores != nullptr && g_score_queue.pop(out_scores, 1);
+}
+
+uint32_t inference_score_overruns() {
+    return g_score_queue.overruns();
+}
+
+uint8_t inference_window_channel_mask() {
+    uint8_t order[IMU_MAX_AXES];
+    uint8_t mask;
+    window_stream_order(order, &mask);
+    return mask;
+}
+
+bool inference_pop_window_frame(inference_window_frame_t* out_frame) {
+    return out_frame != nullptr && g_window_queue.pop(out_frame, 1);
+}
+
+uint32_t inference_window_stream_overruns() {
+    return g_window_queue.overruns();
 }
 
-rtos::Mutex& inference_get_mutex() {
+hal::Mutex& inference_get_mutex() {
     return g_inference_mutex;
 }
 
 const char* inference_get_category_name(int index) {
-    if (index >= 0 && index < EI_CLASSIFIER_LABEL_COUNT) {
-        return ei_classifier_inferencing_categories[index];
+    if (index >= 0 && index < GESTURE_LABEL_COUNT) {
+        return kGestureLabels[index].name;
     }
     return "unknown";
 }
+
+size_t inference_model_count() {
+    return kModelCount;
+}
+
+size_t inference_active_model() {
+    return g_active_model;
+}
+
+bool inference_select_model(size_t index) {
+    if (index >= kModelCount || (INFERENCE_INT8_WINDOW && index != 0)) {
+        return false;
+    }
+    g_requested_model = (int)index;
+    return true;
+}
+
+bool inference_get_model_stats(size_t index, inference_model_stats_t* out_stats) {
+    if (index >= kModelCount || out_stats == nullptr) {
+        return false;
+    }
+
+    const ei_impulse_t* impulse = g_models[index].handle->impulse;
+    size_t arena_bytes = 0;
+    if (g_models[index].arena_usage) {
+        g_models[index].arena_usage(&arena_bytes, nullptr, nullptr);
+    }
+
+    out_stats->name = impulse->impulse_name;
+    out_stats->label_count = impulse->label_count;
+    out_stats->input_values = impulse->nn_input_frame_size;
+    out_stats->arena_bytes = (uint32_t)arena_bytes;
+    g_inference_mutex.lock();
+    out_stats->invokes = g_model_invokes[index];
+    out_stats->mean_us = g_model_invokes[index] > 0 ? (uint32_t)(g_model_total_us[index] / g_model_invokes[index]) : 0;
+    out_stats->max_us = g_model_max_us[index];
+    out_stats->last_index = g_model_last_index[index];
+    out_stats->last_confidence = g_model_last_confidence[index];
+    g_inference_mutex.unlock();
+    return true;
+}
@@ -0,0 +1,115 @@
+// TFLM 解释器后备路径：MicroInterpreter + 只含部署模型算子的 MicroMutableOpResolver
+#include <Arduino.h>
+#include <new>
+#include <string.h>
+
+#include "app_config.h"
+#include "interp_module.h"
+
+#if MODEL_INTERPRETER_ENABLE
+
+#include "edge-impulse-sdk/tensorflow/lite/micro/micro_interpreter.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/micro_mutable_op_resolver.h"
+#include "edge-impulse-sdk/tensorflow/lite/schema/schema_generated_full.h"
+
+// 解析器注册表按算子种类数定长分配（两个 CONV_2D 节点共用一个注册项）
+#define INTERP_OP_COUNT 5
+
+typedef tflite::MicroMutableOpResolver<INTERP_OP_COUNT> op_resolver_t;
+
+// ==================== 内部状态（模块私有） ====================
+
+// 解析器只登记函数指针，与解释器无关，注册一次后一直使用
+static op_resolver_t g_resolver;
+static bool g_resolver_ready = false;
+
+// 解释器对象放在静态存储中（不经堆），加载时就地构造、卸载时显式析构
+alignas(tflite::MicroInterpreter) static uint8_t g_interpreter_storage[sizeof(tflite::MicroInterpreter)];
+static tflite::MicroInterpreter* g_interpreter = nullptr;
+static TfLiteTensor* g_input = nullptr;
+static TfLiteTensor* g_output = nullptr;
+
+// ==================== 内部辅助函数 ====================
+
+static bool register_ops() {
+    if (!g_resolver_ready) {
+        g_resolver_ready = g_resolver.AddReshape() == kTfLiteOk && g_resolver.AddConv2D() == kTfLiteOk &&
+                           g_resolver.AddMaxPool2D() == kTfLiteOk && g_resolver.AddFullyConnected() == kTfLiteOk &&
+                           g_resolver.AddSoftmax() == kTfLiteOk;
+    }
+    return g_resolver_ready;
+}
+
+static bool fail(const char* message) {
+    Serial.println(message);
+    interp_module_unload();
+    return false;
+}
+
+// ==================== 公共接口实现 ====================
+
+bool interp_module_load(const uint8_t* model, size_t bytes, uint8_t* arena, size_t arena_bytes) {
+    interp_module_unload();
+    if (model == nullptr || arena == nullptr || !register_ops()) {
+        return fail("[Interp] No flatbuffer, arena or op resolver");
+    }
+
+    // flatbuffer 来自 OTA：偏移、向量长度与嵌套表都先完整校验一遍，GetModel 之后的访问不再检查越界
+    flatbuffers::Verifier verifier(model, bytes);
+    if (!tflite::VerifyModelBuffer(verifier)) {
+        return fail("[Interp] Flatbuffer failed verification");
+    }
+    const tflite::Model* parsed = tflite::GetModel(model);
+    if (parsed->version() != TFLITE_SCHEMA_VERSION || parsed->subgraphs() == nullptr ||
+        parsed->subgraphs()->size() != 1) {
+        return fail("[Interp] Unsupported schema version or subgraph count");
+    }
+
+    g_interpreter = new (g_interpreter_storage) tflite::MicroInterpreter(parsed, g_resolver, arena, arena_bytes);
+    // 不在解析器中的算子与放不下的 arena 都在这里失败（MicroPrintf 经 ei_printf 给出具体原因）
+    if (g_interpreter->initialization_status() != kTfLiteOk || g_interpreter->AllocateTensors(true) != kTfLiteOk) {
+        return fail("[Interp] AllocateTensors failed (unsupported op or arena too small)");
+    }
+    if (g_interpreter->inputs_size() != 1 || g_interpreter->outputs_size() != 1) {
+        return fail("[Interp] Expected one input and one output tensor");
+    }
+    g_input = g_interpreter->input(0);
+    g_output = g_interpreter->output(0);
+
+    char line[96];
+    snprintf(line, sizeof(line), "[Interp] Flatbuffer %u B, arena %u of %u B", (unsigned)bytes,
+             (unsigned)g_interpreter->arena_used_bytes(), (unsigned)arena_bytes);
+    Serial.println(line);
+    return true;
+}
+
+void interp_module_unload() {
+    if (g_interpreter != nullptr) {
+        g_interpreter->~MicroInterpreter();
+        g_interpreter = nullptr;
+    }
+    g_input = nullptr;
+    g_output = nullptr;
+}
+
+bool interp_module_active() {
+    return g_input != nullptr;
+}
+
+TfLiteTensor* interp_module_input() {
+    return g_input;
+}
+
+TfLiteTensor* interp_module_output() {
+    return g_output;
+}
+
+bool interp_module_invoke() {
+    return g_input != nullptr && g_interpreter->Invoke() == kTfLiteOk;
+}
+
+size_t interp_module_arena_used() {
+    return g_input != nullptr ? g_interpreter->arena_used_bytes() : 0;
+}
+
+#endif
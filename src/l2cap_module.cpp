@@ -0,0 +1,633 @@
+// LE credit-based L2CAP channel for the bulk streams (see l2cap_module.h).
+#include <Arduino.h>
+#include <ArduinoBLE.h>
+#include <utility/HCI.h>
+#include <utility/HCITransport.h>
+#include <string.h>
+
+#include "app_config.h"
+#include "l2cap_module.h"
+#include "log_module.h"
+#include "usb_frame.h"
+#include "wire_schema.h"
+
+#if BLE_L2CAP_ENABLE
+
+namespace {
+
+constexpr uint8_t kHciAclPacket = 0x02;
+constexpr uint8_t kHciEventPacket = 0x04;
+constexpr uint8_t kHciDisconnectionComplete = 0x05;
+// Packet boundary flag of an ACL fragment that continues the previous one.
+constexpr uint8_t kAclContinuation = 0x01;
+
+constexpr uint16_t kSignalingCid = 0x0005;
+constexpr uint8_t kDisconnectionRequest = 0x06;
+constexpr uint8_t kDisconnectionResponse = 0x07;
+constexpr uint8_t kCreditConnectionRequest = 0x14;
+constexpr uint8_t kCreditConnectionResponse = 0x15;
+constexpr uint8_t kFlowControlCredit = 0x16;
+
+constexpr uint16_t kResultSuccess = 0x0000;
+constexpr uint16_t kResultPsmNotSupported = 0x0002;
+constexpr uint16_t kResultNoResources = 0x0004;
+constexpr uint16_t kResultInvalidSourceCid = 0x0009;
+constexpr uint16_t kResultUnacceptableParameters = 0x000B;
+
+// The channel's CID on this side. HCI.sendAclPkt takes the CID as uint8_t,
+// which covers the LE dynamic range the central allocates its CID from.
+constexpr uint16_t kLocalCid = 0x0040;
+constexpr uint16_t kDynamicCidLast = 0x007F;
+constexpr uint16_t kMinMtu = 23;
+
+constexpr size_t kSduHeaderBytes = 2;
+constexpr size_t kRecordHeaderBytes = 2;
+// An outgoing SDU fills BLE_L2CAP_SDU_FRAMES K-frames of BLE_L2CAP_MPS exactly.
+constexpr size_t kTxSduBytes = BLE_L2CAP_SDU_FRAMES * BLE_L2CAP_MPS - kSduHeaderBytes;
+constexpr size_t kRxRingBytes = BLE_L2CAP_RX_FRAMES * BLE_L2CAP_MPS;
+// Packet indicator and header, then the longest event parameters (255) or
+// LE ACL data the controller hands over (251).
+constexpr size_t kHciPacketMax = 1 + 4 + 255;
+constexpr size_t kSignalQueue = 4;
+constexpr size_t kSignalMaxBytes = 14;
+
+struct channel_t {
+    bool open;
+    uint16_t handle;
+    uint16_t remote_cid;
+    uint16_t remote_mtu;
+    uint16_t remote_mps;
+    uint16_t tx_credits;  // K-frames the central lets us send
+    uint16_t rx_credits;  // K-frames the central may still send
+    bool hello;           // the host has sent its hello
+    uint8_t streams;      // hello bitmap
+};
+
+struct signal_t {
+    uint16_t handle;
+    uint8_t length;
+    uint8_t bytes[kSignalMaxBytes];
+};
+
+struct tx_sdu_t {
+    uint16_t length;
+    uint8_t bytes[kTxSduBytes];
+};
+
+channel_t g_channel = {};
+
+// Signaling replies and credits, queued while ArduinoBLE polls the transport
+// (sending from there would re-enter HCI.poll()) and sent by l2cap_module_service().
+signal_t g_signals[kSignalQueue];
+size_t g_signal_count = 0;
+uint8_t g_signal_id = 0;
+
+// K-frame being reassembled from ACL fragments.
+uint8_t g_pdu[BLE_L2CAP_MPS];
+size_t g_pdu_length = 0;
+size_t g_pdu_left = 0;
+
+// Inbound SDUs back to back as uint16 length + bytes. A credit is granted only
+// for MPS bytes that are free and not already promised to an outstanding
+// credit, so the central can never overrun the ring.
+uint8_t g_rx_ring[kRxRingBytes];
+size_t g_rx_head = 0;
+size_t g_rx_used = 0;
+size_t g_rx_sdus = 0;       // complete SDUs in the ring
+size_t g_rx_sdu_left = 0;   // bytes of the SDU being received still to come
+// SDU being read by l2cap_module_pop().
+uint8_t g_rx_sdu[BLE_L2CAP_MTU];
+size_t g_rx_sdu_length = 0;
+size_t g_rx_sdu_pos = 0;
+
+// Outbound: g_tx_count complete SDUs from g_tx_head, then the one being filled.
+tx_sdu_t g_tx[BLE_L2CAP_TX_SDUS];
+size_t g_tx_head = 0;
+size_t g_tx_count = 0;
+size_t g_tx_offset = 0;  // bytes of the head SDU already sent
+
+uint16_t get_u16(const uint8_t* src) {
+    return static_cast<uint16_t>(src[0] | (src[1] << 8));
+}
+
+void put_u16(uint8_t* dst, uint16_t value) {
+    dst[0] = static_cast<uint8_t>(value);
+    dst[1] = static_cast<uint8_t>(value >> 8);
+}
+
+void queue_signal(uint16_t handle, const uint8_t* bytes, size_t length) {
+    if (g_signal_count == kSignalQueue) {
+        LOG_WARN("[L2CAP] Signaling queue full, command 0x%02x dropped\n", (unsigned)bytes[0]);
+        return;
+    }
+    signal_t& signal = g_signals[g_signal_count++];
+    signal.handle = handle;
+    signal.length = static_cast<uint8_t>(length);
+    memcpy(signal.bytes, bytes, length);
+}
+
+uint8_t next_signal_id() {
+    g_signal_id = g_signal_id == 0xFF ? 1 : g_signal_id + 1;
+    return g_signal_id;
+}
+
+void reset_buffers() {
+    g_pdu_left = 0;
+    g_rx_head = 0;
+    g_rx_used = 0;
+    g_rx_sdus = 0;
+    g_rx_sdu_left = 0;
+    g_rx_sdu_length = 0;
+    g_rx_sdu_pos = 0;
+    for (tx_sdu_t& sdu : g_tx) {
+        sdu.length = 0;
+    }
+    g_tx_head = 0;
+    g_tx_count = 0;
+    g_tx_offset = 0;
+}
+
+/**
+ * Closes the channel. With a reason (a protocol error of the central) the
+ * device asks the central to disconnect it; without, the link or the central
+ * already did.
+ */
+void close_channel(const char* reason) {
+    if (!g_channel.open) {
+        return;
+    }
+    if (reason != nullptr) {
+        LOG_WARN("[L2CAP] Closing the channel: %s\n", reason);
+        uint8_t request[8] = {kDisconnectionRequest, next_signal_id(), 4, 0};
+        put_u16(request + 4, g_channel.remote_cid);
+        put_u16(request + 6, kLocalCid);
+        queue_signal(g_channel.handle, request, sizeof(request));
+    } else {
+        LOG_INFO("[L2CAP] Channel closed\n");
+    }
+    g_channel = {};
+    reset_buffers();
+}
+
+void connection_request(uint16_t handle, uint8_t id, const uint8_t* params) {
+    const uint16_t psm = get_u16(params);
+    const uint16_t source_cid = get_u16(params + 2);
+    const uint16_t mtu = get_u16(params + 4);
+    const uint16_t mps = get_u16(params + 6);
+    uint16_t result = kResultSuccess;
+    if (psm != BLE_L2CAP_PSM) {
+        result = kResultPsmNotSupported;
+    } else if (g_channel.open) {
+        result = kResultNoResources;
+    } else if (source_cid < kLocalCid || source_cid > kDynamicCidLast) {
+        result = kResultInvalidSourceCid;
+    } else if (mtu < kMinMtu || mps < kMinMtu) {
+        result = kResultUnacceptableParameters;
+    }
+    const bool accepted = result == kResultSuccess;
+    if (accepted) {
+        reset_buffers();
+        g_channel.open = true;
+        g_channel.handle = handle;
+        g_channel.remote_cid = source_cid;
+        g_channel.remote_mtu = mtu;
+        g_channel.remote_mps = mps;
+        g_channel.tx_credits = get_u16(params + 8);
+        g_channel.rx_credits = BLE_L2CAP_RX_FRAMES;
+        g_channel.hello = false;
+        g_channel.streams = 0;
+        LOG_INFO("[L2CAP] Channel opened: central MTU %u, MPS %u, %u credits\n", (unsigned)mtu, (unsigned)mps,
+                 (unsigned)g_channel.tx_credits);
+    } else {
+        LOG_WARN("[L2CAP] Channel request on SPSM 0x%04x refused (0x%04x)\n", (unsigned)psm, (unsigned)result);
+    }
+    uint8_t response[14] = {kCreditConnectionResponse, id, 10, 0};
+    put_u16(response + 4, accepted ? kLocalCid : 0);
+    put_u16(response + 6, BLE_L2CAP_MTU);
+    put_u16(response + 8, BLE_L2CAP_MPS);
+    put_u16(response + 10, accepted ? BLE_L2CAP_RX_FRAMES : 0);
+    put_u16(response + 12, result);
+    queue_signal(handle, response, sizeof(response));
+}
+
+/**
+ * LE signaling commands for credit-based channels; the rest (connection
+ * parameter updates) is left to ArduinoBLE.
+ * @return true if the command was taken.
+ */
+bool handle_signaling(uint16_t handle, const uint8_t* command, size_t length) {
+    if (length < 4) {
+        return false;
+    }
+    const uint8_t code = command[0];
+    const uint8_t id = command[1];
+    const uint8_t* params = command + 4;
+    const size_t params_length = get_u16(command + 2) < length - 4 ? get_u16(command + 2) : length - 4;
+    const bool ours = g_channel.open && handle == g_channel.handle;
+    switch (code) {
+    case kCreditConnectionRequest:
+        if (params_length >= 10) {
+            connection_request(handle, id, params);
+        }
+        return true;
+    case kFlowControlCredit:
+        if (params_length >= 4 && ours && get_u16(params) == g_channel.remote_cid) {
+            const uint32_t credits = g_channel.tx_credits + get_u16(params + 2);
+            g_channel.tx_credits = static_cast<uint16_t>(credits > 0xFFFF ? 0xFFFF : credits);
+        }
+        return true;
+    case kDisconnectionRequest:
+        if (params_length < 4 || !ours || get_u16(params) != kLocalCid || get_u16(params + 2) != g_channel.remote_cid) {
+            return false;
+        }
+        {
+            uint8_t response[8] = {kDisconnectionResponse, id, 4, 0};
+            memcpy(response + 4, params, 4);
+            queue_signal(handle, response, sizeof(response));
+        }
+        close_channel(nullptr);
+        return true;
+    default:
+        return false;
+    }
+}
+
+void ring_put(const uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        g_rx_ring[(g_rx_head + g_rx_used + i) % kRxRingBytes] = data[i];
+    }
+    g_rx_used += length;
+}
+
+uint8_t ring_byte(size_t offset) {
+    return g_rx_ring[(g_rx_head + offset) % kRxRingBytes];
+}
+
+void handle_kframe(const uint8_t* data, size_t length) {
+    if (g_channel.rx_credits == 0) {
+        close_channel("K-frame without a credit");
+        return;
+    }
+    g_channel.rx_credits--;
+    size_t at = 0;
+    if (g_rx_sdu_left == 0) {
+        const uint16_t sdu_length = length >= kSduHeaderBytes ? get_u16(data) : 0;
+        if (sdu_length == 0 || sdu_length > BLE_L2CAP_MTU) {
+            close_channel("SDU length outside the MTU");
+            return;
+        }
+        ring_put(data, kSduHeaderBytes);
+        g_rx_sdu_left = sdu_length;
+        at = kSduHeaderBytes;
+    }
+    if (length - at > g_rx_sdu_left) {
+        close_channel("K-frame beyond its SDU");
+        return;
+    }
+    ring_put(data + at, length - at);
+    g_rx_sdu_left -= length - at;
+    if (g_rx_sdu_left == 0) {
+        g_rx_sdus++;
+    }
+}
+
+void add_pdu_bytes(const uint8_t* data, size_t length) {
+    const size_t take = length < g_pdu_left ? length : g_pdu_left;
+    memcpy(g_pdu + g_pdu_length, data, take);
+    g_pdu_length += take;
+    g_pdu_left -= take;
+    if (g_pdu_left == 0) {
+        handle_kframe(g_pdu, g_pdu_length);
+    }
+}
+
+/**
+ * Takes the channel's traffic out of a complete HCI packet from the controller.
+ * @return true if the packet was consumed (ArduinoBLE does not see it).
+ */
+bool intercept(const uint8_t* packet, size_t length) {
+    if (packet[0] == kHciEventPacket) {
+        // Disconnection Complete: status, handle, reason. Passed on either way.
+        if (length >= 7 && packet[1] == kHciDisconnectionComplete && packet[3] == 0 && g_channel.open &&
+            (get_u16(packet + 4) & 0x0FFF) == g_channel.handle) {
+            close_channel(nullptr);
+        }
+        return false;
+    }
+    if (packet[0] != kHciAclPacket || length < 5) {
+        return false;
+    }
+    const uint16_t handle = get_u16(packet + 1) & 0x0FFF;
+    const uint8_t boundary = (packet[2] >> 4) & 0x03;
+    const uint8_t* data = packet + 5;
+    const size_t data_length = length - 5;
+    const bool ours = g_channel.open && handle == g_channel.handle;
+    if (boundary == kAclContinuation) {
+        if (!ours || g_pdu_left == 0) {
+            return false;
+        }
+        add_pdu_bytes(data, data_length);
+        return true;
+    }
+    if (ours) {
+        // A new PDU on the link ends an unfinished one.
+        g_pdu_left = 0;
+    }
+    if (data_length < 4) {
+        return false;
+    }
+    const uint16_t pdu_length = get_u16(data);
+    const uint16_t cid = get_u16(data + 2);
+    if (cid == kSignalingCid) {
+        return handle_signaling(handle, data + 4, data_length - 4);
+    }
+    if (cid != kLocalCid || !ours) {
+        return false;
+    }
+    if (pdu_length > BLE_L2CAP_MPS || pdu_length == 0) {
+        close_channel("K-frame length outside the MPS");
+        return true;
+    }
+    g_pdu_length = 0;
+    g_pdu_left = pdu_length;
+    add_pdu_bytes(data + 4, data_length - 4);
+    return true;
+}
+
+/**
+ * Sits between ArduinoBLE's HCI layer and the Cordio transport. It reads one
+ * complete HCI packet at a time, keeps the ones intercept() takes and hands
+ * the rest to HCI.poll() byte by byte as they came.
+ */
+class FilteringTransport : public HCITransportInterface {
+public:
+    int begin() override {
+        length_ = 0;
+        pass_pos_ = 0;
+        pass_length_ = 0;
+        raw_left_ = 0;
+        return HCITransport.begin();
+    }
+
+    void end() override {
+        close_channel(nullptr);
+        HCITransport.end();
+    }
+
+    void wait(unsigned long timeout) override {
+        if (pass_pos_ == pass_length_) {
+            HCITransport.wait(timeout);
+        }
+    }
+
+    int available() override {
+        fill();
+        return static_cast<int>(pass_length_ - pass_pos_);
+    }
+
+    int peek() override {
+        fill();
+        return pass_pos_ < pass_length_ ? packet_[pass_pos_] : -1;
+    }
+
+    int read() override {
+        fill();
+        return pass_pos_ < pass_length_ ? packet_[pass_pos_++] : -1;
+    }
+
+    size_t write(const uint8_t* data, size_t length) override {
+        return HCITransport.write(data, length);
+    }
+
+private:
+    // Length of the packet in packet_ from its header, 0 while the header is incomplete.
+    size_t packet_total() const {
+        switch (packet_[0]) {
+        case kHciAclPacket:
+            return length_ >= 5 ? 5 + get_u16(packet_ + 3) : 0;
+        case kHciEventPacket:
+            return length_ >= 3 ? 3 + packet_[2] : 0;
+        default:
+            // Nothing else comes from an LE controller; passed on as it is.
+            return length_;
+        }
+    }
+
+    void fill() {
+        if (pass_pos_ < pass_length_) {
+            return;
+        }
+        pass_pos_ = 0;
+        pass_length_ = 0;
+        while (HCITransport.available()) {
+            if (raw_left_ > 0) {
+                // The rest of a packet too long to inspect goes straight through.
+                while (raw_left_ > 0 && pass_length_ < sizeof(packet_) && HCITransport.available()) {
+                    packet_[pass_length_++] = static_cast<uint8_t>(HCITransport.read());
+                    raw_left_--;
+                }
+                return;
+            }
+            packet_[length_++] = static_cast<uint8_t>(HCITransport.read());
+            const size_t total = packet_total();
+            if (total == 0 || (length_ < total && total <= sizeof(packet_))) {
+                continue;
+            }
+            const size_t length = length_;
+            length_ = 0;
+            if (total > length) {
+                raw_left_ = total - length;
+                pass_length_ = length;
+                return;
+            }
+            if (!intercept(packet_, length)) {
+                pass_length_ = length;
+                return;
+            }
+        }
+    }
+
+    uint8_t packet_[kHciPacketMax];
+    size_t length_ = 0;       // bytes of the packet being assembled
+    size_t pass_pos_ = 0;     // packet_[pass_pos_, pass_length_) is waiting for HCI.poll()
+    size_t pass_length_ = 0;
+    size_t raw_left_ = 0;
+};
+
+FilteringTransport g_transport;
+
+void handle_hello(const uint8_t* payload, size_t length) {
+    if (length < 1) {
+        return;
+    }
+    if (!g_channel.hello || payload[0] != g_channel.streams) {
+        LOG_INFO("[L2CAP] Streams 0x%02x\n", (unsigned)payload[0]);
+    }
+    g_channel.hello = true;
+    g_channel.streams = payload[0];
+    const uint8_t reply[3] = {payload[0], L2CAP_BULK_VERSION, WIRE_SCHEMA_VERSION};
+    l2cap_module_send(USB_FRAME_HELLO, reply, sizeof(reply));
+}
+
+bool take_sdu() {
+    if (g_rx_sdus == 0) {
+        return false;
+    }
+    const size_t length = ring_byte(0) | (ring_byte(1) << 8);
+    for (size_t i = 0; i < length; i++) {
+        g_rx_sdu[i] = ring_byte(kSduHeaderBytes + i);
+    }
+    g_rx_head = (g_rx_head + kSduHeaderBytes + length) % kRxRingBytes;
+    g_rx_used -= kSduHeaderBytes + length;
+    g_rx_sdus--;
+    g_rx_sdu_length = length;
+    g_rx_sdu_pos = 0;
+    return true;
+}
+
+// Record type to the hello bit that selects it; 0 = sent whenever the channel is open.
+bool bulk_stream(uint8_t type, uint8_t* out_stream) {
+    switch (type) {
+    case USB_FRAME_RECORD_DATA:
+        *out_stream = USB_STREAM_RECORD;
+        return true;
+    case USB_FRAME_WINDOW:
+        *out_stream = USB_STREAM_WINDOW;
+        return true;
+    case USB_FRAME_TRACE:
+        *out_stream = USB_STREAM_TRACE;
+        return true;
+    case USB_FRAME_TELEMETRY_DATA:
+        *out_stream = 0;
+        return true;
+    default:
+        return false;
+    }
+}
+
+tx_sdu_t& filling_sdu() {
+    return g_tx[(g_tx_head + g_tx_count) % BLE_L2CAP_TX_SDUS];
+}
+
+void send_kframes() {
+    const size_t mps = g_channel.remote_mps < BLE_L2CAP_MPS ? g_channel.remote_mps : BLE_L2CAP_MPS;
+    while (g_channel.open && g_channel.tx_credits > 0 && g_tx_count > 0) {
+        const tx_sdu_t& sdu = g_tx[g_tx_head];
+        uint8_t frame[BLE_L2CAP_MPS];
+        size_t length = 0;
+        if (g_tx_offset == 0) {
+            put_u16(frame, sdu.length);
+            length = kSduHeaderBytes;
+        }
+        const size_t chunk = sdu.length - g_tx_offset < mps - length ? sdu.length - g_tx_offset : mps - length;
+        memcpy(frame + length, sdu.bytes + g_tx_offset, chunk);
+        length += chunk;
+        // May poll the stack while the controller's buffers are full; the channel can close meanwhile.
+        HCI.sendAclPkt(g_channel.handle, static_cast<uint8_t>(g_channel.remote_cid), static_cast<uint8_t>(length),
+                       frame);
+        if (!g_channel.open) {
+            return;
+        }
+        g_channel.tx_credits--;
+        g_tx_offset += chunk;
+        if (g_tx_offset == sdu.length) {
+            g_tx[g_tx_head].length = 0;
+            g_tx_head = (g_tx_head + 1) % BLE_L2CAP_TX_SDUS;
+            g_tx_count--;
+            g_tx_offset = 0;
+        }
+    }
+}
+
+}  // namespace
+
+void l2cap_module_install() {
+    HCI.setTransport(&g_transport);
+}
+
+void l2cap_module_service() {
+    if (g_channel.open) {
+        // Credits go back in batches of at least half the window, not one indication per K-frame.
+        const size_t promised = g_channel.rx_credits * BLE_L2CAP_MPS + g_rx_used;
+        const size_t grant = promised < kRxRingBytes ? (kRxRingBytes - promised) / BLE_L2CAP_MPS : 0;
+        if (grant >= (BLE_L2CAP_RX_FRAMES + 1) / 2) {
+            uint8_t credit[8] = {kFlowControlCredit, next_signal_id(), 4, 0};
+            put_u16(credit + 4, kLocalCid);
+            put_u16(credit + 6, static_cast<uint16_t>(grant));
+            queue_signal(g_channel.handle, credit, sizeof(credit));
+            g_channel.rx_credits += static_cast<uint16_t>(grant);
+        }
+    }
+    // Sending polls the stack when the controller is out of buffers, which can queue more.
+    while (g_signal_count > 0) {
+        const signal_t signal = g_signals[0];
+        g_signal_count--;
+        memmove(g_signals, g_signals + 1, g_signal_count * sizeof(signal_t));
+        HCI.sendAclPkt(signal.handle, static_cast<uint8_t>(kSignalingCid), signal.length,
+                       const_cast<uint8_t*>(signal.bytes));
+    }
+    send_kframes();
+}
+
+bool l2cap_module_open() {
+    return g_channel.open && g_channel.hello;
+}
+
+bool l2cap_module_subscribed(uint8_t type) {
+    uint8_t stream;
+    return bulk_stream(type, &stream) && l2cap_module_open() && (stream == 0 || (g_channel.streams & stream) != 0);
+}
+
+bool l2cap_module_send(uint8_t type, const uint8_t* payload, size_t length) {
+    const size_t capacity = g_channel.remote_mtu < kTxSduBytes ? g_channel.remote_mtu : kTxSduBytes;
+    if (!g_channel.open || length > L2CAP_RECORD_MAX || kRecordHeaderBytes + length > capacity) {
+        return false;
+    }
+    if (g_tx_count == BLE_L2CAP_TX_SDUS) {
+        return false;
+    }
+    if (filling_sdu().length + kRecordHeaderBytes + length > capacity) {
+        l2cap_module_flush();
+        if (g_tx_count == BLE_L2CAP_TX_SDUS) {
+            return false;
+        }
+    }
+    tx_sdu_t& sdu = filling_sdu();
+    sdu.bytes[sdu.length] = type;
+    sdu.bytes[sdu.length + 1] = static_cast<uint8_t>(length);
+    memcpy(sdu.bytes + sdu.length + kRecordHeaderBytes, payload, length);
+    sdu.length = static_cast<uint16_t>(sdu.length + kRecordHeaderBytes + length);
+    return true;
+}
+
+void l2cap_module_flush() {
+    if (g_tx_count < BLE_L2CAP_TX_SDUS && filling_sdu().length > 0) {
+        g_tx_count++;
+    }
+}
+
+bool l2cap_module_pop(l2cap_record_t* out_record) {
+    for (;;) {
+        if (g_rx_sdu_pos >= g_rx_sdu_length && !take_sdu()) {
+            return false;
+        }
+        const size_t left = g_rx_sdu_length - g_rx_sdu_pos;
+        const uint8_t* record = g_rx_sdu + g_rx_sdu_pos;
+        if (left < kRecordHeaderBytes || kRecordHeaderBytes + record[1] > left) {
+            LOG_WARN("[L2CAP] Truncated record dropped\n");
+            g_rx_sdu_pos = g_rx_sdu_length;
+            continue;
+        }
+        g_rx_sdu_pos += kRecordHeaderBytes + record[1];
+        if (record[0] == USB_FRAME_HELLO) {
+            handle_hello(record + kRecordHeaderBytes, record[1]);
+            continue;
+        }
+        out_record->type = record[0];
+        out_record->length = record[1];
+        memcpy(out_record->data, record + kRecordHeaderBytes, record[1]);
+        return true;
+    }
+}
+
+#endif
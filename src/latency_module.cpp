@@ -0,0 +1,85 @@
+// 端到端延迟追踪模块实现
+#include <Arduino.h>
+
+#include "app_config.h"
+#include "latency_module.h"
+#include "log_module.h"
+#include "seqlock.h"
+#include "stat_counters.h"
+#include "stats_module.h"
+
+#define LATENCY_SLO_US ((uint32_t)LATENCY_SLO_MS * 1000UL)
+
+// 128 个 2 ms 桶（量程 256 ms）
+#define LATENCY_BUCKETS 128
+#define LATENCY_BUCKET_US 2000
+
+// ==================== 内部状态（模块私有） ====================
+
+static const char* const kStageNames[LATENCY_STAGE_COUNT] = {"inference", "notify", "ack"};
+// 统计注册表中的名称（当前窗口内的分布）
+static const char* const kStatNames[LATENCY_STAGE_COUNT] = {"latency.inference_us", "latency.notify_us",
+                                                            "latency.ack_us"};
+
+struct latency_snapshot_t {
+    latency_stats_t stages[LATENCY_STAGE_COUNT];
+};
+
+// 当前窗口的直方图（各阶段的线程无锁记录，报告时取出清零）与上一个窗口的快照（报告者发布，任意线程读取）
+static StatHistogram<LATENCY_BUCKETS> g_histograms[LATENCY_STAGE_COUNT] = {
+    StatHistogram<LATENCY_BUCKETS>(LATENCY_BUCKET_US), StatHistogram<LATENCY_BUCKETS>(LATENCY_BUCKET_US),
+    StatHistogram<LATENCY_BUCKETS>(LATENCY_BUCKET_US)};
+static Seqlock<latency_snapshot_t> g_snapshots;
+
+// ==================== 公共接口实现 ====================
+
+void latency_module_init() {
+    for (size_t i = 0; i < LATENCY_STAGE_COUNT; i++) {
+        stats_module_register(kStatNames[i], &g_histograms[i]);
+    }
+}
+
+void latency_module_record(latency_stage_t stage, uint32_t sample_us) {
+    if (stage >= LATENCY_STAGE_COUNT || sample_us == 0) {
+        return;
+    }
+    g_histograms[stage].record(micros() - sample_us);
+}
+
+void latency_module_get_stats(latency_stage_t stage, latency_stats_t* out_stats) {
+    if (!out_stats || stage >= LATENCY_STAGE_COUNT) {
+        return;
+    }
+    latency_snapshot_t snapshot;
+    g_snapshots.load(&snapshot);
+    *out_stats = snapshot.stages[stage];
+}
+
+void latency_module_report() {
+    latency_snapshot_t snapshot;
+    latency_stats_t* stats = snapshot.stages;
+    for (size_t i = 0; i < LATENCY_STAGE_COUNT; i++) {
+        StatBins<LATENCY_BUCKETS> bins;
+        g_histograms[i].take(&bins);
+        stats[i].count = bins.count;
+        stats[i].p50_us = bins.percentile(0.50f);
+        stats[i].p95_us = bins.percentile(0.95f);
+        stats[i].p99_us = bins.percentile(0.99f);
+        stats[i].max_us = bins.max;
+        stats[i].over_slo = bins.count_at_least(LATENCY_SLO_US);
+    }
+    g_snapshots.store(snapshot);
+
+    for (size_t i = 0; i < LATENCY_STAGE_COUNT; i++) {
+        if (stats[i].count == 0) {
+            continue;
+        }
+        LOG_INFO("[Latency] %-9s n %lu, p50 %lu us, p95 %lu us, p99 %lu us, max %lu us, over %d ms %lu\n",
+                 kStageNames[i], (unsigned long)stats[i].count, (unsigned long)stats[i].p50_us,
+                 (unsigned long)stats[i].p95_us, (unsigned long)stats[i].p99_us, (unsigned long)stats[i].max_us,
+                 (int)LATENCY_SLO_MS, (unsigned long)stats[i].over_slo);
+        if (stats[i].p99_us >= LATENCY_SLO_US) {
+            LOG_WARN("[Latency] %s p99 above the %d ms target\n", kStageNames[i], (int)LATENCY_SLO_MS);
+        }
+    }
+}
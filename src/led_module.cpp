@@ -1,70 +1,314 @@
 // LED control implementation
 #include <Arduino.h>
+#include "mbed.h"
 #include "rtos.h"
 #include <chrono>
 #include <cstring>
 
+#include "app_config.h"
+#if PLATFORM_NICLA
+#include "Nicla_System.h"
+#endif
+#include "config_module.h"
+#include "event_module.h"
+#include "gesture_labels.h"
 #include "led_module.h"
 #include "inference_module.h"
+#include "pipeline_module.h"
+#include "profiler_module.h"
+#include "spsc_ring.h"
 
-// Local helper to drive the built-in RGB LED (active low on Nano 33 BLE Sense).
-static void set_led_color(int r, int g, int b) {
-    digitalWrite(LEDR, r);
-    digitalWrite(LEDG, g);
-    digitalWrite(LEDB, b);
+#if LED_ENABLE
+
+// ==================== Internal state ====================
+
+#if PLATFORM_NICLA
+// The Nicla Sense ME's RGB LED sits behind an I2C driver that cannot be written from the animation
+// interrupt: the interrupt only records the colour and posts an LED event, whose handler sends it.
+static volatile uint32_t g_pending_rgb = 0;
+static volatile bool g_rgb_dirty = false;
+#else
+// Hardware PWM channels of the built-in RGB LED (active low on Nano 33 BLE Sense).
+static mbed::PwmOut* g_pwm[3] = {nullptr, nullptr, nullptr};
+#endif
+
+// Filled by the LED event handler, drained by the animation interrupt.
+static SpscRing<led_pattern_t, LED_QUEUE_PATTERNS> g_pattern_queue;
+
+// Animation state. Owned by the Timeout interrupt while an animation is running; once the
+// engine goes idle the LED event handler restarts it from inside a critical section.
+static mbed::Timeout g_step_timeout;
+static volatile bool g_engine_idle = true;
+static led_pattern_t g_pattern = {};
+static uint8_t g_frame = 0;
+static uint8_t g_repeats_left = 0;
+static uint8_t g_from[3] = {0, 0, 0};
+static uint8_t g_color[3] = {0, 0, 0};
+static uint16_t g_fade_steps = 0;
+static uint16_t g_fade_step = 0;
+static bool g_hold_pending = false;
+
+// What the LED settles on once queued animations finish, so repeated idle / low-confidence
+// results (one per inference step) do not flood the animation queue.
+static enum { STEADY_OFF, STEADY_IDLE } g_steady = STEADY_OFF;
+
+// ==================== Internal helpers ====================
+
+#if PLATFORM_NICLA
+// Gamma 2 so that fades and brightness levels look linear.
+static void write_color(const uint8_t color[3]) {
+    uint32_t rgb = 0;
+    for (int c = 0; c < 3; c++) {
+        rgb = (rgb << 8) | (uint32_t)((color[c] * color[c] + 127) / 255);
+    }
+    g_pending_rgb = rgb;
+    g_rgb_dirty = true;
+    event_module_post(EVENT_LED);
 }
 
-void led_module_init() {
-    pinMode(LEDR, OUTPUT);
-    pinMode(LEDG, OUTPUT);
-    pinMode(LEDB, OUTPUT);
-    set_led_color(HIGH, HIGH, HIGH);
+static void flush_color() {
+    if (g_rgb_dirty) {
+        g_rgb_dirty = false;
+        const uint32_t rgb = g_pending_rgb;
+        nicla::leds.setColor((uint8_t)(rgb >> 16), (uint8_t)(rgb >> 8), (uint8_t)rgb);
+    }
+}
+#else
+// Gamma 2 so that fades and brightness levels look linear; the output is inverted (active low).
+static void write_color(const uint8_t color[3]) {
+    for (int c = 0; c < 3; c++) {
+        const float level = color[c] / 255.0f;
+        g_pwm[c]->write(1.0f - level * level);
+    }
 }
+#endif
 
-void led_control_task() {
-    const int OFF = HIGH;
-    const int ON = LOW;
-    const int GESTURE_LIGHT_DURATION_MS = 500;
-    uint32_t last_sequence = 0;
+static void frame_target(uint8_t target[3]) {
+    const led_keyframe_t& frame = g_pattern.frames[g_frame];
+    target[0] = frame.r;
+    target[1] = frame.g;
+    target[2] = frame.b;
+}
 
-    for (;;) {
-        int prediction_index = -1;
-        float confidence = 0.0f;
-        uint32_t sequence = 0;
+static void begin_frame() {
+    memcpy(g_from, g_color, sizeof(g_from));
+    g_fade_steps = g_pattern.frames[g_frame].fade_ms / LED_FADE_STEP_MS;
+    g_fade_step = 0;
+    g_hold_pending = true;
+    if (g_fade_steps == 0) {
+        frame_target(g_color);
+        write_color(g_color);
+    }
+}
 
-        // Snapshot the latest inference result.
-        inference_get_result_with_seq(&prediction_index, &confidence, &sequence);
+// Moves to the next keyframe: the rest of this pattern, its repeats, then the next queued pattern.
+static bool next_frame() {
+    if (g_frame + 1 < g_pattern.count) {
+        g_frame++;
+    } else if (g_repeats_left > 0) {
+        g_repeats_left--;
+        g_frame = 0;
+    } else if (g_pattern_queue.pop(&g_pattern, 1)) {
+        g_frame = 0;
+        g_repeats_left = g_pattern.repeat;
+    } else {
+        g_pattern.count = 0;
+        return false;
+    }
+    begin_frame();
+    return true;
+}
 
-        if (sequence == last_sequence) {
-            // Nothing new to show, yield the CPU briefly.
-            rtos::ThisThread::sleep_for(std::chrono::milliseconds(100));
-            continue;
+// Runs in the Timeout interrupt. Between keyframes the PWM hardware holds the colour on its own;
+// the interrupt only fires for fade steps and at the end of each hold.
+static void engine_step() {
+    for (;;) {
+        if (g_fade_step < g_fade_steps) {
+            g_fade_step++;
+            uint8_t target[3];
+            frame_target(target);
+            for (int c = 0; c < 3; c++) {
+                g_color[c] = (uint8_t)(g_from[c] + ((int)target[c] - g_from[c]) * g_fade_step / g_fade_steps);
+            }
+            write_color(g_color);
+            if (g_fade_step < g_fade_steps) {
+                g_step_timeout.attach(engine_step, std::chrono::milliseconds(LED_FADE_STEP_MS));
+                return;
+            }
         }
-        last_sequence = sequence;
-
-        if (confidence > 0.80f && prediction_index != -1) {
-            const char* prediction = inference_get_category_name(prediction_index);
-            bool is_gesture = (strcmp(prediction, "idle") != 0 && strcmp(prediction, "unknown") != 0);
-
-            if (is_gesture) {
-                if (strcmp(prediction, "up") == 0)        set_led_color(OFF, ON, OFF);   // green
-                else if (strcmp(prediction, "down") == 0) set_led_color(ON, ON, OFF);   // yellow
-                else if (strcmp(prediction, "right") == 0)set_led_color(ON, OFF, ON);   // purple
-                else if (strcmp(prediction, "left") == 0) set_led_color(OFF, OFF, ON);  // blue
-
-                rtos::ThisThread::sleep_for(std::chrono::milliseconds(GESTURE_LIGHT_DURATION_MS));
-                set_led_color(OFF, OFF, OFF);
-            } else {
-                if (strcmp(prediction, "idle") == 0) {
-                    set_led_color(ON, OFF, OFF);  // red
-                } else { // unknown
-                    set_led_color(OFF, OFF, OFF);
-                }
+        if (g_hold_pending) {
+            g_hold_pending = false;
+            const uint16_t hold_ms = g_pattern.frames[g_frame].hold_ms;
+            if (hold_ms > 0) {
+                g_step_timeout.attach(engine_step, std::chrono::milliseconds(hold_ms));
+                return;
+            }
+        }
+        if (!next_frame()) {
+            // Nothing queued: keep showing the last colour until led_module_play() restarts us.
+            g_engine_idle = true;
+            return;
+        }
+    }
+}
+
+static led_pattern_t solid(uint8_t r, uint8_t g, uint8_t b, uint16_t fade_ms) {
+    led_pattern_t pattern = {};
+    pattern.frames[0] = {r, g, b, fade_ms, 0};
+    pattern.count = 1;
+    return pattern;
+}
+
+// Fades in, holds, fades out and ends dark.
+static led_pattern_t flash(uint8_t r, uint8_t g, uint8_t b, uint16_t duration_ms) {
+    const uint16_t fade_ms = 60;
+    led_pattern_t pattern = {};
+    pattern.frames[0] = {r, g, b, fade_ms, (uint16_t)(duration_ms > 2 * fade_ms ? duration_ms - 2 * fade_ms : 0)};
+    pattern.frames[1] = {0, 0, 0, fade_ms, 0};
+    pattern.count = 2;
+    return pattern;
+}
+
+static led_pattern_t blink(uint8_t r, uint8_t g, uint8_t b, uint16_t on_ms, uint16_t off_ms, uint8_t times) {
+    led_pattern_t pattern = {};
+    pattern.frames[0] = {r, g, b, 0, on_ms};
+    pattern.frames[1] = {0, 0, 0, 0, off_ms};
+    pattern.count = 2;
+    pattern.repeat = times > 0 ? times - 1 : 0;
+    return pattern;
+}
+
+// Maps confidence threshold..1 to brightness LED_MIN_BRIGHTNESS..1.
+static uint8_t scale(uint8_t level, float confidence, float threshold) {
+    float t = threshold < 1.0f ? (confidence - threshold) / (1.0f - threshold) : 1.0f;
+    t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+    const float brightness = LED_MIN_BRIGHTNESS + (1.0f - LED_MIN_BRIGHTNESS) * t;
+    return (uint8_t)(level * brightness + 0.5f);
+}
+
+// Turns one published result into an animation.
+static void show_result(const inference_result_snapshot_t& event) {
+    const uint32_t start_us = micros();
+    const uint32_t zone_start = profiler_zone_now();
+    const int prediction_index = event.index;
+    const float confidence = inference_confidence_value(event.confidence_q);
+    // The threshold is runtime configuration (config_module), read once per result.
+    runtime_config_t config;
+    config_module_get(&config);
+    const float threshold = config.led_confidence_threshold;
+
+    if (confidence > threshold && prediction_index >= 0 && prediction_index < GESTURE_LABEL_COUNT) {
+        // Colours and kinds come from the generated label table: no string handling per result.
+        const gesture_label_info_t& label = kGestureLabels[prediction_index];
+
+        if (label.kind == GESTURE_KIND_IDLE) {
+            if (g_steady != STEADY_IDLE && led_module_play(solid(label.r, label.g, label.b, 100))) {
+                g_steady = STEADY_IDLE;
+            }
+        } else if (label.kind == GESTURE_KIND_UNKNOWN) {
+            if (led_module_play(blink(label.r, label.g, label.b, 80, 80, 2))) {  // double blink
+                g_steady = STEADY_OFF;
             }
         } else {
-            set_led_color(OFF, OFF, OFF);
+            if (led_module_play(flash(scale(label.r, confidence, threshold), scale(label.g, confidence, threshold),
+                                      scale(label.b, confidence, threshold), LED_GESTURE_MS))) {
+                g_steady = STEADY_OFF;
+            }
         }
+    } else if (g_steady != STEADY_OFF && led_module_play(solid(0, 0, 0, 100))) {
+        g_steady = STEADY_OFF;
+    }
+    pipeline_module_record(PIPELINE_LED, start_us);
+    profiler_zone_record(ZONE_LED, zone_start);
+}
+
+// Runs in the inference thread as each result is published: hands the work to the event thread.
+static void on_result_published() {
+    event_module_post(EVENT_LED);
+}
+
+// ==================== Public API ====================
+
+void led_module_init() {
+#if PLATFORM_NICLA
+    // Also powers up the board (PMIC), so this runs before the sensors are initialised.
+    nicla::begin();
+    nicla::leds.begin();
+    write_color(g_color);
+    flush_color();
+#else
+    const int pins[3] = {LED_PIN_RED, LED_PIN_GREEN, LED_PIN_BLUE};
+    for (int c = 0; c < 3; c++) {
+        g_pwm[c] = new mbed::PwmOut(digitalPinToPinName(pins[c]));
+        g_pwm[c]->period_us(LED_PWM_PERIOD_US);
+    }
+    write_color(g_color);
+#endif
+    inference_set_result_listener(INFERENCE_CONSUMER_LED, on_result_published);
+}
+
+bool led_module_play(const led_pattern_t& pattern) {
+    if (pattern.count == 0 || pattern.count > LED_MAX_KEYFRAMES) {
+        return false;
+    }
+    if (!g_pattern_queue.push(&pattern, 1)) {
+        return false;
+    }
+    // The interrupt is not armed while the engine is idle, and cannot fire inside the critical
+    // section, so starting the next pattern from this thread does not race with it.
+    mbed::CriticalSectionLock lock;
+    if (g_engine_idle) {
+        g_engine_idle = false;
+        engine_step();
+    }
+    return true;
+}
 
-        rtos::ThisThread::sleep_for(std::chrono::milliseconds(100));
+void led_module_set_enabled(bool enabled) {
+    if (enabled == pipeline_module_subscribed(PIPELINE_OUTPUT_LED)) {
+        return;
     }
+    pipeline_module_subscribe(PIPELINE_OUTPUT_LED, enabled);
+    // The handler drops what was queued and turns a steady colour off.
+    event_module_post(EVENT_LED);
 }
+
+void led_module_on_event() {
+#if PLATFORM_NICLA
+    flush_color();
+#endif
+    inference_result_snapshot_t event;
+    if (!pipeline_module_subscribed(PIPELINE_OUTPUT_LED)) {
+        while (inference_pop_result_event(INFERENCE_CONSUMER_LED, &event)) {
+        }
+        if (g_steady != STEADY_OFF && led_module_play(solid(0, 0, 0, 100))) {
+            g_steady = STEADY_OFF;
+        }
+        return;
+    }
+    // Results are shown in publish order: two quick gestures animate one after the other.
+    while (inference_pop_result_event(INFERENCE_CONSUMER_LED, &event)) {
+        show_result(event);
+    }
+}
+
+#else
+
+// LED_ENABLE=0: no PWM outputs, no pattern queue, and no result events are queued for the LED.
+
+void led_module_init() {
+#if PLATFORM_NICLA
+    // The PMIC still has to be brought up before the sensors.
+    nicla::begin();
+#endif
+}
+
+bool led_module_play(const led_pattern_t&) {
+    return false;
+}
+
+void led_module_set_enabled(bool) {}
+
+void led_module_on_event() {}
+
+#endif
@@ -0,0 +1,178 @@
+// 延迟日志模块实现
+#include <Arduino.h>
+#include "rtos.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "app_config.h"
+#include "log_module.h"
+#include "mpsc_ring.h"
+#if LOG_DEFERRED
+#include "event_module.h"
+#include "record_module.h"
+#endif
+
+// 单条日志格式化后的最大长度（超长截断）
+#define LOG_LINE_BYTES 192
+// 单个转换说明符的最大长度（如 "%-10.3f"）
+#define LOG_SPEC_BYTES 16
+
+// ==================== 内部状态（模块私有） ====================
+
+#if LOG_DEFERRED
+static MpscRing<log_record_t, LOG_QUEUE_RECORDS> g_log_queue;
+static uint32_t g_reported_drops = 0;
+#else
+// 立即输出时多个线程共用一个行缓冲区
+static rtos::Mutex g_log_mutex;
+#endif
+static char g_line[LOG_LINE_BYTES];
+
+// ==================== 内部辅助函数 ====================
+
+/**
+ * @brief 按一个转换说明符格式化一个参数，说明符中的长度修饰符换成参数实际保存的类型
+ */
+static int format_arg(char* dst, size_t size, const char* spec, size_t spec_len, char conversion,
+                      const log_arg_t& arg) {
+    char fmt[LOG_SPEC_BYTES + 2];
+    size_t n = 0;
+    for (size_t i = 0; i < spec_len && n < LOG_SPEC_BYTES - 1; i++) {
+        if (spec[i] != 'l' && spec[i] != 'h' && spec[i] != 'z' && spec[i] != 'j' && spec[i] != 't' &&
+            spec[i] != 'L') {
+            fmt[n++] = spec[i];
+        }
+    }
+    switch (conversion) {
+        case 'd':
+        case 'i':
+            fmt[n++] = 'l';
+            fmt[n++] = conversion;
+            fmt[n] = '\0';
+            return snprintf(dst, size, fmt, (long)arg.i);
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+            fmt[n++] = 'l';
+            fmt[n++] = conversion;
+            fmt[n] = '\0';
+            return snprintf(dst, size, fmt, (unsigned long)arg.u);
+        case 'c':
+            fmt[n++] = conversion;
+            fmt[n] = '\0';
+            return snprintf(dst, size, fmt, (int)arg.i);
+        case 's':
+            fmt[n++] = conversion;
+            fmt[n] = '\0';
+            return snprintf(dst, size, fmt, arg.s ? arg.s : "(null)");
+        case 'p':
+            fmt[n++] = conversion;
+            fmt[n] = '\0';
+            return snprintf(dst, size, fmt, arg.p);
+        default: {  // f F e E g G
+#if LOG_FLOAT_ENABLE
+            fmt[n++] = conversion;
+            fmt[n] = '\0';
+            return snprintf(dst, size, fmt, (double)arg.f);
+#else
+            // 不链接浮点格式化：千分位定点数，超出 ±2e6 的值饱和
+            const float magnitude = fminf(fabsf(arg.f), 2e6f);
+            const unsigned long milli = (unsigned long)lroundf(magnitude * 1000.0f);
+            return snprintf(dst, size, "%s%lu.%03lu", arg.f < 0.0f ? "-" : "", milli / 1000, milli % 1000);
+#endif
+        }
+    }
+}
+
+/**
+ * @brief 把一条记录格式化到 g_line
+ * @return size_t 行长度
+ */
+static size_t format_record(const log_record_t& record) {
+    size_t out = 0;
+    size_t next_arg = 0;
+    const char* p = record.format;
+    while (*p && out < LOG_LINE_BYTES - 1) {
+        if (*p != '%') {
+            g_line[out++] = *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            g_line[out++] = '%';
+            p += 2;
+            continue;
+        }
+        // 说明符：% [标志] [宽度] [.精度] [长度] 转换字符
+        const char* spec = p++;
+        while (*p && strchr("-+ #0123456789.lhzjtL", *p)) {
+            p++;
+        }
+        if (!*p) {
+            break;
+        }
+        const char conversion = *p++;
+        if (next_arg >= record.argc) {
+            break;
+        }
+        const int written = format_arg(g_line + out, LOG_LINE_BYTES - out, spec, (size_t)(p - 1 - spec),
+                                       conversion, record.args[next_arg++]);
+        if (written > 0) {
+            out += (size_t)written < LOG_LINE_BYTES - out ? (size_t)written : LOG_LINE_BYTES - 1 - out;
+        }
+    }
+    g_line[out] = '\0';
+    return out;
+}
+
+static void write_record(const log_record_t& record) {
+    const size_t length = format_record(record);
+    if (length > 0) {
+        Serial.write(reinterpret_cast<const uint8_t*>(g_line), length);
+    }
+}
+
+// ==================== 公共接口实现 ====================
+
+#if LOG_DEFERRED
+void log_module_push(const log_record_t& record) {
+    if (g_log_queue.push(record)) {
+        event_module_post(EVENT_LOG);
+    }
+}
+
+uint32_t log_module_dropped() {
+    return g_log_queue.overruns();
+}
+
+void log_module_drain() {
+    log_record_t record;
+    while (g_log_queue.pop(&record)) {
+        // USB 录制时串口传输二进制包：丢弃文本日志
+        if (record_module_transport() == RECORD_USB) {
+            continue;
+        }
+        write_record(record);
+    }
+    const uint32_t drops = g_log_queue.overruns();
+    if (drops != g_reported_drops && record_module_transport() != RECORD_USB) {
+        snprintf(g_line, sizeof(g_line), "[Log] %lu records dropped (queue full)\n",
+                 (unsigned long)(drops - g_reported_drops));
+        Serial.write(reinterpret_cast<const uint8_t*>(g_line), strlen(g_line));
+        g_reported_drops = drops;
+    }
+}
+#else
+void log_module_push(const log_record_t& record) {
+    g_log_mutex.lock();
+    write_record(record);
+    g_log_mutex.unlock();
+}
+
+uint32_t log_module_dropped() {
+    return 0;
+}
+
+void log_module_drain() {}
+#endif
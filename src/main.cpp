@@ -3,45 +3,132 @@
 #include <Arduino.h>
 #include "rtos.h"
 
+#include "app_config.h"
+#include "alloc_module.h"
+#include "battery_module.h"
+#include "config_module.h"
+#include "core1_module.h"
+#include "crash_module.h"
+#include "energy_module.h"
+#include "event_module.h"
+#include "heap_guard_module.h"
 #include "inference_module.h"
+#include "latency_module.h"
 #include "led_module.h"
 #include "ble_module.h"
-
-// --- Mbed 线程对象 ---
-// 使用相同的优先级 (osPriorityNormal) 实现公平调度
-rtos::Thread inferenceThread(osPriorityNormal, 8192);
-rtos::Thread ledThread(osPriorityNormal);
-rtos::Thread bleThread(osPriorityNormal);
+#include "boot_module.h"
+#include "capture_module.h"
+#include "record_module.h"
+#include "memory_module.h"
+#include "periodic_timer.h"
+#include "pipeline_module.h"
+#include "profiler_module.h"
+#include "radio_module.h"
+#include "supervisor_module.h"
+#include "telemetry_module.h"
+#include "thread_module.h"
+#include "watchdog_module.h"
 
 // --- 主程序 ---
 void setup() {
     Serial.begin(115200);
+    // 上一次若是看门狗复位（推理线程停滞），在这里报告
+    watchdog_module_init();
+#if TELEMETRY_ENABLE
+    // 找到诊断日志的写入位置，并把这次复位的原因写入日志
+    telemetry_module_init();
+#endif
+#if CAPTURE_ENABLE
+    // 主动学习采集区的写入位置
+    capture_module_init();
+#endif
+    // 上一次复位前若有崩溃（或看门狗复位），报告记录下的寄存器、栈峰值与流水线轨迹
+    crash_module_init();
+    // 区段剖析的周期计数器（PROFILER_ZONES_ENABLE 为 0 时为空）
+    profiler_module_init();
+    // 分配检查的自检（HEAP_GUARD_ENABLE 为 0 时为空）
+    heap_guard_module_init();
+    // 诊断统计量登记到统计注册表（stats_module.h），串口 "stats"、诊断命令与统计特征值从那里导出
+    latency_module_init();
+    event_module_init();
+    pipeline_module_init();
+
+    // BLE 线程先启动：协议栈在它自己的线程中启动（失败时按退避重试），与下面的 IMU / 模型初始化并行，
+    // 读取运行时配置前等待 setup 完成
+    if (!thread_module_start_early(THREAD_BLE)) {
+        supervisor_module_fatal("Failed to start the BLE thread");
+    }
 
-    // 初始化推理模块（包括IMU）
-    if (!inference_module_init()) {
-        Serial.println("Failed to initialize inference module!");
-        while (1);
+    // 初始化推理模块（包括IMU 与模型）；瞬时的总线故障按退避重试，仍失败则复位重新上电初始化传感器
+    if (!supervisor_module_init(SUPERVISOR_IMU, inference_module_init, SUPERVISOR_INIT_RETRIES)) {
+        supervisor_module_fatal("Failed to initialize inference module");
     }
+    // 载入保存的运行时配置（阈值、步长、轮询间隔）
+    config_module_init();
+#if BATTERY_LADDER_ENABLE
+    // 按电池电压选择推理的工作点（在运行时配置的步长生效之后）
+    battery_module_init();
+#endif
 
     // 初始化LED模块
     led_module_init();
 
-    // 初始化BLE模块
-    if (!ble_module_init()) {
-        Serial.println("Failed to initialize BLE module!");
-        while (1);
-    }
-
     Serial.println("--- Starting Modularized System ---");
 
-    // 启动线程
-    inferenceThread.start(inference_task);
-    ledThread.start(led_control_task);
-    bleThread.start(ble_task);
+#if POWER_LOW_POWER_MODE && defined(LED_PWR)
+    // 板载电源指示灯常亮约 1 mA，低功耗模式下关闭
+    pinMode(LED_PWR, OUTPUT);
+    digitalWrite(LED_PWR, LOW);
+#endif
+    energy_module_init();
+#if INFERENCE_RADIO_AWARE
+    // 推理线程启动前开始记录连接事件时序（不可用时推理照常运行，只是不避开连接事件）
+    radio_module_init();
+#endif
+    // RP2040 双核：推理线程启动前让核 1 进入作业循环（单核时为空）
+    core1_module_init();
+
+    // 核对热路径缓冲区（窗口、样本环、传感器与链路暂存区、张量 arena）的对齐与所在 RAM，违反的逐条打印，不阻止启动
+    memory_module_check_placement();
+
+    // 按线程表（优先级与栈大小见 app_config.h）启动线程，栈登记后由推理线程在窗口填满时打印 RAM 预算
+    if (!thread_module_start()) {
+        supervisor_module_fatal("Failed to start threads");
+    }
+    boot_module_mark(BOOT_SETUP_DONE);
 
     Serial.println("--- System Ready ---");
 }
 
 void loop() {
-    // 空闲循环 - 所有工作由RTOS线程完成
+    // 所有工作由RTOS线程完成，这里监督各线程（重启已退出或卡死的线程），并定期打印各线程栈峰值与 SDK 分配统计
+    static PeriodicTimer supervisor_timer(std::chrono::milliseconds(SUPERVISOR_POLL_MS));
+    supervisor_timer.wait();
+    supervisor_module_poll();
+#if BATTERY_LADDER_ENABLE
+    battery_module_poll();
+#endif
+#if TELEMETRY_ENABLE
+    // 诊断日志在这里攒批写入 Flash：写入期间暂停的是优先级最低的主线程
+    telemetry_module_poll();
+#endif
+#if CAPTURE_ENABLE
+    // 推理线程采集的含糊窗口同样在这里写入 Flash
+    capture_module_poll();
+#endif
+#if THREAD_REPORT_INTERVAL_MS > 0
+    // 绝对截止时间：报告本身的串口输出时间不会推迟下一次报告
+    static PeriodicTimer report_timer(std::chrono::milliseconds(THREAD_REPORT_INTERVAL_MS));
+    if (!report_timer.expired()) {
+        return;
+    }
+    report_timer.advance();
+    // USB 录制时串口传输二进制包，不能插入文本
+    if (record_module_transport() != RECORD_USB) {
+        thread_module_report();
+        alloc_module_report();
+        supervisor_module_report();
+        core1_module_report();
+    }
+#endif
 }
@@ -0,0 +1,345 @@
+// RAM 预算与共享 scratch 内存模块实现
+#include <Arduino.h>
+#include "rtos.h"
+#include <malloc.h>
+#include <atomic>
+
+#include "app_config.h"
+#include "memory_module.h"
+#include "tflite-model/tflite_learn_792000_36_compiled.h"
+#include "edge-impulse-sdk/dsp/config.hpp"
+#if EIDSP_TRACK_ALLOCATIONS
+#include "edge-impulse-sdk/dsp/memory.hpp"
+#endif
+#if MODEL_INTERPRETER_ENABLE
+#include "interp_module.h"
+#endif
+
+// 登记表容量
+#define MEMORY_MAX_REGIONS 16
+
+#if defined(__MBED__) && defined(__GNUC__)
+// GCC_ARM 链接脚本导出的 RAM 段边界
+extern "C" char __data_start__;
+extern "C" char __bss_end__;
+#define MEMORY_HAS_LINKER_SYMBOLS 1
+#else
+#define MEMORY_HAS_LINKER_SYMBOLS 0
+#endif
+
+// ==================== 内部状态（模块私有） ====================
+
+struct memory_region_t {
+    const char* name;
+    size_t bytes;
+    bool on_heap;
+};
+
+// 各线程启动时都可能登记，用互斥锁保护登记表
+static rtos::Mutex g_regions_mutex;
+static memory_region_t g_regions[MEMORY_MAX_REGIONS];
+static size_t g_region_count = 0;
+static void* volatile g_lease = nullptr;
+
+// 热路径缓冲区登记表：MemoryPlacement 在静态初始化期间登记，不能依赖互斥锁已构造，
+// 与 stats_module 一样原子地领取表项，填好后再置 ready
+struct memory_hot_t {
+    const char* name;
+    const void* buffer;
+    size_t bytes;
+    uint8_t flags;
+    std::atomic<bool> ready;
+};
+static memory_hot_t g_hot[MEMORY_HOT_BUFFER_CAPACITY];
+static std::atomic<uint32_t> g_hot_claimed(0);
+
+#if EIDSP_TRACK_ALLOCATIONS
+// DSP 堆统计：只由推理线程更新，报告时读到的最多差一次推理
+struct memory_dsp_stats_t {
+    uint32_t inferences;
+    uint32_t allocations;       // 所有推理中的分配总次数
+    uint32_t max_allocations;   // 单次推理中最多的分配次数
+    size_t peak_bytes;          // 单次推理中 DSP 堆占用的最大值
+};
+static memory_dsp_stats_t g_dsp;
+static size_t g_dsp_start_count = 0;
+
+/**
+ * @brief 打印 DSP 堆峰值、每次推理的分配次数与启动以来最大的单块分配
+ */
+static void report_dsp_heap() {
+    char line[112];
+    const uint32_t inferences = g_dsp.inferences;
+    const uint32_t average_x10 = inferences > 0 ? (uint32_t)(g_dsp.allocations * 10ull / inferences) : 0;
+    snprintf(line, sizeof(line), "[Memory]     %-22s %6u B peak, %u.%u allocs/inference (max %u), largest %u B",
+             "DSP heap", (unsigned)g_dsp.peak_bytes, (unsigned)(average_x10 / 10), (unsigned)(average_x10 % 10),
+             (unsigned)g_dsp.max_allocations, (unsigned)ei_memory_largest_alloc);
+    Serial.println(line);
+    snprintf(line, sizeof(line), "[Memory]       in use between inferences %u B, %u inferences",
+             (unsigned)ei_memory_in_use, (unsigned)inferences);
+    Serial.println(line);
+}
+#endif
+
+#if EI_ARENA_RECORDING
+/**
+ * @brief 打印记录构建中初始化以来各类缓冲区的请求 / 实占字节数与能装下它们的最小 arena
+ * 溢出到堆上的缓冲区按放进 arena 时的大小计入最小值；初始化前不打印。
+ */
+static void report_arena_record() {
+    static const char* const kKinds[] = {"persistent", "scratch", "overflow (heap)"};
+    char line[96];
+    tflite_learn_792000_36_arena_record_t record;
+    if (tflite_learn_792000_36_arena_record(&record) != kTfLiteOk) {
+        return;
+    }
+    const tflite_learn_792000_36_recorded_allocation_t* buckets[] = {&record.persistent, &record.scratch,
+                                                                     &record.overflow};
+    for (size_t i = 0; i < 3; i++) {
+        snprintf(line, sizeof(line), "[Memory]       %-16s %6u B in %u (requested %u B)", kKinds[i],
+                 (unsigned)buckets[i]->used_bytes, (unsigned)buckets[i]->count,
+                 (unsigned)buckets[i]->requested_bytes);
+        Serial.println(line);
+    }
+    snprintf(line, sizeof(line), "[Memory]     arena minimum %u B (-DEI_TENSOR_ARENA_SIZE=%u), reclaimable %d B",
+             (unsigned)record.minimum_arena_bytes, (unsigned)record.minimum_arena_bytes,
+             (int)record.arena_bytes - (int)record.minimum_arena_bytes);
+    Serial.println(line);
+}
+#endif
+
+// ==================== 公共接口实现 ====================
+
+void memory_module_register(const char* name, size_t bytes, bool on_heap) {
+    g_regions_mutex.lock();
+    if (g_region_count < MEMORY_MAX_REGIONS) {
+        g_regions[g_region_count].name = name;
+        g_regions[g_region_count].bytes = bytes;
+        g_regions[g_region_count].on_heap = on_heap;
+        g_region_count++;
+    }
+    g_regions_mutex.unlock();
+}
+
+void memory_module_register_hot(const char* name, const void* buffer, size_t bytes, uint8_t flags) {
+    const uint32_t claimed = g_hot_claimed.load(std::memory_order_acquire);
+    for (uint32_t i = 0; i < claimed && i < MEMORY_HOT_BUFFER_CAPACITY; i++) {
+        if (g_hot[i].ready.load(std::memory_order_acquire) && g_hot[i].buffer == buffer) {
+            return;
+        }
+    }
+    const uint32_t slot = g_hot_claimed.fetch_add(1, std::memory_order_relaxed);
+    if (slot >= MEMORY_HOT_BUFFER_CAPACITY) {
+        return;     // 启动检查时报告
+    }
+    memory_hot_t& entry = g_hot[slot];
+    entry.name = name;
+    entry.buffer = buffer;
+    entry.bytes = bytes;
+    entry.flags = flags;
+    entry.ready.store(true, std::memory_order_release);
+}
+
+/**
+ * @brief 两块缓冲区是否有共享的缓存行
+ */
+static bool share_cache_line(const memory_hot_t& a, const memory_hot_t& b) {
+    const uintptr_t line = EI_CACHE_LINE_BYTES;
+    const uintptr_t a_first = (uintptr_t)a.buffer / line;
+    const uintptr_t a_last = ((uintptr_t)a.buffer + a.bytes - 1) / line;
+    const uintptr_t b_first = (uintptr_t)b.buffer / line;
+    const uintptr_t b_last = ((uintptr_t)b.buffer + b.bytes - 1) / line;
+    return a_first <= b_last && b_first <= a_last;
+}
+
+/**
+ * @brief 核对一块缓冲区，违反时打印原因
+ * @return 是否符合全部要求
+ */
+static bool check_hot(const memory_hot_t& entry, size_t count) {
+    const char* problem = nullptr;
+    if ((entry.flags & MEMORY_PLACE_SIMD) && !ei_is_aligned(entry.buffer, EI_SIMD_ALIGN)) {
+        problem = "not 16-byte aligned";
+    } else if ((entry.flags & MEMORY_PLACE_DMA) && !ei_is_aligned(entry.buffer, EI_DMA_ALIGN)) {
+        problem = "not word aligned for DMA";
+    } else if ((entry.flags & MEMORY_PLACE_DMA) &&
+               !ei_in_region(entry.buffer, entry.bytes, MEMORY_DMA_RAM_START,
+                             MEMORY_DMA_RAM_START + MEMORY_DMA_RAM_BYTES)) {
+        problem = "outside DMA-capable RAM";
+    } else if ((entry.flags & MEMORY_PLACE_RING) && !ei_is_aligned(entry.buffer, EI_CACHE_LINE_BYTES)) {
+        problem = "not on a cache line boundary";
+    } else if (entry.flags & MEMORY_PLACE_RING) {
+        for (size_t i = 0; i < count; i++) {
+            if (&g_hot[i] != &entry && share_cache_line(entry, g_hot[i])) {
+                problem = "shares a cache line";
+                break;
+            }
+        }
+    }
+    if (problem == nullptr) {
+        return true;
+    }
+    char line[112];
+    snprintf(line, sizeof(line), "[Memory] Placement: %s at %p (%u B) %s", entry.name, entry.buffer,
+             (unsigned)entry.bytes, problem);
+    Serial.println(line);
+    return false;
+}
+
+size_t memory_module_check_placement() {
+    // 编译图的 arena 在静态模式下是一个 16 字节对齐的全局数组（堆模式下初始化前为空，跳过）
+    size_t arena_bytes = 0;
+    const uint8_t* arena = tflite_learn_792000_36_arena(&arena_bytes);
+    if (arena != nullptr) {
+        memory_module_register_hot("tensor arena", arena, arena_bytes, MEMORY_PLACE_SIMD);
+    }
+
+    const uint32_t claimed = g_hot_claimed.load(std::memory_order_acquire);
+    const size_t count = claimed < MEMORY_HOT_BUFFER_CAPACITY ? claimed : MEMORY_HOT_BUFFER_CAPACITY;
+    size_t failures = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (g_hot[i].ready.load(std::memory_order_acquire) && !check_hot(g_hot[i], count)) {
+            failures++;
+        }
+    }
+    char line[96];
+    if (claimed > MEMORY_HOT_BUFFER_CAPACITY) {
+        snprintf(line, sizeof(line), "[Memory] Placement: %u hot buffers not checked (MEMORY_HOT_BUFFER_CAPACITY %u)",
+                 (unsigned)(claimed - MEMORY_HOT_BUFFER_CAPACITY), (unsigned)MEMORY_HOT_BUFFER_CAPACITY);
+        Serial.println(line);
+    }
+    snprintf(line, sizeof(line), "[Memory] Placement: %u hot buffers checked, %u misplaced", (unsigned)count,
+             (unsigned)failures);
+    Serial.println(line);
+    return failures;
+}
+
+/**
+ * @brief 静态数据 + bss 的字节数
+ */
+static size_t static_data_bytes() {
+#if MEMORY_HAS_LINKER_SYMBOLS
+    return (size_t)(&__bss_end__ - &__data_start__);
+#else
+    return 0;
+#endif
+}
+
+void memory_module_report() {
+    char line[96];
+    const size_t static_bytes = static_data_bytes();
+    const size_t heap_bytes = (size_t)mallinfo().uordblks;
+
+    size_t arena_bytes = 0;
+    size_t tensor_bytes = 0;
+    size_t persistent_bytes = 0;
+    size_t idle_bytes = 0;
+    tflite_learn_792000_36_arena_usage(&arena_bytes, &tensor_bytes, &persistent_bytes);
+    tflite_learn_792000_36_idle_region(&idle_bytes);
+
+    snprintf(line, sizeof(line), "[Memory] RAM budget: %u B total", (unsigned)MEMORY_RAM_BYTES);
+    Serial.println(line);
+    snprintf(line, sizeof(line), "[Memory]   static data + bss %7u B", (unsigned)static_bytes);
+    Serial.println(line);
+    snprintf(line, sizeof(line), "[Memory]   heap in use       %7u B", (unsigned)heap_bytes);
+    Serial.println(line);
+    g_regions_mutex.lock();
+    for (size_t i = 0; i < g_region_count; i++) {
+        snprintf(line, sizeof(line), "[Memory]     %-22s %6u B (%s)", g_regions[i].name,
+                 (unsigned)g_regions[i].bytes, g_regions[i].on_heap ? "heap" : "static");
+        Serial.println(line);
+    }
+    g_regions_mutex.unlock();
+    snprintf(line, sizeof(line), "[Memory]     %-22s %6u B (tensors %u, persistent %u, idle between invokes %u)",
+             "tensor arena", (unsigned)arena_bytes, (unsigned)tensor_bytes, (unsigned)persistent_bytes,
+             (unsigned)idle_bytes);
+    Serial.println(line);
+#if MODEL_INTERPRETER_ENABLE
+    if (interp_module_active()) {
+        snprintf(line, sizeof(line), "[Memory]     %-22s %6u B (held by the interpreter)", "tensor arena used",
+                 (unsigned)interp_module_arena_used());
+        Serial.println(line);
+    }
+#endif
+#if EIDSP_TRACK_ALLOCATIONS
+    report_dsp_heap();
+#endif
+#if EI_ARENA_RECORDING
+    report_arena_record();
+#endif
+
+    const size_t used = static_bytes + heap_bytes;
+    snprintf(line, sizeof(line), "[Memory]   free              %7d B", (int)MEMORY_RAM_BYTES - (int)used);
+    Serial.println(line);
+}
+
+size_t memory_module_high_water(size_t* out_static) {
+    const size_t static_bytes = static_data_bytes();
+    if (out_static) {
+        *out_static = static_bytes;
+    }
+    return static_bytes + (size_t)mallinfo().arena;
+}
+
+void memory_module_dsp_begin() {
+#if EIDSP_TRACK_ALLOCATIONS
+    // 峰值从当前占用重新开始，得到的是这一次推理的峰值
+    ei_memory_peak_use = ei_memory_in_use;
+    g_dsp_start_count = ei_memory_alloc_count;
+#endif
+}
+
+void memory_module_dsp_end() {
+#if EIDSP_TRACK_ALLOCATIONS
+    const uint32_t allocations = (uint32_t)(ei_memory_alloc_count - g_dsp_start_count);
+    g_dsp.allocations += allocations;
+    if (allocations > g_dsp.max_allocations) {
+        g_dsp.max_allocations = allocations;
+    }
+    if (ei_memory_peak_use > g_dsp.peak_bytes) {
+        g_dsp.peak_bytes = ei_memory_peak_use;
+    }
+    g_dsp.inferences++;
+#endif
+}
+
+void* memory_module_borrow(size_t bytes) {
+    if (g_lease != nullptr) {
+        return nullptr;
+    }
+#if MODEL_INTERPRETER_ENABLE
+    // 解释器持有 arena 时编译图未初始化，idle_region 会给出整块 arena
+    if (interp_module_active()) {
+        return nullptr;
+    }
+#endif
+
+    size_t idle_bytes = 0;
+    uint8_t* region = tflite_learn_792000_36_idle_region(&idle_bytes);
+    if (region == nullptr || bytes > idle_bytes) {
+        return nullptr;
+    }
+
+    g_lease = region;
+    return region;
+}
+
+void memory_module_release(void* ptr) {
+    if (ptr != nullptr && ptr == g_lease) {
+        g_lease = nullptr;
+    }
+}
+
+bool memory_module_arena_lent() {
+    return g_lease != nullptr;
+}
+
+bool memory_module_in_static_ram(const void* ptr) {
+#if MEMORY_HAS_LINKER_SYMBOLS
+    const char* p = static_cast<const char*>(ptr);
+    return p >= &__data_start__ && p < &__bss_end__;
+#else
+    (void)ptr;
+    return false;
+#endif
+}
@@ -0,0 +1,2076 @@
+// EON 编译模型直接调用模块实现
+// 注意：这里只引用编译后的模型头文件；a5-deminsion_inferencing.h 中定义了全局变量，
+// 只能由 inference_module.cpp 引用
+#include <Arduino.h>
+#include <math.h>
+#include <string.h>
+#include "app_config.h"
+#include "memory_module.h"
+#include "model_module.h"
+#include "edge-impulse-sdk/classifier/ei_aligned_malloc.h"
+#include "tflite-model/tflite_learn_792000_36_compiled.h"
+#include "model-parameters/model_metadata.h"
+#include "edge-impulse-sdk/classifier/ei_classifier_config.h"
+#if EI_CLASSIFIER_EON_PROFILER
+#include "mbed.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/compatibility.h"
+#endif
+#if INFERENCE_STREAMING
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/common.h"
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/quantization_util.h"
+#if EI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN || MODEL_SPECIALIZED_KERNELS
+#include "edge-impulse-sdk/CMSIS/NN/Include/arm_nnfunctions.h"
+#include "edge-impulse-sdk/CMSIS/NN/Include/arm_nnsupportfunctions.h"
+#endif
+#if !EI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/reference/softmax.h"
+#endif
+#endif
+#if MODEL_HOT_CODE_IN_RAM && defined(__MBED__)
+#include "platform/mbed_mpu_mgmt.h"
+#endif
+#if MODEL_EARLY_EXIT
+#include "early_exit_model.h"
+#endif
+#if MODEL_KERNEL_AUTOTUNE
+#include "calib_store.h"
+#endif
+#if MODEL_INTERPRETER_ENABLE
+#include "interp_module.h"
+#endif
+
+#if MODEL_INTERPRETER_ENABLE && !defined(EI_CLASSIFIER_ALLOCATION_STATIC)
+#error "MODEL_INTERPRETER_ENABLE requires EI_CLASSIFIER_ALLOCATION_STATIC (the interpreter runs in the compiled graph's static arena)"
+#endif
+
+// ==================== 算子内核 ====================
+//
+// 各算子用哪套内核由 tensorflow/lite/micro/kernels/*.cpp 在编译期按同一个
+// EI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN 选择（Mbed 目标默认开启）；CMSIS-NN 内核在有 DSP 扩展
+// （Cortex-M4F：__ARM_FEATURE_DSP）时走 SMLAD 等 SIMD 路径，否则退化为标量循环。
+
+#if EI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN
+#define MODEL_KERNEL_BACKEND "CMSIS-NN"
+#else
+#define MODEL_KERNEL_BACKEND "reference"
+#endif
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#define MODEL_KERNEL_SIMD "DSP SIMD"
+#else
+#define MODEL_KERNEL_SIMD "no SIMD"
+#endif
+
+#pragma message("Model kernels: " MODEL_KERNEL_BACKEND ", " MODEL_KERNEL_SIMD)
+
+// 放进 RAM 执行的热点内核：链接脚本的 *(.data*) 把该段并入 .data，启动代码连同初始化数据一起从 flash
+// 复制到 RAM（段名不用 ".data." 前缀，否则汇编器会把代码段强制标为可写数据）。RAM（0x2000_0000）与
+// flash 相距超出 BL 的 ±16 MB 范围，调用它们要用 long_call（间接跳转）；noinline 保证函数体留在该段内。
+#if MODEL_HOT_CODE_IN_RAM && defined(__arm__) && defined(__GNUC__)
+#define MODEL_RAMFUNC __attribute__((section(".data_model_ramfunc"), noinline, long_call))
+#define MODEL_RAMFUNC_ACTIVE 1
+#else
+#define MODEL_RAMFUNC
+#define MODEL_RAMFUNC_ACTIVE 0
+#endif
+
+#if !EI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN && defined(__ARM_FEATURE_DSP)
+#warning "CMSIS-NN kernels are disabled on a DSP-capable core; int8 inference falls back to reference kernels"
+#endif
+
+/**
+ * @brief 编译图中一个算子解析到的内核
+ */
+struct model_kernel_info_t {
+    const char* op;
+    const char* shape;
+    const char* kernel;
+};
+
+// arm_convolve_wrapper_s8 的分发：1x1 且无填充、步长 1 -> arm_convolve_1x1_s8_fast；
+// 1xN 且输出宽度为 4 的倍数 -> arm_convolve_1_x_n_s8，它在没有 MVE 的内核上直接转到 arm_convolve_s8
+static const model_kernel_info_t g_kernel_table[] = {
+#if EI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN
+    {"RESHAPE", "72 -> 1x72x1", "in place (no copy)"},
+    {"CONV_2D", "1x3 SAME, 1 -> 8 ch", "arm_convolve_s8"},
+    {"MAX_POOL_2D", "1x2 /2, 8 ch", "arm_max_pool_s8"},
+    {"CONV_2D", "1x1, 8 -> 10 ch", "arm_convolve_1x1_s8_fast"},
+    {"FULLY_CONNECTED", "360 -> 5", "arm_fully_connected_s8"},
+    {"SOFTMAX", "5", "arm_softmax_s8"},
+#else
+    {"RESHAPE", "72 -> 1x72x1", "in place (no copy)"},
+    {"CONV_2D", "1x3 SAME, 1 -> 8 ch", "reference_integer_ops::ConvPerChannel"},
+    {"MAX_POOL_2D", "1x2 /2, 8 ch", "reference_integer_ops::MaxPool"},
+    {"CONV_2D", "1x1, 8 -> 10 ch", "reference_integer_ops::ConvPerChannel"},
+    {"FULLY_CONNECTED", "360 -> 5", "reference_integer_ops::FullyConnected"},
+    {"SOFTMAX", "5", "reference_ops::Softmax"},
+#endif
+};
+
+// ==================== 流式推理的图结构 ====================
+//
+// 编译后的图：RESHAPE -> CONV_2D(1x3, SAME, ReLU) -> MAX_POOL(1x2, 步长 2) -> CONV_2D(1x1, ReLU)
+//            -> FULLY_CONNECTED -> SOFTMAX
+// 输入的 72 个值（24 帧 x 3 轴交错）被当作长度 72 的一维序列。卷积只看相邻位置、池化两两合并、
+// 第二层是逐列的 1x1 卷积，所以窗口滑动后绝大部分列的激活值不变：缓存第二层卷积的输出列，
+// 每次只计算新进入的列和受边界填充影响的两列，全连接层与 softmax 照常完整计算。
+
+#define STREAM_INPUT_LEN    72
+#define STREAM_CONV1_CH     8
+#define STREAM_CONV1_KERNEL 3
+#define STREAM_COLUMNS      (STREAM_INPUT_LEN / 2)
+#define STREAM_CONV2_CH     10
+#define STREAM_CLASSES      5
+
+// 张量在编译图中的序号（见 tflite_learn_792000_36_compiled.cpp 的 tensorData）
+#define TENSOR_INPUT        0
+#define TENSOR_INPUT_RESHAPE 11
+#define TENSOR_FC_BIAS      5
+#define TENSOR_FC_WEIGHTS   6
+#define TENSOR_CONV2_BIAS   7
+#define TENSOR_CONV2_FILTER 8
+#define TENSOR_CONV1_BIAS   9
+#define TENSOR_CONV1_FILTER 10
+#define TENSOR_CONV1_OUTPUT 12
+#define TENSOR_CONV2_OUTPUT 16
+#define TENSOR_FC_OUTPUT    18
+#define TENSOR_OUTPUT       19
+
+// ==================== 内部状态（模块私有） ====================
+
+static bool g_model_ready = false;
+static TfLiteTensor g_input;
+static TfLiteTensor g_output;
+static bool g_stream_ready = false;
+static bool g_stream_valid = false;
+// 最近一次推理是否由流式路径完成（列缓存即该窗口的激活），以及其窗口起点
+static bool g_features_valid = false;
+#if INFERENCE_STREAMING
+static size_t g_features_head = 0;
+#endif
+// 当前权重来自模型槽（见 model_module_set_custom_weights）
+static bool g_custom_weights = false;
+
+#if MODEL_SKIP_SOFTMAX
+// 编译图停在全连接层（图不以 softmax 结尾时为 false，照常运行完整的图）
+static bool g_skip_softmax = false;
+static TfLiteTensor g_logits_tensor;
+// 最近一次推理的 logits；nullptr = 输出张量中是概率（提前退出、解释器）
+static const int8_t* g_logits = nullptr;
+// exp(-Δ x k) 的 Q15 查找表，k = logit scale / 温度，Δ = 与最大 logit 的量化差（0 ~ 255）拆成
+// 高低 4 位：exp(-Δk) = g_exp_hi[Δ >> 4] x g_exp_lo[Δ & 15]
+static uint16_t g_exp_hi[16];
+static uint16_t g_exp_lo[16];
+#endif
+
+#if MODEL_INTERPRETER_ENABLE
+// 选中的 flatbuffer（nullptr = 编译图），以及当前初始化的引擎是否为解释器
+static const uint8_t* g_flatbuffer = nullptr;
+static size_t g_flatbuffer_bytes = 0;
+static bool g_interp_ready = false;
+#endif
+
+#if INFERENCE_STREAMING
+/**
+ * @brief 一个量化层的参数（与 TFLite Micro int8 内核的重量化方式一致）
+ */
+struct stream_layer_t {
+    const int8_t* weights;
+#if MODEL_INT4_WEIGHTS
+    // weights 为 4 位打包（每字节两个，低半字节在前）
+    bool packed;
+#endif
+    const int32_t* bias;
+    int32_t multiplier[STREAM_CONV2_CH];
+    int shift[STREAM_CONV2_CH];
+#if MODEL_SPECIALIZED_KERNELS
+    // 折叠了输入偏移的偏置：bias + input_offset * sum(weights)
+    int32_t folded_bias[STREAM_CONV2_CH];
+#endif
+    int32_t input_offset;
+    int32_t output_offset;
+    int32_t act_min;
+};
+
+static stream_layer_t g_conv1;
+static stream_layer_t g_conv2;
+static stream_layer_t g_fc;
+static int32_t g_softmax_multiplier = 0;
+static int g_softmax_shift = 0;
+static int32_t g_softmax_diff_min = 0;
+
+// 第二层卷积输出列的环形缓存：逻辑列 j 存放在 (head / 2 + j) % STREAM_COLUMNS
+static int8_t g_stream_columns[STREAM_COLUMNS][STREAM_CONV2_CH];
+static int8_t g_stream_logits[STREAM_CLASSES];
+#endif
+
+#if MODEL_SPARSE_FC
+static_assert(STREAM_COLUMNS <= 64, "g_fc_blocks holds one bit per column");
+
+// 每个类别的全连接权重中非零块（一列 STREAM_CONV2_CH 个权重）的位图，位 j = 逻辑列 j
+static uint64_t g_fc_blocks[STREAM_CLASSES];
+static size_t g_fc_nonzero_blocks = 0;
+#endif
+
+#if MODEL_EARLY_EXIT
+static_assert(STREAM_COLUMNS <= 64, "g_conv2_dirty holds one bit per column slot");
+
+// 池化输出的环形缓存（槽位与 g_stream_columns 相同），以及第二层卷积尚未按池化输出更新的槽位
+static int8_t g_stream_pooled[STREAM_COLUMNS][STREAM_CONV1_CH];
+static uint64_t g_conv2_dirty = 0;
+static bool g_early_exit_ready = false;
+// 最近一次流式推理的池化缓存是否对应其窗口
+static bool g_pooled_valid = false;
+static uint32_t g_early_exit_evaluated = 0;
+static uint32_t g_early_exit_taken = 0;
+static uint64_t g_early_exit_us = 0;
+static uint64_t g_full_us = 0;
+static const float g_early_exit_threshold =
+    MODEL_EARLY_EXIT_THRESHOLD > 0.0f ? MODEL_EARLY_EXIT_THRESHOLD : kEarlyExitThreshold;
+#endif
+
+// ==================== 内部辅助函数 ====================
+
+#if INFERENCE_STREAMING
+static bool tensor_shape_is(const TfLiteTensor& tensor, TfLiteType type, size_t bytes) {
+    return tensor.type == type && tensor.bytes == bytes && tensor.data.raw != nullptr;
+}
+
+static inline int32_t requantize(int32_t acc, const stream_layer_t& layer, size_t channel) {
+    int32_t out = tflite::MultiplyByQuantizedMultiplier(acc, layer.multiplier[channel], layer.shift[channel]);
+    out += layer.output_offset;
+    if (out < layer.act_min) {
+        out = layer.act_min;
+    }
+    return out > 127 ? 127 : out;
+}
+
+/**
+ * @brief 一层的第 i 个权重（4 位打包时拆出对应的半字节并符号扩展）
+ */
+static inline int8_t layer_weight(const stream_layer_t& layer, size_t i) {
+#if MODEL_INT4_WEIGHTS
+    if (layer.packed) {
+        const int8_t byte = layer.weights[i / 2];
+        return (i & 1) ? (int8_t)(byte >> 4) : (int8_t)((int8_t)(byte << 4) >> 4);
+    }
+#endif
+    return layer.weights[i];
+}
+
+/**
+ * @brief 读取一层的权重与量化参数，按 TFLite 的方式预先计算重量化乘数
+ * packable：权重可以是 4 位打包的（MODEL_INT4_WEIGHTS，每个输出通道的权重须占整数个字节）
+ */
+static bool load_layer(stream_layer_t* layer, int weights_index, size_t weights_count, int bias_index,
+                       size_t channels, const TfLiteTensor& input, int output_index, bool relu, bool packable) {
+    TfLiteTensor weights;
+    TfLiteTensor bias;
+    TfLiteTensor output;
+    if (tflite_learn_792000_36_tensor(weights_index, &weights) != kTfLiteOk ||
+        tflite_learn_792000_36_tensor(bias_index, &bias) != kTfLiteOk ||
+        tflite_learn_792000_36_tensor(output_index, &output) != kTfLiteOk ||
+        !tensor_shape_is(bias, kTfLiteInt32, channels * sizeof(int32_t)) ||
+        output.type != kTfLiteInt8 || weights.params.zero_point != 0) {
+        return false;
+    }
+#if MODEL_INT4_WEIGHTS
+    layer->packed = packable && (weights_count / channels) % 2 == 0 &&
+                    tensor_shape_is(weights, kTfLiteInt4, weights_count / 2);
+    if (!layer->packed && !tensor_shape_is(weights, kTfLiteInt8, weights_count)) {
+        return false;
+    }
+#else
+    (void)packable;
+    if (!tensor_shape_is(weights, kTfLiteInt8, weights_count)) {
+        return false;
+    }
+#endif
+
+    layer->weights = weights.data.int8;
+    layer->bias = bias.data.i32;
+    layer->input_offset = -input.params.zero_point;
+    layer->output_offset = output.params.zero_point;
+    layer->act_min = relu && output.params.zero_point > -128 ? output.params.zero_point : -128;
+
+    const double effective_scale = static_cast<double>(input.params.scale) *
+                                   static_cast<double>(weights.params.scale) /
+                                   static_cast<double>(output.params.scale);
+    for (size_t c = 0; c < channels; c++) {
+        tflite::QuantizeMultiplier(effective_scale, &layer->multiplier[c], &layer->shift[c]);
+    }
+
+#if MODEL_SPECIALIZED_KERNELS
+    const size_t per_channel = weights_count / channels;
+    for (size_t c = 0; c < channels; c++) {
+        int32_t sum = 0;
+        for (size_t i = 0; i < per_channel; i++) {
+            sum += layer_weight(*layer, c * per_channel + i);
+        }
+        layer->folded_bias[c] = layer->bias[c] + layer->input_offset * sum;
+    }
+#endif
+    return true;
+}
+
+#if MODEL_SPARSE_FC
+/**
+ * @brief 找出全连接权重中的非零块；全零块对累加没有贡献（特化内核折叠进偏置的部分也为 0），跳过后结果不变
+ */
+static void init_fc_blocks() {
+    g_fc_nonzero_blocks = 0;
+    for (size_t o = 0; o < STREAM_CLASSES; o++) {
+        g_fc_blocks[o] = 0;
+        for (size_t j = 0; j < STREAM_COLUMNS; j++) {
+            const size_t first = (o * STREAM_COLUMNS + j) * STREAM_CONV2_CH;
+            for (size_t c = 0; c < STREAM_CONV2_CH; c++) {
+                if (layer_weight(g_fc, first + c) != 0) {
+                    g_fc_blocks[o] |= 1ull << j;
+                    g_fc_nonzero_blocks++;
+                    break;
+                }
+            }
+        }
+    }
+}
+#endif
+
+/**
+ * @brief 校验编译图的结构与预期一致，并准备流式推理用到的参数
+ * 重新导出模型后结构若有变化，这里会失败并回退到完整推理。
+ */
+static bool stream_init() {
+    TfLiteTensor conv1_out;
+    TfLiteTensor conv2_out;
+    TfLiteTensor fc_out;
+    if (!tensor_shape_is(g_input, kTfLiteInt8, STREAM_INPUT_LEN) ||
+        !tensor_shape_is(g_output, kTfLiteInt8, STREAM_CLASSES) ||
+        tflite_learn_792000_36_tensor(TENSOR_CONV1_OUTPUT, &conv1_out) != kTfLiteOk ||
+        tflite_learn_792000_36_tensor(TENSOR_CONV2_OUTPUT, &conv2_out) != kTfLiteOk ||
+        tflite_learn_792000_36_tensor(TENSOR_FC_OUTPUT, &fc_out) != kTfLiteOk ||
+        conv1_out.bytes != STREAM_INPUT_LEN * STREAM_CONV1_CH ||
+        conv2_out.bytes != STREAM_COLUMNS * STREAM_CONV2_CH) {
+        return false;
+    }
+
+    // 最大池化不改变量化参数，所以第二层卷积的输入量化即第一层的输出量化。
+    // 第一层每个通道只有 STREAM_CONV1_KERNEL 个权重，半字节跨通道，只能是 int8
+    if (!load_layer(&g_conv1, TENSOR_CONV1_FILTER, STREAM_CONV1_CH * STREAM_CONV1_KERNEL, TENSOR_CONV1_BIAS,
+                    STREAM_CONV1_CH, g_input, TENSOR_CONV1_OUTPUT, true, false) ||
+        !load_layer(&g_conv2, TENSOR_CONV2_FILTER, STREAM_CONV2_CH * STREAM_CONV1_CH, TENSOR_CONV2_BIAS,
+                    STREAM_CONV2_CH, conv1_out, TENSOR_CONV2_OUTPUT, true, true) ||
+        !load_layer(&g_fc, TENSOR_FC_WEIGHTS, STREAM_CLASSES * STREAM_COLUMNS * STREAM_CONV2_CH, TENSOR_FC_BIAS,
+                    STREAM_CLASSES, conv2_out, TENSOR_FC_OUTPUT, false, true)) {
+        return false;
+    }
+
+    // softmax（beta = 1）：与 TFLite Micro 的 int8 softmax 参数计算相同
+    static const int kScaledDiffIntegerBits = 5;
+    tflite::PreprocessSoftmaxScaling(1.0, static_cast<double>(fc_out.params.scale), kScaledDiffIntegerBits,
+                                     &g_softmax_multiplier, &g_softmax_shift);
+    g_softmax_diff_min = -tflite::CalculateInputRadius(kScaledDiffIntegerBits, g_softmax_shift);
+#if MODEL_SPARSE_FC
+    init_fc_blocks();
+#endif
+    return true;
+}
+
+#if MODEL_SPECIALIZED_KERNELS
+// ==================== 按层形状特化的内核 ====================
+//
+// 与上面的流式内核计算完全相同，但所有循环次数都是模板参数：点积由模板递归在编译期完全展开
+// （工具链的 GCC 7 不支持 #pragma GCC unroll），输入偏移预先折叠进偏置，内层只剩 int8 x int8
+// 乘加；有 DSP 扩展时每 4 个值用两条 SMLAD 完成。整数运算与通用内核一致，结果逐位相同。
+
+/**
+ * @brief N 个 int8 的点积，按 4 个一组展开（N < 4 的余数单独特化）
+ */
+template <size_t N>
+struct FixedDot;
+
+template <>
+struct FixedDot<4> {
+    static inline __attribute__((always_inline)) int32_t run(const int8_t* x, const int8_t* w, int32_t acc) {
+#if defined(ARM_MATH_DSP)
+        // x 与 w 按同样的方式重排为 (0, 2) / (1, 3) 两组 q15，点积不受顺序影响
+        int32_t x02, x13, w02, w13;
+        read_and_pad_reordered(x, &x02, &x13);
+        read_and_pad_reordered(w, &w02, &w13);
+        acc = __SMLAD(x02, w02, acc);
+        return __SMLAD(x13, w13, acc);
+#else
+        return acc + x[0] * w[0] + x[1] * w[1] + x[2] * w[2] + x[3] * w[3];
+#endif
+    }
+};
+
+template <>
+struct FixedDot<3> {
+    static inline __attribute__((always_inline)) int32_t run(const int8_t* x, const int8_t* w, int32_t acc) {
+        return acc + x[0] * w[0] + x[1] * w[1] + x[2] * w[2];
+    }
+};
+
+template <>
+struct FixedDot<2> {
+    static inline __attribute__((always_inline)) int32_t run(const int8_t* x, const int8_t* w, int32_t acc) {
+        return acc + x[0] * w[0] + x[1] * w[1];
+    }
+};
+
+template <>
+struct FixedDot<1> {
+    static inline __attribute__((always_inline)) int32_t run(const int8_t* x, const int8_t* w, int32_t acc) {
+        return acc + x[0] * w[0];
+    }
+};
+
+template <size_t N>
+struct FixedDot {
+    static inline __attribute__((always_inline)) int32_t run(const int8_t* x, const int8_t* w, int32_t acc) {
+        return FixedDot<N - 4>::run(x + 4, w + 4, FixedDot<4>::run(x, w, acc));
+    }
+};
+
+#if MODEL_INT4_WEIGHTS
+/**
+ * @brief N 个 int8 与 N 个 4 位打包权重（N / 2 字节，低半字节在前）的点积的 16 倍
+ * 半字节移到字节高 4 位再按 int8 读出即得到 16 * w，省去逐个右移；累加和是 16 的倍数，调用方右移 4 位即精确结果
+ */
+template <size_t N>
+struct PackedDot;
+
+template <>
+struct PackedDot<4> {
+    static inline __attribute__((always_inline)) int32_t run(const int8_t* x, const uint8_t* w, int32_t acc) {
+#if defined(ARM_MATH_DSP)
+        // 两个字节分放到第 0 / 2 字节：低半字节左移 4 位得到 (w0, w2)，高半字节原位得到 (w1, w3)，
+        // SXTB16 一次把两个字节符号扩展成 q15，正好对上 read_and_pad_reordered 的 (0, 2) / (1, 3) 顺序
+        const uint32_t spread = (uint32_t)w[0] | ((uint32_t)w[1] << 16);
+        int32_t x02, x13;
+        read_and_pad_reordered(x, &x02, &x13);
+        acc = __SMLAD(x02, __SXTB16((spread << 4) & 0x00F000F0u), acc);
+        return __SMLAD(x13, __SXTB16(spread & 0x00F000F0u), acc);
+#else
+        return acc + x[0] * (int8_t)(w[0] << 4) + x[1] * (int8_t)(w[0] & 0xF0) +
+               x[2] * (int8_t)(w[1] << 4) + x[3] * (int8_t)(w[1] & 0xF0);
+#endif
+    }
+};
+
+template <>
+struct PackedDot<2> {
+    static inline __attribute__((always_inline)) int32_t run(const int8_t* x, const uint8_t* w, int32_t acc) {
+        return acc + x[0] * (int8_t)(w[0] << 4) + x[1] * (int8_t)(w[0] & 0xF0);
+    }
+};
+
+template <size_t N>
+struct PackedDot {
+    static_assert(N % 2 == 0, "packed rows hold whole bytes");
+    static inline __attribute__((always_inline)) int32_t run(const int8_t* x, const uint8_t* w, int32_t acc) {
+        return PackedDot<N - 4>::run(x + 4, w + 2, PackedDot<4>::run(x, w, acc));
+    }
+};
+#endif
+
+/**
+ * @brief 一行 N 个权重的点积加上折叠后的偏置；Packed 时 row 指向 4 位打包权重
+ */
+template <size_t N, bool Packed>
+static inline __attribute__((always_inline)) int32_t fixed_row_dot(const int8_t* x, const int8_t* row, int32_t acc) {
+#if MODEL_INT4_WEIGHTS
+    if (Packed) {
+        return acc + (PackedDot<N>::run(x, reinterpret_cast<const uint8_t*>(row), 0) >> 4);
+    }
+#endif
+    return FixedDot<N>::run(x, row, acc);
+}
+
+/**
+ * @brief 第 index 行（每行 N 个权重）的起始地址
+ */
+template <size_t N, bool Packed>
+static inline __attribute__((always_inline)) const int8_t* fixed_row(const int8_t* weights, size_t index) {
+    return weights + index * (Packed ? N / 2 : N);
+}
+
+/**
+ * @brief 特化版 stream_pool_column：第一层 1xKernel SAME 卷积 + 2 选 1 池化
+ * SAME 填充位置填入输入零点（折叠偏移后等价于不参与累加）。
+ */
+template <size_t InputLen, size_t Kernel, size_t Conv1Ch>
+static inline __attribute__((always_inline)) void fixed_pool_column(const int8_t* window, size_t head, size_t column,
+                                                                    int8_t* pooled) {
+    const int8_t pad = (int8_t)(-g_conv1.input_offset);
+    for (size_t c = 0; c < Conv1Ch; c++) {
+        pooled[c] = -128;
+    }
+
+    for (size_t p = 2 * column; p < 2 * column + 2; p++) {
+        int8_t taps[Kernel];
+        for (size_t k = 0; k < Kernel; k++) {
+            const size_t q = p + k;  // 逻辑位置 q - Kernel / 2
+            taps[k] = (q >= Kernel / 2 && q < InputLen + Kernel / 2)
+                          ? window[(head + q - Kernel / 2) % InputLen] : pad;
+        }
+        for (size_t c = 0; c < Conv1Ch; c++) {
+            const int32_t acc = FixedDot<Kernel>::run(taps, &g_conv1.weights[c * Kernel], g_conv1.folded_bias[c]);
+            const int8_t out = (int8_t)requantize(acc, g_conv1, c);
+            if (out > pooled[c]) {
+                pooled[c] = out;
+            }
+        }
+    }
+}
+
+/**
+ * @brief 特化版 stream_conv2_column：1x1 卷积
+ */
+template <size_t Conv1Ch, size_t Conv2Ch, bool Packed>
+static inline __attribute__((always_inline)) void fixed_conv2_column(const int8_t* pooled, int8_t* dst) {
+    for (size_t c = 0; c < Conv2Ch; c++) {
+        const int32_t acc = fixed_row_dot<Conv1Ch, Packed>(pooled, fixed_row<Conv1Ch, Packed>(g_conv2.weights, c),
+                                                           g_conv2.folded_bias[c]);
+        dst[c] = (int8_t)requantize(acc, g_conv2, c);
+    }
+}
+
+/**
+ * @brief 特化版全连接层：逐列累加（列缓存是环形的），每列 Conv2Ch 个值一次展开
+ */
+template <size_t Columns, size_t Conv2Ch, size_t Classes, bool Packed>
+MODEL_RAMFUNC static void fixed_classify_logits(size_t head) {
+    for (size_t o = 0; o < Classes; o++) {
+        const int8_t* weights = fixed_row<Columns * Conv2Ch, Packed>(g_fc.weights, o);
+        int32_t acc = g_fc.folded_bias[o];
+#if MODEL_SPARSE_FC
+        for (uint64_t blocks = g_fc_blocks[o]; blocks != 0; blocks &= blocks - 1) {
+            const size_t j = (size_t)__builtin_ctzll(blocks);
+            acc = fixed_row_dot<Conv2Ch, Packed>(g_stream_columns[(head / 2 + j) % Columns],
+                                                 fixed_row<Conv2Ch, Packed>(weights, j), acc);
+        }
+#else
+        for (size_t j = 0; j < Columns; j++) {
+            acc = fixed_row_dot<Conv2Ch, Packed>(g_stream_columns[(head / 2 + j) % Columns],
+                                                 fixed_row<Conv2Ch, Packed>(weights, j), acc);
+        }
+#endif
+        g_stream_logits[o] = (int8_t)requantize(acc, g_fc, 0);
+    }
+}
+
+/**
+ * @brief 以部署模型的形状实例化特化内核
+ */
+MODEL_RAMFUNC static void specialized_pool_column(const int8_t* window, size_t head, size_t column, int8_t* pooled) {
+    fixed_pool_column<STREAM_INPUT_LEN, STREAM_CONV1_KERNEL, STREAM_CONV1_CH>(window, head, column, pooled);
+}
+
+MODEL_RAMFUNC static void specialized_conv2_column(const int8_t* pooled, int8_t* dst) {
+#if MODEL_INT4_WEIGHTS
+    if (g_conv2.packed) {
+        fixed_conv2_column<STREAM_CONV1_CH, STREAM_CONV2_CH, true>(pooled, dst);
+        return;
+    }
+#endif
+    fixed_conv2_column<STREAM_CONV1_CH, STREAM_CONV2_CH, false>(pooled, dst);
+}
+
+MODEL_RAMFUNC static void specialized_classify_logits(size_t head) {
+#if MODEL_INT4_WEIGHTS
+    if (g_fc.packed) {
+        fixed_classify_logits<STREAM_COLUMNS, STREAM_CONV2_CH, STREAM_CLASSES, true>(head);
+        return;
+    }
+#endif
+    fixed_classify_logits<STREAM_COLUMNS, STREAM_CONV2_CH, STREAM_CLASSES, false>(head);
+}
+#endif
+
+#if !MODEL_SPECIALIZED_KERNELS || MODEL_KERNEL_AUTOTUNE
+// ==================== 通用流式内核 ====================
+
+/**
+ * @brief 逻辑列 column（输入位置 2*column, 2*column+1）的第一层卷积与池化输出
+ */
+MODEL_RAMFUNC static void generic_pool_column(const int8_t* window, size_t head, size_t column, int8_t* pooled) {
+    for (size_t c = 0; c < STREAM_CONV1_CH; c++) {
+        pooled[c] = -128;
+    }
+
+    // 第一层 1x3 卷积（SAME 填充：越界位置不参与累加）+ 2 选 1 最大池化
+    for (size_t p = 2 * column; p < 2 * column + 2; p++) {
+        int32_t inputs[STREAM_CONV1_KERNEL];
+        bool valid[STREAM_CONV1_KERNEL];
+        for (size_t k = 0; k < STREAM_CONV1_KERNEL; k++) {
+            const size_t q = p + k;  // 逻辑位置 q - 1
+            valid[k] = q >= 1 && q <= STREAM_INPUT_LEN;
+            inputs[k] = valid[k] ? window[(head + q - 1) % STREAM_INPUT_LEN] + g_conv1.input_offset : 0;
+        }
+        for (size_t c = 0; c < STREAM_CONV1_CH; c++) {
+            const int8_t* filter = &g_conv1.weights[c * STREAM_CONV1_KERNEL];
+            int32_t acc = g_conv1.bias[c];
+            for (size_t k = 0; k < STREAM_CONV1_KERNEL; k++) {
+                acc += inputs[k] * filter[k];
+            }
+            const int8_t out = (int8_t)requantize(acc, g_conv1, c);
+            if (out > pooled[c]) {
+                pooled[c] = out;
+            }
+        }
+    }
+}
+
+/**
+ * @brief 一列池化输出的第二层 1x1 卷积
+ */
+MODEL_RAMFUNC static void generic_conv2_column(const int8_t* pooled, int8_t* dst) {
+    for (size_t c = 0; c < STREAM_CONV2_CH; c++) {
+        const int8_t* filter = &g_conv2.weights[c * STREAM_CONV1_CH];
+        int32_t acc = g_conv2.bias[c];
+        for (size_t i = 0; i < STREAM_CONV1_CH; i++) {
+            acc += (pooled[i] + g_conv2.input_offset) * filter[i];
+        }
+        dst[c] = (int8_t)requantize(acc, g_conv2, c);
+    }
+}
+
+/**
+ * @brief 全连接层的 logits（按逻辑列顺序遍历环形缓存，MODEL_SPARSE_FC 时只遍历非零列）
+ */
+MODEL_RAMFUNC static void generic_classify_logits(size_t head) {
+    for (size_t o = 0; o < STREAM_CLASSES; o++) {
+        const int8_t* weights = &g_fc.weights[o * STREAM_COLUMNS * STREAM_CONV2_CH];
+        int32_t acc = g_fc.bias[o];
+#if MODEL_SPARSE_FC
+        for (uint64_t blocks = g_fc_blocks[o]; blocks != 0; blocks &= blocks - 1) {
+            const size_t j = (size_t)__builtin_ctzll(blocks);
+#else
+        for (size_t j = 0; j < STREAM_COLUMNS; j++) {
+#endif
+            const int8_t* column = g_stream_columns[(head / 2 + j) % STREAM_COLUMNS];
+            const int8_t* w = &weights[j * STREAM_CONV2_CH];
+            for (size_t c = 0; c < STREAM_CONV2_CH; c++) {
+                acc += (column[c] + g_fc.input_offset) * w[c];
+            }
+        }
+        g_stream_logits[o] = (int8_t)requantize(acc, g_fc, 0);
+    }
+}
+#endif
+
+#if MODEL_KERNEL_AUTOTUNE && EI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN
+// ==================== CMSIS-NN 内核 ====================
+//
+// 同样的整数运算交给 CMSIS-NN 的 int8 矩阵乘（逐通道 / 逐张量重量化与 TFLite 一致），不支持 4 位打包权重
+
+static_assert(sizeof(int) == sizeof(int32_t), "CMSIS-NN takes the per-channel shifts as int32_t");
+
+// 全连接层的输入：环形列缓存按逻辑列顺序展开
+MEMORY_SIMD_BUFFER static int8_t g_fc_input[STREAM_COLUMNS * STREAM_CONV2_CH];
+static const MemoryPlacement g_fc_input_placement("fc input", g_fc_input, sizeof(g_fc_input), MEMORY_PLACE_SIMD);
+
+static void cmsis_conv2_column(const int8_t* pooled, int8_t* dst) {
+    arm_nn_mat_mult_nt_t_s8(pooled, g_conv2.weights, g_conv2.bias, dst, g_conv2.multiplier,
+                            reinterpret_cast<const int32_t*>(g_conv2.shift), 1, STREAM_CONV2_CH, STREAM_CONV1_CH,
+                            g_conv2.input_offset, g_conv2.output_offset, g_conv2.act_min, 127);
+}
+
+static void cmsis_classify_logits(size_t head) {
+    for (size_t j = 0; j < STREAM_COLUMNS; j++) {
+        memcpy(&g_fc_input[j * STREAM_CONV2_CH], g_stream_columns[(head / 2 + j) % STREAM_COLUMNS], STREAM_CONV2_CH);
+    }
+    arm_nn_vec_mat_mult_t_s8(g_fc_input, g_fc.weights, g_fc.bias, g_stream_logits, g_fc.input_offset, 0,
+                             g_fc.output_offset, g_fc.multiplier[0], g_fc.shift[0], STREAM_COLUMNS * STREAM_CONV2_CH,
+                             STREAM_CLASSES, g_fc.act_min, 127, 1);
+}
+#endif
+
+#if MODEL_KERNEL_AUTOTUNE
+// ==================== 内核选择 ====================
+
+typedef void (*pool_kernel_t)(const int8_t* window, size_t head, size_t column, int8_t* pooled);
+typedef void (*conv2_kernel_t)(const int8_t* pooled, int8_t* dst);
+typedef void (*fc_kernel_t)(size_t head);
+
+// 各层每个变体的实现（nullptr = 本构建没有）；启动时按 Flash 记录或实测结果填入 g_kernels
+static const pool_kernel_t kPoolKernels[MODEL_KERNEL_VARIANTS] = {generic_pool_column, specialized_pool_column,
+                                                                   nullptr};
+#if EI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN
+static const conv2_kernel_t kConv2Kernels[MODEL_KERNEL_VARIANTS] = {generic_conv2_column, specialized_conv2_column,
+                                                                     cmsis_conv2_column};
+static const fc_kernel_t kFcKernels[MODEL_KERNEL_VARIANTS] = {generic_classify_logits, specialized_classify_logits,
+                                                               cmsis_classify_logits};
+#else
+static const conv2_kernel_t kConv2Kernels[MODEL_KERNEL_VARIANTS] = {generic_conv2_column, specialized_conv2_column,
+                                                                     nullptr};
+static const fc_kernel_t kFcKernels[MODEL_KERNEL_VARIANTS] = {generic_classify_logits, specialized_classify_logits,
+                                                               nullptr};
+#endif
+static const char* const kKernelVariantNames[MODEL_KERNEL_VARIANTS] = {"generic", "specialized", "CMSIS-NN"};
+
+static struct {
+    pool_kernel_t pool;
+    conv2_kernel_t conv2;
+    fc_kernel_t fc;
+} g_kernels = {specialized_pool_column, specialized_conv2_column, specialized_classify_logits};
+static model_kernel_choice_t g_kernel_choice = {};
+#endif
+
+/**
+ * @brief 各层内核的分派：MODEL_KERNEL_AUTOTUNE 时经启动时填好的函数指针表，否则在编译期选定
+ */
+MODEL_RAMFUNC static void stream_pool_column(const int8_t* window, size_t head, size_t column, int8_t* pooled) {
+#if MODEL_KERNEL_AUTOTUNE
+    g_kernels.pool(window, head, column, pooled);
+#elif MODEL_SPECIALIZED_KERNELS
+    specialized_pool_column(window, head, column, pooled);
+#else
+    generic_pool_column(window, head, column, pooled);
+#endif
+}
+
+MODEL_RAMFUNC static void stream_conv2_column(const int8_t* pooled, int8_t* dst) {
+#if MODEL_KERNEL_AUTOTUNE
+    g_kernels.conv2(pooled, dst);
+#elif MODEL_SPECIALIZED_KERNELS
+    specialized_conv2_column(pooled, dst);
+#else
+    generic_conv2_column(pooled, dst);
+#endif
+}
+
+MODEL_RAMFUNC static void stream_classify_logits(size_t head) {
+#if MODEL_KERNEL_AUTOTUNE
+    g_kernels.fc(head);
+#elif MODEL_SPECIALIZED_KERNELS
+    specialized_classify_logits(head);
+#else
+    generic_classify_logits(head);
+#endif
+}
+
+/**
+ * @brief 计算逻辑列 column 的池化输出与第二层卷积输出并写入缓存
+ * 启用提前退出时只算到池化，第二层卷积推迟到需要完整推理时（见 stream_flush_columns）
+ */
+MODEL_RAMFUNC static void stream_compute_column(const int8_t* window, size_t head, size_t column) {
+    const size_t slot = (head / 2 + column) % STREAM_COLUMNS;
+#if MODEL_EARLY_EXIT
+    stream_pool_column(window, head, column, g_stream_pooled[slot]);
+    g_conv2_dirty |= 1ull << slot;
+#else
+    int8_t pooled[STREAM_CONV1_CH];
+    stream_pool_column(window, head, column, pooled);
+    stream_conv2_column(pooled, g_stream_columns[slot]);
+#endif
+}
+
+#if MODEL_EARLY_EXIT
+/**
+ * @brief 补算池化输出已更新、第二层卷积尚未更新的列
+ */
+MODEL_RAMFUNC static void stream_flush_columns() {
+    for (size_t slot = 0; g_conv2_dirty != 0; slot++, g_conv2_dirty >>= 1) {
+        if (g_conv2_dirty & 1u) {
+            stream_conv2_column(g_stream_pooled[slot], g_stream_columns[slot]);
+        }
+    }
+}
+
+/**
+ * @brief 提前退出头：池化激活逐通道的和与最大值（与列顺序无关，不需要 head）经线性层得到 logits，再做 softmax
+ * @return true 获胜类别允许退出且概率达到阈值，头的概率已按输出量化写入输出张量
+ */
+static bool stream_early_exit() {
+    int32_t features[EARLY_EXIT_MODEL_FEATURES];
+    for (size_t c = 0; c < STREAM_CONV1_CH; c++) {
+        int32_t sum = 0;
+        int32_t max = -128;
+        for (size_t slot = 0; slot < STREAM_COLUMNS; slot++) {
+            const int32_t v = g_stream_pooled[slot][c];
+            sum += v;
+            max = v > max ? v : max;
+        }
+        // 最大值乘以列数，与求和处于同一量级，便于共用一套权重量化
+        features[c] = sum;
+        features[STREAM_CONV1_CH + c] = max * (int32_t)STREAM_COLUMNS;
+    }
+
+    float probs[STREAM_CLASSES];
+    float max_logit = -INFINITY;
+    for (size_t k = 0; k < STREAM_CLASSES; k++) {
+        const int8_t* w = &kEarlyExitWeights[k * EARLY_EXIT_MODEL_FEATURES];
+        int32_t acc = kEarlyExitBias[k];
+        for (size_t i = 0; i < EARLY_EXIT_MODEL_FEATURES; i++) {
+            acc += features[i] * w[i];
+        }
+        probs[k] = acc * kEarlyExitLogitScale;
+        max_logit = probs[k] > max_logit ? probs[k] : max_logit;
+    }
+    float total = 0.0f;
+    size_t top = 0;
+    for (size_t k = 0; k < STREAM_CLASSES; k++) {
+        probs[k] = expf(probs[k] - max_logit);
+        total += probs[k];
+        top = probs[k] > probs[top] ? k : top;
+    }
+    if ((kEarlyExitClassMask & (1u << top)) == 0 || probs[top] < g_early_exit_threshold * total) {
+        return false;
+    }
+
+    for (size_t k = 0; k < STREAM_CLASSES; k++) {
+        const int32_t q = (int32_t)lroundf(probs[k] / total / g_output.params.scale) + g_output.params.zero_point;
+        g_output.data.int8[k] = (int8_t)(q < -128 ? -128 : (q > 127 ? 127 : q));
+    }
+    return true;
+}
+#endif
+
+/**
+ * @brief 全连接层（按逻辑列顺序遍历环形缓存）+ softmax，结果写入输出张量
+ * MODEL_SPARSE_FC 时只遍历 g_fc_blocks 中的非零列；跳过 softmax 时结果留在 g_stream_logits
+ */
+MODEL_RAMFUNC static void stream_classify(size_t head) {
+#if MODEL_EARLY_EXIT
+    stream_flush_columns();
+#endif
+    stream_classify_logits(head);
+
+#if MODEL_SKIP_SOFTMAX
+    if (g_skip_softmax) {
+        g_logits = g_stream_logits;
+        return;
+    }
+#endif
+#if EI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN
+    arm_softmax_s8(g_stream_logits, 1, STREAM_CLASSES, g_softmax_multiplier, g_softmax_shift,
+                   g_softmax_diff_min, g_output.data.int8);
+#else
+    tflite::SoftmaxParams params;
+    params.input_multiplier = g_softmax_multiplier;
+    params.input_left_shift = g_softmax_shift;
+    params.diff_min = g_softmax_diff_min;
+    const tflite::RuntimeShape shape({1, STREAM_CLASSES});
+    tflite::reference_ops::Softmax(params, shape, g_stream_logits, shape, g_output.data.int8);
+#endif
+}
+#endif
+
+/**
+ * @brief 浮点窗口模式下图由 run_classifier 管理：测试前临时初始化
+ * （连续分类已让图保持初始化时直接接管，不是临时的）
+ * @param out_temporary 输出是否为临时初始化（测试结束后须调用 release_graph）
+ */
+static bool acquire_graph(bool* out_temporary) {
+    if (memory_module_arena_lent()) {
+        return false;
+    }
+    *out_temporary = !g_model_ready && !tflite_learn_792000_36_initialized();
+    return g_model_ready || model_module_init();
+}
+
+/**
+ * @brief 释放当前初始化的引擎（图状态由调用者清除）
+ */
+static void reset_engine() {
+#if MODEL_INTERPRETER_ENABLE
+    if (g_interp_ready) {
+        interp_module_unload();
+        g_interp_ready = false;
+        return;
+    }
+#endif
+    tflite_learn_792000_36_reset(ei_aligned_free);
+}
+
+static void release_graph(bool temporary) {
+    if (temporary) {
+        reset_engine();
+        g_model_ready = false;
+        g_stream_ready = false;
+    }
+    // 测试覆盖了输入张量，流式缓存下一次重新完整计算
+    g_stream_valid = false;
+}
+
+/**
+ * @brief 输入内容不影响 int8 内核的耗时，用固定的伪随机序列填充
+ */
+static void fill_test_input() {
+    uint32_t seed = 0x12345678u;
+    for (size_t i = 0; i < g_input.bytes; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        g_input.data.int8[i] = (int8_t)(seed >> 24);
+    }
+}
+
+#if EI_CLASSIFIER_EON_PROFILER
+/**
+ * @brief 按节点累计 DWT CYCCNT 周期数的 profiler（invoke 每个节点产生一个事件，按顺序对应节点）
+ */
+class NodeCycleProfiler : public tflite::MicroProfilerInterface {
+public:
+    static const size_t kMaxNodes = 16;
+
+    NodeCycleProfiler() : next_(0) {
+        for (size_t i = 0; i < kMaxNodes; i++) {
+            tags_[i] = nullptr;
+            start_[i] = 0;
+            cycles_[i] = 0;
+        }
+    }
+
+    void begin_invoke() { next_ = 0; }
+
+    uint32_t BeginEvent(const char* tag) override {
+        const uint32_t handle = next_ < kMaxNodes ? next_++ : kMaxNodes - 1;
+        tags_[handle] = tag;
+        start_[handle] = DWT->CYCCNT;
+        return handle;
+    }
+
+    void EndEvent(uint32_t handle) override {
+        cycles_[handle] += DWT->CYCCNT - start_[handle];
+    }
+
+    uint64_t cycles(size_t node) const { return cycles_[node]; }
+
+private:
+    uint32_t next_;
+    const char* tags_[kMaxNodes];
+    uint32_t start_[kMaxNodes];
+    uint64_t cycles_[kMaxNodes];
+
+    TF_LITE_REMOVE_VIRTUAL_DELETE
+};
+
+static void enable_cycle_counter() {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+#endif
+
+#if MODEL_SKIP_SOFTMAX
+static_assert(MODEL_SOFTMAX_TEMPERATURE > 0.0f, "MODEL_SOFTMAX_TEMPERATURE must be greater than 0");
+
+/**
+ * @brief 按 logit scale 与温度生成 exp 查找表
+ */
+static void init_exp_lut(float logit_scale) {
+    const double k = static_cast<double>(logit_scale) / static_cast<double>(MODEL_SOFTMAX_TEMPERATURE);
+    for (size_t i = 0; i < 16; i++) {
+        g_exp_lo[i] = (uint16_t)lround(32768.0 * exp(-k * i));
+        g_exp_hi[i] = (uint16_t)lround(32768.0 * exp(-k * 16.0 * i));
+    }
+}
+
+/**
+ * @brief exp(-Δ x k)，Q15（Δ = 0 时为 32768）
+ */
+static inline uint32_t exp_q15(int32_t delta) {
+    return ((uint32_t)g_exp_hi[delta >> 4] * g_exp_lo[delta & 15] + (1u << 14)) >> 15;
+}
+
+/**
+ * @brief softmax(logits / 温度) 的分母（Q15，最大 logit 一项为 32768），并给出最大 logit 的位置
+ * 并列时取序号最小者
+ */
+static uint32_t logit_sum(size_t* out_top) {
+    size_t top = 0;
+    for (size_t i = 1; i < g_output.bytes; i++) {
+        top = g_logits[i] > g_logits[top] ? i : top;
+    }
+    uint32_t sum = 0;
+    for (size_t i = 0; i < g_output.bytes; i++) {
+        sum += exp_q15(g_logits[top] - g_logits[i]);
+    }
+    *out_top = top;
+    return sum;
+}
+
+/**
+ * @brief 按输出张量的量化格式量化一个概率
+ */
+static int8_t quantize_probability(float probability) {
+    const int32_t q = (int32_t)lroundf(probability / g_output.params.scale) + g_output.params.zero_point;
+    return (int8_t)(q < -128 ? -128 : (q > 127 ? 127 : q));
+}
+#endif
+
+static void dequantize_output(float* out_scores, size_t num_scores) {
+#if MODEL_SKIP_SOFTMAX
+    if (g_logits != nullptr) {
+        size_t top;
+        const float inv_sum = 1.0f / logit_sum(&top);
+        for (size_t i = 0; i < num_scores; i++) {
+            out_scores[i] = exp_q15(g_logits[top] - g_logits[i]) * inv_sum;
+        }
+        return;
+    }
+#endif
+    const float scale = g_output.params.scale;
+    const int32_t zero_point = g_output.params.zero_point;
+    for (size_t i = 0; i < num_scores; i++) {
+        out_scores[i] = (g_output.data.int8[i] - zero_point) * scale;
+    }
+}
+
+/**
+ * @brief int8 域 argmax：量化分数与概率单调对应，比较量化值即可，只反量化获胜类别与第二名
+ * 并列时取序号最小者，全为最小量化值时返回 -1（与浮点 argmax 从 0 开始比较的行为一致）
+ * 跳过 softmax 时在 logits 上取 argmax，只为获胜类别与第二名查表计算概率
+ */
+static void top_output(int8_t min_score_q, model_top_result_t* out_top) {
+#if MODEL_SKIP_SOFTMAX
+    if (g_logits != nullptr) {
+        // logits 的 argmax 即概率的 argmax；获胜类别的概率 = 32768 / 分母，量化后与阈值比较
+        size_t top;
+        const float inv_sum = 1.0f / logit_sum(&top);
+        int runner_up = -1;
+        for (size_t i = 0; i < g_output.bytes; i++) {
+            if (i != top && (runner_up < 0 || g_logits[i] > g_logits[runner_up])) {
+                runner_up = (int)i;
+            }
+        }
+        out_top->confidence = 32768.0f * inv_sum;
+        out_top->score_q = quantize_probability(out_top->confidence);
+        out_top->index = out_top->score_q >= min_score_q ? (int)top : -1;
+        out_top->top = (int)top;
+        out_top->runner_up = runner_up;
+        out_top->runner_up_confidence = runner_up >= 0 ? exp_q15(g_logits[top] - g_logits[runner_up]) * inv_sum : 0.0f;
+        return;
+    }
+#endif
+    int best_index = -1;
+    int8_t best_q = -128;
+    int second_index = -1;
+    int8_t second_q = -128;
+    for (size_t i = 0; i < g_output.bytes; i++) {
+        const int8_t q = g_output.data.int8[i];
+        if (q > best_q) {
+            if (best_index >= 0) {
+                second_q = best_q;
+                second_index = best_index;
+            }
+            best_q = q;
+            best_index = (int)i;
+        } else if (q > second_q || second_index < 0) {
+            second_q = q;
+            second_index = (int)i;
+        }
+    }
+
+    out_top->score_q = best_q;
+    out_top->confidence = (best_q - g_output.params.zero_point) * g_output.params.scale;
+    out_top->index = best_q >= min_score_q ? best_index : -1;
+    out_top->top = best_index;
+    out_top->runner_up = second_index;
+    out_top->runner_up_confidence =
+        second_index >= 0 ? (second_q - g_output.params.zero_point) * g_output.params.scale : 0.0f;
+}
+
+#if MODEL_SPECIALIZED_KERNELS
+/**
+ * @brief 最近一次推理的 int8 结果：跳过 softmax 时为 logits，否则为输出张量
+ */
+static const int8_t* result_scores() {
+#if MODEL_SKIP_SOFTMAX
+    if (g_logits != nullptr) {
+        return g_logits;
+    }
+#endif
+    return g_output.data.int8;
+}
+#endif
+
+/**
+ * @brief 运行一次完整的图，输出留在输出张量中（跳过 softmax 时 logits 留在全连接层的输出张量中）
+ */
+static bool invoke_graph() {
+    if (!g_model_ready || memory_module_arena_lent()) {
+        return false;
+    }
+#if MODEL_SKIP_SOFTMAX
+    g_logits = nullptr;
+#endif
+#if MODEL_INTERPRETER_ENABLE
+    if (g_interp_ready) {
+        return interp_module_invoke();
+    }
+#endif
+    if (tflite_learn_792000_36_invoke() != kTfLiteOk) {
+        return false;
+    }
+#if MODEL_SKIP_SOFTMAX
+    if (g_skip_softmax) {
+        g_logits = g_logits_tensor.data.int8;
+    }
+#endif
+    return true;
+}
+
+/**
+ * @brief 流式推理（或回退到完整推理），输出留在输出张量中
+ */
+static bool stream_run(const int8_t* window, size_t head, size_t new_values) {
+    // 流式路径把输出写入 arena 中的输出张量，同样不能与借用重叠
+    if (!g_model_ready || memory_module_arena_lent()) {
+        return false;
+    }
+
+    g_features_valid = false;
+#if MODEL_EARLY_EXIT
+    g_pooled_valid = false;
+#endif
+    if (!g_stream_ready || (head % 2) != 0) {
+        // 回退：按时间顺序写入输入张量，运行完整的图
+        const size_t tail = g_input.bytes - head;
+        memcpy(g_input.data.int8, &window[head], tail);
+        memcpy(g_input.data.int8 + tail, window, head);
+        return invoke_graph();
+    }
+
+#if INFERENCE_STREAMING
+#if MODEL_EARLY_EXIT
+    const uint32_t start_us = micros();
+#endif
+    if (!g_stream_valid || new_values >= STREAM_INPUT_LEN || (new_values % 2) != 0) {
+        for (size_t j = 0; j < STREAM_COLUMNS; j++) {
+            stream_compute_column(window, head, j);
+        }
+        g_stream_valid = true;
+    } else if (new_values > 0) {
+        // 新进入的列，加上原来的最后一列（右侧不再是填充）和新的第一列（左侧变为填充）
+        const size_t fresh = new_values / 2;
+        stream_compute_column(window, head, 0);
+        for (size_t j = STREAM_COLUMNS - fresh - 1; j < STREAM_COLUMNS; j++) {
+            stream_compute_column(window, head, j);
+        }
+    }
+
+    g_features_head = head;
+#if MODEL_EARLY_EXIT
+    g_pooled_valid = true;
+    if (g_early_exit_ready) {
+        g_early_exit_evaluated++;
+        if (stream_early_exit()) {
+            // 第二层卷积没有更新，倒数第二层激活对本窗口无效
+#if MODEL_SKIP_SOFTMAX
+            g_logits = nullptr;
+#endif
+            g_early_exit_taken++;
+            g_early_exit_us += micros() - start_us;
+            return true;
+        }
+    }
+#endif
+
+    stream_classify(head);
+    g_features_valid = true;
+#if MODEL_EARLY_EXIT
+    if (g_early_exit_ready) {
+        g_full_us += micros() - start_us;
+    }
+#endif
+#else
+    (void)new_values;
+#endif
+    return true;
+}
+
+/**
+ * @brief 连续调用 invoke 若干次，统计单次耗时
+ */
+static bool time_invokes(bool (*invoke)(), uint32_t iterations, model_benchmark_t* out_result) {
+    model_benchmark_t result = {iterations, 0, 0xFFFFFFFFu, 0};
+    uint64_t total_us = 0;
+    bool ok = true;
+    for (uint32_t i = 0; i < iterations && ok; i++) {
+        const uint32_t start_us = micros();
+        ok = invoke();
+        const uint32_t elapsed_us = micros() - start_us;
+        total_us += elapsed_us;
+        if (elapsed_us < result.min_us) {
+            result.min_us = elapsed_us;
+        }
+        if (elapsed_us > result.max_us) {
+            result.max_us = elapsed_us;
+        }
+    }
+    result.mean_us = (uint32_t)(total_us / iterations);
+    *out_result = result;
+    return ok;
+}
+
+static void print_benchmark(const char* label, const model_benchmark_t& result) {
+    Serial.print(label);
+    Serial.print(result.iterations);
+    Serial.print(" invokes, mean ");
+    Serial.print(result.mean_us);
+    Serial.print(" us, min ");
+    Serial.print(result.min_us);
+    Serial.print(" us, max ");
+    Serial.print(result.max_us);
+    Serial.println(" us");
+}
+
+#if MODEL_SPECIALIZED_KERNELS
+/**
+ * @brief 用特化内核对输入张量做一次完整推理（所有列都重新计算），基准测试用
+ */
+static bool invoke_fixed() {
+    if (memory_module_arena_lent()) {
+        return false;
+    }
+    for (size_t j = 0; j < STREAM_COLUMNS; j++) {
+        stream_compute_column(g_input.data.int8, 0, j);
+    }
+    stream_classify(0);
+    g_stream_valid = false;
+    g_features_valid = false;
+    return true;
+}
+#endif
+
+#if MODEL_KERNEL_AUTOTUNE
+/**
+ * @brief 内核耗时取决于代码与权重所在的存储器（由构建决定）以及权重布局（4 位打包、稀疏块数），
+ * 签名覆盖这两者：重新烧录或 OTA 改变布局后重新测量
+ */
+static uint32_t kernel_signature() {
+    uint32_t layout = 0;
+#if MODEL_INT4_WEIGHTS
+    layout |= (g_conv2.packed ? 1u : 0u) | (g_fc.packed ? 2u : 0u);
+#endif
+#if MODEL_SPARSE_FC
+    layout |= (uint32_t)g_fc_nonzero_blocks << 2;
+#endif
+    char text[40];
+    const int length = snprintf(text, sizeof(text), __DATE__ " " __TIME__ " %08lx", (unsigned long)layout);
+    return calib_store_crc32(reinterpret_cast<const uint8_t*>(text), (size_t)length);
+}
+
+/**
+ * @brief 一层的某个变体能否用于当前权重（通用内核与 CMSIS-NN 不读 4 位打包权重）
+ */
+static bool kernel_available(size_t layer, uint8_t variant) {
+    if (variant >= MODEL_KERNEL_VARIANTS) {
+        return false;
+    }
+    switch (layer) {
+        case MODEL_KERNEL_LAYER_POOL:
+            return kPoolKernels[variant] != nullptr;
+        case MODEL_KERNEL_LAYER_CONV2:
+#if MODEL_INT4_WEIGHTS
+            if (g_conv2.packed && variant != MODEL_KERNEL_SPECIALIZED) {
+                return false;
+            }
+#endif
+            return kConv2Kernels[variant] != nullptr;
+        default:
+#if MODEL_INT4_WEIGHTS
+            if (g_fc.packed && variant != MODEL_KERNEL_SPECIALIZED) {
+                return false;
+            }
+#endif
+            return kFcKernels[variant] != nullptr;
+    }
+}
+
+/**
+ * @brief 对一个变体计时：MODEL_KERNEL_AUTOTUNE_ROUNDS 轮取最短
+ * @param window_pass 按完整窗口运行一次该层
+ * @return uint32_t MODEL_KERNEL_AUTOTUNE_REPS 个完整窗口的耗时（微秒）
+ */
+template <typename WindowPass>
+static uint32_t time_kernel(WindowPass window_pass) {
+    uint32_t best = UINT32_MAX;
+    for (int round = 0; round < MODEL_KERNEL_AUTOTUNE_ROUNDS; round++) {
+        const uint32_t start_us = micros();
+        for (int rep = 0; rep < MODEL_KERNEL_AUTOTUNE_REPS; rep++) {
+            window_pass();
+        }
+        const uint32_t elapsed_us = micros() - start_us;
+        best = elapsed_us < best ? elapsed_us : best;
+    }
+    return best;
+}
+
+/**
+ * @brief 在固定的伪随机窗口上测量各层每个可用变体，输出与特化内核不同的变体不参与选择
+ * 基准用特化内核：它与通用内核逐位一致，也是唯一能读 4 位打包权重的变体，所以总是可用
+ */
+static void tune_kernels(model_kernel_choice_t* choice) {
+    static int8_t ref_pooled[STREAM_COLUMNS][STREAM_CONV1_CH];
+    static int8_t ref_columns[STREAM_COLUMNS][STREAM_CONV2_CH];
+    static int8_t out_pooled[STREAM_COLUMNS][STREAM_CONV1_CH];
+    static int8_t out_columns[STREAM_COLUMNS][STREAM_CONV2_CH];
+    int8_t ref_logits[STREAM_CLASSES];
+
+    fill_test_input();
+    const int8_t* window = g_input.data.int8;
+    for (size_t j = 0; j < STREAM_COLUMNS; j++) {
+        specialized_pool_column(window, 0, j, ref_pooled[j]);
+        specialized_conv2_column(ref_pooled[j], ref_columns[j]);
+    }
+    memcpy(g_stream_columns, ref_columns, sizeof(ref_columns));
+    specialized_classify_logits(0);
+    memcpy(ref_logits, g_stream_logits, sizeof(ref_logits));
+
+    for (size_t layer = 0; layer < MODEL_KERNEL_LAYERS; layer++) {
+        char line[128];
+        int length = snprintf(line, sizeof(line), "[Model] Kernel autotune, %s:",
+                              layer == MODEL_KERNEL_LAYER_POOL ? "conv1 + pool"
+                                                               : (layer == MODEL_KERNEL_LAYER_CONV2 ? "conv2" : "fc"));
+        uint8_t best = MODEL_KERNEL_SPECIALIZED;
+        uint32_t best_us = UINT32_MAX;
+        for (uint8_t v = 0; v < MODEL_KERNEL_VARIANTS; v++) {
+            if (!kernel_available(layer, v)) {
+                continue;
+            }
+            bool same;
+            uint32_t elapsed_us;
+            if (layer == MODEL_KERNEL_LAYER_POOL) {
+                const pool_kernel_t kernel = kPoolKernels[v];
+                const auto pass = [&]() {
+                    for (size_t j = 0; j < STREAM_COLUMNS; j++) {
+                        kernel(window, 0, j, out_pooled[j]);
+                    }
+                };
+                pass();
+                same = memcmp(out_pooled, ref_pooled, sizeof(ref_pooled)) == 0;
+                elapsed_us = time_kernel(pass);
+            } else if (layer == MODEL_KERNEL_LAYER_CONV2) {
+                const conv2_kernel_t kernel = kConv2Kernels[v];
+                const auto pass = [&]() {
+                    for (size_t j = 0; j < STREAM_COLUMNS; j++) {
+                        kernel(ref_pooled[j], out_columns[j]);
+                    }
+                };
+                pass();
+                same = memcmp(out_columns, ref_columns, sizeof(ref_columns)) == 0;
+                elapsed_us = time_kernel(pass);
+            } else {
+                const fc_kernel_t kernel = kFcKernels[v];
+                const auto pass = [&]() { kernel(0); };
+                pass();
+                same = memcmp(g_stream_logits, ref_logits, sizeof(ref_logits)) == 0;
+                elapsed_us = time_kernel(pass);
+            }
+            if (length > 0 && (size_t)length < sizeof(line)) {
+                const char* separator = line[length - 1] == ':' ? " " : ", ";
+                length += same ? snprintf(line + length, sizeof(line) - length, "%s%s %lu us", separator,
+                                          kKernelVariantNames[v],
+                                          (unsigned long)(elapsed_us / MODEL_KERNEL_AUTOTUNE_REPS))
+                               : snprintf(line + length, sizeof(line) - length, "%s%s mismatch", separator,
+                                          kKernelVariantNames[v]);
+            }
+            if (same && elapsed_us < best_us) {
+                best = v;
+                best_us = elapsed_us;
+            }
+        }
+        const uint32_t window_us = best_us / MODEL_KERNEL_AUTOTUNE_REPS;
+        choice->variant[layer] = best;
+        choice->us[layer] = (uint16_t)(window_us > UINT16_MAX ? UINT16_MAX : window_us);
+        Serial.println(line);
+    }
+
+    // 测量覆盖了输入张量与列缓存
+    g_stream_valid = false;
+    g_features_valid = false;
+}
+
+static void install_kernels(const model_kernel_choice_t& choice) {
+    g_kernels.pool = kPoolKernels[choice.variant[MODEL_KERNEL_LAYER_POOL]];
+    g_kernels.conv2 = kConv2Kernels[choice.variant[MODEL_KERNEL_LAYER_CONV2]];
+    g_kernels.fc = kFcKernels[choice.variant[MODEL_KERNEL_LAYER_FC]];
+    g_kernel_choice = choice;
+}
+
+/**
+ * @brief 按 Flash 中的记录填函数指针表；没有记录或签名不同（首次启动、重新烧录、权重布局变化）时实测并保存
+ */
+static void select_kernels() {
+    const uint32_t signature = kernel_signature();
+    model_kernel_choice_t choice;
+    bool stored = calib_store_load_kernels(&choice) && choice.signature == signature;
+    for (size_t layer = 0; stored && layer < MODEL_KERNEL_LAYERS; layer++) {
+        stored = kernel_available(layer, choice.variant[layer]);
+    }
+
+    bool saved = false;
+    const uint32_t start_ms = millis();
+    if (!stored) {
+        memset(&choice, 0, sizeof(choice));
+        choice.signature = signature;
+        tune_kernels(&choice);
+        saved = calib_store_save_kernels(&choice);
+    }
+    install_kernels(choice);
+
+    char line[160];
+    snprintf(line, sizeof(line), "[Model] Kernels (%s): conv1 + pool %s, conv2 %s, fc %s (%u + %u + %u us per window)",
+             stored ? "stored" : (saved ? "measured, saved" : "measured, not saved"),
+             kKernelVariantNames[choice.variant[MODEL_KERNEL_LAYER_POOL]],
+             kKernelVariantNames[choice.variant[MODEL_KERNEL_LAYER_CONV2]],
+             kKernelVariantNames[choice.variant[MODEL_KERNEL_LAYER_FC]], (unsigned)choice.us[MODEL_KERNEL_LAYER_POOL],
+             (unsigned)choice.us[MODEL_KERNEL_LAYER_CONV2], (unsigned)choice.us[MODEL_KERNEL_LAYER_FC]);
+    Serial.println(line);
+    if (!stored) {
+        snprintf(line, sizeof(line), "[Model] Kernel autotune took %lu ms", (unsigned long)(millis() - start_ms));
+        Serial.println(line);
+    }
+}
+#endif
+
+#if MODEL_INTERPRETER_ENABLE
+/**
+ * @brief 用解释器加载选中的 flatbuffer：编译图未初始化，idle_region 即整块静态 arena
+ */
+static bool init_interpreter() {
+    size_t arena_bytes = 0;
+    uint8_t* arena = tflite_learn_792000_36_idle_region(&arena_bytes);
+    if (!interp_module_load(g_flatbuffer, g_flatbuffer_bytes, arena, arena_bytes)) {
+        Serial.println("[Model] Failed to load the flatbuffer");
+        return false;
+    }
+
+    // 窗口长度与类别数由固件决定，flatbuffer 只能改变两者之间的图
+    TfLiteTensor builtin_input;
+    TfLiteTensor builtin_output;
+    tflite_learn_792000_36_input(0, &builtin_input);
+    tflite_learn_792000_36_output(0, &builtin_output);
+    g_input = *interp_module_input();
+    g_output = *interp_module_output();
+    if (g_input.type != kTfLiteInt8 || g_output.type != kTfLiteInt8 || g_input.bytes != builtin_input.bytes ||
+        g_output.bytes != builtin_output.bytes) {
+        Serial.println("[Model] Flatbuffer input / output tensors do not match the firmware");
+        interp_module_unload();
+        return false;
+    }
+
+    g_interp_ready = true;
+    g_model_ready = true;
+    return true;
+}
+
+/**
+ * @brief 编译图与解释器的对比：两者轮流持有同一块 arena，依次初始化、计时、释放，最后恢复调用前的状态
+ * 编译图使用内置权重（耗时与权重内容无关）
+ */
+static bool benchmark_engines(uint32_t iterations, model_benchmark_t* out_result) {
+    if (iterations == 0 || memory_module_arena_lent()) {
+        return false;
+    }
+    const bool was_ready = model_module_deinit();
+    const uint8_t* flatbuffer = g_flatbuffer;
+
+    model_benchmark_t eon_result;
+    size_t eon_tensor_bytes = 0;
+    size_t eon_persistent_bytes = 0;
+    g_flatbuffer = nullptr;
+    bool eon_ok = model_module_init();
+    if (eon_ok) {
+        tflite_learn_792000_36_arena_usage(nullptr, &eon_tensor_bytes, &eon_persistent_bytes);
+        fill_test_input();
+        eon_ok = time_invokes(&invoke_graph, iterations, &eon_result);
+    }
+    model_module_deinit();
+    g_flatbuffer = flatbuffer;
+
+    model_benchmark_t interp_result;
+    size_t interp_arena_bytes = 0;
+    bool interp_ok = model_module_init();
+    if (interp_ok) {
+        interp_arena_bytes = interp_module_arena_used();
+        fill_test_input();
+        interp_ok = time_invokes(&invoke_graph, iterations, &interp_result);
+    }
+    if (!was_ready) {
+        model_module_deinit();
+    }
+
+    if (!eon_ok || !interp_ok) {
+        Serial.println("[Model] Benchmark invoke failed");
+        return false;
+    }
+
+    print_benchmark("[Model] Benchmark (EON, " MODEL_KERNEL_BACKEND ", " MODEL_KERNEL_SIMD "): ", eon_result);
+    print_benchmark("[Model] Benchmark (interpreter, " MODEL_KERNEL_BACKEND ", " MODEL_KERNEL_SIMD "): ",
+                    interp_result);
+    const int32_t overhead_us = (int32_t)interp_result.mean_us - (int32_t)eon_result.mean_us;
+    char line[112];
+    snprintf(line, sizeof(line), "[Model] Interpreter overhead %+ld us per invoke (%+.1f%%), arena %u B vs %u B",
+             (long)overhead_us, eon_result.mean_us > 0 ? 100.0 * overhead_us / eon_result.mean_us : 0.0,
+             (unsigned)interp_arena_bytes, (unsigned)(eon_tensor_bytes + eon_persistent_bytes));
+    Serial.println(line);
+
+    if (out_result) {
+        *out_result = interp_result;
+    }
+    return true;
+}
+#endif
+
+/**
+ * @brief 检查图的第一个 RESHAPE 与窗口布局是否一致
+ * 窗口按帧交错存放（x, y, z, x, y, z, ...），RESHAPE 只改形状不搬数据，所以卷积输入的最内维须是 1
+ * （整个窗口当作一维序列）或轴数（每帧一个位置），卷积才按窗口的存放顺序读取。
+ * 编译图中输入与 RESHAPE 的输出共用 arena 中的同一块内存，RESHAPE 不再复制
+ */
+static void check_input_layout() {
+    TfLiteTensor reshaped;
+    if (tflite_learn_792000_36_tensor(TENSOR_INPUT_RESHAPE, &reshaped) != kTfLiteOk ||
+        reshaped.bytes != g_input.bytes || reshaped.dims == nullptr || reshaped.dims->size == 0) {
+        Serial.println("[Model] Graph does not start with the input RESHAPE, window layout not checked");
+        return;
+    }
+    const int inner = reshaped.dims->data[reshaped.dims->size - 1];
+    if (inner != 1 && inner != EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME) {
+        Serial.println("[Model] The first conv does not read the window frame by frame, interleaved layout mismatch");
+        return;
+    }
+    Serial.println(reshaped.data.raw == g_input.data.raw ? "[Model] Input RESHAPE in place"
+                                                         : "[Model] Input RESHAPE copies the window");
+}
+
+// ==================== 公共接口实现 ====================
+
+bool model_module_init() {
+    if (g_model_ready) {
+        return true;
+    }
+#if MODEL_INTERPRETER_ENABLE
+    if (g_flatbuffer != nullptr) {
+        return init_interpreter();
+    }
+#endif
+
+#if MODEL_SKIP_SOFTMAX
+    // 初始化之前决定：图停在全连接层时 softmax 不做 init / prepare。logits 须与输出张量同为 int8、长度相同
+    int logits_index = -1;
+    tflite_learn_792000_36_output(0, &g_output);
+    g_skip_softmax = tflite_learn_792000_36_skip_softmax(true, &logits_index) == kTfLiteOk &&
+                     tflite_learn_792000_36_tensor(logits_index, &g_logits_tensor) == kTfLiteOk &&
+                     g_logits_tensor.type == kTfLiteInt8 && g_logits_tensor.bytes == g_output.bytes &&
+                     g_logits_tensor.params.scale > 0.0f;
+    if (!g_skip_softmax) {
+        tflite_learn_792000_36_skip_softmax(false, nullptr);
+        Serial.println("[Model] Graph does not end with an int8 SOFTMAX, running it in full");
+    }
+    g_logits = nullptr;
+#endif
+
+    if (tflite_learn_792000_36_init(ei_aligned_calloc) != kTfLiteOk) {
+        Serial.println("[Model] Failed to initialize compiled graph");
+        return false;
+    }
+
+    tflite_learn_792000_36_input(0, &g_input);
+    tflite_learn_792000_36_output(0, &g_output);
+    if (g_input.type != kTfLiteInt8 || g_output.type != kTfLiteInt8) {
+        Serial.println("[Model] Expected int8 input/output tensors");
+        tflite_learn_792000_36_reset(ei_aligned_free);
+        return false;
+    }
+
+    g_model_ready = true;
+    check_input_layout();
+
+#if MODEL_SKIP_SOFTMAX
+    if (g_skip_softmax) {
+        // 堆上的 arena 在初始化时才分配，数据指针此时才有效
+        tflite_learn_792000_36_tensor(logits_index, &g_logits_tensor);
+        init_exp_lut(g_logits_tensor.params.scale);
+        char line[96];
+        snprintf(line, sizeof(line), "[Model] SOFTMAX skipped: argmax on logits, exp LUT %u B, temperature %.2f",
+                 (unsigned)(sizeof(g_exp_hi) + sizeof(g_exp_lo)), (double)MODEL_SOFTMAX_TEMPERATURE);
+        Serial.println(line);
+    }
+#endif
+
+#if MODEL_RAMFUNC_ACTIVE && defined(__MBED__)
+    // Mbed 的 MPU 默认把 RAM 设为不可执行；加锁后允许执行（不再释放，内核常驻 RAM）
+    mbed_mpu_manager_lock_ram_execution();
+#endif
+#if INFERENCE_STREAMING
+    g_stream_ready = stream_init();
+    if (!g_stream_ready) {
+        Serial.println("[Model] Graph layout changed, streaming inference disabled");
+    }
+#endif
+#if MODEL_KERNEL_AUTOTUNE
+    if (g_stream_ready) {
+        select_kernels();
+    }
+#endif
+#if MODEL_SPARSE_FC
+    if (g_stream_ready) {
+        char sparse_line[96];
+        snprintf(sparse_line, sizeof(sparse_line), "[Model] Sparse FC: %u of %u weight blocks nonzero (%u MACs)",
+                 (unsigned)g_fc_nonzero_blocks, (unsigned)(STREAM_CLASSES * STREAM_COLUMNS),
+                 (unsigned)(g_fc_nonzero_blocks * STREAM_CONV2_CH));
+        Serial.println(sparse_line);
+    }
+#endif
+#if MODEL_INT4_WEIGHTS
+    if (g_stream_ready) {
+        char int4_line[64];
+        snprintf(int4_line, sizeof(int4_line), "[Model] 4-bit weights: conv2 %s, fc %s",
+                 g_conv2.packed ? "yes" : "no", g_fc.packed ? "yes" : "no");
+        Serial.println(int4_line);
+    }
+#endif
+#if MODEL_EARLY_EXIT
+    if (EARLY_EXIT_MODEL_CLASSES == 0) {
+        Serial.println("[Model] Early-exit head not trained (train it with early_exit_trainer.py)");
+    } else if (EARLY_EXIT_MODEL_CLASSES != STREAM_CLASSES || EARLY_EXIT_MODEL_COLUMNS != STREAM_COLUMNS ||
+               EARLY_EXIT_MODEL_CHANNELS != STREAM_CONV1_CH ||
+               EARLY_EXIT_MODEL_FEATURES != 2 * STREAM_CONV1_CH) {
+        Serial.println("[Model] Early-exit head shape does not match the graph, early exit disabled");
+    } else if (g_custom_weights) {
+        Serial.println("[Model] Early-exit head was trained for the built-in weights, early exit disabled");
+    } else {
+        g_early_exit_ready = g_stream_ready;
+        char line[80];
+        snprintf(line, sizeof(line), "[Model] Early-exit head: class mask 0x%02lx, threshold %.3f",
+                 (unsigned long)kEarlyExitClassMask, (double)g_early_exit_threshold);
+        Serial.println(line);
+    }
+#endif
+    return true;
+}
+
+bool model_module_deinit() {
+    const bool was_ready = g_model_ready;
+    // 连续分类在推理之间保持编译图初始化：覆盖权重与加载解释器都要求它先复位
+    if (was_ready || tflite_learn_792000_36_initialized()) {
+        reset_engine();
+    }
+    g_model_ready = false;
+    g_stream_ready = false;
+    g_stream_valid = false;
+    g_features_valid = false;
+#if MODEL_EARLY_EXIT
+    g_early_exit_ready = false;
+    g_pooled_valid = false;
+#endif
+#if MODEL_SKIP_SOFTMAX
+    // 复位之后恢复完整的图：编译图由 run_classifier 共用，否则它在 deinit 之后输出 logits
+    if (g_skip_softmax) {
+        tflite_learn_792000_36_skip_softmax(false, nullptr);
+    }
+    g_skip_softmax = false;
+    g_logits = nullptr;
+#endif
+    return was_ready;
+}
+
+void model_module_set_custom_weights(bool custom) {
+    g_custom_weights = custom;
+}
+
+void model_module_set_flatbuffer(const uint8_t* model, size_t bytes) {
+#if MODEL_INTERPRETER_ENABLE
+    g_flatbuffer = model;
+    g_flatbuffer_bytes = model != nullptr ? bytes : 0;
+#else
+    (void)model;
+    (void)bytes;
+#endif
+}
+
+bool model_module_verify(const int8_t* input, size_t input_length, const int8_t* expected_logits,
+                         size_t num_logits) {
+    bool temporary = false;
+    if (!acquire_graph(&temporary)) {
+        return false;
+    }
+
+#if MODEL_INTERPRETER_ENABLE
+    if (g_interp_ready) {
+        bool matches = input_length == g_input.bytes && num_logits == g_output.bytes;
+        if (matches) {
+            memcpy(g_input.data.int8, input, input_length);
+            matches = invoke_graph() && memcmp(g_output.data.int8, expected_logits, num_logits) == 0;
+        }
+        release_graph(temporary);
+        return matches;
+    }
+#endif
+
+    TfLiteTensor logits;
+    bool ok = input_length == g_input.bytes && num_logits == g_output.bytes &&
+              tflite_learn_792000_36_tensor(TENSOR_FC_OUTPUT, &logits) == kTfLiteOk && logits.bytes == num_logits;
+    if (ok) {
+        memcpy(g_input.data.int8, input, input_length);
+        // 全连接层的输出与 softmax 的输出位于 arena 的不同位置，推理结束后仍可读取
+        ok = invoke_graph() && memcmp(logits.data.int8, expected_logits, num_logits) == 0;
+    }
+#if INFERENCE_STREAMING
+    if (ok && g_stream_ready) {
+        int8_t graph_output[STREAM_CLASSES];
+        memcpy(graph_output, g_output.data.int8, sizeof(graph_output));
+#if MODEL_EARLY_EXIT
+        // 只比较完整的流式路径（也不计入提前退出统计）
+        const bool early_exit_ready = g_early_exit_ready;
+        g_early_exit_ready = false;
+#endif
+        g_stream_valid = false;
+        ok = stream_run(input, 0, STREAM_INPUT_LEN) &&
+             memcmp(g_stream_logits, expected_logits, num_logits) == 0;
+#if MODEL_SKIP_SOFTMAX
+        // 跳过 softmax 时两条路径都不写输出张量，比较 logits 即可
+        ok = ok && (g_logits == g_stream_logits || memcmp(g_output.data.int8, graph_output, sizeof(graph_output)) == 0);
+#else
+        ok = ok && memcmp(g_output.data.int8, graph_output, sizeof(graph_output)) == 0;
+#endif
+#if MODEL_EARLY_EXIT
+        g_early_exit_ready = early_exit_ready;
+#endif
+    }
+#endif
+    release_graph(temporary);
+    g_features_valid = false;
+    return ok;
+}
+
+void model_module_print_kernels() {
+    Serial.println("[Model] Kernels: " MODEL_KERNEL_BACKEND ", " MODEL_KERNEL_SIMD);
+    for (size_t i = 0; i < sizeof(g_kernel_table) / sizeof(g_kernel_table[0]); i++) {
+        Serial.print("[Model]   ");
+        Serial.print(g_kernel_table[i].op);
+        Serial.print(" (");
+        Serial.print(g_kernel_table[i].shape);
+        Serial.print("): ");
+#if MODEL_SKIP_SOFTMAX
+        if (g_skip_softmax && strcmp(g_kernel_table[i].op, "SOFTMAX") == 0) {
+            Serial.println("skipped (argmax on logits, exp LUT for the winner)");
+            continue;
+        }
+#endif
+        Serial.println(g_kernel_table[i].kernel);
+    }
+}
+
+void model_module_print_placement() {
+    // 常量张量（权重、偏置、形状）是否已由启动代码复制到 RAM
+    size_t ram_bytes = 0;
+    size_t flash_bytes = 0;
+    TfLiteTensor tensor;
+    for (int i = 0; tflite_learn_792000_36_tensor(i, &tensor) == kTfLiteOk; i++) {
+        if (tensor.allocation_type != kTfLiteMmapRo) {
+            continue;
+        }
+        if (memory_module_in_static_ram(tensor.data.raw)) {
+            ram_bytes += tensor.bytes;
+        } else {
+            flash_bytes += tensor.bytes;
+        }
+    }
+    if (ram_bytes > 0) {
+        memory_module_register("model weights", ram_bytes, false);
+    }
+
+    char line[96];
+    snprintf(line, sizeof(line), "[Model] Weights: %u B in RAM, %u B in flash", (unsigned)ram_bytes,
+             (unsigned)flash_bytes);
+    Serial.println(line);
+#if MODEL_INTERPRETER_ENABLE
+    if (g_flatbuffer != nullptr) {
+        snprintf(line, sizeof(line), "[Model] Flatbuffer: %u B in %s (interpreter)", (unsigned)g_flatbuffer_bytes,
+                 memory_module_in_static_ram(g_flatbuffer) ? "RAM" : "flash");
+        Serial.println(line);
+    }
+#endif
+#if MODEL_WEIGHTS_IN_RAM
+    if (flash_bytes > 0) {
+        Serial.println("[Model] MODEL_WEIGHTS_IN_RAM is set but EI_MODEL_SECTION did not reach the compiled model");
+    }
+#endif
+
+#if INFERENCE_STREAMING
+    const bool kernels_in_ram =
+        memory_module_in_static_ram(reinterpret_cast<const void*>(reinterpret_cast<uintptr_t>(&stream_classify)));
+    Serial.println(kernels_in_ram ? "[Model] Streaming kernels: RAM (.data_model_ramfunc)"
+                                  : "[Model] Streaming kernels: flash");
+#endif
+}
+
+bool model_module_benchmark(uint32_t iterations, model_benchmark_t* out_result) {
+#if MODEL_INTERPRETER_ENABLE
+    if (g_flatbuffer != nullptr) {
+        return benchmark_engines(iterations, out_result);
+    }
+#endif
+    bool temporary = false;
+    if (iterations == 0 || !acquire_graph(&temporary)) {
+        return false;
+    }
+    fill_test_input();
+
+    model_benchmark_t result;
+    bool ok = time_invokes(&invoke_graph, iterations, &result);
+#if MODEL_SPECIALIZED_KERNELS
+    model_benchmark_t fixed_result = {};
+    int8_t graph_output[STREAM_CLASSES];
+    bool fixed_matches = false;
+    if (ok && g_stream_ready) {
+        memcpy(graph_output, result_scores(), sizeof(graph_output));
+        ok = time_invokes(&invoke_fixed, iterations, &fixed_result);
+        fixed_matches = memcmp(graph_output, result_scores(), sizeof(graph_output)) == 0;
+    }
+#endif
+    release_graph(temporary);
+
+    if (!ok) {
+        Serial.println("[Model] Benchmark invoke failed");
+        return false;
+    }
+
+    print_benchmark("[Model] Benchmark (" MODEL_KERNEL_BACKEND ", " MODEL_KERNEL_SIMD "): ", result);
+#if MODEL_SPECIALIZED_KERNELS
+    if (g_stream_ready) {
+        print_benchmark("[Model] Benchmark (specialized, " MODEL_KERNEL_SIMD "): ", fixed_result);
+        Serial.println(fixed_matches ? "[Model] Specialized kernels match the graph output"
+                                     : "[Model] Specialized kernels DIFFER from the graph output");
+    }
+#endif
+
+    if (out_result) {
+        *out_result = result;
+    }
+    return true;
+}
+
+bool model_module_profile(uint32_t iterations) {
+#if EI_CLASSIFIER_EON_PROFILER
+#if MODEL_INTERPRETER_ENABLE
+    if (g_flatbuffer != nullptr) {
+        Serial.println("[Model] Per-op profiling covers the compiled graph only, not the interpreter");
+        return false;
+    }
+#endif
+    const size_t nodes = tflite_learn_792000_36_nodes();
+    bool temporary = false;
+    if (iterations == 0 || nodes > NodeCycleProfiler::kMaxNodes || !acquire_graph(&temporary)) {
+        return false;
+    }
+    fill_test_input();
+    enable_cycle_counter();
+
+    static NodeCycleProfiler profiler;
+    profiler = NodeCycleProfiler();
+    tflite_learn_792000_36_set_profiler(&profiler);
+    bool ok = true;
+    for (uint32_t i = 0; i < iterations && ok; i++) {
+        profiler.begin_invoke();
+        ok = tflite_learn_792000_36_invoke() == kTfLiteOk;
+    }
+    tflite_learn_792000_36_set_profiler(nullptr);
+
+    uint64_t total_cycles = 0;
+    for (size_t n = 0; n < nodes; n++) {
+        total_cycles += profiler.cycles(n);
+    }
+
+    if (ok) {
+        const float cycles_per_us = SystemCoreClock / 1000000.0f;
+        char line[96];
+        Serial.print("[Model] Per-op profile (" MODEL_KERNEL_BACKEND ", " MODEL_KERNEL_SIMD "), mean of ");
+        Serial.print(iterations);
+        Serial.println(" invokes:");
+        Serial.println("[Model]   #  op               in B  out B       us      %");
+        for (size_t n = 0; n < nodes; n++) {
+            const char* op = "";
+            int input_index = -1;
+            int output_index = -1;
+            TfLiteTensor input;
+            TfLiteTensor output;
+            tflite_learn_792000_36_node(n, &op, &input_index, &output_index);
+            const size_t input_bytes =
+                tflite_learn_792000_36_tensor(input_index, &input) == kTfLiteOk ? input.bytes : 0;
+            const size_t output_bytes =
+                tflite_learn_792000_36_tensor(output_index, &output) == kTfLiteOk ? output.bytes : 0;
+            const float us = profiler.cycles(n) / cycles_per_us / iterations;
+            const float percent = total_cycles > 0 ? 100.0f * profiler.cycles(n) / total_cycles : 0.0f;
+            snprintf(line, sizeof(line), "[Model]   %u  %-15s %5u  %5u  %7.1f  %5.1f",
+                     (unsigned)n, op, (unsigned)input_bytes, (unsigned)output_bytes, us, percent);
+            Serial.println(line);
+        }
+        snprintf(line, sizeof(line), "[Model]   total %.1f us per invoke",
+                 total_cycles / cycles_per_us / iterations);
+        Serial.println(line);
+    } else {
+        Serial.println("[Model] Profile invoke failed");
+    }
+
+    release_graph(temporary);
+    return ok;
+#else
+    (void)iterations;
+    Serial.println("[Model] Per-op profiling not built in (build with -DEI_CLASSIFIER_EON_PROFILER=1)");
+    return false;
+#endif
+}
+
+void model_module_get_input_quantization(float* out_scale, int32_t* out_zero_point) {
+    if (out_scale) {
+        *out_scale = g_input.params.scale;
+    }
+    if (out_zero_point) {
+        *out_zero_point = g_input.params.zero_point;
+    }
+}
+
+void model_module_get_output_quantization(float* out_scale, int32_t* out_zero_point) {
+    if (out_scale) {
+        *out_scale = g_output.params.scale;
+    }
+    if (out_zero_point) {
+        *out_zero_point = g_output.params.zero_point;
+    }
+}
+
+size_t model_module_output_scores(int8_t* out_scores, size_t max_scores) {
+    if (!g_model_ready || out_scores == nullptr) {
+        return 0;
+    }
+    const size_t count = g_output.bytes < max_scores ? g_output.bytes : max_scores;
+#if MODEL_SKIP_SOFTMAX
+    if (g_logits != nullptr) {
+        // 没有输出张量：查表算出全部类别的概率，按输出张量的格式量化
+        float probabilities[STREAM_CLASSES];
+        const size_t classes = count < STREAM_CLASSES ? count : STREAM_CLASSES;
+        dequantize_output(probabilities, classes);
+        for (size_t i = 0; i < classes; i++) {
+            out_scores[i] = quantize_probability(probabilities[i]);
+        }
+        return classes;
+    }
+#endif
+    memcpy(out_scores, g_output.data.int8, count);
+    return count;
+}
+
+int8_t* model_module_input_buffer(size_t* out_length) {
+    if (out_length) {
+        *out_length = g_model_ready ? g_input.bytes : 0;
+    }
+    return g_model_ready ? g_input.data.int8 : nullptr;
+}
+
+int8_t model_module_quantize_score(float probability) {
+    if (!g_model_ready || g_output.params.scale <= 0.0f) {
+        return -128;
+    }
+
+    // 向上取整：量化分数 >= 阈值时反量化后的概率也不低于 probability
+    const int32_t q = (int32_t)ceilf(probability / g_output.params.scale) + g_output.params.zero_point;
+    return (int8_t)(q < -128 ? -128 : (q > 127 ? 127 : q));
+}
+
+bool model_module_invoke(float* out_scores, size_t num_scores) {
+    if (num_scores > g_output.bytes || !invoke_graph()) {
+        return false;
+    }
+
+    dequantize_output(out_scores, num_scores);
+    return true;
+}
+
+void model_module_stream_reset() {
+    g_stream_valid = false;
+}
+
+bool model_module_kernel_choice(model_kernel_choice_t* out_choice) {
+#if MODEL_KERNEL_AUTOTUNE
+    if (out_choice == nullptr || !g_stream_ready) {
+        return false;
+    }
+    *out_choice = g_kernel_choice;
+    return true;
+#else
+    (void)out_choice;
+    return false;
+#endif
+}
+
+bool model_module_stream_invoke(const int8_t* window, size_t head, size_t new_values,
+                                float* out_scores, size_t num_scores) {
+    if (num_scores > g_output.bytes || !stream_run(window, head, new_values)) {
+        return false;
+    }
+
+    dequantize_output(out_scores, num_scores);
+    return true;
+}
+
+bool model_module_stream_invoke_top(const int8_t* window, size_t head, size_t new_values,
+                                    int8_t min_score_q, model_top_result_t* out_top) {
+    if (out_top == nullptr || !stream_run(window, head, new_values)) {
+        return false;
+    }
+
+    top_output(min_score_q, out_top);
+    return true;
+}
+
+const int8_t* model_module_stream_features(size_t* out_first_column, size_t* out_columns, size_t* out_channels) {
+#if INFERENCE_STREAMING
+    if (out_first_column) {
+        *out_first_column = (g_features_head / 2) % STREAM_COLUMNS;
+    }
+    if (out_columns) {
+        *out_columns = STREAM_COLUMNS;
+    }
+    if (out_channels) {
+        *out_channels = STREAM_CONV2_CH;
+    }
+    return g_features_valid ? &g_stream_columns[0][0] : nullptr;
+#else
+    (void)out_first_column;
+    (void)out_columns;
+    (void)out_channels;
+    return nullptr;
+#endif
+}
+
+const int8_t* model_module_stream_pooled(size_t* out_first_column, size_t* out_columns, size_t* out_channels) {
+#if MODEL_EARLY_EXIT
+    if (out_first_column) {
+        *out_first_column = (g_features_head / 2) % STREAM_COLUMNS;
+    }
+    if (out_columns) {
+        *out_columns = STREAM_COLUMNS;
+    }
+    if (out_channels) {
+        *out_channels = STREAM_CONV1_CH;
+    }
+    return g_pooled_valid ? &g_stream_pooled[0][0] : nullptr;
+#else
+    (void)out_first_column;
+    (void)out_columns;
+    (void)out_channels;
+    return nullptr;
+#endif
+}
+
+void model_module_get_early_exit_stats(model_early_exit_stats_t* out_stats) {
+    if (out_stats == nullptr) {
+        return;
+    }
+    model_early_exit_stats_t stats = {};
+#if MODEL_EARLY_EXIT
+    stats.enabled = g_early_exit_ready;
+    stats.evaluated = g_early_exit_evaluated;
+    stats.taken = g_early_exit_taken;
+    const uint32_t full = g_early_exit_evaluated - g_early_exit_taken;
+    stats.early_mean_us = g_early_exit_taken > 0 ? (uint32_t)(g_early_exit_us / g_early_exit_taken) : 0;
+    stats.full_mean_us = full > 0 ? (uint32_t)(g_full_us / full) : 0;
+#endif
+    *out_stats = stats;
+}
@@ -0,0 +1,397 @@
+// 模型权重空中更新：Flash 模型槽的接收、校验与切换
+#include <Arduino.h>
+#include "rtos.h"
+#include <math.h>
+#include <string.h>
+
+#include "app_config.h"
+#include "calib_store.h"
+#include "log_module.h"
+#include "memory_module.h"
+#include "model_blob.h"
+#include "model_module.h"
+#include "model_slot_module.h"
+#include "tflite-model/tflite_learn_792000_36_compiled.h"
+
+#if MODEL_OTA_ENABLE
+
+// 推理线程待处理的请求
+enum model_slot_request_t {
+    REQUEST_NONE = 0,
+    REQUEST_SLOT,       // 切换到刚接收的槽
+    REQUEST_BUILTIN,    // 切回内置权重
+};
+
+/**
+ * @brief 解析后的权重包：entry 表、两个自检向量与（格式 2 的）flatbuffer（都指向 Flash）
+ */
+struct blob_view_t {
+    const uint8_t* blob;
+    uint16_t entry_count;
+    uint32_t version;
+    const int8_t* test_input;
+    size_t test_input_bytes;
+    const int8_t* test_logits;
+    size_t test_logits_bytes;
+    const uint8_t* flatbuffer;
+    size_t flatbuffer_bytes;
+};
+
+static const char* const kErrorNames[] = {"ok", "size", "flash", "offset", "crc", "format", "tensor", "verify", "state"};
+
+// ==================== 内部状态（模块私有） ====================
+
+// g_status 与接收状态受 g_mutex 保护（BLE 线程写、推理线程切换、任意线程读取）
+static rtos::Mutex g_mutex;
+static model_slot_status_t g_status = {MODEL_SLOT_BUILTIN, MODEL_SLOT_OK, 0xFF, 0, 0, 0};
+static uint8_t g_receive_slot = 0;
+static uint32_t g_receive_crc = 0;
+static volatile int g_request = REQUEST_NONE;
+
+// ==================== 内部辅助函数 ====================
+
+static const uint8_t* slot_data(uint8_t slot) {
+    return reinterpret_cast<const uint8_t*>(calib_store_model_slot_address(slot));
+}
+
+static bool blob_crc_ok(const uint8_t* blob, uint32_t total_bytes, uint32_t crc) {
+    if (blob == nullptr || total_bytes <= MODEL_BLOB_CRC_OFFSET) {
+        return false;
+    }
+    model_blob_header_t header;
+    memcpy(&header, blob, sizeof(header));
+    return header.crc32 == crc &&
+           calib_store_crc32(blob + MODEL_BLOB_CRC_OFFSET, total_bytes - MODEL_BLOB_CRC_OFFSET) == crc;
+}
+
+/**
+ * @brief 检查包头与每个 entry：序号、类型、长度与编译图中的张量一致，数据区不越界
+ * 格式 2 只有 flatbuffer 与自检向量，flatbuffer 的内容由解释器加载时校验
+ */
+static model_slot_error_t parse_blob(const uint8_t* blob, uint32_t total_bytes, blob_view_t* out_view) {
+    model_blob_header_t header;
+    memcpy(&header, blob, sizeof(header));
+    const uint32_t table_end = MODEL_BLOB_HEADER_BYTES + (uint32_t)header.entry_count * MODEL_BLOB_ENTRY_BYTES;
+    const bool flatbuffer_format = MODEL_INTERPRETER_ENABLE && header.format == MODEL_BLOB_FORMAT_FLATBUFFER;
+    if (header.magic != MODEL_BLOB_MAGIC || (header.format != MODEL_BLOB_FORMAT && !flatbuffer_format) ||
+        header.total_bytes != total_bytes || header.entry_count == 0 || table_end > total_bytes) {
+        return MODEL_SLOT_ERR_FORMAT;
+    }
+
+    blob_view_t view = {blob, header.entry_count, header.version, nullptr, 0, nullptr, 0, nullptr, 0};
+    for (uint16_t i = 0; i < header.entry_count; i++) {
+        model_blob_entry_t entry;
+        memcpy(&entry, blob + MODEL_BLOB_HEADER_BYTES + i * MODEL_BLOB_ENTRY_BYTES, sizeof(entry));
+        if (entry.offset % 4 != 0 || entry.offset < table_end || entry.offset > total_bytes ||
+            entry.bytes > total_bytes - entry.offset) {
+            return MODEL_SLOT_ERR_FORMAT;
+        }
+        const int8_t* data = reinterpret_cast<const int8_t*>(blob + entry.offset);
+        if (entry.tensor == MODEL_BLOB_TEST_INPUT || entry.tensor == MODEL_BLOB_TEST_LOGITS) {
+            if (entry.type != kTfLiteInt8 || entry.flags != MODEL_BLOB_HAS_DATA) {
+                return MODEL_SLOT_ERR_FORMAT;
+            }
+            if (entry.tensor == MODEL_BLOB_TEST_INPUT) {
+                view.test_input = data;
+                view.test_input_bytes = entry.bytes;
+            } else {
+                view.test_logits = data;
+                view.test_logits_bytes = entry.bytes;
+            }
+            continue;
+        }
+        if (entry.tensor == MODEL_BLOB_FLATBUFFER) {
+            if (!flatbuffer_format || entry.type != kTfLiteUInt8 || entry.flags != MODEL_BLOB_HAS_DATA ||
+                entry.bytes == 0 || entry.offset % MODEL_BLOB_FLATBUFFER_ALIGN != 0) {
+                return MODEL_SLOT_ERR_FORMAT;
+            }
+            view.flatbuffer = blob + entry.offset;
+            view.flatbuffer_bytes = entry.bytes;
+            continue;
+        }
+        if (flatbuffer_format) {
+            return MODEL_SLOT_ERR_FORMAT;
+        }
+
+        TfLiteTensor tensor;
+        if (entry.flags == 0 || (entry.flags & ~(MODEL_BLOB_HAS_DATA | MODEL_BLOB_HAS_QUANT)) != 0 ||
+            tflite_learn_792000_36_tensor(entry.tensor, &tensor) != kTfLiteOk || entry.type != tensor.type) {
+            return MODEL_SLOT_ERR_TENSOR;
+        }
+        if ((entry.flags & MODEL_BLOB_HAS_DATA) &&
+            (entry.bytes != tensor.bytes || tensor.allocation_type != kTfLiteMmapRo)) {
+            return MODEL_SLOT_ERR_TENSOR;
+        }
+        if ((entry.flags & MODEL_BLOB_HAS_QUANT) &&
+            (tensor.quantization.type != kTfLiteAffineQuantization || !(entry.scale > 0.0f) ||
+             !isfinite(entry.scale) || entry.zero_point < -128 || entry.zero_point > 127)) {
+            return MODEL_SLOT_ERR_TENSOR;
+        }
+    }
+
+    if (view.test_input == nullptr || view.test_logits == nullptr || (flatbuffer_format && view.flatbuffer == nullptr)) {
+        return MODEL_SLOT_ERR_FORMAT;
+    }
+    *out_view = view;
+    return MODEL_SLOT_OK;
+}
+
+static bool apply_overrides(const blob_view_t& view) {
+    for (uint16_t i = 0; i < view.entry_count; i++) {
+        model_blob_entry_t entry;
+        memcpy(&entry, view.blob + MODEL_BLOB_HEADER_BYTES + i * MODEL_BLOB_ENTRY_BYTES, sizeof(entry));
+        if (entry.tensor == MODEL_BLOB_TEST_INPUT || entry.tensor == MODEL_BLOB_TEST_LOGITS) {
+            continue;
+        }
+        const bool has_quant = (entry.flags & MODEL_BLOB_HAS_QUANT) != 0;
+        if (tflite_learn_792000_36_override_tensor(
+                entry.tensor, (entry.flags & MODEL_BLOB_HAS_DATA) ? view.blob + entry.offset : nullptr,
+                has_quant ? &entry.scale : nullptr, has_quant ? &entry.zero_point : nullptr) != kTfLiteOk) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 换上 blob 中的权重或 flatbuffer（nullptr = 内置权重），按需重新初始化图，并用包中的自检向量验证
+ * @param reinit 切换前图已初始化（INT8 窗口常驻）；浮点窗口由 run_classifier 每次推理自行初始化
+ */
+static model_slot_error_t install(const uint8_t* blob, uint32_t total_bytes, bool reinit, uint32_t* out_version) {
+    blob_view_t view = {nullptr, 0, 0, nullptr, 0, nullptr, 0, nullptr, 0};
+    if (blob != nullptr) {
+        const model_slot_error_t error = parse_blob(blob, total_bytes, &view);
+        if (error != MODEL_SLOT_OK) {
+            return error;
+        }
+    }
+
+    model_module_deinit();
+    tflite_learn_792000_36_clear_overrides();
+    if (blob != nullptr && view.flatbuffer == nullptr && !apply_overrides(view)) {
+        tflite_learn_792000_36_clear_overrides();
+        return MODEL_SLOT_ERR_TENSOR;
+    }
+#if MODEL_INTERPRETER_ENABLE
+    model_module_set_flatbuffer(view.flatbuffer, view.flatbuffer_bytes);
+#endif
+    model_module_set_custom_weights(blob != nullptr);
+    if (reinit && !model_module_init()) {
+        return MODEL_SLOT_ERR_VERIFY;
+    }
+    if (blob != nullptr && !model_module_verify(view.test_input, view.test_input_bytes, view.test_logits,
+                                                view.test_logits_bytes)) {
+        return MODEL_SLOT_ERR_VERIFY;
+    }
+    *out_version = view.version;
+    return MODEL_SLOT_OK;
+}
+
+/**
+ * @brief 恢复内置权重（内置权重总能初始化，除非固件本身有问题）
+ */
+static void install_builtin(bool reinit) {
+    uint32_t version = 0;
+    if (install(nullptr, 0, reinit, &version) != MODEL_SLOT_OK) {
+        LOG_ERROR("[Model OTA] Failed to restore the built-in weights\n");
+    }
+}
+
+static void set_idle_state(uint8_t active_slot, uint32_t version, model_slot_error_t error) {
+    g_mutex.lock();
+    g_status.state = active_slot == 0xFF ? MODEL_SLOT_BUILTIN : MODEL_SLOT_ACTIVE;
+    g_status.active_slot = active_slot;
+    g_status.version = version;
+    g_status.error = error;
+    g_mutex.unlock();
+}
+
+/**
+ * @brief 接收失败：记录原因，状态不变（start 可以重新开始）
+ */
+static bool fail(model_slot_error_t error) {
+    g_status.error = error;
+    g_mutex.unlock();
+    return false;
+}
+
+// ==================== 公共接口实现 ====================
+
+void model_slot_module_begin() {
+    model_commit_t commit;
+    if (!calib_store_load_model(&commit) || commit.slot > 1) {
+        LOG_INFO("[Model OTA] Using the built-in weights\n");
+        return;
+    }
+
+    const uint8_t* blob = slot_data((uint8_t)commit.slot);
+    uint32_t version = 0;
+    model_slot_error_t error = MODEL_SLOT_ERR_CRC;
+    if (commit.total_bytes <= MODEL_SLOT_BYTES && blob_crc_ok(blob, commit.total_bytes, commit.crc32)) {
+        error = install(blob, commit.total_bytes, false, &version);
+    }
+    if (error != MODEL_SLOT_OK) {
+        install_builtin(false);
+        set_idle_state(0xFF, 0, error);
+        LOG_WARN("[Model OTA] Slot %u rejected (%s), using the built-in weights\n", (unsigned)commit.slot,
+                 kErrorNames[error]);
+        return;
+    }
+    set_idle_state((uint8_t)commit.slot, version, MODEL_SLOT_OK);
+    LOG_INFO("[Model OTA] Using weights version %lu from slot %u\n", (unsigned long)version, (unsigned)commit.slot);
+}
+
+bool model_slot_module_start(uint32_t total_bytes, uint32_t crc32) {
+    g_mutex.lock();
+    if (g_status.state == MODEL_SLOT_PENDING) {
+        return fail(MODEL_SLOT_ERR_STATE);
+    }
+    if (total_bytes <= MODEL_BLOB_HEADER_BYTES || total_bytes > MODEL_SLOT_BYTES) {
+        return fail(MODEL_SLOT_ERR_SIZE);
+    }
+
+    // 写入未使用的槽；使用中的权重留在原位，切换失败或掉电时仍然可用
+    g_receive_slot = g_status.active_slot == 0 ? 1 : 0;
+    g_receive_crc = crc32;
+    g_status.state = g_status.active_slot == 0xFF ? MODEL_SLOT_BUILTIN : MODEL_SLOT_ACTIVE;
+    if (!calib_store_model_slot_erase(g_receive_slot, total_bytes)) {
+        return fail(MODEL_SLOT_ERR_FLASH);
+    }
+    g_status.state = MODEL_SLOT_RECEIVING;
+    g_status.error = MODEL_SLOT_OK;
+    g_status.received = 0;
+    g_status.total = total_bytes;
+    g_mutex.unlock();
+    LOG_INFO("[Model OTA] Receiving %lu bytes into slot %u\n", (unsigned long)total_bytes, (unsigned)g_receive_slot);
+    return true;
+}
+
+bool model_slot_module_write(uint32_t offset, const uint8_t* data, size_t length) {
+    g_mutex.lock();
+    if (g_status.state != MODEL_SLOT_RECEIVING) {
+        return fail(MODEL_SLOT_ERR_STATE);
+    }
+    // 只有最后一块可以不是 4 的倍数：已接收的字节数不是 4 的倍数说明尾块已经写过
+    if (offset != g_status.received || g_status.received % 4 != 0) {
+        return fail(MODEL_SLOT_ERR_OFFSET);
+    }
+    if (length == 0 || length > g_status.total - g_status.received) {
+        return fail(MODEL_SLOT_ERR_SIZE);
+    }
+
+    // 经对齐的缓冲区分段写入，尾块用擦除后的 0xFF 补齐到编程单位
+    alignas(4) uint8_t buffer[64];
+    for (size_t done = 0; done < length;) {
+        const size_t chunk = length - done < sizeof(buffer) ? length - done : sizeof(buffer);
+        const size_t padded = (chunk + 3) & ~(size_t)3;
+        memset(buffer, 0xFF, sizeof(buffer));
+        memcpy(buffer, data + done, chunk);
+        if (!calib_store_model_slot_program(g_receive_slot, offset + done, buffer, padded)) {
+            return fail(MODEL_SLOT_ERR_FLASH);
+        }
+        done += chunk;
+    }
+    g_status.received += length;
+    g_mutex.unlock();
+    return true;
+}
+
+bool model_slot_module_finish() {
+    g_mutex.lock();
+    if (g_status.state != MODEL_SLOT_RECEIVING) {
+        return fail(MODEL_SLOT_ERR_STATE);
+    }
+    if (g_status.received != g_status.total ||
+        !blob_crc_ok(slot_data(g_receive_slot), g_status.total, g_receive_crc)) {
+        g_status.state = g_status.active_slot == 0xFF ? MODEL_SLOT_BUILTIN : MODEL_SLOT_ACTIVE;
+        return fail(MODEL_SLOT_ERR_CRC);
+    }
+    g_status.state = MODEL_SLOT_PENDING;
+    g_request = REQUEST_SLOT;
+    g_mutex.unlock();
+    return true;
+}
+
+void model_slot_module_abort() {
+    g_mutex.lock();
+    if (g_status.state == MODEL_SLOT_RECEIVING) {
+        g_status.state = g_status.active_slot == 0xFF ? MODEL_SLOT_BUILTIN : MODEL_SLOT_ACTIVE;
+        g_status.received = 0;
+    }
+    g_mutex.unlock();
+}
+
+bool model_slot_module_request_builtin() {
+    g_mutex.lock();
+    if (g_status.state == MODEL_SLOT_PENDING) {
+        return fail(MODEL_SLOT_ERR_STATE);
+    }
+    g_status.state = MODEL_SLOT_PENDING;
+    g_request = REQUEST_BUILTIN;
+    g_mutex.unlock();
+    return true;
+}
+
+bool model_slot_module_apply() {
+    const int request = g_request;
+    // 借出 arena 期间不能重建图，下一次循环再试
+    if (request == REQUEST_NONE || memory_module_arena_lent()) {
+        return false;
+    }
+    g_request = REQUEST_NONE;
+
+    g_mutex.lock();
+    const uint8_t previous_slot = g_status.active_slot;
+    const uint32_t previous_version = g_status.version;
+    const uint8_t slot = g_receive_slot;
+    const uint32_t total_bytes = g_status.total;
+    const uint32_t crc = g_receive_crc;
+    g_mutex.unlock();
+
+    const bool reinit = model_module_deinit();
+    if (request == REQUEST_BUILTIN) {
+        install_builtin(reinit);
+        const bool erased = calib_store_erase_model();
+        set_idle_state(0xFF, 0, erased ? MODEL_SLOT_OK : MODEL_SLOT_ERR_FLASH);
+        LOG_INFO("[Model OTA] Switched to the built-in weights\n");
+        return true;
+    }
+
+    uint32_t version = 0;
+    const uint32_t start_us = micros();
+    const model_slot_error_t error = install(slot_data(slot), total_bytes, reinit, &version);
+    if (error != MODEL_SLOT_OK) {
+        // 回到原来的权重：它们在切换前已通过同样的校验
+        model_commit_t commit;
+        const uint8_t* previous = previous_slot == 0xFF ? nullptr : slot_data(previous_slot);
+        uint32_t restored = 0;
+        if (previous == nullptr || !calib_store_load_model(&commit) ||
+            install(previous, commit.total_bytes, reinit, &restored) != MODEL_SLOT_OK) {
+            install_builtin(reinit);
+            set_idle_state(0xFF, 0, error);
+        } else {
+            set_idle_state(previous_slot, previous_version, error);
+        }
+        LOG_WARN("[Model OTA] New weights rejected (%s), previous model kept\n", kErrorNames[error]);
+        return true;
+    }
+
+    // 提交记录最后写入：写入前掉电，下次启动仍使用原来的记录（或内置权重）
+    const model_commit_t commit = {slot, total_bytes, crc, version};
+    const bool saved = calib_store_save_model(&commit);
+    set_idle_state(slot, version, saved ? MODEL_SLOT_OK : MODEL_SLOT_ERR_FLASH);
+    LOG_INFO("[Model OTA] Switched to weights version %lu in slot %u (%lu us)%s\n", (unsigned long)version,
+             (unsigned)slot, (unsigned long)(micros() - start_us), saved ? "" : ", not saved to flash");
+    return true;
+}
+
+void model_slot_module_get_status(model_slot_status_t* out_status) {
+    if (out_status == nullptr) {
+        return;
+    }
+    g_mutex.lock();
+    *out_status = g_status;
+    g_mutex.unlock();
+}
+
+#endif
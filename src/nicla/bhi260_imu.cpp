@@ -0,0 +1,334 @@
+// Nicla Sense ME 的 IMU 模块：按 imu_module.h 的接口从 BHI260AP 的虚拟传感器取帧（Arduino_BHY2）
+// BHI260 自己的核以最接近 output_hz 的速率采样、校准，并按 NICLA_BATCH_MS 的时延把事件攒在它的 FIFO 中；
+// 采集线程每个批次醒来一次，BHY2.update() 取出整批事件，线性重采样到 output_hz 后交给推理线程。
+// 开启 MOTION_GATE_ENABLE 时静止期间关闭加速度 / 陀螺仪通路，BHI260 只运行 significant motion 检测，
+// 主机每 NICLA_IDLE_POLL_MS 才醒来查询一次运动事件
+#include <Arduino.h>
+#include "Arduino_BHY2.h"
+#include <chrono>
+#include <ctype.h>
+#include <string.h>
+
+#include "app_config.h"
+#include "energy_module.h"
+#include "imu_module.h"
+#include "log_module.h"
+#include "resampler.h"
+#include "supervisor_module.h"
+
+// BHI260 虚拟传感器的默认量程：±8 g / ±2000 dps
+#define ACC_LSB_PER_G          4096.0f
+#define GYR_LSB_PER_DPS        16.384f
+
+// 一个批次最多的输出帧数（按 200 Hz 算 NICLA_BATCH_MS 内的样本，留一倍余量），放不下的帧丢弃
+#define BATCH_MAX_FRAMES       (2 * (NICLA_BATCH_MS * 200 / 1000) + 8)
+
+namespace {
+
+/**
+ * @brief 把每个事件都收进来的虚拟传感器（库里的 SensorXYZ 只保留最新一个值）
+ */
+class BatchedSensor : public SensorClass {
+public:
+    typedef void (*handler_t)(const int16_t* xyz);
+
+    BatchedSensor(uint8_t id, handler_t handler) : SensorClass(id), handler_(handler) {}
+
+    void setData(SensorDataPacket& data) override {
+        DataXYZ xyz;
+        DataParser::parse3DVector(data, xyz);
+        const int16_t values[3] = {xyz.x, xyz.y, xyz.z};
+        handler_(values);
+    }
+    void setData(SensorLongDataPacket&) override {}
+    String toString() override { return String(); }
+
+private:
+    handler_t handler_;
+};
+
+/**
+ * @brief significant motion 事件：只记录时间
+ */
+class MotionEventSensor : public SensorClass {
+public:
+    explicit MotionEventSensor(uint8_t id) : SensorClass(id), last_ms_(0), events_(0) {}
+
+    void setData(SensorDataPacket&) override {
+        last_ms_ = millis();
+        events_++;
+    }
+    void setData(SensorLongDataPacket&) override {}
+    String toString() override { return String(); }
+
+    uint32_t last_ms() const { return last_ms_; }
+    uint32_t events() const { return events_; }
+
+private:
+    uint32_t last_ms_;
+    uint32_t events_;
+};
+
+struct axis_name_t {
+    const char* name;
+    uint8_t channel;
+};
+
+// 与 imu_module.cpp 相同的融合轴名称
+const axis_name_t kAxisNames[] = {
+    {"accx", 0}, {"accy", 1}, {"accz", 2},
+    {"gyrx", 3}, {"gyry", 4}, {"gyrz", 5},
+    {"gyrox", 3}, {"gyroy", 4}, {"gyroz", 5},
+};
+
+void on_accel(const int16_t* xyz);
+void on_gyro(const int16_t* xyz);
+
+BatchedSensor g_accel(SENSOR_ID_ACC, on_accel);
+BatchedSensor g_gyro(SENSOR_ID_GYRO, on_gyro);
+MotionEventSensor g_motion(SENSOR_ID_SIG);
+
+uint8_t g_axis_map[IMU_MAX_AXES];
+size_t g_axis_count = 0;
+bool g_gyro_enabled = false;
+float g_sensor_hz = 0.0f;
+
+#if INFERENCE_Q15_FEATURES
+LinearResamplerQ15<IMU_MAX_AXES> g_resampler;
+#else
+LinearResampler<IMU_MAX_AXES> g_resampler;
+#endif
+
+// 本批次重采样后的输出帧（按融合轴顺序），读取时逐批交出
+imu_sample_t g_pending[BATCH_MAX_FRAMES * IMU_MAX_AXES];
+size_t g_pending_frames = 0;
+size_t g_pending_pos = 0;
+
+// 陀螺仪事件在同一时刻的加速度事件之前到达时先存下来，与下一个加速度事件拼成一帧
+int16_t g_last_gyro[3] = {0, 0, 0};
+
+bool g_streaming = false;
+uint32_t g_motion_events_seen = 0;
+imu_stats_t g_stats = {};
+
+inline float channel_lsb(size_t channel) {
+    return channel < 3 ? ACC_LSB_PER_G : GYR_LSB_PER_DPS;
+}
+
+int channel_from_name(const char* name) {
+    for (size_t i = 0; i < sizeof(kAxisNames) / sizeof(kAxisNames[0]); i++) {
+        if (strcmp(name, kAxisNames[i].name) == 0) {
+            return kAxisNames[i].channel;
+        }
+    }
+    return -1;
+}
+
+bool parse_axes(const char* fusion_axes) {
+    g_axis_count = 0;
+    g_gyro_enabled = false;
+    const char* p = fusion_axes;
+    while (*p) {
+        while (*p == ' ' || *p == '+') {
+            p++;
+        }
+        if (!*p) {
+            break;
+        }
+        char token[8];
+        size_t len = 0;
+        while (*p && *p != ' ' && *p != '+') {
+            if (len < sizeof(token) - 1) {
+                token[len++] = (char)tolower((unsigned char)*p);
+            }
+            p++;
+        }
+        token[len] = '\0';
+        const int channel = channel_from_name(token);
+        if (channel < 0 || g_axis_count >= IMU_MAX_AXES) {
+            return false;
+        }
+        g_axis_map[g_axis_count++] = (uint8_t)channel;
+        g_gyro_enabled = g_gyro_enabled || channel >= 3;
+    }
+    return g_axis_count > 0;
+}
+
+void on_gyro(const int16_t* xyz) {
+    memcpy(g_last_gyro, xyz, sizeof(g_last_gyro));
+}
+
+/**
+ * @brief 一个加速度事件即一个传感器帧：换算、按融合轴打包、重采样进本批次的输出
+ */
+void on_accel(const int16_t* xyz) {
+    g_stats.sensor_frames++;
+    const int16_t sensor[IMU_MAX_AXES] = {xyz[0], xyz[1], xyz[2], g_last_gyro[0], g_last_gyro[1], g_last_gyro[2]};
+    imu_sample_t packed[IMU_MAX_AXES] = {0};
+    for (size_t i = 0; i < g_axis_count; i++) {
+#if INFERENCE_Q15_FEATURES
+        packed[i] = sensor[g_axis_map[i]];
+#else
+        packed[i] = sensor[g_axis_map[i]] / channel_lsb(g_axis_map[i]);
+#endif
+    }
+    imu_sample_t out[2 * IMU_MAX_AXES];
+    const size_t produced = g_resampler.push(packed, out, 2);
+    for (size_t f = 0; f < produced && g_pending_frames < BATCH_MAX_FRAMES; f++) {
+        memcpy(&g_pending[g_pending_frames++ * g_axis_count], &out[f * IMU_MAX_AXES],
+               g_axis_count * sizeof(imu_sample_t));
+    }
+}
+
+/**
+ * @brief 打开 / 关闭加速度（与陀螺仪）通路；打开时重采样从干净状态开始
+ */
+void set_streaming(bool enable) {
+    if (enable == g_streaming) {
+        return;
+    }
+    g_streaming = enable;
+    const float rate = enable ? g_sensor_hz : 0.0f;
+    const uint32_t latency = enable ? NICLA_BATCH_MS : 0;
+    g_accel.configure(rate, latency);
+    if (g_gyro_enabled) {
+        g_gyro.configure(rate, latency);
+    }
+    g_resampler.reset();
+}
+
+/**
+ * @brief 运动门控：significant motion 之后保持 NICLA_MOTION_HOLD_MS，其余时间关闭数据通路
+ */
+void update_motion_gate() {
+#if MOTION_GATE_ENABLE
+    if (g_motion.events() != g_motion_events_seen) {
+        g_motion_events_seen = g_motion.events();
+        g_stats.motion_events++;
+        // significant motion 是一次性检测，触发后重新使能
+        g_motion.configure(1.0f, 0);
+    }
+    set_streaming(millis() - g_motion.last_ms() < NICLA_MOTION_HOLD_MS && g_motion_events_seen > 0);
+#endif
+}
+
+}  // namespace
+
+// ==================== 公共接口实现 ====================
+
+bool imu_module_init(float output_hz, const char* fusion_axes) {
+    if (!parse_axes(fusion_axes)) {
+        Serial.println("[IMU] Invalid axis layout");
+        return false;
+    }
+    if (!BHY2.begin(NICLA_STANDALONE)) {
+        Serial.println("[IMU] Failed to initialize BHI260");
+        return false;
+    }
+
+    // BHI260 只支持 1.5625 Hz 的 2 的幂倍速率，取不低于 output_hz 的一档，主机侧重采样到 output_hz
+    g_sensor_hz = 1.5625f;
+    while (g_sensor_hz < output_hz) {
+        g_sensor_hz *= 2.0f;
+    }
+    g_resampler.set_rates(g_sensor_hz, output_hz);
+    g_resampler.reset();
+    g_stats.sensor_hz = g_sensor_hz;
+    g_stats.output_hz = output_hz;
+
+#if MOTION_GATE_ENABLE
+    if (!g_motion.begin(1.0f, 0)) {
+        Serial.println("[IMU] Failed to enable significant motion detection");
+        return false;
+    }
+    Serial.println("[IMU] BHI260 batching, gated by significant motion");
+#else
+    set_streaming(true);
+    Serial.println("[IMU] BHI260 batching enabled");
+#endif
+    return true;
+}
+
+size_t imu_module_read_frames(imu_sample_t* out_frames, size_t max_frames) {
+    while (g_pending_pos >= g_pending_frames) {
+        g_pending_frames = 0;
+        g_pending_pos = 0;
+        // 数据通路打开时按批次时延醒来，关闭时只为查询运动事件
+        energy_module_sleep_for(ENERGY_SAMPLER,
+                                std::chrono::milliseconds(g_streaming ? NICLA_BATCH_MS : NICLA_IDLE_POLL_MS));
+        g_stats.wakeups++;
+        const uint32_t start_us = micros();
+        BHY2.update();
+        update_motion_gate();
+        g_stats.process_us += micros() - start_us;
+        g_stats.output_frames += g_pending_frames;
+        supervisor_module_heartbeat(THREAD_SAMPLER);
+    }
+
+    size_t frames = g_pending_frames - g_pending_pos;
+    if (frames > max_frames) {
+        frames = max_frames;
+    }
+    memcpy(out_frames, &g_pending[g_pending_pos * g_axis_count], frames * g_axis_count * sizeof(imu_sample_t));
+    g_pending_pos += frames;
+    return frames;
+}
+
+size_t imu_module_axis_count() {
+    return g_axis_count;
+}
+
+float imu_module_axis_lsb(size_t axis) {
+#if INFERENCE_Q15_FEATURES
+    return axis < g_axis_count ? channel_lsb(g_axis_map[axis]) : 1.0f;
+#else
+    (void)axis;
+    return 1.0f;
+#endif
+}
+
+uint8_t imu_module_axis_channel(size_t axis) {
+    return axis < g_axis_count ? g_axis_map[axis] : 0xFF;
+}
+
+float imu_module_channel_lsb(size_t channel) {
+    return channel_lsb(channel);
+}
+
+bool imu_module_motion_active() {
+    return !MOTION_GATE_ENABLE || g_streaming;
+}
+
+void imu_module_set_raw_sink(imu_raw_sink_t sink) {
+    // BHI260 只交出校准后的虚拟传感器数据，没有未经处理的原始帧
+    if (sink) {
+        LOG_WARN("[IMU] Raw recording is not available on the Nicla Sense ME build\n");
+    }
+}
+
+bool imu_module_set_replay_source(imu_replay_source_t source) {
+    (void)source;
+    return false;
+}
+
+void imu_module_set_low_rate(bool low_rate) {
+    // 虚拟传感器以模型采样率批量交付，没有可单独降低的高速 ODR
+    (void)low_rate;
+}
+
+bool imu_module_recover() {
+    // 重新下发虚拟传感器配置，丢弃本批次剩余的帧
+    g_stats.recoveries++;
+    const bool streaming = g_streaming;
+    g_streaming = !streaming;
+    set_streaming(streaming);
+    g_pending_frames = 0;
+    g_pending_pos = 0;
+    return true;
+}
+
+void imu_module_get_stats(imu_stats_t* out_stats) {
+    if (out_stats) {
+        *out_stats = g_stats;
+    }
+}
@@ -0,0 +1,175 @@
+// 处理流水线各级统计模块实现
+#include <Arduino.h>
+#include <atomic>
+
+#include "app_config.h"
+#include "crash_module.h"
+#include "log_module.h"
+#include "pipeline_module.h"
+#include "seqlock.h"
+#include "stat_counters.h"
+#include "stats_module.h"
+
+// 各级单次耗时的直方图：32 个 500 us 桶（16 ms 量程，更长的落入最后一个桶，最大值仍精确）
+#define PIPELINE_BUCKETS 32
+#define PIPELINE_BUCKET_US 500
+
+// ==================== 内部状态（模块私有） ====================
+
+struct pipeline_stage_entry_t {
+    const char* name;
+    const char* thread;         // 运行这一级的线程（thread_module 线程表中的名字）
+    const char* time_stat;      // 统计注册表中的耗时分布（当前窗口）
+    const char* overrun_stat;   // 统计注册表中的输入队列丢弃数（nullptr = 没有输入队列）
+};
+
+// 顺序与 pipeline_stage_t 一致
+static const pipeline_stage_entry_t kStageTable[PIPELINE_STAGE_COUNT] = {
+    {"acquire", "sampler", "pipeline.acquire_us", nullptr},
+    {"window", "inference", "pipeline.window_us", "pipeline.window_drops"},
+    {"infer", "inference", "pipeline.infer_us", nullptr},
+    {"postprocess", "inference", "pipeline.postprocess_us", nullptr},
+    {"ble", "ble", "pipeline.ble_us", "pipeline.ble_drops"},
+    {"led", "events", "pipeline.led_us", "pipeline.led_drops"},
+};
+
+// 当前窗口的累计值：每一级由运行它的线程无锁记录，报告时取出清零
+struct stage_accumulator_t {
+    StatHistogram<PIPELINE_BUCKETS> time_us;
+    StatCounter total_us;
+    StatMax queue_peak;
+    StatMax queue_capacity;  // 跨窗口保留
+    StatMax overruns;        // 队列自己的累计丢弃数，跨窗口保留
+
+    stage_accumulator_t() : time_us(PIPELINE_BUCKET_US) {}
+};
+
+struct pipeline_snapshot_t {
+    pipeline_stage_stats_t stages[PIPELINE_STAGE_COUNT];
+};
+
+// 上一个窗口的快照由报告者（推理线程）发布，任意线程读取；窗口起点只有报告者读写
+static stage_accumulator_t g_stages[PIPELINE_STAGE_COUNT];
+static Seqlock<pipeline_snapshot_t> g_snapshots;
+static uint32_t g_window_start_ms = 0;
+
+// 有消费者的产出（位 = pipeline_output_t）
+static std::atomic<uint32_t> g_subscriptions((1UL << PIPELINE_OUTPUT_EVENTS) |
+                                             (LED_ENABLE ? (1UL << PIPELINE_OUTPUT_LED) : 0));
+
+// ==================== 内部辅助函数 ====================
+
+/**
+ * @brief 一级是否仍在流水线中：发布级只服务于一个产出，该产出没有消费者时整级不运行
+ */
+static bool stage_has_consumers(size_t stage) {
+    switch (stage) {
+        case PIPELINE_BLE:
+            return pipeline_module_subscribed(PIPELINE_OUTPUT_EVENTS);
+        case PIPELINE_LED:
+            return pipeline_module_subscribed(PIPELINE_OUTPUT_LED);
+        default:
+            return true;
+    }
+}
+
+// ==================== 公共接口实现 ====================
+
+void pipeline_module_init() {
+    for (size_t i = 0; i < PIPELINE_STAGE_COUNT; i++) {
+        stats_module_register(kStageTable[i].time_stat, &g_stages[i].time_us);
+        if (kStageTable[i].overrun_stat) {
+            stats_module_register(kStageTable[i].overrun_stat, &g_stages[i].overruns);
+        }
+    }
+}
+
+void pipeline_module_record(pipeline_stage_t stage, uint32_t start_us) {
+    if (stage >= PIPELINE_STAGE_COUNT) {
+        return;
+    }
+    const uint32_t elapsed_us = micros() - start_us;
+    crash_module_trail((uint8_t)stage, start_us, elapsed_us);
+    stage_accumulator_t& acc = g_stages[stage];
+    acc.time_us.record(elapsed_us);
+    acc.total_us.add(elapsed_us);
+}
+
+void pipeline_module_record_queue(pipeline_stage_t stage, size_t depth, size_t capacity, uint32_t overruns) {
+    if (stage >= PIPELINE_STAGE_COUNT) {
+        return;
+    }
+    stage_accumulator_t& acc = g_stages[stage];
+    acc.queue_peak.observe((uint32_t)(depth > 0xFFFF ? 0xFFFF : depth));
+    acc.queue_capacity.observe((uint32_t)(capacity > 0xFFFF ? 0xFFFF : capacity));
+    acc.overruns.observe(overruns);
+}
+
+void pipeline_module_get_stats(pipeline_stage_t stage, pipeline_stage_stats_t* out_stats) {
+    if (!out_stats || stage >= PIPELINE_STAGE_COUNT) {
+        return;
+    }
+    pipeline_snapshot_t snapshot;
+    g_snapshots.load(&snapshot);
+    *out_stats = snapshot.stages[stage];
+}
+
+void pipeline_module_subscribe(pipeline_output_t output, bool subscribed) {
+    if (output >= PIPELINE_OUTPUT_COUNT) {
+        return;
+    }
+    if (subscribed) {
+        g_subscriptions.fetch_or(1UL << output);
+    } else {
+        g_subscriptions.fetch_and(~(1UL << output));
+    }
+}
+
+bool pipeline_module_subscribed(pipeline_output_t output) {
+    return output < PIPELINE_OUTPUT_COUNT && (g_subscriptions.load(std::memory_order_relaxed) & (1UL << output)) != 0;
+}
+
+const char* pipeline_module_stage_name(pipeline_stage_t stage) {
+    return stage < PIPELINE_STAGE_COUNT ? kStageTable[stage].name : "unknown";
+}
+
+void pipeline_module_report() {
+    pipeline_snapshot_t snapshot;
+    pipeline_stage_stats_t* stats = snapshot.stages;
+    const uint32_t now_ms = millis();
+    const uint32_t window_us = (now_ms - g_window_start_ms) * 1000UL;
+    g_window_start_ms = now_ms;
+    for (size_t i = 0; i < PIPELINE_STAGE_COUNT; i++) {
+        stage_accumulator_t& acc = g_stages[i];
+        StatBins<PIPELINE_BUCKETS> bins;
+        acc.time_us.take(&bins);
+        // 耗时之和与直方图分别取出，相差取出期间正在进行的一两次记录
+        const uint64_t total_us = acc.total_us.take();
+        stats[i].runs = bins.count;
+        stats[i].mean_us = bins.count > 0 ? (uint32_t)(total_us / bins.count) : 0;
+        stats[i].max_us = bins.max;
+        stats[i].busy_permille = window_us > 0 ? (uint32_t)(total_us * 1000 / window_us) : 0;
+        stats[i].queue_peak = (uint16_t)acc.queue_peak.take();
+        stats[i].queue_capacity = (uint16_t)acc.queue_capacity.value();
+        stats[i].overruns = acc.overruns.value();
+    }
+    g_snapshots.store(snapshot);
+
+    for (size_t i = 0; i < PIPELINE_STAGE_COUNT; i++) {
+        const pipeline_stage_stats_t& s = stats[i];
+        if (s.runs == 0 && !stage_has_consumers(i)) {
+            LOG_INFO("[Pipeline] %-11s (%-9s) no consumers, not running\n", kStageTable[i].name, kStageTable[i].thread);
+        } else if (s.queue_capacity > 0) {
+            LOG_INFO("[Pipeline] %-11s (%-9s) runs %lu, mean %lu us, max %lu us, busy %lu.%lu%%, queue peak %u/%u, overruns %lu\n",
+                     kStageTable[i].name, kStageTable[i].thread, (unsigned long)s.runs, (unsigned long)s.mean_us,
+                     (unsigned long)s.max_us, (unsigned long)(s.busy_permille / 10),
+                     (unsigned long)(s.busy_permille % 10), (unsigned)s.queue_peak, (unsigned)s.queue_capacity,
+                     (unsigned long)s.overruns);
+        } else {
+            LOG_INFO("[Pipeline] %-11s (%-9s) runs %lu, mean %lu us, max %lu us, busy %lu.%lu%%\n",
+                     kStageTable[i].name, kStageTable[i].thread, (unsigned long)s.runs, (unsigned long)s.mean_us,
+                     (unsigned long)s.max_us, (unsigned long)(s.busy_permille / 10),
+                     (unsigned long)(s.busy_permille % 10));
+        }
+    }
+}
@@ -0,0 +1,148 @@
+// Portenta H7 M4 核的固件（[env:portenta_h7_m4]）：运行 imu_module（BMI270 FIFO 读出、抗混叠抽取、校准、重采样），
+// 把输出帧写进 SRAM4 中的共享环形缓冲并通知 M7（见 h7_link.h）。
+// 本核只链接 imu_module / imu_bus / calib_store，能耗统计与监督由 M7 负责，这里提供空实现；
+// LOG_* 记录转交 M7 的日志线程输出，imu_module 的 Serial 启动信息只在 M4 自己的串口上可见
+#include <Arduino.h>
+#include "mbed.h"
+#include "rtos.h"
+#include <chrono>
+#include <string.h>
+
+#include "app_config.h"
+#include "energy_module.h"
+#include "h7_link.h"
+#include "imu_module.h"
+#include "log_module.h"
+#include "supervisor_module.h"
+
+// ==================== 内部状态（模块私有） ====================
+
+// 每次从 imu_module 读取的最多帧数（与 M7 采集线程的批大小相同）
+#define M4_BATCH_FRAMES 8
+
+static imu_sample_t g_batch[M4_BATCH_FRAMES * IMU_MAX_AXES];
+static uint32_t g_recovers_seen = 0;
+
+/**
+ * @brief 释放一次硬件信号量，触发 M7 的 HSEM 中断
+ * M4 没有数据缓存，之前对 SRAM4 的写在 __DMB 后对 M7 可见
+ */
+static void notify_m7() {
+    __DMB();
+    if (HAL_HSEM_FastTake(H7_LINK_HSEM) == HAL_OK) {
+        HAL_HSEM_Release(H7_LINK_HSEM, 0);
+    }
+}
+
+/**
+ * @brief 把一批帧写进环形缓冲；M7 来不及取时丢弃放不下的帧并计数（不覆盖 M7 正在读的帧）
+ */
+static void publish_frames(const imu_sample_t* frames, size_t count, size_t axes) {
+    volatile h7_link_t* link = h7_link();
+    uint32_t head = link->frame_head;
+    const uint32_t tail = link->frame_tail;
+    for (size_t i = 0; i < count; i++) {
+        if (head - tail >= H7_LINK_FRAMES) {
+            link->frame_overruns += (uint32_t)(count - i);
+            break;
+        }
+        memcpy((void*)link->frames[head & (H7_LINK_FRAMES - 1)], &frames[i * axes], axes * sizeof(imu_sample_t));
+        head++;
+    }
+    // 帧数据先于 head 可见
+    __DMB();
+    link->frame_head = head;
+}
+
+// ==================== M7 负责的模块：M4 上的空实现 ====================
+
+void energy_module_wake(energy_thread_t thread) {
+    (void)thread;
+}
+
+void energy_module_sleep(energy_thread_t thread) {
+    (void)thread;
+}
+
+void energy_module_sleep_for(energy_thread_t thread, std::chrono::milliseconds duration) {
+    (void)thread;
+    rtos::ThisThread::sleep_for(duration);
+}
+
+void supervisor_module_heartbeat(thread_role_t role) {
+    // M4 停止出帧时 M7 的采集线程得不到心跳，由 M7 的监督者处理
+    (void)role;
+}
+
+/**
+ * @brief 日志记录转交 M7（M4 只有 loop 一个写者）；M7 来不及取时丢弃并计数
+ */
+void log_module_push(const log_record_t& record) {
+    volatile h7_link_t* link = h7_link();
+    const uint32_t head = link->log_head;
+    if (head - link->log_tail >= H7_LINK_LOGS) {
+        link->log_overruns++;
+        return;
+    }
+    memcpy((void*)&link->logs[head & (H7_LINK_LOGS - 1)], &record, sizeof(record));
+    __DMB();
+    link->log_head = head + 1;
+    notify_m7();
+}
+
+// ==================== Arduino 入口 ====================
+
+void setup() {
+    volatile h7_link_t* link = h7_link();
+    __HAL_RCC_HSEM_CLK_ENABLE();
+
+    // M7 在引导本核之前写好配置；配置无效时没有人能读到帧，停在失败状态
+    char axes[H7_LINK_AXES_CHARS];
+    memcpy(axes, (const void*)link->fusion_axes, sizeof(axes));
+    axes[sizeof(axes) - 1] = '\0';
+    if (link->magic != H7_LINK_MAGIC || !imu_module_init(link->output_hz, axes)) {
+        link->state = H7_LINK_FAILED;
+        notify_m7();
+        return;
+    }
+
+    const size_t axis_count = imu_module_axis_count();
+    link->axis_count = (uint32_t)axis_count;
+    for (size_t i = 0; i < IMU_MAX_AXES; i++) {
+        link->axis_channel[i] = imu_module_axis_channel(i);
+        link->axis_lsb[i] = imu_module_axis_lsb(i);
+        link->channel_lsb[i] = imu_module_channel_lsb(i);
+    }
+    g_recovers_seen = link->recover_requests;
+    link->motion_active = imu_module_motion_active() ? 1 : 0;
+    __DMB();
+    link->state = H7_LINK_READY;
+    notify_m7();
+}
+
+void loop() {
+    volatile h7_link_t* link = h7_link();
+    if (link->state != H7_LINK_READY) {
+        rtos::ThisThread::sleep_for(std::chrono::milliseconds(100));
+        return;
+    }
+
+    // imu_module_read_frames 在水位中断上阻塞，M4 其余时间在 WFI 中
+    const size_t frames = imu_module_read_frames(g_batch, M4_BATCH_FRAMES);
+
+    // M7 请求的重新配置（其监督者发现采集停顿时）：本批帧已不连续，丢弃
+    const uint32_t requests = link->recover_requests;
+    if (requests != g_recovers_seen) {
+        g_recovers_seen = requests;
+        imu_module_recover();
+    } else {
+        publish_frames(g_batch, frames, imu_module_axis_count());
+    }
+
+    imu_stats_t stats;
+    imu_module_get_stats(&stats);
+    memcpy((void*)&link->stats, &stats, sizeof(stats));
+    link->motion_active = imu_module_motion_active() ? 1 : 0;
+    link->recovers_done = g_recovers_seen;
+    notify_m7();
+}
@@ -0,0 +1,254 @@
+// Portenta H7 M7 侧的 IMU 模块：按 imu_module.h 的接口从 M4 写入的共享环形缓冲取帧（见 h7_link.h）
+// 采集线程、窗口与推理路径与单核构建完全相同，只是传感器、抽取与重采样在 M4 上运行
+#include <Arduino.h>
+#include "mbed.h"
+#include "rtos.h"
+#include <chrono>
+#include <string.h>
+#include "stm32h7xx_ll_rcc.h"
+
+#include "app_config.h"
+#include "energy_module.h"
+#include "h7_link.h"
+#include "imu_module.h"
+#include "log_module.h"
+#include "supervisor_module.h"
+
+// ==================== 内部状态（模块私有） ====================
+
+#define LINK_FLAG_FRAMES       0x01
+// 与 imu_module.cpp 的水位等待相同：通知丢失时最多晚这么久查询一次
+#define LINK_WAIT_TIMEOUT_MS   100
+#define LINK_HSEM_MASK         __HAL_HSEM_SEMID_TO_MASK(H7_LINK_HSEM)
+
+static rtos::EventFlags g_link_flags;
+
+// M4 完成初始化时发布的轴信息（启动后不变，复制到本地避免每次访问都失效缓存行）
+static size_t g_axis_count = 0;
+static uint8_t g_axis_map[IMU_MAX_AXES];
+static float g_axis_lsb[IMU_MAX_AXES];
+static float g_channel_lsb[IMU_MAX_AXES];
+
+static uint32_t g_wakeups = 0;
+static bool g_ready = false;
+
+/**
+ * @brief 按缓存行失效 M4 写的字段（读之前调用）；范围扩展到整行，这些行 M7 从不写，失效不会丢数据
+ */
+static void invalidate(const volatile void* address, size_t bytes) {
+    const uintptr_t start = (uintptr_t)address & ~(uintptr_t)(H7_LINK_CACHE_LINE - 1);
+    const uintptr_t end = ((uintptr_t)address + bytes + H7_LINK_CACHE_LINE - 1) &
+                          ~(uintptr_t)(H7_LINK_CACHE_LINE - 1);
+    SCB_InvalidateDCache_by_Addr((uint32_t*)start, (int32_t)(end - start));
+}
+
+/**
+ * @brief 把 M7 写的字段写回 SRAM4（写之后调用）
+ */
+static void clean(const volatile void* address, size_t bytes) {
+    const uintptr_t start = (uintptr_t)address & ~(uintptr_t)(H7_LINK_CACHE_LINE - 1);
+    const uintptr_t end = ((uintptr_t)address + bytes + H7_LINK_CACHE_LINE - 1) &
+                          ~(uintptr_t)(H7_LINK_CACHE_LINE - 1);
+    SCB_CleanDCache_by_Addr((uint32_t*)start, (int32_t)(end - start));
+}
+
+/**
+ * @brief HSEM 中断：M4 每写完一批帧（或一条日志）释放一次信号量
+ * 只清除标志、保持通知使能（HAL_HSEM_IRQHandler 会关闭通知，这里不用它）
+ */
+static void on_hsem_irq() {
+    const uint32_t status = HSEM_COMMON->MISR;
+    HSEM_COMMON->ICR = status;
+    if (status & LINK_HSEM_MASK) {
+        g_link_flags.set(LINK_FLAG_FRAMES);
+    }
+}
+
+/**
+ * @brief 把 M4 转交的日志记录交给本核的日志线程（格式串与 %s 参数在 M4 的 flash 中，直接可读）
+ */
+static void drain_logs() {
+    h7_link_t* link = h7_link();
+    invalidate(&link->log_head, sizeof(link->log_head));
+    const uint32_t head = link->log_head;
+    uint32_t tail = link->log_tail;
+    if (head == tail) {
+        return;
+    }
+    invalidate(link->logs, sizeof(link->logs));
+    for (; tail != head; tail++) {
+        log_record_t record = link->logs[tail & (H7_LINK_LOGS - 1)];
+        log_module_push(record);
+    }
+    link->log_tail = tail;
+    clean(&link->log_tail, sizeof(link->log_tail));
+}
+
+/**
+ * @brief 复制环形缓冲中从 tail 开始的 frames 帧（调用者保证不跨越 head）
+ */
+static void copy_frames(imu_sample_t* out_frames, uint32_t tail, size_t frames) {
+    h7_link_t* link = h7_link();
+    while (frames > 0) {
+        const uint32_t index = tail & (H7_LINK_FRAMES - 1);
+        size_t run = H7_LINK_FRAMES - index;
+        if (run > frames) {
+            run = frames;
+        }
+        invalidate(link->frames[index], run * sizeof(link->frames[0]));
+        for (size_t i = 0; i < run; i++) {
+            memcpy(out_frames, link->frames[index + i], g_axis_count * sizeof(imu_sample_t));
+            out_frames += g_axis_count;
+        }
+        tail += run;
+        frames -= run;
+    }
+}
+
+/**
+ * @brief 引导 M4（其镜像须已烧写到 0x08100000），等待它完成 IMU 初始化
+ */
+static bool boot_m4() {
+    HAL_SYSCFG_CM4BootAddConfig(SYSCFG_BOOT_ADDR0, 0x08100000);
+    LL_RCC_ForceCM4Boot();
+
+    h7_link_t* link = h7_link();
+    const uint32_t start_ms = millis();
+    while (millis() - start_ms < H7_LINK_BOOT_TIMEOUT_MS) {
+        invalidate(&link->state, sizeof(link->state));
+        if (link->state != H7_LINK_BOOTING) {
+            break;
+        }
+        drain_logs();
+        rtos::ThisThread::sleep_for(std::chrono::milliseconds(10));
+    }
+    drain_logs();
+    return link->state == H7_LINK_READY;
+}
+
+// ==================== 公共接口实现 ====================
+
+bool imu_module_init(float output_hz, const char* fusion_axes) {
+    if (fusion_axes == nullptr || strlen(fusion_axes) >= H7_LINK_AXES_CHARS) {
+        Serial.println("[IMU] Invalid axis layout");
+        return false;
+    }
+
+    // 整块清零后写回，之后 M7 只写自己的行，失效 M4 的行不会丢掉本核尚未写回的数据
+    h7_link_t* link = h7_link();
+    memset(link, 0, sizeof(*link));
+    link->output_hz = output_hz;
+    strcpy(link->fusion_axes, fusion_axes);
+    link->state = H7_LINK_BOOTING;
+    link->magic = H7_LINK_MAGIC;
+    clean(link, sizeof(*link));
+
+    __HAL_RCC_HSEM_CLK_ENABLE();
+    HSEM_COMMON->ICR = LINK_HSEM_MASK;
+    HAL_HSEM_ActivateNotification(LINK_HSEM_MASK);
+    NVIC_SetVector(HSEM1_IRQn, (uint32_t)&on_hsem_irq);
+    NVIC_EnableIRQ(HSEM1_IRQn);
+
+    if (!boot_m4()) {
+        Serial.println(link->state == H7_LINK_FAILED ? "[IMU] M4 failed to initialize BMI270"
+                                                     : "[IMU] M4 core did not start");
+        return false;
+    }
+
+    invalidate(&link->axis_count, sizeof(link->axis_count) + sizeof(link->axis_channel) +
+                                      sizeof(link->axis_lsb) + sizeof(link->channel_lsb));
+    g_axis_count = link->axis_count <= IMU_MAX_AXES ? link->axis_count : 0;
+    memcpy(g_axis_map, link->axis_channel, sizeof(g_axis_map));
+    memcpy(g_axis_lsb, link->axis_lsb, sizeof(g_axis_lsb));
+    memcpy(g_channel_lsb, link->channel_lsb, sizeof(g_channel_lsb));
+    g_ready = g_axis_count > 0;
+    Serial.println("[IMU] Frames from the M4 core over shared SRAM4");
+    return g_ready;
+}
+
+size_t imu_module_read_frames(imu_sample_t* out_frames, size_t max_frames) {
+    h7_link_t* link = h7_link();
+    for (;;) {
+        drain_logs();
+        invalidate(&link->frame_head, sizeof(link->frame_head));
+        const uint32_t head = link->frame_head;
+        const uint32_t tail = link->frame_tail;
+        size_t frames = head - tail;
+        if (frames > 0 && max_frames > 0) {
+            if (frames > max_frames) {
+                frames = max_frames;
+            }
+            copy_frames(out_frames, tail, frames);
+            link->frame_tail = tail + (uint32_t)frames;
+            clean(&link->frame_tail, sizeof(link->frame_tail));
+            supervisor_module_heartbeat(THREAD_SAMPLER);
+            return frames;
+        }
+
+        energy_module_sleep(ENERGY_SAMPLER);
+        g_link_flags.wait_any_for(LINK_FLAG_FRAMES, std::chrono::milliseconds(LINK_WAIT_TIMEOUT_MS));
+        energy_module_wake(ENERGY_SAMPLER);
+        g_wakeups++;
+    }
+}
+
+void imu_module_set_raw_sink(imu_raw_sink_t sink) {
+    // 原始帧在 M4 上产生，不经共享缓冲转交
+    if (sink) {
+        LOG_WARN("[IMU] Raw recording is not available on the Portenta H7 build\n");
+    }
+}
+
+bool imu_module_set_replay_source(imu_replay_source_t source) {
+    (void)source;
+    return false;
+}
+
+void imu_module_set_low_rate(bool low_rate) {
+    // BMI270 由 M4 采集，共享缓冲中没有切换请求的通道，M4 保持满速
+    (void)low_rate;
+}
+
+bool imu_module_motion_active() {
+    h7_link_t* link = h7_link();
+    invalidate(&link->motion_active, sizeof(link->motion_active));
+    return !g_ready || link->motion_active != 0;
+}
+
+size_t imu_module_axis_count() {
+    return g_axis_count;
+}
+
+float imu_module_axis_lsb(size_t axis) {
+    return axis < g_axis_count ? g_axis_lsb[axis] : 1.0f;
+}
+
+uint8_t imu_module_axis_channel(size_t axis) {
+    return axis < g_axis_count ? g_axis_map[axis] : 0xFF;
+}
+
+float imu_module_channel_lsb(size_t channel) {
+    return channel < IMU_MAX_AXES ? g_channel_lsb[channel] : 1.0f;
+}
+
+bool imu_module_recover() {
+    // 传感器由 M4 在下一批帧之前重新配置，这里只能确认请求已发出；环形缓冲中的旧帧直接丢弃
+    h7_link_t* link = h7_link();
+    invalidate(&link->frame_head, sizeof(link->frame_head));
+    link->frame_tail = link->frame_head;
+    link->recover_requests++;
+    clean(&link->frame_tail, sizeof(link->frame_tail));
+    clean(&link->recover_requests, sizeof(link->recover_requests));
+    return g_ready;
+}
+
+void imu_module_get_stats(imu_stats_t* out_stats) {
+    if (out_stats == nullptr) {
+        return;
+    }
+    h7_link_t* link = h7_link();
+    invalidate(&link->stats, sizeof(link->stats));
+    *out_stats = link->stats;
+    // 唤醒次数按 M7 采集线程计，其余字段是 M4 上的采集统计
+    out_stats->wakeups = g_wakeups;
+}
@@ -0,0 +1,114 @@
+// 区段剖析模块实现
+#include "profiler_module.h"
+
+#if PROFILER_ZONES_ENABLE
+#include <stdio.h>
+#include <string.h>
+#include "memory_module.h"
+
+// ==================== 内部状态（模块私有） ====================
+
+struct zone_entry_t {
+    const char* name;
+    const char* thread;  // 运行这一区段的线程（thread_module 线程表中的名字）
+};
+
+// 顺序与 profiler_zone_t 一致
+static const zone_entry_t kZoneTable[ZONE_COUNT] = {
+    {"acquire", "sampler"},
+    {"window", "inference"},
+    {"infer", "inference"},
+    {"classify", "inference"},
+    {"postprocess", "inference"},
+    {"ble", "ble"},
+    {"led", "events"},
+};
+
+profiler_zone_record_t g_profiler_zones[PROFILER_ZONE_CAPACITY];
+std::atomic<uint32_t> g_profiler_zone_head(0);
+volatile bool g_profiler_zones_paused = false;
+
+// 导出用的快照（只在导出线程中使用，放在静态区而不是线程栈上）
+static profiler_zone_record_t g_dump_records[PROFILER_ZONE_CAPACITY];
+
+// ==================== 公共接口实现 ====================
+
+void profiler_module_init() {
+#if !defined(INFERENCE_HOST_REPLAY)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+    memory_module_register("profiler zones", sizeof(g_profiler_zones) + sizeof(g_dump_records), false);
+}
+
+void profiler_module_snapshot(profiler_zone_record_t* out_records, profiler_zone_snapshot_t* out_snapshot) {
+    g_profiler_zones_paused = true;
+    const uint32_t now = profiler_zone_now();
+    const uint32_t head = g_profiler_zone_head.load(std::memory_order_relaxed);
+    const size_t count = head < PROFILER_ZONE_CAPACITY ? head : PROFILER_ZONE_CAPACITY;
+    // 最旧的一条在 head 所指的槽位（写满之前从 0 开始）
+    const uint32_t first = head - (uint32_t)count;
+    for (size_t i = 0; i < count; i++) {
+        out_records[i] = g_profiler_zones[(first + i) & (PROFILER_ZONE_CAPACITY - 1)];
+    }
+    g_profiler_zones_paused = false;
+
+    out_snapshot->now_cycles = now;
+    out_snapshot->clock_hz = profiler_module_clock_hz();
+    out_snapshot->recorded = head;
+    out_snapshot->count = count;
+}
+
+uint32_t profiler_module_clock_hz() {
+#if defined(INFERENCE_HOST_REPLAY)
+    return 62500000;
+#else
+    return SystemCoreClock;
+#endif
+}
+
+size_t profiler_module_read(uint32_t* cursor, profiler_zone_record_t* out_records, size_t max_records,
+                            uint32_t* out_lost) {
+    const uint32_t head = g_profiler_zone_head.load(std::memory_order_acquire);
+    uint32_t first = *cursor;
+    // 游标落后超过一圈的部分已被覆盖
+    *out_lost = head - first > PROFILER_ZONE_CAPACITY ? head - first - PROFILER_ZONE_CAPACITY : 0;
+    first += *out_lost;
+    const uint32_t available = head - first;
+    const size_t count = available < max_records ? available : max_records;
+    for (size_t i = 0; i < count; i++) {
+        out_records[i] = g_profiler_zones[(first + i) & (PROFILER_ZONE_CAPACITY - 1)];
+    }
+    *cursor = first + (uint32_t)count;
+    return count;
+}
+
+const char* profiler_module_zone_name(profiler_zone_t zone) {
+    return zone < ZONE_COUNT ? kZoneTable[zone].name : "?";
+}
+
+const char* profiler_module_zone_thread(profiler_zone_t zone) {
+    return zone < ZONE_COUNT ? kZoneTable[zone].thread : "?";
+}
+
+void profiler_module_dump(void (*emit)(const char* line)) {
+    profiler_zone_snapshot_t snapshot;
+    profiler_module_snapshot(g_dump_records, &snapshot);
+    char line[64];
+    snprintf(line, sizeof(line), "[Zones] clock %lu recorded %lu count %u\n", (unsigned long)snapshot.clock_hz,
+             (unsigned long)snapshot.recorded, (unsigned)snapshot.count);
+    emit(line);
+    for (size_t zone = 0; zone < ZONE_COUNT; zone++) {
+        snprintf(line, sizeof(line), "[Zones] zone %u %s %s\n", (unsigned)zone, kZoneTable[zone].name,
+                 kZoneTable[zone].thread);
+        emit(line);
+    }
+    for (size_t i = 0; i < snapshot.count; i++) {
+        const profiler_zone_record_t& record = g_dump_records[i];
+        snprintf(line, sizeof(line), "[Zones] Z %u %lu %lu\n", (unsigned)record.zone,
+                 (unsigned long)(snapshot.now_cycles - record.start_cycles), (unsigned long)record.cycles);
+        emit(line);
+    }
+    emit("[Zones] end\n");
+}
+#endif
@@ -0,0 +1,128 @@
+// 射频活动时序模块实现
+#include <Arduino.h>
+
+#include "app_config.h"
+#include "radio_module.h"
+#if INFERENCE_RADIO_AWARE
+#include "mbed.h"
+#endif
+
+// ==================== 内部状态（模块私有） ====================
+
+#if INFERENCE_RADIO_AWARE
+// 只在 EGU 中断里写；读者关掉这个中断后整体复制
+static RadioGapPredictor g_predictor;
+static NRF_EGU_Type* const kEgu = NRF_EGU3;
+static const IRQn_Type kEguIrq = SWI3_EGU3_IRQn;
+static bool g_running = false;
+
+static void on_radio_event() {
+    const uint32_t now_us = micros();
+    // 中断被链路层的 RADIO 中断推迟时两个事件可能同时挂起：先开始、后结束
+    if (kEgu->EVENTS_TRIGGERED[0]) {
+        kEgu->EVENTS_TRIGGERED[0] = 0;
+        g_predictor.on_radio_start(now_us);
+    }
+    if (kEgu->EVENTS_TRIGGERED[1]) {
+        kEgu->EVENTS_TRIGGERED[1] = 0;
+        g_predictor.on_radio_end(now_us);
+    }
+    // 清除事件的写入到达外设之后再退出，否则中断会立即再次进入
+    (void)kEgu->EVENTS_TRIGGERED[1];
+}
+
+/**
+ * @brief 从高编号往下找一个未被使用的 PPI 通道（未启用且端点为空），没有时返回 -1
+ */
+static int claim_ppi_channel(int below) {
+    for (int ch = below - 1; ch >= 0; ch--) {
+        if ((NRF_PPI->CHEN & (1u << ch)) == 0 && NRF_PPI->CH[ch].EEP == 0 && NRF_PPI->CH[ch].TEP == 0) {
+            return ch;
+        }
+    }
+    return -1;
+}
+
+static RadioGapPredictor snapshot() {
+    NVIC_DisableIRQ(kEguIrq);
+    const RadioGapPredictor copy = g_predictor;
+    NVIC_EnableIRQ(kEguIrq);
+    return copy;
+}
+#endif
+
+// ==================== 公共接口实现 ====================
+
+bool radio_module_init() {
+#if INFERENCE_RADIO_AWARE
+    if (g_running) {
+        return true;
+    }
+    if (kEgu->INTEN != 0) {
+        Serial.println("[Radio] EGU3 is in use, radio-aware scheduling disabled");
+        return false;
+    }
+    // 可编程通道 0~19；20 以上是链路层使用的预编程通道
+    const int start_ch = claim_ppi_channel(20);
+    const int end_ch = start_ch > 0 ? claim_ppi_channel(start_ch) : -1;
+    if (end_ch < 0) {
+        Serial.println("[Radio] No free PPI channels, radio-aware scheduling disabled");
+        return false;
+    }
+    kEgu->EVENTS_TRIGGERED[0] = 0;
+    kEgu->EVENTS_TRIGGERED[1] = 0;
+    NVIC_SetVector(kEguIrq, (uint32_t)&on_radio_event);
+    NVIC_SetPriority(kEguIrq, (1u << __NVIC_PRIO_BITS) - 1);
+    NVIC_EnableIRQ(kEguIrq);
+    kEgu->INTENSET = EGU_INTENSET_TRIGGERED0_Msk | EGU_INTENSET_TRIGGERED1_Msk;
+    NRF_PPI->CH[start_ch].EEP = (uint32_t)&NRF_RADIO->EVENTS_READY;
+    NRF_PPI->CH[start_ch].TEP = (uint32_t)&kEgu->TASKS_TRIGGER[0];
+    NRF_PPI->CH[end_ch].EEP = (uint32_t)&NRF_RADIO->EVENTS_DISABLED;
+    NRF_PPI->CH[end_ch].TEP = (uint32_t)&kEgu->TASKS_TRIGGER[1];
+    NRF_PPI->CHENSET = (1u << start_ch) | (1u << end_ch);
+    g_running = true;
+    Serial.print("[Radio] Connection event timing on PPI channels ");
+    Serial.print(start_ch);
+    Serial.print("/");
+    Serial.println(end_ch);
+    return true;
+#else
+    return false;
+#endif
+}
+
+radio_gap_decision_t radio_module_decide(uint32_t busy_us, uint32_t guard_us, uint32_t max_defer_us) {
+#if INFERENCE_RADIO_AWARE
+    if (g_running) {
+        // 先复制再读时钟：复制之后才到的事件只会让锚点显得更旧，不会出现在“现在”之后
+        const RadioGapPredictor predictor = snapshot();
+        return predictor.decide(micros(), busy_us, guard_us, max_defer_us);
+    }
+#else
+    (void)busy_us;
+    (void)guard_us;
+    (void)max_defer_us;
+#endif
+    const radio_gap_decision_t untimed = {RADIO_GAP_UNTIMED, 0};
+    return untimed;
+}
+
+void radio_module_get_timing(uint32_t* out_interval_us, uint32_t* out_event_us) {
+    uint32_t interval_us = 0;
+    uint32_t event_us = 0;
+#if INFERENCE_RADIO_AWARE
+    if (g_running) {
+        const RadioGapPredictor predictor = snapshot();
+        if (predictor.locked(micros())) {
+            interval_us = predictor.interval_us();
+            event_us = predictor.event_us();
+        }
+    }
+#endif
+    if (out_interval_us) {
+        *out_interval_us = interval_us;
+    }
+    if (out_event_us) {
+        *out_event_us = event_us;
+    }
+}
@@ -0,0 +1,357 @@
+// 原始 IMU 录制模块实现
+#include <Arduino.h>
+#include "rtos.h"
+#include <chrono>
+#include <stdlib.h>
+#include <string.h>
+
+#include "app_config.h"
+#include "ble_module.h"
+#include "config_module.h"
+#include "energy_module.h"
+#include "gesture_labels.h"
+#include "imu_module.h"
+#include "inference_module.h"
+#include "memory_module.h"
+#include "periodic_timer.h"
+#include "profiler_module.h"
+#include "record_module.h"
+#include "replay_module.h"
+#include "spsc_ring.h"
+#include "stats_module.h"
+#include "usb_link_module.h"
+
+// 串口命令行最大长度
+#define RECORD_COMMAND_MAX_LEN 32
+
+// ==================== 内部状态（模块私有） ====================
+
+#if RECORD_ENABLE
+// 采集线程编码、录制线程 / BLE 线程发送
+static SpscRing<record_packet_t, RECORD_QUEUE_PACKETS> g_packet_queue;
+static volatile record_transport_t g_transport = RECORD_OFF;
+// 重新开始录制时丢弃上一次停止时未写满的包
+static volatile bool g_discard_open_packet = false;
+
+// 以下只由采集线程（原始帧回调）访问
+static RecordPacketEncoder g_encoder;
+static uint16_t g_sequence = 0;
+static uint32_t g_packet_start_us = 0;
+static record_stats_t g_stats = {0, 0, 0};
+#endif
+
+// ==================== 内部辅助函数 ====================
+
+#if RECORD_ENABLE
+
+static void flush_packet() {
+    if (!g_encoder.is_open()) {
+        return;
+    }
+    const uint8_t frames = g_encoder.frame_count();
+    const record_packet_t& packet = g_encoder.finish();
+    if (frames == 0) {
+        return;
+    }
+    if (g_packet_queue.push(&packet, 1)) {
+        g_stats.packets++;
+    } else {
+        g_stats.dropped++;
+    }
+    g_sequence++;  // 丢弃的包也占用序号，主机端据此统计丢包
+}
+
+/**
+ * @brief 原始帧回调（采集线程）：追加到当前包，写满或超过 RECORD_FLUSH_MS 时入队
+ */
+static void on_raw_frame(const int16_t* frame, uint8_t channel_mask, uint32_t timestamp_us) {
+    if (g_discard_open_packet) {
+        g_discard_open_packet = false;
+        if (g_encoder.is_open()) {
+            g_encoder.finish();
+        }
+    }
+    if (g_encoder.is_open() && !g_encoder.add(frame, timestamp_us)) {
+        flush_packet();
+    }
+    if (!g_encoder.is_open()) {
+        g_encoder.begin(g_sequence, timestamp_us, channel_mask);
+        g_packet_start_us = timestamp_us;
+        g_encoder.add(frame, timestamp_us);
+    }
+    g_stats.frames++;
+
+    if (timestamp_us - g_packet_start_us >= RECORD_FLUSH_MS * 1000UL) {
+        flush_packet();
+    }
+}
+#endif
+
+#if SERIAL_COMMANDS_ENABLE
+static void print_models() {
+    const size_t active = inference_active_model();
+    for (size_t i = 0; i < inference_model_count(); i++) {
+        inference_model_stats_t stats;
+        if (!inference_get_model_stats(i, &stats)) {
+            continue;
+        }
+        Serial.print(i == active ? "* " : "  ");
+        Serial.print(i);
+        Serial.print(": ");
+        Serial.print(stats.name);
+        Serial.print(", ");
+        Serial.print(stats.label_count);
+        Serial.print(" labels, ");
+        Serial.print(stats.input_values);
+        Serial.print(" inputs, arena ");
+        Serial.print(stats.arena_bytes);
+        Serial.print(" B, ");
+        Serial.print(stats.invokes);
+        Serial.print(" invokes, mean ");
+        Serial.print(stats.mean_us);
+        Serial.print(" us, max ");
+        Serial.print(stats.max_us);
+        Serial.print(" us, last ");
+        if (stats.last_index >= 0) {
+            Serial.print(kGestureLabels[stats.last_index].name);
+            Serial.print(" ");
+            Serial.println(stats.last_confidence, 2);
+        } else {
+            Serial.println("-");
+        }
+    }
+    inference_shadow_stats_t shadow;
+    inference_get_shadow_stats(&shadow);
+    if (shadow.candidate >= 0) {
+        Serial.print("  shadow ");
+        Serial.print(shadow.candidate);
+        Serial.print(" vs ");
+        Serial.print(active);
+        Serial.print(": ");
+        Serial.print(shadow.runs);
+        Serial.print(" windows, ");
+        Serial.print(shadow.agree);
+        Serial.print(" agree, ");
+        Serial.print(shadow.candidate_only);
+        Serial.print(" candidate only, ");
+        Serial.print(shadow.production_only);
+        Serial.print(" production only, ");
+        Serial.print(shadow.differ);
+        Serial.print(" differ, ");
+        Serial.print(shadow.deferred);
+        Serial.println(" deferred");
+    }
+}
+
+static void print_ble_counters() {
+    ble_counters_t counters;
+    ble_module_get_counters(&counters);
+    Serial.print("[BLE] ");
+    Serial.print(counters.published);
+    Serial.print(" published, ");
+    Serial.print(counters.suppressed);
+    Serial.print(" below threshold, ");
+    Serial.print(counters.notify_failures);
+    Serial.print(" notify failures, ");
+    Serial.print(counters.sessions);
+    Serial.print(" sessions, ");
+    Serial.print(counters.connected_s);
+    Serial.println(" s connected");
+}
+
+static void print_line(const char* line) {
+    Serial.print(line);
+}
+
+static void handle_command(const char* command) {
+    if (strcmp(command, "rec usb") == 0) {
+        record_module_start(RECORD_USB);
+    } else if (strcmp(command, "rec ble") == 0) {
+        record_module_start(RECORD_BLE);
+    } else if (strcmp(command, "rec stop") == 0) {
+        record_module_stop();
+        Serial.println("[Record] Stopped");
+    } else if (strcmp(command, "replay") == 0) {
+        replay_module_start();
+    } else if (strcmp(command, "prof") == 0) {
+        inference_request_profile();
+    } else if (strcmp(command, "bench") == 0 || strncmp(command, "bench ", 6) == 0) {
+        // bench [n]：合成窗口；bench live [n]：接下来的 n 次实时推理；结果由推理线程打印
+        const char* args = command + 5;
+        inference_bench_mode_t mode = INFERENCE_BENCH_SYNTHETIC;
+        if (strncmp(args, " live", 5) == 0) {
+            mode = INFERENCE_BENCH_LIVE;
+            args += 5;
+        }
+        const int runs = *args ? atoi(args) : INFERENCE_BENCHMARK_DEFAULT_RUNS;
+        if (runs <= 0 || runs > INFERENCE_BENCHMARK_MAX_RUNS || !inference_request_benchmark(mode, (uint16_t)runs)) {
+            Serial.print("[Record] Benchmark not started (1-");
+            Serial.print(INFERENCE_BENCHMARK_MAX_RUNS);
+            Serial.println(" runs, one at a time)");
+        }
+    } else if (strcmp(command, "mem") == 0) {
+        memory_module_report();
+    } else if (strcmp(command, "zones") == 0) {
+        profiler_module_dump(print_line);
+    } else if (strcmp(command, "stats") == 0) {
+        stats_module_dump(print_line);
+    } else if (strcmp(command, "cfg") == 0 || strncmp(command, "cfg ", 4) == 0) {
+        config_module_command(command + 3);
+    } else if (strcmp(command, "ble") == 0) {
+        print_ble_counters();
+    } else if (strcmp(command, "model") == 0) {
+        print_models();
+    } else if (strncmp(command, "model ", 6) == 0) {
+        const size_t index = (size_t)atoi(command + 6);
+        if (!inference_select_model(index)) {
+            Serial.print("[Record] No such model: ");
+            Serial.println(command + 6);
+        }
+    }
+}
+#endif
+
+/**
+ * @brief 空闲时睡到下一个轮询截止时间
+ * 连续发送期间不等待，错过的节拍不算超时：截止时间已过时从现在起重新计时。
+ */
+static void wait_next_poll(PeriodicTimer& timer) {
+    if (timer.expired()) {
+        timer.restart();
+    }
+    energy_module_sleep(ENERGY_RECORD);
+    timer.wait();
+    energy_module_wake(ENERGY_RECORD);
+}
+
+// ==================== 公共接口实现 ====================
+
+#if RECORD_ENABLE
+void record_module_start(record_transport_t transport) {
+    if (transport == RECORD_OFF) {
+        record_module_stop();
+        return;
+    }
+    g_transport = transport;
+    g_discard_open_packet = true;
+    imu_module_set_raw_sink(on_raw_frame);
+}
+
+void record_module_stop() {
+    imu_module_set_raw_sink(nullptr);
+    g_transport = RECORD_OFF;
+}
+
+bool record_module_active() {
+    return g_transport != RECORD_OFF;
+}
+
+record_transport_t record_module_transport() {
+    return g_transport;
+}
+
+bool record_module_pop_packet(record_packet_t* out_packet) {
+    return g_packet_queue.pop(out_packet, 1);
+}
+
+void record_module_get_stats(record_stats_t* out_stats) {
+    if (out_stats) {
+        *out_stats = g_stats;
+    }
+}
+#else
+// RECORD_ENABLE=0：录制请求被忽略，通道始终为 RECORD_OFF
+void record_module_start(record_transport_t) {}
+
+void record_module_stop() {}
+
+bool record_module_active() {
+    return false;
+}
+
+record_transport_t record_module_transport() {
+    return RECORD_OFF;
+}
+
+bool record_module_pop_packet(record_packet_t*) {
+    return false;
+}
+
+void record_module_get_stats(record_stats_t* out_stats) {
+    if (out_stats) {
+        *out_stats = {0, 0, 0};
+    }
+}
+#endif
+
+void record_task() {
+#if SERIAL_COMMANDS_ENABLE
+    char command[RECORD_COMMAND_MAX_LEN + 1];
+    size_t command_len = 0;
+#endif
+#if RECORD_ENABLE
+    memory_module_register("record queue", sizeof(g_packet_queue), false);
+#endif
+    replay_module_init();
+    // 串口的轮询节拍：发送 / 回放占用的时间不会推迟下一次轮询
+    PeriodicTimer poll_timer(std::chrono::milliseconds(RECORD_IDLE_SLEEP_MS));
+    energy_module_wake(ENERGY_RECORD);
+
+    for (;;) {
+        // 回放期间串口输入是二进制帧，由回放模块按队列余量读取
+        if (replay_module_active()) {
+            if (!replay_module_service()) {
+                wait_next_poll(poll_timer);
+            }
+            continue;
+        }
+        while (Serial.available() > 0) {
+            const int c = Serial.read();
+#if USB_LINK_ENABLE
+            // 二进制链路的帧由 USB 链路模块解码，帧之间的字节仍是文本命令
+            if (usb_link_module_feed((uint8_t)c)) {
+                if (replay_module_active()) {
+                    break;
+                }
+                continue;
+            }
+#endif
+#if SERIAL_COMMANDS_ENABLE
+            if (c == '\n' || c == '\r') {
+                command[command_len] = '\0';
+                if (command_len > 0) {
+                    handle_command(command);
+                }
+                command_len = 0;
+            } else if (command_len < RECORD_COMMAND_MAX_LEN) {
+                command[command_len++] = (char)c;
+            }
+#else
+            (void)c;
+#endif
+            // "replay" 或诊断命令开始回放后，其后的字节都是回放数据
+            if (replay_module_active()) {
+                break;
+            }
+        }
+
+        bool sent = false;
+#if RECORD_ENABLE
+        if (g_transport == RECORD_USB) {
+            record_packet_t packet;
+            while (record_module_pop_packet(&packet)) {
+                Serial.write(packet.bytes, packet.length);
+                sent = true;
+            }
+        }
+#endif
+        if (!sent) {
+#if USB_LINK_ENABLE
+            // 链路打开期间主机写入的 ack / 时钟同步不等满一个空闲节拍
+            poll_timer.set_period(std::chrono::milliseconds(usb_link_module_open() ? USB_LINK_POLL_MS
+                                                                                   : RECORD_IDLE_SLEEP_MS));
+#endif
+            wait_next_poll(poll_timer);
+        }
+    }
+}
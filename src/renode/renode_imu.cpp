@@ -0,0 +1,301 @@
+// Renode 仿真的 IMU 模块：按 imu_module.h 的接口从 renode/imu_replay.py 模拟的外设取帧（见 [env:nano33ble_renode]）
+// 外设是一个按字读出的 FIFO，内容是 pc_controller/renode_bench.py 由录制 CSV 转换的板坐标系原始帧（传感器 ODR，
+// int16 LSB）。采集线程按 FIFO 水位周期醒来，按仿真时间取出这段时间内"采到"的帧，之后经过与设备相同的
+// 抗混叠抽取和线性重采样，采集 / 推理线程与量产固件完全相同。
+// 录制放完后把区段剖析的环形缓冲（周期计数）从 UART0（Serial1）导出一次，renode_bench.py 据此汇总
+#include <Arduino.h>
+#include "rtos.h"
+#include <chrono>
+#include <ctype.h>
+#include <math.h>
+#include <string.h>
+
+#include "app_config.h"
+#include "energy_module.h"
+#include "fir_decimator.h"
+#include "imu_module.h"
+#include "profiler_module.h"
+#include "resampler.h"
+#include "supervisor_module.h"
+
+#if IMU_GRAVITY_FRAME
+#error "The Renode IMU does not run the gravity frame stage"
+#endif
+
+// 外设寄存器（与 renode/imu_replay.py 一致）
+#define RENODE_IMU_BASE        0x4F000000UL
+#define RENODE_IMU_ID          0x494D5552UL  // "IMUR"
+#define RENODE_IMU_REG_ID      0x00
+#define RENODE_IMU_REG_ODR     0x04  // 录制的采样率（Hz）
+#define RENODE_IMU_REG_MASK    0x08  // 录制包含的通道（位 i = 板坐标系通道 i）
+#define RENODE_IMU_REG_LEFT    0x0C  // 尚未读出的帧数
+#define RENODE_IMU_REG_DATA    0x10  // 读出下一个字：每帧 3 个字，低半字在前（加速度 X/Y/Z，陀螺仪 X/Y/Z）
+
+// 与 imu_module.cpp 一致的量程：±4 g / ±2000 dps
+#define ACC_LSB_PER_G          8192.0f
+#define GYR_LSB_PER_DPS        16.384f
+
+// 采集线程的唤醒周期：与设备上 FIFO 水位中断的周期相同
+#define RENODE_IMU_POLL_MS     (IMU_FIFO_WATERMARK_FRAMES * 1000 / IMU_SENSOR_ODR_HZ)
+
+namespace {
+
+struct axis_name_t {
+    const char* name;
+    uint8_t channel;
+};
+
+const axis_name_t kAxisNames[] = {
+    {"accx", 0}, {"accy", 1}, {"accz", 2},
+    {"gyrx", 3}, {"gyry", 4}, {"gyrz", 5},
+};
+
+uint8_t g_axis_map[IMU_MAX_AXES];
+size_t g_axis_count = 0;
+uint8_t g_channel_mask = 0;
+float g_sensor_hz = 0.0f;
+
+FirDecimator<IMU_MAX_AXES, IMU_DECIMATION_TAPS> g_decimator;
+#if INFERENCE_Q15_FEATURES
+LinearResamplerQ15<IMU_MAX_AXES> g_resampler;
+#else
+LinearResampler<IMU_MAX_AXES> g_resampler;
+#endif
+
+// 一个原始帧最多产生两个输出帧，放不下的留到下一次读取
+imu_sample_t g_carry[2 * IMU_MAX_AXES];
+size_t g_carry_count = 0;
+size_t g_carry_pos = 0;
+
+// 第一次读取的时刻与已从外设取出的帧数：按仿真时间应取出 elapsed * ODR 帧
+uint32_t g_first_read_us = 0;
+bool g_started = false;
+uint32_t g_consumed = 0;
+bool g_dumped = false;
+
+imu_stats_t g_stats = {};
+
+inline uint32_t read_reg(uint32_t offset) {
+    return *reinterpret_cast<volatile uint32_t*>(RENODE_IMU_BASE + offset);
+}
+
+inline float channel_lsb(size_t channel) {
+    return channel < 3 ? ACC_LSB_PER_G : GYR_LSB_PER_DPS;
+}
+
+int channel_from_name(const char* name) {
+    char lower[8];
+    size_t len = 0;
+    for (; name[len] && len < sizeof(lower) - 1; len++) {
+        lower[len] = (char)tolower((unsigned char)name[len]);
+    }
+    lower[len] = '\0';
+    for (const axis_name_t& axis : kAxisNames) {
+        if (strcmp(lower, axis.name) == 0) {
+            return axis.channel;
+        }
+    }
+    return -1;
+}
+
+bool parse_axes(const char* fusion_axes) {
+    g_axis_count = 0;
+    const char* p = fusion_axes;
+    while (*p) {
+        while (*p == ' ' || *p == '+') {
+            p++;
+        }
+        if (!*p) {
+            break;
+        }
+        char token[8];
+        size_t len = 0;
+        while (*p && *p != ' ' && *p != '+') {
+            if (len < sizeof(token) - 1) {
+                token[len++] = *p;
+            }
+            p++;
+        }
+        token[len] = '\0';
+        const int channel = channel_from_name(token);
+        if (channel < 0 || g_axis_count >= IMU_MAX_AXES || !(g_channel_mask & (1u << channel))) {
+            return false;
+        }
+        g_axis_map[g_axis_count++] = (uint8_t)channel;
+    }
+    return g_axis_count > 0;
+}
+
+void emit_uart(const char* line) {
+    Serial1.print(line);
+}
+
+/**
+ * @brief 录制放完：导出区段剖析的环形缓冲（只导出一次）
+ */
+void finish() {
+    if (g_dumped) {
+        return;
+    }
+    g_dumped = true;
+    profiler_module_dump(emit_uart);
+    Serial1.print("[Renode] done ");
+    Serial1.print(g_stats.sensor_frames);
+    Serial1.print(" sensor frames, ");
+    Serial1.print(g_stats.output_frames);
+    Serial1.println(" output frames");
+}
+
+/**
+ * @brief 取出一个原始帧，经抽取与重采样后放进 g_carry
+ */
+void process_frame() {
+    int16_t sensor[IMU_MAX_AXES];
+    for (size_t w = 0; w < IMU_MAX_AXES / 2; w++) {
+        const uint32_t word = read_reg(RENODE_IMU_REG_DATA);
+        sensor[2 * w] = (int16_t)(word & 0xFFFF);
+        sensor[2 * w + 1] = (int16_t)(word >> 16);
+    }
+    g_consumed++;
+    g_stats.sensor_frames++;
+    int16_t filtered[IMU_MAX_AXES];
+    if (!g_decimator.push(sensor, filtered)) {
+        return;
+    }
+    imu_sample_t packed[IMU_MAX_AXES] = {0};
+    for (size_t i = 0; i < g_axis_count; i++) {
+#if INFERENCE_Q15_FEATURES
+        packed[i] = filtered[g_axis_map[i]];
+#else
+        packed[i] = filtered[g_axis_map[i]] / channel_lsb(g_axis_map[i]);
+#endif
+    }
+    g_carry_count = g_resampler.push(packed, g_carry, 2);
+    g_carry_pos = 0;
+}
+
+}  // namespace
+
+// ==================== 公共接口实现 ====================
+
+bool imu_module_init(float output_hz, const char* fusion_axes) {
+    Serial1.begin(115200);
+    if (read_reg(RENODE_IMU_REG_ID) != RENODE_IMU_ID) {
+        Serial1.println("[Renode] IMU replay peripheral not found");
+        return false;
+    }
+    g_sensor_hz = (float)read_reg(RENODE_IMU_REG_ODR);
+    g_channel_mask = (uint8_t)read_reg(RENODE_IMU_REG_MASK);
+    if (g_sensor_hz <= 0.0f || !parse_axes(fusion_axes)) {
+        Serial1.println("[Renode] Recording does not provide the model's axes");
+        return false;
+    }
+
+    // 与 replay_imu.cpp 相同：抽取倍数按设备上的抽取后采样率换算
+    long factor = lroundf(g_sensor_hz * IMU_DECIMATION_FACTOR / (float)IMU_SENSOR_ODR_HZ);
+    factor = factor < 1 ? 1 : (factor > 255 ? 255 : factor);
+    float cutoff_hz = (float)IMU_DECIMATION_CUTOFF_HZ;
+    if (cutoff_hz > 0.4f * g_sensor_hz / factor) {
+        cutoff_hz = 0.4f * g_sensor_hz / factor;
+    }
+    g_decimator.design(g_sensor_hz, cutoff_hz, (uint8_t)factor);
+    g_resampler.set_rates(g_sensor_hz / factor, output_hz);
+    g_resampler.reset();
+    g_carry_count = g_carry_pos = 0;
+
+    g_stats = imu_stats_t();
+    g_stats.sensor_hz = g_sensor_hz;
+    g_stats.output_hz = output_hz;
+    Serial1.print("[Renode] ");
+    Serial1.print(read_reg(RENODE_IMU_REG_LEFT));
+    Serial1.print(" frames at ");
+    Serial1.print(g_sensor_hz, 1);
+    Serial1.println(" Hz");
+    return true;
+}
+
+size_t imu_module_read_frames(imu_sample_t* out_frames, size_t max_frames) {
+    size_t produced = 0;
+    for (;;) {
+        const uint32_t start_us = micros();
+        if (!g_started) {
+            g_first_read_us = start_us;
+            g_started = true;
+        }
+        // 按仿真时间已"采到"的帧
+        const uint32_t due = (uint32_t)((uint64_t)(start_us - g_first_read_us) * (uint32_t)g_sensor_hz / 1000000u);
+        while (produced < max_frames) {
+            if (g_carry_pos < g_carry_count) {
+                memcpy(&out_frames[produced++ * g_axis_count], &g_carry[g_carry_pos++ * IMU_MAX_AXES],
+                       g_axis_count * sizeof(imu_sample_t));
+                continue;
+            }
+            if (g_consumed >= due || read_reg(RENODE_IMU_REG_LEFT) == 0) {
+                break;
+            }
+            process_frame();
+        }
+        g_stats.process_us += micros() - start_us;
+        if (produced > 0) {
+            g_stats.output_frames += produced;
+            return produced;
+        }
+        if (read_reg(RENODE_IMU_REG_LEFT) == 0 && g_carry_pos >= g_carry_count) {
+            finish();
+        }
+        energy_module_sleep_for(ENERGY_SAMPLER, std::chrono::milliseconds(RENODE_IMU_POLL_MS));
+        g_stats.wakeups++;
+        supervisor_module_heartbeat(THREAD_SAMPLER);
+    }
+}
+
+size_t imu_module_axis_count() {
+    return g_axis_count;
+}
+
+float imu_module_axis_lsb(size_t axis) {
+#if INFERENCE_Q15_FEATURES
+    return axis < g_axis_count ? channel_lsb(g_axis_map[axis]) : 1.0f;
+#else
+    (void)axis;
+    return 1.0f;
+#endif
+}
+
+uint8_t imu_module_axis_channel(size_t axis) {
+    return axis < g_axis_count ? g_axis_map[axis] : 0xFF;
+}
+
+float imu_module_channel_lsb(size_t channel) {
+    return channel_lsb(channel);
+}
+
+bool imu_module_motion_active() {
+    return true;
+}
+
+void imu_module_set_raw_sink(imu_raw_sink_t sink) {
+    (void)sink;
+}
+
+bool imu_module_set_replay_source(imu_replay_source_t source) {
+    (void)source;
+    return false;
+}
+
+void imu_module_set_low_rate(bool low_rate) {
+    // 外设按录制的采样率交付，没有可降低的 ODR
+    (void)low_rate;
+}
+
+bool imu_module_recover() {
+    g_stats.recoveries++;
+    g_carry_count = g_carry_pos = 0;
+    return true;
+}
+
+void imu_module_get_stats(imu_stats_t* out_stats) {
+    if (out_stats) {
+        *out_stats = g_stats;
+    }
+}
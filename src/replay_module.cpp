@@ -0,0 +1,255 @@
+// 板上回放模块实现
+#include <Arduino.h>
+#include "rtos.h"
+#include <stdio.h>
+#include <string.h>
+
+#include "app_config.h"
+#include "imu_module.h"
+#include "inference_module.h"
+#include "log_module.h"
+#include "memory_module.h"
+#include "pipeline_module.h"
+#include "record_format.h"
+#include "record_module.h"
+#include "replay_module.h"
+#include "spsc_ring.h"
+#include "model-parameters/model_metadata.h"
+
+// ==================== 内部状态（模块私有） ====================
+
+enum replay_state_t {
+    REPLAY_IDLE = 0,
+    REPLAY_STREAMING,  // 接收主机数据
+    REPLAY_DRAINING,   // 已收到结束包，等采集 / 推理线程处理完剩余的帧
+};
+
+struct replay_frame_t {
+    int16_t values[IMU_MAX_AXES];  // 板坐标系原始 LSB，缺失的通道为 0
+};
+
+static volatile replay_state_t g_state = REPLAY_IDLE;
+
+// 录制线程解码写入、采集线程（回放数据源）读出
+static SpscRing<replay_frame_t, REPLAY_QUEUE_FRAMES> g_frames;
+// 推理线程（结果观察者）写入、录制线程打印
+static SpscRing<inference_result_event_t, REPLAY_RESULT_QUEUE> g_results;
+
+// 以下只由录制线程访问
+static RecordPacketDecoder g_decoder;
+static uint16_t g_last_sequence = 0;
+static uint32_t g_packets = 0;
+static uint32_t g_lost_packets = 0;
+static uint32_t g_windows = 0;
+static uint32_t g_last_rx_ms = 0;
+static imu_stats_t g_imu_start;
+
+// 以下由采集线程在第一次取帧时写入：此前写入样本队列的帧都是实时采集的
+static volatile bool g_started = false;
+static volatile uint32_t g_start_frame = 0;
+static volatile uint32_t g_start_us = 0;
+static volatile uint32_t g_sensor_frames = 0;
+// 结束包之后采集线程又来取帧且队列已空：之前取走的帧都已写入样本队列
+static volatile bool g_drained = false;
+
+// ==================== 内部辅助函数 ====================
+
+/**
+ * @brief 回放数据源（采集线程）
+ */
+static size_t read_replay_frames(int16_t* out_frames, size_t max_frames) {
+    if (!g_started) {
+        g_start_frame = inference_frames_pushed();
+        g_start_us = micros();
+        g_started = true;
+    }
+    size_t count = 0;
+    replay_frame_t frame;
+    while (count < max_frames && g_frames.pop(&frame, 1)) {
+        memcpy(&out_frames[count * IMU_MAX_AXES], frame.values, sizeof(frame.values));
+        count++;
+    }
+    g_sensor_frames += count;
+    if (count == 0 && g_state == REPLAY_DRAINING) {
+        g_drained = true;
+    }
+    return count;
+}
+
+/**
+ * @brief 结果观察者（推理线程）：只保留窗口完全由回放样本组成之后的结果
+ */
+static void on_result(const inference_result_event_t* event) {
+    if (!g_started) {
+        return;
+    }
+    inference_result_event_t result = *event;
+    result.frame = event->frame - g_start_frame;
+    if ((int32_t)result.frame < (int32_t)EI_CLASSIFIER_RAW_SAMPLE_COUNT) {
+        return;
+    }
+    g_results.push(&result, 1);
+}
+
+static void print_results() {
+    inference_result_event_t result;
+    char line[80];
+    while (g_results.pop(&result, 1)) {
+        snprintf(line, sizeof(line), "result,%lu,%s,%.5f,%lu,%lu", (unsigned long)result.frame,
+                 result.index >= 0 ? inference_get_category_name(result.index) : "uncertain",
+                 result.confidence, (unsigned long)result.classify_us, (unsigned long)result.latency_us);
+        Serial.println(line);
+        g_windows++;
+    }
+}
+
+/**
+ * @brief 把已解码包中剩余的帧写入回放队列，队列有空间时继续读串口
+ * 队列满时不再读取串口，USB CDC 的流控随之让主机暂停发送。
+ * @return true 本次读到了数据
+ */
+static bool receive() {
+    bool received = false;
+    for (;;) {
+        while (g_decoder.frames_left() > 0) {
+            if (g_frames.size() >= g_frames.capacity()) {
+                return received;
+            }
+            int16_t values[IMU_MAX_AXES];
+            uint32_t timestamp_us;
+            if (!g_decoder.read_frame(values, &timestamp_us)) {
+                break;
+            }
+            replay_frame_t frame = {};
+            size_t next = 0;
+            for (size_t c = 0; c < IMU_MAX_AXES; c++) {
+                if (g_decoder.channel_mask() & (1u << c)) {
+                    frame.values[c] = values[next++];
+                }
+            }
+            g_frames.push(&frame, 1);
+        }
+        if (Serial.available() <= 0) {
+            return received;
+        }
+
+        received = true;
+        g_last_rx_ms = millis();
+        if (!g_decoder.feed((uint8_t)Serial.read())) {
+            continue;
+        }
+        if (g_packets > 0) {
+            g_lost_packets += (uint16_t)(g_decoder.sequence() - g_last_sequence - 1);
+        }
+        g_last_sequence = g_decoder.sequence();
+        g_packets++;
+        if (g_decoder.frame_count() == 0) {
+            g_state = REPLAY_DRAINING;
+            return received;
+        }
+    }
+}
+
+/**
+ * @brief 恢复传感器输入，打印汇总与各级耗时
+ */
+static void finish() {
+    imu_module_set_replay_source(nullptr);
+    inference_set_result_observer(nullptr);
+    print_results();
+
+    imu_stats_t imu;
+    imu_module_get_stats(&imu);
+    char line[96];
+    snprintf(line, sizeof(line), "summary,%lu,%lu,%lu,%lu,%lu", (unsigned long)g_windows,
+             (unsigned long)g_sensor_frames, (unsigned long)(imu.output_frames - g_imu_start.output_frames),
+             (unsigned long)(micros() - g_start_us), (unsigned long)(imu.process_us - g_imu_start.process_us));
+    Serial.println(line);
+    size_t static_bytes = 0;
+    const size_t high_water = memory_module_high_water(&static_bytes);
+    snprintf(line, sizeof(line), "memory,%lu,%lu", (unsigned long)high_water, (unsigned long)static_bytes);
+    Serial.println(line);
+    for (size_t i = 0; i < PIPELINE_STAGE_COUNT; i++) {
+        const pipeline_stage_t stage = static_cast<pipeline_stage_t>(i);
+        pipeline_stage_stats_t stats;
+        pipeline_module_get_stats(stage, &stats);
+        snprintf(line, sizeof(line), "stage,%s,%lu,%lu,%lu,%lu", pipeline_module_stage_name(stage),
+                 (unsigned long)stats.runs, (unsigned long)stats.mean_us, (unsigned long)stats.max_us,
+                 (unsigned long)stats.busy_permille);
+        Serial.println(line);
+    }
+
+    if (g_lost_packets > 0 || g_decoder.crc_errors() > 0) {
+        LOG_WARN("[Replay] %lu packets lost, %lu CRC errors\n", (unsigned long)g_lost_packets,
+                 (unsigned long)g_decoder.crc_errors());
+    }
+    LOG_INFO("[Replay] Done: %lu packets, %lu frames, %lu windows\n", (unsigned long)g_packets,
+             (unsigned long)g_sensor_frames, (unsigned long)g_windows);
+    g_state = REPLAY_IDLE;
+}
+
+// ==================== 公共接口实现 ====================
+
+void replay_module_init() {
+    memory_module_register("replay queue", sizeof(g_frames) + sizeof(g_results), false);
+}
+
+bool replay_module_start() {
+    if (g_state != REPLAY_IDLE || record_module_active()) {
+        LOG_WARN("[Replay] Busy (recording or replay in progress)\n");
+        return false;
+    }
+
+    // 上一次回放的残留（例如主机中途断开）
+    replay_frame_t frame;
+    while (g_frames.pop(&frame, 1)) {
+    }
+    inference_result_event_t result;
+    while (g_results.pop(&result, 1)) {
+    }
+    g_decoder = RecordPacketDecoder();
+    g_packets = 0;
+    g_lost_packets = 0;
+    g_windows = 0;
+    g_started = false;
+    g_drained = false;
+    g_sensor_frames = 0;
+    imu_module_get_stats(&g_imu_start);
+
+    g_state = REPLAY_STREAMING;
+    if (!imu_module_set_replay_source(read_replay_frames)) {
+        g_state = REPLAY_IDLE;
+        LOG_WARN("[Replay] Not supported without IMU_USE_FIFO\n");
+        return false;
+    }
+    inference_set_result_observer(on_result);
+    g_last_rx_ms = millis();
+    Serial.println("[Replay] Ready");
+    return true;
+}
+
+bool replay_module_active() {
+    return g_state != REPLAY_IDLE;
+}
+
+bool replay_module_service() {
+    if (g_state == REPLAY_IDLE) {
+        return false;
+    }
+    bool busy = g_results.size() > 0;
+    print_results();
+
+    if (g_state == REPLAY_STREAMING) {
+        busy |= receive();
+        if (g_state == REPLAY_STREAMING && millis() - g_last_rx_ms > REPLAY_TIMEOUT_MS) {
+            // 主机中途停止发送：按已收到的部分结束
+            LOG_WARN("[Replay] No data for %u ms, ending replay\n", (unsigned)REPLAY_TIMEOUT_MS);
+            g_state = REPLAY_DRAINING;
+        }
+    }
+    if (g_state == REPLAY_DRAINING && (g_drained || !g_started) && inference_caught_up()) {
+        finish();
+        busy = true;
+    }
+    return busy;
+}
@@ -0,0 +1,329 @@
+// 二进制诊断命令实现
+#include "shell_module.h"
+
+#if SHELL_ENABLE
+#include <Arduino.h>
+#include <string.h>
+
+#include "config_module.h"
+#include "inference_module.h"
+#include "latency_module.h"
+#include "memory_module.h"
+#include "profiler_module.h"
+#include "replay_module.h"
+#include "stats_module.h"
+#include "supervisor_module.h"
+#include "telemetry_module.h"
+#include "thread_module.h"
+#include "usb_link_module.h"
+#include "watchdog_module.h"
+#include "wire_schema.h"
+
+// 应答头：序号、命令、状态
+#define SHELL_REPLY_HEADER_BYTES 3
+// 应答 payload 上限：一帧（usb_frame.h）
+#define SHELL_REPLY_MAX_BYTES (USB_FRAME_MAX_CONTENT - 3)
+
+// 区段追踪应答：wire_trace_t 与其后的 wire_trace_zone_t（与 BLE 追踪特征值相同）
+#define SHELL_TRACE_MAX_RECORDS \
+    ((SHELL_REPLY_MAX_BYTES - SHELL_REPLY_HEADER_BYTES - sizeof(wire_trace_t)) / sizeof(wire_trace_zone_t))
+
+static_assert(SHELL_REPLY_HEADER_BYTES + 40 + 4 <= SHELL_REPLY_MAX_BYTES, "system stats must fit one frame");
+static_assert(SHELL_REPLY_HEADER_BYTES + THREAD_COUNT * 12 <= SHELL_REPLY_MAX_BYTES, "thread stats must fit one frame");
+static_assert(SHELL_REPLY_HEADER_BYTES + LATENCY_STAGE_COUNT * 24 <= SHELL_REPLY_MAX_BYTES,
+              "latency stats must fit one frame");
+static_assert(SHELL_REPLY_HEADER_BYTES + sizeof(wire_stat_t) + STATS_NAME_MAX + sizeof(wire_stat_distribution_t) <=
+                  SHELL_REPLY_MAX_BYTES,
+              "a statistic must fit one frame");
+static_assert(SHELL_REPLY_HEADER_BYTES + 4 + 4 + INFERENCE_BENCH_STAGE_COUNT * 20 <= SHELL_REPLY_MAX_BYTES,
+              "the benchmark report must fit one frame");
+#if TELEMETRY_ENABLE
+static_assert(SHELL_REPLY_HEADER_BYTES + 4 + 2 * TELEMETRY_LABEL_BINS * 4 <= SHELL_REPLY_MAX_BYTES,
+              "a label histogram must fit one frame");
+#endif
+
+// ==================== 内部状态（模块私有） ====================
+
+// 以下只由录制线程访问
+#if PROFILER_ZONES_ENABLE
+static uint32_t g_trace_cursor = 0;
+static bool g_trace_started = false;
+#endif
+
+// ==================== 内部辅助函数 ====================
+
+/**
+ * @brief 按小端依次写入应答数据
+ */
+struct ShellWriter {
+    uint8_t* cursor;
+
+    void u8(uint8_t value) { *cursor++ = value; }
+
+    void u16(uint16_t value) {
+        memcpy(cursor, &value, sizeof(value));
+        cursor += sizeof(value);
+    }
+
+    void u32(uint32_t value) {
+        memcpy(cursor, &value, sizeof(value));
+        cursor += sizeof(value);
+    }
+
+    void bytes(const uint8_t* data, size_t length) {
+        memcpy(cursor, data, length);
+        cursor += length;
+    }
+
+    /**
+     * @brief 在应答缓冲区中就地构造一条线上记录（wire_schema.h）并前移
+     */
+    template <typename T>
+    T* record() {
+        T* out = wire_at<T>(cursor);
+        cursor += sizeof(T);
+        return out;
+    }
+};
+
+static uint8_t stats_system(ShellWriter& out) {
+    uint32_t overruns;
+    uint32_t high_water;
+    inference_get_sampler_stats(&overruns, &high_water);
+    watchdog_stats_t watchdog;
+    watchdog_module_get_stats(&watchdog);
+    supervisor_stats_t supervisor;
+    supervisor_module_get_stats(&supervisor);
+    size_t static_bytes = 0;
+    const size_t ram_high_water = memory_module_high_water(&static_bytes);
+
+    out.u32(millis());
+    out.u32(inference_frames_pushed());
+    out.u32(overruns);
+    out.u32(high_water);
+    out.u32(watchdog.stalls);
+    out.u32(watchdog.longest_gap_ms);
+    out.u32(supervisor.imu_recoveries);
+    out.u32(supervisor.imu_longest_outage_ms);
+    out.u32((uint32_t)ram_high_water);
+    out.u32((uint32_t)static_bytes);
+    out.u8(watchdog.watchdog_reset ? 1 : 0);
+    out.u8((uint8_t)inference_get_power_point());
+    out.u8((uint8_t)inference_active_model());
+    out.u8(0);
+    return SHELL_OK;
+}
+
+static uint8_t stats_threads(ShellWriter& out) {
+    supervisor_stats_t supervisor;
+    supervisor_module_get_stats(&supervisor);
+    for (size_t i = 0; i < THREAD_COUNT; i++) {
+        thread_stack_stats_t stats;
+        thread_module_get_stats((thread_role_t)i, &stats);
+        out.u32(stats.stack_bytes);
+        out.u32(stats.peak_bytes);
+        out.u32(supervisor.restarts[i]);
+    }
+    return SHELL_OK;
+}
+
+static uint8_t stats_latency(ShellWriter& out) {
+    for (size_t i = 0; i < LATENCY_STAGE_COUNT; i++) {
+        latency_stats_t stats;
+        latency_module_get_stats((latency_stage_t)i, &stats);
+        out.u32(stats.count);
+        out.u32(stats.p50_us);
+        out.u32(stats.p95_us);
+        out.u32(stats.p99_us);
+        out.u32(stats.max_us);
+        out.u32(stats.over_slo);
+    }
+    return SHELL_OK;
+}
+
+static uint8_t stats_confidence(const uint8_t* args, size_t length, ShellWriter& out) {
+#if TELEMETRY_ENABLE
+    telemetry_label_histogram_t histogram;
+    if (length < 2 || !telemetry_module_label_histogram(args[1], &histogram)) {
+        return SHELL_BAD_ARGUMENT;
+    }
+    out.u8(TELEMETRY_LABELS);
+    out.u8(TELEMETRY_LABEL_BINS);
+    out.u16(0);
+    for (size_t b = 0; b < TELEMETRY_LABEL_BINS; b++) {
+        out.u32(histogram.top[b]);
+    }
+    for (size_t b = 0; b < TELEMETRY_LABEL_BINS; b++) {
+        out.u32(histogram.margin[b]);
+    }
+    return SHELL_OK;
+#else
+    (void)args;
+    (void)length;
+    (void)out;
+    return SHELL_UNSUPPORTED;
+#endif
+}
+
+static uint8_t bench_start(const uint8_t* args, size_t length) {
+    if (length < 3 || args[0] > INFERENCE_BENCH_LIVE) {
+        return SHELL_BAD_ARGUMENT;
+    }
+    const uint16_t runs = (uint16_t)(args[1] | (args[2] << 8));
+    if (runs == 0 || runs > INFERENCE_BENCHMARK_MAX_RUNS) {
+        return SHELL_BAD_ARGUMENT;
+    }
+    return inference_request_benchmark((inference_bench_mode_t)args[0], runs) ? SHELL_OK : SHELL_BUSY;
+}
+
+static uint8_t bench_result(ShellWriter& out) {
+    inference_bench_report_t report;
+    out.u32(inference_get_benchmark(&report));
+    out.u8(report.mode);
+    out.u8(report.state);
+    out.u16(report.runs);
+    for (size_t i = 0; i < INFERENCE_BENCH_STAGE_COUNT; i++) {
+        const inference_bench_stats_t& stats = report.stages[i];
+        out.u32(stats.min_us);
+        out.u32(stats.p50_us);
+        out.u32(stats.p95_us);
+        out.u32(stats.p99_us);
+        out.u32(stats.max_us);
+    }
+    return SHELL_OK;
+}
+
+static uint8_t config_get(ShellWriter& out) {
+    uint8_t config[CONFIG_WIRE_BYTES];
+    out.u32(config_module_encode(config));
+    out.bytes(config, sizeof(config));
+    return SHELL_OK;
+}
+
+#if PROFILER_ZONES_ENABLE
+static uint8_t trace_read(const uint8_t* args, size_t length, ShellWriter& out) {
+    if (!g_trace_started) {
+        return SHELL_NOT_STARTED;
+    }
+    const size_t max_records = length >= 1 && args[0] > 0 && args[0] < SHELL_TRACE_MAX_RECORDS
+                                   ? args[0]
+                                   : SHELL_TRACE_MAX_RECORDS;
+    profiler_zone_record_t records[SHELL_TRACE_MAX_RECORDS];
+    uint32_t lost;
+    const size_t count = profiler_module_read(&g_trace_cursor, records, max_records, &lost);
+    wire_trace_t* header = out.record<wire_trace_t>();
+    header->now_ms = millis();
+    header->now_cycles = profiler_zone_now();
+    header->clock_khz = (uint16_t)(profiler_module_clock_hz() / 1000);
+    header->count = (uint8_t)(count | (lost > 0 ? WIRE_TRACE_LOST : 0));
+    for (size_t i = 0; i < count; i++) {
+        wire_trace_zone_t* zone = out.record<wire_trace_zone_t>();
+        zone->zone = records[i].zone;
+        zone->start_age = header->now_cycles - records[i].start_cycles;
+        zone->cycles = records[i].cycles;
+    }
+    return SHELL_OK;
+}
+#endif
+
+static uint8_t stat_read(const uint8_t* args, size_t length, ShellWriter& out) {
+    if (length < 1) {
+        return SHELL_BAD_ARGUMENT;
+    }
+    const size_t written = stats_module_encode(args[0], out.cursor, SHELL_REPLY_MAX_BYTES - SHELL_REPLY_HEADER_BYTES);
+    if (written == 0) {
+        return SHELL_BAD_ARGUMENT;
+    }
+    out.cursor += written;
+    return SHELL_OK;
+}
+
+/**
+ * @brief 执行命令，数据写入 out
+ * @return shell_status_t
+ */
+static uint8_t execute(uint8_t command, const uint8_t* args, size_t length, ShellWriter& out) {
+    switch (command) {
+        case SHELL_CMD_INFO:
+            out.u8(SHELL_PROTOCOL_VERSION);
+            out.u8(THREAD_COUNT);
+            out.u8(LATENCY_STAGE_COUNT);
+            out.u8(PROFILER_ZONES_ENABLE ? ZONE_COUNT : 0);
+            out.u32(millis());
+            return SHELL_OK;
+        case SHELL_CMD_STATS:
+            if (length < 1) {
+                return SHELL_BAD_ARGUMENT;
+            }
+            switch (args[0]) {
+                case SHELL_STATS_SYSTEM:
+                    return stats_system(out);
+                case SHELL_STATS_THREADS:
+                    return stats_threads(out);
+                case SHELL_STATS_LATENCY:
+                    return stats_latency(out);
+                case SHELL_STATS_CONFIDENCE:
+                    return stats_confidence(args, length, out);
+                default:
+                    return SHELL_BAD_ARGUMENT;
+            }
+        case SHELL_CMD_BENCH_START:
+            return bench_start(args, length);
+        case SHELL_CMD_BENCH_RESULT:
+            return bench_result(out);
+        case SHELL_CMD_CONFIG_GET:
+            return config_get(out);
+        case SHELL_CMD_CONFIG_SET:
+            if (!config_module_write(args, length)) {
+                return SHELL_BAD_ARGUMENT;
+            }
+            return config_get(out);
+#if PROFILER_ZONES_ENABLE
+        case SHELL_CMD_TRACE_START:
+            g_trace_cursor = profiler_module_head();
+            g_trace_started = true;
+            return SHELL_OK;
+        case SHELL_CMD_TRACE_STOP:
+            g_trace_started = false;
+            return SHELL_OK;
+        case SHELL_CMD_TRACE_READ:
+            return trace_read(args, length, out);
+#else
+        case SHELL_CMD_TRACE_START:
+        case SHELL_CMD_TRACE_STOP:
+        case SHELL_CMD_TRACE_READ:
+            return SHELL_UNSUPPORTED;
+#endif
+        case SHELL_CMD_REPLAY:
+#if IMU_USE_FIFO
+            // 录制线程在本次读取之后把串口输入交给回放模块
+            return replay_module_start() ? SHELL_OK : SHELL_BUSY;
+#else
+            return SHELL_UNSUPPORTED;
+#endif
+        case SHELL_CMD_STAT_READ:
+            return stat_read(args, length, out);
+        default:
+            return SHELL_UNKNOWN_COMMAND;
+    }
+}
+
+// ==================== 公共接口实现 ====================
+
+void shell_module_handle(const uint8_t* request, size_t length) {
+    if (length < 2) {
+        return;
+    }
+    uint8_t reply[SHELL_REPLY_MAX_BYTES];
+    ShellWriter out = {reply + SHELL_REPLY_HEADER_BYTES};
+    const uint8_t command = request[1];
+    const uint8_t status = execute(command, request + 2, length - 2, out);
+    if (status != SHELL_OK) {
+        out.cursor = reply + SHELL_REPLY_HEADER_BYTES;
+    }
+    reply[0] = request[0];
+    reply[1] = command;
+    reply[2] = status;
+    usb_link_module_send(USB_FRAME_SHELL, reply, (size_t)(out.cursor - reply));
+}
+#endif
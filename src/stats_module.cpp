@@ -0,0 +1,143 @@
+// 统计注册表实现
+#include "stats_module.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+
+#include "app_config.h"
+#include "log_module.h"
+#include "memory_module.h"
+#include "wire_schema.h"
+
+// ==================== 内部状态（模块私有） ====================
+
+struct stat_entry_t {
+    const char* name;
+    const void* stat;
+    stat_summarize_fn summarize;    // 分布的摘要函数（计数 / 最大值为 nullptr）
+    std::atomic<uint8_t> kind;      // 填好其余字段后最后写入（0 = 表项已领取、尚未填好）
+};
+
+static stat_entry_t g_entries[STATS_REGISTRY_CAPACITY];
+// 已领取的表项数（可能超过容量：超出的登记被忽略）
+static std::atomic<uint32_t> g_claimed(0);
+
+// ==================== 内部辅助函数 ====================
+
+static void add_entry(const char* name, const void* stat, uint8_t kind, stat_summarize_fn summarize) {
+    const uint32_t slot = g_claimed.fetch_add(1, std::memory_order_relaxed);
+    if (slot >= STATS_REGISTRY_CAPACITY) {
+        LOG_WARN("[Stats] Registry full (STATS_REGISTRY_CAPACITY %d), %s not exported\n", (int)STATS_REGISTRY_CAPACITY,
+                 name);
+        return;
+    }
+    if (slot == 0) {
+        memory_module_register("stats registry", sizeof(g_entries), false);
+    }
+    stat_entry_t& entry = g_entries[slot];
+    entry.name = name;
+    entry.stat = stat;
+    entry.summarize = summarize;
+    entry.kind.store(kind, std::memory_order_release);
+}
+
+// ==================== 公共接口实现 ====================
+
+void stats_module_register_counter(const char* name, const StatCounter* stat) {
+    add_entry(name, stat, STAT_KIND_COUNTER, nullptr);
+}
+
+void stats_module_register_max(const char* name, const StatMax* stat) {
+    add_entry(name, stat, STAT_KIND_MAX, nullptr);
+}
+
+void stats_module_register_distribution(const char* name, const void* stat, stat_summarize_fn summarize) {
+    add_entry(name, stat, STAT_KIND_DISTRIBUTION, summarize);
+}
+
+size_t stats_module_count() {
+    const uint32_t claimed = g_claimed.load(std::memory_order_relaxed);
+    return claimed < STATS_REGISTRY_CAPACITY ? claimed : STATS_REGISTRY_CAPACITY;
+}
+
+bool stats_module_read(size_t index, stat_value_t* out) {
+    if (index >= stats_module_count()) {
+        return false;
+    }
+    const stat_entry_t& entry = g_entries[index];
+    const uint8_t kind = entry.kind.load(std::memory_order_acquire);
+    if (kind == 0) {
+        return false;
+    }
+    out->name = entry.name;
+    out->kind = kind;
+    out->value = 0;
+    memset(&out->distribution, 0, sizeof(out->distribution));
+    switch (kind) {
+        case STAT_KIND_COUNTER:
+            out->value = static_cast<const StatCounter*>(entry.stat)->value();
+            break;
+        case STAT_KIND_MAX:
+            out->value = static_cast<const StatMax*>(entry.stat)->value();
+            break;
+        default:
+            entry.summarize(entry.stat, &out->distribution);
+            break;
+    }
+    return true;
+}
+
+size_t stats_module_encode(size_t index, uint8_t* out, size_t capacity) {
+    stat_value_t value;
+    if (!stats_module_read(index, &value)) {
+        return 0;
+    }
+    size_t name_length = strlen(value.name);
+    if (name_length > STATS_NAME_MAX) {
+        name_length = STATS_NAME_MAX;
+    }
+    const size_t value_bytes = value.kind == STAT_KIND_DISTRIBUTION ? sizeof(wire_stat_distribution_t) : sizeof(uint32_t);
+    const size_t length = sizeof(wire_stat_t) + name_length + value_bytes;
+    if (length > capacity) {
+        return 0;
+    }
+    wire_stat_t* header = wire_at<wire_stat_t>(out);
+    header->index = (uint8_t)index;
+    header->count = (uint8_t)stats_module_count();
+    header->kind = value.kind;
+    header->name_length = (uint8_t)name_length;
+    memcpy(out + sizeof(wire_stat_t), value.name, name_length);
+    uint8_t* body = out + sizeof(wire_stat_t) + name_length;
+    if (value.kind == STAT_KIND_DISTRIBUTION) {
+        wire_stat_distribution_t* distribution = wire_at<wire_stat_distribution_t>(body);
+        distribution->count = value.distribution.count;
+        distribution->max = value.distribution.max;
+        distribution->p50 = value.distribution.p50;
+        distribution->p90 = value.distribution.p90;
+        distribution->p99 = value.distribution.p99;
+    } else {
+        memcpy(body, &value.value, sizeof(value.value));
+    }
+    return length;
+}
+
+void stats_module_dump(void (*emit)(const char* line)) {
+    char line[112];
+    const size_t count = stats_module_count();
+    for (size_t i = 0; i < count; i++) {
+        stat_value_t value;
+        if (!stats_module_read(i, &value)) {
+            continue;
+        }
+        if (value.kind == STAT_KIND_DISTRIBUTION) {
+            const stat_distribution_t& d = value.distribution;
+            snprintf(line, sizeof(line), "[Stats] %s n %lu p50 %lu p90 %lu p99 %lu max %lu\n", value.name,
+                     (unsigned long)d.count, (unsigned long)d.p50, (unsigned long)d.p90, (unsigned long)d.p99,
+                     (unsigned long)d.max);
+        } else {
+            snprintf(line, sizeof(line), "[Stats] %s %lu\n", value.name, (unsigned long)value.value);
+        }
+        emit(line);
+    }
+}
@@ -0,0 +1,191 @@
+// 子系统监督模块实现
+#include <Arduino.h>
+#include "mbed.h"
+#include "rtos.h"
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+#include "app_config.h"
+#include "imu_module.h"
+#include "log_module.h"
+#include "supervisor_module.h"
+#include "telemetry_module.h"
+#include "thread_module.h"
+
+// ==================== 内部状态（模块私有） ====================
+
+static const char* const kSubsystemNames[SUPERVISOR_SUBSYSTEM_COUNT] = {"IMU", "BLE"};
+
+// 由各线程写心跳、主线程读；32 位读写是原子的，不加锁
+static volatile uint32_t g_heartbeat_ms[THREAD_COUNT] = {0};
+static volatile bool g_monitored[THREAD_COUNT] = {false};
+static volatile uint32_t g_restarts[THREAD_COUNT] = {0};
+static volatile uint32_t g_init_attempts[SUPERVISOR_SUBSYSTEM_COUNT] = {0};
+static volatile bool g_init_ok[SUPERVISOR_SUBSYSTEM_COUNT] = {false};
+
+// 以下只由主线程访问
+static uint32_t g_restart_ms[THREAD_COUNT] = {0};
+static uint32_t g_restarts_in_row[THREAD_COUNT] = {0};
+
+// ==================== 内部辅助函数 ====================
+
+/**
+ * @brief 第 retry 次重试前的退避时间：SUPERVISOR_BACKOFF_MIN_MS 起每次翻倍，不超过 SUPERVISOR_BACKOFF_MAX_MS
+ */
+static uint32_t backoff_ms(uint32_t retry) {
+    uint32_t ms = SUPERVISOR_BACKOFF_MIN_MS;
+    for (uint32_t i = 0; i < retry && ms < SUPERVISOR_BACKOFF_MAX_MS; i++) {
+        ms *= 2;
+    }
+    return ms < SUPERVISOR_BACKOFF_MAX_MS ? ms : SUPERVISOR_BACKOFF_MAX_MS;
+}
+
+/**
+ * @brief 重启一个已退出或卡死的线程；接连重启仍不恢复时软件复位
+ */
+static void restart_thread(thread_role_t role, const char* reason, uint32_t now_ms) {
+    thread_stack_stats_t stats;
+    thread_module_get_stats(role, &stats);
+    if (g_restarts_in_row[role] >= SUPERVISOR_MAX_RESTARTS) {
+        char message[64];
+        snprintf(message, sizeof(message), "%s thread %s after %u restarts", stats.name, reason,
+                 (unsigned)g_restarts_in_row[role]);
+        supervisor_module_fatal(message);
+    }
+
+    LOG_WARN("[Supervisor] %s thread %s, restarting\n", stats.name, reason);
+    thread_module_stop(role);
+    g_monitored[role] = false;
+    if (role == THREAD_SAMPLER && !imu_module_recover()) {
+        // 传感器仍无响应：采集线程照常启动，由它继续按退避重新配置
+        LOG_WARN("[Supervisor] IMU did not accept its configuration\n");
+    }
+    if (!thread_module_restart(role)) {
+        supervisor_module_fatal("thread restart failed");
+    }
+    g_restarts[role]++;
+    g_restarts_in_row[role]++;
+    g_restart_ms[role] = now_ms;
+}
+
+// ==================== 公共接口实现 ====================
+
+bool supervisor_module_init(supervisor_subsystem_t subsystem, bool (*init)(), uint32_t max_attempts) {
+    if (subsystem >= SUPERVISOR_SUBSYSTEM_COUNT || !init) {
+        return false;
+    }
+    const char* name = kSubsystemNames[subsystem];
+    for (uint32_t attempt = 0; max_attempts == 0 || attempt < max_attempts; attempt++) {
+        if (attempt > 0) {
+            const uint32_t wait_ms = backoff_ms(attempt - 1);
+            LOG_WARN("[Supervisor] %s init failed, retrying in %lu ms\n", name, (unsigned long)wait_ms);
+            rtos::ThisThread::sleep_for(std::chrono::milliseconds(wait_ms));
+        }
+        g_init_attempts[subsystem]++;
+        if (init()) {
+            g_init_ok[subsystem] = true;
+            if (attempt > 0) {
+                LOG_INFO("[Supervisor] %s initialized after %lu attempts\n", name, (unsigned long)(attempt + 1));
+            }
+            return true;
+        }
+    }
+    LOG_ERROR("[Supervisor] %s init failed after %lu attempts\n", name, (unsigned long)max_attempts);
+    return false;
+}
+
+bool supervisor_module_ready(supervisor_subsystem_t subsystem) {
+    return subsystem < SUPERVISOR_SUBSYSTEM_COUNT && g_init_ok[subsystem];
+}
+
+void supervisor_module_heartbeat(thread_role_t role) {
+    if (role < THREAD_COUNT) {
+        g_heartbeat_ms[role] = millis();
+        g_monitored[role] = true;
+    }
+}
+
+void supervisor_module_poll() {
+    const uint32_t now_ms = millis();
+    for (size_t i = 0; i < THREAD_COUNT; i++) {
+        const thread_role_t role = (thread_role_t)i;
+        const char* reason = nullptr;
+        if (!thread_module_running(role)) {
+            reason = "exited";
+        } else if (g_monitored[i] && now_ms - g_heartbeat_ms[i] > SUPERVISOR_STALL_MS) {
+            reason = "stalled";
+        }
+        if (reason) {
+            restart_thread(role, reason, now_ms);
+        } else if (g_restarts_in_row[i] > 0 && now_ms - g_restart_ms[i] >= SUPERVISOR_STABLE_MS) {
+            g_restarts_in_row[i] = 0;
+        }
+    }
+}
+
+void supervisor_module_fatal(const char* reason) {
+    // 日志线程可能正是出问题的线程：直接写串口
+    Serial.print("[Supervisor] Unrecoverable: ");
+    Serial.print(reason);
+    Serial.println(", resetting");
+#if TELEMETRY_ENABLE
+    // 复位前把原因连同待写的记录写入诊断日志
+    const size_t length = strlen(reason);
+    telemetry_module_record(TELEMETRY_FATAL, reason, length < TELEMETRY_MAX_PAYLOAD ? length : TELEMETRY_MAX_PAYLOAD);
+    telemetry_module_flush();
+#endif
+    delay(SUPERVISOR_RESET_DELAY_MS);
+    NVIC_SystemReset();
+    for (;;) {
+    }
+}
+
+void supervisor_module_get_stats(supervisor_stats_t* out_stats) {
+    if (!out_stats) {
+        return;
+    }
+    for (size_t i = 0; i < SUPERVISOR_SUBSYSTEM_COUNT; i++) {
+        out_stats->init_attempts[i] = g_init_attempts[i];
+        out_stats->init_ok[i] = g_init_ok[i];
+    }
+    for (size_t i = 0; i < THREAD_COUNT; i++) {
+        out_stats->restarts[i] = g_restarts[i];
+    }
+    imu_stats_t imu;
+    imu_module_get_stats(&imu);
+    out_stats->imu_recoveries = imu.recoveries;
+    out_stats->imu_longest_outage_ms = imu.longest_outage_ms;
+}
+
+void supervisor_module_report() {
+    supervisor_stats_t stats;
+    supervisor_module_get_stats(&stats);
+    bool eventful = stats.imu_recoveries > 0;
+    for (size_t i = 0; i < SUPERVISOR_SUBSYSTEM_COUNT; i++) {
+        eventful |= stats.init_attempts[i] != 1 || !stats.init_ok[i];
+    }
+    for (size_t i = 0; i < THREAD_COUNT; i++) {
+        eventful |= stats.restarts[i] > 0;
+    }
+    if (!eventful) {
+        return;
+    }
+
+    char line[160];
+    int len = snprintf(line, sizeof(line), "[Supervisor] init attempts");
+    for (size_t i = 0; i < SUPERVISOR_SUBSYSTEM_COUNT && len > 0 && (size_t)len < sizeof(line); i++) {
+        len += snprintf(line + len, sizeof(line) - len, " %s %lu%s", kSubsystemNames[i],
+                        (unsigned long)stats.init_attempts[i], stats.init_ok[i] ? "" : " (not ready)");
+    }
+    for (size_t i = 0; i < THREAD_COUNT && len > 0 && (size_t)len < sizeof(line); i++) {
+        thread_stack_stats_t thread;
+        thread_module_get_stats((thread_role_t)i, &thread);
+        len += snprintf(line + len, sizeof(line) - len, "%s %s %lu", i == 0 ? "; restarts" : ",", thread.name,
+                        (unsigned long)stats.restarts[i]);
+    }
+    Serial.println(line);
+    snprintf(line, sizeof(line), "[Supervisor] IMU recoveries %lu, longest outage %lu ms",
+             (unsigned long)stats.imu_recoveries, (unsigned long)stats.imu_longest_outage_ms);
+    Serial.println(line);
+}
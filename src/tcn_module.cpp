@@ -0,0 +1,132 @@
+// TCN 推理引擎：tcn_model.h 中的因果膨胀卷积网络逐帧消费 int8 窗口的新样本
+#include <Arduino.h>
+#include <math.h>
+#include <string.h>
+
+#include "app_config.h"
+#include "log_module.h"
+#include "tcn_module.h"
+
+#if INFERENCE_TCN_ENGINE
+
+#include "model-parameters/model_metadata.h"
+#include "edge-impulse-sdk/classifier/inferencing_engines/tcn.h"
+#include "tcn_model.h"
+
+// 自检概率允许的误差（主机参考实现用 double 计算 softmax）
+#define TCN_SELF_TEST_TOLERANCE 1e-3f
+
+// ==================== 内部状态（模块私有） ====================
+
+static bool g_ready = false;
+// 历史中是否已有整个窗口的帧；否则下一次推理复位后送入整个窗口
+static bool g_primed = false;
+// 最近一次的概率：没有新帧时原样返回
+static float g_scores[EI_CLASSIFIER_LABEL_COUNT];
+
+// ==================== 内部辅助函数 ====================
+
+/**
+ * @brief 从复位状态逐帧送入自检帧，最后一帧的概率须与导出工具的整数参考实现一致
+ */
+static bool self_test() {
+    if (TCN_MODEL_TEST_FRAMES == 0) {
+        return true;
+    }
+    ei_tcn_reset(&kTcnConfig);
+    for (size_t t = 0; t < TCN_MODEL_TEST_FRAMES; t++) {
+        if (ei_tcn_step(&kTcnConfig, &kTcnTestFrames[t * TCN_MODEL_INPUT_CHANNELS],
+                        t + 1 == TCN_MODEL_TEST_FRAMES ? g_scores : nullptr) != EI_IMPULSE_OK) {
+            return false;
+        }
+    }
+    for (size_t k = 0; k < TCN_MODEL_CLASSES; k++) {
+        if (fabsf(g_scores[k] - kTcnTestScores[k]) > TCN_SELF_TEST_TOLERANCE) {
+            LOG_ERROR("[TCN] Self-test class %u: %.5f, expected %.5f\n", (unsigned)k, g_scores[k],
+                      kTcnTestScores[k]);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 按时间顺序送入 frames 帧，从环形窗口的第 first 个样本开始；最后一帧输出概率
+ */
+static bool feed(const int8_t* window, size_t first, size_t frames) {
+    for (size_t t = 0; t < frames; t++) {
+        const size_t offset = (first + t * EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME) % EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE;
+        if (ei_tcn_step(&kTcnConfig, &window[offset], t + 1 == frames ? g_scores : nullptr) != EI_IMPULSE_OK) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ==================== 公共接口实现 ====================
+
+bool tcn_module_init(float input_scale, int32_t input_zero_point) {
+    g_ready = false;
+    g_primed = false;
+    if (TCN_MODEL_LAYERS == 0) {
+        LOG_WARN("[TCN] No TCN model (train it and run tcn_export.py), using the CNN\n");
+        return false;
+    }
+    if (TCN_MODEL_INPUT_CHANNELS != EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME ||
+        TCN_MODEL_CLASSES != EI_CLASSIFIER_LABEL_COUNT) {
+        LOG_ERROR("[TCN] Model takes %u axes / %u classes, the firmware %u / %u, using the CNN\n",
+                  (unsigned)TCN_MODEL_INPUT_CHANNELS, (unsigned)TCN_MODEL_CLASSES,
+                  (unsigned)EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME, (unsigned)EI_CLASSIFIER_LABEL_COUNT);
+        return false;
+    }
+    // 窗口按 CNN 的输入量化保存：两者不同（例如换了 OTA 权重）时不能直接送入 TCN
+    if (kTcnConfig.input_zero_point != input_zero_point ||
+        fabsf(kTcnConfig.input_scale - input_scale) > 1e-6f * input_scale) {
+        LOG_ERROR("[TCN] Model input quantization (%.6f, %d) differs from the window (%.6f, %d), using the CNN\n",
+                  kTcnConfig.input_scale, (int)kTcnConfig.input_zero_point, input_scale, (int)input_zero_point);
+        return false;
+    }
+    if (!self_test()) {
+        LOG_ERROR("[TCN] Self-test failed, using the CNN\n");
+        return false;
+    }
+    g_ready = true;
+    LOG_INFO("[TCN] %u layers, receptive field %u frames (window %u frames)\n", (unsigned)TCN_MODEL_LAYERS,
+             (unsigned)TCN_MODEL_RECEPTIVE_FIELD, (unsigned)EI_CLASSIFIER_RAW_SAMPLE_COUNT);
+    if (TCN_MODEL_RECEPTIVE_FIELD > EI_CLASSIFIER_RAW_SAMPLE_COUNT) {
+        LOG_WARN("[TCN] Receptive field is longer than the window: results right after a reset differ\n");
+    }
+    return true;
+}
+
+bool tcn_module_ready() {
+    return g_ready;
+}
+
+bool tcn_module_stream_invoke(const int8_t* window, size_t head, size_t new_values,
+                              float* out_scores, size_t num_scores) {
+    if (!g_ready || window == nullptr || out_scores == nullptr || num_scores < EI_CLASSIFIER_LABEL_COUNT) {
+        return false;
+    }
+    bool ok = true;
+    if (!g_primed || new_values >= EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE) {
+        ei_tcn_reset(&kTcnConfig);
+        ok = feed(window, head, EI_CLASSIFIER_RAW_SAMPLE_COUNT);
+    } else if (new_values > 0) {
+        // 新样本位于 head 之前：head 是整个窗口中最旧的样本，也是刚写完的最新样本的下一个位置
+        const size_t first = (head + EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE - new_values) % EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE;
+        ok = feed(window, first, new_values / EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME);
+    }
+    g_primed = ok;
+    if (!ok) {
+        return false;
+    }
+    memcpy(out_scores, g_scores, sizeof(g_scores));
+    return true;
+}
+
+void tcn_module_reset() {
+    g_primed = false;
+}
+
+#endif
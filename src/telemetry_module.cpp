@@ -0,0 +1,522 @@
+// 现场诊断日志实现：RAM 批缓冲与 Flash 环形扇区
+#include <Arduino.h>
+#include "mbed.h"
+#include "rtos.h"
+#include <stdio.h>
+#include <string.h>
+
+#include "app_config.h"
+#include "calib_store.h"
+#include "gesture_labels.h"
+#include "latency_module.h"
+#include "log_module.h"
+#include "memory_module.h"
+#include "stat_counters.h"
+#include "stats_module.h"
+#include "telemetry_module.h"
+#include "usb_frame.h"
+#include "wire_schema.h"
+
+#if TELEMETRY_ENABLE
+
+#define SECTOR_HEADER_BYTES 8
+#define ERASED_WORD 0xFFFFFFFFu
+// 置信度直方图以千分比记录，等宽分箱即千分比除以桶宽（1.0 落入最后一个桶）；
+// 逐类别直方图记录 x 255 的置信度字节，分箱与记录格式（telemetry_dump.py）一致
+#define CONFIDENCE_SCALE 1000u
+#define LABEL_BIN_WIDTH (256u / TELEMETRY_LABEL_BINS)
+
+static_assert(TELEMETRY_LABELS == GESTURE_LABEL_COUNT, "gesture_labels.h does not match the deployed model");
+
+// 导出中的一段：一个扇区的记录部分
+struct dump_span_t {
+    uint32_t sequence;
+    uint32_t address;
+    uint32_t length;
+};
+
+// 一个类别获胜窗口的两个直方图（置信度 x 255）
+struct label_histograms_t {
+    StatHistogram<TELEMETRY_LABEL_BINS> top{LABEL_BIN_WIDTH};
+    StatHistogram<TELEMETRY_LABEL_BINS> margin{LABEL_BIN_WIDTH};
+};
+
+// ==================== 内部状态（模块私有） ====================
+
+// 批缓冲与计数受 g_mutex 保护（各线程追加记录，主循环交换批缓冲）
+static rtos::Mutex g_mutex;
+alignas(4) static uint8_t g_batches[2][TELEMETRY_BATCH_BYTES];
+static uint8_t g_active_batch = 0;
+static size_t g_batch_len = 0;
+static uint32_t g_batch_since_ms = 0;
+static uint32_t g_records = 0;
+static uint32_t g_dropped = 0;
+
+// 置信度直方图不加锁（推理线程记录，主循环到期时 take() 出本周期并写入 Flash）；到期时刻只由主循环读写
+static StatHistogram<TELEMETRY_HISTOGRAM_BINS> g_histogram(CONFIDENCE_SCALE / TELEMETRY_HISTOGRAM_BINS);
+static uint32_t g_histogram_since_ms = 0;
+// 逐类别直方图：本周期的计数（写入 Flash 时 take() 清零）与启动以来的累计（登记到统计注册表）
+static label_histograms_t g_label_period[TELEMETRY_LABELS];
+static label_histograms_t g_label_total[TELEMETRY_LABELS];
+static uint32_t g_label_since_ms = 0;
+static char g_label_stat_names[TELEMETRY_LABELS][2][STATS_NAME_MAX + 1];
+// 低置信度记录的限速状态只由推理线程读写
+static bool g_low_recorded = false;
+static uint32_t g_low_last_ms = 0;
+static uint16_t g_low_suppressed = 0;
+
+// 写入位置与导出受 g_flash_mutex 保护（主循环写入，BLE 线程导出，监督者复位前写入）
+static rtos::Mutex g_flash_mutex;
+static uint32_t g_base = 0;  // 第一个扇区的地址（0 = Flash 不可用，记录丢弃）
+static uint8_t g_sector = TELEMETRY_SECTORS - 1;
+static uint32_t g_offset = TELEMETRY_SECTOR_BYTES;
+static uint32_t g_sequence = 0;
+static uint32_t g_log_bytes = 0;
+static uint32_t g_flash_errors = 0;
+static bool g_dumping = false;
+static dump_span_t g_dump[TELEMETRY_SECTORS];
+static size_t g_dump_spans = 0;
+static uint32_t g_dump_bytes = 0;
+
+// ==================== 内部辅助函数 ====================
+
+static uint32_t record_size(uint8_t payload_length) {
+    return TELEMETRY_RECORD_HEADER_BYTES + ((payload_length + 3u) & ~3u);
+}
+
+static const uint8_t* sector_data(uint8_t sector) {
+    return reinterpret_cast<const uint8_t*>(g_base + (uint32_t)sector * TELEMETRY_SECTOR_BYTES);
+}
+
+static uint32_t read_word(const uint8_t* data) {
+    uint32_t word;
+    memcpy(&word, data, sizeof(word));
+    return word;
+}
+
+/**
+ * @brief 扇区头部有效时给出其序号
+ */
+static bool sector_sequence(uint8_t sector, uint32_t* out_sequence) {
+    const uint8_t* data = sector_data(sector);
+    if (read_word(data) != TELEMETRY_SECTOR_MAGIC) {
+        return false;
+    }
+    *out_sequence = read_word(data + 4);
+    return true;
+}
+
+/**
+ * @brief 沿记录走到扇区中第一个未写入的字
+ * @param out_clean 停下的位置之后可以继续写入（false = 遇到损坏的头部，扇区按写满处理）
+ * @return 记录部分的结束偏移
+ */
+static uint32_t sector_end(uint8_t sector, bool* out_clean) {
+    const uint8_t* data = sector_data(sector);
+    uint32_t offset = SECTOR_HEADER_BYTES;
+    bool clean = true;
+    while (offset + TELEMETRY_RECORD_HEADER_BYTES <= TELEMETRY_SECTOR_BYTES) {
+        if (read_word(data + offset) == ERASED_WORD) {
+            break;
+        }
+        const uint8_t length = data[offset + 1];
+        const uint32_t size = record_size(length);
+        if (length > TELEMETRY_MAX_PAYLOAD || offset + size > TELEMETRY_SECTOR_BYTES) {
+            clean = false;
+            break;
+        }
+        offset += size;
+    }
+    if (out_clean) {
+        *out_clean = clean;
+    }
+    return offset;
+}
+
+static bool program(const void* data, uint32_t length) {
+    if (length == 0) {
+        return true;
+    }
+    if (!calib_store_telemetry_program(g_sector, g_offset, data, length)) {
+        // 写入位置之后的内容不确定：下一批从新的扇区开始
+        g_flash_errors++;
+        g_offset = TELEMETRY_SECTOR_BYTES;
+        return false;
+    }
+    g_offset += length;
+    g_log_bytes += length;
+    return true;
+}
+
+/**
+ * @brief 打开下一个扇区：擦除它（其中最旧的记录离开日志）并写入更大的序号
+ */
+static bool open_next_sector() {
+    const uint8_t next = (uint8_t)((g_sector + 1) % TELEMETRY_SECTORS);
+    uint32_t sequence;
+    const uint32_t leaving = sector_sequence(next, &sequence) ? sector_end(next, nullptr) - SECTOR_HEADER_BYTES : 0;
+    if (!calib_store_telemetry_erase(next)) {
+        g_flash_errors++;
+        return false;
+    }
+    g_log_bytes -= leaving < g_log_bytes ? leaving : g_log_bytes;
+    // 序号先递增：头部写入失败时下一次打开的扇区仍得到更大的序号
+    g_sector = next;
+    g_sequence++;
+    const uint32_t header[2] = {TELEMETRY_SECTOR_MAGIC, g_sequence};
+    if (!calib_store_telemetry_program(next, 0, header, sizeof(header))) {
+        g_flash_errors++;
+        g_offset = TELEMETRY_SECTOR_BYTES;
+        return false;
+    }
+    g_offset = SECTOR_HEADER_BYTES;
+    return true;
+}
+
+/**
+ * @brief 把一批记录写入 Flash：记录不跨扇区，放不下的记录连同其后的部分写入下一个扇区
+ */
+static void write_batch(const uint8_t* batch, size_t length) {
+    size_t run_start = 0;
+    size_t pos = 0;
+    while (pos < length) {
+        const uint32_t size = record_size(batch[pos + 1]);
+        if (g_offset + (pos - run_start) + size > TELEMETRY_SECTOR_BYTES) {
+            program(batch + run_start, pos - run_start);
+            if (!open_next_sector()) {
+                // 失败已计数：这一批其余的记录丢弃，下一批再打开扇区
+                return;
+            }
+            run_start = pos;
+        }
+        pos += size;
+    }
+    program(batch + run_start, pos - run_start);
+}
+
+static uint8_t confidence_byte(float confidence) {
+    const float scaled = confidence * 255.0f + 0.5f;
+    return scaled <= 0.0f ? 0 : (scaled >= 255.0f ? 255 : (uint8_t)scaled);
+}
+
+static void put_u16(uint8_t* dst, uint16_t value) {
+    dst[0] = (uint8_t)value;
+    dst[1] = (uint8_t)(value >> 8);
+}
+
+static void put_u32(uint8_t* dst, uint32_t value) {
+    put_u16(dst, (uint16_t)value);
+    put_u16(dst + 2, (uint16_t)(value >> 16));
+}
+
+static uint32_t confidence_scaled(float confidence) {
+    const float scaled = confidence * CONFIDENCE_SCALE;
+    return scaled <= 0.0f ? 0 : (scaled >= CONFIDENCE_SCALE ? CONFIDENCE_SCALE : (uint32_t)scaled);
+}
+
+template <size_t N>
+static void put_bins(uint8_t* dst, const StatBins<N>& bins) {
+    for (size_t b = 0; b < N; b++) {
+        put_u16(dst + 2 * b, (uint16_t)(bins.bins[b] > UINT16_MAX ? UINT16_MAX : bins.bins[b]));
+    }
+}
+
+/**
+ * @brief 到期时把本周期的逐类别直方图记为记录（主循环）：只记这期间获胜过的类别，
+ * 批缓冲半满时先写入，一个周期的记录不会因批缓冲已满而丢弃
+ */
+static void record_label_histograms(uint32_t now_ms) {
+    if (now_ms - g_label_since_ms < TELEMETRY_LABEL_HISTOGRAM_MS) {
+        return;
+    }
+    g_label_since_ms = now_ms;
+
+    for (size_t label = 0; label < TELEMETRY_LABELS; label++) {
+        StatBins<TELEMETRY_LABEL_BINS> period[2];
+        g_label_period[label].top.take(&period[TELEMETRY_LABEL_TOP]);
+        g_label_period[label].margin.take(&period[TELEMETRY_LABEL_MARGIN]);
+        if (period[TELEMETRY_LABEL_TOP].count == 0) {
+            continue;
+        }
+        for (uint8_t kind = TELEMETRY_LABEL_TOP; kind <= TELEMETRY_LABEL_MARGIN; kind++) {
+            uint8_t payload[4 + 2 * TELEMETRY_LABEL_BINS] = {(uint8_t)label, kind, 0, 0};
+            put_bins(payload + 4, period[kind]);
+            telemetry_module_record(TELEMETRY_LABEL_HISTOGRAM, payload, sizeof(payload));
+        }
+        g_mutex.lock();
+        const bool half_full = g_batch_len >= TELEMETRY_BATCH_BYTES / 2;
+        g_mutex.unlock();
+        if (half_full) {
+            telemetry_module_flush();
+        }
+    }
+}
+
+// ==================== 公共接口实现 ====================
+
+void telemetry_module_init() {
+    memory_module_register("telemetry batches", sizeof(g_batches), false);
+    memory_module_register("telemetry label histograms", sizeof(g_label_period) + sizeof(g_label_total), false);
+    g_histogram_since_ms = millis();
+    g_label_since_ms = g_histogram_since_ms;
+    stats_module_register("telemetry.confidence", &g_histogram);
+    for (size_t label = 0; label < TELEMETRY_LABELS; label++) {
+        snprintf(g_label_stat_names[label][TELEMETRY_LABEL_TOP], STATS_NAME_MAX + 1, "telemetry.%s.top",
+                 kGestureLabels[label].name);
+        snprintf(g_label_stat_names[label][TELEMETRY_LABEL_MARGIN], STATS_NAME_MAX + 1, "telemetry.%s.margin",
+                 kGestureLabels[label].name);
+        stats_module_register(g_label_stat_names[label][TELEMETRY_LABEL_TOP], &g_label_total[label].top);
+        stats_module_register(g_label_stat_names[label][TELEMETRY_LABEL_MARGIN], &g_label_total[label].margin);
+    }
+    g_base = calib_store_telemetry_address();
+    if (g_base == 0) {
+        LOG_ERROR("[Telemetry] Flash unavailable, diagnostics log disabled\n");
+        return;
+    }
+
+    // 序号最大的扇区是最新的；沿它的记录找到写入位置
+    bool found = false;
+    for (uint8_t sector = 0; sector < TELEMETRY_SECTORS; sector++) {
+        uint32_t sequence;
+        if (!sector_sequence(sector, &sequence)) {
+            continue;
+        }
+        g_log_bytes += sector_end(sector, nullptr) - SECTOR_HEADER_BYTES;
+        if (!found || sequence > g_sequence) {
+            g_sector = sector;
+            g_sequence = sequence;
+            found = true;
+        }
+    }
+    if (found) {
+        bool clean = false;
+        const uint32_t end = sector_end(g_sector, &clean);
+        g_offset = clean ? end : TELEMETRY_SECTOR_BYTES;
+    }
+    LOG_INFO("[Telemetry] Log: %lu bytes in %u sectors, sector %u at %lu\n", (unsigned long)g_log_bytes,
+             (unsigned)TELEMETRY_SECTORS, (unsigned)g_sector, (unsigned long)g_offset);
+
+    uint8_t reset[4] = {0xFF, 0, 0, 0};
+#if defined(DEVICE_RESET_REASON)
+    reset[0] = (uint8_t)mbed::ResetReason::get();
+#endif
+    telemetry_module_record(TELEMETRY_RESET, reset, sizeof(reset));
+    // 复位记录立即写入：反复复位时每次启动都留下记录，不等攒批
+    telemetry_module_flush();
+}
+
+bool telemetry_module_record(telemetry_record_type_t type, const void* payload, size_t length) {
+    if (length > TELEMETRY_MAX_PAYLOAD) {
+        return false;
+    }
+    alignas(4) uint8_t record[TELEMETRY_RECORD_HEADER_BYTES + TELEMETRY_MAX_PAYLOAD];
+    const uint32_t size = record_size((uint8_t)length);
+    memset(record, 0, size);
+    record[0] = (uint8_t)type;
+    record[1] = (uint8_t)length;
+    put_u32(record + 4, millis());
+    memcpy(record + TELEMETRY_RECORD_HEADER_BYTES, payload, length);
+    uint16_t crc = usb_frame_crc16(record, 2);
+    crc = usb_frame_crc16(record + 4, 4 + length, crc);
+    put_u16(record + 2, crc);
+
+    g_mutex.lock();
+    const bool ok = g_batch_len + size <= TELEMETRY_BATCH_BYTES;
+    if (ok) {
+        if (g_batch_len == 0) {
+            g_batch_since_ms = millis();
+        }
+        memcpy(&g_batches[g_active_batch][g_batch_len], record, size);
+        g_batch_len += size;
+        g_records++;
+    } else {
+        g_dropped++;
+    }
+    g_mutex.unlock();
+    return ok;
+}
+
+void telemetry_module_poll() {
+    const uint32_t now_ms = millis();
+    if (now_ms - g_histogram_since_ms >= TELEMETRY_HISTOGRAM_MS) {
+        StatBins<TELEMETRY_HISTOGRAM_BINS> bins;
+        g_histogram.take(&bins);
+        g_histogram_since_ms = now_ms;
+        if (bins.count > 0) {
+            uint8_t histogram[TELEMETRY_HISTOGRAM_BINS * 2];
+            put_bins(histogram, bins);
+            telemetry_module_record(TELEMETRY_HISTOGRAM, histogram, sizeof(histogram));
+        }
+    }
+    record_label_histograms(now_ms);
+
+    // 半满即写入：两次轮询之间追加的记录仍有空间，不必丢弃
+    g_mutex.lock();
+    const bool flush_due = g_batch_len >= TELEMETRY_BATCH_BYTES / 2 ||
+                           (g_batch_len > 0 && now_ms - g_batch_since_ms >= TELEMETRY_FLUSH_MS);
+    g_mutex.unlock();
+    if (flush_due) {
+        telemetry_module_flush();
+    }
+}
+
+void telemetry_module_flush() {
+    g_flash_mutex.lock();
+    if (g_dumping) {
+        g_flash_mutex.unlock();
+        return;
+    }
+    // 交换批缓冲：写入期间其它线程继续追加到另一个缓冲
+    g_mutex.lock();
+    const uint8_t* batch = g_batches[g_active_batch];
+    const size_t length = g_batch_len;
+    g_active_batch ^= 1;
+    g_batch_len = 0;
+    g_mutex.unlock();
+    if (g_base != 0) {
+        write_batch(batch, length);
+    }
+    g_flash_mutex.unlock();
+}
+
+void telemetry_module_window(int index, float confidence, float runner_up_confidence, bool low) {
+    g_histogram.record(confidence_scaled(confidence));
+    if (index >= 0 && index < TELEMETRY_LABELS) {
+        const uint32_t top = confidence_byte(confidence);
+        const uint32_t margin = confidence_byte(confidence - runner_up_confidence);
+        g_label_period[index].top.record(top);
+        g_label_period[index].margin.record(margin);
+        g_label_total[index].top.record(top);
+        g_label_total[index].margin.record(margin);
+    }
+    if (low) {
+        const uint32_t now_ms = millis();
+        if (g_low_recorded && now_ms - g_low_last_ms < TELEMETRY_LOW_CONFIDENCE_MS) {
+            if (g_low_suppressed < UINT16_MAX) {
+                g_low_suppressed++;
+            }
+        } else {
+            uint8_t payload[4];
+            payload[0] = index >= 0 ? (uint8_t)index : 0xFF;
+            payload[1] = confidence_byte(confidence);
+            put_u16(payload + 2, g_low_suppressed);
+            g_low_suppressed = 0;
+            g_low_last_ms = now_ms;
+            g_low_recorded = true;
+            telemetry_module_record(TELEMETRY_LOW_CONFIDENCE, payload, sizeof(payload));
+        }
+    }
+}
+
+void telemetry_module_gesture(int index, float confidence, uint32_t sequence) {
+    if (index < 0) {
+        return;
+    }
+    uint8_t payload[sizeof(wire_result_t)];
+    wire_result_t* result = wire_at<wire_result_t>(payload);
+    result->index = (int8_t)index;
+    result->confidence = confidence_byte(confidence);
+    result->sequence = (uint16_t)sequence;
+    telemetry_module_record(TELEMETRY_GESTURE, payload, sizeof(payload));
+}
+
+void telemetry_module_latency() {
+    for (size_t stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+        latency_stats_t stats;
+        latency_module_get_stats((latency_stage_t)stage, &stats);
+        if (stats.count == 0 || stats.over_slo == 0) {
+            continue;
+        }
+        uint8_t payload[12];
+        payload[0] = (uint8_t)stage;
+        payload[1] = 0;
+        put_u16(payload + 2, (uint16_t)(stats.over_slo > UINT16_MAX ? UINT16_MAX : stats.over_slo));
+        put_u32(payload + 4, stats.p99_us);
+        put_u32(payload + 8, stats.max_us);
+        telemetry_module_record(TELEMETRY_LATENCY_SLO, payload, sizeof(payload));
+    }
+}
+
+uint32_t telemetry_module_dump_begin() {
+    telemetry_module_flush();
+    g_flash_mutex.lock();
+    g_dumping = true;
+    g_dump_spans = 0;
+    g_dump_bytes = 0;
+    for (uint8_t sector = 0; g_base != 0 && sector < TELEMETRY_SECTORS; sector++) {
+        uint32_t sequence;
+        if (!sector_sequence(sector, &sequence)) {
+            continue;
+        }
+        const dump_span_t span = {sequence, g_base + (uint32_t)sector * TELEMETRY_SECTOR_BYTES + SECTOR_HEADER_BYTES,
+                                  sector_end(sector, nullptr) - SECTOR_HEADER_BYTES};
+        // 按序号插入：导出按时间顺序
+        size_t i = g_dump_spans++;
+        for (; i > 0 && g_dump[i - 1].sequence > sequence; i--) {
+            g_dump[i] = g_dump[i - 1];
+        }
+        g_dump[i] = span;
+        g_dump_bytes += span.length;
+    }
+    const uint32_t bytes = g_dump_bytes;
+    g_flash_mutex.unlock();
+    LOG_INFO("[Telemetry] Dump of %lu bytes started\n", (unsigned long)bytes);
+    return bytes;
+}
+
+size_t telemetry_module_dump_read(uint32_t offset, uint8_t* out, size_t length) {
+    size_t copied = 0;
+    g_flash_mutex.lock();
+    for (size_t i = 0; g_dumping && i < g_dump_spans && copied < length; i++) {
+        const dump_span_t& span = g_dump[i];
+        if (offset >= span.length) {
+            offset -= span.length;
+            continue;
+        }
+        size_t n = span.length - offset;
+        n = n < length - copied ? n : length - copied;
+        memcpy(out + copied, reinterpret_cast<const uint8_t*>(span.address + offset), n);
+        copied += n;
+        offset = 0;
+    }
+    g_flash_mutex.unlock();
+    return copied;
+}
+
+void telemetry_module_dump_end() {
+    g_flash_mutex.lock();
+    const bool was_dumping = g_dumping;
+    g_dumping = false;
+    g_flash_mutex.unlock();
+    if (was_dumping) {
+        LOG_INFO("[Telemetry] Dump finished\n");
+    }
+}
+
+void telemetry_module_get_status(telemetry_status_t* out_status) {
+    // 写入位置一侧不加锁：擦除期间持有 g_flash_mutex 达数十毫秒，32 位的读是原子的
+    out_status->dumping = g_dumping;
+    out_status->log_bytes = g_log_bytes;
+    out_status->sequence = g_sequence;
+    out_status->flash_errors = g_flash_errors;
+    g_mutex.lock();
+    out_status->pending_bytes = (uint16_t)g_batch_len;
+    out_status->records = g_records;
+    out_status->dropped = g_dropped;
+    g_mutex.unlock();
+}
+
+bool telemetry_module_label_histogram(size_t label, telemetry_label_histogram_t* out_histogram) {
+    if (label >= TELEMETRY_LABELS) {
+        return false;
+    }
+    StatBins<TELEMETRY_LABEL_BINS> top;
+    StatBins<TELEMETRY_LABEL_BINS> margin;
+    g_label_total[label].top.snapshot(&top);
+    g_label_total[label].margin.snapshot(&margin);
+    memcpy(out_histogram->top, top.bins, sizeof(out_histogram->top));
+    memcpy(out_histogram->margin, margin.bins, sizeof(out_histogram->margin));
+    return true;
+}
+
+#endif
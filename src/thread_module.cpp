@@ -0,0 +1,192 @@
+// 线程表与栈峰值统计模块实现
+#include <Arduino.h>
+#include "rtos.h"
+#include <stdio.h>
+
+#include "app_config.h"
+#include "ble_module.h"
+#include "event_module.h"
+#include "inference_module.h"
+#include "memory_module.h"
+#include "periodic_timer.h"
+#include "record_module.h"
+#include "thread_module.h"
+
+// 启动前的栈填充字（与 RTX 的 osRtxStackFillPattern 相同；ESP-IDF 的 FreeRTOS 创建任务时自己用 tskSTACK_FILL_BYTE
+// 重新填充一遍，取同一个值）
+#if PLATFORM_ESP32
+#define THREAD_STACK_FILL 0xA5A5A5A5UL
+#else
+#define THREAD_STACK_FILL 0xCCCCCCCCUL
+#endif
+// RTX 写在栈底、用于溢出检查的魔数（osRtxStackMagicWord）
+#define THREAD_STACK_MAGIC 0xE25A2EA5UL
+
+// ==================== 内部状态（模块私有） ====================
+
+// 栈按 8 字节对齐（AAPCS 要求）
+alignas(8) static uint32_t g_sampler_stack[THREAD_SAMPLER_STACK_BYTES / 4];
+alignas(8) static uint32_t g_inference_stack[THREAD_INFERENCE_STACK_BYTES / 4];
+alignas(8) static uint32_t g_ble_stack[THREAD_BLE_STACK_BYTES / 4];
+alignas(8) static uint32_t g_events_stack[THREAD_EVENTS_STACK_BYTES / 4];
+alignas(8) static uint32_t g_record_stack[THREAD_RECORD_STACK_BYTES / 4];
+alignas(8) static uint32_t g_hci_stack[THREAD_HCI_STACK_BYTES / 4];
+
+struct thread_entry_t {
+    const char* name;
+    osPriority_t priority;
+    uint32_t* stack;
+    uint32_t stack_bytes;
+    void (*task)();
+    int core;  // ESP32 上绑定的核（其它平台忽略）
+};
+
+// 线程表，顺序与 thread_role_t 一致；采集线程最先启动
+static const thread_entry_t kThreadTable[THREAD_COUNT] = {
+    {"sampler", THREAD_SAMPLER_PRIORITY, g_sampler_stack, THREAD_SAMPLER_STACK_BYTES, inference_sampler_task,
+     THREAD_SAMPLER_CORE},
+    {"inference", THREAD_INFERENCE_PRIORITY, g_inference_stack, THREAD_INFERENCE_STACK_BYTES, inference_task,
+     THREAD_INFERENCE_CORE},
+    {"ble", THREAD_BLE_PRIORITY, g_ble_stack, THREAD_BLE_STACK_BYTES, ble_task,
+     THREAD_BLE_CORE},
+    {"events", THREAD_EVENTS_PRIORITY, g_events_stack, THREAD_EVENTS_STACK_BYTES, event_task,
+     THREAD_EVENTS_CORE},
+    {"record", THREAD_RECORD_PRIORITY, g_record_stack, THREAD_RECORD_STACK_BYTES, record_task,
+     THREAD_RECORD_CORE},
+    {"hci", THREAD_HCI_PRIORITY, g_hci_stack, THREAD_HCI_STACK_BYTES, ble_hci_watch_task,
+     THREAD_HCI_CORE},
+};
+
+static rtos::Thread* g_threads[THREAD_COUNT] = {nullptr};
+// 各线程登记的周期节拍（没有周期性工作的线程为 nullptr）
+static const PeriodicTimer* volatile g_timers[THREAD_COUNT] = {nullptr};
+
+// ==================== 内部辅助函数 ====================
+
+/**
+ * @brief 栈峰值：栈向下增长，从低地址数仍保持填充字的字数，其余部分都曾被使用过
+ */
+static uint32_t stack_peak_bytes(const thread_entry_t& entry) {
+    const uint32_t words = entry.stack_bytes / 4;
+    uint32_t untouched = 0;
+    while (untouched < words && (entry.stack[untouched] == THREAD_STACK_FILL ||
+                                 (untouched == 0 && entry.stack[0] == THREAD_STACK_MAGIC))) {
+        untouched++;
+    }
+    return (words - untouched) * 4;
+}
+
+/**
+ * @brief 填充栈并启动线程表中的一个线程
+ */
+static bool start_thread(size_t index) {
+    const thread_entry_t& entry = kThreadTable[index];
+    for (uint32_t w = 0; w < entry.stack_bytes / 4; w++) {
+        entry.stack[w] = THREAD_STACK_FILL;
+    }
+#if PLATFORM_ESP32
+    g_threads[index] = new rtos::Thread(entry.priority, entry.stack_bytes,
+                                        reinterpret_cast<unsigned char*>(entry.stack), entry.name, entry.core);
+#else
+    g_threads[index] = new rtos::Thread(entry.priority, entry.stack_bytes,
+                                        reinterpret_cast<unsigned char*>(entry.stack), entry.name);
+#endif
+    if (g_threads[index]->start(entry.task) != osOK) {
+        Serial.print("[Threads] Failed to start ");
+        Serial.println(entry.name);
+        return false;
+    }
+    return true;
+}
+
+// ==================== 公共接口实现 ====================
+
+bool thread_module_start_early(thread_role_t role) {
+    if (role >= THREAD_COUNT) {
+        return false;
+    }
+    return g_threads[role] || start_thread(role);
+}
+
+bool thread_module_start() {
+    bool ok = true;
+    for (size_t i = 0; i < THREAD_COUNT; i++) {
+        if (!g_threads[i]) {
+            ok &= start_thread(i);
+        }
+        memory_module_register(kThreadTable[i].name, kThreadTable[i].stack_bytes, false);
+    }
+    return ok;
+}
+
+void thread_module_get_stats(thread_role_t role, thread_stack_stats_t* out_stats) {
+    if (!out_stats || role >= THREAD_COUNT) {
+        return;
+    }
+    const thread_entry_t& entry = kThreadTable[role];
+    out_stats->name = entry.name;
+    out_stats->priority = (int)entry.priority;
+    out_stats->stack_bytes = entry.stack_bytes;
+    out_stats->peak_bytes = g_threads[role] ? stack_peak_bytes(entry) : 0;
+}
+
+thread_role_t thread_module_role_at(uintptr_t address) {
+    for (size_t i = 0; i < THREAD_COUNT; i++) {
+        const uintptr_t base = reinterpret_cast<uintptr_t>(kThreadTable[i].stack);
+        if (address >= base && address < base + kThreadTable[i].stack_bytes) {
+            return (thread_role_t)i;
+        }
+    }
+    return THREAD_COUNT;
+}
+
+void thread_module_register_timer(thread_role_t role, const PeriodicTimer* timer) {
+    if (role < THREAD_COUNT) {
+        g_timers[role] = timer;
+    }
+}
+
+void thread_module_report() {
+    char line[144];
+    for (size_t i = 0; i < THREAD_COUNT; i++) {
+        thread_stack_stats_t stats;
+        thread_module_get_stats((thread_role_t)i, &stats);
+        int len = snprintf(line, sizeof(line), "[Threads] %-9s prio %2d, stack %5lu B, peak %5lu B (%lu%%)",
+                           stats.name, stats.priority, (unsigned long)stats.stack_bytes,
+                           (unsigned long)stats.peak_bytes, (unsigned long)(stats.peak_bytes * 100UL / stats.stack_bytes));
+        const PeriodicTimer* timer = g_timers[i];
+        if (timer && len > 0 && (size_t)len < sizeof(line)) {
+            snprintf(line + len, sizeof(line) - len, ", period %lu ms, overruns %lu, max late %lu ms",
+                     (unsigned long)timer->period().count(), (unsigned long)timer->overruns(),
+                     (unsigned long)timer->max_late_ms());
+        }
+        Serial.println(line);
+    }
+}
+
+bool thread_module_running(thread_role_t role) {
+    if (role >= THREAD_COUNT || !g_threads[role]) {
+        return false;
+    }
+    const rtos::Thread::State state = g_threads[role]->get_state();
+    return state != rtos::Thread::Inactive && state != rtos::Thread::Deleted;
+}
+
+void thread_module_stop(thread_role_t role) {
+    if (role >= THREAD_COUNT || !g_threads[role]) {
+        return;
+    }
+    // 析构时终止线程（已退出的线程只回收控制块）；栈是静态的，不随之释放
+    delete g_threads[role];
+    g_threads[role] = nullptr;
+    // 线程登记的周期节拍是它栈上的局部变量，随线程一起失效
+    g_timers[role] = nullptr;
+}
+
+bool thread_module_restart(thread_role_t role) {
+    if (role >= THREAD_COUNT) {
+        return false;
+    }
+    thread_module_stop(role);
+    return start_thread(role);
+}
@@ -0,0 +1,206 @@
+// USB CDC 二进制链路实现
+#include <Arduino.h>
+#include <string.h>
+
+#include "app_config.h"
+#include "ble_module.h"
+#include "inference_module.h"
+#include "log_module.h"
+#include "memory_module.h"
+#include "shell_module.h"
+#include "spsc_ring.h"
+#include "usb_link_module.h"
+#include "wire_schema.h"
+
+// 主机写入的一帧编码后的最大长度（type + payload + crc16，加 COBS 开销），更长的段丢弃
+#define USB_LINK_RX_MAX (1 + USB_LINK_INBOUND_MAX + 2 + 2)
+
+// ==================== 内部状态（模块私有） ====================
+
+// 录制线程写入、BLE 线程读出
+MEMORY_RING_BUFFER static SpscRing<usb_link_frame_t, USB_LINK_QUEUE_FRAMES> g_inbound;
+static const MemoryPlacement g_inbound_placement("usb inbound ring", &g_inbound, sizeof(g_inbound), MEMORY_PLACE_RING);
+static volatile bool g_open = false;
+static volatile uint8_t g_streams = 0;
+static volatile uint32_t g_last_hello_ms = 0;
+
+// 以下只由录制线程访问
+MEMORY_DMA_BUFFER static uint8_t g_rx[USB_LINK_RX_MAX];
+static const MemoryPlacement g_rx_placement("usb rx frame", g_rx, sizeof(g_rx), MEMORY_PLACE_DMA);
+static size_t g_rx_len = 0;
+static bool g_in_frame = false;
+static bool g_rx_overflow = false;
+
+// ==================== 内部辅助函数 ====================
+
+/**
+ * @brief 帧类型所属的订阅位（0 = 总是发送）
+ */
+static uint8_t stream_of(uint8_t type) {
+    switch (type) {
+    case USB_FRAME_EVENTS:
+    case USB_FRAME_GESTURE:
+    case USB_FRAME_SEGMENT:
+    case USB_FRAME_COMBO_EVENT:
+        return USB_STREAM_EVENTS;
+    case USB_FRAME_SCORES:
+        return USB_STREAM_SCORES;
+    case USB_FRAME_WINDOW:
+        return USB_STREAM_WINDOW;
+    case USB_FRAME_DIAGNOSTICS:
+    case USB_FRAME_CPU:
+    case USB_FRAME_LATENCY:
+    case USB_FRAME_COUNTERS:
+        return USB_STREAM_DIAGNOSTICS;
+    case USB_FRAME_RECORD_DATA:
+        return USB_STREAM_RECORD;
+    case USB_FRAME_TRACE:
+        return USB_STREAM_TRACE;
+    default:
+        return 0;
+    }
+}
+
+static void handle_hello(const uint8_t* payload, size_t length) {
+    if (length < 1) {
+        return;
+    }
+    const bool was_open = g_open;
+    g_streams = payload[0];
+    g_last_hello_ms = millis();
+    g_open = payload[0] != 0;
+    if (g_open != was_open) {
+        LOG_INFO("[USB] Link %s, streams 0x%02x\n", g_open ? "opened" : "closed", (unsigned)payload[0]);
+        // BLE 线程立即切换会话，不等到下一次轮询
+        ble_module_wake();
+    }
+    uint8_t reply[3 + sizeof(wire_confidence_format_t)] = {payload[0], USB_LINK_VERSION, WIRE_SCHEMA_VERSION};
+    inference_confidence_format_t format;
+    inference_get_confidence_format(&format);
+    wire_confidence_format_t* confidence = wire_at<wire_confidence_format_t>(reply + 3);
+    confidence->zero_point = format.zero_point;
+    confidence->scale = format.scale;
+    usb_link_module_send(USB_FRAME_HELLO, reply, sizeof(reply));
+}
+
+/**
+ * @brief 时钟同步：格式与 BLE 时钟同步特征值（19B10024）相同，在读到请求的线程中当场回复
+ */
+static void handle_time_sync(const uint8_t* payload, size_t length, uint32_t received_ms, uint32_t received_us) {
+    if (length < 2) {
+        return;
+    }
+    uint8_t reply[8];
+    reply[0] = payload[0];
+    reply[1] = payload[1];
+    reply[2] = (uint8_t)received_ms;
+    reply[3] = (uint8_t)(received_ms >> 8);
+    reply[4] = (uint8_t)(received_ms >> 16);
+    reply[5] = (uint8_t)(received_ms >> 24);
+    const uint32_t held_us = micros() - received_us;
+    const uint16_t held = (uint16_t)(held_us > 0xFFFF ? 0xFFFF : held_us);
+    reply[6] = (uint8_t)held;
+    reply[7] = (uint8_t)(held >> 8);
+    usb_link_module_send(USB_FRAME_TIME_SYNC, reply, sizeof(reply));
+}
+
+static void handle_frame(uint32_t received_ms, uint32_t received_us) {
+    uint8_t content[USB_LINK_RX_MAX];
+    const size_t length = usb_frame_decode(g_rx, g_rx_len, content);
+    if (length == 0) {
+        return;
+    }
+    const uint8_t type = content[0];
+    const uint8_t* payload = content + 1;
+    const size_t payload_len = length - 1;
+    if (type == USB_FRAME_HELLO) {
+        handle_hello(payload, payload_len);
+        return;
+    }
+#if SHELL_ENABLE
+    // 诊断命令在链路关闭时也应答
+    if (type == USB_FRAME_SHELL) {
+        shell_module_handle(payload, payload_len);
+        return;
+    }
+#endif
+    if (!usb_link_module_open()) {
+        return;
+    }
+    if (type == USB_FRAME_TIME_SYNC) {
+        handle_time_sync(payload, payload_len, received_ms, received_us);
+        return;
+    }
+    usb_link_frame_t frame;
+    frame.type = type;
+    frame.length = (uint8_t)(payload_len < USB_LINK_INBOUND_MAX ? payload_len : USB_LINK_INBOUND_MAX);
+    memcpy(frame.data, payload, frame.length);
+    if (!g_inbound.push(&frame, 1)) {
+        LOG_WARN("[USB] Inbound queue full, frame 0x%02x dropped\n", (unsigned)type);
+        return;
+    }
+    ble_module_wake();
+}
+
+// ==================== 公共接口实现 ====================
+
+bool usb_link_module_feed(uint8_t byte) {
+    if (!g_in_frame) {
+        // 文本命令中不会出现 0x00：它总是一帧的开始
+        if (byte != USB_FRAME_DELIMITER) {
+            return false;
+        }
+        g_in_frame = true;
+        g_rx_len = 0;
+        g_rx_overflow = false;
+        return true;
+    }
+    if (byte != USB_FRAME_DELIMITER) {
+        if (g_rx_len < sizeof(g_rx)) {
+            g_rx[g_rx_len++] = byte;
+        } else {
+            g_rx_overflow = true;
+        }
+        return true;
+    }
+    // 相邻帧之间是两个分隔符：空段仍是下一帧的开始
+    if (g_rx_len == 0) {
+        return true;
+    }
+    const uint32_t received_ms = millis();
+    const uint32_t received_us = micros();
+    if (!g_rx_overflow) {
+        handle_frame(received_ms, received_us);
+    }
+    g_in_frame = false;
+    return true;
+}
+
+bool usb_link_module_open() {
+    if (g_open && millis() - g_last_hello_ms >= USB_LINK_TIMEOUT_MS) {
+        g_open = false;
+        LOG_INFO("[USB] Link timed out\n");
+    }
+    return g_open;
+}
+
+bool usb_link_module_subscribed(uint8_t type) {
+    const uint8_t stream = stream_of(type);
+    return usb_link_module_open() && (stream == 0 || (g_streams & stream) != 0);
+}
+
+bool usb_link_module_send(uint8_t type, const uint8_t* payload, size_t length) {
+    if (type != USB_FRAME_HELLO && type != USB_FRAME_SHELL && !usb_link_module_subscribed(type)) {
+        return false;
+    }
+    uint8_t frame[USB_FRAME_MAX_BYTES];
+    const size_t frame_len = usb_frame_encode(type, payload, length, frame);
+    if (frame_len == 0) {
+        return false;
+    }
+    return Serial.write(frame, frame_len) == frame_len;
+}
+
+bool usb_link_module_pop(usb_link_frame_t* out_frame) {
+    return g_inbound.pop(out_frame, 1);
+}
@@ -0,0 +1,77 @@
+// 推理线程看门狗模块实现
+#include <Arduino.h>
+
+#include "app_config.h"
+#include "log_module.h"
+#include "watchdog_module.h"
+#if WATCHDOG_ENABLE
+#include "mbed.h"
+#endif
+
+// ==================== 内部状态（模块私有） ====================
+
+// 只由推理线程写；32 位读写是原子的，读者不加锁
+static volatile uint32_t g_stalls = 0;
+static volatile uint32_t g_longest_gap_ms = 0;
+static volatile bool g_watchdog_reset = false;
+static uint32_t g_last_progress_ms = 0;
+static bool g_started = false;
+
+// ==================== 公共接口实现 ====================
+
+void watchdog_module_init() {
+#if WATCHDOG_ENABLE && defined(DEVICE_RESET_REASON)
+    g_watchdog_reset = mbed::ResetReason::get() == RESET_REASON_WATCHDOG;
+    if (g_watchdog_reset) {
+        Serial.println("[Watchdog] Last reset was caused by the watchdog (inference thread stalled)");
+    }
+#endif
+}
+
+void watchdog_module_start() {
+#if WATCHDOG_ENABLE && defined(DEVICE_WATCHDOG)
+    // 推理线程被监督者重启时再次调用：看门狗已在运行，只重新开始停滞计时
+    if (!g_started && !mbed::Watchdog::get_instance().start(WATCHDOG_TIMEOUT_MS)) {
+        LOG_ERROR("[Watchdog] Failed to start the hardware watchdog\n");
+    }
+#endif
+    g_last_progress_ms = millis();
+    g_started = true;
+}
+
+void watchdog_module_progress() {
+    if (!g_started) {
+        return;
+    }
+#if WATCHDOG_ENABLE && defined(DEVICE_WATCHDOG)
+    mbed::Watchdog::get_instance().kick();
+#endif
+    const uint32_t now_ms = millis();
+    const uint32_t gap_ms = now_ms - g_last_progress_ms;
+    g_last_progress_ms = now_ms;
+    if (gap_ms > g_longest_gap_ms) {
+        g_longest_gap_ms = gap_ms;
+    }
+    if (gap_ms >= WATCHDOG_STALL_MS) {
+        g_stalls++;
+        LOG_WARN("[Watchdog] Inference thread stalled for %lu ms\n", (unsigned long)gap_ms);
+    }
+}
+
+void watchdog_module_get_stats(watchdog_stats_t* out_stats) {
+    if (out_stats) {
+        out_stats->stalls = g_stalls;
+        out_stats->longest_gap_ms = g_longest_gap_ms;
+        out_stats->watchdog_reset = g_watchdog_reset;
+    }
+}
+
+void watchdog_module_report() {
+    watchdog_stats_t stats;
+    watchdog_module_get_stats(&stats);
+    if (stats.stalls == 0 && !stats.watchdog_reset) {
+        return;
+    }
+    LOG_INFO("[Watchdog] %lu stalls since boot, longest loop gap %lu ms%s\n", (unsigned long)stats.stalls,
+             (unsigned long)stats.longest_gap_ms, stats.watchdog_reset ? ", last reset by watchdog" : "");
+}
@@ -0,0 +1,160 @@
+// 向量化的 numpy 基本运算（pio test -e native_dsp）：ei::simd 的每条路径与原来的逐元素循环比较。
+// 逐元素运算（scale / offset）要求逐位一致；求和类运算按八路部分和累加，要求误差在 n·ε·Σ|x| 以内，
+// 且 x86 上 SSE2 与 AVX2 两条路径逐位一致
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "edge-impulse-sdk/dsp/numpy.hpp"
+
+using namespace ei;
+namespace detail = ei::simd::detail;
+
+// 覆盖空数组、不足一组、整组与各种余数
+static const size_t kLengths[] = {0, 1, 3, 4, 7, 8, 9, 15, 16, 17, 31, 64, 100, 257};
+static const size_t kLengthCount = sizeof(kLengths) / sizeof(kLengths[0]);
+
+static std::vector<float> make_values(size_t n, uint32_t seed) {
+    std::vector<float> values(n);
+    srand(seed);
+    for (size_t i = 0; i < n; i++) {
+        values[i] = ((float)rand() / (float)RAND_MAX - 0.3f) * 8.0f;
+    }
+    return values;
+}
+
+static bool same_bits(const std::vector<float>& a, const std::vector<float>& b) {
+    return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0);
+}
+
+/**
+ * @brief 与双精度参考值比较：逐次舍入的误差上界为 n·ε·Σ|项|，取两倍余量
+ */
+static void assert_sum_close(double reference, double magnitude, size_t n, float actual) {
+    const double bound = 2.0 * (double)(n + 1) * FLT_EPSILON * magnitude + 1e-30;
+    TEST_ASSERT_TRUE(fabs((double)actual - reference) <= bound);
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+static void test_elementwise_is_bit_exact() {
+    for (size_t l = 0; l < kLengthCount; l++) {
+        const size_t n = kLengths[l];
+        std::vector<float> expected = make_values(n, 11 + l), actual = expected;
+        detail::scale_scalar(expected.data(), n, 0.37f);
+        simd::scale(actual.data(), n, 0.37f);
+        TEST_ASSERT_TRUE(same_bits(expected, actual));
+
+        detail::offset_scalar(expected.data(), n, -1.25f);
+        simd::offset(actual.data(), n, -1.25f);
+        TEST_ASSERT_TRUE(same_bits(expected, actual));
+    }
+}
+
+static void test_reductions_are_within_the_rounding_bound() {
+    for (size_t l = 0; l < kLengthCount; l++) {
+        const size_t n = kLengths[l];
+        const std::vector<float> x = make_values(n, 23 + l), y = make_values(n, 57 + l);
+        const float mean = n > 0 ? simd::sum(x.data(), n) / n : 0.0f;
+        double sum = 0.0, abs_sum = 0.0, squares = 0.0, deviations = 0.0, dot = 0.0, abs_dot = 0.0;
+        for (size_t i = 0; i < n; i++) {
+            sum += x[i];
+            abs_sum += fabs(x[i]);
+            squares += (double)x[i] * x[i];
+            deviations += ((double)x[i] - mean) * ((double)x[i] - mean);
+            dot += (double)x[i] * y[i];
+            abs_dot += fabs((double)x[i] * y[i]);
+        }
+        assert_sum_close(sum, abs_sum, n, simd::sum(x.data(), n));
+        assert_sum_close(squares, squares, n, simd::sum_of_squares(x.data(), n));
+        assert_sum_close(deviations, deviations, n, simd::sum_of_squared_deviations(x.data(), n, mean));
+        assert_sum_close(dot, abs_dot, n, simd::dot(x.data(), y.data(), n));
+    }
+}
+
+static void test_sse2_and_avx2_agree() {
+#if EI_SIMD_X86
+    if (!detail::has_avx2()) {
+        printf("  (no AVX2 on this CPU, only SSE2 is checked)\n");
+        return;
+    }
+    for (size_t l = 0; l < kLengthCount; l++) {
+        const size_t n = kLengths[l];
+        const std::vector<float> x = make_values(n, 91 + l), y = make_values(n, 97 + l);
+        TEST_ASSERT_TRUE(detail::sum_sse2(x.data(), n) == detail::sum_avx2(x.data(), n));
+        TEST_ASSERT_TRUE(detail::sum_of_squares_sse2(x.data(), n) == detail::sum_of_squares_avx2(x.data(), n));
+        TEST_ASSERT_TRUE(detail::sum_of_squared_deviations_sse2(x.data(), n, 0.5f) ==
+                         detail::sum_of_squared_deviations_avx2(x.data(), n, 0.5f));
+        TEST_ASSERT_TRUE(detail::dot_sse2(x.data(), y.data(), n) == detail::dot_avx2(x.data(), y.data(), n));
+
+        std::vector<float> sse2 = x, avx2 = x;
+        detail::scale_sse2(sse2.data(), n, 3.5f);
+        detail::scale_avx2(avx2.data(), n, 3.5f);
+        detail::offset_sse2(sse2.data(), n, 0.1f);
+        detail::offset_avx2(avx2.data(), n, 0.1f);
+        TEST_ASSERT_TRUE(same_bits(sse2, avx2));
+    }
+#else
+    printf("  (not an x86 build)\n");
+#endif
+}
+
+static void test_numpy_row_statistics() {
+    // 3 行 × 37 列：每行各自求均值 / 标准差 / RMS，与双精度参考比较
+    const size_t rows = 3, cols = 37;
+    std::vector<float> values = make_values(rows * cols, 5);
+    matrix_t input(rows, cols, values.data());
+    std::vector<float> mean_out(rows), std_out(rows), rms_out(rows);
+    matrix_t mean_matrix(rows, 1, mean_out.data()), std_matrix(rows, 1, std_out.data()),
+        rms_matrix(rows, 1, rms_out.data());
+    TEST_ASSERT_TRUE(numpy::mean(&input, &mean_matrix) == EIDSP_OK);
+    TEST_ASSERT_TRUE(numpy::stdev(&input, &std_matrix) == EIDSP_OK);
+    TEST_ASSERT_TRUE(numpy::rms(&input, &rms_matrix) == EIDSP_OK);
+    for (size_t r = 0; r < rows; r++) {
+        const float* row = values.data() + r * cols;
+        double sum = 0.0, squares = 0.0;
+        for (size_t c = 0; c < cols; c++) {
+            sum += row[c];
+            squares += (double)row[c] * row[c];
+        }
+        const double mean = sum / cols;
+        double deviations = 0.0;
+        for (size_t c = 0; c < cols; c++) {
+            deviations += (row[c] - mean) * (row[c] - mean);
+        }
+        TEST_ASSERT_TRUE(fabs(mean_out[r] - mean) < 1e-5);
+        TEST_ASSERT_TRUE(fabs(std_out[r] - sqrt(deviations / cols)) < 1e-5);
+        TEST_ASSERT_TRUE(fabs(rms_out[r] - sqrt(squares / cols)) < 1e-5);
+    }
+}
+
+static void test_numpy_add_and_subtract_match_the_loop() {
+    std::vector<float> values = make_values(29, 7), expected = values;
+    matrix_t matrix(1, values.size(), values.data());
+    TEST_ASSERT_TRUE(numpy::subtract(&matrix, 0.3f) == EIDSP_OK);
+    for (size_t i = 0; i < expected.size(); i++) {
+        expected[i] -= 0.3f;
+    }
+    TEST_ASSERT_TRUE(same_bits(expected, values));
+    TEST_ASSERT_TRUE(numpy::add(&matrix, 2.0f) == EIDSP_OK);
+    for (size_t i = 0; i < expected.size(); i++) {
+        expected[i] += 2.0f;
+    }
+    TEST_ASSERT_TRUE(same_bits(expected, values));
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_elementwise_is_bit_exact);
+    RUN_TEST(test_reductions_are_within_the_rounding_bound);
+    RUN_TEST(test_sse2_and_avx2_agree);
+    RUN_TEST(test_numpy_row_statistics);
+    RUN_TEST(test_numpy_add_and_subtract_match_the_loop);
+    return UNITY_END();
+}
@@ -0,0 +1,171 @@
+// 连续分类保持 EON 图初始化（pio test -e native_dsp）：第一个窗口之后每次 run_classifier_continuous 只填输入并 invoke，
+// 不再初始化、不清零 arena、不调用算子 prepare；复用的图与每次重新初始化的图结果一致；
+// run_classifier_init 只清零变量（有状态模型），run_classifier_deinit 才释放图
+#include <unity.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "edge-impulse-sdk/classifier/ei_run_classifier.h"
+
+static const size_t kAxes = EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME;
+static const uint8_t kSentinel = 0xA5;
+
+/**
+ * @brief 模拟三轴信号：每轴一个不同频率的正弦加噪声
+ */
+static std::vector<float> make_stream(size_t frames, uint32_t seed) {
+    std::vector<float> stream(frames * kAxes);
+    srand(seed);
+    for (size_t f = 0; f < frames; f++) {
+        const float t = (float)f / EI_CLASSIFIER_FREQUENCY;
+        for (size_t a = 0; a < kAxes; a++) {
+            const float noise = ((float)rand() / (float)RAND_MAX - 0.5f) * 0.3f;
+            stream[f * kAxes + a] = sinf(2.0f * (float)M_PI * (1.5f + 2.0f * a) * t) * (0.8f + 0.3f * a) + noise;
+        }
+    }
+    return stream;
+}
+
+static EI_IMPULSE_ERROR classify_slice(const std::vector<float>& stream, size_t frame, ei_impulse_result_t* result) {
+    signal_t signal;
+    numpy::signal_from_buffer(const_cast<float*>(stream.data()) + frame * kAxes, EI_CLASSIFIER_SLICE_SIZE * kAxes,
+                              &signal);
+    return run_classifier_continuous(&signal, result, false);
+}
+
+/**
+ * @brief 对同一窗口用 run_classifier 运行（图未初始化时每次初始化 + 复位）
+ */
+static void classify_window(const std::vector<float>& stream, size_t end_frame, ei_impulse_result_t* result) {
+    signal_t signal;
+    numpy::signal_from_buffer(const_cast<float*>(stream.data()) + (end_frame - EI_CLASSIFIER_RAW_SAMPLE_COUNT) * kAxes,
+                              EI_CLASSIFIER_RAW_SAMPLE_COUNT * kAxes, &signal);
+    TEST_ASSERT_TRUE(run_classifier(&signal, result, false) == EI_IMPULSE_OK);
+}
+
+/**
+ * @brief arena 中张量与 persistent 缓冲区之间的空隙：invoke 不写它，只有 init 的 memset 会清零它
+ */
+static uint8_t* arena_gap_byte() {
+    size_t idle_bytes = 0, tensor_bytes = 0;
+    uint8_t* idle = tflite_learn_792000_36_idle_region(&idle_bytes);
+    tflite_learn_792000_36_arena_usage(nullptr, &tensor_bytes, nullptr);
+    return (idle && idle_bytes > tensor_bytes) ? idle + idle_bytes - 1 : nullptr;
+}
+
+void setUp() {
+    run_classifier_deinit();
+}
+
+void tearDown() {
+    run_classifier_deinit();
+}
+
+static void test_continuous_loop_keeps_the_graph_initialized() {
+    const std::vector<float> stream = make_stream(EI_CLASSIFIER_RAW_SAMPLE_COUNT * 6, 0x5EED);
+    run_classifier_init();
+    TEST_ASSERT_FALSE(tflite_learn_792000_36_initialized());
+
+    ei_impulse_result_t result;
+    size_t persistent_bytes = 0;
+    uint8_t* gap = nullptr;
+    size_t inferences = 0;
+    for (size_t frame = 0; frame + EI_CLASSIFIER_SLICE_SIZE <= stream.size() / kAxes;
+         frame += EI_CLASSIFIER_SLICE_SIZE) {
+        TEST_ASSERT_TRUE(classify_slice(stream, frame, &result) == EI_IMPULSE_OK);
+        // 窗口填满之前只积累样本，不运行推理
+        if (frame + EI_CLASSIFIER_SLICE_SIZE < EI_CLASSIFIER_RAW_SAMPLE_COUNT) {
+            TEST_ASSERT_FALSE(tflite_learn_792000_36_initialized());
+            continue;
+        }
+        TEST_ASSERT_TRUE(tflite_learn_792000_36_initialized());
+        size_t bytes = 0;
+        tflite_learn_792000_36_arena_usage(nullptr, nullptr, &bytes);
+        if (inferences++ == 0) {
+            // 第一个窗口初始化了图；之后的 invoke 若重新初始化，空隙里的标记会被 memset 清掉
+            persistent_bytes = bytes;
+            gap = arena_gap_byte();
+        } else {
+            TEST_ASSERT_EQUAL_UINT32(persistent_bytes, bytes);
+            if (gap) {
+                TEST_ASSERT_EQUAL_HEX8(kSentinel, *gap);
+            }
+        }
+        if (gap) {
+            *gap = kSentinel;
+        }
+    }
+    TEST_ASSERT_TRUE(inferences > 1);
+
+    // 已初始化的图被非连续路径直接复用，也不被它复位
+    classify_window(stream, EI_CLASSIFIER_RAW_SAMPLE_COUNT, &result);
+    TEST_ASSERT_TRUE(tflite_learn_792000_36_initialized());
+
+    run_classifier_deinit();
+    TEST_ASSERT_FALSE(tflite_learn_792000_36_initialized());
+}
+
+static void test_reused_graph_matches_a_fresh_graph() {
+    const std::vector<float> stream = make_stream(EI_CLASSIFIER_RAW_SAMPLE_COUNT * 4, 0xC0FFEE);
+    std::vector<std::vector<float>> continuous;
+    std::vector<size_t> end_frames;
+
+    run_classifier_init();
+    for (size_t frame = 0; frame + EI_CLASSIFIER_SLICE_SIZE <= stream.size() / kAxes;
+         frame += EI_CLASSIFIER_SLICE_SIZE) {
+        ei_impulse_result_t result;
+        TEST_ASSERT_TRUE(classify_slice(stream, frame, &result) == EI_IMPULSE_OK);
+        const size_t end_frame = frame + EI_CLASSIFIER_SLICE_SIZE;
+        if (end_frame < EI_CLASSIFIER_RAW_SAMPLE_COUNT) {
+            continue;
+        }
+        std::vector<float> scores(EI_CLASSIFIER_LABEL_COUNT);
+        for (size_t i = 0; i < EI_CLASSIFIER_LABEL_COUNT; i++) {
+            scores[i] = result.classification[i].value;
+        }
+        continuous.push_back(scores);
+        end_frames.push_back(end_frame);
+    }
+    run_classifier_deinit();
+
+    // 每个窗口都在新初始化的图上重跑一次
+    for (size_t w = 0; w < continuous.size(); w++) {
+        ei_impulse_result_t result;
+        classify_window(stream, end_frames[w], &result);
+        TEST_ASSERT_FALSE(tflite_learn_792000_36_initialized());
+        for (size_t i = 0; i < EI_CLASSIFIER_LABEL_COUNT; i++) {
+            TEST_ASSERT_FLOAT_WITHIN(1e-6f, result.classification[i].value, continuous[w][i]);
+        }
+    }
+}
+
+static void test_init_resets_state_without_releasing_the_graph() {
+    const std::vector<float> stream = make_stream(EI_CLASSIFIER_RAW_SAMPLE_COUNT * 2, 0xBEEF);
+    TEST_ASSERT_TRUE(tflite_learn_792000_36_reset_state() == kTfLiteError);
+
+    run_classifier_init();
+    ei_impulse_result_t result;
+    for (size_t frame = 0; frame < EI_CLASSIFIER_RAW_SAMPLE_COUNT; frame += EI_CLASSIFIER_SLICE_SIZE) {
+        TEST_ASSERT_TRUE(classify_slice(stream, frame, &result) == EI_IMPULSE_OK);
+    }
+    TEST_ASSERT_TRUE(tflite_learn_792000_36_initialized());
+    TEST_ASSERT_TRUE(tflite_learn_792000_36_reset_state() == kTfLiteOk);
+
+    // 重新开始连续分类：变量清零，图保持初始化
+    run_classifier_init();
+    TEST_ASSERT_TRUE(tflite_learn_792000_36_initialized());
+    TEST_ASSERT_TRUE(classify_slice(stream, 0, &result) == EI_IMPULSE_OK);
+
+    run_classifier_deinit();
+    TEST_ASSERT_FALSE(tflite_learn_792000_36_initialized());
+    TEST_ASSERT_TRUE(tflite_learn_792000_36_reset_state() == kTfLiteError);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_continuous_loop_keeps_the_graph_initialized);
+    RUN_TEST(test_reused_graph_matches_a_fresh_graph);
+    RUN_TEST(test_init_resets_state_without_releasing_the_graph);
+    return UNITY_END();
+}
@@ -0,0 +1,446 @@
+// 黄金输出等价性（pio test -e native_golden -e native_golden_specialized）：同一份语料逐窗口经参考路径
+// run_classifier（浮点窗口：原始特征块 + 编译图 + softmax）与固件的每条优化路径推理——int8 窗口上的完整图、
+// 流式增量卷积（按构建开启特化内核 / 稀疏全连接 / 跳过 softmax）与 int8 域后处理——断言获胜类别相同、
+// 概率差不超过 GOLDEN_MAX_SCORE_DELTA，流式路径与完整图逐位一致，并在同一次运行中打印各路径每窗口耗时与加速比。
+// 改变数值路径的优化须在两个环境下通过后再合入。
+//
+// 语料：环境变量 GOLDEN_CORPUS 给出录制（raw_recorder.py 导出的 CSV，多个文件以 ':' 分隔，按模型的融合轴名取列），
+// 也可以是会话语料（session_corpus.h，映射后逐会话取列，LSB 换算回 g / dps），
+// 未设置时用固定种子的模拟信号（静止、不同幅度的挥动与随机冲击交替）。等价性与采样率无关，帧按原样使用。
+// 窗口按设备的步长滑动（2 帧，间插自适应步长的粗步长），环形窗口与新值计数与 inference_module 相同。
+#include <unity.h>
+#include <chrono>
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "app_config.h"
+#include "model_module.h"
+#include "session_corpus.h"
+#include "edge-impulse-sdk/classifier/ei_run_classifier.h"
+
+#if !INFERENCE_INT8_WINDOW
+#error "test_golden_equivalence compares the int8 window paths: build it with -DINFERENCE_INT8_WINDOW=1 (native_golden)"
+#endif
+
+// 参考路径与优化路径的概率之差上限：输出张量的量化步长为 1/256，跳过 softmax 时获胜概率来自 exp 查找表
+#ifndef GOLDEN_MAX_SCORE_DELTA
+#define GOLDEN_MAX_SCORE_DELTA 0.02f
+#endif
+
+static const size_t kAxes = EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME;
+static const size_t kFrames = EI_CLASSIFIER_RAW_SAMPLE_COUNT;
+static const size_t kValues = EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE;
+static const size_t kLabels = EI_CLASSIFIER_LABEL_COUNT;
+// 每次滑动的帧数：设备的步长是 2 帧，自适应步长在稳定时改为粗步长
+static const size_t kStrides[] = {2, 2, 2, 4, 12, 2, 6, 2};
+
+struct scores_t {
+    float p[kLabels];
+};
+
+static std::vector<float> g_frames;        // 语料，按帧交错
+static std::vector<size_t> g_window_ends;  // 每个窗口最后一帧之后的帧号
+static std::vector<scores_t> g_reference;
+static double g_reference_us = 0.0;
+
+static double now_us() {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static size_t argmax(const float* p) {
+    size_t best = 0;
+    for (size_t i = 1; i < kLabels; i++) {
+        if (p[i] > p[best]) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief 获胜类别与第二名的概率差（差距不超过容差时两条路径的获胜类别允许不同）
+ */
+static float top_margin(const float* p) {
+    const size_t best = argmax(p);
+    float second = 0.0f;
+    for (size_t i = 0; i < kLabels; i++) {
+        if (i != best && p[i] > second) {
+            second = p[i];
+        }
+    }
+    return p[best] - second;
+}
+
+// ==================== 语料 ====================
+
+static void append_simulated(size_t frames, uint32_t seed) {
+    srand(seed);
+    float amplitude = 0.0f;
+    float frequency = 2.0f;
+    for (size_t f = 0; f < frames; f++) {
+        // 每 1.5 s 换一段：静止、慢挥、快挥或冲击
+        if (f % 72 == 0) {
+            const int kind = rand() % 4;
+            amplitude = kind == 0 ? 0.0f : 0.3f + 1.5f * (float)rand() / (float)RAND_MAX;
+            frequency = kind == 3 ? 6.0f : 1.0f + 2.0f * (float)rand() / (float)RAND_MAX;
+        }
+        const float t = (float)f / EI_CLASSIFIER_FREQUENCY;
+        for (size_t a = 0; a < kAxes; a++) {
+            const float noise = ((float)rand() / (float)RAND_MAX - 0.5f) * 0.05f;
+            const float gravity = a == kAxes - 1 ? 1.0f : 0.0f;
+            g_frames.push_back(gravity + amplitude * sinf(2.0f * (float)M_PI * frequency * t + a) + noise);
+        }
+    }
+}
+
+static std::string lower(std::string s) {
+    for (char& c : s) {
+        c = (char)tolower((unsigned char)c);
+    }
+    return s;
+}
+
+static std::vector<std::string> split(const std::string& s, const char* separators) {
+    std::vector<std::string> parts;
+    size_t start = 0;
+    while (start <= s.size()) {
+        const size_t end = s.find_first_of(separators, start);
+        std::string part = s.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        while (!part.empty() && isspace((unsigned char)part.back())) {
+            part.pop_back();
+        }
+        while (!part.empty() && isspace((unsigned char)part.front())) {
+            part.erase(0, 1);
+        }
+        if (!part.empty()) {
+            parts.push_back(part);
+        }
+        if (end == std::string::npos) {
+            break;
+        }
+        start = end + 1;
+    }
+    return parts;
+}
+
+/**
+ * @brief 读入一段录制：表头 timestamp + 轴名，按模型的融合轴取列（不区分大小写）
+ */
+static bool append_recording(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (f == nullptr) {
+        printf("  cannot open %s\n", path);
+        return false;
+    }
+    char line[1024];
+    std::vector<std::string> header = fgets(line, sizeof(line), f) ? split(line, ",\r\n") : std::vector<std::string>();
+    int columns[kAxes];
+    const std::vector<std::string> axes = split(EI_CLASSIFIER_FUSION_AXES_STRING, "+");
+    bool ok = axes.size() == kAxes;
+    for (size_t a = 0; ok && a < kAxes; a++) {
+        columns[a] = -1;
+        for (size_t c = 1; c < header.size(); c++) {
+            if (lower(header[c]) == lower(axes[a])) {
+                columns[a] = (int)c;
+            }
+        }
+        ok = columns[a] >= 0;
+    }
+    if (!ok) {
+        printf("  %s lacks the model axes (%s)\n", path, EI_CLASSIFIER_FUSION_AXES_STRING);
+        fclose(f);
+        return false;
+    }
+    size_t frames = 0;
+    while (fgets(line, sizeof(line), f)) {
+        const std::vector<std::string> fields = split(line, ",\r\n");
+        if (fields.size() < header.size()) {
+            continue;
+        }
+        for (size_t a = 0; a < kAxes; a++) {
+            g_frames.push_back(strtof(fields[columns[a]].c_str(), nullptr));
+        }
+        frames++;
+    }
+    fclose(f);
+    printf("  %s: %u frames\n", path, (unsigned)frames);
+    return true;
+}
+
+/**
+ * @brief 读入会话语料中的全部会话：按模型的融合轴取列（accX..gyrZ 即通道 0..5），样本从 LSB 换算回物理单位
+ */
+static bool append_session_corpus(const char* path) {
+    static const char* const kChannelNames[SESSION_CORPUS_CHANNELS] = {"accx", "accy", "accz", "gyrx", "gyry", "gyrz"};
+    session_corpus_t corpus;
+    if (!session_corpus_open(path, &corpus)) {
+        return false;
+    }
+    const std::vector<std::string> axes = split(EI_CLASSIFIER_FUSION_AXES_STRING, "+");
+    size_t channels[kAxes];
+    bool ok = axes.size() == kAxes;
+    for (size_t a = 0; ok && a < kAxes; a++) {
+        channels[a] = SESSION_CORPUS_CHANNELS;
+        for (size_t c = 0; c < SESSION_CORPUS_CHANNELS; c++) {
+            if (lower(axes[a]) == kChannelNames[c]) {
+                channels[a] = c;
+            }
+        }
+        ok = channels[a] < SESSION_CORPUS_CHANNELS;
+    }
+    size_t frames = 0;
+    uint32_t sessions = 0;
+    for (uint32_t i = 0; ok && i < session_corpus_count(&corpus); i++) {
+        session_corpus_view_t view;
+        session_corpus_session(&corpus, i, &view);
+        bool complete = true;
+        for (size_t a = 0; a < kAxes; a++) {
+            complete = complete && view.columns[channels[a]] != nullptr;
+        }
+        if (!complete) {
+            continue;
+        }
+        for (uint32_t f = 0; f < view.frames; f++) {
+            for (size_t a = 0; a < kAxes; a++) {
+                const float lsb = channels[a] < 3 ? 8192.0f : 16.384f;
+                g_frames.push_back(view.columns[channels[a]][f] / lsb);
+            }
+        }
+        frames += view.frames;
+        sessions++;
+    }
+    session_corpus_close(&corpus);
+    if (!ok || sessions == 0) {
+        printf("  %s has no session with the model axes (%s)\n", path, EI_CLASSIFIER_FUSION_AXES_STRING);
+        return false;
+    }
+    printf("  %s: %u sessions, %u frames\n", path, (unsigned)sessions, (unsigned)frames);
+    return true;
+}
+
+static bool load_corpus() {
+    g_frames.clear();
+    const char* corpus = getenv("GOLDEN_CORPUS");
+    if (corpus != nullptr && corpus[0] != '\0') {
+        for (const std::string& path : split(corpus, ":")) {
+            const bool ok = session_corpus_is_corpus(path.c_str()) ? append_session_corpus(path.c_str())
+                                                                    : append_recording(path.c_str());
+            if (!ok) {
+                return false;
+            }
+        }
+    } else {
+        printf("  GOLDEN_CORPUS not set, simulated corpus\n");
+        append_simulated(4800, 0x601D);
+    }
+    // 多段录制首尾相接，少数窗口跨段；等价性与信号内容无关，因此整体滑动
+    g_window_ends.clear();
+    const size_t total = g_frames.size() / kAxes;
+    size_t i = 0;
+    for (size_t end = kFrames; end <= total; end += kStrides[i++ % (sizeof(kStrides) / sizeof(kStrides[0]))]) {
+        g_window_ends.push_back(end);
+    }
+    return !g_window_ends.empty();
+}
+
+static void quantize_window(size_t end, int8_t* dst) {
+    float scale = 1.0f;
+    int32_t zero_point = 0;
+    model_module_get_input_quantization(&scale, &zero_point);
+    const float* src = &g_frames[(end - kFrames) * kAxes];
+    for (size_t i = 0; i < kValues; i++) {
+        // 与 inference_module 的 quantize_samples 相同
+        const int32_t q = (int32_t)lroundf(src[i] / scale) + zero_point;
+        dst[i] = (int8_t)(q < -128 ? -128 : (q > 127 ? 127 : q));
+    }
+}
+
+// ==================== 路径 ====================
+
+/**
+ * @brief 参考路径：run_classifier 对浮点窗口推理。跳过 softmax 改变编译图，因此在任何优化路径初始化之前运行
+ */
+static void compute_reference() {
+    g_reference.assign(g_window_ends.size(), scores_t());
+    const double start = now_us();
+    for (size_t w = 0; w < g_window_ends.size(); w++) {
+        signal_t signal;
+        numpy::signal_from_buffer(&g_frames[(g_window_ends[w] - kFrames) * kAxes], kValues, &signal);
+        ei_impulse_result_t result;
+        memset(&result, 0, sizeof(result));
+        if (run_classifier(&signal, &result, false) != EI_IMPULSE_OK) {
+            g_reference.clear();
+            return;
+        }
+        for (size_t c = 0; c < kLabels; c++) {
+            g_reference[w].p[c] = result.classification[c].value;
+        }
+    }
+    g_reference_us = (now_us() - start) / g_window_ends.size();
+    run_classifier_deinit();
+}
+
+struct comparison_t {
+    float max_delta;
+    size_t near_ties;   // 参考路径前两名差距不超过容差、获胜类别允许不同的窗口
+    size_t mismatches;  // 获胜类别不同的其余窗口
+};
+
+static void compare(const scores_t& reference, const float* scores, comparison_t* out) {
+    for (size_t c = 0; c < kLabels; c++) {
+        const float delta = fabsf(scores[c] - reference.p[c]);
+        out->max_delta = delta > out->max_delta ? delta : out->max_delta;
+    }
+    if (argmax(scores) != argmax(reference.p)) {
+        if (top_margin(reference.p) <= GOLDEN_MAX_SCORE_DELTA) {
+            out->near_ties++;
+        } else {
+            out->mismatches++;
+        }
+    }
+}
+
+static void report(const char* path, double us, const comparison_t& c) {
+    printf("  %-34s %8.2f us/window  %5.2fx  max |dp| %.4f  argmax mismatches %u (near ties %u)\n", path, us,
+           us > 0.0 ? g_reference_us / us : 0.0, c.max_delta, (unsigned)c.mismatches, (unsigned)c.near_ties);
+}
+
+/**
+ * @brief 按设备的方式推进环形 int8 窗口：写入新帧，返回上一次推理以来写入的值数
+ */
+struct ring_t {
+    int8_t values[kValues];
+    size_t head;
+    size_t end;  // 窗口中最新一帧之后的帧号（0 = 空）
+};
+
+static size_t ring_advance(ring_t* ring, size_t end) {
+    int8_t window[kValues];
+    quantize_window(end, window);
+    size_t new_frames = ring->end == 0 || end - ring->end >= kFrames ? kFrames : end - ring->end;
+    for (size_t f = kFrames - new_frames; f < kFrames; f++) {
+        memcpy(&ring->values[ring->head], &window[f * kAxes], kAxes);
+        ring->head = (ring->head + kAxes) % kValues;
+    }
+    ring->end = end;
+    return new_frames * kAxes;
+}
+
+void setUp() {
+    model_module_deinit();
+}
+
+void tearDown() {
+    model_module_deinit();
+}
+
+// ==================== 测试 ====================
+
+static void test_optimized_paths_match_the_reference() {
+    printf("  %u windows, reference run_classifier %.2f us/window\n", (unsigned)g_window_ends.size(), g_reference_us);
+    TEST_ASSERT_TRUE(model_module_init());
+
+    // int8 窗口上的完整图（model_module_invoke：跳过 softmax 时同样经查找表得到概率）
+    std::vector<scores_t> full(g_window_ends.size());
+    comparison_t full_cmp = {};
+    size_t input_bytes = 0;
+    int8_t* input = model_module_input_buffer(&input_bytes);
+    TEST_ASSERT_TRUE(input != nullptr && input_bytes == kValues);
+    double spent = 0.0;
+    for (size_t w = 0; w < g_window_ends.size(); w++) {
+        quantize_window(g_window_ends[w], input);
+        const double start = now_us();
+        TEST_ASSERT_TRUE(model_module_invoke(full[w].p, kLabels));
+        spent += now_us() - start;
+        compare(g_reference[w], full[w].p, &full_cmp);
+    }
+    report("int8 window, full graph", spent / g_window_ends.size(), full_cmp);
+
+    // 流式增量卷积：与完整图逐位一致
+    ring_t ring = {};
+    comparison_t stream_cmp = {};
+    model_module_stream_reset();
+    spent = 0.0;
+    size_t diverged = 0;
+    for (size_t w = 0; w < g_window_ends.size(); w++) {
+        const size_t new_values = ring_advance(&ring, g_window_ends[w]);
+        float scores[kLabels];
+        const double start = now_us();
+        TEST_ASSERT_TRUE(model_module_stream_invoke(ring.values, ring.head, new_values, scores, kLabels));
+        spent += now_us() - start;
+        compare(g_reference[w], scores, &stream_cmp);
+        diverged += memcmp(scores, full[w].p, sizeof(scores)) != 0;
+    }
+#if MODEL_SPECIALIZED_KERNELS
+    report("streaming, specialized kernels", spent / g_window_ends.size(), stream_cmp);
+#else
+    report("streaming, generic kernels", spent / g_window_ends.size(), stream_cmp);
+#endif
+    TEST_ASSERT_EQUAL_UINT32(0, diverged);
+
+    // int8 域后处理：只反量化获胜类别
+    ring = {};
+    comparison_t top_cmp = {};
+    model_module_stream_reset();
+    spent = 0.0;
+    size_t top_diverged = 0;
+    for (size_t w = 0; w < g_window_ends.size(); w++) {
+        const size_t new_values = ring_advance(&ring, g_window_ends[w]);
+        model_top_result_t top;
+        const double start = now_us();
+        TEST_ASSERT_TRUE(model_module_stream_invoke_top(ring.values, ring.head, new_values, -128, &top));
+        spent += now_us() - start;
+        // 只有获胜类别的概率：其余类别按参考值补上，差值与获胜类别只看这一项
+        scores_t scores = g_reference[w];
+        if (top.index >= 0) {
+            scores.p[top.index] = top.confidence;
+        }
+        compare(g_reference[w], scores.p, &top_cmp);
+        top_diverged += top.index != (int)argmax(full[w].p) && top_margin(full[w].p) > 0.0f;
+    }
+    report("streaming, int8 post-processing", spent / g_window_ends.size(), top_cmp);
+    TEST_ASSERT_EQUAL_UINT32(0, top_diverged);
+
+    for (const comparison_t* c : {&full_cmp, &stream_cmp, &top_cmp}) {
+        TEST_ASSERT_EQUAL_UINT32(0, c->mismatches);
+        TEST_ASSERT_TRUE(c->max_delta <= GOLDEN_MAX_SCORE_DELTA);
+    }
+}
+
+static void test_reference_is_unchanged_after_the_optimized_paths() {
+    // 优化路径释放编译图后，run_classifier 须重新得到参考结果（例如跳过 softmax 不得残留在图中）
+    TEST_ASSERT_TRUE(model_module_init());
+    TEST_ASSERT_TRUE(model_module_deinit());
+    const size_t w = g_window_ends.size() / 2;
+    signal_t signal;
+    numpy::signal_from_buffer(&g_frames[(g_window_ends[w] - kFrames) * kAxes], kValues, &signal);
+    ei_impulse_result_t result;
+    memset(&result, 0, sizeof(result));
+    TEST_ASSERT_TRUE(run_classifier(&signal, &result, false) == EI_IMPULSE_OK);
+    for (size_t c = 0; c < kLabels; c++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-6f, g_reference[w].p[c], result.classification[c].value);
+    }
+    run_classifier_deinit();
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    if (!load_corpus()) {
+        printf("  no usable corpus\n");
+        return 1;
+    }
+    compute_reference();
+    if (g_reference.empty()) {
+        printf("  reference run_classifier failed\n");
+        return 1;
+    }
+    RUN_TEST(test_optimized_paths_match_the_reference);
+    RUN_TEST(test_reference_is_unchanged_after_the_optimized_paths);
+    return UNITY_END();
+}
@@ -0,0 +1,161 @@
+// 流水线压力测试（pio test -e native）：模拟 IMU 以十倍实时喂给真实的采集 / 推理线程，
+// 另起两个线程按 BLE / LED 线程的方式消费结果事件（inference_wait_result + inference_pop_result_event），
+// 回放结束后检查：结果不丢、序列号只增不减、各级队列深度有界、采集始终跟得上
+#include <Arduino.h>
+#include <unity.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "app_config.h"
+#include "boot_module.h"
+#include "inference_module.h"
+#include "pipeline_module.h"
+#include "profiler_module.h"
+#include "replay_source.h"
+
+// 60 秒的模拟数据，十倍实时约 6 秒跑完；传感器按设备的抽取前采样率模拟
+static const float kSimulatedSeconds = 60.0f;
+static const float kSpeed = 10.0f;
+static const uint32_t kSeed = 0x5EED;
+// 预期耗时的两倍仍未跑完即判失败
+static const uint32_t kTimeoutMs = (uint32_t)(kSimulatedSeconds / kSpeed * 2000.0f);
+
+struct consumer_stats_t {
+    uint32_t events = 0;
+    uint32_t gaps = 0;          // 序列号跳过的次数（两个事件之间丢了结果）
+    uint32_t regressions = 0;   // 序列号没有递增的次数
+    uint32_t last_sequence = 0;
+};
+
+static std::atomic<bool> g_stop{false};
+static consumer_stats_t g_consumers[INFERENCE_CONSUMER_COUNT];
+static pipeline_stage_stats_t g_peaks[PIPELINE_STAGE_COUNT];
+static std::atomic<uint32_t> g_windows{0};
+
+static void on_result(const inference_result_event_t*) {
+    g_windows++;
+}
+
+/**
+ * @brief 与 BLE / LED 线程相同的取法：等通知，然后把队列取空
+ */
+static void consume(inference_consumer_t consumer) {
+    consumer_stats_t& stats = g_consumers[consumer];
+    inference_result_snapshot_t event;
+    while (!g_stop) {
+        inference_wait_result(consumer, std::chrono::milliseconds(10));
+        while (inference_pop_result_event(consumer, &event)) {
+            if (event.sequence <= stats.last_sequence) {
+                stats.regressions++;
+            } else if (event.sequence != stats.last_sequence + 1) {
+                stats.gaps++;
+            }
+            stats.last_sequence = event.sequence;
+            stats.events++;
+        }
+    }
+}
+
+/**
+ * @brief 记下各级统计窗口中的最大队列峰值与累计丢弃数
+ */
+static void collect_pipeline_stats() {
+    for (size_t i = 0; i < PIPELINE_STAGE_COUNT; i++) {
+        pipeline_stage_stats_t stats;
+        pipeline_module_get_stats((pipeline_stage_t)i, &stats);
+        if (stats.queue_peak > g_peaks[i].queue_peak) {
+            g_peaks[i].queue_peak = stats.queue_peak;
+        }
+        if (stats.queue_capacity > 0) {
+            g_peaks[i].queue_capacity = stats.queue_capacity;
+        }
+        g_peaks[i].overruns = stats.overruns;
+    }
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+static void test_runs_simulated_recording() {
+    replay_source_set_speed(kSpeed);
+    TEST_ASSERT_TRUE(replay_source_simulate(kSimulatedSeconds, (float)IMU_SENSOR_ODR_HZ, kSeed));
+    TEST_ASSERT_TRUE(inference_module_init());
+    inference_set_result_observer(on_result);
+    boot_module_mark(BOOT_SETUP_DONE);
+
+    // 采集 / 推理线程是无限循环，与回放程序一样随进程退出
+    std::thread(inference_sampler_task).detach();
+    std::thread(inference_task).detach();
+    std::thread ble(consume, INFERENCE_CONSUMER_BLE);
+    std::thread led(consume, INFERENCE_CONSUMER_LED);
+
+    const uint32_t start_ms = millis();
+    while (!(replay_source_finished() && inference_caught_up()) && millis() - start_ms < kTimeoutMs) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        collect_pipeline_stats();
+    }
+    const bool finished = replay_source_finished() && inference_caught_up();
+    // 结束最后一个统计窗口，再给消费者一点时间取空队列
+    pipeline_module_report();
+    collect_pipeline_stats();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    g_stop = true;
+    ble.join();
+    led.join();
+
+    TEST_ASSERT_TRUE_MESSAGE(finished, "pipeline did not finish the simulated recording in time");
+    uint32_t sensor_frames = 0;
+    replay_source_get_stats(&sensor_frames, nullptr, nullptr);
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)(kSimulatedSeconds * IMU_SENSOR_ODR_HZ), sensor_frames);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, g_windows.load());
+}
+
+static void test_no_lost_results() {
+    inference_result_snapshot_t last;
+    inference_get_result_snapshot(&last);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, last.sequence);
+    for (size_t i = 0; i < INFERENCE_CONSUMER_COUNT; i++) {
+        const inference_consumer_t consumer = (inference_consumer_t)i;
+        TEST_ASSERT_EQUAL_UINT32(0, inference_result_event_overruns(consumer));
+        TEST_ASSERT_EQUAL_UINT32(0, g_consumers[i].gaps);
+        TEST_ASSERT_EQUAL_UINT32(last.sequence, g_consumers[i].events);
+        TEST_ASSERT_EQUAL_UINT32(last.sequence, g_consumers[i].last_sequence);
+    }
+}
+
+static void test_no_sequence_regressions() {
+    for (size_t i = 0; i < INFERENCE_CONSUMER_COUNT; i++) {
+        TEST_ASSERT_EQUAL_UINT32(0, g_consumers[i].regressions);
+    }
+}
+
+static void test_queue_depths_bounded() {
+    for (size_t i = 0; i < PIPELINE_STAGE_COUNT; i++) {
+        const pipeline_stage_stats_t& peak = g_peaks[i];
+        if (peak.queue_capacity == 0) {
+            continue;
+        }
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, peak.overruns, pipeline_module_stage_name((pipeline_stage_t)i));
+        // 十倍实时下任何一级的输入队列都不应接近填满
+        TEST_ASSERT_LESS_THAN_UINT32_MESSAGE(peak.queue_capacity, 2u * peak.queue_peak + 1u,
+                                             pipeline_module_stage_name((pipeline_stage_t)i));
+    }
+}
+
+int main(int, char**) {
+    profiler_module_init();
+    UNITY_BEGIN();
+    // 后面几项检查的都是这一次运行收集到的统计
+    RUN_TEST(test_runs_simulated_recording);
+    RUN_TEST(test_no_lost_results);
+    RUN_TEST(test_no_sequence_regressions);
+    RUN_TEST(test_queue_depths_bounded);
+    const int failures = UNITY_END();
+    fflush(stdout);
+    fflush(stderr);
+    // 不执行静态析构：推理线程仍在使用模型和队列
+    _Exit(failures);
+}
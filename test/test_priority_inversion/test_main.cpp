@@ -0,0 +1,187 @@
+// 优先级反转压力测试（pio test -e native）：按目标上的相对优先级以实时调度运行真实的采集 / 推理线程，
+// 全部线程绑定到同一个 CPU（与单核 MCU 一样，高优先级线程就绪时低优先级线程不运行）。
+// 低优先级的"BLE"线程反复调用 BLE 线程使用的持锁接口，并在共享状态锁内唤醒中优先级的负载线程
+// （如同协议栈事件唤醒另一个线程），负载线程立即抢占它并空转一段时间。锁带优先级继承时，推理线程等锁期间
+// 持锁的读者被提升到推理线程的优先级、负载不能抢占它，最长等待（inference_get_lock_stats）只是读者临界区的长度，
+// 须在 INFERENCE_LOCK_WAIT_BUDGET_US 之内；没有优先级继承时推理线程要等负载空转完，判定失败。
+// 设置实时优先级需要 root 或 CAP_SYS_NICE：没有权限时照常运行并报告测得的等待，预算判定被忽略
+#include <Arduino.h>
+#include <unity.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "app_config.h"
+#include "boot_module.h"
+#include "inference_module.h"
+#include "profiler_module.h"
+#include "replay_source.h"
+
+// 20 秒的模拟数据按四倍实时回放
+static const float kSimulatedSeconds = 20.0f;
+static const float kSpeed = 4.0f;
+static const uint32_t kSeed = 0x1A7E;
+static const uint32_t kTimeoutMs = (uint32_t)(kSimulatedSeconds / kSpeed * 3000.0f);
+
+// 实时优先级（SCHED_FIFO，数值越大越优先），相对顺序与 app_config.h 的线程表一致
+static const int kMainPriority = 50;
+static const int kSamplerPriority = 40;
+static const int kInferencePriority = 30;
+static const int kLoadPriority = 20;
+static const int kReaderPriority = 10;
+
+// 负载线程每次被唤醒空转 3 ms；读者每次在锁内停留 50 us（远大于真实读者只复制几个字段的时间）
+static const std::chrono::microseconds kLoadBusy(3000);
+static const std::chrono::microseconds kReaderHold(50);
+static const std::chrono::microseconds kReaderPeriod(500);
+
+static std::atomic<bool> g_stop{false};
+static std::atomic<bool> g_realtime{true};
+static std::atomic<uint32_t> g_reader_passes{0};
+static bool g_finished = false;
+// 读者唤醒负载线程
+static std::mutex g_load_mutex;
+static std::condition_variable g_load_wake;
+static bool g_load_pending = false;
+
+static void spin_for(std::chrono::microseconds duration) {
+    const auto end = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < end) {
+    }
+}
+
+/**
+ * @brief 把调用线程设为给定的实时优先级；没有权限时记下并以普通调度继续
+ */
+static void set_priority(int priority) {
+    sched_param param = {};
+    param.sched_priority = priority;
+    if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0) {
+        g_realtime = false;
+    }
+}
+
+/**
+ * @brief 与 BLE 线程相同的持锁读取，外加一段较长的临界区（读者在锁内被抢占的窗口）
+ */
+static void reader() {
+    set_priority(kReaderPriority);
+    inference_result_snapshot_t event;
+    while (!g_stop) {
+        while (inference_pop_result_event(INFERENCE_CONSUMER_BLE, &event)) {
+        }
+        inference_gesture_event_t gesture;
+        inference_get_gesture_event(&gesture, nullptr);
+        inference_scheduler_stats_t scheduler;
+        inference_get_scheduler_stats(&scheduler);
+        inference_get_benchmark(nullptr);
+        inference_model_stats_t model;
+        inference_get_model_stats(0, &model);
+
+        // 人为的长临界区直接持有共享状态锁（接口已弃用，只在这里用来制造争用）
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+        hal::Mutex& mutex = inference_get_mutex();
+#pragma GCC diagnostic pop
+        mutex.lock();
+        {
+            std::lock_guard<std::mutex> lock(g_load_mutex);
+            g_load_pending = true;
+        }
+        // 优先级更高的负载线程在这里抢占持锁的读者
+        g_load_wake.notify_one();
+        spin_for(kReaderHold);
+        mutex.unlock();
+        g_reader_passes++;
+        std::this_thread::sleep_for(kReaderPeriod);
+    }
+    std::lock_guard<std::mutex> lock(g_load_mutex);
+    g_load_pending = true;
+    g_load_wake.notify_one();
+}
+
+static void load() {
+    set_priority(kLoadPriority);
+    while (!g_stop) {
+        {
+            std::unique_lock<std::mutex> lock(g_load_mutex);
+            g_load_wake.wait(lock, [] { return g_load_pending; });
+            g_load_pending = false;
+        }
+        spin_for(kLoadBusy);
+    }
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+static void test_runs_under_load() {
+    // 单核：之后创建的线程继承这一绑定
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(0, &cpus);
+    sched_setaffinity(0, sizeof(cpus), &cpus);
+    set_priority(kMainPriority);
+
+    replay_source_set_speed(kSpeed);
+    TEST_ASSERT_TRUE(replay_source_simulate(kSimulatedSeconds, (float)IMU_SENSOR_ODR_HZ, kSeed));
+    TEST_ASSERT_TRUE(inference_module_init());
+    boot_module_mark(BOOT_SETUP_DONE);
+
+    // 采集 / 推理线程是无限循环，与回放程序一样随进程退出
+    std::thread([] {
+        set_priority(kSamplerPriority);
+        inference_sampler_task();
+    }).detach();
+    std::thread([] {
+        set_priority(kInferencePriority);
+        inference_task();
+    }).detach();
+    std::thread load_thread(load);
+    std::thread reader_thread(reader);
+
+    const uint32_t start_ms = millis();
+    while (!(replay_source_finished() && inference_caught_up()) && millis() - start_ms < kTimeoutMs) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    g_finished = replay_source_finished() && inference_caught_up();
+    g_stop = true;
+    load_thread.join();
+    reader_thread.join();
+
+    TEST_ASSERT_TRUE_MESSAGE(g_finished, "pipeline did not finish the simulated recording in time");
+    TEST_ASSERT_GREATER_THAN_UINT32(0, g_reader_passes.load());
+}
+
+static void test_inference_lock_wait_within_budget() {
+    inference_lock_stats_t stats;
+    inference_get_lock_stats(&stats);
+    printf("[Test] inference lock: %lu acquisitions, %lu waited, max %lu us, total %lu us (budget %u us)\n",
+           (unsigned long)stats.acquisitions, (unsigned long)stats.contended, (unsigned long)stats.max_wait_us,
+           (unsigned long)stats.total_wait_us, (unsigned)INFERENCE_LOCK_WAIT_BUDGET_US);
+    if (!g_realtime) {
+        TEST_IGNORE_MESSAGE("no real-time scheduling (needs root or CAP_SYS_NICE), wait not judged");
+    }
+    // 读者确实与推理线程争用过锁，判定才有意义
+    TEST_ASSERT_GREATER_THAN_UINT32(0, stats.contended);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(INFERENCE_LOCK_WAIT_BUDGET_US, stats.max_wait_us);
+}
+
+int main(int, char**) {
+    profiler_module_init();
+    UNITY_BEGIN();
+    RUN_TEST(test_runs_under_load);
+    RUN_TEST(test_inference_lock_wait_within_budget);
+    const int failures = UNITY_END();
+    fflush(stdout);
+    fflush(stderr);
+    // 不执行静态析构：推理线程仍在使用模型和队列
+    _Exit(failures);
+}
@@ -0,0 +1,157 @@
+// 连接事件时序学习与推理放置（pio test -e native）：模拟 7.5 ms 连接间隔、每个事件约 1.5 ms 的射频活动，
+// 检查学习、漂移跟随与重新学习，并按放置的决定模拟推理被射频中断拉长的耗时，放置后的 p99 须低于原地运行
+#include <unity.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+#include "radio_gap.h"
+
+static const uint32_t kIntervalUs = 7500;
+static const uint32_t kEventUs = 1500;
+static const uint32_t kGuardUs = 500;
+static const uint32_t kMaxDeferUs = 10000;
+static const uint32_t kBusyUs = 4000;
+
+/**
+ * @brief 喂入一个连接事件：从 start 开始的三次收发，最后一次在 start + length 结束
+ */
+static void feed_event(RadioGapPredictor* predictor, uint32_t start, uint32_t length) {
+    const uint32_t packet = length / 3;
+    for (uint32_t i = 0; i < 3; i++) {
+        predictor->on_radio_start(start + i * packet);
+        predictor->on_radio_end(start + (i + 1) * packet - 150);
+    }
+}
+
+/**
+ * @brief 在 [start, start + busy) 中运行的推理被连接事件中断后的耗时（事件期间 CPU 让给链路层）
+ */
+static uint32_t stretched(uint32_t start, uint32_t busy, uint32_t first_event) {
+    uint32_t end = start + busy;
+    for (uint32_t event = first_event; event < end; event += kIntervalUs) {
+        const uint32_t event_end = event + kEventUs;
+        if (event_end > start) {
+            end += event_end - std::max(event, start);
+        }
+    }
+    return end - start;
+}
+
+static uint32_t p99(std::vector<uint32_t> samples) {
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() * 99 / 100];
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+static void test_learns_interval_and_event_length() {
+    RadioGapPredictor predictor;
+    TEST_ASSERT_FALSE(predictor.locked(0));
+    const uint32_t base = 1000000;
+    for (uint32_t i = 0; i < 4; i++) {
+        feed_event(&predictor, base + i * kIntervalUs, kEventUs);
+    }
+    const uint32_t now = base + 3 * kIntervalUs + 2000;
+    TEST_ASSERT_TRUE(predictor.locked(now));
+    TEST_ASSERT_EQUAL_UINT32(kIntervalUs, predictor.interval_us());
+    TEST_ASSERT_UINT32_WITHIN(200, kEventUs, predictor.event_us());
+    // 长时间没有射频活动（断开连接）：失去时序
+    TEST_ASSERT_FALSE(predictor.locked(now + RadioGapPredictor::kMaxSkipped * kIntervalUs));
+}
+
+static void test_skipped_events_and_drift() {
+    RadioGapPredictor predictor;
+    uint32_t t = 50000;
+    feed_event(&predictor, t, kEventUs);
+    t += kIntervalUs;
+    feed_event(&predictor, t, kEventUs);
+    // 外设延迟跳过两个事件，间隔按 3 倍取整后仍然一致
+    t += 3 * kIntervalUs;
+    feed_event(&predictor, t, kEventUs);
+    TEST_ASSERT_EQUAL_UINT32(kIntervalUs, predictor.interval_us());
+    // 对端时钟稍快：估计逐步跟上
+    for (int i = 0; i < 40; i++) {
+        t += kIntervalUs + 40;
+        feed_event(&predictor, t, kEventUs);
+    }
+    TEST_ASSERT_UINT32_WITHIN(5, kIntervalUs + 40, predictor.interval_us());
+    // 连接参数更新为 20 ms：连续几次对不上之后改用新间隔
+    // （更新为原间隔的整数倍时与跳过事件无法区分，预测的多余事件只会让推理偶尔多推迟一次）
+    for (int i = 0; i < 6; i++) {
+        t += 20000;
+        feed_event(&predictor, t, kEventUs);
+    }
+    TEST_ASSERT_EQUAL_UINT32(20000, predictor.interval_us());
+}
+
+static void test_decide_places_around_events() {
+    RadioGapPredictor predictor;
+    const uint32_t base = 200000;
+    for (uint32_t i = 0; i < 4; i++) {
+        feed_event(&predictor, base + i * kIntervalUs, kEventUs);
+    }
+    const uint32_t anchor = base + 3 * kIntervalUs;
+    const uint32_t quiet = anchor + predictor.event_us() + kGuardUs;
+    // 事件刚结束：空隙放得下
+    radio_gap_decision_t d = predictor.decide(quiet + 100, kBusyUs, kGuardUs, kMaxDeferUs);
+    TEST_ASSERT_EQUAL(RADIO_GAP_FITS, d.kind);
+    // 仍在事件中：推迟到事件结束之后
+    d = predictor.decide(anchor + 200, kBusyUs, kGuardUs, kMaxDeferUs);
+    TEST_ASSERT_EQUAL(RADIO_GAP_DEFER, d.kind);
+    TEST_ASSERT_EQUAL_UINT32(quiet, anchor + 200 + d.defer_us);
+    // 空隙剩下的不够：推迟到下一个事件之后
+    d = predictor.decide(anchor + 5000, kBusyUs, kGuardUs, kMaxDeferUs);
+    TEST_ASSERT_EQUAL(RADIO_GAP_DEFER, d.kind);
+    TEST_ASSERT_EQUAL_UINT32(quiet + kIntervalUs, anchor + 5000 + d.defer_us);
+    // 推迟超过上限、推理比空隙还长：原地运行
+    d = predictor.decide(anchor + 5000, kBusyUs, kGuardUs, 1000);
+    TEST_ASSERT_EQUAL(RADIO_GAP_NO_FIT, d.kind);
+    d = predictor.decide(quiet, kIntervalUs, kGuardUs, kMaxDeferUs);
+    TEST_ASSERT_EQUAL(RADIO_GAP_NO_FIT, d.kind);
+    TEST_ASSERT_EQUAL_UINT32(0, d.defer_us);
+}
+
+static void test_placement_lowers_p99() {
+    RadioGapPredictor predictor;
+    const uint32_t base = 10000;
+    uint32_t next_event = base;
+    std::vector<uint32_t> placed;
+    std::vector<uint32_t> unplaced;
+    srand(0x5EED);
+    // 推理在随机时刻就绪（窗口步长与连接间隔无关）
+    uint32_t now = base + 4 * kIntervalUs;
+    for (int i = 0; i < 2000; i++) {
+        now += 9000 + (uint32_t)(rand() % 7000);
+        while (next_event <= now) {
+            feed_event(&predictor, next_event, kEventUs - (uint32_t)(rand() % 300));
+            next_event += kIntervalUs;
+        }
+        const uint32_t first_event = next_event - kIntervalUs;
+        unplaced.push_back(stretched(now, kBusyUs, first_event));
+        const radio_gap_decision_t d = predictor.decide(now, kBusyUs, kGuardUs, kMaxDeferUs);
+        TEST_ASSERT_TRUE(d.kind != RADIO_GAP_UNTIMED);
+        placed.push_back(stretched(now + d.defer_us, kBusyUs, first_event));
+    }
+    const uint32_t placed_p99 = p99(placed);
+    const uint32_t unplaced_p99 = p99(unplaced);
+    printf("[Test] invoke p99: %lu us placed, %lu us unplaced\n", (unsigned long)placed_p99,
+           (unsigned long)unplaced_p99);
+    // 放进空隙的推理不被中断
+    TEST_ASSERT_EQUAL_UINT32(kBusyUs, placed_p99);
+    TEST_ASSERT_GREATER_THAN_UINT32(placed_p99, unplaced_p99);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_learns_interval_and_event_length);
+    RUN_TEST(test_skipped_events_and_drift);
+    RUN_TEST(test_decide_places_around_events);
+    RUN_TEST(test_placement_lowers_p99);
+    return UNITY_END();
+}
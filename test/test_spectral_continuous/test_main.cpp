@@ -0,0 +1,211 @@
+// 增量频谱分析块（pio test -e native）：逐片段送入 extract_spectral_analysis_per_slice_features /
+// continuous_spectral_analysis，每次都与对同一窗口运行的整窗 extract_spectral_analysis_features 比较。
+// 当前模型只有原始特征块，这里用手写的频谱分析配置
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "edge-impulse-sdk/classifier/ei_run_classifier.h"
+
+using ei::spectral::continuous_spectral_analysis;
+
+static const size_t kAxes = 3;
+static const float kFrequency = 50.0f;
+
+/**
+ * @brief 频谱分析配置：FFT、版本 2，默认不滤波
+ */
+static ei_dsp_config_spectral_analysis_t make_config(size_t fft_length, bool overlap, bool do_log) {
+    ei_dsp_config_spectral_analysis_t config = {
+        1, 2, (int)kAxes, 1.0f, 1, "none", 0.0f, 0, "FFT", (int)fft_length, 3, 0.1f, "0.1, 0.5, 1.0",
+        do_log, overlap, 1, "haar", false,
+    };
+    return config;
+}
+
+/**
+ * @brief 模拟三轴信号：每轴一个正弦加噪声，第二轴另有 1 g 的偏置（检验均值处理）
+ */
+static std::vector<float> make_stream(size_t frames, uint32_t seed) {
+    std::vector<float> stream(frames * kAxes);
+    srand(seed);
+    for (size_t f = 0; f < frames; f++) {
+        const float t = (float)f / kFrequency;
+        for (size_t a = 0; a < kAxes; a++) {
+            const float noise = ((float)rand() / (float)RAND_MAX - 0.5f) * 0.2f;
+            stream[f * kAxes + a] = sinf(2.0f * (float)M_PI * (2.0f + 3.0f * a) * t) * (0.5f + 0.2f * a) +
+                                    (a == 1 ? 1.0f : 0.0f) + noise;
+        }
+    }
+    return stream;
+}
+
+/**
+ * @brief 每轴 RMS / 偏度 / 峰度加上滤波器截止频率以内的频谱 bin
+ */
+static size_t feature_count(const ei_dsp_config_spectral_analysis_t* config) {
+    size_t start_bin = 1;
+    size_t stop_bin = config->fft_length / 2 + 1;
+    if (strcmp(config->filter_type, "none") != 0) {
+        ei::spectral::feature::get_start_stop_bin(kFrequency, config->fft_length, config->filter_cutoff, &start_bin,
+                                                  &stop_bin, strcmp(config->filter_type, "high") == 0);
+    }
+    return kAxes * (3 + stop_bin - start_bin);
+}
+
+/**
+ * @brief 对 stream 中结束于 end_frame 的窗口运行整窗频谱分析
+ */
+static std::vector<float> batch_features(const std::vector<float>& stream, size_t end_frame, size_t window,
+                                         ei_dsp_config_spectral_analysis_t* config, size_t n_features) {
+    std::vector<float> data(stream.begin() + (end_frame - window) * kAxes, stream.begin() + end_frame * kAxes);
+    signal_t signal;
+    numpy::signal_from_buffer(data.data(), data.size(), &signal);
+    std::vector<float> out(n_features);
+    matrix_t features(1, n_features, out.data());
+    TEST_ASSERT_TRUE(extract_spectral_analysis_features(&signal, &features, config, kFrequency) == EIDSP_OK);
+    return out;
+}
+
+static void assert_features_close(const std::vector<float>& expected, const float* actual) {
+    for (size_t i = 0; i < expected.size(); i++) {
+        const float tolerance = 1e-3f * (1.0f + fabsf(expected[i]));
+        TEST_ASSERT_FLOAT_WITHIN(tolerance, expected[i], actual[i]);
+    }
+}
+
+/**
+ * @brief 按 slice 帧一片地推入 continuous_spectral_analysis，窗口满后每片都与整窗结果比较
+ * @param first_window_only 只比较第一个完整窗口（滤波器从窗口起点开始时两者才一致）
+ */
+static void run_against_batch(ei_dsp_config_spectral_analysis_t* config, size_t window, size_t slice,
+                              bool expect_incremental, bool first_window_only) {
+    const size_t n_features = feature_count(config);
+    const std::vector<float> stream = make_stream(window * 4, 0xF00D);
+    continuous_spectral_analysis state;
+    TEST_ASSERT_TRUE(state.configure(config, kFrequency, window) == EIDSP_OK);
+    TEST_ASSERT_TRUE(state.incremental() == expect_incremental);
+
+    std::vector<float> out(n_features);
+    matrix_t features(1, n_features, out.data());
+    size_t compared = 0;
+    for (size_t frame = 0; frame + slice <= stream.size() / kAxes; frame += slice) {
+        signal_t signal;
+        numpy::signal_from_buffer(const_cast<float*>(stream.data()) + frame * kAxes, slice * kAxes, &signal);
+        TEST_ASSERT_TRUE(state.push(&signal) == EIDSP_OK);
+        if (!state.window_full()) {
+            continue;
+        }
+        TEST_ASSERT_TRUE(state.extract(&features) == EIDSP_OK);
+        assert_features_close(batch_features(stream, frame + slice, window, config, n_features), out.data());
+        compared++;
+        if (first_window_only) {
+            break;
+        }
+    }
+    TEST_ASSERT_GREATER_THAN_UINT32(0, compared);
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+static void test_matches_batch_with_overlap() {
+    ei_dsp_config_spectral_analysis_t config = make_config(16, true, false);
+    run_against_batch(&config, 64, 8, true, false);
+}
+
+static void test_matches_batch_with_log_and_no_overlap() {
+    ei_dsp_config_spectral_analysis_t config = make_config(16, false, true);
+    run_against_batch(&config, 64, 16, true, false);
+}
+
+static void test_unaligned_slices_fall_back_to_the_window() {
+    ei_dsp_config_spectral_analysis_t config = make_config(16, true, false);
+    run_against_batch(&config, 64, 5, true, false);
+}
+
+static void test_filter_matches_batch_on_the_first_window() {
+    // 第一个窗口上两者的滤波器都从零状态起步；之后增量版本的滤波器连续运行，不再与整窗结果逐值一致
+    ei_dsp_config_spectral_analysis_t config = make_config(16, true, false);
+    config.filter_type = "low";
+    config.filter_cutoff = 8.0f;
+    config.filter_order = 4;
+    run_against_batch(&config, 64, 8, true, true);
+}
+
+static void test_other_versions_are_not_incremental() {
+    ei_dsp_config_spectral_analysis_t config = make_config(16, true, false);
+    config.implementation_version = 4;
+    TEST_ASSERT_TRUE(!continuous_spectral_analysis::supports(&config, 64));
+    config.implementation_version = 3;
+    config.analysis_type = "Wavelet";
+    TEST_ASSERT_TRUE(!continuous_spectral_analysis::supports(&config, 64));
+    config = make_config(16, true, false);
+    // 窗口不是 Welch 步长的整数倍
+    TEST_ASSERT_TRUE(!continuous_spectral_analysis::supports(&config, 60));
+}
+
+static void test_per_slice_features_fill_the_window_first() {
+    // run_classifier_continuous 使用的入口：窗口为 EI_CLASSIFIER_RAW_SAMPLE_COUNT 帧
+    const size_t window = EI_CLASSIFIER_RAW_SAMPLE_COUNT;
+    const size_t slice = EI_CLASSIFIER_SLICE_SIZE;
+    ei_dsp_config_spectral_analysis_t config = make_config(8, true, false);
+    const size_t n_features = feature_count(&config);
+    const std::vector<float> stream = make_stream(window * 3, 0xBEEF);
+    ei_dsp_clear_continuous_audio_state();
+
+    std::vector<float> out(n_features);
+    matrix_t features(1, n_features, out.data());
+    for (size_t frame = 0; frame + slice <= stream.size() / kAxes; frame += slice) {
+        signal_t signal;
+        numpy::signal_from_buffer(const_cast<float*>(stream.data()) + frame * kAxes, slice * kAxes, &signal);
+        matrix_size_t written;
+        TEST_ASSERT_TRUE(extract_spectral_analysis_per_slice_features(&signal, &features, &config, kFrequency,
+                                                                      &written) == EIDSP_OK);
+        if (frame + slice < window) {
+            TEST_ASSERT_EQUAL_UINT32(0, written.rows * written.cols);
+            continue;
+        }
+        TEST_ASSERT_EQUAL_UINT32(n_features, written.rows * written.cols);
+        assert_features_close(batch_features(stream, frame + slice, window, &config, n_features), out.data());
+    }
+    ei_dsp_clear_continuous_audio_state();
+}
+
+static void test_cached_fft_plans_match_a_direct_dft() {
+    // 同一长度第二次起复用缓存的计划；24 不是 2 的幂，走 kissfft；满帧与补零两种输入
+    const size_t lengths[] = {16, 24, 16, 24};
+    for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+        const size_t n_fft = lengths[l];
+        const size_t src_size = l < 2 ? n_fft : n_fft - 5;
+        const std::vector<float> src = make_stream(n_fft, 0xF17 + l);
+        std::vector<ei::fft_complex_t> out(n_fft / 2 + 1);
+        TEST_ASSERT_TRUE(numpy::rfft(src.data(), src_size, out.data(), out.size(), n_fft) == EIDSP_OK);
+        for (size_t k = 0; k < out.size(); k++) {
+            double re = 0.0, im = 0.0;
+            for (size_t i = 0; i < src_size; i++) {
+                re += src[i] * cos(2.0 * M_PI * k * i / n_fft);
+                im -= src[i] * sin(2.0 * M_PI * k * i / n_fft);
+            }
+            TEST_ASSERT_FLOAT_WITHIN(1e-3f, (float)re, out[k].r);
+            TEST_ASSERT_FLOAT_WITHIN(1e-3f, (float)im, out[k].i);
+        }
+    }
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_matches_batch_with_overlap);
+    RUN_TEST(test_matches_batch_with_log_and_no_overlap);
+    RUN_TEST(test_unaligned_slices_fall_back_to_the_window);
+    RUN_TEST(test_filter_matches_batch_on_the_first_window);
+    RUN_TEST(test_other_versions_are_not_incremental);
+    RUN_TEST(test_per_slice_features_fill_the_window_first);
+    RUN_TEST(test_cached_fft_plans_match_a_direct_dft);
+    return UNITY_END();
+}
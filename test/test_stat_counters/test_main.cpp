@@ -0,0 +1,147 @@
+// 无锁统计与统计注册表（pio test -e native）：多线程同时更新时计数不丢失，直方图取出清零不丢样本，
+// 分位数草图的相对误差在界内，注册表的线上记录与 wire_schema.h 一致
+#include <unity.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include "stat_counters.h"
+#include "stats_module.h"
+#include "wire_schema.h"
+
+static const int kThreads = 4;
+static const uint32_t kPerThread = 200000;
+
+void setUp() {}
+void tearDown() {}
+
+static void test_concurrent_updates_are_exact() {
+    StatCounter counter;
+    StatMax high_water;
+    StatHistogram<16> histogram(100);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([&, t] {
+            for (uint32_t i = 0; i < kPerThread; i++) {
+                counter.add();
+                high_water.observe(i * kThreads + (uint32_t)t);
+                histogram.record(i % 2000);
+            }
+        });
+    }
+    // 记录期间周期性取出：每个样本恰好落在某一次取出中
+    uint32_t taken = 0;
+    for (int round = 0; round < 50; round++) {
+        StatBins<16> bins;
+        histogram.take(&bins);
+        taken += bins.count;
+        std::this_thread::yield();
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    StatBins<16> rest;
+    histogram.take(&rest);
+    TEST_ASSERT_EQUAL_UINT32(kThreads * kPerThread, counter.value());
+    TEST_ASSERT_EQUAL_UINT32(kThreads * kPerThread, taken + rest.count);
+    TEST_ASSERT_EQUAL_UINT32(kThreads * kPerThread - 1, high_water.value());
+    TEST_ASSERT_EQUAL_UINT32(kThreads * kPerThread, counter.take());
+    TEST_ASSERT_EQUAL_UINT32(0, counter.value());
+}
+
+static void test_histogram_percentiles() {
+    StatHistogram<8> histogram(10);
+    for (uint32_t v = 0; v < 100; v++) {
+        histogram.record(v < 90 ? v % 30 : 500);
+    }
+    StatBins<8> bins;
+    histogram.snapshot(&bins);
+    TEST_ASSERT_EQUAL_UINT32(100, bins.count);
+    TEST_ASSERT_EQUAL_UINT32(20, bins.percentile(0.50f));
+    TEST_ASSERT_EQUAL_UINT32(500, bins.percentile(0.95f));  // 溢出桶以最大值代替
+    TEST_ASSERT_EQUAL_UINT32(10, bins.count_at_least(70));
+    // 直接在原子桶上取的分位数与副本相同；按批记录等同于逐个记录
+    TEST_ASSERT_EQUAL_UINT32(bins.percentile(0.50f), histogram.percentile(0.50f));
+    TEST_ASSERT_EQUAL_UINT32(bins.percentile(0.95f), histogram.percentile(0.95f));
+    histogram.record(15, 20);
+    TEST_ASSERT_EQUAL_UINT32(120, histogram.count());
+    TEST_ASSERT_EQUAL_UINT32(500, histogram.max());
+    histogram.reset();
+    TEST_ASSERT_EQUAL_UINT32(0, histogram.count());
+    TEST_ASSERT_EQUAL_UINT32(0, histogram.percentile(0.50f));
+}
+
+static void test_quantile_sketch_error_is_bounded() {
+    StatQuantile<> sketch;
+    std::vector<uint32_t> values;
+    uint32_t state = 12345;
+    for (int i = 0; i < 50000; i++) {
+        state = state * 1664525u + 1013904223u;
+        // 对数均匀地覆盖 1 µs ~ 1 s
+        const uint32_t value = 1u << (state >> 27) % 20;
+        const uint32_t jittered = value + (state & 0xFFFF) % value;
+        values.push_back(jittered);
+        sketch.record(jittered);
+    }
+    std::sort(values.begin(), values.end());
+    const float quantiles[] = {0.5f, 0.9f, 0.99f};
+    for (float p : quantiles) {
+        const float exact = (float)values[(size_t)(values.size() * p)];
+        const float estimate = (float)sketch.quantile(p);
+        TEST_ASSERT_FLOAT_WITHIN(exact * 0.0625f + 1.0f, exact, estimate);
+    }
+    TEST_ASSERT_EQUAL_UINT32(values.back(), sketch.max());
+    for (uint32_t v = 0; v < 8; v++) {
+        TEST_ASSERT_EQUAL_UINT32(v, StatQuantile<>::bin_middle(StatQuantile<>::bin_of(v)));
+    }
+    TEST_ASSERT_EQUAL(StatQuantile<>::kBins - 1, StatQuantile<>::bin_of(0xFFFFFFFFu));
+}
+
+static StatCounter g_counter;
+static StatQuantile<> g_sketch;
+
+static void test_registry_encodes_wire_records() {
+    const size_t first = stats_module_count();
+    stats_module_register("test.counter", &g_counter);
+    stats_module_register("test.a_very_long_statistic_name", &g_sketch);
+    TEST_ASSERT_EQUAL(first + 2, stats_module_count());
+    g_counter.add(7);
+    for (int i = 0; i < 3; i++) {
+        g_sketch.record(5);  // 小于 2^kSubBits 的值精确
+    }
+    g_sketch.record(1000);
+
+    uint8_t buffer[64];
+    size_t length = stats_module_encode(first, buffer, sizeof(buffer));
+    TEST_ASSERT_EQUAL(sizeof(wire_stat_t) + strlen("test.counter") + 4, length);
+    const wire_stat_t* header = reinterpret_cast<const wire_stat_t*>(buffer);
+    TEST_ASSERT_EQUAL(first, header->index);
+    TEST_ASSERT_EQUAL(first + 2, header->count);
+    TEST_ASSERT_EQUAL(STAT_KIND_COUNTER, header->kind);
+    TEST_ASSERT_EQUAL_MEMORY("test.counter", buffer + sizeof(wire_stat_t), header->name_length);
+    uint32_t value;
+    memcpy(&value, buffer + length - 4, 4);
+    TEST_ASSERT_EQUAL_UINT32(7, value);
+
+    length = stats_module_encode(first + 1, buffer, sizeof(buffer));
+    TEST_ASSERT_EQUAL(sizeof(wire_stat_t) + STATS_NAME_MAX + sizeof(wire_stat_distribution_t), length);
+    wire_stat_distribution_t distribution;
+    memcpy(&distribution, buffer + length - sizeof(distribution), sizeof(distribution));
+    TEST_ASSERT_EQUAL_UINT32(4, distribution.count);
+    TEST_ASSERT_EQUAL_UINT32(1000, distribution.max);
+    TEST_ASSERT_EQUAL_UINT32(5, distribution.p50);
+    TEST_ASSERT_UINT32_WITHIN(1000 / 16, 1000, distribution.p99);
+
+    TEST_ASSERT_EQUAL(0, stats_module_encode(first + 1, buffer, 20));
+    TEST_ASSERT_EQUAL(0, stats_module_encode(first + 2, buffer, sizeof(buffer)));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_concurrent_updates_are_exact);
+    RUN_TEST(test_histogram_percentiles);
+    RUN_TEST(test_quantile_sketch_error_is_bounded);
+    RUN_TEST(test_registry_encodes_wire_records);
+    return UNITY_END();
+}
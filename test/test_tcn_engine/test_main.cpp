@@ -0,0 +1,210 @@
+// TCN 流式引擎（pio test -e native_dsp）：ei_tcn_step 逐帧推进的结果与每步从头做一次完整因果卷积的结果
+// 逐位一致；run_tcn_inference 与逐帧推进一致；复位后历史回到因果补零
+#include <unity.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "edge-impulse-sdk/classifier/inferencing_engines/tcn.h"
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/quantization_util.h"
+
+// 两层：3 轴 → 4 通道（kernel 2，dilation 1，ReLU），4 → 5 通道（kernel 3，dilation 2，无激活），5 类
+#define INPUTS 3
+#define CLASSES 5
+#define FRAMES 40
+
+static const uint8_t kChannels[] = {INPUTS, 4, 5};
+static const uint8_t kKernels[] = {2, 3};
+static const uint16_t kDilations[] = {1, 2};
+static const int32_t kInputOffset = 1;  // 输入零点 -1
+
+static std::vector<int8_t> g_weights[2];
+static std::vector<int32_t> g_bias[2];
+static std::vector<int8_t> g_history[2];
+static uint16_t g_heads[2];
+static ei_tcn_layer_t g_layers[2];
+static std::vector<int8_t> g_head_weights;
+static std::vector<int32_t> g_head_bias;
+static int8_t g_scratch[2 * 5];
+static ei_learning_block_config_tcn_t g_config;
+
+static int8_t random_int8() {
+    return (int8_t)(rand() % 255 - 127);
+}
+
+static void build_config() {
+    srand(1234);
+    const int32_t offsets[] = {kInputOffset, 128};
+    const int32_t zero_points[] = {-128, 3};
+    const double scales[] = {0.0031, 0.0017};
+    for (size_t l = 0; l < 2; l++) {
+        const size_t in = kChannels[l], out = kChannels[l + 1];
+        g_weights[l].resize(out * kKernels[l] * in);
+        for (size_t i = 0; i < g_weights[l].size(); i++) {
+            g_weights[l][i] = random_int8();
+        }
+        g_bias[l].resize(out);
+        for (size_t o = 0; o < out; o++) {
+            g_bias[l][o] = rand() % 4001 - 2000;
+        }
+        g_history[l].resize(((kKernels[l] - 1) * kDilations[l] + 1) * in);
+        int32_t multiplier = 0;
+        int shift = 0;
+        tflite::QuantizeMultiplier(scales[l], &multiplier, &shift);
+        g_layers[l] = {(uint8_t)in, (uint8_t)out, kKernels[l], kDilations[l], g_weights[l].data(), g_bias[l].data(),
+                       multiplier, shift, offsets[l], zero_points[l], l == 0 ? zero_points[l] : -128,
+                       g_history[l].data(), &g_heads[l]};
+    }
+    g_head_weights.resize(CLASSES * 5);
+    for (size_t i = 0; i < g_head_weights.size(); i++) {
+        g_head_weights[i] = random_int8();
+    }
+    g_head_bias.assign(CLASSES, 0);
+    for (size_t k = 0; k < CLASSES; k++) {
+        g_head_bias[k] = rand() % 2001 - 1000;
+    }
+    g_config = {1, 0, INPUTS, 0.0627f, -kInputOffset, g_layers, 2, g_head_weights.data(), g_head_bias.data(), -3,
+                0.0004f, CLASSES, g_scratch};
+}
+
+static std::vector<int8_t> make_frames(uint32_t seed) {
+    srand(seed);
+    std::vector<int8_t> frames(FRAMES * INPUTS);
+    for (size_t i = 0; i < frames.size(); i++) {
+        frames[i] = random_int8();
+    }
+    return frames;
+}
+
+/**
+ * @brief 完整的因果卷积：第 t 步的每一层都从第 0 帧重新计算，t 之前不存在的帧取输入零点
+ */
+static std::vector<int8_t> naive_last_layer(const std::vector<int8_t>& frames, size_t steps) {
+    std::vector<int8_t> x(frames.begin(), frames.begin() + steps * INPUTS);
+    for (size_t l = 0; l < 2; l++) {
+        const ei_tcn_layer_t& layer = g_layers[l];
+        std::vector<int8_t> y(steps * layer.out_channels);
+        for (size_t t = 0; t < steps; t++) {
+            for (size_t o = 0; o < layer.out_channels; o++) {
+                int32_t acc = layer.bias[o];
+                for (size_t k = 0; k < layer.kernel_size; k++) {
+                    const long s = (long)t - (long)((layer.kernel_size - 1 - k) * layer.dilation);
+                    for (size_t i = 0; i < layer.in_channels; i++) {
+                        const int32_t v = s >= 0 ? x[s * layer.in_channels + i] : -layer.input_offset;
+                        acc += (v + layer.input_offset) * layer.weights[(o * layer.kernel_size + k) * layer.in_channels + i];
+                    }
+                }
+                int32_t out = tflite::MultiplyByQuantizedMultiplier(acc, layer.multiplier, layer.shift) +
+                              layer.output_offset;
+                out = out < layer.act_min ? layer.act_min : (out > 127 ? 127 : out);
+                y[t * layer.out_channels + o] = (int8_t)out;
+            }
+        }
+        x.swap(y);
+    }
+    return std::vector<int8_t>(x.end() - 5, x.end());
+}
+
+static void naive_scores(const std::vector<int8_t>& frames, size_t steps, float* out) {
+    const std::vector<int8_t> features = naive_last_layer(frames, steps);
+    float max_logit = -INFINITY;
+    for (size_t k = 0; k < CLASSES; k++) {
+        int32_t acc = g_config.head_bias[k];
+        for (size_t i = 0; i < features.size(); i++) {
+            acc += (features[i] + g_config.head_input_offset) * g_config.head_weights[k * features.size() + i];
+        }
+        out[k] = acc * g_config.head_logit_scale;
+        max_logit = out[k] > max_logit ? out[k] : max_logit;
+    }
+    float total = 0.0f;
+    for (size_t k = 0; k < CLASSES; k++) {
+        out[k] = expf(out[k] - max_logit);
+        total += out[k];
+    }
+    for (size_t k = 0; k < CLASSES; k++) {
+        out[k] /= total;
+    }
+}
+
+static void assert_scores_equal(const float* expected, const float* actual) {
+    TEST_ASSERT_TRUE(memcmp(expected, actual, CLASSES * sizeof(float)) == 0);
+}
+
+void setUp() {
+    build_config();
+}
+
+void tearDown() {
+}
+
+static void test_stepping_matches_full_recompute() {
+    for (uint32_t seed = 1; seed <= 4; seed++) {
+        const std::vector<int8_t> frames = make_frames(seed);
+        ei_tcn_reset(&g_config);
+        for (size_t t = 0; t < FRAMES; t++) {
+            float stepped[CLASSES], expected[CLASSES];
+            TEST_ASSERT_TRUE(ei_tcn_step(&g_config, &frames[t * INPUTS], stepped) == EI_IMPULSE_OK);
+            naive_scores(frames, t + 1, expected);
+            assert_scores_equal(expected, stepped);
+        }
+    }
+}
+
+static void test_reset_restores_causal_padding() {
+    const std::vector<int8_t> warmup = make_frames(8), frames = make_frames(9);
+    ei_tcn_reset(&g_config);
+    for (size_t t = 0; t < FRAMES; t++) {
+        TEST_ASSERT_TRUE(ei_tcn_step(&g_config, &warmup[t * INPUTS], nullptr) == EI_IMPULSE_OK);
+    }
+    ei_tcn_reset(&g_config);
+    float stepped[CLASSES], expected[CLASSES];
+    for (size_t t = 0; t < 3; t++) {
+        TEST_ASSERT_TRUE(ei_tcn_step(&g_config, &frames[t * INPUTS], stepped) == EI_IMPULSE_OK);
+    }
+    naive_scores(frames, 3, expected);
+    assert_scores_equal(expected, stepped);
+}
+
+static void test_run_tcn_inference_matches_stepping() {
+    const std::vector<int8_t> frames = make_frames(5);
+    // 特征矩阵是浮点：取量化后恰好落回原值的数
+    std::vector<float> features(frames.size());
+    for (size_t i = 0; i < frames.size(); i++) {
+        features[i] = (frames[i] + kInputOffset) * g_config.input_scale;
+    }
+    ei::matrix_t matrix(1, features.size(), features.data());
+    ei_feature_t fmatrix[1];
+    fmatrix[0].matrix = &matrix;
+    fmatrix[0].blockId = 0;
+
+    ei_impulse_t impulse = {};
+    impulse.dsp_blocks_size = 1;
+    ei_feature_t raw_outputs[1];
+    raw_outputs[0].matrix = nullptr;
+    raw_outputs[0].blockId = 0;
+    ei_impulse_result_t result = {};
+    result._raw_outputs = raw_outputs;
+    uint32_t input_block_ids[] = {0};
+    TEST_ASSERT_TRUE(run_tcn_inference(&impulse, fmatrix, 0, input_block_ids, 1, &result, &g_config) == EI_IMPULSE_OK);
+    TEST_ASSERT_TRUE(raw_outputs[0].matrix != nullptr);
+
+    float expected[CLASSES];
+    naive_scores(frames, FRAMES, expected);
+    assert_scores_equal(expected, raw_outputs[0].matrix->buffer);
+    delete raw_outputs[0].matrix;
+
+    // 帧数不是整数的特征矩阵被拒绝
+    ei::matrix_t partial(1, features.size() - 1, features.data());
+    fmatrix[0].matrix = &partial;
+    raw_outputs[0].matrix = nullptr;
+    TEST_ASSERT_TRUE(run_tcn_inference(&impulse, fmatrix, 0, input_block_ids, 1, &result, &g_config) ==
+                     EI_IMPULSE_INVALID_SIZE);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_stepping_matches_full_recompute);
+    RUN_TEST(test_reset_restores_causal_padding);
+    RUN_TEST(test_run_tcn_inference_matches_stepping);
+    return UNITY_END();
+}